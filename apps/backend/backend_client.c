@@ -71,6 +71,39 @@
 #include "backend_handle.h"
 #include "backend_get.h"
 #include "backend_client.h"
+#include "backend_startup.h"
+
+/*! Client message queued while a commit is pending
+ *
+ * @see candidate_commit_pending
+ */
+struct client_msg{
+    qelem_t      cm_q;      /* Queue header */
+    uint32_t     cm_id;     /* Session id of client */
+    cbuf        *cm_msg;    /* Message, not parsed */
+};
+
+/*! Autocommit edit whose commit and reply are deferred to a coalesced commit
+ *
+ * @see CLICON_AUTOCOMMIT_BATCH
+ */
+struct autocommit_edit{
+    qelem_t      ae_q;      /* Queue header */
+    uint32_t     ae_id;     /* Session id of client */
+    cxobj       *ae_xrpc;   /* Copy of request <rpc><edit-config>, for individual commit */
+    char        *ae_existed;/* Value of objectexisted of edit, or NULL */
+};
+
+/*! Autocommit edits made within the coalescing window
+ */
+struct autocommit_batch{
+    struct autocommit_edit *ab_edits;  /* Edits in candidate not committed */
+    int                     ab_replay; /* Edits are applied and committed one by one */
+};
+
+static int from_client_msg(clixon_handle h, struct client_entry *ce, cbuf *msg, int queue);
+static int autocommit_batch_run(int fd, void *arg);
+static int from_client_shm(int fd, void *arg);
 
 /*! Find client by session-id 
  *
@@ -91,8 +124,9 @@ ce_find_byid(struct client_entry *ce_list,
 
 /*! Construct a client string description from client_entry information for logging
  *
+ * The description is only used in message debug logs and is not built otherwise
  * @param[in]  ce   Client entry struct
- * @param[out] cbp  Cligen buffer, deallocate with cbuf_free
+ * @param[out] cbp  Cligen buffer, deallocate with cbuf_free, NULL if debug msg is not set
  * @retval     0    OK 
  * @retval    -1    Error
  */
@@ -108,6 +142,11 @@ ce_client_descr(struct client_entry *ce,
         clixon_err(OE_UNIX, EINVAL, "ce or cbp is NULL");
         goto done;
     }
+    if (!clixon_debug_isset(CLIXON_DBG_MSG)){
+        *cbp = NULL;
+        retval = 0;
+        goto done;
+    }
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
@@ -156,7 +195,7 @@ ce_event_cb(clixon_handle h,
     default:
         if (ce_client_descr(ce, &cbce) < 0)
             goto done;
-        if (send_msg_notify_xml(h, ce->ce_s, cbuf_get(cbce), event) < 0){
+        if (send_msg_notify_xml(h, ce->ce_s, cbce?cbuf_get(cbce):NULL, event) < 0){
             if (errno == ECONNRESET || errno == EPIPE){
                 clixon_log(h, LOG_WARNING, "client %d reset", ce->ce_nr);
             }
@@ -220,42 +259,47 @@ release_all_dbs(clixon_handle h,
     return retval;
 }
 
-/*! Get backend-specific client netconf monitoring state
+/*! Get cached netconf monitoring session subtree of a client, create it if needed
  *
- * Backend-specific netconf monitoring state is:
- *   sessions
+ * The subtree is parsed once per session, only the counters are updated on each call.
+ * It is reset if transport or source-host of the session changes.
  * @param[in]     h       Clixon handle
  * @param[in]     yspec   Yang spec
- * @param[in]     xpath   XML Xpath
- * @param[in]     nsc     XML Namespace context for xpath
- * @param[in,out] xret    Existing XML tree, merge x into this
+ * @param[in]     ce      Client entry
+ * @param[out]    xsp     Cached <session> subtree, do not free
  * @param[out]    xerr    XML error tree, if retval = 0
  * @retval        1       OK
- * @retval        0       Statedata callback failed, error in xerr
+ * @retval        0       Invalid XML, error in xerr
  * @retval       -1       Error (fatal)
- * @see RFC 6022
  */
-int
-backend_monitoring_state_get(clixon_handle h,
-                             yang_stmt    *yspec,
-                             char         *xpath,
-                             cvec         *nsc,
-                             cxobj       **xret,
-                             cxobj       **xerr)
+static int
+ce_monitoring_session(clixon_handle        h,
+                      yang_stmt           *yspec,
+                      struct client_entry *ce,
+                      cxobj              **xsp,
+                      cxobj              **xerr)
 {
-    int                  retval = -1;
-    cbuf                *cb = NULL;
-    struct client_entry *ce;
-    char                 timestr[28];
-    int                  ret;
-
-    if ((cb = cbuf_new()) ==NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
-        goto done;
-    }
-    cprintf(cb, "<netconf-state xmlns=\"%s\">", NETCONF_MONITORING_NAMESPACE);
-    cprintf(cb, "<sessions>");
-    for (ce = backend_client_list(h); ce; ce = ce->ce_next){
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cxobj  *xt = NULL;
+    cxobj  *xs;
+    char    timestr[28];
+    char    valstr[16];
+    char   *names[] = {"in-rpcs", "in-bad-rpcs", "out-rpc-errors", "out-notifications"};
+    uint32_t vals[] = {ce->ce_in_rpcs, ce->ce_in_bad_rpcs, ce->ce_out_rpc_errors,
+                       ce->ce_out_notifications};
+    cxobj  *xc;
+    cxobj  *xb;
+    int     i;
+    int     ret;
+
+    if ((xs = ce->ce_monitoring) == NULL){
+        if ((cb = cbuf_new()) ==NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "<netconf-state xmlns=\"%s\">", NETCONF_MONITORING_NAMESPACE);
+        cprintf(cb, "<sessions>");
         cprintf(cb, "<session>");
         cprintf(cb, "<session-id>%u</session-id>", ce->ce_id);
         if (ce->ce_transport == NULL){
@@ -281,21 +325,40 @@ backend_monitoring_state_get(clixon_handle h,
             }
             cprintf(cb, "<login-time>%s</login-time>", timestr);
         }
-        cprintf(cb, "<in-rpcs>%u</in-rpcs>", ce->ce_in_rpcs);
-        cprintf(cb, "<in-bad-rpcs>%u</in-bad-rpcs>", ce->ce_in_bad_rpcs);
-        cprintf(cb, "<out-rpc-errors>%u</out-rpc-errors>", ce->ce_out_rpc_errors);
-        cprintf(cb, "<out-notifications>%u</out-notifications>", ce->ce_out_notifications);
+        for (i=0; i<sizeof(names)/sizeof(char*); i++)
+            cprintf(cb, "<%s>0</%s>", names[i], names[i]);
         cprintf(cb, "</session>");
+        cprintf(cb, "</sessions>");
+        cprintf(cb, "</netconf-state>");
+        if ((ret = clixon_xml_parse_string(cbuf_get(cb), YB_MODULE, yspec, &xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if ((xs = xml_find_type(xt, NULL, "netconf-state", CX_ELMNT)) == NULL ||
+            (xs = xml_find_type(xs, NULL, "sessions", CX_ELMNT)) == NULL ||
+            (xs = xml_find_type(xs, NULL, "session", CX_ELMNT)) == NULL){
+            clixon_err(OE_XML, 0, "session not found");
+            goto done;
+        }
+        if (xml_rm(xs) < 0)
+            goto done;
+        ce->ce_monitoring = xs;
     }
-    cprintf(cb, "</sessions>");
-    cprintf(cb, "</netconf-state>");
-    if ((ret = clixon_xml_parse_string(cbuf_get(cb), YB_MODULE, yspec, xret, xerr)) < 0)
-        goto done;
-    if (ret == 0)
-        goto fail;
+    /* Update counters */
+    for (i=0; i<sizeof(names)/sizeof(char*); i++){
+        if ((xc = xml_find_type(xs, NULL, names[i], CX_ELMNT)) == NULL ||
+            (xb = xml_body_get(xc)) == NULL)
+            continue;
+        snprintf(valstr, sizeof(valstr), "%u", vals[i]);
+        if (strcmp(xml_value(xb), valstr) != 0 &&
+            xml_value_set(xb, valstr) < 0)
+            goto done;
+    }
+    *xsp = xs;
     retval = 1;
  done:
-    clixon_debug(CLIXON_DBG_BACKEND, "retval:%d", retval);
+    if (xt)
+        xml_free(xt);
     if (cb)
         cbuf_free(cb);
     return retval;
@@ -304,6 +367,78 @@ backend_monitoring_state_get(clixon_handle h,
     goto done;
 }
 
+/*! Get backend-specific client netconf monitoring state
+ *
+ * Backend-specific netconf monitoring state is:
+ *   sessions
+ * Each session subtree is cached in its client entry and copied, see ce_monitoring_session
+ * @param[in]     h       Clixon handle
+ * @param[in]     yspec   Yang spec
+ * @param[in]     xpath   XML Xpath
+ * @param[in]     nsc     XML Namespace context for xpath
+ * @param[in,out] xret    Existing XML tree, merge x into this
+ * @param[out]    xerr    XML error tree, if retval = 0
+ * @retval        1       OK
+ * @retval        0       Statedata callback failed, error in xerr
+ * @retval       -1       Error (fatal)
+ * @see RFC 6022
+ */
+int
+backend_monitoring_state_get(clixon_handle h,
+                             yang_stmt    *yspec,
+                             char         *xpath,
+                             cvec         *nsc,
+                             cxobj       **xret,
+                             cxobj       **xerr)
+{
+    int                  retval = -1;
+    struct client_entry *ce;
+    yang_stmt           *ymod;
+    yang_stmt           *ystate;
+    yang_stmt           *ysessions;
+    cxobj               *xstate;
+    cxobj               *xsessions;
+    cxobj               *xs;
+    int                  ret;
+
+    if ((ymod = yang_find_module_by_namespace(yspec, NETCONF_MONITORING_NAMESPACE)) == NULL ||
+        (ystate = yang_find(ymod, Y_CONTAINER, "netconf-state")) == NULL ||
+        (ysessions = yang_find(ystate, Y_CONTAINER, "sessions")) == NULL){
+        clixon_err(OE_YANG, ENOENT, "yang netconf-state sessions not found");
+        goto done;
+    }
+    if (*xret == NULL &&
+        (*xret = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if ((xstate = xml_new("netconf-state", *xret, CX_ELMNT)) == NULL)
+        goto done;
+    xml_spec_set(xstate, ystate);
+    if (xmlns_set(xstate, NULL, NETCONF_MONITORING_NAMESPACE) < 0)
+        goto done;
+    if ((xsessions = xml_new("sessions", xstate, CX_ELMNT)) == NULL)
+        goto done;
+    xml_spec_set(xsessions, ysessions);
+    for (ce = backend_client_list(h); ce; ce = ce->ce_next){
+        if ((ret = ce_monitoring_session(h, yspec, ce, &xs, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if ((xs = xml_dup(xs)) == NULL)
+            goto done;
+        if (xml_addsub(xsessions, xs) < 0)
+            goto done;
+    }
+    if (xml_sort(xsessions) < 0)
+        goto done;
+    retval = 1;
+ done:
+    clixon_debug(CLIXON_DBG_BACKEND, "retval:%d", retval);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Remove client entry state
  *
  * Close down everything wrt clients (eg sockets, subscriptions)
@@ -325,6 +460,12 @@ backend_client_rm(clixon_handle        h,
     uint32_t              myid = ce->ce_id;
     yang_stmt            *yspec;
 
+    if (ce->ce_thread){
+        /* Reader thread sends on socket, remove when done, see backend_client_resume */
+        shutdown(ce->ce_s, SHUT_RDWR);
+        ce->ce_rm = 1;
+        return 0;
+    }
     /* If the confirmed-commit feature is enabled, rollback any ephemeral commit originated by this client */
     if ((yspec = clicon_dbspec_yang(h)) != NULL) {
         if (if_feature(yspec, "ietf-netconf", "confirmed-commit")) {
@@ -353,6 +494,10 @@ backend_client_rm(clixon_handle        h,
         if (c == ce){
             if (ce->ce_s){
                 clixon_event_unreg_fd(ce->ce_s, from_client);
+                if (ce->ce_shm == 2)
+                    clixon_event_unreg_fd(ce->ce_shm_efd, from_client_shm);
+                clixon_shm_close(ce->ce_s);
+                clixon_msg_outq_free(ce->ce_s);
                 close(ce->ce_s);
                 ce->ce_s = 0;
                 if (release_all_dbs(h, ce->ce_id) < 0)
@@ -362,6 +507,8 @@ backend_client_rm(clixon_handle        h,
         }
         ce_prev = &c->ce_next;
     }
+    if (private_candidate_free(h, ce) < 0)
+        return -1;
     return backend_client_delete(h, ce); /* actually purge it */
 }
 
@@ -382,20 +529,16 @@ clixon_stats_datastore_get(clixon_handle h,
     cxobj    *xt = NULL; /* should not be freed */
     uint64_t  nr = 0;
     size_t    sz = 0;
-    cxobj    *xn = NULL;
+    cxobj    *xerr = NULL;
     int       ret;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "%s", dbname);
-    /* This is the db cache */
-    if ((xt = xmldb_cache_get(h, dbname)) == NULL){
-        /* Trigger cache if no exist (trick to ensure cache is present) */
-        if ((ret = xmldb_get0(h, dbname, YB_MODULE, NULL, "/", 1, 0, &xn, NULL, NULL)) < 0)
-            //goto done;
-            goto ok;
-        if (ret == 0)
-            goto ok;
-        xt = xmldb_cache_get(h, dbname);
-    }
+    /* This is the db cache, read from file if not present. Keeps its content generation */
+    if ((ret = xmldb_get_cache(h, dbname, YB_MODULE, &xt, NULL, &xerr)) < 0)
+        //goto done;
+        goto ok;
+    if (ret == 0)
+        goto ok;
     if (xt != NULL){
         if (xml_stats(xt, &nr, &sz) < 0)
             goto done;
@@ -406,11 +549,39 @@ clixon_stats_datastore_get(clixon_handle h,
  ok:
     retval = 0;
  done:
-    if (xn)
-        xml_free(xn);
+    if (xerr)
+        xml_free(xerr);
     return retval;
 }
 
+/*! Memory of backend client sessions, see clixon_memstats_register
+ *
+ * Client entries, receive buffers and queued replies not yet written
+ * @param[in]  h     Clixon handle
+ * @param[in]  arg   Not used
+ * @param[out] nr    Number of clients
+ * @param[out] size  Size in bytes
+ * @retval     0     OK
+ */
+static int
+backend_client_memstats(clixon_handle h,
+                        void         *arg,
+                        uint64_t     *nr,
+                        size_t       *size)
+{
+    struct client_entry *ce;
+
+    for (ce = backend_client_list(h); ce; ce = ce->ce_next){
+        (*nr)++;
+        *size += sizeof(*ce);
+        if (ce->ce_pipe)
+            *size += clixon_msg_pipe_size(ce->ce_pipe);
+        if (ce->ce_s >= 0)
+            *size += clixon_msg_outq_len(ce->ce_s);
+    }
+    return 0;
+}
+
 /*! Get clixon per yang-spec stats
  *
  * @param[in]     h       Clixon handle
@@ -517,6 +688,130 @@ do_lock(clixon_handle h,
     goto done;
 }
 
+/*! Check if an autocommit batch is open, ie edits wait for a coalesced commit
+ *
+ * Then other requests than reads and autocommit edits should be queued
+ * @param[in]  h   Clixon handle
+ * @retval     1   Batch is open
+ * @retval     0   No
+ */
+static int
+autocommit_batch_open(clixon_handle h)
+{
+    struct autocommit_batch *ab = NULL;
+
+    clicon_ptr_get(h, "autocommit-batch", (void**)&ab);
+    return ab != NULL && ab->ab_edits != NULL;
+}
+
+/*! Check if an autocommit edit may be coalesced with other autocommit edits
+ *
+ * Not if NACM is used, since the edit may be replayed outside the client message,
+ * nor with locks or copy to startup.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xn      Request: <rpc><xn></rpc>
+ * @param[in]  target  Target datastore
+ * @retval     1       Edit may be coalesced
+ * @retval     0       No, commit edit directly
+ */
+static int
+autocommit_batch_check(clixon_handle h,
+                       cxobj        *xn,
+                       char         *target)
+{
+    struct autocommit_batch *ab = NULL;
+    char                    *attr;
+
+    if (clicon_option_int(h, "CLICON_AUTOCOMMIT_BATCH") <= 0)
+        return 0;
+    clicon_ptr_get(h, "autocommit-batch", (void**)&ab);
+    if (ab != NULL && ab->ab_replay)
+        return 0;
+    if (strcmp(target, "candidate") != 0 ||
+        clicon_option_bool(h, "CLICON_AUTOLOCK") ||
+        clicon_nacm_cache(h) != NULL ||
+        candidate_commit_pending(h))
+        return 0;
+    if ((attr = xml_find_value(xn, "copystartup")) != NULL &&
+        strcmp(attr, "true") == 0)
+        return 0;
+    return 1;
+}
+
+/*! Add autocommit edit to batch, open batch and start coalescing window if not open
+ *
+ * The reply to the client is deferred until the batch is committed
+ * @param[in]  h     Clixon handle
+ * @param[in]  ce    Client entry
+ * @param[in]  xrpc  Copy of request <rpc><edit-config>, consumed
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see autocommit_batch_run
+ */
+static int
+autocommit_batch_add(clixon_handle        h,
+                     struct client_entry *ce,
+                     cxobj               *xrpc)
+{
+    int                      retval = -1;
+    struct autocommit_batch *ab = NULL;
+    struct autocommit_edit  *ae = NULL;
+    char                    *val = NULL;
+    struct timeval           t;
+    struct timeval           t1;
+    int                      ms;
+
+    clicon_ptr_get(h, "autocommit-batch", (void**)&ab);
+    if (ab == NULL){
+        if ((ab = calloc(1, sizeof(*ab))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if (clicon_ptr_set(h, "autocommit-batch", ab) < 0){
+            free(ab);
+            goto done;
+        }
+    }
+    if ((ae = calloc(1, sizeof(*ae))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    ae->ae_id = ce->ce_id;
+    ae->ae_xrpc = xrpc;
+    xrpc = NULL;
+    /* Set in text_modify */
+    if (clicon_data_get(h, "objectexisted", &val) == 0 &&
+        (ae->ae_existed = strdup(val)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (ab->ab_edits == NULL){
+        ms = clicon_option_int(h, "CLICON_AUTOCOMMIT_BATCH");
+        gettimeofday(&t, NULL);
+        t1.tv_sec = ms/1000;
+        t1.tv_usec = (ms%1000)*1000;
+        timeradd(&t, &t1, &t);
+        if (clixon_event_reg_timeout(t, autocommit_batch_run, h, "autocommit batch") < 0)
+            goto done;
+    }
+    ADDQ(ae, ab->ab_edits);
+    ae = NULL;
+    ce->ce_reply_pending = 1;
+    clixon_debug(CLIXON_DBG_BACKEND, "autocommit edit of ce_id:%u batched", ce->ce_id);
+    retval = 0;
+ done:
+    if (ae){
+        if (ae->ae_xrpc)
+            xml_free(ae->ae_xrpc);
+        if (ae->ae_existed)
+            free(ae->ae_existed);
+        free(ae);
+    }
+    if (xrpc)
+        xml_free(xrpc);
+    return retval;
+}
+
 /*! Loads all or part of a specified configuration to target configuration
  * 
  * @param[in]  h       Clixon handle 
@@ -560,7 +855,9 @@ from_client_edit_config(clixon_handle h,
     int                 autocommit = 0;
     char               *val = NULL;
     cvec               *nsc = NULL;
+    xml_nsscope        *nss = NULL;
     char               *prefix = NULL;
+    cxobj              *xrpc = NULL; /* Copy of request if autocommit is batched */
 
     username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -576,6 +873,20 @@ from_client_edit_config(clixon_handle h,
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
     }
+    /* Clixon extension: autocommit */
+    if ((attr = xml_find_value(xn, "autocommit")) != NULL &&
+        strcmp(attr,"true") == 0)
+        autocommit = 1;
+    /* Private candidate, not with autocommit which commits the shared candidate */
+    if (!clicon_autocommit(h) && !autocommit &&
+        private_candidate_db(h, ce, target, 1, &target) < 0)
+        goto done;
+    /* Keep request before it is modified, in case batch commit fails and edit is replayed */
+    if ((clicon_autocommit(h) || autocommit) &&
+        autocommit_batch_check(h, xn, target)){
+        if ((xrpc = xml_dup(xml_parent(xn))) == NULL)
+            goto done;
+    }
     /* Check if target locked by other client */
     iddb = xmldb_islocked(h, target);
     if (iddb && myid != iddb){
@@ -598,8 +909,9 @@ from_client_edit_config(clixon_handle h,
                 goto done;
         }
     }
-    if (xml_nsctx_node(xn, &nsc) < 0)
+    if (xml_nsscope_node(xn, &nss) < 0)
         goto done;
+    nsc = xml_nsscope_nsc(nss);
     /* Get prefix of netconf base namespace in the incoming message */
     if (xml_nsctx_get_prefix(nsc, NETCONF_BASE_NAMESPACE, &prefix) == 0){
         cprintf(cbx, "No appropriate prefix exists for: %s", NETCONF_BASE_NAMESPACE);
@@ -695,10 +1007,6 @@ from_client_edit_config(clixon_handle h,
     if (ret == 0)
         goto ok;
     xmldb_modified_set(h, target, 1); /* mark as dirty */
-    /* Clixon extension: autocommit */
-    if ((attr = xml_find_value(xn, "autocommit")) != NULL &&
-        strcmp(attr,"true") == 0)
-        autocommit = 1;
     /* If autocommit option is set or requested by client */
     if (clicon_autocommit(h) || autocommit) {
         /* if this is from a restconf client ...
@@ -729,6 +1037,14 @@ from_client_edit_config(clixon_handle h,
                 break;
             }
         }
+        /* Commit and reply later together with other edits within the coalescing window */
+        if (xrpc != NULL){
+            ret = autocommit_batch_add(h, ce, xrpc);
+            xrpc = NULL;
+            if (ret < 0)
+                goto done;
+            goto ok;
+        }
         if ((ret = candidate_commit(h, NULL, "candidate", myid, 0, cbret)) < 0){ /* Assume validation fail, nofatal */
             if (clixon_plugin_report_err(h, cbret) < 0)
                 goto done;
@@ -777,16 +1093,118 @@ from_client_edit_config(clixon_handle h,
     }
     retval = 0;
  done:
-    if (nsc)
-        cvec_free(nsc);
+    if (nss)
+        xml_nsscope_unref(nss);
     if (xret)
         xml_free(xret);
     if (cbx)
         cbuf_free(cbx);
+    if (xrpc)
+        xml_free(xrpc);
     clixon_debug(CLIXON_DBG_BACKEND, "done cbret:%s", cbuf_get(cbret));
     return retval;
 } /* from_client_edit_config */
 
+/*! Coalescing window closed: commit batched autocommit edits and reply to all clients
+ *
+ * If the commit fails and there are several edits, candidate is reset and the edits
+ * are applied and committed one by one, so that each client gets the result of its own edit.
+ * @param[in]  fd   No-op
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see autocommit_batch_add
+ */
+static int
+autocommit_batch_run(int   fd,
+                     void *arg)
+{
+    int                      retval = -1;
+    clixon_handle            h = (clixon_handle)arg;
+    struct autocommit_batch *ab = NULL;
+    struct autocommit_edit  *edits;
+    struct autocommit_edit  *ae;
+    struct client_entry     *ce;
+    cxobj                   *xn;
+    cbuf                    *cbret = NULL;
+    int                      ret;
+
+    clicon_ptr_get(h, "autocommit-batch", (void**)&ab);
+    if (ab == NULL || (edits = ab->ab_edits) == NULL)
+        return 0;
+    ab->ab_edits = NULL;
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_BACKEND, "commit autocommit batch");
+    if ((ret = candidate_commit(h, NULL, "candidate", edits->ae_id, 0, cbret)) < 0){
+        if (clixon_plugin_report_err(h, cbret) < 0)
+            goto done;
+        ret = 0;
+    }
+    if (ret == 0){
+        if (xmldb_copy(h, "running", "candidate") < 0)
+            goto done;
+        if (NEXTQ(struct autocommit_edit *, edits) != edits){ /* Several edits */
+            clixon_debug(CLIXON_DBG_BACKEND, "autocommit batch failed, commit edits one by one");
+            ab->ab_replay = 1;
+            while ((ae = edits) != NULL){
+                DELQ(ae, edits, struct autocommit_edit *);
+                if ((ce = ce_find_byid(backend_client_list(h), ae->ae_id)) != NULL){
+                    cbuf_reset(cbret);
+                    clicon_username_set(h, xml_find_value(ae->ae_xrpc, "username"));
+                    if ((xn = xml_find_type(ae->ae_xrpc, NULL, "edit-config", CX_ELMNT)) == NULL ||
+                        from_client_edit_config(h, xn, cbret, ce, NULL) < 0){
+                        cbuf_reset(cbret);
+                        if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
+                            goto done;
+                    }
+                    if (backend_client_reply(h, ae->ae_id, cbret) < 0)
+                        goto done;
+                }
+                xml_free(ae->ae_xrpc);
+                if (ae->ae_existed)
+                    free(ae->ae_existed);
+                free(ae);
+            }
+            goto ok;
+        }
+    }
+    while ((ae = edits) != NULL){
+        DELQ(ae, edits, struct autocommit_edit *);
+        if (ret == 1){
+            cbuf_reset(cbret);
+            cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok", NETCONF_BASE_NAMESPACE);
+            if (ae->ae_existed)
+                cprintf(cbret, " %s:objectexisted=\"%s\" xmlns:%s=\"%s\"",
+                        CLIXON_LIB_PREFIX, ae->ae_existed,
+                        CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+            cprintf(cbret, "/></rpc-reply>");
+        }
+        if (backend_client_reply(h, ae->ae_id, cbret) < 0)
+            goto done;
+        xml_free(ae->ae_xrpc);
+        if (ae->ae_existed)
+            free(ae->ae_existed);
+        free(ae);
+    }
+ ok:
+    retval = 0;
+ done:
+    ab->ab_replay = 0;
+    while ((ae = edits) != NULL){
+        DELQ(ae, edits, struct autocommit_edit *);
+        xml_free(ae->ae_xrpc);
+        if (ae->ae_existed)
+            free(ae->ae_existed);
+        free(ae);
+    }
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
 /*! Create or replace an entire config with another complete config db
  *
  * @param[in]  h       Clixon handle
@@ -832,6 +1250,10 @@ from_client_copy_config(clixon_handle h,
             goto done;
         goto ok;
     }
+    if (private_candidate_db(h, ce, source, 0, &source) < 0)
+        goto done;
+    if (private_candidate_db(h, ce, target, 1, &target) < 0)
+        goto done;
     /* Check if target locked by other client */
     iddb = xmldb_islocked(h, target);
     if (iddb && myid != iddb){
@@ -1456,6 +1878,173 @@ from_client_ping(clixon_handle h,
     return 0;
 }
 
+/*! Change of a datastore, see datastore_change_get
+ */
+struct datastore_change {
+    qelem_t        dc_qelem;
+    char          *dc_db;    /* Datastore name */
+    uint64_t       dc_gen;   /* Content generation of datastore at last change */
+    struct timeval dc_tv;    /* Time of last change */
+};
+
+/*! Get change id and time of last change of a datastore
+ *
+ * A change is noted when the content generation of the datastore differs from the last
+ * time, ie on the first request after a change. The time of a change is after the time of
+ * the last change by at least one second, so that HTTP-dates of two changes differ.
+ * The change id is the time of change in microseconds, which also differs after a restart
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Datastore, eg "running"
+ * @param[out] id  Change id
+ * @param[out] tv  Time of last change
+ * @retval     1   OK
+ * @retval     0   Datastore could not be read, and xerr set
+ * @retval    -1   Error
+ * @see xmldb_generation
+ */
+static int
+datastore_change_get(clixon_handle   h,
+                     char           *db,
+                     uint64_t       *id,
+                     struct timeval *tv,
+                     cxobj         **xerr)
+{
+    int                      retval = -1;
+    struct datastore_change *list = NULL;
+    struct datastore_change *dc;
+    cxobj                   *xt;
+    uint64_t                 gen;
+    struct timeval           now;
+    int                      ret;
+
+    if ((ret = xmldb_get_cache(h, db, YB_MODULE, &xt, NULL, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    gen = xmldb_generation(h, db);
+    clicon_ptr_get(h, "datastore-change", (void**)&list);
+    if ((dc = list) != NULL){
+        do {
+            if (strcmp(dc->dc_db, db) == 0)
+                break;
+            dc = NEXTQ(struct datastore_change *, dc);
+        } while (dc != list);
+        if (strcmp(dc->dc_db, db) != 0)
+            dc = NULL;
+    }
+    if (dc == NULL){
+        if ((dc = calloc(1, sizeof(*dc))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if ((dc->dc_db = strdup(db)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            free(dc);
+            goto done;
+        }
+        ADDQ(dc, list);
+        if (clicon_ptr_set(h, "datastore-change", list) < 0)
+            goto done;
+    }
+    if (dc->dc_gen != gen){
+        gettimeofday(&now, NULL);
+        if (now.tv_sec <= dc->dc_tv.tv_sec){
+            now.tv_sec = dc->dc_tv.tv_sec + 1;
+            now.tv_usec = 0;
+        }
+        dc->dc_tv = now;
+        dc->dc_gen = gen;
+    }
+    *id = (uint64_t)dc->dc_tv.tv_sec*1000000 + dc->dc_tv.tv_usec;
+    *tv = dc->dc_tv;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Free datastore changes
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ */
+int
+datastore_change_free(clixon_handle h)
+{
+    struct datastore_change *list = NULL;
+    struct datastore_change *dc;
+
+    clicon_ptr_get(h, "datastore-change", (void**)&list);
+    while ((dc = list) != NULL){
+        DELQ(dc, list, struct datastore_change *);
+        if (dc->dc_db)
+            free(dc->dc_db);
+        free(dc);
+    }
+    clicon_ptr_del(h, "datastore-change");
+    return 0;
+}
+
+/*! Get change id and time of last change of a datastore
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see datastore_change_get
+ */
+static int
+from_client_datastore_change(clixon_handle h,
+                             cxobj        *xe,
+                             cbuf         *cbret,
+                             void         *arg,
+                             void         *regarg)
+{
+    int            retval = -1;
+    char          *db;
+    uint64_t       id;
+    struct timeval tv;
+    char           timestr[28];
+    cxobj         *xerr = NULL;
+    int            ret;
+
+    if ((db = xml_find_body(xe, "datastore")) == NULL)
+        db = "running";
+    if (strcmp(db, "running") != 0 &&
+        strcmp(db, "candidate") != 0 &&
+        strcmp(db, "startup") != 0){
+        if (netconf_invalid_value(cbret, "protocol", "No such datastore") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((ret = datastore_change_get(h, db, &id, &tv, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
+            goto done;
+        goto ok;
+    }
+    if (time2str(&tv, timestr, sizeof(timestr)) < 0){
+        clixon_err(OE_UNIX, errno, "time2str");
+        goto done;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<change-id xmlns=\"%s\">%" PRIu64 "</change-id>", CLIXON_LIB_NS, id);
+    cprintf(cbret, "<last-modified xmlns=\"%s\">%s</last-modified>", CLIXON_LIB_NS, timestr);
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
 /*! Check liveness of backend daemon,  just send a reply
  *
  * @param[in]  h       Clixon handle
@@ -1475,8 +2064,18 @@ from_client_stats(clixon_handle h,
 {
     int        retval = -1;
     uint64_t   nr;
+    uint64_t   hits;
+    uint64_t   misses;
+    uint64_t   csz;
     char      *str;
     int        modules = 0;
+    int        xprofile = 0;
+    int        vprofile = 0;
+    int        eprofile = 0;
+    int        ctiming = 0;
+    int        memory = 0;
+    int        aprofile = 0;
+    int        stiming = 0;
     yang_stmt *yspec0;
     yang_stmt *ymounts;
     yang_stmt *ydomain;
@@ -1490,6 +2089,20 @@ from_client_stats(clixon_handle h,
 
     if ((str = xml_find_body(xe, "modules")) != NULL)
         modules = strcmp(str, "true") == 0;
+    if ((str = xml_find_body(xe, "xpath-profile")) != NULL)
+        xprofile = strcmp(str, "true") == 0;
+    if ((str = xml_find_body(xe, "validate-profile")) != NULL)
+        vprofile = strcmp(str, "true") == 0;
+    if ((str = xml_find_body(xe, "event-profile")) != NULL)
+        eprofile = strcmp(str, "true") == 0;
+    if ((str = xml_find_body(xe, "commit-timing")) != NULL)
+        ctiming = strcmp(str, "true") == 0;
+    if ((str = xml_find_body(xe, "memory")) != NULL)
+        memory = strcmp(str, "true") == 0;
+    if ((str = xml_find_body(xe, "alloc-profile")) != NULL)
+        aprofile = strcmp(str, "true") == 0;
+    if ((str = xml_find_body(xe, "startup-timing")) != NULL)
+        stiming = strcmp(str, "true") == 0;
     yspec0 = clicon_dbspec_yang(h);
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
     cprintf(cbret, "<global xmlns=\"%s\">", CLIXON_LIB_NS);
@@ -1499,6 +2112,14 @@ from_client_stats(clixon_handle h,
     nr=0;
     yang_stats_global(&nr);
     cprintf(cbret, "<yangnr>%" PRIu64 "</yangnr>", nr);
+    yang_stats_compact(&nr, &csz);
+    cprintf(cbret, "<yangcompactnr>%" PRIu64 "</yangcompactnr>", nr);
+    cprintf(cbret, "<yangcompactsize>%" PRIu64 "</yangcompactsize>", csz);
+    if (regex_cache_stats(&nr, &hits, &misses) < 0)
+        goto done;
+    cprintf(cbret, "<regexnr>%" PRIu64 "</regexnr>", nr);
+    cprintf(cbret, "<regexhits>%" PRIu64 "</regexhits>", hits);
+    cprintf(cbret, "<regexmisses>%" PRIu64 "</regexmisses>", misses);
     cprintf(cbret, "</global>");
     cprintf(cbret, "<datastores xmlns=\"%s\">", CLIXON_LIB_NS);
     if (clixon_stats_datastore_get(h, "running", cbret) < 0)
@@ -1537,6 +2158,48 @@ from_client_stats(clixon_handle h,
         }
     }
     cprintf(cbret, "</module-sets>");
+    if (xprofile){
+        cprintf(cbret, "<xpath-profile xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (xpath_profile_print(cbret) < 0)
+            goto done;
+        cprintf(cbret, "</xpath-profile>");
+    }
+    if (vprofile){
+        cprintf(cbret, "<validate-profile xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (validate_profile_print(cbret) < 0)
+            goto done;
+        cprintf(cbret, "</validate-profile>");
+    }
+    if (eprofile){
+        cprintf(cbret, "<event-profile xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (event_profile_print(cbret) < 0)
+            goto done;
+        cprintf(cbret, "</event-profile>");
+    }
+    if (ctiming){
+        cprintf(cbret, "<commit-timing xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (commit_timing_print(h, cbret) < 0)
+            goto done;
+        cprintf(cbret, "</commit-timing>");
+    }
+    if (stiming){
+        cprintf(cbret, "<startup-timing xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (startup_timing_print(h, cbret) < 0)
+            goto done;
+        cprintf(cbret, "</startup-timing>");
+    }
+    if (memory){
+        cprintf(cbret, "<memory xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (clixon_memstats_print(h, cbret) < 0)
+            goto done;
+        cprintf(cbret, "</memory>");
+    }
+    if (aprofile){
+        cprintf(cbret, "<alloc-profile xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (alloc_profile_print(cbret) < 0)
+            goto done;
+        cprintf(cbret, "</alloc-profile>");
+    }
     cprintf(cbret, "</rpc-reply>");
     retval = 0;
  done:
@@ -1658,7 +2321,10 @@ from_client_hello(clixon_handle  h,
 {
     int                  retval = -1;
     char                *val;
+    cxobj               *xcaps;
+    cxobj               *xc;
     struct client_entry *ce = (struct client_entry *)arg;
+    int                  shm = 0;
 
     if ((val = xml_find_type_value(xn, "cl", "transport", CX_ATTR)) != NULL){
         if ((ce->ce_transport = strdup(val)) == NULL){
@@ -1672,18 +2338,287 @@ from_client_hello(clixon_handle  h,
             goto done;
         }
     }
-    cprintf(cbret, "<hello xmlns=\"%s\"><session-id>%u</session-id></hello>",
-            NETCONF_BASE_NAMESPACE, ce->ce_id);
+    if (ce->ce_monitoring){ /* Reset cached monitoring session */
+        xml_free(ce->ce_monitoring);
+        ce->ce_monitoring = NULL;
+    }
+    if ((xcaps = xml_find_type(xn, NULL, "capabilities", CX_ELMNT)) != NULL){
+        xc = NULL;
+        while ((xc = xml_child_each(xcaps, xc, CX_ELMNT)) != NULL){
+            if (strcmp(xml_name(xc), "capability") != 0 ||
+                (val = xml_body(xc)) == NULL)
+                continue;
+            if (strcmp(val, CLIXON_IPC_BINARY_CAPABILITY) == 0)
+                ce->ce_binary = 1;
+            else if (strcmp(val, CLIXON_IPC_SHM_CAPABILITY) == 0 &&
+                     ce->ce_shm == 0 &&
+                     ce->ce_addr.sa_family == AF_UNIX &&
+                     clicon_option_bool(h, "CLICON_IPC_SHM") &&
+                     clixon_shm_supported())
+                shm = 1;
+        }
+    }
+    cprintf(cbret, "<hello xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    if (shm){
+        /* Client sends the channel next, see from_client */
+        cprintf(cbret, "<capabilities><capability>%s</capability></capabilities>",
+                CLIXON_IPC_SHM_CAPABILITY);
+        ce->ce_shm = 1;
+    }
+    cprintf(cbret, "<session-id>%u</session-id></hello>", ce->ce_id);
     retval = 0;
  done:
     return retval;
 }
 
+/*! Check if a client message should be queued since a commit is pending
+ *
+ * Read requests are served while a commit is pending, unless earlier messages of the
+ * same client are queued or it waits for the commit reply, so that replies are in order.
+ * While an autocommit batch is open, also autocommit edits are served.
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @param[in]  x    Request: <rpc>
+ * @retval     1    Queue message
+ * @retval     0    No
+ */
+static int
+from_client_queue_check(clixon_handle        h,
+                        struct client_entry *ce,
+                        cxobj               *x)
+{
+    cxobj *xe;
+    char  *rpc;
+    char  *attr;
+    int    pending;
+
+    if (ce->ce_queued || ce->ce_reply_pending)
+        return 1;
+    if (!(pending = candidate_commit_pending(h)) &&
+        !autocommit_batch_open(h))
+        return 0;
+    if ((xe = xml_child_i_type(x, 0, CX_ELMNT)) == NULL)
+        return 0;
+    rpc = xml_name(xe);
+    if (strcmp(rpc, "get") == 0 ||
+        strcmp(rpc, "get-config") == 0 ||
+        strcmp(rpc, "get-schema") == 0)
+        return 0;
+    if (!pending &&
+        strcmp(rpc, "edit-config") == 0 &&
+        (clicon_autocommit(h) ||
+         ((attr = xml_find_value(xe, "autocommit")) != NULL && strcmp(attr, "true") == 0)))
+        return 0;
+    return 1;
+}
+
+/*! Queue a client message until a pending commit is done
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @param[in]  msg  Message, consumed
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see backend_client_queue_run
+ */
+static int
+from_client_queue(clixon_handle        h,
+                  struct client_entry *ce,
+                  cbuf                *msg)
+{
+    struct client_msg *cm;
+    struct client_msg *list = NULL;
+
+    if ((cm = malloc(sizeof(*cm))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    memset(cm, 0, sizeof(*cm));
+    cm->cm_id = ce->ce_id;
+    cm->cm_msg = msg;
+    clicon_ptr_get(h, "client-msg-queue", (void**)&list);
+    ADDQ(cm, list);
+    if (clicon_ptr_set(h, "client-msg-queue", list) < 0)
+        return -1;
+    ce->ce_queued++;
+    clixon_debug(CLIXON_DBG_BACKEND, "queued message of ce_id:%u", ce->ce_id);
+    return 0;
+}
+
+/*! Dispatch queued client messages in order, until a commit is pending or batched again
+ *
+ * @param[in]  fd   No-op
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+backend_client_queue_run(int   fd,
+                         void *arg)
+{
+    int                  retval = -1;
+    clixon_handle        h = (clixon_handle)arg;
+    struct client_msg   *list = NULL;
+    struct client_msg   *cm;
+    struct client_entry *ce;
+    int                  ret;
+
+    while (!candidate_commit_pending(h) && !autocommit_batch_open(h)){
+        clicon_ptr_get(h, "client-msg-queue", (void**)&list);
+        if ((cm = list) == NULL)
+            break;
+        ce = ce_find_byid(backend_client_list(h), cm->cm_id);
+        if (ce && ce->ce_reply_pending) /* Wait for reply, see backend_client_resume */
+            break;
+        DELQ(cm, list, struct client_msg *);
+        if (clicon_ptr_set(h, "client-msg-queue", list) < 0)
+            goto done;
+        ret = 0;
+        if (ce != NULL){
+            ce->ce_queued--;
+            ret = from_client_msg(h, ce, cm->cm_msg, 0);
+        }
+        cbuf_free(cm->cm_msg);
+        free(cm);
+        if (ret < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send deferred reply to a client when a pending commit is done
+ *
+ * Then dispatch messages queued while the commit was pending
+ * @param[in]  h      Clixon handle
+ * @param[in]  id     Session id of client
+ * @param[in]  cbret  Reply
+ * @retval     0      OK, also if client has closed
+ * @retval    -1      Error
+ */
+int
+backend_client_reply(clixon_handle h,
+                     uint32_t      id,
+                     cbuf         *cbret)
+{
+    int                  retval = -1;
+    struct client_entry *ce;
+    cbuf                *cbce = NULL;
+    struct timeval       t;
+
+    if ((ce = ce_find_byid(backend_client_list(h), id)) != NULL && ce->ce_reply_pending){
+        ce->ce_reply_pending = 0;
+        if (ce_client_descr(ce, &cbce) < 0)
+            goto done;
+        if (send_msg_reply(ce->ce_s, cbce?cbuf_get(cbce):NULL, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
+            if (errno != EPIPE && errno != ECONNRESET)
+                goto done;
+            clixon_log(h, LOG_WARNING, "client rpc reset");
+        }
+    }
+    /* Dispatch queue outside of plugin event callback */
+    gettimeofday(&t, NULL);
+    if (clixon_event_reg_timeout(t, backend_client_queue_run, h, "client message queue") < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cbce)
+        cbuf_free(cbce);
+    return retval;
+}
+
+/*! Resume reading from a client when a reader thread has sent its reply
+ *
+ * Then dispatch messages queued for the client while a commit was pending
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  cbret  Reply to send if the thread failed before sending anything, or NULL
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see get_config_thread
+ */
+int
+backend_client_resume(clixon_handle        h,
+                      struct client_entry *ce,
+                      cbuf                *cbret)
+{
+    int            retval = -1;
+    cbuf          *cbce = NULL;
+    struct timeval t;
+
+    ce->ce_thread = 0;
+    ce->ce_reply_pending = 0;
+    if (ce->ce_rm){
+        retval = backend_client_rm(h, ce);
+        goto done;
+    }
+    if (cbret){
+        if (ce_client_descr(ce, &cbce) < 0)
+            goto done;
+        if (send_msg_reply(ce->ce_s, cbce?cbuf_get(cbce):NULL, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
+            if (errno != EPIPE && errno != ECONNRESET)
+                goto done;
+            clixon_log(h, LOG_WARNING, "client rpc reset");
+        }
+    }
+    if (clixon_event_reg_fd_prio(ce->ce_s, from_client, (void*)ce, "local netconf client socket",
+                                 clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
+        goto done;
+    gettimeofday(&t, NULL);
+    if (clixon_event_reg_timeout(t, backend_client_queue_run, h, "client message queue") < 0)
+        goto done;
+    /* Rpcs sent while the reader thread was running */
+    if (((ce->ce_pipe && clixon_msg_pipe_pending(ce->ce_pipe)) ||
+         clixon_shm_pending(ce->ce_s)) &&
+        from_client(ce->ce_s, ce) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cbce)
+        cbuf_free(cbce);
+    return retval;
+}
+
+/*! Output queue of a client has drained, read the client again
+ *
+ * @param[in]  s    Client socket
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_msg_outq_init
+ * @see CLICON_BACKEND_OUTPUT_HIWAT
+ */
+int
+backend_client_outq_resume(int   s,
+                           void *arg)
+{
+    clixon_handle        h = (clixon_handle)arg;
+    struct client_entry *ce;
+
+    for (ce = backend_client_list(h); ce; ce = ce->ce_next)
+        if (ce->ce_s == s)
+            break;
+    if (ce == NULL || !ce->ce_outq_full)
+        return 0;
+    ce->ce_outq_full = 0;
+    if (clixon_event_reg_fd_prio(s, from_client, (void*)ce, "local netconf client socket",
+                                 clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
+        return -1;
+    /* Rpcs already read */
+    if (((ce->ce_pipe && clixon_msg_pipe_pending(ce->ce_pipe)) ||
+         clixon_shm_pending(s)) &&
+        from_client(s, ce) < 0)
+        return -1;
+    return 0;
+}
+
 /*! An internal clixon NETCONF message has arrived from a local client. Receive and dispatch.
  *
  * @param[in]   h    Clixon handle
  * @param[in]   ce   Client entry (from)
- * @param[in]   msg  Incoming message
+ * @param[in]   msg  Incoming message, parsed in place: content is undefined after the call
+ * @param[in]   queue If set, queue message if a commit is pending, see from_client_queue_check
  * @retval      0    OK
  * @retval     -1    Error Terminates backend and is never called). Instead errors are
  *                   propagated back to client.
@@ -1691,7 +2626,8 @@ from_client_hello(clixon_handle  h,
 static int
 from_client_msg(clixon_handle        h,
                 struct client_entry *ce,
-                char                *msg)
+                cbuf                *msg,
+                int                  queue)
 {
     int                  retval = -1;
     cxobj               *xt = NULL;
@@ -1713,9 +2649,26 @@ from_client_msg(clixon_handle        h,
     char                *namespace = NULL;
     int                  nr = 0;
     cbuf                *cbce = NULL;
+    cbuf                *msgq = NULL; /* Copy of msg to queue */
+    int                  traced = 0;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
+#ifdef ALLOC_PROFILE
+    alloc_profile_begin();
+#endif
     yspec = clicon_dbspec_yang(h);
+    /* Message is parsed in place, keep a copy if it may be queued */
+    if (queue && (ce->ce_queued || ce->ce_reply_pending ||
+                  candidate_commit_pending(h) || autocommit_batch_open(h))){
+        if ((msgq = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (cbuf_append_buf(msgq, cbuf_get(msg), cbuf_len(msg)) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+    }
     /* Return netconf message. Should be filled in by the dispatch(sub) functions 
      * as wither rpc-error or by positive response.
      */
@@ -1726,7 +2679,7 @@ from_client_msg(clixon_handle        h,
     /* Decode msg from client -> xml top (ct) and session id 
      * Bind is a part of the decode function
      */
-    if ((ret = clixon_xml_parse_string(msg, YB_RPC, yspec, &xt, &xret)) < 0){
+    if ((ret = clixon_xml_parse_cbuf(NULL, msg, YB_RPC, yspec, &xt, &xret)) < 0){
         if (netconf_malformed_message(cbret, "XML parse error") < 0)
             goto done;
         goto reply;
@@ -1773,6 +2726,10 @@ from_client_msg(clixon_handle        h,
                 clixon_err(OE_UNIX, errno, "strdup");
                 goto done;
             }
+            if (ce->ce_monitoring){ /* Reset cached monitoring session */
+                xml_free(ce->ce_monitoring);
+                ce->ce_monitoring = NULL;
+            }
         }
     }
 #endif
@@ -1800,6 +2757,12 @@ from_client_msg(clixon_handle        h,
     }
 
     if (strcmp(rpcname, "rpc") == 0){
+        if (msgq && from_client_queue_check(h, ce, x)){
+            if (from_client_queue(h, ce, msgq) < 0)
+                goto done;
+            msgq = NULL;
+            goto ok;
+        }
     }
     else if (strcmp(rpcname, "hello") == 0){
         if ((ret = rpc_callback_call(h, x, ce, &nr, cbret)) < 0){
@@ -1849,8 +2812,14 @@ from_client_msg(clixon_handle        h,
     username = xml_find_value(x, "username");
     /* May be used by callbacks, etc */
     clicon_username_set(h, username);
+    ce->ce_reply_chunks = 0;
     while ((xe = xml_child_each(x, xe, CX_ELMNT)) != NULL) {
         rpc = xml_name(xe);
+        CLIXON_PROBE2(rpc__receive, ce->ce_id, rpc);
+        /* Continue trace of frontend request, if any */
+        if (traced == 0 &&
+            (traced = clixon_trace_start(h, xml_find_value(x, CLIXON_TRACE_ATTR), "backend rpc", rpc)) < 0)
+            goto done;
         if ((ye = xml_spec(xe)) == NULL){
             if (netconf_operation_not_supported(cbret, "protocol", rpc) < 0)
                 goto done;
@@ -1898,7 +2867,7 @@ from_client_msg(clixon_handle        h,
                 goto reply;
             }
             /* NACM rpc operation exec validation */
-            if ((ret = nacm_rpc(rpc, module, username, xnacm, cbret)) < 0)
+            if ((ret = nacm_rpc(h, rpc, module, username, xnacm, cbret)) < 0)
                 goto done;
             if (ret == 0){ /* Not permitted and cbret set */
                 ce->ce_out_rpc_errors++;
@@ -1908,6 +2877,12 @@ from_client_msg(clixon_handle        h,
         }
         clixon_err_reset();
         if ((ret = rpc_callback_call(h, xe, ce, &nr, cbret)) < 0){
+            if (ce->ce_reply_chunks){
+                /* Part of reply already sent, an error cannot be sent */
+                clixon_log(h, LOG_WARNING, "%s Reply partially sent, closing client:%s",
+                           __func__, clixon_err_reason());
+                shutdown(ce->ce_s, SHUT_RDWR);
+            }
             if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
                 goto done;
             clixon_log(h, LOG_NOTICE, "%s Error in rpc_callback_call:%s", __func__, xml_name(xe));
@@ -1934,6 +2909,8 @@ from_client_msg(clixon_handle        h,
                 goto done;
         }
     } /* while */
+    if (ce->ce_reply_pending) /* Reply when commit is done, see backend_client_reply */
+        goto ok;
  reply:
     if (cbuf_len(cbret) == 0)
         if (netconf_operation_failed(cbret, "application",
@@ -1944,7 +2921,7 @@ from_client_msg(clixon_handle        h,
        parse errors */
     if (ce_client_descr(ce, &cbce) < 0)
         goto done;
-    if (send_msg_reply(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
+    if (send_msg_reply(ce->ce_s, cbce?cbuf_get(cbce):NULL, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
         switch (errno){
         case EPIPE:
             /* man (2) write: 
@@ -1961,10 +2938,16 @@ from_client_msg(clixon_handle        h,
             goto done;
         }
     }
-    // ok:
+    CLIXON_PROBE2(rpc__reply, ce->ce_id, rpc);
+ ok:
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
+#ifdef ALLOC_PROFILE
+    alloc_profile_end(rpc);
+#endif
+    if (msgq)
+        cbuf_free(msgq);
     if (xnacm){
         xml_free(xnacm);
         if (clicon_nacm_cache_set(h, NULL) < 0)
@@ -1978,6 +2961,8 @@ from_client_msg(clixon_handle        h,
         cbuf_free(cbce);
     if (cbret)
         cbuf_free(cbret);
+    if (traced > 0)
+        clixon_trace_stop(h, retval);
     /* Sanity: log if clixon_err() is not called ! */
     if (retval < 0 && clixon_err_category() < 0)
         clixon_log(h, LOG_NOTICE, "%s: Internal error: No clixon_err call on RPC error (message: %s)",
@@ -1989,6 +2974,10 @@ from_client_msg(clixon_handle        h,
 /*! Internal clixon message has arrived from a client. Receive and dispatch.
  *
  * Internal clixon is NETCONF 1.1 chunked encoding
+ * A client may send several rpcs without waiting for replies. Messages already read are
+ * dispatched in order, until the socket is handed over to a reader thread.
+ * If the client was accepted for shared memory in its hello, its first input is the channel,
+ * and messages are then read from the channel, see CLICON_IPC_SHM.
  * @param[in]   s    Socket where message arrived. read from this.
  * @param[in]   arg  Client entry (from).
  * @retval      0    OK
@@ -2005,6 +2994,9 @@ from_client(int   s,
     int                  eof = 0;
     cbuf                *cbce = NULL;
     cbuf                *cb = NULL;
+    uint32_t             id;
+    int                  efd;
+    int                  ret;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     if (s != ce->ce_s){
@@ -2013,14 +3005,53 @@ from_client(int   s,
     }
     if (ce_client_descr(ce, &cbce) < 0)
         goto done;
-    if (clixon_msg_rcv11(s, cbuf_get(cbce), 0, &cb, &eof) < 0) /* XXX why not descr here? */
-        goto done;
-    if (eof){
-        backend_client_rm(h, ce);
-        netconf_monitoring_counter_inc(h, "dropped-sessions");
+    if (ce->ce_shm == 1){
+        /* First input after hello accepting shared memory is the channel */
+        if ((ret = clixon_shm_accept(s, &efd)) < 0){
+            clixon_log(h, LOG_WARNING, "%s: shared memory from session %u failed", __func__, ce->ce_id);
+            backend_client_rm(h, ce);
+            goto ok;
+        }
+        ce->ce_shm = 0;
+        if (ret == 1){
+            if (clixon_event_reg_fd_prio(efd, from_client_shm, (void*)ce,
+                                         "local netconf client shared memory",
+                                         clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
+                goto done;
+            ce->ce_shm = 2;
+            ce->ce_shm_efd = efd;
+        }
+        goto ok;
     }
-    else if (from_client_msg(h, ce, cbuf_get(cb)) < 0)
+    if (ce->ce_pipe == NULL &&
+        (ce->ce_pipe = clixon_msg_pipe_new()) == NULL)
         goto done;
+    id = ce->ce_id;
+    do {
+        if (clixon_msg_rcv11_pipe(s, cbce?cbuf_get(cbce):NULL, ce->ce_pipe, &cb, &eof) < 0)
+            goto done;
+        if (eof){
+            backend_client_rm(h, ce);
+            netconf_monitoring_counter_inc(h, "dropped-sessions");
+            ce = NULL;
+            break;
+        }
+        if (from_client_msg(h, ce, cb, 1) < 0)
+            goto done;
+        cbuf_free(cb);
+        cb = NULL;
+        /* Client may be removed, or socket handed to reader thread, see backend_client_resume */
+        if ((ce = ce_find_byid(backend_client_list(h), id)) == NULL ||
+            ce->ce_thread || ce->ce_rm)
+            break;
+    } while ((clixon_msg_pipe_pending(ce->ce_pipe) || clixon_shm_pending(s)) &&
+             !clixon_msg_outq_full(s));
+    if (ce && !ce->ce_thread && !ce->ce_rm && clixon_msg_outq_full(s)){
+        /* Do not read client until replies are written, see backend_client_outq_resume */
+        clixon_event_unreg_fd(s, from_client);
+        ce->ce_outq_full = 1;
+    }
+ ok:
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
@@ -2031,6 +3062,29 @@ from_client(int   s,
     return retval; /* -1 here terminates backend */
 }
 
+/*! Input in the shared memory channel of a client
+ *
+ * Not read while the client is paused, see backend_client_resume and
+ * backend_client_outq_resume
+ * @param[in]   fd   eventfd of channel
+ * @param[in]   arg  Client entry
+ * @retval      0    OK
+ * @retval     -1    Error
+ * @see CLICON_IPC_SHM
+ */
+static int
+from_client_shm(int   fd,
+                void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+
+    if (!clixon_shm_pending(ce->ce_s))
+        return 0;
+    if (ce->ce_thread || ce->ce_outq_full || ce->ce_rm)
+        return 0;
+    return from_client(ce->ce_s, ce);
+}
+
 /*! Init backend rpc: Set up standard netconf rpc callbacks
  *
  * @param[in]  h     Clixon handle
@@ -2111,6 +3165,17 @@ backend_rpc_init(clixon_handle h)
     if (rpc_callback_register(h, from_client_stats, NULL,
                               CLIXON_LIB_NS, "stats") < 0)
         goto done;
+    if (clixon_memstats_register("clients", backend_client_memstats, NULL) < 0)
+        goto done;
+    if (rpc_callback_register(h, from_client_datastore_change, NULL,
+                              CLIXON_LIB_NS, "datastore-change") < 0)
+        goto done;
+    if (rpc_callback_register(h, from_client_expand_values, NULL,
+                              CLIXON_LIB_NS, "expand-values") < 0)
+        goto done;
+    if (rpc_callback_register(h, from_client_datastore_diff, NULL,
+                              CLIXON_LIB_NS, "datastore-diff") < 0)
+        goto done;
     if (rpc_callback_register(h, from_client_restart_plugin, NULL,
                               CLIXON_LIB_NS, "restart-plugin") < 0)
         goto done;
@@ -43,6 +43,10 @@
 int backend_monitoring_state_get(clixon_handle h, yang_stmt *yspec, char *xpath, cvec *nsc, cxobj **xret, cxobj **xerr);
 int backend_client_rm(clixon_handle h, struct client_entry *ce);
 int from_client(int fd, void *arg);
+int backend_client_reply(clixon_handle h, uint32_t id, cbuf *cbret);
+int backend_client_resume(clixon_handle h, struct client_entry *ce, cbuf *cbret);
+int backend_client_outq_resume(int s, void *arg);
+int datastore_change_free(clixon_handle h);
 int backend_rpc_init(clixon_handle h);
 
 #endif  /* _BACKEND_CLIENT_H_ */
@@ -44,6 +44,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <inttypes.h>
 #include <errno.h>
 #include <signal.h>
 #include <fcntl.h>
@@ -71,6 +72,41 @@
 #include "backend_handle.h"
 #include "clixon_backend_commit.h"
 #include "backend_client.h"
+#include "backend_push.h"
+#include "backend_replica.h"
+#include "backend_startup.h"
+
+#ifdef LEAFREF_INDEX
+/*! Flag unchanged leafrefs of target referring to deleted or changed nodes
+ *
+ * The reverse leafref index is built from running if not valid
+ * @param[in]  h    Clixon handle
+ * @param[in]  td   Transaction data
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see LEAFREF_INDEX
+ */
+static int
+leafref_index_mark(clixon_handle       h,
+                   transaction_data_t *td)
+{
+    db_elmnt *de;
+    uint64_t  gen;
+
+    /* Content generation of running not known, check leafrefs by dependencies */
+    if ((de = clicon_db_elmnt_get(h, "running")) == NULL ||
+        (gen = de->de_gen) == 0)
+        return 0;
+    if (xml_leafref_index_gen(h) != gen &&
+        xml_leafref_index_build(h, td->td_src, gen) < 0)
+        return -1;
+    if (xml_leafref_index_mark(h, td->td_target, td->td_dvec, td->td_dlen) < 0)
+        return -1;
+    if (xml_leafref_index_mark(h, td->td_target, td->td_scvec, td->td_clen) < 0)
+        return -1;
+    return 0;
+}
+#endif /* LEAFREF_INDEX */
 
 /*! Key values are checked for validity independent of user-defined callbacks
  *
@@ -84,25 +120,55 @@
  * @param[in]   h       Clixon handle
  * @param[in]   yspec   Yang spec
  * @param[in]   td      Transaction data
+ * @param[in]   incr    Source of td is valid: only validate nodes affected by diffs
  * @param[out]  xret    Error XML tree. Free with xml_free after use
  * @retval      1       Validation OK       
  * @retval      0       Validation failed (with cbret set)
  * @retval     -1       Error
+ * @see VALIDATE_INCREMENTAL
  */
 static int
 generic_validate(clixon_handle       h,
                  yang_stmt          *yspec,
                  transaction_data_t *td,
+                 int                 incr,
                  cxobj             **xret)
 {
-    int        retval = -1;
-    cxobj     *x2;
-    int        i;
-    int        ret;
-    cbuf      *cb = NULL;
+    int            retval = -1;
+    cxobj         *x2;
+    int            i;
+    int            ret;
+    cbuf          *cb = NULL;
+    clicon_hash_t *chg = NULL;
+    int            frozen;
 
+    /* Trees are not modified while XPaths are evaluated */
+    frozen = xpath_parallel_frozen(1);
+#ifdef VALIDATE_INCREMENTAL
+    /* Names of all changed nodes */
+    if (incr){
+        if ((chg = clicon_hash_init()) == NULL)
+            goto done;
+        for (i=0; i<td->td_dlen; i++)
+            if (xml_yang_validate_changed(chg, td->td_dvec[i], 1) < 0)
+                goto done;
+        for (i=0; i<td->td_alen; i++)
+            if (xml_yang_validate_changed(chg, td->td_avec[i], 1) < 0)
+                goto done;
+        for (i=0; i<td->td_clen; i++){
+            if (xml_yang_validate_changed(chg, td->td_scvec[i], 0) < 0)
+                goto done;
+            if (xml_yang_validate_changed(chg, td->td_tcvec[i], 0) < 0)
+                goto done;
+        }
+#ifdef LEAFREF_INDEX
+        if (leafref_index_mark(h, td) < 0)
+            goto done;
+#endif
+    }
+#endif
     /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0)
+    if ((ret = xml_yang_validate_all_changed(h, td->td_target, chg, xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -126,6 +192,13 @@ generic_validate(clixon_handle       h,
     // ok:
     retval = 1;
  done:
+    xpath_parallel_frozen(frozen);
+#ifdef LEAFREF_INDEX
+    if (chg)
+        xml_leafref_index_unmark(h);
+#endif
+    if (chg)
+        clicon_hash_free(chg);
     if (cb)
         cbuf_free(cb);
     return retval;
@@ -138,12 +211,14 @@ generic_validate(clixon_handle       h,
  *
  * @param[in]  h       Clixon handle
  * @param[in]  td      Transaction data
+ * @param[in]  flag    If set, only compare nodes of target marked with flag, see xml_diff_marked
  * @retval     0   OK
  * @retval    -1   Error
  */
 static int
 compute_diffs(clixon_handle       h,
-              transaction_data_t *td)
+              transaction_data_t *td,
+              int                 flag)
 {
     int    retval = -1;
     int    i;
@@ -153,15 +228,16 @@ compute_diffs(clixon_handle       h,
     xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
     /* 3. Compute differences */
-    if (xml_diff(td->td_src,
-                 td->td_target,
-                 &td->td_dvec,      /* removed: only in running */
-                 &td->td_dlen,
-                 &td->td_avec,      /* added: only in candidate */
-                 &td->td_alen,
-                 &td->td_scvec,     /* changed: original values */
-                 &td->td_tcvec,     /* changed: wanted values */
-                 &td->td_clen) < 0)
+    if (xml_diff_marked(td->td_src,
+                        td->td_target,
+                        flag,
+                        &td->td_dvec,      /* removed: only in running */
+                        &td->td_dlen,
+                        &td->td_avec,      /* added: only in candidate */
+                        &td->td_alen,
+                        &td->td_scvec,     /* changed: original values */
+                        &td->td_tcvec,     /* changed: wanted values */
+                        &td->td_clen) < 0)
         goto done;
     if (clixon_debug_get() & CLIXON_DBG_DETAIL)
         transaction_dbg(h, CLIXON_DBG_DETAIL, td, __func__);
@@ -186,11 +262,215 @@ compute_diffs(clixon_handle       h,
         xml_flag_set(xn, XML_FLAG_CHANGE);
         xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
     }
+    /* Views of plugins subscribing to subtrees */
+    if (transaction_views_compute(h, td) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Given a transaction with empty src, set all of target as added without diffing
+ *
+ * Same result as compute_diffs when td_src has no children: every top-level child
+ * of target is added.
+ * @param[in]  h       Clixon handle
+ * @param[in]  td      Transaction data
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see compute_diffs
+ */
+static int
+compute_diffs_add(clixon_handle       h,
+                  transaction_data_t *td)
+{
+    int    retval = -1;
+    int    n;
+    cxobj *xn;
+
+    if ((n = xml_child_nr_type(td->td_target, CX_ELMNT)) > 0){
+        if ((td->td_avec = calloc(n, sizeof(cxobj *))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        xn = NULL;
+        while ((xn = xml_child_each(td->td_target, xn, CX_ELMNT)) != NULL){
+            td->td_avec[td->td_alen++] = xn;
+            xml_flag_set(xn, XML_FLAG_ADD);
+            xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_ADD);
+        }
+        xml_flag_set(td->td_target, XML_FLAG_CHANGE);
+    }
+    if (clixon_debug_get() & CLIXON_DBG_DETAIL)
+        transaction_dbg(h, CLIXON_DBG_DETAIL, td, __func__);
+    /* Views of plugins subscribing to subtrees */
+    if (transaction_views_compute(h, td) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Time of the last commit, and counters, for the stats RPC
+ */
+struct commit_timing {
+    uint64_t            ct_commits;  /* Number of commits */
+    uint64_t            ct_slow;     /* Number of commits slower than CLICON_BACKEND_COMMIT_SLOW */
+    uint64_t            ct_usec;     /* Total time of last commit */
+    uint64_t            ct_usec_sum; /* Total time of all commits */
+    uint64_t            ct_failed;   /* Number of commits that failed, eg validation */
+    uint64_t            ct_phase[TRANS_PHASE_NR]; /* Time per phase of last commit */
+    transaction_time_t *ct_timevec;  /* Callback time per plugin of last commit */
+    int                 ct_timelen;
+};
+
+/*! Get commit timing of handle, create if not found
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     ct  Commit timing
+ * @retval     NULL Error
+ */
+static struct commit_timing *
+commit_timing_get(clixon_handle h)
+{
+    struct commit_timing *ct = NULL;
+
+    clicon_ptr_get(h, "commit-timing", (void**)&ct);
+    if (ct == NULL){
+        if ((ct = calloc(1, sizeof(*ct))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            return NULL;
+        }
+        if (clicon_ptr_set(h, "commit-timing", ct) < 0){
+            free(ct);
+            return NULL;
+        }
+    }
+    return ct;
+}
+
+/*! Record time of a completed commit, and log it if slow
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  td  Transaction data
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see CLICON_BACKEND_COMMIT_SLOW
+ */
+static int
+commit_timing_done(clixon_handle       h,
+                   transaction_data_t *td)
+{
+    int                   retval = -1;
+    struct commit_timing *ct = NULL;
+    uint32_t              slow;
+    cbuf                 *cb = NULL;
+    int                   i;
+    int                   j;
+
+    if ((ct = commit_timing_get(h)) == NULL)
+        goto done;
+    ct->ct_commits++;
+    ct->ct_usec = transaction_clock() - td->td_start;
+    ct->ct_usec_sum += ct->ct_usec;
+    CLIXON_PROBE2(commit__done, td->td_id, ct->ct_usec);
+    memcpy(ct->ct_phase, td->td_usec, sizeof(ct->ct_phase));
+    if (ct->ct_timevec)
+        free(ct->ct_timevec);
+    ct->ct_timevec = NULL;
+    ct->ct_timelen = 0;
+    if (td->td_timelen){
+        if ((ct->ct_timevec = calloc(td->td_timelen, sizeof(*ct->ct_timevec))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        memcpy(ct->ct_timevec, td->td_timevec, td->td_timelen*sizeof(*ct->ct_timevec));
+        ct->ct_timelen = td->td_timelen;
+    }
+    slow = clicon_option_int(h, "CLICON_BACKEND_COMMIT_SLOW");
+    if (slow == 0 || ct->ct_usec < (uint64_t)slow*1000)
+        goto ok;
+    ct->ct_slow++;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    for (i=0; i<TRANS_PHASE_NR; i++)
+        if (ct->ct_phase[i])
+            cprintf(cb, " %s=%" PRIu64, transaction_phase_str(i), ct->ct_phase[i]);
+    for (j=0; j<ct->ct_timelen; j++)
+        for (i=0; i<TRANS_PHASE_NR; i++)
+            if (ct->ct_timevec[j].tt_usec[i])
+                cprintf(cb, " %s:%s=%" PRIu64,
+                        clixon_plugin_name_get(ct->ct_timevec[j].tt_plugin),
+                        transaction_phase_str(i), ct->ct_timevec[j].tt_usec[i]);
+    clixon_log(h, LOG_WARNING, "Slow commit %" PRIu64 " usec:%s", ct->ct_usec, cbuf_get(cb));
+ ok:
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
+/*! Print time of the last commit as XML of the clixon-lib stats RPC
+ *
+ * @param[in]  h     Clixon handle
+ * @param[out] cb    CLIgen buffer, <commit-timing> children are appended
+ * @retval     0     OK
+ */
+int
+commit_timing_print(clixon_handle h,
+                    cbuf         *cb)
+{
+    struct commit_timing *ct = NULL;
+    int                   i;
+    int                   j;
+
+    clicon_ptr_get(h, "commit-timing", (void**)&ct);
+    if (ct == NULL){
+        cprintf(cb, "<commits>0</commits>");
+        return 0;
+    }
+    cprintf(cb, "<commits>%" PRIu64 "</commits>", ct->ct_commits);
+    cprintf(cb, "<slow-commits>%" PRIu64 "</slow-commits>", ct->ct_slow);
+    cprintf(cb, "<failed-commits>%" PRIu64 "</failed-commits>", ct->ct_failed);
+    cprintf(cb, "<usec>%" PRIu64 "</usec>", ct->ct_usec);
+    cprintf(cb, "<total-usec>%" PRIu64 "</total-usec>", ct->ct_usec_sum);
+    for (i=0; i<TRANS_PHASE_NR; i++)
+        cprintf(cb, "<phase><name>%s</name><usec>%" PRIu64 "</usec></phase>",
+                transaction_phase_str(i), ct->ct_phase[i]);
+    for (j=0; j<ct->ct_timelen; j++){
+        cprintf(cb, "<plugin><name>%s</name>", clixon_plugin_name_get(ct->ct_timevec[j].tt_plugin));
+        for (i=0; i<TRANS_PHASE_NR; i++)
+            if (ct->ct_timevec[j].tt_usec[i])
+                cprintf(cb, "<phase><name>%s</name><usec>%" PRIu64 "</usec></phase>",
+                        transaction_phase_str(i), ct->ct_timevec[j].tt_usec[i]);
+        cprintf(cb, "</plugin>");
+    }
+    return 0;
+}
+
+/*! Free time of the last commit
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ */
+int
+commit_timing_free(clixon_handle h)
+{
+    struct commit_timing *ct = NULL;
+
+    clicon_ptr_get(h, "commit-timing", (void**)&ct);
+    if (ct != NULL){
+        if (ct->ct_timevec)
+            free(ct->ct_timevec);
+        free(ct);
+    }
+    clicon_ptr_del(h, "commit-timing");
+    return 0;
+}
+
 /*! Common startup validation
  *
  * Get db, upgrade it w potential transformed XML, populate it w yang spec,
@@ -262,8 +542,9 @@ startup_common(clixon_handle       h,
     else {
         /* Get the startup datastore WITHOUT binding to YANG, sorting and default setting.
          * It is done below, later in this function
+         * The tree is taken from the cache, not copied, since startup is read once
          */
-        if (xmldb_get0(h, db, YB_NONE, NULL, "/", 0, 0, &xt, msdiff, &xerr) < 0)
+        if (xmldb_get_take(h, db, YB_NONE, &xt, msdiff, &xerr) < 0)
             goto done;
     }
     clixon_debug_xml(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, xt, "startup");
@@ -277,6 +558,7 @@ startup_common(clixon_handle       h,
         goto done;
     }
     clixon_debug(CLIXON_DBG_BACKEND, "Reading startup config done");
+    startup_timing_phase(h, "startup-read");
     /* Clear flags xpath for get */
     xml_apply0(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
@@ -294,6 +576,7 @@ startup_common(clixon_handle       h,
             goto fail;
         }
     }
+    startup_timing_phase(h, "startup-upgrade");
     /* Print upgraded db: -q backend switch for debugging/ showing upgraded config only */
     if (clicon_quit_upgrade_get(h) == 1){
         /* bind yang */
@@ -354,32 +637,45 @@ startup_common(clixon_handle       h,
     /* Apply default values (removed in clear function) */
     if (xml_default_recurse(xt, 0, 0) < 0)
         goto done;
+    startup_timing_phase(h, "startup-bind");
     /* Handcraft transition with with only add tree */
     td->td_target = xt;
     xt = NULL;
-    if (compute_diffs(h, td) < 0)
+    transaction_timing_add(td, TRANS_PHASE_GET_TARGET);
+    /* Empty running: all of startup is added, no need to diff */
+    if (xml_child_nr(td->td_src) == 0){
+        if (compute_diffs_add(h, td) < 0)
+            goto done;
+    }
+    else if (compute_diffs(h, td, 0) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_DIFF);
     /* 4. Call plugin transaction start callbacks */
     if (plugin_transaction_begin_all(h, td) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_BEGIN);
 
     /* 5. Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
     clixon_debug(CLIXON_DBG_BACKEND, "Validating startup %s", db);
-    if ((ret = generic_validate(h, yspec, td, &xret)) < 0)
+    if ((ret = generic_validate(h, yspec, td, 0, &xret)) < 0)
         goto done;
     if (ret == 0){
         if (clixon_xml2cbuf1(cbret, xret, 0, 0, NULL, -1, 0, 0) < 0)
             goto done;
         goto fail; /* STARTUP_INVALID */
     }
+    transaction_timing_add(td, TRANS_PHASE_VALIDATE);
     /* 6. Call plugin transaction validate callbacks */
     if (plugin_transaction_validate_all(h, td) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_PLUGIN_VALIDATE);
 
     /* 7. Call plugin transaction complete callbacks */
     if (plugin_transaction_complete_all(h, td) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_COMPLETE);
+    startup_timing_phase(h, "startup-validate");
  ok:
     retval = 1;
  done:
@@ -479,9 +775,12 @@ startup_commit(clixon_handle h,
     /* 8. Call plugin transaction commit callbacks */
     if (plugin_transaction_commit_all(h, td) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_COMMIT);
     /* After commit, make a post-commit call (sure that all plugins have committed) */
     if (plugin_transaction_commit_done_all(h, td) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_COMMIT_DONE);
+    startup_timing_phase(h, "startup-commit");
     /* [Delete and] create running db */
     if (xmldb_exists(h, "running") == 1){
         if (xmldb_delete(h, "running") != 0 && errno != ENOENT)
@@ -519,11 +818,16 @@ startup_commit(clixon_handle h,
             goto fail;
 #endif
     }
+    transaction_timing_add(td, TRANS_PHASE_COPY);
     /* 10. Call plugin transaction end callbacks
      * XXX Issue: diff may include default values, but these are removed ^
      * If diff is read by end callback, they may reference freed nodes.
      */
     plugin_transaction_end_all(h, td);
+    transaction_timing_add(td, TRANS_PHASE_END);
+    startup_timing_phase(h, "startup-write");
+    if (commit_timing_done(h, td) < 0)
+        goto done;
     retval = 1;
  done:
 #ifdef STARTUP_COMMIT_REORDER
@@ -548,6 +852,7 @@ startup_commit(clixon_handle h,
  * @param[in]  h       Clixon handle
  * @param[in]  db      The (candidate) database. The wanted backend state
  * @param[in]  td      Transaction data
+ * @param[in]  incr    Running is valid: only validate nodes affected by diffs
  * @param[out] xret    Error XML tree, if retval is 0. Free with xml_free after use
  * @retval     1       Validation OK       
  * @retval     0       Validation failed (with xret set)
@@ -560,27 +865,36 @@ static int
 validate_common(clixon_handle       h,
                 char               *db,
                 transaction_data_t *td,
+                int                 incr,
                 cxobj             **xret)
 {
     int         retval = -1;
     yang_stmt  *yspec;
     int         ret;
+    int         flag = 0;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clixon_err(OE_FATAL, 0, "No DB_SPEC");
         goto done;
     }
+#ifdef XMLDB_EDIT_MARK
+    /* Check before cache access below resets the edit marks */
+    if (xmldb_edit_marked(h, db, "running") == 1)
+        flag = XML_FLAG_EDIT;
+#endif
     if (xmldb_cache_get(h, db) != NULL){
         if (xmldb_populate(h, db) < 0)
             goto done;
         if (xmldb_write_cache2file(h, db) < 0)
             goto done;
     }
+    transaction_timing_add(td, TRANS_PHASE_PERSIST);
     /* This is the state we are going to */
     if ((ret = xmldb_get0(h, db, YB_MODULE, NULL, "/", 0, 0, &td->td_target, NULL, xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
+    transaction_timing_add(td, TRANS_PHASE_GET_TARGET);
     /* Clear flags xpath for get */
     xml_apply0(td->td_target, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
@@ -590,26 +904,32 @@ validate_common(clixon_handle       h,
         goto done;
     if (ret == 0)
         goto fail;
-    if (compute_diffs(h, td) < 0)
+    transaction_timing_add(td, TRANS_PHASE_GET_SOURCE);
+    if (compute_diffs(h, td, flag) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_DIFF);
     /* 4. Call plugin transaction start callbacks */
     if (plugin_transaction_begin_all(h, td) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_BEGIN);
 
     /* 5. Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, xret)) < 0)
+    if ((ret = generic_validate(h, yspec, td, incr, xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
+    transaction_timing_add(td, TRANS_PHASE_VALIDATE);
 
     /* 6. Call plugin transaction validate callbacks */
     if (plugin_transaction_validate_all(h, td) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_PLUGIN_VALIDATE);
 
     /* 7. Call plugin transaction complete callbacks */
     if (plugin_transaction_complete_all(h, td) < 0)
         goto done;
+    transaction_timing_add(td, TRANS_PHASE_COMPLETE);
     retval = 1;
  done:
     return retval;
@@ -645,8 +965,8 @@ candidate_validate(clixon_handle h,
     /* 1. Start transaction */
     if ((td = transaction_new()) == NULL)
         goto done;
-        /* Common steps (with commit) */
-    if ((ret = validate_common(h, db, td, &xret)) < 0){
+        /* Common steps (with commit), validate whole candidate */
+    if ((ret = validate_common(h, db, td, 0, &xret)) < 0){
         /* A little complex due to several sources of validation fails or errors.
          * (1) xerr is set -> translate to cbret; (2) cbret set use that; otherwise
          * use clixon_err. 
@@ -685,45 +1005,38 @@ candidate_validate(clixon_handle h,
     goto done;
 }
 
-/*! Do a diff between candidate and running, then start a commit transaction
+/*! Start a commit transaction: diff and validate candidate and running and call commit callbacks
  *
- * The code reverts changes if the commit fails. But if the revert
- * fails, we just ignore the errors and proceed. Maybe we should
- * do something more drastic?
  * @param[in]  h          Clixon handle
  * @param[in]  xe         Request: <rpc><xn></rpc>  (or NULL)
  * @param[in]  db         A candidate database, not necessarily "candidate"
  * @param[in]  myid       Client id of triggering incoming message (or 0)
- * @param[in]  vlev       Validation level (0: full validation) // obsolete
+ * @param[in]  td         Transaction data
  * @param[out] cbret      Return xml tree, eg <rpc-reply>..., <rpc-error.. (if retval = 0)
- * @retval     1          Validation OK       
+ * @retval     1          OK, commit callbacks called, some may be pending
  * @retval     0          Validation failed (with cbret set)
  * @retval    -1          Error - or validation failed 
- * @see startup_commit  for commit on startup
+ * @see candidate_commit_end  for the remaining steps
  */
-int
-candidate_commit(clixon_handle  h,
-                 cxobj         *xe,
-                 char          *db,
-                 uint32_t       myid,
-                 validate_level vlev, // obsolete
-                 cbuf          *cbret)
+static int
+candidate_commit_begin(clixon_handle       h,
+                       cxobj              *xe,
+                       char               *db,
+                       uint32_t            myid,
+                       transaction_data_t *td,
+                       cbuf               *cbret)
 {
     int                 retval = -1;
-    transaction_data_t *td = NULL;
     int                 ret;
     cxobj              *xret = NULL;
     yang_stmt          *yspec;
 
     clixon_debug(CLIXON_DBG_DATASTORE, "db: %s", db);
-    /* 1. Start transaction */
-    if ((td = transaction_new()) == NULL)
-        goto done;
-
+    CLIXON_PROBE1(commit__start, td->td_id);
     /* Common steps (with validate). Load candidate and running and compute diffs
      * Note this is only call that uses 3-values
      */
-    if ((ret = validate_common(h, db, td, &xret)) < 0)
+    if ((ret = validate_common(h, db, td, 1, &xret)) < 0)
         goto done;
 
     /* If the confirmed-commit feature is enabled, execute phase 2:
@@ -752,15 +1065,82 @@ candidate_commit(clixon_handle  h,
         goto fail;
     }
     /* 7. Call plugin transaction commit callbacks */
+    transaction_timing_add(td, TRANS_PHASE_NR);
     if (plugin_transaction_commit_all(h, td) < 0)
         goto done;
+    retval = 1;
+ done:
+    if (xret)
+        xml_free(xret);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Terminate a commit transaction when all commit callbacks are done
+ *
+ * @param[in]  h          Clixon handle
+ * @param[in]  db         A candidate database, not necessarily "candidate"
+ * @param[in]  td         Transaction data
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see candidate_commit_begin
+ */
+static int
+candidate_commit_end(clixon_handle       h,
+                     char               *db,
+                     transaction_data_t *td)
+{
+    int                 retval = -1;
+    transaction_data_t *tv;
+    int                 i;
+    int                 moved;
+#ifdef LEAFREF_INDEX
+    db_elmnt           *de;
+    int                 lrindex = 0;
+#endif
+
+    /* Pending commit callbacks that failed */
+    if (plugin_transaction_pending_end(h, td) < 0)
+        goto done;
+    transaction_timing_add(td, TRANS_PHASE_COMMIT);
     /* After commit, make a post-commit call (sure that all plugins have committed) */
     if (plugin_transaction_commit_done_all(h, td) < 0)
         goto done;
+    /* On-change push of the diff, see CLICON_STREAM_ON_CHANGE */
+    if (backend_push_commit(h, td) < 0)
+        goto done;
+    /* Stream the diff to the standby backend, see CLICON_BACKEND_REPLICA */
+    if (backend_replica_commit(h, td) < 0)
+        goto done;
+    transaction_timing_add(td, TRANS_PHASE_COMMIT_DONE);
+#ifdef LEAFREF_INDEX
+    /* Update reverse leafref index of running with diff, invalid until running is copied */
+    if ((de = clicon_db_elmnt_get(h, "running")) != NULL &&
+        de->de_gen != 0 &&
+        xml_leafref_index_gen(h) == de->de_gen){
+        if (xml_leafref_index_gen_set(h, 0) < 0)
+            goto done;
+        if (xml_leafref_index_update(h, td->td_dvec, td->td_dlen, 0) < 0 ||
+            xml_leafref_index_update(h, td->td_scvec, td->td_clen, 0) < 0 ||
+            xml_leafref_index_update(h, td->td_tcvec, td->td_clen, 1) < 0 ||
+            xml_leafref_index_update(h, td->td_avec, td->td_alen, 1) < 0)
+            goto done;
+        lrindex = 1;
+    }
+#endif
+    /* Pending confirmed-commit: old running becomes the rollback database */
+    if ((moved = confirmed_commit_snapshot(h)) < 0)
+        goto done;
     /* 8. Success: Copy candidate to running 
      */
-    if (xmldb_copy(h, db, "running") < 0)
+    if (xmldb_copy(h, db, "running") < 0){
+        /* Running was moved out, put it back so that running is not left empty */
+        if (moved)
+            confirmed_commit_snapshot_restore(h);
         goto done;
+    }
     /* Remove system-only-config data from destination cache */
     if (clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")){
         xmldb_clear(h, "running");
@@ -769,6 +1149,13 @@ candidate_commit(clixon_handle  h,
 #endif
     }
     xmldb_modified_set(h, db, 0); /* reset dirty bit */
+#ifdef LEAFREF_INDEX
+    if (lrindex &&
+        (de = clicon_db_elmnt_get(h, "running")) != NULL &&
+        xml_leafref_index_gen_set(h, de->de_gen) < 0)
+        goto done;
+#endif
+    transaction_timing_add(td, TRANS_PHASE_COPY);
     /* Here pointers to old (source) tree are obsolete */
     if (td->td_dvec){
         td->td_dlen = 0;
@@ -779,8 +1166,70 @@ candidate_commit(clixon_handle  h,
         free(td->td_scvec);
         td->td_scvec = NULL;
     }
+    for (i=0; i<td->td_nviews; i++){
+        tv = td->td_views[i];
+        if (tv->td_dvec){
+            tv->td_dlen = 0;
+            free(tv->td_dvec);
+            tv->td_dvec = NULL;
+        }
+        if (tv->td_scvec){
+            free(tv->td_scvec);
+            tv->td_scvec = NULL;
+        }
+    }
     /* 9. Call plugin transaction end callbacks */
     plugin_transaction_end_all(h, td);
+    transaction_timing_add(td, TRANS_PHASE_END);
+    if (commit_timing_done(h, td) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Do a diff between candidate and running, then start a commit transaction
+ *
+ * The code reverts changes if the commit fails. But if the revert
+ * fails, we just ignore the errors and proceed. Maybe we should
+ * do something more drastic?
+ * @param[in]  h          Clixon handle
+ * @param[in]  xe         Request: <rpc><xn></rpc>  (or NULL)
+ * @param[in]  db         A candidate database, not necessarily "candidate"
+ * @param[in]  myid       Client id of triggering incoming message (or 0)
+ * @param[in]  vlev       Validation level (0: full validation) // obsolete
+ * @param[out] cbret      Return xml tree, eg <rpc-reply>..., <rpc-error.. (if retval = 0)
+ * @retval     1          Validation OK       
+ * @retval     0          Validation failed (with cbret set)
+ * @retval    -1          Error - or validation failed 
+ * @see startup_commit  for commit on startup
+ * @see from_client_commit  for asynchronous commit
+ */
+int
+candidate_commit(clixon_handle  h,
+                 cxobj         *xe,
+                 char          *db,
+                 uint32_t       myid,
+                 validate_level vlev, // obsolete
+                 cbuf          *cbret)
+{
+    int                   retval = -1;
+    transaction_data_t   *td = NULL;
+    int                   ret;
+    int                   traced;
+    struct commit_timing *ct;
+
+    if ((traced = clixon_trace_span_begin("commit", db)) < 0)
+        goto done;
+    /* 1. Start transaction */
+    if ((td = transaction_new()) == NULL)
+        goto done;
+    if ((ret = candidate_commit_begin(h, xe, db, myid, td, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (candidate_commit_end(h, db, td) < 0)
+        goto done;
     retval = 1;
  done:
     /* In case of failure (or error), call plugin transaction termination callbacks */
@@ -789,8 +1238,149 @@ candidate_commit(clixon_handle  h,
             plugin_transaction_abort_all(h, td);
         transaction_free1(td, 1);
     }
-    if (xret)
-        xml_free(xret);
+    if (retval < 1 && (ct = commit_timing_get(h)) != NULL)
+        ct->ct_failed++;
+    if (traced > 0)
+        clixon_trace_span_end(h, retval);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Commit with pending commit callbacks, whose client reply is deferred
+ */
+struct commit_pending {
+    transaction_data_t *cp_td;  /* Transaction */
+    uint32_t            cp_id;  /* Session id of client */
+};
+
+/*! Check if a commit with pending commit callbacks is in progress
+ *
+ * Then the client messages that are not read requests should be queued
+ * @param[in]  h   Clixon handle
+ * @retval     1   A commit is pending
+ * @retval     0   No
+ * @see CLICON_BACKEND_COMMIT_ASYNC
+ */
+int
+candidate_commit_pending(clixon_handle h)
+{
+    struct commit_pending *cc = NULL;
+
+    clicon_ptr_get(h, "commit-pending-struct", (void**)&cc);
+    return cc != NULL;
+}
+
+/*! All pending commit callbacks are done, terminate the commit and reply to client
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  td  Transaction data
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see transaction_pending_done
+ */
+static int
+candidate_commit_pending_done(clixon_handle       h,
+                              transaction_data_t *td)
+{
+    int                    retval = -1;
+    struct commit_pending *cc = NULL;
+    cbuf                  *cbret = NULL;
+    int                    ret;
+
+    clicon_ptr_get(h, "commit-pending-struct", (void**)&cc);
+    if (cc == NULL || cc->cp_td != td){
+        clixon_err(OE_CFG, EFAULT, "No pending commit");
+        cc = NULL;
+        goto done;
+    }
+    clicon_ptr_del(h, "commit-pending-struct");
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = candidate_commit_end(h, "candidate", td)) < 0){
+        clixon_debug(CLIXON_DBG_BACKEND, "Commit candidate failed");
+        plugin_transaction_abort_all(h, td);
+        if (clixon_plugin_report_err(h, cbret) < 0)
+            goto done;
+    }
+    else{
+        if (clicon_option_bool(h, "CLICON_AUTOLOCK"))
+            xmldb_unlock(h, "candidate");
+        cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+    }
+    if (backend_client_reply(h, cc->cp_id, cbret) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cc){
+        transaction_free1(cc->cp_td, 1);
+        free(cc);
+    }
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Commit candidate where commit callbacks may be pending
+ *
+ * If commit callbacks are pending, the reply to the client is deferred until they are done
+ * @param[in]  h       Clixon handle
+ * @param[in]  ce      Client entry
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     2       Pending, reply when done
+ * @retval     1       Committed
+ * @retval     0       Validation failed (with cbret set)
+ * @retval    -1       Error
+ * @see transaction_pending
+ */
+static int
+from_client_commit_async(clixon_handle        h,
+                         struct client_entry *ce,
+                         cxobj               *xe,
+                         cbuf                *cbret)
+{
+    int                    retval = -1;
+    transaction_data_t    *td = NULL;
+    struct commit_pending *cc;
+    int                    ret;
+
+    if ((td = transaction_new()) == NULL)
+        goto done;
+    td->td_async = 1;
+    if ((ret = candidate_commit_begin(h, xe, "candidate", ce->ce_id, td, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    td->td_async = 0;
+    if (td->td_pending){
+        if ((cc = malloc(sizeof(*cc))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        cc->cp_td = td;
+        cc->cp_id = ce->ce_id;
+        td->td_pendfn = candidate_commit_pending_done;
+        if (clicon_ptr_set(h, "commit-pending-struct", cc) < 0){
+            free(cc);
+            goto done;
+        }
+        ce->ce_reply_pending = 1;
+        retval = 2;
+        goto done;
+    }
+    if (candidate_commit_end(h, "candidate", td) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (td && retval != 2){
+        if (retval < 1)
+            plugin_transaction_abort_all(h, td);
+        transaction_free1(td, 1);
+    }
     return retval;
  fail:
     retval = 0;
@@ -838,6 +1428,7 @@ from_client_commit(clixon_handle h,
     cbuf                *cbx = NULL; /* Assist cbuf */
     int                  ret;
     yang_stmt           *yspec;
+    int                  private;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL) {
         clixon_err(OE_YANG, ENOENT, "No yang spec");
@@ -849,8 +1440,10 @@ from_client_commit(clixon_handle h,
         if (ret == 0)
             goto ok;
     }
+    /* Private candidate is not locked by other clients */
+    private = clicon_option_bool(h, "CLICON_XMLDB_PRIVATE_CANDIDATE");
     /* Check if target locked by other client */
-    iddb = xmldb_islocked(h, "candidate");
+    iddb = private ? 0 : xmldb_islocked(h, "candidate");
     if (iddb && myid != iddb){
         if ((cbx = cbuf_new()) == NULL){
             clixon_err(OE_XML, errno, "cbuf_new");
@@ -870,13 +1463,20 @@ from_client_commit(clixon_handle h,
             goto done;
         goto ok;
     }
-    if ((ret = candidate_commit(h, xe, "candidate", myid, 0, cbret)) < 0){ /* Assume validation fail, nofatal */
+    if (private)
+        ret = private_candidate_commit(h, ce, xe, cbret);
+    else if (clicon_option_bool(h, "CLICON_BACKEND_COMMIT_ASYNC"))
+        ret = from_client_commit_async(h, ce, xe, cbret);
+    else
+        ret = candidate_commit(h, xe, "candidate", myid, 0, cbret);
+    if (ret < 0){ /* Assume validation fail, nofatal */
         clixon_debug(CLIXON_DBG_BACKEND, "Commit candidate failed");
-        if (ret < 0)
-            if (clixon_plugin_report_err(h, cbret) < 0)
-                goto done;
+        if (clixon_plugin_report_err(h, cbret) < 0)
+            goto done;
         goto ok;
     }
+    if (ret == 2) /* Commit callbacks pending, reply is deferred */
+        goto ok;
     if (clicon_option_bool(h, "CLICON_AUTOLOCK"))
         xmldb_unlock(h, "candidate");
     if (ret == 0)
@@ -915,6 +1515,13 @@ from_client_discard_changes(clixon_handle h,
     uint32_t             iddb;
     cbuf                *cbx = NULL; /* Assist cbuf */
 
+    /* Private candidate: drop edits and share running again */
+    if (clicon_option_bool(h, "CLICON_XMLDB_PRIVATE_CANDIDATE")){
+        if (private_candidate_discard(h, ce) < 0)
+            goto done;
+        cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+        goto ok;
+    }
     /* Check if target locked by other client */
     iddb = xmldb_islocked(h, "candidate");
     if (iddb && myid != iddb){
@@ -963,9 +1570,10 @@ from_client_validate(clixon_handle h,
                      void         *arg,
                      void         *regarg)
 {
-    int   retval = -1;
-    int   ret;
-    char *db;
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    int                  ret;
+    char                *db;
 
     clixon_debug(CLIXON_DBG_BACKEND, "");
     if ((db = netconf_db_find(xe, "source")) == NULL){
@@ -973,6 +1581,8 @@ from_client_validate(clixon_handle h,
             goto done;
         goto ok;
     }
+    if (private_candidate_db(h, ce, db, 0, &db) < 0)
+        goto done;
     if ((ret = candidate_validate(h, db, cbret)) < 0)
         goto done;
     if (ret == 1)
@@ -1074,7 +1684,7 @@ from_client_restart_one(clixon_handle    h,
         goto fail;
     /* Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, &xerr)) < 0)
+    if ((ret = generic_validate(h, yspec, td, 0, &xerr)) < 0)
         goto done;
     if (ret == 0){
         if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
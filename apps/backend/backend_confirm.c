@@ -84,6 +84,7 @@ struct confirmed_commit {
     uint32_t    cc_session_id;       /* the session_id of the client that gave no <persist> value */
     int        (*cc_fn)(int, void*); /* function pointer for rollback event (rollback_fn()) */
     void        *cc_arg;             /* clixon_handle that will be passed to rollback_fn() */
+    int          cc_snapshot;        /* rollback db is taken from running on next commit */
 };
 
 int
@@ -222,6 +223,87 @@ confirmed_commit_fn_arg_set(clixon_handle h,
     return 0;
 }
 
+static int
+confirmed_commit_snapshot_set(clixon_handle h,
+                              int           snapshot)
+{
+    struct confirmed_commit *cc = NULL;
+
+    clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
+    cc->cc_snapshot = snapshot;
+    return 0;
+}
+
+/*! Take the rollback database from running just before it is replaced by a commit
+ *
+ * A confirmed-commit only marks that the rollback database is needed. The old running is
+ * moved to rollback when a commit is about to overwrite it, instead of copying running
+ * when the confirmed-commit begins.
+ * As long as no commit has succeeded running is still the configuration to roll back to.
+ * If the commit then fails to write running, restore it with confirmed_commit_snapshot_restore
+ * @param[in]  h   Clixon handle
+ * @retval     1   OK, running moved to rollback
+ * @retval     0   OK, rollback not needed or already taken
+ * @retval    -1   Error
+ * @see candidate_commit_end
+ */
+int
+confirmed_commit_snapshot(clixon_handle h)
+{
+    struct confirmed_commit *cc = NULL;
+
+    clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
+    if (cc == NULL || cc->cc_snapshot == 0)
+        return 0;
+    cc->cc_snapshot = 0;
+    if (xmldb_move(h, "running", "rollback") < 0){
+        clixon_err(OE_DAEMON, 0, "there was an error while moving the running configuration to rollback database.");
+        return -1;
+    }
+    return 1;
+}
+
+/*! Move the rollback database back to running after a commit failed to write running
+ *
+ * Undoes confirmed_commit_snapshot, the rollback database is again taken by the next commit
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see confirmed_commit_snapshot
+ */
+int
+confirmed_commit_snapshot_restore(clixon_handle h)
+{
+    struct confirmed_commit *cc = NULL;
+
+    clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
+    if (xmldb_move(h, "rollback", "running") < 0){
+        clixon_err(OE_DAEMON, 0, "there was an error while restoring the running configuration from rollback database.");
+        return -1;
+    }
+    if (cc)
+        cc->cc_snapshot = 1;
+    return 0;
+}
+
+/*! Rollback database is needed but no commit has taken it, make it from running
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+confirmed_commit_snapshot_copy(clixon_handle h)
+{
+    struct confirmed_commit *cc = NULL;
+
+    clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
+    if (cc->cc_snapshot == 0)
+        return 0;
+    cc->cc_snapshot = 0;
+    return xmldb_copy(h, "running", "rollback");
+}
+
 /*! Return if confirmed tag found
  *
  * @param[in]  xe  Commit rpc xml
@@ -391,6 +473,7 @@ cancel_confirmed_commit(clixon_handle h)
     }
 
     confirmed_commit_state_set(h, INACTIVE);
+    confirmed_commit_snapshot_set(h, 0);
 
     if (xmldb_delete(h, "rollback") < 0)
         clixon_err(OE_DB, 0, "Error deleting the rollback configuration");
@@ -559,7 +642,7 @@ handle_confirmed_commit(clixon_handle h,
          *
          * |    edit
          * |    | confirmed-commit
-         * |    | copy t=0 running to rollback
+         * |    | move t=0 running to rollback
          * |    | | edit
          * |    | | | both
          * |    | | | | edit
@@ -587,11 +670,8 @@ handle_confirmed_commit(clixon_handle h,
             clixon_err(OE_DAEMON, 0, "there was an error while checking existence of the rollback database");
             goto done;
         } else if (db_exists == 0) {
-            // db does not yet exists
-            if (xmldb_copy(h, "running", "rollback") < 0) {
-                clixon_err(OE_DAEMON, 0, "there was an error while copying the running configuration to rollback database.");
-                goto done;
-            };
+            // db does not yet exists, take running when it is replaced, see confirmed_commit_snapshot()
+            confirmed_commit_snapshot_set(h, 1);
         }
 
         if (schedule_rollback_event(h, confirm_timeout) < 0) {
@@ -604,6 +684,7 @@ handle_confirmed_commit(clixon_handle h,
         /* There was no subsequent confirmed-commit, meaning this is the end of the confirmed/confirming sequence;
          * The new configuration is already committed to running and the rollback database can now be deleted
          */
+        confirmed_commit_snapshot_set(h, 0);
         if (xmldb_delete(h, "rollback") < 0) {
             clixon_err(OE_DB, 0, "Error deleting the rollback configuration");
             goto done;
@@ -640,6 +721,12 @@ do_rollback(clixon_handle h,
     uint8_t errstate = 0;
     cbuf   *cbret;
 
+    /* No commit succeeded since the confirmed-commit, running is the rollback configuration */
+    if (confirmed_commit_snapshot_copy(h) < 0){
+        clixon_log(h, LOG_CRIT, "An error occurred creating the rollback database.");
+        errstate |= ROLLBACK_NOT_APPLIED;
+        goto done;
+    }
     if ((cbret = cbuf_new()) == NULL) {
         clixon_err(OE_DAEMON, 0, "rollback was not performed. (cbuf_new: %s)", strerror(errno));
         /* the rollback_db won't be deleted, so one can try recovery by:
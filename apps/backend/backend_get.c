@@ -41,6 +41,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#define __USE_GNU /* for qsort_r or qsort_s */
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdarg.h>
@@ -58,6 +59,9 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -173,6 +177,40 @@ client_get_streams(clixon_handle h,
     goto done;
 }
 
+/*! Raw check if an xpath may select nodes in a top-level state subtree
+ *
+ * Only the first location step of an absolute xpath is checked, any other xpath is
+ * assumed to intersect.
+ * @param[in]  xpath  XPath, or NULL for all
+ * @param[in]  top    Name of top-level node of subtree
+ * @retval     1      XPath may intersect subtree
+ * @retval     0      XPath does not intersect subtree
+ */
+static int
+get_xpath_top_match(const char *xpath,
+                    const char *top)
+{
+    const char *id;
+    const char *p;
+    size_t      len;
+
+    if (xpath == NULL || xpath[0] != '/' || strchr(xpath, '|') != NULL)
+        return 1;
+    id = xpath + 1;
+    len = strcspn(id, "/[ ");
+    if (len == 0)
+        return 1;
+    if ((p = memchr(id, ':', len)) != NULL){
+        if (p[1] == ':') /* axis */
+            return 1;
+        len -= p + 1 - id;
+        id = p + 1;
+    }
+    if (id[0] == '*' || id[0] == '.')
+        return 1;
+    return strlen(top) == len && strncmp(id, top, len) == 0;
+}
+
 /*! Get system state-data, including streams and plugins
  *
  * @param[in]     h       Clixon handle
@@ -250,16 +288,15 @@ get_state_data(clixon_handle h,
                 goto fail;
         }
     }
-    if (clicon_option_bool(h, "CLICON_YANG_LIBRARY")){
+    if (clicon_option_bool(h, "CLICON_YANG_LIBRARY") &&
+        get_xpath_top_match(xpath, "yang-library")){
         if ((ret = yang_modules_state_get(h, yspec, xpath, nsc, 0, xret)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
     }
     if (clicon_option_bool(h, "CLICON_NETCONF_MONITORING"))
-        if (xpath == NULL ||         /* Raw optimization of xpath filtering */
-            strcmp(xpath, "/") == 0 ||
-            strstr(xpath, "netconf-state") != 0){
+        if (get_xpath_top_match(xpath, "netconf-state")){ /* Raw optimization of xpath filtering */
             if ((ret = netconf_monitoring_state_get(h, yspec, xpath, nsc, xret, &xerr)) < 0)
                 goto done;
             if (ret == 0){
@@ -405,10 +442,14 @@ get_nacm_and_reply(clixon_handle     h,
 {
     int     retval = -1;
     cxobj  *xnacm = NULL;
+    int     ret;
 
     /* Pre-NACM access step */
     xnacm = clicon_nacm_cache(h);
-    if (xnacm != NULL){ /* Do NACM validation */
+    /* Skip tree walk and pruning if user may read everything */
+    if ((ret = nacm_datanode_read_permitted(h, username, xnacm)) < 0)
+        goto done;
+    if (ret == 0){ /* Do NACM validation */
         /* NACM datanode/module read validation */
         if (nacm_datanode_read1(h, xret, username, xnacm) < 0)
             goto done;
@@ -431,271 +472,2215 @@ get_nacm_and_reply(clixon_handle     h,
     return retval;
 }
 
-/*! Help function for parsing restconf query parameter and setting netconf attribute
- *
- * Parse and set a uint32 numeric value,
- * Accept also a default string (such as none/unbounded) which sets value to 0
- * @param[in]     h          Clixon handle
- * @param[in]     name       Name of attribute
- * @param[in]     defaultstr Default string which is accepted and sets value to 0
- * @param[in,out] cbret      Output buffer for internal bad-element RPC message if invalid
- * @param[out]    value      Value
- * @retval        1          OK (or not found)
- * @retval        0          Invalid, netconf bad-element error cbret set
- * @retval       -1          Error
+#ifdef BACKEND_GET_ZEROCOPY
+/*! Apply function: set XML_FLAG_CHANGE on ancestor, stop if already set
  */
 static int
-element2value(clixon_handle h,
-              cxobj        *xe,
-              char         *name,
-              char         *defaultstr,
-              cbuf         *cbret,
-              uint32_t     *value)
+get_zerocopy_mark_ancestor(cxobj *x,
+                           void  *arg)
 {
-    char  *valstr;
-    cxobj *x;
-
-    *value = 0;
-    if ((x = xml_find_type(xe, NULL, name, CX_ELMNT)) != NULL &&
-        (valstr = xml_body(x)) != NULL){
-        return netconf_parse_uint32(name, valstr, defaultstr, 0, cbret, value);
-    }
-    return 1;
+    if (xml_flag(x, XML_FLAG_CHANGE))
+        return 1; /* Stop, ancestors already marked */
+    xml_flag_set(x, XML_FLAG_CHANGE);
+    return 0;
 }
 
-/*! Extract offset and limit from get/list-pagination
+#ifdef BACKEND_GET_STREAM_CHUNK
+/*! Flush function: send the reply printed so far as a NETCONF chunk to the client
  *
- * @param[in]  h      Clixon handle
- * @param[in]  xe     Request: <rpc><xn></rpc>
- * @param[out] offset Number of entries in the working result-set that should be skipped
- * @param[out] limit  Limits the number of entries returned from the working result-set
- * @param[out] cbret  Return xml tree, eg <rpc-reply>..., <rpc-error..
- * @retval     1      OK
- * @retval     0      Invalid, netconf bad-element error cbret set
- * @retval    -1      Error
+ * @param[in,out] cb   Reply buffer, reset on return
+ * @param[in]     arg  Client entry
+ * @retval        0    OK
+ * @retval       -1    Error
  */
 static int
-list_pagination_hdr(clixon_handle h,
-                    cxobj        *xe,
-                    uint32_t     *offset,
-                    uint32_t     *limit,
-                    cbuf         *cbret)
+get_zerocopy_flush(cbuf *cb,
+                   void *arg)
 {
-    int retval = -1;
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
 
-    /* offset */
-    if ((retval = element2value(h, xe, "offset", "none", cbret, offset)) < 0)
-        goto done;
-    /* limit */
-    if (retval && (retval = element2value(h, xe, "limit", "unbounded", cbret, limit)) < 0)
+    if (clixon_msg_send11_chunk(ce->ce_s, NULL, cb) < 0)
         goto done;
+    ce->ce_reply_chunks++;
+    retval = 0;
  done:
     return retval;
 }
+#endif /* BACKEND_GET_STREAM_CHUNK */
 
-/*! Special handling of state data for partial reading
+/*! Mark xpath matches and their ancestors in a datastore cache
  *
- * @param[in]  h       Clixon handle
- * @param[in]  ce        Client entry, for locking
- * @param[in]  yspec     (Top-level) yang spec
- * @param[in]  xpath     XPath point to object to get
- * @param[in]  where
- * @param[in]  sort_by
- * @param[in]  direction NULL means forward
- * @param[in]  offset    Start of pagination interval
- * @param[in]  limit     Number of elements (limit)
- * @param[out] xret      Returned xml state tree
- * @param[out] cbret     Return xml tree, eg <rpc-reply>..., <rpc-error..
- * @retval     1         OK
- * @retval     0         Fail, cbret contains error message
- * @retval    -1         Error
+ * Matches are marked with XML_FLAG_MARK and ancestors with XML_FLAG_CHANGE
+ * @param[in]  xt     Datastore cache
+ * @param[in]  nsc    Namespace context of xpath
+ * @param[in]  xpath  XPath, or NULL for "/"
+ * @param[out] xvec   Vector of matches, free after resetting flags
+ * @param[out] xlen   Length of vector
+ * @retval     0      OK
+ * @retval    -1      Error
  */
 static int
-get_pagination_state_partial(clixon_handle        h,
-                             struct client_entry *ce,
-                             yang_stmt           *yspec,
-                             char                *xpath,
-                             char                *where,
-                             char                *sort_by,
-                             char                *direction,
-                             uint32_t             offset,
-                             uint32_t             limit,
-                             cxobj               *xret,
-                             cbuf                *cbret)
+get_zerocopy_mark(cxobj   *xt,
+                  cvec    *nsc,
+                  char    *xpath,
+                  cxobj ***xvec,
+                  size_t  *xlen)
 {
-    int                 retval = -1;
-    int                 locked;
-    cbuf               *cberr = NULL;
-    uint32_t            iddb; /* DBs lock, if any */
-    cxobj              *xerr = NULL;
-    pagination_data_t   pd = {0,};
-    dispatcher_entry_t *htable = NULL;
-    int                 ret;
-
-    clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
-    if ((iddb = xmldb_islocked(h, "running")) != 0 &&
-        iddb == ce->ce_id)
-        locked = 1;
-    else
-        locked = 0;
-    pd.pd_where = where;
-    pd.pd_sort_by = sort_by;
-    pd.pd_direction = direction;
-    pd.pd_offset = offset;
-    pd.pd_limit = limit;
-    pd.pd_locked = locked;
-    pd.pd_xstate = xret;
-    clicon_ptr_get(h, "pagination-entries", (void**)&htable);
-    if (htable){
-        if (dispatcher_call_handlers(htable, h, xpath, &pd) < 0){
-            if ((cberr = cbuf_new()) == NULL){
-                clixon_err(OE_UNIX, errno, "cbuf_new");
-                goto done;
-            }
-            /* error reason should be in clixon_err_reason */
-            cprintf(cberr, "Internal error, pagination state callback invalid return : %s",
-                    clixon_err_reason());
-            if (netconf_operation_failed_xml(&xerr, "application", cbuf_get(cberr)) < 0)
-                goto done;
-            if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
-                goto done;
-            goto fail;
-        }
-    }
+    int retval = -1;
+    int frozen;
+    int ret;
+    int i;
 
-    /* System makes the binding */
-    if ((ret = xml_bind_yang(h, xret, YB_MODULE, yspec, 0, &xerr)) < 0)
+    frozen = xpath_parallel_frozen(1);
+    ret = xpath_vec(xt, nsc, "%s", xvec, xlen, xpath?xpath:"/");
+    xpath_parallel_frozen(frozen);
+    if (ret < 0)
         goto done;
-    if (ret == 0){
-        clixon_debug_xml(CLIXON_DBG_BACKEND, xret, "Yang bind pagination state");
-        if (clixon_netconf_internal_error(xerr,
-                                          ". Internal error, state callback returned invalid XML",
-                                          NULL) < 0)
-            goto done;
-        if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
+    for (i=0; i<*xlen; i++){
+        xml_flag_set((*xvec)[i], XML_FLAG_MARK);
+        if (xml_apply_ancestor((*xvec)[i], get_zerocopy_mark_ancestor, NULL) < 0)
             goto done;
-        goto fail;
     }
-    retval = 1;
+    retval = 0;
  done:
-    if (cberr)
-        cbuf_free(cberr);
-    if (xerr)
-        xml_free(xerr);
     return retval;
- fail:
-    retval = 0;
-    goto done;
 }
 
-/*! Specialized get for list-pagination
+/*! Wrap output filter of zero-copy get in NACM read filter
  *
- * It is specialized enough to have its own function. Specifically, extra attributes as well
- * as the list-paginaiton API
- * @param[in]  h       Clixon handle
- * @param[in]  ce      Client entry, for locking
- * @param[in]  xe      Request: <rpc><xn></rpc>
- * @param[in]  content Get config/state/both
- * @param[in]  db      Database name
- * @param[in]  depth   Depth attribute
- * @param[in]  yspec   (Top-level) yang spec
- * @param[in]  xpath   XPath point to object to get
- * @param[in]  nsc     Namespace context of xpath
- * @param[in]  username
- * @param[in]  wdef    With-defaults parameter, see RFC 6243
- * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
- * @retval     0       OK
- * @retval    -1       Error
- * @note pagination uses appending xpath with predicate, eg [position()<limit], this may not work
- *       if there is an existing predicate
- * XXX Reuse code with get_common
- * From draft-ietf-netconf-list-pagination-04.txt 3.1:
-   The order is as follows: a server first processes the "where"
-   parameter (see Section 3.1.1), then the "sort-by" parameter (see
-   Section 3.1.2), then the "direction" parameter (see Section 3.1.4),
-   and either a combination of the "offset" parameter (see
-   Section 3.1.5) or the "cursor" parameter (see Section 3.1.6), and
-   lastly "the "limit" parameter (see Section 3.1.7).
+ * @param[in]     h        Clixon handle
+ * @param[in]     xt       Datastore cache tree to be printed
+ * @param[in]     username User name of requestor
+ * @param[in,out] fnp      Output filter, replaced by NACM read filter
+ * @param[out]    argp     Argument to output filter
+ * @param[out]    nfp      NACM read filter, free with nacm_read_filter_free
+ * @retval        0        OK
+ * @retval       -1        Error
  */
 static int
-get_list_pagination(clixon_handle        h,
+get_zerocopy_nacm(clixon_handle             h,
+                  cxobj                    *xt,
+                  char                     *username,
+                  xml_output_filter_t     **fnp,
+                  void                    **argp,
+                  struct nacm_read_filter **nfp)
+{
+    if (nacm_read_filter_new(h, xt, username, clicon_nacm_cache(h), *fnp, *argp, nfp) < 0)
+        return -1;
+    *fnp = nacm_read_filter;
+    *argp = *nfp;
+    return 0;
+}
+
+/*! Get config data and reply directly from datastore cache without copying
+ *
+ * Mark xpath matches and their ancestors in the cache, print marked nodes and reset marks.
+ * Simple xpaths are instead matched while printing, see xpath_stream2cbuf
+ * NACM read access is checked while printing, see nacm_read_filter
+ * With BACKEND_GET_STREAM_CHUNK, the reply printed so far is sent to the client in NETCONF
+ * chunks while printing, and only the remainder is left in cbret.
+ * If negotiated by the client, the reply is binary XML, see CLICON_IPC_BINARY
+ * @param[in]  h        Clixon handle
+ * @param[in]  ce       Client entry
+ * @param[in]  db       Datastore
+ * @param[in]  xpath    XPath point to object to get
+ * @param[in]  nsc      Namespace context of xpath
+ * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
+ * @param[in]  wdef     With-defaults parameter
+ * @param[in]  username User name of requestor
+ * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see get_nacm_and_reply  for the copying variant
+ */
+static int
+get_config_zerocopy(clixon_handle        h,
                     struct client_entry *ce,
-                    cxobj               *xe,
-                    netconf_content      content,
                     char                *db,
-                    int32_t              depth,
-                    yang_stmt           *yspec,
                     char                *xpath,
                     cvec                *nsc,
-                    char                *username,
+                    int32_t              depth,
                     withdefaults_type    wdef,
-                    cbuf                *cbret
-                    )
+                    char                *username,
+                    cbuf                *cbret)
 {
-    int        retval = -1;
-    uint32_t   offset = 0;
-    uint32_t   limit = 0;
-    uint32_t   upper;
-    int        partial_pagination_cb = 0; /* use state partial reads callback */
-    yang_stmt *ylist;
-    cxobj     *xerr = NULL;
-    cbuf      *cbmsg = NULL; /* For error msg */
-    cxobj     *xret = NULL;
-    cxobj    **xvec = NULL;
-    cxobj    **xvec2;
-    size_t     xlen;
-    cxobj     *x;
-    cxobj     *xj;
-    cxobj     *xp;
-    char      *sort_by = NULL;
-    char      *direction = NULL;
-    char      *where = NULL;
-    int        i;
-    int        j;
-    int        ret;
-    dispatcher_entry_t *htable = NULL;
-    cvec      *wherens = NULL;
-    //    int        extflag = 0;
-#ifdef LIST_PAGINATION_REMAINING
-    cxobj     *xcache;
-    uint32_t   total;
-    uint32_t   remaining = 0;
-#endif
+    int     retval = -1;
+    cxobj  *xt = NULL;
+    cxobj  *x;
+    cxobj  *xerr = NULL;
+    cxobj **xvec = NULL;
+    size_t  xlen = 0;
+    size_t  len0;
+    cbuf   *cbmsg = NULL;
+    int     i;
+    int     ret;
+    int     chunks0;
+    int     nacm;
+    clixon_xml_bin *xb = NULL;
+    xml_output_filter_t     *fn = NULL;
+    void                    *fnarg = NULL;
+    struct nacm_read_filter *nf = NULL;
 
-    clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
-    if (cbret == NULL){
-        clixon_err(OE_PLUGIN, EINVAL, "cbret is NULL");
-        goto done;
-    }
-    /* Check if list/leaf-list */
-    if (yang_path_arg(yspec, xpath?xpath:"/", &ylist) < 0)
+    /* NACM read filter is needed unless user is permitted to read everything */
+    if ((ret = nacm_datanode_read_permitted(h, username, clicon_nacm_cache(h))) < 0)
         goto done;
-    if (ylist == NULL){
+    nacm = (ret == 0);
+    if ((ret = xmldb_get_cache(h, db, YB_MODULE, &xt, NULL, &xerr)) < 0){
         if ((cbmsg = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
             goto done;
         }
-        /* error reason should be in clixon_err_reason() */
-        cprintf(cbmsg, "Netconf get list-pagination: \"%s\" not found", xpath);
-        if (netconf_invalid_value(cbret, "application", cbuf_get(cbmsg)) < 0)
+        cprintf(cbmsg, "Get %s datastore: %s", db, clixon_err_reason());
+        if (netconf_operation_failed(cbret, "application", cbuf_get(cbmsg)) < 0)
             goto done;
         goto ok;
     }
-    if (yang_keyword_get(ylist) != Y_LIST &&
-        yang_keyword_get(ylist) != Y_LEAF_LIST){
-        if (netconf_invalid_value(cbret, "application", "list-pagination is enabled but target is not list or leaf-list") < 0)
+    if (ret == 0){
+        if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
             goto done;
         goto ok;
     }
-    /* Sanity checks on state/config */
-    if (yang_config_ancestor(ylist) != 0){ /* config list */
-        if (content == CONTENT_NONCONFIG){
-            if (netconf_invalid_value(cbret, "application", "list-pagination targets a config list but content request is nonconfig") < 0)
+    if (strcmp(db, "running") == 0 &&
+        clicon_option_bool(h, "CLICON_XMLDB_RUNNING_RDONLY") &&
+        !xmldb_rdonly_held(h, db)){ /* Not mark tree read by threads */
+        if (xmldb_rdonly_get(h, db, &x) < 0)
+            goto done;
+        if (x != NULL)
+            xt = x;
+    }
+    if (ce->ce_binary && wdef != WITHDEFAULTS_REPORT_ALL_TAGGED){
+        /* Binary XML reply negotiated in hello, see CLICON_IPC_BINARY */
+        if ((xb = clixon_xml_bin_new(cbret)) == NULL)
+            goto done;
+#ifdef BACKEND_GET_STREAM_CHUNK
+        clixon_xml_bin_flush_set(xb, BACKEND_GET_STREAM_CHUNK, get_zerocopy_flush, ce);
+#endif
+        if (clixon_xml_bin_element(xb, NULL, "rpc-reply", NETCONF_BASE_NAMESPACE) < 0 ||
+            clixon_xml_bin_element(xb, NULL, NETCONF_OUTPUT_DATA, NULL) < 0)
+            goto done;
+        ret = 1; /* Print */
+        if (xpath != NULL && strcmp(xpath, "/") != 0){
+            if (get_zerocopy_mark(xt, nsc, xpath, &xvec, &xlen) < 0)
                 goto done;
-            goto ok;
+            ret = (xlen != 0);
+            if (!xml_flag(xt, XML_FLAG_MARK))
+                fn = xml_marked_filter;
         }
-    }
-    else { /* state list */
+        if (ret && nacm && get_zerocopy_nacm(h, xt, username, &fn, &fnarg, &nf) < 0)
+            goto done;
+        if (ret &&
+            clixon_xml2bin_filter(xb, xt, depth, 1, wdef, fn, fnarg) < 0)
+            goto done;
+        clixon_xml_bin_end(xb);
+        clixon_xml_bin_end(xb);
+        goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    len0 = cbuf_len(cbret);
+    chunks0 = ce->ce_reply_chunks;
+    cprintf(cbret, "<%s>", NETCONF_OUTPUT_DATA);
+    ret = 0;
+#ifdef BACKEND_GET_STREAM_CHUNK
+    /* Whole datastore is printed and sent in chunks */
+    if (xpath == NULL || strcmp(xpath, "/") == 0){
+        if (nacm && get_zerocopy_nacm(h, xt, username, &fn, &fnarg, &nf) < 0)
+            goto done;
+        if (clixon_xml2cbuf_stream(cbret, xt, depth, 1, wdef, fn, fnarg,
+                                   BACKEND_GET_STREAM_CHUNK, get_zerocopy_flush, ce) < 0)
+            goto done;
+        ret = 1;
+    }
+#endif
+    /* Simple paths are matched while printing, without node vector and NACM */
+    if (ret == 0 && depth < 0 && !nacm &&
+        (ret = xpath_stream2cbuf(cbret, xt, nsc, xpath?xpath:"/", wdef)) < 0)
+        goto done;
+    if (ret == 0){
+        if (get_zerocopy_mark(xt, nsc, xpath, &xvec, &xlen) < 0)
+            goto done;
+        if (!xml_flag(xt, XML_FLAG_MARK))
+            fn = xml_marked_filter;
+        if (nacm && get_zerocopy_nacm(h, xt, username, &fn, &fnarg, &nf) < 0)
+            goto done;
+#ifdef BACKEND_GET_STREAM_CHUNK
+        if (xlen &&
+            clixon_xml2cbuf_stream(cbret, xt, depth, 1, wdef, fn, fnarg,
+                                   BACKEND_GET_STREAM_CHUNK, get_zerocopy_flush, ce) < 0)
+            goto done;
+#else
+        if (xlen &&
+            clixon_xml2cbuf_filter(cbret, xt, 0, 0, NULL, depth, 1, wdef, fn, fnarg) < 0)
+            goto done;
+#endif
+    }
+    if (ce->ce_reply_chunks == chunks0 &&
+        cbuf_len(cbret) == len0 + strlen(NETCONF_OUTPUT_DATA) + 2){ /* Nothing printed */
+        cbuf_trunc(cbret, len0);
+        cprintf(cbret, "<%s/>", NETCONF_OUTPUT_DATA);
+    }
+    else
+        cprintf(cbret, "</%s>", NETCONF_OUTPUT_DATA);
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    for (i=0; i<xlen; i++){
+        xml_flag_reset(xvec[i], XML_FLAG_MARK);
+        xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_CHANGE);
+    }
+    if (xvec)
+        free(xvec);
+    if (nf)
+        nacm_read_filter_free(nf);
+    if (xb)
+        clixon_xml_bin_free(xb);
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*! Get-config reply made by a reader thread
+ */
+struct get_read_job{
+    qelem_t              gj_q;      /* Queue header */
+    struct client_entry *gj_ce;     /* Client, its socket is not read by the event loop */
+    int                  gj_s;      /* Client socket */
+    cxobj               *gj_xt;     /* Held read-only running */
+    int32_t              gj_depth;  /* Nr of levels to print, -1 is all */
+    withdefaults_type    gj_wdef;   /* With-defaults parameter */
+    int                  gj_chunks; /* Chunks sent */
+    int                  gj_err;    /* Print or send failed */
+};
+
+/*! Reader threads and their job queue
+ */
+struct get_read_pool{
+    pthread_mutex_t      rp_mutex;
+    pthread_cond_t       rp_cond;
+    struct get_read_job *rp_jobs;   /* Jobs not yet taken by a thread */
+    struct get_read_job *rp_busy;   /* Jobs taken by a thread */
+    int                  rp_pipe[2];/* Done jobs are written to the event loop */
+    pthread_t           *rp_tids;   /* Reader threads */
+    int                  rp_nthreads;
+    int                  rp_exit;   /* Set at exit, threads stop */
+};
+
+#ifdef BACKEND_GET_STREAM_CHUNK
+/*! Flush function of reader thread: send the reply printed so far as a NETCONF chunk
+ */
+static int
+get_read_flush(cbuf *cb,
+               void *arg)
+{
+    struct get_read_job *gj = (struct get_read_job *)arg;
+
+    if (clixon_msg_send11_chunk(gj->gj_s, NULL, cb) < 0)
+        return -1;
+    gj->gj_chunks++;
+    return 0;
+}
+#endif
+
+/*! Reader thread: print replies of whole running and send them to clients
+ *
+ * Only the held read-only tree, the client socket and the job are accessed
+ * @param[in]  arg  Reader pool
+ */
+static void *
+get_read_worker(void *arg)
+{
+    struct get_read_pool *rp = (struct get_read_pool *)arg;
+    struct get_read_job  *gj;
+    cbuf                 *cb;
+
+    /* Write replies directly, the event loop does not write to the socket meanwhile */
+    clixon_msg_outq_bypass(1);
+    for (;;){
+        pthread_mutex_lock(&rp->rp_mutex);
+        while ((gj = rp->rp_jobs) == NULL && !rp->rp_exit)
+            pthread_cond_wait(&rp->rp_cond, &rp->rp_mutex);
+        if (rp->rp_exit){
+            pthread_mutex_unlock(&rp->rp_mutex);
+            break;
+        }
+        DELQ(gj, rp->rp_jobs, struct get_read_job *);
+        ADDQ(gj, rp->rp_busy);
+        pthread_mutex_unlock(&rp->rp_mutex);
+        if ((cb = cbuf_new()) == NULL)
+            gj->gj_err++;
+        else {
+            cprintf(cb, "<rpc-reply xmlns=\"%s\"><%s>", NETCONF_BASE_NAMESPACE, NETCONF_OUTPUT_DATA);
+#ifdef BACKEND_GET_STREAM_CHUNK
+            if (clixon_xml2cbuf_stream(cb, gj->gj_xt, gj->gj_depth, 1, gj->gj_wdef, NULL, NULL,
+                                       BACKEND_GET_STREAM_CHUNK, get_read_flush, gj) < 0)
+                gj->gj_err++;
+#else
+            if (clixon_xml2cbuf_filter(cb, gj->gj_xt, 0, 0, NULL, gj->gj_depth, 1, gj->gj_wdef,
+                                       NULL, NULL) < 0)
+                gj->gj_err++;
+#endif
+            cprintf(cb, "</%s></rpc-reply>", NETCONF_OUTPUT_DATA);
+            if (gj->gj_err == 0 &&
+                send_msg_reply(gj->gj_s, NULL, cbuf_get(cb), cbuf_len(cb)+1) < 0)
+                gj->gj_err++;
+            cbuf_free(cb);
+        }
+        pthread_mutex_lock(&rp->rp_mutex);
+        DELQ(gj, rp->rp_busy, struct get_read_job *);
+        pthread_mutex_unlock(&rp->rp_mutex);
+        if (write(rp->rp_pipe[1], &gj, sizeof(gj)) != sizeof(gj))
+            break; /* Event loop gone */
+    }
+    return NULL;
+}
+
+/*! A reader thread is done: release tree and resume client, called in the event loop
+ *
+ * @param[in]  fd   Read end of done pipe
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+get_read_done(int   fd,
+              void *arg)
+{
+    int                  retval = -1;
+    clixon_handle        h = (clixon_handle)arg;
+    struct get_read_job *gj = NULL;
+    struct client_entry *ce;
+    cbuf                *cbret = NULL;
+
+    if (read(fd, &gj, sizeof(gj)) != sizeof(gj)){
+        clixon_err(OE_UNIX, errno, "read");
+        goto done;
+    }
+    ce = gj->gj_ce;
+    ce->ce_reply_chunks = gj->gj_chunks;
+    if (xmldb_rdonly_release(h, "running", gj->gj_xt) < 0)
+        goto done;
+    if (gj->gj_err){
+        clixon_log(h, LOG_WARNING, "%s: get-config reply of reader thread failed", __func__);
+        if (gj->gj_chunks) /* Part of reply already sent */
+            shutdown(ce->ce_s, SHUT_RDWR);
+        else {
+            if ((cbret = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            if (netconf_operation_failed(cbret, "application", "get-config reply failed") < 0)
+                goto done;
+        }
+        ce->ce_out_rpc_errors++;
+        netconf_monitoring_counter_inc(h, "out-rpc-errors");
+    }
+    if (backend_client_resume(h, ce, cbret) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (gj)
+        free(gj);
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Get reader thread pool, start it if not started
+ *
+ * @param[in]  h    Clixon handle
+ * @param[out] rpp  Reader pool
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+get_read_pool(clixon_handle          h,
+              struct get_read_pool **rpp)
+{
+    int                   retval = -1;
+    struct get_read_pool *rp = NULL;
+    int                   nthreads;
+    int                   ret;
+
+    if (clicon_ptr_get(h, "get-read-pool", (void**)&rp) == 0 && rp != NULL)
+        goto ok;
+    if ((rp = calloc(1, sizeof(*rp))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if (pipe(rp->rp_pipe) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        free(rp);
+        rp = NULL;
+        goto done;
+    }
+    pthread_mutex_init(&rp->rp_mutex, NULL);
+    pthread_cond_init(&rp->rp_cond, NULL);
+    if (clixon_event_reg_fd(rp->rp_pipe[0], get_read_done, h, "get-config reader threads") < 0)
+        goto done;
+    if (clicon_ptr_set(h, "get-read-pool", rp) < 0)
+        goto done;
+    nthreads = clicon_option_int(h, "CLICON_BACKEND_READ_THREADS");
+    if ((rp->rp_tids = calloc(nthreads, sizeof(pthread_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (; rp->rp_nthreads<nthreads; rp->rp_nthreads++){
+        if ((ret = pthread_create(&rp->rp_tids[rp->rp_nthreads], NULL, get_read_worker, rp)) != 0){
+            clixon_err(OE_UNIX, ret, "pthread_create");
+            goto done;
+        }
+    }
+ ok:
+    *rpp = rp;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Stop reader threads and free reader pool
+ *
+ * Jobs not taken by a thread are dropped. Sockets of jobs being sent are shut down, so that
+ * a thread does not wait for a client that does not read, and threads are joined.
+ * Done jobs not handled by the event loop are freed. Held trees are freed by xmldb_disconnect.
+ * @param[in]  h   Clixon handle
+ */
+static void
+get_read_pool_exit(clixon_handle h)
+{
+    struct get_read_pool *rp = NULL;
+    struct get_read_job  *gj;
+    int                   i;
+
+    if (clicon_ptr_get(h, "get-read-pool", (void**)&rp) < 0 || rp == NULL)
+        return;
+    pthread_mutex_lock(&rp->rp_mutex);
+    rp->rp_exit = 1;
+    while ((gj = rp->rp_jobs) != NULL){
+        DELQ(gj, rp->rp_jobs, struct get_read_job *);
+        free(gj);
+    }
+    if ((gj = rp->rp_busy) != NULL){
+        do {
+            shutdown(gj->gj_s, SHUT_RDWR);
+            gj = NEXTQ(struct get_read_job *, gj);
+        } while (gj && gj != rp->rp_busy);
+    }
+    pthread_cond_broadcast(&rp->rp_cond);
+    pthread_mutex_unlock(&rp->rp_mutex);
+    for (i=0; i<rp->rp_nthreads; i++)
+        pthread_join(rp->rp_tids[i], NULL);
+    clixon_event_unreg_fd(rp->rp_pipe[0], get_read_done);
+    fcntl(rp->rp_pipe[0], F_SETFL, O_NONBLOCK);
+    while (read(rp->rp_pipe[0], &gj, sizeof(gj)) == sizeof(gj))
+        free(gj);
+    close(rp->rp_pipe[0]);
+    close(rp->rp_pipe[1]);
+    pthread_cond_destroy(&rp->rp_cond);
+    pthread_mutex_destroy(&rp->rp_mutex);
+    if (rp->rp_tids)
+        free(rp->rp_tids);
+    free(rp);
+    clicon_ptr_del(h, "get-read-pool");
+}
+
+/*! Get whole running config in a reader thread from the published read-only running
+ *
+ * The client socket is not read until the thread has sent the reply, so that replies are
+ * in order and the event loop serves other clients and commits meanwhile.
+ * Only whole datastore and without NACM (checked by caller), since XPath and NACM
+ * evaluation are not thread-safe
+ * @param[in]  h        Clixon handle
+ * @param[in]  ce       Client entry
+ * @param[in]  db       Datastore
+ * @param[in]  xpath    XPath point to object to get
+ * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
+ * @param[in]  wdef     With-defaults parameter
+ * @retval     1        Reply is sent by reader thread
+ * @retval     0        Not applicable, reply in event loop
+ * @retval    -1        Error
+ * @see CLICON_BACKEND_READ_THREADS
+ */
+static int
+get_config_thread(clixon_handle        h,
+                  struct client_entry *ce,
+                  char                *db,
+                  char                *xpath,
+                  int32_t              depth,
+                  withdefaults_type    wdef)
+{
+    int                   retval = -1;
+    struct get_read_pool *rp = NULL;
+    struct get_read_job  *gj = NULL;
+    cxobj                *xt = NULL;
+
+    if (clicon_option_int(h, "CLICON_BACKEND_READ_THREADS") <= 0 ||
+        strcmp(db, "running") != 0 ||
+        !clicon_option_bool(h, "CLICON_XMLDB_RUNNING_RDONLY") ||
+        (xpath != NULL && strcmp(xpath, "/") != 0) ||
+        ce->ce_binary ||
+        ce->ce_thread ||
+        clixon_msg_outq_len(ce->ce_s) > 0) /* Queued replies are written by event loop */
+        goto skip;
+    /* Make sure running cache is loaded */
+    if (xmldb_get_cache(h, db, YB_MODULE, &xt, NULL, NULL) <= 0)
+        goto skip;
+    if (get_read_pool(h, &rp) < 0)
+        goto done;
+    if ((gj = calloc(1, sizeof(*gj))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if (xmldb_rdonly_hold(h, db, &gj->gj_xt) < 0)
+        goto done;
+    if (gj->gj_xt == NULL)
+        goto skip;
+    gj->gj_ce = ce;
+    gj->gj_s = ce->ce_s;
+    gj->gj_depth = depth;
+    gj->gj_wdef = wdef;
+    /* Do not read client until reply is sent, see backend_client_resume */
+    clixon_event_unreg_fd(ce->ce_s, from_client);
+    ce->ce_thread = 1;
+    ce->ce_reply_pending = 1;
+    pthread_mutex_lock(&rp->rp_mutex);
+    ADDQ(gj, rp->rp_jobs);
+    pthread_cond_signal(&rp->rp_cond);
+    pthread_mutex_unlock(&rp->rp_mutex);
+    gj = NULL;
+    retval = 1;
+ done:
+    if (gj)
+        free(gj);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+#endif /* HAVE_LIBPTHREAD */
+
+#ifdef BACKEND_GET_REPLY_CACHE
+/*! Serialized get-config reply of config data, cached for identical requests
+ */
+struct reply_cache{
+    qelem_t           rc_q;       /* Queue header, most recently used first */
+    char             *rc_db;      /* Datastore */
+    uint64_t          rc_gen;     /* Content generation of datastore, see xmldb_generation */
+    char             *rc_xpath;   /* Canonical xpath, NULL is whole datastore */
+    int32_t           rc_depth;   /* Nr of levels printed, -1 is all */
+    withdefaults_type rc_wdef;    /* With-defaults parameter */
+    char             *rc_user;    /* NACM user, NULL if NACM permits reading all */
+    uint64_t          rc_nacm_gen; /* NACM generation of reply, see nacm_generation */
+    char             *rc_reply;   /* Reply <rpc-reply> */
+    size_t            rc_len;     /* Length of reply */
+};
+
+static void
+get_reply_cache_free1(struct reply_cache *rc)
+{
+    if (rc->rc_db)
+        free(rc->rc_db);
+    if (rc->rc_xpath)
+        free(rc->rc_xpath);
+    if (rc->rc_user)
+        free(rc->rc_user);
+    if (rc->rc_reply)
+        free(rc->rc_reply);
+    free(rc);
+}
+
+static int
+get_reply_cache_strcmp(char *s1,
+                       char *s2)
+{
+    if (s1 == NULL || s2 == NULL)
+        return s1 != s2;
+    return strcmp(s1, s2);
+}
+
+/*! Find cached reply of a get-config request, remove replies of modified datastores or NACM rules
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Datastore
+ * @param[in]  xpath  Canonical xpath
+ * @param[in]  depth  Nr of levels to print, -1 is all
+ * @param[in]  wdef   With-defaults parameter
+ * @param[in]  user   NACM user, NULL if NACM permits reading all
+ * @retval     rc     Cached reply, moved first
+ * @retval     NULL   Not found
+ */
+static struct reply_cache *
+get_reply_cache_find(clixon_handle     h,
+                     char             *db,
+                     char             *xpath,
+                     int32_t           depth,
+                     withdefaults_type wdef,
+                     char             *user)
+{
+    struct reply_cache *head = NULL;
+    struct reply_cache *rc;
+    struct reply_cache *rc1;
+    struct reply_cache *found = NULL;
+    uint64_t            gen;
+    uint64_t            nacm_gen;
+
+    gen = xmldb_generation(h, db);
+    nacm_gen = nacm_generation(h);
+    clicon_ptr_get(h, "get-reply-cache", (void**)&head);
+    if ((rc = head) != NULL){
+        do {
+            rc1 = NEXTQ(struct reply_cache *, rc);
+            if (rc->rc_nacm_gen != nacm_gen ||
+                (strcmp(rc->rc_db, db) == 0 && rc->rc_gen != gen)){
+                DELQ(rc, head, struct reply_cache *);
+                get_reply_cache_free1(rc);
+            }
+            else if (found == NULL &&
+                     rc->rc_depth == depth && rc->rc_wdef == wdef &&
+                     strcmp(rc->rc_db, db) == 0 &&
+                     get_reply_cache_strcmp(rc->rc_xpath, xpath) == 0 &&
+                     get_reply_cache_strcmp(rc->rc_user, user) == 0)
+                found = rc;
+            rc = rc1;
+        } while (head && rc != head);
+    }
+    if (found){ /* Move first */
+        DELQ(found, head, struct reply_cache *);
+        INSQ(found, head);
+    }
+    clicon_ptr_set(h, "get-reply-cache", head);
+    return found;
+}
+
+/*! Add a get-config reply to the cache, remove least recently used if full
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Datastore
+ * @param[in]  xpath  Canonical xpath
+ * @param[in]  depth  Nr of levels to print, -1 is all
+ * @param[in]  wdef   With-defaults parameter
+ * @param[in]  user   NACM user, NULL if NACM permits reading all
+ * @param[in]  reply  Reply <rpc-reply>
+ * @param[in]  len    Length of reply
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+get_reply_cache_add(clixon_handle     h,
+                    char             *db,
+                    char             *xpath,
+                    int32_t           depth,
+                    withdefaults_type wdef,
+                    char             *user,
+                    char             *reply,
+                    size_t            len)
+{
+    int                 retval = -1;
+    struct reply_cache *head = NULL;
+    struct reply_cache *rc;
+    int                 nr = 0;
+
+    clicon_ptr_get(h, "get-reply-cache", (void**)&head);
+    if ((rc = head) != NULL){
+        do {
+            nr++;
+            rc = NEXTQ(struct reply_cache *, rc);
+        } while (rc != head);
+    }
+    if (nr >= BACKEND_GET_REPLY_CACHE){ /* Remove least recently used, last */
+        rc = PREVQ(struct reply_cache *, head);
+        DELQ(rc, head, struct reply_cache *);
+        get_reply_cache_free1(rc);
+    }
+    if ((rc = calloc(1, sizeof(*rc))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    rc->rc_gen = xmldb_generation(h, db);
+    rc->rc_depth = depth;
+    rc->rc_wdef = wdef;
+    rc->rc_nacm_gen = nacm_generation(h);
+    rc->rc_len = len;
+    if ((rc->rc_db = strdup(db)) == NULL ||
+        (xpath && (rc->rc_xpath = strdup(xpath)) == NULL) ||
+        (user && (rc->rc_user = strdup(user)) == NULL)){
+        clixon_err(OE_UNIX, errno, "strdup");
+        get_reply_cache_free1(rc);
+        goto done;
+    }
+    if ((rc->rc_reply = malloc(len)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        get_reply_cache_free1(rc);
+        goto done;
+    }
+    memcpy(rc->rc_reply, reply, len);
+    INSQ(rc, head);
+    retval = 0;
+ done:
+    clicon_ptr_set(h, "get-reply-cache", head);
+    return retval;
+}
+
+/*! Get config data from the reply cache or from the datastore cache, and cache the reply
+ *
+ * Identical requests between changes of the datastore are served from the serialized reply
+ * without xpath, NACM, default and print evaluation.
+ * @param[in]  h        Clixon handle
+ * @param[in]  ce       Client entry
+ * @param[in]  db       Datastore
+ * @param[in]  xpath    XPath point to object to get
+ * @param[in]  nsc      Namespace context of xpath
+ * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
+ * @param[in]  wdef     With-defaults parameter
+ * @param[in]  username User name of requestor
+ * @param[in]  readall  NACM permits user to read all data
+ * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see BACKEND_GET_REPLY_CACHE
+ */
+static int
+get_config_cached(clixon_handle        h,
+                  struct client_entry *ce,
+                  char                *db,
+                  char                *xpath,
+                  cvec                *nsc,
+                  int32_t              depth,
+                  withdefaults_type    wdef,
+                  char                *username,
+                  int                  readall,
+                  cbuf                *cbret)
+{
+    int                 retval = -1;
+    struct reply_cache *rc;
+    char               *user;
+    size_t              len0;
+    int                 chunks0;
+    cbuf               *cb = NULL;
+    char               *reply;
+
+    if (ce->ce_binary)
+        return get_config_zerocopy(h, ce, db, xpath, nsc, depth, wdef, username, cbret);
+    if (xpath != NULL && strcmp(xpath, "/") == 0)
+        xpath = NULL;
+    user = readall ? NULL : username;
+    if ((rc = get_reply_cache_find(h, db, xpath, depth, wdef, user)) != NULL){
+        if (cbuf_append_buf(cbret, rc->rc_reply, rc->rc_len) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+        goto ok;
+    }
+    len0 = cbuf_len(cbret);
+    chunks0 = ce->ce_reply_chunks;
+    if (get_config_zerocopy(h, ce, db, xpath, nsc, depth, wdef, username, cbret) < 0)
+        goto done;
+    if (ce->ce_reply_chunks != chunks0) /* Part of reply already sent */
+        goto ok;
+    /* Only data replies, not errors */
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc-reply xmlns=\"%s\"><%s", NETCONF_BASE_NAMESPACE, NETCONF_OUTPUT_DATA);
+    reply = cbuf_get(cbret) + len0;
+    if (strncmp(reply, cbuf_get(cb), cbuf_len(cb)) == 0 &&
+        get_reply_cache_add(h, db, xpath, depth, wdef, user, reply, cbuf_len(cbret) - len0) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+#endif /* BACKEND_GET_REPLY_CACHE */
+#endif /* BACKEND_GET_ZEROCOPY */
+
+/*! Help function for parsing restconf query parameter and setting netconf attribute
+ *
+ * Parse and set a uint32 numeric value,
+ * Accept also a default string (such as none/unbounded) which sets value to 0
+ * @param[in]     h          Clixon handle
+ * @param[in]     name       Name of attribute
+ * @param[in]     defaultstr Default string which is accepted and sets value to 0
+ * @param[in,out] cbret      Output buffer for internal bad-element RPC message if invalid
+ * @param[out]    value      Value
+ * @retval        1          OK (or not found)
+ * @retval        0          Invalid, netconf bad-element error cbret set
+ * @retval       -1          Error
+ */
+static int
+element2value(clixon_handle h,
+              cxobj        *xe,
+              char         *name,
+              char         *defaultstr,
+              cbuf         *cbret,
+              uint32_t     *value)
+{
+    char  *valstr;
+    cxobj *x;
+
+    *value = 0;
+    if ((x = xml_find_type(xe, NULL, name, CX_ELMNT)) != NULL &&
+        (valstr = xml_body(x)) != NULL){
+        return netconf_parse_uint32(name, valstr, defaultstr, 0, cbret, value);
+    }
+    return 1;
+}
+
+/*! Extract offset and limit from get/list-pagination
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  xe     Request: <rpc><xn></rpc>
+ * @param[out] offset Number of entries in the working result-set that should be skipped
+ * @param[out] limit  Limits the number of entries returned from the working result-set
+ * @param[out] cbret  Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     1      OK
+ * @retval     0      Invalid, netconf bad-element error cbret set
+ * @retval    -1      Error
+ */
+static int
+list_pagination_hdr(clixon_handle h,
+                    cxobj        *xe,
+                    uint32_t     *offset,
+                    uint32_t     *limit,
+                    cbuf         *cbret)
+{
+    int retval = -1;
+
+    /* offset */
+    if ((retval = element2value(h, xe, "offset", "none", cbret, offset)) < 0)
+        goto done;
+    /* limit */
+    if (retval && (retval = element2value(h, xe, "limit", "unbounded", cbret, limit)) < 0)
+        goto done;
+ done:
+    return retval;
+}
+
+/*! Check if a state list producer is registered for exactly an xpath
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xpath   Canonical XPath, or NULL
+ * @param[out] htable  Registered producers
+ * @retval     1       Producer registered
+ * @retval     0       No producer
+ * @retval    -1       Error
+ * @see clixon_statelist_cb_register
+ */
+static int
+get_statelist_match(clixon_handle        h,
+                    char                *xpath,
+                    dispatcher_entry_t **htable)
+{
+    *htable = NULL;
+    if (xpath == NULL)
+        return 0;
+    clicon_ptr_get(h, "statelist-entries", (void**)htable);
+    if (*htable == NULL)
+        return 0;
+    return dispatcher_match_exact(*htable, xpath);
+}
+
+/*! Call state list producer for one batch of entries
+ *
+ * The previous batch is freed, and the new batch is bound to YANG, sorted and defaults added
+ * @param[in]     h       Clixon handle
+ * @param[in]     htable  Registered producers
+ * @param[in]     yspec   Yang spec
+ * @param[in]     xpath   Canonical XPath of list
+ * @param[in,out] sl      Producer data, sl_xstate is the new batch on return
+ * @param[out]    xerr    Error tree if invalid
+ * @retval        1       OK
+ * @retval        0       Invalid XML from producer, xerr set
+ * @retval       -1       Error
+ */
+static int
+get_statelist_batch(clixon_handle       h,
+                    dispatcher_entry_t *htable,
+                    yang_stmt          *yspec,
+                    char               *xpath,
+                    statelist_data_t   *sl,
+                    cxobj             **xerr)
+{
+    int retval = -1;
+    int ret;
+
+    if (sl->sl_xstate){
+        xml_free(sl->sl_xstate);
+        sl->sl_xstate = NULL;
+    }
+    if ((sl->sl_xstate = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (dispatcher_call_handlers(htable, h, xpath, sl) < 0){
+        if (clixon_err_category() < 0)
+            clixon_err(OE_PLUGIN, 0, "State list producer of %s failed", xpath);
+        goto done;
+    }
+    if ((ret = xml_bind_yang(h, sl->sl_xstate, YB_MODULE, yspec, 0, xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_netconf_internal_error(*xerr,
+                                          ". Internal error, state list producer returned invalid XML",
+                                          NULL) < 0)
+            goto done;
+        goto fail;
+    }
+    /* Sorted on serialization unless the producer declared it sorted */
+    if (xml_sort_lazy(sl->sl_xstate) < 0)
+        goto done;
+    if (xml_default_recurse(sl->sl_xstate, 1, 0) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check that all ancestors of a state list are containers, choices or cases
+ *
+ * @param[in]  ylist  YANG list
+ * @retval     1      Yes, ancestors can be printed from YANG
+ * @retval     0      No
+ */
+static int
+get_statelist_ancestors(yang_stmt *ylist)
+{
+    yang_stmt *yp;
+
+    for (yp = yang_parent_get(ylist); yp != NULL; yp = yang_parent_get(yp)){
+        switch (yang_keyword_get(yp)){
+        case Y_MODULE:
+        case Y_SUBMODULE:
+            return 1;
+        case Y_CONTAINER:
+        case Y_CHOICE:
+        case Y_CASE:
+            break;
+        default:
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/*! Print start or end tags of the ancestors of a state list from YANG
+ *
+ * @param[in]  cb     Buffer
+ * @param[in]  y      Parent of list, or its ancestor
+ * @param[in]  end    0: start tags top-down, 1: end tags bottom-up
+ * @see get_statelist_ancestors  all ancestors are containers, choices or cases
+ */
+static void
+get_statelist_tags(cbuf      *cb,
+                   yang_stmt *y,
+                   int        end)
+{
+    yang_stmt *yp;
+
+    if (y == NULL ||
+        yang_keyword_get(y) == Y_MODULE || yang_keyword_get(y) == Y_SUBMODULE)
+        return;
+    yp = yang_parent_get(y);
+    if (yang_keyword_get(y) != Y_CONTAINER){ /* choice, case */
+        get_statelist_tags(cb, yp, end);
+        return;
+    }
+    if (end){
+        cprintf(cb, "</%s>", yang_argument_get(y));
+        get_statelist_tags(cb, yp, end);
+        return;
+    }
+    get_statelist_tags(cb, yp, end);
+    while (yang_keyword_get(yp) == Y_CHOICE || yang_keyword_get(yp) == Y_CASE)
+        yp = yang_parent_get(yp);
+    if (yang_keyword_get(yp) == Y_MODULE || yang_keyword_get(yp) == Y_SUBMODULE ||
+        strcmp(yang_find_mynamespace(y), yang_find_mynamespace(yp)) != 0)
+        cprintf(cb, "<%s xmlns=\"%s\">", yang_argument_get(y), yang_find_mynamespace(y));
+    else
+        cprintf(cb, "<%s>", yang_argument_get(y));
+}
+
+/*! Get a state list by streaming the entries of its producer in batches
+ *
+ * Ancestors of the list are printed from YANG. Entries of each batch are NACM filtered and
+ * printed to the reply, and with BACKEND_GET_STREAM_CHUNK sent to the client in NETCONF chunks
+ * while the producer is called for the next batch. Only one batch is held as XML at a time.
+ * @param[in]  h        Clixon handle
+ * @param[in]  ce       Client entry
+ * @param[in]  htable   Registered producers
+ * @param[in]  yspec    Yang spec
+ * @param[in]  xpath    Canonical XPath of list, with a producer
+ * @param[in]  nsc      Namespace context of xpath
+ * @param[in]  username User name of requestor
+ * @param[in]  wdef     With-defaults parameter
+ * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     1        OK, reply or error in cbret
+ * @retval     0        Not streamed, xpath is not a state list whose ancestors are containers
+ * @retval    -1        Error
+ * @note Entries should not use namespace prefixes declared on their ancestors
+ */
+static int
+get_statelist_stream(clixon_handle        h,
+                     struct client_entry *ce,
+                     dispatcher_entry_t  *htable,
+                     yang_stmt           *yspec,
+                     char                *xpath,
+                     cvec                *nsc,
+                     char                *username,
+                     withdefaults_type    wdef,
+                     cbuf                *cbret)
+{
+    int              retval = -1;
+    statelist_data_t sl = {0,};
+    yang_stmt       *ylist = NULL;
+    cxobj           *xnacm;
+    cxobj           *xerr = NULL;
+    cxobj          **xvec = NULL;
+    size_t           xlen = 0;
+    size_t           len0;
+    uint32_t         iddb;
+    uint32_t         chunks0;
+    uint64_t         n = 0;
+    int              nacm;
+    int              i;
+    int              ret;
+
+    if (yang_path_arg(yspec, xpath, &ylist) < 0)
+        goto done;
+    if (ylist == NULL ||
+        yang_keyword_get(ylist) != Y_LIST ||
+        yang_config_ancestor(ylist) != 0 ||
+        !get_statelist_ancestors(ylist))
+        goto skip;
+    xnacm = clicon_nacm_cache(h);
+    if ((ret = nacm_datanode_read_permitted(h, username, xnacm)) < 0)
+        goto done;
+    nacm = (ret == 0);
+    sl.sl_batch = STATELIST_BATCH;
+    sl.sl_locked = (iddb = xmldb_islocked(h, "running")) != 0 && iddb == ce->ce_id;
+    len0 = cbuf_len(cbret);
+    chunks0 = ce->ce_reply_chunks;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><%s>", NETCONF_BASE_NAMESPACE, NETCONF_OUTPUT_DATA);
+    do {
+        if ((ret = get_statelist_batch(h, htable, yspec, xpath, &sl, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            if (ce->ce_reply_chunks != chunks0){
+                clixon_err(OE_PLUGIN, 0, "State list producer of %s returned invalid XML", xpath);
+                goto done;
+            }
+            cbuf_trunc(cbret, len0);
+            if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
+                goto done;
+            goto ok;
+        }
+        if (xml_child_nr_type(sl.sl_xstate, CX_ELMNT) == 0) /* No more entries */
+            break;
+        if (nacm){
+            if (nacm_datanode_read1(h, sl.sl_xstate, username, xnacm) < 0)
+                goto done;
+            if (nacm_datanode_read_prune(h, sl.sl_xstate) < 0)
+                goto done;
+        }
+        if (xpath_vec(sl.sl_xstate, nsc, "%s", &xvec, &xlen, xpath) < 0)
+            goto done;
+        if (xlen && n == 0)
+            get_statelist_tags(cbret, yang_parent_get(ylist), 0);
+        for (i=0; i<xlen; i++)
+            if (clixon_xml2cbuf1(cbret, xvec[i], 0, 0, NULL, -1, 0, wdef) < 0)
+                goto done;
+        n += xlen;
+        if (xvec){
+            free(xvec);
+            xvec = NULL;
+        }
+#ifdef BACKEND_GET_STREAM_CHUNK
+        if (cbuf_len(cbret) >= BACKEND_GET_STREAM_CHUNK){
+            if (clixon_msg_send11_chunk(ce->ce_s, NULL, cbret) < 0)
+                goto done;
+            ce->ce_reply_chunks++;
+        }
+#endif
+    } while (!sl.sl_end);
+    if (n == 0){ /* Nothing printed, and no chunk sent */
+        cbuf_trunc(cbret, len0);
+        cprintf(cbret, "<rpc-reply xmlns=\"%s\"><%s/>", NETCONF_BASE_NAMESPACE, NETCONF_OUTPUT_DATA);
+    }
+    else{
+        get_statelist_tags(cbret, yang_parent_get(ylist), 1);
+        cprintf(cbret, "</%s>", NETCONF_OUTPUT_DATA);
+    }
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 1;
+ done:
+    if (xvec)
+        free(xvec);
+    if (xerr)
+        xml_free(xerr);
+    if (sl.sl_xstate)
+        xml_free(sl.sl_xstate);
+    if (sl.sl_cursor)
+        free(sl.sl_cursor);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
+/*! List pagination of a state list from its producer
+ *
+ * The producer seeks to offset and is called in batches until limit entries are merged
+ * @param[in]  h         Clixon handle
+ * @param[in]  ce        Client entry, for locking
+ * @param[in]  htable    Registered producers
+ * @param[in]  yspec     Yang spec
+ * @param[in]  xpath     Canonical XPath of list, with a producer
+ * @param[in]  nsc       Namespace context of xpath
+ * @param[in]  offset    Start of pagination interval
+ * @param[in]  limit     Number of elements, 0 is unbounded
+ * @param[in,out] xret   XML tree where entries are merged
+ * @param[out] cbret     Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     1         OK
+ * @retval     0         Fail, cbret contains error message
+ * @retval    -1         Error
+ * @see get_pagination_state_partial  for pagination callbacks
+ */
+static int
+get_pagination_statelist(clixon_handle        h,
+                         struct client_entry *ce,
+                         dispatcher_entry_t  *htable,
+                         yang_stmt           *yspec,
+                         char                *xpath,
+                         cvec                *nsc,
+                         uint32_t             offset,
+                         uint32_t             limit,
+                         cxobj              **xret,
+                         cbuf                *cbret)
+{
+    int              retval = -1;
+    statelist_data_t sl = {0,};
+    cxobj           *xerr = NULL;
+    uint32_t         iddb;
+    uint32_t         n = 0;
+    uint32_t         count;
+    int              ret;
+
+    sl.sl_offset = offset;
+    sl.sl_locked = (iddb = xmldb_islocked(h, "running")) != 0 && iddb == ce->ce_id;
+    do {
+        sl.sl_batch = STATELIST_BATCH;
+        if (limit && limit - n < STATELIST_BATCH)
+            sl.sl_batch = limit - n;
+        if ((ret = get_statelist_batch(h, htable, yspec, xpath, &sl, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
+                goto done;
+            goto fail;
+        }
+        if (xpath_count(sl.sl_xstate, nsc, xpath, &count) < 0)
+            goto done;
+        if (count == 0)
+            break;
+        if ((ret = netconf_trymerge(sl.sl_xstate, yspec, xret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf1(cbret, *xret, 0, 0, NULL, -1, 0, 0) < 0)
+                goto done;
+            goto fail;
+        }
+        n += count;
+    } while (!sl.sl_end && (limit == 0 || n < limit));
+    retval = 1;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    if (sl.sl_xstate)
+        xml_free(sl.sl_xstate);
+    if (sl.sl_cursor)
+        free(sl.sl_cursor);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Base64 alphabet of list pagination cursors */
+static const char get_cursor_b64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*! Print the list pagination cursor of a list or leaf-list entry
+ *
+ * The cursor is the base64 encoding of the key values of a list entry, or of the value of a
+ * leaf-list entry, each terminated by a null character. It identifies the entry independently
+ * of its position, and is decoded with get_cursor_decode
+ * @param[in]  cb     Buffer
+ * @param[in]  x      List or leaf-list entry
+ * @param[in]  ylist  YANG list or leaf-list
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+get_cursor_encode(cbuf      *cb,
+                  cxobj     *x,
+                  yang_stmt *ylist)
+{
+    int            retval = -1;
+    cbuf          *cbk = NULL;
+    cg_var        *cvi = NULL;
+    char          *body;
+    unsigned char *s;
+    size_t         len;
+    size_t         i;
+    uint32_t       v;
+
+    if ((cbk = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (yang_keyword_get(ylist) == Y_LEAF_LIST){
+        if ((body = xml_body(x)) != NULL)
+            cprintf(cbk, "%s", body);
+        cbuf_append_buf(cbk, "", 1);
+    }
+    else while ((cvi = cvec_each(yang_cvec_get(ylist), cvi)) != NULL){
+            if ((body = xml_find_body(x, cv_string_get(cvi))) != NULL)
+                cprintf(cbk, "%s", body);
+            cbuf_append_buf(cbk, "", 1);
+        }
+    s = (unsigned char *)cbuf_get(cbk);
+    len = cbuf_len(cbk);
+    for (i=0; i+2<len; i+=3){
+        v = (s[i] << 16) | (s[i+1] << 8) | s[i+2];
+        cprintf(cb, "%c%c%c%c", get_cursor_b64[(v >> 18) & 0x3f], get_cursor_b64[(v >> 12) & 0x3f],
+                get_cursor_b64[(v >> 6) & 0x3f], get_cursor_b64[v & 0x3f]);
+    }
+    if (i < len){
+        v = s[i] << 16;
+        if (i+1 < len)
+            v |= s[i+1] << 8;
+        cprintf(cb, "%c%c%c=", get_cursor_b64[(v >> 18) & 0x3f], get_cursor_b64[(v >> 12) & 0x3f],
+                i+1 < len ? get_cursor_b64[(v >> 6) & 0x3f] : '=');
+    }
+    retval = 0;
+ done:
+    if (cbk)
+        cbuf_free(cbk);
+    return retval;
+}
+
+/*! Decode a list pagination cursor into a key vector for clixon_xml_find_index
+ *
+ * @param[in]  cursor Cursor, see get_cursor_encode
+ * @param[in]  ylist  YANG list or leaf-list
+ * @param[out] cvkp   Key names and values, "." for a leaf-list. Free with cvec_free
+ * @retval     1      OK
+ * @retval     0      Invalid cursor
+ * @retval    -1      Error
+ */
+static int
+get_cursor_decode(char       *cursor,
+                  yang_stmt  *ylist,
+                  cvec      **cvkp)
+{
+    int       retval = -1;
+    cvec     *cvk = NULL;
+    cg_var   *cvi = NULL;
+    char     *buf = NULL;
+    char     *s;
+    char     *p;
+    size_t    len = 0;
+    uint32_t  v = 0;
+    int       bits = 0;
+    int       i;
+
+    if ((buf = malloc(strlen(cursor)*3/4 + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    for (s=cursor; *s && *s != '='; s++){
+        if ((p = strchr(get_cursor_b64, *s)) == NULL)
+            goto fail;
+        v = (v << 6) | (p - get_cursor_b64);
+        if ((bits += 6) >= 8){
+            bits -= 8;
+            buf[len++] = (v >> bits) & 0xff;
+        }
+    }
+    if (len == 0 || buf[len-1] != '\0')
+        goto fail;
+    if ((cvk = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    s = buf;
+    if (yang_keyword_get(ylist) == Y_LEAF_LIST){
+        if (strlen(s) + 1 != len)
+            goto fail;
+        if (cvec_add_string(cvk, ".", s) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+    }
+    else {
+        i = 0;
+        while ((cvi = cvec_each(yang_cvec_get(ylist), cvi)) != NULL){
+            if (s >= buf + len)
+                goto fail;
+            if (cvec_add_string(cvk, cv_string_get(cvi), s) < 0){
+                clixon_err(OE_UNIX, errno, "cvec_add_string");
+                goto done;
+            }
+            s += strlen(s) + 1;
+            i++;
+        }
+        if (i == 0 || s != buf + len)
+            goto fail;
+    }
+    *cvkp = cvk;
+    cvk = NULL;
+    retval = 1;
+ done:
+    if (buf)
+        free(buf);
+    if (cvk)
+        cvec_free(cvk);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check if a list or leaf-list entry has the keys of a decoded cursor
+ *
+ * @param[in]  x      List or leaf-list entry
+ * @param[in]  cvk    Key names and values, see get_cursor_decode
+ * @retval     1      Match
+ * @retval     0      No match
+ */
+static int
+get_cursor_match(cxobj *x,
+                 cvec  *cvk)
+{
+    cg_var *cvi = NULL;
+    char   *body;
+
+    while ((cvi = cvec_each(cvk, cvi)) != NULL){
+        if (strcmp(cv_name_get(cvi), ".") == 0)
+            body = xml_body(x);
+        else
+            body = xml_find_body(x, cv_name_get(cvi));
+        if (body == NULL || strcmp(body, cv_string_get(cvi)) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+/*! Annotate the first entry of a list pagination result set with next and previous cursors
+ *
+ * @param[in]  xfirst First entry of result set
+ * @param[in]  ylist  YANG list or leaf-list
+ * @param[in]  xnext  Entry after the result set, or NULL
+ * @param[in]  xprev  First entry of the previous result set, or NULL
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+get_cursor_annotate(cxobj     *xfirst,
+                    yang_stmt *ylist,
+                    cxobj     *xnext,
+                    cxobj     *xprev)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (xnext){
+        if (get_cursor_encode(cb, xnext, ylist) < 0)
+            goto done;
+        if (xml_add_attr(xfirst, "next", cbuf_get(cb), "lpg",
+                         "urn:ietf:params:xml:ns:yang:ietf-list-pagination") == NULL)
+            goto done;
+        cbuf_reset(cb);
+    }
+    if (xprev){
+        if (get_cursor_encode(cb, xprev, ylist) < 0)
+            goto done;
+        if (xml_add_attr(xfirst, "previous", cbuf_get(cb), "lpg",
+                         "urn:ietf:params:xml:ns:yang:ietf-list-pagination") == NULL)
+            goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+#ifdef BACKEND_GET_ZEROCOPY
+/*! Get list or leaf-list entry i of a parent in a datastore cache
+ *
+ * Entries are either a range of the sorted child vector of the parent, or a vector
+ * @see get_pagination_range
+ */
+static cxobj *
+get_pagination_entry(cxobj   *xp,
+                     cxobj  **vec,
+                     int      start,
+                     uint32_t i)
+{
+    return vec ? vec[i] : xml_child_i(xp, start + i);
+}
+
+/*! Get the entries of a list or leaf-list in a parent of a datastore cache
+ *
+ * If the parent has a cached range of children of the list, see xml_child_group(), the entries
+ * are the range of the child vector and no vector is made
+ * @param[in]  xp     Parent
+ * @param[in]  ylist  YANG list or leaf-list
+ * @param[out] vecp   Vector of entries, or NULL if range. Free with free()
+ * @param[out] start  Start of range in child vector
+ * @param[out] n      Number of entries
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+get_pagination_range(cxobj      *xp,
+                     yang_stmt  *ylist,
+                     cxobj    ***vecp,
+                     int        *start,
+                     uint32_t   *n)
+{
+    cxobj *x = NULL;
+    int    end;
+    int    len = 0;
+
+    *vecp = NULL;
+    if (xml_child_group(xp, ylist, start, &end) == 1){
+        *n = end - *start;
+        return 0;
+    }
+    *start = 0;
+    while ((x = xml_child_each(xp, x, CX_ELMNT)) != NULL)
+        if (xml_spec(x) == ylist &&
+            cxvec_append(x, vecp, &len) < 0)
+            return -1;
+    *n = len;
+    return 0;
+}
+
+#ifdef LIST_PAGINATION_SORT_CACHE
+/*! Sort order of list entries in a datastore cache for a sort-by parameter
+ */
+struct pagination_sort {
+    qelem_t    ps_qelem;     /* List header */
+    char      *ps_db;        /* Datastore */
+    uint64_t   ps_gen;       /* Content generation of datastore, see xmldb_generation */
+    cxobj     *ps_xp;        /* Parent of entries in datastore cache, only compared */
+    yang_stmt *ps_ylist;     /* YANG list or leaf-list */
+    char      *ps_sort_by;   /* sort-by parameter */
+    uint32_t   ps_len;       /* Number of entries */
+    uint32_t  *ps_perm;      /* Entry of each sorted position */
+    uint32_t  *ps_rank;      /* Sorted position of each entry */
+};
+
+/*! Entry to be sorted, index makes the sort stable
+ */
+struct pagination_sort_elem {
+    cxobj     *se_x;
+    uint32_t   se_i;
+};
+
+static int
+get_pagination_sort_cmp(const void *arg1,
+                        const void *arg2,
+                        void       *sort_by)
+{
+    const struct pagination_sort_elem *se1 = arg1;
+    const struct pagination_sort_elem *se2 = arg2;
+    int                                eq;
+
+    if ((eq = xml_cmp(se1->se_x, se2->se_x, 1, 0, sort_by)) != 0)
+        return eq;
+    return se1->se_i < se2->se_i ? -1 : se1->se_i > se2->se_i;
+}
+
+/*! Free a sort order
+ */
+static void
+get_pagination_sort_free1(struct pagination_sort *ps)
+{
+    if (ps->ps_db)
+        free(ps->ps_db);
+    if (ps->ps_sort_by)
+        free(ps->ps_sort_by);
+    if (ps->ps_perm)
+        free(ps->ps_perm);
+    if (ps->ps_rank)
+        free(ps->ps_rank);
+    free(ps);
+}
+
+/*! Get the sort order of list entries for a sort-by parameter, cached for repeated requests
+ *
+ * Sort orders are cached for the content generation of the datastore, and at most
+ * LIST_PAGINATION_SORT_CACHE orders are kept, least recently used are removed first
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Datastore
+ * @param[in]  xp      Parent of entries in datastore cache
+ * @param[in]  ylist   YANG list or leaf-list
+ * @param[in]  sort_by sort-by parameter
+ * @param[in]  vec     Entries, see get_pagination_range
+ * @param[in]  start   Start of range of entries
+ * @param[in]  n       Number of entries
+ * @param[out] psp     Sort order, owned by the cache
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+get_pagination_sort(clixon_handle            h,
+                    char                    *db,
+                    cxobj                   *xp,
+                    yang_stmt               *ylist,
+                    char                    *sort_by,
+                    cxobj                  **vec,
+                    int                      start,
+                    uint32_t                 n,
+                    struct pagination_sort **psp)
+{
+    int                          retval = -1;
+    struct pagination_sort      *head = NULL;
+    struct pagination_sort      *ps;
+    struct pagination_sort      *ps1;
+    struct pagination_sort_elem *se = NULL;
+    uint64_t                     gen;
+    uint32_t                     i;
+    int                          nr = 0;
+
+    gen = xmldb_generation(h, db);
+    clicon_ptr_get(h, "pagination-sort", (void**)&head);
+    *psp = NULL;
+    if ((ps = head) != NULL){
+        do {
+            ps1 = NEXTQ(struct pagination_sort *, ps);
+            if (strcmp(ps->ps_db, db) == 0 && ps->ps_gen != gen){ /* Datastore modified */
+                DELQ(ps, head, struct pagination_sort *);
+                get_pagination_sort_free1(ps);
+            }
+            else if (*psp == NULL &&
+                     ps->ps_xp == xp && ps->ps_ylist == ylist && ps->ps_len == n &&
+                     strcmp(ps->ps_db, db) == 0 &&
+                     strcmp(ps->ps_sort_by, sort_by) == 0)
+                *psp = ps;
+            ps = ps1;
+        } while (head && ps != head);
+    }
+    if ((ps = *psp) != NULL){ /* Move first */
+        DELQ(ps, head, struct pagination_sort *);
+        INSQ(ps, head);
+        goto ok;
+    }
+    if ((ps = calloc(1, sizeof(*ps))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    ps->ps_gen = gen;
+    ps->ps_xp = xp;
+    ps->ps_ylist = ylist;
+    ps->ps_len = n;
+    if ((ps->ps_db = strdup(db)) == NULL ||
+        (ps->ps_sort_by = strdup(sort_by)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        get_pagination_sort_free1(ps);
+        goto done;
+    }
+    if ((ps->ps_perm = calloc(n + 1, sizeof(uint32_t))) == NULL ||
+        (ps->ps_rank = calloc(n + 1, sizeof(uint32_t))) == NULL ||
+        (se = calloc(n + 1, sizeof(*se))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        get_pagination_sort_free1(ps);
+        goto done;
+    }
+    for (i=0; i<n; i++){
+        se[i].se_x = get_pagination_entry(xp, vec, start, i);
+        se[i].se_i = i;
+    }
+#ifdef HAVE_QSORT_S
+    qsort_s(se, n, sizeof(*se), get_pagination_sort_cmp, sort_by);
+#else
+    qsort_r(se, n, sizeof(*se), get_pagination_sort_cmp, sort_by);
+#endif
+    for (i=0; i<n; i++){
+        ps->ps_perm[i] = se[i].se_i;
+        ps->ps_rank[se[i].se_i] = i;
+    }
+    INSQ(ps, head);
+    /* Remove least recently used */
+    ps = head;
+    do {
+        nr++;
+        ps = NEXTQ(struct pagination_sort *, ps);
+    } while (ps != head);
+    while (nr-- > LIST_PAGINATION_SORT_CACHE){
+        ps = PREVQ(struct pagination_sort *, head);
+        DELQ(ps, head, struct pagination_sort *);
+        get_pagination_sort_free1(ps);
+    }
+    *psp = head;
+ ok:
+    clicon_ptr_set(h, "pagination-sort", head);
+    retval = 0;
+ done:
+    if (se)
+        free(se);
+    return retval;
+}
+#endif /* LIST_PAGINATION_SORT_CACHE */
+
+/*! Copy the ancestors of a parent in a datastore cache, with keys of lists
+ *
+ * @param[in]  xt     Datastore cache
+ * @param[in]  xp     Parent in datastore cache
+ * @param[out] xretp  Copy of top
+ * @param[out] xcp    Copy of parent
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+get_pagination_ancestors(cxobj  *xt,
+                         cxobj  *xp,
+                         cxobj **xretp,
+                         cxobj **xcp)
+{
+    cxobj     *xpc;
+    cxobj     *xc;
+    cxobj     *x = NULL;
+    yang_stmt *y;
+    cg_var    *cvi = NULL;
+
+    if (xp == xt){
+        if ((*xretp = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            return -1;
+        *xcp = *xretp;
+        return 0;
+    }
+    if (get_pagination_ancestors(xt, xml_parent(xp), xretp, &xpc) < 0)
+        return -1;
+    if ((xc = xml_new(xml_name(xp), xpc, CX_ELMNT)) == NULL)
+        return -1;
+    if (xml_copy_one(xp, xc) < 0)
+        return -1;
+    while ((x = xml_child_each(xp, x, CX_ATTR)) != NULL)
+        if (xml_addsub(xc, xml_dup(x)) < 0)
+            return -1;
+    if ((y = xml_spec(xp)) != NULL && yang_keyword_get(y) == Y_LIST)
+        while ((cvi = cvec_each(yang_cvec_get(y), cvi)) != NULL)
+            if ((x = xml_find_type(xp, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL &&
+                xml_addsub(xc, xml_dup(x)) < 0)
+                return -1;
+    *xcp = xc;
+    return 0;
+}
+
+/*! List pagination of config data directly from the sorted datastore cache
+ *
+ * Entries of the result set are found by position in the sorted child vector of the list
+ * parent, and a cursor entry by key lookup. With sort-by, a sort order of the entries is made
+ * once and cached until the datastore is modified. Only the entries of the result set and
+ * their ancestors are copied, so that a page is O(limit) also in very large lists.
+ * @param[in]  h         Clixon handle
+ * @param[in]  db        Datastore
+ * @param[in]  ylist     YANG list or leaf-list
+ * @param[in]  xpath     Canonical XPath of list, last step without predicate
+ * @param[in]  nsc       Namespace context of xpath
+ * @param[in]  sort_by   sort-by parameter, or NULL
+ * @param[in]  backwards direction parameter is backwards
+ * @param[in]  cursor    cursor parameter, or NULL
+ * @param[in]  offset    Start of result set, after cursor
+ * @param[in]  limit     Number of entries, 0 is unbounded
+ * @param[in]  depth     Nr of levels to print, -1 is all
+ * @param[in]  username  User name of requestor
+ * @param[in]  wdef      With-defaults parameter
+ * @param[out] cbret     Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     1         OK, reply or error in cbret
+ * @retval     0         Not applicable, eg the list has more than one parent
+ * @retval    -1         Error
+ */
+static int
+get_pagination_cache(clixon_handle     h,
+                     char             *db,
+                     yang_stmt        *ylist,
+                     char             *xpath,
+                     cvec             *nsc,
+                     char             *sort_by,
+                     int               backwards,
+                     char             *cursor,
+                     uint32_t          offset,
+                     uint32_t          limit,
+                     int32_t           depth,
+                     char             *username,
+                     withdefaults_type wdef,
+                     cbuf             *cbret)
+{
+    int        retval = -1;
+    char      *p;
+    char      *pxpath = NULL;
+    cxobj     *xt = NULL;
+    cxobj     *xp;
+    cxobj     *xerr = NULL;
+    cxobj     *xret = NULL;
+    cxobj     *xpc = NULL;
+    cxobj     *x;
+    cxobj     *xfirst = NULL;
+    cxobj    **xvec = NULL;
+    size_t     xlen = 0;
+    cxobj    **vec = NULL;
+    cvec      *cvk = NULL;
+    cbuf      *cbmsg = NULL;
+    clixon_xvec *xv = NULL;
+    int        start = 0;
+    uint32_t   n = 0;
+    uint32_t   first;
+    uint32_t   upper;
+    uint32_t   pos;
+    uint32_t   i;
+    uint32_t  *perm = NULL;
+    uint32_t  *rank = NULL;
+    int        ret;
+#ifdef LIST_PAGINATION_SORT_CACHE
+    struct pagination_sort *ps = NULL;
+#endif
+
+    /* Parent xpath: xpath without last step */
+    if (xpath == NULL ||
+        (p = strrchr(xpath, '/')) == NULL ||
+        strchr(p, '[') != NULL || strchr(p, ']') != NULL ||
+        strchr(xpath, '|') != NULL ||
+        (p > xpath && *(p-1) == '/'))
+        goto skip;
+#ifndef LIST_PAGINATION_SORT_CACHE
+    if (sort_by)
+        goto skip;
+#endif
+    if (p > xpath && (pxpath = strndup(xpath, p - xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strndup");
+        goto done;
+    }
+    if ((ret = xmldb_get_cache(h, db, YB_MODULE, &xt, NULL, &xerr)) < 0){
+        if ((cbmsg = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbmsg, "Get %s datastore: %s", db, clixon_err_reason());
+        if (netconf_operation_failed(cbret, "application", cbuf_get(cbmsg)) < 0)
+            goto done;
+        goto ok;
+    }
+    if (ret == 0){
+        if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
+            goto done;
+        goto ok;
+    }
+    if (pxpath == NULL)
+        xp = xt;
+    else {
+        if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, pxpath) < 0)
+            goto done;
+        if (xlen > 1)
+            goto skip;
+        xp = xlen ? xvec[0] : NULL;
+    }
+    if (xp != NULL &&
+        get_pagination_range(xp, ylist, &vec, &start, &n) < 0)
+        goto done;
+    if (n == 0){
+        if (get_nacm_and_reply(h, NULL, xpath, nsc, username, depth, wdef, cbret) < 0)
+            goto done;
+        goto ok;
+    }
+#ifdef LIST_PAGINATION_SORT_CACHE
+    if (sort_by){
+        if (get_pagination_sort(h, db, xp, ylist, sort_by, vec, start, n, &ps) < 0)
+            goto done;
+        perm = ps->ps_perm;
+        rank = ps->ps_rank;
+    }
+#endif
+    /* Position of cursor entry in the working result-set */
+    pos = 0;
+    if (cursor && strlen(cursor)){
+        if ((ret = get_cursor_decode(cursor, ylist, &cvk)) < 0)
+            goto done;
+        x = NULL;
+        if (ret == 1){
+            if ((xv = clixon_xvec_new()) == NULL)
+                goto done;
+            if (clixon_xml_find_index(xp, xml_spec(xp)?NULL:ys_module(ylist),
+                                      NULL, yang_argument_get(ylist), cvk, xv) < 0)
+                goto done;
+            if (clixon_xvec_len(xv) == 1)
+                x = clixon_xvec_i(xv, 0);
+        }
+        if (x == NULL){
+            if (netconf_invalid_value(cbret, "application", "cursor not found in list") < 0)
+                goto done;
+            goto ok;
+        }
+        if (vec){
+            for (i=0; i<n; i++)
+                if (vec[i] == x)
+                    break;
+        }
+        else
+            i = xml_child_order(xp, x) - start;
+        if (rank)
+            i = rank[i];
+        pos = backwards ? n - 1 - i : i;
+    }
+    first = pos + offset;
+    if (first < pos || first >= n){ /* Past the end */
+        if (get_nacm_and_reply(h, NULL, xpath, nsc, username, depth, wdef, cbret) < 0)
+            goto done;
+        goto ok;
+    }
+    if (limit == 0 || (upper = first + limit) > n || upper < first)
+        upper = n;
+    if (get_pagination_ancestors(xt, xp, &xret, &xpc) < 0)
+        goto done;
+    for (i=first; i<upper; i++){
+        pos = backwards ? n - 1 - i : i;
+        if (perm)
+            pos = perm[pos];
+        if ((x = xml_dup(get_pagination_entry(xp, vec, start, pos))) == NULL)
+            goto done;
+        if (xml_addsub(xpc, x) < 0)
+            goto done;
+        if (xfirst == NULL)
+            xfirst = x;
+    }
+    if (cursor){
+        cxobj *xnext = NULL;
+        cxobj *xprev = NULL;
+
+        if (limit && upper < n){
+            pos = backwards ? n - 1 - upper : upper;
+            xnext = get_pagination_entry(xp, vec, start, perm ? perm[pos] : pos);
+        }
+        if (first > 0){
+            pos = (limit && first > limit) ? first - limit : 0;
+            pos = backwards ? n - 1 - pos : pos;
+            xprev = get_pagination_entry(xp, vec, start, perm ? perm[pos] : pos);
+        }
+        if (get_cursor_annotate(xfirst, ylist, xnext, xprev) < 0)
+            goto done;
+    }
+    if (get_nacm_and_reply(h, xret, xpath, nsc, username, depth, wdef, cbret) < 0)
+        goto done;
+ ok:
+    retval = 1;
+ done:
+    if (pxpath)
+        free(pxpath);
+    if (xvec)
+        free(xvec);
+    if (vec)
+        free(vec);
+    if (cvk)
+        cvec_free(cvk);
+    if (xv)
+        clixon_xvec_free(xv);
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    if (xerr)
+        xml_free(xerr);
+    if (xret)
+        xml_free(xret);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+#endif /* BACKEND_GET_ZEROCOPY */
+
+/*! Free cached sort orders of list pagination
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ */
+int
+get_pagination_free(clixon_handle h)
+{
+#if defined(BACKEND_GET_ZEROCOPY) && defined(LIST_PAGINATION_SORT_CACHE)
+    struct pagination_sort *head = NULL;
+    struct pagination_sort *ps;
+
+    clicon_ptr_get(h, "pagination-sort", (void**)&head);
+    while ((ps = head) != NULL){
+        DELQ(ps, head, struct pagination_sort *);
+        get_pagination_sort_free1(ps);
+    }
+    clicon_ptr_del(h, "pagination-sort");
+#endif
+    return 0;
+}
+
+/*! Stop get-config reader threads, if started
+ *
+ * Called before datastores are freed, since threads read the held read-only running
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @see CLICON_BACKEND_READ_THREADS
+ */
+int
+get_read_threads_exit(clixon_handle h)
+{
+#if defined(BACKEND_GET_ZEROCOPY) && defined(HAVE_LIBPTHREAD)
+    get_read_pool_exit(h);
+#endif
+    return 0;
+}
+
+/*! Free cached get-config replies
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @see BACKEND_GET_REPLY_CACHE
+ */
+int
+get_reply_cache_free(clixon_handle h)
+{
+#if defined(BACKEND_GET_ZEROCOPY) && defined(BACKEND_GET_REPLY_CACHE)
+    struct reply_cache *head = NULL;
+    struct reply_cache *rc;
+
+    clicon_ptr_get(h, "get-reply-cache", (void**)&head);
+    while ((rc = head) != NULL){
+        DELQ(rc, head, struct reply_cache *);
+        get_reply_cache_free1(rc);
+    }
+    clicon_ptr_del(h, "get-reply-cache");
+#endif
+    return 0;
+}
+
+/*! Special handling of state data for partial reading
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  ce        Client entry, for locking
+ * @param[in]  yspec     (Top-level) yang spec
+ * @param[in]  xpath     XPath point to object to get
+ * @param[in]  where
+ * @param[in]  sort_by
+ * @param[in]  direction NULL means forward
+ * @param[in]  offset    Start of pagination interval
+ * @param[in]  limit     Number of elements (limit)
+ * @param[out] xret      Returned xml state tree
+ * @param[out] cbret     Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     1         OK
+ * @retval     0         Fail, cbret contains error message
+ * @retval    -1         Error
+ */
+static int
+get_pagination_state_partial(clixon_handle        h,
+                             struct client_entry *ce,
+                             yang_stmt           *yspec,
+                             char                *xpath,
+                             char                *where,
+                             char                *sort_by,
+                             char                *direction,
+                             uint32_t             offset,
+                             uint32_t             limit,
+                             cxobj               *xret,
+                             cbuf                *cbret)
+{
+    int                 retval = -1;
+    int                 locked;
+    cbuf               *cberr = NULL;
+    uint32_t            iddb; /* DBs lock, if any */
+    cxobj              *xerr = NULL;
+    pagination_data_t   pd = {0,};
+    dispatcher_entry_t *htable = NULL;
+    int                 ret;
+
+    clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
+    if ((iddb = xmldb_islocked(h, "running")) != 0 &&
+        iddb == ce->ce_id)
+        locked = 1;
+    else
+        locked = 0;
+    pd.pd_where = where;
+    pd.pd_sort_by = sort_by;
+    pd.pd_direction = direction;
+    pd.pd_offset = offset;
+    pd.pd_limit = limit;
+    pd.pd_locked = locked;
+    pd.pd_xstate = xret;
+    clicon_ptr_get(h, "pagination-entries", (void**)&htable);
+    if (htable){
+        if (dispatcher_call_handlers(htable, h, xpath, &pd) < 0){
+            if ((cberr = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            /* error reason should be in clixon_err_reason */
+            cprintf(cberr, "Internal error, pagination state callback invalid return : %s",
+                    clixon_err_reason());
+            if (netconf_operation_failed_xml(&xerr, "application", cbuf_get(cberr)) < 0)
+                goto done;
+            if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
+                goto done;
+            goto fail;
+        }
+    }
+
+    /* System makes the binding */
+    if ((ret = xml_bind_yang(h, xret, YB_MODULE, yspec, 0, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_debug_xml(CLIXON_DBG_BACKEND, xret, "Yang bind pagination state");
+        if (clixon_netconf_internal_error(xerr,
+                                          ". Internal error, state callback returned invalid XML",
+                                          NULL) < 0)
+            goto done;
+        if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
+            goto done;
+        goto fail;
+    }
+    retval = 1;
+ done:
+    if (cberr)
+        cbuf_free(cberr);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Specialized get for list-pagination
+ *
+ * It is specialized enough to have its own function. Specifically, extra attributes as well
+ * as the list-paginaiton API
+ * @param[in]  h       Clixon handle
+ * @param[in]  ce      Client entry, for locking
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[in]  content Get config/state/both
+ * @param[in]  db      Database name
+ * @param[in]  depth   Depth attribute
+ * @param[in]  yspec   (Top-level) yang spec
+ * @param[in]  xpath   XPath point to object to get
+ * @param[in]  nsc     Namespace context of xpath
+ * @param[in]  username
+ * @param[in]  wdef    With-defaults parameter, see RFC 6243
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @note pagination uses appending xpath with predicate, eg [position()<limit], this may not work
+ *       if there is an existing predicate
+ * XXX Reuse code with get_common
+ * From draft-ietf-netconf-list-pagination-04.txt 3.1:
+   The order is as follows: a server first processes the "where"
+   parameter (see Section 3.1.1), then the "sort-by" parameter (see
+   Section 3.1.2), then the "direction" parameter (see Section 3.1.4),
+   and either a combination of the "offset" parameter (see
+   Section 3.1.5) or the "cursor" parameter (see Section 3.1.6), and
+   lastly "the "limit" parameter (see Section 3.1.7).
+ */
+static int
+get_list_pagination(clixon_handle        h,
+                    struct client_entry *ce,
+                    cxobj               *xe,
+                    netconf_content      content,
+                    char                *db,
+                    int32_t              depth,
+                    yang_stmt           *yspec,
+                    char                *xpath,
+                    cvec                *nsc,
+                    char                *username,
+                    withdefaults_type    wdef,
+                    cbuf                *cbret
+                    )
+{
+    int        retval = -1;
+    uint32_t   offset = 0;
+    uint32_t   limit = 0;
+    uint32_t   upper;
+    int        partial_pagination_cb = 0; /* use state partial reads callback */
+    int        statelist_cb = 0;          /* use state list producer */
+    yang_stmt *ylist;
+    cxobj     *xerr = NULL;
+    cbuf      *cbmsg = NULL; /* For error msg */
+    cxobj     *xret = NULL;
+    cxobj    **xvec = NULL;
+    cxobj    **xvec2;
+    size_t     xlen;
+    cxobj     *x;
+    cxobj     *xj;
+    cxobj     *xp;
+    char      *sort_by = NULL;
+    char      *direction = NULL;
+    char      *where = NULL;
+    char      *cursor = NULL;
+    cvec      *cvk = NULL;
+    int        i;
+    int        j;
+    int        ret;
+    dispatcher_entry_t *htable = NULL;
+    dispatcher_entry_t *sltable = NULL;
+    cvec      *wherens = NULL;
+    //    int        extflag = 0;
+#ifdef LIST_PAGINATION_REMAINING
+    cxobj     *xcache;
+    uint32_t   total;
+    uint32_t   remaining = 0;
+#endif
+
+    clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
+    if (cbret == NULL){
+        clixon_err(OE_PLUGIN, EINVAL, "cbret is NULL");
+        goto done;
+    }
+    /* Check if list/leaf-list */
+    if (yang_path_arg(yspec, xpath?xpath:"/", &ylist) < 0)
+        goto done;
+    if (ylist == NULL){
+        if ((cbmsg = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        /* error reason should be in clixon_err_reason() */
+        cprintf(cbmsg, "Netconf get list-pagination: \"%s\" not found", xpath);
+        if (netconf_invalid_value(cbret, "application", cbuf_get(cbmsg)) < 0)
+            goto done;
+        goto ok;
+    }
+    if (yang_keyword_get(ylist) != Y_LIST &&
+        yang_keyword_get(ylist) != Y_LEAF_LIST){
+        if (netconf_invalid_value(cbret, "application", "list-pagination is enabled but target is not list or leaf-list") < 0)
+            goto done;
+        goto ok;
+    }
+    /* Sanity checks on state/config */
+    if (yang_config_ancestor(ylist) != 0){ /* config list */
+        if (content == CONTENT_NONCONFIG){
+            if (netconf_invalid_value(cbret, "application", "list-pagination targets a config list but content request is nonconfig") < 0)
+                goto done;
+            goto ok;
+        }
+    }
+    else { /* state list */
         if (content == CONTENT_CONFIG){
             if (netconf_invalid_value(cbret, "application", "list-pagination targets a state list but content request is config") < 0)
                 goto done;
@@ -735,13 +2720,47 @@ get_list_pagination(clixon_handle        h,
         if (strcmp(direction, "forwards") == 0)
             direction = NULL;
     }
-    /* the "offset" parameter (see Section 3.1.5) or
-       NYI: the "cursor" parameter (see Section 3.1.6)
+    /* the "cursor" parameter (see Section 3.1.6), offset is counted from the cursor entry
+       An empty cursor is the first entry, and requests next and previous cursors */
+    if ((x = xml_find_type(xe, NULL, "cursor", CX_ELMNT)) != NULL)
+        cursor = xml_body(x) ? xml_body(x) : "";
+    /* the "offset" parameter (see Section 3.1.5)
        lastly "the "limit" parameter (see Section 3.1.7) */
     if ((ret = list_pagination_hdr(h, xe, &offset, &limit, cbret)) < 0)
         goto done;
     if (ret == 0)
         goto ok;
+    /* State list producer yields entries in key order and seeks to offset */
+    if (yang_config_ancestor(ylist) == 0 &&
+        !partial_pagination_cb &&
+        where == NULL && sort_by == NULL && direction == NULL){
+        if ((ret = get_statelist_match(h, xpath, &sltable)) < 0)
+            goto done;
+        statelist_cb = ret;
+    }
+    if (cursor && (partial_pagination_cb || statelist_cb)){
+        if (netconf_invalid_value(cbret, "application", "list-pagination cursor is not supported for lists with pagination callbacks") < 0)
+            goto done;
+        goto ok;
+    }
+#ifdef BACKEND_GET_ZEROCOPY
+    /* Config list: page directly from the sorted datastore cache */
+    if (content == CONTENT_CONFIG &&
+        where == NULL &&
+#ifdef XMLDB_DEFAULTS_VIRTUAL
+        /* Cache has no defaults */
+        (wdef == WITHDEFAULTS_EXPLICIT || wdef == WITHDEFAULTS_TRIM) &&
+#endif
+        !clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG") &&
+        !clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY")){
+        if ((ret = get_pagination_cache(h, db, ylist, xpath, nsc, sort_by, direction != NULL,
+                                        cursor, offset, limit, depth, username, wdef,
+                                        cbret)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
+    }
+#endif
     /* Read config */
     switch (content){
     case CONTENT_CONFIG:    /* config data only */
@@ -777,6 +2796,13 @@ get_list_pagination(clixon_handle        h,
         if (ret == 0)
             goto ok;
     }
+    else if (statelist_cb) {
+        if ((ret = get_pagination_statelist(h, ce, sltable, yspec, xpath, nsc,
+                                            offset, limit, &xret, cbret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
     else {
         if (content != CONTENT_CONFIG){
             if ((ret = get_state_data(h, xpath?xpath:"/", nsc, &xret)) < 0)
@@ -794,6 +2820,9 @@ get_list_pagination(clixon_handle        h,
             if (xml_default_recurse(xret, 1, 0) < 0)
                 goto done;
         }
+        /* Pagination below assumes state data is sorted, see xml_sort_lazy */
+        if (xml_sort_ensure_recurse(xret) < 0)
+            goto done;
         /* first processes the "where" parameter (see Section 3.1.1) */
         if (where){
             if (xpath_vec(xret, nsc, "%s[%s]", &xvec, &xlen, xpath?xpath:"/", where) < 0)
@@ -845,6 +2874,19 @@ get_list_pagination(clixon_handle        h,
            lastly "the "limit" parameter (see Section 3.1.7) */
         if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
             goto done;
+        if (cursor && strlen(cursor)){
+            if ((ret = get_cursor_decode(cursor, ylist, &cvk)) < 0)
+                goto done;
+            for (i=0; ret == 1 && i<xlen; i++)
+                if (get_cursor_match(xvec[i], cvk))
+                    break;
+            if (ret == 0 || i == xlen){
+                if (netconf_invalid_value(cbret, "application", "cursor not found in list") < 0)
+                    goto done;
+                goto ok;
+            }
+            offset = (offset > xlen - i) ? xlen : offset + i;
+        }
         if (limit == 0)
             upper = xlen;
         else{
@@ -856,6 +2898,11 @@ get_list_pagination(clixon_handle        h,
                 break;
             xml_flag_set(x, XML_FLAG_MARK);
         }
+        if (cursor && offset < upper &&
+            get_cursor_annotate(xvec[offset], ylist,
+                                (limit && upper < xlen) ? xvec[upper] : NULL,
+                                offset ? xvec[(limit && offset > limit) ? offset - limit : 0] : NULL) < 0)
+            goto done;
         /* Remove everything that is not marked */
         if (xml_tree_prune_flagged_sub(xret, XML_FLAG_MARK, 1, NULL) < 0)
             goto done;
@@ -910,6 +2957,8 @@ get_list_pagination(clixon_handle        h,
  done:
     if (wherens)
         cvec_free(wherens);
+    if (cvk)
+        cvec_free(cvk);
     if (xvec)
         free(xvec);
     if (cbmsg)
@@ -921,6 +2970,60 @@ get_list_pagination(clixon_handle        h,
     return retval;
 }
 
+/*! Get depth hint for reading data, where the depth is applied already when reading
+ *
+ * Data below depth is not printed and need not be copied from the datastore or produced
+ * by state callbacks. The hint is only given if the reply is otherwise unchanged:
+ * NACM may not prune the tree, since a node is visible if a descendant is permitted, and
+ * predicates of the xpath may not refer to nodes deeper than children of the selected nodes
+ * @param[in]  h        Clixon handle
+ * @param[in]  xpath    XPath of get, or NULL
+ * @param[in]  username User name for NACM access
+ * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
+ * @param[out] hint     Depth hint, or -1 if the complete data is read
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xmldb_get_depth
+ */
+static int
+get_depth_hint(clixon_handle h,
+               char         *xpath,
+               char         *username,
+               int32_t       depth,
+               int32_t      *hint)
+{
+    int   retval = -1;
+    char *p;
+    int   level = 0;
+    int   ret;
+
+    *hint = -1;
+    if (depth < 0 ||
+        clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML"))
+        goto ok;
+    if (xpath != NULL){
+        if (strstr(xpath, "//") != NULL)
+            goto ok;
+        /* Predicates may only refer to children, eg [x:name='a'] but not [x:a/x:b='c'] */
+        for (p = xpath; *p != '\0'; p++){
+            if (*p == '[')
+                level++;
+            else if (*p == ']')
+                level--;
+            else if (level > 0 && (*p == '/' || *p == '('))
+                goto ok;
+        }
+    }
+    if ((ret = nacm_datanode_read_permitted(h, username, clicon_nacm_cache(h))) < 0)
+        goto done;
+    if (ret == 1)
+        *hint = depth;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Common get/get-config code for retrieving  configuration and state information.
  *
  * @param[in]  h       Clixon handle
@@ -966,6 +3069,12 @@ get_common(clixon_handle        h,
     cxobj            *xlpg2 = NULL;
     withdefaults_type wdef;
     char             *wdefstr;
+    int               frozen;
+    dispatcher_entry_t *sltable = NULL;
+    int32_t           hint;
+#ifdef BACKEND_GET_ZEROCOPY
+    int               readall;
+#endif
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     wdef = WITHDEFAULTS_EXPLICIT;
@@ -1030,11 +3139,60 @@ get_common(clixon_handle        h,
             goto ok;
         }
     }
+    /* State list with a producer: stream entries in batches */
+    if (content != CONTENT_CONFIG &&
+        depth < 0 &&
+        !clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML")){
+        if ((ret = get_statelist_match(h, xpath, &sltable)) < 0)
+            goto done;
+        if (ret == 1){
+            if ((ret = get_statelist_stream(h, ce, sltable, yspec, xpath, nsc,
+                                            username, wdef, cbret)) < 0)
+                goto done;
+            if (ret == 1)
+                goto ok;
+        }
+    }
+#ifdef BACKEND_GET_ZEROCOPY
+    /* NACM permits user to read everything */
+    if ((readall = nacm_datanode_read_permitted(h, username, clicon_nacm_cache(h))) < 0)
+        goto done;
+    /* Config only: reply directly from datastore cache unless the reply needs to be modified */
+    if (content == CONTENT_CONFIG &&
+        depth != 0 &&
+#ifdef XMLDB_DEFAULTS_VIRTUAL
+        /* Cache has no defaults */
+        (wdef == WITHDEFAULTS_EXPLICIT || wdef == WITHDEFAULTS_TRIM) &&
+#endif
+        !clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG") &&
+        !clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY")){
+#ifdef HAVE_LIBPTHREAD
+        /* Reader threads print without NACM read filter */
+        if (readall == 1){
+            if ((ret = get_config_thread(h, ce, db, xpath, depth, wdef)) < 0)
+                goto done;
+            if (ret == 1)
+                goto ok;
+        }
+#endif
+#ifdef BACKEND_GET_REPLY_CACHE
+        if (get_config_cached(h, ce, db, xpath, nsc, depth, wdef, username, readall, cbret) < 0)
+            goto done;
+#else
+        if (get_config_zerocopy(h, ce, db, xpath, nsc, depth, wdef, username, cbret) < 0)
+            goto done;
+#endif
+        goto ok;
+    }
+#endif
+    /* Data below depth is not printed, do not read it if possible */
+    if (get_depth_hint(h, xpath, username, depth, &hint) < 0)
+        goto done;
     /* Read configuration */
     switch (content){
     case CONTENT_CONFIG:    /* config data only */
         /* specific xpath. with-default gets masked in get_nacm_and_reply */
-        if ((ret = xmldb_get0(h, db, YB_MODULE, nsc, xpath?xpath:"/", 1, WITHDEFAULTS_REPORT_ALL, &xret, NULL, &xerr)) < 0) {
+        if ((ret = xmldb_get_depth(h, db, YB_MODULE, nsc, xpath?xpath:"/", hint, WITHDEFAULTS_REPORT_ALL, &xret, NULL, &xerr)) < 0) {
             if ((cbmsg = cbuf_new()) == NULL){
                 clixon_err(OE_UNIX, errno, "cbuf_new");
                 goto done;
@@ -1072,7 +3230,7 @@ get_common(clixon_handle        h,
         }
         else if (content == CONTENT_ALL){
             /* specific xpath */
-            if ((ret = xmldb_get0(h, db, YB_MODULE, nsc, xpath?xpath:"/", 1, WITHDEFAULTS_REPORT_ALL, &xret, NULL, &xerr)) < 0) {
+            if ((ret = xmldb_get_depth(h, db, YB_MODULE, nsc, xpath?xpath:"/", hint, WITHDEFAULTS_REPORT_ALL, &xret, NULL, &xerr)) < 0) {
                 if ((cbmsg = cbuf_new()) == NULL){
                     clixon_err(OE_UNIX, errno, "cbuf_new");
                     goto done;
@@ -1102,7 +3260,13 @@ get_common(clixon_handle        h,
         break;
     case CONTENT_ALL:       /* both config and state */
     case CONTENT_NONCONFIG: /* state data only */
-        if ((ret = get_state_data(h, xpath?xpath:"/", nsc, &xret)) < 0)
+        /* Depth hint to state callbacks, see plgstatedata_t */
+        if (hint >= 0)
+            clicon_data_int_set(h, "clixon-get-depth", hint);
+        ret = get_state_data(h, xpath?xpath:"/", nsc, &xret);
+        if (hint >= 0)
+            clicon_data_int_del(h, "clixon-get-depth");
+        if (ret < 0)
             goto done;
         if (ret == 0){ /* Error from callback (error in xret) */
             if (clixon_xml2cbuf1(cbret, xret, 0, 0, NULL, -1, 0, 0) < 0)
@@ -1124,6 +3288,8 @@ get_common(clixon_handle        h,
          * Primarily intended for user-supplied state-data.
          * The whole config tree must be present in case the state data references config data
          */
+        if (xml_sort_ensure_recurse(xret) < 0)
+            goto done;
         if ((ret = xml_yang_validate_all_top(h, xret, &xerr)) < 0)
             goto done;
         if (ret > 0 &&
@@ -1152,7 +3318,10 @@ get_common(clixon_handle        h,
             if (xml_apply(xret, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
                 goto done;
         }
-    if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+    frozen = xpath_parallel_frozen(1);
+    ret = xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/");
+    xpath_parallel_frozen(frozen);
+    if (ret < 0)
         goto done;
     if (filter_xpath_again(h, yspec, xret, xvec, xlen, xpath, nsc) < 0)
         goto done;
@@ -1187,6 +3356,76 @@ get_common(clixon_handle        h,
     return retval;
 }
 
+/*! Sample config and state data of running selected by xpath, as a <get> without NACM
+ *
+ * Used by periodic push to read a subtree once for all subscriptions of the same filter
+ * @param[in]  h       Clixon handle
+ * @param[in]  xpath   XPath of subtree, NULL or "/" is all
+ * @param[in]  nsc     Namespace context of xpath, or NULL
+ * @param[out] xret    Result tree, or error tree if fail. Free with xml_free
+ * @retval     1       OK
+ * @retval     0       Fail, error message in xret
+ * @retval    -1       Error
+ * @see get_common
+ */
+int
+get_sample(clixon_handle h,
+           char         *xpath,
+           cvec         *nsc,
+           cxobj       **xret)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    cxobj     *xt = NULL;
+    cxobj     *xerr = NULL;
+    cxobj    **xvec = NULL;
+    size_t     xlen;
+    int        ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if (xpath == NULL)
+        xpath = "/";
+    if ((ret = xmldb_get0(h, "running", YB_MODULE, nsc, xpath, 1, WITHDEFAULTS_REPORT_ALL, &xt, NULL, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        *xret = xerr;
+        xerr = NULL;
+        goto fail;
+    }
+    if ((ret = get_state_data(h, xpath, nsc, &xt)) < 0)
+        goto done;
+    if (ret == 0){ /* Error from callback (error in xt) */
+        *xret = xt;
+        xt = NULL;
+        goto fail;
+    }
+    if (xml_global_defaults(h, xt, nsc, xpath, yspec, 1) < 0)
+        goto done;
+    if (xml_default_recurse(xt, 1, 0) < 0)
+        goto done;
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
+        goto done;
+    if (filter_xpath_again(h, yspec, xt, xvec, xlen, xpath, nsc) < 0)
+        goto done;
+    *xret = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (xvec)
+        free(xvec);
+    if (xt)
+        xml_free(xt);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Retrieve all or part of a specified configuration.
  *
  * @param[in]  h       Clixon handle
@@ -1213,6 +3452,8 @@ from_client_get_config(clixon_handle h,
         clixon_err(OE_XML, 0, "db not found");
         goto done;
     }
+    if (private_candidate_db(h, ce, db, 0, &db) < 0)
+        goto done;
     retval = get_common(h, ce, xe, CONTENT_CONFIG, db, cbret);
  done:
     return retval;
@@ -1246,3 +3487,332 @@ from_client_get(clixon_handle h,
         content = netconf_content_str2int(attr);
     return get_common(h, ce, xe, content, "running", cbret);
 }
+
+/*! Add distinct values of nodes to reply, filtered by prefix and limit
+ *
+ * If the nodes are the only key of a list ordered-by system and of string type, they
+ * are sorted and the first value with the prefix is found by binary search.
+ * @param[in]  xvec    Vector of nodes (elements or bodies)
+ * @param[in]  xlen    Length of vector
+ * @param[in]  prefix  Only values beginning with prefix, or NULL
+ * @param[in]  limit   Max nr of values, 0 is unbounded
+ * @param[out] cbret   Reply with <value> elements
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+expand_values_reply(cxobj   **xvec,
+                    size_t    xlen,
+                    char     *prefix,
+                    uint32_t  limit,
+                    cbuf     *cbret)
+{
+    int            retval = -1;
+    clicon_hash_t *hdup = NULL;
+    yang_stmt     *y = NULL;
+    yang_stmt     *yp;
+    cvec          *cvk;
+    cg_var        *cv;
+    char          *body;
+    char          *bodyprev = NULL;
+    size_t         plen = prefix ? strlen(prefix) : 0;
+    size_t         lo = 0;
+    size_t         hi;
+    size_t         mid;
+    size_t         i;
+    uint32_t       n = 0;
+    int            sorted = 0;
+
+    if (xlen && xml_type(xvec[0]) == CX_ELMNT)
+        y = xml_spec(xvec[0]);
+    if (y != NULL && yang_keyword_get(y) == Y_LEAF &&
+        (yp = yang_parent_get(y)) != NULL &&
+        yang_keyword_get(yp) == Y_LIST &&
+        yang_find(yp, Y_ORDERED_BY, "user") == NULL &&
+        (cvk = yang_cvec_get(yp)) != NULL &&
+        cvec_len(cvk) == 1 &&
+        strcmp(cv_string_get(cvec_i(cvk, 0)), yang_argument_get(y)) == 0 &&
+        (cv = yang_cv_get(y)) != NULL &&
+        cv_type_get(cv) == CGV_STRING)
+        sorted = 1;
+    if (sorted && plen){
+        /* Lower bound of prefix */
+        hi = xlen;
+        while (lo < hi){
+            mid = (lo + hi) / 2;
+            if ((body = xml_body(xvec[mid])) == NULL || strcmp(body, prefix) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+    }
+    else if (!sorted && (hdup = clicon_hash_init()) == NULL)
+        goto done;
+    for (i = lo; i < xlen; i++){
+        if (xml_type(xvec[i]) == CX_BODY)
+            body = xml_value(xvec[i]);
+        else
+            body = xml_body(xvec[i]);
+        if (body == NULL)
+            continue;
+        if (plen && strncmp(body, prefix, plen) != 0){
+            if (sorted)
+                break;
+            continue;
+        }
+        if (sorted){
+            if (bodyprev && strcmp(body, bodyprev) == 0)
+                continue;
+            bodyprev = body;
+        }
+        else {
+            if (clicon_hash_lookup(hdup, body) != NULL)
+                continue;
+            if (clicon_hash_add(hdup, body, NULL, 0) == NULL)
+                goto done;
+        }
+        cprintf(cbret, "<value xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (xml_chardata_cbuf_append(cbret, 0, body) < 0)
+            goto done;
+        cprintf(cbret, "</value>");
+        if (limit && ++n == limit)
+            break;
+    }
+    retval = 0;
+ done:
+    if (hdup)
+        clicon_hash_free(hdup);
+    return retval;
+}
+
+/*! Distinct values of the nodes selected by an XPath in a datastore, eg for CLI completion
+ *
+ * Only values are returned, not the data tree.
+ * If the user may read everything, values are read directly from the datastore cache,
+ * otherwise from a NACM filtered copy.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+from_client_expand_values(clixon_handle h,
+                          cxobj        *xe,
+                          cbuf         *cbret,
+                          void         *arg,
+                          void         *regarg)
+{
+    int        retval = -1;
+    char      *db;
+    cxobj     *x;
+    char      *xpath;
+    char      *prefix;
+    uint32_t   limit = 0;
+    cvec      *nsc = NULL;
+    char      *username;
+    cxobj     *xnacm;
+    cxobj     *xt = NULL;
+    cxobj     *xret = NULL;
+    cxobj     *xerr = NULL;
+    cxobj    **xvec = NULL;
+    size_t     xlen = 0;
+    cbuf      *cbmsg = NULL;
+    int        readall;
+    int        ret;
+
+    if ((db = xml_find_body(xe, "datastore")) == NULL)
+        db = "running";
+    if (strcmp(db, "running") != 0 &&
+        strcmp(db, "candidate") != 0 &&
+        strcmp(db, "startup") != 0){
+        if (netconf_invalid_value(cbret, "protocol", "No such datastore") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((x = xml_find_type(xe, NULL, "xpath", CX_ELMNT)) == NULL ||
+        (xpath = xml_body(x)) == NULL){
+        if (netconf_missing_element(cbret, "protocol", "xpath", NULL) < 0)
+            goto done;
+        goto ok;
+    }
+    /* Namespace prefixes of xpath are declared on the xpath element */
+    if (xml_nsctx_node(x, &nsc) < 0)
+        goto done;
+    prefix = xml_find_body(xe, "prefix");
+    if ((ret = element2value(h, xe, "limit", NULL, cbret, &limit)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    username = clicon_username_get(h);
+    xnacm = clicon_nacm_cache(h);
+    if ((readall = nacm_datanode_read_permitted(h, username, xnacm)) < 0)
+        goto done;
+    if (readall)
+        ret = xmldb_get_cache(h, db, YB_MODULE, &xt, NULL, &xerr);
+    else
+        ret = xmldb_get0(h, db, YB_MODULE, nsc, xpath, 1, WITHDEFAULTS_EXPLICIT, &xret, NULL, &xerr);
+    if (ret < 0){
+        if ((cbmsg = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbmsg, "Get %s datastore: %s", db, clixon_err_reason());
+        if (netconf_operation_failed(cbret, "application", cbuf_get(cbmsg)) < 0)
+            goto done;
+        goto ok;
+    }
+    if (ret == 0){
+        if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
+            goto done;
+        goto ok;
+    }
+    if (!readall){
+        if (nacm_datanode_read1(h, xret, username, xnacm) < 0)
+            goto done;
+        if (nacm_datanode_read_prune(h, xret) < 0)
+            goto done;
+        xt = xret;
+    }
+    if (xt && xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
+        goto done;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    if (expand_values_reply(xvec, xlen, prefix, limit, cbret) < 0)
+        goto done;
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    if (xvec)
+        free(xvec);
+    if (xerr)
+        xml_free(xerr);
+    if (xret)
+        xml_free(xret);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Differences between two datastores, only the diff is returned, eg for CLI compare
+ *
+ * If the user may read everything, the diff is made directly on the datastore caches,
+ * otherwise on NACM filtered copies.
+ * If edits of the target are marked relative to the source, eg candidate after edits of
+ * running, only marked subtrees are compared, see xmldb_edit_marked.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+from_client_datastore_diff(clixon_handle h,
+                           cxobj        *xe,
+                           cbuf         *cbret,
+                           void         *arg,
+                           void         *regarg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    char                *db[2];
+    char                *format;
+    char                *username;
+    cxobj               *xnacm;
+    cxobj               *xt[2] = {NULL, NULL};
+    cxobj               *xcopy[2] = {NULL, NULL};
+    cxobj               *xerr = NULL;
+    cbuf                *cbdiff = NULL;
+    cbuf                *cbmsg = NULL;
+    int                  readall;
+    int                  flag = 0;
+    int                  i;
+    int                  ret;
+
+    if ((db[0] = xml_find_body(xe, "source")) == NULL)
+        db[0] = "running";
+    if ((db[1] = xml_find_body(xe, "target")) == NULL)
+        db[1] = "candidate";
+    for (i=0; i<2; i++){
+        if (strcmp(db[i], "running") != 0 &&
+            strcmp(db[i], "candidate") != 0 &&
+            strcmp(db[i], "startup") != 0){
+            if (netconf_invalid_value(cbret, "protocol", "No such datastore") < 0)
+                goto done;
+            goto ok;
+        }
+        if (private_candidate_db(h, ce, db[i], 0, &db[i]) < 0)
+            goto done;
+    }
+    format = xml_find_body(xe, "format");
+    username = clicon_username_get(h);
+    xnacm = clicon_nacm_cache(h);
+    if ((readall = nacm_datanode_read_permitted(h, username, xnacm)) < 0)
+        goto done;
+    for (i=0; i<2; i++){
+        if (readall)
+            ret = xmldb_get_cache(h, db[i], YB_MODULE, &xt[i], NULL, &xerr);
+        else
+            ret = xmldb_get0(h, db[i], YB_MODULE, NULL, "/", 1, WITHDEFAULTS_EXPLICIT, &xcopy[i], NULL, &xerr);
+        if (ret < 0){
+            if ((cbmsg = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(cbmsg, "Get %s datastore: %s", db[i], clixon_err_reason());
+            if (netconf_operation_failed(cbret, "application", cbuf_get(cbmsg)) < 0)
+                goto done;
+            goto ok;
+        }
+        if (ret == 0){
+            if (clixon_xml2cbuf1(cbret, xerr, 0, 0, NULL, -1, 0, 0) < 0)
+                goto done;
+            goto ok;
+        }
+        if (!readall){
+            if (nacm_datanode_read1(h, xcopy[i], username, xnacm) < 0)
+                goto done;
+            if (nacm_datanode_read_prune(h, xcopy[i]) < 0)
+                goto done;
+            xt[i] = xcopy[i];
+        }
+    }
+#ifdef XMLDB_EDIT_MARK
+    if (readall && xmldb_edit_marked(h, db[1], db[0]) == 1)
+        flag = XML_FLAG_EDIT;
+#endif
+    if ((cbdiff = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (format && strcmp(format, "text") == 0)
+        ret = clixon_text_diff2cbuf_marked(cbdiff, xt[0], xt[1], flag);
+    else
+        ret = clixon_xml_diff2cbuf_marked(cbdiff, xt[0], xt[1], flag);
+    if (ret < 0)
+        goto done;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<diff xmlns=\"%s\">", CLIXON_LIB_NS);
+    if (xml_chardata_cbuf_append(cbret, 0, cbuf_get(cbdiff)) < 0)
+        goto done;
+    cprintf(cbret, "</diff></rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (cbdiff)
+        cbuf_free(cbdiff);
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    if (xerr)
+        xml_free(xerr);
+    for (i=0; i<2; i++)
+        if (xcopy[i])
+            xml_free(xcopy[i]);
+    return retval;
+}
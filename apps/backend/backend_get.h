@@ -42,6 +42,12 @@
  */
 int from_client_get_config(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_get(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
+int from_client_expand_values(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
+int from_client_datastore_diff(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
+int get_sample(clixon_handle h, char *xpath, cvec *nsc, cxobj **xret);
+int get_pagination_free(clixon_handle h);
+int get_reply_cache_free(clixon_handle h);
+int get_read_threads_exit(clixon_handle h);
 int from_client_get_pageable_list(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg); /* XXX */
 
 #endif  /* _BACKEND_GET_H_ */
@@ -72,14 +72,18 @@
 #include "backend_socket.h"
 #include "clixon_backend_client.h"
 #include "backend_client.h"
+#include "backend_get.h"
 #include "clixon_backend_plugin.h"
 #include "clixon_backend_commit.h"
 #include "backend_handle.h"
 #include "backend_startup.h"
+#include "backend_push.h"
+#include "backend_replica.h"
+#include "backend_periodic.h"
 #include "backend_plugin_restconf.h"
 
 /* Command line options to be passed to getopt(3) */
-#define BACKEND_OPTS "hVD:f:E:l:C:d:p:b:Fza:u:P:1qs:c:U:g:y:o:"
+#define BACKEND_OPTS "hVD:f:E:l:C:d:p:b:Fza:u:P:1qs:c:U:g:y:o:T"
 
 #define BACKEND_LOGFILE "/usr/local/var/clixon_backend.log"
 
@@ -102,6 +106,8 @@ backend_terminate(clixon_handle h)
     clixon_debug(CLIXON_DBG_BACKEND, "");
     if ((ss = clicon_socket_get(h)) != -1)
         close(ss);
+    /* Reader threads read held datastore trees */
+    get_read_threads_exit(h);
     /* Disconnect datastore */
     xmldb_disconnect(h);
     /* Clear module state caches */
@@ -121,7 +127,14 @@ backend_terminate(clixon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     confirmed_commit_free(h);
+    commit_timing_free(h);
+    startup_timing_free(h);
+    backend_push_exit(h);
+    backend_replica_exit(h);
+    backend_periodic_exit(h);
     stream_publish_exit();
+    /* Cached state trees refer to plugins */
+    clixon_plugin_statedata_cache_free(h);
     /* Delete all plugins, RPC callbacks, and upgrade callbacks */
     clixon_plugin_module_exit(h);
     /* Delete all process-control entries */
@@ -129,6 +142,10 @@ backend_terminate(clixon_handle h)
 
     xpath_optimize_exit();
     clixon_pagination_free(h);
+    clixon_statelist_free(h);
+    get_pagination_free(h);
+    get_reply_cache_free(h);
+    datastore_change_free(h);
     if (pidfile)
         unlink(pidfile);
     if (sockfamily==AF_UNIX && lstat(sockpath, &st) == 0)
@@ -138,6 +155,9 @@ backend_terminate(clixon_handle h)
     clixon_err_exit();
     clixon_log_exit();
     backend_handle_exit(h); /* Also deletes streams. Cannot use h after this. */
+#ifdef XML_SLAB_ALLOC
+    xml_slab_release();
+#endif
     return 0;
 }
 
@@ -402,6 +422,7 @@ usage(clixon_handle h,
             "\t-g <group>\tClient membership required to this group (default: %s)\n"
 
             "\t-y <file>\tLoad yang spec file (override yang main module)\n"
+            "\t-T \t\tLog time of each startup phase and plugin callback\n"
             "\t-o \"<option>=<value>\"\tGive configuration option overriding config file (see clixon-config.yang)\n",
             argv0,
             plgdir ? plgdir : "none",
@@ -455,10 +476,15 @@ main(int    argc,
     enum format_enum config_dump_format = FORMAT_XML;
     int           print_version = 0;
     int32_t       d;
+    int           startup_report = 0;
+    clixon_plugin_t *cp;
+    uint64_t      t0;
 
     /* Initiate CLICON handle */
     if ((h = backend_handle_init()) == NULL)
         return -1;
+    if (startup_timing_start(h) < 0)
+        goto done;
     /* In the startup, logs to stderr & syslog and debug flag set later */
     if (clixon_log_init(h, __PROGRAM__, LOG_INFO, logdst) < 0)
         goto done;
@@ -642,6 +668,9 @@ main(int    argc,
                 goto done;
             break;
         }
+        case 'T': /* Log startup timing */
+            startup_report = 1;
+            break;
         default:
             usage(h, argv[0]);
             break;
@@ -732,6 +761,7 @@ main(int    argc,
     if (clicon_option_exists(h, "CLICON_STREAM_PUB") &&
         stream_publish_init() < 0)
         goto done;
+    startup_timing_phase(h, "options");
     /* Connect to plugin to get a handle */
     if (xmldb_connect(h) < 0)
         goto done;
@@ -739,6 +769,9 @@ main(int    argc,
     /* Set default namespace according to CLICON_NAMESPACE_NETCONF_DEFAULT */
     xml_nsctx_namespace_netconf_default(h);
 
+    /* Set number of XPath predicate threads according to CLICON_XPATH_THREADS */
+    xpath_parallel_init(h);
+
     /* Add (hardcoded) netconf features in case ietf-netconf loaded here
      * Otherwise it is loaded in netconf_module_load below
      */
@@ -754,12 +787,18 @@ main(int    argc,
     /* Create top-level data yangs */
     if ((yspec = yspec_new1(h, YANG_DOMAIN_TOP, YANG_DATA_TOP)) == NULL)
         goto done;
+    startup_timing_phase(h, "lib-init");
 
     /* Load backend plugins before yangs are loaded (eg extension callbacks) */
     if ((dir = clicon_backend_dir(h)) != NULL &&
         clixon_plugins_load(h, CLIXON_PLUGIN_INIT, dir,
                             clicon_option_str(h, "CLICON_BACKEND_REGEXP")) < 0)
         goto done;
+    startup_timing_phase(h, "plugin-load");
+    cp = NULL;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+        if (startup_timing_plugin(h, cp, "init", clixon_plugin_init_usec_get(cp)) < 0)
+            goto done;
     /* Print version, customized variant must wait for plugins to load */
     if (print_version){
         if (clixon_plugin_version_all(h, stdout) < 0)
@@ -809,6 +848,7 @@ main(int    argc,
         goto done;
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
         goto done;
+    startup_timing_phase(h, "yang-parse");
 
     /* Initialize server socket and save it to handle */
     if (backend_rpc_init(h) < 0)
@@ -823,9 +863,19 @@ main(int    argc,
         if (confirmed_commit_init(h) < 0)
             goto done;
     }
+    /* On-change stream of datastore changes */
+    if (backend_push_init(h) < 0)
+        goto done;
+    /* Periodic stream of sampled data */
+    if (backend_periodic_init(h) < 0)
+        goto done;
+    /* Active/standby replication of running */
+    if (backend_replica_init(h) < 0)
+        goto done;
     /* Save modules state of the backend (server). Compare with startup XML */
     if (startup_module_state(h, yspec) < 0)
         goto done;
+    startup_timing_phase(h, "backend-init");
     /* Startup mode needs to be defined,  */
     startup_mode = clicon_startup_mode(h);
     if ((int)startup_mode == -1){
@@ -909,6 +959,7 @@ main(int    argc,
     default:
         break;
     }
+    startup_timing_phase(h, "startup-mode");
     /* Quit after upgrade catch-all, running/startup quits in upgrade code */
     if (clicon_quit_upgrade_get(h) == 1)
         goto done;
@@ -947,6 +998,7 @@ main(int    argc,
         status = STARTUP_OK;
         cbuf_reset(cbret); /* cbret contains error info */
     }
+    startup_timing_phase(h, "extra-xml");
     /* Initiate the shared candidate. */
     if (xmldb_copy(h, "running", "candidate") < 0)
         goto done;
@@ -959,9 +1011,17 @@ main(int    argc,
 
     if (status == STARTUP_INVALID && cbuf_len(cbret))
         clixon_log(h, LOG_NOTICE, "%s: %u %s", __PROGRAM__, getpid(), cbuf_get(cbret));
-    /* Call backend plugin_start with user -- options */
-    if (clixon_plugin_start_all(h) < 0)
-        goto done;
+    startup_timing_phase(h, "candidate");
+    /* Call backend plugin_start with user -- options, each timed */
+    cp = NULL;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+        t0 = transaction_clock();
+        if (clixon_plugin_start_one(cp, h) < 0)
+            goto done;
+        if (startup_timing_plugin(h, cp, "start", transaction_clock() - t0) < 0)
+            goto done;
+    }
+    startup_timing_phase(h, "plugin-start");
     /* Explicit dump of config (also debug dump below). */
     if (config_dump){
         if (clicon_option_dump1(h, stdout, config_dump_format, 1) < 0)
@@ -969,8 +1029,10 @@ main(int    argc,
     }
 
     /* -1 option to run only once */
-    if (once)
+    if (once){
+        startup_timing_done(h, startup_report);
         goto ok;
+    }
 
     /* Debug dump of config options */
     clicon_option_dump(h, CLIXON_DBG_INIT);
@@ -994,6 +1056,7 @@ main(int    argc,
     if (clixon_plugin_daemon_all(h) < 0)
         goto done;
 
+    startup_timing_phase(h, "daemon");
     /* Write pid-file */
     if (pidfile_write(pidfile) <  0)
         goto done;
@@ -1039,6 +1102,8 @@ main(int    argc,
     /* Just before event-loop, after socket bind/listen */
     if (netconf_monitoring_statistics_init(h) < 0)
         goto done;
+    startup_timing_phase(h, "socket");
+    startup_timing_done(h, startup_report);
     clixon_log(h, LOG_NOTICE, "%s: %u Started", __PROGRAM__, getpid());
     if (clixon_event_loop(h) < 0)
         goto done;
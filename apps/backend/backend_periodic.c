@@ -0,0 +1,261 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Periodic push of sampled config and state data, see CLICON_STREAM_PERIODIC
+ *
+ * Once per period, the subtrees selected by the filters of the subscriptions of the
+ * periodic stream are read from running and state data, as a <get>. A subtree is sampled
+ * once per distinct filter, wrapped in a RFC 8641 YANG-Push push-update notification
+ * and sent to the subscriptions of that filter with stream_notify_xml_selector.
+ * Collectors subscribe instead of polling with <get>, so that state callbacks are called
+ * once per period and filter regardless of the number of collectors.
+ * No subscriptions means no sampling.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "backend_get.h"
+#include "backend_periodic.h"
+
+/* RFC 8641 YANG-Push namespace of push-update */
+#define YANG_PUSH_NAMESPACE "urn:ietf:params:xml:ns:yang:ietf-yang-push"
+
+/*
+ * Local types
+ */
+/* Periodic push state, see CLICON_STREAM_PERIODIC */
+struct periodic_state {
+    char           *pe_stream;  /* Name of periodic stream */
+    uint32_t        pe_period;  /* Period in ms */
+    struct timeval  pe_next;    /* Time of next sample */
+};
+
+/*! Sample subtree of a filter and send it as push-update to subscriptions of the filter
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  pe      Periodic push state
+ * @param[in]  xpath   Filter of subscriptions, "" if none
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+periodic_sample(clixon_handle          h,
+                struct periodic_state *pe,
+                char                  *xpath)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *xn = NULL;
+    cxobj *xc;
+    cxobj *x;
+    int    ret;
+
+    if ((ret = get_sample(h, strlen(xpath) ? xpath : NULL, NULL, &xt)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_debug_xml(CLIXON_DBG_BACKEND, xt, "Periodic sample of %s failed", xpath);
+        goto ok;
+    }
+    if ((xn = xml_new("push-update", NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (xmlns_set(xn, NULL, YANG_PUSH_NAMESPACE) < 0)
+        goto done;
+    if ((xc = xml_new("datastore-contents", xn, CX_ELMNT)) == NULL)
+        goto done;
+    /* Move sampled top-level nodes, no copy */
+    while ((x = xml_child_i_type(xt, 0, CX_ELMNT)) != NULL){
+        if (xml_rm(x) < 0)
+            goto done;
+        if (xml_addsub(xc, x) < 0)
+            goto done;
+    }
+    if (stream_notify_xml_selector(h, pe->pe_stream, xpath, xn) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xn)
+        xml_free(xn);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Period has passed, sample once per distinct filter of subscriptions and re-arm timer
+ *
+ * @param[in]  fd    Not used
+ * @param[in]  arg   Clixon handle
+ */
+static int
+periodic_timeout(int   fd,
+                 void *arg)
+{
+    int                         retval = -1;
+    clixon_handle               h = (clixon_handle)arg;
+    struct periodic_state      *pe = NULL;
+    event_stream_t             *es;
+    struct stream_subscription *ss;
+    cvec                       *filters = NULL;
+    char                       *xpath;
+    cg_var                     *cv;
+    struct timeval              now;
+    struct timeval              t;
+
+    if (clicon_ptr_get(h, "periodic-push", (void**)&pe) < 0 || pe == NULL)
+        return 0;
+    if ((es = stream_find(h, pe->pe_stream)) != NULL &&
+        (ss = es->es_subscription) != NULL){
+        if ((filters = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        /* Collect filters first, sending may remove subscriptions of closed sessions */
+        do {
+            xpath = ss->ss_xpath ? ss->ss_xpath : "";
+            if (cvec_find(filters, xpath) == NULL &&
+                cvec_add_string(filters, xpath, NULL) < 0){
+                clixon_err(OE_UNIX, errno, "cvec_add_string");
+                goto done;
+            }
+            ss = NEXTQ(struct stream_subscription *, ss);
+        } while (ss != es->es_subscription);
+        cv = NULL;
+        while ((cv = cvec_each(filters, cv)) != NULL)
+            if (periodic_sample(h, pe, cv_name_get(cv)) < 0)
+                goto done;
+    }
+    /* Next period, skip periods that have passed */
+    t.tv_sec = pe->pe_period / 1000;
+    t.tv_usec = (pe->pe_period % 1000) * 1000;
+    timeradd(&pe->pe_next, &t, &pe->pe_next);
+    gettimeofday(&now, NULL);
+    if (timercmp(&pe->pe_next, &now, <=))
+        timeradd(&now, &t, &pe->pe_next);
+    if (clixon_event_reg_timeout(pe->pe_next, periodic_timeout, h, "periodic push") < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (filters)
+        cvec_free(filters);
+    return retval;
+}
+
+/*! Create periodic stream and start sampling timer if CLICON_STREAM_PERIODIC is set
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see backend_periodic_exit
+ */
+int
+backend_periodic_init(clixon_handle h)
+{
+    int                    retval = -1;
+    struct periodic_state *pe = NULL;
+    char                  *name;
+    struct timeval         t;
+
+    if ((name = clicon_option_str(h, "CLICON_STREAM_PERIODIC")) == NULL ||
+        strlen(name) == 0)
+        goto ok;
+    if (stream_add(h, name, "Periodic samples of config and state data", 0, NULL) < 0)
+        goto done;
+    if ((pe = calloc(1, sizeof(*pe))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((pe->pe_stream = strdup(name)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    pe->pe_period = clicon_option_int(h, "CLICON_STREAM_PERIODIC_PERIOD");
+    if (pe->pe_period == 0){
+        clixon_err(OE_CFG, EINVAL, "CLICON_STREAM_PERIODIC_PERIOD is 0");
+        goto done;
+    }
+    gettimeofday(&pe->pe_next, NULL);
+    t.tv_sec = pe->pe_period / 1000;
+    t.tv_usec = (pe->pe_period % 1000) * 1000;
+    timeradd(&pe->pe_next, &t, &pe->pe_next);
+    if (clixon_event_reg_timeout(pe->pe_next, periodic_timeout, h, "periodic push") < 0)
+        goto done;
+    if (clicon_ptr_set(h, "periodic-push", pe) < 0)
+        goto done;
+    pe = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (pe){
+        if (pe->pe_stream)
+            free(pe->pe_stream);
+        free(pe);
+    }
+    return retval;
+}
+
+/*! Stop sampling timer and free periodic push state
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ */
+int
+backend_periodic_exit(clixon_handle h)
+{
+    struct periodic_state *pe = NULL;
+
+    if (clicon_ptr_get(h, "periodic-push", (void**)&pe) < 0 || pe == NULL)
+        return 0;
+    clixon_event_unreg_timeout(periodic_timeout, h);
+    free(pe->pe_stream);
+    free(pe);
+    clicon_ptr_del(h, "periodic-push");
+    return 0;
+}
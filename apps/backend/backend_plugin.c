@@ -49,10 +49,15 @@
 #include <errno.h>
 #include <signal.h>
 #include <syslog.h>
+#include <time.h>
+#include <ctype.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/param.h>
 #include <netinet/in.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -63,6 +68,25 @@
 #include "clixon_backend_transaction.h"
 #include "clixon_backend_plugin.h"
 #include "clixon_backend_commit.h"
+#include "backend_startup.h"
+
+#ifdef HAVE_LIBPTHREAD
+static int plugin_transaction_parallel(clixon_handle h, transaction_data_t *td, int commit);
+#endif
+
+/* Max number of cached state trees, the oldest is removed when full, see ca_statedata_ttl */
+#define STATEDATA_CACHE_SIZE 64
+
+/*! Cached state tree of the statedata callback of one plugin, see ca_statedata_ttl
+ */
+struct statedata_cache{
+    qelem_t          sc_q;      /* Queue of entries, oldest first */
+    clixon_plugin_t *sc_plugin; /* Plugin of statedata callback */
+    char            *sc_xpath;  /* Xpath given to callback */
+    char            *sc_nsc;    /* Namespace context of xpath, as xmlns attributes */
+    cxobj           *sc_xt;     /* State tree, bound, sorted and with defaults removed */
+    uint64_t         sc_expire; /* Expiry time, monotonic microseconds */
+};
 
 /*! Request plugins to reset system state
  *
@@ -116,12 +140,16 @@ clixon_plugin_reset_all(clixon_handle h,
 {
     int              retval = -1;
     clixon_plugin_t *cp = NULL;
+    uint64_t         t0;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     /* Loop through all plugins, call callbacks in each */
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+        t0 = transaction_clock();
         if (clixon_plugin_reset_one(cp, h, db) < 0)
             goto done;
+        if (startup_timing_plugin(h, cp, "reset", transaction_clock() - t0) < 0)
+            goto done;
     }
     retval = 0;
  done:
@@ -317,6 +345,504 @@ clixon_plugin_statedata_one(clixon_plugin_t *cp,
     goto done;
 }
 
+/*! Check if the subtree of one xpath covers the subtree of another xpath
+ *
+ * An xpath covers another if it is "/" or a prefix of it ending at a step or predicate
+ * @param[in]  cxpath  Covering xpath, eg of cached tree
+ * @param[in]  xpath   Requested xpath
+ * @retval     1       Covered
+ * @retval     0       Not covered
+ */
+static int
+statedata_xpath_covers(const char *cxpath,
+                       const char *xpath)
+{
+    size_t len;
+
+    if (strcmp(cxpath, "/") == 0)
+        return 1;
+    len = strlen(cxpath);
+    if (strncmp(cxpath, xpath, len) != 0)
+        return 0;
+    return xpath[len] == '\0' || xpath[len] == '/' || xpath[len] == '[';
+}
+
+/*! Remove and free a cached state tree
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  sc  Cache entry
+ */
+static void
+statedata_cache_rm(clixon_handle           h,
+                   struct statedata_cache *sc)
+{
+    struct statedata_cache *head = NULL;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&head);
+    DELQ(sc, head, struct statedata_cache *);
+    clicon_ptr_set(h, "statedata-cache", head);
+    free(sc->sc_xpath);
+    free(sc->sc_nsc);
+    xml_free(sc->sc_xt);
+    free(sc);
+}
+
+/*! Get a copy of a cached state tree of a plugin covering an xpath
+ *
+ * Expired entries of the plugin are removed
+ * @param[in]  h     Clixon handle
+ * @param[in]  cp    Plugin
+ * @param[in]  xpath Requested xpath
+ * @param[in]  nsc   Namespace context of xpath, as xmlns attributes
+ * @param[out] xp    Copy of cached state tree, if found. Free with xml_free
+ * @retval     1     Found
+ * @retval     0     Not found
+ * @retval    -1     Error
+ */
+static int
+statedata_cache_get(clixon_handle    h,
+                    clixon_plugin_t *cp,
+                    const char      *xpath,
+                    const char      *nsc,
+                    cxobj          **xp)
+{
+    struct statedata_cache *head = NULL;
+    struct statedata_cache *sc;
+    struct statedata_cache *next;
+    uint64_t                now;
+    int                     i;
+    int                     n;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&head);
+    if (head == NULL)
+        return 0;
+    now = transaction_clock();
+    /* Count entries first since expired entries are removed */
+    n = 0;
+    sc = head;
+    do {
+        n++;
+        sc = NEXTQ(struct statedata_cache *, sc);
+    } while (sc != head);
+    sc = head;
+    for (i=0; i<n; i++, sc = next){
+        next = NEXTQ(struct statedata_cache *, sc);
+        if (sc->sc_plugin != cp)
+            continue;
+        if (sc->sc_expire <= now){
+            statedata_cache_rm(h, sc);
+            continue;
+        }
+        if (!statedata_xpath_covers(sc->sc_xpath, xpath))
+            continue;
+        if (strcmp(sc->sc_xpath, "/") != 0 && strcmp(sc->sc_nsc, nsc) != 0)
+            continue;
+        if ((*xp = xml_dup(sc->sc_xt)) == NULL)
+            return -1;
+        clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "%s %s: cached",
+                     clixon_plugin_name_get(cp), xpath);
+        return 1;
+    }
+    return 0;
+}
+
+/*! Add a copy of a state tree of a plugin to the cache
+ *
+ * A previous entry of the same xpath is replaced, and the oldest entry is removed if full
+ * @param[in]  h     Clixon handle
+ * @param[in]  cp    Plugin
+ * @param[in]  xpath Xpath given to callback
+ * @param[in]  nsc   Namespace context of xpath, as xmlns attributes
+ * @param[in]  xt    State tree
+ * @param[in]  ttl   Time to live in milliseconds
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+statedata_cache_add(clixon_handle    h,
+                    clixon_plugin_t *cp,
+                    const char      *xpath,
+                    const char      *nsc,
+                    cxobj           *xt,
+                    uint32_t         ttl)
+{
+    int                     retval = -1;
+    struct statedata_cache *head = NULL;
+    struct statedata_cache *sc;
+    int                     n = 0;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&head);
+    if ((sc = head) != NULL){
+        do {
+            if (sc->sc_plugin == cp &&
+                strcmp(sc->sc_xpath, xpath) == 0 &&
+                strcmp(sc->sc_nsc, nsc) == 0){
+                statedata_cache_rm(h, sc); /* Replaced */
+                break;
+            }
+            n++;
+            sc = NEXTQ(struct statedata_cache *, sc);
+        } while (sc != head);
+    }
+    if (n >= STATEDATA_CACHE_SIZE){
+        clicon_ptr_get(h, "statedata-cache", (void**)&head);
+        statedata_cache_rm(h, head);
+    }
+    if ((sc = calloc(1, sizeof(*sc))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    sc->sc_plugin = cp;
+    sc->sc_expire = transaction_clock() + (uint64_t)ttl*1000;
+    if ((sc->sc_xpath = strdup(xpath)) == NULL ||
+        (sc->sc_nsc = strdup(nsc)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((sc->sc_xt = xml_dup(xt)) == NULL)
+        goto done;
+    clicon_ptr_get(h, "statedata-cache", (void**)&head);
+    ADDQ(sc, head);
+    clicon_ptr_set(h, "statedata-cache", head);
+    sc = NULL;
+    retval = 0;
+ done:
+    if (sc){
+        if (sc->sc_xpath)
+            free(sc->sc_xpath);
+        if (sc->sc_nsc)
+            free(sc->sc_nsc);
+        free(sc);
+    }
+    return retval;
+}
+
+/*! Invalidate cached state trees of plugins, see ca_statedata_ttl
+ *
+ * Call when state is known to have changed, the next get calls the statedata callback
+ * @param[in]  h      Clixon handle
+ * @param[in]  name   Name of plugin, or NULL for all plugins
+ * @param[in]  xpath  Invalidate trees of this xpath, of its prefixes and of xpaths below it,
+ *                    or NULL for all
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   if (clixon_plugin_statedata_invalidate(h, "example", "/if:interfaces") < 0)
+ *      err;
+ * @endcode
+ */
+int
+clixon_plugin_statedata_invalidate(clixon_handle h,
+                                   const char   *name,
+                                   const char   *xpath)
+{
+    struct statedata_cache *head = NULL;
+    struct statedata_cache *sc;
+    struct statedata_cache *next;
+    int                     i;
+    int                     n;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&head);
+    if (head == NULL)
+        return 0;
+    n = 0;
+    sc = head;
+    do {
+        n++;
+        sc = NEXTQ(struct statedata_cache *, sc);
+    } while (sc != head);
+    sc = head;
+    for (i=0; i<n; i++, sc = next){
+        next = NEXTQ(struct statedata_cache *, sc);
+        if (name && strcmp(clixon_plugin_name_get(sc->sc_plugin), name) != 0)
+            continue;
+        if (xpath &&
+            !statedata_xpath_covers(sc->sc_xpath, xpath) &&
+            !statedata_xpath_covers(xpath, sc->sc_xpath))
+            continue;
+        statedata_cache_rm(h, sc);
+    }
+    return 0;
+}
+
+/*! Free all cached state trees
+ *
+ * @param[in]  h      Clixon handle
+ */
+int
+clixon_plugin_statedata_cache_free(clixon_handle h)
+{
+    return clixon_plugin_statedata_invalidate(h, NULL, NULL);
+}
+
+/*! Get the leading location path of a canonical xpath, without predicates
+ *
+ * Eg /a:x[a:k='1']/a:y//a:z gives /a:x/a:y, whose subtree holds all nodes selected by the
+ * xpath. Stops at a step that is not a plain name, such as // or *
+ * @param[in]  xpath  Canonical xpath, with module prefixes
+ * @param[out] cb     Location path, or "/"
+ * @retval     1      OK
+ * @retval     0      Xpath may select nodes anywhere, eg a union or relative path
+ */
+static int
+statedata_xpath_top(const char *xpath,
+                    cbuf       *cb)
+{
+    const char *p = xpath;
+    const char *p0;
+    char        quote;
+    int         level;
+
+    if (*p != '/' || strchr(p, '|') != NULL)
+        return 0;
+    while (*p == '/' && (isalpha((unsigned char)p[1]) || p[1] == '_')){
+        p0 = p++;
+        while (isalnum((unsigned char)*p) || *p == '_' || *p == '-' || *p == '.' || *p == ':')
+            p++;
+        if (*p != '\0' && *p != '/' && *p != '[')
+            break; /* eg function call */
+        cbuf_append_buf(cb, (void*)p0, p - p0);
+        /* Skip predicates */
+        level = 0;
+        quote = 0;
+        while (*p == '[' || level > 0){
+            if (*p == '\0')
+                return 0;
+            if (quote){
+                if (*p == quote)
+                    quote = 0;
+            }
+            else if (*p == '\'' || *p == '"')
+                quote = *p;
+            else if (*p == '[')
+                level++;
+            else if (*p == ']')
+                level--;
+            p++;
+        }
+    }
+    if (cbuf_len(cb) == 0)
+        cprintf(cb, "/");
+    return 1;
+}
+
+/*! Print data path of yang node with module prefixes, as in canonical xpaths
+ *
+ * @param[in]  yspec  Yang spec
+ * @param[in]  ys     Yang data node
+ * @param[out] cb     Data path, eg /a:x/a:y
+ * @retval     1      OK
+ * @retval     0      Module of a node not found
+ */
+static int
+statedata_yang2path(yang_stmt *yspec,
+                    yang_stmt *ys,
+                    cbuf      *cb)
+{
+    char      *ns;
+    yang_stmt *ymod;
+    char      *prefix;
+
+    if (ys == NULL ||
+        yang_keyword_get(ys) == Y_MODULE ||
+        yang_keyword_get(ys) == Y_SUBMODULE)
+        return 1;
+    if (statedata_yang2path(yspec, yang_parent_get(ys), cb) == 0)
+        return 0;
+    if (yang_keyword_get(ys) == Y_CHOICE || yang_keyword_get(ys) == Y_CASE)
+        return 1;
+    if ((ns = yang_find_mynamespace(ys)) == NULL ||
+        (ymod = yang_find_module_by_namespace(yspec, ns)) == NULL ||
+        (prefix = yang_find_myprefix(ymod)) == NULL)
+        return 0;
+    cprintf(cb, "/%s:%s", prefix, yang_argument_get(ys));
+    return 1;
+}
+
+/*! Check if state data paths of a plugin intersect the subtree of a location path
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  yspec  Yang spec
+ * @param[in]  paths  NULL-terminated schema-nodeids, see ca_statedata_paths
+ * @param[in]  top    Location path of request, see statedata_xpath_top
+ * @retval     1      Intersects, or a path cannot be resolved
+ * @retval     0      No path intersects
+ * @retval    -1      Error
+ */
+static int
+statedata_paths_match(clixon_handle h,
+                      yang_stmt    *yspec,
+                      char        **paths,
+                      const char   *top)
+{
+    int        retval = -1;
+    cbuf      *cb = NULL;
+    yang_stmt *y;
+    int        i;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    for (i=0; paths[i] != NULL; i++){
+        if (yang_abs_schema_nodeid(yspec, paths[i], &y) < 0)
+            goto done;
+        if (y == NULL){
+            clixon_log(h, LOG_NOTICE, "%s: State data path %s not found", __func__, paths[i]);
+            goto match;
+        }
+        cbuf_reset(cb);
+        if (statedata_yang2path(yspec, y, cb) == 0)
+            goto match;
+        if (statedata_xpath_covers(top, cbuf_get(cb)) ||
+            statedata_xpath_covers(cbuf_get(cb), top))
+            goto match;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ match:
+    retval = 1;
+    goto done;
+}
+
+/*! State of the statedata callback of one plugin in a get
+ */
+enum statedata_state{
+    SD_CALL = 0, /* Call in main thread */
+    SD_SKIP,     /* Paths do not match xpath */
+    SD_CACHED,   /* Tree from cache */
+    SD_PARALLEL, /* Call in parallel with other thread-safe callbacks */
+    SD_CALLED,   /* Called in parallel, see sd_ret */
+};
+
+/*! Statedata callback of one plugin in a get, in load order
+ */
+struct statedata_call{
+    clixon_plugin_t     *sd_cp;
+    enum statedata_state sd_state;
+    int                  sd_ret;   /* If SD_CALLED: as clixon_plugin_statedata_one */
+    cxobj               *sd_x;     /* If SD_CACHED or SD_CALLED: state tree */
+};
+
+#ifdef HAVE_LIBPTHREAD
+/*! Shared state of statedata workers
+ */
+struct statedata_work{
+    pthread_mutex_t        sw_mutex;
+    clixon_handle          sw_h;
+    cvec                  *sw_nsc;
+    char                  *sw_xpath;
+    struct statedata_call *sw_vec;
+    int                    sw_n;
+    int                    sw_next;  /* Next callback to call */
+};
+
+/*! Worker calling thread-safe statedata callbacks, one at a time
+ *
+ * Resource checks are not made in workers since signals and terminal are per process
+ */
+static void *
+statedata_worker(void *arg)
+{
+    struct statedata_work *sw = (struct statedata_work *)arg;
+    struct statedata_call *sd;
+    plgstatedata_t        *fn;
+    int                    i;
+
+    for (;;){
+        pthread_mutex_lock(&sw->sw_mutex);
+        while ((i = sw->sw_next) < sw->sw_n && sw->sw_vec[i].sd_state != SD_PARALLEL)
+            sw->sw_next++;
+        if (i < sw->sw_n)
+            sw->sw_next++;
+        pthread_mutex_unlock(&sw->sw_mutex);
+        if (i >= sw->sw_n)
+            break;
+        sd = &sw->sw_vec[i];
+        fn = clixon_plugin_api_get(sd->sd_cp)->ca_statedata;
+        if ((sd->sd_x = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            sd->sd_ret = -1;
+        else if (fn(sw->sw_h, sw->sw_nsc, sw->sw_xpath, sd->sd_x) < 0)
+            sd->sd_ret = 0;
+        else
+            sd->sd_ret = 1;
+        sd->sd_state = SD_CALLED;
+    }
+    return NULL;
+}
+
+/*! Call thread-safe statedata callbacks in parallel threads
+ *
+ * @param[in]     h        Clixon handle
+ * @param[in]     nsc      Namespace context
+ * @param[in]     xpath    XPath
+ * @param[in,out] sv       Callbacks of plugins, those in SD_PARALLEL are SD_CALLED on return
+ * @param[in]     n        Length of sv
+ * @param[in]     nthreads Number of threads
+ * @retval        0        OK
+ * @retval       -1        Error
+ */
+static int
+statedata_parallel(clixon_handle          h,
+                   cvec                  *nsc,
+                   char                  *xpath,
+                   struct statedata_call *sv,
+                   int                    n,
+                   int                    nthreads)
+{
+    int                   retval = -1;
+    struct statedata_work sw = {0,};
+    pthread_t            *tids = NULL;
+    void                 *wh = NULL;
+    int                   frozen;
+    int                   threads;
+    int                   i;
+    int                   t = 0;
+    int                   ret;
+
+    if ((tids = calloc(nthreads, sizeof(*tids))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if (pthread_mutex_init(&sw.sw_mutex, NULL) != 0){
+        clixon_err(OE_UNIX, errno, "pthread_mutex_init");
+        goto done;
+    }
+    sw.sw_h = h;
+    sw.sw_nsc = nsc;
+    sw.sw_xpath = xpath;
+    sw.sw_vec = sv;
+    sw.sw_n = n;
+    if (clixon_resource_check(h, &wh, "parallel", "clixon_plugin_statedata_one") < 0)
+        goto done;
+    /* Namespace lookups in threads only read caches, and XML nodes are created in threads */
+    frozen = xml2ns_cache_freeze(1);
+    threads = xml_threads_set(1);
+    for (t=0; t<nthreads; t++)
+        if ((ret = pthread_create(&tids[t], NULL, statedata_worker, &sw)) != 0){
+            clixon_err(OE_UNIX, ret, "pthread_create");
+            break;
+        }
+    if (t == 0) /* No threads, call here */
+        statedata_worker(&sw);
+    for (i=0; i<t; i++)
+        pthread_join(tids[i], NULL);
+    xml_threads_set(threads);
+    xml2ns_cache_freeze(frozen);
+    pthread_mutex_destroy(&sw.sw_mutex);
+    if (clixon_resource_check(h, &wh, "parallel", "clixon_plugin_statedata_one") < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (tids)
+        free(tids);
+    return retval;
+}
+#endif /* HAVE_LIBPTHREAD */
+
 /*! Go through all backend statedata callbacks and collect state data
  *
  * This is internal system call, plugin is invoked (does not call) this function
@@ -330,6 +856,14 @@ clixon_plugin_statedata_one(clixon_plugin_t *cp,
  * @retval        0       Statedata callback failed (xret set with netconf-error)
  * @retval       -1       Error
  * @note xret can be replaced in this function
+ * @note State trees of plugins with ca_statedata_ttl are cached, and reused while the TTL
+ *       has not expired instead of calling the callback
+ * @note Callbacks of plugins with ca_statedata_paths are only called if a path intersects
+ *       the subtree of xpath
+ * @note Callbacks of plugins with ca_statedata_parallel are called in parallel by
+ *       CLICON_BACKEND_PLUGIN_THREADS threads before the other callbacks. All trees are
+ *       merged in load order
+ * @note State trees of a get with a depth hint may be incomplete and are not cached
  */
 int
 clixon_plugin_statedata_all(clixon_handle h,
@@ -338,16 +872,121 @@ clixon_plugin_statedata_all(clixon_handle h,
                             char         *xpath,
                             cxobj       **xret)
 {
-    int              retval = -1;
-    int              ret;
-    cxobj           *x = NULL;
-    clixon_plugin_t *cp = NULL;
-    cxobj           *xerr = NULL;
+    int                    retval = -1;
+    int                    ret;
+    cxobj                 *x = NULL;
+    clixon_plugin_t       *cp = NULL;
+    cxobj                 *xerr = NULL;
+    uint32_t               ttl;
+    cbuf                  *cbnsc = NULL;
+    char                 **paths;
+    cbuf                  *cbtop = NULL;
+    int                    anywhere = 0;
+    struct statedata_call *sv = NULL;
+    struct statedata_call *sd;
+    int                    n = 0;
+    int                    i;
+    int                    depth;
+#ifdef HAVE_LIBPTHREAD
+    int                    np = 0;
+    int                    nthreads;
+#endif
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
+    if (xpath == NULL)
+        xpath = "/";
+    depth = clicon_data_int_get(h, "clixon-get-depth");
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+        if (clixon_plugin_api_get(cp)->ca_statedata != NULL)
+            n++;
+    if (n && (sv = calloc(n, sizeof(*sv))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    /* Skip callbacks whose paths do not match and get cached trees */
+    i = 0;
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if ((ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
-            goto done;
+        if (clixon_plugin_api_get(cp)->ca_statedata == NULL)
+            continue;
+        sd = &sv[i++];
+        sd->sd_cp = cp;
+        if ((paths = clixon_plugin_api_get(cp)->ca_statedata_paths) != NULL &&
+            !anywhere){
+            if (cbtop == NULL){
+                if ((cbtop = cbuf_new()) == NULL){
+                    clixon_err(OE_UNIX, errno, "cbuf_new");
+                    goto done;
+                }
+                anywhere = !statedata_xpath_top(xpath, cbtop);
+            }
+            if (!anywhere){
+                if ((ret = statedata_paths_match(h, yspec, paths, cbuf_get(cbtop))) < 0)
+                    goto done;
+                if (ret == 0){
+                    clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "%s %s: skipped",
+                                 clixon_plugin_name_get(cp), xpath);
+                    sd->sd_state = SD_SKIP;
+                    continue;
+                }
+            }
+        }
+        if (clixon_plugin_api_get(cp)->ca_statedata_ttl != 0){
+            if (cbnsc == NULL){
+                if ((cbnsc = cbuf_new()) == NULL){
+                    clixon_err(OE_UNIX, errno, "cbuf_new");
+                    goto done;
+                }
+                if (xml_nsctx_cbuf(cbnsc, nsc) < 0)
+                    goto done;
+            }
+            if ((ret = statedata_cache_get(h, cp, xpath, cbuf_get(cbnsc), &sd->sd_x)) < 0)
+                goto done;
+            if (ret == 1){
+                sd->sd_state = SD_CACHED;
+                continue;
+            }
+        }
+#ifdef HAVE_LIBPTHREAD
+        if (clixon_plugin_api_get(cp)->ca_statedata_parallel){
+            sd->sd_state = SD_PARALLEL;
+            np++;
+        }
+#endif
+    }
+#ifdef HAVE_LIBPTHREAD
+    nthreads = clicon_option_int(h, "CLICON_BACKEND_PLUGIN_THREADS");
+    if (np < nthreads)
+        nthreads = np;
+    if (nthreads > 1 &&
+        statedata_parallel(h, nsc, xpath, sv, n, nthreads) < 0)
+        goto done;
+#endif
+    /* Call other callbacks and merge in load order */
+    for (i=0; i<n; i++){
+        sd = &sv[i];
+        cp = sd->sd_cp;
+        ttl = clixon_plugin_api_get(cp)->ca_statedata_ttl;
+        switch (sd->sd_state){
+        case SD_SKIP:
+            continue;
+        case SD_CACHED:
+            x = sd->sd_x;
+            sd->sd_x = NULL;
+            goto merge;
+        case SD_CALLED:
+            if ((ret = sd->sd_ret) < 0)
+                goto done;
+            x = sd->sd_x;
+            sd->sd_x = NULL;
+            if (ret == 0 && !clixon_plugin_rpc_err_set(h) && clixon_err_category() < 0)
+                clixon_log(h, LOG_WARNING, "%s: Internal error: State callback in plugin: %s returned -1 but did not make a clixon_err call",
+                           __func__, clixon_plugin_name_get(cp));
+            break;
+        default:
+            if ((ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
+                goto done;
+            break;
+        }
         if (ret == 0){
             /* error reason should be in clixon_err_reason */
             if (clixon_plugin_report_err_xml(h, &xerr,
@@ -362,6 +1001,8 @@ clixon_plugin_statedata_all(clixon_handle h,
         if (x == NULL)
             continue;
         if (xml_child_nr(x) == 0){
+            if (ttl && depth < 0 && statedata_cache_add(h, cp, xpath, cbuf_get(cbnsc), x, ttl) < 0)
+                goto done;
             xml_free(x);
             x = NULL;
             continue;
@@ -380,12 +1021,16 @@ clixon_plugin_statedata_all(clixon_handle h,
             xerr = NULL;
             goto fail;
         }
-        if (xml_sort_recurse(x) < 0)
+        /* Sorted on first keyed access or when serialized, or not at all if declared sorted */
+        if (xml_sort_lazy(x) < 0)
             goto done;
         /* Remove global defaults and empty non-presence containers */
         /* XXX: only for state data and according to with-defaults setting */
         if (xml_default_nopresence(x, 2, 0) < 0)
             goto done;
+        if (ttl && depth < 0 && statedata_cache_add(h, cp, xpath, cbuf_get(cbnsc), x, ttl) < 0)
+            goto done;
+    merge:
         if (xpath_first(x, nsc, "%s", xpath) != NULL){
             if ((ret = netconf_trymerge(x, yspec, xret)) < 0)
                 goto done;
@@ -396,9 +1041,19 @@ clixon_plugin_statedata_all(clixon_handle h,
             xml_free(x);
             x = NULL;
         }
-    } /* while plugin */
+    } /* for plugin */
     retval = 1;
  done:
+    if (sv){
+        for (i=0; i<n; i++)
+            if (sv[i].sd_x)
+                xml_free(sv[i].sd_x);
+        free(sv);
+    }
+    if (cbtop)
+        cbuf_free(cbtop);
+    if (cbnsc)
+        cbuf_free(cbnsc);
     if (xerr)
         xml_free(xerr);
     if (x)
@@ -504,6 +1159,55 @@ clixon_pagination_cb_register(clixon_handle    h,
     return retval;
 }
 
+/*! Register a state list producer callback
+ *
+ * The producer is called with statelist_data instead of building the whole list in a statedata
+ * callback. Gets of exactly the list, and list pagination of it, stream the entries in batches
+ * @param[in]  h      Clixon handle
+ * @param[in]  fn     Callback
+ * @param[in]  xpath  Registered XPath of list using canonical prefixes
+ * @param[in]  arg    Domain-specific argument to send to callback
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see statelist_data_t
+ */
+int
+clixon_statelist_cb_register(clixon_handle    h,
+                             handler_function fn,
+                             char            *xpath,
+                             void            *arg)
+{
+    int                       retval = -1;
+    dispatcher_definition     x = {xpath, fn, arg};
+    dispatcher_entry_t       *htable = NULL;
+
+    clicon_ptr_get(h, "statelist-entries", (void**)&htable);
+    if (dispatcher_register_handler(&htable, &x) < 0){
+        clixon_err(OE_PLUGIN, errno, "dispatcher");
+        goto done;
+    }
+    if (clicon_ptr_set(h, "statelist-entries", htable) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free state list producer callback structure
+ *
+ * @param[in]  h      Clixon handle
+ */
+int
+clixon_statelist_free(clixon_handle h)
+{
+    dispatcher_entry_t       *htable = NULL;
+
+    clicon_ptr_get(h, "statelist-entries", (void**)&htable);
+    if (htable)
+        dispatcher_free(htable);
+    return 0;
+}
+
 /*! Free pagination callback structure
  *
  * @param[in]  h      Clixon handle
@@ -537,6 +1241,8 @@ transaction_new(void)
     }
     memset(td, 0, sizeof(*td));
     td->td_id = id++;
+    td->td_start = transaction_clock();
+    td->td_clock = td->td_start;
     return td;
 }
 
@@ -559,17 +1265,22 @@ int
 transaction_free1(transaction_data_t *td,
                   int                 copy)
 {
+    int i;
+    int reset = 0;  /* Transient flags reset by flag epoch */
+
+    if (!copy)
+        reset = xml_flag_epoch_next();
     if (td->td_src){
         if (copy)
             xml_free(td->td_src);
-        else
+        else if (!reset)
             xml_apply(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                       (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_SKIP|XML_FLAG_MARK));
     }
     if (td->td_target){
         if (copy)
             xml_free(td->td_target);
-        else
+        else if (!reset)
             xml_apply(td->td_target, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                       (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_SKIP|XML_FLAG_MARK));
     }
@@ -581,25 +1292,299 @@ transaction_free1(transaction_data_t *td,
         free(td->td_scvec);
     if (td->td_tcvec)
         free(td->td_tcvec);
+    if (td->td_timevec)
+        free(td->td_timevec);
+    if (td->td_views){
+        for (i=0; i<td->td_nviews; i++)
+            transaction_free1(td->td_views[i], 0);
+        free(td->td_views);
+    }
+    if (td->td_pendvec)
+        free(td->td_pendvec);
     free(td);
     return 0;
 }
 
+/*! Monotonic clock for transaction timing
+ *
+ * @retval  usec  Microseconds since an unspecified start
+ */
+uint64_t
+transaction_clock(void)
+{
+    struct timespec ts = {0,};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+}
+
+/*! Name of transaction phase, as in stats and logs
+ *
+ * @param[in]  tp   Transaction phase
+ * @retval     str  Name
+ */
+const char *
+transaction_phase_str(enum transaction_phase tp)
+{
+    static const char *names[TRANS_PHASE_NR] = {
+        "persist", "get-target", "get-source", "diff", "begin", "validate",
+        "plugin-validate", "complete", "commit", "commit-done", "copy", "end"};
+
+    if (tp >= TRANS_PHASE_NR)
+        return NULL;
+    return names[tp];
+}
+
+/*! Add time since the end of the previous phase to a phase of a transaction
+ *
+ * @param[in]  td   Transaction data
+ * @param[in]  tp   Transaction phase, or TRANS_PHASE_NR to only restart the clock
+ * @code
+ *   transaction_timing_add(td, TRANS_PHASE_NR);
+ *   compute_diffs(h, td, 0);
+ *   transaction_timing_add(td, TRANS_PHASE_DIFF);
+ * @endcode
+ */
+void
+transaction_timing_add(transaction_data_t    *td,
+                       enum transaction_phase tp)
+{
+    uint64_t t1;
+
+    t1 = transaction_clock();
+    if (tp < TRANS_PHASE_NR){
+        td->td_usec[tp] += t1 - td->td_clock;
+        CLIXON_PROBE3(commit__phase, td->td_id, transaction_phase_str(tp), t1 - td->td_clock);
+    }
+    td->td_clock = t1;
+}
+
+/*! Add time of a callback of a plugin to a transaction
+ *
+ * @param[in]  td    Transaction data
+ * @param[in]  cp    Plugin handle
+ * @param[in]  tp    Transaction phase of callback
+ * @param[in]  usec  Time of callback
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @note Not thread-safe, workers record their time locally
+ */
+int
+transaction_timing_plugin(transaction_data_t    *td,
+                          clixon_plugin_t       *cp,
+                          enum transaction_phase tp,
+                          uint64_t               usec)
+{
+    transaction_time_t *tt;
+    int                 i;
+
+    if (tp >= TRANS_PHASE_NR)
+        return 0;
+    for (i=0; i<td->td_timelen; i++)
+        if (td->td_timevec[i].tt_plugin == cp)
+            break;
+    if (i == td->td_timelen){
+        if ((tt = realloc(td->td_timevec, (i+1)*sizeof(*tt))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        td->td_timevec = tt;
+        memset(&tt[i], 0, sizeof(*tt));
+        tt[i].tt_plugin = cp;
+        td->td_timelen++;
+    }
+    td->td_timevec[i].tt_usec[tp] += usec;
+    return 0;
+}
+
+/*! Check if the schema node of an xml node is in, or contains, one of a set of subtrees
+ *
+ * @param[in]  xn    XML node
+ * @param[in]  yvec  Vector of yang schema nodes of subtrees
+ * @param[in]  ylen  Length of yvec
+ * @retval     1     xn is in or contains a subtree
+ * @retval     0     No
+ */
+static int
+transaction_view_match(cxobj      *xn,
+                       yang_stmt **yvec,
+                       int         ylen)
+{
+    yang_stmt *ys;
+    yang_stmt *y;
+    int        i;
+
+    if ((ys = xml_spec(xn)) == NULL)
+        return 0;
+    for (i=0; i<ylen; i++){
+        for (y = ys; y != NULL; y = yang_parent_get(y))
+            if (y == yvec[i])
+                return 1;
+        for (y = yang_parent_get(yvec[i]); y != NULL; y = yang_parent_get(y))
+            if (y == ys)
+                return 1;
+    }
+    return 0;
+}
+
+/*! Compute transaction views of plugins that subscribe to subtrees with ca_trans_paths
+ *
+ * Each view has the deleted, added and changed nodes of the transaction that are in one of
+ * the subtrees of the plugin, or that contain one (eg an added parent).
+ * Call after the vectors of the transaction are computed.
+ * @param[in]  h    Clixon handle
+ * @param[in]  td   Transaction data
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see transaction_view  which gets the view of a plugin
+ */
+int
+transaction_views_compute(clixon_handle       h,
+                          transaction_data_t *td)
+{
+    int                 retval = -1;
+    yang_stmt          *yspec;
+    clixon_plugin_t    *cp = NULL;
+    char              **paths;
+    yang_stmt         **yvec = NULL;
+    int                 ylen;
+    yang_stmt          *y;
+    transaction_data_t *tv;
+    transaction_data_t **views;
+    int                 i;
+    int                 n;
+
+    yspec = clicon_dbspec_yang(h);
+    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+        if ((paths = clixon_plugin_api_get(cp)->ca_trans_paths) == NULL)
+            continue;
+        for (ylen=0; paths[ylen] != NULL; ylen++);
+        if ((yvec = calloc(ylen+1, sizeof(*yvec))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        ylen = 0;
+        for (i=0; paths[i] != NULL; i++){
+            if (yang_abs_schema_nodeid(yspec, paths[i], &y) < 0)
+                goto done;
+            if (y == NULL)
+                clixon_log(h, LOG_NOTICE, "%s: Plugin '%s' path %s not found",
+                           __func__, clixon_plugin_name_get(cp), paths[i]);
+            else
+                yvec[ylen++] = y;
+        }
+        if ((tv = calloc(1, sizeof(*tv))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        tv->td_parent = td;
+        tv->td_plugin = cp;
+        if ((views = realloc(td->td_views, (td->td_nviews+1)*sizeof(*views))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            free(tv);
+            goto done;
+        }
+        td->td_views = views;
+        td->td_views[td->td_nviews++] = tv;
+        for (i=0; i<td->td_dlen; i++)
+            if (transaction_view_match(td->td_dvec[i], yvec, ylen) &&
+                cxvec_append(td->td_dvec[i], &tv->td_dvec, &tv->td_dlen) < 0)
+                goto done;
+        for (i=0; i<td->td_alen; i++)
+            if (transaction_view_match(td->td_avec[i], yvec, ylen) &&
+                cxvec_append(td->td_avec[i], &tv->td_avec, &tv->td_alen) < 0)
+                goto done;
+        for (i=0; i<td->td_clen; i++)
+            if (transaction_view_match(td->td_tcvec[i], yvec, ylen)){
+                n = tv->td_clen;
+                if (cxvec_append(td->td_scvec[i], &tv->td_scvec, &n) < 0)
+                    goto done;
+                if (cxvec_append(td->td_tcvec[i], &tv->td_tcvec, &tv->td_clen) < 0)
+                    goto done;
+            }
+        free(yvec);
+        yvec = NULL;
+    }
+    retval = 0;
+ done:
+    if (yvec)
+        free(yvec);
+    return retval;
+}
+
+/*! Get transaction view of a plugin
+ *
+ * @param[in]  cp   Plugin handle
+ * @param[in]  td   Transaction data
+ * @retval     tv   View of plugin, or td if the plugin has no view
+ */
+static transaction_data_t *
+transaction_view(clixon_plugin_t    *cp,
+                 transaction_data_t *td)
+{
+    int i;
+
+    for (i=0; i<td->td_nviews; i++)
+        if (td->td_views[i]->td_plugin == cp)
+            return td->td_views[i];
+    return td;
+}
+
+/*! Check if a plugin view has no changes, then its data callbacks are not called
+ */
+static int
+transaction_view_unchanged(transaction_data_t *tv)
+{
+    return tv->td_parent != NULL && tv->td_dlen == 0 && tv->td_alen == 0 && tv->td_clen == 0;
+}
+
+/*! Call a transaction callback of a plugin with its view of the transaction
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  cp      Plugin handle
+ * @param[in]  fn      Callback
+ * @param[in]  fnname  Name of caller, for logs
+ * @param[in]  tp      Transaction phase the time of the callback is added to
+ * @param[in]  td      Transaction data
+ * @param[in]  data    If set, do not call if the view of the plugin has no changes
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
 static int
 plugin_transaction_call_one(clixon_handle       h,
 			    clixon_plugin_t    *cp,
 			    trans_cb_t         *fn,
 			    const char         *fnname,
-			    transaction_data_t *td)
+			    enum transaction_phase tp,
+			    transaction_data_t *td,
+			    int                 data)
 {
     int  retval = -1;
     int  rv;
     void *wh = NULL;
-
+    transaction_data_t *tv;
+    uint64_t t0;
+    uint64_t usec;
+    int      traced;
+
+    tv = transaction_view(cp, td);
+    if (data && transaction_view_unchanged(tv))
+        return 0;
     wh = NULL;
     if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), fnname) < 0)
         goto done;
-    rv = fn(h, (transaction_data)td);
+    t0 = transaction_clock();
+    CLIXON_PROBE2(plugin__entry, clixon_plugin_name_get(cp), fnname);
+    if ((traced = clixon_trace_span_begin(fnname, clixon_plugin_name_get(cp))) < 0)
+        goto done;
+    rv = fn(h, (transaction_data)tv);
+    usec = transaction_clock() - t0;
+    if (traced > 0 &&
+        clixon_trace_span_end(h, rv) < 0)
+        goto done;
+    CLIXON_PROBE4(plugin__exit, clixon_plugin_name_get(cp), fnname, rv, usec);
+    if (transaction_timing_plugin(td, cp, tp, usec) < 0)
+        goto done;
     if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), fnname) < 0)
         goto done;
     if (rv < 0) {
@@ -630,7 +1615,7 @@ plugin_transaction_begin_one(clixon_plugin_t    *cp,
     trans_cb_t *fn;
 
     if ((fn = clixon_plugin_api_get(cp)->ca_trans_begin) != NULL)
-        return plugin_transaction_call_one(h, cp, fn, __func__, td);
+        return plugin_transaction_call_one(h, cp, fn, __func__, TRANS_PHASE_BEGIN, td, 0);
     return 0;
 }
 
@@ -676,7 +1661,7 @@ plugin_transaction_validate_one(clixon_plugin_t    *cp,
     trans_cb_t *fn;
 
     if ((fn = clixon_plugin_api_get(cp)->ca_trans_validate) != NULL)
-        return plugin_transaction_call_one(h, cp, fn, __func__, td);
+        return plugin_transaction_call_one(h, cp, fn, __func__, TRANS_PHASE_PLUGIN_VALIDATE, td, 1);
     return 0;
 }
 
@@ -686,6 +1671,7 @@ plugin_transaction_validate_one(clixon_plugin_t    *cp,
  * @param[in]  td      Transaction data
  * @retval     0       OK. Validation succeeded in all plugins
  * @retval    -1       Error: one of the plugin callbacks returned validation fail
+ * @see CLICON_BACKEND_PLUGIN_THREADS for parallel validation of plugins with a group
  */
 int
 plugin_transaction_validate_all(clixon_handle       h,
@@ -694,6 +1680,10 @@ plugin_transaction_validate_all(clixon_handle       h,
     int            retval = -1;
     clixon_plugin_t *cp = NULL;
 
+#ifdef HAVE_LIBPTHREAD
+    if (clicon_option_int(h, "CLICON_BACKEND_PLUGIN_THREADS") > 1)
+        return plugin_transaction_parallel(h, td, 0);
+#endif
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
         if (plugin_transaction_validate_one(cp, h, td) < 0)
             goto done;
@@ -720,7 +1710,7 @@ plugin_transaction_complete_one(clixon_plugin_t    *cp,
     trans_cb_t *fn;
 
     if ((fn = clixon_plugin_api_get(cp)->ca_trans_complete) != NULL)
-        return plugin_transaction_call_one(h, cp, fn, __func__, td);
+        return plugin_transaction_call_one(h, cp, fn, __func__, TRANS_PHASE_COMPLETE, td, 1);
     return 0;
 }
 
@@ -767,12 +1757,15 @@ plugin_transaction_revert_all(clixon_handle       h,
     int              retval = 0;
     clixon_plugin_t *cp = NULL;
     trans_cb_t      *fn;
+    transaction_data_t *tv;
 
     while ((cp = clixon_plugin_each_revert(h, cp, nr)) != NULL) {
         if ((fn = clixon_plugin_api_get(cp)->ca_trans_revert) == NULL)
             continue;
-
-        if ((retval = fn(h, (transaction_data)td)) < 0){
+        tv = transaction_view(cp, td);
+        if (transaction_view_unchanged(tv))
+            continue;
+        if ((retval = fn(h, (transaction_data)tv)) < 0){
             clixon_log(h, LOG_NOTICE, "%s: Plugin '%s' trans_revert callback failed",
                            __func__, clixon_plugin_name_get(cp));
                 break;
@@ -792,7 +1785,7 @@ plugin_transaction_commit_failed(clixon_plugin_t    *cp,
     trans_cb_t *fn;
 
     if ((fn = clixon_plugin_api_get(cp)->ca_trans_commit_failed) != NULL)
-        return plugin_transaction_call_one(h, cp, fn, __func__, td);
+        return plugin_transaction_call_one(h, cp, fn, __func__, TRANS_PHASE_COMMIT, td, 1);
     return 0;
 }
 
@@ -810,11 +1803,292 @@ plugin_transaction_commit_one(clixon_plugin_t    *cp,
                               transaction_data_t *td)
 {
     trans_cb_t *fn;
+    int         ret = 0;
 
-    if ((fn = clixon_plugin_api_get(cp)->ca_trans_commit) != NULL)
-        return plugin_transaction_call_one(h, cp, fn, __func__, td);
-    return 0;
+    if ((fn = clixon_plugin_api_get(cp)->ca_trans_commit) != NULL){
+        td->td_current = cp; /* For transaction_pending */
+        ret = plugin_transaction_call_one(h, cp, fn, __func__, TRANS_PHASE_COMMIT, td, 1);
+        td->td_current = NULL;
+    }
+    return ret;
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*! Shared state of plugin_transaction_stage workers
+ */
+struct plugin_trans_work{
+    pthread_mutex_t     pw_mutex;
+    clixon_handle       pw_h;
+    transaction_data_t *pw_td;
+    int                 pw_commit; /* 1: commit, 0: validate */
+    clixon_plugin_t   **pw_vec;    /* All plugins in load order */
+    int                *pw_status; /* Per plugin: 1 called OK, -1 failed, 0 not called */
+    uint64_t           *pw_usec;   /* Per plugin: time of callback */
+    int                *pw_leader; /* Per plugin: first plugin in stage of same group */
+    int                 pw_end;    /* End of stage in pw_vec */
+    int                *pw_units;  /* First plugin of each group in stage */
+    int                 pw_nunits;
+    int                 pw_next;   /* Next unit to call */
+    int                 pw_err;    /* Set if any callback failed */
+};
+
+/*! Worker calling the plugins of one group at a time, in load order
+ *
+ * Resource checks are not made in workers since signals and terminal are per process
+ */
+static void *
+plugin_trans_worker(void *arg)
+{
+    struct plugin_trans_work *pw = (struct plugin_trans_work *)arg;
+    clixon_plugin_api        *api;
+    trans_cb_t               *fn;
+    transaction_data_t       *tv;
+    uint64_t                  t0;
+    int                       rv;
+    int                       u;
+    int                       i;
+
+    for (;;){
+        pthread_mutex_lock(&pw->pw_mutex);
+        if (pw->pw_err || (u = pw->pw_next) >= pw->pw_nunits)
+            u = -1;
+        else
+            pw->pw_next++;
+        pthread_mutex_unlock(&pw->pw_mutex);
+        if (u < 0)
+            break;
+        for (i=pw->pw_units[u]; i<pw->pw_end; i++){
+            if (pw->pw_leader[i] != pw->pw_units[u])
+                continue;
+            api = clixon_plugin_api_get(pw->pw_vec[i]);
+            fn = pw->pw_commit ? api->ca_trans_commit : api->ca_trans_validate;
+            tv = transaction_view(pw->pw_vec[i], pw->pw_td);
+            if (transaction_view_unchanged(tv))
+                continue;
+            if (fn == NULL){
+                pw->pw_status[i] = 1;
+                continue;
+            }
+            t0 = transaction_clock();
+            rv = fn(pw->pw_h, (transaction_data)tv);
+            pw->pw_usec[i] = transaction_clock() - t0;
+            if (rv < 0){
+                pw->pw_status[i] = -1;
+                pthread_mutex_lock(&pw->pw_mutex);
+                pw->pw_err++;
+                pthread_mutex_unlock(&pw->pw_mutex);
+                break; /* Later plugins of group may depend on this */
+            }
+            pw->pw_status[i] = 1;
+        }
+    }
+    return NULL;
+}
+
+/*! Call validate or commit of a stage of consecutive plugins with groups in parallel
+ *
+ * @param[in]  pw       Work state with plugins, status and stage end set
+ * @param[in]  start    First plugin of stage
+ * @param[in]  nthreads Max number of threads
+ * @retval     0        OK, see pw_status for result of each plugin
+ * @retval    -1        Error
+ */
+static int
+plugin_transaction_stage(struct plugin_trans_work *pw,
+                         int                       start,
+                         int                       nthreads)
+{
+    int         retval = -1;
+    pthread_t  *tids = NULL;
+    void       *wh = NULL;
+    const char *fnname;
+    char       *group;
+    int         frozen;
+    int         threads;
+    int         i;
+    int         j;
+    int         n = 0;
+    int         ret;
+
+    fnname = pw->pw_commit ? "plugin_transaction_commit_one" : "plugin_transaction_validate_one";
+    pw->pw_nunits = 0;
+    pw->pw_next = 0;
+    pw->pw_err = 0;
+    for (i=start; i<pw->pw_end; i++){
+        group = clixon_plugin_api_get(pw->pw_vec[i])->ca_trans_group;
+        for (j=start; j<i; j++)
+            if (strcmp(clixon_plugin_api_get(pw->pw_vec[j])->ca_trans_group, group) == 0)
+                break;
+        pw->pw_leader[i] = j;
+        if (j == i)
+            pw->pw_units[pw->pw_nunits++] = i;
+    }
+    if (pw->pw_nunits < nthreads)
+        nthreads = pw->pw_nunits;
+    if ((tids = calloc(nthreads, sizeof(*tids))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if (clixon_resource_check(pw->pw_h, &wh, "parallel", fnname) < 0)
+        goto done;
+    /* Namespace lookups of callbacks in threads only read caches, and XML nodes are created
+     * in threads */
+    frozen = xml2ns_cache_freeze(1);
+    threads = xml_threads_set(1);
+    if (nthreads > 1)
+        for (n=0; n<nthreads; n++)
+            if ((ret = pthread_create(&tids[n], NULL, plugin_trans_worker, pw)) != 0){
+                clixon_err(OE_UNIX, ret, "pthread_create");
+                break;
+            }
+    if (n == 0) /* No threads, call here */
+        plugin_trans_worker(pw);
+    for (i=0; i<n; i++)
+        pthread_join(tids[i], NULL);
+    xml_threads_set(threads);
+    xml2ns_cache_freeze(frozen);
+    if (clixon_resource_check(pw->pw_h, &wh, "parallel", fnname) < 0)
+        goto done;
+    for (i=start; i<pw->pw_end; i++)
+        if (pw->pw_status[i] < 0 &&
+            !clixon_plugin_rpc_err_set(pw->pw_h) && !clixon_err_category())
+            /* sanity: log if err is not called ! */
+            clixon_log(pw->pw_h, LOG_NOTICE, "%s: Plugin '%s' callback does not make clixon_err or clixon_plugin_rpc_err call on error",
+                       fnname, clixon_plugin_name_get(pw->pw_vec[i]));
+    retval = 0;
+ done:
+    if (tids)
+        free(tids);
+    return retval;
+}
+
+/*! Call validate or commit callbacks of all plugins, plugins with groups in parallel
+ *
+ * Plugins are called in load order, except that consecutive plugins with a group form a stage
+ * whose groups are called in parallel by CLICON_BACKEND_PLUGIN_THREADS threads.
+ * Plugins of the same group are called in load order in one thread.
+ * If a commit fails, commit_failed is called for every failed plugin and revert in reverse
+ * load order for every plugin whose commit succeeded.
+ * @param[in]  h       Clixon handle
+ * @param[in]  td      Transaction data
+ * @param[in]  commit  1: commit, 0: validate
+ * @retval     0       OK
+ * @retval    -1       Error: one of the plugin callbacks returned error
+ * @note clixon_err is not per thread: if several plugins fail, the error may be from any of them
+ */
+static int
+plugin_transaction_parallel(clixon_handle       h,
+                            transaction_data_t *td,
+                            int                 commit)
+{
+    int                      retval = -1;
+    struct plugin_trans_work pw = {0,};
+    clixon_plugin_t         *cp = NULL;
+    trans_cb_t              *fn;
+    int                      nthreads;
+    int                      n = 0;
+    int                      i;
+    int                      start;
+    int                      err = 0;
+    int                      async;
+    int                      ret;
+
+    nthreads = clicon_option_int(h, "CLICON_BACKEND_PLUGIN_THREADS");
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+        n++;
+    if (n == 0)
+        return 0;
+    async = td->td_async;
+    td->td_async = 0; /* Commits are not pending in parallel calls */
+    if ((pw.pw_vec = calloc(n, sizeof(*pw.pw_vec))) == NULL ||
+        (pw.pw_status = calloc(n, sizeof(int))) == NULL ||
+        (pw.pw_usec = calloc(n, sizeof(uint64_t))) == NULL ||
+        (pw.pw_leader = calloc(n, sizeof(int))) == NULL ||
+        (pw.pw_units = calloc(n, sizeof(int))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    i = 0;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+        pw.pw_vec[i++] = cp;
+    pw.pw_h = h;
+    pw.pw_td = td;
+    pw.pw_commit = commit;
+    if (pthread_mutex_init(&pw.pw_mutex, NULL) != 0){
+        clixon_err(OE_UNIX, errno, "pthread_mutex_init");
+        goto done;
+    }
+    for (start=0; start<n && err==0; start=pw.pw_end){
+        cp = pw.pw_vec[start];
+        if (clixon_plugin_api_get(cp)->ca_trans_group == NULL){
+            /* Barrier: plugin without group is called alone */
+            if (commit)
+                ret = plugin_transaction_commit_one(cp, h, td);
+            else
+                ret = plugin_transaction_validate_one(cp, h, td);
+            pw.pw_status[start] = ret < 0 ? -1 : 1;
+            if (ret < 0)
+                err++;
+            pw.pw_end = start + 1;
+            continue;
+        }
+        for (pw.pw_end=start; pw.pw_end<n; pw.pw_end++)
+            if (clixon_plugin_api_get(pw.pw_vec[pw.pw_end])->ca_trans_group == NULL)
+                break;
+        if (plugin_transaction_stage(&pw, start, nthreads) < 0){
+            pthread_mutex_destroy(&pw.pw_mutex);
+            goto done;
+        }
+        for (i=start; i<pw.pw_end; i++){
+            if (pw.pw_status[i] < 0)
+                err++;
+            if (pw.pw_usec[i] &&
+                transaction_timing_plugin(td, pw.pw_vec[i],
+                                          commit ? TRANS_PHASE_COMMIT : TRANS_PHASE_PLUGIN_VALIDATE,
+                                          pw.pw_usec[i]) < 0){
+                pthread_mutex_destroy(&pw.pw_mutex);
+                goto done;
+            }
+        }
+    }
+    pthread_mutex_destroy(&pw.pw_mutex);
+    if (err){
+        if (commit){
+            /* First make an effort ro revert transaction for the failed plugins */
+            for (i=0; i<n; i++)
+                if (pw.pw_status[i] < 0)
+                    plugin_transaction_commit_failed(pw.pw_vec[i], h, td);
+            /* Make an effort to revert transaction in plugins that committed */
+            for (i=n-1; i>=0; i--){
+                if (pw.pw_status[i] != 1)
+                    continue;
+                if ((fn = clixon_plugin_api_get(pw.pw_vec[i])->ca_trans_revert) == NULL)
+                    continue;
+                if (fn(h, (transaction_data)transaction_view(pw.pw_vec[i], td)) < 0){
+                    clixon_log(h, LOG_NOTICE, "%s: Plugin '%s' trans_revert callback failed",
+                               __func__, clixon_plugin_name_get(pw.pw_vec[i]));
+                    break;
+                }
+            }
+        }
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (pw.pw_vec)
+        free(pw.pw_vec);
+    if (pw.pw_status)
+        free(pw.pw_status);
+    if (pw.pw_usec)
+        free(pw.pw_usec);
+    if (pw.pw_leader)
+        free(pw.pw_leader);
+    if (pw.pw_units)
+        free(pw.pw_units);
+    td->td_async = async;
+    return retval;
 }
+#endif /* HAVE_LIBPTHREAD */
 
 /*! Call transaction_commit callbacks in all backend plugins
  *
@@ -825,6 +2099,7 @@ plugin_transaction_commit_one(clixon_plugin_t    *cp,
  * If any of the commit callbacks fail by returning -1, a revert of the 
  * transaction is tried by calling the commit callbacsk with reverse arguments
  * and in reverse order.
+ * @see CLICON_BACKEND_PLUGIN_THREADS for parallel commit of plugins with a group
  */
 int
 plugin_transaction_commit_all(clixon_handle       h,
@@ -834,6 +2109,10 @@ plugin_transaction_commit_all(clixon_handle       h,
     clixon_plugin_t *cp = NULL;
     int            i=0;
 
+#ifdef HAVE_LIBPTHREAD
+    if (clicon_option_int(h, "CLICON_BACKEND_PLUGIN_THREADS") > 1)
+        return plugin_transaction_parallel(h, td, 1);
+#endif
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
         i++;
         if (plugin_transaction_commit_one(cp, h, td) < 0){
@@ -849,6 +2128,57 @@ plugin_transaction_commit_all(clixon_handle       h,
     return retval;
 }
 
+/*! Terminate the pending commit callbacks of a transaction when all are done
+ *
+ * If any pending commit failed, commit_failed is called in the failed plugins and revert in
+ * all other plugins, in reverse load order.
+ * @param[in]  h       Clixon handle
+ * @param[in]  td      Transaction data
+ * @retval     0       OK, all pending commits succeeded, or there were none
+ * @retval    -1       Error: a pending commit failed
+ * @see transaction_pending
+ */
+int
+plugin_transaction_pending_end(clixon_handle       h,
+                               transaction_data_t *td)
+{
+    clixon_plugin_t *cp = NULL;
+    trans_cb_t      *fn;
+    transaction_data_t *tv;
+    int              failed = 0;
+    int              n = 0;
+    int              i;
+
+    for (i=0; i<td->td_pendlen; i++)
+        if (td->td_pendvec[i].tp_status < 0){
+            plugin_transaction_commit_failed(td->td_pendvec[i].tp_plugin, h, td);
+            failed++;
+        }
+    if (failed == 0)
+        return 0;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+        n++;
+    cp = NULL;
+    while ((cp = clixon_plugin_each_revert(h, cp, n)) != NULL) {
+        for (i=0; i<td->td_pendlen; i++)
+            if (td->td_pendvec[i].tp_plugin == cp && td->td_pendvec[i].tp_status < 0)
+                break;
+        if (i < td->td_pendlen)
+            continue;
+        if ((fn = clixon_plugin_api_get(cp)->ca_trans_revert) == NULL)
+            continue;
+        tv = transaction_view(cp, td);
+        if (transaction_view_unchanged(tv))
+            continue;
+        if (fn(h, (transaction_data)tv) < 0){
+            clixon_log(h, LOG_NOTICE, "%s: Plugin '%s' trans_revert callback failed",
+                       __func__, clixon_plugin_name_get(cp));
+            break;
+        }
+    }
+    return -1;
+}
+
 /*! Call single plugin transaction_commit_done() in a commit transaction
  *
  * @param[in]  cp      Plugin handle
@@ -865,7 +2195,7 @@ plugin_transaction_commit_done_one(clixon_plugin_t    *cp,
     trans_cb_t *fn;
 
     if ((fn = clixon_plugin_api_get(cp)->ca_trans_commit_done) != NULL)
-        return plugin_transaction_call_one(h, cp, fn, __func__, td);
+        return plugin_transaction_call_one(h, cp, fn, __func__, TRANS_PHASE_COMMIT_DONE, td, 1);
     return 0;
 }
 
@@ -909,7 +2239,7 @@ plugin_transaction_end_one(clixon_plugin_t    *cp,
     trans_cb_t *fn;
 
     if ((fn = clixon_plugin_api_get(cp)->ca_trans_end) != NULL)
-        return plugin_transaction_call_one(h, cp, fn, __func__, td);
+        return plugin_transaction_call_one(h, cp, fn, __func__, TRANS_PHASE_END, td, 0);
     return 0;
 }
 
@@ -945,7 +2275,7 @@ plugin_transaction_abort_one(clixon_plugin_t    *cp,
     trans_cb_t *fn;
 
     if ((fn = clixon_plugin_api_get(cp)->ca_trans_abort) != NULL)
-        return plugin_transaction_call_one(h, cp, fn, __func__, td);
+        return plugin_transaction_call_one(h, cp, fn, __func__, TRANS_PHASE_NR, td, 0);
     return 0;
 }
 
@@ -0,0 +1,488 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  Private candidate datastores, see draft-ietf-netconf-privcand
+  With CLICON_XMLDB_PRIVATE_CANDIDATE, <candidate/> of a session refers to its own private
+  candidate datastore "candidate-<session-id>". It shares running until the session first
+  edits it, and is then copied from running. The running tree it was copied from is held as
+  its base. A commit rebases the edits of the session, ie the difference between base and
+  private candidate, onto current running. An edit conflicts if running has changed the same
+  node since the base.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_transaction.h"
+#include "clixon_backend_plugin.h"
+#include "clixon_backend_client.h"
+#include "backend_handle.h"
+#include "clixon_backend_commit.h"
+#include "backend_client.h"
+
+/*! Find node in tree corresponding to a node in another tree with same top
+ *
+ * Match each ancestor of x from the top using keys of lists
+ * @param[in]  xt   Top of tree to search in
+ * @param[in]  x    Node in other tree
+ * @param[out] xmp  Matching node in xt, or NULL if none
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+private_candidate_match(cxobj  *xt,
+                        cxobj  *x,
+                        cxobj **xmp)
+{
+    cxobj *xp;
+    cxobj *xtp = NULL;
+
+    *xmp = NULL;
+    if ((xp = xml_parent(x)) == NULL){
+        *xmp = xt;
+        return 0;
+    }
+    if (private_candidate_match(xt, xp, &xtp) < 0)
+        return -1;
+    if (xtp == NULL)
+        return 0;
+    return match_base_child(xtp, x, xml_spec(x), xmp);
+}
+
+/*! Check if two subtrees are equal, including body of leafs
+ *
+ * @param[in]  x0  First subtree
+ * @param[in]  x1  Second subtree
+ * @retval     1   Equal
+ * @retval     0   Not equal
+ */
+static int
+private_candidate_equal(cxobj *x0,
+                        cxobj *x1)
+{
+    char *b0 = xml_body(x0);
+    char *b1 = xml_body(x1);
+
+    if ((b0 == NULL) != (b1 == NULL) ||
+        (b0 && strcmp(b0, b1) != 0))
+        return 0;
+    return xml_tree_equal(x0, x1) == 0;
+}
+
+/*! Check or apply edits of a private candidate onto a tree
+ *
+ * The edits are the differences between the base and the private candidate, see xml_diff.
+ * An edit conflicts if the node it edits is changed in the tree since the base.
+ * Edits already made in the tree are skipped.
+ * @param[in]  xt     Tree, eg running or a copy of running
+ * @param[in]  dvec   Nodes of base deleted in private candidate
+ * @param[in]  dlen   Length of dvec
+ * @param[in]  avec   Nodes of private candidate added since base
+ * @param[in]  alen   Length of avec
+ * @param[in]  scvec  Leafs of base changed in private candidate
+ * @param[in]  tcvec  Changed leafs of private candidate
+ * @param[in]  clen   Length of scvec and tcvec
+ * @param[in]  apply  0: Only check conflicts, 1: also apply edits to xt
+ * @param[out] xconf  Node of first conflicting edit, or NULL
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+private_candidate_merge(cxobj  *xt,
+                        cxobj **dvec,
+                        int     dlen,
+                        cxobj **avec,
+                        int     alen,
+                        cxobj **scvec,
+                        cxobj **tcvec,
+                        int     clen,
+                        int     apply,
+                        cxobj **xconf)
+{
+    int    retval = -1;
+    cxobj *x;
+    cxobj *xp;
+    cxobj *xb;
+    char  *b;
+    int    i;
+
+    *xconf = NULL;
+    for (i=0; i<dlen; i++){
+        if (private_candidate_match(xt, dvec[i], &x) < 0)
+            goto done;
+        if (x == NULL) /* Deleted also in tree */
+            continue;
+        if (!private_candidate_equal(dvec[i], x)){
+            *xconf = dvec[i];
+            goto ok;
+        }
+        if (apply && xml_purge(x) < 0)
+            goto done;
+    }
+    for (i=0; i<clen; i++){
+        if (private_candidate_match(xt, scvec[i], &x) < 0)
+            goto done;
+        if (x == NULL ||
+            (b = xml_body(x)) == NULL){
+            *xconf = tcvec[i];
+            goto ok;
+        }
+        if (xml_body(tcvec[i]) && strcmp(b, xml_body(tcvec[i])) == 0)
+            continue;
+        if (xml_body(scvec[i]) == NULL || strcmp(b, xml_body(scvec[i])) != 0){
+            *xconf = tcvec[i];
+            goto ok;
+        }
+        if (apply &&
+            (xb = xml_body_get(x)) != NULL &&
+            xml_value_set(xb, xml_body(tcvec[i])) < 0)
+            goto done;
+    }
+    for (i=0; i<alen; i++){
+        if (private_candidate_match(xt, xml_parent(avec[i]), &xp) < 0)
+            goto done;
+        if (xp == NULL){ /* Parent deleted in tree */
+            *xconf = avec[i];
+            goto ok;
+        }
+        if (match_base_child(xp, avec[i], xml_spec(avec[i]), &x) < 0)
+            goto done;
+        if (x != NULL){
+            if (private_candidate_equal(avec[i], x))
+                continue;
+            *xconf = avec[i];
+            goto ok;
+        }
+        if (apply){
+            if ((x = xml_dup(avec[i])) == NULL)
+                goto done;
+            if (xml_addsub(xp, x) < 0)
+                goto done;
+            if (xml_sort(xp) < 0)
+                goto done;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Rebase edits of private candidate onto current running
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry with private candidate
+ * @param[out] cbret  Error reply if conflict
+ * @retval     1      OK, private candidate is based on current running
+ * @retval     0      Conflict, error reply in cbret
+ * @retval    -1      Error
+ */
+static int
+private_candidate_rebase(clixon_handle        h,
+                         struct client_entry *ce,
+                         cbuf                *cbret)
+{
+    int       retval = -1;
+    char     *db = ce->ce_candidate;
+    db_elmnt *de;
+    cxobj    *xrun;
+    cxobj    *xpriv = NULL;   /* Copy of private candidate */
+    cxobj    *xt;
+    cxobj    *xbase;
+    cxobj   **dvec = NULL;
+    int       dlen;
+    cxobj   **avec = NULL;
+    int       alen;
+    cxobj   **scvec = NULL;
+    cxobj   **tcvec = NULL;
+    int       clen;
+    cxobj    *xconf = NULL;
+    char     *xpath = NULL;
+    cbuf     *cb = NULL;
+
+    if (xmldb_generation(h, "running") == ce->ce_candidate_gen)
+        goto ok;
+    if ((de = clicon_db_elmnt_get(h, "running")) == NULL ||
+        (xrun = de->de_xml) == NULL ||
+        (xbase = ce->ce_candidate_base) == NULL){
+        if (netconf_operation_failed(cbret, "application", "Private candidate has no running to rebase onto") < 0)
+            goto done;
+        goto fail;
+    }
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_xml == NULL)
+        goto ok;
+    clixon_debug(CLIXON_DBG_BACKEND, "Rebase %s", db);
+    if ((xpriv = xml_dup(de->de_xml)) == NULL)
+        goto done;
+    if (xml_diff(xbase, xpriv, &dvec, &dlen, &avec, &alen, &scvec, &tcvec, &clen) < 0)
+        goto done;
+    /* Check conflicts before private candidate is replaced */
+    if (private_candidate_merge(xrun, dvec, dlen, avec, alen, scvec, tcvec, clen, 0, &xconf) < 0)
+        goto done;
+    if (xconf != NULL){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        if (xml2xpath(xconf, NULL, 0, 1, &xpath) < 0)
+            goto done;
+        cprintf(cb, "Private candidate conflicts with running at %s", xpath);
+        if (netconf_operation_failed(cbret, "application", cbuf_get(cb)) < 0)
+            goto done;
+        goto fail;
+    }
+    if (xmldb_copy(h, "running", db) < 0)
+        goto done;
+    if ((xt = xmldb_cache_get(h, db)) == NULL){
+        clixon_err(OE_DB, ENOENT, "No cache of %s", db);
+        goto done;
+    }
+    if (private_candidate_merge(xt, dvec, dlen, avec, alen, scvec, tcvec, clen, 1, &xconf) < 0)
+        goto done;
+    if (xmldb_write_cache2file(h, db) < 0)
+        goto done;
+    xmldb_modified_set(h, db, 1);
+    if (xmldb_rdonly_release(h, "running", ce->ce_candidate_base) < 0)
+        goto done;
+    ce->ce_candidate_base = NULL;
+    if (xmldb_rdonly_hold(h, "running", &ce->ce_candidate_base) < 0)
+        goto done;
+    ce->ce_candidate_gen = xmldb_generation(h, "running");
+ ok:
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xpath)
+        free(xpath);
+    if (dvec)
+        free(dvec);
+    if (avec)
+        free(avec);
+    if (scvec)
+        free(scvec);
+    if (tcvec)
+        free(tcvec);
+    if (xpriv)
+        xml_free(xpriv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Map a datastore of a session to its private candidate
+ *
+ * If the private candidate has no edits, it shares running and reads are made from running.
+ * On first write, running is copied to the private candidate and held as its base.
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  db     Datastore in request, eg "candidate"
+ * @param[in]  write  0: read, 1: write
+ * @param[out] dbp    Datastore to use: db, "running" or the private candidate
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see CLICON_XMLDB_PRIVATE_CANDIDATE
+ */
+int
+private_candidate_db(clixon_handle        h,
+                     struct client_entry *ce,
+                     char                *db,
+                     int                  write,
+                     char               **dbp)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cxobj *xt = NULL;
+    cxobj *xerr = NULL;
+
+    *dbp = db;
+    if (db == NULL ||
+        strcmp(db, "candidate") != 0 ||
+        !clicon_option_bool(h, "CLICON_XMLDB_PRIVATE_CANDIDATE"))
+        goto ok;
+    if (ce->ce_candidate == NULL){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "candidate-%u", ce->ce_id);
+        if ((ce->ce_candidate = strdup(cbuf_get(cb))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+    }
+    if (ce->ce_candidate_gen == 0){ /* Shares running */
+        if (!write){
+            *dbp = "running";
+            goto ok;
+        }
+        clixon_debug(CLIXON_DBG_BACKEND, "Copy running to %s", ce->ce_candidate);
+        if (xmldb_get_cache(h, "running", YB_MODULE, &xt, NULL, &xerr) < 0)
+            goto done;
+        if (xmldb_copy(h, "running", ce->ce_candidate) < 0)
+            goto done;
+        if (xmldb_rdonly_hold(h, "running", &ce->ce_candidate_base) < 0)
+            goto done;
+        ce->ce_candidate_gen = xmldb_generation(h, "running");
+    }
+    *dbp = ce->ce_candidate;
+ ok:
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Discard private candidate, it shares running again
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+private_candidate_discard(clixon_handle        h,
+                          struct client_entry *ce)
+{
+    int retval = -1;
+
+    if (ce->ce_candidate == NULL || ce->ce_candidate_gen == 0)
+        goto ok;
+    clixon_debug(CLIXON_DBG_BACKEND, "Discard %s", ce->ce_candidate);
+    if (ce->ce_candidate_base != NULL){
+        if (xmldb_rdonly_release(h, "running", ce->ce_candidate_base) < 0)
+            goto done;
+        ce->ce_candidate_base = NULL;
+    }
+    ce->ce_candidate_gen = 0;
+    if (xmldb_delete(h, ce->ce_candidate) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Commit private candidate of session
+ *
+ * Rebase private candidate onto running if running has changed, then commit it.
+ * On success the private candidate is equal to running, and is discarded.
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  xe     Request: <rpc><xn></rpc>
+ * @param[out] cbret  Error reply if conflict or validation fails
+ * @retval     1      OK
+ * @retval     0      Conflict or validation failed, error reply in cbret
+ * @retval    -1      Error
+ */
+int
+private_candidate_commit(clixon_handle        h,
+                         struct client_entry *ce,
+                         cxobj               *xe,
+                         cbuf                *cbret)
+{
+    int retval = -1;
+    int ret;
+
+    if (ce->ce_candidate == NULL || ce->ce_candidate_gen == 0) /* No edits */
+        goto ok;
+    if ((ret = private_candidate_rebase(h, ce, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if ((ret = candidate_commit(h, xe, ce->ce_candidate, ce->ce_id, 0, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (private_candidate_discard(h, ce) < 0)
+        goto done;
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Free private candidate of session when session ends
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+private_candidate_free(clixon_handle        h,
+                       struct client_entry *ce)
+{
+    int   retval = -1;
+    char *filename = NULL;
+
+    if (ce->ce_candidate == NULL)
+        goto ok;
+    if (private_candidate_discard(h, ce) < 0)
+        goto done;
+    if (xmldb_db2file(h, ce->ce_candidate, &filename) < 0)
+        goto done;
+    unlink(filename);
+    free(ce->ce_candidate);
+    ce->ce_candidate = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (filename)
+        free(filename);
+    return retval;
+}
@@ -0,0 +1,491 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * On-change push of datastore changes, see CLICON_STREAM_ON_CHANGE
+ *
+ * After a commit, the diff of the transaction (td_dvec, td_scvec/td_tcvec, td_avec) is
+ * translated to RFC 8641 YANG-Push push-change-update notifications with a yang-patch
+ * of the changes of each subscribed subtree. A subscription is a RFC 5277
+ * create-subscription of the on-change stream, where the filter selects subtrees of the
+ * datastore, no filter means all of it. A patch is made once per distinct filter, and
+ * sent to the subscriptions of that filter with stream_notify_xml_selector.
+ * With a dampening period, edits of commits within the period are sent as one patch.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_transaction.h"
+#include "clixon_backend_plugin.h"
+#include "backend_push.h"
+
+/* RFC 8641 YANG-Push namespace of push-change-update */
+#define YANG_PUSH_NAMESPACE "urn:ietf:params:xml:ns:yang:ietf-yang-push"
+
+/*
+ * Local types
+ */
+/* Pending patch of the subscriptions with a filter */
+struct push_patch {
+    qelem_t  pp_q;      /* queue header */
+    char    *pp_xpath;  /* Filter of subscriptions, "" if none */
+    cxobj   *pp_xn;     /* Pending push-change-update notification */
+    cxobj   *pp_xpatch; /* yang-patch of pp_xn */
+    int      pp_nr;     /* Nr of edits in pp_xpatch */
+    uint64_t pp_commit; /* Last commit whose edits are added */
+};
+
+/* On-change push state, see CLICON_STREAM_ON_CHANGE */
+struct push_state {
+    char              *ps_stream;     /* Name of on-change stream */
+    uint32_t           ps_dampening;  /* Min time between pushes in ms, 0 is none */
+    struct timeval     ps_last;       /* Time of last push */
+    int                ps_timer;      /* Dampening timer registered */
+    uint64_t           ps_commit;     /* Commit counter */
+    uint64_t           ps_patch_id;   /* Patch counter, for patch-id */
+    struct push_patch *ps_patches;    /* Pending patches, one per filter */
+};
+
+/*! Add a yang-patch edit of a changed node
+ *
+ * @param[in]  pp    Pending patch
+ * @param[in]  pb    Api-path builder
+ * @param[in]  op    yang-patch operation: create, delete or replace
+ * @param[in]  x     Changed node, in source tree for delete, in target tree otherwise
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+push_edit_add(struct push_patch *pp,
+              api_path_builder  *pb,
+              char              *op,
+              cxobj             *x)
+{
+    int    retval = -1;
+    cxobj *xe;
+    cxobj *xv;
+    cxobj *xc;
+    cbuf  *cb = NULL;
+    char  *path;
+    char  *prefix;
+    char  *ns = NULL;
+    char  *ns1 = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((xe = xml_new("edit", pp->pp_xpatch, CX_ELMNT)) == NULL)
+        goto done;
+    cprintf(cb, "edit%d", ++pp->pp_nr);
+    if (xml_new_body("edit-id", xe, cbuf_get(cb)) == NULL)
+        goto done;
+    if (xml_new_body("operation", xe, op) == NULL)
+        goto done;
+    if (api_path_builder_path(pb, x, &path) < 0)
+        goto done;
+    if (xml_new_body("target", xe, path) == NULL)
+        goto done;
+    if (strcmp(op, "delete") != 0){
+        if ((xv = xml_new("value", xe, CX_ELMNT)) == NULL)
+            goto done;
+        if ((xc = xml_dup(x)) == NULL)
+            goto done;
+        if (xml_addsub(xv, xc) < 0)
+            goto done;
+        /* The copy is out of its ancestors namespace context */
+        prefix = xml_prefix(x);
+        if (xml2ns(x, prefix, &ns) < 0)
+            goto done;
+        if (xml2ns(xc, prefix, &ns1) < 0)
+            goto done;
+        if (ns && ns1 == NULL && xmlns_set(xc, prefix, ns) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Check if node is in a marked subtree of a filter
+ *
+ * @param[in]  x    XML node
+ * @retval     1    x or an ancestor is marked with XML_FLAG_TRANSIENT
+ * @retval     0    No
+ */
+static int
+push_marked(cxobj *x)
+{
+    for (; x != NULL; x = xml_parent(x))
+        if (xml_flag(x, XML_FLAG_TRANSIENT))
+            return 1;
+    return 0;
+}
+
+/*! Add edits of a commit to the pending patch of a filter
+ *
+ * A subtree selected by the filter that is deleted or added as a whole is one edit. Otherwise
+ * changes in a selected subtree are edits of their own, deletes first, then changed leafs,
+ * then added nodes. Uses the commit marks of compute_diffs: XML_FLAG_ADD, XML_FLAG_DEL and
+ * XML_FLAG_CHANGE.
+ * @param[in]  td    Transaction data after commit
+ * @param[in]  pp    Pending patch of filter
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+push_filter_edits(transaction_data_t *td,
+                  struct push_patch  *pp)
+{
+    int               retval = -1;
+    cxobj           **svec = NULL; /* Selected in source */
+    size_t            slen = 0;
+    cxobj           **tvec = NULL; /* Selected in target */
+    size_t            tlen = 0;
+    cxobj            *x;
+    size_t            i;
+    api_path_builder *pb = NULL;
+
+    if ((pb = api_path_builder_new()) == NULL)
+        goto done;
+    if (strlen(pp->pp_xpath) == 0){
+        xml_flag_set(td->td_src, XML_FLAG_TRANSIENT);
+        xml_flag_set(td->td_target, XML_FLAG_TRANSIENT);
+    }
+    else {
+        if (xpath_vec(td->td_src, NULL, "%s", &svec, &slen, pp->pp_xpath) < 0)
+            goto done;
+        if (xpath_vec(td->td_target, NULL, "%s", &tvec, &tlen, pp->pp_xpath) < 0)
+            goto done;
+        for (i=0; i<slen; i++){
+            x = svec[i];
+            if (xml_flag(x, XML_FLAG_DEL)){
+                if (push_edit_add(pp, pb, "delete", x) < 0)
+                    goto done;
+            }
+            else if (xml_flag(x, XML_FLAG_CHANGE))
+                xml_flag_set(x, XML_FLAG_TRANSIENT);
+        }
+        for (i=0; i<tlen; i++){
+            x = tvec[i];
+            if (!xml_flag(x, XML_FLAG_ADD) && xml_flag(x, XML_FLAG_CHANGE))
+                xml_flag_set(x, XML_FLAG_TRANSIENT);
+        }
+    }
+    for (i=0; i<(size_t)td->td_dlen; i++)
+        if (push_marked(td->td_dvec[i]) &&
+            push_edit_add(pp, pb, "delete", td->td_dvec[i]) < 0)
+            goto done;
+    for (i=0; i<(size_t)td->td_clen; i++)
+        if (push_marked(td->td_tcvec[i]) &&
+            push_edit_add(pp, pb, "replace", td->td_tcvec[i]) < 0)
+            goto done;
+    for (i=0; i<tlen; i++)
+        if (xml_flag(tvec[i], XML_FLAG_ADD) &&
+            push_edit_add(pp, pb, "create", tvec[i]) < 0)
+            goto done;
+    for (i=0; i<(size_t)td->td_alen; i++)
+        if (push_marked(td->td_avec[i]) &&
+            push_edit_add(pp, pb, "create", td->td_avec[i]) < 0)
+            goto done;
+    retval = 0;
+ done:
+    xml_flag_reset(td->td_src, XML_FLAG_TRANSIENT);
+    xml_flag_reset(td->td_target, XML_FLAG_TRANSIENT);
+    for (i=0; i<slen; i++)
+        xml_flag_reset(svec[i], XML_FLAG_TRANSIENT);
+    for (i=0; i<tlen; i++)
+        xml_flag_reset(tvec[i], XML_FLAG_TRANSIENT);
+    if (svec)
+        free(svec);
+    if (tvec)
+        free(tvec);
+    if (pb)
+        api_path_builder_free(pb);
+    return retval;
+}
+
+/*! Get pending patch of a filter, create if not found
+ *
+ * @param[in]  ps     On-change push state
+ * @param[in]  xpath  Filter, "" if none
+ * @retval     pp     Pending patch
+ * @retval     NULL   Error
+ */
+static struct push_patch *
+push_patch_get(struct push_state *ps,
+               const char        *xpath)
+{
+    struct push_patch *pp;
+    cxobj             *xd;
+    char               id[32];
+
+    if ((pp = ps->ps_patches) != NULL)
+        do {
+            if (strcmp(pp->pp_xpath, xpath) == 0)
+                return pp;
+            pp = NEXTQ(struct push_patch *, pp);
+        } while (pp && pp != ps->ps_patches);
+    if ((pp = calloc(1, sizeof(*pp))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    if ((pp->pp_xpath = strdup(xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto err;
+    }
+    if ((pp->pp_xn = xml_new("push-change-update", NULL, CX_ELMNT)) == NULL)
+        goto err;
+    if (xmlns_set(pp->pp_xn, NULL, YANG_PUSH_NAMESPACE) < 0)
+        goto err;
+    if ((xd = xml_new("datastore-changes", pp->pp_xn, CX_ELMNT)) == NULL)
+        goto err;
+    if ((pp->pp_xpatch = xml_new("yang-patch", xd, CX_ELMNT)) == NULL)
+        goto err;
+    snprintf(id, sizeof(id), "%" PRIu64, ps->ps_patch_id++);
+    if (xml_new_body("patch-id", pp->pp_xpatch, id) == NULL)
+        goto err;
+    ADDQ(pp, ps->ps_patches);
+    return pp;
+ err:
+    if (pp->pp_xn)
+        xml_free(pp->pp_xn);
+    if (pp->pp_xpath)
+        free(pp->pp_xpath);
+    free(pp);
+    return NULL;
+}
+
+/*! Send pending patches with edits to the subscriptions of their filters, and free them
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  ps    On-change push state
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+push_send(clixon_handle      h,
+          struct push_state *ps)
+{
+    int                retval = -1;
+    struct push_patch *pp;
+
+    while ((pp = ps->ps_patches) != NULL){
+        DELQ(pp, ps->ps_patches, struct push_patch *);
+        if (pp->pp_nr &&
+            stream_notify_xml_selector(h, ps->ps_stream, pp->pp_xpath, pp->pp_xn) < 0)
+            goto done;
+        xml_free(pp->pp_xn);
+        free(pp->pp_xpath);
+        free(pp);
+    }
+    gettimeofday(&ps->ps_last, NULL);
+    retval = 0;
+ done:
+    if (retval < 0 && pp){
+        xml_free(pp->pp_xn);
+        free(pp->pp_xpath);
+        free(pp);
+    }
+    return retval;
+}
+
+/*! Dampening period has passed, send pending patches
+ *
+ * @param[in]  fd    Not used
+ * @param[in]  arg   Clixon handle
+ */
+static int
+push_timeout(int   fd,
+             void *arg)
+{
+    clixon_handle      h = (clixon_handle)arg;
+    struct push_state *ps = NULL;
+
+    if (clicon_ptr_get(h, "on-change-push", (void**)&ps) < 0 || ps == NULL)
+        return 0;
+    ps->ps_timer = 0;
+    return push_send(h, ps);
+}
+
+/*! Push changes of a commit to subscriptions of the on-change stream
+ *
+ * Called after the commit_done callbacks of a commit, while the source tree of the
+ * transaction is still valid.
+ * @param[in]  h     Clixon handle
+ * @param[in]  td    Transaction data
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see CLICON_STREAM_ON_CHANGE
+ */
+int
+backend_push_commit(clixon_handle       h,
+                    transaction_data_t *td)
+{
+    int                         retval = -1;
+    struct push_state          *ps = NULL;
+    struct push_patch          *pp;
+    event_stream_t             *es;
+    struct stream_subscription *ss;
+    struct timeval              now;
+    struct timeval              t;
+    int                         nr = 0;
+
+    if (clicon_ptr_get(h, "on-change-push", (void**)&ps) < 0 || ps == NULL)
+        goto ok;
+    if ((es = stream_find(h, ps->ps_stream)) == NULL ||
+        (ss = es->es_subscription) == NULL ||
+        td->td_src == NULL || td->td_target == NULL)
+        goto ok;
+    ps->ps_commit++;
+    do {
+        if ((pp = push_patch_get(ps, ss->ss_xpath ? ss->ss_xpath : "")) == NULL)
+            goto done;
+        if (pp->pp_commit != ps->ps_commit){
+            pp->pp_commit = ps->ps_commit;
+            if (push_filter_edits(td, pp) < 0)
+                goto done;
+        }
+        nr += pp->pp_nr;
+        ss = NEXTQ(struct stream_subscription *, ss);
+    } while (ss != es->es_subscription);
+    if (nr == 0 || ps->ps_timer)
+        goto ok;
+    gettimeofday(&now, NULL);
+    t.tv_sec = ps->ps_dampening / 1000;
+    t.tv_usec = (ps->ps_dampening % 1000) * 1000;
+    timeradd(&ps->ps_last, &t, &t);
+    if (ps->ps_dampening == 0 || timercmp(&t, &now, <=)){
+        if (push_send(h, ps) < 0)
+            goto done;
+    }
+    else {
+        if (clixon_event_reg_timeout(t, push_timeout, h, "on-change dampening") < 0)
+            goto done;
+        ps->ps_timer = 1;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Create on-change stream if CLICON_STREAM_ON_CHANGE is set
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see backend_push_exit
+ */
+int
+backend_push_init(clixon_handle h)
+{
+    int                retval = -1;
+    struct push_state *ps = NULL;
+    char              *name;
+
+    if ((name = clicon_option_str(h, "CLICON_STREAM_ON_CHANGE")) == NULL ||
+        strlen(name) == 0)
+        goto ok;
+    if (stream_add(h, name, "On-change datastore changes", 0, NULL) < 0)
+        goto done;
+    if ((ps = calloc(1, sizeof(*ps))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((ps->ps_stream = strdup(name)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (clicon_option_exists(h, "CLICON_STREAM_ON_CHANGE_DAMPENING"))
+        ps->ps_dampening = clicon_option_int(h, "CLICON_STREAM_ON_CHANGE_DAMPENING");
+    if (clicon_ptr_set(h, "on-change-push", ps) < 0)
+        goto done;
+    ps = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (ps){
+        if (ps->ps_stream)
+            free(ps->ps_stream);
+        free(ps);
+    }
+    return retval;
+}
+
+/*! Free on-change push state, pending patches are dropped
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ */
+int
+backend_push_exit(clixon_handle h)
+{
+    struct push_state *ps = NULL;
+    struct push_patch *pp;
+
+    if (clicon_ptr_get(h, "on-change-push", (void**)&ps) < 0 || ps == NULL)
+        return 0;
+    if (ps->ps_timer)
+        clixon_event_unreg_timeout(push_timeout, h);
+    while ((pp = ps->ps_patches) != NULL){
+        DELQ(pp, ps->ps_patches, struct push_patch *);
+        xml_free(pp->pp_xn);
+        free(pp->pp_xpath);
+        free(pp);
+    }
+    free(ps->ps_stream);
+    free(ps);
+    clicon_ptr_del(h, "on-change-push");
+    return 0;
+}
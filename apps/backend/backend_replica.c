@@ -0,0 +1,695 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Active/standby replication of running, see CLICON_BACKEND_REPLICA
+ *
+ * After a commit, the active backend translates the diff of the transaction (td_dvec,
+ * td_tcvec, td_avec) to an edit with nc:operation attributes and sends it in a clixon-lib
+ * replicate rpc over the internal protocol to the standby backend. The standby applies the
+ * edit to its running and candidate caches.
+ * Each delta has a sequence number. The first commit after start or after a lost connection,
+ * and a delta rejected by the standby, is sent as a full copy of running instead.
+ * The commit does not wait for the standby: messages are queued on the socket and replies are
+ * received from the event loop. A standby that does not reply within REPLICA_TIMEOUT_MS is
+ * disconnected.
+ * Replication errors are logged but do not fail the commit of the active backend.
+ * Only a backend with CLICON_BACKEND_STANDBY set accepts the replicate rpc.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_transaction.h"
+#include "clixon_backend_plugin.h"
+#include "backend_replica.h"
+
+/* Max time in ms to wait for a reply from the standby before the connection is closed */
+#define REPLICA_TIMEOUT_MS 10000
+
+/*
+ * Local types
+ */
+/* Replication state, see CLICON_BACKEND_REPLICA and CLICON_BACKEND_STANDBY */
+struct replica_state {
+    clixon_handle    rs_h;       /* Clixon handle */
+    char            *rs_addr;    /* Active: address of standby backend, NULL on standby */
+    int              rs_s;       /* Active: socket to standby, -1 if not connected */
+    clixon_msg_pipe *rs_pipe;    /* Active: receive state of replies from standby */
+    int              rs_pending; /* Active: messages sent without reply */
+    int              rs_sync;    /* Active: standby is in sync, deltas can be sent */
+    uint64_t         rs_seq;     /* Sequence number of last delta sent (active) or applied (standby) */
+};
+
+static int replica_reply(int s, void *arg);
+static int replica_timeout(int fd, void *arg);
+
+/*! Add a changed node to the replication edit
+ *
+ * A deleted node is added with its keys and operation remove. An added subtree or changed
+ * leaf is copied under its ancestors with operation replace.
+ * @param[in]  yspec    Yang spec
+ * @param[in]  xconfig  Edit, top-level <config>
+ * @param[in]  pb       Api-path builder
+ * @param[in]  x        Changed node, in source tree for remove, in target tree otherwise
+ * @param[in]  op       OP_REMOVE or OP_REPLACE
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+replica_edit_add(yang_stmt          *yspec,
+                 cxobj              *xconfig,
+                 api_path_builder   *pb,
+                 cxobj              *x,
+                 enum operation_type op)
+{
+    int        retval = -1;
+    cxobj     *xp;
+    cxobj     *xbot = xconfig;
+    cxobj     *xc;
+    cxobj     *xerr = NULL;
+    yang_stmt *y = NULL;
+    char      *path;
+    char      *prefix;
+    char      *ns = NULL;
+    char      *ns1 = NULL;
+    int        ret;
+
+    xp = op == OP_REMOVE ? x : xml_parent(x);
+    if (xp != NULL && xml_parent(xp) != NULL){
+        if (api_path_builder_path(pb, xp, &path) < 0)
+            goto done;
+        if ((ret = api_path2xml(path, yspec, xconfig, YC_DATANODE, 1, &xbot, &y, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err(OE_XML, EINVAL, "Invalid api-path %s", path);
+            goto done;
+        }
+    }
+    if (op == OP_REPLACE){
+        if ((xc = xml_dup(x)) == NULL)
+            goto done;
+        if (xml_addsub(xbot, xc) < 0)
+            goto done;
+        /* The copy is out of its ancestors namespace context */
+        prefix = xml_prefix(x);
+        if (xml2ns(x, prefix, &ns) < 0)
+            goto done;
+        if (xml2ns(xc, prefix, &ns1) < 0)
+            goto done;
+        if (ns && ns1 == NULL && xmlns_set(xc, prefix, ns) < 0)
+            goto done;
+        xbot = xc;
+    }
+    if (xml_add_attr(xbot, "operation", xml_operation2str(op), NETCONF_BASE_PREFIX, NULL) == NULL)
+        goto done;
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+/*! Encode the delta of a commit, or all of running, as a replicate rpc
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  td     Transaction data, or NULL if xfull is set
+ * @param[in]  xfull  Running to send as full copy, or NULL for delta of commit
+ * @param[in]  seq    Sequence number
+ * @param[out] cb     Rpc message
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+replica_msg(clixon_handle       h,
+            transaction_data_t *td,
+            cxobj              *xfull,
+            uint64_t            seq,
+            cbuf               *cb)
+{
+    int               retval = -1;
+    yang_stmt        *yspec;
+    cxobj            *xconfig = NULL;
+    cxobj            *x;
+    int               i;
+    api_path_builder *pb = NULL;
+
+    cprintf(cb, "<rpc xmlns=\"%s\" xmlns:%s=\"%s\">",
+            NETCONF_BASE_NAMESPACE, NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    cprintf(cb, "<replicate xmlns=\"%s\">", CLIXON_LIB_NS);
+    cprintf(cb, "<sequence>%" PRIu64 "</sequence>", seq);
+    if (xfull){
+        cprintf(cb, "<full>true</full>");
+        cprintf(cb, "<%s>", NETCONF_INPUT_CONFIG);
+        if (clixon_xml2cbuf1(cb, xfull, 0, 0, NULL, -1, 1, WITHDEFAULTS_EXPLICIT) < 0)
+            goto done;
+        cprintf(cb, "</%s>", NETCONF_INPUT_CONFIG);
+    }
+    else {
+        if ((yspec = clicon_dbspec_yang(h)) == NULL){
+            clixon_err(OE_YANG, ENOENT, "No yang spec");
+            goto done;
+        }
+        if ((xconfig = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+            goto done;
+        if ((pb = api_path_builder_new()) == NULL)
+            goto done;
+        for (i=0; i<td->td_dlen; i++)
+            if (replica_edit_add(yspec, xconfig, pb, td->td_dvec[i], OP_REMOVE) < 0)
+                goto done;
+        for (i=0; i<td->td_clen; i++)
+            if ((x = td->td_tcvec[i]) != NULL &&
+                replica_edit_add(yspec, xconfig, pb, x, OP_REPLACE) < 0)
+                goto done;
+        for (i=0; i<td->td_alen; i++)
+            if (replica_edit_add(yspec, xconfig, pb, td->td_avec[i], OP_REPLACE) < 0)
+                goto done;
+        if (clixon_xml2cbuf1(cb, xconfig, 0, 0, NULL, -1, 0, WITHDEFAULTS_EXPLICIT) < 0)
+            goto done;
+    }
+    cprintf(cb, "</replicate></rpc>");
+    retval = 0;
+ done:
+    if (xconfig)
+        xml_free(xconfig);
+    if (pb)
+        api_path_builder_free(pb);
+    return retval;
+}
+
+/*! Close connection to standby, replies not yet received are dropped
+ *
+ * The standby is resynced with a full copy of running when connected again
+ * @param[in]  rs    Replication state
+ */
+static void
+replica_close(struct replica_state *rs)
+{
+    if (rs->rs_s != -1){
+        clixon_event_unreg_fd(rs->rs_s, replica_reply);
+        clixon_msg_outq_free(rs->rs_s);
+        close(rs->rs_s);
+        rs->rs_s = -1;
+    }
+    clixon_event_unreg_timeout(replica_timeout, rs);
+    if (rs->rs_pipe){
+        clixon_msg_pipe_free(rs->rs_pipe);
+        rs->rs_pipe = NULL;
+    }
+    rs->rs_pending = 0;
+    rs->rs_sync = 0;
+}
+
+/*! Restart timeout of the replies awaited from the standby
+ *
+ * @param[in]  rs    Replication state
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+replica_timer(struct replica_state *rs)
+{
+    struct timeval t;
+    struct timeval tt = {REPLICA_TIMEOUT_MS/1000, (REPLICA_TIMEOUT_MS%1000)*1000};
+
+    clixon_event_unreg_timeout(replica_timeout, rs);
+    if (rs->rs_pending == 0)
+        return 0;
+    gettimeofday(&t, NULL);
+    timeradd(&t, &tt, &t);
+    return clixon_event_reg_timeout(t, replica_timeout, rs, "replica reply");
+}
+
+/*! Timer callback: standby has not replied in time, close connection
+ *
+ * @param[in]  fd    Not used
+ * @param[in]  arg   Replication state
+ * @retval     0     OK
+ */
+static int
+replica_timeout(int   fd,
+                void *arg)
+{
+    struct replica_state *rs = (struct replica_state *)arg;
+
+    clixon_log(rs->rs_h, LOG_WARNING, "Replication to standby %s failed: no reply in %d ms",
+               rs->rs_addr, REPLICA_TIMEOUT_MS);
+    replica_close(rs);
+    return 0;
+}
+
+/*! Send a message to the standby backend without waiting for the reply
+ *
+ * Output the standby does not read is queued and written from the event loop. Replies are
+ * received by replica_reply.
+ * @param[in]  rs    Replication state
+ * @param[in]  cb    Message
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+replica_send_msg(struct replica_state *rs,
+                 cbuf                 *cb)
+{
+    if (clixon_msg_send11(rs->rs_s, rs->rs_addr, cb) < 0)
+        return -1;
+    if (rs->rs_pending++ == 0 && replica_timer(rs) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Connect to standby backend and send hello
+ *
+ * The address is a UNIX socket path if it starts with '/', otherwise an IPv4 address with
+ * port CLICON_SOCK_PORT
+ * @param[in]  h     Clixon handle
+ * @param[in]  rs    Replication state
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+replica_connect(clixon_handle         h,
+                struct replica_state *rs)
+{
+    int   retval = -1;
+    int   s = -1;
+    cbuf *cb = NULL;
+
+    if (rs->rs_addr[0] == '/'){
+        if (clixon_rpc_connect_unix(h, rs->rs_addr, &s) < 0)
+            goto done;
+    }
+    else if (clixon_rpc_connect_inet(h, rs->rs_addr, clicon_sock_port(h), &s) < 0)
+        goto done;
+    rs->rs_s = s;
+    /* Commits do not block on a standby that does not read */
+    if (clixon_msg_outq_init(s, 0, NULL, NULL) < 0)
+        goto done;
+    if ((rs->rs_pipe = clixon_msg_pipe_new()) == NULL)
+        goto done;
+    if (clixon_event_reg_fd(s, replica_reply, rs, "replica standby socket") < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<hello xmlns=\"%s\"><capabilities><capability>%s</capability></capabilities></hello>",
+            NETCONF_BASE_NAMESPACE, NETCONF_BASE_CAPABILITY_1_1);
+    if (replica_send_msg(rs, cb) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (retval < 0)
+        replica_close(rs);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Send a delta or full copy of running to the standby
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  rs     Replication state
+ * @param[in]  td     Transaction data, or NULL if xfull is set
+ * @param[in]  xfull  Running to send as full copy, or NULL for delta of commit
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+replica_send(clixon_handle         h,
+             struct replica_state *rs,
+             transaction_data_t   *td,
+             cxobj                *xfull)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (replica_msg(h, td, xfull, rs->rs_seq + 1, cb) < 0)
+        goto done;
+    if (replica_send_msg(rs, cb) < 0)
+        goto done;
+    rs->rs_seq++;
+    rs->rs_sync = 1;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Connect to the standby if not connected and send a full copy of running
+ *
+ * @param[in]  rs    Replication state
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+replica_resync(struct replica_state *rs)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *xerr = NULL;
+    int    ret;
+
+    if ((ret = xmldb_get_cache(rs->rs_h, "running", YB_MODULE, &xt, NULL, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_XML, EINVAL, "Running not bound to yang");
+        goto done;
+    }
+    if (rs->rs_s == -1 && replica_connect(rs->rs_h, rs) < 0)
+        goto done;
+    if (replica_send(rs->rs_h, rs, NULL, xt) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+/*! Receive replies from the standby backend
+ *
+ * A reply with rpc-error means that the standby did not apply a message, eg a delta out of
+ * sequence. The connection is then closed, which drops the replies of messages sent after it,
+ * and the standby is resynced with a full copy of running on a new connection.
+ * Errors are logged and close the connection, they do not terminate the backend.
+ * @param[in]  s     Socket to standby
+ * @param[in]  arg   Replication state
+ * @retval     0     OK
+ */
+static int
+replica_reply(int   s,
+              void *arg)
+{
+    struct replica_state *rs = (struct replica_state *)arg;
+    cbuf                 *cbmsg = NULL;
+    cxobj                *xret = NULL;
+    cxobj                *xerr;
+    int                   eof = 0;
+
+    do {
+        if (clixon_msg_rcv11_pipe(s, rs->rs_addr, rs->rs_pipe, &cbmsg, &eof) < 0)
+            goto fail;
+        if (eof){
+            clixon_log(rs->rs_h, LOG_WARNING, "Standby %s closed connection", rs->rs_addr);
+            replica_close(rs);
+            goto ok;
+        }
+        if (clixon_xml_parse_string(cbuf_get(cbmsg), YB_NONE, NULL, &xret, NULL) < 0)
+            goto fail;
+        if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+            clixon_debug(CLIXON_DBG_BACKEND, "Rejected by standby %s: %s, send running",
+                         rs->rs_addr, xml_find_body(xerr, "error-message"));
+            replica_close(rs);
+            if (replica_resync(rs) < 0)
+                goto fail;
+            goto ok;
+        }
+        rs->rs_pending--;
+        xml_free(xret);
+        xret = NULL;
+        cbuf_free(cbmsg);
+        cbmsg = NULL;
+    } while (clixon_msg_pipe_pending(rs->rs_pipe));
+    if (replica_timer(rs) < 0)
+        goto fail;
+ ok:
+    if (xret)
+        xml_free(xret);
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    return 0;
+ fail:
+    clixon_log(rs->rs_h, LOG_WARNING, "Replication to standby %s failed: %s",
+               rs->rs_addr, clixon_err_reason());
+    clixon_err_reset();
+    replica_close(rs);
+    goto ok;
+}
+
+/*! Replicate the changes of a commit to the standby backend
+ *
+ * Called before candidate is copied to running, while the source tree of the transaction
+ * is still valid. The commit does not wait for the standby: the message is queued, and
+ * the reply is received from the event loop, see replica_reply.
+ * Errors are logged and the standby is resynced on next commit.
+ * @param[in]  h     Clixon handle
+ * @param[in]  td    Transaction data
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see CLICON_BACKEND_REPLICA
+ */
+int
+backend_replica_commit(clixon_handle       h,
+                       transaction_data_t *td)
+{
+    struct replica_state *rs = NULL;
+
+    if (clicon_ptr_get(h, "replica", (void**)&rs) < 0 || rs == NULL || rs->rs_addr == NULL)
+        return 0;
+    if (td->td_src == NULL || td->td_target == NULL)
+        return 0;
+    if (rs->rs_sync && td->td_dlen == 0 && td->td_alen == 0 && td->td_clen == 0)
+        return 0;
+    if (rs->rs_s == -1 && replica_connect(h, rs) < 0)
+        goto fail;
+    if (replica_send(h, rs, td, rs->rs_sync ? NULL : td->td_target) < 0)
+        goto fail;
+    return 0;
+ fail:
+    clixon_log(h, LOG_WARNING, "Replication to standby %s failed: %s",
+               rs->rs_addr, clixon_err_reason());
+    clixon_err_reset();
+    replica_close(rs);
+    return 0;
+}
+
+/*! Apply a delta or full copy of running from the active backend
+ *
+ * A delta is applied to running and to candidate unless candidate is modified.
+ * A delta out of sequence is rejected, the active backend then sends a full copy.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_replicate(clixon_handle h,
+                      cxobj        *xe,
+                      cbuf         *cbret,
+                      void         *arg,
+                      void         *regarg)
+{
+    int                   retval = -1;
+    struct replica_state *rs = NULL;
+    yang_stmt            *yspec;
+    cxobj                *xc;
+    cxobj                *xc1 = NULL;
+    cxobj                *xret = NULL;
+    char                 *str;
+    char                 *reason = NULL;
+    uint64_t              seq = 0;
+    int                   full = 0;
+    int                   candidate;
+    int                   ret;
+
+    if (clicon_ptr_get(h, "replica", (void**)&rs) < 0 || rs == NULL){
+        clixon_err(OE_PROTO, ENOENT, "No replication state");
+        goto done;
+    }
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if ((str = xml_find_body(xe, "sequence")) != NULL &&
+        (ret = parse_uint64(str, &seq, &reason)) <= 0){
+        if (ret < 0){
+            clixon_err(OE_XML, errno, "parse_uint64");
+            goto done;
+        }
+        if (netconf_invalid_value(cbret, "protocol", reason) < 0)
+            goto done;
+        goto ok;
+    }
+    if ((str = xml_find_body(xe, "full")) != NULL && strcmp(str, "true") == 0)
+        full = 1;
+    if (!full && seq != rs->rs_seq + 1){
+        if (netconf_operation_failed(cbret, "application", "Replica out of sequence") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((xc = xml_find_type(xe, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) == NULL){
+        if (netconf_missing_element(cbret, "protocol", NETCONF_INPUT_CONFIG, NULL) < 0)
+            goto done;
+        goto ok;
+    }
+    /* <config> is anydata, bind its children as datastore content */
+    if (xml_spec(xc) != NULL)
+        xml_spec_set(xc, NULL);
+    if ((ret = xml_bind_yang(h, xc, YB_MODULE, yspec, 0, &xret)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_xml2cbuf1(cbret, xret, 0, 0, NULL, -1, 0, 0) < 0)
+            goto done;
+        goto ok;
+    }
+    if (xml_sort_recurse(xc) < 0)
+        goto done;
+    /* Operation attributes are removed by the edit, keep a copy for candidate */
+    candidate = xmldb_modified_get(h, "candidate") == 0;
+    if (candidate && (xc1 = xml_dup(xc)) == NULL)
+        goto done;
+    if ((ret = xmldb_put(h, "running", full?OP_REPLACE:OP_NONE, xc, NULL, cbret)) < 0){
+        if (netconf_operation_failed(cbret, "application", clixon_err_reason()) < 0)
+            goto done;
+        goto ok;
+    }
+    if (ret == 0)
+        goto ok;
+    rs->rs_seq = seq;
+    if (candidate){
+        cbuf_reset(cbret);
+        if ((ret = xmldb_put(h, "candidate", full?OP_REPLACE:OP_NONE, xc1, NULL, cbret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+        xmldb_modified_set(h, "candidate", 0);
+    }
+    cbuf_reset(cbret);
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+ ok:
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    if (xc1)
+        xml_free(xc1);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Init replication state and register replicate rpc on a standby
+ *
+ * A backend is either active, replicating to a standby, or standby, accepting replicate rpcs.
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see backend_replica_exit
+ */
+int
+backend_replica_init(clixon_handle h)
+{
+    int                   retval = -1;
+    struct replica_state *rs = NULL;
+    char                 *addr;
+
+    if ((rs = calloc(1, sizeof(*rs))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    rs->rs_h = h;
+    rs->rs_s = -1;
+    if ((addr = clicon_option_str(h, "CLICON_BACKEND_REPLICA")) != NULL &&
+        strlen(addr) &&
+        (rs->rs_addr = strdup(addr)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (clicon_option_bool(h, "CLICON_BACKEND_STANDBY")){
+        if (rs->rs_addr != NULL){
+            clixon_err(OE_CFG, EINVAL, "CLICON_BACKEND_STANDBY and CLICON_BACKEND_REPLICA are both set");
+            goto done;
+        }
+        if (rpc_callback_register(h, from_client_replicate, NULL,
+                                  CLIXON_LIB_NS, "replicate") < 0)
+            goto done;
+    }
+    if (clicon_ptr_set(h, "replica", rs) < 0)
+        goto done;
+    rs = NULL;
+    retval = 0;
+ done:
+    if (rs){
+        if (rs->rs_addr)
+            free(rs->rs_addr);
+        free(rs);
+    }
+    return retval;
+}
+
+/*! Close connection to standby and free replication state
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ */
+int
+backend_replica_exit(clixon_handle h)
+{
+    struct replica_state *rs = NULL;
+
+    if (clicon_ptr_get(h, "replica", (void**)&rs) < 0 || rs == NULL)
+        return 0;
+    replica_close(rs);
+    if (rs->rs_addr)
+        free(rs->rs_addr);
+    free(rs);
+    clicon_ptr_del(h, "replica");
+    return 0;
+}
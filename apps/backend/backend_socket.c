@@ -237,6 +237,8 @@ backend_accept_client(int   fd,
     socklen_t            len;
     struct client_entry *ce;
     char                *name = NULL;
+    int                  hiwat;
+    int                  coalesce;
 #ifdef HAVE_SO_PEERCRED        /* Linux. */
     socklen_t            clen;
     struct ucred         cr = {0,};
@@ -286,6 +288,16 @@ backend_accept_client(int   fd,
         break;
     }
     ce->ce_s = s;
+    /* Queue replies to a client that does not read, see CLICON_BACKEND_OUTPUT_HIWAT */
+    hiwat = clicon_option_int(h, "CLICON_BACKEND_OUTPUT_HIWAT");
+    /* Write several notifications at once, see CLICON_STREAM_COALESCE_USEC */
+    coalesce = clicon_option_int(h, "CLICON_STREAM_COALESCE_USEC");
+    if (hiwat > 0 || coalesce > 0){
+        if (clixon_msg_outq_init(s, hiwat > 0 ? hiwat : 0, backend_client_outq_resume, h) < 0)
+            goto done;
+        if (coalesce > 0 && clixon_msg_outq_coalesce(s, coalesce) < 0)
+            goto done;
+    }
     /*
      * Register callback for actual data socket
      */
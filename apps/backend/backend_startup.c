@@ -45,6 +45,8 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <signal.h>
 #include <fcntl.h>
 #include <time.h>
@@ -71,6 +73,38 @@
 #include "clixon_backend_commit.h"
 #include "backend_startup.h"
 
+/* Max number of timed startup phases, later phases are not recorded */
+#define STARTUP_TIMING_PHASES 32
+
+/*
+ * Types
+ */
+/*! Time of one plugin callback at startup
+ */
+struct startup_timing_plugin{
+    char       *sp_plugin;   /* Plugin name */
+    const char *sp_callback; /* Callback, eg init, start or reset */
+    uint64_t    sp_usec;     /* Time in micro-seconds */
+};
+
+/*! Time of each backend startup phase and plugin callback
+ *
+ * Phases are consecutive: each phase is the time since the end of the previous phase, so
+ * that the sum of the phases is the total startup time. A phase or plugin callback that
+ * occurs several times, eg startup commit of rollback and failsafe, is summed.
+ */
+struct startup_timing{
+    uint64_t                      st_start;  /* Start of startup, see transaction_clock */
+    uint64_t                      st_mark;   /* End of last phase */
+    uint64_t                      st_usec;   /* Total startup time, set when done */
+    int                           st_done;   /* Startup done, no more phases are recorded */
+    int                           st_nphase;
+    const char                   *st_phase[STARTUP_TIMING_PHASES];
+    uint64_t                      st_phase_usec[STARTUP_TIMING_PHASES];
+    struct startup_timing_plugin *st_plugin; /* Vector of plugin callback times */
+    int                           st_nplugin;
+};
+
 /*! Merge db1 into db2 without commit 
  *
  * @retval    1       Validation OK       
@@ -384,3 +418,178 @@ startup_module_state(clixon_handle h,
     retval = 0;
     goto done;
 }
+
+/*! Start timing of backend startup
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+startup_timing_start(clixon_handle h)
+{
+    struct startup_timing *st;
+
+    if ((st = calloc(1, sizeof(*st))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    st->st_start = st->st_mark = transaction_clock();
+    return clicon_ptr_set(h, "startup-timing", st);
+}
+
+/*! Record end of a startup phase, the time since the end of the previous phase
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  phase  Name of phase, a constant string
+ * @note No-op if timing is not started or startup is done
+ */
+void
+startup_timing_phase(clixon_handle h,
+                     const char   *phase)
+{
+    struct startup_timing *st = NULL;
+    uint64_t               now;
+    int                    i;
+
+    clicon_ptr_get(h, "startup-timing", (void**)&st);
+    if (st == NULL || st->st_done)
+        return;
+    now = transaction_clock();
+    for (i=0; i<st->st_nphase; i++)
+        if (strcmp(st->st_phase[i], phase) == 0)
+            break;
+    if (i == st->st_nphase){
+        if (i >= STARTUP_TIMING_PHASES)
+            return;
+        st->st_phase[i] = phase;
+        st->st_nphase++;
+    }
+    st->st_phase_usec[i] += now - st->st_mark;
+    st->st_mark = now;
+}
+
+/*! Record time of a plugin callback at startup
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  cp       Plugin
+ * @param[in]  callback Name of callback, a constant string
+ * @param[in]  usec     Time of callback in micro-seconds
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+startup_timing_plugin(clixon_handle    h,
+                      clixon_plugin_t *cp,
+                      const char      *callback,
+                      uint64_t         usec)
+{
+    struct startup_timing        *st = NULL;
+    struct startup_timing_plugin *sp;
+    int                           i;
+
+    clicon_ptr_get(h, "startup-timing", (void**)&st);
+    if (st == NULL || st->st_done)
+        return 0;
+    for (i=0; i<st->st_nplugin; i++){
+        sp = &st->st_plugin[i];
+        if (strcmp(sp->sp_callback, callback) == 0 &&
+            strcmp(sp->sp_plugin, clixon_plugin_name_get(cp)) == 0){
+            sp->sp_usec += usec;
+            return 0;
+        }
+    }
+    if ((sp = realloc(st->st_plugin, (st->st_nplugin+1)*sizeof(*sp))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    st->st_plugin = sp;
+    sp = &st->st_plugin[st->st_nplugin];
+    if ((sp->sp_plugin = strdup(clixon_plugin_name_get(cp))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    sp->sp_callback = callback;
+    sp->sp_usec = usec;
+    st->st_nplugin++;
+    return 0;
+}
+
+/*! Startup is done, record total time and log report if requested
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  report If set, log one line per phase and plugin callback
+ */
+void
+startup_timing_done(clixon_handle h,
+                    int           report)
+{
+    struct startup_timing *st = NULL;
+    int                    i;
+
+    clicon_ptr_get(h, "startup-timing", (void**)&st);
+    if (st == NULL || st->st_done)
+        return;
+    st->st_usec = transaction_clock() - st->st_start;
+    st->st_done = 1;
+    if (!report)
+        return;
+    clixon_log(h, LOG_NOTICE, "Startup timing: total %" PRIu64 " us", st->st_usec);
+    for (i=0; i<st->st_nphase; i++)
+        clixon_log(h, LOG_NOTICE, "Startup timing: phase %-16s %10" PRIu64 " us",
+                   st->st_phase[i], st->st_phase_usec[i]);
+    for (i=0; i<st->st_nplugin; i++)
+        clixon_log(h, LOG_NOTICE, "Startup timing: plugin %s %s %" PRIu64 " us",
+                   st->st_plugin[i].sp_plugin, st->st_plugin[i].sp_callback,
+                   st->st_plugin[i].sp_usec);
+}
+
+/*! Print startup timing as XML
+ *
+ * @param[in]  h     Clixon handle
+ * @param[out] cb    CLIgen buffer, <startup-timing> children are appended
+ * @retval     0     OK
+ */
+int
+startup_timing_print(clixon_handle h,
+                     cbuf         *cb)
+{
+    struct startup_timing *st = NULL;
+    int                    i;
+
+    clicon_ptr_get(h, "startup-timing", (void**)&st);
+    if (st == NULL)
+        return 0;
+    cprintf(cb, "<usec>%" PRIu64 "</usec>", st->st_usec);
+    for (i=0; i<st->st_nphase; i++)
+        cprintf(cb, "<phase><name>%s</name><usec>%" PRIu64 "</usec></phase>",
+                st->st_phase[i], st->st_phase_usec[i]);
+    for (i=0; i<st->st_nplugin; i++)
+        cprintf(cb, "<plugin><name>%s</name><callback>%s</callback><usec>%" PRIu64 "</usec></plugin>",
+                st->st_plugin[i].sp_plugin, st->st_plugin[i].sp_callback,
+                st->st_plugin[i].sp_usec);
+    return 0;
+}
+
+/*! Free startup timing
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ */
+int
+startup_timing_free(clixon_handle h)
+{
+    struct startup_timing *st = NULL;
+    int                    i;
+
+    clicon_ptr_get(h, "startup-timing", (void**)&st);
+    if (st != NULL){
+        for (i=0; i<st->st_nplugin; i++)
+            free(st->st_plugin[i].sp_plugin);
+        if (st->st_plugin)
+            free(st->st_plugin);
+        free(st);
+    }
+    clicon_ptr_del(h, "startup-timing");
+    return 0;
+}
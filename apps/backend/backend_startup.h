@@ -44,5 +44,11 @@
 int startup_mode_startup(clixon_handle h, char *db, cbuf *cbret);
 int startup_extraxml(clixon_handle h, char *file, cbuf *cbret);
 int startup_module_state(clixon_handle h, yang_stmt *yspec);
+int  startup_timing_start(clixon_handle h);
+void startup_timing_phase(clixon_handle h, const char *phase);
+int  startup_timing_plugin(clixon_handle h, clixon_plugin_t *cp, const char *callback, uint64_t usec);
+void startup_timing_done(clixon_handle h, int report);
+int  startup_timing_print(clixon_handle h, cbuf *cb);
+int  startup_timing_free(clixon_handle h);
 
 #endif  /* _BACKEND_STARTUP_H_ */
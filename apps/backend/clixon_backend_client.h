@@ -73,6 +73,25 @@ struct client_entry{
     uint32_t              ce_in_bad_rpcs;    /* Not correct <rpc> messages */
     uint32_t              ce_out_rpc_errors; /*  <rpc-error> messages*/
     uint32_t              ce_out_notifications; /* Outgoing notifications */
+    uint32_t              ce_reply_chunks; /* Chunks of current reply already sent */
+    int                   ce_binary;  /* Client accepts binary XML replies, see CLICON_IPC_BINARY */
+    int                   ce_reply_pending; /* Reply of commit is deferred, see transaction_pending */
+    int                   ce_queued;  /* Messages queued while a commit is pending */
+    int                   ce_thread;  /* Reply is sent by a reader thread, socket is not read */
+    int                   ce_rm;      /* Remove client when reader thread is done */
+    clixon_msg_pipe      *ce_pipe;    /* Receive state, client may send several rpcs before reply */
+    int                   ce_outq_full; /* Replies not written, socket is not read */
+    int                   ce_shm;     /* Shared memory transport, 1: expected on socket, 2: active,
+                                         see CLICON_IPC_SHM */
+    int                   ce_shm_efd; /* Signaled on input in shared memory, if active */
+    char                 *ce_candidate; /* Private candidate datastore,
+                                           see CLICON_XMLDB_PRIVATE_CANDIDATE */
+    uint64_t              ce_candidate_gen; /* Generation of running private candidate is based on,
+                                               0 if it has no edits and shares running */
+    cxobj                *ce_candidate_base; /* Held read-only running the private candidate
+                                                is based on, see xmldb_rdonly_hold */
+    cxobj                *ce_monitoring; /* Cached netconf monitoring <session> subtree, see
+                                            backend_monitoring_state_get */
 };
 typedef struct client_entry client_entry;
 
@@ -62,16 +62,28 @@ uint32_t confirmed_commit_session_id_get(clixon_handle h);
 int cancel_rollback_event(clixon_handle h);
 int cancel_confirmed_commit(clixon_handle h);
 int handle_confirmed_commit(clixon_handle h, cxobj *xe, uint32_t myid);
+int confirmed_commit_snapshot(clixon_handle h);
+int confirmed_commit_snapshot_restore(clixon_handle h);
 int do_rollback(clixon_handle h, uint8_t *errs);
 int from_client_cancel_commit(clixon_handle h,  cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_confirmed_commit(clixon_handle h, cxobj *xe, uint32_t myid, cbuf *cbret);
 
+/* backend_private.c */
+struct client_entry;
+int private_candidate_db(clixon_handle h, struct client_entry *ce, char *db, int write, char **dbp);
+int private_candidate_discard(clixon_handle h, struct client_entry *ce);
+int private_candidate_commit(clixon_handle h, struct client_entry *ce, cxobj *xe, cbuf *cbret);
+int private_candidate_free(clixon_handle h, struct client_entry *ce);
+
 /* backend_commit.c */
 int startup_validate(clixon_handle h, char *db, cxobj **xtr, cbuf *cbret);
 int startup_commit(clixon_handle h, char *db, cbuf *cbret);
 int candidate_validate(clixon_handle h, char *db, cbuf *cbret);
 int candidate_commit(clixon_handle h, cxobj *xe, char *db, uint32_t myid,
                      validate_level vlev, cbuf *cbret);
+int candidate_commit_pending(clixon_handle h);
+int commit_timing_print(clixon_handle h, cbuf *cb);
+int commit_timing_free(clixon_handle h);
 int from_client_commit(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_discard_changes(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_validate(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
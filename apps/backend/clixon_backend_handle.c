@@ -90,6 +90,7 @@ struct backend_handle {
     clicon_hash_t       *bh_data;      /* internal clicon data (HDR) */
     clicon_hash_t       *ch_db_elmnt;  /* xml datastore element cache data */
     event_stream_t      *bh_stream;    /* notification streams, see clixon_stream.[ch] */
+    struct clicon_option_slots *bh_optslots; /* pre-resolved options (HDR) */
 
     /* ------ end of common handle ------ */
     struct client_entry *bh_ce_list;   /* The client list */
@@ -205,6 +206,12 @@ backend_client_delete(clixon_handle        h,
                 free(ce->ce_transport);
             if (ce->ce_source_host)
                 free(ce->ce_source_host);
+            if (ce->ce_candidate)
+                free(ce->ce_candidate);
+            if (ce->ce_pipe)
+                clixon_msg_pipe_free(ce->ce_pipe);
+            if (ce->ce_monitoring)
+                xml_free(ce->ce_monitoring);
             ce->ce_next = NULL;
             free(ce);
             break;
@@ -41,6 +41,41 @@
 /*
  * Types
  */
+/*! Timed phases of a commit transaction
+ *
+ * Plugin callback phases are also timed per plugin
+ * @see transaction_phase_str
+ */
+enum transaction_phase {
+    TRANS_PHASE_PERSIST,     /* Write target cache to file */
+    TRANS_PHASE_GET_TARGET,  /* Read target, eg candidate */
+    TRANS_PHASE_GET_SOURCE,  /* Read source, ie running */
+    TRANS_PHASE_DIFF,        /* Compute diff of source and target */
+    TRANS_PHASE_BEGIN,       /* Plugin begin callbacks */
+    TRANS_PHASE_VALIDATE,    /* Generic validation */
+    TRANS_PHASE_PLUGIN_VALIDATE, /* Plugin validate callbacks */
+    TRANS_PHASE_COMPLETE,    /* Plugin complete callbacks */
+    TRANS_PHASE_COMMIT,      /* Plugin commit callbacks, until pending are done */
+    TRANS_PHASE_COMMIT_DONE, /* Plugin commit_done callbacks */
+    TRANS_PHASE_COPY,        /* Copy target to running, cache and file */
+    TRANS_PHASE_END,         /* Plugin end callbacks */
+    TRANS_PHASE_NR           /* Number of phases, also: not timed */
+};
+
+/*! Time of transaction callbacks of one plugin
+ */
+typedef struct {
+    clixon_plugin_t *tt_plugin;
+    uint64_t         tt_usec[TRANS_PHASE_NR]; /* Microseconds per phase */
+} transaction_time_t;
+
+
+/*! Pending commit callback of a plugin, see transaction_pending
+ */
+typedef struct {
+    clixon_plugin_t *tp_plugin;  /* Plugin whose commit is pending */
+    int              tp_status;  /* 0: pending, 1: done, -1: failed */
+} transaction_pending_t;
 
 /*! Transaction data describing a system transition from a src to target state
  *
@@ -52,9 +87,11 @@
  * It is up to the validate callbacks to ensure that these changes are OK
  * It is up to the commit callbacks to enforce these changes in the "state" of 
  * the system.
+ * A plugin that subscribes to subtrees (ca_trans_paths) is given a view of the transaction
+ * with vectors restricted to those subtrees, see transaction_views_compute
  * @see transaction_data in clixon_plugin.h
  */
-typedef struct {
+typedef struct transaction_data_t {
     uint64_t   td_id;       /* Transaction id */
     void      *td_arg;      /* Callback argument */
     cxobj     *td_src;      /* Source database xml tree */
@@ -66,6 +103,21 @@ typedef struct {
     cxobj    **td_scvec;    /* Source changed xml vector */
     cxobj    **td_tcvec;    /* Target changed xml vector */
     int        td_clen;     /* Changed xml vector length */
+    struct transaction_data_t *td_parent;  /* View: the full transaction, else NULL */
+    clixon_plugin_t           *td_plugin;  /* View: plugin of view */
+    struct transaction_data_t **td_views;  /* Views of plugins with ca_trans_paths */
+    int        td_nviews;   /* Length of views vector */
+    int        td_async;    /* Commit callbacks may be pending, see transaction_pending */
+    clixon_plugin_t           *td_current; /* Plugin whose commit callback is called */
+    transaction_pending_t     *td_pendvec; /* Pending commit callbacks */
+    int        td_pendlen;  /* Length of pending vector */
+    int        td_pending;  /* Number of pending commit callbacks not done */
+    int      (*td_pendfn)(clixon_handle h, struct transaction_data_t *td); /* Called when done */
+    uint64_t   td_start;    /* Start time, monotonic microseconds, see transaction_clock */
+    uint64_t   td_clock;    /* End of previous timed phase */
+    uint64_t   td_usec[TRANS_PHASE_NR]; /* Microseconds per phase */
+    transaction_time_t *td_timevec; /* Callback time per plugin */
+    int        td_timelen;  /* Length of callback time vector */
 } transaction_data_t;
 
 /*! Pagination userdata 
@@ -94,6 +146,26 @@ typedef struct {
     cxobj            *pd_xstate;    /* Returned xml state tree */
 } pagination_data_t;
 
+/*! State list producer userdata
+ *
+ * A producer registered with clixon_statelist_cb_register is called repeatedly for the entries
+ * of one operational list. In each call it adds at most sl_batch entries in key order to
+ * sl_xstate, as a tree from the top, eg <rib><route>..</route>..</rib>.
+ * In the first call sl_cursor is NULL and the producer starts at entry sl_offset.
+ * In later calls it continues after sl_cursor, which it sets in each call.
+ * The producer sets sl_end when it has produced the last entry.
+ * @see statelist_data in clixon_plugin.h
+ * @see statelist_offset() and other accessor functions
+ */
+typedef struct {
+    uint32_t          sl_offset;    /* Entries skipped before first entry */
+    uint32_t          sl_batch;     /* Max number of entries per call */
+    char             *sl_cursor;    /* Position after last entry produced, NULL in first call */
+    int               sl_end;       /* Set by producer after last entry */
+    int               sl_locked;    /* Running datastore is locked by this caller */
+    cxobj            *sl_xstate;    /* Tree where entries are added */
+} statelist_data_t;
+
 /*
  * Prototypes
  */
@@ -104,14 +176,23 @@ int clixon_plugin_pre_daemon_all(clixon_handle h);
 int clixon_plugin_daemon_all(clixon_handle h);
 
 int clixon_plugin_statedata_all(clixon_handle h, yang_stmt *yspec, cvec *nsc, char *xpath, cxobj **xtop);
+int clixon_plugin_statedata_invalidate(clixon_handle h, const char *name, const char *xpath);
+int clixon_plugin_statedata_cache_free(clixon_handle h);
 int clixon_plugin_lockdb_all(clixon_handle h, char *db, int lock, int id);
 
 int clixon_pagination_cb_register(clixon_handle h, handler_function fn, char *path, void *arg);
 int clixon_pagination_free(clixon_handle h);
+int clixon_statelist_cb_register(clixon_handle h, handler_function fn, char *xpath, void *arg);
+int clixon_statelist_free(clixon_handle h);
 
 transaction_data_t * transaction_new(void);
 int transaction_free(transaction_data_t *);
 int transaction_free1(transaction_data_t *, int copy);
+int transaction_views_compute(clixon_handle h, transaction_data_t *td);
+uint64_t transaction_clock(void);
+const char *transaction_phase_str(enum transaction_phase tp);
+void transaction_timing_add(transaction_data_t *td, enum transaction_phase tp);
+int transaction_timing_plugin(transaction_data_t *td, clixon_plugin_t *cp, enum transaction_phase tp, uint64_t usec);
 
 int plugin_transaction_begin_one(clixon_plugin_t *cp, clixon_handle h, transaction_data_t *td);
 int plugin_transaction_begin_all(clixon_handle h, transaction_data_t *td);
@@ -125,6 +206,8 @@ int plugin_transaction_complete_all(clixon_handle h, transaction_data_t *td);
 int plugin_transaction_commit_one(clixon_plugin_t *cp, clixon_handle h, transaction_data_t *td);
 int plugin_transaction_commit_all(clixon_handle h, transaction_data_t *td);
 
+int plugin_transaction_pending_end(clixon_handle h, transaction_data_t *td);
+
 int plugin_transaction_commit_done_one(clixon_plugin_t *cp, clixon_handle h, transaction_data_t *td);
 int plugin_transaction_commit_done_all(clixon_handle h, transaction_data_t *td);
 
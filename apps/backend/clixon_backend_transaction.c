@@ -68,6 +68,18 @@
  * For example, adding a database symbol 'a' in candidate and commiting
  * would give running in source and 'a' and candidate in 'target'.
  */
+/*! Get the full transaction of a transaction or of a plugin view of it
+ *
+ * Id, argument and xml trees are shared by the views of a transaction
+ */
+static transaction_data_t *
+transaction_top(transaction_data td)
+{
+    transaction_data_t *td0 = (transaction_data_t *)td;
+
+    return td0->td_parent ? td0->td_parent : td0;
+}
+
 /*! Get transaction id
  *
  * @param[in]  td   transaction_data
@@ -76,7 +88,7 @@
 uint64_t
 transaction_id(transaction_data td)
 {
-    return ((transaction_data_t *)td)->td_id;
+    return transaction_top(td)->td_id;
 }
 
 /*! Get plugin/application specific callback argument
@@ -87,7 +99,7 @@ transaction_id(transaction_data td)
 void *
 transaction_arg(transaction_data td)
 {
-    return ((transaction_data_t *)td)->td_arg;
+    return transaction_top(td)->td_arg;
 }
 
 /*! Set plugin/application specific callback argument
@@ -99,7 +111,7 @@ int
 transaction_arg_set(transaction_data td,
                     void             *arg)
 {
-    ((transaction_data_t *)td)->td_arg = arg;
+    transaction_top(td)->td_arg = arg;
     return 0;
 }
 
@@ -111,7 +123,7 @@ transaction_arg_set(transaction_data td,
 cxobj *
 transaction_src(transaction_data td)
 {
-    return ((transaction_data_t *)td)->td_src;
+    return transaction_top(td)->td_src;
 }
 
 /*! Get target database xml tree
@@ -122,7 +134,7 @@ transaction_src(transaction_data td)
 cxobj *
 transaction_target(transaction_data td)
 {
-    return ((transaction_data_t *)td)->td_target;
+    return transaction_top(td)->td_target;
 }
 
 /*! Get delete xml vector, ie vector of xml nodes that are deleted src->target
@@ -213,6 +225,67 @@ transaction_clen(transaction_data td)
     return ((transaction_data_t *)td)->td_clen;
 }
 
+/*! Make the commit callback of a plugin pending, it is done later with transaction_pending_done
+ *
+ * Call in a transaction_commit callback that has started an operation that completes later,
+ * eg on a socket or timer event. The commit is not terminated and its client not answered
+ * until all pending callbacks are done, while the backend serves other read requests.
+ * Only commits from the commit RPC with CLICON_BACKEND_COMMIT_ASYNC set may be pending
+ * @param[in]  td   transaction_data
+ * @retval     id   Pending id, > 0, to use in transaction_pending_done
+ * @retval     0    Not possible in this transaction, commit synchronously
+ * @retval    -1    Error
+ * @note revert may be called in a plugin whose commit is pending, if another plugin fails
+ */
+int
+transaction_pending(transaction_data td)
+{
+    transaction_data_t    *top = transaction_top(td);
+    transaction_pending_t *vec;
+
+    if (!top->td_async || top->td_current == NULL)
+        return 0;
+    if ((vec = realloc(top->td_pendvec, (top->td_pendlen+1)*sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    top->td_pendvec = vec;
+    vec[top->td_pendlen].tp_plugin = top->td_current;
+    vec[top->td_pendlen].tp_status = 0;
+    top->td_pending++;
+    return ++top->td_pendlen;
+}
+
+/*! A pending commit callback is done
+ *
+ * When the last pending callback is done, the commit is terminated: if any failed, the
+ * commit fails and is reverted, otherwise it continues with commit_done
+ * @param[in]  h      Clixon handle
+ * @param[in]  td     transaction_data
+ * @param[in]  id     Pending id returned by transaction_pending
+ * @param[in]  status 0: OK, -1: Failed, call clixon_err before
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+transaction_pending_done(clixon_handle    h,
+                         transaction_data td,
+                         int              id,
+                         int              status)
+{
+    transaction_data_t *top = transaction_top(td);
+
+    if (id < 1 || id > top->td_pendlen || top->td_pendvec[id-1].tp_status != 0){
+        clixon_err(OE_PLUGIN, EINVAL, "No pending commit with id %d", id);
+        return -1;
+    }
+    top->td_pendvec[id-1].tp_status = status < 0 ? -1 : 1;
+    top->td_pending--;
+    if (top->td_pending == 0 && top->td_pendfn != NULL)
+        return top->td_pendfn(h, top);
+    return 0;
+}
+
 /*! Print info about transaction on FILE, including what has changed
  *
  * @param[in] f   stdio FILE
@@ -413,3 +486,98 @@ pagination_xstate(pagination_data pd)
 {
     return ((pagination_data_t *)pd)->pd_xstate;
 }
+
+/*! Get state list producer data: entries to skip before the first entry
+ *
+ * Only significant in the first call, where cursor is NULL
+ * @param[in]  sd     State list producer userdata
+ * @retval     offset Number of entries to skip
+ */
+uint32_t
+statelist_offset(statelist_data sd)
+{
+    return ((statelist_data_t *)sd)->sl_offset;
+}
+
+/*! Get state list producer data: max number of entries to produce in this call
+ *
+ * @param[in]  sd     State list producer userdata
+ * @retval     batch  Max number of entries
+ */
+uint32_t
+statelist_batch(statelist_data sd)
+{
+    return ((statelist_data_t *)sd)->sl_batch;
+}
+
+/*! Get state list producer data: cursor set by the producer in the previous call
+ *
+ * @param[in]  sd     State list producer userdata
+ * @retval     cursor Position after the last entry produced
+ * @retval     NULL   First call, start at offset
+ */
+const char *
+statelist_cursor(statelist_data sd)
+{
+    return ((statelist_data_t *)sd)->sl_cursor;
+}
+
+/*! Set state list producer data: cursor given to the producer in the next call
+ *
+ * The cursor is opaque to the backend, eg the key of the last entry produced
+ * @param[in]  sd     State list producer userdata
+ * @param[in]  cursor Position after the last entry produced, copied
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+statelist_cursor_set(statelist_data sd,
+                     const char    *cursor)
+{
+    statelist_data_t *sl = (statelist_data_t *)sd;
+    char             *str = NULL;
+
+    if (cursor && (str = strdup(cursor)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    if (sl->sl_cursor)
+        free(sl->sl_cursor);
+    sl->sl_cursor = str;
+    return 0;
+}
+
+/*! Set state list producer data: the last entry is produced
+ *
+ * @param[in]  sd     State list producer userdata
+ * @retval     0      OK
+ */
+int
+statelist_end_set(statelist_data sd)
+{
+    ((statelist_data_t *)sd)->sl_end = 1;
+    return 0;
+}
+
+/*! Get state list producer data: locked parameter
+ *
+ * @param[in]  sd     State list producer userdata
+ * @retval     locked 0: unlocked/stateless 1: running locked by this caller
+ * @see pagination_locked
+ */
+int
+statelist_locked(statelist_data sd)
+{
+    return ((statelist_data_t *)sd)->sl_locked;
+}
+
+/*! Get state list producer data: tree where entries are added
+ *
+ * @param[in]  sd     State list producer userdata
+ * @retval     xstate XML state tree, empty top on each call
+ */
+cxobj*
+statelist_xstate(statelist_data sd)
+{
+    return ((statelist_data_t *)sd)->sl_xstate;
+}
@@ -60,6 +60,8 @@ size_t  transaction_alen(transaction_data td);
 cxobj **transaction_scvec(transaction_data td);
 cxobj **transaction_tcvec(transaction_data td);
 size_t  transaction_clen(transaction_data td);
+int     transaction_pending(transaction_data td);
+int     transaction_pending_done(clixon_handle h, transaction_data td, int id, int status);
 
 int transaction_print(FILE *f, transaction_data th);
 int transaction_dbg(clixon_handle h, int dbglevel, transaction_data th, const char *msg);
@@ -73,4 +75,15 @@ uint32_t pagination_limit(pagination_data pd);
 int      pagination_locked(pagination_data pd);
 cxobj   *pagination_xstate(pagination_data pd);
 
+/* State list producer callbacks
+ * @see statelist_data_t  internal structure
+ */
+uint32_t    statelist_offset(statelist_data sd);
+uint32_t    statelist_batch(statelist_data sd);
+const char *statelist_cursor(statelist_data sd);
+int         statelist_cursor_set(statelist_data sd, const char *cursor);
+int         statelist_end_set(statelist_data sd);
+int         statelist_locked(statelist_data sd);
+cxobj      *statelist_xstate(statelist_data sd);
+
 #endif /* _CLIXON_BACKEND_TRANSACTION_H_ */
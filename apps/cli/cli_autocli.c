@@ -444,6 +444,49 @@ autocli_grouping_treeref(clixon_handle h,
     return retval;
 }
 
+/*! Return autocli module treeref option
+ *
+ * When true, sub-statements of top-level containers and lists are generated on demand
+ * @param[in]  h          Clixon handle
+ * @param[out] treeref    Top-level nodes using treerefs enabled
+ * @retval     0          OK
+ * @retval    -1          Error
+ */
+int
+autocli_module_treeref(clixon_handle h,
+                       int          *treeref)
+{
+    int     retval = -1;
+    char   *str;
+    uint8_t val;
+    char   *reason = NULL;
+    int     ret;
+    cxobj  *xautocli;
+
+    if (treeref == NULL){
+        clixon_err(OE_YANG, EINVAL, "Argument is NULL");
+        goto done;
+    }
+    if ((xautocli = clicon_conf_autocli(h)) == NULL){
+        clixon_err(OE_YANG, 0, "No clixon-autocli");
+        goto done;
+    }
+    if ((str = xml_find_body(xautocli, "module-treeref")) == NULL){
+        clixon_err(OE_XML, EINVAL, "No module-treeref rule");
+        goto done;
+    }
+    if ((ret = parse_bool(str, &val, &reason)) < 0){
+        clixon_err(OE_CFG, errno, "parse_bool");
+        goto done;
+    }
+    *treeref = val;
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    return retval;
+}
+
 /*! Return default autocli list keyword setting
  *
  * Currently only returns list-keyword-default, could be extended to rules
@@ -64,6 +64,7 @@ typedef enum autocli_cache autocli_cache_t;
 int autocli_module(clixon_handle h, char *modname, int *enable);
 int autocli_completion(clixon_handle h, int *completion);
 int autocli_grouping_treeref(clixon_handle h, int *grouping_treeref);
+int autocli_module_treeref(clixon_handle h, int *module_treeref);
 int autocli_list_keyword(clixon_handle h, autocli_listkw_t *listkw);
 int autocli_compress(clixon_handle h, yang_stmt *ys, int *compress);
 int autocli_treeref_state(clixon_handle h, int *treeref_state);
@@ -364,6 +364,272 @@ mtpoint_paths(yang_stmt *yspec0,
     return retval;
 }
 
+/*! Batch of CLI edits sent to the backend in one edit-config
+ *
+ * Used when the CLI reads commands from a script, see CLICON_CLI_BATCH_EDITS
+ */
+struct cli_edit_batch {
+    cxobj         *eb_xconfig;  /* Accumulated edits, top-level <config> */
+    clicon_hash_t *eb_paths;    /* api-path of each edit, value is its operation */
+    clicon_hash_t *eb_prefixes; /* api-path of each edit and of all its ancestors */
+    uint32_t       eb_nr;       /* Nr of edits in batch */
+};
+
+/* Callbacks whose edits are batched, any other callback flushes the batch first */
+static const char *cli_edit_batch_fns[] = {
+    "cli_set",
+    "cli_merge",
+    "cli_create",
+    "cli_remove",
+    "cli_del",
+    "cli_auto_set",
+    "cli_auto_merge",
+    "cli_auto_create",
+    "cli_auto_del",
+    "cli_auto_edit",
+    "cli_auto_up",
+    "cli_auto_top",
+    NULL
+};
+
+/*! Empty edit batch
+ *
+ * @param[in]  eb   Edit batch
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+cli_edit_batch_reset(struct cli_edit_batch *eb)
+{
+    if (eb->eb_xconfig)
+        xml_free(eb->eb_xconfig);
+    if (eb->eb_paths)
+        clicon_hash_free(eb->eb_paths);
+    if (eb->eb_prefixes)
+        clicon_hash_free(eb->eb_prefixes);
+    eb->eb_nr = 0;
+    if ((eb->eb_xconfig = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+        return -1;
+    if ((eb->eb_paths = clicon_hash_init()) == NULL)
+        return -1;
+    if ((eb->eb_prefixes = clicon_hash_init()) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Start batching CLI edits if enabled
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see CLICON_CLI_BATCH_EDITS
+ */
+int
+cli_edit_batch_init(clixon_handle h)
+{
+    struct cli_edit_batch *eb = NULL;
+
+    if (clicon_option_int(h, "CLICON_CLI_BATCH_EDITS") == 0)
+        return 0;
+    if ((eb = calloc(1, sizeof(*eb))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    if (cli_edit_batch_reset(eb) < 0)
+        return -1;
+    clicon_ptr_set(h, "cli-edit-batch", eb);
+    return 0;
+}
+
+/*! Send batched CLI edits to the backend in one edit-config
+ *
+ * The batch is emptied also on error
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK, or no batch
+ * @retval    -1    Error
+ */
+int
+cli_edit_batch_flush(clixon_handle h)
+{
+    int                    retval = -1;
+    struct cli_edit_batch *eb = NULL;
+    cbuf                  *cb = NULL;
+
+    if (clicon_ptr_get(h, "cli-edit-batch", (void**)&eb) < 0 || eb == NULL || eb->eb_nr == 0)
+        return 0;
+    clixon_debug(CLIXON_DBG_CLI, "edits:%u", eb->eb_nr);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, eb->eb_xconfig, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if (cli_edit_batch_reset(eb) < 0)
+        goto done;
+    if (clicon_rpc_edit_config(h, "candidate", OP_NONE, cbuf_get(cb)) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Stop batching CLI edits, unsent edits are discarded
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+cli_edit_batch_exit(clixon_handle h)
+{
+    struct cli_edit_batch *eb = NULL;
+
+    if (clicon_ptr_get(h, "cli-edit-batch", (void**)&eb) == 0 && eb){
+        if (eb->eb_xconfig)
+            xml_free(eb->eb_xconfig);
+        if (eb->eb_paths)
+            clicon_hash_free(eb->eb_paths);
+        if (eb->eb_prefixes)
+            clicon_hash_free(eb->eb_prefixes);
+        free(eb);
+        clicon_ptr_del(h, "cli-edit-batch");
+    }
+    return 0;
+}
+
+/*! Check if an edit must not be merged with earlier edits in the batch
+ *
+ * Edits are merged into one tree, where only the operation of a new node is kept. An edit
+ * whose target is the same as, an ancestor of, or a descendant of an earlier target
+ * may therefore have another result than when applied in sequence. Exceptions are
+ * merge/replace of the same leaf, and merge/replace below an earlier merge/replace.
+ * @param[in]  eb       Edit batch
+ * @param[in]  api_path api-path of edit target
+ * @param[in]  op       Operation of edit
+ * @param[in]  leaf     Edit target is a leaf
+ * @retval     1        Conflict, flush batch before adding edit
+ * @retval     0        No conflict
+ */
+static int
+cli_edit_batch_conflict(struct cli_edit_batch *eb,
+                        char                  *api_path,
+                        enum operation_type    op,
+                        int                    leaf)
+{
+    int    setop = (op == OP_MERGE || op == OP_REPLACE);
+    int   *op0;
+    size_t vlen;
+    char  *p;
+
+    if (clicon_hash_lookup(eb->eb_prefixes, api_path) != NULL){
+        if ((op0 = clicon_hash_value(eb->eb_paths, api_path, &vlen)) == NULL)
+            return 1; /* Ancestor of earlier target */
+        if (!leaf || !setop || (*op0 != OP_MERGE && *op0 != OP_REPLACE))
+            return 1;
+        return 0;
+    }
+    /* Descendant of earlier target */
+    for (p = api_path + 1; (p = strchr(p, '/')) != NULL; p++){
+        *p = '\0';
+        op0 = clicon_hash_value(eb->eb_paths, api_path, &vlen);
+        *p = '/';
+        if (op0 && (!setop || (*op0 != OP_MERGE && *op0 != OP_REPLACE)))
+            return 1;
+    }
+    return 0;
+}
+
+/*! Add edit to batch, flush before on conflict and after when the batch is full
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  eb       Edit batch
+ * @param[in]  api_path api-path of edit target
+ * @param[in]  op       Operation of edit
+ * @param[in]  leaf     Edit target is a leaf
+ * @param[in]  xtop     Edit as top-level <config> tree, children are moved to the batch
+ * @param[in]  yspec    Top-level yang spec
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+cli_edit_batch_add(clixon_handle          h,
+                   struct cli_edit_batch *eb,
+                   char                  *api_path,
+                   enum operation_type    op,
+                   int                    leaf,
+                   cxobj                 *xtop,
+                   yang_stmt             *yspec)
+{
+    int    retval = -1;
+    char  *reason = NULL;
+    char  *p;
+    int    opi = op;
+    int    ret;
+    clicon_hash_t hp;
+
+    if (cli_edit_batch_conflict(eb, api_path, op, leaf) &&
+        cli_edit_batch_flush(h) < 0)
+        goto done;
+    if ((ret = xml_merge(eb->eb_xconfig, xtop, yspec, &reason)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_CFG, EINVAL, "%s", reason);
+        goto done;
+    }
+    if (clicon_hash_add(eb->eb_paths, api_path, &opi, sizeof(opi)) == NULL)
+        goto done;
+    if (clicon_hash_add(eb->eb_prefixes, api_path, NULL, 0) == NULL)
+        goto done;
+    for (p = api_path + 1; (p = strchr(p, '/')) != NULL; p++){
+        *p = '\0';
+        hp = clicon_hash_add(eb->eb_prefixes, api_path, NULL, 0);
+        *p = '/';
+        if (hp == NULL)
+            goto done;
+    }
+    if (++eb->eb_nr >= clicon_option_int(h, "CLICON_CLI_BATCH_EDITS") &&
+        cli_edit_batch_flush(h) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    return retval;
+}
+
+/*! CLIgen callback wrapper: flush batched edits before a callback that is not an edit
+ *
+ * Called before and after each CLI callback
+ * @param[in]     arg   Clixon handle
+ * @param[in,out] wh    Wrapper handle, NULL before callback
+ * @param[in]     name  Command name
+ * @param[in]     fn    Callback function name
+ * @retval        1     OK
+ * @retval        0     Fail
+ * @retval       -1     Error
+ * @see clixon_resource_check
+ */
+int
+cli_eval_wrap(void       *arg,
+              void      **wh,
+              const char *name,
+              const char *fn)
+{
+    clixon_handle h = (clixon_handle)arg;
+    int           i;
+
+    if (wh && *wh == NULL && fn){
+        for (i = 0; cli_edit_batch_fns[i]; i++)
+            if (strcmp(fn, cli_edit_batch_fns[i]) == 0)
+                break;
+        if (cli_edit_batch_fns[i] == NULL &&
+            cli_edit_batch_flush(h) < 0)
+            return -1;
+    }
+    return clixon_resource_check(h, wh, name, fn);
+}
+
 /*! Modify xml datastore from a callback using xml key format strings
  *
  * @param[in]  h     Clixon handle
@@ -414,6 +680,7 @@ cli_dbxml(clixon_handle       h,
     char      *mtpoint = NULL;
     yang_stmt *yspec0 = NULL;
     int        argc = 0;
+    struct cli_edit_batch *eb = NULL;
 
     /* Top-level yspec */
     if ((yspec0 = clicon_dbspec_yang(h)) == NULL){
@@ -499,6 +766,13 @@ cli_dbxml(clixon_handle       h,
      */
     if ((ret = xml_apply0(xbot, CX_ELMNT, identityref_add_ns, yspec0)) < 0)
         goto done;
+    /* Batch edits from script, not edits of mounted data */
+    if (api_path && mtpoint == NULL &&
+        clicon_ptr_get(h, "cli-edit-batch", (void**)&eb) == 0 && eb){
+        if (cli_edit_batch_add(h, eb, api_path, op, yang_keyword_get(y) == Y_LEAF, xtop, yspec0) < 0)
+            goto done;
+        goto ok;
+    }
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
@@ -507,6 +781,7 @@ cli_dbxml(clixon_handle       h,
         goto done;
     if (clicon_rpc_edit_config(h, "candidate", OP_NONE, cbuf_get(cb)) < 0)
         goto done;
+ ok:
     retval = 0;
  done:
     if (api_path_fmt_cb)
@@ -860,6 +1135,7 @@ cli_validate(clixon_handle h,
  * @retval     0      OK
  * @retval    -1      Error
  * @note JSON and CLI are NYI
+ * XML and TEXT diffs are computed in the backend, see clicon_rpc_datastore_diff
  */
 int
 compare_db_names(clixon_handle    h,
@@ -873,6 +1149,17 @@ compare_db_names(clixon_handle    h,
     cxobj *xerr = NULL;
     cbuf  *cb = NULL;
 
+    if (format == FORMAT_XML || format == FORMAT_TEXT){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (clicon_rpc_datastore_diff(h, db1, db2, format == FORMAT_XML ? "xml" : "text", cb) < 0)
+            goto done;
+        cligen_output(stdout, "%s", cbuf_get(cb));
+        retval = 0;
+        goto done;
+    }
     if (clicon_rpc_get_config(h, NULL, db1, "/", NULL, NULL, &xc1) < 0)
         goto done;
     if ((xerr = xpath_first(xc1, NULL, "/rpc-error")) != NULL){
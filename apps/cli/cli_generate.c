@@ -91,6 +91,7 @@ You can see which CLISPEC it generates via clixon_cli -D 2:
 #include <syslog.h>
 #include <signal.h>
 #include <wordexp.h>
+#include <inttypes.h>
 #include <sys/param.h>
 #include <sys/stat.h>
 
@@ -1092,6 +1093,57 @@ yang2cli_leaf(clixon_handle h,
     return retval;
 }
 
+/*! Generate treeref to the sub-statements of a top-level container or list
+ *
+ * If autocli module-treeref, the sub-statements are generated when first referenced,
+ * see yang2cli_grouping_wrap
+ * @param[in]  h     Clixon handle
+ * @param[in]  ys    Yang container or list statement
+ * @param[in]  level Indentation level
+ * @param[out] cb    Buffer where cligen code is written
+ * @retval     1     Treeref generated
+ * @retval     0     Not top-level or module-treeref not set, generate sub-statements
+ * @retval    -1     Error
+ */
+static int
+yang2cli_module_treeref(clixon_handle h,
+                        yang_stmt    *ys,
+                        int           level,
+                        cbuf         *cb)
+{
+    int            retval = -1;
+    int            module_treeref = 0;
+    enum rfc_6020  keyw;
+    cbuf          *cbtree = NULL;
+
+    keyw = yang_keyword_get(yang_parent_get(ys));
+    if (keyw != Y_MODULE && keyw != Y_SUBMODULE)
+        goto skip;
+    if (autocli_module_treeref(h, &module_treeref) < 0)
+        goto done;
+    if (!module_treeref)
+        goto skip;
+    if ((cbtree = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (yang2cli_cmd_encode(cbtree, AUTOCLI_CMD_DELIM, "module",
+                            yang_argument_get(ys_domain(ys)),
+                            yang_argument_get(ys_spec(ys)),
+                            yang_argument_get(ys_module(ys)),
+                            yang_argument_get(ys)) < 0)
+        goto done;
+    cprintf(cb, "%*s@%s;\n", level*3, "", cbuf_get(cbtree));
+    retval = 1;
+ done:
+    if (cbtree)
+        cbuf_free(cbtree);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
 /*! Generate CLI code for Yang container statement
  *
  * @param[in]  h     Clixon handle
@@ -1154,10 +1206,16 @@ yang2cli_container(clixon_handle h,
             cprintf(cb, "%*s%s", (level+1)*3, "", "@mountpoint;\n");
         }
     }
-    inext = 0;
-    while ((yc = yn_iter(ys, &inext)) != NULL)
-        if (yang2cli_stmt(h, yc, level+1, cb) < 0)
-            goto done;
+    ret = 0;
+    if (!compress &&
+        (ret = yang2cli_module_treeref(h, ys, level+1, cb)) < 0)
+        goto done;
+    if (ret == 0){
+        inext = 0;
+        while ((yc = yn_iter(ys, &inext)) != NULL)
+            if (yang2cli_stmt(h, yc, level+1, cb) < 0)
+                goto done;
+    }
     if (!compress)
         cprintf(cb, "%*s}\n", level*3, "");
     retval = 0;
@@ -1195,6 +1253,7 @@ yang2cli_list(clixon_handle h,
     int           exist = 0;
     int           keynr = 0;
     int           inext;
+    int           ret;
 
     cprintf(cb, "%*s%s", level*3, "", yang_argument_get(ys));
     if ((yd = yang_find(ys, Y_DESCRIPTION, NULL)) != NULL){
@@ -1243,8 +1302,10 @@ yang2cli_list(clixon_handle h,
         keynr++;
     }
     cprintf(cb, "{\n");
+    if ((ret = yang2cli_module_treeref(h, ys, level+1, cb)) < 0)
+        goto done;
     inext = 0;
-    while ((yc = yn_iter(ys, &inext)) != NULL) {
+    while (ret == 0 && (yc = yn_iter(ys, &inext)) != NULL) {
         /*  cvk is a cvec of strings containing variable names
             yc is a leaf that may match one of the values of cvk.
         */
@@ -1674,15 +1735,127 @@ ph_add_set(cligen_handle h,
     return retval;
 }
 
+/*! Compute autocli cache key of the module-set and autocli config
+ *
+ * A cached clispec of a module also depends on other modules (eg augment, deviation, leafref)
+ * and on the autocli config, a cache entry is only used if its key is the same.
+ * Key is a FNV-1a hash of the name and revision of all modules of the YANG spec (in any
+ * order), the autocli config and the Clixon version.
+ * @param[in]  h     Clixon handle
+ * @param[in]  ymod  Yang module object
+ * @param[out] cb    Key as cache file header line
+ * @retval     0     OK
+ * @retval    -1    Error
+ */
+static int
+autocli_cache_key(clixon_handle h,
+                  yang_stmt    *ymod,
+                  cbuf         *cb)
+{
+    int        retval = -1;
+    cbuf      *cbk = NULL;
+    yang_stmt *ym;
+    yang_stmt *yrev;
+    uint64_t   mset = 0;
+    uint64_t   hash;
+    char      *p;
+    int        inext;
+
+    if ((cbk = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    inext = 0;
+    while ((ym = yn_iter(ys_spec(ymod), &inext)) != NULL){
+        if (yang_keyword_get(ym) != Y_MODULE && yang_keyword_get(ym) != Y_SUBMODULE)
+            continue;
+        cbuf_reset(cbk);
+        cprintf(cbk, "%s", yang_argument_get(ym));
+        if ((yrev = yang_find(ym, Y_REVISION, NULL)) != NULL)
+            cprintf(cbk, "@%s", yang_argument_get(yrev));
+        hash = 14695981039346656037ULL;
+        for (p = cbuf_get(cbk); *p; p++)
+            hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+        mset ^= hash; /* Module order does not matter */
+    }
+    cbuf_reset(cbk);
+    cprintf(cbk, "%s", CLIXON_VERSION);
+    if (clixon_xml2cbuf(cbk, clicon_conf_autocli(h), 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    hash = 14695981039346656037ULL;
+    for (p = cbuf_get(cbk); *p; p++)
+        hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+    cprintf(cb, "# clixon autocli cache %016" PRIx64 "%016" PRIx64 "\n", mset, hash);
+    retval = 0;
+ done:
+    if (cbk)
+        cbuf_free(cbk);
+    return retval;
+}
+
+/*! Read clispec from autocli cache file if its key is the same
+ *
+ * @param[in]  filename  Cache file
+ * @param[in]  size      Size of cache file
+ * @param[in]  key       Expected header line, see autocli_cache_key
+ * @param[out] cb        Clispec
+ * @retval     1         OK, clispec read
+ * @retval     0         Stale cache entry, clispec not read
+ * @retval    -1         Error
+ */
+static int
+autocli_cache_read(char  *filename,
+                   off_t  size,
+                   char  *key,
+                   cbuf  *cb)
+{
+    int    retval = -1;
+    FILE  *f = NULL;
+    char  *str = NULL;
+    size_t len;
+    size_t klen = strlen(key);
+
+    if ((f = fopen(filename, "r")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
+        goto done;
+    }
+    if ((str = calloc(size+1, 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    len = fread(str, 1, size, f);
+    if (len != size){
+        clixon_err(OE_UNIX, errno, "fread %lu != %lu", len, size);
+        goto done;
+    }
+    if (len < klen || strncmp(str, key, klen) != 0){
+        clixon_debug(CLIXON_DBG_CLI, "CLI cache: stale %s", filename);
+        retval = 0;
+        goto done;
+    }
+    if (cbuf_append_str(cb, str + klen) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_str");
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (str)
+        free(str);
+    if (f)
+        fclose(f);
+    return retval;
+}
+
 /*! Generate clispecs, read / write from autocli cache if defined
  *
  * Cache entry is: <AUTOCLI_CACHE_DIR>/<domain>/<module>@<revision>[-<tag>-<name>].cli
+ * The first line of a cache entry is a key of the module-set and autocli config, an entry
+ * with another key is regenerated, see autocli_cache_key
  * @param[in]  h       Clixon handle
  * @param[in]  ymod    Yang module object
  * @param[in]  domain  Domain string
  * @param[in]  skiptop Do not include ymod when generating clispec
  * @param[out] cb      Clispec
- * XXX only disable and readwrite
  */
 static int
 cli_autocli_gen_cache(clixon_handle h,
@@ -1696,13 +1869,13 @@ cli_autocli_gen_cache(clixon_handle h,
     yang_stmt      *yrev;
     cbuf           *dbuf = NULL;
     cbuf           *fbuf = NULL;
+    cbuf           *kbuf = NULL;
     char           *dir00 = NULL;
     char           *dir0 = NULL;
     char           *dir = NULL;
     char           *filename = NULL;
     struct stat     fstat;
     FILE           *f = NULL;
-    char           *str = NULL;
     size_t          len;
     autocli_cache_t type;
     int             inext;
@@ -1745,101 +1918,76 @@ cli_autocli_gen_cache(clixon_handle h,
             cprintf(fbuf, "-%s-%s", yang_key2str(yang_keyword_get(ys)), yang_argument_get(ys));
         cprintf(fbuf, ".cli");
         filename =  cbuf_get(fbuf);
-        if (type == AUTOCLI_CACHE_WRITE ||
-            stat(filename, &fstat) < 0) { /* File does not exist or should be written*/
-            /* Generate clispec */
-            if (skiptop){
-                inext = 0;
-                while ((yc = yn_iter(ys, &inext)) != NULL)
-                    if (yang2cli_stmt(h, yc, 1, cb) < 0)
-                        goto done;
-            }
-            else if (yang2cli_stmt(h, ys, 0, cb) < 0)
-                goto done;
-            /* Write to cache, also if empty */
-            if (dir && filename &&
-                (type == AUTOCLI_CACHE_WRITE || type == AUTOCLI_CACHE_READWRITE)){
-                if (stat(dir0, &fstat) < 0) {
-                    if (mkdir(dir0, S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH) < 0){
-                        clixon_err(OE_UNIX, errno, "mkdir(%s)", dir0);
-                        goto done;
-                    }
-                }
-                else {
-                    if (!S_ISDIR(fstat.st_mode)){
-                        clixon_err(OE_UNIX, 0, "%s exists but is not a directory as expected", dir0);
-                        goto done;
-                    }
-                }
-                if (stat(dir, &fstat) < 0) {
-                    if (mkdir(dir, S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH) < 0){
-                        clixon_err(OE_UNIX, errno, "mkdir(%s)", dir);
-                        goto done;
-                    }
-                }
-                if ((f = fopen(filename, "w")) == NULL){
-                    clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
-                    goto done;
-                }
-                len = fwrite(cbuf_get(cb), 1, cbuf_len(cb), f);
-                if (len != cbuf_len(cb)){
-                    if (feof(f))
-                        clixon_err(OE_UNIX, 0, "fwrite(%s) eof",
-                                   filename);
-                    else
-                        clixon_err(OE_UNIX, 0, "fwrite(%s) %lu != %lu",
-                                   filename, len, cbuf_len(cb));
-                    goto done;
-                }
-            }
-        } /* stat */
-        else if (type == AUTOCLI_CACHE_READ ||
-                 type == AUTOCLI_CACHE_READWRITE){ /* Read cache */
+        if ((kbuf = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (autocli_cache_key(h, ymod, kbuf) < 0)
+            goto done;
+        if ((type == AUTOCLI_CACHE_READ || type == AUTOCLI_CACHE_READWRITE) &&
+            stat(filename, &fstat) == 0){ /* Read cache */
             clixon_debug(CLIXON_DBG_CLI, "CLI cache: read %s", filename);
-            if ((f = fopen(filename, "r")) == NULL){
-                clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
+            if ((ret = autocli_cache_read(filename, fstat.st_size, cbuf_get(kbuf), cb)) < 0)
                 goto done;
-            }
-            if ((str = calloc(fstat.st_size+1, 1)) == NULL){
-                clixon_err(OE_UNIX, errno, "calloc");
-                goto done;
-            }
-            len = fread(str, 1, fstat.st_size, f);
-            if (len != fstat.st_size){
-                clixon_err(OE_UNIX, errno, "fread %lu != %lu", len, fstat.st_size);
+            if (ret == 1)
+                goto ok;
+        }
+    }
+    /* Generate clispec */
+    if (skiptop){
+        inext = 0;
+        while ((yc = yn_iter(ys, &inext)) != NULL)
+            if (yang2cli_stmt(h, yc, 1, cb) < 0)
                 goto done;
-            }
-            if (cbuf_append_str(cb, str) < 0){
-                clixon_err(OE_UNIX, errno, "cbuf_append_str");
+    }
+    else if (yang2cli_stmt(h, ys, 0, cb) < 0)
+        goto done;
+    /* Write to cache, also if empty */
+    if (filename &&
+        (type == AUTOCLI_CACHE_WRITE || type == AUTOCLI_CACHE_READWRITE)){
+        if (stat(dir0, &fstat) < 0) {
+            if (mkdir(dir0, S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH) < 0){
+                clixon_err(OE_UNIX, errno, "mkdir(%s)", dir0);
                 goto done;
             }
         }
         else {
-            if (skiptop){
-                inext = 0;
-                while ((yc = yn_iter(ys, &inext)) != NULL)
-                    if (yang2cli_stmt(h, yc, 1, cb) < 0)
-                        goto done;
+            if (!S_ISDIR(fstat.st_mode)){
+                clixon_err(OE_UNIX, 0, "%s exists but is not a directory as expected", dir0);
+                goto done;
             }
-            else if (yang2cli_stmt(h, ys, 0, cb) < 0)
+        }
+        if (stat(dir, &fstat) < 0) {
+            if (mkdir(dir, S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH) < 0){
+                clixon_err(OE_UNIX, errno, "mkdir(%s)", dir);
                 goto done;
+            }
         }
-    }
-    else {
-        if (skiptop){
-            inext = 0;
-            while ((yc = yn_iter(ys, &inext)) != NULL)
-                if (yang2cli_stmt(h, yc, 1, cb) < 0)
-                    goto done;
+        if ((f = fopen(filename, "w")) == NULL){
+            clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
+            goto done;
+        }
+        if (fputs(cbuf_get(kbuf), f) < 0){
+            clixon_err(OE_UNIX, errno, "fputs(%s)", filename);
+            goto done;
         }
-        else if (yang2cli_stmt(h, ys, 0, cb) < 0)
+        len = fwrite(cbuf_get(cb), 1, cbuf_len(cb), f);
+        if (len != cbuf_len(cb)){
+            if (feof(f))
+                clixon_err(OE_UNIX, 0, "fwrite(%s) eof",
+                           filename);
+            else
+                clixon_err(OE_UNIX, 0, "fwrite(%s) %lu != %lu",
+                           filename, len, cbuf_len(cb));
             goto done;
+        }
     }
+ ok:
     retval = 0;
  done:
     wordfree(&wresult);
-    if (str)
-        free(str);
+    if (kbuf)
+        cbuf_free(kbuf);
     if (fbuf)
         cbuf_free(fbuf);
     if (dbuf)
@@ -1849,12 +1997,11 @@ cli_autocli_gen_cache(clixon_handle h,
     return retval;
 }
 
-/*! Generate clispec for all modules in a grouping
+/*! Generate clispec for the sub-statements of a grouping or a top-level container or list
  *
- * Called in cli main function for top-level yangs. But may also be called dynamically for
- * mountpoints.
+ * Called dynamically when a treeref is first resolved, see yang2cli_grouping_wrap
  * @param[in]  h         Clixon handle
- * @param[in]  ys        Top-level Yang statement
+ * @param[in]  ys        Yang grouping, or top-level container or list if module-treeref
  * @param[in]  ymod      Yang module
  * @param[in]  domain    Domain name
  * @param[in]  treename  Name of tree in the form <tag>-<domain>-<module>-<id>
@@ -1928,8 +2075,8 @@ yang2cli_grouping(clixon_handle h,
         clixon_err(OE_PLUGIN, 0, "%s", cbuf_get(cb));
         goto done;
     }
-    clixon_debug(CLIXON_DBG_CLI, "Generated auto-cli for grouping:%s",
-                 yang_argument_get(ys));
+    clixon_debug(CLIXON_DBG_CLI, "Generated auto-cli for %s:%s",
+                 yang_key2str(yang_keyword_get(ys)), yang_argument_get(ys));
     /* Add prefix: assume new are appended */
     for (i=0; i<pt_len_get(pt); i++){
         if ((co = pt_vec_i_get(pt, i)) != NULL){
@@ -2140,6 +2287,8 @@ yang2cli_yspec(clixon_handle h,
  * If a yang and specific tree is created, the name of that tree is returned in namep,
  * That tree is called something like mountpoint-<device-name>
  * otherwise the generic name "mountpoint" is used.
+ * Trees of groupings (grouping-treeref) and of top-level containers and lists
+ * (module-treeref) are generated here when first referenced.
  * @param[in]  ch    CLIgen handle
  * @param[in]  name  Base tree name
  * @param[in]  cvt   Tokenized string: vector of tokens
@@ -2164,6 +2313,7 @@ yang2cli_grouping_wrap(cligen_handle ch,
     yang_stmt    *yspec;
     yang_stmt    *ymod;
     yang_stmt    *ygrouping;
+    yang_stmt    *ynode;
     char         *tag = NULL;
     char         *domain = NULL;
     char         *spec = NULL;
@@ -2179,7 +2329,8 @@ yang2cli_grouping_wrap(cligen_handle ch,
     yspec = clicon_dbspec_yang(h);
     if (yang2cli_cmd_decode(name, AUTOCLI_CMD_DELIM, &tag, &domain, &spec, &modname, &grouping) < 0)
         goto done;
-    if (tag == NULL || strcmp(tag, "grouping") != 0)
+    if (tag == NULL ||
+        (strcmp(tag, "grouping") != 0 && strcmp(tag, "module") != 0))
         goto ok;
     if (cligen_ph_find(ch, name) != NULL){
         *namep = strdup(name);
@@ -2202,10 +2353,19 @@ yang2cli_grouping_wrap(cligen_handle ch,
         clixon_err(OE_YANG, 0, "yang2cli cmd label no module %s", modname);
         goto done;
     }
-    if ((ygrouping = yang_find(ymod, Y_GROUPING, grouping)) == NULL)
-        goto ok;
-    if ((ret = yang2cli_grouping(h, ygrouping, ymod, domain, name)) < 0)
-        goto done;
+    if (strcmp(tag, "module") == 0){
+        /* Top-level container or list, see yang2cli_module_treeref */
+        if ((ynode = yang_find_datanode(ymod, grouping)) == NULL)
+            goto ok;
+        if ((ret = yang2cli_grouping(h, ynode, ymod, domain, name)) < 0)
+            goto done;
+    }
+    else {
+        if ((ygrouping = yang_find(ymod, Y_GROUPING, grouping)) == NULL)
+            goto ok;
+        if ((ret = yang2cli_grouping(h, ygrouping, ymod, domain, name)) < 0)
+            goto done;
+    }
     if (ret == 0){ /* tree empty */
         clixon_err(OE_UNIX, 0, "Tree empty %s", name);
         goto done;
@@ -2224,6 +2384,7 @@ yang2cli_grouping_wrap(cligen_handle ch,
  * Initialize CLIgen generation from YANG models.
  * Some logic around grouping-treeref: if enabled, then groupings are separate trees with lazy
  * evaluation.  Only expanded when referenced, but need a callback. If one is not already installed.
+ * Same for top-level containers and lists if module-treeref
  * @param[in]  h      Clixon handle
  */
 int
@@ -2231,11 +2392,14 @@ yang2cli_init(clixon_handle h)
 {
     int                             retval = -1;
     int                             grouping_treeref = 0;
+    int                             module_treeref = 0;
     cligen_tree_resolve_wrapper_fn *fn = NULL;
 
     if (autocli_grouping_treeref(h, &grouping_treeref) < 0)
         goto done;
-    if (grouping_treeref) {
+    if (autocli_module_treeref(h, &module_treeref) < 0)
+        goto done;
+    if (grouping_treeref || module_treeref) {
         cligen_tree_resolve_wrapper_get(cli_cligen(h), &fn, NULL);
         if (fn == NULL)
             cligen_tree_resolve_wrapper_set(cli_cligen(h), yang2cli_grouping_wrap, NULL);
@@ -84,6 +84,7 @@ struct cli_handle {
     clicon_hash_t  *cl_data;     /* internal clicon data (HDR) */
     clicon_hash_t  *ch_db_elmnt; /* xml datastore element cache data */
     event_stream_t *cl_stream;   /* notification streams, see clixon_stream.[ch] */
+    struct clicon_option_slots *cl_optslots; /* pre-resolved options (HDR) */
     /* ------ end of common handle ------ */
 
     cligen_handle   cl_cligen;   /* cligen handle */
@@ -106,7 +107,7 @@ cli_handle_init(void)
         goto done;
     }
     cligen_userhandle_set(clih, cl);
-    cligen_eval_wrap_fn_set(clih, clixon_resource_check, cl);
+    cligen_eval_wrap_fn_set(clih, cli_eval_wrap, cl);
     cl->cl_cligen = clih;
 
     h = (clixon_handle)cl;
@@ -245,6 +245,9 @@ cli_interactive(clixon_handle h)
     int           ret;
     pt_head      *ph;
 
+    /* Commands from script: batch edits */
+    if (!isatty(0) && cli_edit_batch_init(h) < 0)
+        goto done;
     /* Loop through all commands */
     while(!cligen_exiting(cli_cligen(h))) {
         if ((ph =  cligen_pt_head_active_get(cli_cligen(h))) == NULL){
@@ -267,8 +270,13 @@ cli_interactive(clixon_handle h)
             goto done;
         /* Why not check result? */
     }
+    if (cli_edit_batch_flush(h) < 0){
+        cli_handler_err(stdout);
+        goto done;
+    }
     retval = 0;
  done:
+    cli_edit_batch_exit(h);
     return retval;
 }
 
@@ -34,6 +34,9 @@
  * Example cli pipe output functions.
  * @note Paths to bins, such as GREP_BIN, are detected in configure.ac
  * @note These functions are normally run in a forked sub-process as spawned in cligen_eval()
+ * @note The pipe_*_fn functions using GREP_BIN etc exec an external command, while
+ *       pipe_include_fn, pipe_exclude_fn, pipe_count_fn, pipe_head_fn, pipe_last_fn and
+ *       pipe_xpath_fn filter stdin in the sub-process itself without exec
  * A developer should probably revise these functions, since they are primarily intended for testing
  * of the pipe functionality
  */
@@ -61,6 +64,7 @@
 #include <sys/param.h>
 #include <sys/mount.h>
 #include <pwd.h>
+#include <regex.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -253,6 +257,368 @@ pipe_tail_fn(clixon_handle h,
     return retval;
 }
 
+/*! Get value of cli variable named by argv[i]
+ *
+ * @param[in]  cvv   Vector of cli string and instantiated variables
+ * @param[in]  argv  String vector of options
+ * @param[in]  i     Index in argv of variable name
+ * @retval     str   Value of variable
+ * @retval     NULL  Not found or empty
+ */
+static char *
+pipe_argv_var(cvec *cvv,
+              cvec *argv,
+              int   i)
+{
+    cg_var *cv;
+    char   *argname;
+    char   *str;
+
+    if ((cv = cvec_i(argv, i)) != NULL &&
+        (argname = cv_string_get(cv)) != NULL &&
+        strlen(argname) &&
+        (cv = cvec_find_var(cvv, argname)) != NULL &&
+        (str = cv_string_get(cv)) != NULL &&
+        strlen(str))
+        return str;
+    return NULL;
+}
+
+/*! Get non-negative line count from cli variable named by argv[0]
+ *
+ * @param[in]  cvv   Vector of cli string and instantiated variables
+ * @param[in]  argv  String vector of options. Format: <argname>
+ * @param[out] n     Line count
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+pipe_argv_lines(cvec     *cvv,
+                cvec     *argv,
+                uint32_t *n)
+{
+    char *str;
+    char *reason = NULL;
+    int   ret;
+
+    if (cvec_len(argv) != 1){
+        clixon_err(OE_PLUGIN, EINVAL, "Received %d arguments. Expected: <argname>", cvec_len(argv));
+        return -1;
+    }
+    if ((str = pipe_argv_var(cvv, argv, 0)) == NULL){
+        *n = 0;
+        return 0;
+    }
+    if ((ret = parse_uint32(str, n, &reason)) < 0){
+        clixon_err(OE_UNIX, errno, "parse_uint32");
+        return -1;
+    }
+    if (ret == 0){
+        clixon_err(OE_PLUGIN, EINVAL, "%s", reason);
+        free(reason);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Print lines of stdin matching or not matching a regex, in-process grep
+ *
+ * @param[in]  cvv     Vector of cli string and instantiated variables
+ * @param[in]  argv    String vector of options. Format: <argname>
+ * @param[in]  invert  If set, print lines not matching
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+pipe_regex_filter(cvec *cvv,
+                  cvec *argv,
+                  int   invert)
+{
+    int     retval = -1;
+    char   *pattern;
+    regex_t re;
+    int     compiled = 0;
+    char   *line = NULL;
+    size_t  linelen = 0;
+    char    errbuf[128];
+    int     ret;
+
+    if (cvec_len(argv) != 1){
+        clixon_err(OE_PLUGIN, EINVAL, "Received %d arguments. Expected: <argname>", cvec_len(argv));
+        goto done;
+    }
+    if ((pattern = pipe_argv_var(cvv, argv, 0)) == NULL)
+        pattern = "";
+    if ((ret = regcomp(&re, pattern, REG_EXTENDED|REG_NOSUB)) != 0){
+        regerror(ret, &re, errbuf, sizeof(errbuf));
+        clixon_err(OE_PLUGIN, EINVAL, "regcomp(%s): %s", pattern, errbuf);
+        goto done;
+    }
+    compiled++;
+    while (getline(&line, &linelen, stdin) > 0){
+        if ((regexec(&re, line, 0, NULL, 0) == 0) != invert){
+            cligen_output(stdout, "%s", line);
+            if (cli_output_status() < 0)
+                break;
+        }
+    }
+    retval = 0;
+ done:
+    if (line)
+        free(line);
+    if (compiled)
+        regfree(&re);
+    return retval;
+}
+
+/*! Include pipe output function: print lines matching an extended regex, without exec
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables
+ * @param[in]  argv  String vector of options. Format: <argname>
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @code
+ *   include <arg:string>, pipe_include_fn("arg");
+ * @endcode
+ */
+int
+pipe_include_fn(clixon_handle h,
+                cvec         *cvv,
+                cvec         *argv)
+{
+    return pipe_regex_filter(cvv, argv, 0);
+}
+
+/*! Exclude pipe output function: print lines not matching an extended regex, without exec
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables
+ * @param[in]  argv  String vector of options. Format: <argname>
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+pipe_exclude_fn(clixon_handle h,
+                cvec         *cvv,
+                cvec         *argv)
+{
+    return pipe_regex_filter(cvv, argv, 1);
+}
+
+/*! Count pipe output function: print nr of lines, without exec
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables
+ * @param[in]  argv  No options
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+pipe_count_fn(clixon_handle h,
+              cvec         *cvv,
+              cvec         *argv)
+{
+    char  *line = NULL;
+    size_t linelen = 0;
+    size_t n = 0;
+
+    while (getline(&line, &linelen, stdin) > 0)
+        n++;
+    if (line)
+        free(line);
+    cligen_output(stdout, "%zu\n", n);
+    return 0;
+}
+
+/*! Head pipe output function: print first lines, without exec
+ *
+ * Stops reading stdin after the last line printed
+ * @param[in]  h     Clixon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables
+ * @param[in]  argv  String vector of options. Format: <argname> of nr of lines
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+pipe_head_fn(clixon_handle h,
+             cvec         *cvv,
+             cvec         *argv)
+{
+    int      retval = -1;
+    uint32_t n;
+    uint32_t i = 0;
+    char    *line = NULL;
+    size_t   linelen = 0;
+
+    if (pipe_argv_lines(cvv, argv, &n) < 0)
+        goto done;
+    while (i++ < n && getline(&line, &linelen, stdin) > 0){
+        cligen_output(stdout, "%s", line);
+        if (cli_output_status() < 0)
+            break;
+    }
+    retval = 0;
+ done:
+    if (line)
+        free(line);
+    return retval;
+}
+
+/*! Last pipe output function: print last lines, without exec
+ *
+ * The last lines are kept in a ring of line buffers while reading stdin
+ * @param[in]  h     Clixon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables
+ * @param[in]  argv  String vector of options. Format: <argname> of nr of lines
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+pipe_last_fn(clixon_handle h,
+             cvec         *cvv,
+             cvec         *argv)
+{
+    int      retval = -1;
+    uint32_t n;
+    char   **ring = NULL;
+    size_t  *ringlen = NULL;
+    size_t   nr = 0;
+    uint32_t i;
+
+    if (pipe_argv_lines(cvv, argv, &n) < 0)
+        goto done;
+    if (n == 0)
+        goto ok;
+    if ((ring = calloc(n, sizeof(char *))) == NULL ||
+        (ringlen = calloc(n, sizeof(size_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    while (getline(&ring[nr%n], &ringlen[nr%n], stdin) > 0)
+        nr++;
+    for (i = nr > n ? nr - n : 0; i < nr; i++){
+        cligen_output(stdout, "%s", ring[i%n]);
+        if (cli_output_status() < 0)
+            break;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (ring){
+        for (i = 0; i < n; i++)
+            if (ring[i])
+                free(ring[i]);
+        free(ring);
+    }
+    if (ringlen)
+        free(ringlen);
+    return retval;
+}
+
+/*! XPath pipe output function: filter XML on stdin with an XPath, then render
+ *
+ * The filter is applied on the parsed XML tree, not on its text, and only matching nodes
+ * are rendered. Prefixes in the XPath are module prefixes.
+ * @param[in]  h     Clixon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables
+ * @param[in]  argv  String vector of options, format:
+ *   <argname>       Name of cli variable containing the XPath
+ *   <format>        "text"|"xml"|"json"|"cli" (see format_enum), default: xml
+ *   <pretty>        true|false: pretty-print or not
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @code
+ *   xpath <arg:string>, pipe_xpath_fn("arg", "xml", true);
+ * @endcode
+ */
+int
+pipe_xpath_fn(clixon_handle h,
+              cvec         *cvv,
+              cvec         *argv)
+{
+    int              retval = -1;
+    cxobj           *xt = NULL;
+    cxobj           *xerr = NULL;
+    cxobj          **xvec = NULL;
+    size_t           xlen = 0;
+    cvec            *nsc = NULL;
+    yang_stmt       *yspec;
+    char            *xpath;
+    enum format_enum format = FORMAT_XML;
+    int              pretty = 1;
+    int              argc = 1;
+    size_t           i;
+    int              ret;
+
+    if (cvec_len(argv) < 1 || cvec_len(argv) > 3){
+        clixon_err(OE_PLUGIN, EINVAL, "Received %d arguments. Expected: <argname> [<format> [<pretty>]]", cvec_len(argv));
+        goto done;
+    }
+    if ((xpath = pipe_argv_var(cvv, argv, 0)) == NULL){
+        clixon_err(OE_PLUGIN, EINVAL, "XPath is empty");
+        goto done;
+    }
+    if (cvec_len(argv) > argc){
+        if (cli_show_option_format(h, argv, argc++, &format) < 0)
+            goto done;
+    }
+    if (cvec_len(argv) > argc){
+        if (cli_show_option_bool(argv, argc++, &pretty) < 0)
+            goto done;
+    }
+    yspec = clicon_dbspec_yang(h);
+    if (clixon_xml_parse_file(stdin, YB_NONE, yspec, &xt, NULL) < 0)
+        goto done;
+    if ((ret = xml_bind_yang(h, xt, YB_MODULE, yspec, 0, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Parse top file");
+        goto done;
+    }
+    if (xml_nsctx_yangspec(yspec, &nsc) < 0)
+        goto done;
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
+        goto done;
+    for (i = 0; i < xlen; i++){
+        switch (format){
+        case FORMAT_XML:
+            if (clixon_xml2file(stdout, xvec[i], 0, pretty, NULL, cligen_output, 0, 0) < 0)
+                goto done;
+            if (!pretty)
+                cligen_output(stdout, "\n");
+            break;
+        case FORMAT_JSON:
+            if (clixon_json2file(stdout, xvec[i], pretty, cligen_output, 0, 0, 0) < 0)
+                goto done;
+            break;
+        case FORMAT_TEXT:
+            if (clixon_text2file(stdout, xvec[i], 0, cligen_output, 0, 1) < 0)
+                goto done;
+            break;
+        case FORMAT_CLI:
+            if (clixon_cli2file(h, stdout, xvec[i], NULL, cligen_output, 0) < 0)
+                goto done;
+            break;
+        default:
+            break;
+        }
+        if (cli_output_status() < 0)
+            break;
+    }
+    retval = 0;
+ done:
+    if (xvec)
+        free(xvec);
+    if (nsc)
+        cvec_free(nsc);
+    if (xerr)
+        xml_free(xerr);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
 /*! Output pipe translate from xml to other format: json,text,
  *
  * @param[in]  h     Clixon handle
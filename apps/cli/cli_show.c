@@ -330,10 +330,7 @@ expand_dbvar(clixon_handle h,
     char            *dbstr;
     cxobj           *xt = NULL;
     char            *xpath = NULL;
-    cxobj          **xvec = NULL;
-    cxobj           *xe; /* direct ptr */
     cxobj           *xerr = NULL; /* free */
-    size_t           xlen = 0;
     cg_var          *cv;
     cg_obj          *co;
     cxobj           *xtop = NULL; /* xpath root */
@@ -458,8 +455,7 @@ expand_dbvar(clixon_handle h,
          * tree and apply the path to that.
          * Last, the reference point for the xpath code below is changed to 
          * the point of the tentative new xml.
-         * Here the whole syntax tree is loaded, and it would be better to offload
-         * such operations to the datastore by a generic xpath function.
+         * The xpath is evaluated in the backend, see clicon_rpc_expand_values
          */
 
         /* 
@@ -487,17 +483,11 @@ expand_dbvar(clixon_handle h,
         if (xpath_append(cbxpath, yang_argument_get(ypath), y, nsc) < 0)
             goto done;
     }
-    /* Get configuration based on cbxpath */
-    if (clicon_rpc_get_config(h, NULL, dbstr, cbuf_get(cbxpath), nsc, NULL, &xt) < 0)
-        goto done;
-    if ((xe = xpath_first(xt, NULL, "/rpc-error")) != NULL){
-        clixon_err_netconf(h, OE_NETCONF, 0, xe, "Get configuration");
-        goto ok;
-    }
-    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, cbuf_get(cbxpath)) < 0)
+    /* Get distinct values selected by cbxpath, evaluated in the backend */
+    if (clicon_rpc_expand_values(h, dbstr, cbuf_get(cbxpath), nsc, NULL, 0, &xt) < 0)
         goto done;
     /* Loop for inserting into commands cvec. */
-    if (expand_dbvar_insert(h, co, xvec, xlen, commands) < 0)
+    if (expand_dbvar_insert(h, co, xml_childvec_get(xt), xml_child_nr(xt), commands) < 0)
         goto done;
  ok:
     retval = 0;
@@ -516,8 +506,6 @@ expand_dbvar(clixon_handle h,
         xml_nsctx_free(nsc);
     if (api_path)
         free(api_path);
-    if (xvec)
-        free(xvec);
     if (xtop)
         xml_free(xtop);
     if (xt)
@@ -720,6 +708,131 @@ show_yang(clixon_handle h,
     return retval;
 }
 
+/*! Show a config list page by page using list pagination
+ *
+ * Each page of CLICON_CLI_SHOW_PAGE_SIZE entries is fetched from the backend and printed
+ * before the next page is fetched, and fetching stops if the user quits line scrolling.
+ * @param[in] h            Clixon handle
+ * @param[in] db           Datastore
+ * @param[in] format       Output format, one of XML, TEXT or CLI
+ * @param[in] pretty       Pretty-print XML
+ * @param[in] state        Also state data
+ * @param[in] withdefault  RFC 6243 with-default modes
+ * @param[in] prepend      CLI prefix to prepend cli syntax, eg "set "
+ * @param[in] xpath        XPath of list
+ * @param[in] nsc          Namespace mapping for xpath
+ * @param[in] skiptop      If set, do not show object itself, only its children
+ * @retval    1            OK, shown
+ * @retval    0            Not a list or paging not enabled, show whole result instead
+ * @retval   -1            Error
+ * @see cli_pagination
+ */
+static int
+cli_show_paged(clixon_handle    h,
+               char            *db,
+               enum format_enum format,
+               int              pretty,
+               int              state,
+               char            *withdefault,
+               char            *prepend,
+               char            *xpath,
+               cvec            *nsc,
+               int              skiptop)
+{
+    int        retval = -1;
+    uint32_t   limit;
+    cxobj     *xtop = NULL;
+    cxobj     *xbot = NULL;
+    cxobj     *xerr = NULL;
+    yang_stmt *y = NULL;
+    cxobj     *xret = NULL;
+    cxobj     *xe;
+    cxobj    **xvec = NULL;
+    size_t     xlen = 0;
+    size_t     n = 0;
+    uint32_t   i;
+    size_t     j;
+    int        ret;
+
+    if ((limit = clicon_option_int(h, "CLICON_CLI_SHOW_PAGE_SIZE")) == 0)
+        goto skip;
+    if (format != FORMAT_XML && format != FORMAT_TEXT && format != FORMAT_CLI)
+        goto skip;
+    if (xpath == NULL || strcmp(xpath, "/") == 0)
+        goto skip;
+    if ((xtop = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if ((ret = xpath2xml(xpath, nsc, xtop, clicon_dbspec_yang(h), &xbot, &y, &xerr)) < 0)
+        goto done;
+    if (ret == 0 || y == NULL || yang_keyword_get(y) != Y_LIST)
+        goto skip;
+    /* Predicate on the list itself selects entries, not pages */
+    if (xpath[strlen(xpath)-1] == ']')
+        goto skip;
+    for (i = 0;; i++){
+        if (clicon_rpc_get_pageable_list(h, db, xpath, nsc,
+                                         state?CONTENT_ALL:CONTENT_CONFIG,
+                                         -1,          /* depth */
+                                         withdefault,
+                                         limit*i,     /* offset */
+                                         limit,       /* limit */
+                                         NULL, NULL, NULL,
+                                         &xret) < 0)
+            goto done;
+        if ((xe = xpath_first(xret, NULL, "/rpc-error")) != NULL){
+            clixon_err_netconf(h, OE_NETCONF, 0, xe, "Get configuration");
+            goto done;
+        }
+        if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath) < 0)
+            goto done;
+        for (j = 0; j < xlen; j++){
+            switch (format){
+            case FORMAT_XML:
+                if (clixon_xml2file(stdout, xvec[j], 0, pretty, NULL, cligen_output, skiptop, 1) < 0)
+                    goto done;
+                break;
+            case FORMAT_TEXT:
+                if (clixon_text2file(stdout, xvec[j], 0, cligen_output, skiptop, 1) < 0)
+                    goto done;
+                break;
+            case FORMAT_CLI:
+                if (clixon_cli2file(h, stdout, xvec[j], prepend, cligen_output, skiptop) < 0)
+                    goto done;
+                break;
+            default:
+                break;
+            }
+            if (cli_output_status() < 0)
+                break;
+        }
+        n += xlen;
+        if (cli_output_status() < 0)
+            break;
+        if (xlen != limit) /* Break if fewer elements than requested */
+            break;
+        xml_free(xret);
+        xret = NULL;
+        free(xvec);
+        xvec = NULL;
+    }
+    if (format == FORMAT_XML && !pretty && n)
+        cligen_output(stdout, "\n");
+    retval = 1;
+ done:
+    if (xvec)
+        free(xvec);
+    if (xret)
+        xml_free(xret);
+    if (xerr)
+        xml_free(xerr);
+    if (xtop)
+        xml_free(xtop);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
 /*! Common internal show routine for several show cli callbacks
  *
  * @param[in] h            Clixon handle
@@ -759,11 +872,20 @@ cli_show_common(clixon_handle    h,
     cxobj  *xp;
     int     i;
     cxobj  *xerr;
+    int     ret;
 
     if (state && strcmp(db, "running") != 0){
         clixon_err(OE_FATAL, 0, "Show state only for running database, not %s", db);
         goto done;
     }
+    /* Large list: fetch and print page by page */
+    if (!fromroot && extdefault == NULL){
+        if ((ret = cli_show_paged(h, db, format, pretty, state, withdefault, prepend,
+                                  xpath, nsc, skiptop)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
+    }
     if (state == 0){     /* Get configuration-only from a database */
         if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, withdefault, &xt) < 0)
             goto done;
@@ -843,6 +965,7 @@ cli_show_common(clixon_handle    h,
     }
     else if (format == FORMAT_JSON)
         cligen_output(stdout, "{}\n");
+ ok:
     retval = 0;
 done:
     if (vec)
@@ -1473,7 +1596,8 @@ cli_show_options(clixon_handle h,
         else
             fprintf(stdout, "%s: NULL\n", keys[i]);
     }
-    /* Next print CLICON_FEATURE, CLICON_YANG_DIR and CLICON_SNMP_MIB from config tree
+    /* Next print CLICON_FEATURE, CLICON_YANG_DIR, CLICON_SNMP_MIB and CLICON_YANG_SEARCH_INDEX
+     * from config tree
      * Since they are lists they are placed in the config tree.
      */
     x = NULL;
@@ -1494,6 +1618,12 @@ cli_show_options(clixon_handle h,
             continue;
         fprintf(stdout, "%s: \"%s\"\n", xml_name(x), xml_body(x));
     }
+    x = NULL;
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "CLICON_YANG_SEARCH_INDEX") != 0)
+            continue;
+        fprintf(stdout, "%s: \"%s\"\n", xml_name(x), xml_body(x));
+    }
    retval = 0;
  done:
     if (keys)
@@ -2012,12 +2142,208 @@ translatenumber(uint64_t   inr,
     return 0;
 }
 
+/*! Print XPath profile as table
+ *
+ * @param[in]  xp    XPath profile, <xpath-profile><entry>... of clixon-lib stats
+ * @retval     0     OK
+ * @see xpath_profile_print
+ */
+static int
+cli_show_xpath_profile(cxobj *xp)
+{
+    cxobj   *x;
+    char    *origin;
+    uint64_t calls;
+    uint64_t usec;
+    uint64_t nodes;
+    uint64_t hits;
+
+    cligen_output(stdout, "%-10s %-12s %-10s %-10s %s\n", "Calls", "Usec", "Nodes", "Opt-hits", "XPath");
+    x = NULL;
+    while ((x = xml_child_each(xp, x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "entry") != 0)
+            continue;
+        calls = usec = nodes = hits = 0;
+        parse_uint64(xml_find_body(x, "calls"), &calls, NULL);
+        parse_uint64(xml_find_body(x, "usec"), &usec, NULL);
+        parse_uint64(xml_find_body(x, "nodes"), &nodes, NULL);
+        parse_uint64(xml_find_body(x, "opthits"), &hits, NULL);
+        cligen_output(stdout, "%-10" PRIu64 " %-12" PRIu64 " %-10" PRIu64 " %-10" PRIu64 " %s\n",
+                      calls, usec, nodes, hits, xml_find_body(x, "xpath"));
+        if ((origin = xml_find_body(x, "origin")) != NULL)
+            cligen_output(stdout, "%-10s %s\n", "", origin);
+    }
+    return 0;
+}
+
+/*! Print validation profile as table
+ *
+ * @param[in]  vp    Validation profile, <validate-profile><entry>... of clixon-lib stats
+ * @retval     0     OK
+ * @see validate_profile_print
+ */
+static int
+cli_show_validate_profile(cxobj *vp)
+{
+    cxobj   *x;
+    cxobj   *xc;
+    uint64_t calls;
+    uint64_t nsec;
+    uint64_t maxnsec;
+
+    cligen_output(stdout, "%-10s %-10s %-14s %-12s %s\n", "Check", "Calls", "Nsec", "Max-nsec", "Node");
+    x = NULL;
+    while ((x = xml_child_each(vp, x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "entry") != 0)
+            continue;
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(xc), "check") != 0)
+                continue;
+            calls = nsec = maxnsec = 0;
+            parse_uint64(xml_find_body(xc, "calls"), &calls, NULL);
+            parse_uint64(xml_find_body(xc, "nsec"), &nsec, NULL);
+            parse_uint64(xml_find_body(xc, "maxnsec"), &maxnsec, NULL);
+            cligen_output(stdout, "%-10s %-10" PRIu64 " %-14" PRIu64 " %-12" PRIu64 " %s\n",
+                          xml_find_body(xc, "kind"), calls, nsec, maxnsec,
+                          xml_find_body(x, "node"));
+        }
+    }
+    return 0;
+}
+
+/*! Get approximate percentile of an event profile histogram
+ *
+ * Upper bound of the bucket holding the percentile, but at most the max value
+ * @param[in]  x     Histogram, <entry> of clixon-lib stats event-profile
+ * @param[in]  count Number of values
+ * @param[in]  max   Max value
+ * @param[in]  pct   Percentile, 1-100
+ * @retval     val   Percentile value
+ */
+static uint64_t
+cli_event_profile_pct(cxobj   *x,
+                      uint64_t count,
+                      uint64_t max,
+                      int      pct)
+{
+    cxobj   *xb;
+    uint64_t lower;
+    uint64_t n;
+    uint64_t sum = 0;
+
+    xb = NULL;
+    while ((xb = xml_child_each(x, xb, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(xb), "bucket") != 0)
+            continue;
+        lower = n = 0;
+        parse_uint64(xml_find_body(xb, "lower"), &lower, NULL);
+        parse_uint64(xml_find_body(xb, "count"), &n, NULL);
+        sum += n;
+        if (sum*100 >= count*pct)
+            return lower ? (2*lower-1 < max ? 2*lower-1 : max) : 0;
+    }
+    return max;
+}
+
+/*! Print event profile as table
+ *
+ * Times are in micro-seconds, except ready which is number of file descriptors
+ * @param[in]  ep    Event profile, <event-profile><entry>... of clixon-lib stats
+ * @retval     0     OK
+ * @see event_profile_print
+ */
+static int
+cli_show_event_profile(cxobj *ep)
+{
+    cxobj   *x;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+
+    cligen_output(stdout, "%-9s %-10s %-10s %-10s %-10s %-10s %s\n",
+                  "Kind", "Count", "Avg", "P50", "P99", "Max", "Name");
+    x = NULL;
+    while ((x = xml_child_each(ep, x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "entry") != 0)
+            continue;
+        count = sum = max = 0;
+        parse_uint64(xml_find_body(x, "count"), &count, NULL);
+        parse_uint64(xml_find_body(x, "sum"), &sum, NULL);
+        parse_uint64(xml_find_body(x, "max"), &max, NULL);
+        if (count == 0)
+            continue;
+        cligen_output(stdout, "%-9s %-10" PRIu64 " %-10" PRIu64 " %-10" PRIu64 " %-10" PRIu64 " %-10" PRIu64 " %s\n",
+                      xml_find_body(x, "kind"), count, sum/count,
+                      cli_event_profile_pct(x, count, max, 50),
+                      cli_event_profile_pct(x, count, max, 99),
+                      max, xml_find_body(x, "name"));
+    }
+    return 0;
+}
+
+/*! Print memory accounting per subsystem as table
+ *
+ * @param[in]  xm    Memory, <memory>... of clixon-lib stats
+ * @retval     0     OK
+ * @see clixon_memstats_print
+ */
+static int
+cli_show_memory(cxobj *xm)
+{
+    cxobj   *x;
+    char    *str;
+    uint64_t nr;
+    uint64_t sz;
+    uint64_t peak;
+    uint64_t u64;
+    uint64_t p64;
+    char    *unit;
+    char    *punit;
+
+    if ((str = xml_find_body(xm, "heap-inuse")) != NULL &&
+        parse_uint64(str, &sz, NULL) == 1){
+        translatenumber(sz, &u64, &unit);
+        cligen_output(stdout, "%-25s %" PRIu64 "%s\n", "Heap in use", u64, unit);
+    }
+    if ((str = xml_find_body(xm, "heap-peak")) != NULL &&
+        parse_uint64(str, &sz, NULL) == 1){
+        translatenumber(sz, &u64, &unit);
+        cligen_output(stdout, "%-25s %" PRIu64 "%s\n", "Heap peak", u64, unit);
+    }
+    if ((str = xml_find_body(xm, "rss-peak")) != NULL &&
+        parse_uint64(str, &sz, NULL) == 1){
+        translatenumber(sz, &u64, &unit);
+        cligen_output(stdout, "%-25s %" PRIu64 "%s\n", "RSS peak", u64, unit);
+    }
+    cligen_output(stdout, "%-25s %-10s %-10s %-10s\n", "Subsystem", "Nr", "Mem", "Peak");
+    x = NULL;
+    while ((x = xml_child_each(xm, x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "subsystem") != 0)
+            continue;
+        nr = sz = peak = 0;
+        parse_uint64(xml_find_body(x, "nr"), &nr, NULL);
+        parse_uint64(xml_find_body(x, "size"), &sz, NULL);
+        parse_uint64(xml_find_body(x, "peak"), &peak, NULL);
+        translatenumber(sz, &u64, &unit);
+        translatenumber(peak, &p64, &punit);
+        cligen_output(stdout, "%-25s %-10" PRIu64 " %" PRIu64 "%-10s %" PRIu64 "%s\n",
+                      xml_find_body(x, "name"), nr, u64, unit, p64, punit);
+    }
+    return 0;
+}
+
 /*! CLI callback show memory statistics (and numbers)
  *
  * mempry in KiB
+ * With xpath argument, show XPath evaluation profile instead, with validate argument
+ * show validation cost profile, and with event argument show event loop and rpc latency
+ * histograms, all recorded when debug bit profile is set. With memory argument show
+ * memory held per subsystem.
  * @param[in]  h     Clixon handle
  * @param[in]  cvv   Vector of cli string and instantiated variables
- * @param[in]  argv  Arguments given at the callback: [(cli|backend|all) [detail]]
+ * @param[in]  argv  Arguments given at the callback:
+ *                   [(cli|backend|all) [detail|xpath|validate|event|memory]]
  * @retval     0     OK
  * @retval    -1     Error
  */
@@ -2034,6 +2360,10 @@ cli_show_statistics(clixon_handle h,
     int         cli = 0;
     int         backend = 0;
     int         detail = 0;
+    int         xprofile = 0;
+    int         vprofile = 0;
+    int         eprofile = 0;
+    int         memory = 0;
     pt_head    *ph;
     parse_tree *pt;
     uint64_t    nr;
@@ -2056,7 +2386,7 @@ cli_show_statistics(clixon_handle h,
     int         inext2;
 
     if (argv == NULL || (cvec_len(argv) < 1 || cvec_len(argv) > 2)){
-        clixon_err(OE_PLUGIN, EINVAL, "Expected arguments: [(cli|backend|all) [detail]]");
+        clixon_err(OE_PLUGIN, EINVAL, "Expected arguments: [(cli|backend|all) [detail|xpath|validate|event|memory]]");
         goto done;
     }
     cv = cvec_i(argv, 0);
@@ -2075,17 +2405,158 @@ cli_show_statistics(clixon_handle h,
     }
     if (cvec_len(argv) > 1 &&
         (cv = cvec_i(argv, 1)) != NULL){
-        if (strcmp(cv_string_get(cv), "detail") != 0){
-            clixon_err(OE_PLUGIN, EINVAL, "Unexpected argument: %s, expected: detail",
+        if (strcmp(cv_string_get(cv), "detail") == 0)
+            detail = 1;
+        else if (strcmp(cv_string_get(cv), "xpath") == 0)
+            xprofile = 1;
+        else if (strcmp(cv_string_get(cv), "validate") == 0)
+            vprofile = 1;
+        else if (strcmp(cv_string_get(cv), "event") == 0)
+            eprofile = 1;
+        else if (strcmp(cv_string_get(cv), "memory") == 0)
+            memory = 1;
+        else {
+            clixon_err(OE_PLUGIN, EINVAL, "Unexpected argument: %s, expected: detail|xpath|validate|event|memory",
                        cv_string_get(cv));
             goto done;
         }
-        detail = 1;
     }
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_PLUGIN, errno, "cbuf_new");
         goto done;
     }
+    if (xprofile){
+        if (cli){
+            if (backend)
+                cligen_output(stdout, "CLI:\n====\n");
+            cprintf(cb, "<xpath-profile>");
+            if (xpath_profile_print(cb) < 0)
+                goto done;
+            cprintf(cb, "</xpath-profile>");
+            if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xret, NULL) < 0)
+                goto done;
+            if ((xp = xml_find_type(xret, NULL, "xpath-profile", CX_ELMNT)) != NULL)
+                cli_show_xpath_profile(xp);
+            xml_free(xret);
+            xret = NULL;
+            cbuf_reset(cb);
+        }
+        if (backend){
+            if (cli)
+                cligen_output(stdout, "\nBackend:\n========\n");
+            cprintf(cb, "<rpc xmlns=\"%s\" %s>", NETCONF_BASE_NAMESPACE, NETCONF_MESSAGE_ID_ATTR);
+            cprintf(cb, "<stats xmlns=\"%s\"><xpath-profile>true</xpath-profile></stats>", CLIXON_LIB_NS);
+            cprintf(cb, "</rpc>");
+            if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, NULL) < 0)
+                goto done;
+            if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+                clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get statistics");
+                goto done;
+            }
+            if ((xp = xpath_first(xret, NULL, "rpc-reply/xpath-profile")) != NULL)
+                cli_show_xpath_profile(xp);
+        }
+        goto ok;
+    }
+    if (vprofile){
+        if (cli){
+            if (backend)
+                cligen_output(stdout, "CLI:\n====\n");
+            cprintf(cb, "<validate-profile>");
+            if (validate_profile_print(cb) < 0)
+                goto done;
+            cprintf(cb, "</validate-profile>");
+            if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xret, NULL) < 0)
+                goto done;
+            if ((xp = xml_find_type(xret, NULL, "validate-profile", CX_ELMNT)) != NULL)
+                cli_show_validate_profile(xp);
+            xml_free(xret);
+            xret = NULL;
+            cbuf_reset(cb);
+        }
+        if (backend){
+            if (cli)
+                cligen_output(stdout, "\nBackend:\n========\n");
+            cprintf(cb, "<rpc xmlns=\"%s\" %s>", NETCONF_BASE_NAMESPACE, NETCONF_MESSAGE_ID_ATTR);
+            cprintf(cb, "<stats xmlns=\"%s\"><validate-profile>true</validate-profile></stats>", CLIXON_LIB_NS);
+            cprintf(cb, "</rpc>");
+            if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, NULL) < 0)
+                goto done;
+            if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+                clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get statistics");
+                goto done;
+            }
+            if ((xp = xpath_first(xret, NULL, "rpc-reply/validate-profile")) != NULL)
+                cli_show_validate_profile(xp);
+        }
+        goto ok;
+    }
+    if (eprofile){
+        if (cli){
+            if (backend)
+                cligen_output(stdout, "CLI:\n====\n");
+            cprintf(cb, "<event-profile>");
+            if (event_profile_print(cb) < 0)
+                goto done;
+            cprintf(cb, "</event-profile>");
+            if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xret, NULL) < 0)
+                goto done;
+            if ((xp = xml_find_type(xret, NULL, "event-profile", CX_ELMNT)) != NULL)
+                cli_show_event_profile(xp);
+            xml_free(xret);
+            xret = NULL;
+            cbuf_reset(cb);
+        }
+        if (backend){
+            if (cli)
+                cligen_output(stdout, "\nBackend:\n========\n");
+            cprintf(cb, "<rpc xmlns=\"%s\" %s>", NETCONF_BASE_NAMESPACE, NETCONF_MESSAGE_ID_ATTR);
+            cprintf(cb, "<stats xmlns=\"%s\"><event-profile>true</event-profile></stats>", CLIXON_LIB_NS);
+            cprintf(cb, "</rpc>");
+            if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, NULL) < 0)
+                goto done;
+            if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+                clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get statistics");
+                goto done;
+            }
+            if ((xp = xpath_first(xret, NULL, "rpc-reply/event-profile")) != NULL)
+                cli_show_event_profile(xp);
+        }
+        goto ok;
+    }
+    if (memory){
+        if (cli){
+            if (backend)
+                cligen_output(stdout, "CLI:\n====\n");
+            cprintf(cb, "<memory>");
+            if (clixon_memstats_print(h, cb) < 0)
+                goto done;
+            cprintf(cb, "</memory>");
+            if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xret, NULL) < 0)
+                goto done;
+            if ((xp = xml_find_type(xret, NULL, "memory", CX_ELMNT)) != NULL)
+                cli_show_memory(xp);
+            xml_free(xret);
+            xret = NULL;
+            cbuf_reset(cb);
+        }
+        if (backend){
+            if (cli)
+                cligen_output(stdout, "\nBackend:\n========\n");
+            cprintf(cb, "<rpc xmlns=\"%s\" %s>", NETCONF_BASE_NAMESPACE, NETCONF_MESSAGE_ID_ATTR);
+            cprintf(cb, "<stats xmlns=\"%s\"><memory>true</memory></stats>", CLIXON_LIB_NS);
+            cprintf(cb, "</rpc>");
+            if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, NULL) < 0)
+                goto done;
+            if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+                clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get statistics");
+                goto done;
+            }
+            if ((xp = xpath_first(xret, NULL, "rpc-reply/memory")) != NULL)
+                cli_show_memory(xp);
+        }
+        goto ok;
+    }
     if ((ymounts = clixon_yang_mounts_get(h)) == NULL){
         clixon_err(OE_YANG, ENOENT, "Top-level yang mounts not found");
         goto done;
@@ -2237,6 +2708,7 @@ cli_show_statistics(clixon_handle h,
             cligen_output(stdout, "%-25s %" PRIu64 "%-10s\n", "Mem Total", u64, unit);
         }
     }
+ ok:
     retval = 0;
  done:
     if (xret)
@@ -86,6 +86,10 @@ void cli_signal_flush(clixon_handle h);
 int mtpoint_paths(yang_stmt *yspec0, char *mtpoint, char *api_path_fmt1, char **api_path_fmt01);
 int dbxml_body(cxobj *xbot, cvec *cvv);
 int identityref_add_ns(cxobj *x, void *arg);
+int cli_edit_batch_init(clixon_handle h);
+int cli_edit_batch_flush(clixon_handle h);
+int cli_edit_batch_exit(clixon_handle h);
+int cli_eval_wrap(void *arg, void **wh, const char *name, const char *fn);
 int cli_dbxml(clixon_handle h, cvec *vars, cvec *argv, enum operation_type op, cvec *nsctx);
 int cli_set(clixon_handle h, cvec *vars, cvec *argv);
 int cli_merge(clixon_handle h, cvec *vars, cvec *argv);
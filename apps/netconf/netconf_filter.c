@@ -211,3 +211,116 @@ xml_filter(cxobj *xfilter,
                                   &remove_s);
     return retval;
 }
+
+/*! Get or add prefix of namespace in namespace context of subtree filter xpath
+ *
+ * @param[in]  xfilter  Filter xml, new prefixes must not be declared on it
+ * @param[in]  nsc      Namespace context
+ * @param[in]  ns       Namespace
+ * @param[out] prefix   Prefix of namespace in nsc
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+xml_filter_prefix(cxobj *xfilter,
+                  cvec  *nsc,
+                  char  *ns,
+                  char **prefix)
+{
+    char pf[16];
+    int  i;
+
+    if (xml_nsctx_get_prefix(nsc, ns, prefix) == 1)
+        return 0;
+    i = cvec_len(nsc);
+    do {
+        snprintf(pf, sizeof(pf), "nf%d", i++);
+    } while (xml_find_type(xfilter, "xmlns", pf, CX_ATTR) != NULL);
+    if (xml_nsctx_add(nsc, pf, ns) < 0)
+        return -1;
+    if (xml_nsctx_get_prefix(nsc, ns, prefix) != 1){
+        clixon_err(OE_XML, ENOENT, "prefix of %s", ns);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Translate subtree filter to an xpath selecting a superset of what the filter selects
+ *
+ * Follows the filter down as long as there is a single containment or selection node.
+ * Content match nodes become predicates and end the path, since the matched nodes are
+ * part of the result, eg for list keys:
+ *   <interfaces xmlns="urn:ietf:params:xml:ns:yang:ietf-interfaces">
+ *     <interface><name>eth0</name><enabled/></interface></interfaces>
+ *   ->
+ *   /nf0:interfaces/nf0:interface[nf0:name='eth0']
+ * The xpath can be used to fetch data, eg with XPATH_LIST_OPTIMIZE key lookups, before
+ * xml_filter prunes it to exactly what the subtree filter selects.
+ * @param[in]  xfilter  Filter xml, ie <filter>
+ * @param[in]  yspec    Yang spec, namespaces must be of its modules
+ * @param[in]  nsc      Namespace context, prefixes of the xpath are added
+ * @param[out] cb       XPath
+ * @retval     1        OK, xpath in cb
+ * @retval     0        Not translatable, eg several top nodes or unknown namespace
+ * @retval    -1        Error
+ * @see xml_filter  which must still be applied to the result
+ */
+int
+xml_filter2xpath(cxobj     *xfilter,
+                 yang_stmt *yspec,
+                 cvec      *nsc,
+                 cbuf      *cb)
+{
+    cxobj *f;
+    cxobj *c;
+    cxobj *next;
+    char  *ns;
+    char  *prefix;
+    char  *val;
+    char   q;
+    int    containments;
+    int    matches;
+
+    if (xml_child_nr_type(xfilter, CX_ELMNT) != 1)
+        return 0;
+    f = xml_child_i_type(xfilter, 0, CX_ELMNT);
+    if (leafstring(f))
+        return 0;
+    while (f != NULL){
+        if (xml2ns(f, xml_prefix(f), &ns) < 0)
+            return -1;
+        if (ns == NULL || yang_find_module_by_namespace(yspec, ns) == NULL)
+            return 0;
+        if (xml_filter_prefix(xfilter, nsc, ns, &prefix) < 0)
+            return -1;
+        cprintf(cb, "/%s:%s", prefix, xml_name(f));
+        next = NULL;
+        containments = 0;
+        matches = 0;
+        c = NULL;
+        while ((c = xml_child_each(f, c, CX_ELMNT)) != NULL) {
+            if ((val = leafstring(c)) == NULL){
+                containments++;
+                next = c;
+                continue;
+            }
+            /* Content match node */
+            if (xml2ns(c, xml_prefix(c), &ns) < 0)
+                return -1;
+            if (ns == NULL || yang_find_module_by_namespace(yspec, ns) == NULL)
+                return 0;
+            if (strchr(val, '\'') == NULL)
+                q = '\'';
+            else if (strchr(val, '"') == NULL)
+                q = '"';
+            else
+                return 0;
+            if (xml_filter_prefix(xfilter, nsc, ns, &prefix) < 0)
+                return -1;
+            cprintf(cb, "[%s:%s=%c%s%c]", prefix, xml_name(c), q, val, q);
+            matches++;
+        }
+        f = (containments == 1 && matches == 0) ? next : NULL;
+    }
+    return 1;
+}
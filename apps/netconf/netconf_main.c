@@ -67,9 +67,10 @@
 #include <clixon/clixon.h>
 
 #include "netconf_rpc.h"
+#include "netconf_server.h"
 
 /* Command line options to be passed to getopt(3) */
-#define NETCONF_OPTS "hVD:f:E:l:C:q01ca:u:d:p:y:U:t:eo:"
+#define NETCONF_OPTS "hVD:f:E:l:C:q01ca:u:d:p:y:U:t:eo:S"
 
 #define NETCONF_LOGFILE "/tmp/clixon_netconf.log"
 
@@ -388,6 +389,398 @@ netconf_input_packet(clixon_handle h,
     return retval;
 }
 
+/* Operations forwarded to the backend as-is, see netconf_rpc_dispatch */
+static const char *netconf_passthrough_ops[] = {
+    "edit-config",
+    "copy-config",
+    "delete-config",
+    "lock",
+    "unlock",
+    "validate",
+    "commit",
+    "cancel-commit",
+    "discard-changes",
+    "get-config",       /* Only without subtree filter */
+    "get",              /* Only without subtree filter */
+    NULL
+};
+
+/* Max length of reply before its rpc-reply start-tag is complete */
+#define PASSTHROUGH_REPLY_HEAD_MAX 8192
+
+/* State of a reply streamed from backend to client, see netconf_passthrough_reply */
+struct passthrough_reply {
+    netconf_framing_type pr_framing; /* Framing type of reply */
+    char                *pr_attrs;   /* Attributes of rpc start-tag */
+    char                *pr_gt;      /* End of rpc start-tag */
+    cbuf                *pr_head;    /* Start of reply until rpc-reply start-tag is complete */
+    int                  pr_started; /* Start of reply is written */
+    cbuf                *pr_out;     /* Output buffer */
+};
+
+/*! Skip XML white space
+ */
+static char *
+passthrough_ws(char *p,
+               char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        p++;
+    return p;
+}
+
+/*! Skip XML name, possibly with prefix
+ */
+static char *
+passthrough_name(char *p,
+                 char *end)
+{
+    while (p < end && strchr(" \t\r\n/>=", *p) == NULL)
+        p++;
+    return p;
+}
+
+/*! Find end of start-tag, ie its '>', not within quoted attribute values
+ *
+ * @param[in]  p    Start of start-tag after element name
+ * @param[in]  end  End of buffer
+ * @retval     gt   Pointer to '>'
+ * @retval     NULL Not found
+ */
+static char *
+passthrough_tag_end(char *p,
+                    char *end)
+{
+    char q = 0;
+
+    for (; p < end; p++){
+        if (q){
+            if (*p == q)
+                q = 0;
+        }
+        else if (*p == '"' || *p == '\'')
+            q = *p;
+        else if (*p == '>')
+            return p;
+    }
+    return NULL;
+}
+
+/*! Scan attribute on the form name="value" in start-tag
+ *
+ * @param[in]  p     Start of attribute, after white space
+ * @param[in]  gt    End of start-tag
+ * @param[out] name  Attribute name
+ * @param[out] nlen  Length of name
+ * @param[out] val   Attribute value without quotes
+ * @param[out] vlen  Length of value
+ * @retval     p     Pointer after attribute
+ * @retval     NULL  Malformed, or not on this simple form
+ */
+static char *
+passthrough_attr(char   *p,
+                 char   *gt,
+                 char  **name,
+                 size_t *nlen,
+                 char  **val,
+                 size_t *vlen)
+{
+    char q;
+
+    *name = p;
+    p = passthrough_name(p, gt);
+    if ((*nlen = p - *name) == 0 || p + 1 >= gt || *p++ != '=' ||
+        (*p != '"' && *p != '\''))
+        return NULL;
+    q = *p++;
+    *val = p;
+    while (p < gt && *p != q)
+        p++;
+    if (p >= gt)
+        return NULL;
+    *vlen = p - *val;
+    return p + 1;
+}
+
+/*! Check that filter of get or get-config is not a subtree filter, which is applied in frontend
+ *
+ * @param[in]  op    Operation element
+ * @param[in]  end   End of message
+ * @retval     1     No filter or xpath filter
+ * @retval     0     Subtree filter, or filter not on a simple form
+ */
+static int
+passthrough_filter_xpath(char *op,
+                         char *end)
+{
+    char  *p;
+    char  *gt;
+    char  *name;
+    size_t nlen;
+    char  *val;
+    size_t vlen;
+
+    if ((p = strstr(op, "filter")) == NULL)
+        return 1;
+    if (p[-1] != '<' || passthrough_name(p, end) != p + strlen("filter") ||
+        (gt = passthrough_tag_end(p, end)) == NULL)
+        return 0;
+    p += strlen("filter");
+    while ((p = passthrough_ws(p, gt)) < gt && *p != '/'){
+        if ((p = passthrough_attr(p, gt, &name, &nlen, &val, &vlen)) == NULL)
+            return 0;
+        if (nlen == strlen("type") && strncmp(name, "type", nlen) == 0)
+            return vlen == strlen("xpath") && strncmp(val, "xpath", vlen) == 0;
+    }
+    return 0;
+}
+
+/*! Write start of reply, with attributes of rpc copied to the rpc-reply start-tag
+ *
+ * Attributes already present in the reply are not copied
+ * @param[in]  pr    Reply state, start of reply in pr_head
+ * @param[in]  eom   Reply is complete
+ * @retval     1     Written
+ * @retval     0     Start-tag not complete, wait for more
+ * @retval    -1     Error
+ */
+static int
+passthrough_reply_head(struct passthrough_reply *pr,
+                       int                       eom)
+{
+    cbuf  *cbout = pr->pr_out;
+    char  *r = cbuf_get(pr->pr_head);
+    char  *rend = r + cbuf_len(pr->pr_head);
+    char  *rattrs;     /* Attributes of rpc-reply start-tag */
+    char  *rgt = NULL; /* End of rpc-reply start-tag */
+    char  *p;
+    char  *name;
+    size_t nlen;
+    char  *val;
+    size_t vlen;
+    char  *rname;
+    size_t rnlen;
+    int    found;
+
+    r = passthrough_ws(r, rend);
+    if (!eom && cbuf_len(pr->pr_head) < PASSTHROUGH_REPLY_HEAD_MAX &&
+        (rend - r <= 10 ||
+         (strncmp(r, "<rpc-reply", 10) == 0 && passthrough_tag_end(r + 10, rend) == NULL)))
+        return 0;
+    cbuf_reset(cbout);
+    if (rend - r > 10 && strncmp(r, "<rpc-reply", 10) == 0 &&
+        passthrough_name(r + 10, rend) == r + 10 &&
+        (rgt = passthrough_tag_end(r + 10, rend)) != NULL){
+        rattrs = r + 10;
+        cbuf_append_buf(cbout, r, rgt - r);
+        p = pr->pr_attrs;
+        while ((p = passthrough_ws(p, pr->pr_gt)) < pr->pr_gt){
+            if ((p = passthrough_attr(p, pr->pr_gt, &name, &nlen, &val, &vlen)) == NULL)
+                break;
+            found = 0;
+            r = rattrs;
+            while (!found && (r = passthrough_ws(r, rgt)) < rgt){
+                if ((r = passthrough_attr(r, rgt, &rname, &rnlen, &val, &vlen)) == NULL)
+                    break;
+                found = (rnlen == nlen && strncmp(rname, name, nlen) == 0);
+            }
+            if (!found){
+                cprintf(cbout, " ");
+                cbuf_append_buf(cbout, name, p - name);
+            }
+        }
+        r = rgt;
+    }
+    cbuf_append_buf(cbout, r, rend - r);
+    return 1;
+}
+
+/*! Write part of a reply from backend to client as it is received
+ *
+ * With chunked framing each part is written as a chunk, so that the frontend does not
+ * hold the whole reply.
+ * @param[in]  arg   Reply state
+ * @param[in]  data  Part of reply
+ * @param[in]  len   Length of part
+ * @param[in]  eom   Last part of reply
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see clixon_msg_rcv11_stream
+ */
+static int
+netconf_passthrough_reply(void  *arg,
+                          char  *data,
+                          size_t len,
+                          int    eom)
+{
+    struct passthrough_reply *pr = (struct passthrough_reply *)arg;
+    cbuf                     *cbout = pr->pr_out;
+    int                       ret;
+
+    if (!pr->pr_started){
+        cbuf_append_buf(pr->pr_head, data, len);
+        if ((ret = passthrough_reply_head(pr, eom)) < 0)
+            return -1;
+        if (ret == 0)
+            return 0;
+        pr->pr_started = 1;
+        data = cbuf_get(cbout);
+        len = cbuf_len(cbout);
+        /* cbout is reused below, move part to head buffer */
+        cbuf_reset(pr->pr_head);
+        cbuf_append_buf(pr->pr_head, data, len);
+        data = cbuf_get(pr->pr_head);
+    }
+    cbuf_reset(cbout);
+    if (len){
+        if (pr->pr_framing == NETCONF_SSH_CHUNKED)
+            cprintf(cbout, "\n#%zu\n", len);
+        cbuf_append_buf(cbout, data, len);
+    }
+    if (eom && netconf_framing_postamble(pr->pr_framing, cbout) < 0)
+        return -1;
+    if (cbuf_len(cbout) && netconf_output(1, cbout, "rpc-reply") < 0)
+        return -1;
+    return 0;
+}
+
+/*! Forward netconf rpc as text to the backend, and its reply as text to the client
+ *
+ * Only the rpc start-tag and the operation name are scanned, the message is not parsed.
+ * The backend parses and validates the rpc, as it does for all rpcs.
+ * Attributes of the rpc are copied to the reply, as netconf_add_request_attr does.
+ * The reply is written to the client in parts as it is received from the backend.
+ * Messages that need processing in the frontend, or where the rpc start-tag is not on
+ * a simple form, are not handled here but parsed as usual.
+ * @param[in]   h        Clixon handle
+ * @param[in]   cbmsg    Netconf message without framing
+ * @param[in]   framing  Framing type of reply
+ * @retval      1        Handled
+ * @retval      0        Not handled, parse message
+ * @retval     -1        Error
+ * @see CLICON_NETCONF_PASSTHROUGH
+ */
+static int
+netconf_passthrough(clixon_handle        h,
+                    cbuf                *cbmsg,
+                    netconf_framing_type framing)
+{
+    int    retval = -1;
+    char  *p = cbuf_get(cbmsg);
+    char  *end = p + cbuf_len(cbmsg);
+    char  *attrs;      /* Attributes of rpc start-tag */
+    char  *gt;         /* End of rpc start-tag */
+    char  *op;
+    size_t oplen;
+    char  *name;
+    size_t nlen;
+    char  *val;
+    size_t vlen;
+    int    msgid = 0;
+    int    ns = 0;
+    char  *username;
+    cbuf  *cbsend = NULL;
+    struct passthrough_reply pr = {0,};
+    int    i;
+
+    if (_netconf_hello_nr == 0 &&
+        clicon_option_bool(h, "CLICON_NETCONF_HELLO_OPTIONAL") == 0)
+        goto skip;
+    p = passthrough_ws(p, end);
+    if (end - p > 5 && strncmp(p, "<?xml", 5) == 0){
+        if ((p = strstr(p, "?>")) == NULL)
+            goto skip;
+        p = passthrough_ws(p + 2, end);
+    }
+    /* Unprefixed rpc element in netconf base namespace with message-id */
+    if (end - p < 5 || strncmp(p, "<rpc", 4) != 0)
+        goto skip;
+    attrs = p + 4;
+    if (passthrough_name(attrs, end) != attrs ||
+        (gt = passthrough_tag_end(attrs, end)) == NULL ||
+        gt[-1] == '/')
+        goto skip;
+    p = attrs;
+    while ((p = passthrough_ws(p, gt)) < gt){
+        if ((p = passthrough_attr(p, gt, &name, &nlen, &val, &vlen)) == NULL)
+            goto skip;
+        if (nlen == strlen("message-id") && strncmp(name, "message-id", nlen) == 0)
+            msgid++;
+        else if (nlen == strlen("xmlns") && strncmp(name, "xmlns", nlen) == 0){
+            if (vlen != strlen(NETCONF_BASE_NAMESPACE) ||
+                strncmp(val, NETCONF_BASE_NAMESPACE, vlen) != 0)
+                goto skip;
+            ns++;
+        }
+        /* The clixon-lib prefix is reserved for internal attributes */
+        else if ((nlen > strlen(CLIXON_LIB_PREFIX) &&
+                  strncmp(name, CLIXON_LIB_PREFIX ":", strlen(CLIXON_LIB_PREFIX) + 1) == 0) ||
+                 (nlen == strlen("xmlns:" CLIXON_LIB_PREFIX) &&
+                  strncmp(name, "xmlns:" CLIXON_LIB_PREFIX, nlen) == 0))
+            goto skip;
+    }
+    if (msgid == 0 || ns == 0)
+        goto skip;
+    /* Operation is first child */
+    p = passthrough_ws(gt + 1, end);
+    if (p >= end || *p++ != '<')
+        goto skip;
+    op = p;
+    oplen = passthrough_name(p, end) - op;
+    for (i = 0; netconf_passthrough_ops[i] != NULL; i++)
+        if (strlen(netconf_passthrough_ops[i]) == oplen &&
+            strncmp(op, netconf_passthrough_ops[i], oplen) == 0)
+            break;
+    if (netconf_passthrough_ops[i] == NULL)
+        goto skip;
+    /* Options are checked in frontend, see netconf_edit_config */
+    if (strcmp(netconf_passthrough_ops[i], "edit-config") == 0 &&
+        (strstr(op, "test-option") != NULL || strstr(op, "error-option") != NULL))
+        goto skip;
+    /* Subtree filters are applied in frontend, see netconf_get_config */
+    if ((strcmp(netconf_passthrough_ops[i], "get-config") == 0 ||
+         strcmp(netconf_passthrough_ops[i], "get") == 0) &&
+        passthrough_filter_xpath(op, end) == 0)
+        goto skip;
+    clixon_debug(CLIXON_DBG_NETCONF, "%s", netconf_passthrough_ops[i]);
+    /* Tag username as netconf_rpc_dispatch does */
+    if ((cbsend = cbuf_new_alloc(cbuf_len(cbmsg) + 128)) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
+        goto done;
+    }
+    cprintf(cbsend, "<rpc");
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cbsend, " xmlns:%s=\"%s\" %s:username=\"",
+                CLIXON_LIB_PREFIX, CLIXON_LIB_NS, CLIXON_LIB_PREFIX);
+        if (xml_chardata_cbuf_append(cbsend, 1, username) < 0)
+            goto done;
+        cprintf(cbsend, "\"");
+    }
+    cbuf_append_buf(cbsend, attrs, end - attrs);
+    pr.pr_framing = framing;
+    pr.pr_attrs = attrs;
+    pr.pr_gt = gt;
+    if ((pr.pr_head = cbuf_new()) == NULL ||
+        (pr.pr_out = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clicon_rpc_netconf_stream(h, cbsend, netconf_passthrough_reply, &pr) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (cbsend)
+        cbuf_free(cbsend);
+    if (pr.pr_head)
+        cbuf_free(pr.pr_head);
+    if (pr.pr_out)
+        cbuf_free(pr.pr_out);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
 /*! Get netconf message: detect end-of-msg
  *
  * @param[in]  s    Socket where input arrived. read from this.
@@ -424,7 +817,11 @@ netconf_input_cb(int   s,
     cxobj         *xreq;
     cxobj         *xerr = NULL;
     int            ret;
+#ifdef NETCONF_INPUT_BUFSIZ
+    unsigned char  buf[NETCONF_INPUT_BUFSIZ];
+#else
     unsigned char  buf[BUFSIZ]; /* from stdio.h, typically 8K */
+#endif
     ssize_t        buflen = sizeof(buf);
     unsigned char *p = buf;
     ssize_t        len;
@@ -479,6 +876,14 @@ netconf_input_cb(int   s,
             clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "Recv ext: %s", cbuf_get(cbmsg));
         else
             clixon_debug(CLIXON_DBG_MSG, "Recv ext len: %lu", cbuf_len(cbmsg));
+        if (clicon_option_bool(h, "CLICON_NETCONF_PASSTHROUGH")){
+            if ((ret = netconf_passthrough(h, cbmsg, framing_type)) < 0)
+                goto done;
+            if (ret == 1){
+                cbuf_reset(cbmsg);
+                continue;
+            }
+        }
         if ((ret = netconf_input_frame2(cbmsg, YB_RPC, yspec, &xtop, &xerr)) < 0)
             goto done;
         cbuf_reset(cbmsg);
@@ -651,6 +1056,7 @@ usage(clixon_handle h,
             "\t-U <user>\tOver-ride unix user with a pseudo user for NACM.\n"
             "\t-t <sec>\tTimeout in seconds. Quit after this time.\n"
             "\t-e \t\tDont ignore errors on packet input.\n"
+            "\t-S \t\tPersistent netconf server on CLICON_NETCONF_SERVER_SOCK, session per connection\n"
             "\t-o \"<option>=<value>\"\tGive configuration option overriding config file (see clixon-config.yang)\n",
             argv0,
             clicon_netconf_dir(h)
@@ -686,6 +1092,9 @@ main(int    argc,
     enum format_enum config_dump_format = FORMAT_XML;
     int              print_version = 0;
     int32_t          d;
+    int              server = 0;
+    int              sessopt = 0; /* Options of this session, not relayed to netconf server */
+    int              ret;
 
     /* Create handle */
     if ((h = clixon_handle_init()) == NULL)
@@ -778,6 +1187,7 @@ main(int    argc,
             break;
         case 'q':  /* quiet: dont write hello */
             quiet++;
+            sessopt++;
             break;
         case 'a': /* internal backend socket address family */
             clicon_option_str_set(h, "CLICON_SOCK_FAMILY", optarg);
@@ -806,20 +1216,28 @@ main(int    argc,
                 usage(h, argv[0]);
             if (clicon_username_set(h, optarg) < 0)
                 goto done;
+            sessopt++;
             break;
         case 't': /* timeout in seconds */
             tv.tv_sec = atoi(optarg);
+            sessopt++;
             break;
         case 'e': /* dont ignore packet errors */
             ignore_packet_errors = 0;
+            sessopt++;
             break;
         case '0': /* Force EOM */
             clicon_option_int_set(h, "CLICON_NETCONF_BASE_CAPABILITY", 0);
             clicon_option_bool_set(h, "CLICON_NETCONF_HELLO_OPTIONAL", 1);
+            sessopt++;
             break;
         case '1': /* Hello messages are optional */
             clicon_option_int_set(h, "CLICON_NETCONF_BASE_CAPABILITY", 1);
             clicon_option_bool_set(h, "CLICON_NETCONF_HELLO_OPTIONAL", 1);
+            sessopt++;
+            break;
+        case 'S': /* Persistent netconf server */
+            server++;
             break;
         case 'o':{ /* Configuration option */
             char          *val;
@@ -843,6 +1261,19 @@ main(int    argc,
     /* Access the remaining argv/argc options (after --) w clicon-argv_get() */
     clicon_argv_set(h, argv0, argc, argv);
 
+    /* Relay session to persistent netconf server if it is running, no yang is loaded */
+    if (!server && !sessopt && !config_dump && !print_version &&
+        (str = clicon_option_str(h, "CLICON_NETCONF_SERVER_SOCK")) != NULL){
+        if ((ret = netconf_relay(h, str)) < 0)
+            goto done;
+        if (ret == 1){
+            clixon_handle_exit(h);
+            clixon_err_exit();
+            clixon_log_exit();
+            return 0;
+        }
+    }
+
     /* Init cligen buffers */
     cligen_buflen = clicon_option_int(h, "CLICON_CLI_BUF_START");
     cligen_bufthreshold = clicon_option_int(h, "CLICON_CLI_BUF_THRESHOLD");
@@ -935,6 +1366,16 @@ main(int    argc,
     /* Debug dump of config options */
     clicon_option_dump(h, CLIXON_DBG_INIT);
 
+    /* Persistent netconf server, returns in forked session process */
+    if (server){
+        if ((str = clicon_option_str(h, "CLICON_NETCONF_SERVER_SOCK")) == NULL){
+            clixon_err(OE_CFG, EINVAL, "-S requires CLICON_NETCONF_SERVER_SOCK");
+            goto done;
+        }
+        if (netconf_server(h, str) < 0)
+            goto done;
+    }
+
     /* Send hello request to backend to get session-id back
      * This is done once at the beginning of the session and then this is
      * used by the client, even though new TCP sessions are created for
@@ -106,6 +106,60 @@ netconf_get_config_subtree(clixon_handle h,
     return retval;
 }
 
+/*! Add xpath select to subtree filter so that the backend only fetches the selected data
+ *
+ * The subtree filter is still applied to the reply, the xpath selects a superset of it.
+ * If the filter cannot be translated, the backend fetches all data as before.
+ * @param[in]  h        Clixon handle
+ * @param[in]  xfilter  Subtree filter, or NULL
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xml_filter2xpath
+ */
+static int
+netconf_filter_subtree_select(clixon_handle h,
+                              cxobj        *xfilter)
+{
+    int     retval = -1;
+    cvec   *nsc = NULL;
+    cbuf   *cb = NULL;
+    char   *encstr = NULL;
+    int     ret;
+
+    if (xfilter == NULL ||
+        xml_find_type(xfilter, NULL, "select", CX_ATTR) != NULL)
+        goto ok;
+    if ((nsc = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = xml_filter2xpath(xfilter, clicon_dbspec_yang(h), nsc, cb)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    clixon_debug(CLIXON_DBG_NETCONF, "subtree filter select:%s", cbuf_get(cb));
+    if (xmlns_set_all(xfilter, nsc) < 0)
+        goto done;
+    if (xml_chardata_encode(&encstr, 1, "%s", cbuf_get(cb)) < 0)
+        goto done;
+    if (xml_add_attr(xfilter, "select", encstr, NULL, NULL) == NULL)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (encstr)
+        free(encstr);
+    if (cb)
+        cbuf_free(cb);
+    if (nsc)
+        cvec_free(nsc);
+    return retval;
+}
+
 /*! Get configuration
  *
  * @param[in]  h       Clixon handle
@@ -166,10 +220,12 @@ netconf_get_config(clixon_handle h,
     cxobj     *xfilter; /* filter */
     char      *ftype = NULL;
     cvec      *nsc = NULL;
+    xml_nsscope *nss = NULL;
     char      *prefix = NULL;
 
-    if(xml_nsctx_node(xn, &nsc) < 0)
+    if (xml_nsscope_node(xn, &nss) < 0)
         goto done;
+    nsc = xml_nsscope_nsc(nss);
 
     /* Get prefix of netconf base namespace in the incoming message */
     if (xml_nsctx_get_prefix(nsc, NETCONF_BASE_NAMESPACE, &prefix) == 0){
@@ -180,8 +236,10 @@ netconf_get_config(clixon_handle h,
     if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
         ftype = xml_find_value(xfilter, "type");
     if (xfilter == NULL || ftype == NULL || strcmp(ftype, "subtree") == 0) {
-        /* Get whole config first, then filter. This is suboptimal
+        /* Translate filter to xpath so that only selected config is fetched, then filter
          */
+        if (netconf_filter_subtree_select(h, xfilter) < 0)
+            goto done;
         if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
             goto done;
         /* Now filter on whole tree */
@@ -203,8 +261,8 @@ netconf_get_config(clixon_handle h,
     }
     retval = 0;
  done:
-    if (nsc)
-        cvec_free(nsc);
+    if (nss)
+        xml_nsscope_unref(nss);
     return retval;
 }
 
@@ -379,10 +437,12 @@ netconf_get(clixon_handle h,
     cxobj     *xfilter; /* filter */
     char      *ftype = NULL;
     cvec      *nsc = NULL;
+    xml_nsscope *nss = NULL;
     char      *prefix = NULL;
 
-    if(xml_nsctx_node(xn, &nsc) < 0)
+    if (xml_nsscope_node(xn, &nss) < 0)
         goto done;
+    nsc = xml_nsscope_nsc(nss);
 
     /* Get prefix of netconf base namespace in the incoming message */
     if (xml_nsctx_get_prefix(nsc, NETCONF_BASE_NAMESPACE, &prefix) == 0){
@@ -393,8 +453,10 @@ netconf_get(clixon_handle h,
     if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
         ftype = xml_find_value(xfilter, "type");
     if (xfilter == NULL || ftype == NULL || strcmp(ftype, "subtree") == 0) {
-        /* Get whole config + state first, then filter. This is suboptimal
+        /* Translate filter to xpath so that only selected config + state is fetched, then filter
          */
+        if (netconf_filter_subtree_select(h, xfilter) < 0)
+            goto done;
         if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
             goto done;
         /* Now filter on whole tree */
@@ -415,8 +477,8 @@ netconf_get(clixon_handle h,
     }
     retval = 0;
  done:
-    if(nsc)
-        cvec_free(nsc);
+    if (nss)
+        xml_nsscope_unref(nss);
     return retval;
 }
 
@@ -0,0 +1,339 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Persistent NETCONF server and stdio relay, see CLICON_NETCONF_SERVER_SOCK
+ *
+ * A NETCONF server (clixon_netconf -S) loads plugins and YANG once and listens on a UNIX
+ * socket. For each connection a session process is forked that shares the loaded YANG
+ * copy-on-write and runs the NETCONF session on the connection as on stdin/stdout.
+ * The user of the session is the peer of the connection.
+ * A clixon_netconf started as SSH subsystem connects to the server socket, if it exists,
+ * and relays stdin/stdout to it without loading YANG.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#define _GNU_SOURCE /* for ucred */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "netconf_server.h"
+
+/*! Create, bind and listen on NETCONF server unix socket
+ *
+ * Same access as the backend socket: socket file group is CLICON_SOCK_GROUP
+ * @param[in]  h    Clixon handle
+ * @param[in]  sock Unix file-system path
+ * @retval     s    Socket file descriptor
+ * @retval    -1    Error
+ */
+static int
+netconf_server_socket(clixon_handle h,
+                      char         *sock)
+{
+    int                s;
+    struct sockaddr_un addr;
+    mode_t             old_mask;
+    char              *config_group;
+    gid_t              gid;
+    struct stat        st;
+
+    if (lstat(sock, &st) == 0 && unlink(sock) < 0){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", sock);
+        return -1;
+    }
+    if ((config_group = clicon_sock_group(h)) == NULL){
+        clixon_err(OE_FATAL, 0, "clicon_sock_group option not set %s", sock);
+        return -1;
+    }
+    if (group_name2gid(config_group, &gid) < 0)
+        return -1;
+    if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        clixon_err(OE_UNIX, errno, "socket %s", sock);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock, sizeof(addr.sun_path)-1);
+    old_mask = umask(S_IRWXO | S_IXGRP | S_IXUSR);
+    if (bind(s, (struct sockaddr *)&addr, SUN_LEN(&addr)) < 0){
+        clixon_err(OE_UNIX, errno, "bind %s", sock);
+        umask(old_mask);
+        goto err;
+    }
+    umask(old_mask);
+    if (lchown(sock, -1, gid) < 0){
+        clixon_err(OE_UNIX, errno, "lchown(%s, %s)", sock, config_group);
+        goto err;
+    }
+    clixon_debug(CLIXON_DBG_INIT, "Listen on netconf server socket at %s", addr.sun_path);
+    if (listen(s, 16) < 0){
+        clixon_err(OE_UNIX, errno, "listen");
+        goto err;
+    }
+    return s;
+  err:
+    close(s);
+    return -1;
+}
+
+/*! Set username of session to user of connected peer
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  s    Connected unix socket
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+netconf_server_peer(clixon_handle h,
+                    int           s)
+{
+    int          retval = -1;
+    char        *name = NULL;
+#ifdef HAVE_SO_PEERCRED        /* Linux. */
+    socklen_t    clen;
+    struct ucred cr = {0,};
+#elif defined(HAVE_GETPEEREID) /* FreeBSD */
+    uid_t        euid;
+    uid_t        guid;
+#endif
+
+#if defined(HAVE_SO_PEERCRED)
+    clen =  sizeof(cr);
+    if (getsockopt(s, SOL_SOCKET, SO_PEERCRED, &cr, &clen) < 0){
+        clixon_err(OE_UNIX, errno, "getsockopt");
+        goto done;
+    }
+    if (uid2name(cr.uid, &name) < 0)
+        goto done;
+#elif defined(HAVE_GETPEEREID)
+    if (getpeereid(s, &euid, &guid) < 0){
+        clixon_err(OE_UNIX, errno, "getpeereid");
+        goto done;
+    }
+    if (uid2name(euid, &name) < 0)
+        goto done;
+#else
+#error "Need getsockopt O_PEERCRED or getpeereid for unix socket peer cred"
+#endif
+    if (name == NULL){
+        clixon_err(OE_UNIX, ENOENT, "No user of netconf server peer");
+        goto done;
+    }
+    if (clicon_username_set(h, name) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (name)
+        free(name);
+    return retval;
+}
+
+/*! Run NETCONF server: accept connections and fork a session process for each
+ *
+ * Returns only in a session process, with the connection as stdin and stdout and the
+ * username set to the peer user. The server process runs until terminated.
+ * Backend sessions are not shared between NETCONF sessions since locks and
+ * session-ids belong to a backend session, each session process makes its own hello.
+ * @param[in]  h     Clixon handle
+ * @param[in]  sock  Unix socket path
+ * @retval     0     OK, in session process
+ * @retval    -1     Error
+ * @see CLICON_NETCONF_SERVER_SOCK
+ */
+int
+netconf_server(clixon_handle h,
+               char         *sock)
+{
+    int                retval = -1;
+    int                ss = -1;
+    int                s = -1;
+    pid_t              pid;
+    struct sockaddr_un from;
+    socklen_t          len;
+
+    if ((ss = netconf_server_socket(h, sock)) < 0)
+        goto done;
+    /* Session processes are reaped automatically */
+    if (set_signal(SIGCHLD, SIG_IGN, NULL) < 0){
+        clixon_err(OE_UNIX, errno, "Setting SIGCHLD signal");
+        goto done;
+    }
+    clixon_log(h, LOG_NOTICE, "%s: %u Started netconf server on %s", __PROGRAM__, getpid(), sock);
+    while (1){
+        len = sizeof(from);
+        if ((s = accept(ss, (struct sockaddr *)&from, &len)) < 0){
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            clixon_err(OE_UNIX, errno, "accept");
+            goto done;
+        }
+        if ((pid = fork()) < 0){
+            clixon_err(OE_UNIX, errno, "fork");
+            goto done;
+        }
+        if (pid == 0) /* Session process */
+            break;
+        clixon_debug(CLIXON_DBG_NETCONF, "session pid:%u", pid);
+        close(s);
+        s = -1;
+    }
+    close(ss);
+    ss = -1;
+    if (set_signal(SIGCHLD, SIG_DFL, NULL) < 0){
+        clixon_err(OE_UNIX, errno, "Setting SIGCHLD signal");
+        goto done;
+    }
+    if (netconf_server_peer(h, s) < 0)
+        goto done;
+    if (dup2(s, 0) < 0 || dup2(s, 1) < 0){
+        clixon_err(OE_UNIX, errno, "dup2");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (s >= 0)
+        close(s);
+    if (ss >= 0)
+        close(ss);
+    return retval;
+}
+
+/*! Write all of buffer
+ */
+static int
+netconf_relay_write(int   fd,
+                    char *buf,
+                    int   len)
+{
+    int n;
+
+    while (len > 0){
+        if ((n = write(fd, buf, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "write");
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*! Relay stdin/stdout to NETCONF server socket if the server is running
+ *
+ * Returns when the server closes the connection
+ * @param[in]  h     Clixon handle
+ * @param[in]  sock  Unix socket path of NETCONF server
+ * @retval     1     Relayed, session is closed
+ * @retval     0     Server not running, run session in this process
+ * @retval    -1    Error
+ * @see netconf_server
+ */
+int
+netconf_relay(clixon_handle h,
+              char         *sock)
+{
+    int           retval = -1;
+    int           s = -1;
+    struct pollfd fds[2];
+    char          buf[BUFSIZ];
+    int           n;
+    int           i;
+
+    if (clixon_rpc_connect_unix(h, sock, &s) < 0){
+        clixon_debug(CLIXON_DBG_NETCONF, "netconf server %s not running: %s", sock, clixon_err_reason());
+        clixon_err_reset();
+        retval = 0;
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_NETCONF, "relay to %s", sock);
+    fds[0].fd = 0;
+    fds[1].fd = s;
+    fds[0].events = fds[1].events = POLLIN;
+    while (1){
+        if (poll(fds, 2, -1) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "poll");
+            goto done;
+        }
+        for (i = 0; i < 2; i++){
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+                continue;
+            if ((n = read(fds[i].fd, buf, sizeof(buf))) < 0){
+                if (errno == EINTR)
+                    continue;
+                clixon_err(OE_UNIX, errno, "read");
+                goto done;
+            }
+            if (n == 0){
+                if (i == 1) /* Server closed session */
+                    goto ok;
+                /* Client closed, let server finish the session */
+                shutdown(s, SHUT_WR);
+                fds[0].fd = -1;
+                continue;
+            }
+            if (netconf_relay_write(i == 0 ? s : 1, buf, n) < 0)
+                goto done;
+        }
+    }
+ ok:
+    retval = 1;
+ done:
+    if (s >= 0)
+        close(s);
+    return retval;
+}
@@ -264,16 +264,343 @@ http_data_check_file_path(clixon_handle h,
     goto done;
 }
 
+#ifdef HTTP_DATA_CACHE_NR
+/*! Cached contents of a small http-data file, see HTTP_DATA_CACHE_NR
+ */
+struct http_data_cache{
+    qelem_t  hc_q;       /* Queue header, most recently used first */
+    char    *hc_path;    /* File path */
+    dev_t    hc_dev;     /* Device, inode, size and modification time of cached file */
+    ino_t    hc_ino;
+    off_t    hc_size;
+    time_t   hc_mtime;
+    char    *hc_data;    /* File contents */
+};
+
+static void
+http_data_cache_free1(struct http_data_cache *hc)
+{
+    if (hc->hc_path)
+        free(hc->hc_path);
+    if (hc->hc_data)
+        free(hc->hc_data);
+    free(hc);
+}
+
+/*! Find cached contents of file, if file is unchanged
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  path  File path
+ * @param[in]  st    Stat of open file
+ * @retval     hc    Cached file, moved first
+ * @retval     NULL  Not found, or file changed and entry removed
+ */
+static struct http_data_cache *
+http_data_cache_find(clixon_handle h,
+                     const char   *path,
+                     struct stat  *st)
+{
+    struct http_data_cache *head = NULL;
+    struct http_data_cache *hc;
+
+    clicon_ptr_get(h, "http-data-cache", (void**)&head);
+    if ((hc = head) != NULL)
+        do {
+            if (strcmp(hc->hc_path, path) == 0)
+                break;
+            hc = NEXTQ(struct http_data_cache *, hc);
+        } while (hc && hc != head);
+    if (hc == NULL || strcmp(hc->hc_path, path) != 0)
+        return NULL;
+    DELQ(hc, head, struct http_data_cache *);
+    if (hc->hc_dev != st->st_dev ||
+        hc->hc_ino != st->st_ino ||
+        hc->hc_size != st->st_size ||
+        hc->hc_mtime != st->st_mtime){
+        http_data_cache_free1(hc);
+        hc = NULL;
+    }
+    else
+        INSQ(hc, head);
+    clicon_ptr_set(h, "http-data-cache", head);
+    return hc;
+}
+
+/*! Add contents of file to cache, remove least recently used if full
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  path  File path
+ * @param[in]  st    Stat of open file
+ * @param[in]  data  File contents, consumed
+ * @retval     hc    Cached file
+ * @retval     NULL  Error
+ */
+static struct http_data_cache *
+http_data_cache_add(clixon_handle h,
+                    const char   *path,
+                    struct stat  *st,
+                    char         *data)
+{
+    struct http_data_cache *head = NULL;
+    struct http_data_cache *hc;
+    int                     nr = 0;
+
+    clicon_ptr_get(h, "http-data-cache", (void**)&head);
+    if ((hc = head) != NULL)
+        do {
+            nr++;
+            hc = NEXTQ(struct http_data_cache *, hc);
+        } while (hc != head);
+    if (nr >= HTTP_DATA_CACHE_NR){
+        hc = PREVQ(struct http_data_cache *, head);
+        DELQ(hc, head, struct http_data_cache *);
+        http_data_cache_free1(hc);
+    }
+    if ((hc = malloc(sizeof(*hc))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        free(data);
+        return NULL;
+    }
+    memset(hc, 0, sizeof(*hc));
+    hc->hc_data = data;
+    if ((hc->hc_path = strdup(path)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        http_data_cache_free1(hc);
+        return NULL;
+    }
+    hc->hc_dev = st->st_dev;
+    hc->hc_ino = st->st_ino;
+    hc->hc_size = st->st_size;
+    hc->hc_mtime = st->st_mtime;
+    INSQ(hc, head);
+    clicon_ptr_set(h, "http-data-cache", head);
+    return hc;
+}
+#endif /* HTTP_DATA_CACHE_NR */
+
+/*! Free cached http-data files
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @see HTTP_DATA_CACHE_NR
+ */
+int
+http_data_cache_free(clixon_handle h)
+{
+#ifdef HTTP_DATA_CACHE_NR
+    struct http_data_cache *head = NULL;
+    struct http_data_cache *hc;
+
+    clicon_ptr_get(h, "http-data-cache", (void**)&head);
+    while ((hc = head) != NULL){
+        DELQ(hc, head, struct http_data_cache *);
+        http_data_cache_free1(hc);
+    }
+    clicon_ptr_del(h, "http-data-cache");
+#endif
+    return 0;
+}
+
+/*! Read part of file
+ *
+ * @param[in]  fd    Open file
+ * @param[in]  off   Offset in file
+ * @param[in]  len   Length to read
+ * @param[out] buf   Buffer of at least len bytes
+ * @retval     1     OK
+ * @retval     0     Read error or file shorter than expected
+ */
+static int
+http_data_read(int    fd,
+               off_t  off,
+               size_t len,
+               char  *buf)
+{
+    ssize_t n;
+    size_t  totlen = 0;
+
+    while (totlen < len){
+        if ((n = pread(fd, buf + totlen, len - totlen, off + totlen)) <= 0){
+            clixon_debug(CLIXON_DBG_RESTCONF, "Error pread: %s", n<0?strerror(errno):"eof");
+            return 0;
+        }
+        totlen += n;
+    }
+    return 1;
+}
+
+/*! Use precompressed variant of file if it exists and client accepts gzip
+ *
+ * A variant is file with suffix .gz that is not older than file, eg index.html.gz
+ * @param[in]     h         Clixon handle
+ * @param[in]     req       Generic Www handle
+ * @param[in,out] cbfile    File path, suffix .gz is added if variant is used
+ * @param[in,out] fp        Open file, replaced by variant
+ * @param[in,out] st        Stat of open file, replaced by variant
+ * @retval        1         Variant used
+ * @retval        0         No variant or not accepted
+ * @retval       -1         Error
+ */
+static int
+http_data_gzip(clixon_handle h,
+               void         *req,
+               cbuf         *cbfile,
+               FILE        **fp,
+               struct stat  *st)
+{
+    int         retval = -1;
+    cbuf       *cb = NULL;
+    struct stat stgz;
+    FILE       *f;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s.gz", cbuf_get(cbfile));
+    if (lstat(cbuf_get(cb), &stgz) < 0 ||
+        !S_ISREG(stgz.st_mode) ||
+        stgz.st_mtime < st->st_mtime)
+        goto novariant;
+    /* Representation depends on Accept-Encoding */
+    if (restconf_reply_header(req, "Vary", "Accept-Encoding") < 0)
+        goto done;
+    if (restconf_accept_encoding(h, "gzip") == 0)
+        goto novariant;
+    if ((f = fopen(cbuf_get(cb), "rb")) == NULL)
+        goto novariant;
+    if (fstat(fileno(f), &stgz) < 0){
+        clixon_err(OE_UNIX, errno, "fstat");
+        fclose(f);
+        goto done;
+    }
+    fclose(*fp);
+    *fp = f;
+    *st = stgz;
+    cprintf(cbfile, ".gz");
+    if (restconf_reply_header(req, "Content-Encoding", "gzip") < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_RESTCONF, "%s", cbuf_get(cbfile));
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ novariant:
+    retval = 0;
+    goto done;
+}
+
+/*! Check If-None-Match and If-Modified-Since of request, RFC 9110 Sec 13.1
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  etag   Entity-tag of file
+ * @param[in]  mtime  Modification time of file
+ * @retval     1      Not modified, reply 304
+ * @retval     0      Modified or no conditional
+ */
+static int
+http_data_not_modified(clixon_handle h,
+                       const char   *etag,
+                       time_t        mtime)
+{
+    char  *str;
+    time_t t;
+
+    if ((str = restconf_param_get(h, "HTTP_IF_NONE_MATCH")) != NULL)
+        return strcmp(str, "*") == 0 || strstr(str, etag) != NULL;
+    if ((str = restconf_param_get(h, "HTTP_IF_MODIFIED_SINCE")) != NULL)
+        return restconf_http_date2time(str, &t) == 1 && mtime <= t;
+    return 0;
+}
+
+/*! Get single byte range of request, RFC 9110 Sec 14
+ *
+ * Only a single range is supported, otherwise the whole file is sent.
+ * If-Range with another entity-tag or date also sends the whole file.
+ * @param[in]  h      Clixon handle
+ * @param[in]  etag   Entity-tag of file
+ * @param[in]  mtime  Modification time of file
+ * @param[in]  size   Size of file
+ * @param[out] off    Offset of range
+ * @param[out] len    Length of range
+ * @retval     2      Range not satisfiable, reply 416
+ * @retval     1      Range, reply 206
+ * @retval     0      No range, reply whole file
+ */
+static int
+http_data_range(clixon_handle h,
+                const char   *etag,
+                time_t        mtime,
+                off_t         size,
+                off_t        *off,
+                size_t       *len)
+{
+    char              *str;
+    char              *p;
+    char              *e;
+    unsigned long long a;
+    unsigned long long b;
+    time_t             t;
+
+    if ((str = restconf_param_get(h, "HTTP_RANGE")) == NULL)
+        return 0;
+    if ((p = restconf_param_get(h, "HTTP_IF_RANGE")) != NULL){
+        if (p[0] == '"'){
+            if (strcmp(p, etag) != 0)
+                return 0;
+        }
+        else if (restconf_http_date2time(p, &t) == 0 || t != mtime)
+            return 0;
+    }
+    if (strncmp(str, "bytes=", 6) != 0 || strchr(str, ',') != NULL)
+        return 0;
+    p = str + 6;
+    if (*p == '-'){ /* Suffix range: last bytes */
+        a = strtoull(p+1, &e, 10);
+        if (e == p+1 || *e != '\0')
+            return 0;
+        if (a == 0 || size == 0)
+            return 2;
+        if (a > (unsigned long long)size)
+            a = size;
+        *off = size - a;
+        *len = a;
+        return 1;
+    }
+    a = strtoull(p, &e, 10);
+    if (e == p || *e != '-')
+        return 0;
+    p = e + 1;
+    if (*p == '\0')
+        b = size - 1;
+    else {
+        b = strtoull(p, &e, 10);
+        if (*e != '\0' || b < a)
+            return 0;
+    }
+    if (a >= (unsigned long long)size)
+        return 2;
+    if (b >= (unsigned long long)size)
+        b = size - 1;
+    *off = a;
+    *len = b - a + 1;
+    return 1;
+}
+
 /*! Read file data request
  *
+ * Replies have entity-tag and last-modified of the file, and conditional requests are
+ * replied with 304. A single byte range is supported.
+ * A precompressed variant (eg index.html.gz) is sent if the client accepts gzip.
+ * Small files are cached, see HTTP_DATA_CACHE_NR, larger are sent without reading
+ * them if possible, see restconf_reply_send_file
  * @param[in]  h         Clixon handle
  * @param[in]  req       Generic Www handle (can be part of clixon handle)
  * @param[in]  pathname  With stripped prefix (eg /data), ultimately a filename
  * @param[in]  head      HEAD not GET
  * @retval     0         OK
  * @retval    -1         Error
- * @note: primitive file handling, just check if file exists and read it all
- * XXX 1: Buffer copying once too many, see #if 0 below
  */
 static int
 api_http_data_file(clixon_handle h,
@@ -281,20 +608,28 @@ api_http_data_file(clixon_handle h,
                    char         *pathname,
                    int           head)
 {
-    int    retval = -1;
-    cbuf  *cbfile = NULL;
-    char  *filename = NULL;
-    cbuf  *cbdata = NULL;
-    FILE  *f = NULL;
-    off_t  fsz = 0;
-    long   fsize;
-    char  *www_data_root = NULL;
-    char  *suffix;
-    char  *media;
-    char  *buf = NULL;
-    size_t sz;
-    char  *media_list = NULL;
-    int    ret;
+    int         retval = -1;
+    cbuf       *cbfile = NULL;
+    char       *filename = NULL;
+    cbuf       *cbdata = NULL;
+    FILE       *f = NULL;
+    off_t       fsz = 0;
+    long        fsize;
+    char       *www_data_root = NULL;
+    char       *suffix;
+    char       *media;
+    char       *buf = NULL;
+    char       *media_list = NULL;
+    int         ret;
+    struct stat st;
+    char        etag[64];
+    char        lastmod[64];
+    int         code = 200;
+    off_t       off = 0;
+    size_t      len;
+#ifdef HTTP_DATA_CACHE_NR
+    struct http_data_cache *hc;
+#endif
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
     if ((cbfile = cbuf_new()) == NULL){
@@ -343,7 +678,7 @@ api_http_data_file(clixon_handle h,
             goto ok;
         }
     }
-    /* Size could have been taken from stat() but this reduces the race condition interval 
+    /* Size could have been taken from stat() but this reduces the race condition interval
      * There is still one without flock
      */
     fseek(f, 0, SEEK_END);
@@ -356,37 +691,104 @@ api_http_data_file(clixon_handle h,
             goto done;
         goto ok;
     }
-    fseek(f, 0, SEEK_SET);  /* same as rewind(f); */
-    if ((cbdata = cbuf_new_alloc(fsize+1)) == NULL){
+    if (fstat(fileno(f), &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat");
+        goto done;
+    }
+    /* Precompressed variant, eg index.html.gz */
+    if (http_data_gzip(h, req, cbfile, &f, &st) < 0)
+        goto done;
+    filename = cbuf_get(cbfile);
+    /* Entity-tag from inode, size and modification time, as eg nginx */
+    snprintf(etag, sizeof(etag), "\"%lx-%lx-%lx\"",
+             (unsigned long)st.st_ino, (unsigned long)st.st_size, (unsigned long)st.st_mtime);
+    strftime(lastmod, sizeof(lastmod), "%a, %d %b %Y %H:%M:%S GMT", gmtime(&st.st_mtime));
+    len = st.st_size;
+    if (http_data_not_modified(h, etag, st.st_mtime)){
+        code = 304;
+        goto headers;
+    }
+    if ((ret = http_data_range(h, etag, st.st_mtime, st.st_size, &off, &len)) == 2){
+        if (restconf_reply_header(req, "Content-Range", "bytes */%zu", (size_t)st.st_size) < 0)
+            goto done;
+        if (restconf_reply_send(req, 416, NULL, 0) < 0)
+            goto done;
+        goto ok;
+    }
+    if (ret == 1)
+        code = 206;
+    if ((cbdata = cbuf_new_alloc(len+1)) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
         goto done;
     }
-    /* Unoptimized, no direct read but requires an extra copy,
-     * the cligen buf API should have some mechanism for this case without the extra copy.
-     */
-    if ((buf = malloc(fsize)) == NULL){
+#ifdef HTTP_DATA_CACHE_NR
+    if (st.st_size <= HTTP_DATA_CACHE_FILE_MAX){
+        if ((hc = http_data_cache_find(h, filename, &st)) == NULL){
+            if ((buf = malloc(st.st_size+1)) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            if (http_data_read(fileno(f), 0, st.st_size, buf) == 0){
+                if (api_http_data_err(h, req, 500) < 0) /* Internal error? */
+                    goto done;
+                goto ok;
+            }
+            hc = http_data_cache_add(h, filename, &st, buf);
+            buf = NULL;
+            if (hc == NULL)
+                goto done;
+        }
+        if (cbuf_append_buf(cbdata, hc->hc_data + off, len) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+        goto headers;
+    }
+#endif
+    /* Send file without reading it if possible, eg sendfile */
+    if ((ret = restconf_reply_send_file(req, code, fileno(f), off, len, head)) < 0)
+        goto done;
+    if (ret == 1){
+        cbuf_free(cbdata);
+        cbdata = NULL;
+        goto headers;
+    }
+    if ((buf = malloc(len+1)) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
         goto done;
     }
-    if ((sz = fread(buf, fsize, 1, f)) == 0){
-        clixon_debug(CLIXON_DBG_RESTCONF, "Error fread(%s) err:%d", filename, ferror(f));
+    if (http_data_read(fileno(f), off, len, buf) == 0){
         if (api_http_data_err(h, req, 500) < 0) /* Internal error? */
             goto done;
         goto ok;
     }
-    if (sz != 1){
-        clixon_debug(CLIXON_DBG_RESTCONF, "Error fread(%s) sz:%zu", filename, sz);
-        if (api_http_data_err(h, req, 500) < 0) /* Internal error? */
+    if (cbuf_append_buf(cbdata, buf, len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+ headers:
+    if (restconf_reply_header(req, "ETag", "%s", etag) < 0)
+        goto done;
+    if (restconf_reply_header(req, "Last-Modified", "%s", lastmod) < 0)
+        goto done;
+    if (code == 304){
+        if (restconf_reply_send(req, 304, NULL, 0) < 0)
             goto done;
         goto ok;
     }
-    if (cbuf_append_buf(cbdata, buf, fsize) < 0){
-        clixon_err(OE_UNIX, errno, "cbuf_append_str");
+    if (restconf_reply_header(req, "Accept-Ranges", "bytes") < 0)
+        goto done;
+    if (code == 206 &&
+        restconf_reply_header(req, "Content-Range", "bytes %zu-%zu/%zu",
+                              (size_t)off, (size_t)off+len-1, (size_t)st.st_size) < 0)
         goto done;
-    }
     if (restconf_reply_header(req, "Content-Type", "%s", media) < 0)
         goto done;
-    if (restconf_reply_send(req, 200, cbdata, head) < 0)
+    if (cbdata == NULL){ /* Sent by restconf_reply_send_file */
+        clixon_debug(CLIXON_DBG_RESTCONF, "Send %s OK", filename);
+        goto ok;
+    }
+    if (restconf_reply_send(req, code, cbdata, head) < 0)
         goto done;
     cbdata = NULL; /* consumed by reply-send */
     clixon_debug(CLIXON_DBG_RESTCONF, "Read %s OK", filename);
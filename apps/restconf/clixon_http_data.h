@@ -43,5 +43,6 @@
  */
 int api_path_is_data(clixon_handle h);
 int api_http_data(clixon_handle h, void *req, cvec *qvec);
+int http_data_cache_free(clixon_handle h);
 
 #endif /* _CLIXON_HTTP_DATA_H_ */
@@ -55,7 +55,8 @@ enum restconf_media{
     YANG_PATCH_JSON,     /* "application/yang-patch+json" */
     YANG_PATCH_XML,      /* "application/yang-patch+xml" */
     YANG_PAGINATION_XML, /* draft-netconf-list-pagination-04.txt */
-    HTTP_DATA_TEXT_HTML  /* For http_data */
+    HTTP_DATA_TEXT_HTML, /* For http_data */
+    YANG_DATA_CBOR       /* "application/yang-data+cbor", RFC 9254 */
     /*   For JSON, the existing "application/yang-data+json" media type is
          sufficient, as the JSON format has built-in support for encoding
          arrays. */
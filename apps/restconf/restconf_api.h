@@ -45,6 +45,7 @@ int restconf_reply_header(void *req, const char *name, const char *vfmt, ...)  _
 
 /* note cb is consumed dont free */
 int restconf_reply_send(void *req, int code, cbuf *cb, int head);
+int restconf_reply_send_file(void *req, int code, int fd, off_t off, size_t len, int head);
 
 cbuf *restconf_get_indata(void *req);
 
@@ -218,7 +218,7 @@ restconf_reply_send(void  *req0,
     /* Write a body if cbuf is nonzero */
     if (cb != NULL){
         if (!head && cbuf_len(cb)){
-            FCGX_FPrintF(req->out, "%s", cbuf_get(cb));
+            FCGX_PutStr(cbuf_get(cb), cbuf_len(cb), req->out); /* May be binary, eg CBOR */
             FCGX_FPrintF(req->out, "\r\n");
         }
         cbuf_free(cb);
@@ -229,6 +229,27 @@ restconf_reply_send(void  *req0,
     return retval;
 }
 
+/*! Reply with a file as body, not supported by fcgi
+ *
+ * @param[in]  req   Fastcgi request handle
+ * @param[in]  code  Status code
+ * @param[in]  fd    Open file
+ * @param[in]  off   Offset of body in file
+ * @param[in]  len   Length of body
+ * @param[in]  head  Only send headers, dont send body.
+ * @retval     0     Not supported, use restconf_reply_send
+ */
+int
+restconf_reply_send_file(void  *req0,
+                         int    code,
+                         int    fd,
+                         off_t  off,
+                         size_t len,
+                         int    head)
+{
+    return 0;
+}
+
 /*! Get input data from http request, eg such as curl -X PUT http://... <indata>
  *
  * @param[in]  req        Fastcgi request handle
@@ -240,12 +261,22 @@ cbuf *
 restconf_get_indata(void *req0)
 {
     FCGX_Request *req = (FCGX_Request *)req0;
-    int           c;
+    char          buf[BUFSIZ];
+    int           n;
+    char         *str;
+    size_t        len = 0;
     cbuf         *cb = NULL;
 
-    if ((cb = cbuf_new()) == NULL)
+    /* Allocate whole body at once if length is known */
+    if ((str = FCGX_GetParam("CONTENT_LENGTH", req->envp)) != NULL)
+        len = strtoul(str, NULL, 10);
+    if ((cb = len ? cbuf_new_alloc(len + 2) : cbuf_new()) == NULL)
         return NULL;
-    while ((c = FCGX_GetChar(req->in)) != -1)
-        cprintf(cb, "%c", c);
+    /* Read in blocks */
+    while ((n = FCGX_GetStr(buf, sizeof(buf), req->in)) > 0)
+        if (cbuf_append_buf(cb, buf, n) < 0){
+            cbuf_free(cb);
+            return NULL;
+        }
     return cb;
 }
@@ -164,6 +164,12 @@ restconf_reply_send(void  *req0,
     sd->sd_code = code;
     if (cb != NULL){
         if (cbuf_len(cb)){
+            /* Content-Encoding, see CLICON_RESTCONF_COMPRESS_LEVEL */
+            if (sd->sd_conn &&
+                restconf_reply_compress(sd->sd_conn->rc_h, sd, &cb) < 0){
+                cbuf_free(cb);
+                goto done;
+            }
             sd->sd_body_len = cbuf_len(cb);
             if (head){
                 cbuf_free(cb);
@@ -185,6 +191,54 @@ restconf_reply_send(void  *req0,
     return retval;
 }
 
+/*! Reply with a file as body without reading it, for HTTP/1 only
+ *
+ * The file is sent by the kernel when the reply is written, see native_file_write
+ * @param[in]  req   http request handle
+ * @param[in]  code  Status code
+ * @param[in]  fd    Open file, is duplicated, the caller closes fd
+ * @param[in]  off   Offset of body in file
+ * @param[in]  len   Length of body
+ * @param[in]  head  Only send headers, dont send body.
+ * @retval     1     OK
+ * @retval     0     Not supported, use restconf_reply_send
+ * @retval    -1     Error
+ */
+int
+restconf_reply_send_file(void  *req0,
+                         int    code,
+                         int    fd,
+                         off_t  off,
+                         size_t len,
+                         int    head)
+{
+    int                   retval = -1;
+    restconf_stream_data *sd = (restconf_stream_data *)req0;
+
+    clixon_debug(CLIXON_DBG_RESTCONF, "code:%d off:%zu len:%zu", code, (size_t)off, len);
+    if (sd == NULL){
+        clixon_err(OE_CFG, EINVAL, "sd is NULL");
+        goto done;
+    }
+    if (sd->sd_conn == NULL ||
+        (sd->sd_conn->rc_proto != HTTP_10 && sd->sd_conn->rc_proto != HTTP_11)){
+        retval = 0;
+        goto done;
+    }
+    if (!head && len){
+        if ((sd->sd_fd = dup(fd)) < 0){
+            clixon_err(OE_UNIX, errno, "dup");
+            goto done;
+        }
+    }
+    sd->sd_code = code;
+    sd->sd_body_offset = off;
+    sd->sd_body_len = len;
+    retval = 1;
+ done:
+    return retval;
+}
+
 /*! Get input data from http request, eg such as curl -X PUT http://... <indata>
  *
  * @param[in]  req        Request handle
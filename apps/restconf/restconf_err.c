@@ -279,6 +279,8 @@ api_return_err(clixon_handle  h,
                 code = 404; /* Not found */
         }
     }
+    if (media == YANG_DATA_CBOR) /* Errors are not encoded in CBOR, use JSON */
+        media = YANG_DATA_JSON;
     if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media)) < 0) // XXX
         goto done;
     switch (media){
@@ -42,6 +42,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <syslog.h>
 #include <errno.h>
@@ -64,182 +65,335 @@
 #include "restconf_native.h"
 #include "restconf_api.h"
 #include "restconf_err.h"
-#include "clixon_http1_parse.h"
 #include "restconf_http1.h"
 #include "clixon_http_data.h"
 #include "restconf_stream.h"
+#include "restconf_metrics.h"
 
-/* Size of xml read buffer */
-#define BUFLEN 1024
+/*
+ * Types
+ */
+/* Slice of the receive buffer, not null-terminated */
+typedef struct {
+    char  *hs_ptr;
+    size_t hs_len;
+} http1_slice;
+
+/* Header field slices */
+typedef struct {
+    http1_slice hf_name;
+    http1_slice hf_value;
+} http1_field;
+
+/* Request-line and header-field slices of a HTTP/1 request, see http1_parse_request */
+typedef struct {
+    http1_slice hr_method;
+    http1_slice hr_path;
+    http1_slice hr_query;
+    int         hr_d1;     /* HTTP version digit 1 */
+    int         hr_d2;     /* HTTP version digit 2 */
+    int         hr_nfields;
+    http1_field hr_fields[HTTP1_FIELDS_MAX];
+} http1_request;
+
+/*! Is character a tchar of a HTTP token (RFC 7230 Sec 3.2.6)
+ */
+static inline int
+http1_tchar(char c)
+{
+    return c != '\0' && (isalnum(c & 0xff) || strchr("!#$%&'*+-.^_`|~", c) != NULL);
+}
+
+/*! Is character a pchar of an URI path segment (RFC 3986 Sec 3.3), except pct-encoded
+ */
+static inline int
+http1_pchar(char c)
+{
+    return c != '\0' && (isalnum(c & 0xff) || strchr("-._~!$&'()*+,;=:@", c) != NULL);
+}
 
-/*! HTTP/1 parsing function. Input is string and side-effect is populating connection structs
+/*! Scan an URI path or query in the request-target
  *
- * @param[in]  h        Clixon handle
- * @param[in]  rc       Restconf connection
- * @param[in]  str      Pointer to string containing HTTP/1 
- * @param[in]  filename Debug string identifying file or connection
- * @retval     0        Parse OK 
- * @retval    -1        Error
+ * @param[in]  p      Start of path or query
+ * @param[in]  end    End of header section
+ * @param[in]  query  If set, also accept "/" and "?" (query), otherwise "/" only (path)
+ * @retval     p      Pointer to first character not in the path or query
  */
-static int
-_http1_parse(clixon_handle  h,
-             restconf_conn *rc,
-             char          *str,
-             const char    *filename)
+static char *
+http1_scan_uri(char  *p,
+               char  *end,
+               int    query)
 {
-    int               retval = -1;
-    clixon_http1_yacc hy = {0,};
-    int               ret;
-
-    clixon_debug(CLIXON_DBG_PARSE, "%s", str);
-    if (strlen(str) == 0)
-        goto ok;
-    hy.hy_parse_string = str;
-    hy.hy_name = filename;
-    hy.hy_h = h;
-    hy.hy_rc = rc;
-    hy.hy_linenum = 1;
-    if (http1_scan_init(&hy) < 0)
-        goto done;
-    if (http1_parse_init(&hy) < 0)
-        goto done;
-    ret = clixon_http1_parseparse(&hy); /* yacc returns 1 on error */
-    /* yacc/lex terminates parsing after headers. 
-     * Look for body after headers assuming str terminating with \n\n\0 and then <body> */
-    http1_parse_exit(&hy);
-    http1_scan_exit(&hy);
-    if (ret != 0){
-        if (filename)
-            clixon_log(h, LOG_NOTICE, "HTTP1 error: on line %d in %s", hy.hy_linenum, filename);
+    while (p < end){
+        if (http1_pchar(*p) || *p == '/' || (query && *p == '?'))
+            p++;
+        else if (*p == '%' && end - p > 2 &&
+                 isxdigit(p[1] & 0xff) && isxdigit(p[2] & 0xff))
+            p += 3;
         else
-            clixon_log(h, LOG_NOTICE, "HTTP1 error: on line %d", hy.hy_linenum);
-        if (clixon_err_category() == 0)
-            clixon_err(OE_RESTCONF, 0, "HTTP1 parser error with no error code (should not happen)");
-        goto done;
+            break;
     }
- ok:
-    retval = 0;
- done:
-    clixon_debug(CLIXON_DBG_PARSE, "retval:%d", retval);
-    return retval;
+    return p;
 }
 
-/*! HTTP/1 parsing function from file
+/*! Find end of HTTP/1 request header section, ie the empty line "\r\n\r\n"
  *
- * @param[in]  h        Clixon handle
- * @param[in]  rc       Restconf connection
- * @param[in]  f        A file descriptor containing HTTP/1 (as ASCII characters)
- * @param[in]  filename Debug string identifying file or connection
- * @retval     0        Parse OK 
- * @retval    -1        Error
+ * Incremental: search starts close to where the previous search ended, so that a request
+ * received in many reads is not rescanned from the start.
+ * @param[in]  buf     Receive buffer
+ * @param[in]  len     Length of receive buffer
+ * @param[in]  prevlen Length of receive buffer at previous search
+ * @retval     n       Length of header section including the empty line
+ * @retval     0       Incomplete, read more
  */
-int
-clixon_http1_parse_file(clixon_handle  h,
-                        restconf_conn *rc,
-                        FILE          *f,
-                        const char    *filename)
+static size_t
+http1_header_end(char  *buf,
+                 size_t len,
+                 size_t prevlen)
 {
-    int   retval = -1;
-    char  ch;
-    char *buf = NULL;
-    char *ptr;
-    int   buflen = BUFLEN; /* start size */
-    int   len = 0;
-    int   oldbuflen;
-    size_t sz;
-
-    clixon_debug(CLIXON_DBG_RESTCONF, "%s", filename);
-    if (f == NULL){
-        clixon_err(OE_RESTCONF, EINVAL, "f is NULL");
-        goto done;
+    char *p;
+    char *end = buf + len;
+
+    p = buf + (prevlen > 3 ? prevlen - 3 : 0);
+    while ((p = memchr(p, '\r', end - p)) != NULL){
+        if (end - p < 4)
+            break;
+        if (p[1] == '\n' && p[2] == '\r' && p[3] == '\n')
+            return p + 4 - buf;
+        p++;
     }
-    if ((buf = malloc(buflen)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
-        goto done;
+    return 0;
+}
+
+/*! Parse HTTP/1 request-line and header-fields in place, report slices without copying
+ *
+ * picohttpparser-style: the buffer is not modified, slices point into the buffer.
+ * The header section must be complete, see http1_header_end
+ * request-line = method SP request-target SP HTTP-version CRLF
+ * header-field = field-name ":" OWS field-value OWS
+ * @param[in]  buf    Start of request, leading empty lines skipped
+ * @param[in]  hlen   Length of header section including the empty line
+ * @param[out] hr     Request slices
+ * @retval     0      OK
+ * @retval    -1      Malformed request, clixon_err is set
+ * @see RFC 7230 Sec 3
+ */
+static int
+http1_parse_request(char          *buf,
+                    size_t         hlen,
+                    http1_request *hr)
+{
+    char        *p = buf;
+    char        *end = buf + hlen;
+    http1_field *hf;
+
+    memset(hr, 0, sizeof(*hr));
+    /* method = token */
+    hr->hr_method.hs_ptr = p;
+    while (http1_tchar(*p))
+        p++;
+    if ((hr->hr_method.hs_len = p - hr->hr_method.hs_ptr) == 0 || *p++ != ' ')
+        goto malformed;
+    /* origin-form = absolute-path [ "?" query ] */
+    if (*p != '/')
+        goto malformed;
+    hr->hr_path.hs_ptr = p;
+    p = http1_scan_uri(p, end, 0);
+    hr->hr_path.hs_len = p - hr->hr_path.hs_ptr;
+    if (*p == '?'){
+        hr->hr_query.hs_ptr = ++p;
+        p = http1_scan_uri(p, end, 1);
+        hr->hr_query.hs_len = p - hr->hr_query.hs_ptr;
     }
-    memset(buf, 0, buflen);
-    ptr = buf;
-    while (1){
-        if ((sz = fread(&ch, 1, 1, f)) == 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (sz == 0) { /* buffer read */
-            if (feof(f)){
-                if (_http1_parse(h, rc, ptr, filename) < 0)
-                    goto done;
-                break;
-            }
-            else{
-                clixon_err(OE_XML, 0, "fread(%s)", filename);
-                goto done;
-            }
-        }
-        buf[len++] = ch;
-        if (len >= buflen-1){ /* Space: one for the null character */
-            oldbuflen = buflen;
-            buflen *= 2;
-            if ((buf = realloc(buf, buflen)) == NULL){
-                clixon_err(OE_XML, errno, "realloc");
-                goto done;
-            }
-            memset(buf+oldbuflen, 0, buflen-oldbuflen);
-            ptr = buf;
+    if (*p++ != ' ')
+        goto malformed;
+    /* HTTP-version = HTTP-name "/" DIGIT "." DIGIT */
+    if (end - p < 10 ||
+        strncmp(p, "HTTP/", 5) != 0 ||
+        !isdigit(p[5] & 0xff) || p[6] != '.' || !isdigit(p[7] & 0xff) ||
+        p[8] != '\r' || p[9] != '\n')
+        goto malformed;
+    hr->hr_d1 = p[5] - '0';
+    hr->hr_d2 = p[7] - '0';
+    p += 10;
+    /* *( header-field CRLF ) CRLF */
+    while (!(p[0] == '\r' && p[1] == '\n')){
+        if (hr->hr_nfields == HTTP1_FIELDS_MAX){
+            clixon_err(OE_RESTCONF, 0, "Too many header fields");
+            return -1;
         }
-    } /* while */
-    retval = 0;
- done:
-    if (buf)
-        free(buf);
-    return retval;
+        hf = &hr->hr_fields[hr->hr_nfields++];
+        hf->hf_name.hs_ptr = p;
+        while (http1_tchar(*p))
+            p++;
+        if ((hf->hf_name.hs_len = p - hf->hf_name.hs_ptr) == 0 || *p++ != ':')
+            goto malformed;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        hf->hf_value.hs_ptr = p;
+        while (*p != '\r' && *p != '\n')
+            p++;
+        if (p[0] != '\r' || p[1] != '\n')
+            goto malformed;
+        hf->hf_value.hs_len = p - hf->hf_value.hs_ptr;
+        while (hf->hf_value.hs_len &&
+               (hf->hf_value.hs_ptr[hf->hf_value.hs_len-1] == ' ' ||
+                hf->hf_value.hs_ptr[hf->hf_value.hs_len-1] == '\t'))
+            hf->hf_value.hs_len--;
+        p += 2;
+    }
+    return 0;
+ malformed:
+    clixon_err(OE_RESTCONF, 0, "Malformed HTTP/1 request at or before: '%.16s'", p > buf ? p - 1 : p);
+    return -1;
 }
 
-/*! HTTP/1 parsing function from string
+/*! Null-terminate a slice in place, the byte after the slice is a consumed delimiter
  *
- * @param[in]  h        Clixon handle
- * @param[in]  rc       Restconf connection
- * @param[in]  str      HTTP/1 string
- * @retval     0        Parse OK 
- * @retval    -1        Error
+ * Runs of whitespace inside a header field value are replaced with a single space
+ * @param[in]  hs  Slice
+ * @retval     str Null-terminated string in receive buffer
+ */
+static char *
+http1_slice_str(http1_slice *hs)
+{
+    char  *s = hs->hs_ptr;
+    size_t i;
+    size_t j = 0;
+
+    for (i = 0; i < hs->hs_len; i++){
+        if (s[i] == '\t')
+            s[i] = ' ';
+        if (s[i] == ' ' && j > 0 && s[j-1] == ' ')
+            continue;
+        s[j++] = s[i];
+    }
+    s[j] = '\0';
+    return s;
+}
+
+/*! Append received request body to sd_indata up to Content-Length
+ *
+ * Content-Length is parsed once into sd_inlen by clixon_http1_parse_inbuf
+ * @param[in]  h    Clixon handle
+ * @param[in]  sd   Restconf stream data (for http1 only stream 0)
+ * @param[in]  buf  Received data
+ * @param[in]  n    Length of received data
+ * @param[out] used Bytes belonging to the body, remaining bytes start next pipelined request
+ * @retval     0    OK
+ * @retval    -1    Error
  */
 int
-clixon_http1_parse_string(clixon_handle  h,
-                          restconf_conn *rc,
-                          char          *str)
+http1_body_append(clixon_handle         h,
+                  restconf_stream_data *sd,
+                  char                 *buf,
+                  size_t                n,
+                  size_t               *used)
 {
-    return _http1_parse(h, rc, str, "http1-parse");
+    size_t len = 0;
+
+    if (sd->sd_inlen > cbuf_len(sd->sd_indata))
+        len = sd->sd_inlen - cbuf_len(sd->sd_indata);
+    if (len > n)
+        len = n;
+    if (len && cbuf_append_buf(sd->sd_indata, buf, len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        return -1;
+    }
+    *used = len;
+    return 0;
 }
 
-/*! HTTP/1 parsing function from buffer (non-null terminated)
+/*! Incremental HTTP/1 parsing of receive buffer. Side-effect is populating connection structs
  *
- * Convert buffer to null-terminated string
+ * The receive buffer sd_inbuf is parsed in place once the header section is complete.
+ * The header section is removed from sd_inbuf, body bytes up to Content-Length are moved
+ * to sd_indata, and bytes of a following pipelined request are kept in sd_inbuf.
  * @param[in]  h        Clixon handle
  * @param[in]  rc       Restconf connection
- * @param[in]  buf      HTTP/1 buffer
- * @param[in]  n        Length of buffer
- * @retval     0        Parse OK 
- * @retval    -1        Error
- * @note  Had preferred to do this without copying, OR 
- * input flex with a non-null terminated string
+ * @param[in]  sd       Restconf stream data (for http1 only stream 0)
+ * @param[in]  prevlen  Length of sd_inbuf at previous call for the same request, or 0
+ * @retval     1        OK, request-line and header-fields parsed
+ * @retval     0        Incomplete header section, read more
+ * @retval    -1        Error or malformed request
  */
 int
-clixon_http1_parse_buf(clixon_handle  h,
-                       restconf_conn *rc,
-                       char          *buf,
-                       size_t         n)
+clixon_http1_parse_inbuf(clixon_handle         h,
+                         restconf_conn        *rc,
+                         restconf_stream_data *sd,
+                         size_t                prevlen)
 {
-    char *str = NULL;
-    int   ret;
+    int           retval = -1;
+    http1_request hr;
+    char         *buf;
+    size_t        len;
+    size_t        skip = 0;
+    size_t        hlen;
+    size_t        used;
+    char         *val;
+    int           i;
 
-    if ((str = malloc(n+1)) == NULL){
-        clixon_err(OE_RESTCONF, errno, "malloc");
-        return -1;
+    buf = cbuf_get(sd->sd_inbuf);
+    len = cbuf_len(sd->sd_inbuf);
+    /* Ignore empty lines before request-line, RFC 7230 Sec 3.5 */
+    while (len - skip >= 2 && buf[skip] == '\r' && buf[skip+1] == '\n')
+        skip += 2;
+    if ((hlen = http1_header_end(buf + skip, len - skip, prevlen > skip ? prevlen - skip : 0)) == 0){
+        if (len > HTTP1_HEADER_MAX){
+            clixon_err(OE_RESTCONF, 0, "Request header section too large");
+            goto done;
+        }
+        retval = 0;
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_PARSE, "%.*s", (int)hlen, buf + skip);
+    if (http1_parse_request(buf + skip, hlen, &hr) < 0)
+        goto done;
+    if (restconf_param_set(h, "REQUEST_METHOD", http1_slice_str(&hr.hr_method)) < 0)
+        goto done;
+    /* Not according to standards: trailing / */
+    if (hr.hr_path.hs_len > 1 && hr.hr_path.hs_ptr[hr.hr_path.hs_len-1] == '/')
+        hr.hr_path.hs_len--;
+    if (restconf_param_set(h, "REQUEST_URI", http1_slice_str(&hr.hr_path)) < 0)
+        goto done;
+    if (hr.hr_query.hs_len){
+        clixon_debug(CLIXON_DBG_DEFAULT, "?%.*s", (int)hr.hr_query.hs_len, hr.hr_query.hs_ptr);
+        if (uri_str2cvec(http1_slice_str(&hr.hr_query), '&', '=', 1, &sd->sd_qvec) < 0)
+            goto done;
+    }
+    /* make sanity check later */
+    rc->rc_proto_d1 = hr.hr_d1;
+    rc->rc_proto_d2 = hr.hr_d2;
+    clixon_debug(CLIXON_DBG_DEFAULT, "http/%d.%d", hr.hr_d1, hr.hr_d2);
+    for (i = 0; i < hr.hr_nfields; i++){
+        if (hr.hr_fields[i].hf_value.hs_len == 0)
+            continue;
+        if (restconf_convert_hdr(h,
+                                 http1_slice_str(&hr.hr_fields[i].hf_name),
+                                 http1_slice_str(&hr.hr_fields[i].hf_value)) < 0)
+            goto done;
+    }
+    /* Preallocate body buffer, remaining body is appended in restconf_http1_process */
+    sd->sd_inlen = 0;
+    if ((val = restconf_param_get(h, "HTTP_CONTENT_LENGTH")) != NULL){
+        if (restconf_content_length(val, &sd->sd_inlen) == 0){
+            clixon_err(OE_RESTCONF, 0, "Invalid Content-Length: %s", val);
+            goto done;
+        }
+        if (restconf_stream_indata_alloc(sd, sd->sd_inlen) < 0)
+            goto done;
     }
-    memcpy(str, buf, n);
-    str[n] = '\0';
-    ret = _http1_parse(h, rc, str, "http1-parse");
-    free(str);
-    return ret;
+    hlen += skip;
+    if (http1_body_append(h, sd, buf + hlen, len - hlen, &used) < 0)
+        goto done;
+    /* Keep start of next pipelined request */
+    hlen += used;
+    memmove(buf, buf + hlen, len - hlen);
+    cbuf_trunc(sd->sd_inbuf, len - hlen);
+    retval = 1;
+ done:
+    clixon_debug(CLIXON_DBG_PARSE, "retval:%d", retval);
+    return retval;
 }
 
 #ifdef HAVE_LIBNGHTTP2
@@ -314,8 +468,9 @@ restconf_http1_reply(restconf_conn        *rc,
      * server MUST NOT send a Content-Length header field in any 2xx
      * (Successful) response to a CONNECT request (Section 4.3.6 of
      * [RFC7231]).
+     * A 304 (Not Modified) has no body, and a Content-Length would be that of the 200 reply
      */
-    if (sd->sd_code != 204 && sd->sd_code > 199 && !rc->rc_event_stream)
+    if (sd->sd_code != 204 && sd->sd_code != 304 && sd->sd_code > 199 && !rc->rc_event_stream)
         if (restconf_reply_header(sd, "Content-Length", "%zu", sd->sd_body_len) < 0)
             goto done;
     /* Create reply and write headers */
@@ -366,11 +521,11 @@ restconf_http1_path_root(clixon_handle  h,
     char                 *subject = NULL;
     cxobj                *xerr = NULL;
     int                   pretty;
-#ifdef HAVE_LIBNGHTTP2
     int                   ret;
-#endif
+    struct timespec       t0;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "------------");
+    event_profile_start(&t0);
     pretty = restconf_pretty_get(h);
     if ((sd = restconf_stream_find(rc, 0)) == NULL){
         clixon_err(OE_RESTCONF, EINVAL, "No stream_data");
@@ -436,6 +591,11 @@ restconf_http1_path_root(clixon_handle  h,
     if (ret == 0) /* upgrade */
         goto upgrade;
 #endif
+    /* Decode request body with Content-Encoding, may reply error */
+    if ((ret = restconf_content_decode(h, sd)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
     /* Matching algorithm:
      * 1. try well-known
      * 2. try /restconf
@@ -447,6 +607,10 @@ restconf_http1_path_root(clixon_handle  h,
         if (api_well_known(h, sd) < 0)
             goto done;
     }
+    else if (api_path_is_metrics(h)){
+        if (api_metrics(h, sd) < 0)
+            goto done;
+    }
     else if (api_path_is_restconf(h)){
         if (api_root_restconf(h, sd, sd->sd_qvec) < 0)
             goto done;
@@ -463,6 +627,9 @@ restconf_http1_path_root(clixon_handle  h,
     else
         sd->sd_code = 404; /* catch all without body/media */
  fail:
+    if (sd->sd_code)
+        restconf_metrics_request(restconf_param_get(h, "REQUEST_METHOD"), sd->sd_code,
+                                 event_profile_usec(&t0));
    if (restconf_param_del_all(h) < 0)
         goto done;
 #ifdef HAVE_LIBNGHTTP2
@@ -532,15 +699,12 @@ http1_check_content_length(clixon_handle         h,
                            restconf_stream_data *sd,
                            int                  *status)
 {
-    int   retval = -1;
-    char *val;
-    int   len;
+    int retval = -1;
 
-    if ((val = restconf_param_get(h, "HTTP_CONTENT_LENGTH")) == NULL ||
-        (len = atoi(val)) == 0)
+    if (sd->sd_inlen == 0)
         *status = 0;
     else{
-        if (cbuf_len(sd->sd_indata) < len)
+        if (cbuf_len(sd->sd_indata) < sd->sd_inlen)
             *status = 1;
         else
             *status = 2;
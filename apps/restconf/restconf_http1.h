@@ -36,12 +36,23 @@
 #ifndef _RESTCONF_HTTP1_H_
 #define _RESTCONF_HTTP1_H_
 
+/*
+ * Constants
+ */
+/* Max number of header fields of a HTTP/1 request */
+#define HTTP1_FIELDS_MAX 64
+
+/* Max size of request-line and header fields of a HTTP/1 request */
+#define HTTP1_HEADER_MAX (64*1024)
+
+/* Max pipelined requests of a connection processed before other connections are served */
+#define HTTP1_PIPELINE_BATCH 16
+
 /*
  * Prototypes
  */
-int clixon_http1_parse_file(clixon_handle h, restconf_conn *rc, FILE *f, const char *filename);
-int clixon_http1_parse_string(clixon_handle h, restconf_conn *rc, char *str);
-int clixon_http1_parse_buf(clixon_handle h, restconf_conn *rc, char *buf, size_t n);
+int http1_body_append(clixon_handle h, restconf_stream_data *sd, char *buf, size_t n, size_t *used);
+int clixon_http1_parse_inbuf(clixon_handle h, restconf_conn *rc, restconf_stream_data *sd, size_t prevlen);
 int restconf_http1_path_root(clixon_handle h, restconf_conn *rc);
 int http1_check_expect(clixon_handle h, restconf_conn *rc, restconf_stream_data *sd);
 int http1_check_content_length(clixon_handle h, restconf_stream_data *sd, int *status);
@@ -209,6 +209,7 @@ static const map_str2int http_media_map[] = {
     {"application/yang-patch+json",      YANG_PATCH_JSON},
     {"application/yang-data+xml-list",   YANG_PAGINATION_XML},  /* sdraft-netconf-list-pagination-04.txt */
     {"text/html",                        HTTP_DATA_TEXT_HTML}, /* for http_data */
+    {"application/yang-data+cbor",       YANG_DATA_CBOR},      /* RFC 9254 */
     {NULL,                              -1}
 };
 
@@ -326,6 +327,74 @@ restconf_proto2str(int proto)
     return clicon_int2str(http_proto_map, proto);
 }
 
+/*! Check if content-coding is accepted by client in Accept-Encoding, see RFC 9110 Sec 12.5.3
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  coding  Content-coding, eg gzip
+ * @retval     1       Accepted, or by "*" if not given explicitly
+ * @retval     0       Not accepted, or with q=0
+ */
+int
+restconf_accept_encoding(clixon_handle h,
+                         const char   *coding)
+{
+    char  *str;
+    char  *p;
+    char  *e;
+    char  *q;
+    size_t len;
+    size_t clen = strlen(coding);
+    int    q0;
+    int    star = 0;
+
+    if ((str = restconf_param_get(h, "HTTP_ACCEPT_ENCODING")) == NULL)
+        return 0;
+    for (p = str; *p != '\0'; p = *e ? e + 1 : e){
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if ((e = strchr(p, ',')) == NULL)
+            e = p + strlen(p);
+        len = strcspn(p, " \t;,");
+        q = p + len;
+        while (*q == ' ' || *q == '\t' || *q == ';')
+            q++;
+        /* q=0, q=0.0 etc means not acceptable */
+        q0 = (q < e && (*q == 'q' || *q == 'Q') && q[1] == '=' && strtod(q+2, NULL) == 0.0);
+        if (len == clen && strncasecmp(p, coding, clen) == 0)
+            return !q0;
+        if (len == 1 && *p == '*')
+            star = !q0;
+    }
+    return star;
+}
+
+/*! Translate HTTP-date to time, eg "Sun, 06 Nov 1994 08:49:37 GMT", see RFC 9110 Sec 5.6.7
+ *
+ * @param[in]  str  HTTP-date in IMF-fixdate format
+ * @param[out] t    Time
+ * @retval     1    OK
+ * @retval     0    Invalid or other format
+ */
+int
+restconf_http_date2time(const char *str,
+                        time_t     *t)
+{
+    struct tm   tm = {0,};
+    char        mon[4];
+    const char *months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    const char *p;
+
+    if (sscanf(str, "%*3s, %d %3s %d %d:%d:%d GMT",
+               &tm.tm_mday, mon, &tm.tm_year, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6 ||
+        strlen(mon) != 3 ||
+        (p = strstr(months, mon)) == NULL)
+        return 0;
+    tm.tm_mon = (p - months) / 3;
+    tm.tm_year -= 1900;
+    *t = timegm(&tm);
+    return 1;
+}
+
 /*! Return media_in from Content-Type, -1 if not found or unrecognized
  *
  * @note media-type syntax does not support parameters
@@ -55,7 +55,8 @@ enum restconf_media{
     YANG_PATCH_JSON,     /* "application/yang-patch+json" */
     YANG_PATCH_XML,      /* "application/yang-patch+xml" */
     YANG_PAGINATION_XML, /* draft-netconf-list-pagination-04.txt */
-    HTTP_DATA_TEXT_HTML  /* For http_data */
+    HTTP_DATA_TEXT_HTML, /* For http_data */
+    YANG_DATA_CBOR       /* "application/yang-data+cbor", RFC 9254 */
 };
 typedef enum restconf_media restconf_media;
 
@@ -90,6 +91,8 @@ const restconf_media restconf_media_list_str2int(char *list);
 const char *restconf_media_int2str(restconf_media media);
 int   restconf_str2proto(char *str);
 const char *restconf_proto2str(int proto);
+int   restconf_accept_encoding(clixon_handle h, const char *coding);
+int   restconf_http_date2time(const char *str, time_t *t);
 restconf_media restconf_content_type(clixon_handle h);
 int   restconf_convert_hdr(clixon_handle h, char *name, char *val);
 int   get_user_cookie(char *cookiestr, char  *attribute, char **val);
@@ -221,6 +221,10 @@ static clixon_handle _CLIXON_HANDLE = NULL;
  */
 static int _MYSOCK;
 
+/* Pids of forked worker processes, see CLICON_RESTCONF_WORKERS */
+static pid_t *_workers = NULL;
+static int    _nworkers = 0;
+
 /*! Signal terminates process
  */
 static void
@@ -259,6 +263,73 @@ restconf_sig_child(int arg)
         stream_child_free(_CLIXON_HANDLE, pid);
 }
 
+/*! Fork worker processes that accept FCGI requests on the same socket
+ *
+ * Each worker, and this process, runs its own FCGI accept loop with its own backend
+ * session, so that a reverse proxy may spread requests over several cores.
+ * A notification stream blocks the accept loop of the process that serves it, but not
+ * the other processes.
+ * @param[in]  h   Clixon handle
+ * @retval     1   OK, this is the parent, or no workers
+ * @retval     0   OK, this is a worker
+ * @retval    -1   Error
+ * @see CLICON_RESTCONF_WORKERS  Number of processes, including this
+ */
+static int
+restconf_workers_start(clixon_handle h)
+{
+    pid_t pid;
+    int   n;
+    int   s;
+    int   i;
+
+    if ((n = clicon_option_int(h, "CLICON_RESTCONF_WORKERS")) <= 1)
+        return 1;
+    if ((_workers = calloc(n - 1, sizeof(pid_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    for (i = 0; i < n - 1; i++){
+        if ((pid = fork()) < 0){
+            clixon_err(OE_UNIX, errno, "fork");
+            return -1;
+        }
+        if (pid == 0){ /* worker */
+            free(_workers);
+            _workers = NULL;
+            _nworkers = 0;
+            /* Open own backend session on first request */
+            if ((s = clicon_client_socket_get(h)) >= 0){
+                clixon_shm_close(s);
+                close(s);
+                clicon_client_socket_set(h, -1);
+            }
+            clicon_session_id_del(h);
+            clixon_debug(CLIXON_DBG_RESTCONF, "worker %d pid %u", i + 1, getpid());
+            return 0;
+        }
+        _workers[_nworkers++] = pid;
+    }
+    return 1;
+}
+
+/*! Terminate and wait for worker processes
+ */
+static void
+restconf_workers_stop(void)
+{
+    int i;
+
+    for (i = 0; i < _nworkers; i++)
+        kill(_workers[i], SIGTERM);
+    for (i = 0; i < _nworkers; i++)
+        waitpid(_workers[i], NULL, 0);
+    if (_workers)
+        free(_workers);
+    _workers = NULL;
+    _nworkers = 0;
+}
+
 /*! Usage help routine
  *
  * @param[in]  h      Clixon handle
@@ -641,7 +712,9 @@ main(int    argc,
      * @see clicon_hello_req
      */
     clicon_data_set(h, "session-transport", "cl:restconf");
-
+    /* Fork workers accepting on the same FCGI socket */
+    if (restconf_workers_start(h) < 0)
+        goto done;
     if (FCGX_InitRequest(req, sock, 0) != 0){
         clixon_err(OE_CFG, errno, "FCGX_InitRequest");
         goto done;
@@ -727,6 +800,7 @@ main(int    argc,
  ok:
     retval = 0;
  done:
+    restconf_workers_stop();
     if (h){
         stream_child_freeall(h);
         restconf_terminate(h);
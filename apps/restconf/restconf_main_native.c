@@ -118,13 +118,17 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
 #include <string.h>
 #include <syslog.h>
 #include <pwd.h>
 #include <ctype.h>
 #include <signal.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <sys/resource.h>
@@ -133,6 +137,10 @@
 #include <openssl/rand.h>
 #include <openssl/err.h>
 #include <openssl/x509v3.h>
+#include <openssl/hmac.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
 
 #ifdef HAVE_LIBNGHTTP2
 #include <nghttp2/nghttp2.h>
@@ -150,7 +158,9 @@
 #include "restconf_api.h"       /* generic not shared with plugins */
 #include "restconf_err.h"
 #include "restconf_root.h"
+#include "clixon_http_data.h"
 #include "restconf_native.h"   /* Restconf-openssl mode specific headers*/
+#include "restconf_metrics.h"
 #ifdef HAVE_LIBNGHTTP2
 #include "restconf_nghttp2.h"  /* http/2 */
 #endif
@@ -183,6 +193,16 @@
 
 static int             session_id_context = 1;
 
+/* Secret of session ticket keys, made before workers are started so that all share it */
+static unsigned char   ticket_secret[32];
+
+/* Rotation interval of session ticket keys in seconds, see CLICON_RESTCONF_TLS_TICKET_ROTATE */
+static uint32_t        ticket_rotate = 0;
+
+/* Pids of forked worker processes, see CLICON_RESTCONF_WORKERS */
+static pid_t          *_workers = NULL;
+static int             _nworkers = 0;
+
 /*! Set restconf native handle
  *
  * @param[in]  h    Clixon handle
@@ -365,6 +385,115 @@ alpn_select_proto_cb(SSL                  *ssl,
     return SSL_TLSEXT_ERR_OK;
 }
 
+/*! Derive a session ticket key of a rotation interval from the ticket secret
+ *
+ * @param[in]  epoch  Rotation interval, time divided by ticket_rotate
+ * @param[in]  label  Use of key, at most 8 characters
+ * @param[out] key    Key of 32 bytes
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+restconf_ticket_key(uint64_t     epoch,
+                    const char  *label,
+                    unsigned char *key)
+{
+    unsigned char data[16] = {0,};
+    unsigned int  len = 32;
+    int           i;
+
+    strncpy((char*)data, label, 8);
+    for (i=0; i<8; i++)
+        data[8+i] = (epoch >> (56-8*i)) & 0xff;
+    if (HMAC(EVP_sha256(), ticket_secret, sizeof(ticket_secret), data, sizeof(data), key, &len) == NULL){
+        clixon_err(OE_SSL, 0, "HMAC");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Session ticket key callback: encrypt with key of current interval, decrypt also previous
+ *
+ * The key name is a tag derived from the secret followed by the interval, so that keys need
+ * not be stored and all workers derive the same keys
+ * @param[in]     ssl      SSL connection
+ * @param[in,out] key_name Key name, set if enc
+ * @param[in,out] iv       Initialization vector, set if enc
+ * @param[in]     cctx     Cipher context
+ * @param[in]     hctx     HMAC context
+ * @param[in]     enc      1: encrypt new ticket, 0: decrypt ticket
+ * @retval        2        Ticket decrypted with previous key, replace it
+ * @retval        1        OK
+ * @retval        0        Unknown or expired key, full handshake
+ * @retval       -1        Error
+ * @see CLICON_RESTCONF_TLS_TICKET_ROTATE
+ */
+static int
+restconf_ticket_key_cb(SSL            *ssl,
+                       unsigned char   key_name[16],
+                       unsigned char  *iv,
+                       EVP_CIPHER_CTX *cctx,
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+                       HMAC_CTX       *hctx,
+#else
+                       EVP_MAC_CTX    *hctx,
+#endif
+                       int             enc)
+{
+    uint64_t      now;
+    uint64_t      epoch = 0;
+    unsigned char tag[32];
+    unsigned char aeskey[32];
+    unsigned char mackey[32];
+    int           ret = 1;
+    int           i;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_PARAM    params[3];
+#endif
+
+    if (ticket_rotate == 0)
+        return 0;
+    now = time(NULL) / ticket_rotate;
+    if (enc){
+        epoch = now;
+        if (restconf_ticket_key(epoch, "name", tag) < 0)
+            return -1;
+        memcpy(key_name, tag, 8);
+        for (i=0; i<8; i++)
+            key_name[8+i] = (epoch >> (56-8*i)) & 0xff;
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1)
+            return -1;
+    }
+    else {
+        for (i=0; i<8; i++)
+            epoch = (epoch << 8) | key_name[8+i];
+        if (epoch != now && epoch + 1 != now)
+            return 0;
+        if (restconf_ticket_key(epoch, "name", tag) < 0)
+            return -1;
+        if (memcmp(key_name, tag, 8) != 0)
+            return 0;
+        if (epoch != now)
+            ret = 2;
+    }
+    if (restconf_ticket_key(epoch, "aes", aeskey) < 0 ||
+        restconf_ticket_key(epoch, "mac", mackey) < 0)
+        return -1;
+    if (EVP_CipherInit_ex(cctx, EVP_aes_256_cbc(), NULL, aeskey, iv, enc) != 1)
+        return -1;
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+    if (HMAC_Init_ex(hctx, mackey, sizeof(mackey), EVP_sha256(), NULL) != 1)
+        return -1;
+#else
+    params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, mackey, sizeof(mackey));
+    params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "sha256", 0);
+    params[2] = OSSL_PARAM_construct_end();
+    if (EVP_MAC_CTX_set_params(hctx, params) != 1)
+        return -1;
+#endif
+    return ret;
+}
+
 /*
  */
 static SSL_CTX *
@@ -387,7 +516,11 @@ restconf_ssl_context_create(clixon_handle h)
     */
     SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv3 | SSL_OP_NO_TLSv1 | SSL_OP_NO_TLSv1_1);
 
-    SSL_CTX_set_options(ctx, SSL_MODE_RELEASE_BUFFERS | SSL_OP_NO_COMPRESSION);
+    SSL_CTX_set_options(ctx, SSL_OP_NO_COMPRESSION);
+    /* Output that would block is queued and retried from a buffer that may move.
+     * Read and write buffers of idle connections are released, which saves about 34K
+     * per connection with many persistent or callhome clients */
+    SSL_CTX_set_mode(ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER | SSL_MODE_RELEASE_BUFFERS);
     //    SSL_CTX_set_timeout(ctx, cfg->ssl_ctx_timeout); /* default 300s */
     /* Application Layer Protocol Negotiation (alpn) callback */
     SSL_CTX_set_alpn_select_cb(ctx, alpn_select_proto_cb, h);
@@ -410,6 +543,7 @@ restconf_ssl_context_configure(clixon_handle h,
                                const char   *server_ca_cert_path)
 {
     int retval = -1;
+    int nr;
 
     SSL_CTX_set_ecdh_auto(ctx, 1);
 
@@ -433,7 +567,35 @@ restconf_ssl_context_configure(clixon_handle h,
 
     SSL_CTX_set_session_id_context(ctx, (void *)&session_id_context, sizeof(session_id_context));
     SSL_CTX_set_app_data(ctx, h);
-    SSL_CTX_set_session_cache_mode(ctx, 0);
+    /* Session resumption with session cache and session tickets */
+    if ((nr = clicon_option_int(h, "CLICON_RESTCONF_TLS_SESSION_CACHE")) > 0){
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(ctx, nr);
+    }
+    else
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_timeout(ctx, clicon_option_int(h, "CLICON_RESTCONF_TLS_SESSION_TIMEOUT"));
+    if ((ticket_rotate = clicon_option_int(h, "CLICON_RESTCONF_TLS_TICKET_ROTATE")) > 0){
+        if (RAND_bytes(ticket_secret, sizeof(ticket_secret)) != 1){
+            clixon_err(OE_SSL, 0, "RAND_bytes");
+            goto done;
+        }
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+        SSL_CTX_set_tlsext_ticket_key_cb(ctx, restconf_ticket_key_cb);
+#else
+        SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, restconf_ticket_key_cb);
+#endif
+    }
+    else
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    /* Kernel TLS, used if the negotiated cipher is supported by the kernel */
+    if (clicon_option_bool(h, "CLICON_RESTCONF_TLS_KTLS")){
+#ifdef SSL_OP_ENABLE_KTLS
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#else
+        clixon_log(h, LOG_WARNING, "CLICON_RESTCONF_TLS_KTLS set but kernel TLS not supported by OpenSSL");
+#endif
+    }
 
     /* Set the key and cert */
     if (SSL_CTX_use_certificate_chain_file(ctx, server_cert_path) != 1) {
@@ -548,6 +710,10 @@ restconf_accept_client(int   fd,
     h = rsock->rs_h;
     len = sizeof(from);
     if ((s = accept(rsock->rs_ss, &from, &len)) < 0){
+        if (errno == EAGAIN || errno == EWOULDBLOCK){ /* Accepted by other worker */
+            retval = 0;
+            goto done;
+        }
         clixon_err(OE_UNIX, errno, "accept");
         goto done;
     }
@@ -634,10 +800,18 @@ restconf_native_terminate(clixon_handle h)
                 free(rsock->rs_from_addr);
             free(rsock);
         }
-        if (rn->rn_ctx)
+        if (rn->rn_ctx){
+            if (SSL_CTX_sess_accept(rn->rn_ctx) > 0)
+                clixon_log(h, LOG_NOTICE, "%s native %u TLS handshakes:%ld resumed:%ld",
+                           __PROGRAM__, getpid(),
+                           SSL_CTX_sess_accept_good(rn->rn_ctx),
+                           SSL_CTX_sess_hits(rn->rn_ctx));
             SSL_CTX_free(rn->rn_ctx);
+        }
         free(rn);
     }
+    restconf_conn_pool_free();
+    http_data_cache_free(h);
     EVP_cleanup();
     return 0;
 }
@@ -1111,6 +1285,87 @@ restconf_clixon_init(clixon_handle h,
     goto done;
 }
 
+/*! Fork worker processes that accept clients on the same listening sockets
+ *
+ * Each worker, and this process, runs its own event loop with its own TLS connections
+ * and its own backend session. The listening sockets are non-blocking, a worker that
+ * loses an accept race returns to its event loop.
+ * Not used with callhome, since each worker would call home.
+ * @param[in]  h   Clixon handle
+ * @retval     1   OK, this is the parent, or no workers
+ * @retval     0   OK, this is a worker
+ * @retval    -1   Error
+ * @see CLICON_RESTCONF_WORKERS  Number of processes, including this
+ */
+static int
+restconf_workers_start(clixon_handle h)
+{
+    restconf_native_handle *rn;
+    restconf_socket        *rsock;
+    pid_t                   pid;
+    int                     n;
+    int                     s;
+    int                     i;
+
+    if ((n = clicon_option_int(h, "CLICON_RESTCONF_WORKERS")) <= 1)
+        return 1;
+    if ((rn = restconf_native_handle_get(h)) == NULL){
+        clixon_err(OE_XML, EFAULT, "No openssl handle");
+        return -1;
+    }
+    if ((rsock = rn->rn_sockets) != NULL){
+        do {
+            if (rsock->rs_callhome){
+                clixon_log(h, LOG_WARNING, "CLICON_RESTCONF_WORKERS not used with callhome");
+                return 1;
+            }
+            rsock = NEXTQ(restconf_socket *, rsock);
+        } while (rsock && rsock != rn->rn_sockets);
+    }
+    if ((_workers = calloc(n - 1, sizeof(pid_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    for (i = 0; i < n - 1; i++){
+        if ((pid = fork()) < 0){
+            clixon_err(OE_UNIX, errno, "fork");
+            return -1;
+        }
+        if (pid == 0){ /* worker */
+            free(_workers);
+            _workers = NULL;
+            _nworkers = 0;
+            /* Open own backend session on first request */
+            if ((s = clicon_client_socket_get(h)) >= 0){
+                clixon_shm_close(s);
+                close(s);
+                clicon_client_socket_set(h, -1);
+            }
+            clixon_debug(CLIXON_DBG_RESTCONF, "worker %d pid %u", i + 1, getpid());
+            return 0;
+        }
+        _workers[_nworkers++] = pid;
+    }
+    return 1;
+}
+
+/*! Terminate and wait for worker processes
+ */
+static void
+restconf_workers_stop(void)
+{
+    int i;
+
+    for (i = 0; i < _nworkers; i++)
+        kill(_workers[i], SIGTERM);
+    for (i = 0; i < _nworkers; i++)
+        waitpid(_workers[i], NULL, 0);
+    if (_workers)
+        free(_workers);
+    _workers = NULL;
+    _nworkers = 0;
+}
+
 /*! Signal terminates process
  *
  * Just set exit flag for proper exit in event loop
@@ -1392,6 +1647,7 @@ main(int    argc,
     memset(rn, 0, sizeof *rn);
     if (restconf_native_handle_set(h, rn) < 0)
         goto done;
+    restconf_metrics_conn_bytes_register(restconf_native_conn_bytes);
     /* Openssl inits */
     if (restconf_openssl_init(h, dbg, xrestconf, stream_timeout) < 0)
         goto done;
@@ -1406,6 +1662,12 @@ main(int    argc,
      */
     clicon_data_set(h, "session-transport", "cl:restconf");
 
+    /* Fork worker processes accepting on the same sockets */
+    if (restconf_workers_start(h) < 0)
+        goto done;
+    /* Pool of backend sessions shared by connections, per process */
+    if (clicon_client_pool_init(h, clicon_option_int(h, "CLICON_RESTCONF_BACKEND_SESSIONS")) < 0)
+        goto done;
     /* Main event loop */
     if (clixon_event_loop(h) < 0)
         goto done;
@@ -1413,9 +1675,12 @@ main(int    argc,
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "restconf_main_openssl done");
+    if (_nworkers)
+        restconf_workers_stop();
     if (xrestconf)
         xml_free(xrestconf);
     if (h){
+        clicon_client_pool_exit(h);
         restconf_native_terminate(h);
         restconf_terminate(h);
     }
@@ -340,6 +340,7 @@ api_data_write(clixon_handle h,
             goto ok;
         }
         break;
+    case YANG_DATA_CBOR: /* Translated to JSON, see api_root_restconf */
     case YANG_DATA_JSON:
         // XXX yspec is top-level, but data may be mounted yspec
         if ((ret = clixon_json_parse_string(h, data, 1, yb, yspec, &xdata0, &xerr)) < 0){
@@ -684,6 +685,7 @@ api_data_patch(clixon_handle h,
     switch (media_in){
     case YANG_DATA_XML:
     case YANG_DATA_JSON:        /* plain patch */
+    case YANG_DATA_CBOR:
         ret = api_data_write(h, req, api_path0, pi, qvec, data, pretty,
                              media_in, media_out, 1, ds);
         break;
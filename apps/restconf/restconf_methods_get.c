@@ -48,6 +48,7 @@
 #include <time.h>
 #include <signal.h>
 #include <limits.h>
+#include <inttypes.h>
 #include <sys/time.h>
 #include <sys/wait.h>
 
@@ -66,6 +67,118 @@
 /* Forward */
 static int api_data_pagination(clixon_handle h, void *req, char *api_path, int pi, cvec *qvec, int pretty, restconf_media media_out);
 
+/*! Check if a yang data node and all its descendants are configuration
+ *
+ * Then only configuration data is returned for the node, and no state data
+ * @param[in]  y   Yang data node
+ * @retval     1   Configuration only
+ * @retval     0   Node or a descendant is state data or a mount-point
+ */
+static int
+api_data_config_only(yang_stmt *y)
+{
+    yang_stmt *yc;
+    int        inext;
+
+    if (yang_config(y) == 0 ||
+        yang_schema_mount_point(y) != 0)
+        return 0;
+    inext = 0;
+    while ((yc = yn_iter(y, &inext)) != NULL) {
+        switch (yang_keyword_get(yc)){
+        case Y_CONTAINER:
+        case Y_LIST:
+        case Y_LEAF:
+        case Y_LEAF_LIST:
+        case Y_CHOICE:
+        case Y_CASE:
+        case Y_ANYDATA:
+        case Y_ANYXML:
+            if (api_data_config_only(yc) == 0)
+                return 0;
+            break;
+        default:
+            break;
+        }
+    }
+    return 1;
+}
+
+/*! Entity-tag and last-modified of a GET of configuration data, and conditional GET
+ *
+ * The entity-tag is the change id of the running datastore, and last-modified its time of
+ * last change, see RFC 8040 Sec 3.5.2.
+ * Only for configuration data, since state data may change without a change of running.
+ * If the request has If-None-Match with the entity-tag, or if it has no If-None-Match
+ * but If-Modified-Since not before last-modified, reply 304 without reading the data.
+ * @param[in]  h        Clixon handle
+ * @param[in]  req      Generic Www handle
+ * @param[in]  y        Yang data node of request, or NULL for the data root
+ * @param[in]  content  Content query parameter
+ * @param[out] etag     Entity-tag, or empty if none
+ * @param[in]  len      Length of etag
+ * @param[out] lastmod  Last-modified HTTP-date
+ * @param[in]  len2     Length of lastmod
+ * @retval     1        304 Not Modified is sent
+ * @retval     0        OK, continue with GET
+ * @retval    -1        Error
+ */
+static int
+api_data_conditional(clixon_handle   h,
+                     void           *req,
+                     yang_stmt      *y,
+                     netconf_content content,
+                     char           *etag,
+                     size_t          len,
+                     char           *lastmod,
+                     size_t          len2)
+{
+    int            retval = -1;
+    uint64_t       id;
+    struct timeval tv;
+    char          *str;
+    time_t         t;
+
+    etag[0] = '\0';
+    lastmod[0] = '\0';
+    if (content != CONTENT_CONFIG &&
+        (content != CONTENT_ALL || y == NULL || api_data_config_only(y) == 0))
+        goto ok;
+    if (clicon_rpc_datastore_change(h, "running", &id, &tv) < 0){
+        /* Eg an older backend, reply without entity-tag */
+        clixon_debug(CLIXON_DBG_RESTCONF, "%s", clixon_err_reason());
+        clixon_err_reset();
+        goto ok;
+    }
+    snprintf(etag, len, "\"%" PRIx64 "\"", id);
+    t = tv.tv_sec;
+    strftime(lastmod, len2, "%a, %d %b %Y %H:%M:%S GMT", gmtime(&t));
+    if ((str = restconf_param_get(h, "HTTP_IF_NONE_MATCH")) != NULL){
+        if (strcmp(str, "*") != 0 && strstr(str, etag) == NULL)
+            goto ok;
+    }
+    else if ((str = restconf_param_get(h, "HTTP_IF_MODIFIED_SINCE")) != NULL){
+        if (restconf_http_date2time(str, &t) == 0 || tv.tv_sec > t)
+            goto ok;
+    }
+    else
+        goto ok;
+    if (restconf_reply_header(req, "ETag", "%s", etag) < 0)
+        goto done;
+    if (restconf_reply_header(req, "Last-Modified", "%s", lastmod) < 0)
+        goto done;
+    if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+        goto done;
+    if (restconf_reply_send(req, 304, NULL, 0) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ ok:
+    retval = 0;
+    goto done;
+}
+
 /*! Generic GET (both HEAD and GET)
  *
  * According to restconf
@@ -126,6 +239,8 @@ api_data_get2(clixon_handle  h,
     yang_stmt *y = NULL;
     char      *defaults = NULL;
     cvec      *nscd = NULL;
+    char       etag[24] = {0,};
+    char       lastmod[32] = {0,};
     int        ret;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
@@ -208,6 +323,12 @@ api_data_get2(clixon_handle  h,
         defaults = attr;
     }
 
+    /* Conditional GET of configuration data: do not get data if not modified */
+    if ((ret = api_data_conditional(h, req, y, content,
+                                    etag, sizeof(etag), lastmod, sizeof(lastmod))) < 0)
+        goto done;
+    if (ret == 1)
+        goto ok;
     clixon_debug(CLIXON_DBG_RESTCONF, "path:%s", xpath);
     if ((ret = clicon_rpc_get(h, xpath, nsc, content, depth, defaults, &xret)) < 0){
         if (netconf_operation_failed_xml(&xerr, "protocol", clixon_err_reason()) < 0)
@@ -244,6 +365,10 @@ api_data_get2(clixon_handle  h,
             if (clixon_json2cbuf(cbx, xret, pretty, 0, 0, 0) < 0)
                 goto done;
             break;
+        case YANG_DATA_CBOR:
+            if (clixon_cbor2cbuf(cbx, xret, 0, 0) < 0)
+                goto done;
+            break;
         default:
             break;
         }
@@ -292,6 +417,10 @@ api_data_get2(clixon_handle  h,
             if (xml2json_cbuf_vec(cbx, xvec, xlen, pretty, 0) < 0)
                 goto done;
             break;
+        case YANG_DATA_CBOR:
+            if (clixon_cbor2cbuf_vec(cbx, xvec, xlen) < 0)
+                goto done;
+            break;
         default:
             break;
         }
@@ -301,6 +430,12 @@ api_data_get2(clixon_handle  h,
         goto done;
     if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
         goto done;
+    if (strlen(etag)){
+        if (restconf_reply_header(req, "ETag", "%s", etag) < 0)
+            goto done;
+        if (restconf_reply_header(req, "Last-Modified", "%s", lastmod) < 0)
+            goto done;
+    }
     if (restconf_reply_send(req, 200, cbx, head) < 0)
         goto done;
     cbx = NULL;
@@ -659,6 +794,7 @@ api_data_get(clixon_handle h,
     switch (media_out){
     case YANG_DATA_XML:
     case YANG_DATA_JSON: /* ad-hoc algorithm in get to determine if a paginated request */
+    case YANG_DATA_CBOR:
         if (api_data_get2(h, req, api_path, pi, qvec, pretty, media_out, 0) < 0)
             goto done;
         break;
@@ -721,6 +857,8 @@ api_operations_get(clixon_handle h,
     int        i;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
+    if (media_out == YANG_DATA_CBOR) /* Operations list is not encoded in CBOR, use JSON */
+        media_out = YANG_DATA_JSON;
     yspec = clicon_dbspec_yang(h);
     if ((cbx = cbuf_new()) == NULL)
         goto done;
@@ -254,6 +254,7 @@ api_data_post(clixon_handle h,
             goto ok;
         }
         break;
+    case YANG_DATA_CBOR: /* Translated to JSON, see api_root_restconf */
     case YANG_DATA_JSON:
         if ((ret = clixon_json_parse_string(h, data, 1, yb, yspec, &xbot, &xerr)) < 0){
             if (netconf_malformed_message_xml(&xerr, clixon_err_reason()) < 0)
@@ -466,6 +467,7 @@ api_operations_post_input(clixon_handle h,
             goto fail;
         }
         break;
+    case YANG_DATA_CBOR: /* Translated to JSON, see api_root_restconf */
     case YANG_DATA_JSON:
         /* XXX: Here data is on the form: {"clixon-example:input":null} and has no proper yang binding
          * support */
@@ -890,6 +892,10 @@ api_operations_post(clixon_handle h,
             goto done;
         /* xoutput should now look: {"example:output": {"x":0,"y":42}} */
         break;
+    case YANG_DATA_CBOR:
+        if (clixon_cbor2cbuf(cbret, xoutput, 0, 0) < 0)
+            goto done;
+        break;
     default:
         break;
     }
@@ -0,0 +1,488 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+
+ * Prometheus/OpenMetrics text exposition of native restconf and backend counters
+ * @see restconf_metrics.h
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <errno.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "restconf_handle.h"
+#include "restconf_lib.h"
+#include "restconf_api.h"
+#include "restconf_err.h"
+#include "restconf_metrics.h"
+
+/*
+ * Constants
+ */
+/* Max number of distinct method and status code pairs counted */
+#define METRICS_CODES_MAX   64
+
+/* Number of request latency histogram buckets */
+#define METRICS_BUCKETS     10
+
+/*
+ * Types
+ */
+enum metrics_method {
+    MM_GET,
+    MM_HEAD,
+    MM_POST,
+    MM_PUT,
+    MM_PATCH,
+    MM_DELETE,
+    MM_OPTIONS,
+    MM_OTHER,
+    MM_NR
+};
+
+/* Number of requests of a method with a status code */
+struct metrics_code {
+    enum metrics_method mc_method;
+    uint16_t            mc_code;
+    uint64_t            mc_count;
+};
+
+/* Request latency histogram of a method */
+struct metrics_latency {
+    uint64_t            ml_count;
+    uint64_t            ml_usec;
+    uint64_t            ml_buckets[METRICS_BUCKETS]; /* Not cumulative */
+};
+
+/*
+ * Variables
+ */
+static const map_str2int mmmap[] = {
+    {"GET",     MM_GET},
+    {"HEAD",    MM_HEAD},
+    {"POST",    MM_POST},
+    {"PUT",     MM_PUT},
+    {"PATCH",   MM_PATCH},
+    {"DELETE",  MM_DELETE},
+    {"OPTIONS", MM_OPTIONS},
+    {"other",   MM_OTHER},
+    {NULL,      -1}
+};
+
+/* Upper bounds of latency buckets in usec */
+static const uint64_t _metrics_bounds[METRICS_BUCKETS] = {
+    1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 5000000
+};
+
+static struct metrics_code    _metrics_codes[METRICS_CODES_MAX];
+static int                    _metrics_codes_nr = 0;
+static struct metrics_latency _metrics_latency[MM_NR];
+static uint64_t               _metrics_conns = 0;
+static uint64_t               _metrics_conns_total = 0;
+static uint64_t               _metrics_streams = 0;
+static uint64_t               _metrics_streams_total = 0;
+static uint64_t               _metrics_tls_ok = 0;
+static uint64_t               _metrics_tls_failed = 0;
+
+/* Memory of open connections, registered by restconf modes that keep connection state */
+static size_t               (*_metrics_conn_bytes_fn)(clixon_handle h) = NULL;
+
+/*! Check if uri path is the metrics path
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     1    Yes, the path is CLICON_RESTCONF_METRICS_PATH
+ * @retval     0    No, or not enabled
+ */
+int
+api_path_is_metrics(clixon_handle h)
+{
+    int   retval = 0;
+    char *path = NULL;
+    char *metrics_path;
+
+    if ((metrics_path = clicon_option_str(h, "CLICON_RESTCONF_METRICS_PATH")) == NULL)
+        goto done;
+    if ((path = restconf_uripath(h)) == NULL)
+        goto done;
+    if (strcmp(path, metrics_path) != 0)
+        goto done;
+    retval = 1;
+ done:
+    if (path)
+        free(path);
+    return retval;
+}
+
+/*! Count a request when its reply is made
+ *
+ * @param[in]  method  HTTP method, or NULL
+ * @param[in]  code    HTTP status code of reply
+ * @param[in]  usec    Time from dispatch of request to reply
+ */
+void
+restconf_metrics_request(const char *method,
+                         uint16_t    code,
+                         uint64_t    usec)
+{
+    int                     m;
+    int                     i;
+    struct metrics_latency *ml;
+
+    if (method == NULL || (m = clicon_str2int(mmmap, method)) < 0)
+        m = MM_OTHER;
+    for (i=0; i<_metrics_codes_nr; i++)
+        if (_metrics_codes[i].mc_method == m && _metrics_codes[i].mc_code == code)
+            break;
+    if (i == _metrics_codes_nr && i < METRICS_CODES_MAX){
+        _metrics_codes[i].mc_method = m;
+        _metrics_codes[i].mc_code = code;
+        _metrics_codes_nr++;
+    }
+    if (i < _metrics_codes_nr)
+        _metrics_codes[i].mc_count++;
+    ml = &_metrics_latency[m];
+    ml->ml_count++;
+    ml->ml_usec += usec;
+    for (i=0; i<METRICS_BUCKETS; i++)
+        if (usec <= _metrics_bounds[i]){
+            ml->ml_buckets[i]++;
+            break;
+        }
+}
+
+/*! Count an opened (1) or closed (-1) connection
+ */
+void
+restconf_metrics_conn(int delta)
+{
+    if (delta > 0){
+        _metrics_conns++;
+        _metrics_conns_total++;
+    }
+    else if (_metrics_conns > 0)
+        _metrics_conns--;
+}
+
+/*! Count an opened (1) or closed (-1) HTTP/2 stream
+ */
+void
+restconf_metrics_stream(int delta)
+{
+    if (delta > 0){
+        _metrics_streams++;
+        _metrics_streams_total++;
+    }
+    else if (_metrics_streams > 0)
+        _metrics_streams--;
+}
+
+/*! Count a completed (1) or failed (0) TLS handshake
+ */
+void
+restconf_metrics_tls(int ok)
+{
+    if (ok)
+        _metrics_tls_ok++;
+    else
+        _metrics_tls_failed++;
+}
+
+/*! Register function returning memory of open connections in bytes
+ *
+ * @param[in]  fn   Function, or NULL
+ */
+void
+restconf_metrics_conn_bytes_register(size_t (*fn)(clixon_handle h))
+{
+    _metrics_conn_bytes_fn = fn;
+}
+
+/*! Print HELP and TYPE lines of a metric
+ */
+static void
+metrics_head(cbuf       *cb,
+             const char *name,
+             const char *type,
+             const char *help)
+{
+    cprintf(cb, "# HELP %s %s\n", name, help);
+    cprintf(cb, "# TYPE %s %s\n", name, type);
+}
+
+/*! Print restconf metrics of this process
+ *
+ * @param[in]  h    Clixon handle
+ * @param[out] cb   Metrics in text exposition format are appended
+ */
+static void
+metrics_restconf_print(clixon_handle h,
+                       cbuf         *cb)
+{
+    struct metrics_latency *ml;
+    uint64_t                sum;
+    int                     m;
+    int                     i;
+
+    metrics_head(cb, "clixon_restconf_requests_total", "counter",
+                 "RESTCONF requests by method and status code");
+    for (i=0; i<_metrics_codes_nr; i++)
+        cprintf(cb, "clixon_restconf_requests_total{method=\"%s\",code=\"%u\"} %" PRIu64 "\n",
+                clicon_int2str(mmmap, _metrics_codes[i].mc_method),
+                _metrics_codes[i].mc_code,
+                _metrics_codes[i].mc_count);
+    metrics_head(cb, "clixon_restconf_request_duration_seconds", "histogram",
+                 "Time from dispatch of request to reply");
+    for (m=0; m<MM_NR; m++){
+        ml = &_metrics_latency[m];
+        if (ml->ml_count == 0)
+            continue;
+        sum = 0;
+        for (i=0; i<METRICS_BUCKETS; i++){
+            sum += ml->ml_buckets[i];
+            cprintf(cb, "clixon_restconf_request_duration_seconds_bucket{method=\"%s\",le=\"%g\"} %" PRIu64 "\n",
+                    clicon_int2str(mmmap, m), _metrics_bounds[i]/1000000.0, sum);
+        }
+        cprintf(cb, "clixon_restconf_request_duration_seconds_bucket{method=\"%s\",le=\"+Inf\"} %" PRIu64 "\n",
+                clicon_int2str(mmmap, m), ml->ml_count);
+        cprintf(cb, "clixon_restconf_request_duration_seconds_sum{method=\"%s\"} %.6f\n",
+                clicon_int2str(mmmap, m), ml->ml_usec/1000000.0);
+        cprintf(cb, "clixon_restconf_request_duration_seconds_count{method=\"%s\"} %" PRIu64 "\n",
+                clicon_int2str(mmmap, m), ml->ml_count);
+    }
+    metrics_head(cb, "clixon_restconf_connections", "gauge", "Open connections");
+    cprintf(cb, "clixon_restconf_connections %" PRIu64 "\n", _metrics_conns);
+    metrics_head(cb, "clixon_restconf_connections_total", "counter", "Accepted connections");
+    cprintf(cb, "clixon_restconf_connections_total %" PRIu64 "\n", _metrics_conns_total);
+    if (_metrics_conn_bytes_fn){
+        metrics_head(cb, "clixon_restconf_connection_bytes", "gauge",
+                     "Memory of open connections, their streams and buffers, excluding TLS and HTTP/2 library state");
+        cprintf(cb, "clixon_restconf_connection_bytes %zu\n", _metrics_conn_bytes_fn(h));
+    }
+    metrics_head(cb, "clixon_restconf_http2_streams", "gauge", "Open HTTP/2 streams");
+    cprintf(cb, "clixon_restconf_http2_streams %" PRIu64 "\n", _metrics_streams);
+    metrics_head(cb, "clixon_restconf_http2_streams_total", "counter", "HTTP/2 streams");
+    cprintf(cb, "clixon_restconf_http2_streams_total %" PRIu64 "\n", _metrics_streams_total);
+    metrics_head(cb, "clixon_restconf_tls_handshakes_total", "counter", "TLS handshakes by result");
+    cprintf(cb, "clixon_restconf_tls_handshakes_total{result=\"ok\"} %" PRIu64 "\n", _metrics_tls_ok);
+    cprintf(cb, "clixon_restconf_tls_handshakes_total{result=\"failed\"} %" PRIu64 "\n", _metrics_tls_failed);
+}
+
+/*! Print value of an element as a metric, time in usec is printed in seconds
+ */
+static void
+metrics_value(cbuf       *cb,
+              cxobj      *x,
+              const char *xname,
+              const char *name,
+              const char *labels,
+              int         usec)
+{
+    char    *str;
+    uint64_t val;
+
+    if ((str = xml_find_body(x, (char*)xname)) == NULL)
+        return;
+    val = strtoull(str, NULL, 10);
+    if (usec)
+        cprintf(cb, "%s%s %.6f\n", name, labels?labels:"", val/1000000.0);
+    else
+        cprintf(cb, "%s%s %" PRIu64 "\n", name, labels?labels:"", val);
+}
+
+/*! Print backend metrics read with the stats RPC
+ *
+ * If the backend cannot be reached, only clixon_backend_up 0 is printed
+ * @param[in]  h    Clixon handle
+ * @param[out] cb   Metrics in text exposition format are appended
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+metrics_backend_print(clixon_handle h,
+                      cbuf         *cb)
+{
+    int     retval = -1;
+    cbuf   *cbx = NULL;
+    cxobj  *xret = NULL;
+    cxobj  *xr;
+    cxobj  *x;
+    cxobj  *xc = NULL;
+    char   *username;
+    char   *name;
+    cbuf   *cbl = NULL;
+    int     lag;
+
+    if ((cbx = cbuf_new()) == NULL ||
+        (cbl = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbx, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cbx, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cbx, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cbx, " %s>", NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cbx, "<stats xmlns=\"%s\">", CLIXON_LIB_NS);
+    cprintf(cbx, "<commit-timing>true</commit-timing>");
+    cprintf(cbx, "<event-profile>true</event-profile>");
+    cprintf(cbx, "</stats></rpc>");
+    metrics_head(cb, "clixon_backend_up", "gauge", "Backend stats could be read");
+    if (clicon_rpc_netconf(h, cbuf_get(cbx), &xret, NULL) < 0 ||
+        (xr = xpath_first(xret, NULL, "rpc-reply")) == NULL ||
+        xpath_first(xr, NULL, "rpc-error") != NULL){
+        /* Do not fail the scrape */
+        clixon_err_reset();
+        cprintf(cb, "clixon_backend_up 0\n");
+        goto ok;
+    }
+    cprintf(cb, "clixon_backend_up 1\n");
+    if ((xc = xpath_first(xr, NULL, "commit-timing")) != NULL){
+        metrics_head(cb, "clixon_backend_commits_total", "counter", "Commits");
+        metrics_value(cb, xc, "commits", "clixon_backend_commits_total", NULL, 0);
+        metrics_head(cb, "clixon_backend_commit_failures_total", "counter",
+                     "Commits that failed, eg validation failed");
+        metrics_value(cb, xc, "failed-commits", "clixon_backend_commit_failures_total", NULL, 0);
+        metrics_head(cb, "clixon_backend_slow_commits_total", "counter",
+                     "Commits slower than CLICON_BACKEND_COMMIT_SLOW");
+        metrics_value(cb, xc, "slow-commits", "clixon_backend_slow_commits_total", NULL, 0);
+        metrics_head(cb, "clixon_backend_commit_duration_seconds_total", "counter",
+                     "Sum of the time of all commits");
+        metrics_value(cb, xc, "total-usec", "clixon_backend_commit_duration_seconds_total", NULL, 1);
+        metrics_head(cb, "clixon_backend_last_commit_duration_seconds", "gauge",
+                     "Time of last commit");
+        metrics_value(cb, xc, "usec", "clixon_backend_last_commit_duration_seconds", NULL, 1);
+    }
+    if ((xc = xpath_first(xr, NULL, "datastores")) != NULL){
+        metrics_head(cb, "clixon_backend_datastore_nodes", "gauge", "XML nodes of cached datastore");
+        metrics_head(cb, "clixon_backend_datastore_bytes", "gauge", "Memory of cached datastore");
+        x = NULL;
+        while ((x = xml_child_each(xc, x, CX_ELMNT)) != NULL){
+            if ((name = xml_find_body(x, "name")) == NULL)
+                continue;
+            cbuf_reset(cbl);
+            cprintf(cbl, "{db=\"%s\"}", name);
+            metrics_value(cb, x, "nr", "clixon_backend_datastore_nodes", cbuf_get(cbl), 0);
+            metrics_value(cb, x, "size", "clixon_backend_datastore_bytes", cbuf_get(cbl), 0);
+        }
+    }
+    /* Only if event profiler is enabled in backend, see CLIXON_DBG_PROFILE */
+    if ((xc = xpath_first(xr, NULL, "event-profile")) != NULL){
+        lag = 0;
+        x = NULL;
+        while ((x = xml_child_each(xc, x, CX_ELMNT)) != NULL){
+            if ((name = xml_find_body(x, "kind")) == NULL || strcmp(name, "lag") != 0)
+                continue;
+            if ((name = xml_find_body(x, "name")) == NULL)
+                continue;
+            if (lag++ == 0)
+                metrics_head(cb, "clixon_backend_event_lag_seconds", "summary",
+                             "Event loop lag of dispatch and timers");
+            cbuf_reset(cbl);
+            cprintf(cbl, "{name=\"%s\"}", name);
+            metrics_value(cb, x, "sum", "clixon_backend_event_lag_seconds_sum", cbuf_get(cbl), 1);
+            metrics_value(cb, x, "count", "clixon_backend_event_lag_seconds_count", cbuf_get(cbl), 0);
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cbx)
+        cbuf_free(cbx);
+    if (cbl)
+        cbuf_free(cbl);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Reply with metrics in Prometheus text exposition format
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  req  Generic Www handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see CLICON_RESTCONF_METRICS_PATH
+ */
+int
+api_metrics(clixon_handle h,
+            void         *req)
+{
+    int   retval = -1;
+    char *request_method;
+    cbuf *cb = NULL;
+    int   head;
+
+    clixon_debug(CLIXON_DBG_RESTCONF, "");
+    request_method = restconf_param_get(h, "REQUEST_METHOD");
+    head = strcmp(request_method, "HEAD") == 0;
+    if (!head && strcmp(request_method, "GET") != 0){
+        if (restconf_method_notallowed(h, req, "GET,HEAD", restconf_pretty_get(h), YANG_DATA_JSON) < 0)
+            goto done;
+        goto ok;
+    }
+    if (restconf_reply_header(req, "Content-Type", "text/plain; version=0.0.4; charset=utf-8") < 0)
+        goto done;
+    if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    metrics_restconf_print(h, cb);
+    if (metrics_backend_print(h, cb) < 0)
+        goto done;
+    if (restconf_reply_send(req, 200, cb, head) < 0)
+        goto done;
+    cb = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
@@ -31,40 +31,26 @@
 
   ***** END LICENSE BLOCK *****
 
- * HTTP/1.1 parser according to RFC 7230
+ * Prometheus/OpenMetrics text exposition of native restconf and backend counters
+ * Restconf counters are kept in this process: requests per method and status code,
+ * request latency, connections, HTTP/2 streams and TLS handshakes.
+ * Backend counters are read with the clixon-lib stats RPC when the metrics are requested:
+ * commits, commit durations, failed commits, datastore sizes and event loop lag (the
+ * latter only if the backend event profiler is enabled, see CLIXON_DBG_PROFILE).
+ * Served on CLICON_RESTCONF_METRICS_PATH if set.
  */
-#ifndef _CLIXON_HTTP1_PARSE_H_
-#define _CLIXON_HTTP1_PARSE_H_
-
-/*
- * Types
- */
-struct clixon_http1_yacc {
-    const char   *hy_name;         /* Name of syntax (for error string) */
-    clixon_handle hy_h;            /* Clixon handle */
-    restconf_conn *hy_rc;          /* Connection handle */
-    int           hy_linenum;      /* Number of \n in parsed buffer */
-    char         *hy_parse_string; /* original (copy of) parse string */
-    void         *hy_lexbuf;       /* internal parse buffer from lex */
-};
-typedef struct clixon_http1_yacc clixon_http1_yacc;
-
-/*
- * Variables
- */
-extern char *clixon_http1_parsetext;
+#ifndef _RESTCONF_METRICS_H_
+#define _RESTCONF_METRICS_H_
 
 /*
  * Prototypes
  */
-int http1_scan_init(clixon_http1_yacc *);
-int http1_scan_exit(clixon_http1_yacc *);
-
-int http1_parse_init(clixon_http1_yacc *);
-int http1_parse_exit(clixon_http1_yacc *);
-
-int clixon_http1_parselex(void *);
-int clixon_http1_parseparse(void *);
-void clixon_http1_parseerror(void *, char*);
-
-#endif  /* _CLIXON_HTTP1_PARSE_H_ */
+int  api_path_is_metrics(clixon_handle h);
+int  api_metrics(clixon_handle h, void *req);
+void restconf_metrics_request(const char *method, uint16_t code, uint64_t usec);
+void restconf_metrics_conn(int delta);
+void restconf_metrics_stream(int delta);
+void restconf_metrics_tls(int ok);
+void restconf_metrics_conn_bytes_register(size_t (*fn)(clixon_handle h));
+
+#endif /* _RESTCONF_METRICS_H_ */
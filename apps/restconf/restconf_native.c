@@ -45,15 +45,22 @@
 #include <pwd.h>
 #include <ctype.h>
 #include <signal.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <sys/resource.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 #include <openssl/ssl.h>
 #include <openssl/rand.h>
 #include <openssl/err.h>
 #include <openssl/x509v3.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 #ifdef HAVE_LIBNGHTTP2
 #include <nghttp2/nghttp2.h>
 #endif
@@ -67,6 +74,7 @@
 /* restconf */
 #include "restconf_lib.h"       /* generic shared with plugins */
 #include "restconf_handle.h"
+#include "restconf_api.h"       /* generic not shared with plugins */
 #include "restconf_err.h"
 #include "restconf_native.h"    /* Restconf-openssl mode specific headers*/
 #ifdef HAVE_LIBNGHTTP2
@@ -77,9 +85,17 @@
 #include "restconf_http1.h"
 #endif
 #include "restconf_stream.h"
+#include "restconf_metrics.h"
 
 /* Forward */
 static int restconf_idle_cb(int fd, void *arg);
+static int native_outq_drain(int fd, void *arg);
+static int native_conn_dequeue(int fd, void *arg);
+static int native_conn_queue_wait(restconf_conn *rc);
+
+/* Freed connection structs kept for reuse, see restconf_conn_new */
+static restconf_conn *_conn_pool[RESTCONF_CONN_POOL_MAX];
+static int            _conn_pool_nr = 0;
 
 /*! Create restconf stream
  *
@@ -127,6 +143,43 @@ restconf_stream_data_new(restconf_conn *rc,
     goto ok;
 }
 
+/*! Release large buffers of a stream when a request is done
+ *
+ * Buffers grow to the size of the largest request and reply of the stream. Buffers larger
+ * than RESTCONF_IDLE_BUFLEN are replaced with new small buffers, so that a persistent
+ * connection does not keep them while idle.
+ * @param[in]  sd       Restconf data stream, with empty indata and output buffers
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+restconf_stream_release(restconf_stream_data *sd)
+{
+    cbuf *cb;
+
+    if (cbuf_buflen(sd->sd_indata) > RESTCONF_IDLE_BUFLEN){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            return -1;
+        }
+        cbuf_free(sd->sd_indata);
+        sd->sd_indata = cb;
+    }
+    if (cbuf_buflen(sd->sd_outp_buf) > RESTCONF_IDLE_BUFLEN){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            return -1;
+        }
+        cbuf_free(sd->sd_outp_buf);
+        sd->sd_outp_buf = cb;
+    }
+    if (sd->sd_body && cbuf_buflen(sd->sd_body) > RESTCONF_IDLE_BUFLEN){
+        cbuf_free(sd->sd_body);
+        sd->sd_body = NULL;
+    }
+    return 0;
+}
+
 /*! Find restconf stream data
  *
  * @param[in]  rc       Restconf connection handle 
@@ -147,6 +200,65 @@ restconf_stream_find(restconf_conn *rc,
     return NULL;
 }
 
+/*! Preallocate request body buffer from Content-Length
+ *
+ * Avoids reallocating and copying a large body while it is received. The allocation is
+ * capped, larger bodies grow as before.
+ * @param[in]  sd       Restconf data stream
+ * @param[in]  len      Content-Length of request body
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+restconf_stream_indata_alloc(restconf_stream_data *sd,
+                             size_t                len)
+{
+    cbuf *cb;
+
+    if (len > RESTCONF_INDATA_ALLOC_MAX)
+        len = RESTCONF_INDATA_ALLOC_MAX;
+    /* Two extra bytes so that the parsers can scan the body in place */
+    if (cbuf_len(sd->sd_indata) != 0 || cbuf_buflen(sd->sd_indata) >= len + 2)
+        return 0;
+    if ((cb = cbuf_new_alloc(len + 2)) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
+        return -1;
+    }
+    cbuf_free(sd->sd_indata);
+    sd->sd_indata = cb;
+    return 0;
+}
+
+/*! Parse Content-Length header value of a request
+ *
+ * Only digits are accepted, see RFC 9110 Sec 8.6, and the length is capped by
+ * RESTCONF_INDATA_MAX.
+ * @param[in]  val      Content-Length header value
+ * @param[out] lenp     Content-Length
+ * @retval     1        OK
+ * @retval     0        Invalid or too large
+ */
+int
+restconf_content_length(const char *val,
+                        size_t     *lenp)
+{
+    const char        *s;
+    char              *ep = NULL;
+    unsigned long long len;
+
+    if (val == NULL || *val == '\0')
+        return 0;
+    for (s = val; *s != '\0'; s++)
+        if (!isdigit((unsigned char)*s))
+            return 0;
+    errno = 0;
+    len = strtoull(val, &ep, 10);
+    if (errno != 0 || ep == val || *ep != '\0' || len > RESTCONF_INDATA_MAX)
+        return 0;
+    *lenp = (size_t)len;
+    return 1;
+}
+
 /*
  * @param[in]  sd       Restconf data stream
  */
@@ -172,6 +284,8 @@ restconf_stream_free(restconf_stream_data *sd)
         free(sd->sd_settings2);
     if (sd->sd_qvec)
         cvec_free(sd->sd_qvec);
+    if (sd->sd_inhdrs)
+        cvec_free(sd->sd_inhdrs);
     free(sd);
     return 0;
 }
@@ -189,8 +303,17 @@ restconf_conn_new(clixon_handle    h,
                   restconf_socket *rsock)
 {
     restconf_conn *rc;
+    int            flags;
 
-    if ((rc = (restconf_conn*)malloc(sizeof(restconf_conn))) == NULL){
+    /* Replies are written without blocking, see native_buf_write */
+    if ((flags = fcntl(s, F_GETFL, 0)) < 0 ||
+        fcntl(s, F_SETFL, flags | O_NONBLOCK) < 0){
+        clixon_err(OE_UNIX, errno, "fcntl");
+        return NULL;
+    }
+    if (_conn_pool_nr > 0)
+        rc = _conn_pool[--_conn_pool_nr];
+    else if ((rc = (restconf_conn*)malloc(sizeof(restconf_conn))) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
         return NULL;
     }
@@ -200,6 +323,7 @@ restconf_conn_new(clixon_handle    h,
     rc->rc_callhome = rsock->rs_callhome;
     rc->rc_socket = rsock;
     INSQ(rc, rsock->rs_conns);
+    restconf_metrics_conn(1);
     clixon_debug(CLIXON_DBG_RESTCONF, "%p", rc);
     return rc;
 }
@@ -221,6 +345,14 @@ restconf_conn_free(restconf_conn *rc)
         clixon_err(OE_RESTCONF, EINVAL, "rc is NULL");
         goto done;
     }
+    clicon_client_pool_release(rc->rc_h, rc);
+    restconf_metrics_conn(-1);
+    if (rc->rc_outq_timer)
+        clixon_event_unreg_timeout(native_outq_drain, rc);
+    if (rc->rc_inq_timer)
+        clixon_event_unreg_timeout(native_conn_dequeue, rc);
+    if (rc->rc_outq)
+        cbuf_free(rc->rc_outq);
 #ifdef HAVE_LIBNGHTTP2
     if (rc->rc_ngsession)
         nghttp2_session_del(rc->rc_ngsession);
@@ -242,12 +374,89 @@ restconf_conn_free(restconf_conn *rc)
             rc1 = NEXTQ(restconf_conn *, rc1);
         } while (rc1 && rc1 != rsock->rs_conns);
     }
-    free(rc);
+    if (_conn_pool_nr < RESTCONF_CONN_POOL_MAX)
+        _conn_pool[_conn_pool_nr++] = rc;
+    else
+        free(rc);
     retval = 0;
  done:
     return retval;
 }
 
+/*! Get memory of a connection in bytes
+ *
+ * Includes the connection, its streams and their buffers, but not memory of the SSL and
+ * nghttp2 libraries.
+ * @param[in]  rc   restconf connection
+ * @retval     sz   Size in bytes
+ */
+size_t
+restconf_conn_size(restconf_conn *rc)
+{
+    size_t                sz;
+    restconf_stream_data *sd;
+
+    sz = sizeof(restconf_conn);
+    if (rc->rc_outq)
+        sz += cbuf_buflen(rc->rc_outq);
+    if ((sd = rc->rc_streams) != NULL) {
+        do {
+            sz += sizeof(restconf_stream_data);
+            if (sd->sd_inbuf)
+                sz += cbuf_buflen(sd->sd_inbuf);
+            if (sd->sd_indata)
+                sz += cbuf_buflen(sd->sd_indata);
+            if (sd->sd_outp_buf)
+                sz += cbuf_buflen(sd->sd_outp_buf);
+            if (sd->sd_body)
+                sz += cbuf_buflen(sd->sd_body);
+            sd = NEXTQ(restconf_stream_data *, sd);
+        } while (sd && sd != rc->rc_streams);
+    }
+    return sz;
+}
+
+/*! Get memory of all open connections in bytes
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     sz   Size in bytes
+ * @see restconf_conn_size
+ */
+size_t
+restconf_native_conn_bytes(clixon_handle h)
+{
+    size_t                  sz = 0;
+    restconf_native_handle *rn;
+    restconf_socket        *rsock;
+    restconf_conn          *rc;
+
+    if ((rn = restconf_native_handle_get(h)) == NULL)
+        return 0;
+    if ((rsock = rn->rn_sockets) != NULL){
+        do {
+            if ((rc = rsock->rs_conns) != NULL){
+                do {
+                    sz += restconf_conn_size(rc);
+                    rc = NEXTQ(restconf_conn *, rc);
+                } while (rc && rc != rsock->rs_conns);
+            }
+            rsock = NEXTQ(restconf_socket *, rsock);
+        } while (rsock && rsock != rn->rn_sockets);
+    }
+    return sz;
+}
+
+/*! Free connection structs kept for reuse
+ *
+ * @see restconf_conn_new
+ */
+void
+restconf_conn_pool_free(void)
+{
+    while (_conn_pool_nr > 0)
+        free(_conn_pool[--_conn_pool_nr]);
+}
+
 /*! Given SSL connection, get peer certificate one-line name
  *
  * @param[in]  ssl      SSL session
@@ -380,103 +589,508 @@ restconf_connection_sanity(clixon_handle         h,
     return retval;
 }
 
-/* Write buf to socket
+/*! Compress reply body with gzip if accepted by client, see CLICON_RESTCONF_COMPRESS_LEVEL
  *
- * Only (at least mostly?) for HTTP/1
- * @param[in]  h        Clixon handle
- * @param[in]  buf      Buffer to write
- * @param[in]  buflen   Length of buffer
- * @param[in]  rc       Connection struct
- * @param[in]  callfn   For debug
- * @retval  1  OK
- * @retval  0  OK, but socket write returned error, caller should close rc
- * @retval -1  Error
+ * Only text, JSON and XML bodies, not already encoded, and not event streams.
+ * The body is compressed in chunks, and kept as is if it does not get smaller.
+ * @param[in]     h    Clixon handle
+ * @param[in]     sd   Http stream
+ * @param[in,out] cbp  Reply body, replaced by compressed body
+ * @retval        1    Compressed
+ * @retval        0    Not compressed
+ * @retval       -1    Error
  */
 int
-native_buf_write(clixon_handle    h,
-                 char            *buf,
-                 size_t           buflen,
-                 restconf_conn   *rc,
-                 const char      *callfn)
+restconf_reply_compress(clixon_handle         h,
+                        restconf_stream_data *sd,
+                        cbuf                **cbp)
 {
-    int     retval = -1;
-    ssize_t len;
-    ssize_t totlen = 0;
-    int     er;
-    SSL    *ssl;
-
-    if (rc == NULL){
-        clixon_err(OE_RESTCONF, EINVAL, "rc is NULL");
+#ifdef HAVE_LIBZ
+    int      retval = -1;
+    int      level;
+    cbuf    *cb = *cbp;
+    cbuf    *cbz = NULL;
+    cg_var  *cv;
+    char    *media;
+    z_stream zs = {0,};
+    char     buf[16*1024];
+    int      ret;
+
+    if ((level = clicon_option_int(h, "CLICON_RESTCONF_COMPRESS_LEVEL")) <= 0 ||
+        cbuf_len(cb) < clicon_option_int(h, "CLICON_RESTCONF_COMPRESS_MIN") ||
+        sd->sd_conn->rc_event_stream ||
+        cvec_find(sd->sd_outp_hdrs, "Content-Encoding") != NULL ||
+        (cv = cvec_find(sd->sd_outp_hdrs, "Content-Type")) == NULL)
+        return 0;
+    media = cv_string_get(cv);
+    if (strncmp(media, "text/", 5) != 0 &&
+        strstr(media, "json") == NULL &&
+        strstr(media, "xml") == NULL &&
+        strstr(media, "javascript") == NULL)
+        return 0;
+    if (restconf_accept_encoding(h, "gzip") == 0)
+        return 0;
+    /* windowBits 15+16 is gzip */
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+        clixon_err(OE_RESTCONF, 0, "deflateInit2");
+        return -1;
+    }
+    if ((cbz = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    ssl = rc->rc_ssl;
-    /* Two problems with debugging buffers that this fixes:
-     * 1. they are not "strings" in the sense they are not NULL-terminated
-     * 2. they are often very long
-     */
-    if ((clixon_debug_get() & CLIXON_DBG_RESTCONF) != 0) {
-        char *dbgstr = NULL;
-        size_t sz;
-        sz = buflen>256?256:buflen; /* Truncate to 256 */
-        if ((dbgstr = malloc(sz+1)) == NULL){
-            clixon_err(OE_UNIX, errno, "malloc");
+    zs.next_in = (Bytef*)cbuf_get(cb);
+    zs.avail_in = cbuf_len(cb);
+    do {
+        zs.next_out = (Bytef*)buf;
+        zs.avail_out = sizeof(buf);
+        if ((ret = deflate(&zs, Z_FINISH)) == Z_STREAM_ERROR){
+            clixon_err(OE_RESTCONF, 0, "deflate");
             goto done;
         }
-        memcpy(dbgstr, buf, sz);
-        dbgstr[sz] = '\0';
-        clixon_debug(CLIXON_DBG_RESTCONF, "%s buflen:%zu buf:\n%s", callfn, buflen, dbgstr);
-        free(dbgstr);
+        if (cbuf_append_buf(cbz, buf, sizeof(buf) - zs.avail_out) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+        if (cbuf_len(cbz) >= cbuf_len(cb)) /* Not smaller */
+            break;
+    } while (ret != Z_STREAM_END);
+    clixon_debug(CLIXON_DBG_RESTCONF, "gzip %zu -> %zu bytes", cbuf_len(cb), cbuf_len(cbz));
+    if (ret != Z_STREAM_END){
+        retval = 0;
+        goto done;
+    }
+    if (restconf_reply_header(sd, "Content-Encoding", "gzip") < 0)
+        goto done;
+    if (cvec_find(sd->sd_outp_hdrs, "Vary") == NULL &&
+        restconf_reply_header(sd, "Vary", "Accept-Encoding") < 0)
+        goto done;
+    cbuf_free(cb);
+    *cbp = cbz;
+    cbz = NULL;
+    retval = 1;
+ done:
+    deflateEnd(&zs);
+    if (cbz)
+        cbuf_free(cbz);
+    return retval;
+#else
+    return 0;
+#endif
+}
+
+/*! Decode request body with Content-Encoding, see RFC 9110 Sec 8.4
+ *
+ * gzip and deflate are decoded if zlib is available. Other encodings are replied with
+ * 415 Unsupported Media Type and the accepted encodings
+ * @param[in]  h    Clixon handle
+ * @param[in]  sd   Http stream
+ * @retval     1    OK, body decoded or not encoded
+ * @retval     0    Invalid, error reply is set
+ * @retval    -1    Error
+ */
+int
+restconf_content_decode(clixon_handle         h,
+                        restconf_stream_data *sd)
+{
+    int            retval = -1;
+    char          *enc;
+    cxobj         *xerr = NULL;
+    char          *media_list;
+    restconf_media media_out = YANG_DATA_JSON;
+#ifdef HAVE_LIBZ
+    cbuf          *cbz = NULL;
+    z_stream       zs = {0,};
+    char           buf[16*1024];
+    int            ret;
+    int            code = 400;
+#endif
+
+    if ((enc = restconf_param_get(h, "HTTP_CONTENT_ENCODING")) == NULL ||
+        strcasecmp(enc, "identity") == 0 ||
+        sd->sd_indata == NULL || cbuf_len(sd->sd_indata) == 0)
+        goto ok;
+    if ((media_list = restconf_param_get(h, "HTTP_ACCEPT")) != NULL)
+        media_out = restconf_media_list_str2int(media_list);
+#ifdef HAVE_LIBZ
+    if (strcasecmp(enc, "gzip") == 0 ||
+        strcasecmp(enc, "x-gzip") == 0 ||
+        strcasecmp(enc, "deflate") == 0){
+        /* windowBits 15+32 detects gzip and zlib headers */
+        if (inflateInit2(&zs, 15+32) != Z_OK){
+            clixon_err(OE_RESTCONF, 0, "inflateInit2");
+            goto done;
+        }
+        if ((cbz = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        zs.next_in = (Bytef*)cbuf_get(sd->sd_indata);
+        zs.avail_in = cbuf_len(sd->sd_indata);
+        do {
+            zs.next_out = (Bytef*)buf;
+            zs.avail_out = sizeof(buf);
+            ret = inflate(&zs, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END)
+                break;
+            if (cbuf_append_buf(cbz, buf, sizeof(buf) - zs.avail_out) < 0){
+                clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                goto done;
+            }
+            if (cbuf_len(cbz) > RESTCONF_INDATA_INFLATE_MAX){
+                code = 413;
+                break;
+            }
+        } while (ret != Z_STREAM_END);
+        if (ret != Z_STREAM_END){
+            clixon_debug(CLIXON_DBG_RESTCONF, "inflate %d: %s", ret, zs.msg?zs.msg:"");
+            if (netconf_malformed_message_xml(&xerr, code==413?"Decoded request body too large":
+                                              "Invalid request body Content-Encoding") < 0)
+                goto done;
+            if (api_return_err0(h, sd, xerr, 1, media_out, code) < 0)
+                goto done;
+            goto fail;
+        }
+        clixon_debug(CLIXON_DBG_RESTCONF, "%s %zu -> %zu bytes",
+                     enc, cbuf_len(sd->sd_indata), cbuf_len(cbz));
+        cbuf_free(sd->sd_indata);
+        sd->sd_indata = cbz;
+        cbz = NULL;
+        goto ok;
     }
+    if (restconf_reply_header(sd, "Accept-Encoding", "gzip, deflate") < 0)
+        goto done;
+#else
+    if (restconf_reply_header(sd, "Accept-Encoding", "identity") < 0)
+        goto done;
+#endif
+    if (restconf_unsupported_media(h, sd, 1, media_out) < 0)
+        goto done;
+#ifdef HAVE_LIBZ
+ fail:
+#endif
+    retval = 0;
+ done:
+#ifdef HAVE_LIBZ
+    inflateEnd(&zs);
+    if (cbz)
+        cbuf_free(cbz);
+#endif
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+ ok:
+    retval = 1;
+    goto done;
+}
+
+/*! Write as much as possible of buf to socket without blocking
+ *
+ * If an SSL write could not complete, it must be retried with the same length, see
+ * rc_outq_ssl
+ * @param[in]  rc       Connection struct
+ * @param[in]  buf      Buffer to write
+ * @param[in]  buflen   Length of buffer
+ * @param[out] np       Bytes written, 0 if socket would block
+ * @retval     1        OK
+ * @retval     0        Socket write returned error, caller should close rc
+ * @retval    -1        Error
+ */
+static int
+native_write1(restconf_conn *rc,
+              char          *buf,
+              size_t         buflen,
+              size_t        *np)
+{
+    ssize_t len;
+    size_t  totlen = 0;
+    int     er;
+    SSL    *ssl = rc->rc_ssl;
+
     while (totlen < buflen){
         if (ssl){
             if ((len = SSL_write(ssl, buf+totlen, buflen-totlen)) <= 0){
                 er = errno;
                 switch (SSL_get_error(ssl, len)){
+                case SSL_ERROR_WANT_WRITE:           /* 3 */
+                    rc->rc_outq_ssl = buflen-totlen;
+                    goto wouldblock;
+                    break;
                 case SSL_ERROR_SYSCALL:              /* 5 */
                     if (er == ECONNRESET || /* Connection reset by peer */
                         er == EPIPE) {      /* Reading end of socket is closed */
-                        goto closed; /* Close socket and ssl */
+                        return 0; /* Close socket and ssl */
                     }
                     else if (er == EAGAIN){
                         clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
-                        usleep(10000);
-                        continue;
+                        rc->rc_outq_ssl = buflen-totlen;
+                        goto wouldblock;
                     }
                     else{
                         clixon_err(OE_RESTCONF, er, "SSL_write %d", er);
-                        goto done;
+                        return -1;
                     }
                     break;
                 default:
                     clixon_err(OE_SSL, 0, "SSL_write");
-                    goto done;
+                    return -1;
                     break;
                 }
-                goto done;
             }
+            rc->rc_outq_ssl = 0;
         }
         else{
             if ((len = write(rc->rc_s, buf+totlen, buflen-totlen)) < 0){
                 switch (errno){
                 case EAGAIN:     /* Operation would block */
                     clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
-                    usleep(10000);
-                    continue;
+                    goto wouldblock;
                     break;
                     //          case EBADF: // XXX if this happens there is some larger error
                 case ECONNRESET: /* Connection reset by peer */
                 case EPIPE:   /* Broken pipe */
-                    goto closed; /* Close socket and ssl */
+                    return 0; /* Close socket and ssl */
                     break;
                 default:
                     clixon_err(OE_UNIX, errno, "write %d", errno);
-                    goto done;
+                    return -1;
                     break;
                 }
             }
         }
         totlen += len;
     } /* while */
+ wouldblock:
+    *np = totlen;
+    return 1;
+}
+
+/*! Number of bytes in output queue of connection
+ */
+static size_t
+native_outq_bytes(restconf_conn *rc)
+{
+    if (rc->rc_outq == NULL)
+        return 0;
+    return cbuf_len(rc->rc_outq) - rc->rc_outq_off;
+}
+
+/*! Write output queue of connection, called from drain timer
+ *
+ * The client socket is not read while output is queued. When the queue is empty, reading
+ * is resumed, or the connection is closed if requested by restconf_close_after_write.
+ * @param[in]  rc   Connection struct
+ * @retval     1    OK
+ * @retval     0    Socket closed
+ * @retval    -1    Error
+ */
+static int
+native_outq_flush(restconf_conn *rc)
+{
+    size_t                len;
+    size_t                n = 0;
+    int                   ret;
+#ifdef HAVE_HTTP1
+    restconf_stream_data *sd;
+#endif
+
+    if ((len = native_outq_bytes(rc)) > 0){
+        if (rc->rc_outq_ssl && rc->rc_outq_ssl < len)
+            len = rc->rc_outq_ssl;
+        if ((ret = native_write1(rc, cbuf_get(rc->rc_outq) + rc->rc_outq_off, len, &n)) <= 0)
+            return ret;
+        rc->rc_outq_off += n;
+        if (native_outq_bytes(rc) == 0){
+            if (cbuf_buflen(rc->rc_outq) > RESTCONF_IDLE_BUFLEN){
+                cbuf_free(rc->rc_outq); /* Reallocated when output blocks again */
+                rc->rc_outq = NULL;
+            }
+            else
+                cbuf_reset(rc->rc_outq);
+            rc->rc_outq_off = 0;
+        }
+    }
+#ifdef HAVE_LIBNGHTTP2
+    if (rc->rc_proto == HTTP_2 && rc->rc_ngsession &&
+        nghttp2_session_want_write(rc->rc_ngsession) &&
+        nghttp2_session_send(rc->rc_ngsession) != 0){
+        if (clixon_err_category())
+            return -1;
+        return 0;
+    }
+#endif
+    if (native_outq_bytes(rc) > 0
+#ifdef HAVE_LIBNGHTTP2
+        || (rc->rc_proto == HTTP_2 && rc->rc_ngsession &&
+            nghttp2_session_want_write(rc->rc_ngsession))
+#endif
+        )
+        return restconf_conn_output_wait(rc) < 0 ? -1 : 1;
+    if (rc->rc_outq_close)
+        return 0;
+    if (rc->rc_outq_paused){
+        rc->rc_outq_paused = 0;
+        if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0)
+            return -1;
+        /* Resume requests queued while output was blocked */
+#ifdef HAVE_HTTP1
+        if ((rc->rc_proto == HTTP_10 || rc->rc_proto == HTTP_11) &&
+            (sd = restconf_stream_find(rc, 0)) != NULL &&
+            cbuf_len(sd->sd_inbuf) > 0 &&
+            native_conn_queue_wait(rc) < 0)
+            return -1;
+#endif
+#ifdef HAVE_LIBNGHTTP2
+        if (rc->rc_proto == HTTP_2 && rc->rc_ready > 0 &&
+            native_conn_queue_wait(rc) < 0)
+            return -1;
+#endif
+    }
+    return 1;
+}
+
+/*! Drain timer of connection output, see restconf_conn_output_wait
+ *
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Connection struct
+ */
+static int
+native_outq_drain(int   fd,
+                  void *arg)
+{
+    restconf_conn *rc = (restconf_conn *)arg;
+    int            ret;
+
+    rc->rc_outq_timer = 0;
+    if ((ret = native_outq_flush(rc)) < 0)
+        return -1;
+    if (ret == 0){
+        if (restconf_close_ssl_socket(rc, __func__, 0) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Output of connection would block: write it later from the event loop
+ *
+ * Stop reading the client socket until the output is written, so that a client that does
+ * not read its replies does not make the server queue more.
+ * The event loop has no write events, output is retried with a timer, as the output queues
+ * of the backend
+ * @param[in]  rc   Connection struct
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+restconf_conn_output_wait(restconf_conn *rc)
+{
+    struct timeval t;
+    struct timeval tr = {0, 10000}; /* Retry after 10 ms */
+
+    if (!rc->rc_outq_paused){
+        clixon_event_unreg_fd(rc->rc_s, restconf_connection);
+        rc->rc_outq_paused = 1;
+    }
+    if (!rc->rc_outq_timer){
+        gettimeofday(&t, NULL);
+        timeradd(&t, &tr, &t);
+        if (clixon_event_reg_timeout(t, native_outq_drain, (void*)rc, "restconf output") < 0)
+            return -1;
+        rc->rc_outq_timer = 1;
+    }
+    return 0;
+}
+
+/*! Close connection when its queued output is written
+ *
+ * @param[in]  rc       Connection struct
+ * @param[in]  callfn   For debug
+ * @retval     0        OK, rc is closed now or later and should not be used
+ * @retval    -1        Error
+ */
+static int
+restconf_close_after_write(restconf_conn *rc,
+                           const char    *callfn)
+{
+    if (native_outq_bytes(rc) > 0){
+        rc->rc_outq_close = 1;
+        return 0;
+    }
+    return restconf_close_ssl_socket(rc, callfn, 0);
+}
+
+/* Write buf to socket
+ *
+ * Only (at least mostly?) for HTTP/1
+ * What cannot be written without blocking is queued in the connection and written from
+ * the event loop, see restconf_conn_output_wait
+ * @param[in]  h        Clixon handle
+ * @param[in]  buf      Buffer to write
+ * @param[in]  buflen   Length of buffer
+ * @param[in]  rc       Connection struct
+ * @param[in]  callfn   For debug
+ * @retval  1  OK
+ * @retval  0  OK, but socket write returned error, caller should close rc
+ * @retval -1  Error
+ */
+int
+native_buf_write(clixon_handle    h,
+                 char            *buf,
+                 size_t           buflen,
+                 restconf_conn   *rc,
+                 const char      *callfn)
+{
+    int     retval = -1;
+    size_t  n = 0;
+    int     ret;
+
+    if (rc == NULL){
+        clixon_err(OE_RESTCONF, EINVAL, "rc is NULL");
+        goto done;
+    }
+    /* Two problems with debugging buffers that this fixes:
+     * 1. they are not "strings" in the sense they are not NULL-terminated
+     * 2. they are often very long
+     */
+    if ((clixon_debug_get() & CLIXON_DBG_RESTCONF) != 0) {
+        char *dbgstr = NULL;
+        size_t sz;
+        sz = buflen>256?256:buflen; /* Truncate to 256 */
+        if ((dbgstr = malloc(sz+1)) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memcpy(dbgstr, buf, sz);
+        dbgstr[sz] = '\0';
+        clixon_debug(CLIXON_DBG_RESTCONF, "%s buflen:%zu buf:\n%s", callfn, buflen, dbgstr);
+        free(dbgstr);
+    }
+    /* Queued output is written first to keep order */
+    if (native_outq_bytes(rc) == 0){
+        if ((ret = native_write1(rc, buf, buflen, &n)) < 0)
+            goto done;
+        if (ret == 0)
+            goto closed;
+        if (n == buflen)
+            goto ok;
+    }
+    if (rc->rc_outq == NULL &&
+        (rc->rc_outq = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (rc->rc_outq_off > cbuf_len(rc->rc_outq)/2){ /* Compact */
+        memmove(cbuf_get(rc->rc_outq), cbuf_get(rc->rc_outq) + rc->rc_outq_off, native_outq_bytes(rc));
+        cbuf_trunc(rc->rc_outq, native_outq_bytes(rc));
+        rc->rc_outq_off = 0;
+    }
+    if (cbuf_append_buf(rc->rc_outq, buf+n, buflen-n) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (restconf_conn_output_wait(rc) < 0)
+        goto done;
+ ok:
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
@@ -486,6 +1100,83 @@ native_buf_write(clixon_handle    h,
     goto done;
 }
 
+#ifdef HAVE_HTTP1
+/*! Kernel TLS is used for sending on connection, see CLICON_RESTCONF_TLS_KTLS
+ */
+static int
+native_ktls_send(restconf_conn *rc)
+{
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+    return BIO_get_ktls_send(SSL_get_wbio(rc->rc_ssl));
+#else
+    return 0;
+#endif
+}
+
+/*! Write file as body of HTTP/1 reply, see restconf_reply_send_file
+ *
+ * The file is sent by the kernel without copying it to user space: with sendfile(2) on
+ * plain sockets and SSL_sendfile with kernel TLS.
+ * Otherwise, or if the socket would block, the rest is read and written with
+ * native_buf_write which queues what cannot be written
+ * @param[in]  h    Clixon handle
+ * @param[in]  rc   Connection struct
+ * @param[in]  fd   Open file
+ * @param[in]  off  Offset of body in file
+ * @param[in]  len  Length of body
+ * @retval     1    OK
+ * @retval     0    OK, but socket write returned error, caller should close rc
+ * @retval    -1    Error
+ */
+static int
+native_file_write(clixon_handle  h,
+                  restconf_conn *rc,
+                  int            fd,
+                  off_t          off,
+                  size_t         len)
+{
+    off_t   end = off + len;
+    ssize_t n;
+    char    buf[16*1024];
+    int     ret;
+
+    if (native_outq_bytes(rc) == 0){
+        while (off < end){
+            if (rc->rc_ssl){
+                if (!native_ktls_send(rc))
+                    break;
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+                if ((n = SSL_sendfile(rc->rc_ssl, fd, off, end-off, 0)) <= 0)
+                    break;
+                off += n;
+#endif
+            }
+            else {
+#ifdef __linux__
+                if (sendfile(rc->rc_s, fd, &off, end-off) <= 0) /* Advances off */
+                    break;
+#else
+                break;
+#endif
+            }
+        }
+        clixon_debug(CLIXON_DBG_RESTCONF, "sendfile %zu of %zu bytes", len-(size_t)(end-off), len);
+    }
+    while (off < end){
+        if ((n = pread(fd, buf, (size_t)(end-off)<sizeof(buf)?(size_t)(end-off):sizeof(buf), off)) < 0){
+            clixon_err(OE_UNIX, errno, "pread");
+            return -1;
+        }
+        if (n == 0) /* File truncated, Content-Length cannot be met */
+            return 0;
+        if ((ret = native_buf_write(h, buf, n, rc, __func__)) <= 0)
+            return ret;
+        off += n;
+    }
+    return 1;
+}
+#endif /* HAVE_HTTP1 */
+
 /*! Send early handcoded bad request reply before actual packet received, just after accept
  *
  * @param[in]  h    Clixon handle
@@ -544,6 +1235,7 @@ http1_native_clear_input(clixon_handle         h,
     int retval = -1;
 
     cbuf_reset(sd->sd_indata);
+    sd->sd_inlen = 0;
     if (sd->sd_qvec){
         cvec_free(sd->sd_qvec);
         sd->sd_qvec = NULL;
@@ -677,6 +1369,9 @@ restconf_http1_process(restconf_conn *rc,
     int                   ret;
     int                   status;
     cbuf                 *cberr = NULL;
+    size_t                prevlen;
+    size_t                used;
+    int                   nreq = 0;
 
     h = rc->rc_h;
     if ((sd = restconf_stream_find(rc, 0)) == NULL){
@@ -684,120 +1379,132 @@ restconf_http1_process(restconf_conn *rc,
         goto done;
     }
     /* Two states for reading:
-     * 1) Initial reading of headers, parse from start
-     * 2) Headers are read / body started, dont parse, just append body
-     */
-    /* Check whole message is read. 
-     * Only way this could happen is that body is read
-     * 0: No Content-Length or 0
-     *    header does not contain Content-Length or is 0
-     *    (OR: message header not fully read SHOULDNT HAPPEN IF BODY READ)
-     * 1: Content-Length found but body has fewer bytes, ie remaining bytes to read
-     * 2: Content-Length found and matches body length. No more bytes to read
+     * 1) Reading of request-line and headers, incrementally scanned in sd_inbuf
+     * 2) Headers are parsed, append body to sd_indata up to Content-Length
+     * Bytes after the body start the next pipelined request and are kept in sd_inbuf
      */
     if ((ret = http1_check_content_length(h, sd, &status)) < 0)
         goto done;
-    if (status == 1){   /* Next read: keep header state and only append inbody */
-        if (cbuf_append_buf(sd->sd_indata, buf, n) < 0){
-            clixon_err(OE_UNIX, errno, "cbuf_append");
+    if (status == 1){   /* Next read: keep header state and only append body */
+        if (http1_body_append(h, sd, buf, n, &used) < 0)
             goto done;
-        }
+        buf += used;
+        n -= used;
     }
-    else {
-        /* multi-buffer for multiple reads 
-         * This is different from sd_indata that it is before and includes headers
-         */
-        if (cbuf_append_buf(sd->sd_inbuf, buf, n) < 0){
-            clixon_err(OE_UNIX, errno, "cbuf_append");
-            goto done;
-        }
-        if (clixon_http1_parse_string(h, rc, cbuf_get(sd->sd_inbuf)) < 0){
-            /* XXX This does not work for SSL */
-            if (rc->rc_ssl){
-                ret = SSL_pending(rc->rc_ssl);
-            }
-            else if ((ret = clixon_event_poll(rc->rc_s)) < 0)
-                goto done;
-            if (ret > 0){
+    prevlen = cbuf_len(sd->sd_inbuf);
+    if (n > 0 && cbuf_append_buf(sd->sd_inbuf, buf, n) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append");
+        goto done;
+    }
+    /* Loop over pipelined requests */
+    while (1){
+        if (status != 1){
+            if ((ret = clixon_http1_parse_inbuf(h, rc, sd, prevlen)) < 0){
+                if ((cberr = cbuf_new()) == NULL){
+                    clixon_err(OE_UNIX, errno, "cbuf_new");
+                    goto done;
+                }
+                cprintf(cberr, "<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>%s</error-message></error></errors>", clixon_err_reason());
+                if ((ret = native_send_badrequest(h, "application/yang-data+xml", cbuf_get(cberr), rc)) < 0)
+                    goto done;
                 if (http1_native_clear_input(h, sd) < 0)
                     goto done;
-                (*readmore)++;
+                if (restconf_close_ssl_socket(rc, __func__, 0) < 0)
+                    goto done;
+                rc = NULL;
+                goto closed;
+            }
+            if (ret == 0){ /* Partial header section, wait for more data */
+                if (rc->rc_ssl && SSL_pending(rc->rc_ssl) > 0)
+                    (*readmore)++;
                 goto ok;
             }
-            /* Return error. Honestly, the sender could just e slow, it should really be a 
-             * timeout here.
+            /* Check for Continue and if so reply with 100 Continue 
+             * ret == 1: send reply
              */
-            if ((cberr = cbuf_new()) == NULL){
-                clixon_err(OE_UNIX, errno, "cbuf_new");
+            if ((ret = http1_check_expect(h, rc, sd)) < 0)
                 goto done;
+            if (ret == 1){
+                if ((ret = native_buf_write(h, cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf),
+                                            rc, __func__)) < 0)
+                    goto done;
+                cvec_reset(sd->sd_outp_hdrs);
+                cbuf_reset(sd->sd_outp_buf);
+                if (ret == 0){
+                    if (restconf_close_ssl_socket(rc, __func__, 0) < 0)
+                        goto done;
+                    rc = NULL;
+                    goto closed;
+                }
             }
-            cprintf(cberr, "<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>%s</error-message></error></errors>", clixon_err_reason());
-            if ((ret = native_send_badrequest(h, "application/yang-data+xml", cbuf_get(cberr), rc)) < 0)
+        }
+        /* Check whole message is read. 
+         * 0: No Content-Length or 0
+         * 1: Content-Length found but body has fewer bytes, ie remaining bytes to read
+         * 2: Content-Length found and matches body length. No more bytes to read
+         */
+        if ((ret = http1_check_content_length(h, sd, &status)) < 0)
+            goto done;
+        if (status == 1){
+            (*readmore)++;
+            goto ok;
+        }
+        /* nginx compatible, set HTTPS parameter if SSL */
+        if (rc->rc_ssl)
+            if (restconf_param_set(h, "HTTPS", "https") < 0)
                 goto done;
-            if (http1_native_clear_input(h, sd) < 0)
+        /* main restconf processing */
+        if (restconf_http1_path_root(h, rc) < 0)
+            goto done;
+        if ((ret = native_buf_write(h, cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf),
+                                    rc, __func__)) < 0)
+            goto done;
+        if (sd->sd_fd != -1){ /* Body is a file */
+            if (ret == 1 &&
+                (ret = native_file_write(h, rc, sd->sd_fd, sd->sd_body_offset, sd->sd_body_len)) < 0)
                 goto done;
+            close(sd->sd_fd);
+            sd->sd_fd = -1;
+        }
+        cvec_reset(sd->sd_outp_hdrs); /* Can be done in native_send_reply */
+        cbuf_reset(sd->sd_outp_buf);
+        cbuf_reset(sd->sd_indata);
+        sd->sd_inlen = 0;
+        if (sd->sd_body)
+            cbuf_reset(sd->sd_body);
+        if (sd->sd_qvec){
+            cvec_free(sd->sd_qvec);
+            sd->sd_qvec = NULL;
+        }
+        if (restconf_stream_release(sd) < 0)
+            goto done;
+        if (ret == 0){
             if (restconf_close_ssl_socket(rc, __func__, 0) < 0)
                 goto done;
-            rc = NULL;
             goto closed;
         }
-        /* Check for Continue and if so reply with 100 Continue 
-         * ret == 1: send reply
-         */
-        if ((ret = http1_check_expect(h, rc, sd)) < 0)
-            goto done;
-        if (ret == 1){
-            if ((ret = native_buf_write(h, cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf),
-                                        rc, __func__)) < 0)
+        if (rc->rc_exit){  /* Server-initiated exit, after reply is written */
+            if (restconf_close_after_write(rc, __func__) < 0)
                 goto done;
-            cvec_reset(sd->sd_outp_hdrs);
-            cbuf_reset(sd->sd_outp_buf);
-            if (ret == 0){
-                if (restconf_close_ssl_socket(rc, __func__, 0) < 0)
-                    goto done;
-                rc = NULL;
-                goto closed;
-            }
+            goto closed;
         }
-    }
-    /* Check whole message is read. 
-     * Only way this could happen is that body is read
-     * 0: No Content-Length or 0
-     *    header does not contain Content-Length or is 0
-     *    (OR: message header not fully read SHOULDNT HAPPEN IF BODY READ OK in parse above)
-     * 1: Content-Length found but body has fewer bytes, ie remaining bytes to read
-     * 2: Content-Length found and matches body length. No more bytes to read
-     */
-    if ((ret = http1_check_content_length(h, sd, &status)) < 0)
-        goto done;
-    if (status == 1){
-        (*readmore)++;
-        goto ok;
-    }
-    /* nginx compatible, set HTTPS parameter if SSL */
-    if (rc->rc_ssl)
-        if (restconf_param_set(h, "HTTPS", "https") < 0)
-            goto done;
-    /* main restconf processing */
-    if (restconf_http1_path_root(h, rc) < 0)
-        goto done;
-    if ((ret = native_buf_write(h, cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf),
-                                rc, __func__)) < 0)
-        goto done;
-    cvec_reset(sd->sd_outp_hdrs); /* Can be done in native_send_reply */
-    cbuf_reset(sd->sd_outp_buf);
-    cbuf_reset(sd->sd_inbuf);
-    cbuf_reset(sd->sd_indata);
-    if (sd->sd_body)
-        cbuf_reset(sd->sd_body);
-    if (sd->sd_qvec){
-        cvec_free(sd->sd_qvec);
-        sd->sd_qvec = NULL;
-    }
-    if (ret == 0 || rc->rc_exit){  /* Server-initiated exit */
-        if (restconf_close_ssl_socket(rc, __func__, 0) < 0)
-            goto done;
-        goto closed;
+        if (sd->sd_upgrade2){ /* Upgrade to http/2, no more http/1 requests */
+            cbuf_reset(sd->sd_inbuf);
+            break;
+        }
+        if (cbuf_len(sd->sd_inbuf) == 0)
+            break;
+        /* Next pipelined request stays queued in sd_inbuf while output would block,
+         * and after a batch of requests so that other connections are served */
+        if (rc->rc_outq_paused) /* Resumed by native_outq_flush */
+            break;
+        if (++nreq >= HTTP1_PIPELINE_BATCH){
+            if (native_conn_queue_wait(rc) < 0)
+                goto done;
+            break;
+        }
+        prevlen = 0;
+        status = 0;
     }
  ok:
     retval = 1;
@@ -809,6 +1516,7 @@ restconf_http1_process(restconf_conn *rc,
     retval = 0;
     goto done;
 }
+
 #endif
 
 #ifdef HAVE_LIBNGHTTP2
@@ -925,6 +1633,73 @@ restconf_http2_process(restconf_conn *rc,
 }
 #endif /* HAVE_LIBNGHTTP2 */
 
+/*! Timer callback processing requests queued in connection
+ *
+ * HTTP/1 pipelined requests are queued in the receive buffer, HTTP/2 streams whose
+ * request is received are marked ready
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Connection struct
+ * @see native_conn_queue_wait
+ */
+static int
+native_conn_dequeue(int   fd,
+                    void *arg)
+{
+    restconf_conn *rc = (restconf_conn *)arg;
+    int            readmore = 0;
+    int            ret = 1;
+
+    rc->rc_inq_timer = 0;
+    if (clicon_client_pool_select(rc->rc_h, rc) < 0)
+        return -1;
+    switch (rc->rc_proto){
+#ifdef HAVE_HTTP1
+    case HTTP_10:
+    case HTTP_11:
+        if ((ret = restconf_http1_process(rc, NULL, 0, &readmore)) < 0)
+            return -1;
+        break;
+#endif
+#ifdef HAVE_LIBNGHTTP2
+    case HTTP_2:
+        if ((ret = http2_dispatch(rc)) < 0)
+            return -1;
+        if (ret == 0){
+            if (restconf_close_ssl_socket(rc, __func__, 0) < 0)
+                return -1;
+            return 0;
+        }
+        break;
+#endif
+    default:
+        break;
+    }
+    if (ret == 1 && readmore && !rc->rc_outq_paused)
+        return restconf_connection(rc->rc_s, rc);
+    return 0;
+}
+
+/*! Process queued requests of connection later from the event loop
+ *
+ * Queued requests are processed in order, see restconf_http1_process and http2_dispatch
+ * @param[in]  rc   Connection struct
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+native_conn_queue_wait(restconf_conn *rc)
+{
+    struct timeval t;
+
+    if (!rc->rc_inq_timer){
+        gettimeofday(&t, NULL);
+        if (clixon_event_reg_timeout(t, native_conn_dequeue, (void*)rc, "restconf queued requests") < 0)
+            return -1;
+        rc->rc_inq_timer = 1;
+    }
+    return 0;
+}
+
 /*! Get restconf native handle
  *
  * @param[in]  h     Clixon handle
@@ -964,7 +1739,7 @@ restconf_connection(int   s,
     int            retval = -1;
     restconf_conn *rc = NULL;
     ssize_t        n;
-    char           buf[1024]; /* Alter BUFSIZ (8K) from stdio.h 8K. 256 fails some tests */
+    char           buf[RESTCONF_READ_BUFLEN];
     int            readmore = 1;
     int            ret;
 
@@ -978,6 +1753,9 @@ restconf_connection(int   s,
         goto done;
     }
     gettimeofday(&rc->rc_t, NULL); /* activity timer */
+    /* Requests of connection use its backend session, see CLICON_RESTCONF_BACKEND_SESSIONS */
+    if (clicon_client_pool_select(rc->rc_h, rc) < 0)
+        goto done;
     while (readmore) {
         clixon_debug(CLIXON_DBG_RESTCONF, "readmore");
         readmore = 0;
@@ -1319,6 +2097,7 @@ restconf_ssl_accept_client(clixon_handle    h,
                 switch (e){
                 case SSL_ERROR_SSL:                  /* 1 */
                     clixon_debug(CLIXON_DBG_RESTCONF, "SSL_ERROR_SSL (non-ssl message on ssl socket)");
+                    restconf_metrics_tls(0);
 #ifdef HTTP_ON_HTTPS_REPLY
                     SSL_free(rc->rc_ssl);
                     rc->rc_ssl = NULL;
@@ -1337,6 +2116,7 @@ restconf_ssl_accept_client(clixon_handle    h,
                        operations should be performed on the connection and SSL_shutdown() must 
                        not be called.*/
                     clixon_debug(CLIXON_DBG_RESTCONF, "SSL_accept() SSL_ERROR_SYSCALL %d", er);
+                    restconf_metrics_tls(0);
                     if (restconf_close_ssl_socket(rc, __func__, 1) < 0)
                         goto done;
                     rc = NULL;
@@ -1370,6 +2150,7 @@ restconf_ssl_accept_client(clixon_handle    h,
                 }
             } /* SSL_accept */
         } /* while(readmore) */
+        restconf_metrics_tls(1);
         /* Sets data and len to point to the client's requested protocol for this connection. */
 #ifndef OPENSSL_NO_NEXTPROTONEG
         SSL_get0_next_proto_negotiated(rc->rc_ssl, &alpn, &alpnlen);
@@ -1384,6 +2165,16 @@ restconf_ssl_accept_client(clixon_handle    h,
             goto closed;
         }
         clixon_debug(CLIXON_DBG_RESTCONF, "proto:%s", restconf_proto2str(proto));
+        /* Resumed sessions skip certificate exchange, see CLICON_RESTCONF_TLS_SESSION_CACHE */
+        clixon_debug(CLIXON_DBG_RESTCONF, "session reused:%d, %ld of %ld handshakes resumed",
+                     SSL_session_reused(rc->rc_ssl),
+                     SSL_CTX_sess_hits(SSL_get_SSL_CTX(rc->rc_ssl)),
+                     SSL_CTX_sess_accept_good(SSL_get_SSL_CTX(rc->rc_ssl)));
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+        /* See CLICON_RESTCONF_TLS_KTLS */
+        clixon_debug(CLIXON_DBG_RESTCONF, "kernel TLS send:%d",
+                     (int)BIO_get_ktls_send(SSL_get_wbio(rc->rc_ssl)));
+#endif
 
         /* Get the actual peer, XXX this maybe could be done in ca-auth client-cert code ? 
          * Note this _only_ works if SSL_set1_host() was set previously,...
@@ -64,6 +64,29 @@ extern "C" {
 #ifndef _RESTCONF_NATIVE_H_
 #define _RESTCONF_NATIVE_H_
 
+/*
+ * Constants
+ */
+/* Size of socket read buffer of connection, several small pipelined requests are read at once
+ * 256 fails some tests */
+#define RESTCONF_READ_BUFLEN (16*1024)
+
+/* Max preallocation of request body from Content-Length, see restconf_stream_indata_alloc */
+#define RESTCONF_INDATA_ALLOC_MAX (16*1024*1024)
+
+/* Max Content-Length of request body, see restconf_content_length */
+#define RESTCONF_INDATA_MAX (256*1024*1024)
+
+/* Max size of request body decoded from Content-Encoding, see restconf_content_decode */
+#define RESTCONF_INDATA_INFLATE_MAX (256*1024*1024)
+
+/* Buffers of a connection larger than this are released when a request is done, so that
+ * idle connections do not keep the buffers of their largest request, see restconf_stream_release */
+#define RESTCONF_IDLE_BUFLEN (4*1024)
+
+/* Max number of freed connection structs kept for reuse, see restconf_conn_new */
+#define RESTCONF_CONN_POOL_MAX 256
+
 /*
  * Types
  */
@@ -76,14 +99,15 @@ struct restconf_conn;
 typedef struct  {
     qelem_t               sd_qelem;     /* List header */
     int32_t               sd_stream_id;
-    int                   sd_fd;        /* XXX Is this used? */
+    int                   sd_fd;        /* Body file of reply or -1, see restconf_reply_send_file */
     cvec                 *sd_outp_hdrs; /* List of output headers */
     cbuf                 *sd_outp_buf;  /* Output buffer */
     cbuf                 *sd_body;      /* http output body as cbuf terminated with \r\n */
     size_t                sd_body_len;  /* Content-Length, note for HEAD body body can be NULL and this non-zero */
     size_t                sd_body_offset; /* Offset into body */
-    cbuf                 *sd_inbuf;     /* Receive/input buf (whole message) */
+    cbuf                 *sd_inbuf;     /* Receive buf: header section and pipelined requests */
     cbuf                 *sd_indata;    /* Receive/input data body */
+    size_t                sd_inlen;     /* Content-Length of request body, 0 if none */
     char                 *sd_path;      /* Uri path, uri-encoded, without args (eg ?) */
     uint16_t              sd_code;      /* If != 0 send a reply XXX: need reply flag? */
     struct restconf_conn *sd_conn;      /* Backpointer to connection this stream is part of */
@@ -92,6 +116,8 @@ typedef struct  {
     void                 *sd_req;       /* Lib-specific request */
     int                   sd_upgrade2;  /* Upgrade to http/2 */
     uint8_t              *sd_settings2; /* Settings for upgrade to http/2 request */
+    cvec                 *sd_inhdrs;    /* Request headers of http/2 stream until dispatch */
+    int                   sd_ready;     /* Http/2 request received, ready for dispatch */
 } restconf_stream_data;
 
 typedef struct restconf_socket restconf_socket;
@@ -122,6 +148,15 @@ typedef struct restconf_conn {
     struct timeval        rc_t;         /* Timestamp of last read/write activity, used by callhome
                                            idle-timeout algorithm */
     int                   rc_event_stream;    /* Event notification stream socket (maybe in sd?) */
+    clixon_msg_pipe      *rc_event_pipe;      /* Receive state of rc_event_stream */
+    cbuf                 *rc_outq;      /* Output not yet written, see native_buf_write */
+    size_t                rc_outq_off;  /* Bytes of rc_outq already written */
+    size_t                rc_outq_ssl;  /* Length of SSL_write to retry, 0 if none */
+    int                   rc_outq_timer;  /* Drain timer registered */
+    int                   rc_outq_paused; /* Socket not read until output is written */
+    int                   rc_outq_close;  /* Close connection when output is written */
+    int                   rc_inq_timer;   /* Timer processing queued requests registered */
+    int                   rc_ready;       /* Nr of http/2 streams ready for dispatch */
 } restconf_conn;
 
 /* Restconf per socket handle
@@ -174,13 +209,21 @@ typedef struct {
  */
 restconf_stream_data *restconf_stream_data_new(restconf_conn *rc, int32_t stream_id);
 restconf_stream_data *restconf_stream_find(restconf_conn *rc, int32_t id);
+int               restconf_stream_indata_alloc(restconf_stream_data *sd, size_t len);
+int               restconf_content_length(const char *val, size_t *lenp);
 int               restconf_stream_free(restconf_stream_data *sd);
 restconf_conn    *restconf_conn_new(clixon_handle h, int s, restconf_socket *socket);
+size_t            restconf_conn_size(restconf_conn *rc);
+size_t            restconf_native_conn_bytes(clixon_handle h);
+void              restconf_conn_pool_free(void);
 int               ssl_x509_name_oneline(SSL *ssl, char **oneline);
 
 int               restconf_close_ssl_socket(restconf_conn *rc, const char *callfn, int sslerr0);
 int               restconf_connection_sanity(clixon_handle h, restconf_conn *rc, restconf_stream_data *sd);
+int               restconf_reply_compress(clixon_handle h, restconf_stream_data *sd, cbuf **cbp);
+int               restconf_content_decode(clixon_handle h, restconf_stream_data *sd);
 int               native_buf_write(clixon_handle h, char *buf, size_t buflen, restconf_conn *rc, const char *callfn);
+int               restconf_conn_output_wait(restconf_conn *rc);
 restconf_native_handle *restconf_native_handle_get(clixon_handle h);
 int               restconf_connection(int s, void *arg);
 int               restconf_ssl_accept_client(clixon_handle h, int s, restconf_socket *rsock, restconf_conn  **rcp);
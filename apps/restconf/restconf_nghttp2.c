@@ -52,6 +52,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <syslog.h>
@@ -90,6 +91,7 @@
 #ifdef HAVE_LIBNGHTTP2          /* Ends at end-of-file */
 #include "restconf_nghttp2.h"   /* Restconf-openssl mode specific headers*/
 #include "clixon_http_data.h"
+#include "restconf_metrics.h"
 
 #define ARRLEN(x) (sizeof(x) / sizeof(x[0]))
 
@@ -198,8 +200,7 @@ session_send_callback(nghttp2_session *session,
                 switch (sslerr){
                 case SSL_ERROR_WANT_WRITE:           /* 3 */
                     clixon_debug(CLIXON_DBG_RESTCONF, "write SSL_ERROR_WANT_WRITE");
-                    usleep(1000);
-                    continue;
+                    goto wouldblock;
                     break;
                 case SSL_ERROR_SYSCALL:              /* 5 */
                     if (er == ECONNRESET || /* Connection reset by peer */
@@ -212,8 +213,7 @@ session_send_callback(nghttp2_session *session,
                          * ssl lib versions?
                          */
                         clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
-                        usleep(1000);
-                        continue;
+                        goto wouldblock;
                     }
                     else{
                         clixon_err(OE_RESTCONF, er, "SSL_write %d", sslerr);
@@ -232,8 +232,7 @@ session_send_callback(nghttp2_session *session,
             if ((len = write(s, buf+totlen, buflen-totlen)) < 0){
                 if (errno == EAGAIN){
                     clixon_debug(CLIXON_DBG_RESTCONF, "write EAGAIN");
-                    usleep(10000);
-                    continue;
+                    goto wouldblock;
                 }
 #if 1
                 else if (errno == ECONNRESET) {/* Connection reset by peer */
@@ -263,6 +262,15 @@ session_send_callback(nghttp2_session *session,
     }
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%zd", totlen);
     return retval == 0 ? totlen : retval;
+ wouldblock:
+    /* Frames not sent remain in the session, and are sent from the event loop.
+     * An SSL write is retried by nghttp2 with the same data */
+    if (restconf_conn_output_wait(rc) < 0)
+        goto done;
+    if (totlen > 0)
+        goto ok;
+    retval = NGHTTP2_ERR_WOULDBLOCK;
+    goto done;
 }
 
 /*! Invoked when |session| wants to receive data from the remote peer.  
@@ -302,8 +310,11 @@ restconf_nghttp2_path(restconf_stream_data *sd)
     char          *oneline = NULL;
     cvec          *cvv = NULL;
     char          *cn;
+    int            ret = 0;
+    struct timespec t0;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "------------");
+    event_profile_start(&t0);
     rc = sd->sd_conn;
     if ((h = rc->rc_h) == NULL){
         clixon_err(OE_RESTCONF, EINVAL, "arg is NULL");
@@ -327,7 +338,11 @@ restconf_nghttp2_path(restconf_stream_data *sd)
     /* Check sanity of session, eg ssl client cert validation, may set rc_exit */
     if (restconf_connection_sanity(h, rc, sd) < 0)
         goto done;
-    if (!rc->rc_exit){
+    /* Decode request body with Content-Encoding, may reply error */
+    if (!rc->rc_exit &&
+        (ret = restconf_content_decode(h, sd)) < 0)
+        goto done;
+    if (!rc->rc_exit && ret == 1){
         /* Matching algorithm:
          * 1. try well-known
          * 2. try /restconf
@@ -339,6 +354,10 @@ restconf_nghttp2_path(restconf_stream_data *sd)
             if (api_well_known(h, sd) < 0)
                 goto done;
         }
+        else if (api_path_is_metrics(h)){
+            if (api_metrics(h, sd) < 0)
+                goto done;
+        }
         else if (api_path_is_restconf(h)){
             if (api_root_restconf(h, sd, sd->sd_qvec) < 0)
                 goto done;
@@ -355,6 +374,9 @@ restconf_nghttp2_path(restconf_stream_data *sd)
         else if (api_root_restconf(h, sd, sd->sd_qvec) < 0) /* error handling */
             goto done;
     }
+    if (sd->sd_code)
+        restconf_metrics_request(restconf_param_get(h, "REQUEST_METHOD"), sd->sd_code,
+                                 event_profile_usec(&t0));
     /* Clear (fcgi) paramaters from this request */
     if (restconf_param_del_all(h) < 0)
         goto done;
@@ -539,6 +561,7 @@ http2_exec(restconf_conn        *rc,
     clixon_debug(CLIXON_DBG_RESTCONF, "path:%s", sd->sd_path);
     /* Early sanity check. Full dispatch in restconf_nghttp2_path */
     if (strcmp(sd->sd_path, RESTCONF_WELL_KNOWN) == 0
+        || api_path_is_metrics(rc->rc_h)
         || api_path_is_restconf(rc->rc_h)
         || api_path_is_data(rc->rc_h)
         || api_path_is_stream(rc->rc_h)
@@ -590,10 +613,8 @@ on_frame_recv_callback(nghttp2_session     *session,
                        const nghttp2_frame *frame,
                        void                *user_data)
 {
-    int                   retval = -1;
     restconf_conn        *rc = (restconf_conn *)user_data;
     restconf_stream_data *sd = NULL;
-    char                 *query;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "%s %d",
                  clicon_int2str(nghttp2_frame_type_map, frame->hd.type),
@@ -608,25 +629,17 @@ on_frame_recv_callback(nghttp2_session     *session,
              */
             if ((sd = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id)) == NULL)
                 return 0;
-            /* Query vector, ie the ?a=x&b=y stuff */
-            query = restconf_param_get(rc->rc_h, "REQUEST_URI");
-            if ((query = index(query, '?')) != NULL){
-                query++;
-                if (strlen(query) &&
-                    uri_str2cvec(query, '&', '=', 1, &sd->sd_qvec) < 0)
-                    goto done;
+            /* Dispatched after all received frames are processed, see http2_dispatch */
+            if (!sd->sd_ready){
+                sd->sd_ready = 1;
+                rc->rc_ready++;
             }
-            if (http2_exec(rc, sd, session, frame->hd.stream_id) < 0)
-                goto done;
         }
         break;
     default:
         break;
     }
-    retval = 0;
- done:
-    clixon_debug(CLIXON_DBG_RESTCONF|CLIXON_DBG_DETAIL, "retval:%d", retval);
-    return retval;
+    return 0;
 }
 
 /*! An invalid non-DATA frame is received. 
@@ -736,6 +749,7 @@ on_stream_close_callback(nghttp2_session   *session,
     //    restconf_conn *rc = (restconf_conn *)user_data;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "%d %s", error_code, nghttp2_strerror(error_code));
+    restconf_metrics_stream(-1);
 #if 0 // NOTNEEDED /* XXX think this is not necessary? */
     if (error_code){
         if (restconf_close_ssl_socket(rc, __func__, 0) < 0)
@@ -764,6 +778,7 @@ on_begin_headers_callback(nghttp2_session     *session,
         frame->headers.cat == NGHTTP2_HCAT_REQUEST) {
         sd = restconf_stream_data_new(rc, frame->hd.stream_id);
         nghttp2_session_set_stream_user_data(session, frame->hd.stream_id, sd);
+        restconf_metrics_stream(1);
     }
     return 0;
 }
@@ -825,14 +840,35 @@ on_header_callback(nghttp2_session     *session,
                    void               *user_data)
 {
     int                   retval = -1;
-    restconf_conn      *rc = (restconf_conn *)user_data;
+    restconf_conn        *rc = (restconf_conn *)user_data;
+    restconf_stream_data *sd;
 
     switch (frame->hd.type){
     case NGHTTP2_HEADERS:
         assert (frame->headers.cat == NGHTTP2_HCAT_REQUEST);
         clixon_debug(CLIXON_DBG_RESTCONF, "HEADERS %s %s", name, value);
-        if (nghttp2_hdr2clixon(rc->rc_h, (char*)name, (char*)value) < 0)
+        if ((sd = restconf_stream_find(rc, frame->hd.stream_id)) == NULL)
+            break;
+        /* Headers are kept in the stream, other streams may be received before dispatch */
+        if (sd->sd_inhdrs == NULL &&
+            (sd->sd_inhdrs = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        if (cvec_add_string(sd->sd_inhdrs, (char*)name, (char*)value) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
             goto done;
+        }
+        /* Preallocate body buffer before DATA frames are received */
+        if (strcmp((char*)name, "content-length") == 0){
+            if (restconf_content_length((char*)value, &sd->sd_inlen) == 0){
+                clixon_debug(CLIXON_DBG_RESTCONF, "Invalid content-length: %s", value);
+                retval = NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE; /* Reset stream */
+                goto done;
+            }
+            if (restconf_stream_indata_alloc(sd, sd->sd_inlen) < 0)
+                goto done;
+        }
         break;
     default:
         clixon_debug(CLIXON_DBG_RESTCONF, "%s %s", clicon_int2str(nghttp2_frame_type_map, frame->hd.type), name);
@@ -939,6 +975,92 @@ error_callback2(nghttp2_session *session,
 }
 #endif
 
+/*! Execute received request of http/2 stream
+ *
+ * Restconf parameters are set from the request headers of the stream
+ * @param[in] rc        Restconf connection
+ * @param[in] sd        Restconf native stream struct
+ * @retval    0         OK
+ * @retval   -1         Error
+ */
+static int
+http2_stream_exec(restconf_conn        *rc,
+                  restconf_stream_data *sd)
+{
+    int     retval = -1;
+    cg_var *cv = NULL;
+    char   *query;
+
+    if (restconf_param_del_all(rc->rc_h) < 0)
+        goto done;
+    while ((cv = cvec_each(sd->sd_inhdrs, cv)) != NULL)
+        if (nghttp2_hdr2clixon(rc->rc_h, cv_name_get(cv), cv_string_get(cv)) < 0)
+            goto done;
+    if (sd->sd_inhdrs){
+        cvec_free(sd->sd_inhdrs);
+        sd->sd_inhdrs = NULL;
+    }
+    /* Query vector, ie the ?a=x&b=y stuff */
+    if ((query = restconf_param_get(rc->rc_h, "REQUEST_URI")) != NULL &&
+        (query = index(query, '?')) != NULL){
+        query++;
+        if (strlen(query) &&
+            uri_str2cvec(query, '&', '=', 1, &sd->sd_qvec) < 0)
+            goto done;
+    }
+    if (http2_exec(rc, sd, rc->rc_ngsession, sd->sd_stream_id) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Dispatch http/2 streams whose request is received, in order of arrival
+ *
+ * The response of each stream is sent as soon as it is executed, so that one stream does
+ * not wait for the others received in the same read.
+ * Streams stay ready while the output of the connection would block, and are resumed when
+ * it is written.
+ * @param[in] rc   Restconf connection
+ * @retval    1    OK
+ * @retval    0    Invalid session, close
+ * @retval   -1    Fatal error
+ */
+int
+http2_dispatch(restconf_conn *rc)
+{
+    restconf_stream_data *sd;
+    nghttp2_error         ngerr;
+
+    while (rc->rc_ready > 0 && !rc->rc_outq_paused){
+        if ((sd = rc->rc_streams) != NULL){
+            do {
+                if (sd->sd_ready)
+                    break;
+                sd = NEXTQ(restconf_stream_data *, sd);
+            } while (sd && sd != rc->rc_streams);
+        }
+        if (sd == NULL || !sd->sd_ready){ /* Shouldnt happen */
+            rc->rc_ready = 0;
+            break;
+        }
+        sd->sd_ready = 0;
+        rc->rc_ready--;
+        /* Stream may have been reset by client */
+        if (nghttp2_session_get_stream_user_data(rc->rc_ngsession, sd->sd_stream_id) == NULL)
+            continue;
+        if (http2_stream_exec(rc, sd) < 0)
+            return -1;
+        clixon_err_reset();
+        if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0){
+            if (clixon_err_category())
+                return -1;
+            return 0; /* Not fatal error */
+        }
+    }
+    return 1;
+}
+
 /*! Process an HTTP/2 request received in buffer, process request and send reply
  *
  * @param[in] rc   Restconf connection
@@ -955,6 +1077,7 @@ http2_recv(restconf_conn       *rc,
 {
     int           retval = -1;
     nghttp2_error ngerr;
+    int           ret;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
     if (rc->rc_ngsession == NULL){
@@ -991,6 +1114,11 @@ http2_recv(restconf_conn       *rc,
         else
             goto fail; /* Not fatal error */
     }
+    /* Execute requests of the received streams */
+    if ((ret = http2_dispatch(rc)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
     retval = 1; /* OK */
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
@@ -1011,6 +1139,7 @@ http2_send_server_connection(restconf_conn *rc)
     nghttp2_error          ngerr;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
+    iv[0].value = clicon_option_int(rc->rc_h, "CLICON_RESTCONF_HTTP2_MAX_STREAMS");
     if ((ngerr = nghttp2_submit_settings(rc->rc_ngsession,
                                          NGHTTP2_FLAG_NONE,
                                          iv,
@@ -215,6 +215,10 @@ api_root_restconf_exact(clixon_handle  h,
         if (clixon_json2cbuf(cb, xt, pretty, 0, 0, 0) < 0)
             goto done;
         break;
+    case YANG_DATA_CBOR:
+        if (clixon_cbor2cbuf(cb, xt, 0, 0) < 0)
+            goto done;
+        break;
     default:
         break;
     }
@@ -301,6 +305,10 @@ api_yang_library_version(clixon_handle h,
         if (clixon_json2cbuf(cb, xt, pretty, 0, 0, 0) < 0)
             goto done;
         break;
+    case YANG_DATA_CBOR:
+        if (clixon_cbor2cbuf(cb, xt, 0, 0) < 0)
+            goto done;
+        break;
     default:
         break;
     }
@@ -472,12 +480,15 @@ api_root_restconf(clixon_handle        h,
     int            pn;
     int            pretty;
     cbuf          *cb = NULL;
+    cbuf          *cbj = NULL;
     char          *media_list = NULL;
     restconf_media media_out = YANG_DATA_JSON;
     char          *indata = NULL;
     char          *username = NULL;
     int            ret;
     cxobj         *xerr = NULL;
+    int            traced = 0;
+    char           spanname[32];
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
     if (req == NULL){
@@ -487,6 +498,11 @@ api_root_restconf(clixon_handle        h,
     request_method = restconf_param_get(h, "REQUEST_METHOD");
     if ((path = restconf_uripath(h)) == NULL)
         goto done;
+    CLIXON_PROBE2(restconf__request__start, request_method, path);
+    /* Trace request, propagated to backend, continue trace of client if traceparent */
+    snprintf(spanname, sizeof(spanname), "restconf %s", request_method?request_method:"");
+    if ((traced = clixon_trace_start(h, restconf_param_get(h, "HTTP_TRACEPARENT"), spanname, path)) < 0)
+        goto done;
     pretty = restconf_pretty_get(h);
     /* Get media for output (proactive negotiation) RFC7231 by using
      * Accept:. This is for methods that have output, such as GET,
@@ -558,6 +574,21 @@ api_root_restconf(clixon_handle        h,
         goto done;
     if (ret == 0)
         goto ok;
+    /* YANG-CBOR input is translated to JSON text which the methods parse as JSON */
+    if (restconf_content_type(h) == YANG_DATA_CBOR && cbuf_len(cb)){
+        if ((cbj = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (clixon_cbor2json(cbuf_get(cb), cbuf_len(cb), cbj) < 0){
+            if (netconf_malformed_message_xml(&xerr, clixon_err_reason()) < 0)
+                goto done;
+            if (api_return_err0(h, req, xerr, pretty, media_out, 0) < 0)
+                goto done;
+            goto ok;
+        }
+        indata = cbuf_get(cbj);
+    }
     if (strcmp(api_resource, "yang-library-version")==0){
         if (api_yang_library_version(h, req, pretty, media_out) < 0)
             goto done;
@@ -627,6 +658,8 @@ api_root_restconf(clixon_handle        h,
     if (cb)
         cbuf_free(cb);
 #endif
+    if (cbj)
+        cbuf_free(cbj);
     if (xerr)
         xml_free(xerr);
     if (username)
@@ -635,7 +668,11 @@ api_root_restconf(clixon_handle        h,
         cvec_free(pcvec);
     if (pvec)
         free(pvec);
-    if (path)
+    if (traced > 0)
+        clixon_trace_stop(h, retval);
+    if (path){
+        CLIXON_PROBE3(restconf__request__done, request_method, path, retval);
         free(path);
+    }
     return retval;
 }
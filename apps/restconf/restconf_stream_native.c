@@ -85,6 +85,9 @@
 #include "restconf_native.h"    /* Restconf-openssl mode specific headers*/
 #include "restconf_stream.h"
 
+/* Max notifications already received from backend written as one SSE write / DATA frame */
+#define STREAM_NATIVE_BATCH_MAX 64
+
 #ifdef HAVE_LIBNGHTTP2
 #include "restconf_nghttp2.h"
 
@@ -120,6 +123,8 @@ restconf_http2_send_notification(clixon_handle         h,
 
 /*! Callback when stream notifications arrive from backend
  *
+ * Notifications that the backend wrote at once, see CLICON_STREAM_COALESCE_USEC, are sent
+ * as events of one SSE write or HTTP/2 DATA frame instead of one for each notification.
  * @param[in]  s    Socket
  * @param[in]  req  Generic Www handle (can be part of clixon handle)
  * @retval     0    OK
@@ -140,6 +145,7 @@ stream_native_backend_cb(int   s,
     cbuf                 *cbmsg = NULL;
     int                   pretty = 0;
     int                   ret;
+    int                   nr = 0;
     restconf_conn        *rc = sd->sd_conn;
     clixon_handle         h = rc->rc_h;
 #ifdef HAVE_LIBNGHTTP2
@@ -148,21 +154,6 @@ stream_native_backend_cb(int   s,
 
     clixon_debug(CLIXON_DBG_STREAM|CLIXON_DBG_DETAIL, "");
     pretty = restconf_pretty_get(h);
-    if (clixon_msg_rcv11(s, NULL, 0, &cbmsg, &eof) < 0)
-        goto done;
-    clixon_debug(CLIXON_DBG_STREAM, "%s", cbuf_get(cbmsg));
-    /* handle close from remote end: this will exit the client */
-    if (eof){
-        clixon_debug(CLIXON_DBG_STREAM, "eof");
-        restconf_close_ssl_socket(rc, __func__, 0);
-        goto ok;
-    }
-    if ((ret = clixon_xml_parse_string(cbuf_get(cbmsg), YB_NONE, NULL, &xtop, NULL)) < 0)
-        goto done;
-    if (ret == 0){
-        clixon_err(OE_XML, EFAULT, "Invalid notification");
-        goto done;
-    }
     /* create event */
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_PLUGIN, errno, "cbuf_new");
@@ -172,13 +163,36 @@ stream_native_backend_cb(int   s,
         clixon_err(OE_PLUGIN, errno, "cbuf_new");
         goto done;
     }
-    if ((xn = xpath_first(xtop, NULL, "notification")) == NULL)
+    do {
+        if (clixon_msg_rcv11_pipe(s, NULL, rc->rc_event_pipe, &cbmsg, &eof) < 0)
+            goto done;
+        /* handle close from remote end: this will exit the client */
+        if (eof){
+            clixon_debug(CLIXON_DBG_STREAM, "eof");
+            restconf_close_ssl_socket(rc, __func__, 0);
+            goto ok;
+        }
+        clixon_debug(CLIXON_DBG_STREAM, "%s", cbuf_get(cbmsg));
+        if ((ret = clixon_xml_parse_string(cbuf_get(cbmsg), YB_NONE, NULL, &xtop, NULL)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err(OE_XML, EFAULT, "Invalid notification");
+            goto done;
+        }
+        if ((xn = xpath_first(xtop, NULL, "notification")) != NULL){
+            cprintf(cb, "data: ");
+            if (clixon_xml2cbuf(cb, xn, 0, pretty, NULL, -1, 0) < 0)
+                goto done;
+            cprintf(cb, "\r\n");
+            cprintf(cb, "\r\n");
+        }
+        xml_free(xtop);
+        xtop = NULL;
+        cbuf_free(cbmsg);
+        cbmsg = NULL;
+    } while (++nr < STREAM_NATIVE_BATCH_MAX && clixon_msg_pipe_pending(rc->rc_event_pipe));
+    if (cbuf_len(cb) == 0)
         goto ok;
-    cprintf(cb, "data: ");
-    if (clixon_xml2cbuf(cb, xn, 0, pretty, NULL, -1, 0) < 0)
-        goto done;
-    cprintf(cb, "\r\n");
-    cprintf(cb, "\r\n");
 #ifdef HAVE_LIBNGHTTP2
     if (rc->rc_proto == HTTP_2){
         if (restconf_reply_send(sd, 200, cb, 0) < 0)
@@ -265,6 +279,10 @@ stream_close(clixon_handle h,
     clixon_event_unreg_timeout(stream_timeout_end, req);
     close(rc->rc_event_stream);
     rc->rc_event_stream = 0;
+    if (rc->rc_event_pipe){
+        clixon_msg_pipe_free(rc->rc_event_pipe);
+        rc->rc_event_pipe = NULL;
+    }
     return 0;
 }
 
@@ -290,13 +308,17 @@ stream_sockets_setup(clixon_handle h,
     restconf_stream_data *sd = (restconf_stream_data *)req;
     restconf_conn        *rc;
 
+    rc = sd->sd_conn;
+    /* Several notifications may be read at once */
+    if (rc->rc_event_pipe == NULL &&
+        (rc->rc_event_pipe = clixon_msg_pipe_new()) == NULL)
+        goto done;
     /* Listen to backend socket */
     if (clixon_event_reg_fd(besock,
                             stream_native_backend_cb,
                             req,
                             "stream socket") < 0)
         goto done;
-    rc = sd->sd_conn;
     rc->rc_event_stream = besock;
     /* Timeout of notification stream, close after limited lifetime, for debug */
     if (timeout){
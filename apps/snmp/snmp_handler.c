@@ -60,12 +60,50 @@
 #include "snmp_register.h"
 #include "snmp_handler.h"
 
+/*! Row of a cached table with key part of OID, ordered by OID
+ */
+struct snmp_getnext_row {
+    oid           *sr_oid;   /* Key part of OID */
+    size_t         sr_len;   /* Length of sr_oid */
+    cxobj         *sr_xrow;  /* XML list entry in sg_xml */
+};
+
+/*! Column of a cached table, ordered by OID
+ */
+struct snmp_getnext_col {
+    oid           *sc_oid;   /* Column OID */
+    size_t         sc_len;   /* Length of sc_oid */
+    yang_stmt     *sc_ycol;  /* YANG leaf of column */
+    int            sc_cursor; /* Row last returned for column, next getnext of a walk is after it */
+};
+
+/*! Cache of a table for getnext, with rows and columns in OID order
+ *
+ * One entry per table, found by XPath in the hash of the handle pointer "snmp-getnext-cache"
+ */
 struct snmp_getnext_cache {
-    cxobj         *sg_xml;
-    char          *sg_xpath;
-    struct timeval sg_timer;
+    qelem_t                  sg_q;     /* List of all tables, for freeing */
+    cxobj                   *sg_xml;   /* Table from backend */
+    char                    *sg_xpath; /* XPath of table, key of cache */
+    struct timeval           sg_timer; /* Time of backend get */
+    struct snmp_getnext_row *sg_rows;  /* Rows ordered by key OID */
+    int                      sg_nrows;
+    struct snmp_getnext_col *sg_cols;  /* Columns ordered by OID */
+    int                      sg_ncols;
+};
+
+/*! Tables cached for getnext, see table_getnext_cache
+ */
+struct snmp_getnext_tables {
+    clicon_hash_t             *st_hash; /* XPath -> struct snmp_getnext_cache* */
+    struct snmp_getnext_cache *st_list; /* All cached tables */
 };
 
+/* Transaction id of last committed SET PDU, see snmp_set_commit */
+static long _snmp_commit_transid = -1;
+
+static int table_getnext_cache_clear(clixon_handle h);
+
 /*! Common code for handling incoming SNMP request
  * 
  * Get clixon handle from snmp request, print debug data
@@ -413,6 +451,7 @@ snmp_scalar_set(clixon_handle               h,
     netsnmp_variable_list *requestvb = request->requestvb;
     int        asn1_type;
     enum operation_type op = OP_MERGE;
+    cxobj     *xbatch = NULL;
 
     clixon_debug(CLIXON_DBG_SNMP, "");
     if ((xtop = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
@@ -436,6 +475,13 @@ snmp_scalar_set(clixon_handle               h,
         if (xml_value_set(xb, valstr) < 0)
             goto done;
     }
+    /* Collect edits of a SET PDU, see snmp_set_batch_begin */
+    clicon_ptr_get(h, "snmp-set-batch", (void**)&xbatch);
+    if (xbatch){
+        if (xml_merge(xbatch, xtop, ys_spec(ys), NULL) < 0)
+            goto done;
+        goto ok;
+    }
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
@@ -456,6 +502,143 @@ snmp_scalar_set(clixon_handle               h,
     return retval;
 }
 
+/*! Start collecting edits of the varbinds of a SET into one edit-config
+ *
+ * Values set by snmp_scalar_set are merged into a tree instead of sent to the backend
+ * one by one, until snmp_set_batch_flush
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+snmp_set_batch_begin(clixon_handle h)
+{
+    cxobj *xbatch = NULL;
+
+    clicon_ptr_get(h, "snmp-set-batch", (void**)&xbatch);
+    if (xbatch == NULL){
+        if ((xbatch = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+            return -1;
+        clicon_ptr_set(h, "snmp-set-batch", xbatch);
+    }
+    return 0;
+}
+
+/*! Send collected edits to the backend in one edit-config
+ *
+ * Also called before a rowstatus row operation to keep the order of edits
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+snmp_set_batch_flush(clixon_handle h)
+{
+    int    retval = -1;
+    cxobj *xbatch = NULL;
+    cxobj *xc;
+    cbuf  *cb = NULL;
+
+    clicon_ptr_get(h, "snmp-set-batch", (void**)&xbatch);
+    if (xbatch == NULL || xml_child_nr_type(xbatch, CX_ELMNT) == 0)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, xbatch, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    while ((xc = xml_child_i_type(xbatch, 0, CX_ELMNT)) != NULL)
+        if (xml_purge(xc) < 0)
+            goto done;
+    if (clicon_rpc_edit_config(h, "candidate", OP_MERGE, cbuf_get(cb)) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Stop collecting edits and free collected edits not sent
+ */
+static void
+snmp_set_batch_end(clixon_handle h)
+{
+    cxobj *xbatch = NULL;
+
+    if (clicon_ptr_get(h, "snmp-set-batch", (void**)&xbatch) == 0 && xbatch){
+        xml_free(xbatch);
+        clicon_ptr_del(h, "snmp-set-batch");
+    }
+}
+
+/*! Send collected edits of a SET and validate candidate, discard if invalid
+ *
+ * There does not seem to be a separate validation action and commit does not
+ * return an error.
+ * Therefore validation is done in the action as well as discard if it fails.
+ * @param[in]  h        Clixon handle
+ * @param[in]  requests The netsnmp request info structures
+ * @retval     0        OK
+ * @retval    -1        Error or invalid, error set in first request
+ */
+static int
+snmp_set_validate(clixon_handle         h,
+                  netsnmp_request_info *requests)
+{
+    int ret;
+
+    if (snmp_set_batch_flush(h) < 0)
+        return -1;
+    if ((ret = clicon_rpc_validate(h, "candidate")) < 0)
+        return -1;
+    if (ret == 0){
+        clicon_rpc_discard_changes(h);
+        netsnmp_request_set_error(requests, SNMP_ERR_COMMITFAILED);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Commit candidate once per SET PDU
+ *
+ * The commit phase of a PDU calls the handler of each registration with varbinds in the
+ * PDU, only the first commits
+ * @param[in]  h        Clixon handle
+ * @param[in]  reqinfo  Agent transaction request structure
+ * @param[in]  requests The netsnmp request info structures
+ * @retval     0        OK
+ * @retval    -1        Error or commit failed, error set in first request
+ */
+static int
+snmp_set_commit(clixon_handle               h,
+                netsnmp_agent_request_info *reqinfo,
+                netsnmp_request_info       *requests)
+{
+    int ret;
+
+    if (reqinfo->asp && reqinfo->asp->pdu){
+        if (reqinfo->asp->pdu->transid == _snmp_commit_transid)
+            return 0;
+        _snmp_commit_transid = reqinfo->asp->pdu->transid;
+    }
+    if ((ret = clicon_rpc_commit(h, 0, 0, 0, NULL, NULL)) < 0)
+        return -1;
+    if (ret == 0){
+        /* Note that error given in commit is not propagated to the snmp client,
+         * therefore validation is in the ACTION instead
+         */
+        clicon_rpc_discard_changes(h);
+        netsnmp_request_set_error(requests, SNMP_ERR_COMMITFAILED);
+        return -1;
+    }
+    /* Tables may have changed */
+    table_getnext_cache_clear(h);
+    return 0;
+}
+
 /* Make cache row operation: move to backend, remove altogether
  *
  * Remove row from cache, then make merge or delete operation on backend.
@@ -494,6 +677,9 @@ snmp_cache_row_op(clixon_handle h,
         if (xml_rm(xrow) < 0)
             goto done;
         if (rpc){
+            /* Edits of earlier varbinds first */
+            if (snmp_set_batch_flush(h) < 0)
+                goto done;
             if ((xtop = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
                 goto done;
             if (snmp_yang2xml(xtop, yang_parent_get(yp), cvk, &xbot) < 0)
@@ -743,32 +929,12 @@ clixon_snmp_scalar_handler1(netsnmp_mib_handler          *handler,
     case MODE_SET_RESERVE2: /* 1 */
         break;
     case MODE_SET_ACTION:   /* 2 */
+        /* Collected, validated in clixon_snmp_scalar_handler */
         if (snmp_scalar_set(sh->sh_h, sh->sh_ys, NULL, NULL, reqinfo, request) < 0)
             goto done;
-        /*
-         * There does not seem to be a separate validation action and commit does not
-         * return an error.
-         * Therefore validation is done here directly as well as discard if it fails.
-         */
-        if ((ret = clicon_rpc_validate(sh->sh_h, "candidate")) < 0)
-            goto done;
-        if (ret == 0){
-            clicon_rpc_discard_changes(sh->sh_h);
-            netsnmp_request_set_error(request, SNMP_ERR_COMMITFAILED);
-            goto done;
-        }
         break;
     case MODE_SET_COMMIT:   /* 3 */
-        if ((ret = clicon_rpc_commit(sh->sh_h, 0, 0, 0, NULL, NULL)) < 0)
-            goto done;
-        if (ret == 0){
-            /* Note that error given in commit is not propagated to the snmp client,
-             * therefore validation is in the ACTION instead
-             */
-            clicon_rpc_discard_changes(sh->sh_h);
-            netsnmp_request_set_error(request, SNMP_ERR_COMMITFAILED);
-            goto done;
-        }
+        /* See snmp_set_commit in clixon_snmp_scalar_handler */
         break;
     case MODE_SET_FREE:     /* 4 */
         break;
@@ -802,9 +968,18 @@ clixon_snmp_scalar_handler(netsnmp_mib_handler          *handler,
 {
     int                   retval = -1;
     netsnmp_request_info *req;
+    clixon_snmp_handle   *sh;
     int                   ret;
 
     clixon_debug(CLIXON_DBG_SNMP, "");
+    if ((sh = (clixon_snmp_handle*)handler->myvoid) == NULL){
+        clixon_err(OE_XML, 0, "No myvoid handler");
+        goto done;
+    }
+    /* Values of all varbinds in one edit-config */
+    if (reqinfo->mode == MODE_SET_ACTION &&
+        snmp_set_batch_begin(sh->sh_h) < 0)
+        goto done;
     for (req = requests; req; req = req->next){
         ret = clixon_snmp_scalar_handler1(handler, nhreg, reqinfo, req);
         if (ret != SNMP_ERR_NOERROR){
@@ -813,8 +988,22 @@ clixon_snmp_scalar_handler(netsnmp_mib_handler          *handler,
             break;
         }
     }
+    switch (reqinfo->mode){
+    case MODE_SET_ACTION:
+        if (snmp_set_validate(sh->sh_h, requests) < 0)
+            goto done;
+        break;
+    case MODE_SET_COMMIT:
+        if (snmp_set_commit(sh->sh_h, reqinfo, requests) < 0)
+            goto done;
+        break;
+    default:
+        break;
+    }
     retval = SNMP_ERR_NOERROR;
  done:
+    if (sh && reqinfo->mode == MODE_SET_ACTION)
+        snmp_set_batch_end(sh->sh_h);
     return retval;
 }
 
@@ -1149,77 +1338,240 @@ snmp_table_set(clixon_handle               h,
     goto done;
 }
 
-/*! Use a cache for getnext tables instead of an RPC to the backend every time
+/*! Free rows, columns and XML of a cached table
+ */
+static void
+table_getnext_index_free(struct snmp_getnext_cache *sg)
+{
+    int i;
+
+    for (i=0; i<sg->sg_nrows; i++)
+        free(sg->sg_rows[i].sr_oid);
+    if (sg->sg_rows)
+        free(sg->sg_rows);
+    sg->sg_rows = NULL;
+    sg->sg_nrows = 0;
+    for (i=0; i<sg->sg_ncols; i++)
+        free(sg->sg_cols[i].sc_oid);
+    if (sg->sg_cols)
+        free(sg->sg_cols);
+    sg->sg_cols = NULL;
+    sg->sg_ncols = 0;
+    if (sg->sg_xml){
+        xml_free(sg->sg_xml);
+        sg->sg_xml = NULL;
+    }
+}
+
+/*! Order rows by key OID, qsort callback
+ */
+static int
+table_getnext_row_cmp(const void *a,
+                      const void *b)
+{
+    const struct snmp_getnext_row *ra = a;
+    const struct snmp_getnext_row *rb = b;
+
+    return oid_eq(ra->sr_oid, ra->sr_len, rb->sr_oid, rb->sr_len);
+}
+
+/*! Order columns by OID, qsort callback
+ */
+static int
+table_getnext_col_cmp(const void *a,
+                      const void *b)
+{
+    const struct snmp_getnext_col *ca = a;
+    const struct snmp_getnext_col *cb = b;
+
+    return oid_eq(ca->sc_oid, ca->sc_len, cb->sc_oid, cb->sc_len);
+}
+
+/*! Build OID ordered index of columns and rows of a table
  *
- * The cache works as follows:
- * It has three parts:
- * - xpath     Of the requested YANG
- * - xml tree  Saved from previous rpc to this xpath
- * - timestamp Time of last rpc call for this xpath
- * On a new call, the cache is used if:
- * - the cache exist, and
- * - the xpath is the same as the requested xpath, and
- * - the age of the cache entry is less than a threshold
+ * Rows without all keys are skipped
+ * @param[in]  sg     Cached table, sg_xml is set
+ * @param[in]  ylist  Yang of table (of list type)
+ * @param[in]  nsc    Namespace context
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+table_getnext_index(struct snmp_getnext_cache *sg,
+                    yang_stmt                 *ylist,
+                    cvec                      *nsc)
+{
+    int        retval = -1;
+    cxobj     *xtable;
+    cxobj     *xrow;
+    yang_stmt *ycol;
+    cvec      *cvk_name;
+    oid        oidc[MAX_OID_LEN] = {0,};
+    size_t     oidclen = MAX_OID_LEN;
+    oid        oidk[MAX_OID_LEN] = {0,};
+    size_t     oidklen = MAX_OID_LEN;
+    size_t     maxclen;
+    int        n;
+    int        i;
+    int        ret;
+
+    if ((cvk_name = yang_cvec_get(ylist)) == NULL){
+        clixon_err(OE_YANG, 0, "No keys");
+        goto done;
+    }
+    /* Columns: leafs of list with OID */
+    n = 0;
+    ycol = NULL;
+    while ((ycol = yn_each(ylist, ycol)) != NULL)
+        if (yang_keyword_get(ycol) == Y_LEAF)
+            n++;
+    if (n && (sg->sg_cols = calloc(n, sizeof(*sg->sg_cols))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    ycol = NULL;
+    while ((ycol = yn_each(ylist, ycol)) != NULL) {
+        if (yang_keyword_get(ycol) != Y_LEAF)
+            continue;
+        oidclen = MAX_OID_LEN;
+        if ((ret = yangext_oid_get(ycol, oidc, &oidclen, NULL)) < 0)
+            goto done;
+        if (ret == 0)
+            continue;
+        if ((sg->sg_cols[sg->sg_ncols].sc_oid = malloc(oidclen*sizeof(oid))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memcpy(sg->sg_cols[sg->sg_ncols].sc_oid, oidc, oidclen*sizeof(oid));
+        sg->sg_cols[sg->sg_ncols].sc_len = oidclen;
+        sg->sg_cols[sg->sg_ncols++].sc_ycol = ycol;
+    }
+    qsort(sg->sg_cols, sg->sg_ncols, sizeof(*sg->sg_cols), table_getnext_col_cmp);
+    maxclen = 0;
+    for (i=0; i<sg->sg_ncols; i++)
+        if (sg->sg_cols[i].sc_len > maxclen)
+            maxclen = sg->sg_cols[i].sc_len;
+    /* Rows: list entries with key OID */
+    if ((xtable = xpath_first(sg->sg_xml, nsc, "%s", sg->sg_xpath)) != NULL) {
+        if ((n = xml_child_nr_type(xtable, CX_ELMNT)) > 0 &&
+            (sg->sg_rows = calloc(n, sizeof(*sg->sg_rows))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        xrow = NULL;
+        while ((xrow = xml_child_each(xtable, xrow, CX_ELMNT)) != NULL) {
+            if (xml_spec(xrow) != ylist)
+                continue;
+            if ((ret = snmp_xmlkey2val_oid(xrow, cvk_name, NULL, oidk, &oidklen)) < 0)
+                goto done;
+            if (ret == 0)
+                continue; /* skip row, not all indexes */
+            if (maxclen + oidklen > MAX_OID_LEN)
+                continue; /* skip row, too long OID */
+            if ((sg->sg_rows[sg->sg_nrows].sr_oid = malloc((oidklen?oidklen:1)*sizeof(oid))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            memcpy(sg->sg_rows[sg->sg_nrows].sr_oid, oidk, oidklen*sizeof(oid));
+            sg->sg_rows[sg->sg_nrows].sr_len = oidklen;
+            sg->sg_rows[sg->sg_nrows++].sr_xrow = xrow;
+        }
+        qsort(sg->sg_rows, sg->sg_nrows, sizeof(*sg->sg_rows), table_getnext_row_cmp);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Use a per-table cache for getnext tables instead of an RPC to the backend every time
+ *
+ * Each table is cached with its XPath as key, and with an index of its columns and rows
+ * in OID order, see table_getnext_index.
+ * On a new call, the cached table is used if its age is less than CLICON_SNMP_CACHE_TTL,
+ * otherwise it is fetched from the backend and indexed again.
+ * A walk of a table, also interleaved with walks of other tables, thereby fetches each
+ * table once per TTL.
  * @param[in]  h      Clixon handle
- * @param[in]  xpath  XPath of requetsed YANG
+ * @param[in]  ylist  Yang of table (of list type)
+ * @param[in]  xpath  XPath of requested YANG
  * @param[in]  nsc    Namespace context
- * @param[out] xt     XML, either cached or new, dont free
+ * @param[out] sgp    Cached table, dont free
  * @retval     0      OK
  * @retval    -1      Error
  */
-#define GETNEXT_THRESHOLD_US 1000000
 static int
-table_getnext_cache(clixon_handle h,
-                    char         *xpath,
-                    cvec         *nsc,
-                    cxobj       **xtp)
+table_getnext_cache(clixon_handle               h,
+                    yang_stmt                  *ylist,
+                    char                       *xpath,
+                    cvec                       *nsc,
+                    struct snmp_getnext_cache **sgp)
 {
-    int                        retval = -1;
-    cxobj                     *xerr;
-    cxobj                     *xt = NULL;
-    int64_t                    tdiff_us = 0;
-    struct timeval             now;
-    struct timeval             td;
-    struct snmp_getnext_cache *sg = NULL;
+    int                          retval = -1;
+    cxobj                       *xerr;
+    cxobj                       *xt = NULL;
+    int64_t                      tdiff_us = 0;
+    uint32_t                     ttl_ms;
+    struct timeval               now;
+    struct timeval               td;
+    struct snmp_getnext_tables  *st = NULL;
+    struct snmp_getnext_cache   *sg = NULL;
+    struct snmp_getnext_cache  **sgv;
 
-    clicon_ptr_get(h, "snmp-getnext-cache", (void**)&sg);
-    if (sg == NULL){
+    clicon_ptr_get(h, "snmp-getnext-cache", (void**)&st);
+    if (st == NULL){
+        if ((st = calloc(1, sizeof(*st))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if ((st->st_hash = clicon_hash_init()) == NULL){
+            free(st);
+            goto done;
+        }
+        clicon_ptr_set(h, "snmp-getnext-cache", st);
+    }
+    if ((sgv = clicon_hash_value(st->st_hash, xpath, NULL)) != NULL)
+        sg = *sgv;
+    else {
         if ((sg = calloc(1, sizeof(*sg))) == NULL){
             clixon_err(OE_UNIX, errno, "calloc");
             goto done;
         }
-        clicon_ptr_set(h, "snmp-getnext-cache", sg);
+        if ((sg->sg_xpath = strdup(xpath)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            free(sg);
+            goto done;
+        }
+        if (clicon_hash_add(st->st_hash, xpath, &sg, sizeof(sg)) == NULL){
+            free(sg->sg_xpath);
+            free(sg);
+            goto done;
+        }
+        ADDQ(sg, st->st_list);
     }
+    ttl_ms = clicon_option_int(h, "CLICON_SNMP_CACHE_TTL");
     if (timerisset(&sg->sg_timer)){
         gettimeofday(&now, NULL);
         timersub(&now, &sg->sg_timer, &td);
         tdiff_us = 1000000*td.tv_sec + td.tv_usec;
     }
-    if (sg->sg_xml == NULL || sg->sg_xpath == NULL ||
-        strcmp(xpath, sg->sg_xpath) != 0 || tdiff_us > 1000000){ // gettime
-        if (sg->sg_xml){
-            xml_free(sg->sg_xml);
-            sg->sg_xml = NULL;
-        }
-        if (sg->sg_xpath){
-            free(sg->sg_xpath);
-            sg->sg_xpath = NULL;
-        }
+    if (sg->sg_xml == NULL || tdiff_us > (int64_t)ttl_ms*1000){
+        table_getnext_index_free(sg);
+        timerclear(&sg->sg_timer);
         if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, NULL, &xt) < 0)
             goto done;
         if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
             clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
             goto done;
         }
-        gettimeofday(&sg->sg_timer, NULL);
-        if ((sg->sg_xpath = strdup(xpath)) == NULL){
-            clixon_err(OE_UNIX, errno, "strdup");
-            goto done;
-        }
         sg->sg_xml = xt;
         xt = NULL;
+        if (table_getnext_index(sg, ylist, nsc) < 0){
+            table_getnext_index_free(sg);
+            goto done;
+        }
+        gettimeofday(&sg->sg_timer, NULL);
     }
-    *xtp = sg->sg_xml;
+    *sgp = sg;
     retval = 0;
  done:
     if (xt)
@@ -1227,10 +1579,74 @@ table_getnext_cache(clixon_handle h,
     return retval;
 }
 
+/*! Invalidate all cached tables, eg after a set
+ */
+static int
+table_getnext_cache_clear(clixon_handle h)
+{
+    struct snmp_getnext_tables *st = NULL;
+    struct snmp_getnext_cache  *sg;
+
+    if (clicon_ptr_get(h, "snmp-getnext-cache", (void**)&st) == 0 && st &&
+        (sg = st->st_list) != NULL){
+        do {
+            table_getnext_index_free(sg);
+            timerclear(&sg->sg_timer);
+            sg = NEXTQ(struct snmp_getnext_cache *, sg);
+        } while (sg && sg != st->st_list);
+    }
+    return 0;
+}
+
+/*! Get cached table of list for getnext
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  ylist  Yang of table (of list type)
+ * @param[out] sgp    Cached table, dont free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see table_getnext_cache
+ */
+static int
+table_getnext_cache_get(clixon_handle               h,
+                        yang_stmt                  *ylist,
+                        struct snmp_getnext_cache **sgp)
+{
+    int        retval = -1;
+    cvec      *nsc = NULL;
+    char      *xpath = NULL;
+    yang_stmt *ys;
+
+    if ((ys = yang_parent_get(ylist)) == NULL ||
+        yang_keyword_get(ys) != Y_CONTAINER){
+        clixon_err(OE_YANG, EINVAL, "ylist parent is not list");
+        goto done;
+    }
+    if (xml_nsctx_yang(ys, &nsc) < 0)
+        goto done;
+    if (snmp_yang2xpath(ys, NULL, &xpath) < 0)
+        goto done;
+    if (table_getnext_cache(h, ylist, xpath, nsc, sgp) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (xpath)
+        free(xpath);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+}
+
 /*! Find "next" object from oids minus key and return that.
  *
+ * Binary search in the OID ordered index of the cached table: OIDs of a table are ordered
+ * by column, then by row key. For each column in order, the first row whose OID is larger
+ * than the requested and which has a value of the column is the next object.
+ * Columns before the requested OID are skipped. A walk, eg the repetitions of a GETBULK,
+ * requests the successor of the previously returned OID of a column, which is the next
+ * row after the cursor of the column without searching.
  * @param[in]  h        Clixon handle
- * @param[in]  ylist    Yang of table (of list type)
+ * @param[in]  sg       Cached table
  * @param[in]  oids     OID of ultimate scalar value
  * @param[in]  oidslen  OID length of scalar
  * @param[in]  reqinfo  Agent transaction request structure
@@ -1238,88 +1654,77 @@ table_getnext_cache(clixon_handle h,
  * @retval     1        OK
  * @retval     0        Failed
  * @retval    -1        Error
- * XXX: merge with cache
  */
 static int
 snmp_table_getnext(clixon_handle               h,
-                   yang_stmt                  *ylist,
+                   struct snmp_getnext_cache  *sg,
                    oid                        *oids,
                    size_t                      oidslen,
                    netsnmp_agent_request_info *reqinfo,
                    netsnmp_request_info       *request)
 {
-    int        retval = -1;
-    cvec      *nsc = NULL;
-    char      *xpath = NULL;
-    cxobj     *xt = NULL;
-    cxobj     *xtable;
-    cxobj     *xrow;
-    cxobj     *xcol;
-    yang_stmt *ycol;
-    yang_stmt *ys;
-    int        ret;
-    cvec      *cvk_name;
-    oid        oidc[MAX_OID_LEN] = {0,}; /* Table / list oid */
-    size_t     oidclen = MAX_OID_LEN;
-    oid        oidk[MAX_OID_LEN] = {0,}; /* Key oid */
-    size_t     oidklen = MAX_OID_LEN;
-    oid        oidnext[MAX_OID_LEN] = {0x7fffffff,}; /* Next oid: start with high value */
-    size_t     oidnextlen = MAX_OID_LEN;
-    int        found = 0;
-    cxobj     *xnext = NULL;
-    yang_stmt *ynext = NULL;
-    cbuf      *cb = NULL;
+    int                        retval = -1;
+    struct snmp_getnext_col   *sc;
+    struct snmp_getnext_row   *sr;
+    oid                        oidnext[MAX_OID_LEN] = {0,}; /* Next oid */
+    size_t                     oidnextlen = 0;
+    int                        found = 0;
+    cxobj                     *xnext = NULL;
+    yang_stmt                 *ynext = NULL;
+    cbuf                      *cb = NULL;
+    int                        c;
+    int                        lo;
+    int                        hi;
+    int                        mid;
 
     clixon_debug(CLIXON_DBG_SNMP, "");
-    if ((ys = yang_parent_get(ylist)) == NULL ||
-        yang_keyword_get(ys) != Y_CONTAINER){
-        clixon_err(OE_YANG, EINVAL, "ylist parent is not list");
-        goto done;
-    }
-    if (xml_nsctx_yang(ys, &nsc) < 0)
-        goto done;
-    if (snmp_yang2xpath(ys, NULL, &xpath) < 0)
-        goto done;
-    /* Get next via cache */
-    if (table_getnext_cache(h, xpath, nsc, &xt) < 0)
-        goto done;
-    if ((xtable = xpath_first(xt, nsc, "%s", xpath)) != NULL) {
-        /* Make a clone of key-list, but replace names with values */
-        if ((cvk_name = yang_cvec_get(ylist)) == NULL){
-            clixon_err(OE_YANG, 0, "No keys");
-            goto done;
-        }
-        xrow = NULL;
-        while ((xrow = xml_child_each(xtable, xrow, CX_ELMNT)) != NULL) {
-            /* Get key part of OID from XML list entry */
-            if ((ret = snmp_xmlkey2val_oid(xrow, cvk_name, NULL, /*&cvk_oid,*/ oidk, &oidklen)) < 0)
+    for (c = 0; c < sg->sg_ncols && !found; c++){
+        sc = &sg->sg_cols[c];
+        /* All OIDs of column are before requested */
+        if (oid_eq(sc->sc_oid, sc->sc_len, oids, oidslen < sc->sc_len ? oidslen : sc->sc_len) < 0)
+            continue;
+        lo = -1;
+        /* Successor of previously returned row of column */
+        if (sc->sc_cursor < sg->sg_nrows){
+            sr = &sg->sg_rows[sc->sc_cursor];
+            memcpy(oidnext, sc->sc_oid, sc->sc_len*sizeof(*oidnext));
+            oidnextlen = sc->sc_len;
+            if (oid_append(oidnext, &oidnextlen, sr->sr_oid, sr->sr_len) < 0)
                 goto done;
-            if (ret == 0)
-                continue; /* skip row, not all indexes */
-            xcol = NULL;
-            while ((xcol = xml_child_each(xrow, xcol, CX_ELMNT)) != NULL) {
-                if ((ycol = xml_spec(xcol)) == NULL)
-                    continue;
-                if (yang_keyword_get(ycol) != Y_LEAF)
-                    continue;
-                if ((ret = yangext_oid_get(ycol, oidc, &oidclen, NULL)) < 0)
-                    goto done;
-                if (ret == 0)
-                    continue;
-                /* Append key oid */
-                if (oid_append(oidc, &oidclen, oidk, oidklen) < 0)
+            if (oid_eq(oidnext, oidnextlen, oids, oidslen) == 0)
+                lo = sc->sc_cursor + 1;
+        }
+        if (lo < 0){
+            /* First row with column + key oid larger than requested */
+            lo = 0;
+            hi = sg->sg_nrows;
+            while (lo < hi){
+                mid = (lo + hi)/2;
+                sr = &sg->sg_rows[mid];
+                memcpy(oidnext, sc->sc_oid, sc->sc_len*sizeof(*oidnext));
+                oidnextlen = sc->sc_len;
+                if (oid_append(oidnext, &oidnextlen, sr->sr_oid, sr->sr_len) < 0)
                     goto done;
-                /* Get smallest larger */
-                if (oid_eq(oidc, oidclen, oids, oidslen) > 0 &&
-                    oid_eq(oidc, oidclen, oidnext, oidnextlen) < 0){
-                    memcpy(oidnext, oidc, oidclen*sizeof(*oidnext));
-                    oidnextlen = oidclen;
-                    xnext = xcol;
-                    ynext = ycol;
-                    found++;
-                }
-            } /* while xcol */
-        } /* while xrow */
+                if (oid_eq(oidnext, oidnextlen, oids, oidslen) > 0)
+                    hi = mid;
+                else
+                    lo = mid + 1;
+            }
+        }
+        /* Skip rows without value of column */
+        for (; lo < sg->sg_nrows; lo++){
+            sr = &sg->sg_rows[lo];
+            if ((xnext = xml_find_type(sr->sr_xrow, NULL, yang_argument_get(sc->sc_ycol), CX_ELMNT)) == NULL)
+                continue;
+            memcpy(oidnext, sc->sc_oid, sc->sc_len*sizeof(*oidnext));
+            oidnextlen = sc->sc_len;
+            if (oid_append(oidnext, &oidnextlen, sr->sr_oid, sr->sr_len) < 0)
+                goto done;
+            ynext = sc->sc_ycol;
+            sc->sc_cursor = lo;
+            found++;
+            break;
+        }
     }
     if (found){
         if (snmp_scalar_return(xnext, ynext, oidnext, oidnextlen, reqinfo, request) < 0)
@@ -1333,12 +1738,8 @@ snmp_table_getnext(clixon_handle               h,
     }
     retval = found;
  done:
-    if (xpath)
-        free(xpath);
     if (cb)
         cbuf_free(cb);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
 }
 
@@ -1348,6 +1749,7 @@ snmp_table_getnext(clixon_handle               h,
  * @param[in]  nhreg   Root registration info.
  * @param[in]  reqinfo Agent transaction request structure
  * @param[in]  request The netsnmp request info structure.
+ * @param[in]  sg      Cached table for getnext, or NULL
  * @retval     0       OK
  * @retval    -1       Error
  */
@@ -1355,7 +1757,8 @@ static int
 clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
                            netsnmp_handler_registration *nhreg,
                            netsnmp_agent_request_info   *reqinfo,
-                           netsnmp_request_info         *request)
+                           netsnmp_request_info         *request,
+                           struct snmp_getnext_cache    *sg)
 {
     int                     retval = -1;
     clixon_snmp_handle     *sh = NULL;
@@ -1393,7 +1796,10 @@ clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
         break;
     case MODE_GETNEXT: // 161
         /* Register table sub-oid:s of existing entries in clixon */
-        if ((ret = snmp_table_getnext(sh->sh_h, sh->sh_ys,
+        if (sg == NULL &&
+            table_getnext_cache_get(sh->sh_h, sh->sh_ys, &sg) < 0)
+            goto done;
+        if ((ret = snmp_table_getnext(sh->sh_h, sg,
                                       requestvb->name, requestvb->name_length,
                                       reqinfo, request)) < 0)
             goto done;
@@ -1427,27 +1833,10 @@ clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
             }
             clixon_debug(CLIXON_DBG_SNMP, "Nosuchinstance");
         }
-        /*
-         * There does not seem to be a separate validation action and commit does not 
-         * return an error.
-         * Therefore validation is done here directly as well as discard if it fails.
-         */
-        if ((ret = clicon_rpc_validate(sh->sh_h, "candidate")) < 0)
-            goto done;
-        if (ret == 0){
-            clicon_rpc_discard_changes(sh->sh_h);
-            netsnmp_request_set_error(request, SNMP_ERR_COMMITFAILED);
-            goto done;
-        }
+        /* Validated in clixon_snmp_table_handler */
         break;
     case MODE_SET_COMMIT:   // 3
-        if ((ret = clicon_rpc_commit(sh->sh_h, 0, 0, 0, NULL, NULL)) < 0)
-            goto done;
-        if (ret == 0){
-            clicon_rpc_discard_changes(sh->sh_h);
-            netsnmp_request_set_error(request, SNMP_ERR_COMMITFAILED);
-            goto done;
-        }
+        /* See snmp_set_commit in clixon_snmp_table_handler */
         break;
     case MODE_SET_FREE:     // 4
         break;
@@ -1484,21 +1873,56 @@ clixon_snmp_table_handler(netsnmp_mib_handler          *handler,
                           netsnmp_agent_request_info   *reqinfo,
                           netsnmp_request_info         *requests)
 {
-    int                   retval = -1;
-    netsnmp_request_info *req;
-    int                   ret;
+    int                        retval = -1;
+    netsnmp_request_info      *req;
+    clixon_snmp_handle        *sh;
+    struct snmp_getnext_cache *sg = NULL;
+    int                        ret;
 
     clixon_debug(CLIXON_DBG_SNMP, "");
+    if ((sh = (clixon_snmp_handle*)handler->myvoid) == NULL){
+        clixon_err(OE_XML, 0, "No myvoid handler");
+        goto done;
+    }
+    switch (reqinfo->mode){
+    case MODE_GETNEXT:
+        /* Getnext of all varbinds of the table, eg a GETBULK repetition, use one cached table */
+        if (sh->sh_ys != NULL &&
+            table_getnext_cache_get(sh->sh_h, sh->sh_ys, &sg) < 0)
+            goto done;
+        break;
+    case MODE_SET_ACTION:
+        /* Values of all varbinds in one edit-config */
+        if (snmp_set_batch_begin(sh->sh_h) < 0)
+            goto done;
+        break;
+    default:
+        break;
+    }
     for (req = requests; req; req = req->next){
-        ret = clixon_snmp_table_handler1(handler, nhreg, reqinfo, req);
+        ret = clixon_snmp_table_handler1(handler, nhreg, reqinfo, req, sg);
         if (ret != SNMP_ERR_NOERROR){
             retval = ret;
             goto done;
             break;
         }
     }
+    switch (reqinfo->mode){
+    case MODE_SET_ACTION:
+        if (snmp_set_validate(sh->sh_h, requests) < 0)
+            goto done;
+        break;
+    case MODE_SET_COMMIT:
+        if (snmp_set_commit(sh->sh_h, reqinfo, requests) < 0)
+            goto done;
+        break;
+    default:
+        break;
+    }
     retval = SNMP_ERR_NOERROR;
  done:
+    if (sh && reqinfo->mode == MODE_SET_ACTION)
+        snmp_set_batch_end(sh->sh_h);
     return retval;
 }
 
@@ -1507,14 +1931,21 @@ clixon_snmp_table_handler(netsnmp_mib_handler          *handler,
 int
 clixon_snmp_table_exit(clixon_handle h)
 {
-    struct snmp_getnext_cache *sg = NULL;
+    struct snmp_getnext_tables *st = NULL;
+    struct snmp_getnext_cache  *sg;
 
-    if (clicon_ptr_get(h, "snmp-getnext-cache", (void**)&sg) == 0 && sg){
-        if (sg->sg_xml)
-            xml_free(sg->sg_xml);
-        if (sg->sg_xpath)
+    if (clicon_ptr_get(h, "snmp-getnext-cache", (void**)&st) == 0 && st){
+        while ((sg = st->st_list) != NULL){
+            DELQ(sg, st->st_list, struct snmp_getnext_cache *);
+            table_getnext_index_free(sg);
             free(sg->sg_xpath);
-        free(sg);
+            free(sg);
+        }
+        if (st->st_hash)
+            clicon_hash_free(st->st_hash);
+        free(st);
     }
     return 0;
+}
+    return 0;
 }
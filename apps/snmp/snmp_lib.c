@@ -94,6 +94,18 @@ static const map_str2int snmp_access_map[] = {
     {NULL,                   -1}
 };
 
+/*! Parsed SMIv2 oid extension of a YANG node, see yangext_oid_get
+ */
+struct snmp_oid_cache {
+    int     so_exist; /* YANG node has OID */
+    oid    *so_oid;   /* Parsed OID */
+    size_t  so_len;   /* Length of so_oid */
+    char   *so_str;   /* OID string of extension, not malloced */
+};
+
+/* Parsed OIDs of YANG nodes: yang pointer -> struct snmp_oid_cache */
+static clicon_hash_t *_oid_cache = NULL;
+
 /* Map between clixon and ASN.1 types. 
  * @see net-snmp/library/asn1.h
  * @see union netsnmp_vardata in net-snmp/types.h
@@ -445,21 +457,15 @@ yang_extension_value_opt(yang_stmt *ys,
     return retval;
 }
 
-/*! Given a YANG node, return SMIv2 oid extension as OID 
+/*! Parse SMIv2 oid extension of a YANG node
  *
- * @param[in]  yn        Yang node
- * @param[out] objid     OID vector, assume allocated with MAX_OID_LEN > oidlen
- * @param[out] objidlen  Length of OID vector on return
- * @param[out] objidstrp Pointer to string (direct not malloced) optional
- * @retval     1         OK
- * @retval     0         Invalid, not found
- * @retval    -1         Error
+ * @see yangext_oid_get  Cached
  */
-int
-yangext_oid_get(yang_stmt *yn,
-                oid       *objid,
-                size_t    *objidlen,
-                char     **objidstrp)
+static int
+yangext_oid_parse(yang_stmt *yn,
+                  oid       *objid,
+                  size_t    *objidlen,
+                  char     **objidstrp)
 {
     int        retval = -1;
     int        exist = 0;
@@ -493,6 +499,96 @@ yangext_oid_get(yang_stmt *yn,
     goto done;
 }
 
+/*! Given a YANG node, return SMIv2 oid extension as OID 
+ *
+ * @param[in]  yn        Yang node
+ * @param[out] objid     OID vector, assume allocated with MAX_OID_LEN > oidlen
+ * @param[out] objidlen  Length of OID vector on return
+ * @param[out] objidstrp Pointer to string (direct not malloced) optional
+ * @retval     1         OK
+ * @retval     0         Invalid, not found
+ * @retval    -1         Error
+ */
+int
+yangext_oid_get(yang_stmt *yn,
+                oid       *objid,
+                size_t    *objidlen,
+                char     **objidstrp)
+{
+    int                    retval = -1;
+    struct snmp_oid_cache  so = {0,};
+    struct snmp_oid_cache *sop;
+    char                   key[32];
+    char                  *oidstr = NULL;
+    int                    ret;
+
+    snprintf(key, sizeof(key), "%p", yn);
+    if (_oid_cache == NULL &&
+        (_oid_cache = clicon_hash_init()) == NULL)
+        goto done;
+    if ((sop = clicon_hash_value(_oid_cache, key, NULL)) == NULL){
+        /* Parse once and keep result also if no OID */
+        if ((ret = yangext_oid_parse(yn, objid, objidlen, &oidstr)) < 0)
+            goto done;
+        if ((so.so_exist = ret) == 1){
+            if ((so.so_oid = malloc(*objidlen*sizeof(oid))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            memcpy(so.so_oid, objid, *objidlen*sizeof(oid));
+            so.so_len = *objidlen;
+            so.so_str = oidstr;
+        }
+        if ((sop = clicon_hash_add(_oid_cache, key, &so, sizeof(so))) == NULL){
+            if (so.so_oid)
+                free(so.so_oid);
+            goto done;
+        }
+    }
+    if (sop->so_exist == 0)
+        goto fail;
+    if (sop->so_len > *objidlen){
+        clixon_err(OE_SNMP, 0, "OID length %zu larger than %zu", sop->so_len, *objidlen);
+        goto done;
+    }
+    memcpy(objid, sop->so_oid, sop->so_len*sizeof(oid));
+    *objidlen = sop->so_len;
+    if (objidstrp)
+        *objidstrp = sop->so_str;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Free cache of parsed OIDs of YANG nodes
+ *
+ * @see yangext_oid_get
+ */
+int
+yangext_oid_cache_exit(void)
+{
+    char                 **keys = NULL;
+    size_t                 nkeys = 0;
+    struct snmp_oid_cache *sop;
+    size_t                 i;
+
+    if (_oid_cache == NULL)
+        return 0;
+    if (clicon_hash_keys(_oid_cache, &keys, &nkeys) == 0){
+        for (i=0; i<nkeys; i++)
+            if ((sop = clicon_hash_value(_oid_cache, keys[i], NULL)) != NULL && sop->so_oid)
+                free(sop->so_oid);
+    }
+    if (keys)
+        free(keys);
+    clicon_hash_free(_oid_cache);
+    _oid_cache = NULL;
+    return 0;
+}
+
 /*! Given a YANG node, return 1 if leaf has oid directive in it, otherwise 0
  *
  * @param[in]  yn        Yang node
@@ -122,6 +122,7 @@ snmp_terminate(clixon_handle h)
         x = NULL;
     }
     clixon_snmp_table_exit(h);
+    yangext_oid_cache_exit();
     clicon_rpc_close_session(h);
     yang_exit(h);
     if ((nsctx = clicon_nsctx_global_get(h)) != NULL)
@@ -49,6 +49,8 @@
   *  -U  general-purpose upgrade
   *  -t  enable transaction logging (call syslog for every transaction)
   *  -V <xpath> Failing validate and commit if <xpath> is present (synthetic error)
+  *  -C <xpath> Failing commit if <xpath> is present, every time (synthetic error)
+  *  -P <ms> Commit is pending and done after <ms> (requires CLICON_BACKEND_COMMIT_ASYNC)
  * Note example_backend uses -v
  */
 #include <stdio.h>
@@ -73,7 +75,7 @@
 #include <clixon/clixon_backend.h>
 
 /* Command line options to be passed to getopt(3) */
-#define BACKEND_EXAMPLE_OPTS "a:m:M:n:o:O:rsS:x:iuUtV:"
+#define BACKEND_EXAMPLE_OPTS "a:m:M:n:o:O:p:rsS:x:iT:uUtV:C:P:"
 
 /* Enabling this improves performance in tests, but there may trigger the "double XPath"
  * problem.
@@ -157,6 +159,19 @@ static char *_state_xpath = NULL;
  */
 static int _state_file_cached = 0;
 
+/*! Time in milliseconds state data is cached by the backend, see ca_statedata_ttl
+ *
+ * Start backend with -- -sS <file> -T <ms>
+ */
+static int _state_ttl = 0;
+
+/*! State data path, the state callback is only called for gets of this subtree
+ *
+ * See ca_statedata_paths
+ * Start backend with -- -sS <file> -p <schema-nodeid>
+ */
+static char *_state_paths[2] = {NULL, NULL};
+
 /*! Cache control of read state file pagination example,
  *
  * keep xml tree cache as long as db is locked
@@ -200,6 +215,25 @@ static char *_validate_fail_xpath = NULL;
  */
 static int   _validate_fail_toggle = 0; /* fail at validate and commit */
 
+/*! Variable to trigger commit errors (synthetic errors) for tests
+ *
+ * If the XPath matches the target, commit fails, also if the commit is pending.
+ * Start backend with -- -C <xpath>
+ */
+static char *_commit_fail_xpath = NULL;
+
+/*! Variable to make commit pending and done later by a timer, for asynchronous commit tests
+ *
+ * Start backend with -- -P <ms>
+ * @see transaction_pending
+ */
+static int   _commit_pending_ms = 0;
+
+/*! Transaction and id of pending commit, see _commit_pending_ms
+ */
+static transaction_data _commit_pending_td = NULL;
+static int              _commit_pending_id = 0;
+
 /* forward */
 static int example_stream_timer_setup(clixon_handle h, int sec);
 static int main_system_only_commit(clixon_handle h, transaction_data td);
@@ -241,6 +275,32 @@ main_complete(clixon_handle    h,
     return 0;
 }
 
+/*! Timer callback: pending commit is done, fails if -C <xpath> matches
+ *
+ * @param[in]  fd   No-op
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+main_commit_pending_timer(int   fd,
+                          void *arg)
+{
+    clixon_handle    h = (clixon_handle)arg;
+    transaction_data td = _commit_pending_td;
+    int              status = 0;
+
+    if (td == NULL)
+        return 0;
+    _commit_pending_td = NULL;
+    if (_commit_fail_xpath &&
+        xpath_first(transaction_target(td), NULL, "%s", _commit_fail_xpath)){
+        clixon_err(OE_XML, 0, "User commit error");
+        status = -1;
+    }
+    return transaction_pending_done(h, td, _commit_pending_id, status);
+}
+
 /*! This is called on commit. Identify modifications and adjust machine state
  *
  * Somewhat complex due to the different test-cases
@@ -259,6 +319,8 @@ main_commit(clixon_handle    h,
     int     i;
     size_t  len;
     cvec   *nsc = NULL;
+    int     id;
+    struct timeval t;
 
     if (_transaction_log)
         transaction_log(h, td, LOG_NOTICE, __func__);
@@ -275,6 +337,29 @@ main_commit(clixon_handle    h,
             goto done; /* simulate fail */
         }
     }
+    if (_commit_pending_ms > 0 && _commit_pending_td == NULL){
+        if ((id = transaction_pending(td)) < 0)
+            goto done;
+        if (id > 0){ /* Done and checked later in main_commit_pending_timer */
+            gettimeofday(&t, NULL);
+            t.tv_sec += _commit_pending_ms/1000;
+            t.tv_usec += (_commit_pending_ms%1000)*1000;
+            if (t.tv_usec >= 1000000){
+                t.tv_sec++;
+                t.tv_usec -= 1000000;
+            }
+            if (clixon_event_reg_timeout(t, main_commit_pending_timer, h, "example pending commit") < 0)
+                goto done;
+            _commit_pending_td = td;
+            _commit_pending_id = id;
+            goto ok;
+        }
+    }
+    if (_commit_fail_xpath &&
+        xpath_first(transaction_target(td), NULL, "%s", _commit_fail_xpath)){
+        clixon_err(OE_XML, 0, "User commit error");
+        goto done; /* simulate fail */
+    }
 
     /* Create namespace context for xpath */
     if ((nsc = xml_nsctx_init(NULL, "urn:ietf:params:xml:ns:yang:ietf-interfaces")) == NULL)
@@ -550,6 +635,22 @@ example_statedata(clixon_handle h,
                                     NULL, &xstate, NULL) < 0)
             goto done; /* For the case when urn:example:clixon is not loaded */
     }
+    /* Keyed lists in reverse key order, not sorted until searched in test_state_lazy_sort.sh */
+    if (yang_find_module_by_namespace(yspec, "urn:example:lazy") != NULL){
+        cbuf_reset(cb);
+        cprintf(cb, "<table xmlns=\"urn:example:lazy\">");
+        cprintf(cb, "<parameter><name>c</name><counter>3</counter></parameter>");
+        cprintf(cb, "<parameter><name>b</name><counter>2</counter></parameter>");
+        cprintf(cb, "<parameter><name>a</name><counter>1</counter></parameter>");
+        cprintf(cb, "</table>");
+        cprintf(cb, "<stats xmlns=\"urn:example:lazy\">");
+        cprintf(cb, "<entry><id>30</id><count>300</count></entry>");
+        cprintf(cb, "<entry><id>9</id><count>90</count></entry>");
+        cprintf(cb, "<entry><id>20</id><count>200</count></entry>");
+        cprintf(cb, "</stats>");
+        if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xstate, NULL) < 0)
+            goto done;
+    }
     /* Event state from RFC8040 Appendix B.3.1
      * Note: (1) order is by-system so is different,
      *       (2) event-count is XOR on name, so is not 42 and 4
@@ -1637,6 +1738,12 @@ clixon_plugin_init(clixon_handle h)
         case 'x': /* state xpath (requires -sS) */
             _state_xpath = optarg;
             break;
+        case 'p': /* state data path (requires -s) */
+            _state_paths[0] = optarg;
+            break;
+        case 'T': /* state cache ttl in ms (requires -s) */
+            _state_ttl = atoi(optarg);
+            break;
         case 'i': /* read state file on init not by request (requires -sS <file> */
             _state_file_cached = 1;
             break;
@@ -1652,11 +1759,20 @@ clixon_plugin_init(clixon_handle h)
         case 'V': /* validate fail */
             _validate_fail_xpath = optarg;
             break;
+        case 'C': /* commit fail */
+            _commit_fail_xpath = optarg;
+            break;
+        case 'P': /* pending commit in ms */
+            _commit_pending_ms = atoi(optarg);
+            break;
         }
     if ((_mount_yang && !_mount_namespace) || (!_mount_yang && _mount_namespace)){
         clixon_err(OE_PLUGIN, EINVAL, "Both -m and -M must be given for mounts");
         goto done;
     }
+    api.ca_statedata_ttl = _state_ttl;
+    if (_state_paths[0])
+        api.ca_statedata_paths = _state_paths;
     if (_state_file){
         api.ca_statedata = example_statefile; /* Switch state data callback */
         if (_state_xpath){
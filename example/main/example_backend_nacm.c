@@ -39,6 +39,7 @@
  * - transaction test
  *  -t  enable transaction logging (call syslog for every transaction)
  *  -v <xpath> Failing validate and commit if <xpath> is present (synthetic error)
+ *  -e  reload external NACM file after each commit
  * Note example_backend uses -V
  */
 #include <stdio.h>
@@ -60,7 +61,7 @@
 #include <clixon/clixon_backend.h>
 
 /* Command line options to be passed to getopt(3) */
-#define BACKEND_NACM_OPTS "tv:"
+#define BACKEND_NACM_OPTS "tv:e"
 
 /*! Variable to control transaction logging (for debug)
  *
@@ -84,6 +85,13 @@ static char *_validate_fail_xpath = NULL;
  */
 static int   _validate_fail_toggle = 0; /* fail at validate and commit */
 
+/*! Variable to reload external NACM file after each commit
+ *
+ * This is to make tests where the external NACM rules change while the backend runs.
+ * Start backend with -- -e
+ */
+static int _nacm_ext_reload = 0;
+
 int
 nacm_begin(clixon_handle    h,
            transaction_data td)
@@ -151,8 +159,15 @@ int
 nacm_commit_done(clixon_handle    h,
                  transaction_data td)
 {
+    char *mode;
+
     if (_transaction_log)
         transaction_log(h, td, LOG_NOTICE, __func__);
+    if (_nacm_ext_reload &&
+        (mode = clicon_option_str(h, "CLICON_NACM_MODE")) != NULL &&
+        strcmp(mode, "external") == 0 &&
+        nacm_load_external(h) < 0)
+        return -1;
     return 0;
 }
 
@@ -264,6 +279,9 @@ clixon_plugin_init(clixon_handle h)
         case 'v': /* validate fail */
             _validate_fail_xpath = optarg;
             break;
+        case 'e': /* reload external NACM file */
+            _nacm_ext_reload = 1;
+            break;
         }
 
     nacm_mode = clicon_option_str(h, "CLICON_NACM_MODE");
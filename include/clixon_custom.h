@@ -55,11 +55,229 @@
  *
  * This also applies if there are multiple keys and you want to search on only the second for
  * example.
- * There may be some cases where the index vector is not updated, need to verify before
- * enabling this completely.
+ * Indexes are declared with the clixon-config search_index extension or the
+ * CLICON_YANG_SEARCH_INDEX option.
+ * Search vectors are maintained when list elements or index variables are added, removed,
+ * copied or changed. With debug datastore and detail, vectors are verified after each edit,
+ * see xml_search_index_verify()
  */
 #define XML_EXPLICIT_INDEX
 
+/*! Hash index of list entries keyed on list key values, and of leaf-list entries on value
+ *
+ * A parent with many list children gets a hash index on first key lookup, which is maintained
+ * when children are inserted and removed. Equality lookups of list and leaf-list entries, such
+ * as in edits, in clixon_xml_find_index() and in XPath y[.='x'], use the hash instead of
+ * binary search.
+ * Sorted child order is kept for iteration and for the position of inserts.
+ * Threshold is XML_LIST_HASH_MIN in clixon_xml.c
+ */
+#define XML_LIST_HASH
+
+/*! Store children of elements with very many children in fixed-size chunks
+ *
+ * Inserting or removing a child in the middle of a large flat child vector moves all
+ * children after it. With chunks, only the children of one chunk are moved.
+ * Access is via the same API, eg xml_child_i() and xml_child_each(), and xml_childvec_get()
+ * converts back to a flat vector.
+ * Threshold is XML_CHUNK_THRESHOLD in clixon_xml.c
+ */
+#define XML_CHILD_CHUNKS
+
+/*! Cache ranges of children with the same yang spec in parents with many children
+ *
+ * Children of a sorted parent are grouped by yang order. A parent with many children caches
+ * the start and end of each group on first search, maintained on insert and remove, so
+ * that a search for a list inside a container with many sibling lists is limited to
+ * the children of that list, see xml_child_group().
+ * Threshold is XML_YANG_GROUPS_MIN in clixon_xml.c
+ */
+#define XML_YANG_GROUPS
+
+/*! Label children in order to find the position of a child without scanning all siblings
+ *
+ * Each child has an order label, increasing along the child vector with gaps in between.
+ * An inserted child gets a label between its neighbours, and children are labeled anew only
+ * when there is no free label. xml_child_order() then uses binary search, which speeds up
+ * insert="before/after" in ordered-by user lists with many entries.
+ * The 32-bit label is placed in alignment padding and does not increase the size of nodes.
+ */
+#define XML_CHILD_ORDER
+
+/*! Cache parsed XPath expressions
+ *
+ * XPath strings evaluated by xpath_vec_ctx(), and thereby xpath_vec(), xpath_first(), etc,
+ * are parsed once and kept in a LRU cache keyed by the XPath string. The parse tree does
+ * not depend on the namespace context.
+ * Also, the XPath argument of must and when statements is parsed once when the YANG is
+ * populated and kept in the statement, see yang_xpath_get().
+ * Size is XPATH_PARSE_CACHE_SIZE in clixon_xpath.c
+ */
+#define XPATH_PARSE_CACHE
+
+/*! Compile parsed XPath expressions for boolean evaluation, eg of must and when
+ *
+ * A subset of XPath: paths with child, parent and self steps and predicates, operators,
+ * literals and some functions, is compiled into code where location paths are vectors of
+ * steps and node-sets are kept in buffers that are reused between evaluations.
+ * Other expressions are evaluated by the interpreter xp_eval().
+ */
+#define XPATH_COMPILE
+
+/*! Reuse XPath node-set vectors from a free pool instead of allocating them per step
+ *
+ * Steps append to a growing vector, predicates filter node-sets in place, and vectors of
+ * freed contexts are put back into a small pool, see ctx_nodeset_append() in clixon_xpath_ctx.c
+ */
+#define XPATH_NODESET_POOL
+
+/*! Cache translations of RESTCONF api-paths to XPath
+ *
+ * api_path2xpath() translates an api-path template, ie the api-path without key values,
+ * once per yang spec and keeps the XPath and namespace context in a LRU cache. Key values
+ * of following api-paths with the same template are decoded and inserted into the XPath.
+ * Api-paths via mount-points are not cached.
+ * Size is API_PATH_CACHE_SIZE in clixon_path.c
+ */
+#define API_PATH_CACHE
+
+/*! Identity derivation checks use a bitset of base identities per identity
+ *
+ * Each identity gets an index and a bitset of the indexes of all its base identities on
+ * first use, eg by derived-from() in XPath, instead of searching the derived list of the
+ * base identity, see yang_identity_derived()
+ * Identityref values are looked up in a sorted vector of the derived list of the base
+ * identity, made on first use, see yang_identity_derived_find()
+ */
+#define YANG_IDENTITY_BITSET
+
+/*! Enumeration types have lookup tables of their enums by name and by value
+ *
+ * Made when the type cache is populated, see ys_resolve_type(). Used for enum validation
+ * and enum/value translations instead of searching the enum statements
+ * See yang_enum_find() and yang_enum_find_value()
+ */
+#define YANG_ENUM_TABLE
+
+/*! Datastore caches only contain explicit data, default values are added on read
+ *
+ * Default leaves and non-presence containers are not added to cached datastore trees,
+ * which only contain explicit data. Trees returned by xmldb_get0() and xmldb_get_take()
+ * get defaults of the matching subtrees, and global defaults of the xpath from the
+ * yang-derived global defaults tree, see xml_global_defaults().
+ * Zero-copy get-config is only used with with-defaults explicit and trim.
+ * Limitations: XPath predicates in datastore reads, eg /l[x=0], do not match default
+ * values in list entries, and delete of a default leaf gives data-missing.
+ */
+#undef XMLDB_DEFAULTS_VIRTUAL
+
+/*! Mandatory and min-elements validation use schema summaries made when YANG is loaded
+ *
+ * Each YANG node has a list of its children that may be mandatory, and whether it is
+ * statically mandatory or an empty instance may violate min-elements of a list below it.
+ * check_mandatory() only checks the listed children instead of all children, see
+ * yang_mandatory_each(). Increases memory of each YANG node with one pointer.
+ */
+#define YANG_SCHEMA_SUMMARY
+
+/*! Validate leaf values with a validator compiled once per resolved type
+ *
+ * The validator is attached to the type cache and holds sorted range and length
+ * intervals, compiled patterns and sorted enumeration names. Union members are compiled
+ * likewise and members that cannot match, eg integers and a value starting with a letter,
+ * are rejected without parsing. Values not accepted by the validator are validated again
+ * by the generic code, which also gives the reason, see ys_cv_validate()
+ */
+#define YANG_TYPE_VALIDATOR
+
+/*! Validate must and when expressions only if nodes they depend on are changed
+ *
+ * Dependencies of must and when expressions are computed when YANG is loaded, see
+ * clixon_xpath_deps.c. Commit of candidate skips expressions whose dependencies are not
+ * among the changed nodes of the transaction, since running was valid.
+ * Likewise, mandatory, min/max-elements and unique are only checked on changed nodes and
+ * parents of deleted nodes, and leafrefs of unchanged nodes only if a node on their path
+ * changed. Explicit validate and startup validate the whole tree.
+ * Requires XPATH_PARSE_CACHE
+ */
+#define VALIDATE_INCREMENTAL
+
+/*! Reverse leafref index of running for incremental validation
+ *
+ * Maps referred nodes to the leafrefs in running referring to them, see
+ * clixon_validate_leafref.c. The index is built on first commit and updated with the diff
+ * of every commit. Commit then only checks leafrefs of unchanged nodes that refer to deleted
+ * or changed nodes, instead of all leafrefs with a dependency on the changed nodes.
+ * Requires VALIDATE_INCREMENTAL
+ */
+#define LEAFREF_INDEX
+
+/*! Cache compiled regular expressions of XPath re-match()
+ *
+ * Compiled regexps are kept in a LRU cache keyed by regexp engine and XSD regexp string,
+ * instead of being compiled on every call. YANG patterns are compiled once in the type cache.
+ * Size is REGEX_CACHE_SIZE in clixon_regex.c
+ */
+#define REGEX_CACHE
+
+/*! Match simple XPaths while printing get-config replies
+ *
+ * Absolute paths of child steps with name tests and [name='value'] predicates, eg key
+ * predicates, are matched while walking and printing the datastore cache, without a node
+ * vector or marks, see xpath_stream2cbuf(). Other XPaths are evaluated as before.
+ * Requires BACKEND_GET_ZEROCOPY to have effect in the backend
+ */
+#define XPATH_STREAM
+
+/*! Defer sorting of state data from plugin callbacks until first keyed access
+ *
+ * Trees from state callbacks are marked with xml_sort_lazy() instead of sorted, and a node is
+ * sorted by xml_sort_ensure() on keyed search or insert, diff, duplicate detection or
+ * serialization. A callback producing data in key order can call xml_sorted_declare()
+ * on its tree to skip sorting entirely.
+ * If not set, xml_sort_lazy() sorts directly.
+ */
+#define XML_SORT_LAZY
+
+/*! Sort children using a sort key computed once per child
+ *
+ * xml_sort, eg from xml_sort_recurse at startup, looks up yang order, ordered-by and the
+ * key values of each child once, and sorts on them with a specialized comparator, instead of
+ * going through xml_cmp with its yang lookups in every comparison.
+ * Only for nodes with at least XML_SORT_DECORATE_MIN children, see clixon_xml_sort.c
+ */
+#define XML_SORT_DECORATE
+
+/*! Bulk insert of many new list entries in one edit
+ *
+ * If an edit-config adds many new entries of an ordered-by system list to the same parent,
+ * the new entries are appended unsorted and then sorted once and merged with the existing
+ * entries, instead of a binary search and insert per entry.
+ * Threshold is XMLDB_BULK_MIN in clixon_datastore_write.c
+ */
+#define XMLDB_BULK_INSERT
+
+/*! Merge-join of sorted children in xml_merge
+ *
+ * If both the base and the modification tree have children in strict sorted order, eg
+ * ordered-by system config or state merged by netconf_trymerge, matching children are found
+ * by walking both children vectors in step instead of a binary search per child. New children
+ * are moved in one pass and merged into place with xml_sort_merge, instead of one xml_rm and
+ * one xml_insert per child.
+ * Thresholds are XML_MERGE_JOIN_MIN and XML_MERGE_JOIN_RATIO in clixon_xml_map.c
+ */
+#define XML_MERGE_JOIN
+
+/*! Mark edits of a datastore since its last commit and restrict commit diff to marked nodes
+ *
+ * xmldb_put marks changed nodes and their ancestors with XML_FLAG_EDIT. If the candidate
+ * is marked relative to the current running, the commit diff only descends into marked
+ * subtrees of the candidate, instead of comparing the whole trees.
+ * Not with CLICON_XMLDB_SYSTEM_ONLY_CONFIG or CLICON_NACM_DISABLED_ON_EMPTY, which modify the
+ * datastore copies, see xmldb_edit_marked
+ */
+#define XMLDB_EDIT_MARK
+
 /*! Let state data be ordered-by system
  *
  * RFC 7950 is cryptic about this
@@ -87,6 +305,18 @@
  */
 #define HTTP_DATA_INTERNAL_REDIRECT "index.html"
 
+/*! Cache contents of small http-data files in restconf
+ *
+ * Number of files cached per restconf process, most recently used are kept.
+ * Files are validated against their inode, size and modification time on each request.
+ * Larger files are sent with restconf_reply_send_file. Undefine to disable
+ */
+#define HTTP_DATA_CACHE_NR 64
+
+/*! Max size of a cached http-data file, see HTTP_DATA_CACHE_NR
+ */
+#define HTTP_DATA_CACHE_FILE_MAX (64*1024)
+
 /*! Set a temporary parent for use in special case "when" xpath calls
  *
  * Problem is when changing an existing (candidate) in-memory datastore that yang "when" conditionals
@@ -109,6 +339,24 @@
  */
 #undef LIST_PAGINATION_REMAINING
 
+/*! Number of cached sort orders of list pagination with the sort-by parameter
+ *
+ * List pagination of config lists reads entries directly from the sorted datastore cache.
+ * With sort-by, the order of the entries is made once and kept until the datastore is
+ * modified, so that paging through a large list does not sort it for each page.
+ * If not set, sort-by pagination makes a copy of the list and sorts it.
+ * Requires BACKEND_GET_ZEROCOPY
+ */
+#define LIST_PAGINATION_SORT_CACHE 8
+
+/*! Number of list entries requested per call of a state list producer
+ *
+ * A get of a list with a producer, see clixon_statelist_cb_register, holds at most this many
+ * entries as XML at a time. Entries of each batch are filtered and printed to the reply, which
+ * is sent in NETCONF chunks with BACKEND_GET_STREAM_CHUNK.
+ */
+#define STATELIST_BATCH 1024
+
 /*! If backend is restarted, clients will retry (once) and reconnect
  *
  * But only if the socket is cached, ie was created in the prior message,
@@ -244,30 +492,186 @@
  */
 #define STARTUP_COMMIT_REORDER
 
-/*! Optimize validation of leafrefs by doing an XPath cache and binary search
+/*! Optimize validation of leafrefs by doing an XPath cache and hash set lookup
  *
  * 1) First a cache is used for XPath lookup
- * If a path is ../, ../../ etc, keep a cache of previous results
- * If the same, yang/xpath is used, see if the xml object have a common parent,
- * for ../ one level up, for ../../ two levels up, etc
- * If they match, re-use the result of the previous call.
- * This avoids costly XPath lookups if the number of results is large
+ * During one validation pass, the target node-set of a leafref path is cached per
+ * leafref YANG node. A path beginning with N "../" only depends on the Nth ancestor
+ * (anchor) of the leafref node, and an absolute path on the top of the tree.
+ * If another leafref node of the same YANG has the same anchor, the node-set is
+ * re-used. This avoids costly XPath lookups if the number of results is large.
+ * Leafref nodes with the same absolute path in the same module share the node-set.
+ * Several leafrefs of the same list entry each have their own cache entry.
  * Caveats:
- * 1.1) There is only one cache.
- *      Two leafref placed after each other invalidates the cache
- * 1.2) This assumes that an XPath beginning ../ does not change result
- * if ../ is removed. One could probably construct an XPath that does not
- * behave like this.
+ * 1.1) Paths with current() or deref() are not cached
  * This is in validation code only, not generic XPath
  *
- * 2) Second, binary instead of linear search is done for results
- * If a result of an XPath lookup contain elements that are part of the same
- * LEAFLIST or LIST AND that list is ordered-by-system, then one can
- * use binary search on that list instead of linear.
- * LEAFREF_OPT_CACHE must be enabled
- * Caveat: to find out whether all elements are one list a relatively costly
- * loop is made once per yang, this could possibly change and the loop could
- * be improved.
-
+ * 2) Second, a hash set lookup instead of linear search is done for results
+ * If the node-set is large, its values are put in a hash set once.
  */
 #define LEAFREF_OPTIMIZE
+
+/*! Allocate XML nodes from slabs instead of individual malloc/free calls
+ *
+ * Element and body/attribute nodes (struct xml and struct xmlbody) are carved out of
+ * large slabs, and freed nodes are recycled via a free-list.
+ * This reduces allocator time when parsing, copying and freeing large trees, such as when
+ * reading a large datastore at startup or at discard-changes.
+ * Slabs are never returned to the OS until all nodes are freed, see xml_slab_release().
+ * Disabled by default since leaked nodes are not detected by valgrind memory checks.
+ */
+#undef XML_SLAB_ALLOC
+
+/*! Count allocations of XML tree operations per call site category
+ *
+ * XML nodes, node copies, serializer cbufs, namespace contexts and XPath contexts are counted,
+ * and the backend records the counts of each RPC. Shown in the stats RPC and logged per RPC with
+ * debug subject profile. Used to measure the effect of allocator work such as XML_SLAB_ALLOC
+ * and XML_NAME_INTERN. Disabled by default since it adds a counter to each allocation
+ * @see clixon_alloc_profile.c
+ */
+#undef ALLOC_PROFILE
+
+/*! Intern XML element and attribute names and prefixes in a global table
+ *
+ * Instead of strdup:ing each name, nodes share a single copy per distinct string. In a
+ * YANG-bound tree most names come from a small set of schema identifiers, which reduces memory
+ * and enables pointer comparison of names, see xml_name_eq().
+ * Table size and name length are bounded by XML_INTERN_MAX and XML_INTERN_LEN in clixon_xml.c
+ */
+#define XML_NAME_INTERN
+
+/*! Parse and cache list key and leaf-list values as cligen variables at bind time
+ *
+ * xml_bind_yang populates the cached value (xml_cv) of list keys and leaf-list entries once,
+ * and the cache is kept across sorts. The cache is invalidated when the body changes.
+ * Thereby xml_sort and binary search compare native values without re-parsing the body
+ * strings, at the cost of one cligen variable per key.
+ */
+#define XML_BIND_CV_CACHE
+
+/*! Transient commit flags of XML nodes are valid only in the current flag epoch
+ *
+ * The flags in XML_FLAG_EPOCH_MASK, eg XML_FLAG_ADD and XML_FLAG_CHANGE, are stamped with the
+ * epoch when set. Resetting them in all trees is then O(1) by advancing the epoch with
+ * xml_flag_epoch_next(), instead of traversing the trees. This is done when a transaction
+ * on the datastore caches is freed, see transaction_free1.
+ */
+#define XML_FLAG_EPOCH
+
+/*! Serve get-config of config data directly from the datastore cache
+ *
+ * Matching nodes of the xpath are marked in the cache and the reply is printed from the
+ * cache with an output filter, instead of making a filtered copy of the cache.
+ * NACM read access is checked by the output filter, see nacm_read_filter(), unless NACM
+ * permits the user to read all data, see nacm_datanode_read_permitted().
+ * Not with CLICON_XMLDB_SYSTEM_ONLY_CONFIG or CLICON_NACM_DISABLED_ON_EMPTY, which need a
+ * copy to modify.
+ */
+#define BACKEND_GET_ZEROCOPY
+
+/*! Send large get-config replies to the client in NETCONF chunks while printing
+ *
+ * The reply is printed directly from the datastore cache (see BACKEND_GET_ZEROCOPY) into a
+ * buffer, which is sent as a NETCONF 1.1 chunk each time it reaches this size in bytes.
+ * Thereby the backend does not hold the whole reply as a string.
+ * If an error occurs after a chunk is sent, the client session is closed.
+ * Requires BACKEND_GET_ZEROCOPY
+ */
+#define BACKEND_GET_STREAM_CHUNK 65536
+
+/*! Cache serialized get-config replies of config data for repeated identical requests
+ *
+ * Number of replies kept, least recently used are removed first.
+ * A reply is identified by datastore, xpath, depth, with-defaults and NACM user, and is
+ * valid until the content generation of the datastore or the NACM generation changes, see
+ * xmldb_generation and nacm_generation.
+ * Replies sent in chunks (see BACKEND_GET_STREAM_CHUNK) and binary replies are not cached.
+ * Requires BACKEND_GET_ZEROCOPY
+ */
+#define BACKEND_GET_REPLY_CACHE 16
+
+/*! Decide NACM read access per YANG node instead of per XML node where possible
+ *
+ * The read verdict of a YANG node for a user is permit, deny or no match if it is decided
+ * by module rules, or check if a data-node rule with a path may apply. Verdicts of a node
+ * and of all its schema descendants are computed once per user and NACM configuration.
+ * Reply nodes whose verdict is decided are marked without matching the rules, and their
+ * subtrees are not visited if no descendant may change the outcome.
+ */
+#define NACM_READ_SCHEMA
+
+/*! Decide NACM write access per YANG node instead of per XML node where possible
+ *
+ * As NACM_READ_SCHEMA for create, update and delete: verdicts of YANG nodes are cached per
+ * user and access, and nodes of an edit whose verdict is decided are checked without
+ * matching the rules. The subtree of a node is not visited if all its schema descendants
+ * are permitted, and rule paths are looked up in the request only if some node needs them.
+ * Thereby many list entries of a bulk edit are checked without per-entry rule matching.
+ */
+#define NACM_WRITE_SCHEMA
+
+/*! Share argument strings of YANG statements read from YANG cache files between processes
+ *
+ * A cache file read with CLICON_YANG_CACHE_DIR is kept mapped until exit, and argument
+ * strings of the statements read from it, and of their grouping and augment copies, point
+ * into the mapping instead of being copied. The mapped pages are shared by all processes
+ * reading the same cache file, such as the backend and each CLI and NETCONF client.
+ * The rest of the YANG statement tree is built in each process.
+ * Requires CLICON_YANG_CACHE_DIR to have effect
+ */
+#define YANG_CACHE_SHARED
+
+/*! Look up data nodes by name in a sorted index of YANG nodes with at least this many
+ *
+ * The index of a YANG node holds the data nodes yang_find_datanode() searches: children and
+ * data nodes under choice, case, input and output, and of included submodules. It is made
+ * with the schema summary after grouping expansion and augments, and is not made if two
+ * data nodes have the same name. yang_find_datanode() and yang_find() of a data node then
+ * make a binary search instead of a linear scan of the children.
+ * Requires YANG_SCHEMA_SUMMARY
+ */
+#define YANG_DATANODE_INDEX 8
+
+/*! Registry of mounted YANG specs for schema mount
+ *
+ * Mounted yspecs are registered on the top-level yang mounts node by canonical
+ * mount-point xpath, and by a digest of their yang-library. Resolving the yspec of a
+ * mount-point is then a hash lookup instead of a scan of all yspecs and their mount-points,
+ * and a new mount-point with the same yang-library as an existing one shares its yspec
+ * without getting the yang-library of all other mount-points.
+ */
+#define YANG_SCHEMA_MOUNT_CACHE
+
+/*! Use epoll or kqueue in the poll event handler
+ *
+ * If CLICON_EVENT_SELECT is false, file events are registered persistently with epoll (Linux)
+ * or kqueue (BSD) instead of building a pollfd array of all file events on each event loop,
+ * and only ready file descriptors are visited. Prioritized file events are served first.
+ * Only used if configure finds sys/epoll.h or sys/event.h
+ */
+#define EVENT_EPOLL
+
+/*! Append runs of received NETCONF data to the message in bulk
+ *
+ * Chunk-data of known chunk-size, and EOM-framed data up to the next possible end marker,
+ * is appended to the message buffer in one call instead of per character through the
+ * framing state machine. Chunk headers and end markers are still parsed per character,
+ * and may be split across reads.
+ */
+#define NETCONF_INPUT_BULK
+
+/*! Size in bytes of read buffers of NETCONF input from sockets and stdin
+ *
+ * Used by the backend, the netconf client and the internal client library. Large
+ * messages, such as edit-configs, are read in fewer calls than with BUFSIZ (usually 8K)
+ */
+#define NETCONF_INPUT_BUFSIZ 65536
+
+/*! Size in bytes of each of the two ring buffers of a shared memory transport
+ *
+ * Messages larger than a ring are written in parts as the peer reads.
+ * Must be a power of two.
+ * @see CLICON_IPC_SHM
+ */
+#define IPC_SHM_RING_SIZE (1024*1024)
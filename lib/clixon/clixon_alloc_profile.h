@@ -0,0 +1,70 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+ * Allocation profiler of XML tree operations, build mode ALLOC_PROFILE in clixon_custom.h
+ */
+#ifndef _CLIXON_ALLOC_PROFILE_H
+#define _CLIXON_ALLOC_PROFILE_H
+
+/*
+ * Types
+ */
+/*! Allocation call site categories
+ */
+enum alloc_site{
+    ALLOC_XML_NEW,       /* XML nodes created by xml_new, including copies */
+    ALLOC_XML_COPY,      /* XML nodes copied by xml_copy_one */
+    ALLOC_CBUF,          /* Temporary cbufs in JSON and text serializers */
+    ALLOC_NSCTX,         /* Namespace context cvecs */
+    ALLOC_XPATH,         /* XPath contexts and node-set vectors */
+    ALLOC_SITE_NR
+};
+
+/*
+ * Macros
+ */
+#ifdef ALLOC_PROFILE
+#define ALLOC_PROFILE_COUNT(site) alloc_profile_count(site)
+#else
+#define ALLOC_PROFILE_COUNT(site) do {} while (0)
+#endif
+
+/*
+ * Prototypes
+ */
+void alloc_profile_count(enum alloc_site site);
+void alloc_profile_begin(void);
+int  alloc_profile_end(const char *op);
+int  alloc_profile_print(cbuf *cb);
+int  alloc_profile_exit(void);
+
+#endif  /* _CLIXON_ALLOC_PROFILE_H */
@@ -82,6 +82,8 @@ int   clixon_client_get_uint8(clixon_client_handle ch, uint8_t *rval, const char
 int   clixon_client_get_uint16(clixon_client_handle ch, uint16_t *rval, const char *xnamespace, const char *xpath);
 int   clixon_client_get_uint32(clixon_client_handle ch, uint32_t *rval, const char *xnamespace, const char *xpath);
 int   clixon_client_get_uint64(clixon_client_handle ch, uint64_t *rval, const char *xnamespace, const char *xpath);
+int   clixon_client_get_multi(clixon_client_handle ch, char **rvals, int n, const char *xnamespace, const char **xpaths);
+int   clixon_client_cache(clixon_client_handle ch, int enable);
 
 /* Access functions */
 int   clixon_client_socket_get(clixon_client_handle ch);
@@ -41,6 +41,13 @@
 /*
  * Types
  */
+/* Published read-only copy of a datastore that is replaced while held, see xmldb_rdonly_hold
+ */
+struct xmldb_retired {
+    cxobj         *xr_xml;      /* Read-only tree */
+    int            xr_refs;     /* Number of holders */
+};
+
 /* Struct per database in hash
  * Semantics of de_modified is to implement this from RFC 6241 Sec 7.5:
  *       The target configuration is <candidate>, it has already been
@@ -58,6 +65,17 @@ struct db_elmnt {
     int            de_volatile; /* Disable auto-sync of cache to disk on every update (ie xmldb_put)
                                  * Objects are marked with XML_FLAG_CACHE_DIRTY that are not written
                                  */
+    uint64_t       de_gen;      /* Content generation: two caches with same non-zero generation
+                                 * have equal content. Reset on modification, see xmldb_copy
+                                 */
+    cxobj         *de_rdonly;   /* Published read-only copy of cache, see xmldb_rdonly_get */
+    uint64_t       de_rdonly_gen; /* Content generation of de_rdonly */
+    int            de_rdonly_refs; /* Holders of de_rdonly, eg reader threads */
+    struct xmldb_retired *de_retired; /* Replaced read-only copies still held */
+    int            de_nretired; /* Length of de_retired */
+    uint64_t       de_edit_gen; /* If set, content is equal to generation de_edit_gen except in
+                                 * nodes marked with XML_FLAG_EDIT, see xmldb_put
+                                 */
 };
 typedef struct db_elmnt db_elmnt;
 
@@ -67,8 +85,10 @@ typedef struct db_elmnt db_elmnt;
 
 db_elmnt *clicon_db_elmnt_get(clixon_handle h, const char *db);
 int clicon_db_elmnt_set(clixon_handle h, const char *db, db_elmnt *xc);
+int xmldb_multi_mode(clixon_handle h);
 int xmldb_db2file(clixon_handle h, const char *db, char **filename);
 int xmldb_db2subdir(clixon_handle h, const char *db, char **dir);
+int xmldb_db2journal(clixon_handle h, const char *db, char **filename);
 
 /* API */
 int xmldb_connect(clixon_handle h);
@@ -78,14 +98,28 @@ int xmldb_get(clixon_handle h, const char *db, cvec *nsc, char *xpath, cxobj **x
 int xmldb_get0(clixon_handle h, const char *db, yang_bind yb,
                cvec *nsc, const char *xpath, int copy, withdefaults_type wdef,
                cxobj **xret, modstate_diff_t *msd, cxobj **xerr);
+int xmldb_get_depth(clixon_handle h, const char *db, yang_bind yb,
+                    cvec *nsc, const char *xpath, int32_t depth, withdefaults_type wdef,
+                    cxobj **xret, modstate_diff_t *msd, cxobj **xerr);
 int xmldb_get_cache(clixon_handle h, const char *db, yang_bind yb,
                     cxobj **xtp, modstate_diff_t *msdiff, cxobj **xerr);
+int xmldb_get_take(clixon_handle h, const char *db, yang_bind yb,
+                   cxobj **xtp, modstate_diff_t *msdiff, cxobj **xerr);
 /* in clixon_datastore_write.[ch]: */
 int xmldb_put(clixon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret);
 int xmldb_dump(clixon_handle h, FILE *f, cxobj *xt, enum format_enum format, int pretty, withdefaults_type wdef, int multi, const char *multidb);
 int xmldb_write_cache2file(clixon_handle h, const char *db);
+int xmldb_write_cache2file1(clixon_handle h, const char *db, int incremental);
 
 int xmldb_copy(clixon_handle h, const char *from, const char *to);
+int xmldb_move(clixon_handle h, const char *from, const char *to);
+uint64_t xmldb_generation(clixon_handle h, const char *db);
+int xmldb_rdonly_publish(clixon_handle h, const char *db);
+int xmldb_rdonly_get(clixon_handle h, const char *db, cxobj **xtp);
+int xmldb_rdonly_hold(clixon_handle h, const char *db, cxobj **xtp);
+int xmldb_rdonly_release(clixon_handle h, const char *db, cxobj *xt);
+int xmldb_rdonly_held(clixon_handle h, const char *db);
+int xmldb_edit_marked(clixon_handle h, const char *db, const char *base);
 int xmldb_lock(clixon_handle h, const char *db, uint32_t id);
 int xmldb_unlock(clixon_handle h, const char *db);
 int xmldb_unlock_all(clixon_handle h, uint32_t id);
@@ -78,6 +78,7 @@
 #define CLIXON_DBG_RPC		0x00008000	/* RPC handling */
 #define CLIXON_DBG_STREAM	0x00010000	/* Notification streams */
 #define CLIXON_DBG_PARSE	0x00020000	/* Parser: XML,YANG, etc */
+#define CLIXON_DBG_PROFILE	0x00040000	/* Profiling: XPath evaluation */
 
 /* External applications */
 #define CLIXON_DBG_APP		0x00100000	/* External application */
@@ -92,13 +93,15 @@
 
 /*
  * Macros
+ * The debug mask is checked inline so that arguments are not evaluated when debug is not set
  */
 #if defined(__GNUC__)
 #define clixon_debug(l, _fmt, args...) \
 	do { \
 		_Pragma("GCC diagnostic push") \
 		_Pragma("GCC diagnostic ignored \"-Wformat-zero-length\"") \
-		clixon_debug_fn(NULL, __func__, __LINE__, (l), NULL, _fmt, ##args); \
+		if (clixon_debug_isset(l)) \
+			clixon_debug_fn(NULL, __func__, __LINE__, (l), NULL, _fmt, ##args); \
 		_Pragma("GCC diagnostic pop") \
 	} while (0)
 
@@ -106,7 +109,8 @@
 	do { \
 		_Pragma("GCC diagnostic push") \
 		_Pragma("GCC diagnostic ignored \"-Wformat-zero-length\"") \
-		clixon_debug_fn(NULL, __func__, __LINE__, (l), (x), _fmt, ##args); \
+		if (clixon_debug_isset(l)) \
+			clixon_debug_fn(NULL, __func__, __LINE__, (l), (x), _fmt, ##args); \
 		_Pragma("GCC diagnostic pop") \
 	} while (0)
 
@@ -115,7 +119,8 @@
 	do { \
 		_Pragma("clang diagnostic push") \
 		_Pragma("clangGCC diagnostic ignored \"-Wformat-zero-length\"") \
-		clixon_debug_fn(NULL, __func__, __LINE__, (l), NULL, _fmt, ##args); \
+		if (clixon_debug_isset(l)) \
+			clixon_debug_fn(NULL, __func__, __LINE__, (l), NULL, _fmt, ##args); \
 		_Pragma("clangGCC diagnostic pop") \
 	} while (0)
 
@@ -123,17 +128,29 @@
 	do { \
 		_Pragma("clangGCC diagnostic push") \
 		_Pragma("clangGCC diagnostic ignored \"-Wformat-zero-length\"") \
-		clixon_debug_fn(NULL, __func__, __LINE__, (l), (x), _fmt, ##args); \
+		if (clixon_debug_isset(l)) \
+			clixon_debug_fn(NULL, __func__, __LINE__, (l), (x), _fmt, ##args); \
 		_Pragma("clangGCC diagnostic pop") \
 	} while (0)
 
 #else
 #define clixon_debug(l, _fmt, args...) \
-		clixon_debug_fn(NULL, __func__, __LINE__, (l), NULL, _fmt, ##args)
+	do { \
+		if (clixon_debug_isset(l)) \
+			clixon_debug_fn(NULL, __func__, __LINE__, (l), NULL, _fmt, ##args); \
+	} while (0)
 #define clixon_debug_xml(l, x, _fmt, args...) \
-		clixon_debug_fn(NULL, __func__, __LINE__, (l), (x), _fmt, ##args)
+	do { \
+		if (clixon_debug_isset(l)) \
+			clixon_debug_fn(NULL, __func__, __LINE__, (l), (x), _fmt, ##args); \
+	} while (0)
 #endif
 
+/*
+ * Variables
+ */
+extern int _clixon_debug_level; /* Use clixon_debug_get() */
+
 /*
  * Prototypes
  */
@@ -147,7 +164,7 @@ int clixon_debug_fn(clixon_handle h, const char *fn, const int line, int dbgleve
 /* Is subject set ? */
 static inline int clixon_debug_isset(unsigned n)
 {
-    unsigned level = clixon_debug_get();
+    unsigned level = _clixon_debug_level;
     unsigned detail = (n & CLIXON_DBG_DMASK) >> CLIXON_DBG_DSHIFT;
     unsigned subject = (n & CLIXON_DBG_SMASK);
 
@@ -160,7 +177,7 @@ static inline int clixon_debug_isset(unsigned n)
 /* Is detail set ?, return detail level 0-7 */
 static inline int clixon_debug_detail(void)
 {
-    unsigned level = clixon_debug_get();
+    unsigned level = _clixon_debug_level;
 
     return (level & CLIXON_DBG_DMASK) >> CLIXON_DBG_DSHIFT;
 }
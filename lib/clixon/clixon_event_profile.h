@@ -0,0 +1,65 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+
+ * Event loop and IPC latency profiler, enabled by debug subject CLIXON_DBG_PROFILE
+ */
+#ifndef _CLIXON_EVENT_PROFILE_H
+#define _CLIXON_EVENT_PROFILE_H
+
+/*
+ * Types
+ */
+/*! Kind of value recorded in a histogram
+ *
+ * All kinds are times in micro-seconds, except ready which is a number of file descriptors
+ */
+enum event_profile_kind{
+    EP_CALLBACK, /* File event callback, per registration string */
+    EP_TIMER,    /* Timer callback, per registration string */
+    EP_LAG,      /* Event loop lag: dispatch of ready events and lateness of timers */
+    EP_READY,    /* Number of ready file descriptors per wakeup */
+    EP_RPC,      /* Round-trip time of rpc from client to backend, per rpc name */
+};
+#define EP_NR (EP_RPC+1)
+
+/*
+ * Prototypes
+ */
+int      event_profile_enabled(void);
+void     event_profile_start(struct timespec *t0);
+uint64_t event_profile_usec(struct timespec *t0);
+int      event_profile_add(enum event_profile_kind kind, const char *name, uint64_t value);
+int      event_profile_print(cbuf *cb);
+int      event_profile_exit(void);
+
+#endif  /* _CLIXON_EVENT_PROFILE_H */
@@ -80,6 +80,10 @@ int clixon_handle_check(clixon_handle h);
 /* Return clicon options (hash-array) given a handle.*/
 clicon_hash_t *clicon_options(clixon_handle h);
 
+/* Return pre-resolved options given a handle.*/
+struct clicon_option_slots;
+struct clicon_option_slots *clicon_option_slots_get(clixon_handle h);
+
 /* Return internal clicon data (hash-array) given a handle.*/
 clicon_hash_t *clicon_data(clixon_handle h);
 
@@ -38,8 +38,9 @@
 #ifndef _CLIXON_HASH_H_
 #define _CLIXON_HASH_H_
 
+/*! Hash entry, allocated separately and not moved when the table grows
+ */
 struct clicon_hash {
-    qelem_t     h_qelem;
     /*
      * Key must be NULL-terminated string unless clicon_hash_add_ptr function
      * is used to add keys.
@@ -62,6 +63,7 @@ int            clicon_hash_del (clicon_hash_t *head, const char *key);
 int            clicon_hash_del_ptr (clicon_hash_t *head, void *key);
 int            clicon_hash_dump(clicon_hash_t *head, FILE *f);
 int            clicon_hash_keys(clicon_hash_t *hash, char ***vector, size_t *nkeys);
+int            clicon_hash_stats(clicon_hash_t *hash, uint64_t *nr, size_t *szp);
 
 /*
  *   Macros to iterate over hash contents.
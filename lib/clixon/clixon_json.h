@@ -44,11 +44,13 @@
  * Prototypes
  */
 int json2xml_decode(cxobj *x, cxobj **xerr);
+int xml2json_encode_identityref(cxobj *xb, char *body, yang_stmt *yp, cbuf *cb);
 int clixon_json2cbuf(cbuf *cb, cxobj *x, int pretty, int skiptop, int autocliext, int system_only);
 int xml2json_cbuf_vec(cbuf *cb, cxobj **vec, size_t veclen, int pretty, int skiptop);
 int clixon_json2file(FILE *f, cxobj *x, int pretty, clicon_output_cb *fn, int skiptop, int autocliext, int system_only);
 int json_print(FILE *f, cxobj *x);
 int xml2json_vec(FILE *f, cxobj **vec, size_t veclen, int pretty, clicon_output_cb *fn, int skiptop);
+int clixon_json_parse_fast_set(int enable);
 int clixon_json_parse_string(clixon_handle h, char *str, int jsonenc, yang_bind yb,
                              yang_stmt *yspec, cxobj **xt, cxobj **xret);
 int clixon_json_parse_file(FILE *fp, int jsonenc, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xret);
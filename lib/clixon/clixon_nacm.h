@@ -53,20 +53,32 @@ enum nacm_access{
     NACM_EXEC
 };
 
+/* NACM read filter, see nacm_read_filter_new */
+struct nacm_read_filter;
+
 /*
  * Prototypes
  */
 int nacm_proxyuser_add(clixon_handle h, const char *user);
-int nacm_rpc(char *rpc, char *module, char *username, cxobj *xnacm, cbuf *cbret);
+int nacm_rpc(clixon_handle h, char *rpc, char *module, char *username, cxobj *xnacm, cbuf *cbret);
+int nacm_datanode_read_permitted(clixon_handle h, char *username, cxobj *xnacm);
 int nacm_datanode_read1(clixon_handle h, cxobj *xt, char *username, cxobj *nacm_xtree);
 int nacm_datanode_read_prune(clixon_handle h, cxobj *xt);
+int nacm_read_filter_new(clixon_handle h, cxobj *xt, char *username, cxobj *xnacm,
+                         int (*fn)(cxobj *, void *), void *fnarg,
+                         struct nacm_read_filter **nfp);
+int nacm_read_filter(cxobj *x, void *arg);
+int nacm_read_filter_free(struct nacm_read_filter *nf);
 int nacm_datanode_write(clixon_handle h, cxobj *xr, cxobj *xt,
                         enum nacm_access access,
                         char *username, cxobj *xnacm, cbuf *cbret);
 int nacm_access_pre(clixon_handle h, char *peername, char *username, cxobj **xnacmp, cbuf *cbret);
 int verify_nacm_user(clixon_handle h, enum nacm_credentials_t cred, char *peername, char *nacmname, char *rpcname, cbuf *cbret);
+int nacm_load_external(clixon_handle h);
 int nacm_init(clixon_handle h);
 int nacm_exit(clixon_handle h);
+int nacm_cache_stats(clixon_handle h, uint64_t *nr, size_t *szp);
+uint64_t nacm_generation(clixon_handle h);
 
 /* 7.4 Backward compatible */
 #define nacm_datanode_read(h, xt, xvec, xlen, u, xn) nacm_datanode_read1((h), (xt), (u), (xn))
@@ -67,6 +67,14 @@
  */
 #define NETCONF_BASE_CAPABILITY_1_1 "urn:ietf:params:netconf:base:1.1"
 
+/* Clixon internal capability: client accepts binary XML replies, see CLICON_IPC_BINARY
+ */
+#define CLIXON_IPC_BINARY_CAPABILITY "http://clicon.org/ipc/binary"
+
+/* Clixon internal capability: shared memory transport on UNIX socket, see CLICON_IPC_SHM
+ */
+#define CLIXON_IPC_SHM_CAPABILITY "http://clicon.org/ipc/shm"
+
 /* See RFC 7950 Sec 5.3.1: YANG defines an XML namespace for NETCONF <edit-config>
  * operations, <error-info> content, and the <action> element.
  */
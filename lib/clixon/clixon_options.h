@@ -94,6 +94,33 @@ enum regexp_mode{
     REGEXP_LIBXML2
 };
 
+/*! Options resolved once per config load or change, for lookup without hashing
+ *
+ * Used on hot paths instead of clicon_option_bool(h, "CLICON_XMLDB_MULTI") etc
+ * @see option_slot_tab in clixon_options.c for names and types
+ * @see clicon_option_slot_int
+ */
+enum clicon_option_slot{
+    OS_XMLDB_MULTI,
+    OS_XMLDB_SHARD,
+    OS_XMLDB_PRETTY,
+    OS_XMLDB_FORMAT,
+    OS_XMLDB_MODSTATE,
+    OS_XMLDB_SYSTEM_ONLY_CONFIG,
+    OS_XMLDB_RUNNING_RDONLY,
+    OS_XMLDB_JOURNAL,
+    OS_XMLDB_JOURNAL_SIZE,
+    OS_XMLDB_SNAPSHOT,
+    OS_XMLDB_SORT_THREADS,
+    OS_NACM_DISABLED_ON_EMPTY,
+    OS_YANG_SCHEMA_MOUNT,
+    OS_YANG_UNKNOWN_ANYDATA,
+    OS_IPC_BINARY,
+    OS_IPC_SHM,
+    OS_NR              /* Number of slots, not an option */
+};
+typedef struct clicon_option_slots clicon_option_slots;
+
 /*
  * Prototypes
  */
@@ -133,6 +160,14 @@ int clicon_option_bool_set(clixon_handle h, const char *name, int val);
 /* Delete a single option via handle */
 int clicon_option_del(clixon_handle h, const char *name);
 
+/* Pre-resolved option access */
+clicon_option_slots *clicon_option_slots_new(void);
+int   clicon_option_slots_free(clicon_option_slots *os);
+int   clicon_option_slots_invalidate(clixon_handle h);
+char *clicon_option_slot_str(clixon_handle h, enum clicon_option_slot slot);
+int   clicon_option_slot_int(clixon_handle h, enum clicon_option_slot slot);
+int   clicon_option_slot_bool(clixon_handle h, enum clicon_option_slot slot);
+
 /*-- Standard option access functions for YANG options --*/
 static inline char *clicon_configfile(clixon_handle h){
     return clicon_option_str(h, "CLICON_CONFIGFILE");
@@ -72,6 +72,9 @@ typedef struct {
     yang_stmt  *cp_yang;     /* Corresponding yang spec (after XML match - ie resolved) */
 } clixon_path;
 
+/* Incremental api-path builder, struct defined in clixon_path.c */
+typedef struct api_path_builder api_path_builder;
+
 /*! Callback if empty mount-point is encountered */
 typedef int (api_path_mnt_cb_t)(clixon_handle h, cxobj *x, yang_stmt **yp);
 
@@ -83,6 +86,8 @@ int xml_yang_root(cxobj *x, cxobj **xr);
 int yang2api_path_fmt(yang_stmt *ys, int inclkey, char **api_path_fmt);
 int api_path_fmt2api_path(const char *api_path_fmt, cvec *cvv, yang_stmt *yspec, char **api_path, int *cvvi);
 int api_path_fmt2xpath(char *api_path_fmt, cvec *cvv, char **xpath);
+int api_path_cache_exit(void);
+int api_path_cache_stats(uint64_t *nr, size_t *szp);
 int api_path2xpath(char *api_path, yang_stmt *yspec, char **xpath, cvec **nsc, cxobj **xerr);
 int api_path2xml(char *api_path, yang_stmt *yspec, cxobj *xtop,
                  yang_class nodeclass, int strict,
@@ -92,6 +97,9 @@ int api_path2xml_mnt(char *api_path, yang_stmt *yspec, cxobj *xtop,
                      api_path_mnt_cb_t mnt_cb, void *arg,
                      cxobj **xpathp, yang_stmt **ypathp, cxobj **xerr);
 int xml2api_path_1(cxobj *x, cbuf *cb);
+api_path_builder *api_path_builder_new(void);
+int api_path_builder_free(api_path_builder *pb);
+int api_path_builder_path(api_path_builder *pb, cxobj *x, char **pathp);
 int clixon_xml_find_api_path(cxobj *xt, yang_stmt *yt, cxobj ***xvec, int *xlen, const char *format,
                      ...) __attribute__ ((format (printf, 5, 6)));
 int clixon_xml_find_instance_id(cxobj *xt, yang_stmt *yt, cxobj ***xvec, int *xlen, const char *format,
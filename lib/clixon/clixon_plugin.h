@@ -225,6 +225,9 @@ typedef int (plgreset_t)(clixon_handle h, const char *db);
  *
  * @note The system will make an xpath check and filter out non-matching trees
  * @note The system does not validate the xml, unless CLICON_VALIDATE_STATE_XML is set
+ * @note If the get has a depth, clicon_data_int_get(h, "clixon-get-depth") is the number of
+ *       levels below top that are returned, and the plugin may leave out deeper data.
+ *       Otherwise it is -1
  * @see clixon_pagination_cb_register for special paginated state data callback
  */
 typedef int (plgstatedata_t)(clixon_handle h, cvec *nsc, char *xpath, cxobj *xconfig);
@@ -236,6 +239,14 @@ typedef int (plgstatedata_t)(clixon_handle h, cvec *nsc, char *xpath, cxobj *xco
  */
 typedef void *pagination_data;
 
+/*! State list producer data type
+ *
+ * @see statelist_data_t in for full state list producer data structure
+ * @see statelist_offset() and other accessor functions
+ * @see clixon_statelist_cb_register
+ */
+typedef void *statelist_data;
+
 /*! Lock database status has changed status
  *
  * @param[in]  h    Clixon handle
@@ -424,6 +435,9 @@ struct clixon_plugin_api{
             plgdaemon_t      *cb_daemon;         /* Plugin daemonized (always called) */
             plgreset_t       *cb_reset;          /* Reset system status */
             plgstatedata_t   *cb_statedata;      /* Provide state data XML from plugin */
+            uint32_t          cb_statedata_ttl;  /* Milliseconds state data is cached, 0: not */
+            char            **cb_statedata_paths; /* NULL-terminated subtrees of state data */
+            int               cb_statedata_parallel; /* Statedata callback is thread-safe */
             plgstatedata_t   *cb_system_only;    /* Provide system-only config XML from plugin */
             plglockdb_t      *cb_lockdb;         /* Database lock changed state */
             trans_cb_t       *cb_trans_begin;    /* Transaction start */
@@ -436,6 +450,8 @@ struct clixon_plugin_api{
             trans_cb_t       *cb_trans_end;      /* Transaction completed  */
             trans_cb_t       *cb_trans_abort;    /* Transaction aborted */
             datastore_upgrade_t *cb_datastore_upgrade; /* General-purpose datastore upgrade */
+            char             *cb_trans_group;    /* Group of parallel validate/commit, or NULL */
+            char            **cb_trans_paths;    /* NULL-terminated subtrees of transaction view */
         } cau_backend;
     } u;
 };
@@ -448,6 +464,17 @@ struct clixon_plugin_api{
 #define ca_daemon         u.cau_backend.cb_daemon
 #define ca_reset          u.cau_backend.cb_reset
 #define ca_statedata      u.cau_backend.cb_statedata
+/* Plugins with a state data TTL get their state trees cached per xpath, and gets within the
+ * TTL of an xpath or of a prefix of it do not call the statedata callback.
+ * Invalidate with clixon_plugin_statedata_invalidate, see clixon_plugin_statedata_all */
+#define ca_statedata_ttl  u.cau_backend.cb_statedata_ttl
+/* Plugins with state data paths, absolute schema-nodeids with module prefixes, eg
+ * "/if:interfaces-state", provide state data only in those subtrees, and their statedata
+ * callback is not called for gets of other subtrees, see clixon_plugin_statedata_all */
+#define ca_statedata_paths u.cau_backend.cb_statedata_paths
+/* Plugins with a thread-safe statedata callback may have it called in parallel with those of
+ * other such plugins, see CLICON_BACKEND_PLUGIN_THREADS. State trees are merged in load order */
+#define ca_statedata_parallel u.cau_backend.cb_statedata_parallel
 #define ca_system_only    u.cau_backend.cb_system_only
 #define ca_lockdb         u.cau_backend.cb_lockdb
 #define ca_trans_begin    u.cau_backend.cb_trans_begin
@@ -460,6 +487,22 @@ struct clixon_plugin_api{
 #define ca_trans_end      u.cau_backend.cb_trans_end
 #define ca_trans_abort    u.cau_backend.cb_trans_abort
 #define ca_datastore_upgrade  u.cau_backend.cb_datastore_upgrade
+/* Plugins with a group may run transaction validate and commit in parallel with consecutive
+ * plugins of other groups, see CLICON_BACKEND_PLUGIN_THREADS. Plugins of the same group are
+ * called in load order. Callbacks of such plugins must be thread-safe:
+ * - The source and target trees of the transaction are shared and only read, with eg
+ *   xml_find, xml_child_each, xml_body, xpath_vec and xml_nsctx_node. Not safe on them are
+ *   xml_flag_set/reset, xml_apply with flag changes, xml_sort, xml_childvec_get, xml_purge,
+ *   xml_addsub, xml_value_set and other changes.
+ * - New trees, eg copies made with xml_dup, may be created, changed and freed.
+ * - Not safe are datastore calls, xmldb_get and xmldb_put, and setting handle data and
+ *   options, clicon_data_set and clicon_option_str_set */
+#define ca_trans_group    u.cau_backend.cb_trans_group
+/* Plugins with paths, absolute schema-nodeids with module prefixes, eg "/if:interfaces", get a
+ * view of each transaction with only the changes in those subtrees, and their transaction
+ * validate, complete, commit, commit_done, commit_failed and revert callbacks are not called
+ * if no such subtree changed, see transaction_views_compute */
+#define ca_trans_paths    u.cau_backend.cb_trans_paths
 
 /*
  * Macros
@@ -514,6 +557,7 @@ clixon_plugin_api *clixon_plugin_init(clixon_handle h);
 clixon_plugin_api *clixon_plugin_api_get(clixon_plugin_t *cp);
 char            *clixon_plugin_name_get(clixon_plugin_t *cp);
 plghndl_t        clixon_plugin_handle_get(clixon_plugin_t *cp);
+uint64_t         clixon_plugin_init_usec_get(clixon_plugin_t *cp);
 
 clixon_plugin_t *clixon_plugin_each(clixon_handle h, clixon_plugin_t *cpprev);
 
@@ -0,0 +1,79 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+
+ * Static tracing probes, USDT compatible (SystemTap sys/sdt.h, bpftrace, perf)
+ * Enabled with configure --enable-usdt. A probe is a nop instruction and a note in the
+ * binary, a tracer attaches by replacing the nop. Arguments are integers or pointers that
+ * are cheap to evaluate, strings are read by the tracer. When not enabled, probes are empty.
+ * Latencies are computed by the tracer from pairs of probes, eg:
+ *   bpftrace -e 'usdt:/usr/local/sbin/clixon_backend:clixon:rpc__receive { @t[tid] = nsecs; }
+ *                usdt:/usr/local/sbin/clixon_backend:clixon:rpc__reply /@t[tid]/ {
+ *                  @us[str(arg1)] = hist((nsecs - @t[tid])/1000); delete(@t[tid]); }'
+ * Probes, provider clixon:
+ *   rpc__receive(session-id, rpc-name)              Backend, rpc from client received
+ *   rpc__reply(session-id, rpc-name)                Backend, reply sent or queued
+ *   commit__start(transaction-id)                   Backend commit started
+ *   commit__phase(transaction-id, phase, usec)      Backend commit or validate phase done
+ *   commit__done(transaction-id, usec)              Backend commit done
+ *   plugin__entry(plugin, callback)                 Backend plugin transaction callback
+ *   plugin__exit(plugin, callback, retval, usec)
+ *   datastore__read__start(db)                      Read datastore from file
+ *   datastore__read__done(db, retval)
+ *   datastore__write__start(db)                     Write datastore cache to file
+ *   datastore__write__done(db, retval)
+ *   xpath__eval__start(xpath)                       XPath evaluation, xpath is NULL if
+ *   xpath__eval__done(xpath, retval)                only a parsed XPath is given
+ *   restconf__request__start(method, path)          RESTCONF request
+ *   restconf__request__done(method, path, retval)
+ */
+#ifndef _CLIXON_PROBE_H
+#define _CLIXON_PROBE_H
+
+#ifdef CLIXON_USDT
+#include <sys/sdt.h>
+
+#define CLIXON_PROBE1(name, a1)                 DTRACE_PROBE1(clixon, name, a1)
+#define CLIXON_PROBE2(name, a1, a2)             DTRACE_PROBE2(clixon, name, a1, a2)
+#define CLIXON_PROBE3(name, a1, a2, a3)         DTRACE_PROBE3(clixon, name, a1, a2, a3)
+#define CLIXON_PROBE4(name, a1, a2, a3, a4)     DTRACE_PROBE4(clixon, name, a1, a2, a3, a4)
+
+#else /* CLIXON_USDT */
+
+#define CLIXON_PROBE1(name, a1)                 do {} while (0)
+#define CLIXON_PROBE2(name, a1, a2)             do {} while (0)
+#define CLIXON_PROBE3(name, a1, a2, a3)         do {} while (0)
+#define CLIXON_PROBE4(name, a1, a2, a3, a4)     do {} while (0)
+
+#endif /* CLIXON_USDT */
+
+#endif  /* _CLIXON_PROBE_H */
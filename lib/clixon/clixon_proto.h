@@ -40,6 +40,15 @@
 #ifndef _CLIXON_PROTO_H_
 #define _CLIXON_PROTO_H_
 
+/*
+ * Types
+ */
+/* Receive state of a socket where several messages may be in flight */
+typedef struct clixon_msg_pipe clixon_msg_pipe;
+
+/* Called with each part of a message received as a stream, see clixon_msg_rcv11_stream */
+typedef int (clixon_msg_stream_fn)(void *arg, char *data, size_t len, int eom);
+
 /*
  * Prototypes
  */
@@ -62,6 +71,19 @@ int clixon_rpc10(int sock, const char *descr, cbuf *msgin, cbuf **msgret, int *e
 int clixon_msg_rcv11(int s, const char *descr, int intr, cbuf **msg, int *eof);
 int clixon_rpc11(int sock, const char *descr, cbuf *msg, cbuf **msgret, int *eof);
 int clixon_msg_send11(int s, const char *descr, cbuf *msg);
+int clixon_msg_send11_chunk(int s, const char *descr, cbuf *cb);
+int clixon_msg_outq_init(int s, size_t hiwat, int (*fn)(int, void*), void *arg);
+int clixon_msg_outq_coalesce(int s, uint32_t usec);
+int clixon_msg_outq_free(int s);
+size_t clixon_msg_outq_len(int s);
+int clixon_msg_outq_full(int s);
+void clixon_msg_outq_bypass(int bypass);
+clixon_msg_pipe *clixon_msg_pipe_new(void);
+int clixon_msg_pipe_free(clixon_msg_pipe *mp);
+int clixon_msg_pipe_pending(clixon_msg_pipe *mp);
+size_t clixon_msg_pipe_size(clixon_msg_pipe *mp);
+int clixon_msg_rcv11_pipe(int s, const char *descr, clixon_msg_pipe *mp, cbuf **msg, int *eof);
+int clixon_msg_rcv11_stream(int s, const char *descr, clixon_msg_stream_fn *fn, void *arg, int *eof);
 
 int clixon_msg_send(int s, const char *descr, cbuf *cb);
 int send_msg_reply(int s, const char *descr, char *data, uint32_t datalen);
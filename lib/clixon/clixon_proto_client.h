@@ -44,8 +44,16 @@
 
 int clicon_rpc_msg(clixon_handle h, cbuf *cbsend, cxobj **xret0);
 int clicon_rpc_msg_persistent(clixon_handle h, cbuf *cbsend, cxobj **xret0, int *sock0);
+int clicon_rpc_msg_send(clixon_handle h, cbuf *cbsend, uint32_t *idp);
+int clicon_rpc_msg_recv(clixon_handle h, uint32_t id, cxobj **xret);
+int clicon_client_pool_init(clixon_handle h, int n);
+int clicon_client_pool_select(clixon_handle h, void *owner);
+int clicon_client_pool_release(clixon_handle h, void *owner);
+int clicon_client_pool_exit(clixon_handle h);
 int clicon_rpc_netconf(clixon_handle h, char *xmlst, cxobj **xret, int *sp);
 int clicon_rpc_netconf_xml(clixon_handle h, cxobj *xml, cxobj **xret, int *sp);
+int clicon_rpc_netconf_raw(clixon_handle h, cbuf *cbsend, cbuf **cbret);
+int clicon_rpc_netconf_stream(clixon_handle h, cbuf *cbsend, clixon_msg_stream_fn *fn, void *arg);
 int clicon_rpc_get_config(clixon_handle h, char *username, char *db, char *xpath, cvec *nsc, char *defaults, cxobj **xret);
 int clicon_rpc_edit_config(clixon_handle h, char *db, enum operation_type op,
                            char *xml);
@@ -70,5 +78,8 @@ int clicon_rpc_debug(clixon_handle h, int level);
 int clicon_rpc_restconf_debug(clixon_handle h, int level);
 int clicon_hello_req(clixon_handle h, char *transport, char *source_host, uint32_t *id);
 int clicon_rpc_restart_plugin(clixon_handle h, char *plugin);
+int clicon_rpc_datastore_change(clixon_handle h, char *db, uint64_t *id, struct timeval *tv);
+int clicon_rpc_expand_values(clixon_handle h, char *db, char *xpath, cvec *nsc, char *prefix, uint32_t limit, cxobj **xt);
+int clicon_rpc_datastore_diff(clixon_handle h, char *db1, char *db2, char *format, cbuf *cb);
 
 #endif  /* _CLIXON_PROTO_CLIENT_H_ */
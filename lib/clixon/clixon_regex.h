@@ -45,5 +45,11 @@ int regexp_xsd2posix(char *xsd, char **posix);
 int regex_compile(clixon_handle h, char *regexp, void **recomp);
 int regex_exec(clixon_handle h, void *recomp, char *string);
 int regex_free(clixon_handle h, void *recomp);
+int regex_compile_mode(int mode, const char *regexp, void **recomp);
+int regex_cache_get(int mode, const char *regexp, void **recomp);
+void regex_cache_release(int mode, void *recomp);
+int regex_cache_exit(void);
+int regex_cache_stats(uint64_t *nr, uint64_t *hits, uint64_t *misses);
+int regex_cache_size(size_t *szp);
 
 #endif  /* _CLIXON_REGEX_H_ */
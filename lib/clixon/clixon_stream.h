@@ -63,13 +63,16 @@ struct stream_subscription{
     struct timeval              ss_stoptime; /* Replay stoptime */
     stream_fn_t                 ss_fn;     /* Callback when event occurs */
     void                       *ss_arg;    /* Callback argument */
+    time_t                      ss_rate_sec; /* Second of ss_rate_nr, see es_rate */
+    uint32_t                    ss_rate_nr;  /* Events sent in ss_rate_sec */
+    uint32_t                    ss_dropped;  /* Events dropped by rate limit */
 };
 
-/* Replay time-series */
+/* Replay time-series entry, see es_replay ring */
 struct stream_replay{
-    qelem_t        r_q;   /* queue header */
     struct timeval r_tv;  /* time index */
-    cxobj         *r_xml; /* event in xml form */
+    char          *r_str; /* event in serialized xml form */
+    size_t         r_len; /* length of r_str */
 };
 
 /* See RFC8040 9.3, stream list, no replay support for now
@@ -81,8 +84,14 @@ struct event_stream{
     struct stream_subscription *es_subscription;
     int                  es_replay_enabled; /* set if replay is enables */
     struct timeval       es_retention; /* replay retention - how much to save */
-    struct stream_replay *es_replay;
-
+    struct stream_replay *es_replay;   /* replay ring ordered by time */
+    size_t               es_replay_len;   /* allocated entries of ring */
+    size_t               es_replay_i0;    /* index of oldest entry */
+    size_t               es_replay_nr;    /* nr of entries */
+    size_t               es_replay_size;  /* bytes of serialized entries */
+    size_t               es_replay_max;   /* max bytes, 0 is unlimited */
+    uint32_t             es_rate;         /* max events per second to a subscription, 0 is unlimited */
+    uint64_t             es_dropped;      /* events dropped by rate limit, all subscriptions */
 };
 typedef struct event_stream event_stream_t;
 
@@ -92,6 +101,7 @@ typedef struct event_stream event_stream_t;
 event_stream_t *stream_find(clixon_handle h, const char *name);
 int stream_add(clixon_handle h, const char *name, const char *description, int replay_enabled, struct timeval *retention);
 int stream_delete_all(clixon_handle h, int force);
+int stream_rate_limit_set(clixon_handle h, const char *name, uint32_t rate);
 int stream_get_xml(clixon_handle h, int access, cbuf *cb);
 int stream_timer_setup(int fd, void *arg);
 /* Subscriptions */
@@ -105,11 +115,14 @@ struct stream_subscription *stream_ss_find(event_stream_t *es,
 int stream_ss_delete_all(clixon_handle h, stream_fn_t fn, void *arg);
 int stream_ss_delete(clixon_handle h, char *name, stream_fn_t fn, void *arg);
 
+int stream_event_cbuf(clixon_handle h, cxobj *xev, cbuf **cbp);
 int stream_notify_xml(clixon_handle h, char *stream, cxobj *xml);
+int stream_notify_xml_selector(clixon_handle h, char *stream, const char *selector, cxobj *xml);
 int stream_notify(clixon_handle h, char *stream, const char *event, ...)  __attribute__ ((format (printf, 3, 4)));
 
 /* Replay */
 int stream_replay_add(event_stream_t *es, struct timeval *tv, cxobj *xv);
+int stream_replay_stats(clixon_handle h, uint64_t *nr, size_t *szp);
 int stream_replay_trigger(clixon_handle h, char *stream, stream_fn_t fn, void *arg);
 
 /* Experimental publish streams using SSE. CLIXON_PUBLISH_STREAMS should be set */
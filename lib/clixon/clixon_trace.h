@@ -0,0 +1,61 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+
+ * Request tracing across frontends and backend, W3C trace context ids, spans exported
+ * as JSON lines
+ */
+#ifndef _CLIXON_TRACE_H
+#define _CLIXON_TRACE_H
+
+/*
+ * Constants
+ */
+/* Name of internal rpc attribute carrying the trace context, value as W3C traceparent */
+#define CLIXON_TRACE_ATTR "traceparent"
+
+/* Prefix of CLIXON_TRACE_ATTR, declared separately for the clixon-lib namespace in case
+ * the rpc already declares CLIXON_LIB_PREFIX */
+#define CLIXON_TRACE_PREFIX "cltr"
+
+/*
+ * Prototypes
+ */
+int clixon_trace_start(clixon_handle h, const char *traceparent, const char *name, const char *detail);
+int clixon_trace_active(void);
+int clixon_trace_span_begin(const char *name, const char *detail);
+int clixon_trace_span_end(clixon_handle h, int status);
+int clixon_trace_stop(clixon_handle h, int status);
+int clixon_trace_traceparent(cbuf *cb);
+int clixon_trace_exit(void);
+
+#endif  /* _CLIXON_TRACE_H */
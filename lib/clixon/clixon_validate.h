@@ -49,6 +49,8 @@ int xml_yang_validate_add(clixon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_list_key_only(cxobj *xt, cxobj **xret);
 int xml_yang_validate_all(clixon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_all_top(clixon_handle h, cxobj *xt, cxobj **xret);
+int xml_yang_validate_all_changed(clixon_handle h, cxobj *xt, clicon_hash_t *chg, cxobj **xret);
+int xml_yang_validate_changed(clicon_hash_t *chg, cxobj *x, int recurse);
 int xml_yang_validate_exit(clixon_handle h);
 int rpc_reply_check(clixon_handle h, char *rpcname, cbuf *cbret);
 
@@ -0,0 +1,69 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+ * Validation cost profiler, enabled by debug subject CLIXON_DBG_PROFILE
+ */
+#ifndef _CLIXON_VALIDATE_PROFILE_H
+#define _CLIXON_VALIDATE_PROFILE_H
+
+/*
+ * Types
+ */
+/*! Kind of validation check recorded per YANG node
+ *
+ * Type includes pattern and range of the same value, and min/max includes unique
+ * of the lists below it
+ */
+enum validate_profile_kind{
+    VP_TYPE,    /* Value parsed and checked against its type */
+    VP_PATTERN, /* Pattern restrictions of string types */
+    VP_RANGE,   /* Range and length restrictions */
+    VP_MUST,    /* Must statements */
+    VP_WHEN,    /* When statements */
+    VP_LEAFREF, /* Leafref target lookup */
+    VP_UNIQUE,  /* Unique statements and list keys */
+    VP_MINMAX,  /* Min/max-elements and duplicate check of children */
+};
+#define VP_NR (VP_MINMAX+1)
+
+/*
+ * Prototypes
+ */
+int        validate_profile_enabled(void);
+yang_stmt *validate_profile_node(yang_stmt *ys);
+void       validate_profile_start(struct timespec *t0);
+int        validate_profile_add(yang_stmt *ys, enum validate_profile_kind kind,
+                                struct timespec *t0);
+int        validate_profile_print(cbuf *cb);
+int        validate_profile_exit(void);
+
+#endif  /* _CLIXON_VALIDATE_PROFILE_H */
@@ -184,6 +184,7 @@ typedef struct xml cxobj; /* struct defined in clicon_xml.c */
 typedef int (xml_applyfn_t)(cxobj *x, void *arg);
 
 typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c */
+typedef struct xml_nsscope xml_nsscope; /* struct defined in clixon_xml_nsctx.c */
 
 /*! Alternative tree formats,
  *
@@ -195,6 +196,7 @@ enum format_enum{
     FORMAT_TEXT,
     FORMAT_CLI,
     FORMAT_NETCONF,  /* Last concrete format, used in code */
+    FORMAT_CBOR,     /* Binary YANG-CBOR, datastore only, see clixon_cbor.c */
     FORMAT_DEFAULT,  /* Indirect: actual value in CLICON_CLI_OUTPUT_FORMAT */
     FORMAT_PIPE_XML_DEFAULT /* Meta: If pipe, xml, if not default */
 };
@@ -215,6 +217,12 @@ enum format_enum{
 #define XML_FLAG_CACHE_DIRTY 0x400 /* This part of XML tree is not synced to disk */
 #define XML_FLAG_SKIP      0x800 /* Node is skipped in xml_diff */
 #define XML_FLAG_DENY     0x1000 /* Marked as read denied by NACM  */
+#define XML_FLAG_EDIT     0x2000 /* Node or descendant edited since base of datastore, see de_edit_gen */
+#define XML_FLAG_LEAFREF  0x4000 /* Leafref referring to deleted or changed node, see LEAFREF_INDEX */
+
+/*! Transient flags reset in all trees by xml_flag_epoch_next, see XML_FLAG_EPOCH
+ */
+#define XML_FLAG_EPOCH_MASK (XML_FLAG_MARK|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_NONE|XML_FLAG_SKIP)
 
 /*
  * Prototypes
@@ -222,6 +230,19 @@ enum format_enum{
 char     *xml_type2str(enum cxobj_type type);
 int       xml_stats_global(uint64_t *nr);
 int       xml_stats(cxobj *xt, uint64_t *nrp, size_t *szp);
+int       xml_stats_index(cxobj *xt, size_t *szp);
+int       xml_compact(cxobj *xt, int min, size_t *szp);
+#ifdef XML_SLAB_ALLOC
+int       xml_slab_stats(uint64_t *nslabs, uint64_t *inuse, size_t *sz);
+int       xml_slab_release(void);
+#endif
+int       xml_threads_set(int threads);
+int       xml_threads_get(void);
+int       xml_intern(const char *str, char **istr);
+void      xml_intern_ref(int inc);
+int       xml_intern_exit(void);
+int       xml_name_eq(cxobj *x, const char *name, const char *iname);
+char     *xml_name_interned(cxobj *x);
 char     *xml_name(cxobj *xn);
 int       xml_name_set(cxobj *xn, const char *name);
 char     *xml_prefix(cxobj *xn);
@@ -232,6 +253,9 @@ cvec     *nscache_get_all(cxobj *x);
 int       nscache_set(cxobj *x, const char *prefix, const char *ns);
 int       nscache_clear(cxobj *x);
 int       nscache_replace(cxobj *x, cvec *ns);
+xml_nsscope *nsscope_get(cxobj *x);
+int       nsscope_set(cxobj *x, xml_nsscope *sc);
+uint64_t  nsscope_gen(void);
 cxobj    *xml_parent(cxobj *xn);
 int       xml_parent_set(cxobj *xn, cxobj *parent);
 #ifdef XML_PARENT_CANDIDATE
@@ -242,6 +266,7 @@ int       xml_parent_candidate_set(cxobj *xn, cxobj *parent);
 uint16_t  xml_flag(cxobj *xn, uint16_t flag);
 int       xml_flag_set(cxobj *xn, uint16_t flag);
 int       xml_flag_reset(cxobj *xn, uint16_t flag);
+int       xml_flag_epoch_next(void);
 
 char     *xml_value(cxobj *xn);
 int       xml_value_set(cxobj *xn, const char *val);
@@ -255,6 +280,7 @@ cxobj    *xml_child_i(cxobj *xn, int i);
 cxobj    *xml_child_i_type(cxobj *xn, int i, enum cxobj_type type);
 cxobj    *xml_child_i_set(cxobj *xt, int i, cxobj *xc);
 int       xml_child_order(cxobj *xn, cxobj *xc);
+int       xml_child_group(cxobj *xp, yang_stmt *yc, int *start, int *end);
 int       xml_vector_decrement(cxobj *x, int nr);
 cxobj    *xml_child_each(cxobj *xparent, cxobj *xprev,  enum cxobj_type type);
 cxobj    *xml_child_each_attr(cxobj *xparent, cxobj *xprev);
@@ -281,6 +307,12 @@ int       xml_rootchild_node(cxobj  *xp, cxobj *xc);
 int       xml_enumerate_children(cxobj *xp);
 int       xml_enumerate_reset(cxobj *xp);
 int       xml_enumerate_get(cxobj *x);
+int       xml_sort_pending(cxobj *x);
+int       xml_sort_pending_set(cxobj *x, int val);
+int       xml_sorted_declare(cxobj *x);
+int       xml_sorted_declared(cxobj *x);
+int       xml_visit_mark(cxobj *x);
+int       xml_visit_clear(cxobj *x);
 
 char     *xml_body(cxobj *xn);
 cxobj    *xml_body_get(cxobj *xn);
@@ -313,8 +345,14 @@ int       xml_search_index_p(cxobj *x);
 int       xml_search_vector_get(cxobj *x, char *name, clixon_xvec **xvec);
 int       xml_search_child_insert(cxobj *xp, cxobj *x);
 int       xml_search_child_rm(cxobj *xp, cxobj *x);
+int       xml_search_list_insert(cxobj *xp);
+int       xml_search_list_rm(cxobj *xp);
+int       xml_search_index_verify(cxobj *x, void *arg);
 cxobj    *xml_child_index_each(cxobj *xparent, char *name, cxobj *xprev, enum cxobj_type type);
 
+#endif
+#ifdef XML_LIST_HASH
+int       xml_hash_find(cxobj *xp, cxobj *x1, yang_stmt *yc, clixon_xvec *xvec);
 #endif
 
 #endif /* _CLIXON_XML_H */
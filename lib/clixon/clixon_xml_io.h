@@ -40,9 +40,41 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/*! Filter function for XML output, see clixon_xml2cbuf_filter
+ *
+ * @retval  2   Print element and its whole sub-tree
+ * @retval  1   Print element and filter its children
+ * @retval  0   Skip element
+ * @retval -1   Error
+ */
+typedef int (xml_output_filter_t)(cxobj *x, void *arg);
+
+/*! Flush function for streaming XML output, see clixon_xml2cbuf_stream
+ *
+ * Write the buffer and reset it
+ * @retval  0   OK
+ * @retval -1   Error
+ */
+typedef int (clixon_output_flush_t)(cbuf *cb, void *arg);
+
+/*! Binary XML encoder, see clixon_xml_bin_new
+ */
+typedef struct clixon_xml_bin clixon_xml_bin;
+
+/*
+ * Constants
+ */
+/* Split modes of multi-file datastores, multi argument of clixon_xml2file1 */
+#define XML_MULTI_SPLIT  0x01 /* Split at nodes with the xmldb-split extension, see CLICON_XMLDB_MULTI */
+#define XML_MULTI_SHARD  0x02 /* Also split each top-level node, see CLICON_XMLDB_SHARD */
+
 /*
  * Prototypes
  */
+int   xml_multi_split(cxobj *x, int multi);
 int   clixon_xml2file1(FILE *f, cxobj *xn, int level, int pretty, char *prefix,
                        clicon_output_cb *fn, int skiptop, int autocliext, withdefaults_type wdef,
                        int multi, int system_only);
@@ -54,13 +86,31 @@ int   xml_print(FILE *f, cxobj *xn);
 int   xml_dump(FILE  *f, cxobj *x);
 int   clixon_xml2cbuf1(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix,
                        int32_t depth, int skiptop, withdefaults_type wdef);
+int   clixon_xml2cbuf_filter(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix,
+                             int32_t depth, int skiptop, withdefaults_type wdef,
+                             xml_output_filter_t *fn, void *arg);
+int   clixon_xml2cbuf_stream(cbuf *cb, cxobj *x, int32_t depth, int skiptop, withdefaults_type wdef,
+                             xml_output_filter_t *fn, void *arg,
+                             size_t limit, clixon_output_flush_t *flushfn, void *flusharg);
 int   xmltree2cbuf(cbuf *cb, cxobj *x, int level);
 int   clixon_xml_parse_file(FILE *f, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
 int   clixon_xml_parse_string1(clixon_handle h, const char *str, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
+int   clixon_xml_parse_cbuf(clixon_handle h, cbuf *cb, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
+int   clixon_xml_parse_fast_set(int enable);
 int   clixon_xml_parse_va(yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr,
                         const char *format, ...)  __attribute__ ((format (printf, 5, 6)));
 int   clixon_xml_attr_copy(cxobj *xin, cxobj *xout, char *name);
 int   clixon_xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1);
+int   clixon_xml_diff2cbuf_marked(cbuf *cb, cxobj *x0, cxobj *x1, int flag);
+clixon_xml_bin *clixon_xml_bin_new(cbuf *cb);
+void  clixon_xml_bin_free(clixon_xml_bin *xb);
+void  clixon_xml_bin_flush_set(clixon_xml_bin *xb, size_t limit,
+                               clixon_output_flush_t *flushfn, void *flusharg);
+int   clixon_xml_bin_element(clixon_xml_bin *xb, const char *prefix, const char *name, const char *ns);
+void  clixon_xml_bin_end(clixon_xml_bin *xb);
+int   clixon_xml2bin_filter(clixon_xml_bin *xb, cxobj *xn, int32_t depth, int skiptop,
+                            withdefaults_type wdef, xml_output_filter_t *fn, void *arg);
+int   clixon_xml_parse_bin(char *buf, size_t len, cxobj **xt);
 
 static inline int
 clixon_xml2cbuf(cbuf   *cb,
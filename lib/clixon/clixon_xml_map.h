@@ -66,6 +66,10 @@ int xml_diff(cxobj *x0, cxobj *x1,
              cxobj ***first, int *firstlen,
              cxobj ***second, int *secondlen,
              cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen);
+int xml_diff_marked(cxobj *x0, cxobj *x1, int flag,
+                    cxobj ***first, int *firstlen,
+                    cxobj ***second, int *secondlen,
+                    cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen);
 int xml_tree_equal(cxobj *x0, cxobj *x1);
 int xml_tree_prune_flagged_sub(cxobj *xt, int flag, int test, int *upmark);
 int xml_tree_mark_flagged_sub(cxobj *xt, int flag, int test, int delmark, int *upmark);
@@ -86,6 +90,7 @@ int yang_enum2valstr(yang_stmt *ytype, char *enumstr, char **valstr);
 int yang_enum2int(yang_stmt *ytype, char *enumstr, int32_t *val);
 int yang_enum_int_value(cxobj *node, int32_t *val);
 int xml_copy_marked(cxobj *x0, cxobj *x1);
+int xml_marked_filter(cxobj *x, void *arg);
 int yang_check_when_xpath(cxobj *xn, cxobj *xp, yang_stmt *yn, int *hit, int *nrp, char **xpathp);
 int yang_xml_mandatory(cxobj *xt, yang_stmt *ys);
 int xml_rpc_isaction(cxobj *xn);
@@ -54,11 +54,15 @@ char   *xml_nsctx_get(cvec *nsc, const char *prefix);
 int     xml_nsctx_get_prefix(cvec *cvv, const char *ns, char **prefix);
 int     xml_nsctx_add(cvec *nsc, const char *prefix, const char *ns);
 int     xml_nsctx_node(cxobj *x, cvec **ncp);
+int     xml_nsscope_node(cxobj *x, xml_nsscope **scp);
+cvec   *xml_nsscope_nsc(xml_nsscope *sc);
+int     xml_nsscope_unref(xml_nsscope *sc);
 int     xml_nsctx_yang(yang_stmt *yn, cvec **ncp);
 int     xml_nsctx_yangspec(yang_stmt *yspec, cvec **ncp);
 int     xml_nsctx_cbuf(cbuf *cb, cvec *nsc);
 int     xml2ns(cxobj *x, const char *prefix, char **ns);
 int     xml2ns_recurse(cxobj *x);
+int     xml2ns_cache_freeze(int freeze);
 int     xmlns_set(cxobj *x, const char *prefix, const char *ns);
 int     xmlns_set_all(cxobj *x, cvec *nsc);
 int     xml2prefix(cxobj *xn, const char *ns, char **prefixp);
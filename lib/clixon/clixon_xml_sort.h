@@ -41,10 +41,21 @@
 /*
  * Prototypes
  */
+int xml_cv_cache(cxobj *x, cg_var **cvp);
+int xml_cv_parse(cxobj *x, cg_var **cvp, cg_var **cvfree);
+int xml_cv_cache_keys(cxobj *xt);
+#ifdef XML_LIST_HASH
+int xml_key_hash(cxobj *x, yang_stmt *y, uint32_t *hash);
+#endif
 int xml_cmp(cxobj *x1, cxobj *x2, int same, int skip1, char *expl);
 int xml_sort(cxobj *x);
+int xml_sort_merge(cxobj *x, int start);
 int xml_sort_by(cxobj *x, char *indexvar);
 int xml_sort_recurse(cxobj *xn);
+int xml_sort_recurse_threads(cxobj *xn, int nthreads);
+int xml_sort_lazy(cxobj *xn);
+int xml_sort_ensure(cxobj *x);
+int xml_sort_ensure_recurse(cxobj *xn);
 int xml_insert(cxobj *xp, cxobj *xc, enum insert_type ins, char *key_val, cvec *nsckey);
 int xml_sort_verify(cxobj *x, void *arg);
 #ifdef XML_EXPLICIT_INDEX
@@ -115,9 +115,12 @@ struct xpath_tree{
     char              *xs_strnr;  /* original string xs_double: numeric value */
     char              *xs_s0;     /* set if XP_PRIME_STR, XP_PRIME_FN, XP_NODE[_FN] prefix*/
     char              *xs_s1;     /* set if XP_NODE NAME */
+    char              *xs_s1i;    /* Interned xs_s1 if set, see xml_intern(). Counted with xml_intern_ref */
     struct xpath_tree *xs_c0;     /* child 0 */
     struct xpath_tree *xs_c1;     /* child 1 */
     int                xs_match;  /* meta: match this node */
+    struct xpath_prog *xs_prog;   /* Compiled XPath, top node only, see XPATH_COMPILE */
+    struct xpath_deps *xs_deps;   /* Dependencies, top node only, see xpath_tree_deps */
 };
 typedef struct xpath_tree xpath_tree;
 
@@ -134,9 +137,17 @@ int   xpath_tree_eq(xpath_tree *xt1, xpath_tree *xt2, xpath_tree ***vec, size_t
 xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
+int   xpath_parse_cache_exit(void);
+int   xpath_parse_cache_stats(uint64_t *nr, size_t *szp);
+int   xpath_parallel_init(clixon_handle h);
+int   xpath_parallel_frozen(int frozen);
+int   xpath_parallel_tree(xpath_tree *xs);
+int   xpath_parallel_worker(int worker);
+int   xpath_vec_ctx_tree(cxobj *xcur, cvec *nsc, xpath_tree *xptree, int localonly, xp_ctx **xrp);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx **xrp);
 
 int    xpath_vec_bool(cxobj *xcur, cvec *nsc, const char *xpformat, ...) __attribute__ ((format (printf, 3, 4)));
+int    xpath_vec_bool_tree(cxobj *xcur, cvec *nsc, xpath_tree *xptree);
 int    xpath_vec_flag(cxobj *xcur, cvec *nsc, const char *xpformat, uint16_t flags,
                    cxobj ***vec, size_t *veclen, ...) __attribute__ ((format (printf, 3, 7)));
 
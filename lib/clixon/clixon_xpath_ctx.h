@@ -80,6 +80,7 @@ struct xp_ctx{
     enum xp_objtype xc_type;
     cxobj         **xc_nodeset; /* if type XT_NODESET */
     int             xc_size;    /* Length of nodeset */
+    int             xc_max;     /* Allocated length of nodeset if known, see ctx_nodeset_append */
     int             xc_position;
     int             xc_bool;    /* if xc_type XT_BOOL */
     double          xc_number;  /* if xc_type XT_NUMBER */
@@ -102,6 +103,8 @@ extern const map_str2int ctxmap[];
 int ctx_free(xp_ctx *xc);
 xp_ctx *ctx_dup(xp_ctx *xc);
 int ctx_nodeset_replace(xp_ctx *xc, cxobj **vec, size_t veclen);
+int ctx_nodeset_append(xp_ctx *xc, cxobj *x);
+int ctx_nodeset_pool_exit(void);
 int ctx_print_cb(cbuf *cb, xp_ctx *xc, int indent, char *str);
 int ctx_print(FILE *f, xp_ctx *xc, char *str);
 int ctx2boolean(xp_ctx *xc);
@@ -38,7 +38,8 @@
 #ifndef _CLIXON_XPATH_OPTIMIZE_H
 #define _CLIXON_XPATH_OPTIMIZE_H
 
-int  xpath_list_optimize_stats(int *hits);
+int  xpath_list_optimize_stats(int *hits, int *misses);
+int  xpath_list_optimize_get(int *hits, int *misses);
 int  xpath_list_optimize_set(int enable);
 void xpath_optimize_exit(void);
 int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, cxobj ***xvec0, int *xlen0);
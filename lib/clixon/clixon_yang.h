@@ -62,6 +62,7 @@
                                * list elements using this index with binary search */
 #endif
 #define YANG_FLAG_STATE_LOCAL  0x10  /* Local inverted value of Y_CONFIG child */
+#define YANG_FLAG_IDREF_CHECKED 0x20 /* YANG_FLAG_IDREF is computed, see json2xml_decode */
 #define YANG_FLAG_DISABLED     0x40  /* Disabled due to if-feature evaluate to false
                                       * Transformed to ANYDATA but some code may need to check
                                       * why it is an ANYDATA
@@ -100,6 +101,13 @@
                                       * may be different from orig, therefore do not use link to
                                       * original. May also be due to deviations of derived trees
                                       */
+#define YANG_FLAG_IDREF     0x8000 /* This node or a node below may be an identityref leaf, or
+                                      * anydata or mount-point. Only if YANG_FLAG_IDREF_CHECKED
+                                      */
+#ifdef XML_EXPLICIT_INDEX
+#define YANG_FLAG_HAS_INDEX   0x4000 /* This list has an (extra) index child, see YANG_FLAG_INDEX
+                                      */
+#endif
 /*! Names of top-level data YANGs
  */
 #define YANG_DOMAIN_TOP "top"
@@ -288,12 +296,21 @@ uint32_t   yang_linenum_get(yang_stmt *ys);
 int        yang_linenum_set(yang_stmt *ys, uint32_t linenum);
 void      *yang_typecache_get(yang_stmt *ys);
 int        yang_typecache_set(yang_stmt *ys, void *ycache);
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+void      *yang_mntcache_get(yang_stmt *ys);
+int        yang_mntcache_set(yang_stmt *ys, void *ymc);
+#endif
+void      *yang_xpath_get(yang_stmt *ys);
+int        yang_identity_derived(yang_stmt *yid, yang_stmt *ybase);
+int        yang_identity_derived_find(yang_stmt *ybase, char *idref);
 yang_stmt* yang_mymodule_get(yang_stmt *ys);
 int        yang_mymodule_set(yang_stmt *ys, yang_stmt *ym);
 
 /* Stats */
 int        yang_stats_global(uint64_t *nr);
 int        yang_stats(yang_stmt *y, enum rfc_6020 keyw, uint64_t *nrp, size_t *szp);
+int        yang_stats_compact(uint64_t *nr, uint64_t *sz);
+int        yang_compact(yang_stmt *yt);
 
 /* Other functions */
 yang_stmt *yspec_new(clixon_handle h, char *name);
@@ -348,12 +365,31 @@ int        yang_desc_schema_nodeid(yang_stmt *yn, char *schema_nodeid, yang_stmt
 int        yang_config(yang_stmt *ys);
 int        yang_config_ancestor(yang_stmt *ys);
 int        yang_features(clixon_handle h, yang_stmt *yt);
+int        yang_summary_set(yang_stmt *yspec);
+yang_stmt *yang_mandatory_each(yang_stmt *ys, int *inext);
+int        yang_mandatory_maybe(yang_stmt *ys);
+int        yang_minmax_maybe(yang_stmt *ys);
+int        yang_when_maybe(yang_stmt *ys);
+int        yang_validate_parallel(yang_stmt *ys);
 cvec      *yang_arg2cvec(yang_stmt *ys, char *delimi);
 int        yang_key_match(yang_stmt *yn, char *name, int *lastkey);
+#ifdef XML_EXPLICIT_INDEX
+int        yang_list_index_add(yang_stmt *ys);
+int        yang_search_index_option(clixon_handle h, yang_stmt *yspec);
+#endif
 int        yang_type_cache_get2(yang_stmt *ytype, yang_stmt **resolved, int *options,
                                 cvec **cvv, cvec *patterns, cvec *regexps, uint8_t *fraction);
 int        yang_type_cache_set2(yang_stmt *ys, yang_stmt *resolved, int options, cvec *cvv,
                                 cvec *patterns, uint8_t fraction, int rxmode, cvec *regexps);
+#ifdef YANG_TYPE_VALIDATOR
+void      *yang_type_cache_valid_get(yang_stmt *ytype);
+int        yang_type_cache_valid_set(yang_stmt *ytype, void *tv);
+#endif
+#ifdef YANG_ENUM_TABLE
+int        yang_type_cache_enum_set(yang_stmt *ytype);
+#endif
+yang_stmt *yang_enum_find(yang_stmt *ytype, const char *name);
+yang_stmt *yang_enum_find_value(yang_stmt *ytype, int32_t value);
 yang_stmt *yang_anydata_add(yang_stmt *yp, char *name);
 int        yang_extension_value(yang_stmt *ys, char *name, char *ns, int *exist, char **value);
 int        yang_sort_subelements(yang_stmt *ys);
@@ -70,5 +70,8 @@ int yang_schema_get_child(clixon_handle h, cxobj *x1, cxobj *x1c, yang_stmt **yc
 int yang_schema_yspec_rm(clixon_handle h, cxobj *xmnt);
 int yang_schema_mount_yspec(clixon_handle h, cxobj *xt, yang_bind *yb,
                             yang_stmt **yspec, cxobj **xerr);
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+int yang_mount_cache_free(void *ymc);
+#endif
 
 #endif  /* _CLIXON_YANG_SCHEMA_MOUNT_H_ */
@@ -72,5 +72,8 @@ int        yang_type_resolve(yang_stmt *yorig, yang_stmt *ys,
                              cvec **cvv, cvec *patterns, cvec *regexps,
                              uint8_t *fraction);
 enum cv_type yang_type2cv(yang_stmt *ys);
+#ifdef YANG_TYPE_VALIDATOR
+int        yang_type_valid_free(void *tv);
+#endif
 
 #endif  /* _CLIXON_YANG_TYPE_H_ */
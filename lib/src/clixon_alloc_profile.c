@@ -0,0 +1,233 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * Allocation profiler of XML tree operations
+ * Built with ALLOC_PROFILE in clixon_custom.h, where allocation call sites of XML nodes, node
+ * copies, serializer cbufs, namespace contexts and XPath contexts are counted per category.
+ * Counts are per thread. An operation, eg a backend RPC, is bracketed by alloc_profile_begin
+ * and alloc_profile_end, which logs its counts with debug subject CLIXON_DBG_PROFILE and adds
+ * them to a table per operation name, exposed in the stats RPC, see from_client_stats
+ * Counts are of allocation calls, not bytes, and are meant to compare allocator work such as
+ * slabs and interning between builds
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_alloc_profile.h"
+
+/* Max number of operation names, other operations are not recorded when full */
+#define ALLOC_PROFILE_OPS 128
+
+/*
+ * Types
+ */
+/*! Allocation counts of one operation name
+ */
+struct alloc_profile_op{
+    char     *ap_name;                    /* Operation name, eg rpc name */
+    uint64_t  ap_calls;                   /* Number of operations */
+    uint64_t  ap_count[ALLOC_SITE_NR];    /* Sum of allocations per site */
+    uint64_t  ap_max[ALLOC_SITE_NR];      /* Max allocations of one operation per site */
+};
+
+/*
+ * Variables
+ */
+static const char *alloc_site_name[ALLOC_SITE_NR] = {
+    "xml_new",
+    "xml_copy",
+    "cbuf",
+    "nsctx",
+    "xpath",
+};
+
+/* Allocations of current operation in this thread */
+#ifdef HAVE_LIBPTHREAD
+static __thread uint64_t _alloc_count[ALLOC_SITE_NR];
+static pthread_mutex_t   _alloc_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define ALLOC_LOCK()   pthread_mutex_lock(&_alloc_mutex)
+#define ALLOC_UNLOCK() pthread_mutex_unlock(&_alloc_mutex)
+#else
+static uint64_t          _alloc_count[ALLOC_SITE_NR];
+#define ALLOC_LOCK()
+#define ALLOC_UNLOCK()
+#endif
+
+/* Table of operations, in order of first occurrence */
+static struct alloc_profile_op _alloc_ops[ALLOC_PROFILE_OPS];
+static int                     _alloc_ops_nr = 0;
+
+/*! Count one allocation at a call site, use macro ALLOC_PROFILE_COUNT
+ *
+ * @param[in]  site  Call site category
+ */
+void
+alloc_profile_count(enum alloc_site site)
+{
+    _alloc_count[site]++;
+}
+
+/*! Start counting allocations of an operation in this thread
+ */
+void
+alloc_profile_begin(void)
+{
+    memset(_alloc_count, 0, sizeof(_alloc_count));
+}
+
+/*! Stop counting allocations of an operation in this thread, and record them
+ *
+ * @param[in]  op   Operation name, eg rpc name, or NULL
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+alloc_profile_end(const char *op)
+{
+    int                      retval = -1;
+    struct alloc_profile_op *ap = NULL;
+    int                      i;
+
+    if (op == NULL)
+        op = "";
+    clixon_debug(CLIXON_DBG_PROFILE, "%s xml_new:%" PRIu64 " xml_copy:%" PRIu64
+                 " cbuf:%" PRIu64 " nsctx:%" PRIu64 " xpath:%" PRIu64,
+                 op,
+                 _alloc_count[ALLOC_XML_NEW],
+                 _alloc_count[ALLOC_XML_COPY],
+                 _alloc_count[ALLOC_CBUF],
+                 _alloc_count[ALLOC_NSCTX],
+                 _alloc_count[ALLOC_XPATH]);
+    ALLOC_LOCK();
+    for (i=0; i<_alloc_ops_nr; i++)
+        if (strcmp(_alloc_ops[i].ap_name, op) == 0){
+            ap = &_alloc_ops[i];
+            break;
+        }
+    if (ap == NULL && _alloc_ops_nr < ALLOC_PROFILE_OPS){
+        ap = &_alloc_ops[_alloc_ops_nr];
+        if ((ap->ap_name = strdup(op)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        _alloc_ops_nr++;
+    }
+    if (ap){
+        ap->ap_calls++;
+        for (i=0; i<ALLOC_SITE_NR; i++){
+            ap->ap_count[i] += _alloc_count[i];
+            if (_alloc_count[i] > ap->ap_max[i])
+                ap->ap_max[i] = _alloc_count[i];
+        }
+    }
+    retval = 0;
+ done:
+    ALLOC_UNLOCK();
+    memset(_alloc_count, 0, sizeof(_alloc_count));
+    return retval;
+}
+
+/*! Print allocation profile per operation as XML
+ *
+ * @param[out] cb   CLIgen buf
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+alloc_profile_print(cbuf *cb)
+{
+    struct alloc_profile_op *ap;
+    int                      i;
+    int                      j;
+
+    ALLOC_LOCK();
+    for (i=0; i<_alloc_ops_nr; i++){
+        ap = &_alloc_ops[i];
+        cprintf(cb, "<operation>");
+        cprintf(cb, "<name>%s</name>", ap->ap_name);
+        cprintf(cb, "<calls>%" PRIu64 "</calls>", ap->ap_calls);
+        for (j=0; j<ALLOC_SITE_NR; j++){
+            cprintf(cb, "<site>");
+            cprintf(cb, "<name>%s</name>", alloc_site_name[j]);
+            cprintf(cb, "<count>%" PRIu64 "</count>", ap->ap_count[j]);
+            cprintf(cb, "<max>%" PRIu64 "</max>", ap->ap_max[j]);
+            cprintf(cb, "</site>");
+        }
+        cprintf(cb, "</operation>");
+    }
+    ALLOC_UNLOCK();
+    return 0;
+}
+
+/*! Free allocation profile
+ *
+ * @retval  0    OK
+ */
+int
+alloc_profile_exit(void)
+{
+    int i;
+
+    ALLOC_LOCK();
+    for (i=0; i<_alloc_ops_nr; i++)
+        free(_alloc_ops[i].ap_name);
+    memset(_alloc_ops, 0, sizeof(_alloc_ops));
+    _alloc_ops_nr = 0;
+    ALLOC_UNLOCK();
+    return 0;
+}
@@ -0,0 +1,1099 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+
+ * YANG-CBOR encoding and decoding, RFC 9254, using name-based keys
+ * Member names are the same as in JSON, RFC 7951: a name is qualified with its module
+ * name only where the module differs from the parent's. Lists and leaf-lists are arrays.
+ * Leaf values are typed using YANG:
+ *   integers        major type 0 or 1
+ *   decimal64       tag 4 [exponent, mantissa]
+ *   boolean         true / false
+ *   empty           null
+ *   enumeration     tag 44 text string
+ *   bits            tag 43 text string
+ *   other types     text string, where identityref uses the JSON module:id form
+ * Enumerations and bits use the tagged text forms of RFC 9254 for unions, so that they
+ * can be decoded without YANG.
+ * SID-based keys (YANG Schema Item iDentifiers) are not supported, since they require
+ * SID files for all modules.
+ * Decoding translates CBOR to JSON text and parses that with the JSON parser, so that
+ * namespace translation, yang binding and error handling are the same as for JSON.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <dirent.h>
+#include <sys/types.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_options.h"
+#include "clixon_yang_type.h"
+#include "clixon_xml_sort.h"
+#include "clixon_file.h"
+#include "clixon_json.h"
+#include "clixon_cbor.h"
+
+/* CBOR major types, RFC 8949 Sec 3.1 */
+#define CBOR_UINT    0
+#define CBOR_NEGINT  1
+#define CBOR_BYTES   2
+#define CBOR_TEXT    3
+#define CBOR_ARRAY   4
+#define CBOR_MAP     5
+#define CBOR_TAG     6
+#define CBOR_SIMPLE  7
+
+/* Additional information and simple values, RFC 8949 Sec 3.3 */
+#define CBOR_AI_INDEF 31
+#define CBOR_FALSE    0xf4
+#define CBOR_TRUE     0xf5
+#define CBOR_NULL     0xf6
+#define CBOR_BREAK    0xff
+
+/* Tags used by YANG-CBOR, RFC 9254 Sec 9.3 */
+#define CBOR_TAG_DECIMAL   4
+#define CBOR_TAG_BITS      43
+#define CBOR_TAG_ENUM      44
+#define CBOR_TAG_IDENTITY  45
+#define CBOR_TAG_INSTANCE  46
+#define CBOR_TAG_SID       47
+
+/* Max nesting of arrays, maps and tags when decoding */
+#define CBOR_DEPTH_MAX     1024
+
+/*------------------------------------------------------------------------
+ * Encoding
+ *------------------------------------------------------------------------*/
+
+/*! Append a CBOR head: major type and argument in shortest form
+ */
+static void
+cbor_head(cbuf    *cb,
+          int      major,
+          uint64_t val)
+{
+    uint8_t buf[9];
+    int     n;
+    int     i;
+
+    if (val < 24){
+        cbuf_append(cb, (major << 5) | (int)val);
+        return;
+    }
+    if (val <= 0xff){
+        buf[0] = (major << 5) | 24;
+        n = 1;
+    }
+    else if (val <= 0xffff){
+        buf[0] = (major << 5) | 25;
+        n = 2;
+    }
+    else if (val <= 0xffffffff){
+        buf[0] = (major << 5) | 26;
+        n = 4;
+    }
+    else {
+        buf[0] = (major << 5) | 27;
+        n = 8;
+    }
+    for (i=n; i>0; i--){
+        buf[i] = val & 0xff;
+        val >>= 8;
+    }
+    cbuf_append_buf(cb, buf, n+1);
+}
+
+/*! Append a signed integer as major type 0 or 1
+ */
+static void
+cbor_int(cbuf   *cb,
+         int64_t v)
+{
+    if (v < 0)
+        cbor_head(cb, CBOR_NEGINT, (uint64_t)(-1 - v));
+    else
+        cbor_head(cb, CBOR_UINT, (uint64_t)v);
+}
+
+/*! Append a text string
+ */
+static void
+cbor_text(cbuf       *cb,
+          const char *s,
+          size_t      len)
+{
+    cbor_head(cb, CBOR_TEXT, len);
+    if (len)
+        cbuf_append_buf(cb, (void *)s, len);
+}
+
+/*! Append a member name as text string, "modname:name" or "name"
+ */
+static void
+cbor_name(cbuf       *cb,
+          const char *modname,
+          const char *name)
+{
+    size_t mlen = modname ? strlen(modname) : 0;
+    size_t nlen = strlen(name);
+
+    if (modname == NULL){
+        cbor_text(cb, name, nlen);
+        return;
+    }
+    cbor_head(cb, CBOR_TEXT, mlen + 1 + nlen);
+    cbuf_append_buf(cb, (void *)modname, mlen);
+    cbuf_append(cb, ':');
+    cbuf_append_buf(cb, (void *)name, nlen);
+}
+
+/*! Append a decimal64 value as decimal fraction, tag 4 [exponent, mantissa]
+ *
+ * @param[in]  cb    CBOR buffer
+ * @param[in]  body  Decimal string, eg "-12.345"
+ * @retval     1     OK, appended
+ * @retval     0     Not a decimal number that fits, nothing appended
+ */
+static int
+cbor_decimal(cbuf       *cb,
+             const char *body)
+{
+    const char *s = body;
+    uint64_t    m = 0;
+    int64_t     exp = 0;
+    int         neg = 0;
+    int         point = 0;
+    int         digits = 0;
+
+    if (*s == '-'){
+        neg++;
+        s++;
+    }
+    else if (*s == '+')
+        s++;
+    for (; *s; s++){
+        if (*s == '.' && !point){
+            point++;
+            continue;
+        }
+        if (!isdigit((unsigned char)*s))
+            return 0;
+        if (m > (INT64_MAX - 9) / 10)
+            return 0;
+        m = m*10 + (*s - '0');
+        digits++;
+        if (point)
+            exp--;
+    }
+    if (digits == 0)
+        return 0;
+    cbor_head(cb, CBOR_TAG, CBOR_TAG_DECIMAL);
+    cbor_head(cb, CBOR_ARRAY, 2);
+    cbor_int(cb, exp);
+    cbor_int(cb, neg ? -(int64_t)m : (int64_t)m);
+    return 1;
+}
+
+/*! Append leaf or leaf-list value typed according to YANG
+ *
+ * Values that do not parse as their YANG type are written as text strings
+ * @param[in]  cb    CBOR buffer
+ * @param[in]  x     XML leaf or leaf-list element
+ * @param[in]  y     Yang spec of x, or NULL
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+cbor_encode_leaf(cbuf      *cb,
+                 cxobj     *x,
+                 yang_stmt *y)
+{
+    int                retval = -1;
+    char              *body;
+    yang_stmt         *ytype = NULL;
+    char              *restype = NULL;
+    char              *end = NULL;
+    long long          ll;
+    unsigned long long ull;
+    cbuf              *cbid = NULL;
+
+    body = xml_body(x);
+    if (y == NULL ||
+        (yang_keyword_get(y) != Y_LEAF && yang_keyword_get(y) != Y_LEAF_LIST)){
+        if (body)
+            cbor_text(cb, body, strlen(body));
+        else
+            cbuf_append(cb, CBOR_NULL);
+        goto ok;
+    }
+    if (yang_type_get(y, NULL, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+        goto done;
+    restype = ytype?yang_argument_get(ytype):NULL;
+    if (body == NULL){
+        if (restype && strcmp(restype, "empty") == 0)
+            cbuf_append(cb, CBOR_NULL);
+        else
+            cbor_text(cb, "", 0);
+        goto ok;
+    }
+    switch (yang_type2cv(y)){
+    case CGV_INT8:
+    case CGV_INT16:
+    case CGV_INT32:
+    case CGV_INT64:
+        errno = 0;
+        ll = strtoll(body, &end, 10);
+        if (errno == 0 && end != body && *end == '\0'){
+            cbor_int(cb, ll);
+            goto ok;
+        }
+        break;
+    case CGV_UINT8:
+    case CGV_UINT16:
+    case CGV_UINT32:
+    case CGV_UINT64:
+        errno = 0;
+        if (*body != '-'){
+            ull = strtoull(body, &end, 10);
+            if (errno == 0 && end != body && *end == '\0'){
+                cbor_head(cb, CBOR_UINT, ull);
+                goto ok;
+            }
+        }
+        break;
+    case CGV_DEC64:
+        if (cbor_decimal(cb, body))
+            goto ok;
+        break;
+    case CGV_BOOL:
+        if (strcmp(body, "true") == 0){
+            cbuf_append(cb, CBOR_TRUE);
+            goto ok;
+        }
+        if (strcmp(body, "false") == 0){
+            cbuf_append(cb, CBOR_FALSE);
+            goto ok;
+        }
+        break;
+    default:
+        if (restype == NULL)
+            break;
+        if (strcmp(restype, "identityref") == 0){
+            if ((cbid = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            if (xml2json_encode_identityref(x, body, y, cbid) < 0)
+                goto done;
+            cbor_text(cb, cbuf_get(cbid), cbuf_len(cbid));
+            goto ok;
+        }
+        if (strcmp(restype, "enumeration") == 0)
+            cbor_head(cb, CBOR_TAG, CBOR_TAG_ENUM);
+        else if (strcmp(restype, "bits") == 0)
+            cbor_head(cb, CBOR_TAG, CBOR_TAG_BITS);
+        break;
+    }
+    cbor_text(cb, body, strlen(body));
+ ok:
+    retval = 0;
+ done:
+    if (cbid)
+        cbuf_free(cbid);
+    return retval;
+}
+
+static int cbor_encode_members(cbuf *cb, cxobj *xp, cxobj **vec, size_t len, char *modname0, int system_only);
+
+/*! Append value of an XML element: map of children, or leaf value
+ *
+ * @param[in]  cb          CBOR buffer
+ * @param[in]  x           XML element
+ * @param[in]  modname0    Module name of x, or of closest ancestor with yang
+ * @param[in]  system_only Enable checks for system-only-config extension
+ * @retval     0           OK
+ * @retval    -1           Error
+ */
+static int
+cbor_encode_value(cbuf  *cb,
+                  cxobj *x,
+                  char  *modname0,
+                  int    system_only)
+{
+    yang_stmt    *y;
+    enum rfc_6020 keyword = Y_LEAF;
+
+    if (xml_sort_ensure(x) < 0) /* Array grouping assumes siblings are sorted */
+        return -1;
+    if (xml_child_nr_type(x, CX_ELMNT) > 0)
+        return cbor_encode_members(cb, x, NULL, xml_child_nr(x), modname0, system_only);
+    if ((y = xml_spec(x)) != NULL)
+        keyword = yang_keyword_get(y);
+    if (keyword == Y_CONTAINER || keyword == Y_LIST){
+        cbor_head(cb, CBOR_MAP, 0);
+        return 0;
+    }
+    return cbor_encode_leaf(cb, x, y);
+}
+
+/*! Get member i, from vec if given, otherwise child i of xp
+ *
+ * Children are read with xml_child_i, not xml_childvec_get which modifies xp
+ */
+static inline cxobj *
+cbor_member(cxobj  *xp,
+            cxobj **vec,
+            size_t  i)
+{
+    return vec ? vec[i] : xml_child_i(xp, i);
+}
+
+/*! Return index after the last member that is in the same array as member i
+ *
+ * Same as in JSON: adjacent elements with same name and namespace
+ */
+static size_t
+cbor_array_end(cxobj  *xp,
+               cxobj **vec,
+               size_t  len,
+               size_t  i)
+{
+    cxobj *x = cbor_member(xp, vec, i);
+    cxobj *xn;
+    char  *ns;
+    char  *ns2;
+    size_t j;
+
+    ns = xml_find_type_value(x, NULL, "xmlns", CX_ATTR);
+    for (j=i+1; j<len; j++){
+        xn = cbor_member(xp, vec, j);
+        if (xml_type(xn) != CX_ELMNT ||
+            (xml_name(xn) != xml_name(x) && strcmp(xml_name(xn), xml_name(x)) != 0))
+            break;
+        ns2 = xml_find_type_value(xn, NULL, "xmlns", CX_ATTR);
+        if ((ns == NULL) != (ns2 == NULL) ||
+            (ns && strcmp(ns, ns2) != 0))
+            break;
+    }
+    return j;
+}
+
+/*! Append a map of the elements in a vector or of the children of a parent, with lists and leaf-lists as arrays
+ *
+ * Attributes and bodies are skipped.
+ * The map has definite length, so members are counted in a first pass
+ * @param[in]  cb          CBOR buffer
+ * @param[in]  xp          Parent whose children are members, if vec is NULL
+ * @param[in]  vec         Vector of XML nodes, or NULL
+ * @param[in]  len         Length of vec, or number of children of xp
+ * @param[in]  modname0    Module name of parent, NULL at top
+ * @param[in]  system_only Enable checks for system-only-config extension
+ * @retval     0           OK
+ * @retval    -1           Error
+ */
+static int
+cbor_encode_members(cbuf    *cb,
+                    cxobj   *xp,
+                    cxobj  **vec,
+                    size_t   len,
+                    char    *modname0,
+                    int      system_only)
+{
+    int           retval = -1;
+    int           pass;
+    size_t        n = 0;
+    size_t        i;
+    size_t        j;
+    size_t        k;
+    cxobj        *x;
+    yang_stmt    *y;
+    yang_stmt    *ymod;
+    enum rfc_6020 keyword;
+    char         *modname;
+    int           exist;
+
+    for (pass=0; pass<2; pass++){
+        if (pass == 1)
+            cbor_head(cb, CBOR_MAP, n);
+        for (i=0; i<len; i=j){
+            x = cbor_member(xp, vec, i);
+            if (xml_type(x) != CX_ELMNT){
+                j = i+1;
+                continue;
+            }
+            j = cbor_array_end(xp, vec, len, i);
+            exist = 0;
+            if ((y = xml_spec(x)) != NULL && system_only){
+                if (yang_extension_value(y, "system-only-config", CLIXON_LIB_NS, &exist, NULL) < 0)
+                    goto done;
+                if (exist)
+                    continue;
+            }
+            if (pass == 0){
+                n++;
+                continue;
+            }
+            modname = NULL;
+            keyword = Y_LEAF;
+            if (y != NULL){
+                keyword = yang_keyword_get(y);
+                if (ys_real_module(y, &ymod) < 0)
+                    goto done;
+                modname = yang_argument_get(ymod);
+                /* Same ietf-netconf -> ietf-restconf translation as in JSON */
+                if (strcmp(modname, "ietf-netconf") == 0)
+                    modname = "ietf-restconf";
+            }
+            if (modname && modname0 && strcmp(modname, modname0) == 0)
+                cbor_name(cb, NULL, xml_name(x));
+            else
+                cbor_name(cb, modname, xml_name(x));
+            if (modname == NULL)
+                modname = modname0;
+            if (j - i > 1 || keyword == Y_LIST || keyword == Y_LEAF_LIST)
+                cbor_head(cb, CBOR_ARRAY, j - i);
+            for (k=i; k<j; k++)
+                if (cbor_encode_value(cb, cbor_member(xp, vec, k), modname, system_only) < 0)
+                    goto done;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Translate an XML tree to YANG-CBOR in a CLIgen buffer
+ *
+ * @param[in,out] cb          Cligen buffer to append to, binary data with cbuf_len length
+ * @param[in]     xt          XML tree to translate from, yang bound for typed values
+ * @param[in]     skiptop     0: Map with xt as member 1: Map with children of xt as members
+ * @param[in]     system_only Enable checks for system-only-config extension
+ * @retval        0           OK
+ * @retval       -1           Error
+ * @note XML attributes are not encoded, eg no metadata as in RFC 7952
+ * @see clixon_json2cbuf
+ */
+int
+clixon_cbor2cbuf(cbuf  *cb,
+                 cxobj *xt,
+                 int    skiptop,
+                 int    system_only)
+{
+    if (skiptop){
+        if (xml_sort_ensure(xt) < 0)
+            return -1;
+        return cbor_encode_members(cb, xt, NULL, xml_child_nr(xt), NULL, system_only);
+    }
+    return cbor_encode_members(cb, NULL, &xt, 1, NULL, system_only);
+}
+
+/*! Translate a vector of XML objects to a YANG-CBOR map in a CLIgen buffer
+ *
+ * @param[in,out] cb     Cligen buffer to append to
+ * @param[in]     vec    Vector of XML objects, eg result of xpath_vec
+ * @param[in]     veclen Length of vector
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @see xml2json_cbuf_vec
+ */
+int
+clixon_cbor2cbuf_vec(cbuf   *cb,
+                     cxobj **vec,
+                     size_t  veclen)
+{
+    return cbor_encode_members(cb, NULL, vec, veclen, NULL, 0);
+}
+
+/*! Translate an XML tree to YANG-CBOR and write to file
+ *
+ * @param[in]  f           File to write to
+ * @param[in]  xt          XML tree to translate from
+ * @param[in]  skiptop     0: Include top object 1: Skip top-object, only children
+ * @param[in]  system_only Enable checks for system-only-config extension
+ * @retval     0           OK
+ * @retval    -1           Error
+ * @see clixon_json2file
+ */
+int
+clixon_cbor2file(FILE  *f,
+                 cxobj *xt,
+                 int    skiptop,
+                 int    system_only)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_cbor2cbuf(cb, xt, skiptop, system_only) < 0)
+        goto done;
+    if (fwrite(cbuf_get(cb), 1, cbuf_len(cb), f) != cbuf_len(cb)){
+        clixon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*------------------------------------------------------------------------
+ * Decoding
+ *------------------------------------------------------------------------*/
+
+/*! CBOR decoder state
+ */
+struct cbor_dec {
+    const uint8_t *cd_buf; /* Input buffer */
+    size_t         cd_len; /* Length of input */
+    size_t         cd_i;   /* Current offset */
+};
+
+/*! Read a CBOR head
+ *
+ * @param[in]  cd     Decoder state
+ * @param[out] major  Major type
+ * @param[out] ai     Additional information, CBOR_AI_INDEF for indefinite length
+ * @param[out] val    Argument
+ * @retval     0      OK
+ * @retval    -1      Error, malformed
+ */
+static int
+cbor_dec_head(struct cbor_dec *cd,
+              int             *major,
+              int             *ai,
+              uint64_t        *val)
+{
+    uint8_t b;
+    int     n;
+    int     i;
+
+    if (cd->cd_i >= cd->cd_len){
+        clixon_err(OE_JSON, 0, "CBOR: unexpected end of data");
+        return -1;
+    }
+    b = cd->cd_buf[cd->cd_i++];
+    *major = b >> 5;
+    *ai = b & 0x1f;
+    *val = 0;
+    if (*ai < 24)
+        *val = *ai;
+    else if (*ai <= 27){
+        n = 1 << (*ai - 24);
+        if (cd->cd_len - cd->cd_i < (size_t)n){
+            clixon_err(OE_JSON, 0, "CBOR: unexpected end of data");
+            return -1;
+        }
+        for (i=0; i<n; i++)
+            *val = (*val << 8) | cd->cd_buf[cd->cd_i++];
+    }
+    else if (*ai != CBOR_AI_INDEF ||
+             *major == CBOR_UINT || *major == CBOR_NEGINT || *major == CBOR_TAG){
+        clixon_err(OE_JSON, 0, "CBOR: malformed head 0x%02x at offset %zu", b, cd->cd_i - 1);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Check for and consume a break stop code of an indefinite length item
+ */
+static int
+cbor_dec_break(struct cbor_dec *cd)
+{
+    if (cd->cd_i < cd->cd_len && cd->cd_buf[cd->cd_i] == CBOR_BREAK){
+        cd->cd_i++;
+        return 1;
+    }
+    return 0;
+}
+
+/*! Read a byte or text string
+ *
+ * Definite length strings are returned in place. Indefinite length strings are
+ * concatenated into a temporary buffer
+ * @param[in]  cd     Decoder state
+ * @param[in]  major  Major type, CBOR_BYTES or CBOR_TEXT
+ * @param[in]  ai     Additional information of head
+ * @param[in]  val    Argument of head
+ * @param[out] cbtmp  Temporary buffer, created if needed, free after use
+ * @param[out] sp     String, not NUL-terminated
+ * @param[out] lenp   Length of string
+ * @retval     0      OK
+ * @retval    -1      Error, malformed
+ */
+static int
+cbor_dec_string(struct cbor_dec *cd,
+                int              major,
+                int              ai,
+                uint64_t         val,
+                cbuf           **cbtmp,
+                const uint8_t  **sp,
+                size_t          *lenp)
+{
+    int      major1;
+    int      ai1;
+    uint64_t len1;
+
+    if (ai != CBOR_AI_INDEF){
+        if (cd->cd_len - cd->cd_i < val){
+            clixon_err(OE_JSON, 0, "CBOR: unexpected end of data");
+            return -1;
+        }
+        *sp = cd->cd_buf + cd->cd_i;
+        *lenp = val;
+        cd->cd_i += val;
+        return 0;
+    }
+    if (*cbtmp == NULL && (*cbtmp = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        return -1;
+    }
+    while (!cbor_dec_break(cd)){
+        if (cbor_dec_head(cd, &major1, &ai1, &len1) < 0)
+            return -1;
+        if (major1 != major || ai1 == CBOR_AI_INDEF || cd->cd_len - cd->cd_i < len1){
+            clixon_err(OE_JSON, 0, "CBOR: malformed string chunk at offset %zu", cd->cd_i);
+            return -1;
+        }
+        cbuf_append_buf(*cbtmp, (void *)(cd->cd_buf + cd->cd_i), len1);
+        cd->cd_i += len1;
+    }
+    *sp = (const uint8_t *)cbuf_get(*cbtmp);
+    *lenp = cbuf_len(*cbtmp);
+    return 0;
+}
+
+/*! Append a string as quoted and escaped JSON string
+ */
+static void
+cbor_json_str(cbuf          *cbj,
+              const uint8_t *s,
+              size_t         len)
+{
+    size_t i;
+    size_t i0 = 0;
+
+    cbuf_append(cbj, '"');
+    for (i=0; i<len; i++){
+        if (s[i] != '"' && s[i] != '\\' && s[i] >= 0x20)
+            continue;
+        if (i > i0)
+            cbuf_append_buf(cbj, (void *)(s + i0), i - i0);
+        switch (s[i]){
+        case '"':
+            cbuf_append_str(cbj, "\\\"");
+            break;
+        case '\\':
+            cbuf_append_str(cbj, "\\\\");
+            break;
+        case '\n':
+            cbuf_append_str(cbj, "\\n");
+            break;
+        case '\t':
+            cbuf_append_str(cbj, "\\t");
+            break;
+        case '\r':
+            cbuf_append_str(cbj, "\\r");
+            break;
+        default:
+            cprintf(cbj, "\\u%04x", s[i]);
+            break;
+        }
+        i0 = i + 1;
+    }
+    if (i > i0)
+        cbuf_append_buf(cbj, (void *)(s + i0), i - i0);
+    cbuf_append(cbj, '"');
+}
+
+/*! Append a byte string as base64 encoded JSON string, as YANG binary in RFC 7951
+ */
+static void
+cbor_json_base64(cbuf          *cbj,
+                 const uint8_t *s,
+                 size_t         len)
+{
+    static const char b64[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t   i;
+    uint32_t v;
+
+    cbuf_append(cbj, '"');
+    for (i=0; i+2<len; i+=3){
+        v = (s[i] << 16) | (s[i+1] << 8) | s[i+2];
+        cbuf_append(cbj, b64[(v >> 18) & 0x3f]);
+        cbuf_append(cbj, b64[(v >> 12) & 0x3f]);
+        cbuf_append(cbj, b64[(v >> 6) & 0x3f]);
+        cbuf_append(cbj, b64[v & 0x3f]);
+    }
+    if (i < len){
+        v = s[i] << 16;
+        if (i+1 < len)
+            v |= s[i+1] << 8;
+        cbuf_append(cbj, b64[(v >> 18) & 0x3f]);
+        cbuf_append(cbj, b64[(v >> 12) & 0x3f]);
+        cbuf_append(cbj, i+1 < len ? b64[(v >> 6) & 0x3f] : '=');
+        cbuf_append(cbj, '=');
+    }
+    cbuf_append(cbj, '"');
+}
+
+/*! Read a CBOR integer that fits in int64
+ */
+static int
+cbor_dec_int(struct cbor_dec *cd,
+             int64_t         *v)
+{
+    int      major;
+    int      ai;
+    uint64_t val;
+
+    if (cbor_dec_head(cd, &major, &ai, &val) < 0)
+        return -1;
+    if ((major != CBOR_UINT && major != CBOR_NEGINT) || val > INT64_MAX){
+        clixon_err(OE_JSON, 0, "CBOR: expected integer at offset %zu", cd->cd_i);
+        return -1;
+    }
+    *v = (major == CBOR_UINT) ? (int64_t)val : -1 - (int64_t)val;
+    return 0;
+}
+
+/*! Translate decimal fraction, tag 4 [exponent, mantissa], to JSON string, eg "-12.345"
+ */
+static int
+cbor_json_decimal(struct cbor_dec *cd,
+                  cbuf            *cbj)
+{
+    int      major;
+    int      ai;
+    uint64_t val;
+    int64_t  exp;
+    int64_t  m;
+    char     digits[24];
+    int      n;
+    int      point;
+
+    if (cbor_dec_head(cd, &major, &ai, &val) < 0)
+        return -1;
+    if (major != CBOR_ARRAY || val != 2){
+        clixon_err(OE_JSON, 0, "CBOR: malformed decimal fraction at offset %zu", cd->cd_i);
+        return -1;
+    }
+    if (cbor_dec_int(cd, &exp) < 0 ||
+        cbor_dec_int(cd, &m) < 0)
+        return -1;
+    if (exp < -18 || exp > 18){
+        clixon_err(OE_JSON, 0, "CBOR: decimal exponent %" PRId64 " out of range", exp);
+        return -1;
+    }
+    n = snprintf(digits, sizeof(digits), "%" PRIu64, m < 0 ? -(uint64_t)m : (uint64_t)m);
+    cbuf_append(cbj, '"');
+    if (m < 0)
+        cbuf_append(cbj, '-');
+    if (exp >= 0){
+        cbuf_append_str(cbj, digits);
+        for (; exp > 0; exp--)
+            cbuf_append(cbj, '0');
+    }
+    else if ((point = n + (int)exp) <= 0){
+        cbuf_append_str(cbj, "0.");
+        for (; point < 0; point++)
+            cbuf_append(cbj, '0');
+        cbuf_append_str(cbj, digits);
+    }
+    else {
+        cbuf_append_buf(cbj, digits, point);
+        cbuf_append(cbj, '.');
+        cbuf_append_str(cbj, digits + point);
+    }
+    cbuf_append(cbj, '"');
+    return 0;
+}
+
+/*! Translate one CBOR data item to JSON
+ *
+ * @param[in]  cd     Decoder state
+ * @param[out] cbj    JSON text buffer
+ * @param[in]  depth  Nesting depth
+ * @retval     0      OK
+ * @retval    -1      Error, malformed or not YANG-CBOR name-based
+ */
+static int
+cbor2json_item(struct cbor_dec *cd,
+               cbuf            *cbj,
+               int              depth)
+{
+    int            retval = -1;
+    int            major;
+    int            ai;
+    uint64_t       val;
+    uint64_t       k;
+    int            kmajor;
+    int            kai;
+    uint64_t       kval;
+    const uint8_t *s;
+    size_t         len;
+    cbuf          *cbtmp = NULL;
+
+    if (depth > CBOR_DEPTH_MAX){
+        clixon_err(OE_JSON, 0, "CBOR: nesting deeper than %d", CBOR_DEPTH_MAX);
+        goto done;
+    }
+    if (cbor_dec_head(cd, &major, &ai, &val) < 0)
+        goto done;
+    switch (major){
+    case CBOR_UINT:
+        cprintf(cbj, "%" PRIu64, val);
+        break;
+    case CBOR_NEGINT:
+        if (val == UINT64_MAX)
+            cbuf_append_str(cbj, "-18446744073709551616");
+        else
+            cprintf(cbj, "-%" PRIu64, val + 1);
+        break;
+    case CBOR_BYTES:
+        if (cbor_dec_string(cd, major, ai, val, &cbtmp, &s, &len) < 0)
+            goto done;
+        cbor_json_base64(cbj, s, len);
+        break;
+    case CBOR_TEXT:
+        if (cbor_dec_string(cd, major, ai, val, &cbtmp, &s, &len) < 0)
+            goto done;
+        cbor_json_str(cbj, s, len);
+        break;
+    case CBOR_ARRAY:
+        cbuf_append(cbj, '[');
+        for (k=0; ai == CBOR_AI_INDEF ? !cbor_dec_break(cd) : k < val; k++){
+            if (k)
+                cbuf_append(cbj, ',');
+            if (cbor2json_item(cd, cbj, depth+1) < 0)
+                goto done;
+        }
+        cbuf_append(cbj, ']');
+        break;
+    case CBOR_MAP:
+        cbuf_append(cbj, '{');
+        for (k=0; ai == CBOR_AI_INDEF ? !cbor_dec_break(cd) : k < val; k++){
+            if (k)
+                cbuf_append(cbj, ',');
+            if (cbor_dec_head(cd, &kmajor, &kai, &kval) < 0)
+                goto done;
+            if (kmajor != CBOR_TEXT){
+                clixon_err(OE_JSON, 0, "CBOR: map key at offset %zu is not a text string, only name-based YANG-CBOR is supported", cd->cd_i);
+                goto done;
+            }
+            if (cbtmp)
+                cbuf_reset(cbtmp);
+            if (cbor_dec_string(cd, kmajor, kai, kval, &cbtmp, &s, &len) < 0)
+                goto done;
+            cbor_json_str(cbj, s, len);
+            cbuf_append(cbj, ':');
+            if (cbor2json_item(cd, cbj, depth+1) < 0)
+                goto done;
+        }
+        cbuf_append(cbj, '}');
+        break;
+    case CBOR_TAG:
+        switch (val){
+        case CBOR_TAG_DECIMAL:
+            if (cbor_json_decimal(cd, cbj) < 0)
+                goto done;
+            break;
+        case CBOR_TAG_IDENTITY:
+        case CBOR_TAG_INSTANCE:
+        case CBOR_TAG_SID:
+            clixon_err(OE_JSON, 0, "CBOR: SID tag %" PRIu64 " not supported", val);
+            goto done;
+            break;
+        default: /* Bits, enumeration as text, and other tags: use content */
+            if (cbor2json_item(cd, cbj, depth+1) < 0)
+                goto done;
+            break;
+        }
+        break;
+    case CBOR_SIMPLE:
+        switch (ai){
+        case 20:
+            cbuf_append_str(cbj, "false");
+            break;
+        case 21:
+            cbuf_append_str(cbj, "true");
+            break;
+        case 22: /* null */
+        case 23: /* undefined */
+            cbuf_append_str(cbj, "null");
+            break;
+        default:
+            clixon_err(OE_JSON, 0, "CBOR: unsupported simple or float value at offset %zu", cd->cd_i);
+            goto done;
+        }
+        break;
+    }
+    retval = 0;
+ done:
+    if (cbtmp)
+        cbuf_free(cbtmp);
+    return retval;
+}
+
+/*! Translate YANG-CBOR to JSON text, RFC 9254 to RFC 7951
+ *
+ * @param[in]  buf   CBOR data, one data item
+ * @param[in]  len   Length of buf, 0 gives empty JSON text
+ * @param[out] cbj   JSON text buffer to append to
+ * @retval     0     OK
+ * @retval    -1     Error, malformed or not YANG-CBOR name-based
+ */
+int
+clixon_cbor2json(const char *buf,
+                 size_t      len,
+                 cbuf       *cbj)
+{
+    struct cbor_dec cd = {(const uint8_t *)buf, len, 0};
+
+    if (len == 0)
+        return 0;
+    if (cbor2json_item(&cd, cbj, 0) < 0)
+        return -1;
+    if (cd.cd_i != len){
+        clixon_err(OE_JSON, 0, "CBOR: trailing data at offset %zu", cd.cd_i);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Parse a buffer containing YANG-CBOR and return an XML tree
+ *
+ * @param[in]     h     Clixon handle, or NULL
+ * @param[in]     buf   CBOR data
+ * @param[in]     len   Length of buf
+ * @param[in]     yb    How to bind yang to XML top-level when parsing
+ * @param[in]     yspec Yang specification
+ * @param[in,out] xt    Top object, if not exists, on success it is created with name 'top'
+ * @param[out]    xerr  Reason for invalid returned as netconf err msg
+ * @retval        1     OK and valid
+ * @retval        0     Invalid (only if yang spec) w xerr set
+ * @retval       -1     Error, including malformed CBOR
+ * @see clixon_json_parse_string
+ */
+int
+clixon_cbor_parse_buf(clixon_handle h,
+                      const char   *buf,
+                      size_t        len,
+                      yang_bind     yb,
+                      yang_stmt    *yspec,
+                      cxobj       **xt,
+                      cxobj       **xerr)
+{
+    int   retval = -1;
+    cbuf *cbj = NULL;
+
+    if (xt == NULL){
+        clixon_err(OE_JSON, EINVAL, "xt is NULL");
+        goto done;
+    }
+    if ((cbj = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_cbor2json(buf, len, cbj) < 0)
+        goto done;
+    if (cbuf_len(cbj) == 0){
+        if (*xt == NULL && (*xt = xml_new("top", NULL, CX_ELMNT)) == NULL)
+            goto done;
+        retval = 1;
+        goto done;
+    }
+    retval = clixon_json_parse_string(h, cbuf_get(cbj), 1, yb, yspec, xt, xerr);
+ done:
+    if (cbj)
+        cbuf_free(cbj);
+    return retval;
+}
+
+/*! Read a YANG-CBOR file and parse it into an XML tree
+ *
+ * @param[in]     fp    Open file
+ * @param[in]     yb    How to bind yang to XML top-level when parsing
+ * @param[in]     yspec Yang specification, or NULL
+ * @param[in,out] xt    Pointer to (XML) parse tree. If empty, create.
+ * @param[out]    xerr  Reason for invalid returned as netconf err msg
+ * @retval        1     OK and valid
+ * @retval        0     Invalid (only if yang spec) w xerr set
+ * @retval       -1     Error
+ * @note May block on file I/O
+ * @see clixon_json_parse_file
+ */
+int
+clixon_cbor_parse_file(FILE      *fp,
+                       yang_bind  yb,
+                       yang_stmt *yspec,
+                       cxobj    **xt,
+                       cxobj    **xerr)
+{
+    int    retval = -1;
+    char  *buf = NULL;
+    size_t len = 0;
+
+    if (clicon_file_read(fp, &buf, &len) < 0)
+        goto done;
+    retval = clixon_cbor_parse_buf(NULL, buf, len, yb, yspec, xt, xerr);
+ done:
+    if (buf)
+        free(buf);
+    return retval;
+}
@@ -60,6 +60,7 @@
 #include "clixon_log.h"
 #include "clixon_debug.h"
 #include "clixon_options.h"
+#include "clixon_event.h"
 #include "clixon_proc.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_netconf_lib.h"
@@ -92,6 +93,9 @@ struct clixon_client_handle{
     char              *cch_descr;  /* Description of socket / peer for logging  XXX NYI */
     int                cch_pid;    /* Sub-process-id Only applies for NETCONF/SSH */
     int                cch_locked; /* State variable: 1 means locked */
+    cxobj             *cch_xdata;  /* Data of last get, owns values returned by getters */
+    clicon_hash_t     *cch_cache;  /* Read-through cache of values by namespace and xpath */
+    int                cch_notify; /* On-change subscription socket invalidating cache, or -1 */
 };
 
 /*! Check struct magic number for sanity checks
@@ -307,6 +311,7 @@ clixon_client_connect(clixon_handle      h,
     cch->cch_magic   = CLIXON_CLIENT_MAGIC;
     cch->cch_type = socktype;
     cch->cch_h = h;
+    cch->cch_notify = -1;
     switch (socktype){
     case CLIXON_CLIENT_IPC:
         if (clixon_rpc_connect(h, &cch->cch_socket) < 0)
@@ -358,7 +363,10 @@ clixon_client_disconnect(clixon_client_handle ch)
     /* unlock (if locked) */
     if (cch->cch_locked)
         ;//     (void)clixon_client_lock(cch->cch_socket, 0, "running");
-
+    if (clixon_client_cache(cch, 0) < 0)
+        goto done;
+    if (cch->cch_xdata)
+        xml_free(cch->cch_xdata);
     switch(cch->cch_type){
     case CLIXON_CLIENT_IPC:
         close(cch->cch_socket);
@@ -410,11 +418,56 @@ clixon_xml_bottom(cxobj  *xtop,
     return retval;
 }
 
+/*! Send a message to the backend and receive the reply, reconnect if session is closed
+ *
+ * The session is kept open between calls. If the backend has closed it, eg after a
+ * restart, an IPC session is reconnected once and the message is sent again.
+ * @param[in]  cch     Clixon client handle
+ * @param[in]  msg     Message to send
+ * @param[out] msgret  Reply message, free with cbuf_free
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+clixon_client_rpc(struct clixon_client_handle *cch,
+                  cbuf                        *msg,
+                  cbuf                       **msgret)
+{
+    int retval = -1;
+    int eof = 0;
+    int retry;
+
+    for (retry = 0; ; retry++){
+        if (clixon_msg_send10(cch->cch_socket, cch->cch_descr, msg) < 0)
+            goto done;
+        if (clixon_msg_rcv10(cch->cch_socket, cch->cch_descr, msgret, &eof) < 0)
+            goto done;
+        if (!eof)
+            break;
+        close(cch->cch_socket);
+        cch->cch_socket = -1;
+        if (cch->cch_type != CLIXON_CLIENT_IPC || retry > 0){
+            clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+            goto done;
+        }
+        clixon_debug(CLIXON_DBG_DEFAULT, "Session closed, reconnect");
+        if (*msgret){
+            cbuf_free(*msgret);
+            *msgret = NULL;
+        }
+        if (clixon_rpc_connect(cch->cch_h, &cch->cch_socket) < 0)
+            goto done;
+        if (clixon_client_hello(cch->cch_socket, cch->cch_descr, 0) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Internal function to construct a get-config and query a value from the backend
  *
- * @param[in]  h         Clixon handle
- * @param[in]  sock      Socket
- * @param[in]  descr     Description of peer for logging
+ * @param[in]  cch       Clixon client handle
  * @param[in]  namespace Default namespace used for non-prefixed entries in xpath. (Alt use nsc)
  * @param[in]  xpath     XPath
  * @param[out] xdata     XML data tree (may or may not include the intended data)
@@ -423,12 +476,10 @@ clixon_xml_bottom(cxobj  *xtop,
  * @note configurable netconf framing type, now hardwired to 0
  */
 static int
-clixon_client_get_xdata(clixon_handle h,
-                        int         sock,
-                        const char *descr,
-                        const char *namespace,
-                        const char *xpath,
-                        cxobj     **xdata)
+clixon_client_get_xdata(struct clixon_client_handle *cch,
+                        const char                  *namespace,
+                        const char                  *xpath,
+                        cxobj                      **xdata)
 {
     int          retval = -1;
     cxobj       *xret = NULL;
@@ -437,7 +488,6 @@ clixon_client_get_xdata(clixon_handle h,
     cbuf        *msgret = NULL;
     const char  *db = "running";
     cvec        *nsc = NULL;
-    int          eof = 0;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
     if ((msg = cbuf_new()) == NULL){
@@ -461,20 +511,13 @@ clixon_client_get_xdata(clixon_handle h,
         cprintf(msg, "/>");
     }
     cprintf(msg, "</get-config></rpc>");
-    if (clixon_msg_send10(sock, descr, msg) < 0)
-        goto done;
-    if (clixon_msg_rcv10(sock, descr, &msgret, &eof) < 0)
+    if (clixon_client_rpc(cch, msg, &msgret) < 0)
         goto done;
-    if (eof){
-        close(sock);
-        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
-        goto done;
-    }
     if (clixon_xml_parse_string(cbuf_get(msgret), YB_NONE, NULL, &xret, NULL) < 0)
         goto done;
     if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL){
         xd = xml_parent(xd); /* point to rpc-reply */
-        clixon_err_netconf(h, OE_NETCONF, 0, xd, "Get configuration");
+        clixon_err_netconf(cch->cch_h, OE_NETCONF, 0, xd, "Get configuration");
         goto done; /* Not fatal */
     }
     else if ((xd = xpath_first(xret, NULL, "/rpc-reply/data")) == NULL){
@@ -498,36 +541,101 @@ clixon_client_get_xdata(clixon_handle h,
     return retval;
 }
 
+/*! Invalidate the read-through cache if the on-change stream has notified any changes
+ *
+ * Pending notifications are read and discarded, their content is not examined.
+ * If the subscription is closed, the cache is disabled.
+ * @param[in]  cch     Clixon client handle
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+clixon_client_cache_check(struct clixon_client_handle *cch)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    int   eof = 0;
+    int   changed = 0;
+    int   ret;
+
+    if (cch->cch_cache == NULL)
+        goto ok;
+    while ((ret = clixon_event_poll(cch->cch_notify)) > 0){
+        if (clixon_msg_rcv11(cch->cch_notify, NULL, 0, &cb, &eof) < 0)
+            goto done;
+        if (cb){
+            cbuf_free(cb);
+            cb = NULL;
+        }
+        if (eof){
+            clixon_log(cch->cch_h, LOG_WARNING, "%s: on-change subscription closed, cache disabled", __func__);
+            if (clixon_client_cache(cch, 0) < 0)
+                goto done;
+            goto ok;
+        }
+        changed++;
+    }
+    if (ret < 0)
+        goto done;
+    if (changed){
+        clicon_hash_free(cch->cch_cache);
+        if ((cch->cch_cache = clicon_hash_init()) == NULL)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Generic get value of body
  *
- * @param[in]  h         Clixon handle
- * @param[in]  sock      Open socket
- * @param[in]  descr     Description of peer for logging
+ * @param[in]  cch       Clixon client handle
  * @param[in]  namespace Default namespace used for non-prefixed entries in xpath.
  * @param[in]  xpath     XPath
- * @param[out] val       Output value
+ * @param[out] val       Output value, valid until next call using the handle
  * @retval     0         OK
  * @retval    -1         Error
  */
 static int
-clixon_client_get_body_val(clixon_handle h,
-                           int         sock,
-                           const char *descr,
-                           const char *namespace,
-                           const char *xpath,
-                           char      **val)
+clixon_client_get_body_val(struct clixon_client_handle *cch,
+                           const char                  *namespace,
+                           const char                  *xpath,
+                           char                       **val)
 {
     int    retval = -1;
-    cxobj *xdata = NULL;
+    cxobj *xdata;
     cxobj *xobj = NULL;
+    cbuf  *key = NULL;
+    char  *v;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
     if (val == NULL){
         clixon_err(OE_XML, EINVAL, "Expected val");
         goto done;
     }
-    if (clixon_client_get_xdata(h, sock, descr, namespace, xpath, &xdata) < 0)
+    if (clixon_client_cache_check(cch) < 0)
+        goto done;
+    if (cch->cch_cache){
+        if ((key = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(key, "%s %s", namespace?namespace:"", xpath);
+        if ((v = clicon_hash_value(cch->cch_cache, cbuf_get(key), NULL)) != NULL){
+            *val = v;
+            goto ok;
+        }
+    }
+    if (cch->cch_xdata){
+        xml_free(cch->cch_xdata);
+        cch->cch_xdata = NULL;
+    }
+    if (clixon_client_get_xdata(cch, namespace, xpath, &cch->cch_xdata) < 0)
         goto done;
+    xdata = cch->cch_xdata;
     if (xdata == NULL){
         clixon_err(OE_XML, EINVAL, "No xml obj found");
         goto done;
@@ -544,9 +652,124 @@ clixon_client_get_body_val(clixon_handle h,
         goto done;
     }
     *val = xml_body(xobj);
+    if (key && *val &&
+        clicon_hash_add(cch->cch_cache, cbuf_get(key), *val, strlen(*val)+1) == NULL)
+        goto done;
+ ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_DEFAULT, "retval:%d", retval);
+    if (key)
+        cbuf_free(key);
+    return retval;
+}
+
+/*! Client-api get values of several xpaths in one request
+ *
+ * The xpaths are sent as one union filter of a single get-config, and each value is then
+ * looked up in the reply. Values in the read-through cache are not requested.
+ * @param[in]  ch        Clixon client handle
+ * @param[out] rvals     Vector of n values, malloced strings or NULL if not found. Free with free
+ * @param[in]  n         Number of xpaths
+ * @param[in]  namespace Default namespace used for non-prefixed entries in xpaths
+ * @param[in]  xpaths    Vector of n xpaths of leafs
+ * @retval     0         OK
+ * @retval    -1         Error, rvals are NULL
+ * @code
+ *    const char *xpaths[] = {"/table/parameter[name='a']/value", "/table/parameter[name='b']/value"};
+ *    char       *vals[2];
+ *
+ *    if (clixon_client_get_multi(ch, vals, 2, "urn:example:clixon-client", xpaths) < 0)
+ *       err;
+ * @endcode
+ */
+int
+clixon_client_get_multi(clixon_client_handle ch,
+                        char               **rvals,
+                        int                  n,
+                        const char          *namespace,
+                        const char         **xpaths)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    cxobj                       *xdata = NULL;
+    cxobj                       *x;
+    cbuf                        *key = NULL;
+    cbuf                        *cbx = NULL;
+    cvec                        *nsc = NULL;
+    char                        *v;
+    int                          miss = 0;
+    int                          i;
+
+    clixon_debug(CLIXON_DBG_DEFAULT, "");
+    if (rvals == NULL || xpaths == NULL){
+        clixon_err(OE_XML, EINVAL, "Expected rvals and xpaths");
+        goto done;
+    }
+    for (i=0; i<n; i++)
+        rvals[i] = NULL;
+    if ((key = cbuf_new()) == NULL ||
+        (cbx = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_client_cache_check(cch) < 0)
+        goto done;
+    for (i=0; i<n; i++){
+        if (cch->cch_cache){
+            cbuf_reset(key);
+            cprintf(key, "%s %s", namespace?namespace:"", xpaths[i]);
+            if ((v = clicon_hash_value(cch->cch_cache, cbuf_get(key), NULL)) != NULL){
+                if ((rvals[i] = strdup(v)) == NULL){
+                    clixon_err(OE_UNIX, errno, "strdup");
+                    goto done;
+                }
+                continue;
+            }
+        }
+        cprintf(cbx, "%s%s", miss++?" | ":"", xpaths[i]);
+    }
+    if (miss == 0)
+        goto ok;
+    if (clixon_client_get_xdata(cch, namespace, cbuf_get(cbx), &xdata) < 0)
+        goto done;
+    if ((nsc = xml_nsctx_init(NULL, namespace)) == NULL)
+        goto done;
+    for (i=0; i<n; i++){
+        if (rvals[i] != NULL)
+            continue;
+        if ((x = xpath_first(xdata, nsc, "%s", xpaths[i])) == NULL ||
+            (v = xml_body(x)) == NULL)
+            continue;
+        if ((rvals[i] = strdup(v)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        if (cch->cch_cache){
+            cbuf_reset(key);
+            cprintf(key, "%s %s", namespace?namespace:"", xpaths[i]);
+            if (clicon_hash_add(cch->cch_cache, cbuf_get(key), v, strlen(v)+1) == NULL)
+                goto done;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    clixon_debug(CLIXON_DBG_DEFAULT, "retval:%d", retval);
+    if (retval < 0 && rvals)
+        for (i=0; i<n; i++)
+            if (rvals[i]){
+                free(rvals[i]);
+                rvals[i] = NULL;
+            }
+    if (nsc)
+        cvec_free(nsc);
+    if (xdata)
+        xml_free(xdata);
+    if (key)
+        cbuf_free(key);
+    if (cbx)
+        cbuf_free(cbx);
     return retval;
 }
 
@@ -573,8 +796,7 @@ clixon_client_get_bool(clixon_client_handle ch,
     uint8_t                      val0=0;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if ((ret = parse_bool(val, &val0, &reason)) < 0){
         clixon_err(OE_XML, errno, "parse_bool");
@@ -614,8 +836,7 @@ clixon_client_get_str(clixon_client_handle ch,
     char                        *val = NULL;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     strncpy(rval, val, n-1);
     rval[n-1]= '\0';
@@ -646,8 +867,7 @@ clixon_client_get_uint8(clixon_client_handle ch,
     int                          ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if ((ret = parse_uint8(val, rval, &reason)) < 0){
         clixon_err(OE_XML, errno, "parse_bool");
@@ -686,8 +906,7 @@ clixon_client_get_uint16(clixon_client_handle ch,
     int                          ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if ((ret = parse_uint16(val, rval, &reason)) < 0){
         clixon_err(OE_XML, errno, "parse_bool");
@@ -726,8 +945,7 @@ clixon_client_get_uint32(clixon_client_handle ch,
     int                          ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if (val == NULL){
         clixon_err(OE_XML, EFAULT, "val is NULL");
@@ -771,8 +989,7 @@ clixon_client_get_uint64(clixon_client_handle  ch,
     int                          ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if ((ret = parse_uint64(val, rval, &reason)) < 0){
         clixon_err(OE_XML, errno, "parse_bool");
@@ -789,6 +1006,59 @@ clixon_client_get_uint64(clixon_client_handle  ch,
     return retval;
 }
 
+/*! Enable or disable a read-through cache of values read by the client-api getters
+ *
+ * The cache is invalidated when the backend notifies a change on the on-change stream,
+ * see CLICON_STREAM_ON_CHANGE, which is subscribed to on a separate session.
+ * Changes are seen after the notification has arrived, ie a value changed by another
+ * client may be read from cache until then, eg during a dampening period.
+ * @param[in]  ch      Clixon client handle
+ * @param[in]  enable  1: enable cache, 0: disable cache and free cached values
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @note Only for CLIXON_CLIENT_IPC, and requires the on-change stream in the backend
+ */
+int
+clixon_client_cache(clixon_client_handle ch,
+                    int                  enable)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    char                        *stream;
+
+    clixon_debug(CLIXON_DBG_DEFAULT, "%d", enable);
+    if (!enable){
+        if (cch->cch_notify != -1){
+            close(cch->cch_notify);
+            cch->cch_notify = -1;
+        }
+        if (cch->cch_cache){
+            clicon_hash_free(cch->cch_cache);
+            cch->cch_cache = NULL;
+        }
+        goto ok;
+    }
+    if (cch->cch_cache)
+        goto ok;
+    if (cch->cch_type != CLIXON_CLIENT_IPC){
+        clixon_err(OE_PROTO, EINVAL, "Client cache requires IPC connection");
+        goto done;
+    }
+    if ((stream = clicon_option_str(cch->cch_h, "CLICON_STREAM_ON_CHANGE")) == NULL ||
+        strlen(stream) == 0){
+        clixon_err(OE_CFG, EINVAL, "Client cache requires CLICON_STREAM_ON_CHANGE");
+        goto done;
+    }
+    if (clicon_rpc_create_subscription(cch->cch_h, stream, NULL, &cch->cch_notify) < 0)
+        goto done;
+    if ((cch->cch_cache = clicon_hash_init()) == NULL)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /* Access functions */
 /*! Client-api get uint64
  *
@@ -438,6 +438,8 @@ clicon_nsctx_global_set(clixon_handle h,
  * @param[in]  h    Clixon handle
  * @retval     xn   XML NACM tree, or NULL
  * @note only used if config option CLICON_NACM_MODE is external
+ * @note Do not modify the tree, replace it with clicon_nacm_ext_set. Compiled NACM rules are
+ *       only recompiled when the generation is incremented
  * @see clicon_nacm_ext_set
  */
 cxobj *
@@ -452,6 +454,7 @@ clicon_nacm_ext(clixon_handle h)
 
 /*! Set NACM (rfc 8341) external XML parse tree, free old if any
  *
+ * Also increments the external NACM generation, see nacm_generation
  * @param[in]  h   Clixon handle
  * @param[in]  xn  XML Nacm tree
  * @note only used if config option CLICON_NACM_MODE is external
@@ -462,9 +465,14 @@ clicon_nacm_ext_set(clixon_handle h,
                      cxobj        *x)
 {
     cxobj *x0 = NULL;
+    int    gen;
 
     if ((x0 = clicon_nacm_ext(h)) != NULL)
         xml_free(x0);
+    if ((gen = clicon_data_int_get(h, "nacm_ext_gen")) < 0)
+        gen = 0;
+    if (clicon_data_int_set(h, "nacm_ext_gen", gen+1) < 0)
+        return -1;
     return clicon_ptr_set(h, "nacm_xml", x);
 }
 
@@ -85,6 +85,10 @@
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_snapshot.h"
+
+/* Last assigned datastore content generation, see db_elmnt de_gen */
+static uint64_t _xmldb_gen = 0;
 
 /*! Get xml database element including id, xml cache, empty on startup and dirty bit
  *
@@ -126,6 +130,26 @@ clicon_db_elmnt_set(clixon_handle h,
     return 0;
 }
 
+/*! Get split mode of multi-file datastores
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     mode  XML_MULTI_SPLIT and XML_MULTI_SHARD flags, 0 if not multi-file
+ * @see CLICON_XMLDB_MULTI
+ * @see CLICON_XMLDB_SHARD
+ */
+int
+xmldb_multi_mode(clixon_handle h)
+{
+    int mode = 0;
+
+    if (clicon_option_slot_bool(h, OS_XMLDB_MULTI)){
+        mode |= XML_MULTI_SPLIT;
+        if (clicon_option_slot_bool(h, OS_XMLDB_SHARD))
+            mode |= XML_MULTI_SHARD;
+    }
+    return mode;
+}
+
 /*! Translate from symbolic database name to actual filename in file-system
  *
  * Internal function for explicit XMLDB_MULTI use or not
@@ -189,7 +213,45 @@ xmldb_db2file(clixon_handle  h,
               const char    *db,
               char         **filename)
 {
-    return xmldb_db2file1(h, db, clicon_option_bool(h, "CLICON_XMLDB_MULTI"), filename);
+    return xmldb_db2file1(h, db, clicon_option_slot_bool(h, OS_XMLDB_MULTI), filename);
+}
+
+/*! Translate from symbolic database name to journal filename
+ *
+ * @param[in]   h        Clixon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_db2journal(clixon_handle h,
+                 const char   *db,
+                 char        **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+        clixon_err(OE_XML, errno, "CLICON_XMLDB_DIR not set");
+        goto done;
+    }
+    cprintf(cb, "%s/%s_db.journal", dir, db);
+    if ((*filename = strdup4(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
 }
 
 /*! Translate from symbolic database name to sub-directory of configure sub-files, no checks
@@ -248,6 +310,32 @@ xmldb_connect(clixon_handle h)
     return 0;
 }
 
+/*! Free published read-only copy of datastore cache
+ *
+ * If the copy is held, it is retired and freed when released
+ * @param[in]  de  Datastore element
+ * @see xmldb_rdonly_release
+ */
+static void
+xmldb_rdonly_free(db_elmnt *de)
+{
+    struct xmldb_retired *xr;
+
+    if (de->de_rdonly){
+        if (de->de_rdonly_refs == 0)
+            xml_free(de->de_rdonly);
+        else if ((xr = realloc(de->de_retired, (de->de_nretired+1)*sizeof(*xr))) != NULL){
+            de->de_retired = xr;
+            xr[de->de_nretired].xr_xml = de->de_rdonly;
+            xr[de->de_nretired].xr_refs = de->de_rdonly_refs;
+            de->de_nretired++;
+        } /* else leak rather than free a held tree */
+        de->de_rdonly = NULL;
+    }
+    de->de_rdonly_refs = 0;
+    de->de_rdonly_gen = 0;
+}
+
 /*! Disconnect from a datastore plugin and deallocate resources
  *
  * @param[in]  handle  Disconect and deallocate from this handle
@@ -261,6 +349,7 @@ xmldb_disconnect(clixon_handle h)
     char    **keys = NULL;
     size_t    klen;
     int       i;
+    int       j;
     db_elmnt *de;
 
     if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
@@ -271,6 +360,15 @@ xmldb_disconnect(clixon_handle h)
                 xml_free(de->de_xml);
                 de->de_xml = NULL;
             }
+            de->de_rdonly_refs = 0;
+            xmldb_rdonly_free(de);
+            for (j=0; j<de->de_nretired; j++)
+                xml_free(de->de_retired[j].xr_xml);
+            if (de->de_retired){
+                free(de->de_retired);
+                de->de_retired = NULL;
+            }
+            de->de_nretired = 0;
         }
     retval = 0;
  done:
@@ -332,6 +430,10 @@ check_create_multidir(clixon_handle h,
 /*! Copy datastore from db1 to db2, both cache and datastore
  *
  * May include copying datastore directory structure
+ * If both caches have the same content generation, the copy of the in-memory cache is
+ * skipped since the trees are equal, eg discard-changes without edits after a commit.
+ * The generation is reset whenever a cache may be modified: by xmldb_put, xmldb_clear, or when
+ * exposing the cache via xmldb_cache_get.
  * @param[in]  h     Clixon handle
  * @param[in]  from  Source datastore
  * @param[in]  to    Destination datastore
@@ -353,6 +455,7 @@ xmldb_copy(clixon_handle h,
     cxobj      *x2 = NULL;  /* to */
     char       *fromdir = NULL;
     char       *todir = NULL;
+    struct stat st = {0,};
 
     clixon_debug(CLIXON_DBG_DATASTORE, "%s %s", from, to);
     /* XXX lock */
@@ -376,6 +479,9 @@ xmldb_copy(clixon_handle h,
         if (xml_copy(x1, x2) < 0)
             goto done;
     }
+    else if (de1->de_gen != 0 && de1->de_gen == de2->de_gen){
+        clixon_debug(CLIXON_DBG_DATASTORE, "%s and %s equal, skip cache copy", from, to);
+    }
     else{ /* copy x1 to x2 */
         xml_free0(x2);
         xml_type_set(x2, CX_ELMNT);
@@ -391,11 +497,24 @@ xmldb_copy(clixon_handle h,
     if (de2)
         de0 = *de2;
     de0.de_xml = x2; /* The new tree */
-    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+    if (de1 != NULL && x1 != NULL){ /* Share content generation with source */
+        if (de1->de_gen == 0)
+            de1->de_gen = ++_xmldb_gen;
+        de0.de_gen = de1->de_gen;
+    }
+    else
+        de0.de_gen = 0;
+    de0.de_edit_gen = 0;
+    if (clicon_option_slot_bool(h, OS_XMLDB_MULTI)){
         if (check_create_multidir(h, to) < 0)
             goto done;
     }
     clicon_db_elmnt_set(h, to, &de0);
+    /* Publish committed running to readers */
+    if (strcmp(to, "running") == 0 &&
+        clicon_option_slot_bool(h, OS_XMLDB_RUNNING_RDONLY) &&
+        xmldb_rdonly_publish(h, to) < 0)
+        goto done;
     /* Copy the files themselves (above only in-memory cache)
      * Alt, dump the cache to file
      */
@@ -405,7 +524,25 @@ xmldb_copy(clixon_handle h,
         goto done;
     if (clicon_file_copy(fromfile, tofile) < 0)
         goto done;
-    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")) {
+    if (clicon_option_slot_bool(h, OS_XMLDB_JOURNAL)){
+        free(fromfile);
+        free(tofile);
+        fromfile = tofile = NULL;
+        if (xmldb_db2journal(h, from, &fromfile) < 0)
+            goto done;
+        if (xmldb_db2journal(h, to, &tofile) < 0)
+            goto done;
+        if (lstat(fromfile, &st) == 0){
+            if (clicon_file_copy(fromfile, tofile) < 0)
+                goto done;
+        }
+        else if (xmldb_journal_reset(h, to) < 0)
+            goto done;
+    }
+    if (xmldb_snapshot_enabled(h) &&
+        xmldb_snapshot_copy(h, from, to) < 0)
+        goto done;
+    if (clicon_option_slot_bool(h, OS_XMLDB_MULTI)) {
         if (xmldb_db2subdir(h, from, &fromdir) < 0)
             goto done;
         if (xmldb_db2subdir(h, to, &todir) < 0)
@@ -427,6 +564,281 @@ xmldb_copy(clixon_handle h,
     return retval;
 }
 
+/*! Move datastore from db1 to db2, both cache and datastore file
+ *
+ * Cheaper than xmldb_copy when the source is about to be overwritten, eg running just
+ * before a commit replaces it: the cache tree is handed over instead of copied and the
+ * file and journal are renamed instead of copied.
+ * The source is left without cache and file, the caller is expected to write it directly
+ * afterwards, eg with xmldb_copy.
+ * With sub-files (CLICON_XMLDB_MULTI) or snapshots enabled, fall back to a copy.
+ * @param[in]  h     Clixon handle
+ * @param[in]  from  Source datastore
+ * @param[in]  to    Destination datastore
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xmldb_copy
+ */
+int
+xmldb_move(clixon_handle h,
+           const char   *from,
+           const char   *to)
+{
+    int         retval = -1;
+    db_elmnt   *de1;
+    db_elmnt   *de2;
+    db_elmnt    de0 = {0,};
+    char       *fromfile = NULL;
+    char       *tofile = NULL;
+    struct stat st = {0,};
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "%s %s", from, to);
+    if (clicon_option_slot_bool(h, OS_XMLDB_MULTI) ||
+        xmldb_snapshot_enabled(h))
+        return xmldb_copy(h, from, to);
+    /* Files first, since deleting the destination also clears its cache */
+    if (xmldb_delete(h, to) < 0)
+        goto done;
+    if (xmldb_db2file(h, from, &fromfile) < 0)
+        goto done;
+    if (lstat(fromfile, &st) == 0){
+        if (xmldb_db2file(h, to, &tofile) < 0)
+            goto done;
+        /* Renames journal along with base file */
+        if (xmldb_rename(h, from, tofile, NULL) < 0)
+            goto done;
+    }
+    if ((de2 = clicon_db_elmnt_get(h, to)) != NULL)
+        de0 = *de2;
+    de0.de_xml = NULL;
+    de0.de_gen = 0;
+    de0.de_edit_gen = 0;
+    if ((de1 = clicon_db_elmnt_get(h, from)) != NULL){
+        /* Content is unchanged, keep generation */
+        de0.de_xml = de1->de_xml;
+        de0.de_gen = de1->de_gen;
+        de1->de_xml = NULL;
+        de1->de_gen = 0;
+        de1->de_edit_gen = 0;
+    }
+    clicon_db_elmnt_set(h, to, &de0);
+    retval = 0;
+ done:
+    if (fromfile)
+        free(fromfile);
+    if (tofile)
+        free(tofile);
+    return retval;
+}
+
+/*! Get content generation of datastore cache, assign a new generation if unset
+ *
+ * Two calls return the same non-zero generation only if the cache content is
+ * unchanged in between. Use this to key data derived from datastore content.
+ * Call it only when the cache is not being edited, eg at the start of a request.
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Datastore, eg "running"
+ * @retval     gen Content generation
+ * @retval     0   No cache of datastore
+ * @see xmldb_rdonly_publish
+ */
+uint64_t
+xmldb_generation(clixon_handle h,
+                 const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+        de->de_xml == NULL)
+        return 0;
+    if (de->de_gen == 0)
+        de->de_gen = ++_xmldb_gen;
+    return de->de_gen;
+}
+
+/*! Publish a read-only copy of datastore cache
+ *
+ * The copy is never modified, it is replaced by a new copy when published again.
+ * The content generation of the cache is recorded so that a modified cache is detected.
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Datastore, eg "running"
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see CLICON_XMLDB_RUNNING_RDONLY
+ */
+int
+xmldb_rdonly_publish(clixon_handle h,
+                     const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    cxobj    *x;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+        goto ok;
+    xmldb_rdonly_free(de);
+    if (de->de_xml == NULL)
+        goto ok;
+    if ((x = xml_dup(de->de_xml)) == NULL)
+        goto done;
+    xml_flag_set(x, XML_FLAG_TOP);
+    if (de->de_gen == 0)
+        de->de_gen = ++_xmldb_gen;
+    de->de_rdonly = x;
+    de->de_rdonly_gen = de->de_gen;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get published read-only copy of datastore cache, publish a new copy if cache is modified
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Datastore, eg "running"
+ * @param[out] xtp  Read-only tree, or NULL if no cache. Do not modify or free
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_rdonly_publish
+ */
+int
+xmldb_rdonly_get(clixon_handle h,
+                 const char   *db,
+                 cxobj       **xtp)
+{
+    int       retval = -1;
+    db_elmnt *de;
+
+    *xtp = NULL;
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_xml == NULL)
+        goto ok;
+    if (de->de_rdonly == NULL ||
+        de->de_gen == 0 ||
+        de->de_gen != de->de_rdonly_gen){
+        clixon_debug(CLIXON_DBG_DATASTORE, "Publish %s", db);
+        if (xmldb_rdonly_publish(h, db) < 0)
+            goto done;
+    }
+    *xtp = de->de_rdonly;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get and hold published read-only copy of datastore cache
+ *
+ * The copy is not freed until released, also if a new copy is published. Use for reads
+ * outside the event loop, eg in threads. Hold and release in the main thread.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Datastore, eg "running"
+ * @param[out] xtp  Read-only tree, or NULL if no cache. Do not modify or free
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_rdonly_release
+ */
+int
+xmldb_rdonly_hold(clixon_handle h,
+                  const char   *db,
+                  cxobj       **xtp)
+{
+    db_elmnt *de;
+
+    if (xmldb_rdonly_get(h, db, xtp) < 0)
+        return -1;
+    if (*xtp != NULL && (de = clicon_db_elmnt_get(h, db)) != NULL)
+        de->de_rdonly_refs++;
+    return 0;
+}
+
+/*! Release read-only copy of datastore cache held by xmldb_rdonly_hold
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Datastore, eg "running"
+ * @param[in]  xt   Read-only tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xmldb_rdonly_release(clixon_handle h,
+                     const char   *db,
+                     cxobj        *xt)
+{
+    db_elmnt             *de;
+    struct xmldb_retired *xr;
+    int                   i;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL){
+        clixon_err(OE_CFG, ENOENT, "No such database: %s", db);
+        return -1;
+    }
+    if (xt == de->de_rdonly){
+        if (de->de_rdonly_refs > 0)
+            de->de_rdonly_refs--;
+        return 0;
+    }
+    for (i=0; i<de->de_nretired; i++){
+        xr = &de->de_retired[i];
+        if (xr->xr_xml != xt)
+            continue;
+        if (--xr->xr_refs == 0){
+            xml_free(xr->xr_xml);
+            de->de_retired[i] = de->de_retired[--de->de_nretired];
+        }
+        return 0;
+    }
+    clixon_err(OE_CFG, EINVAL, "%s read-only tree not held", db);
+    return -1;
+}
+
+/*! Check if published read-only copy of datastore cache is held
+ *
+ * Then it may be read by other threads and its flags should not be modified
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Datastore, eg "running"
+ * @retval     1    Held
+ * @retval     0    No
+ */
+int
+xmldb_rdonly_held(clixon_handle h,
+                  const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+        return 0;
+    return de->de_rdonly_refs > 0;
+}
+
+/*! Check if all edits of a datastore since the content of another are marked
+ *
+ * If so, the datastores only differ in nodes marked with XML_FLAG_EDIT in db, and a diff
+ * can skip unmarked nodes, see xml_diff_marked.
+ * Not if copies of the datastores are modified on read, see xmldb_get_copy
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Datastore with edit marks, eg "candidate"
+ * @param[in]  base  Datastore edits are marked relative to, eg "running"
+ * @retval     1     Yes, edits are marked
+ * @retval     0     No, or unknown
+ * @see xmldb_put    where edits are marked
+ */
+int
+xmldb_edit_marked(clixon_handle h,
+                  const char   *db,
+                  const char   *base)
+{
+    db_elmnt *de;
+    db_elmnt *deb;
+
+    if (clicon_option_slot_bool(h, OS_XMLDB_SYSTEM_ONLY_CONFIG) ||
+        clicon_option_slot_bool(h, OS_NACM_DISABLED_ON_EMPTY))
+        return 0;
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_xml == NULL ||
+        (deb = clicon_db_elmnt_get(h, base)) == NULL || deb->de_xml == NULL)
+        return 0;
+    return de->de_edit_gen != 0 && de->de_edit_gen == deb->de_gen;
+}
+
 /*! Lock database
  *
  * @param[in]  h    Clixon handle
@@ -605,6 +1017,9 @@ xmldb_clear(clixon_handle h,
             xml_free(xt);
             de->de_xml = NULL;
         }
+        de->de_gen = 0;
+        de->de_edit_gen = 0;
+        xmldb_rdonly_free(de);
         de->de_modified = 0;
         de->de_id = 0;
         memset(&de->de_tv, 0, sizeof(struct timeval));
@@ -645,7 +1060,9 @@ xmldb_delete(clixon_handle h,
             clixon_err(OE_DB, errno, "truncate %s", filename);
             goto done;
         }
-    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+    if (xmldb_journal_reset(h, db) < 0)
+        goto done;
+    if (clicon_option_slot_bool(h, OS_XMLDB_MULTI)){
         if (xmldb_db2subdir(h, db, &subdir) < 0)
             goto done;
         if (stat(subdir, &st) == 0){
@@ -702,8 +1119,11 @@ xmldb_create(clixon_handle h,
             xml_free(xt);
             de->de_xml = NULL;
         }
+        de->de_gen = 0;
+        de->de_edit_gen = 0;
+        xmldb_rdonly_free(de);
     }
-    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+    if (clicon_option_slot_bool(h, OS_XMLDB_MULTI)){
         if (check_create_multidir(h, db) < 0)
             goto done;
     }
@@ -750,6 +1170,7 @@ xmldb_db_reset(clixon_handle h,
  * @param[in]  db   Database name
  * @retval     xml  XML cached tree or NULL
  * @see xmldb_get_cache  Read from store if miss
+ * @note Since the caller may modify the tree, the content generation and edit marks are reset
  */
 cxobj *
 xmldb_cache_get(clixon_handle h,
@@ -759,6 +1180,8 @@ xmldb_cache_get(clixon_handle h,
 
     if ((de = clicon_db_elmnt_get(h, db)) == NULL)
         return NULL;
+    de->de_gen = 0;
+    de->de_edit_gen = 0;
     return de->de_xml;
 }
 
@@ -922,6 +1345,8 @@ xmldb_print(clixon_handle h,
         fprintf(f, "  XML:      %p\n", de->de_xml);
         fprintf(f, "  Modified: %d\n", de->de_modified);
         fprintf(f, "  Empty:    %d\n", de->de_empty);
+        fprintf(f, "  Gen:      %llu\n", (unsigned long long)de->de_gen);
+        fprintf(f, "  EditGen:  %llu\n", (unsigned long long)de->de_edit_gen);
     }
     retval = 0;
  done:
@@ -946,10 +1371,11 @@ xmldb_rename(clixon_handle h,
              const char    *newdb,
              const char    *suffix)
 {
-    int    retval = -1;
-    char  *old;
-    char  *fname = NULL;
-    cbuf  *cb = NULL;
+    int         retval = -1;
+    char       *old = NULL;
+    char       *fname = NULL;
+    cbuf       *cb = NULL;
+    struct stat st = {0,};
 
     if ((xmldb_db2file(h, db, &old)) < 0)
         goto done;
@@ -967,6 +1393,18 @@ xmldb_rename(clixon_handle h,
         clixon_err(OE_UNIX, errno, "rename: %s", strerror(errno));
         goto done;
     };
+    /* Rename journal along with base file */
+    free(old);
+    old = NULL;
+    if (xmldb_db2journal(h, db, &old) < 0)
+        goto done;
+    if (lstat(old, &st) == 0){
+        cprintf(cb, ".journal");
+        if ((rename(old, cbuf_get(cb))) < 0) {
+            clixon_err(OE_UNIX, errno, "rename: %s", strerror(errno));
+            goto done;
+        }
+    }
     retval = 0;
  done:
     if (cb)
@@ -1001,6 +1439,7 @@ xmldb_populate(clixon_handle h,
     yspec = clicon_dbspec_yang(h);
     if ((ret = xml_bind_yang(h, x, YB_MODULE, yspec, 0, NULL)) < 0)
         goto done;
+#ifndef XMLDB_DEFAULTS_VIRTUAL
     if (ret == 1){
         /* Add default global values (to make xpath below include defaults) */
         if (xml_global_defaults(h, x, NULL, "/", yspec, 0) < 0)
@@ -1009,6 +1448,7 @@ xmldb_populate(clixon_handle h,
         if (xml_default_recurse(x, 0, 0) < 0)
             goto done;
     }
+#endif
     retval = ret;
  done:
     return retval;
@@ -50,6 +50,9 @@
 #include <assert.h>
 #include <syslog.h>
 #include <fcntl.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -72,6 +75,7 @@
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_json.h"
+#include "clixon_cbor.h"
 #include "clixon_nacm.h"
 #include "clixon_path.h"
 #include "clixon_netconf_lib.h"
@@ -81,8 +85,12 @@
 #include "clixon_xml_default.h"
 #include "clixon_xml_io.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_xml_vec.h"
 #include "clixon_datastore.h"
+#include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_snapshot.h"
+#include "clixon_probe.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
@@ -95,6 +103,12 @@ struct xmldb_multi_read_arg {
     yang_stmt       *mr_yspec;
     enum format_enum mr_format;
     cxobj          **mr_xerr;
+    clixon_xvec     *mr_links;  /* Nodes linking to sub-files */
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_t  mr_mutex;  /* Protects mr_next and mr_err in worker threads */
+#endif
+    int              mr_next;   /* Next link to read by worker */
+    int              mr_err;    /* Worker failed */
 };
 
 /*! Ensure that xt only has a single sub-element and that is "config"
@@ -227,24 +241,82 @@ xml_copy_bottom_recurse(cxobj  *x0t,
     return retval;
 }
 
+/*! Copy an XML tree limited to a number of levels
+ *
+ * Elements below the limit are not copied, except list keys. Bodies and attributes of
+ * the last level are copied, so that the copy has children wherever the source has
+ * children in the copied levels, which is what a depth-limited print needs.
+ * @param[in]  x0     Source XML tree
+ * @param[in]  x1     Destination XML tree (must exist)
+ * @param[in]  depth  Levels of child elements to copy, -1 is all, 0 is keys only
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xml_copy
+ */
+static int
+xml_copy_depth(cxobj  *x0,
+               cxobj  *x1,
+               int32_t depth)
+{
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xcopy;
+    yang_stmt *y;
+
+    if (depth < 0)
+        return xml_copy(x0, x1);
+    if (xml_copy_one(x0, x1) < 0)
+        goto done;
+    y = xml_spec(x0);
+    x = NULL;
+    while ((x = xml_child_each(x0, x, -1)) != NULL) {
+        if (depth == 0 &&
+            xml_type(x) == CX_ELMNT &&
+            (y == NULL || yang_keyword_get(y) != Y_LIST ||
+             yang_key_match(y, xml_name(x), NULL) != 1))
+            continue;
+        if ((xcopy = xml_new(xml_name(x), x1, xml_type(x))) == NULL)
+            goto done;
+        if (xml_type(x) != CX_ELMNT || depth == 0){
+            if (xml_copy(x, xcopy) < 0)
+                goto done;
+        }
+        else if (xml_copy_depth(x, xcopy, depth-1) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Copy an XML tree bottom-up
  *
- * @retval     0    OK
- * @retval    -1    OK
+ * @param[in]  x0t   Top of source tree
+ * @param[in]  x0    Source node to copy, with ancestors and keys
+ * @param[in]  x1t   Top of target tree
+ * @param[in]  depth Levels below top of tree to copy, -1 is all, see xml_copy_depth
+ * @param[out] x1r   Copy of x0 (if given)
+ * @retval     0     OK
+ * @retval    -1     OK
  */
 static int
 xml_copy_from_bottom(cxobj  *x0t,
                      cxobj  *x0,
-                     cxobj  *x1t)
+                     cxobj  *x1t,
+                     int32_t depth,
+                     cxobj **x1r)
 {
     int        retval = -1;
     cxobj     *x1p    = NULL;
     cxobj     *x0p    = NULL;
     cxobj     *x1     = NULL;
     yang_stmt *y      = NULL;
+    cxobj     *xa;
 
-    if (x0 == x0t)
+    if (x0 == x0t){
+        x1 = x1t;
         goto ok;
+    }
     x0p = xml_parent(x0);
     if (xml_copy_bottom_recurse(x0t, x0p, x1t, &x1p) < 0)
         goto done;
@@ -256,10 +328,19 @@ xml_copy_from_bottom(cxobj  *x0t,
     if (x1 == NULL){ /* If not, create it and copy complete tree */
         if ((x1 = xml_new(xml_name(x0), x1p, CX_ELMNT)) == NULL)
             goto done;
-        if (xml_copy(x0, x1) < 0)
+        if (depth >= 0){
+            /* Levels left below x0, but always its children for predicates of the xpath */
+            for (xa = x0p; xa != x0t && xa != NULL; xa = xml_parent(xa))
+                depth--;
+            if (depth < 1)
+                depth = 1;
+        }
+        if (xml_copy_depth(x0, x1, depth) < 0)
             goto done;
     }
  ok:
+    if (x1r)
+        *x1r = x1;
     retval = 0;
  done:
     return retval;
@@ -462,27 +543,25 @@ disable_nacm_on_empty(cxobj     *xt,
     return retval;
 }
 
-/*! Callback function for xmldb-multi read
+/*! Read sub-file of xmldb-multi link node into the node
  *
- * Look for link attribute in XML, and if found open the linked file for parsing
- * @param[in]  x    XML node
- * @param[in]  arg
- * @retval     2    Locally abort this subtree, continue with others
- * @retval     1    Abort, dont continue with others, return 1 to end user
- * @retval     0    OK, continue
- * @retval    -1    Error, aborted at first error encounter, return -1 to end user
+ * @param[in]  mr   Multi read argument
+ * @param[in]  x    XML node with link attribute
+ * @param[out] xerr XML error, or NULL
+ * @retval     0    OK
+ * @retval    -1    Error
  */
 static int
-xmldb_multi_read_applyfn(cxobj *x,
-                         void  *arg)
+xmldb_multi_read_file(struct xmldb_multi_read_arg *mr,
+                      cxobj                       *x,
+                      cxobj                      **xerr)
 {
-    struct xmldb_multi_read_arg *mr = (struct xmldb_multi_read_arg *) arg;
-    int                     retval = -1;
-    cxobj                  *xa;
-    char                   *filename;
-    cbuf                   *cb = NULL;
-    char                   *dbfile;
-    FILE                   *fp = NULL;
+    int     retval = -1;
+    cxobj  *xa;
+    char   *filename;
+    cbuf   *cb = NULL;
+    char   *dbfile;
+    FILE   *fp = NULL;
 
     if ((xa = xml_find_type(x, CLIXON_LIB_PREFIX, "link", CX_ATTR)) != NULL &&
         (filename = xml_value(xa)) != NULL){
@@ -502,11 +581,15 @@ xmldb_multi_read_applyfn(cxobj *x,
         }
         switch (mr->mr_format){
         case FORMAT_JSON:
-            if (clixon_json_parse_file(fp, 1, YB_NONE, mr->mr_yspec, &x, mr->mr_xerr) < 0)
+            if (clixon_json_parse_file(fp, 1, YB_NONE, mr->mr_yspec, &x, xerr) < 0)
+                goto done;
+            break;
+        case FORMAT_CBOR:
+            if (clixon_cbor_parse_file(fp, YB_NONE, mr->mr_yspec, &x, xerr) < 0)
                 goto done;
             break;
         case FORMAT_XML:
-            if (clixon_xml_parse_file(fp, YB_NONE, mr->mr_yspec, &x, mr->mr_xerr) < 0)
+            if (clixon_xml_parse_file(fp, YB_NONE, mr->mr_yspec, &x, xerr) < 0)
                 goto done;
             break;
         default:
@@ -524,6 +607,150 @@ xmldb_multi_read_applyfn(cxobj *x,
     return retval;
 }
 
+/*! Callback function for xmldb-multi read
+ *
+ * Look for link attribute in XML, and if found add the node for reading its linked file
+ * @param[in]  x    XML node
+ * @param[in]  arg
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     1    Abort, dont continue with others, return 1 to end user
+ * @retval     0    OK, continue
+ * @retval    -1    Error, aborted at first error encounter, return -1 to end user
+ * @see xmldb_multi_read_files
+ */
+static int
+xmldb_multi_read_applyfn(cxobj *x,
+                         void  *arg)
+{
+    struct xmldb_multi_read_arg *mr = (struct xmldb_multi_read_arg *) arg;
+
+    if (xml_find_type(x, CLIXON_LIB_PREFIX, "link", CX_ATTR) != NULL){
+        if (clixon_xvec_append(mr->mr_links, x) < 0)
+            return -1;
+        return 2;
+    }
+    return 0;
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*! Worker thread: read sub-files until none left
+ */
+static void *
+xmldb_multi_read_worker(void *arg)
+{
+    struct xmldb_multi_read_arg *mr = (struct xmldb_multi_read_arg *)arg;
+    int                          i;
+
+    for (;;){
+        pthread_mutex_lock(&mr->mr_mutex);
+        if (mr->mr_err || (i = mr->mr_next) >= clixon_xvec_len(mr->mr_links))
+            i = -1;
+        else
+            mr->mr_next++;
+        pthread_mutex_unlock(&mr->mr_mutex);
+        if (i < 0)
+            break;
+        if (xmldb_multi_read_file(mr, clixon_xvec_i(mr->mr_links, i), NULL) < 0){
+            pthread_mutex_lock(&mr->mr_mutex);
+            mr->mr_err++;
+            pthread_mutex_unlock(&mr->mr_mutex);
+        }
+    }
+    return NULL;
+}
+#endif /* HAVE_LIBPTHREAD */
+
+/*! Read sub-files of all link nodes found by xmldb_multi_read_applyfn
+ *
+ * Each sub-file is parsed into its own disjoint subtree, so with several threads the
+ * sub-files are read in parallel, such as the shards of CLICON_XMLDB_SHARD.
+ * @param[in]  mr       Multi read argument with link nodes
+ * @param[in]  nthreads Number of threads, 1 or less reads in calling thread only
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+xmldb_multi_read_files(struct xmldb_multi_read_arg *mr,
+                       int                          nthreads)
+{
+    int        retval = -1;
+    int        i;
+#ifdef HAVE_LIBPTHREAD
+    pthread_t *tids = NULL;
+    int        n = 0;
+    int        threads0;
+    int        ret;
+#endif
+
+    if (clixon_xvec_len(mr->mr_links) < nthreads)
+        nthreads = clixon_xvec_len(mr->mr_links);
+#ifdef HAVE_LIBPTHREAD
+    if (nthreads > 1){
+        if ((tids = calloc(nthreads, sizeof(*tids))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if (pthread_mutex_init(&mr->mr_mutex, NULL) != 0){
+            clixon_err(OE_UNIX, errno, "pthread_mutex_init");
+            goto done;
+        }
+        threads0 = xml_threads_set(1);
+        for (n=0; n<nthreads; n++)
+            if ((ret = pthread_create(&tids[n], NULL, xmldb_multi_read_worker, mr)) != 0){
+                clixon_err(OE_UNIX, ret, "pthread_create");
+                break;
+            }
+        if (n == 0) /* No threads, read here */
+            xmldb_multi_read_worker(mr);
+        for (i=0; i<n; i++)
+            pthread_join(tids[i], NULL);
+        xml_threads_set(threads0);
+        pthread_mutex_destroy(&mr->mr_mutex);
+        if (mr->mr_err)
+            goto done;
+        goto ok;
+    }
+#endif
+    for (i=0; i<clixon_xvec_len(mr->mr_links); i++)
+        if (xmldb_multi_read_file(mr, clixon_xvec_i(mr->mr_links, i), mr->mr_xerr) < 0)
+            goto done;
+#ifdef HAVE_LIBPTHREAD
+ ok:
+#endif
+    retval = 0;
+ done:
+#ifdef HAVE_LIBPTHREAD
+    if (tids)
+        free(tids);
+#endif
+    return retval;
+}
+
+/*! Release slack memory of large lists of a datastore tree after it is read
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Symbolic database name, for debug
+ * @param[in]  x0    XML tree read from file
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see CLICON_XMLDB_COMPACT_LISTS
+ */
+static int
+xmldb_compact(clixon_handle h,
+              const char   *db,
+              cxobj        *x0)
+{
+    int    min;
+    size_t sz = 0;
+
+    if ((min = clicon_option_int(h, "CLICON_XMLDB_COMPACT_LISTS")) <= 0)
+        return 0;
+    if (xml_compact(x0, min, &sz) < 0)
+        return -1;
+    clixon_debug(CLIXON_DBG_DATASTORE, "db %s compacted, %zu bytes released", db, sz);
+    return 0;
+}
+
 /*! Common read function that reads an XML tree from file
  *
  * @param[in]  th     Datastore text handle
@@ -569,7 +796,9 @@ xmldb_readfile(clixon_handle    h,
     cxobj           *x;
     yang_stmt       *yspec1 = NULL;
     struct xmldb_multi_read_arg mr = {0, };
+    int              sorted = 0;
 
+    CLIXON_PROBE1(datastore__read__start, db);
     if (yb != YB_MODULE && yb != YB_NONE){
         clixon_err(OE_XML, EINVAL, "yb is %d but should be module or none", yb);
         goto done;
@@ -580,15 +809,37 @@ xmldb_readfile(clixon_handle    h,
         clixon_err(OE_XML, 0, "dbfile NULL");
         goto done;
     }
-    if ((formatstr = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL){
+    if ((formatstr = clicon_option_slot_str(h, OS_XMLDB_FORMAT)) == NULL){
         clixon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
         goto done;
     }
-    if ((ret = format_str2int(formatstr)) < 0){
+    if ((ret = clicon_option_slot_int(h, OS_XMLDB_FORMAT)) < 0){
         clixon_err(OE_XML, 0, "format not found %s", formatstr);
         goto done;
     }
     format = ret;
+    if (yb == YB_MODULE && xmldb_snapshot_enabled(h)){
+        if ((ret = xmldb_snapshot_read(h, db, yspec, &x0, &sorted)) < 0)
+            goto done;
+        if (ret == 1){
+            /* Snapshot is pre-sorted, sort only if YANG has changed */
+            xml_flag_set(x0, XML_FLAG_TOP);
+            if (xml_child_nr(x0) == 0 && de)
+                de->de_empty = 1;
+            if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec, 0, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            if (!sorted &&
+                xml_sort_recurse_threads(x0, clicon_option_slot_int(h, OS_XMLDB_SORT_THREADS)) < 0)
+                goto done;
+            if (xmldb_journal_replay(h, db, x0, yspec) < 0)
+                goto done;
+            if (xmldb_compact(h, db, x0) < 0)
+                goto done;
+            goto ok;
+        }
+    }
     clixon_debug(CLIXON_DBG_DATASTORE, "Reading datastore %s using %s", dbfile, formatstr);
     /* Parse file into internal XML tree from different formats */
     if ((fp = fopen(dbfile, "r")) == NULL) {
@@ -606,6 +857,10 @@ xmldb_readfile(clixon_handle    h,
         if (clixon_json_parse_file(fp, 1, YB_NONE, yspec, &x0, xerr) < 0)
             goto done;
         break;
+    case FORMAT_CBOR:
+        if (clixon_cbor_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0)
+            goto done;
+        break;
     case FORMAT_XML:
         if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0)
             goto done;
@@ -615,14 +870,18 @@ xmldb_readfile(clixon_handle    h,
         goto done;
         break;
     }
-    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+    if (clicon_option_slot_bool(h, OS_XMLDB_MULTI)){
         if (xmldb_db2subdir(h, db, &mr.mr_subdir) < 0)
             goto done;
         mr.mr_format = format;
         mr.mr_yspec = yspec;
         mr.mr_xerr = xerr;
+        if ((mr.mr_links = clixon_xvec_new()) == NULL)
+            goto done;
         if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xmldb_multi_read_applyfn, &mr) < 0)
             goto done;
+        if (xmldb_multi_read_files(&mr, clicon_option_slot_int(h, OS_XMLDB_SORT_THREADS)) < 0)
+            goto done;
     }
     /* Always assert a top-level called "config".
      * To ensure that, deal with two cases:
@@ -647,7 +906,7 @@ xmldb_readfile(clixon_handle    h,
     if (xml_child_nr(x0) == 0 && de)
         de->de_empty = 1;
     /* Check if we support modstate */
-    if (clicon_option_bool(h, "CLICON_XMLDB_MODSTATE"))
+    if (clicon_option_slot_bool(h, OS_XMLDB_MODSTATE))
         if ((msdiff = modstate_diff_new()) == NULL)
             goto done;
     /* First try RFC8525, but also backward compatible RFC7895 */
@@ -732,9 +991,15 @@ xmldb_readfile(clixon_handle    h,
             goto done;
         if (ret == 0)
             goto fail;
-        if (xml_sort_recurse(x0) < 0)
+        if (xml_sort_recurse_threads(x0, clicon_option_slot_int(h, OS_XMLDB_SORT_THREADS)) < 0)
+            goto done;
+        /* Apply edits made after base file was written */
+        if (xmldb_journal_replay(h, db, x0, yspec1?yspec1:yspec) < 0)
+            goto done;
+        if (xmldb_compact(h, db, x0) < 0)
             goto done;
     }
+ ok:
     if (xp){
         *xp = x0;
         x0 = NULL;
@@ -748,6 +1013,8 @@ xmldb_readfile(clixon_handle    h,
  done:
     if (mr.mr_subdir)
         free(mr.mr_subdir);
+    if (mr.mr_links)
+        clixon_xvec_free(mr.mr_links);
     if (xmodfile)
         xml_free(xmodfile);
     if (msdiff)
@@ -758,6 +1025,7 @@ xmldb_readfile(clixon_handle    h,
         free(dbfile);
     if (x0)
         xml_free(x0);
+    CLIXON_PROBE2(datastore__read__done, db, retval);
     return retval;
  fail:
     retval = 0;
@@ -814,6 +1082,7 @@ xmldb_get_cache(clixon_handle     h,
         if (de)
             de0.de_id = de->de_id;
         clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
+#ifndef XMLDB_DEFAULTS_VIRTUAL
         /* Add default global values (to make xpath below include defaults) */
         // Alt:  xmldb_populate(h, db)
         if (yb != YB_NONE) {
@@ -823,6 +1092,7 @@ xmldb_get_cache(clixon_handle     h,
             if (xml_default_recurse(xt, 0, 0) < 0)
                 goto done;
         }
+#endif
     } /* xt == NULL */
     else
         xt = de->de_xml;
@@ -845,6 +1115,7 @@ xmldb_get_cache(clixon_handle     h,
  * @param[in]  yb     How to bind yang to XML top-level when parsing
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPath syntax. or NULL for all
+ * @param[in]  depth  Levels below top to copy, -1 is all, see xmldb_get_depth
  * @param[out] xret   Single return XML tree. Free with xml_free()
  * @param[out] msdiff If set, return modules-state differences
  * @param[out] xerr   XML error if retval is 0
@@ -859,6 +1130,7 @@ xmldb_get_copy(clixon_handle     h,
                yang_bind         yb,
                cvec             *nsc,
                const char       *xpath,
+               int32_t           depth,
                cxobj           **xret,
                modstate_diff_t  *msdiff,
                cxobj           **xerr)
@@ -871,6 +1143,10 @@ xmldb_get_copy(clixon_handle     h,
     size_t     xlen;
     int        i;
     cxobj     *x1t = NULL;
+    cxobj     *x1 = NULL;
+    cxobj     *x;
+    int        rdonly = 0;
+    int        bottom = 0;
     int        ret;
 
     clixon_debug(CLIXON_DBG_DATASTORE, "db %s", db);
@@ -886,6 +1162,21 @@ xmldb_get_copy(clixon_handle     h,
         goto done;
     if (ret == 0)
         goto fail;
+    /* Read from published read-only running, not from the mutable cache.
+     * Not if it is held, since the XPath evaluation below may set lazy indexes and caches of
+     * the tree, while other threads read it, see xmldb_rdonly_hold */
+    if (strcmp(db, "running") == 0 &&
+        clicon_option_slot_bool(h, OS_XMLDB_RUNNING_RDONLY)){
+        if (xmldb_rdonly_get(h, db, &x) < 0)
+            goto done;
+        if (x != NULL && !xmldb_rdonly_held(h, db)){
+            x0t = x;
+            rdonly = 1;
+        }
+    }
+#ifdef XMLDB_DEFAULTS_VIRTUAL
+    bottom = 1; /* Copy of each match is needed for its defaults */
+#endif
     /* Here x0t looks like: <config>...</config> */
     /* Given the xpath, return a vector of matches in xvec
      * Can we do everything in one go?
@@ -903,16 +1194,28 @@ xmldb_get_copy(clixon_handle     h,
         goto done;
     xml_flag_set(x1t, XML_FLAG_TOP);
     xml_spec_set(x1t, xml_spec(x0t));
-    if (xlen < 1000){
+    if (xlen < 1000 || rdonly || bottom || depth >= 0){
         /* This is optimized for the case when the tree is large and xlen is small
          * If the tree is large and xlen too, then the other is better.
          * This only works if yang bind
+         * A read-only tree is not marked
          */
         for (i=0; i<xlen; i++){
             x0 = xvec[i];
-            if (xml_copy_from_bottom(x0t, x0, x1t) < 0) /* config */
+            if (xml_copy_from_bottom(x0t, x0, x1t, depth, &x1) < 0) /* config */
+                goto done;
+#ifdef XMLDB_DEFAULTS_VIRTUAL
+            /* Add default values of the matching subtree */
+            if (yb != YB_NONE && x1 && xml_default_recurse(x1, 0, 0) < 0)
                 goto done;
+#endif
         }
+#ifdef XMLDB_DEFAULTS_VIRTUAL
+        /* Add global default values matching xpath, also if there is no match */
+        if (yb != YB_NONE &&
+            xml_global_defaults(h, x1t, nsc, xpath?xpath:"/", yspec0, 0) < 0)
+            goto done;
+#endif
     }
     else {
         /* Iterate through the match vector
@@ -935,13 +1238,13 @@ xmldb_get_copy(clixon_handle     h,
     if (strcmp(db, "candidate") != 0 ||
         (xmldb_modified_get(h, db) == 0 &&
          xmldb_islocked(h, db) == 0)){
-        if (clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG"))
+        if (clicon_option_slot_bool(h, OS_XMLDB_SYSTEM_ONLY_CONFIG))
             if (xmldb_system_only_config(h, xpath?xpath:"/", nsc, &x1t) < 0)
                 goto done;
     }
     /* If empty NACM config, then disable NACM if loaded
      */
-    if (clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY")){
+    if (clicon_option_slot_bool(h, OS_NACM_DISABLED_ON_EMPTY)){
         if (disable_nacm_on_empty(x1t, yspec0) < 0)
             goto done;
     }
@@ -958,6 +1261,87 @@ xmldb_get_copy(clixon_handle     h,
     goto done;
 }
 
+/*! Take the complete datastore tree out of the cache, read from file if cache-miss
+ *
+ * As xmldb_get0 with xpath "/" and copy, but the cache tree itself is handed over to
+ * the caller instead of copied. Used when a datastore is read once, eg startup, and
+ * avoids holding two full trees.
+ * The datastore is left without cache and is re-read from file on next access.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of datastore, eg "startup"
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[out] xtp    Top-level XML tree. Free with xml_free()
+ * @param[out] msdiff If set, return modules-state differences
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1      Error
+ * @note running and volatile datastores are copied, since their cache is shared or not on file
+ */
+int
+xmldb_get_take(clixon_handle     h,
+               const char       *db,
+               yang_bind         yb,
+               cxobj           **xtp,
+               modstate_diff_t  *msdiff,
+               cxobj           **xerr)
+{
+    int        retval = -1;
+    cxobj     *xt = NULL;
+    db_elmnt  *de;
+    yang_stmt *yspec0;
+    int        ret;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "db %s", db);
+    de = clicon_db_elmnt_get(h, db);
+    if (strcmp(db, "running") == 0 || (de && de->de_volatile))
+        return xmldb_get_copy(h, db, yb, NULL, NULL, -1, xtp, msdiff, xerr);
+    if ((yspec0 = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if ((ret = xmldb_get_cache(h, db, yb, &xt, msdiff, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
+        de->de_xml = NULL;
+        de->de_gen = 0;
+        de->de_edit_gen = 0;
+    }
+#ifdef XMLDB_DEFAULTS_VIRTUAL
+    /* The cache has no defaults, add them to the taken tree */
+    if (yb != YB_NONE){
+        if (xml_global_defaults(h, xt, NULL, "/", yspec0, 0) < 0)
+            goto done;
+        if (xml_default_recurse(xt, 0, 0) < 0)
+            goto done;
+    }
+#endif
+    /* Same post-processing as xmldb_get_copy */
+    if (strcmp(db, "candidate") != 0 ||
+        (xmldb_modified_get(h, db) == 0 &&
+         xmldb_islocked(h, db) == 0)){
+        if (clicon_option_slot_bool(h, OS_XMLDB_SYSTEM_ONLY_CONFIG))
+            if (xmldb_system_only_config(h, "/", NULL, &xt) < 0)
+                goto done;
+    }
+    if (clicon_option_slot_bool(h, OS_NACM_DISABLED_ON_EMPTY)){
+        if (disable_nacm_on_empty(xt, yspec0) < 0)
+            goto done;
+    }
+    *xtp = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (xt)
+        xml_free(xt);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Get content of datastore and return a copy of the XML tree
  *
  * @param[in]  h      Clixon handle
@@ -1045,14 +1429,52 @@ xmldb_get0(clixon_handle    h,
            cxobj          **xret,
            modstate_diff_t *msdiff,
            cxobj          **xerr)
+{
+    return xmldb_get_depth(h, db, yb, nsc, xpath, -1, wdef, xret, msdiff, xerr);
+}
+
+/*! Get content of datastore limited to a number of levels
+ *
+ * As xmldb_get0 but only the levels of the tree that a print limited to depth shows are
+ * copied, which avoids copying large subtrees for eg depth=1 gets of large containers.
+ * Matches of xpath below depth are copied with their ancestors and children, so that the
+ * xpath can be applied again to the returned tree.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of datastore, eg "running"
+ * @param[in]  yb     How to bind yang to XML top-level when parsing (if YB_NONE, no defaults)
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath syntax. or NULL for all
+ * @param[in]  depth  Nr of levels below top that are printed, -1 is all
+ * @param[in]  wdef   With-defaults parameter, see RFC 6243
+ * @param[out] xret   Single return XML tree. Free with xml_free()
+ * @param[out] msdiff If set, return modules-state differences (upgrade code)
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1      Error
+ * @note Predicates of xpath may only refer to list keys of ancestors and to children of the
+ *       selected nodes, deeper nodes may not be present in the returned tree
+ * @see xmldb_get0
+ */
+int
+xmldb_get_depth(clixon_handle    h,
+                const char      *db,
+                yang_bind        yb,
+                cvec            *nsc,
+                const char      *xpath,
+                int32_t          depth,
+                withdefaults_type wdef,
+                cxobj          **xret,
+                modstate_diff_t *msdiff,
+                cxobj          **xerr)
 {
     int    retval = -1;
     int    ret;
     cxobj *x = NULL;
 
     if (wdef != WITHDEFAULTS_EXPLICIT)
-        return xmldb_get_copy(h, db, yb, nsc, xpath, xret, msdiff, xerr);
-    if ((ret = xmldb_get_copy(h, db, yb, nsc, xpath, &x, msdiff, xerr)) < 0)
+        return xmldb_get_copy(h, db, yb, nsc, xpath, depth, xret, msdiff, xerr);
+    if ((ret = xmldb_get_copy(h, db, yb, nsc, xpath, depth, &x, msdiff, xerr)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -0,0 +1,756 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Datastore binary snapshot
+  * A snapshot is a pre-sorted binary image of a datastore cache written alongside the XML
+  * datastore file. It is mapped at startup and the tree is rebuilt without XML tokenizing
+  * and, if the effective YANG schema is the same as when written, without sorting.
+  * The XML file is always canonical. The snapshot records size and mtime of the XML file it
+  * was written together with, and is ignored if they do not match.
+  * File layout, native byte order, no padding:
+  *   header: struct snapshot_hdr
+  *   strings: nstr * { uint32 len; char str[len]; '\0' }
+  *   nodes in pre-order:
+  *     uint8 type; uint32 name; uint32 prefix (SNAPSHOT_NOSTR if none)
+  *     CX_ELMNT:          uint32 nchildren, followed by children
+  *     CX_ATTR, CX_BODY:  uint32 len; char value[len]; '\0'
+ */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_file.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_yang_module.h"
+#include "clixon_datastore.h"
+#include "clixon_datastore_snapshot.h"
+
+/*
+ * Constants
+ */
+#define SNAPSHOT_MAGIC   0x42584c43 /* "CLXB" little-endian */
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_NOSTR   UINT32_MAX
+
+/* Local types */
+/*! Snapshot file header
+ */
+struct snapshot_hdr {
+    uint32_t sh_magic;     /* SNAPSHOT_MAGIC */
+    uint32_t sh_version;   /* SNAPSHOT_VERSION */
+    uint64_t sh_yang;      /* Fingerprint of YANG schema, see snapshot_yang_fingerprint */
+    uint64_t sh_size;      /* Size of XML file written together with snapshot */
+    int64_t  sh_mtime;     /* Mtime of XML file, seconds */
+    int64_t  sh_mtime_ns;  /* Mtime of XML file, nanoseconds */
+    uint32_t sh_nstr;      /* Number of strings in string table */
+    uint32_t sh_pad;
+};
+
+/*! State when writing a snapshot
+ */
+struct snapshot_wr {
+    FILE          *sw_f;
+    clicon_hash_t *sw_hash;  /* String -> index in string table */
+    uint32_t       sw_nstr;  /* Number of strings */
+};
+
+/*! State when reading a snapshot
+ */
+struct snapshot_rd {
+    const char  *sr_p;      /* Current position in mapped file */
+    const char  *sr_end;    /* End of mapped file */
+    const char **sr_strv;   /* String table, pointers into mapped file */
+    uint32_t     sr_nstr;
+};
+
+/*! Start FNV-1a hash */
+#define SNAPSHOT_FNV_INIT 0xcbf29ce484222325ULL
+
+/*! FNV-1a hash of a string including terminating zero
+ */
+static uint64_t
+snapshot_fnv(uint64_t    hash,
+             const char *str)
+{
+    const char *s = str ? str : "";
+
+    do {
+        hash ^= (uint8_t)*s;
+        hash *= 0x100000001b3ULL;
+    } while (*s++ != '\0');
+    return hash;
+}
+
+/*! Add a YANG statement and its descendants to a fingerprint
+ *
+ * @param[in]  hash   Fingerprint so far
+ * @param[in]  ys     YANG statement
+ * @retval     hash   Fingerprint including ys
+ */
+static uint64_t
+snapshot_yang_stmt(uint64_t   hash,
+                   yang_stmt *ys)
+{
+    yang_stmt *yc;
+    int        inext;
+
+    hash ^= (uint64_t)yang_keyword_get(ys);
+    hash *= 0x100000001b3ULL;
+    hash = snapshot_fnv(hash, yang_argument_get(ys));
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL)
+        hash = snapshot_yang_stmt(hash, yc);
+    return hash;
+}
+
+/*! Compute fingerprint of the effective YANG schema
+ *
+ * All statements of all modules are included, after features and deviations are applied, so
+ * that any change affecting sorting, such as a changed key, ordered-by or statement order,
+ * changes the fingerprint also if the revision is not bumped.
+ * Children are sorted in YANG order, if the modules are the same, the order is the same
+ * @param[in]  yspec  Top-level yang spec
+ * @retval     fp     Fingerprint
+ */
+static uint64_t
+snapshot_yang_fingerprint(yang_stmt *yspec)
+{
+    if (yspec == NULL)
+        return 0;
+    return snapshot_yang_stmt(SNAPSHOT_FNV_INIT, yspec);
+}
+
+/*! Translate from symbolic database name to snapshot filename
+ *
+ * @param[in]   h        Clixon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Snapshot filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ */
+static int
+xmldb_db2snapshot(clixon_handle h,
+                  const char   *db,
+                  char        **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+        clixon_err(OE_XML, errno, "CLICON_XMLDB_DIR not set");
+        goto done;
+    }
+    cprintf(cb, "%s/%s_db.bin", dir, db);
+    if ((*filename = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Check if snapshots are enabled and applicable
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     1   Enabled
+ * @retval     0   Not enabled
+ */
+int
+xmldb_snapshot_enabled(clixon_handle h)
+{
+    if (!clicon_option_slot_bool(h, OS_XMLDB_SNAPSHOT))
+        return 0;
+    if (clicon_option_slot_str(h, OS_XMLDB_FORMAT) != NULL &&
+        clicon_option_slot_int(h, OS_XMLDB_FORMAT) != FORMAT_XML)
+        return 0;
+    if (clicon_option_slot_bool(h, OS_XMLDB_MULTI) ||
+        clicon_option_slot_bool(h, OS_XMLDB_MODSTATE) ||
+        clicon_option_slot_bool(h, OS_XMLDB_SYSTEM_ONLY_CONFIG))
+        return 0;
+    return 1;
+}
+
+/*! Check if node is written to snapshot, same as with-defaults explicit in the XML file
+ *
+ * @param[in]  x   XML node
+ * @retval     1   Keep
+ * @retval     0   Skip
+ * @see xml2output_wdef
+ */
+static int
+snapshot_keep(cxobj *x)
+{
+    yang_stmt *y;
+    cxobj     *xc;
+
+    if (xml_type(x) != CX_ELMNT || (y = xml_spec(x)) == NULL)
+        return 1;
+    switch (yang_keyword_get(y)){
+    case Y_LEAF:
+        if (xml_flag(x, XML_FLAG_DEFAULT))
+            return 0;
+        break;
+    case Y_CONTAINER:
+        if (yang_find(y, Y_PRESENCE, NULL) != NULL)
+            break;
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+            if (snapshot_keep(xc))
+                return 1;
+        return 0;
+    default:
+        break;
+    }
+    return 1;
+}
+
+/*! Add string to string table and write it, unless already present
+ *
+ * @param[in]  sw   Write state
+ * @param[in]  str  String
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+snapshot_str_add(struct snapshot_wr *sw,
+                 const char         *str)
+{
+    uint32_t len;
+
+    if (str == NULL || clicon_hash_value(sw->sw_hash, str, NULL) != NULL)
+        return 0;
+    if (clicon_hash_add(sw->sw_hash, str, &sw->sw_nstr, sizeof(sw->sw_nstr)) == NULL)
+        return -1;
+    sw->sw_nstr++;
+    len = strlen(str);
+    if (fwrite(&len, sizeof(len), 1, sw->sw_f) != 1 ||
+        fwrite(str, 1, len+1, sw->sw_f) != len+1){
+        clixon_err(OE_UNIX, errno, "fwrite");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Collect and write names and prefixes of tree recursively to string table
+ *
+ * @param[in]  sw   Write state
+ * @param[in]  x    XML node
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+snapshot_strings(struct snapshot_wr *sw,
+                 cxobj              *x)
+{
+    cxobj *xc;
+
+    if (snapshot_str_add(sw, xml_name(x)) < 0)
+        return -1;
+    if (snapshot_str_add(sw, xml_prefix(x)) < 0)
+        return -1;
+    if (xml_type(x) != CX_ELMNT)
+        return 0;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ERROR)) != NULL) {
+        if (!snapshot_keep(xc))
+            continue;
+        if (snapshot_strings(sw, xc) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Get index of string in string table
+ */
+static uint32_t
+snapshot_str_index(struct snapshot_wr *sw,
+                   const char         *str)
+{
+    uint32_t *ip;
+
+    if (str == NULL || (ip = clicon_hash_value(sw->sw_hash, str, NULL)) == NULL)
+        return SNAPSHOT_NOSTR;
+    return *ip;
+}
+
+/*! Write XML node and its children in pre-order
+ *
+ * @param[in]  sw   Write state
+ * @param[in]  x    XML node
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+snapshot_write_node(struct snapshot_wr *sw,
+                    cxobj              *x)
+{
+    uint8_t  type;
+    uint32_t u32[3];
+    char    *val;
+    cxobj   *xc;
+
+    type = xml_type(x);
+    u32[0] = snapshot_str_index(sw, xml_name(x));
+    u32[1] = snapshot_str_index(sw, xml_prefix(x));
+    if (type == CX_ELMNT){
+        u32[2] = 0;
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ERROR)) != NULL)
+            if (snapshot_keep(xc))
+                u32[2]++;
+    }
+    else{
+        val = xml_value(x);
+        u32[2] = val ? strlen(val) : 0;
+    }
+    if (fwrite(&type, sizeof(type), 1, sw->sw_f) != 1 ||
+        fwrite(u32, sizeof(u32), 1, sw->sw_f) != 1)
+        goto err;
+    if (type == CX_ELMNT){
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ERROR)) != NULL) {
+            if (!snapshot_keep(xc))
+                continue;
+            if (snapshot_write_node(sw, xc) < 0)
+                return -1;
+        }
+    }
+    else if (fwrite(u32[2] ? val : "", 1, u32[2]+1, sw->sw_f) != u32[2]+1)
+        goto err;
+    return 0;
+ err:
+    clixon_err(OE_UNIX, errno, "fwrite");
+    return -1;
+}
+
+/*! Write snapshot of datastore tree, after the XML datastore file is written
+ *
+ * Write to a temporary file and rename so that a partial snapshot is never read.
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Symbolic database name, eg "candidate", "running"
+ * @param[in]  xt  Datastore cache, sorted and bound
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+xmldb_snapshot_write(clixon_handle h,
+                     const char   *db,
+                     cxobj        *xt)
+{
+    int                 retval = -1;
+    char               *dbfile = NULL;
+    char               *snapfile = NULL;
+    cbuf               *cbtmp = NULL;
+    struct stat         st = {0,};
+    struct snapshot_hdr hdr = {0,};
+    struct snapshot_wr  sw = {0,};
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if (xmldb_db2snapshot(h, db, &snapfile) < 0)
+        goto done;
+    if (stat(dbfile, &st) < 0){
+        clixon_err(OE_UNIX, errno, "stat(%s)", dbfile);
+        goto done;
+    }
+    if ((cbtmp = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbtmp, "%s.tmp", snapfile);
+    if ((sw.sw_f = fopen(cbuf_get(cbtmp), "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    if ((sw.sw_hash = clicon_hash_init()) == NULL)
+        goto done;
+    /* Header is rewritten when the number of strings is known */
+    if (fwrite(&hdr, sizeof(hdr), 1, sw.sw_f) != 1){
+        clixon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    if (snapshot_strings(&sw, xt) < 0)
+        goto done;
+    if (snapshot_write_node(&sw, xt) < 0)
+        goto done;
+    hdr.sh_magic = SNAPSHOT_MAGIC;
+    hdr.sh_version = SNAPSHOT_VERSION;
+    hdr.sh_yang = snapshot_yang_fingerprint(clicon_dbspec_yang(h));
+    hdr.sh_size = st.st_size;
+    hdr.sh_mtime = st.st_mtim.tv_sec;
+    hdr.sh_mtime_ns = st.st_mtim.tv_nsec;
+    hdr.sh_nstr = sw.sw_nstr;
+    if (fseek(sw.sw_f, 0, SEEK_SET) < 0 ||
+        fwrite(&hdr, sizeof(hdr), 1, sw.sw_f) != 1){
+        clixon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    if (fclose(sw.sw_f) != 0){
+        sw.sw_f = NULL;
+        clixon_err(OE_UNIX, errno, "fclose(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    sw.sw_f = NULL;
+    if (rename(cbuf_get(cbtmp), snapfile) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", snapfile);
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_DATASTORE, "Wrote snapshot %s, %u strings", snapfile, hdr.sh_nstr);
+    retval = 0;
+ done:
+    if (sw.sw_f){
+        fclose(sw.sw_f);
+        unlink(cbuf_get(cbtmp));
+    }
+    if (sw.sw_hash)
+        clicon_hash_free(sw.sw_hash);
+    if (cbtmp)
+        cbuf_free(cbtmp);
+    if (snapfile)
+        free(snapfile);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+/*! Read uint32 from mapped file
+ *
+ * @retval  0   OK
+ * @retval -1   Truncated file
+ */
+static int
+snapshot_u32(struct snapshot_rd *sr,
+             uint32_t           *u32)
+{
+    if (sr->sr_end - sr->sr_p < (ptrdiff_t)sizeof(*u32))
+        return -1;
+    memcpy(u32, sr->sr_p, sizeof(*u32));
+    sr->sr_p += sizeof(*u32);
+    return 0;
+}
+
+/*! Read zero-terminated string of given length from mapped file
+ *
+ * @retval  str  String in mapped file
+ * @retval  NULL Truncated or malformed file
+ */
+static const char *
+snapshot_str(struct snapshot_rd *sr,
+             uint32_t            len)
+{
+    const char *str;
+
+    if (sr->sr_end - sr->sr_p <= (ptrdiff_t)len || sr->sr_p[len] != '\0')
+        return NULL;
+    str = sr->sr_p;
+    sr->sr_p += len + 1;
+    return str;
+}
+
+/*! Rebuild XML node and its children from mapped file
+ *
+ * @param[in]  sr     Read state
+ * @param[in]  xp     Parent, or NULL for top
+ * @param[out] xret   Created node
+ * @retval     1      OK
+ * @retval     0      Malformed snapshot
+ * @retval    -1      Error
+ */
+static int
+snapshot_read_node(struct snapshot_rd *sr,
+                   cxobj              *xp,
+                   cxobj             **xret)
+{
+    uint8_t     type;
+    uint32_t    name;
+    uint32_t    prefix;
+    uint32_t    n;
+    uint32_t    i;
+    const char *val;
+    cxobj      *x;
+    int         ret;
+
+    if (sr->sr_p >= sr->sr_end)
+        return 0;
+    type = (uint8_t)*sr->sr_p++;
+    if (snapshot_u32(sr, &name) < 0 ||
+        snapshot_u32(sr, &prefix) < 0 ||
+        snapshot_u32(sr, &n) < 0)
+        return 0;
+    if (type > CX_BODY || name >= sr->sr_nstr ||
+        (prefix != SNAPSHOT_NOSTR && prefix >= sr->sr_nstr))
+        return 0;
+    if ((x = xml_new(sr->sr_strv[name], xp, type)) == NULL)
+        return -1;
+    if (xret)
+        *xret = x;
+    if (prefix != SNAPSHOT_NOSTR &&
+        xml_prefix_set(x, sr->sr_strv[prefix]) < 0)
+        return -1;
+    if (type == CX_ELMNT){
+        for (i = 0; i < n; i++)
+            if ((ret = snapshot_read_node(sr, x, NULL)) <= 0)
+                return ret;
+    }
+    else {
+        if ((val = snapshot_str(sr, n)) == NULL)
+            return 0;
+        if (xml_value_set(x, val) < 0)
+            return -1;
+    }
+    return 1;
+}
+
+/*! Check if snapshot header was written together with the XML file
+ *
+ * @param[in]  hdr  Snapshot header
+ * @param[in]  st   Status of XML datastore file
+ * @retval     1    Valid
+ * @retval     0    Stale or not a snapshot
+ */
+static int
+snapshot_hdr_valid(struct snapshot_hdr *hdr,
+                   struct stat         *st)
+{
+    return hdr->sh_magic == SNAPSHOT_MAGIC &&
+        hdr->sh_version == SNAPSHOT_VERSION &&
+        hdr->sh_size == (uint64_t)st->st_size &&
+        hdr->sh_mtime == st->st_mtim.tv_sec &&
+        hdr->sh_mtime_ns == st->st_mtim.tv_nsec;
+}
+
+/*! Read datastore tree from snapshot if it is valid for the XML datastore file
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Symbolic database name, eg "candidate", "running"
+ * @param[in]  yspec   Top-level yang spec
+ * @param[out] xtp     Top-level XML tree, not yang-bound. Free with xml_free
+ * @param[out] sorted  Set if YANG is unchanged since written, and tree need not be sorted
+ * @retval     1       OK, xtp set
+ * @retval     0       No valid snapshot, read XML file instead
+ * @retval    -1       Error
+ */
+int
+xmldb_snapshot_read(clixon_handle h,
+                    const char   *db,
+                    yang_stmt    *yspec,
+                    cxobj       **xtp,
+                    int          *sorted)
+{
+    int                  retval = -1;
+    char                *dbfile = NULL;
+    char                *snapfile = NULL;
+    int                  fd = -1;
+    struct stat          st = {0,};
+    struct stat          stx = {0,};
+    void                *map = MAP_FAILED;
+    struct snapshot_hdr  hdr;
+    struct snapshot_rd   sr = {0,};
+    cxobj               *xt = NULL;
+    uint32_t             len;
+    uint32_t             i;
+    int                  ret;
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if (xmldb_db2snapshot(h, db, &snapfile) < 0)
+        goto done;
+    if (stat(dbfile, &stx) < 0)
+        goto fail;
+    if ((fd = open(snapfile, O_RDONLY)) < 0)
+        goto fail;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(hdr))
+        goto fail;
+    if ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+        clixon_err(OE_UNIX, errno, "mmap(%s)", snapfile);
+        goto done;
+    }
+    memcpy(&hdr, map, sizeof(hdr));
+    if (!snapshot_hdr_valid(&hdr, &stx)){
+        clixon_debug(CLIXON_DBG_DATASTORE, "Snapshot %s stale, ignored", snapfile);
+        goto fail;
+    }
+    sr.sr_p = (const char *)map + sizeof(hdr);
+    sr.sr_end = (const char *)map + st.st_size;
+    if ((sr.sr_strv = calloc(hdr.sh_nstr + 1, sizeof(char *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i = 0; i < hdr.sh_nstr; i++){
+        if (snapshot_u32(&sr, &len) < 0 ||
+            (sr.sr_strv[i] = snapshot_str(&sr, len)) == NULL)
+            goto malformed;
+    }
+    sr.sr_nstr = hdr.sh_nstr;
+    if ((ret = snapshot_read_node(&sr, NULL, &xt)) < 0)
+        goto done;
+    if (ret == 0 || sr.sr_p != sr.sr_end)
+        goto malformed;
+    clixon_debug(CLIXON_DBG_DATASTORE, "Read snapshot %s", snapfile);
+    if (sorted)
+        *sorted = (hdr.sh_yang == snapshot_yang_fingerprint(yspec));
+    *xtp = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (sr.sr_strv)
+        free(sr.sr_strv);
+    if (map != MAP_FAILED)
+        munmap(map, st.st_size);
+    if (fd != -1)
+        close(fd);
+    if (snapfile)
+        free(snapfile);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+ malformed:
+    clixon_log(h, LOG_WARNING, "Snapshot %s malformed, ignored", snapfile);
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Copy snapshot along with XML datastore file
+ *
+ * The recorded XML file status is updated to that of the copied XML file.
+ * If the source has no valid snapshot, any target snapshot is removed.
+ * @param[in]  h     Clixon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Target database, XML file already copied
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xmldb_snapshot_copy(clixon_handle h,
+                    const char   *from,
+                    const char   *to)
+{
+    int                 retval = -1;
+    char               *fromfile = NULL;
+    char               *tofile = NULL;
+    char               *dbfile = NULL;
+    struct stat         st = {0,};
+    struct snapshot_hdr hdr;
+    int                 fd = -1;
+    int                 valid = 0;
+
+    if (xmldb_db2snapshot(h, from, &fromfile) < 0)
+        goto done;
+    if (xmldb_db2snapshot(h, to, &tofile) < 0)
+        goto done;
+    if (xmldb_db2file(h, from, &dbfile) < 0)
+        goto done;
+    if (stat(dbfile, &st) == 0 &&
+        (fd = open(fromfile, O_RDONLY)) >= 0 &&
+        pread(fd, &hdr, sizeof(hdr), 0) == sizeof(hdr))
+        valid = snapshot_hdr_valid(&hdr, &st);
+    if (fd != -1){
+        close(fd);
+        fd = -1;
+    }
+    free(dbfile);
+    if (xmldb_db2file(h, to, &dbfile) < 0)
+        goto done;
+    if (!valid || stat(dbfile, &st) < 0){
+        if (unlink(tofile) < 0 && errno != ENOENT){
+            clixon_err(OE_UNIX, errno, "unlink(%s)", tofile);
+            goto done;
+        }
+        goto ok;
+    }
+    if (clicon_file_copy(fromfile, tofile) < 0)
+        goto done;
+    if ((fd = open(tofile, O_WRONLY)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", tofile);
+        goto done;
+    }
+    hdr.sh_size = st.st_size;
+    hdr.sh_mtime = st.st_mtim.tv_sec;
+    hdr.sh_mtime_ns = st.st_mtim.tv_nsec;
+    if (pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)){
+        clixon_err(OE_UNIX, errno, "pwrite(%s)", tofile);
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    if (fromfile)
+        free(fromfile);
+    if (tofile)
+        free(tofile);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
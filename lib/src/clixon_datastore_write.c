@@ -74,6 +74,7 @@
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_json.h"
+#include "clixon_cbor.h"
 #include "clixon_nacm.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_yang_type.h"
@@ -86,7 +87,17 @@
 #include "clixon_xml_map.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
+#include "clixon_datastore_snapshot.h"
 #include "clixon_datastore_read.h"
+#include "clixon_probe.h"
+
+/* Journal record delimiter, cannot appear in encoded XML, see CLICON_XMLDB_JOURNAL */
+#define XMLDB_JOURNAL_EOM "]]>]]>"
+
+#ifdef XMLDB_BULK_INSERT
+/* Minimum number of new list entries in one parent for bulk insert */
+#define XMLDB_BULK_MIN 64
+#endif
 
 /* Local types */
 /* Argument to apply for recursive call to xmldb_multi write calls
@@ -95,6 +106,7 @@
 struct xmldb_multi_write_arg {
     clixon_handle    *mw_h;
     const char       *mw_db;
+    int               mw_multi;  /* Split mode, see xmldb_multi_mode */
     int               mw_pretty;
     withdefaults_type mw_wdef;
     enum format_enum  mw_format;
@@ -539,6 +551,7 @@ choice_other_match(cxobj              *x0,
             case OP_CREATE:
                 if (xml_purge(x0c) < 0)
                     goto done;
+                xml_flag_set(x0, XML_FLAG_DEL);
                 x0c = x0prev;
                 continue;
                 break;
@@ -563,6 +576,49 @@ choice_other_match(cxobj              *x0,
     goto done;
 }
 
+#ifdef XMLDB_BULK_INSERT
+/*! Check if new children of x1 can be bulk inserted in text_modify
+ *
+ * All element children of x1 must be new entries, ie no match in base tree, of the same
+ * ordered-by system config list without a when statement, and at least XMLDB_BULK_MIN.
+ * Then no sibling is searched or inserted with binary search while the entries are appended.
+ * @param[in]  x1     Modification XML node
+ * @param[in]  x0vec  Matching base children of x1:s children, NULL if new
+ * @param[in]  len    Length of x0vec
+ * @retval     1      Yes, bulk insert
+ * @retval     0      No
+ */
+static int
+text_modify_bulk_p(cxobj  *x1,
+                   cxobj **x0vec,
+                   int     len)
+{
+    cxobj     *x1c;
+    yang_stmt *y = NULL;
+    int        i;
+
+    if (len < XMLDB_BULK_MIN)
+        return 0;
+    for (i=0; i<len; i++)
+        if (x0vec[i] != NULL)
+            return 0;
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
+        if (y == NULL)
+            y = xml_spec(x1c);
+        else if (xml_spec(x1c) != y)
+            return 0;
+    }
+    if (y == NULL ||
+        yang_keyword_get(y) != Y_LIST ||
+        yang_config_ancestor(y) == 0 ||
+        yang_find(y, Y_ORDERED_BY, "user") != NULL ||
+        yang_find(y, Y_WHEN, NULL) != NULL)
+        return 0;
+    return 1;
+}
+#endif /* XMLDB_BULK_INSERT */
+
 /*! Modify a base tree x0 with x1 with yang spec y according to operation op
  *
  * @param[in]  h        Clixon handle
@@ -576,6 +632,7 @@ choice_other_match(cxobj              *x0,
  * @param[in]  username User name of requestor for nacm
  * @param[in]  xnacm    NACM XML tree (only if !permit)
  * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[in]  bulk     If set, append a new x0 to x0p unsorted, x0p is sorted by caller
  * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
  * @retval     1        OK
  * @retval     0        Failed (cbret set)
@@ -600,6 +657,7 @@ text_modify(clixon_handle       h,
             char               *username,
             cxobj              *xnacm,
             int                 permit,
+            int                 bulk,
             cbuf               *cbret)
 {
     int        retval = -1;
@@ -627,6 +685,10 @@ text_modify(clixon_handle       h,
     char      *restype;
     int        ismount = 0;
     yang_stmt *mount_yspec = NULL;
+    int        bulkc = 0;      /* Children of x0 appended unsorted */
+#ifdef XMLDB_BULK_INSERT
+    int        bulkstart = 0;  /* Sorted children of x0 before bulk append */
+#endif
 
     if (x1 == NULL){
         clixon_err(OE_XML, EINVAL, "x1 is missing");
@@ -966,6 +1028,7 @@ text_modify(clixon_handle       h,
                     goto done;
                 if (xml_copy(x1, x0) < 0)
                     goto done;
+                xml_flag_set(x0, XML_FLAG_ADD);
                 break;
             } /* anyxml, anydata */
             if (x0==NULL){
@@ -1009,10 +1072,10 @@ text_modify(clixon_handle       h,
                 x1cname = xml_name(x1c);
                 /* Get yang spec of the child by child matching */
                 if ((yc = yang_find_datanode(y0, x1cname)) == NULL){
-                    if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT"))
+                    if (clicon_option_slot_bool(h, OS_YANG_SCHEMA_MOUNT))
                         yc = xml_spec(x1c);
                     if (yc == NULL){
-                        if (clicon_option_bool(h, "CLICON_YANG_UNKNOWN_ANYDATA") == 1){
+                        if (clicon_option_slot_bool(h, OS_YANG_UNKNOWN_ANYDATA) == 1){
                             /* Add dummy Y_ANYDATA yang stmt, see ysp_add */
                             if (NULL == (yc = yang_anydata_add(y0, x1cname)))
                                 goto done;
@@ -1056,20 +1119,29 @@ text_modify(clixon_handle       h,
                 }
                 i++;
             }
+#ifdef XMLDB_BULK_INSERT
+            /* Bulk insert if all children are many new entries of one list */
+            if ((permit || xnacm == NULL) &&
+                text_modify_bulk_p(x1, x0vec, i)){
+                bulkc = 1;
+                bulkstart = xml_child_nr(x0);
+            }
+#endif
             /* Second pass: Loop through children of the x1 modification tree again
              * Now potentially modify x0:s children 
              * Here x0vec contains one-to-one matching nodes of x1:s children.
              */
+            ret = 1;
             x1c = NULL;
             i = 0;
             while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
                 x0c = x0vec[i++];
                 x1cname = xml_name(x1c);
                 if ((yc = yang_find_datanode(y0, x1cname)) == NULL){
-                    if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT"))
+                    if (clicon_option_slot_bool(h, OS_YANG_SCHEMA_MOUNT))
                         yc = xml_spec(x1c);
                 }
-                if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
+                if (clicon_option_slot_bool(h, OS_YANG_SCHEMA_MOUNT)){
                     /* Check if xc is unresolved mountpoint, ie no yang mount binding yet */
                     if ((ismount = xml_yang_mount_get(h, x1c, NULL, NULL, &mount_yspec)) < 0)
                         goto done;
@@ -1080,18 +1152,25 @@ text_modify(clixon_handle       h,
                     else{
                         if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
                                                yc, op,
-                                               username, xnacm, permit, cbret)) < 0)
+                                               username, xnacm, permit, bulkc, cbret)) < 0)
                             goto done;
                     }
                 }
                 else if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
                                             yc, op,
-                                            username, xnacm, permit, cbret)) < 0)
+                                            username, xnacm, permit, bulkc, cbret)) < 0)
                     goto done;
                 /* If xml return - ie netconf error xml tree, then stop and return OK */
                 if (ret == 0)
-                    goto fail;
+                    break;
             }
+#ifdef XMLDB_BULK_INSERT
+            /* Sort appended entries once and merge, also on failure to leave x0 sorted */
+            if (bulkc && xml_sort_merge(x0, bulkstart) < 0)
+                goto done;
+#endif
+            if (ret == 0)
+                goto fail;
             if (changed){
                 /* Add to parent unless tree is 100% none */
                 if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) < 0)
@@ -1101,7 +1180,11 @@ text_modify(clixon_handle       h,
 #ifdef XML_PARENT_CANDIDATE
                     xml_parent_candidate_set(x0, NULL);
 #endif
-                    if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
+                    if (bulk){ /* Appended unsorted, x0p is sorted by caller */
+                        if (xml_addsub(x0p, x0) < 0)
+                            goto done;
+                    }
+                    else if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
                         goto done;
                     xml_flag_set(x0, XML_FLAG_ADD);
                 }
@@ -1223,6 +1306,7 @@ text_modify_top(clixon_handle       h,
                 while ((x0c = xml_child_i(x0t, 0)) != 0)
                     if (xml_purge(x0c) < 0)
                         goto done;
+                xml_flag_set(x0t, XML_FLAG_DEL);
                 break;
             default:
                 break;
@@ -1271,6 +1355,7 @@ text_modify_top(clixon_handle       h,
         while ((x0c = xml_child_i(x0t, 0)) != 0)
             if (xml_purge(x0c) < 0)
                 goto done;
+        xml_flag_set(x0t, XML_FLAG_DEL);
     }
     /* Loop through children of the modification tree */
     x1c = NULL;
@@ -1284,7 +1369,7 @@ text_modify_top(clixon_handle       h,
             yc = yang_find_datanode(ymod, x1cname);
         if (yc == NULL){
             if (ymod != NULL &&
-                clicon_option_bool(h, "CLICON_YANG_UNKNOWN_ANYDATA") == 1){
+                clicon_option_slot_bool(h, OS_YANG_UNKNOWN_ANYDATA) == 1){
                 /* Add dummy Y_ANYDATA yang stmt, see ysp_add */
                 if (NULL == (yc = yang_anydata_add(ymod, x1cname)))
                     goto done;
@@ -1310,7 +1395,7 @@ text_modify_top(clixon_handle       h,
         }
         if ((ret = text_modify(h, x0c, x0t, x0t, x1c, x1t,
                                yc, op,
-                               username, xnacm, permit, cbret)) < 0)
+                               username, xnacm, permit, 0, cbret)) < 0)
             goto done;
         /* If xml return - ie netconf error xml tree, then stop and return OK */
         if (ret == 0)
@@ -1368,6 +1453,373 @@ xml_mark_cache_dirty(cxobj *x,
     return 2;
 }
 
+#ifdef XMLDB_EDIT_MARK
+/*! Remove edit marks, only descend into marked nodes
+ *
+ * @param[in]  x    XML node
+ */
+static void
+xmldb_edit_unmark(cxobj *x)
+{
+    cxobj *xc;
+
+    xml_flag_reset(x, XML_FLAG_EDIT);
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+        if (xml_flag(xc, XML_FLAG_EDIT))
+            xmldb_edit_unmark(xc);
+}
+
+/*! Mark nodes changed by an edit with XML_FLAG_EDIT
+ *
+ * Called twice in xmldb_put, before and after default values are added and empty
+ * non-presence containers are removed.
+ * The first pass tags existing children of changed nodes, the second marks changed nodes,
+ * added subtrees and untagged children, ie created by defaults.
+ * Subtrees of deleted (XML_FLAG_DEL) nodes are traversed entirely, as are the defaults.
+ * Marks are set on all ancestors, ie an unmarked node is unchanged.
+ * @param[in]  x     XML node
+ * @param[in]  post  0: First pass, 1: second pass
+ * @param[in]  all   Traverse all children, not only changed
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml_diff_marked
+ */
+static int
+xmldb_edit_mark(cxobj *x,
+                int    post,
+                int    all)
+{
+    int        retval = -1;
+    cxobj     *xc;
+    yang_stmt *y;
+
+    if (xml_flag(x, XML_FLAG_DEL))
+        all = 1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+        if (xml_flag(xc, XML_FLAG_ADD)){
+            if (post &&
+                xml_apply0(xc, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_EDIT) < 0)
+                goto done;
+            continue;
+        }
+        if (post == 0){
+            xml_flag_set(xc, XML_FLAG_TRANSIENT);
+            /* May be removed as empty non-presence container */
+            if (all && xml_child_nr_type(xc, CX_ELMNT) == 0 &&
+                (y = xml_spec(xc)) != NULL &&
+                yang_keyword_get(y) == Y_CONTAINER &&
+                yang_find(y, Y_PRESENCE, NULL) == NULL)
+                xml_apply_ancestor(xc, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_EDIT);
+        }
+        else if (xml_flag(xc, XML_FLAG_TRANSIENT))
+            xml_flag_reset(xc, XML_FLAG_TRANSIENT);
+        else { /* Created after first pass */
+            if (xml_apply0(xc, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_EDIT) < 0)
+                goto done;
+            xml_apply_ancestor(xc, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_EDIT);
+            continue;
+        }
+        if ((all || xml_flag(xc, XML_FLAG_CHANGE|XML_FLAG_DEL)) &&
+            xmldb_edit_mark(xc, post, all) < 0)
+            goto done;
+    }
+    if (post && xml_flag(x, XML_FLAG_CHANGE|XML_FLAG_DEL))
+        xml_flag_set(x, XML_FLAG_EDIT);
+    retval = 0;
+ done:
+    return retval;
+}
+#endif /* XMLDB_EDIT_MARK */
+
+/*! Callback function for checking if the top-level datastore file is changed
+ *
+ * Use the add/del marks of xmldb_put. In multi mode, changes in split sub-trees are written
+ * to sub-files and do not affect the top-level file, unless the sub-tree itself is added.
+ * @param[in]  x    XML node
+ * @param[in]  arg  Split mode, see xmldb_multi_mode
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     1    Abort: top-level file is changed
+ * @retval     0    OK, continue
+ * @retval    -1    Error
+ */
+static int
+xmldb_dirty_applyfn(cxobj *x,
+                    void  *arg)
+{
+    int multi = (intptr_t)arg;
+    int ret;
+
+    if (multi){
+        if ((ret = xml_multi_split(x, multi)) < 0)
+            return -1;
+        if (ret == 1)
+            return xml_flag(x, XML_FLAG_ADD) ? 1 : 2;
+    }
+    if (xml_flag(x, XML_FLAG_ADD|XML_FLAG_DEL))
+        return 1;
+    return 0;
+}
+
+/*! Check if datastore journal is used
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     1    Yes, edits are appended to journal
+ * @retval     0    No
+ * @see CLICON_XMLDB_JOURNAL
+ */
+static int
+xmldb_journal_enabled(clixon_handle h)
+{
+    if (!clicon_option_slot_bool(h, OS_XMLDB_JOURNAL))
+        return 0;
+    if (clicon_option_slot_bool(h, OS_XMLDB_MULTI))
+        return 0;
+    if (clicon_option_slot_str(h, OS_XMLDB_FORMAT) != NULL &&
+        clicon_option_slot_int(h, OS_XMLDB_FORMAT) != FORMAT_XML)
+        return 0;
+    return 1;
+}
+
+/*! Make a copy of a modification tree for the journal
+ *
+ * Must be made before the edit since operation attributes are removed by text_modify
+ * Namespaces of ancestors of the modification tree are added to the copy
+ * @param[in]  x1   Modification tree, top-level <config>
+ * @param[out] xjp  Copy, free with xml_free()
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_journal_dup(cxobj  *x1,
+                  cxobj **xjp)
+{
+    int    retval = -1;
+    cxobj *xj = NULL;
+    cvec  *nsc = NULL;
+
+    if ((xj = xml_dup(x1)) == NULL)
+        goto done;
+    if (xml_nsctx_node(x1, &nsc) < 0)
+        goto done;
+    if (xmlns_set_all(xj, nsc) < 0)
+        goto done;
+    xml_sort(xj);
+    *xjp = xj;
+    xj = NULL;
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (xj)
+        xml_free(xj);
+    return retval;
+}
+
+/*! Append an edit as a record to the datastore journal and sync it to disk
+ *
+ * A record looks like: <edit operation="merge"><config>...</config></edit>]]>]]>
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Datastore
+ * @param[in]  op   Top-level operation
+ * @param[in]  xj   Copy of modification tree, see xmldb_journal_dup, or NULL
+ * @param[out] szp  Size of journal after append
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_journal_append(clixon_handle       h,
+                     const char         *db,
+                     enum operation_type op,
+                     cxobj              *xj,
+                     size_t             *szp)
+{
+    int         retval = -1;
+    char       *jfile = NULL;
+    FILE       *f = NULL;
+    struct stat st = {0,};
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if ((f = fopen(jfile, "a")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", jfile);
+        goto done;
+    }
+    fprintf(f, "<edit operation=\"%s\">", xml_operation2str(op));
+    if (xj != NULL &&
+        clixon_xml2file(f, xj, 0, 0, NULL, fprintf, 0, 0) < 0)
+        goto done;
+    fprintf(f, "</edit>%s\n", XMLDB_JOURNAL_EOM);
+    if (fflush(f) != 0 || fsync(fileno(f)) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", jfile);
+        goto done;
+    }
+    if (fstat(fileno(f), &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat(%s)", jfile);
+        goto done;
+    }
+    *szp = st.st_size;
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (jfile)
+        free(jfile);
+    return retval;
+}
+
+/*! Empty datastore journal, eg after the complete datastore has been written
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Datastore
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xmldb_journal_reset(clixon_handle h,
+                    const char   *db)
+{
+    int         retval = -1;
+    char       *jfile = NULL;
+    struct stat st = {0,};
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if (lstat(jfile, &st) == 0 && st.st_size > 0)
+        if (truncate(jfile, 0) < 0){
+            clixon_err(OE_DB, errno, "truncate %s", jfile);
+            goto done;
+        }
+    retval = 0;
+ done:
+    if (jfile)
+        free(jfile);
+    return retval;
+}
+
+/*! Replay datastore journal on a base tree read from file
+ *
+ * Each record is applied as an edit without NACM. An incomplete last record, eg from a crash
+ * while appending, is ignored: it was not synced and the edit was never acknowledged.
+ * A complete record that fails fails the replay, since the datastore would otherwise silently
+ * differ from what was committed.
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Datastore
+ * @param[in]  x0    Base tree, top-level <config>, bound to yang
+ * @param[in]  yspec Yang spec
+ * @retval     0     OK
+ * @retval    -1     Error, including a record that cannot be applied
+ * @see xmldb_readfile  Only replayed if base tree is bound to yang (YB_MODULE)
+ */
+int
+xmldb_journal_replay(clixon_handle h,
+                     const char   *db,
+                     cxobj        *x0,
+                     yang_stmt    *yspec)
+{
+    int                 retval = -1;
+    char               *jfile = NULL;
+    int                 fd = -1;
+    struct stat         st = {0,};
+    char               *buf = NULL;
+    char               *rec;
+    char               *eom;
+    cxobj              *xt = NULL;
+    cxobj              *xe;
+    cxobj              *x1;
+    char               *opstr;
+    enum operation_type op;
+    cbuf               *cbret = NULL;
+    int                 nr = 0;
+    int                 ret;
+
+    if (!xmldb_journal_enabled(h))
+        goto ok;
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if (lstat(jfile, &st) < 0 || st.st_size == 0)
+        goto ok;
+    if ((fd = open(jfile, O_RDONLY)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", jfile);
+        goto done;
+    }
+    if ((buf = malloc(st.st_size + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    if (read(fd, buf, st.st_size) != st.st_size){
+        clixon_err(OE_UNIX, errno, "read(%s)", jfile);
+        goto done;
+    }
+    buf[st.st_size] = '\0';
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    rec = buf;
+    while ((eom = strstr(rec, XMLDB_JOURNAL_EOM)) != NULL){
+        *eom = '\0';
+        if (clixon_xml_parse_string(rec, YB_NONE, yspec, &xt, NULL) < 0)
+            goto done;
+        rec = eom + strlen(XMLDB_JOURNAL_EOM);
+        op = OP_MERGE;
+        if ((xe = xml_find_type(xt, NULL, "edit", CX_ELMNT)) != NULL &&
+            (opstr = xml_find_value(xe, "operation")) != NULL &&
+            xml_operation(opstr, &op) < 0)
+            goto done;
+        if (xe == NULL ||
+            (x1 = xml_find_type(xe, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) == NULL){
+            if ((x1 = xml_new(NETCONF_INPUT_CONFIG, xe, CX_ELMNT)) == NULL)
+                goto done;
+        }
+        cbuf_reset(cbret);
+        if ((ret = xml_bind_yang(h, x1, YB_MODULE, yspec, 0, NULL)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err(OE_DB, 0, "%s journal record %d does not match YANG", db, nr);
+            goto done;
+        }
+        if ((ret = text_modify_top(h, x0, x1, yspec, op, NULL, NULL, 1, cbret)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err(OE_DB, 0, "%s journal record %d failed: %s", db, nr, cbuf_get(cbret));
+            goto done;
+        }
+        xml_free(xt);
+        xt = NULL;
+        nr++;
+    }
+    if (*rec != '\0' && strspn(rec, " \t\n") != strlen(rec))
+        clixon_log(h, LOG_WARNING, "%s: %s incomplete journal record ignored", __func__, db);
+    clixon_debug(CLIXON_DBG_DATASTORE, "%s: %d journal records replayed", db, nr);
+    /* Same cleanup as xmldb_put */
+    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
+        goto done;
+    if (xml_apply(x0, CX_ELMNT, xml_mark_added_ancestors, (void*)(XML_FLAG_ADD|XML_FLAG_DEL)) < 0)
+        goto done;
+    if (xml_default_nopresence(x0, 3, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
+        goto done;
+    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                  (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE)) < 0)
+        goto done;
+    xml_flag_reset(x0, XML_FLAG_DEL);
+ ok:
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    if (xt)
+        xml_free(xt);
+    if (buf)
+        free(buf);
+    if (fd != -1)
+        close(fd);
+    if (jfile)
+        free(jfile);
+    return retval;
+}
+
 /*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
@@ -1412,6 +1864,9 @@ xmldb_put(clixon_handle       h,
     cvec       *nsc = NULL; /* nacm namespace context */
     int         firsttime = 0;
     cxobj      *xerr = NULL;
+    cxobj      *xj = NULL;
+    size_t      jsz = 0;
+    uint64_t    editgen = 0;
 
     clixon_debug(CLIXON_DBG_DATASTORE|CLIXON_DBG_DETAIL, "db %s", db);
     if (cbret == NULL){
@@ -1429,6 +1884,18 @@ xmldb_put(clixon_handle       h,
     }
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
         x0 = de->de_xml; /* XXX flag is not XML_FLAG_TOP */
+#ifdef XMLDB_EDIT_MARK
+        if (x0 != NULL){
+            if (de->de_gen != 0){ /* Mark edits relative to this content */
+                xmldb_edit_unmark(x0);
+                editgen = de->de_gen;
+            }
+            else
+                editgen = de->de_edit_gen;
+        }
+        de->de_edit_gen = 0; /* Reset until this edit is marked */
+#endif
+        de->de_gen = 0;  /* Content is modified */
     }
     /* If there is no xml x0 tree (in cache), then read it from file */
     if (x0 == NULL){
@@ -1438,12 +1905,14 @@ xmldb_put(clixon_handle       h,
             goto done;
         if (ret == 0)
             goto fail;
+#ifndef XMLDB_DEFAULTS_VIRTUAL
         /* Add default global values (see also xmldb_populate) */
         if (xml_global_defaults(h, x0, nsc, "/", yspec, 0) < 0)
             goto done;
         /* Add default recursive values */
         if (xml_default_recurse(x0, 0, 0) < 0)
             goto done;
+#endif
     }
     if (strcmp(xml_name(x0), DATASTORE_TOP_SYMBOL) !=0 ||
         xml_flag(x0, XML_FLAG_TOP) == 0){
@@ -1456,6 +1925,10 @@ xmldb_put(clixon_handle       h,
     permit = (xnacm==NULL);
     /* Here assume if xnacm is set and !permit do NACM */
     clicon_data_del(h, "objectexisted");
+    /* Copy edit for journal before it is consumed */
+    if (x1 && xmldb_journal_enabled(h) &&
+        xmldb_journal_dup(x1, &xj) < 0)
+        goto done;
     /*
      * Modify base tree x with modification x1. This is where the
      * new tree is made.
@@ -1474,9 +1947,18 @@ xmldb_put(clixon_handle       h,
     /* Remove NONE nodes if all subs recursively are also NONE */
     if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
         goto done;
+#ifdef XML_EXPLICIT_INDEX
+    if (clixon_debug_isset(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL) &&
+        xml_apply0(x0, CX_ELMNT, xml_search_index_verify, NULL) < 0)
+        goto done;
+#endif
     /* Mark ancestor if any changes to children. */
     if (xml_apply(x0, CX_ELMNT, xml_mark_added_ancestors, (void*)(XML_FLAG_ADD|XML_FLAG_DEL)) < 0)
         goto done;
+#ifdef XMLDB_EDIT_MARK
+    if (editgen && xmldb_edit_mark(x0, 0, 0) < 0)
+        goto done;
+#endif
     /* Mark changed xml as cache dirty */
     if (xml_apply(x0, CX_ELMNT, xml_mark_cache_dirty, NULL) < 0)
         goto done;
@@ -1484,6 +1966,7 @@ xmldb_put(clixon_handle       h,
      */
     if (xml_default_nopresence(x0, 3, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
         goto done;
+#ifndef XMLDB_DEFAULTS_VIRTUAL
     /* Complete defaults
      */
     if (xml_global_defaults(h, x0, nsc, "/", yspec, 0) < 0)
@@ -1496,17 +1979,37 @@ xmldb_put(clixon_handle       h,
      */
     if (xml_default_recurse(x0, 0, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
         goto done;
+#endif
+#endif /* XMLDB_DEFAULTS_VIRTUAL */
+#ifdef XMLDB_EDIT_MARK
+    /* Mark edit after defaults */
+    if (editgen && xmldb_edit_mark(x0, 1, 0) < 0)
+        goto done;
 #endif
     /* Write back to datastore cache if first time */
     if (de != NULL)
         de0 = *de;
     if (de0.de_xml == NULL)
         de0.de_xml = x0;
+    de0.de_edit_gen = editgen;
     de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
     clicon_db_elmnt_set(h, db, &de0);
     /* Write cache to file unless volatile (ie stop syncing to store) */
     if (xmldb_volatile_get(h, db) == 0){
-        if (xmldb_write_cache2file(h, db) < 0)
+        if (xmldb_journal_enabled(h) && xmldb_exists(h, db) == 1){
+            /* Append edit to journal if changed, fold journal into base file if too large */
+            if (xml_flag(x0, XML_FLAG_DEL) ||
+                (ret = xml_apply(x0, CX_ELMNT, xmldb_dirty_applyfn, (void*)0)) == 1){
+                if (xmldb_journal_append(h, db, op, xj, &jsz) < 0)
+                    goto done;
+                if (jsz > (size_t)clicon_option_slot_int(h, OS_XMLDB_JOURNAL_SIZE) &&
+                    xmldb_write_cache2file(h, db) < 0)
+                    goto done;
+            }
+            else if (ret < 0)
+                goto done;
+        }
+        else if (xmldb_write_cache2file1(h, db, 1) < 0)
             goto done;
         /* Clear flags from previous steps + dirty */
         if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
@@ -1519,9 +2022,12 @@ xmldb_put(clixon_handle       h,
                       (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE)) < 0)
             goto done;
     }
+    xml_flag_reset(x0, XML_FLAG_DEL); /* Top-level purge, see text_modify_top */
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (xj)
+        xml_free(xj);
     if (xerr)
         xml_free(xerr);
     if (nsc)
@@ -1549,8 +2055,7 @@ xmldb_multi_write_applyfn(cxobj *x,
     struct xmldb_multi_write_arg *mw = (struct xmldb_multi_write_arg *) arg;
     int           retval = -1;
     clixon_handle h = mw->mw_h;
-    yang_stmt    *y;
-    int           exist = 0;
+    int           ret;
     char         *xpath = NULL;
     char         *hexstr = NULL;
     cbuf         *cb = NULL;
@@ -1560,41 +2065,38 @@ xmldb_multi_write_applyfn(cxobj *x,
     int           fd = -1;
     FILE         *fsub = NULL;
 
-    if (xml_child_nr_type(x, CX_ELMNT) > 0 &&
-        (y = xml_spec(x)) != NULL){
-        if (yang_extension_value(y, "xmldb-split", CLIXON_LIB_NS, &exist, NULL) < 0)
+    if ((ret = xml_multi_split(x, mw->mw_multi)) < 0)
+        goto done;
+    if (ret == 1){
+        if (xml2xpath(x, NULL, 1, 0, &xpath) < 0)
             goto done;
-        if (exist){
-            if (xml2xpath(x, NULL, 1, 0, &xpath) < 0)
-                goto done;
-            if (clixon_digest_hex(xpath, &hexstr) < 0)
-                goto done;
-            if (xmldb_db2subdir(h, mw->mw_db, &subdir) < 0)
-                goto done;
-            if ((cb = cbuf_new()) == NULL){
-                clixon_err(OE_XML, errno, "cbuf_new");
+        if (clixon_digest_hex(xpath, &hexstr) < 0)
+            goto done;
+        if (xmldb_db2subdir(h, mw->mw_db, &subdir) < 0)
+            goto done;
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "%s/%s.xml", subdir, hexstr);
+        dbfile = cbuf_get(cb);
+        if (xml_flag(x, XML_FLAG_CACHE_DIRTY) ||
+            lstat(dbfile, &st) < 0){
+            clixon_debug(CLIXON_DBG_DATASTORE, "Open: %s for writing", dbfile);
+            if ((fd = open(dbfile, O_CREAT|O_WRONLY|O_TRUNC, S_IRWXU)) < 0) {
+                clixon_err(OE_UNIX, errno, "open(%s)", dbfile);
                 goto done;
             }
-            cprintf(cb, "%s/%s.xml", subdir, hexstr);
-            dbfile = cbuf_get(cb);
-            if (xml_flag(x, XML_FLAG_CACHE_DIRTY) ||
-                lstat(dbfile, &st) < 0){
-                clixon_debug(CLIXON_DBG_DATASTORE, "Open: %s for writing", dbfile);
-                if ((fd = open(dbfile, O_CREAT|O_WRONLY|O_TRUNC, S_IRWXU)) < 0) {
-                    clixon_err(OE_UNIX, errno, "open(%s)", dbfile);
-                    goto done;
-                }
-                if ((fsub = fdopen(fd, "w")) == NULL){
-                    clixon_err(OE_CFG, errno, "fdopen(%s)", dbfile);
-                    goto done;
-                }
-                /* Dont recurse multi-file yet */
-                if (clixon_xml2file1(fsub, x, 0, mw->mw_pretty, NULL, fprintf, 1, 0, mw->mw_wdef, 0, 0) < 0)
-                    goto done;
+            if ((fsub = fdopen(fd, "w")) == NULL){
+                clixon_err(OE_CFG, errno, "fdopen(%s)", dbfile);
+                goto done;
             }
-            retval = 2; /* Locally abort */
-            goto done;
+            /* Dont recurse multi-file yet */
+            if (clixon_xml2file1(fsub, x, 0, mw->mw_pretty, NULL, fprintf, 1, 0, mw->mw_wdef, 0, 0) < 0)
+                goto done;
         }
+        retval = 2; /* Locally abort */
+        goto done;
     }
     retval = 0;
  done:
@@ -1614,12 +2116,12 @@ xmldb_multi_write_applyfn(cxobj *x,
 /* Given open file, xml-tree, and wdef, add modstate, get format and write to file
  *
  * @param[in]  h        Clixon handle
- * @param[in]  f        Output file
+ * @param[in]  f        Output file. If NULL and multi, only write changed sub-files
  * @param[in]  xt       Top of XML tree
  * @param[in]  format   Output format
  * @param[in]  pretty   Pretty-print
  * @param[in]  wdef     With-defaults parameter
- * @param[in]  multi    If split into multiple files
+ * @param[in]  multi    Split mode if split into multiple files, see xmldb_multi_mode
  * @param[in]  multidb  Database name (only if multi)
  * @retval     0        OK
  * @retval    -1        Error
@@ -1656,12 +2158,14 @@ xmldb_dump(clixon_handle     h,
     }
     switch (format){
     case FORMAT_XML:
-        if (clixon_xml2file1(f, xt, 0, pretty, NULL, fprintf, 0, 0, wdef, multi,
-                             clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")) < 0)
+        if (f != NULL &&
+            clixon_xml2file1(f, xt, 0, pretty, NULL, fprintf, 0, 0, wdef, multi,
+                             clicon_option_slot_bool(h, OS_XMLDB_SYSTEM_ONLY_CONFIG)) < 0)
             goto done;
         if (multi){
             mw.mw_h = h;
             mw.mw_db = multidb;
+            mw.mw_multi = multi;
             mw.mw_pretty = pretty;
             mw.mw_wdef = wdef;
             mw.mw_format = format;
@@ -1675,7 +2179,16 @@ xmldb_dump(clixon_handle     h,
             goto done;
         }
         if (clixon_json2file(f, xt, pretty, fprintf, 0, 0,
-                             clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")) < 0)
+                             clicon_option_slot_bool(h, OS_XMLDB_SYSTEM_ONLY_CONFIG)) < 0)
+            goto done;
+        break;
+    case FORMAT_CBOR:
+        if (multi){
+            clixon_err(OE_CFG, errno, "CBOR+multi not supported");
+            goto done;
+        }
+        if (clixon_cbor2file(f, xt, 0,
+                             clicon_option_slot_bool(h, OS_XMLDB_SYSTEM_ONLY_CONFIG)) < 0)
             goto done;
         break;
     default:
@@ -1696,14 +2209,20 @@ xmldb_dump(clixon_handle     h,
 /*! Given datastore, get cache and format, set wdef, add modstate and print to multiple files
  *
  * Also add mod-state if applicable
- * @param[in]  h   Clixon handle
- * @param[in]  db  Name of database to search in (filename including dir path
- * @retval     0   OK
- * @retval    -1   Error
+ * If incremental, use the marks made by xmldb_put to only write what is changed: in single-file
+ * mode skip writing if nothing is changed, in multi mode only write changed sub-files and
+ * the top-level file only if changed outside the sub-files.
+ * @param[in]  h           Clixon handle
+ * @param[in]  db          Name of database to search in (filename including dir path
+ * @param[in]  incremental If set, cache is marked with XML_FLAG_ADD/DEL by xmldb_put
+ * @retval     0           OK
+ * @retval    -1           Error
+ * @see xmldb_write_cache2file  Write all
  */
 int
-xmldb_write_cache2file(clixon_handle h,
-                       const char   *db)
+xmldb_write_cache2file1(clixon_handle h,
+                        const char   *db,
+                        int           incremental)
 {
     int               retval = -1;
     cxobj            *xt;
@@ -1714,16 +2233,19 @@ xmldb_write_cache2file(clixon_handle h,
     int               multi;
     FILE             *f = NULL;
     char             *dbfile = NULL;
+    int               dirty = 1;
+    struct stat       st = {0,};
     int               ret;
 
+    CLIXON_PROBE1(datastore__write__start, db);
     if ((xt = xmldb_cache_get(h, db)) == NULL){
         clixon_err(OE_XML, 0, "XML cache not found");
         goto done;
     }
-    pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
-    multi = clicon_option_bool(h, "CLICON_XMLDB_MULTI");
-    if ((formatstr = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) != NULL){
-        if ((ret = format_str2int(formatstr)) < 0){
+    pretty = clicon_option_slot_bool(h, OS_XMLDB_PRETTY);
+    multi = xmldb_multi_mode(h);
+    if ((formatstr = clicon_option_slot_str(h, OS_XMLDB_FORMAT)) != NULL){
+        if ((ret = clicon_option_slot_int(h, OS_XMLDB_FORMAT)) < 0){
             clixon_err(OE_XML, 0, "Format %s invalid", formatstr);
             goto done;
         }
@@ -1731,17 +2253,61 @@ xmldb_write_cache2file(clixon_handle h,
     }
     if (xmldb_db2file(h, db, &dbfile) < 0)
         goto done;
-    if ((f = fopen(dbfile, "w")) == NULL){
-        clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
-        goto done;
+    if (incremental &&
+        xml_flag(xt, XML_FLAG_DEL) == 0 && /* Top-level purge */
+        lstat(dbfile, &st) == 0){
+        if ((ret = xml_apply(xt, CX_ELMNT, xmldb_dirty_applyfn, (void*)(intptr_t)multi)) < 0)
+            goto done;
+        dirty = ret;
+    }
+    if (dirty){
+        if ((f = fopen(dbfile, "w")) == NULL){
+            clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
+            goto done;
+        }
+    }
+    else if (!multi){
+        clixon_debug(CLIXON_DBG_DATASTORE, "%s unchanged, not written", dbfile);
+        goto ok;
     }
     if (xmldb_dump(h, f, xt, format, pretty, wdef, multi, db) < 0)
         goto done;
+    if (f != NULL && xmldb_journal_enabled(h) &&
+        xmldb_journal_reset(h, db) < 0) /* Journal is now folded into base file */
+        goto done;
+    if (f != NULL && xmldb_snapshot_enabled(h)){
+        /* Close first: snapshot records status of the written XML file */
+        if (fclose(f) != 0){
+            f = NULL;
+            clixon_err(OE_UNIX, errno, "fclose(%s)", dbfile);
+            goto done;
+        }
+        f = NULL;
+        if (xmldb_snapshot_write(h, db, xt) < 0)
+            goto done;
+    }
+ ok:
     retval = 0;
  done:
     if (dbfile)
         free(dbfile);
     if (f)
         fclose(f);
+    CLIXON_PROBE2(datastore__write__done, db, retval);
     return retval;
 }
+
+/*! Given datastore, get cache and format, set wdef, add modstate and print to multiple files
+ *
+ * Also add mod-state if applicable
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Name of database to search in (filename including dir path
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+xmldb_write_cache2file(clixon_handle h,
+                       const char   *db)
+{
+    return xmldb_write_cache2file1(h, db, 0);
+}
@@ -47,6 +47,9 @@
  */
 int xmldb_put(clixon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret);
 int xmldb_write_cache2file(clixon_handle h, const char *db);
+int xmldb_write_cache2file1(clixon_handle h, const char *db, int incremental);
 int xmldb_dump(clixon_handle h, FILE *f, cxobj *xt, enum format_enum format, int pretty, withdefaults_type wdef, int multi, const char *multidb);
+int xmldb_journal_reset(clixon_handle h, const char *db);
+int xmldb_journal_replay(clixon_handle h, const char *db, cxobj *x0, yang_stmt *yspec);
 
 #endif /* _CLIXON_DATASTORE_WRITE_H */
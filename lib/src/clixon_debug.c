@@ -86,8 +86,9 @@ static clixon_handle _debug_clixon_h    = NULL;
  * usefulness, since not all functions have access to a handle.
  * A compromise solution is now in place where h can be provided in the function call, but
  * tolerates NULL, in which case a cached handle is used.
+ * Not static since it is read inline by clixon_debug_isset() in the debug macros
  */
-static int _debug_level = 0;
+int _clixon_debug_level = 0;
 
 /*! Mapping between Clixon debug symbolic names <--> bitfields
  *
@@ -113,6 +114,7 @@ static const map_str2int dbgmap[] = {
     {"rpc",       CLIXON_DBG_RPC},
     {"stream",    CLIXON_DBG_STREAM},
     {"parse",     CLIXON_DBG_PARSE},
+    {"profile",   CLIXON_DBG_PROFILE},
     {"app",       CLIXON_DBG_APP},
     {"app2",      CLIXON_DBG_APP2},
     {"app3",      CLIXON_DBG_APP3},
@@ -184,7 +186,7 @@ clixon_debug_init(clixon_handle h,
                   int           dbglevel)
 {
     _debug_clixon_h = h;
-    _debug_level = dbglevel; /* Global variable */
+    _clixon_debug_level = dbglevel; /* Global variable */
     return 0;
 }
 
@@ -193,7 +195,7 @@ clixon_debug_init(clixon_handle h,
 int
 clixon_debug_get(void)
 {
-    return _debug_level;
+    return _clixon_debug_level;
 }
 
 /*! Print a debug message with debug-level. Settings determine where msg appears.
@@ -54,6 +54,13 @@
 #include <sys/param.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#ifdef EVENT_EPOLL
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#endif
+#endif
 
 #include <cligen/cligen.h>
 
@@ -69,7 +76,14 @@
 #include "clixon_proc.h"
 #include "clixon_options.h"
 #include "clixon_event_select.h"
+#include "clixon_event_timer.h"
 #include "clixon_event.h"
+#include "clixon_event_profile.h"
+
+/* epoll or kqueue only if found by configure */
+#if defined(EVENT_EPOLL) && !defined(HAVE_SYS_EPOLL_H) && !defined(HAVE_SYS_EVENT_H)
+#undef EVENT_EPOLL
+#endif
 
 /*
  * Constants
@@ -84,12 +98,20 @@ struct event_data{
     int                       (*e_fn)(int, void*);      /* Callback function */
     enum {EVENT_FD, EVENT_TIME} e_type;                 /* Type of event */
     int                         e_fd;                   /* File descriptor */
-    struct timeval              e_time;                 /* Timeout */
+    int                         e_prio;                 /* 1: high-prio FD:s only */
     void                       *e_arg;                  /* Function argument */
     char                        e_descr[EVENT_STRLEN]; /* String for debugging */
     struct pollfd              *e_pollfd;               /* Pointer to pull struct */
 };
 
+#ifdef EVENT_EPOLL
+#ifdef HAVE_SYS_EPOLL_H
+typedef struct epoll_event event_epoll_t;
+#else
+typedef struct kevent event_epoll_t;
+#endif
+#endif
+
 /*
  * Internal variables
  * Consider use handle variables instead of global, but needs API changes
@@ -109,8 +131,17 @@ static int _ee_nr = 0;
 static struct event_data *_ee_prio = NULL;
 static int _ee_prio_nr = 0;
 
-/* Timer event handlers */
-static struct event_data *_ee_timers = NULL;
+#ifdef EVENT_EPOLL
+/* epoll or kqueue descriptor where all file events are registered, or -1 */
+static int _ee_epfd = -1;
+
+/* Process that created _ee_epfd, a forked child creates its own */
+static pid_t _ee_eppid = 0;
+
+/* File event handlers indexed by file descriptor */
+static struct event_data **_ee_fdtab = NULL;
+static int _ee_fdtab_len = 0;
+#endif
 
 /* Set if element in _ee is deleted (clixon_event_unreg_fd). Check in _ee loops
  * XXX: algorithm has flaw: which _ee is unregged?
@@ -187,6 +218,142 @@ clicon_sig_ignore_get(void)
     return _clicon_sig_ignore;
 }
 
+#ifdef EVENT_EPOLL
+/*! Add or delete a file event in the epoll or kqueue descriptor
+ *
+ * @param[in]  e    File event
+ * @param[in]  add  1: add, 0: delete
+ * @retval     0    OK
+ * @retval    -1    Error, errno set
+ */
+static int
+event_epoll_ctl(struct event_data *e,
+                int                add)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev = {0,};
+
+    ev.events = EPOLLIN;
+    ev.data.fd = e->e_fd;
+    return epoll_ctl(_ee_epfd, add?EPOLL_CTL_ADD:EPOLL_CTL_DEL, e->e_fd, &ev);
+#else
+    struct kevent kev;
+
+    EV_SET(&kev, e->e_fd, EVFILT_READ, add?EV_ADD:EV_DELETE, 0, 0, NULL);
+    return kevent(_ee_epfd, &kev, 1, NULL, 0, NULL);
+#endif
+}
+
+/*! Get epoll or kqueue descriptor of this process, create it if not exists
+ *
+ * A forked child shares an epoll descriptor with its parent and does not inherit a kqueue,
+ * therefore the child creates its own and registers all file events again.
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_epoll_open(void)
+{
+    int                retval = -1;
+    struct event_data *e;
+
+    if (_ee_epfd != -1){
+        if (_ee_eppid == getpid())
+            return 0;
+#ifdef HAVE_SYS_EPOLL_H
+        close(_ee_epfd);
+#endif
+        _ee_epfd = -1;
+    }
+#ifdef HAVE_SYS_EPOLL_H
+    if ((_ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+        clixon_err(OE_EVENTS, errno, "epoll_create1");
+        goto done;
+    }
+#else
+    if ((_ee_epfd = kqueue()) < 0){
+        clixon_err(OE_EVENTS, errno, "kqueue");
+        goto done;
+    }
+    fcntl(_ee_epfd, F_SETFD, FD_CLOEXEC);
+#endif
+    _ee_eppid = getpid();
+    for (e = _ee_prio; e; e = e->e_next)
+        if (event_epoll_ctl(e, 1) < 0){
+            clixon_err(OE_EVENTS, errno, "%s fd %d", e->e_descr, e->e_fd);
+            goto done;
+        }
+    for (e = _ee; e; e = e->e_next)
+        if (event_epoll_ctl(e, 1) < 0){
+            clixon_err(OE_EVENTS, errno, "%s fd %d", e->e_descr, e->e_fd);
+            goto done;
+        }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Register file event persistently in epoll or kqueue and in file descriptor table
+ *
+ * @param[in]  e    File event
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_epoll_add(struct event_data *e)
+{
+    int                 retval = -1;
+    struct event_data **tab;
+    int                 len;
+
+    if (e->e_fd < 0){
+        clixon_err(OE_EVENTS, EBADF, "%s fd %d", e->e_descr, e->e_fd);
+        goto done;
+    }
+    if (e->e_fd >= _ee_fdtab_len){
+        len = _ee_fdtab_len ? _ee_fdtab_len : 64;
+        while (len <= e->e_fd)
+            len *= 2;
+        if ((tab = realloc(_ee_fdtab, len*sizeof(*tab))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        memset(&tab[_ee_fdtab_len], 0, (len-_ee_fdtab_len)*sizeof(*tab));
+        _ee_fdtab = tab;
+        _ee_fdtab_len = len;
+    }
+    if (_ee_fdtab[e->e_fd] != NULL){
+        clixon_err(OE_EVENTS, EEXIST, "%s fd %d already registered by %s",
+                   e->e_descr, e->e_fd, _ee_fdtab[e->e_fd]->e_descr);
+        goto done;
+    }
+    if (event_epoll_open() < 0)
+        goto done;
+    if (event_epoll_ctl(e, 1) < 0){
+        clixon_err(OE_EVENTS, errno, "%s fd %d", e->e_descr, e->e_fd);
+        goto done;
+    }
+    _ee_fdtab[e->e_fd] = e;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Deregister file event from epoll or kqueue and from file descriptor table
+ *
+ * The file descriptor may already be closed, which removes it from epoll and kqueue
+ * @param[in]  e    File event
+ */
+static void
+event_epoll_rm(struct event_data *e)
+{
+    if (e->e_fd >= 0 && e->e_fd < _ee_fdtab_len && _ee_fdtab[e->e_fd] == e)
+        _ee_fdtab[e->e_fd] = NULL;
+    if (_ee_epfd != -1 && _ee_eppid == getpid())
+        event_epoll_ctl(e, 0);
+}
+#endif /* EVENT_EPOLL */
+
 /*! Register a callback function to be called on input on a file descriptor.
  *
  * Prio is primitive, non-preemptive as follows:
@@ -228,6 +395,13 @@ clixon_event_reg_fd_prio(int   fd,
     e->e_fn = fn;
     e->e_arg = arg;
     e->e_type = EVENT_FD;
+    e->e_prio = prio;
+#ifdef EVENT_EPOLL
+    if (event_epoll_add(e) < 0){
+        free(e);
+        return -1;
+    }
+#endif
     if (prio){
         e->e_next = _ee_prio;
         _ee_prio = e;
@@ -285,6 +459,9 @@ clixon_event_unreg_fd(int   s,
             *e_prev = e->e_next;
             _ee_prio_nr--;
             _ee_unreg++;
+#ifdef EVENT_EPOLL
+            event_epoll_rm(e);
+#endif
             free(e);
             break;
         }
@@ -298,6 +475,9 @@ clixon_event_unreg_fd(int   s,
                 *e_prev = e->e_next;
                 _ee_nr--;
                 _ee_unreg++;
+#ifdef EVENT_EPOLL
+                event_epoll_rm(e);
+#endif
                 free(e);
                 break;
             }
@@ -337,41 +517,7 @@ clixon_event_reg_timeout(struct timeval t,
                          void          *arg,
                          char          *str)
 {
-    int                 retval = -1;
-    struct event_data  *e;
-    struct event_data  *e1;
-    struct event_data **e_prev;
-
-    if (_event_select){
-        return clixon_event_select_reg_timeout(t, fn, arg, str);
-    }
-    if (str == NULL || fn == NULL){
-        clixon_err(OE_CFG, EINVAL, "str or fn is NULL");
-        goto done;
-    }
-    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
-        clixon_err(OE_EVENTS, errno, "malloc");
-        return -1;
-    }
-    memset(e, 0, sizeof(struct event_data));
-    strncpy(e->e_descr, str, EVENT_STRLEN-1);
-    e->e_fn = fn;
-    e->e_arg = arg;
-    e->e_type = EVENT_TIME;
-    e->e_time = t;
-    /* Sort into right place */
-    e_prev = &_ee_timers;
-    for (e1=_ee_timers; e1; e1=e1->e_next){
-        if (timercmp(&e->e_time, &e1->e_time, <))
-            break;
-        e_prev = &e1->e_next;
-    }
-    e->e_next = e1;
-    *e_prev = e;
-    clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "%s", str);
-    retval = 0;
- done:
-    return retval;
+    return clixon_event_timer_add(t, fn, arg, str);
 }
 
 /*! Deregister a timeout callback as previosly registered by clixon_event_reg_timeout()
@@ -390,24 +536,7 @@ int
 clixon_event_unreg_timeout(int (*fn)(int, void*),
                            void *arg)
 {
-    struct event_data  *e;
-    int                 found = 0;
-    struct event_data **e_prev;
-
-    if (_event_select){
-        return clixon_event_select_unreg_timeout(fn, arg);
-    }
-    e_prev = &_ee_timers;
-    for (e = _ee_timers; e; e = e->e_next){
-        if (fn == e->e_fn && arg == e->e_arg) {
-            found++;
-            *e_prev = e->e_next;
-            free(e);
-            break;
-        }
-        e_prev = &e->e_next;
-    }
-    return found?0:-1;
+    return clixon_event_timer_rm(fn, arg);
 }
 
 /*! Poll to see if there is any data available on this file descriptor.
@@ -485,6 +614,32 @@ event_handle_eintr(clixon_handle h)
     goto done;
 }
 
+/*! Invoke callback of a file event, timed if event profile is enabled
+ *
+ * The registration string is copied since the callback may unregister the event
+ * @param[in]  e    File event
+ * @retval     0    OK
+ * @retval    -1    Error, from callback
+ * @see event_profile_add
+ */
+static int
+event_call(struct event_data *e)
+{
+    struct timespec t0;
+    char            descr[EVENT_STRLEN];
+    int             ret;
+
+    if (!event_profile_enabled())
+        return (*e->e_fn)(e->e_fd, e->e_arg);
+    strcpy(descr, e->e_descr);
+    event_profile_start(&t0);
+    ret = (*e->e_fn)(e->e_fd, e->e_arg);
+    if (event_profile_add(EP_CALLBACK, descr, event_profile_usec(&t0)) < 0)
+        return -1;
+    return ret;
+}
+
+#ifndef EVENT_EPOLL
 static int
 event_handle_fds(struct event_data *ee,
                  int                prio)
@@ -503,7 +658,7 @@ event_handle_fds(struct event_data *ee,
             if (pfd->revents & POLLIN || pfd->revents & POLLHUP) {
                 clixon_debug(CLIXON_DBG_EVENT, "fd %s", e->e_descr);
                 _ee_unreg = 0;
-                if ((*e->e_fn)(e->e_fd, e->e_arg) < 0) {
+                if (event_call(e) < 0) {
                     clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_descr);
                     goto done;
                 }
@@ -531,6 +686,92 @@ event_handle_fds(struct event_data *ee,
     return retval;
 }
 
+#else /* EVENT_EPOLL */
+/*! Wait for file events in epoll or kqueue descriptor
+ *
+ * @param[out] evs      Ready events
+ * @param[in]  nevs     Max number of ready events
+ * @param[in]  timeout  Timeout in ms, or -1 for none
+ * @retval    >0        Number of ready events
+ * @retval     0        Timeout
+ * @retval    -1        Error, errno set
+ */
+static int
+event_epoll_wait(event_epoll_t *evs,
+                 int            nevs,
+                 int            timeout)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    return epoll_wait(_ee_epfd, evs, nevs, timeout);
+#else
+    struct timespec ts;
+
+    if (timeout < 0)
+        return kevent(_ee_epfd, NULL, 0, evs, nevs, NULL);
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000;
+    return kevent(_ee_epfd, NULL, 0, evs, nevs, &ts);
+#endif
+}
+
+/*! Invoke callbacks of ready file events from epoll or kqueue, prioritized first
+ *
+ * As event_handle_fds but only visits the ready file descriptors
+ * @param[in]  evs  Ready events
+ * @param[in]  n    Number of ready events
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_handle_epoll(event_epoll_t *evs,
+                   int            n)
+{
+    int                retval = -1;
+    struct event_data *e;
+    int                prio;
+    int                fd;
+    int                ready;
+    int                i;
+
+    for (prio = 1; prio >= 0; prio--){
+        for (i = 0; i < n; i++){
+#ifdef HAVE_SYS_EPOLL_H
+            fd = evs[i].data.fd;
+            ready = (evs[i].events & (EPOLLIN | EPOLLHUP)) != 0;
+#else
+            fd = (int)evs[i].ident;
+            ready = (evs[i].flags & EV_ERROR) == 0;
+#endif
+            if (fd < 0 || fd >= _ee_fdtab_len || (e = _ee_fdtab[fd]) == NULL)
+                continue;
+            if (e->e_prio != prio)
+                continue;
+            clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "check s:%d prio:%d fd %s", fd, prio, e->e_descr);
+            if (!ready){
+                clixon_err(OE_EVENTS, 0, "%s fd %d: error condition", e->e_descr, fd);
+                goto done;
+            }
+            clixon_debug(CLIXON_DBG_EVENT, "fd %s", e->e_descr);
+            _ee_unreg = 0;
+            if (event_call(e) < 0) {
+                clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_descr);
+                goto done;
+            }
+            if (_ee_unreg){ /* Remaining events may refer to reused fds, wait again */
+                _ee_unreg = 0;
+                goto ok;
+            }
+            if (prio == 0 && _ee_prio_nr > 0) /* Prioritized exists, break unprio fairness */
+                goto ok;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+#endif /* EVENT_EPOLL */
+
 /*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
  *
  * @param[in] h  Clixon handle
@@ -546,21 +787,41 @@ clixon_event_loop(clixon_handle h)
 {
     int                retval = -1;
     struct event_data *e = NULL;
+#ifdef EVENT_EPOLL
+    event_epoll_t     *fds = NULL;
+#else
     struct pollfd     *fds = NULL;
     struct pollfd     *pfd;
+#endif
     uint32_t           nfds_max = 0;
     int                nfds = 0;
     struct timeval     t0;
+    struct timeval     t1;
     struct timeval     t;
     int64_t            tdiff;
     int                timeout;
     int                n;
     int                ret;
+    int                prof;
+    struct timespec    ts;
 
     if (_event_select){
         return clixon_event_select_loop(h);
     }
     while (clixon_exit_get() != 1) {
+#ifdef EVENT_EPOLL
+        /* File events are registered persistently, only size the ready events */
+        if (event_epoll_open() < 0)
+            goto done;
+        nfds = _ee_prio_nr + _ee_nr + 1;
+        if (nfds > nfds_max){
+            nfds_max = nfds;
+            if ((fds = realloc(fds, nfds_max*sizeof(event_epoll_t))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+        }
+#else
         nfds = _ee_prio_nr + _ee_nr;
         if (nfds > nfds_max){
             nfds_max = nfds;
@@ -598,11 +859,12 @@ clixon_event_loop(clixon_handle h)
             clixon_err(OE_EVENTS, 0, "File descriptor mismatch");
             goto done;
         }
+#endif /* EVENT_EPOLL */
         timeout = -1;
         clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout");
-        if (_ee_timers != NULL) {
+        if (clixon_event_timer_next(&t1)) {
             gettimeofday(&t0, NULL);
-            timersub(&_ee_timers->e_time, &t0, &t);
+            timersub(&t1, &t0, &t);
             tdiff = t.tv_sec * 1000 + t.tv_usec / 1000;
             if (tdiff < 0)
                 timeout = 0;
@@ -610,7 +872,11 @@ clixon_event_loop(clixon_handle h)
                 timeout = (int)tdiff;
         }
         clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "poll timeout: %d", timeout);
+#ifdef EVENT_EPOLL
+        n = event_epoll_wait(fds, nfds, timeout);
+#else
         n = poll(fds, nfds, timeout);
+#endif
         if (n == -1) {
             int e = errno;
             clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "n=-1 Error: %d", e);
@@ -633,21 +899,28 @@ clixon_event_loop(clixon_handle h)
         }
         if (n == 0) { /* timeout */
             clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "n=0 Timeout");
-            e = _ee_timers;
-            _ee_timers = _ee_timers->e_next;
-            clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_descr);
-            if ((*e->e_fn)(0, e->e_arg) < 0) {
-                free(e);
+            if (clixon_event_timer_run() < 0)
                 goto done;
-            }
-            free(e);
         }
+        if ((prof = event_profile_enabled()) != 0){
+            event_profile_start(&ts);
+            if (n > 0 && event_profile_add(EP_READY, "fds", n) < 0)
+                goto done;
+        }
+#ifdef EVENT_EPOLL
+        if (n > 0 && event_handle_epoll(fds, n) < 0)
+            goto done;
+#else
         /* Prio files */
         if ((ret = event_handle_fds(_ee_prio, 1)) < 0)
             goto done;
         /* Unprio files */
         if ((ret = event_handle_fds(_ee, 0)) < 0)
             goto done;
+#endif
+        /* Time until events that became ready meanwhile are seen */
+        if (prof && n > 0 && event_profile_add(EP_LAG, "dispatch", event_profile_usec(&ts)) < 0)
+            goto done;
         clixon_exit_decr(); /* If exit is set and > 1, decrement it (and exit when 1) */
   }
  ok:
@@ -666,6 +939,7 @@ clixon_event_exit(void)
     struct event_data *e;
     struct event_data *e_next;
 
+    clixon_event_timer_exit();
     if (_event_select){
         return clixon_event_select_exit();
     }
@@ -683,12 +957,15 @@ clixon_event_exit(void)
     }
     _ee = NULL;
 
-    e_next = _ee_timers;
-    while ((e = e_next) != NULL){
-        e_next = e->e_next;
-        free(e);
-    }
-    _ee_timers = NULL;
+#ifdef EVENT_EPOLL
+    if (_ee_epfd != -1 && _ee_eppid == getpid())
+        close(_ee_epfd);
+    _ee_epfd = -1;
+    if (_ee_fdtab)
+        free(_ee_fdtab);
+    _ee_fdtab = NULL;
+    _ee_fdtab_len = 0;
+#endif
     return 0;
 }
 
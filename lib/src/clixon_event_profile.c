@@ -0,0 +1,304 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ * Validation cost profiler
+ * Event loop and IPC latency profiler
+ * When debug subject CLIXON_DBG_PROFILE is set, values are recorded in histograms with
+ * log2-sized buckets per kind and name, see enum event_profile_kind:
+ * time of each event callback per registration string, event loop lag, number of ready
+ * file descriptors per wakeup and round-trip time of rpcs from clients per rpc name.
+ * A callback that blocks the event loop delays all other sessions, which shows as high
+ * lag and as the callback with the highest times.
+ * The profile is exposed in the stats RPC, see from_client_stats
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <time.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_string.h"
+#include "clixon_event_profile.h"
+
+/* Max number of histograms, new names are not recorded when full */
+#define EVENT_PROFILE_SIZE 1024
+
+/* Number of buckets of a histogram
+ * Bucket 0 is value 0, bucket i>0 is values in [2^(i-1), 2^i), last bucket has no upper bound
+ */
+#define EVENT_PROFILE_BUCKETS 32
+
+/*
+ * Types
+ */
+/*! Histogram of values of one kind and name
+ */
+struct event_profile_entry{
+    qelem_t                 ep_q;        /* Queue of entries, in order of first value */
+    enum event_profile_kind ep_kind;     /* Kind of values */
+    char                   *ep_name;     /* Name, eg registration string or rpc name */
+    uint64_t                ep_count;    /* Number of values */
+    uint64_t                ep_sum;      /* Sum of values */
+    uint64_t                ep_max;      /* Max value */
+    uint64_t                ep_buckets[EVENT_PROFILE_BUCKETS]; /* Number of values per bucket */
+};
+
+/*
+ * Variables
+ */
+/* Histograms per kind: name -> struct event_profile_entry* */
+static clicon_hash_t              *_event_profile[EP_NR] = {NULL,};
+/* Queue of histograms */
+static struct event_profile_entry *_event_profile_list = NULL;
+/* Number of histograms */
+static int                         _event_profile_nr = 0;
+
+/* Names of kinds, same order as enum event_profile_kind */
+static const map_str2int epkmap[] = {
+    {"callback", EP_CALLBACK},
+    {"timer",    EP_TIMER},
+    {"lag",      EP_LAG},
+    {"ready",    EP_READY},
+    {"rpc",      EP_RPC},
+    {NULL,       -1}
+};
+
+/*! Check if event profiling is enabled
+ *
+ * @retval  1  Enabled by debug subject CLIXON_DBG_PROFILE
+ * @retval  0  Not enabled
+ */
+int
+event_profile_enabled(void)
+{
+    return clixon_debug_isset(CLIXON_DBG_PROFILE);
+}
+
+/*! Start time of a measurement
+ *
+ * @param[out] t0  Start time, give to event_profile_usec
+ */
+void
+event_profile_start(struct timespec *t0)
+{
+    clock_gettime(CLOCK_MONOTONIC, t0);
+}
+
+/*! Time since start of a measurement
+ *
+ * @param[in]  t0  Start time, see event_profile_start
+ * @retval     us  Micro-seconds since t0
+ */
+uint64_t
+event_profile_usec(struct timespec *t0)
+{
+    struct timespec t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return ((t1.tv_sec - t0->tv_sec)*1000000000ULL + t1.tv_nsec - t0->tv_nsec) / 1000;
+}
+
+/*! Bucket of a value, bit length of the value
+ *
+ * @param[in]  value  Value
+ * @retval     i      Bucket index
+ */
+static int
+event_profile_bucket(uint64_t value)
+{
+    int i;
+
+    if (value == 0)
+        return 0;
+    i = 64 - __builtin_clzll(value);
+    if (i >= EVENT_PROFILE_BUCKETS)
+        i = EVENT_PROFILE_BUCKETS - 1;
+    return i;
+}
+
+/*! Record one value in the histogram of a kind and name
+ *
+ * @param[in]  kind   Kind of value
+ * @param[in]  name   Name of histogram, eg event registration string or rpc name
+ * @param[in]  value  Value, micro-seconds or number of file descriptors
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   struct timespec t0;
+ *   if (event_profile_enabled())
+ *      event_profile_start(&t0);
+ *   ret = fn(s, arg);
+ *   if (event_profile_enabled() &&
+ *       event_profile_add(EP_CALLBACK, descr, event_profile_usec(&t0)) < 0)
+ *      err;
+ * @endcode
+ */
+int
+event_profile_add(enum event_profile_kind kind,
+                  const char             *name,
+                  uint64_t                value)
+{
+    int                         retval = -1;
+    struct event_profile_entry *ep = NULL;
+    struct event_profile_entry **epp;
+
+    if (_event_profile[kind] == NULL &&
+        (_event_profile[kind] = clicon_hash_init()) == NULL)
+        goto done;
+    if ((epp = clicon_hash_value(_event_profile[kind], name, NULL)) != NULL)
+        ep = *epp;
+    else {
+        if (_event_profile_nr >= EVENT_PROFILE_SIZE)
+            goto ok;
+        if ((ep = calloc(1, sizeof(*ep))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        ep->ep_kind = kind;
+        if ((ep->ep_name = strdup(name)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            free(ep);
+            goto done;
+        }
+        if (clicon_hash_add(_event_profile[kind], name, &ep, sizeof(ep)) == NULL){
+            free(ep->ep_name);
+            free(ep);
+            goto done;
+        }
+        ADDQ(ep, _event_profile_list);
+        _event_profile_nr++;
+    }
+    ep->ep_count++;
+    ep->ep_sum += value;
+    if (value > ep->ep_max)
+        ep->ep_max = value;
+    ep->ep_buckets[event_profile_bucket(value)]++;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print event profile as XML entries of clixon-lib stats event-profile
+ *
+ * Only non-empty buckets are printed, identified by their lower bound
+ * @param[in]  cb   CLIgen buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+event_profile_print(cbuf *cb)
+{
+    int                         retval = -1;
+    struct event_profile_entry *ep;
+    char                       *encstr = NULL;
+    int                         i;
+
+    if ((ep = _event_profile_list) != NULL){
+        do {
+            cprintf(cb, "<entry>");
+            cprintf(cb, "<kind>%s</kind>", clicon_int2str(epkmap, ep->ep_kind));
+            if (xml_chardata_encode(&encstr, 0, "%s", ep->ep_name) < 0)
+                goto done;
+            cprintf(cb, "<name>%s</name>", encstr);
+            free(encstr);
+            encstr = NULL;
+            cprintf(cb, "<count>%" PRIu64 "</count>", ep->ep_count);
+            cprintf(cb, "<sum>%" PRIu64 "</sum>", ep->ep_sum);
+            cprintf(cb, "<max>%" PRIu64 "</max>", ep->ep_max);
+            for (i=0; i<EVENT_PROFILE_BUCKETS; i++){
+                if (ep->ep_buckets[i] == 0)
+                    continue;
+                cprintf(cb, "<bucket>");
+                cprintf(cb, "<lower>%" PRIu64 "</lower>", i ? (uint64_t)1 << (i-1) : 0);
+                cprintf(cb, "<count>%" PRIu64 "</count>", ep->ep_buckets[i]);
+                cprintf(cb, "</bucket>");
+            }
+            cprintf(cb, "</entry>");
+            ep = NEXTQ(struct event_profile_entry *, ep);
+        } while (ep && ep != _event_profile_list);
+    }
+    retval = 0;
+ done:
+    if (encstr)
+        free(encstr);
+    return retval;
+}
+
+/*! Clear event profile and free all entries
+ *
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+event_profile_exit(void)
+{
+    struct event_profile_entry *ep;
+    int                         k;
+
+    while ((ep = _event_profile_list) != NULL){
+        DELQ(ep, _event_profile_list, struct event_profile_entry *);
+        free(ep->ep_name);
+        free(ep);
+    }
+    _event_profile_nr = 0;
+    for (k=0; k<EP_NR; k++)
+        if (_event_profile[k]){
+            clicon_hash_free(_event_profile[k]);
+            _event_profile[k] = NULL;
+        }
+    return 0;
+}
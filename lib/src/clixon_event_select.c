@@ -53,6 +53,7 @@
 #include <sys/param.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include <cligen/cligen.h>
 
@@ -69,6 +70,8 @@
 #include "clixon_options.h"
 #include "clixon_event.h"
 #include "clixon_event_select.h"
+#include "clixon_event_timer.h"
+#include "clixon_event_profile.h"
 
 /*
  * Constants
@@ -84,7 +87,6 @@ struct event_data{
     enum {EVENT_FD, EVENT_TIME} e_type;                 /* Type of event */
     int                         e_fd;                   /* File descriptor */
     int                         e_prio;                 /* 1: high-prio FD:s only*/
-    struct timeval              e_time;                 /* Timeout */
     void                       *e_arg;                  /* Function argument */
     char                        e_string[EVENT_STRLEN]; /* String for debugging */
 };
@@ -94,7 +96,6 @@ struct event_data{
  * XXX consider use handle variables instead of global
  */
 static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
 
 /* Set if element in ee is deleted (clixon_event_unreg_fd). Check in ee loops */
 static int _ee_unreg = 0;
@@ -171,103 +172,6 @@ clixon_event_select_unreg_fd(int   s,
     return found?0:-1;
 }
 
-/*! Call a callback function at an absolute time
- *
- * @param[in]  t   Absolute (not relative!) timestamp when callback is called
- * @param[in]  fn  Function to call at time t
- * @param[in]  arg Argument to function fn
- * @param[in]  str Describing string for logging
- * @retval     0   OK
- * @retval    -1   Error
- * @code
- * int fn(int d, void *arg){
- *   struct timeval t, t1;
- *   gettimeofday(&t, NULL);
- *   t1.tv_sec = 1; t1.tv_usec = 0;
- *   timeradd(&t, &t1, &t);
- *   clixon_event_reg_timeout(t, fn, NULL, "call every second");
- * } 
- * @endcode 
- * 
- * @note  The timestamp is an absolute timestamp, not relative.
- * @note  The callback is not periodic, you need to make a new registration for each period, see example.
- * @note  The first argument to fn is a dummy, just to get the same signature as for file-descriptor callbacks.
- * @see clixon_event_reg_fd
- * @see clixon_event_unreg_timeout
- */
-int
-clixon_event_select_reg_timeout(struct timeval t,
-                                int          (*fn)(int, void*),
-                                void          *arg,
-                                char          *str)
-{
-    int                 retval = -1;
-    struct event_data  *e;
-    struct event_data  *e1;
-    struct event_data **e_prev;
-
-    if (str == NULL || fn == NULL){
-        clixon_err(OE_CFG, EINVAL, "str or fn is NULL");
-        goto done;
-    }
-    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
-        clixon_err(OE_EVENTS, errno, "malloc");
-        return -1;
-    }
-    memset(e, 0, sizeof(struct event_data));
-    strncpy(e->e_string, str, EVENT_STRLEN-1);
-    e->e_fn = fn;
-    e->e_arg = arg;
-    e->e_type = EVENT_TIME;
-    e->e_time = t;
-    /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-        if (timercmp(&e->e_time, &e1->e_time, <))
-            break;
-        e_prev = &e1->e_next;
-    }
-    e->e_next = e1;
-    *e_prev = e;
-    clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "%s", str);
-    retval = 0;
- done:
-    return retval;
-}
-
-/*! Deregister a timeout callback as previosly registered by clixon_event_reg_timeout()
- *
- * Note: deregister when exactly function and function arguments match, not time. So you
- * cannot have same function and argument callback on different timeouts. This is a little
- * different from clixon_event_unreg_fd.
- * @param[in]  fn   Function to call at time t
- * @param[in]  arg  Argument to function fn
- * @retval     0    OK, timeout unregistered
- * @retval    -1    OK, but timeout not found
- * @see clixon_event_reg_timeout
- * @see clixon_event_unreg_fd
- */
-int
-clixon_event_select_unreg_timeout(int (*fn)(int, void*),
-                                  void *arg)
-{
-    struct event_data  *e;
-    int                 found = 0;
-    struct event_data **e_prev;
-
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
-        if (fn == e->e_fn && arg == e->e_arg) {
-            found++;
-            *e_prev = e->e_next;
-            free(e);
-            break;
-        }
-        e_prev = &e->e_next;
-    }
-    return found?0:-1;
-}
-
 /*! Poll to see if there is any data available on this file descriptor.
  *
  * @param[in]  fd   File descriptor
@@ -289,6 +193,29 @@ clixon_event_select_poll(int fd)
     return retval;
 }
 
+/*! Invoke callback of a file event, timed if event profile is enabled
+ *
+ * @param[in]  e    File event
+ * @retval     0    OK
+ * @retval    -1    Error, from callback
+ */
+static int
+event_select_call(struct event_data *e)
+{
+    struct timespec t0;
+    char            descr[EVENT_STRLEN];
+    int             ret;
+
+    if (!event_profile_enabled())
+        return (*e->e_fn)(e->e_fd, e->e_arg);
+    strcpy(descr, e->e_string);
+    event_profile_start(&t0);
+    ret = (*e->e_fn)(e->e_fd, e->e_arg);
+    if (event_profile_add(EP_CALLBACK, descr, event_profile_usec(&t0)) < 0)
+        return -1;
+    return ret;
+}
+
 /*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
  *
  * @param[in] h  Clixon handle
@@ -305,10 +232,13 @@ clixon_event_select_loop(clixon_handle h)
     int                n;
     struct timeval     t;
     struct timeval     t0;
+    struct timeval     t1;
     struct timeval     tnull = {0,};
     fd_set             fdset;
     int                retval = -1;
     struct event_data *e_next;
+    int                prof;
+    struct timespec    ts;
 
     while (clixon_exit_get() != 1){
         FD_ZERO(&fdset);
@@ -321,9 +251,9 @@ clixon_event_select_loop(clixon_handle h)
         for (e=ee; e; e=e->e_next)
             if (e->e_type == EVENT_FD)
                 FD_SET(e->e_fd, &fdset);
-        if (ee_timers != NULL){
+        if (clixon_event_timer_next(&t1)){
             gettimeofday(&t0, NULL);
-            timersub(&ee_timers->e_time, &t0, &t);
+            timersub(&t1, &t0, &t);
             if (t.tv_sec < 0)
                 n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull);
             else
@@ -370,14 +300,13 @@ clixon_event_select_loop(clixon_handle h)
             goto err;
         }
         if (n==0){ /* Timeout */
-            e = ee_timers;
-            ee_timers = ee_timers->e_next;
-            clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_string);
-            if ((*e->e_fn)(0, e->e_arg) < 0){
-                free(e);
+            if (clixon_event_timer_run() < 0)
+                goto err;
+        }
+        if ((prof = event_profile_enabled()) != 0){
+            event_profile_start(&ts);
+            if (n > 0 && event_profile_add(EP_READY, "fds", n) < 0)
                 goto err;
-            }
-            free(e);
         }
         _ee_unreg = 0;
         if (clicon_option_bool(h, "CLICON_SOCK_PRIO")){
@@ -387,7 +316,7 @@ clixon_event_select_loop(clixon_handle h)
                 e_next = e->e_next;
                 if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset) && e->e_prio){
                     clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s prio:%d", e->e_string, e->e_prio);
-                    if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+                    if (event_select_call(e) < 0){
                         clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
                         goto err;
                     }
@@ -407,7 +336,7 @@ clixon_event_select_loop(clixon_handle h)
             e_next = e->e_next;
             if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset) && e->e_prio==0){
                 clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s", e->e_string);
-                if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+                if (event_select_call(e) < 0){
                     clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
                     goto err;
                 }
@@ -419,6 +348,8 @@ clixon_event_select_loop(clixon_handle h)
                     break;
             }
         }
+        if (prof && n > 0 && event_profile_add(EP_LAG, "dispatch", event_profile_usec(&ts)) < 0)
+            goto err;
         clixon_exit_decr(); /* If exit is set and > 1, decrement it (and exit when 1) */
         continue;
       err:
@@ -443,11 +374,5 @@ clixon_event_select_exit(void)
         free(e);
     }
     ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-        e_next = e->e_next;
-        free(e);
-    }
-    ee_timers = NULL;
     return 0;
 }
@@ -45,9 +45,6 @@
  */
 int clixon_event_select_reg_fd_prio(int fd, int (*fn)(int, void*), void *arg, char *str, int prio);
 int clixon_event_select_unreg_fd(int s, int (*fn)(int, void*));
-int clixon_event_select_reg_timeout(struct timeval t,  int (*fn)(int, void*),
-                             void *arg, char *str);
-int clixon_event_select_unreg_timeout(int (*fn)(int, void*), void *arg);
 int clixon_event_select_poll(int fd);
 int clixon_event_select_loop(clixon_handle h);
 int clixon_event_select_exit(void);
@@ -0,0 +1,363 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgat)e
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Timer events of the poll and select event handlers
+ * Timers are kept in a binary min-heap ordered by time and registration order, and
+ * are found by callback argument in a hash table for deregistration.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <cligen/cligen.h>
+
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_err.h"
+#include "clixon_event_timer.h"
+#include "clixon_event_profile.h"
+
+/*
+ * Constants
+ */
+#define EVENT_STRLEN 32
+
+/*
+ * Types
+ */
+struct event_timer{
+    int                (*et_fn)(int, void*);     /* Callback function */
+    void                *et_arg;                 /* Function argument */
+    struct timeval       et_time;                /* Timeout */
+    uint64_t             et_seq;                 /* Registration order, for equal timeouts */
+    int                  et_index;               /* Position in heap */
+    struct event_timer  *et_next;                /* Next timer with same argument */
+    char                 et_descr[EVENT_STRLEN]; /* String for debugging */
+};
+
+/*
+ * Internal variables
+ */
+/* Min-heap of timers, earliest first */
+static struct event_timer **_et_heap = NULL;
+static int _et_len = 0;
+static int _et_max = 0;
+
+/* Registration counter */
+static uint64_t _et_seq = 0;
+
+/* Callback argument -> list of timers with that argument */
+static clicon_hash_t *_et_args = NULL;
+
+/* Hash key of NULL argument */
+static char _et_nullarg;
+
+static void *
+event_timer_key(void *arg)
+{
+    return arg ? arg : &_et_nullarg;
+}
+
+/*! Return true if timer a is due before timer b
+ */
+static int
+event_timer_before(struct event_timer *a,
+                   struct event_timer *b)
+{
+    if (timercmp(&a->et_time, &b->et_time, !=))
+        return timercmp(&a->et_time, &b->et_time, <);
+    return a->et_seq < b->et_seq;
+}
+
+static void
+event_timer_set(int                 i,
+                struct event_timer *et)
+{
+    _et_heap[i] = et;
+    et->et_index = i;
+}
+
+/*! Move timer at position i up in heap until its parent is due before it
+ */
+static void
+event_timer_up(int i)
+{
+    struct event_timer *et = _et_heap[i];
+    int                 parent;
+
+    while (i > 0){
+        parent = (i - 1) / 2;
+        if (!event_timer_before(et, _et_heap[parent]))
+            break;
+        event_timer_set(i, _et_heap[parent]);
+        i = parent;
+    }
+    event_timer_set(i, et);
+}
+
+/*! Move timer at position i down in heap until it is due before its children
+ */
+static void
+event_timer_down(int i)
+{
+    struct event_timer *et = _et_heap[i];
+    int                 child;
+
+    while ((child = 2*i + 1) < _et_len){
+        if (child + 1 < _et_len && event_timer_before(_et_heap[child+1], _et_heap[child]))
+            child++;
+        if (!event_timer_before(_et_heap[child], et))
+            break;
+        event_timer_set(i, _et_heap[child]);
+        i = child;
+    }
+    event_timer_set(i, et);
+}
+
+/*! Remove timer from heap and from list of timers with same argument, do not free it
+ *
+ * @param[in]  et   Timer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_timer_unlink(struct event_timer *et)
+{
+    struct event_timer  *last;
+    struct event_timer  *head;
+    struct event_timer **etp;
+    void                *key;
+    int                  i;
+
+    i = et->et_index;
+    last = _et_heap[--_et_len];
+    if (i < _et_len){
+        event_timer_set(i, last);
+        event_timer_down(i);
+        event_timer_up(last->et_index);
+    }
+    key = event_timer_key(et->et_arg);
+    head = clicon_hash_ptr_value(_et_args, key);
+    for (etp = &head; *etp; etp = &(*etp)->et_next)
+        if (*etp == et){
+            *etp = et->et_next;
+            break;
+        }
+    if (head == NULL)
+        clicon_hash_del_ptr(_et_args, key);
+    else if (clicon_hash_add_ptr(_et_args, key, head) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Add a timer callback at an absolute time
+ *
+ * @param[in]  t   Absolute timestamp when callback is called
+ * @param[in]  fn  Function to call at time t
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see clixon_event_reg_timeout
+ */
+int
+clixon_event_timer_add(struct timeval t,
+                       int          (*fn)(int, void*),
+                       void          *arg,
+                       char          *str)
+{
+    int                  retval = -1;
+    struct event_timer  *et = NULL;
+    struct event_timer **heap;
+    void                *key;
+
+    if (str == NULL || fn == NULL){
+        clixon_err(OE_CFG, EINVAL, "str or fn is NULL");
+        goto done;
+    }
+    if (_et_args == NULL &&
+        (_et_args = clicon_hash_init()) == NULL)
+        goto done;
+    if (_et_len == _et_max){
+        _et_max = _et_max ? 2*_et_max : 64;
+        if ((heap = realloc(_et_heap, _et_max*sizeof(*heap))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        _et_heap = heap;
+    }
+    if ((et = malloc(sizeof(*et))) == NULL){
+        clixon_err(OE_EVENTS, errno, "malloc");
+        goto done;
+    }
+    memset(et, 0, sizeof(*et));
+    strncpy(et->et_descr, str, EVENT_STRLEN-1);
+    et->et_fn = fn;
+    et->et_arg = arg;
+    et->et_time = t;
+    et->et_seq = _et_seq++;
+    key = event_timer_key(arg);
+    et->et_next = clicon_hash_ptr_value(_et_args, key);
+    if (clicon_hash_add_ptr(_et_args, key, et) == NULL)
+        goto done;
+    event_timer_set(_et_len++, et);
+    event_timer_up(et->et_index);
+    et = NULL;
+    clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "%s", str);
+    retval = 0;
+ done:
+    if (et)
+        free(et);
+    return retval;
+}
+
+/*! Remove a timer callback by function and argument
+ *
+ * If several timers match, the earliest is removed
+ * @param[in]  fn   Function to call at time t
+ * @param[in]  arg  Argument to function fn
+ * @retval     0    OK, timer removed
+ * @retval    -1    Timer not found
+ * @see clixon_event_unreg_timeout
+ */
+int
+clixon_event_timer_rm(int (*fn)(int, void*),
+                      void *arg)
+{
+    struct event_timer *et;
+    struct event_timer *found = NULL;
+
+    if (_et_args == NULL)
+        return -1;
+    for (et = clicon_hash_ptr_value(_et_args, event_timer_key(arg)); et; et = et->et_next)
+        if (et->et_fn == fn && (found == NULL || event_timer_before(et, found)))
+            found = et;
+    if (found == NULL)
+        return -1;
+    if (event_timer_unlink(found) < 0)
+        return -1;
+    free(found);
+    return 0;
+}
+
+/*! Get time of earliest timer
+ *
+ * @param[out] tp   Absolute time of earliest timer
+ * @retval     1    Timer exists
+ * @retval     0    No timers
+ */
+int
+clixon_event_timer_next(struct timeval *tp)
+{
+    if (_et_len == 0)
+        return 0;
+    *tp = _et_heap[0]->et_time;
+    return 1;
+}
+
+/*! Remove earliest timer and call its callback
+ *
+ * @retval     0    OK, or no timers
+ * @retval    -1    Error, from callback
+ */
+int
+clixon_event_timer_run(void)
+{
+    int                 retval = -1;
+    struct event_timer *et;
+    int                 prof;
+    struct timeval      t;
+    struct timespec     t0;
+
+    if (_et_len == 0)
+        return 0;
+    et = _et_heap[0];
+    if (event_timer_unlink(et) < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", et->et_descr);
+    if ((prof = event_profile_enabled()) != 0){
+        /* Lateness of timer */
+        gettimeofday(&t, NULL);
+        timersub(&t, &et->et_time, &t);
+        if (event_profile_add(EP_LAG, "timer", t.tv_sec < 0 ? 0 : t.tv_sec*1000000ULL + t.tv_usec) < 0)
+            goto done;
+        event_profile_start(&t0);
+    }
+    if ((*et->et_fn)(0, et->et_arg) < 0)
+        goto done;
+    if (prof && event_profile_add(EP_TIMER, et->et_descr, event_profile_usec(&t0)) < 0)
+        goto done;
+    retval = 0;
+ done:
+    free(et);
+    return retval;
+}
+
+/*! Free all timers
+ */
+int
+clixon_event_timer_exit(void)
+{
+    int i;
+
+    for (i = 0; i < _et_len; i++)
+        free(_et_heap[i]);
+    if (_et_heap)
+        free(_et_heap);
+    _et_heap = NULL;
+    _et_len = 0;
+    _et_max = 0;
+    if (_et_args)
+        clicon_hash_free(_et_args);
+    _et_args = NULL;
+    return 0;
+}
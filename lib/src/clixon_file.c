@@ -455,3 +455,76 @@ clicon_file_cbuf(const char *filename,
         errno = err;
     return retval;
 }
+
+/*! Read rest of an open file into a buffer terminated by two null characters
+ *
+ * The file is read in large blocks, and a regular file is sized with fstat so that it is
+ * normally read into one allocation without reallocs.
+ * The two null characters allow a flex scanner to scan the buffer in place, see
+ * yy_scan_buffer.
+ * @param[in]   fp    Open file, eg a datastore file or stdin
+ * @param[out]  bufp  Malloced buffer, free after use
+ * @param[out]  lenp  Length of file content, excluding null characters
+ * @retval      0     OK
+ * @retval     -1     Error
+ * @note May block on file I/O
+ */
+int
+clicon_file_read(FILE   *fp,
+                 char  **bufp,
+                 size_t *lenp)
+{
+    int         retval = -1;
+    char       *buf = NULL;
+    char       *buf1;
+    size_t      buflen = 64*1024; /* start size if not a regular file */
+    size_t      len = 0;
+    size_t      sz;
+    size_t      want;
+    struct stat st;
+    long        pos;
+
+    if (fp == NULL || bufp == NULL || lenp == NULL){
+        clixon_err(OE_UNIX, EINVAL, "arg is NULL");
+        goto done;
+    }
+    if (fstat(fileno(fp), &st) == 0 &&
+        S_ISREG(st.st_mode) &&
+        (pos = ftell(fp)) >= 0 &&
+        st.st_size >= pos)
+        buflen = st.st_size - pos + 3; /* One extra to detect end-of-file without realloc */
+    if ((buf = malloc(buflen)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    while (1){
+        if (len + 2 >= buflen){ /* Space for at least one character and two null characters */
+            buflen *= 2;
+            if ((buf1 = realloc(buf, buflen)) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            buf = buf1;
+        }
+        want = buflen - len - 2;
+        sz = fread(buf + len, 1, want, fp);
+        len += sz;
+        if (sz < want){ /* End-of-file or error */
+            if (ferror(fp)){
+                clixon_err(OE_UNIX, errno, "fread");
+                goto done;
+            }
+            break;
+        }
+    }
+    buf[len] = '\0';
+    buf[len+1] = '\0';
+    *bufp = buf;
+    buf = NULL;
+    *lenp = len;
+    retval = 0;
+ done:
+    if (buf)
+        free(buf);
+    return retval;
+}
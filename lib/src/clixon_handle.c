@@ -50,6 +50,7 @@
 #include <cligen/cligen.h>
 
 /* clixon */
+#include "clixon_map.h"
 #include "clixon_queue.h"
 #include "clixon_hash.h"
 #include "clixon_handle.h"
@@ -61,6 +62,16 @@
 #include "clixon_stream.h"
 #include "clixon_data.h"
 #include "clixon_options.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_path.h"
+#include "clixon_regex.h"
+#include "clixon_xpath_profile.h"
+#include "clixon_validate_profile.h"
+#include "clixon_event_profile.h"
+#include "clixon_memstats.h"
+#include "clixon_trace.h"
+#include "clixon_alloc_profile.h"
 
 #define CLIXON_MAGIC 0x99aafabe
 
@@ -93,6 +104,7 @@ struct clixon_handle {
     clicon_hash_t    *ch_data;     /* internal clicon data (HDR) */
     clicon_hash_t    *ch_db_elmnt; /* xml datastore element cache data */
     event_stream_t   *ch_stream;   /* notification streams, see clixon_stream.[ch] */
+    clicon_option_slots *ch_optslots; /* pre-resolved options (HDR) */
 };
 
 /*! Internal call to allocate a CLICON handle. 
@@ -128,6 +140,10 @@ clixon_handle_init0(int size)
         clixon_handle_exit((clixon_handle)ch);
         goto done;
     }
+    if ((ch->ch_optslots = clicon_option_slots_new()) == NULL){
+        clixon_handle_exit((clixon_handle)ch);
+        goto done;
+    }
     h = (clixon_handle)ch;
   done:
     return h;
@@ -167,7 +183,20 @@ clixon_handle_exit(clixon_handle h)
         clicon_hash_free(ha);
     if ((ha = clicon_db_elmnt(h)) != NULL)
         clicon_hash_free(ha);
+    if (ch->ch_optslots)
+        clicon_option_slots_free(ch->ch_optslots);
     free(ch);
+    xpath_parse_cache_exit();
+    api_path_cache_exit();
+    xml_intern_exit(); /* After caches holding interned strings */
+    ctx_nodeset_pool_exit();
+    regex_cache_exit();
+    xpath_profile_exit();
+    validate_profile_exit();
+    event_profile_exit();
+    clixon_memstats_exit();
+    clixon_trace_exit();
+    alloc_profile_exit();
     retval = 0;
     return retval;
 }
@@ -199,6 +228,19 @@ clicon_options(clixon_handle h)
     return ch->ch_copt;
 }
 
+/*! Return pre-resolved options given a handle.
+ *
+ * @param[in]  h        Clixon handle
+ * @see clicon_option_slot_int
+ */
+clicon_option_slots *
+clicon_option_slots_get(clixon_handle h)
+{
+    struct clixon_handle *ch = handle(h);
+
+    return ch->ch_optslots;
+}
+
 /*! Return clicon data (hash-array) given a handle.
  *
  * @param[in]  h        Clixon handle
@@ -39,6 +39,8 @@
  * A simple implementation of a associative array style data store. Keys
  * are always strings while values can be some arbitrary data referenced
  * by void*.
+ * The table uses open addressing with linear probing and grows when three quarters
+ * full. String keys are hashed with a wyhash-style function, pointer keys by value.
  *
  * XXX: functions such as hash_keys(), hash_value() etc are currently returning
  * pointers to the actual data storage. Should probably make copies.
@@ -101,33 +103,259 @@
 #include "clixon_xml.h"
 #include "clixon_err.h"
 
-#define HASH_SIZE       1031    /* Number of hash buckets. Should be a prime */
+#define HASH_SIZE_INIT  16      /* Initial number of slots, power of two */
 #define HASH_NO_PTR     SIZE_MAX
 #define align4(s) (((s)/4)*4 + 4)
 
-/*! A very simplistic algorithm to calculate a hash bucket index
+/* Secrets of the wyhash-style string hash */
+#define HASH_S0 0xa0761d6478bd642fULL
+#define HASH_S1 0xe7037ed1a0b428dbULL
+#define HASH_S2 0x8ebc6af09c88c6e3ULL
+
+/*! Slot in open addressing table, entry NULL if empty
+ */
+struct hash_slot {
+    uint64_t      hs_hash;   /* Full hash value of key */
+    clicon_hash_t hs_entry;  /* Entry, allocated separately so it does not move on resize */
+};
+
+/*! Hash table with linear probing, cast to clicon_hash_t* in the API
+ *
+ * Grows by doubling when it is three quarters full. Deletion shifts back following
+ * entries, so there are no tombstones.
+ */
+struct hash_table {
+    struct hash_slot *ht_slots;  /* Slot vector */
+    size_t            ht_size;   /* Number of slots, power of two */
+    size_t            ht_nr;     /* Number of entries */
+};
+
+#define hash_table(hash) ((struct hash_table *)(hash))
+
+/*! 64x64->128 bit multiply, return low and high halves in a and b
  */
-static uint32_t
-hash_bucket(const char *str)
+static inline void
+hash_mum(uint64_t *a,
+         uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t
+hash_mix(uint64_t a,
+         uint64_t b)
+{
+    hash_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t
+hash_rd64(const uint8_t *p)
 {
-    uint32_t n = 0;
+    uint64_t v;
 
-    while(*str)
-        n += (uint32_t)*str++;
-    return n % HASH_SIZE;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t
+hash_rd32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*! Hash of a null-terminated string, wyhash-style
+ *
+ * All bytes and the length affect all bits of the result, unlike a sum of characters
+ * where eg anagrams and keys with shared prefixes collide.
+ */
+static uint64_t
+hash_str(const char *str)
+{
+    const uint8_t *p = (const uint8_t *)str;
+    size_t         len = strlen(str);
+    size_t         i = len;
+    uint64_t       seed = HASH_S2;
+    uint64_t       a;
+    uint64_t       b;
+
+    if (len <= 16){
+        if (len >= 4){
+            a = (hash_rd32(p) << 32) | hash_rd32(p + ((len >> 3) << 2));
+            b = (hash_rd32(p + len - 4) << 32) | hash_rd32(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0){
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else {
+        while (i > 16){
+            seed = hash_mix(hash_rd64(p) ^ HASH_S1, hash_rd64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = hash_rd64(p + i - 16);
+        b = hash_rd64(p + i - 8);
+    }
+    a ^= HASH_S1;
+    b ^= seed;
+    hash_mum(&a, &b);
+    return hash_mix(a ^ HASH_S0 ^ len, b ^ HASH_S1);
 }
 
-static uint32_t
+/*! Hash of a pointer key
+ */
+static uint64_t
 hash_ptr(void *p)
 {
-    uint32_t n = 0;
-    uintptr_t h = (uintptr_t)p;
+    return hash_mix((uint64_t)(uintptr_t)p ^ HASH_S0, HASH_S1);
+}
+
+/*! Find slot of key, or the empty slot where it would be inserted
+ *
+ * @param[in]  ht    Hash table
+ * @param[in]  hv    Hash value of key
+ * @param[in]  key   String or pointer key
+ * @param[in]  isptr If set, key is a pointer compared by value
+ * @retval     i     Slot index, entry is NULL if not found
+ */
+static size_t
+hash_find(struct hash_table *ht,
+          uint64_t           hv,
+          const void        *key,
+          int                isptr)
+{
+    size_t        mask = ht->ht_size - 1;
+    size_t        i = hv & mask;
+    clicon_hash_t h;
 
-    for (size_t i = 0; i < sizeof(h); i++) {
-        n += (uint8_t)h;
-        h >>= 8;
+    while ((h = ht->ht_slots[i].hs_entry) != NULL){
+        if (ht->ht_slots[i].hs_hash == hv){
+            if (isptr){
+                if (h->h_vlen == HASH_NO_PTR && h->h_key == key)
+                    break;
+            }
+            else if (h->h_vlen != HASH_NO_PTR && strcmp(h->h_key, key) == 0)
+                break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/*! Double size of table and re-insert all entries
+ *
+ * @param[in]  ht    Hash table
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+hash_grow(struct hash_table *ht)
+{
+    struct hash_slot *slots;
+    size_t            size = ht->ht_size * 2;
+    size_t            mask = size - 1;
+    size_t            i;
+    size_t            j;
+
+    if ((slots = calloc(size, sizeof(*slots))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    for (i = 0; i < ht->ht_size; i++){
+        if (ht->ht_slots[i].hs_entry == NULL)
+            continue;
+        j = ht->ht_slots[i].hs_hash & mask;
+        while (slots[j].hs_entry != NULL)
+            j = (j + 1) & mask;
+        slots[j] = ht->ht_slots[i];
+    }
+    free(ht->ht_slots);
+    ht->ht_slots = slots;
+    ht->ht_size = size;
+    return 0;
+}
+
+/*! Insert new entry in table, key must not exist
+ *
+ * @param[in]  ht    Hash table
+ * @param[in]  hv    Hash value of key
+ * @param[in]  h     New entry
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+hash_insert(struct hash_table *ht,
+            uint64_t           hv,
+            clicon_hash_t      h)
+{
+    size_t mask;
+    size_t i;
+
+    if ((ht->ht_nr + 1) * 4 > ht->ht_size * 3 &&
+        hash_grow(ht) < 0)
+        return -1;
+    mask = ht->ht_size - 1;
+    i = hv & mask;
+    while (ht->ht_slots[i].hs_entry != NULL)
+        i = (i + 1) & mask;
+    ht->ht_slots[i].hs_hash = hv;
+    ht->ht_slots[i].hs_entry = h;
+    ht->ht_nr++;
+    return 0;
+}
+
+/*! Remove entry in slot and shift back following entries of the probe sequence
+ *
+ * @param[in]  ht    Hash table
+ * @param[in]  i     Slot index of entry to remove
+ */
+static void
+hash_remove(struct hash_table *ht,
+            size_t             i)
+{
+    size_t mask = ht->ht_size - 1;
+    size_t j = i;
+    size_t k;
+
+    for (;;){
+        ht->ht_slots[i].hs_entry = NULL;
+        for (;;){
+            j = (j + 1) & mask;
+            if (ht->ht_slots[j].hs_entry == NULL){
+                ht->ht_nr--;
+                return;
+            }
+            k = ht->ht_slots[j].hs_hash & mask;
+            /* Entry in j stays if its home slot k is cyclically in (i, j] */
+            if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+                continue;
+            break;
+        }
+        ht->ht_slots[i] = ht->ht_slots[j];
+        i = j;
     }
-    return n % HASH_SIZE;
 }
 
 /*! Initialize hash table.
@@ -139,14 +367,20 @@ hash_ptr(void *p)
 clicon_hash_t *
 clicon_hash_init(void)
 {
-  clicon_hash_t *hash;
-
-  if ((hash = (clicon_hash_t *)malloc(sizeof(clicon_hash_t) * HASH_SIZE)) == NULL){
-      clixon_err(OE_UNIX, errno, "malloc");
-      return NULL;
-  }
-  memset(hash, 0, sizeof(clicon_hash_t)*HASH_SIZE);
-  return hash;
+    struct hash_table *ht;
+
+    if ((ht = malloc(sizeof(*ht))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(ht, 0, sizeof(*ht));
+    if ((ht->ht_slots = calloc(HASH_SIZE_INIT, sizeof(*ht->ht_slots))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        free(ht);
+        return NULL;
+    }
+    ht->ht_size = HASH_SIZE_INIT;
+    return (clicon_hash_t *)ht;
 }
 
 /*! Free hash table.
@@ -158,21 +392,21 @@ clicon_hash_init(void)
 int
 clicon_hash_free(clicon_hash_t *hash)
 {
-    int i;
-    clicon_hash_t tmp;
-
-    for (i = 0; i < HASH_SIZE; i++) {
-        while (hash[i]) {
-            tmp = hash[i];
-            DELQ(tmp, hash[i], clicon_hash_t);
-            if (tmp->h_vlen != HASH_NO_PTR) {
-              free(tmp->h_key);
-              free(tmp->h_val);
-            }
-            free(tmp);
+    struct hash_table *ht = hash_table(hash);
+    size_t             i;
+    clicon_hash_t      h;
+
+    for (i = 0; i < ht->ht_size; i++) {
+        if ((h = ht->ht_slots[i].hs_entry) == NULL)
+            continue;
+        if (h->h_vlen != HASH_NO_PTR) {
+            free(h->h_key);
+            free(h->h_val);
         }
+        free(h);
     }
-    free(hash);
+    free(ht->ht_slots);
+    free(ht);
     return 0;
 }
 
@@ -187,38 +421,18 @@ clicon_hash_t
 clicon_hash_lookup(clicon_hash_t *hash,
                    const char    *key)
 {
-    uint32_t      bkt;
-    clicon_hash_t h;
+    struct hash_table *ht = hash_table(hash);
 
-    bkt = hash_bucket(key);
-    h = hash[bkt];
-    if (h) {
-        do {
-            if (!strcmp(h->h_key, key))
-                return h;
-            h = NEXTQ(clicon_hash_t, h);
-        } while (h != hash[bkt]);
-    }
-    return NULL;
+    return ht->ht_slots[hash_find(ht, hash_str(key), key, 0)].hs_entry;
 }
 
 clicon_hash_t
 clicon_hash_lookup_ptr(clicon_hash_t *hash,
                        void          *key)
 {
-    uint32_t      bkt;
-    clicon_hash_t h;
+    struct hash_table *ht = hash_table(hash);
 
-    bkt = hash_ptr(key);
-    h = hash[bkt];
-    if (h) {
-        do {
-            if (h->h_key == key)
-                return h;
-            h = NEXTQ(clicon_hash_t, h);
-        } while (h != hash[bkt]);
-    }
-    return NULL;
+    return ht->ht_slots[hash_find(ht, hash_ptr(key), key, 1)].hs_entry;
 }
 
 /*! Get value of hash
@@ -285,6 +499,7 @@ clicon_hash_add(clicon_hash_t *hash,
     void         *newval = NULL;
     clicon_hash_t h;
     clicon_hash_t new = NULL;
+    uint64_t      hv;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
@@ -297,7 +512,8 @@ clicon_hash_add(clicon_hash_t *hash,
         goto catch;
     }
     /* If variable exist, don't allocate a new. just replace value */
-    h = clicon_hash_lookup(hash, key);
+    hv = hash_str(key);
+    h = hash_table(hash)->ht_slots[hash_find(hash_table(hash), hv, key, 0)].hs_entry;
     if (h == NULL) {
         if ((new = (clicon_hash_t)malloc(sizeof(*new))) == NULL){
             clixon_err(OE_UNIX, errno, "malloc");
@@ -320,19 +536,19 @@ clicon_hash_add(clicon_hash_t *hash,
         }
         memcpy(newval, val, vlen);
     }
+    /* Add to table only if new variable */
+    if (new && hash_insert(hash_table(hash), hv, new) < 0)
+        goto catch;
     /* Free old value if existing variable */
     if (h->h_val)
         free(h->h_val);
     h->h_val = newval;
     h->h_vlen =  vlen;
-
-    /* Add to list only if new variable */
-    if (new)
-        INSQ(h, hash[hash_bucket(key)]);
-
     return h;
 
 catch:
+    if (newval)
+        free(newval);
     if (new) {
         if (new->h_key)
             free(new->h_key);
@@ -349,13 +565,15 @@ clicon_hash_add_ptr(clicon_hash_t *hash,
 {
     clicon_hash_t h;
     clicon_hash_t new = NULL;
+    uint64_t      hv;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
         return NULL;
     }
     /* If variable exist, don't allocate a new. just replace value */
-    h = clicon_hash_lookup_ptr(hash, key);
+    hv = hash_ptr(key);
+    h = hash_table(hash)->ht_slots[hash_find(hash_table(hash), hv, key, 1)].hs_entry;
     if (h == NULL) {
         if ((new = (clicon_hash_t)malloc(sizeof(*new))) == NULL){
             clixon_err(OE_UNIX, errno, "malloc");
@@ -363,19 +581,14 @@ clicon_hash_add_ptr(clicon_hash_t *hash,
         }
         memset(new, 0, sizeof(*new));
         new->h_key = key;
-        if (new->h_key == NULL){
-            clixon_err(OE_UNIX, errno, "strdup");
+        new->h_vlen = HASH_NO_PTR;
+        /* Add to table only if new variable */
+        if (hash_insert(hash_table(hash), hv, new) < 0)
             goto catch;
-        }
         h = new;
     }
     h->h_val = val;
     h->h_vlen =  HASH_NO_PTR;
-
-    /* Add to list only if new variable */
-    if (new)
-        INSQ(h, hash[hash_ptr(key)]);
-
     return h;
 
 catch:
@@ -396,16 +609,18 @@ int
 clicon_hash_del(clicon_hash_t *hash,
                 const char    *key)
 {
-    clicon_hash_t h;
+    struct hash_table *ht = hash_table(hash);
+    clicon_hash_t      h;
+    size_t             i;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
         return -1;
     }
-    h = clicon_hash_lookup(hash, key);
-    if (h == NULL)
+    i = hash_find(ht, hash_str(key), key, 0);
+    if ((h = ht->ht_slots[i].hs_entry) == NULL)
         return -1;
-    DELQ(h, hash[hash_bucket(key)], clicon_hash_t);
+    hash_remove(ht, i);
     free(h->h_key);
     free(h->h_val);
     free(h);
@@ -417,16 +632,18 @@ int
 clicon_hash_del_ptr(clicon_hash_t *hash,
                     void          *key)
 {
-    clicon_hash_t h;
+    struct hash_table *ht = hash_table(hash);
+    clicon_hash_t      h;
+    size_t             i;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
         return -1;
     }
-    h = clicon_hash_lookup_ptr(hash, key);
-    if (h == NULL)
+    i = hash_find(ht, hash_ptr(key), key, 1);
+    if ((h = ht->ht_slots[i].hs_entry) == NULL)
         return -1;
-    DELQ(h, hash[hash_ptr(key)], clicon_hash_t);
+    hash_remove(ht, i);
     free(h);
 
     return 0;
@@ -446,32 +663,27 @@ clicon_hash_keys(clicon_hash_t *hash,
                  char        ***vector,
                  size_t        *nkeys)
 {
-    int           retval = -1;
-    int           bkt;
-    clicon_hash_t h;
-    char        **tmp;
-    char        **keys = NULL;
+    int                retval = -1;
+    struct hash_table *ht = hash_table(hash);
+    size_t             i;
+    clicon_hash_t      h;
+    char             **keys = NULL;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
         return -1;
     }
     *nkeys = 0;
-    for (bkt = 0; bkt < HASH_SIZE; bkt++) {
-        h = hash[bkt];
-        do {
-            if (h == NULL)
-                break;
-            tmp = realloc(keys, ((*nkeys)+1) * sizeof(char *));
-            if (tmp == NULL){
-                clixon_err(OE_UNIX, errno, "realloc");
-                goto catch;
-            }
-            keys = tmp;
-            keys[*nkeys] = h->h_key;
-            (*nkeys)++;
-            h = NEXTQ(clicon_hash_t, h);
-        } while (h != hash[bkt]);
+    if (ht->ht_nr &&
+        (keys = malloc(ht->ht_nr * sizeof(char *))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto catch;
+    }
+    for (i = 0; i < ht->ht_size; i++) {
+        if ((h = ht->ht_slots[i].hs_entry) == NULL)
+            continue;
+        keys[*nkeys] = h->h_key;
+        (*nkeys)++;
     }
     if (vector){
         *vector = keys;
@@ -484,6 +696,43 @@ catch:
     return retval;
 }
 
+/*! Return number of entries and allocated size of hash
+ *
+ * Includes slot vector, entries, string keys and copied values, not values added as
+ * pointers with clicon_hash_add_ptr
+ * @param[in]   hash    Hash structure
+ * @param[out]  nr      Number of entries
+ * @param[out]  szp     Size in bytes
+ * @retval      0       OK
+ */
+int
+clicon_hash_stats(clicon_hash_t *hash,
+                  uint64_t      *nr,
+                  size_t        *szp)
+{
+    struct hash_table *ht = hash_table(hash);
+    size_t             i;
+    clicon_hash_t      h;
+    size_t             sz = 0;
+
+    *nr = 0;
+    if (hash != NULL){
+        sz += sizeof(*ht) + sizeof(struct hash_slot) * ht->ht_size;
+        for (i = 0; i < ht->ht_size; i++) {
+            if ((h = ht->ht_slots[i].hs_entry) == NULL)
+                continue;
+            (*nr)++;
+            sz += sizeof(*h);
+            if (h->h_vlen != HASH_NO_PTR){
+                sz += strlen(h->h_key) + 1;
+                sz += align4(h->h_vlen+3);
+            }
+        }
+    }
+    *szp = sz;
+    return 0;
+}
+
 /*! Dump contents of hash to FILE pointer.
  *
  * @param[in]   hash    Hash structure
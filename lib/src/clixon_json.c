@@ -53,6 +53,11 @@
 #include <limits.h>
 #include <stdint.h>
 #include <syslog.h>
+#include <dirent.h>
+#include <sys/types.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -78,18 +83,20 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_json.h"
 #include "clixon_json_parse.h"
+#include "clixon_file.h"
+#include "clixon_alloc_profile.h"
 
 /* Let xml2json_cbuf_vec() return json array: [a,b].
    ALternative is to create a pseudo-object and return that: {top:{a,b}}
 */
 #define VEC_ARRAY 1
 
-/* Size of json read buffer when reading from file*/
-#define BUFLEN 1024
-
 /* Name of xml top object created by parse functions */
 #define JSON_TOP_SYMBOL "top"
 
+/* Use hand-written JSON parser before flex/bison, see CLICON_JSON_PARSE_FAST */
+static int _json_parse_fast = 0;
+
 enum array_element_type{
     NO_ARRAY=0,
     FIRST_ARRAY,  /* [a, */
@@ -211,7 +218,7 @@ array_eval(cxobj *xprev,
     }
     if (xnext &&
         xml_type(xnext)==CX_ELMNT &&
-        strcmp(xml_name(x), xml_name(xnext))==0){
+        (xml_name(x) == xml_name(xnext) || strcmp(xml_name(x), xml_name(xnext))==0)){
         ns2 = xml_find_type_value(xnext, NULL, "xmlns", CX_ATTR);
         if ((!nsx && !ns2)
             || (nsx && ns2 && strcmp(nsx,ns2)==0))
@@ -219,7 +226,7 @@ array_eval(cxobj *xprev,
     }
     if (xprev &&
         xml_type(xprev)==CX_ELMNT &&
-        strcmp(xml_name(x),xml_name(xprev))==0){
+        (xml_name(x) == xml_name(xprev) || strcmp(xml_name(x), xml_name(xprev))==0)){
         ns2 = xml_find_type_value(xprev, NULL, "xmlns", CX_ATTR);
         if ((!nsx && !ns2)
             || (nsx && ns2 && strcmp(nsx,ns2)==0))
@@ -243,8 +250,47 @@ array_eval(cxobj *xprev,
     return arraytype;
 }
 
+/*! Return length of initial part of string without characters to escape in JSON
+ *
+ * Scans 16 bytes at a time with SSE2 where available
+ * @param[in]  s    String
+ * @param[in]  len  Length of string
+ * @retval     n    Index of first of '"', '\\' or control character, or len if none
+ */
+static size_t
+json_str_span(const char *s,
+              size_t      len)
+{
+    size_t        i = 0;
+    unsigned char c;
+#ifdef __SSE2__
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i bsl = _mm_set1_epi8('\\');
+    const __m128i ctl = _mm_set1_epi8(0x1f);
+    __m128i       v;
+    __m128i       m;
+    int           mask;
+
+    while (len - i >= 16){
+        v = _mm_loadu_si128((const __m128i *)(s + i));
+        m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quot), _mm_cmpeq_epi8(v, bsl)),
+                         _mm_cmpeq_epi8(_mm_max_epu8(v, ctl), ctl)); /* v <= 0x1f */
+        if ((mask = _mm_movemask_epi8(m)) != 0)
+            return i + __builtin_ctz(mask);
+        i += 16;
+    }
+#endif
+    for (; i<len; i++){
+        c = (unsigned char)s[i];
+        if (c == '"' || c == '\\' || c <= 0x1f)
+            break;
+    }
+    return i;
+}
+
 /*! Escape a json string as well as decode xml cdata
  *
+ * Runs of characters that need no escaping are appended in bulk
  * @param[out] cb   cbuf   (encoded)
  * @param[in]  str  string (unencoded)
  * @retval     0    OK
@@ -255,36 +301,46 @@ json_str_escape_cdata(cbuf *cb,
 {
     int    retval = -1;
     size_t len;
-    int    i;
+    size_t n;
 
     len = strlen(str);
-    for (i=0; i<len; i++)
-        switch (str[i]){
+    while (len > 0){
+        if ((n = json_str_span(str, len)) > 0){
+            cbuf_append_buf(cb, str, n);
+            str += n;
+            len -= n;
+            if (len == 0)
+                break;
+        }
+        switch (*str){
         case '\"':
-            cprintf(cb, "\\\"");
+            cbuf_append_str(cb, "\\\"");
             break;
         case '\\':
-            cprintf(cb, "\\\\");
+            cbuf_append_str(cb, "\\\\");
             break;
         case '\b':
-            cprintf(cb, "\\b");
+            cbuf_append_str(cb, "\\b");
             break;
         case '\f':
-            cprintf(cb, "\\f");
+            cbuf_append_str(cb, "\\f");
             break;
         case '\n':
-            cprintf(cb, "\\n");
+            cbuf_append_str(cb, "\\n");
             break;
         case '\r':
-            cprintf(cb, "\\r");
+            cbuf_append_str(cb, "\\r");
             break;
         case '\t':
-            cprintf(cb, "\\t");
+            cbuf_append_str(cb, "\\t");
             break;
-        default: /* fall thru */
-            cprintf(cb, "%c", str[i]);
+        default: /* Other control characters as-is */
+            cbuf_append(cb, *str);
             break;
         }
+        str++;
+        len--;
+    }
     retval = 0;
     // done:
     return retval;
@@ -393,6 +449,65 @@ json2xml_decode_identityref(cxobj     *x,
     goto done;
 }
 
+/*! Check if a yang node or any node below may need identityref decoding
+ *
+ * The result is cached in the yang node, since all nodes of a list have the same yang.
+ * Conservative: anydata, anyxml and mount-points may have identityrefs below
+ * @param[in]  y    Yang node
+ * @retval     1    May have identityref at or below y
+ * @retval     0    No identityref at or below y
+ * @retval    -1    Error
+ */
+static int
+json_yang_identityref(yang_stmt *y)
+{
+    int           retval = -1;
+    enum rfc_6020 keyword;
+    yang_stmt    *ytype = NULL;
+    yang_stmt    *yc;
+    int           inext;
+    int           idref = 0;
+    int           ret;
+
+    if (yang_flag_get(y, YANG_FLAG_IDREF_CHECKED))
+        return yang_flag_get(y, YANG_FLAG_IDREF) ? 1 : 0;
+    keyword = yang_keyword_get(y);
+    switch (keyword){
+    case Y_LEAF:
+    case Y_LEAF_LIST:
+        if (yang_type_get(y, NULL, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+            goto done;
+        if (ytype && strcmp(yang_argument_get(ytype), "identityref") == 0)
+            idref++;
+        break;
+    case Y_ANYDATA:
+    case Y_ANYXML:
+        idref++;
+        break;
+    default:
+        if (yang_schema_mount_point(y)){
+            idref++;
+            break;
+        }
+        inext = 0;
+        while ((yc = yn_iter(y, &inext)) != NULL){
+            if ((ret = json_yang_identityref(yc)) < 0)
+                goto done;
+            if (ret == 1){
+                idref++;
+                break;
+            }
+        }
+        break;
+    }
+    if (idref)
+        yang_flag_set(y, YANG_FLAG_IDREF);
+    yang_flag_set(y, YANG_FLAG_IDREF_CHECKED);
+    retval = idref ? 1 : 0;
+ done:
+    return retval;
+}
+
 /*! Decode leaf/leaf_list types from JSON to XML after parsing and yang
  *
  * Assume an xml tree where prefix:name have been split into "module":"name"
@@ -418,6 +533,11 @@ json2xml_decode(cxobj     *x,
     yang_stmt    *ytype = NULL;
 
     if ((y = xml_spec(x)) != NULL){
+        /* Skip subtrees without identityrefs */
+        if ((ret = json_yang_identityref(y)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
         keyword = yang_keyword_get(y);
         if (keyword == Y_LEAF || keyword == Y_LEAF_LIST){
             if (yang_type_get(y, NULL, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
@@ -442,6 +562,7 @@ json2xml_decode(cxobj     *x,
         if (ret == 0)
             goto fail;
     }
+ ok:
     retval = 1;
  done:
     return retval;
@@ -459,7 +580,7 @@ json2xml_decode(cxobj     *x,
  * @retval      0    OK
  * @retval     -1    Error
  */
-static int
+int
 xml2json_encode_identityref(cxobj     *xb,
                             char      *body,
                             yang_stmt *yp,
@@ -519,26 +640,22 @@ xml2json_encode_leafs(cxobj     *xb,
     enum rfc_6020 keyword;
     yang_stmt    *ytype;
     char         *restype;  /* resolved type */
-    char         *origtype=NULL;   /* original type */
     char         *body;
+    char         *val = NULL; /* the variable itself, if not in cb */
     enum cv_type  cvtype;
     int           quote = 1; /* Quote value w string: "val" */
-    cbuf         *cb = NULL; /* the variable itself */
+    cbuf         *cb = NULL; /* the variable itself, if encoded */
 
-    if ((cb = cbuf_new()) ==NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
-        goto done;
-    }
     body = xb?xml_value(xb):NULL;
     if (yp == NULL){
-        cprintf(cb, "%s", body?body:"null");
+        val = body?body:"null";
         goto ok; /* unknown */
     }
     keyword = yang_keyword_get(yp);
     switch (keyword){
     case Y_LEAF:
     case Y_LEAF_LIST:
-        if (yang_type_get(yp, &origtype, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+        if (yang_type_get(yp, NULL, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
             goto done;
         restype = ytype?yang_argument_get(ytype):NULL;
         if (restype == NULL){
@@ -551,17 +668,17 @@ xml2json_encode_leafs(cxobj     *xb,
         case CGV_REST:
             if (body==NULL)
                 ; /* empty: "" */
-            else if (ytype){
-                if (strcmp(restype, "identityref")==0){
-                    if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
-                        goto done;
-                }
-                else{
-                    cprintf(cb, "%s", body);
+            else if (ytype && strcmp(restype, "identityref")==0){
+                if ((cb = cbuf_new()) == NULL){
+                    clixon_err(OE_XML, errno, "cbuf_new");
+                    goto done;
                 }
+                ALLOC_PROFILE_COUNT(ALLOC_CBUF);
+                if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
+                    goto done;
             }
             else
-                cprintf(cb, "%s", body);
+                val = body;
             break;
         case CGV_INT64:
         case CGV_UINT64:
@@ -569,11 +686,15 @@ xml2json_encode_leafs(cxobj     *xb,
             // [RFC7951] JSON Encoding of YANG Data
             // 6.1 Numeric Types - A value of the "int64", "uint64", or "decimal64" type is represented as a JSON string
             if (yang_keyword_get(yp) == Y_LEAF_LIST && xml_child_nr_type(xml_parent(xp), CX_ELMNT) == 1) {
+                if ((cb = cbuf_new()) == NULL){
+                    clixon_err(OE_XML, errno, "cbuf_new");
+                    goto done;
+                }
+                ALLOC_PROFILE_COUNT(ALLOC_CBUF);
                 cprintf(cb, "[%s]", body);
             }
-            else {
-                cprintf(cb, "%s", body);
-            }
+            else
+                val = body;
             quote = 1;
             break;
         case CGV_INT8:
@@ -583,7 +704,7 @@ xml2json_encode_leafs(cxobj     *xb,
         case CGV_UINT16:
         case CGV_UINT32:
         case CGV_BOOL:
-            cprintf(cb, "%s", body);
+            val = body;
             quote = 0;
             break;
         case CGV_VOID:
@@ -591,42 +712,42 @@ xml2json_encode_leafs(cxobj     *xb,
             if (body == NULL && strcmp(restype, "empty")==0){
                 quote = 0;
                 if (keyword == Y_LEAF)
-                    cprintf(cb, "[null]");
+                    val = "[null]";
                 else if (keyword == Y_LEAF_LIST && strcmp(restype, "empty") == 0)
-                    cprintf(cb, "[null]");
+                    val = "[null]";
                 else
-                    cprintf(cb, "null");
+                    val = "null";
             }
             break;
         default:
             if (body)
-                cprintf(cb, "%s", body);
+                val = body;
             else
-                cprintf(cb, "{}"); /* dont know */
+                val = "{}"; /* dont know */
         }
         break;
     default:
-        cprintf(cb, "%s", body);
+        val = body;
         break;
     }
  ok:
     /* write into original cb0
      * includign quoting and encoding
      */
+    if (cb)
+        val = cbuf_get(cb);
     if (quote){
-        cprintf(cb0, "\"");
-        json_str_escape_cdata(cb0, cbuf_get(cb));
+        cbuf_append(cb0, '"');
+        if (val)
+            json_str_escape_cdata(cb0, val);
+        cbuf_append(cb0, '"');
     }
-    else
-        cprintf(cb0, "%s", cbuf_get(cb));
-    if (quote)
-        cprintf(cb0, "\"");
+    else if (val)
+        cbuf_append_str(cb0, val);
     retval = 0;
  done:
     if (cb)
         cbuf_free(cb);
-    if (origtype)
-        free(origtype);
     return retval;
 }
 
@@ -787,6 +908,32 @@ xml2json_encode_attr(cxobj     *xa,
     return retval;
 }
 
+/*! Print JSON object name: "modname:name": with indentation if pretty
+ *
+ * @param[out]  cb       Cligen text buffer
+ * @param[in]   x        XML node
+ * @param[in]   modname  Module name prefix, or NULL
+ * @param[in]   level    Indentation level
+ * @param[in]   pretty   Pretty-print output
+ */
+static void
+json_name_cbuf(cbuf  *cb,
+               cxobj *x,
+               char  *modname,
+               int    level,
+               int    pretty)
+{
+    if (pretty)
+        cprintf(cb, "%*s", level*PRETTYPRINT_INDENT, "");
+    cbuf_append(cb, '"');
+    if (modname){
+        cbuf_append_str(cb, modname);
+        cbuf_append(cb, ':');
+    }
+    cbuf_append_str(cb, xml_name(x));
+    cbuf_append_str(cb, pretty?"\": ":"\":");
+}
+
 /*! Do the actual work of translating XML to JSON
  *
  * @param[out]  cb        Cligen text buffer containing json on exit
@@ -797,7 +944,7 @@ xml2json_encode_attr(cxobj     *xa,
  * @param[in]   flat      Dont print NO_ARRAY object name (for _vec call)
  * @param[in]   system_only Enable checks for system-only-config extension
  * @param[in]   modname0
- * @param[out]  metacbp   Meta encoding of attribute
+ * @param[out]  metacbp   Meta encoding of attribute, created if needed, or NULL
  * @retval      0         OK
  * @retval     -1         Error
  *
@@ -838,7 +985,7 @@ xml2json1_cbuf(cbuf                   *cb,
                int                     flat,
                int                     system_only,
                char                   *modname0,
-               cbuf                   *metacbp)
+               cbuf                  **metacbp)
 {
     int              retval = -1;
     int              i;
@@ -854,6 +1001,8 @@ xml2json1_cbuf(cbuf                   *cb,
     cbuf            *metacbc = NULL;
     int              exist;
 
+    if (xml_sort_ensure(x) < 0) /* Array evaluation assumes siblings are sorted */
+        goto done;
     if ((ys = xml_spec(x)) != NULL){
         if (ys_real_module(ys, &ymod) < 0)
             goto done;
@@ -882,10 +1031,7 @@ xml2json1_cbuf(cbuf                   *cb,
         break;
     case NO_ARRAY:
         if (!flat){
-            cprintf(cb, "%*s\"", pretty?(level*PRETTYPRINT_INDENT):0, "");
-            if (modname)
-                cprintf(cb, "%s:", modname);
-            cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
+            json_name_cbuf(cb, x, modname, level, pretty);
         }
         switch (childt){
         case NULL_CHILD:
@@ -903,10 +1049,7 @@ xml2json1_cbuf(cbuf                   *cb,
         break;
     case FIRST_ARRAY:
     case SINGLE_ARRAY:
-        cprintf(cb, "%*s\"", pretty?(level*PRETTYPRINT_INDENT):0, "");
-        if (modname)
-            cprintf(cb, "%s:", modname);
-        cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
+        json_name_cbuf(cb, x, modname, level, pretty);
         level++;
         cprintf(cb, "[%s%*s",
                 pretty?"\n":"",
@@ -947,10 +1090,6 @@ xml2json1_cbuf(cbuf                   *cb,
     default:
         break;
     }
-    if ((metacbc = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
     /* Check for typed sub-body if:
      * arraytype=* but child-type is BODY_CHILD
      * This is code for writing <a>42</a> as "a":42 and not "a":"42"
@@ -959,8 +1098,14 @@ xml2json1_cbuf(cbuf                   *cb,
     for (i=0; i<xml_child_nr(x); i++){
         xc = xml_child_i(x, i);
         if (xml_type(xc) == CX_ATTR){
-            if (metacbp &&
-                xml2json_encode_attr(xc, x, ys, level, pretty, modname, metacbp) < 0)
+            if (metacbp == NULL)
+                continue;
+            if (*metacbp == NULL &&
+                (*metacbp = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            if (xml2json_encode_attr(xc, x, ys, level, pretty, modname, *metacbp) < 0)
                 goto done;
             continue;
         }
@@ -979,16 +1124,18 @@ xml2json1_cbuf(cbuf                   *cb,
                                xc,
                                xc_arraytype,
                                level+1, pretty, 0, system_only, modname0,
-                               metacbc) < 0)
+                               &metacbc) < 0)
                 goto done;
             if (commas > 0) {
-                cprintf(cb, ",%s", pretty?"\n":"");
+                cbuf_append(cb, ',');
+                if (pretty)
+                    cbuf_append(cb, '\n');
                 --commas;
             }
         }
     }
-    if (cbuf_len(metacbc)){
-        cprintf(cb, "%s", cbuf_get(metacbc));
+    if (metacbc && cbuf_len(metacbc)){
+        cbuf_append_str(cb, cbuf_get(metacbc));
     }
     switch (arraytype){
     case BODY_ARRAY:
@@ -1436,12 +1583,26 @@ json_xmlns_translate(yang_stmt *yspec,
     goto done;
 }
 
+/*! Enable or disable hand-written JSON parser
+ *
+ * @param[in]  enable  If set, try clixon_json_parse_fast before the flex/bison parser
+ * @retval     0       OK
+ * @see CLICON_JSON_PARSE_FAST
+ */
+int
+clixon_json_parse_fast_set(int enable)
+{
+    _json_parse_fast = enable;
+    return 0;
+}
+
 /*! Parse a string containing JSON and return an XML tree
  *
  * Parsing using yacc according to JSON syntax. Names with <prefix>:<id>
  * are split and interpreted as in RFC7951
  * @param[in]  h      Clixon handle sometimes NULL
  * @param[in]  str    Input string containing JSON
+ * @param[in]  len    If > 0, length of str followed by two null characters: scan str in place
  * @param[in]  jsonenc JSON encoding according to RFC7951, prefixes are module-names
  * @param[in]  yb     How to bind yang to XML top-level when parsing (if rfc7951)
  * @param[in]  yspec  Yang specification (if rfc 7951)
@@ -1458,6 +1619,7 @@ json_xmlns_translate(yang_stmt *yspec,
 static int
 _json_parse(clixon_handle h,
             char         *str,
+            size_t        len,
             int           jsonenc,
             yang_bind     yb,
             yang_stmt    *yspec,
@@ -1478,18 +1640,25 @@ _json_parse(clixon_handle h,
     else
         clixon_debug(CLIXON_DBG_PARSE|CLIXON_DBG_TRUNC, "%s", str);
     jy.jy_parse_string = str;
+    jy.jy_parse_len = len;
     jy.jy_linenum = 1;
     jy.jy_current = xt;
     jy.jy_xtop = xt;
-    if (json_scan_init(&jy) < 0)
-        goto done;
-    if (json_parse_init(&jy) < 0)
-        goto done;
-    if (clixon_json_parseparse(&jy) != 0) { /* yacc returns 1 on error */
-        clixon_log(NULL, LOG_NOTICE, "JSON error: line %d", jy.jy_linenum);
-        if (clixon_err_category() == 0)
-            clixon_err(OE_JSON, 0, "JSON parser error with no error code (should not happen)");
+    ret = 0;
+    if (_json_parse_fast &&
+        (ret = clixon_json_parse_fast(&jy)) < 0)
         goto done;
+    if (ret == 0){
+        if (json_scan_init(&jy) < 0)
+            goto done;
+        if (json_parse_init(&jy) < 0)
+            goto done;
+        if (clixon_json_parseparse(&jy) != 0) { /* yacc returns 1 on error */
+            clixon_log(NULL, LOG_NOTICE, "JSON error: line %d", jy.jy_linenum);
+            if (clixon_err_category() == 0)
+                clixon_err(OE_JSON, 0, "JSON parser error with no error code (should not happen)");
+            goto done;
+        }
     }
 
     if ((yt = xml_spec(xt)) != NULL)
@@ -1623,7 +1792,7 @@ clixon_json_parse_string(clixon_handle h,
         if ((*xt = xml_new("top", NULL, CX_ELMNT)) == NULL)
             return -1;
     }
-    return _json_parse(h, str, jsonenc, yb, yspec, *xt, xerr);
+    return _json_parse(h, str, 0, jsonenc, yb, yspec, *xt, xerr);
 }
 
 /*! Read a JSON definition from file and parse it into a parse-tree.
@@ -1671,54 +1840,23 @@ clixon_json_parse_file(FILE      *fp,
     int       retval = -1;
     int       ret;
     char     *jsonbuf = NULL;
-    int       jsonbuflen = BUFLEN; /* start size */
-    int       oldjsonbuflen;
-    char     *ptr;
-    char      ch;
-    int       len = 0;
-    size_t    sz;
+    size_t    len = 0;
 
     if (xt==NULL){
         clixon_err(OE_JSON, EINVAL, "xt is NULL");
         return -1;
     }
-    if ((jsonbuf = malloc(jsonbuflen)) == NULL){
-        clixon_err(OE_JSON, errno, "malloc");
+    /* Read whole file in blocks, parse buffer in place */
+    if (clicon_file_read(fp, &jsonbuf, &len) < 0)
         goto done;
-    }
-    memset(jsonbuf, 0, jsonbuflen);
-    ptr = jsonbuf;
-    while (1){
-        sz = fread(&ch, 1, 1, fp);
-        if (sz == 1){
-            jsonbuf[len++] = ch;
-        }
-        else if (sz == 0 && feof(fp)){
-            if (*xt == NULL)
-                if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if (len){
-                if ((ret = _json_parse(NULL, ptr, jsonenc, yb, yspec, *xt, xerr)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
-            }
-            break;
-        }
-        else {
-            clixon_err(OE_JSON, errno, "fread sz=%lu", sz);
+    if (*xt == NULL)
+        if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
             goto done;
-        }
-        if (len >= jsonbuflen-1){ /* Space: one for the null character */
-            oldjsonbuflen = jsonbuflen;
-            jsonbuflen *= 2;
-            if ((jsonbuf = realloc(jsonbuf, jsonbuflen)) == NULL){
-                clixon_err(OE_JSON, errno, "realloc");
-                goto done;
-            }
-            memset(jsonbuf+oldjsonbuflen, 0, jsonbuflen-oldjsonbuflen);
-            ptr = jsonbuf;
-        }
+    if (len){
+        if ((ret = _json_parse(NULL, jsonbuf, len, jsonenc, yb, yspec, *xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
     }
     retval = 1;
  done:
@@ -43,6 +43,8 @@
 struct clixon_json_yacc {
     int        jy_linenum;      /* Number of \n in parsed buffer */
     char      *jy_parse_string; /* original (copy of) parse string */
+    size_t     jy_parse_len;    /* If set, parse string is scanned in place and followed by
+                                   two null characters, see clicon_file_read */
     void      *jy_lexbuf;       /* internal parse buffer from lex */
     cxobj     *jy_xtop;         /* cxobj top element (fixed) */
     cxobj     *jy_current;      /* cxobj active element (changes with parse context) */
@@ -70,4 +72,6 @@ int clixon_json_parselex(void *);
 int clixon_json_parseparse(void *);
 void clixon_json_parseerror(void *, char*);
 
+int clixon_json_parse_fast(clixon_json_yacc *jy);
+
 #endif  /* _CLIXON_JSON_PARSE_H_ */
@@ -0,0 +1,481 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ * Hand-written JSON parser, see CLICON_JSON_PARSE_FAST
+ * Builds the same untyped XML tree as the flex/bison parser in a single pass over the
+ * input. Strings are scanned for quotes, escapes and control characters 16 bytes at a
+ * time using SSE2 where available.
+ * Documents that are not a top-level object, strings with \u escapes and all errors are
+ * left to the flex/bison parser: the partially built tree is then removed and the caller
+ * falls back to clixon_json_parseparse, so that accepted documents, created trees and
+ * error messages are the same as before.
+ * @see clixon_json_parse.l, clixon_json_parse.y
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <syslog.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_json_parse.h"
+
+/* Max nesting of objects and arrays, deeper documents are parsed by the regular parser */
+#define JSON_FAST_DEPTH 1024
+
+/* White space between tokens, skipped by the lexer in START state */
+#define JF_ISSPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+#define JF_ISDIGIT(c) ((c) >= '0' && (c) <= '9')
+
+/*
+ * Types
+ */
+/*! Fast JSON parser state
+ */
+struct json_fast {
+    clixon_json_yacc *jf_jy;   /* Top and created top-level objects */
+    char             *jf_end;  /* End of input */
+    cbuf             *jf_cb;   /* Current string */
+};
+
+/*! Find next character in a string that needs special handling
+ *
+ * Special characters are '"', '\\' and control characters
+ * @param[in]  s    Start of scan
+ * @param[in]  end  End of buffer
+ * @retval     p    Pointer to first special character, or end if none
+ */
+static inline char *
+jf_scan_strchars(char *s,
+                 char *end)
+{
+    unsigned char c;
+#ifdef __SSE2__
+    const __m128i dq = _mm_set1_epi8('"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i ctl = _mm_set1_epi8(0x1f);
+    __m128i       v;
+    __m128i       m;
+    int           mask;
+
+    while (end - s >= 16){
+        v = _mm_loadu_si128((const __m128i *)s);
+        m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, bs)),
+                         _mm_cmpeq_epi8(_mm_max_epu8(v, ctl), ctl));
+        if ((mask = _mm_movemask_epi8(m)) != 0)
+            return s + __builtin_ctz(mask);
+        s += 16;
+    }
+#endif
+    while (s < end){
+        c = *s;
+        if (c == '"' || c == '\\' || c <= 0x1f)
+            break;
+        s++;
+    }
+    return s;
+}
+
+/*! Skip white space
+ */
+static inline char *
+jf_skip_space(char *s,
+              char *end)
+{
+    while (s < end && JF_ISSPACE(*s))
+        s++;
+    return s;
+}
+
+/*! Scan string after '"' into jf_cb
+ *
+ * @param[in]  jf   Fast JSON parser state
+ * @param[in]  s    First character after '"'
+ * @retval     p    Pointer after end '"'
+ * @retval     NULL Not handled
+ */
+static char *
+jf_scan_string(struct json_fast *jf,
+               char             *s)
+{
+    char *end = jf->jf_end;
+    char *p;
+
+    cbuf_reset(jf->jf_cb);
+    while (1){
+        p = jf_scan_strchars(s, end);
+        cbuf_append_buf(jf->jf_cb, s, p - s);
+        if (p >= end)
+            return NULL;
+        switch (*p){
+        case '"':
+            return p + 1;
+        case '\\':
+            if (++p >= end)
+                return NULL;
+            switch (*p){
+            case '"':
+            case '\\':
+            case '/':
+                cbuf_append(jf->jf_cb, *p);
+                break;
+            case 'b':
+                cbuf_append(jf->jf_cb, '\b');
+                break;
+            case 'f':
+                cbuf_append(jf->jf_cb, '\f');
+                break;
+            case 'n':
+                cbuf_append(jf->jf_cb, '\n');
+                break;
+            case 'r':
+                cbuf_append(jf->jf_cb, '\r');
+                break;
+            case 't':
+                cbuf_append(jf->jf_cb, '\t');
+                break;
+            default: /* Including \u */
+                return NULL;
+            }
+            break;
+        case '\b':
+        case '\f':
+        case '\n':
+        case '\r':
+        case '\t':
+        case '\0':
+            return NULL;
+        default: /* Other control characters are accepted by the lexer */
+            cbuf_append(jf->jf_cb, *p);
+            break;
+        }
+        s = p + 1;
+    }
+}
+
+/*! Scan number, as J_NUMBER in the lexer
+ *
+ * @param[in]  s    First character of number
+ * @param[in]  end  End of buffer
+ * @retval     p    Pointer after number
+ * @retval     NULL Not a number
+ */
+static char *
+jf_scan_number(char *s,
+               char *end)
+{
+    char *p = s;
+    int   nd1 = 0;
+    int   nd2 = 0;
+    int   dot = 0;
+    char *q;
+
+    if (p < end && *p == '-')
+        p++;
+    while (p < end && JF_ISDIGIT(*p)){
+        p++;
+        nd1++;
+    }
+    if (p < end && *p == '.'){
+        q = p + 1;
+        while (q < end && JF_ISDIGIT(*q)){
+            q++;
+            nd2++;
+        }
+        if (nd1 || nd2){
+            dot++;
+            p = q;
+        }
+    }
+    if (nd1 == 0 && !dot)
+        return NULL;
+    /* Exponent requires sign */
+    if (end - p >= 3 && (*p == 'e' || *p == 'E') && (p[1] == '+' || p[1] == '-') &&
+        JF_ISDIGIT(p[2])){
+        p += 3;
+        while (p < end && JF_ISDIGIT(*p))
+            p++;
+    }
+    return p;
+}
+
+/*! Add body, as json_current_body
+ */
+static int
+jf_body(cxobj *xc,
+        char  *value)
+{
+    cxobj *xn;
+
+    if ((xn = xml_new("body", xc, CX_BODY)) == NULL)
+        return -1;
+    if (value && xml_value_append(xn, value) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Add element as child of xp, as json_current_new
+ *
+ * @param[in]  jf     Fast JSON parser state
+ * @param[in]  xp     Parent
+ * @param[in]  prefix Prefix or NULL
+ * @param[in]  name   Name
+ * @retval     x      Created element
+ * @retval     NULL   Error
+ */
+static cxobj *
+jf_new(struct json_fast *jf,
+       cxobj            *xp,
+       char             *prefix,
+       char             *name)
+{
+    clixon_json_yacc *jy = jf->jf_jy;
+    cxobj            *x;
+
+    if ((x = xml_new(name, xp, CX_ELMNT)) == NULL)
+        return NULL;
+    if (xml_prefix_set(x, prefix) < 0)
+        return NULL;
+    if (xp == jy->jy_xtop &&
+        cxvec_append(x, &jy->jy_xvec, &jy->jy_xlen) < 0)
+        return NULL;
+    return x;
+}
+
+/*! Parse JSON value and add it to current element
+ *
+ * @param[in]     jf    Fast JSON parser state
+ * @param[in,out] sp    Input, first character of value. Out: after value
+ * @param[in,out] xcp   Current element. Array values after the first create siblings
+ * @param[in]     depth Nesting depth
+ * @retval        1     OK
+ * @retval        0     Not handled
+ * @retval       -1     Error
+ */
+static int
+jf_value(struct json_fast *jf,
+         char            **sp,
+         cxobj           **xcp,
+         int               depth)
+{
+    char  *s = *sp;
+    char  *end = jf->jf_end;
+    char  *p;
+    char  *name;
+    cxobj *x;
+    cxobj *xp;
+    int    ret;
+
+    if (s >= end || depth > JSON_FAST_DEPTH)
+        return 0;
+    switch (*s){
+    case '{':
+        s = jf_skip_space(s + 1, end);
+        if (s < end && *s == '}'){
+            s++;
+            break;
+        }
+        while (1){
+            if (s >= end || *s != '"')
+                return 0;
+            if ((s = jf_scan_string(jf, s + 1)) == NULL)
+                return 0;
+            name = cbuf_get(jf->jf_cb);
+            if ((p = strchr(name, ':')) != NULL){
+                *p = '\0';
+                x = jf_new(jf, *xcp, name, p + 1);
+            }
+            else
+                x = jf_new(jf, *xcp, NULL, name);
+            if (x == NULL)
+                return -1;
+            s = jf_skip_space(s, end);
+            if (s >= end || *s != ':')
+                return 0;
+            s = jf_skip_space(s + 1, end);
+            if ((ret = jf_value(jf, &s, &x, depth + 1)) <= 0)
+                return ret;
+            s = jf_skip_space(s, end);
+            if (s < end && *s == ','){
+                s = jf_skip_space(s + 1, end);
+                continue;
+            }
+            if (s < end && *s == '}'){
+                s++;
+                break;
+            }
+            return 0;
+        }
+        break;
+    case '[':
+        s = jf_skip_space(s + 1, end);
+        if (s < end && *s == ']'){
+            s++;
+            break;
+        }
+        while (1){
+            if ((ret = jf_value(jf, &s, xcp, depth + 1)) <= 0)
+                return ret;
+            s = jf_skip_space(s, end);
+            if (s < end && *s == ','){
+                /* Next value in a sibling with same name, as json_current_clone */
+                if ((xp = xml_parent(*xcp)) == NULL || *xcp == jf->jf_jy->jy_xtop)
+                    return 0;
+                if ((x = jf_new(jf, xp, xml_prefix(*xcp), xml_name(*xcp))) == NULL)
+                    return -1;
+                *xcp = x;
+                s = jf_skip_space(s + 1, end);
+                continue;
+            }
+            if (s < end && *s == ']'){
+                s++;
+                break;
+            }
+            return 0;
+        }
+        break;
+    case '"':
+        if ((s = jf_scan_string(jf, s + 1)) == NULL)
+            return 0;
+        if (jf_body(*xcp, cbuf_get(jf->jf_cb)) < 0)
+            return -1;
+        break;
+    case 't':
+        if (end - s < 4 || strncmp(s, "true", 4) != 0)
+            return 0;
+        if (jf_body(*xcp, "true") < 0)
+            return -1;
+        s += 4;
+        break;
+    case 'f':
+        if (end - s < 5 || strncmp(s, "false", 5) != 0)
+            return 0;
+        if (jf_body(*xcp, "false") < 0)
+            return -1;
+        s += 5;
+        break;
+    case 'n':
+        if (end - s < 4 || strncmp(s, "null", 4) != 0)
+            return 0;
+        if (jf_body(*xcp, NULL) < 0)
+            return -1;
+        s += 4;
+        break;
+    default:
+        if ((p = jf_scan_number(s, end)) == NULL)
+            return 0;
+        cbuf_reset(jf->jf_cb);
+        cbuf_append_buf(jf->jf_cb, s, p - s);
+        if (jf_body(*xcp, cbuf_get(jf->jf_cb)) < 0)
+            return -1;
+        s = p;
+        break;
+    }
+    *sp = s;
+    return 1;
+}
+
+/*! Parse JSON directly into an XML tree
+ *
+ * Created top-level elements are added to jy_xvec, as by the bison parser.
+ * If the document is not a top-level object, uses constructs not handled here, or is not
+ * well-formed, all created objects are removed and 0 is returned, the caller then parses
+ * the input with the flex/bison parser, which also reports errors.
+ * @param[in]  jy   JSON parser yacc handler struct, with parse string, length and top
+ * @retval     1    OK, tree created
+ * @retval     0    Not handled, use regular parser
+ * @retval    -1    Error
+ */
+int
+clixon_json_parse_fast(clixon_json_yacc *jy)
+{
+    int              retval = -1;
+    struct json_fast jf = {0,};
+    char            *s = jy->jy_parse_string;
+    cxobj           *xc;
+    int              ret;
+    int              i;
+
+    jf.jf_jy = jy;
+    jf.jf_end = s + (jy->jy_parse_len ? jy->jy_parse_len : strlen(s));
+    s = jf_skip_space(s, jf.jf_end);
+    if (s >= jf.jf_end || *s != '{')
+        return 0;
+    if ((jf.jf_cb = cbuf_new()) == NULL){
+        clixon_err(OE_JSON, errno, "cbuf_new");
+        goto done;
+    }
+    xc = jy->jy_xtop;
+    if ((ret = jf_value(&jf, &s, &xc, 0)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (jf_skip_space(s, jf.jf_end) != jf.jf_end)
+        goto fail;
+    retval = 1;
+ done:
+    if (jf.jf_cb)
+        cbuf_free(jf.jf_cb);
+    return retval;
+ fail:
+    /* Remove created objects, the regular parser starts from scratch */
+    for (i = 0; i < jy->jy_xlen; i++)
+        xml_purge(jy->jy_xvec[i]);
+    if (jy->jy_xvec)
+        free(jy->jy_xvec);
+    jy->jy_xvec = NULL;
+    jy->jy_xlen = 0;
+    retval = 0;
+    goto done;
+}
@@ -0,0 +1,393 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * Per-subsystem memory accounting
+ * Memory held by datastore caches, search indexes, caches of XPath, api-path, regexp and
+ * NACM, and replay buffers of streams, plus subsystems and plugins registered with
+ * clixon_memstats_register. Sizes are computed from the data structures when asked for,
+ * no allocations are wrapped. Peaks are high-water marks of the values when sampled,
+ * ie on each stats request.
+ * Process heap in use (mallinfo2 if available) and peak resident set size are reported
+ * for comparison with the sum of the subsystems.
+ * The accounting is exposed in the stats RPC, see from_client_stats
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#ifdef HAVE_MALLINFO2
+#include <malloc.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_string.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_yang_module.h"
+#include "clixon_datastore.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_path.h"
+#include "clixon_regex.h"
+#include "clixon_nacm.h"
+#include "clixon_stream.h"
+#include "clixon_memstats.h"
+
+/*
+ * Types
+ */
+/*! Subsystem with high-water mark, and reporter if registered
+ */
+struct memstats_entry{
+    qelem_t             me_q;    /* Queue of entries, in order of first sample */
+    char               *me_name; /* Name of subsystem */
+    clixon_memstats_fn *me_fn;   /* Reporter, or NULL for built-in subsystem */
+    void               *me_arg;  /* Argument of reporter */
+    size_t              me_peak; /* Largest sampled size */
+};
+
+/*
+ * Variables
+ */
+/* Subsystems: name -> struct memstats_entry* */
+static clicon_hash_t         *_memstats = NULL;
+/* Queue of subsystems */
+static struct memstats_entry *_memstats_list = NULL;
+/* Largest sampled heap in use */
+static size_t                 _memstats_heap_peak = 0;
+
+/*! Find or create subsystem entry
+ *
+ * @param[in]  name  Name of subsystem
+ * @retval     me    Entry
+ * @retval     NULL  Error
+ */
+static struct memstats_entry *
+memstats_entry_get(const char *name)
+{
+    struct memstats_entry  *me = NULL;
+    struct memstats_entry **mep;
+
+    if (_memstats == NULL &&
+        (_memstats = clicon_hash_init()) == NULL)
+        return NULL;
+    if ((mep = clicon_hash_value(_memstats, name, NULL)) != NULL)
+        return *mep;
+    if ((me = calloc(1, sizeof(*me))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    if ((me->me_name = strdup(name)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(me);
+        return NULL;
+    }
+    if (clicon_hash_add(_memstats, name, &me, sizeof(me)) == NULL){
+        free(me->me_name);
+        free(me);
+        return NULL;
+    }
+    ADDQ(me, _memstats_list);
+    return me;
+}
+
+/*! Register memory reporter of a subsystem or plugin
+ *
+ * The reporter is called on each stats request with memory accounting
+ * @param[in]  name  Name of subsystem, eg plugin name
+ * @param[in]  fn    Reporter
+ * @param[in]  arg   Argument given to reporter
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @code
+ *   static int
+ *   example_memstats(clixon_handle h, void *arg, uint64_t *nr, size_t *size)
+ *   {
+ *      *nr = _nentries;
+ *      *size = _nentries*sizeof(struct entry);
+ *      return 0;
+ *   }
+ *   clixon_memstats_register("example", example_memstats, NULL);
+ * @endcode
+ */
+int
+clixon_memstats_register(const char         *name,
+                         clixon_memstats_fn *fn,
+                         void               *arg)
+{
+    struct memstats_entry *me;
+
+    if ((me = memstats_entry_get(name)) == NULL)
+        return -1;
+    me->me_fn = fn;
+    me->me_arg = arg;
+    return 0;
+}
+
+/*! Print one subsystem and update its high-water mark
+ */
+static int
+memstats_print_one(cbuf       *cb,
+                   const char *name,
+                   uint64_t    nr,
+                   size_t      sz)
+{
+    struct memstats_entry *me;
+
+    if ((me = memstats_entry_get(name)) == NULL)
+        return -1;
+    if (sz > me->me_peak)
+        me->me_peak = sz;
+    cprintf(cb, "<subsystem><name>%s</name>", name);
+    cprintf(cb, "<nr>%" PRIu64 "</nr>", nr);
+    cprintf(cb, "<size>%zu</size>", sz);
+    cprintf(cb, "<peak>%zu</peak>", me->me_peak);
+    cprintf(cb, "</subsystem>");
+    return 0;
+}
+
+/*! Print datastore caches and their search indexes
+ *
+ * Only datastores in the cache are counted, datastores are not read from file
+ */
+static int
+memstats_print_datastores(clixon_handle h,
+                          cbuf         *cb)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen = 0;
+    db_elmnt *de;
+    uint64_t  nr;
+    size_t    sz;
+    size_t    isz = 0;
+    uint64_t  inr = 0;
+    char      name[128];
+    int       i;
+
+    if (clicon_db_elmnt(h) == NULL)
+        goto ok;
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++){
+        if ((de = clicon_db_elmnt_get(h, keys[i])) == NULL || de->de_xml == NULL)
+            continue;
+        nr = 0;
+        sz = 0;
+        if (xml_stats(de->de_xml, &nr, &sz) < 0)
+            goto done;
+        /* Published read-only copy, unless shared with the cache */
+        if (de->de_rdonly && de->de_rdonly != de->de_xml &&
+            xml_stats(de->de_rdonly, &nr, &sz) < 0)
+            goto done;
+        snprintf(name, sizeof(name), "datastore/%s", keys[i]);
+        if (memstats_print_one(cb, name, nr, sz) < 0)
+            goto done;
+        inr++;
+        if (xml_stats_index(de->de_xml, &isz) < 0)
+            goto done;
+    }
+    if (memstats_print_one(cb, "search-index", inr, isz) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Print YANG specs of all module-sets
+ */
+static int
+memstats_print_yang(clixon_handle h,
+                    cbuf         *cb)
+{
+    yang_stmt *ymounts;
+    yang_stmt *ydomain;
+    yang_stmt *yspec;
+    uint64_t   nr = 0;
+    size_t     sz = 0;
+    int        inext;
+    int        inext2;
+
+    if ((ymounts = clixon_yang_mounts_get(h)) != NULL){
+        inext = 0;
+        while ((ydomain = yn_iter(ymounts, &inext)) != NULL) {
+            inext2 = 0;
+            while ((yspec = yn_iter(ydomain, &inext2)) != NULL)
+                if (yang_stats(yspec, 0, &nr, &sz) < 0)
+                    return -1;
+        }
+    }
+    return memstats_print_one(cb, "yang", nr, sz);
+}
+
+/*! Print heap in use, its high-water mark, and peak resident set size
+ */
+static int
+memstats_print_heap(cbuf *cb)
+{
+    struct rusage ru;
+#ifdef HAVE_MALLINFO2
+    struct mallinfo2 mi;
+    size_t           heap;
+
+    mi = mallinfo2();
+    heap = mi.uordblks + mi.hblkhd;
+    if (heap > _memstats_heap_peak)
+        _memstats_heap_peak = heap;
+    cprintf(cb, "<heap-inuse>%zu</heap-inuse>", heap);
+    cprintf(cb, "<heap-peak>%zu</heap-peak>", _memstats_heap_peak);
+#endif
+    if (getrusage(RUSAGE_SELF, &ru) < 0){
+        clixon_err(OE_UNIX, errno, "getrusage");
+        return -1;
+    }
+    /* ru_maxrss is in kilobytes */
+    cprintf(cb, "<rss-peak>%" PRIu64 "</rss-peak>", (uint64_t)ru.ru_maxrss*1024);
+    return 0;
+}
+
+/*! Print memory accounting as XML of clixon-lib stats memory
+ *
+ * Built-in subsystems first, then registered subsystems in order of registration
+ * @param[in]  h    Clixon handle
+ * @param[in]  cb   CLIgen buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_memstats_register
+ */
+int
+clixon_memstats_print(clixon_handle h,
+                      cbuf         *cb)
+{
+    int                    retval = -1;
+    struct memstats_entry *me;
+    uint64_t               nr;
+    uint64_t               hits;
+    uint64_t               misses;
+    size_t                 sz;
+
+    if (memstats_print_heap(cb) < 0)
+        goto done;
+    if (memstats_print_datastores(h, cb) < 0)
+        goto done;
+    if (memstats_print_yang(h, cb) < 0)
+        goto done;
+    if (xpath_parse_cache_stats(&nr, &sz) < 0)
+        goto done;
+    if (memstats_print_one(cb, "xpath-cache", nr, sz) < 0)
+        goto done;
+    if (api_path_cache_stats(&nr, &sz) < 0)
+        goto done;
+    if (memstats_print_one(cb, "api-path-cache", nr, sz) < 0)
+        goto done;
+    if (regex_cache_stats(&nr, &hits, &misses) < 0)
+        goto done;
+    if (regex_cache_size(&sz) < 0)
+        goto done;
+    if (memstats_print_one(cb, "regex-cache", nr, sz) < 0)
+        goto done;
+    if (nacm_cache_stats(h, &nr, &sz) < 0)
+        goto done;
+    if (memstats_print_one(cb, "nacm-cache", nr, sz) < 0)
+        goto done;
+    if (stream_replay_stats(h, &nr, &sz) < 0)
+        goto done;
+    if (memstats_print_one(cb, "stream-replay", nr, sz) < 0)
+        goto done;
+    if ((me = _memstats_list) != NULL){
+        do {
+            if (me->me_fn){
+                nr = 0;
+                sz = 0;
+                if (me->me_fn(h, me->me_arg, &nr, &sz) < 0)
+                    goto done;
+                if (memstats_print_one(cb, me->me_name, nr, sz) < 0)
+                    goto done;
+            }
+            me = NEXTQ(struct memstats_entry *, me);
+        } while (me && me != _memstats_list);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Remove registrations and high-water marks
+ *
+ * @retval     0     OK
+ */
+int
+clixon_memstats_exit(void)
+{
+    struct memstats_entry *me;
+
+    while ((me = _memstats_list) != NULL){
+        DELQ(me, _memstats_list, struct memstats_entry *);
+        free(me->me_name);
+        free(me);
+    }
+    if (_memstats){
+        clicon_hash_free(_memstats);
+        _memstats = NULL;
+    }
+    _memstats_heap_peak = 0;
+    return 0;
+}
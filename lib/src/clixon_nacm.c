@@ -78,11 +78,17 @@
 #include "clixon_path.h"
 #include "clixon_xml_vec.h"
 #include "clixon_yang_parse_lib.h"
+#include "clixon_yang_schema_mount.h"
 #include "clixon_nacm.h"
 
 /* NACM namespace for use with xml namespace contexts and xpath */
 #define NACM_NS "urn:ietf:params:xml:ns:yang:ietf-netconf-acm"
 
+/* Verdicts of YANG nodes are used for read or write access */
+#if defined(NACM_READ_SCHEMA) || defined(NACM_WRITE_SCHEMA)
+#define NACM_SCHEMA_VERDICT
+#endif
+
 /*! Add user to list of NACM proxyusers that may represent other users
  *
  * Typical case is restconf daemon which makes its own authentication
@@ -174,6 +180,529 @@ match_access(char *accops,
     return 0;
 }
 
+/*---------------------------------------------------------------
+ * Compiled NACM rules
+ * The effective rules of a user are the rules of all rule-lists matching the groups
+ * of the user, in configuration order. They are compiled once per NACM configuration
+ * and username, and reused by all requests until the NACM configuration changes.
+ */
+
+/* Access bit of enum nacm_access in compiled rule */
+#define NACM_ACCESS_BIT(a) (1 << (a))
+
+/* Rule-type of NACM rule, see RFC8341 rule-type choice */
+enum nacm_rule_type{
+    NACM_RULE_ANY,          /* No rule-type, matches all */
+    NACM_RULE_RPC,          /* protocol-operation: rpc-name */
+    NACM_RULE_NOTIFICATION, /* notification: notification-name */
+    NACM_RULE_DATA          /* data-node: path */
+};
+
+/*! Compiled NACM rule
+ */
+struct nacm_rule{
+    cxobj              *nr_xrule;  /* NACM rule XML */
+    int                 nr_access; /* Access-operations as NACM_ACCESS_BIT bits */
+    enum nacm_rule_type nr_type;   /* Rule-type */
+    char               *nr_path;   /* Trimmed path if data-node rule */
+#ifdef NACM_SCHEMA_VERDICT
+    int                 nr_yresolved; /* Path resolved to nr_ytarget: 1, unresolvable: -1 */
+    yang_stmt          *nr_ytarget;   /* YANG node of path, NULL if root */
+#endif
+};
+
+/*! Effective NACM rules of a user
+ */
+struct nacm_user{
+    size_t            nu_groups; /* Number of groups of user, 0 if no groups */
+    struct nacm_rule *nu_rules;  /* Rules of rule-lists of user groups, in order */
+    size_t            nu_len;    /* Length of nu_rules */
+    int               nu_permit; /* NACM_ACCESS_BIT bits: first data rule permits all nodes */
+    int               nu_norule; /* NACM_ACCESS_BIT bits: no data rule, default decides */
+#ifdef NACM_SCHEMA_VERDICT
+    clicon_hash_t    *nu_yverdict[NACM_EXEC]; /* Per access: YANG node -> verdict, see nacm_verdict */
+#endif
+};
+
+/*! Cache of compiled NACM rules, valid as long as the NACM configuration is unchanged
+ *
+ * Keyed by NACM generation, see nacm_generation
+ */
+struct nacm_compiled{
+    uint64_t       nc_gen;   /* NACM generation of rules */
+    cxobj         *nc_xnacm; /* Private copy of NACM tree, compiled rules refer to it */
+    cxobj         *nc_req;   /* Copy of nc_xnacm returned by last nacm_access_pre */
+    clicon_hash_t *nc_users; /* Username -> struct nacm_user* */
+};
+
+/*! Translate NACM access-operations to access bits
+ *
+ * @param[in] accops Access operations, eg "read create" or "*"
+ * @retval    bits   NACM_ACCESS_BIT bits
+ * @see match_access
+ */
+static int
+nacm_access_bits(char *accops)
+{
+    int bits = 0;
+
+    if (accops == NULL)
+        return 0;
+    if (strcmp(accops, "*") == 0)
+        return NACM_ACCESS_BIT(NACM_CREATE) | NACM_ACCESS_BIT(NACM_READ) |
+            NACM_ACCESS_BIT(NACM_UPDATE) | NACM_ACCESS_BIT(NACM_DELETE) |
+            NACM_ACCESS_BIT(NACM_EXEC);
+    if (strstr(accops, "create") != NULL)
+        bits |= NACM_ACCESS_BIT(NACM_CREATE);
+    if (strstr(accops, "read") != NULL)
+        bits |= NACM_ACCESS_BIT(NACM_READ);
+    if (strstr(accops, "update") != NULL)
+        bits |= NACM_ACCESS_BIT(NACM_UPDATE);
+    if (strstr(accops, "delete") != NULL)
+        bits |= NACM_ACCESS_BIT(NACM_DELETE);
+    if (strstr(accops, "exec") != NULL)
+        bits |= NACM_ACCESS_BIT(NACM_EXEC);
+    if (strstr(accops, "write") != NULL)
+        bits |= NACM_ACCESS_BIT(NACM_CREATE) | NACM_ACCESS_BIT(NACM_UPDATE) |
+            NACM_ACCESS_BIT(NACM_DELETE);
+    return bits;
+}
+
+/*! Free effective rules of a user
+ *
+ * @param[in]  nu   Effective rules of user
+ */
+static void
+nacm_user_free(struct nacm_user *nu)
+{
+    size_t i;
+
+    for (i=0; i<nu->nu_len; i++)
+        if (nu->nu_rules[i].nr_path)
+            free(nu->nu_rules[i].nr_path);
+    if (nu->nu_rules)
+        free(nu->nu_rules);
+#ifdef NACM_SCHEMA_VERDICT
+    for (i=0; i<NACM_EXEC; i++)
+        if (nu->nu_yverdict[i])
+            clicon_hash_free(nu->nu_yverdict[i]);
+#endif
+    free(nu);
+}
+
+/*! Find data node accesses of a user that are decided without matching rules per node
+ *
+ * For each data node access, the first rule with that access that is not an rpc or
+ * notification rule decides if all nodes are permitted: a rule of module "*" without
+ * path that permits. If there is no such rule, the read or write default decides.
+ * @param[in]  nu   Effective rules of user
+ */
+static void
+nacm_user_permit_compile(struct nacm_user *nu)
+{
+    struct nacm_rule *nr;
+    enum nacm_access  access;
+    char             *module_pattern;
+    char             *action;
+    size_t            i;
+
+    for (access = NACM_CREATE; access <= NACM_DELETE; access++){
+        for (i=0; i<nu->nu_len; i++){
+            nr = &nu->nu_rules[i];
+            if ((nr->nr_access & NACM_ACCESS_BIT(access)) == 0)
+                continue;
+            if (nr->nr_type != NACM_RULE_ANY && nr->nr_type != NACM_RULE_DATA)
+                continue;
+            break;
+        }
+        if (i == nu->nu_len){
+            nu->nu_norule |= NACM_ACCESS_BIT(access);
+            continue;
+        }
+        if (nr->nr_type == NACM_RULE_ANY &&
+            (module_pattern = xml_find_body(nr->nr_xrule, "module-name")) != NULL &&
+            strcmp(module_pattern, "*") == 0 &&
+            (action = xml_find_body(nr->nr_xrule, "action")) != NULL &&
+            strcmp(action, "permit") == 0)
+            nu->nu_permit |= NACM_ACCESS_BIT(access);
+    }
+}
+
+/*! Compile effective rules of a user: resolve groups and rule-lists, parse rules
+ *
+ * @param[in]  xnacm    NACM xml tree
+ * @param[in]  username User name of requestor, or NULL
+ * @param[out] nup      Effective rules of user, free with nacm_user_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see RFC8341 3.4.4 steps 4-6 and 3.4.5 steps 3-5
+ */
+static int
+nacm_user_compile(cxobj             *xnacm,
+                  char              *username,
+                  struct nacm_user **nup)
+{
+    int               retval = -1;
+    struct nacm_user *nu = NULL;
+    struct nacm_rule *nr;
+    cvec             *nsc = NULL;
+    cxobj           **gvec = NULL; /* groups */
+    size_t            glen = 0;
+    cxobj           **rlistvec = NULL; /* rule-list */
+    size_t            rlistlen = 0;
+    cxobj           **rvec = NULL; /* rules */
+    size_t            rlen = 0;
+    cxobj            *rlist;
+    cxobj            *xrule;
+    cxobj            *pathobj;
+    char             *gname;
+    char             *path;
+    int               i;
+    int               j;
+
+    if ((nu = malloc(sizeof(*nu))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(nu, 0, sizeof(*nu));
+    if (username == NULL)
+        goto ok;
+    /* Create namespace context for with nacm namespace as default */
+    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
+        goto done;
+    /* User's group */
+    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+        goto done;
+    nu->nu_groups = glen;
+    if (glen == 0)
+        goto ok;
+    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
+        goto done;
+    for (i=0; i<rlistlen; i++){
+        rlist = rlistvec[i];
+        /* Loop through user's group to find match in this rule-list */
+        for (j=0; j<glen; j++){
+            gname = xml_find_body(gvec[j], "name");
+            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
+                break; /* found */
+        }
+        if (j==glen) /* not found */
+            continue;
+        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
+            goto done;
+        if (rlen){
+            if ((nr = realloc(nu->nu_rules, (nu->nu_len+rlen)*sizeof(*nr))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            nu->nu_rules = nr;
+        }
+        for (j=0; j<rlen; j++){
+            xrule = rvec[j];
+            nr = &nu->nu_rules[nu->nu_len];
+            memset(nr, 0, sizeof(*nr));
+            nr->nr_xrule = xrule;
+            nr->nr_access = nacm_access_bits(xml_find_body(xrule, "access-operations"));
+            if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) != NULL){
+                nr->nr_type = NACM_RULE_DATA;
+                path = clixon_trim2(xml_body(pathobj), " \t\n");
+                if ((nr->nr_path = strdup(path)) == NULL){
+                    clixon_err(OE_UNIX, errno, "strdup");
+                    goto done;
+                }
+            }
+            else if (xml_find_body(xrule, "rpc-name"))
+                nr->nr_type = NACM_RULE_RPC;
+            else if (xml_find_body(xrule, "notification-name"))
+                nr->nr_type = NACM_RULE_NOTIFICATION;
+            nu->nu_len++;
+        }
+        if (rvec){
+            free(rvec);
+            rvec = NULL;
+        }
+    }
+ ok:
+    nacm_user_permit_compile(nu);
+    *nup = nu;
+    nu = NULL;
+    retval = 0;
+ done:
+    if (nu)
+        nacm_user_free(nu);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (gvec)
+        free(gvec);
+    if (rlistvec)
+        free(rlistvec);
+    if (rvec)
+        free(rvec);
+    return retval;
+}
+
+/*! Free compiled NACM rules cache
+ *
+ * @param[in]  nc   Compiled NACM rules
+ */
+static void
+nacm_compiled_free(struct nacm_compiled *nc)
+{
+    char            **keys = NULL;
+    size_t            klen = 0;
+    size_t            i;
+    struct nacm_user **nup;
+
+    if (nc->nc_users){
+        if (clicon_hash_keys(nc->nc_users, &keys, &klen) == 0){
+            for (i=0; i<klen; i++)
+                if ((nup = clicon_hash_value(nc->nc_users, keys[i], NULL)) != NULL)
+                    nacm_user_free(*nup);
+            if (keys)
+                free(keys);
+        }
+        clicon_hash_free(nc->nc_users);
+    }
+    if (nc->nc_xnacm)
+        xml_free(nc->nc_xnacm);
+    free(nc);
+}
+
+/*! Get generation of NACM configuration, which changes if NACM rules may have changed
+ *
+ * In internal mode, the content generation of running. In external mode, incremented each
+ * time the external NACM tree is set, see clicon_nacm_ext_set.
+ * Can be used to key results that depend on NACM rules, such as replies of a user
+ * @param[in]  h    Clixon handle
+ * @retval     gen  NACM generation, 0 if NACM is disabled
+ */
+uint64_t
+nacm_generation(clixon_handle h)
+{
+    char *mode;
+    int   gen;
+
+    if ((mode = clicon_option_str(h, "CLICON_NACM_MODE")) == NULL)
+        return 0;
+    if (strcmp(mode, "internal") == 0)
+        return xmldb_generation(h, "running");
+    if (strcmp(mode, "external") == 0){
+        if ((gen = clicon_data_int_get(h, "nacm_ext_gen")) < 0)
+            gen = 0;
+        return (1ULL << 63) | (uint64_t)gen; /* Distinct from running generations */
+    }
+    return 0;
+}
+
+/*! Return number of users and size of compiled NACM rules cache
+ *
+ * Includes the copies of the NACM tree, compiled rules and YANG verdict caches of users
+ * @param[in]  h    Clixon handle
+ * @param[out] nr   Number of users with compiled rules
+ * @param[out] szp  Size in bytes
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+nacm_cache_stats(clixon_handle h,
+                 uint64_t     *nr,
+                 size_t       *szp)
+{
+    int                   retval = -1;
+    struct nacm_compiled *nc = NULL;
+    struct nacm_user    **nup;
+    struct nacm_user     *nu;
+    char                **keys = NULL;
+    size_t                klen = 0;
+    size_t                i;
+    size_t                j;
+    size_t                sz = 0;
+    uint64_t              n = 0;
+    uint64_t              n1;
+    size_t                sz1;
+
+    *nr = 0;
+    *szp = 0;
+    if (clicon_ptr_get(h, "nacm-compiled", (void**)&nc) < 0 || nc == NULL)
+        goto ok;
+    sz += sizeof(*nc);
+    if (nc->nc_xnacm && xml_stats(nc->nc_xnacm, &n, &sz) < 0)
+        goto done;
+    if (nc->nc_req && xml_stats(nc->nc_req, &n, &sz) < 0)
+        goto done;
+    if (nc->nc_users){
+        if (clicon_hash_stats(nc->nc_users, &n1, &sz1) < 0)
+            goto done;
+        sz += sz1;
+        if (clicon_hash_keys(nc->nc_users, &keys, &klen) < 0)
+            goto done;
+        for (i=0; i<klen; i++){
+            if ((nup = clicon_hash_value(nc->nc_users, keys[i], NULL)) == NULL)
+                continue;
+            nu = *nup;
+            sz += sizeof(*nu) + nu->nu_len*sizeof(struct nacm_rule);
+            for (j=0; j<nu->nu_len; j++)
+                if (nu->nu_rules[j].nr_path)
+                    sz += strlen(nu->nu_rules[j].nr_path) + 1;
+#ifdef NACM_SCHEMA_VERDICT
+            for (j=0; j<NACM_EXEC; j++)
+                if (nu->nu_yverdict[j]){
+                    if (clicon_hash_stats(nu->nu_yverdict[j], &n1, &sz1) < 0)
+                        goto done;
+                    sz += sz1;
+                }
+#endif
+        }
+        *nr = klen;
+    }
+    *szp = sz;
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Get compiled NACM rules cache if it is valid for a NACM configuration
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  gen  NACM generation, see nacm_generation, 0 means no cache
+ * @retval     nc   Compiled NACM rules
+ * @retval     NULL No valid cache
+ */
+static struct nacm_compiled *
+nacm_compiled_get(clixon_handle h,
+                  uint64_t      gen)
+{
+    struct nacm_compiled *nc = NULL;
+
+    if (gen == 0)
+        return NULL;
+    if (clicon_ptr_get(h, "nacm-compiled", (void**)&nc) < 0 || nc == NULL)
+        return NULL;
+    if (nc->nc_gen != gen)
+        return NULL;
+    return nc;
+}
+
+/*! Replace compiled NACM rules cache with a new empty cache of a NACM configuration
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  gen   NACM generation, see nacm_generation
+ * @param[in]  xnacm NACM xml tree, copied
+ * @retval     nc    Compiled NACM rules
+ * @retval     NULL  Error
+ */
+static struct nacm_compiled *
+nacm_compiled_new(clixon_handle h,
+                  uint64_t      gen,
+                  cxobj        *xnacm)
+{
+    struct nacm_compiled *nc = NULL;
+
+    if (clicon_ptr_get(h, "nacm-compiled", (void**)&nc) == 0 && nc != NULL){
+        nacm_compiled_free(nc);
+        clicon_ptr_del(h, "nacm-compiled");
+    }
+    if ((nc = malloc(sizeof(*nc))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(nc, 0, sizeof(*nc));
+    nc->nc_gen = gen;
+    if ((nc->nc_users = clicon_hash_init()) == NULL)
+        goto err;
+    if ((nc->nc_xnacm = xml_dup(xnacm)) == NULL)
+        goto err;
+    if (clicon_ptr_set(h, "nacm-compiled", (void*)nc) < 0)
+        goto err;
+ done:
+    return nc;
+ err:
+    nacm_compiled_free(nc);
+    nc = NULL;
+    goto done;
+}
+
+/*! Get effective rules of a user
+ *
+ * If xnacm was returned by nacm_access_pre and the NACM configuration is cached, the
+ * rules are compiled once per user and cached. Otherwise they are compiled from xnacm.
+ * @param[in]  h        Clixon handle
+ * @param[in]  xnacm    NACM xml tree
+ * @param[in]  username User name of requestor, or NULL
+ * @param[out] nup      Effective rules of user
+ * @param[out] freep    Set to 1 if nup is not cached, then free with nacm_user_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+nacm_user_get(clixon_handle      h,
+              cxobj             *xnacm,
+              char              *username,
+              struct nacm_user **nup,
+              int               *freep)
+{
+    int                   retval = -1;
+    struct nacm_compiled *nc = NULL;
+    struct nacm_user     *nu = NULL;
+    struct nacm_user    **p;
+
+    *freep = 0;
+    if (username != NULL &&
+        clicon_ptr_get(h, "nacm-compiled", (void**)&nc) == 0 &&
+        nc != NULL && nc->nc_req == xnacm){
+        if ((p = clicon_hash_value(nc->nc_users, username, NULL)) != NULL){
+            *nup = *p;
+            goto ok;
+        }
+        if (nacm_user_compile(nc->nc_xnacm, username, &nu) < 0)
+            goto done;
+        if (clicon_hash_add(nc->nc_users, username, &nu, sizeof(nu)) == NULL){
+            nacm_user_free(nu);
+            goto done;
+        }
+        clixon_debug(CLIXON_DBG_NACM | CLIXON_DBG_DETAIL, "compiled %zu rules of user %s",
+                     nu->nu_len, username);
+        *nup = nu;
+        goto ok;
+    }
+    if (nacm_user_compile(xnacm, username, nup) < 0)
+        goto done;
+    *freep = 1;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if all data nodes are permitted for a user and access
+ *
+ * @param[in]  nu       Effective rules of user
+ * @param[in]  access   NACM data node access, not exec
+ * @param[in]  defname  Default of access, eg "read-default", in xnacm
+ * @param[in]  xnacm    NACM xml tree
+ * @retval     1        All nodes permitted, rules need not be matched per node
+ * @retval     0        Rules must be matched per node
+ */
+static int
+nacm_user_permit_all(struct nacm_user *nu,
+                     enum nacm_access  access,
+                     const char       *defname,
+                     cxobj            *xnacm)
+{
+    char *def;
+
+    if (nu->nu_permit & NACM_ACCESS_BIT(access))
+        return 1;
+    if ((nu->nu_norule & NACM_ACCESS_BIT(access)) &&
+        (def = xml_find_body(xnacm, defname)) != NULL &&
+        strcmp(def, "permit") == 0)
+        return 1;
+    return 0;
+}
+
 /*! Match nacm single rule. Either match with access or deny. Or not match.
  *
  * @param[in]  rpc    rpc name
@@ -238,6 +767,7 @@ nacm_rule_rpc(char  *rpc,
 
 /*! Process nacm incoming RPC message validation steps
  *
+ * @param[in]  h        Clixon handle
  * @param[in]  rpc      rpc name
  * @param[in]  module   Yang module name
  * @param[in]  username User name of requestor
@@ -251,31 +781,22 @@ nacm_rule_rpc(char  *rpc,
  * @see nacm_datanode_read
  */
 int
-nacm_rpc(char         *rpc,
+nacm_rpc(clixon_handle h,
+         char         *rpc,
          char         *module,
          char         *username,
          cxobj        *xnacm,
          cbuf         *cbret)
 {
-    int     retval = -1;
-    cxobj  *xrule;
-    cxobj **gvec = NULL; /* groups */
-    size_t  glen;
-    cxobj  *rlist;
-    cxobj **rlistvec = NULL; /* rule-list */
-    size_t  rlistlen;
-    cxobj **rvec = NULL; /* rules */
-    size_t  rlen;
-    int     i, j;
-    char   *exec_default = NULL;
-    char   *gname;
-    char   *action;
-    int     match= 0;
-    cvec   *nsc = NULL;
+    int               retval = -1;
+    cxobj            *xrule = NULL;
+    struct nacm_user *nu = NULL;
+    int               nufree = 0;
+    int               i;
+    char             *exec_default = NULL;
+    char             *action;
+    int               match= 0;
 
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
     /* 3.   If the requested operation is the NETCONF <close-session>
        protocol operation, then the protocol operation is permitted.
     */
@@ -290,47 +811,28 @@ nacm_rpc(char         *rpc,
         clixon_debug(CLIXON_DBG_NACM, "NACM rpc deny: No user in message");
         goto step10;
     }
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    /* User's groups and rule-lists, see nacm_user_compile */
+    if (nacm_user_get(h, xnacm, username, &nu, &nufree) < 0)
         goto done;
     /* 5. If no groups are found, continue with step 10. */
-    if (glen == 0)
+    if (nu->nu_groups == 0)
         goto step10;
     /* 6. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
-    for (i=0; i<rlistlen; i++){
-        rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
-        }
-        if (j==glen) /* not found */
-            continue;
-        /* 7. For each rule-list entry found, process all rules, in order,
+        entry.
+       7. For each rule-list entry found, process all rules, in order,
            until a rule that matches the requested access operation is
            found.
-        */
-        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
+    */
+    for (i=0; i<nu->nu_len; i++){
+        if ((nu->nu_rules[i].nr_access & NACM_ACCESS_BIT(NACM_EXEC)) == 0)
+            continue;
+        xrule = nu->nu_rules[i].nr_xrule;
+        if ((match = nacm_rule_rpc(rpc, module, xrule)) < 0)
             goto done;
-        for (j=0; j<rlen; j++){
-            xrule = rvec[j];
-            if ((match = nacm_rule_rpc(rpc, module, xrule)) < 0)
-                goto done;
-            if (match)
-                break;
-        }
         if (match)
             break;
-        if (rvec){
-            free(rvec);
-            rvec=NULL;
-        }
     }
     if (match){
         if ((action = xml_find_body(xrule, "action")) == NULL)
@@ -372,14 +874,8 @@ nacm_rpc(char         *rpc,
  done:
     clixon_debug(CLIXON_DBG_NACM | CLIXON_DBG_DETAIL, "%s %s:%s: %s",
                  username, module, rpc, retval==1?"permit":retval==0?"deny":"error");
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
-    if (rvec)
-        free(rvec);
+    if (nu && nufree)
+        nacm_user_free(nu);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -450,167 +946,282 @@ prepvec_add(prepvec **pv_listp,
  * @param[in]  h        Clixon handle
  * @param[in]  xt       XML request root tree with "config" label at top.
  * @param[in]  access   NACM access of xreq
- * @param[in]  gvec     Vector of groups
- * @param[in]  glen     Length of gvec
- * @param[in]  rlistvec Rule-list entries
- * @param[in]  rlistlen Length of rlistvec
- * @param[in]  nsc      Namespace context of rule-list
+ * @param[in]  nu       Effective rules of user
  * @param[out] pv_listp Precomputed rules + paths that apply to user group
  * @retval     0        OK
  * @retval    -1        Error
  */
 static int
-nacm_datanode_prepare(clixon_handle    h,
-                      cxobj           *xt,
-                      enum nacm_access access,
-                      cxobj          **gvec,
-                      size_t           glen,
-                      cxobj          **rlistvec,
-                      size_t           rlistlen,
-                      cvec            *nsc,
-                      prepvec        **pv_listp)
+nacm_datanode_prepare(clixon_handle     h,
+                      cxobj            *xt,
+                      enum nacm_access  access,
+                      struct nacm_user *nu,
+                      prepvec         **pv_listp)
 {
-    int        retval = -1;
-    cxobj     *rlist;
-    int        i;
-    int        j;
-    int        k;
-    char      *gname;
-    cxobj    **rvec = NULL; /* rules */
-    size_t     rlen;
-    cxobj     *xrule;
-    cxobj     *pathobj;
-    char      *access_operations;
-    char      *path0;         /* Non-canonical path */
-    char      *path=NULL;     /* Canonical path */
-    cvec      *nsc0 = NULL;   /* Non-canonical namespace context */
-    yang_stmt *yspec;
-    cxobj   **xvec = NULL;
-    int       xlen = 0;
-    int       ret;
-    prepvec  *pv;
+    int               retval = -1;
+    int               i;
+    int               k;
+    struct nacm_rule *nr;
+    yang_stmt        *yspec;
+    cxobj           **xvec = NULL;
+    int               xlen = 0;
+    int               ret;
+    prepvec          *pv;
 
+    if (access == NACM_EXEC){
+        clixon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        goto done;
+    }
     yspec = clicon_dbspec_yang(h);
-    for (i=0; i<rlistlen; i++){         /* Loop through rule list */
-        rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
-        }
-        if (j==glen) /* not found */
+    /* 6. For each rule-list entry found, process all rules, in order,
+       until a rule that matches the requested access operation is
+       found. (see 6 sub rules in nacm_rule_datanode)
+    */
+    for (i=0; i<nu->nu_len; i++){ /* Loop through rules */
+        nr = &nu->nu_rules[i];
+        /* 6c-f) For a "read", "create", "delete" or "update" access operation, the
+           rule's "access-operations" leaf has the corresponding bit set or has the
+           special value "*" */
+        if ((nr->nr_access & NACM_ACCESS_BIT(access)) == 0)
             continue;
-        /* 6. For each rule-list entry found, process all rules, in order,
-           until a rule that matches the requested access operation is
-           found. (see 6 sub rules in nacm_rule_datanode
-        */
-        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
-            goto done;
-        for (j=0; j<rlen; j++){ /* Loop through rules */
-            xrule = rvec[j];
-            /* 6c) For a "read" access operation, the rule's "access-operations"
-               leaf has the "read" bit set or has the special value "*" */
-            access_operations = xml_find_body(xrule, "access-operations");
-            switch (access){
-            case NACM_READ:
-                /* 6c) For a "read" access operation, the rule's "access-operations"
-                   leaf has the "read" bit set or has the special value "*" */
-                if (!match_access(access_operations, "read", NULL))
-                    continue;
-                break;
-            case NACM_CREATE:
-                /* 6d) For a "create" access operation, the rule's "access-operations"
-                   leaf has the "create" bit set or has the special value "*". */
-                if (!match_access(access_operations, "create", "write"))
-                    continue;
-                break;
-            case NACM_DELETE:
-                /* 6e) For a "delete" access operation, the rule's "access-operations" 
-                   leaf has the "delete" bit set or has the  special value "*". */
-                if (!match_access(access_operations, "delete", "write"))
-                    continue;
-                break;
-            case NACM_UPDATE:
-                /* 6f) For an "update" access operation, the rule's "access-operations"
-                   leaf has the "update" bit set or has the special value "*". */ 
-                if (!match_access(access_operations, "update", "write"))
-                    continue;
-                break;
-            default:
-                clixon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        /*  6b) Either (1) the rule does not have a "rule-type" defined or
+            (2) the "rule-type" is "data-node" and the "path" matches the
+            requested data node, action node, or notification node. */
+        switch (nr->nr_type){
+        case NACM_RULE_ANY:
+            /* Here a new xrule is found, add it */
+            if (prepvec_add(pv_listp, nr->nr_xrule) == NULL)
                 goto done;
-                break;
-            }
-            /*  6b) Either (1) the rule does not have a "rule-type" defined or
-                (2) the "rule-type" is "data-node" and the "path" matches the
-                requested data node, action node, or notification node. */
-            if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) == NULL){
-                if (xml_find_body(xrule, "rpc-name") || xml_find_body(xrule, "notification-name"))
-                    continue;
-                /* Here a new xrule is found, add it */
-                if (prepvec_add(pv_listp, xrule) == NULL)
+            break;
+        case NACM_RULE_DATA:
+            /* See https://github.com/clicon/clixon/issues/129:
+             * Paths are not translated to canonical namespace context because of JSON encodings
+             */
+            if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", nr->nr_path)) < 0)
+                goto done;
+            if (ret == 0)
+                continue;
+            /* Here a new xrule is found, add it */
+            if ((pv = prepvec_add(pv_listp, nr->nr_xrule)) == NULL)
+                goto done;
+            for (k=0; k<xlen; k++){
+                if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
                     goto done;
             }
-            else{
-                path0 = clixon_trim2(xml_body(pathobj), " \t\n");
-                /* Get canonical namespace context for nacm paths */
-                if ((path = strdup(path0)) == NULL){
-                    clixon_err(OE_UNIX, errno, "strdup");
-                    goto done;
-                }
-#if 0
-                /* See https://github.com/clicon/clixon/issues/129:
-                 * If this is enabled, you are back to the problem of JSON encodings
-                 */
-                /* Create namespace context for with nacm namespace as default */
-                if (xml_nsctx_node(pathobj, &nsc0) < 0)
-                    goto done;
-                /* instance-id requires canonical paths */
-                if (xpath2canonical(path0, nsc0, yspec, &path, NULL) < 0)
-                    goto done;
-#endif
-                if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", path)) < 0)
-                    goto done;
-                if (ret == 0)
-                    continue;
-                /* Here a new xrule is found, add it */
-                if ((pv = prepvec_add(pv_listp, xrule)) == NULL)
-                    goto done;
-                for (k=0; k<xlen; k++){
-                    if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
-                        goto done;
-                }
-                if (xvec){
-                    free(xvec);
-                    xvec = NULL;
-                }
-                if (nsc0){
-                    cvec_free(nsc0);
-                    nsc0 = NULL;
-                }
-                if (path){
-                    free(path);
-                    path = NULL;
-                }
+            if (xvec){
+                free(xvec);
+                xvec = NULL;
             }
-        }
-        if (rvec){
-            free(rvec);
-            rvec=NULL;
+            break;
+        default:
+            break;
         }
     }
     retval = 0;
  done:
     if (xvec)
         free(xvec);
-    if (path)
-        free(path);
-    if (nsc0)
-        cvec_free(nsc0);
     return retval;
 }
 
+/*---------------------------------------------------------------
+ * Verdicts of NACM rules
+ */
+
+/* Verdicts of NACM rules on a node */
+#define NACM_V_PERMIT 0x01 /* Permit rule matches */
+#define NACM_V_DENY   0x02 /* Deny rule matches */
+#define NACM_V_CHECK  0x04 /* Rules must be matched per XML node, see NACM_SCHEMA_VERDICT */
+#define NACM_V_NORULE 0x08 /* No rule matches, default decides */
+
+#ifdef NACM_SCHEMA_VERDICT
+/* Verdicts of YANG node: own verdict in low bits, verdicts of descendants shifted */
+#define NACM_V_SUB    4    /* Shift of descendant verdicts */
+#define NACM_V_SET    0x100 /* Distinguish cached zero verdict from not found */
+
+/*! Resolve YANG node of path of data-node rule
+ *
+ * @param[in]  nr     Compiled NACM rule of type NACM_RULE_DATA
+ * @param[in]  yspec  YANG spec
+ * @retval     1      OK, nr_ytarget is YANG node of path, NULL if root
+ * @retval     0      Path can not be resolved, rule never matches
+ * @retval    -1      Error
+ */
+static int
+nacm_rule_ytarget(struct nacm_rule *nr,
+                  yang_stmt        *yspec)
+{
+    int          retval = -1;
+    clixon_path *cplist = NULL;
+    clixon_path *cp;
+    cxobj       *xerr = NULL;
+    int          ret;
+
+    if (nr->nr_yresolved == 0){
+        if ((ret = clixon_instance_id_parse(yspec, &cplist, &xerr, "%s", nr->nr_path)) < 0)
+            goto done;
+        if (ret == 0)
+            nr->nr_yresolved = -1;
+        else {
+            nr->nr_yresolved = 1;
+            if ((cp = PREVQ(clixon_path *, cplist)) != NULL)
+                nr->nr_ytarget = cp->cp_yang;
+        }
+    }
+    retval = nr->nr_yresolved == 1;
+ done:
+    if (cplist)
+        clixon_path_free(cplist);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+/*! Own verdict of YANG node: the first rule that may match nodes of the YANG node
+ *
+ * A module rule decides the verdict, a data-node rule whose path is the YANG node or an
+ * ancestor requires matching per XML node.
+ * @param[in]  nu     Effective rules of user
+ * @param[in]  yspec  YANG spec
+ * @param[in]  y      YANG data node
+ * @param[in]  access NACM access, not NACM_EXEC
+ * @param[out] vp     Verdict: NACM_V_PERMIT, NACM_V_DENY, NACM_V_CHECK or NACM_V_NORULE
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see nacm_data_read_xrule_xml   Same rule matching per XML node for read
+ * @see nacm_data_write_xrule_xml  Same rule matching per XML node for write
+ */
+static int
+nacm_verdict_self(struct nacm_user *nu,
+                  yang_stmt        *yspec,
+                  yang_stmt        *y,
+                  enum nacm_access  access,
+                  int              *vp)
+{
+    int               retval = -1;
+    struct nacm_rule *nr;
+    yang_stmt        *ymod = NULL;
+    yang_stmt        *yp;
+    char             *module_pattern;
+    char             *action;
+    int               i;
+    int               ret;
+
+    *vp = NACM_V_NORULE;
+    /* Module of mounted YANG is not found by XML namespace in yspec */
+    if (ys_spec(y) != yspec){
+        *vp = NACM_V_CHECK;
+        goto ok;
+    }
+    if (ys_real_module(y, &ymod) < 0)
+        goto done;
+    for (i=0; i<nu->nu_len; i++){
+        nr = &nu->nu_rules[i];
+        if ((nr->nr_access & NACM_ACCESS_BIT(access)) == 0)
+            continue;
+        if (nr->nr_type != NACM_RULE_ANY && nr->nr_type != NACM_RULE_DATA)
+            continue;
+        if ((module_pattern = xml_find_body(nr->nr_xrule, "module-name")) == NULL)
+            continue;
+        if (strcmp(module_pattern, "*") != 0 &&
+            (ymod == NULL || strcmp(yang_argument_get(ymod), module_pattern) != 0))
+            continue;
+        if (nr->nr_type == NACM_RULE_ANY){
+            *vp = 0;
+            if ((action = xml_find_body(nr->nr_xrule, "action")) != NULL){
+                if (strcmp(action, "deny") == 0)
+                    *vp = NACM_V_DENY;
+                else if (strcmp(action, "permit") == 0)
+                    *vp = NACM_V_PERMIT;
+            }
+            break;
+        }
+        if ((ret = nacm_rule_ytarget(nr, yspec)) < 0)
+            goto done;
+        if (ret == 0)
+            continue;
+        if (nr->nr_ytarget == NULL){
+            *vp = NACM_V_CHECK;
+            break;
+        }
+        for (yp = y; yp != NULL && yang_keyword_get(yp) != Y_SPEC; yp = yang_parent_get(yp))
+            if (yp == nr->nr_ytarget)
+                break;
+        if (yp == nr->nr_ytarget){
+            *vp = NACM_V_CHECK;
+            break;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Verdict of YANG node and of its schema descendants, cached per user and access
+ *
+ * @param[in]  nu     Effective rules of user
+ * @param[in]  yspec  YANG spec
+ * @param[in]  y      YANG data node, or choice/case
+ * @param[in]  access NACM access, not NACM_EXEC
+ * @param[out] vp     Own verdict, and verdicts of descendants shifted by NACM_V_SUB
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_verdict(struct nacm_user *nu,
+             yang_stmt        *yspec,
+             yang_stmt        *y,
+             enum nacm_access  access,
+             int              *vp)
+{
+    int           retval = -1;
+    void         *p;
+    int           own = 0;
+    int           sub = 0;
+    int           v;
+    int           inext;
+    yang_stmt    *yc;
+    enum rfc_6020 keyw;
+    int           ret;
+
+    if (nu->nu_yverdict[access] == NULL &&
+        (nu->nu_yverdict[access] = clicon_hash_init()) == NULL)
+        goto done;
+    if ((p = clicon_hash_ptr_value(nu->nu_yverdict[access], y)) != NULL){
+        *vp = (int)(intptr_t)p & ~NACM_V_SET;
+        goto ok;
+    }
+    keyw = yang_keyword_get(y);
+    if (keyw != Y_CHOICE && keyw != Y_CASE &&
+        nacm_verdict_self(nu, yspec, y, access, &own) < 0)
+        goto done;
+    if ((ret = yang_schema_mount_point(y)) < 0)
+        goto done;
+    /* Descendants of mount-points and anydata are not in this schema */
+    if (ret == 1 || keyw == Y_ANYDATA || keyw == Y_ANYXML)
+        sub = NACM_V_CHECK;
+    else {
+        inext = 0;
+        while ((yc = yn_iter(y, &inext)) != NULL) {
+            keyw = yang_keyword_get(yc);
+            if (!yang_datanode(yc) && keyw != Y_CHOICE && keyw != Y_CASE)
+                continue;
+            if (nacm_verdict(nu, yspec, yc, access, &v) < 0)
+                goto done;
+            sub |= (v | (v >> NACM_V_SUB)) & (NACM_V_PERMIT|NACM_V_DENY|NACM_V_CHECK|NACM_V_NORULE);
+        }
+    }
+    *vp = own | (sub << NACM_V_SUB);
+    if (clicon_hash_add_ptr(nu->nu_yverdict[access], y, (void*)(intptr_t)(*vp | NACM_V_SET)) == NULL)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+#endif /* NACM_SCHEMA_VERDICT */
+
 /*---------------------------------------------------------------
  * Datanode write
  */
@@ -689,6 +1300,7 @@ nacm_data_write_xrule_xml(cxobj       *xn,
     goto done;
 }
 
+#ifndef NACM_WRITE_SCHEMA
 /*! Recursive check for NACM write rules among all XML nodes
  *
  * @param[in]  h         Clixon handle
@@ -765,6 +1377,114 @@ nacm_datanode_write_recurse(clixon_handle h,
     retval = 0; /* deny */
     goto done;
 }
+#endif /* NACM_WRITE_SCHEMA */
+
+#ifdef NACM_WRITE_SCHEMA
+/*! Recursive check for NACM write rules using verdicts of YANG nodes
+ *
+ * Nodes with a decided verdict are checked without matching the rules, and the subtree of
+ * a node is not visited if all its schema descendants are permitted. Rules are prepared,
+ * ie instances of rule paths are looked up in the request tree, only if some node needs
+ * matching per XML node.
+ * @param[in]     h         Clixon handle
+ * @param[in]     xn        XML node (requested node)
+ * @param[in]     xt        XML request root tree
+ * @param[in]     access    NACM access of request
+ * @param[in]     nu        Effective rules of user
+ * @param[in,out] pv_listp  Precomputed rules + paths that apply to user group
+ * @param[in,out] prepared  Rules are prepared in pv_listp
+ * @param[in]     defpermit 0 if default deny, 1 is default permit
+ * @param[in]     yspec     YANG spec
+ * @param[out]    cbret     Error message if retval = 0
+ * @param[out]    xpathp    If deny, pointer to failing XPath
+ * @retval        1         OK and accept
+ * @retval        0         Deny and cbret set
+ * @retval       -1         Error
+ * @see nacm_datanode_write_recurse
+ */
+static int
+nacm_datanode_write_schema(clixon_handle     h,
+                           cxobj            *xn,
+                           cxobj            *xt,
+                           enum nacm_access  access,
+                           struct nacm_user *nu,
+                           prepvec         **pv_listp,
+                           int              *prepared,
+                           int               defpermit,
+                           yang_stmt        *yspec,
+                           cbuf             *cbret,
+                           char            **xpathp)
+{
+    int        retval = -1;
+    cxobj     *x;
+    yang_stmt *y;
+    prepvec   *pv;
+    int        v = NACM_V_CHECK | (NACM_V_CHECK << NACM_V_SUB);
+    int        sub;
+    int        ret = 0;
+
+    if ((y = xml_spec(xn)) != NULL &&
+        nacm_verdict(nu, yspec, y, access, &v) < 0)
+        goto done;
+    if (v & NACM_V_CHECK){
+        if (*prepared == 0){
+            if (nacm_datanode_prepare(h, xt, access, nu, pv_listp) < 0)
+                goto done;
+            *prepared = 1;
+        }
+        v &= ~NACM_V_CHECK;
+        v |= NACM_V_NORULE;
+        if ((pv = *pv_listp) != NULL){
+            do {
+                if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_xrule, pv->pv_xpathvec, yspec, xpathp)) < 0)
+                    goto done;
+                if (ret == 1){ /* Match and deny */
+                    if (netconf_access_denied(cbret, "application", "access denied") < 0)
+                        goto done;
+                    goto deny;
+                }
+                if (ret == 2){ /* Match and permit */
+                    v &= ~NACM_V_NORULE;
+                    break;
+                }
+                pv = NEXTQ(prepvec *, pv);
+            } while (pv && pv != *pv_listp);
+        }
+    }
+    else if (v & NACM_V_DENY){
+        *xpathp = NULL;
+        if (netconf_access_denied(cbret, "application", "access denied") < 0)
+            goto done;
+        goto deny;
+    }
+    /* If no rule match, check default rule */
+    if ((v & NACM_V_NORULE) && !defpermit){
+        if (netconf_access_denied(cbret, "application", "default deny") < 0)
+            goto done;
+        goto deny;
+    }
+    /* All schema descendants permitted */
+    sub = v >> NACM_V_SUB;
+    if ((sub & (NACM_V_DENY|NACM_V_CHECK)) == 0 &&
+        (defpermit || (sub & NACM_V_NORULE) == 0))
+        goto ok;
+    x = NULL;   /* Recursively check XML */
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+        if ((ret = nacm_datanode_write_schema(h, x, xt, access, nu, pv_listp, prepared,
+                                              defpermit, yspec, cbret, xpathp)) < 0)
+            goto done;
+        if (ret == 0)
+            goto deny;
+    }
+ ok:
+    retval = 1; /* accept */
+ done:
+    return retval;
+ deny:
+    retval = 0; /* deny */
+    goto done;
+}
+#endif /* NACM_WRITE_SCHEMA */
 
 /*! Make nacm datanode and module rule write access validation
  *
@@ -794,21 +1514,17 @@ nacm_datanode_write(clixon_handle    h,
                     cxobj           *xnacm,
                     cbuf            *cbret)
 {
-    int      retval = -1;
-    cxobj  **gvec = NULL; /* groups */
-    size_t   glen;
-    cxobj  **rlistvec = NULL; /* rule-list */
-    size_t   rlistlen;
-    cxobj  **rvec = NULL; /* rules */
-    char    *write_default = NULL;
-    cvec    *nsc = NULL;
-    int      ret;
-    prepvec *pv_list = NULL;
-    char    *xpath = NULL;
+    int               retval = -1;
+    struct nacm_user *nu = NULL;
+    int               nufree = 0;
+    char             *write_default = NULL;
+    int               ret;
+    prepvec          *pv_list = NULL;
+    char             *xpath = NULL;
+#ifdef NACM_WRITE_SCHEMA
+    int               prepared = 0;
+#endif
 
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
     if (xnacm == NULL)
         goto permit;
     /* write-default (create, update, or delete) has default deny so should never be NULL */
@@ -823,21 +1539,30 @@ nacm_datanode_write(clixon_handle    h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    /* User's groups and rule-lists, see nacm_user_compile */
+    if (nacm_user_get(h, xnacm, username, &nu, &nufree) < 0)
         goto done;
     /* 4. If no groups are found, continue with step 9. */
-    if (glen == 0)
+    if (nu->nu_groups == 0)
         goto step9;
+    /* Rules or write-default permit all nodes: skip instance lookups and traversal */
+    if (nacm_user_permit_all(nu, access, "write-default", xnacm) == 1)
+        goto permit;
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
-    /* First run through rules and cache rules as well as lookup objects in xt. 
+        entry.
+       First run through rules and cache rules as well as lookup objects in xt. 
      */
-    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+#ifdef NACM_WRITE_SCHEMA
+    /* Rules are prepared only if needed while traversing */
+    if ((ret = nacm_datanode_write_schema(h, xreq, xt, access, nu, &pv_list, &prepared,
+                                          strcmp(write_default, "deny"),
+                                          clicon_dbspec_yang(h),
+                                          cbret, &xpath)) < 0)
+        goto done;
+#else
+    if (nacm_datanode_prepare(h, xt, access, nu, &pv_list) < 0)
         goto done;
     /* Then recursively traverse all requested nodes */
     if ((ret = nacm_datanode_write_recurse(h, xreq, pv_list,
@@ -845,6 +1570,7 @@ nacm_datanode_write(clixon_handle    h,
                                            clicon_dbspec_yang(h),
                                            cbret, &xpath)) < 0)
         goto done;
+#endif
     if (ret == 0) /* deny */
         goto deny;
     goto permit;
@@ -874,16 +1600,10 @@ nacm_datanode_write(clixon_handle    h,
     if (retval != 0)
         clixon_debug_xml(CLIXON_DBG_NACM | CLIXON_DBG_DETAIL, xreq, "Write %s: %s",
                          username, retval==1?"permit":retval==0?"deny":"error");
-    if (pv_list)
-        prepvec_free(pv_list);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
-    if (rvec)
-        free(rvec);
+    if (pv_list)
+        prepvec_free(pv_list);
+    if (nu && nufree)
+        nacm_user_free(nu);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     if (xpath)
@@ -899,31 +1619,35 @@ nacm_datanode_write(clixon_handle    h,
  * Datanode read
  */
 
-/*! Perform NACM action: mark if permit, del if deny
+/*! Get NACM read verdict of rule action
  *
  * @param[in]  xrule  NACM rule
  * @param[in]  xn     XML node (requested node)
+ * @param[in]  xpath  Path of rule, or NULL
+ * @param[out] vp     NACM_V_PERMIT, NACM_V_DENY or 0
  * @retval     0      OK
  * @retval    -1      Error
  */
 static int
 nacm_data_read_action(cxobj *xrule,
                       cxobj *xn,
-                      char  *xpath)
+                      char  *xpath,
+                      int   *vp)
 {
     int   retval = -1;
     char *action;
 
+    *vp = 0;
     if ((action = xml_find_body(xrule, "action")) != NULL){
         if (strcmp(action, "deny")==0){
             if (xpath)
                 clixon_debug_xml(CLIXON_DBG_NACM, xn, "NACM data node read deny path:%s", xpath);
             else
                 clixon_debug(CLIXON_DBG_NACM, "NACM data node read deny");
-            xml_flag_set(xn, XML_FLAG_DENY);
+            *vp = NACM_V_DENY;
         }
         else if (strcmp(action, "permit")==0)
-            xml_flag_set(xn, XML_FLAG_ADD);
+            *vp = NACM_V_PERMIT;
     }
     retval = 0;
     //done:
@@ -936,6 +1660,7 @@ nacm_data_read_action(cxobj *xrule,
  * @param[in]  xrule    NACM rule
  * @param[in]  xpathvec
  * @param[in]  yspec    YANG spec
+ * @param[out] vp       Verdict if match: NACM_V_PERMIT, NACM_V_DENY or 0
  * @retval     1        OK and rule matches
  * @retval     0        OK and rule does not match
  * @retval    -1        Error
@@ -949,7 +1674,8 @@ static int
 nacm_data_read_xrule_xml(cxobj       *xn,
                          cxobj       *xrule,
                          clixon_xvec *xpathvec,
-                         yang_stmt   *yspec)
+                         yang_stmt   *yspec,
+                         int         *vp)
 {
     int        retval = -1;
     yang_stmt *ymod;
@@ -973,7 +1699,7 @@ nacm_data_read_xrule_xml(cxobj       *xn,
         (2) the "rule-type" is "data-node" and the "path" matches the
         requested data node, action node, or notification node. */
     if ((xpath = xml_find_type(xrule, NULL, "path", CX_ELMNT)) == NULL){
-        if (nacm_data_read_action(xrule, xn, NULL) < 0)
+        if (nacm_data_read_action(xrule, xn, NULL, vp) < 0)
             goto done;
         goto match;
     }
@@ -981,7 +1707,7 @@ nacm_data_read_xrule_xml(cxobj       *xn,
         xp = clixon_xvec_i(xpathvec, i);
         /* Check if ancestor is xp (for every xpathvec?) */
         if (xn == xp || xml_isancestor(xn, xp)){
-            if (nacm_data_read_action(xrule, xn, xml_body(xpath)) < 0)
+            if (nacm_data_read_action(xrule, xn, xml_body(xpath), vp) < 0)
                 goto done;
             goto match;
         }
@@ -995,6 +1721,125 @@ nacm_data_read_xrule_xml(cxobj       *xn,
     goto done;
 }
 
+/*! Match read rules to a requested node until first match
+ *
+ * @param[in]  xn       XML node (requested node)
+ * @param[in]  pv_list  Precomputed rules + paths that apply to this user group
+ * @param[in]  yspec    YANG spec
+ * @param[out] vp       Verdict of first matching rule: NACM_V_PERMIT, NACM_V_DENY or 0
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+nacm_datanode_read_rules(cxobj     *xn,
+                         prepvec   *pv_list,
+                         yang_stmt *yspec,
+                         int       *vp)
+{
+    int      retval = -1;
+    int      ret;
+    prepvec *pv;
+
+    *vp = 0;
+    pv = pv_list;
+    if (pv){
+        do {
+            if ((ret = nacm_data_read_xrule_xml(xn,
+                                                pv->pv_xrule,
+                                                pv->pv_xpathvec,
+                                                yspec, vp)) < 0)
+                goto done;
+            if (ret == 1)
+                break; /* stop at first match */
+            pv = NEXTQ(prepvec *, pv);
+        } while (pv && pv != pv_list);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Mark requested node with ADD if permitted or DENY if denied
+ *
+ * @param[in]  xn  XML node (requested node)
+ * @param[in]  v   Verdict: NACM_V_PERMIT, NACM_V_DENY or 0
+ */
+static void
+nacm_datanode_read_mark(cxobj *xn,
+                        int    v)
+{
+    if (v & NACM_V_DENY)
+        xml_flag_set(xn, XML_FLAG_DENY);
+    else if (v & NACM_V_PERMIT)
+        xml_flag_set(xn, XML_FLAG_ADD);
+}
+
+#ifdef NACM_READ_SCHEMA
+/*! Recursive check and mark for NACM read rules using read verdicts of YANG nodes
+ *
+ * Nodes with a decided verdict are marked without matching rules. The subtree of a
+ * node is not visited if no descendant may change the outcome: if the node is kept,
+ * only a descendant deny matters, otherwise only a descendant permit.
+ * @param[in]  xn        XML node (requested node)
+ * @param[in]  pv_list   Precomputed rules + paths that apply to this user group
+ * @param[in]  yspec     YANG spec
+ * @param[in]  nu        Effective rules of user
+ * @param[in]  permitted Node is kept unless denied: read-default permit or ancestor permitted
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see nacm_datanode_read_recurse
+ */
+static int
+nacm_datanode_read_schema(cxobj            *xn,
+                          prepvec          *pv_list,
+                          yang_stmt        *yspec,
+                          struct nacm_user *nu,
+                          int               permitted)
+{
+    int        retval = -1;
+    cxobj     *x;
+    yang_stmt *y;
+    int        v = NACM_V_CHECK << NACM_V_SUB;
+    int        vn;
+    int        sub;
+
+    if ((y = xml_spec(xn)) != NULL){ /* Check this node */
+        if (nacm_verdict(nu, yspec, y, NACM_READ, &v) < 0)
+            goto done;
+        if (v & NACM_V_CHECK){
+            if (nacm_datanode_read_rules(xn, pv_list, yspec, &vn) < 0)
+                goto done;
+            nacm_datanode_read_mark(xn, vn);
+        }
+        else {
+            if (v & NACM_V_DENY)
+                clixon_debug(CLIXON_DBG_NACM, "NACM data node read deny");
+            nacm_datanode_read_mark(xn, v);
+        }
+    }
+    /* If node should be purged, dont recurse and defer removal to caller */
+    if (xml_flag(xn, XML_FLAG_DENY) != 0)
+        goto ok;
+    if (xml_flag(xn, XML_FLAG_ADD) != 0)
+        permitted = 1;
+    sub = v >> NACM_V_SUB;
+    if (permitted && (sub & (NACM_V_DENY|NACM_V_CHECK)) == 0)
+        goto ok;
+    if (!permitted && (sub & (NACM_V_PERMIT|NACM_V_CHECK)) == 0)
+        goto ok;
+    x = NULL;       /* Recursively check XML */
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+        if (nacm_datanode_read_schema(x, pv_list, yspec, nu, permitted) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+#endif /* NACM_READ_SCHEMA */
+
+#ifndef NACM_READ_SCHEMA
 /*! Recursive check and mark with DEL flag for NACM read rules among all XML nodes
  *
  * @param[in]  h        Clixon handle
@@ -1012,24 +1857,12 @@ nacm_datanode_read_recurse(clixon_handle h,
 {
     int      retval = -1;
     cxobj   *x;
-    int      ret;
-    prepvec *pv;
+    int      v;
 
     if (xml_spec(xn)){ /* Check this node */
-        pv = pv_list;
-        if (pv){
-            do {
-                /* Marks xn with ADD/DENY */
-                if ((ret = nacm_data_read_xrule_xml(xn,
-                                                    pv->pv_xrule,
-                                                    pv->pv_xpathvec,
-                                                    yspec)) < 0)
-                    goto done;
-                if (ret == 1)
-                    break; /* stop at first match */
-                pv = NEXTQ(prepvec *, pv);
-            } while (pv && pv != pv_list);
-        }
+        if (nacm_datanode_read_rules(xn, pv_list, yspec, &v) < 0)
+            goto done;
+        nacm_datanode_read_mark(xn, v);
     }
     /* If node should be purged, dont recurse and defer removal to caller */
     if (xml_flag(xn, XML_FLAG_DENY) == 0){
@@ -1043,6 +1876,47 @@ nacm_datanode_read_recurse(clixon_handle h,
  done:
     return retval;
 }
+#endif /* NACM_READ_SCHEMA */
+
+/*! Check if NACM permits a user to read all data nodes
+ *
+ * Cheap check before nacm_datanode_read1: if all data nodes are permitted, the tree walk
+ * and pruning can be skipped.
+ * @param[in]  h        Clixon handle
+ * @param[in]  username User name of requestor
+ * @param[in]  xnacm    NACM xml tree, or NULL if no NACM checks are needed
+ * @retval     1        All data nodes readable, no need to call nacm_datanode_read1
+ * @retval     0        Call nacm_datanode_read1 and nacm_datanode_read_prune
+ * @retval    -1        Error
+ */
+int
+nacm_datanode_read_permitted(clixon_handle h,
+                             char         *username,
+                             cxobj        *xnacm)
+{
+    int               retval = -1;
+    struct nacm_user *nu = NULL;
+    int               nufree = 0;
+
+    if (xnacm == NULL)
+        goto permit;
+    if (username == NULL)
+        goto deny;
+    if (nacm_user_get(h, xnacm, username, &nu, &nufree) < 0)
+        goto done;
+    if (nacm_user_permit_all(nu, NACM_READ, "read-default", xnacm) == 1)
+        goto permit;
+ deny:
+    retval = 0;
+ done:
+    if (nu && nufree)
+        nacm_user_free(nu);
+    return retval;
+ permit:
+    clixon_debug(CLIXON_DBG_NACM | CLIXON_DBG_DETAIL, "%s permitted", username?username:"");
+    retval = 1;
+    goto done;
+}
 
 /*! Make nacm datanode and module rule read access validation
  *
@@ -1098,19 +1972,13 @@ nacm_datanode_read1(clixon_handle h,
                     char         *username,
                     cxobj        *xnacm)
 {
-    int      retval = -1;
-    cxobj  **gvec = NULL; /* groups */
-    size_t   glen;
-    cxobj  **rlistvec = NULL; /* rule-list */
-    size_t   rlistlen;
-    char    *read_default = NULL;
-    cvec    *nsc = NULL;
-    prepvec *pv_list = NULL;
+    int               retval = -1;
+    struct nacm_user *nu = NULL;
+    int               nufree = 0;
+    char             *read_default = NULL;
+    prepvec          *pv_list = NULL;
 
     xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_DENY|XML_FLAG_ADD));
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
     /* 3.   Check all the "group" entries to see if any of them contain a
        "user-name" entry that equals the username for the session
        making the request.  (If the "enable-external-groups" leaf is
@@ -1118,17 +1986,15 @@ nacm_datanode_read1(clixon_handle h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    /* User's groups and rule-lists, see nacm_user_compile */
+    if (nacm_user_get(h, xnacm, username, &nu, &nufree) < 0)
         goto done;
-    /* 4. If no groups are found (glen=0), continue and check read-default 
+    /* 4. If no groups are found (no rules), continue and check read-default 
           in step 11. */
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
         entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
     /* read-default has default permit so should never be NULL */
     if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
         clixon_err(OE_XML, EINVAL, "No nacm read-default rule");
@@ -1137,11 +2003,17 @@ nacm_datanode_read1(clixon_handle h,
     /* First run through rules and cache rules as well as lookup objects in xt. 
      * DANGER: objects could be stale if they are removed?
      */
-    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, NACM_READ, nu, &pv_list) < 0)
         goto done;
     /* Then recursively traverse all nodes */
+#ifdef NACM_READ_SCHEMA
+    if (nacm_datanode_read_schema(xt, pv_list, clicon_dbspec_yang(h), nu,
+                                  strcmp(read_default, "deny") != 0) < 0)
+        goto done;
+#else
     if (nacm_datanode_read_recurse(h, xt, pv_list, clicon_dbspec_yang(h)) < 0)
         goto done;
+#endif
     /* Step 8(B) above:
      * If default rule is deny, recursively remove all subtrees that are not marked
      */
@@ -1177,12 +2049,8 @@ nacm_datanode_read1(clixon_handle h,
         xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_ADD);
     if (pv_list)
         prepvec_free(pv_list);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
+    if (nu && nufree)
+        nacm_user_free(nu);
     return retval;
 }
 
@@ -1206,6 +2074,332 @@ nacm_datanode_read_prune(clixon_handle h,
     return retval;
 }
 
+/* Read filter state of an XML node, stored in nf_memo */
+#define NACM_F_PERMITTED   0x01  /* Node is permitted, descendants are kept unless denied */
+#define NACM_F_INNER2      0x02  /* Inner filter returned 2, not called for descendants */
+#define NACM_F_HASPERMIT   0x04  /* A descendant is permitted */
+#define NACM_F_HASCHECKED  0x08  /* NACM_F_HASPERMIT is computed */
+#define NACM_F_SET         0x100 /* Distinguish zero state from not found */
+
+/*! NACM read filter, visibility of data nodes for a user without marking the tree
+ *
+ * @see nacm_read_filter_new
+ */
+struct nacm_read_filter {
+    prepvec          *nf_pv_list;  /* Precomputed rules + paths that apply to user */
+    yang_stmt        *nf_yspec;    /* YANG spec */
+    struct nacm_user *nf_nu;       /* Effective rules of user */
+    int               nf_nufree;   /* nf_nu is not cached, free it */
+    int               nf_defpermit;/* read-default is permit */
+    int               nf_denyall;  /* No user, nothing is readable */
+    int             (*nf_fn)(cxobj *, void *); /* Inner filter function, or NULL */
+    void             *nf_fnarg;    /* Argument to inner filter function */
+    clicon_hash_t    *nf_memo;     /* XML node -> NACM_F_* state */
+};
+
+/*! Get read filter state of XML node
+ *
+ * @param[in]  nf  NACM read filter
+ * @param[in]  x   XML node
+ * @retval     state NACM_F_* bits, 0 if not visited
+ */
+static int
+nacm_read_filter_state(struct nacm_read_filter *nf,
+                       cxobj                   *x)
+{
+    void *p;
+
+    if (nf->nf_memo == NULL ||
+        (p = clicon_hash_ptr_value(nf->nf_memo, x)) == NULL)
+        return 0;
+    return (int)(intptr_t)p;
+}
+
+/*! Set read filter state of XML node
+ *
+ * @param[in]  nf     NACM read filter
+ * @param[in]  x      XML node
+ * @param[in]  state  NACM_F_* bits
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_read_filter_state_set(struct nacm_read_filter *nf,
+                           cxobj                   *x,
+                           int                      state)
+{
+    if (nf->nf_memo == NULL &&
+        (nf->nf_memo = clicon_hash_init()) == NULL)
+        return -1;
+    if (clicon_hash_add_ptr(nf->nf_memo, x, (void*)(intptr_t)(state | NACM_F_SET)) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Read verdict of XML node for read filter
+ *
+ * @param[in]  nf    NACM read filter
+ * @param[in]  x     XML node
+ * @param[out] vp    Verdict of node: NACM_V_PERMIT, NACM_V_DENY or 0
+ * @param[out] subp  Verdicts that descendants may have
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see nacm_datanode_read_schema  Same verdicts when marking the tree
+ */
+static int
+nacm_read_filter_verdict(struct nacm_read_filter *nf,
+                         cxobj                   *x,
+                         int                     *vp,
+                         int                     *subp)
+{
+    int        retval = -1;
+    yang_stmt *y;
+#ifdef NACM_READ_SCHEMA
+    int        v;
+#endif
+
+    *vp = 0;
+    *subp = NACM_V_PERMIT|NACM_V_DENY|NACM_V_CHECK;
+    if ((y = xml_spec(x)) == NULL)
+        goto ok;
+#ifdef NACM_READ_SCHEMA
+    if (nacm_verdict(nf->nf_nu, nf->nf_yspec, y, NACM_READ, &v) < 0)
+        goto done;
+    *subp = v >> NACM_V_SUB;
+    if ((v & NACM_V_CHECK) == 0){
+        *vp = v & (NACM_V_PERMIT|NACM_V_DENY);
+        goto ok;
+    }
+#endif
+    if (nacm_datanode_read_rules(x, nf->nf_pv_list, nf->nf_yspec, vp) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if a node that is not permitted has a permitted descendant, memoized
+ *
+ * Only descendants that the inner filter keeps are considered.
+ * @param[in]  nf      NACM read filter
+ * @param[in]  x       XML node, neither permitted nor denied
+ * @param[in]  inner2  Inner filter is not called for descendants
+ * @param[out] hasp    1 if a descendant is permitted
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+nacm_read_filter_haspermit(struct nacm_read_filter *nf,
+                           cxobj                   *x,
+                           int                      inner2,
+                           int                     *hasp)
+{
+    int    retval = -1;
+    int    state;
+    cxobj *xc;
+    int    inner2c;
+    int    v;
+    int    sub;
+    int    ret;
+
+    state = nacm_read_filter_state(nf, x);
+    if (state & NACM_F_HASCHECKED){
+        *hasp = (state & NACM_F_HASPERMIT) != 0;
+        goto ok;
+    }
+    *hasp = 0;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+        inner2c = inner2;
+        if (!inner2 && nf->nf_fn){
+            if ((ret = nf->nf_fn(xc, nf->nf_fnarg)) < 0)
+                goto done;
+            if (ret == 0)
+                continue;
+            inner2c = (ret == 2);
+        }
+        if (nacm_read_filter_verdict(nf, xc, &v, &sub) < 0)
+            goto done;
+        if (v & NACM_V_DENY)
+            continue;
+        if (v & NACM_V_PERMIT){
+            *hasp = 1;
+            break;
+        }
+        if ((sub & (NACM_V_PERMIT|NACM_V_CHECK)) == 0)
+            continue;
+        if (nacm_read_filter_haspermit(nf, xc, inner2c, hasp) < 0)
+            goto done;
+        if (*hasp)
+            break;
+    }
+    state |= NACM_F_HASCHECKED | (*hasp ? NACM_F_HASPERMIT : 0);
+    if (nacm_read_filter_state_set(nf, x, state) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Create NACM read filter for serializing a tree without marking and pruning it
+ *
+ * The filter decides visibility of each node while the tree is printed, as
+ * nacm_datanode_read1 followed by nacm_datanode_read_prune would on a copy. The tree is
+ * not modified and may thus be a shared datastore cache.
+ * @param[in]  h        Clixon handle
+ * @param[in]  xt       XML root tree to be printed
+ * @param[in]  username User name of requestor, or NULL
+ * @param[in]  xnacm    NACM xml tree
+ * @param[in]  fn       Inner filter function applied before NACM, or NULL
+ * @param[in]  fnarg    Argument to inner filter function
+ * @param[out] nfp      NACM read filter, free with nacm_read_filter_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @code
+ *   if (nacm_read_filter_new(h, xt, username, xnacm, NULL, NULL, &nf) < 0)
+ *      err;
+ *   if (clixon_xml2cbuf_filter(cb, xt, 0, 0, NULL, -1, 1, wdef, nacm_read_filter, nf) < 0)
+ *      err;
+ *   nacm_read_filter_free(nf);
+ * @endcode
+ * @note  The tree may not be modified while the filter is used
+ * @see nacm_datanode_read1
+ */
+int
+nacm_read_filter_new(clixon_handle             h,
+                     cxobj                    *xt,
+                     char                     *username,
+                     cxobj                    *xnacm,
+                     int                     (*fn)(cxobj *, void *),
+                     void                     *fnarg,
+                     struct nacm_read_filter **nfp)
+{
+    int                      retval = -1;
+    struct nacm_read_filter *nf = NULL;
+    char                    *read_default;
+
+    if ((nf = malloc(sizeof(*nf))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(nf, 0, sizeof(*nf));
+    nf->nf_fn = fn;
+    nf->nf_fnarg = fnarg;
+    nf->nf_yspec = clicon_dbspec_yang(h);
+    if (username == NULL){
+        nf->nf_denyall = 1;
+        goto ok;
+    }
+    if (nacm_user_get(h, xnacm, username, &nf->nf_nu, &nf->nf_nufree) < 0)
+        goto done;
+    if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
+        clixon_err(OE_XML, EINVAL, "No nacm read-default rule");
+        goto done;
+    }
+    nf->nf_defpermit = strcmp(read_default, "deny") != 0;
+    if (nacm_datanode_prepare(h, xt, NACM_READ, nf->nf_nu, &nf->nf_pv_list) < 0)
+        goto done;
+ ok:
+    *nfp = nf;
+    nf = NULL;
+    retval = 0;
+ done:
+    if (nf)
+        nacm_read_filter_free(nf);
+    return retval;
+}
+
+/*! Free NACM read filter
+ *
+ * @param[in]  nf  NACM read filter
+ * @retval     0   OK
+ */
+int
+nacm_read_filter_free(struct nacm_read_filter *nf)
+{
+    if (nf == NULL)
+        return 0;
+    if (nf->nf_pv_list)
+        prepvec_free(nf->nf_pv_list);
+    if (nf->nf_nu && nf->nf_nufree)
+        nacm_user_free(nf->nf_nu);
+    if (nf->nf_memo)
+        clicon_hash_free(nf->nf_memo);
+    free(nf);
+    return 0;
+}
+
+/*! XML output filter function of NACM read access
+ *
+ * Nodes are visible as after nacm_datanode_read1 and nacm_datanode_read_prune:
+ * denied nodes and their descendants are skipped. If read-default is deny, only
+ * permitted nodes, their ancestors and the keys of ancestor list entries are printed.
+ * A sub-tree is printed without further calls if no descendant can be denied.
+ * @param[in]  x     XML node
+ * @param[in]  arg   NACM read filter, see nacm_read_filter_new
+ * @retval     2     Print node and its whole sub-tree
+ * @retval     1     Print node and call filter for its children
+ * @retval     0     Skip node
+ * @retval    -1     Error
+ * @see xml_output_filter_t
+ */
+int
+nacm_read_filter(cxobj *x,
+                 void  *arg)
+{
+    struct nacm_read_filter *nf = (struct nacm_read_filter *)arg;
+    cxobj                   *xp;
+    yang_stmt               *yp;
+    int                      pstate = 0;
+    int                      inner = 2;
+    int                      permitted;
+    int                      has;
+    int                      v;
+    int                      sub;
+    int                      r;
+    int                      ret;
+
+    if (nf->nf_denyall)
+        return 0;
+    if ((xp = xml_parent(x)) != NULL)
+        pstate = nacm_read_filter_state(nf, xp);
+    if (nf->nf_fn && (pstate & NACM_F_INNER2) == 0){
+        if ((inner = nf->nf_fn(x, nf->nf_fnarg)) <= 0)
+            return inner;
+    }
+    if (nacm_read_filter_verdict(nf, x, &v, &sub) < 0)
+        return -1;
+    if (v & NACM_V_DENY)
+        return 0;
+    permitted = nf->nf_defpermit || (v & NACM_V_PERMIT) || (pstate & NACM_F_PERMITTED);
+    if (permitted)
+        r = (sub & (NACM_V_DENY|NACM_V_CHECK)) ? 1 : 2;
+    else {
+        /* Keys of list entries with permitted descendants are kept */
+        if (xp && (yp = xml_spec(xp)) != NULL && yang_keyword_get(yp) == Y_LIST){
+            if ((ret = yang_key_match(yp, xml_name(x), NULL)) < 0)
+                return -1;
+            if (ret == 1)
+                return inner;
+        }
+        if (nacm_read_filter_haspermit(nf, x, inner == 2, &has) < 0)
+            return -1;
+        if (has == 0)
+            return 0;
+        r = 1;
+    }
+    if (r == 2 && inner != 2)
+        r = 1;
+    if (r == 1 &&
+        nacm_read_filter_state_set(nf, x, nacm_read_filter_state(nf, x) |
+                                   (permitted ? NACM_F_PERMITTED : 0) |
+                                   (inner == 2 ? NACM_F_INNER2 : 0)) < 0)
+        return -1;
+    return r;
+}
+
 /*---------------------------------------------------------------
  * NACM pre-procesing
  */
@@ -1331,15 +2525,22 @@ nacm_access_pre(clixon_handle h,
                 cxobj       **xnacmp,
                 cbuf         *cbret)
 {
-    int    retval = -1;
-    char  *mode;
-    cxobj *x;
-    cxobj *xnacm0 = NULL;
-    cxobj *xnacm = NULL;
-    cvec  *nsc = NULL;
-    cxobj *xerr = NULL;
-    int    ret;
+    int                   retval = -1;
+    char                 *mode;
+    cxobj                *x = NULL;
+    cxobj                *xnacm0 = NULL;
+    cxobj                *xnacm = NULL;
+    cvec                 *nsc = NULL;
+    cxobj                *xerr = NULL;
+    int                   ret;
+    uint64_t              gen = 0;
+    struct nacm_compiled *nc = NULL;
 
+    /* Tree of previous request is freed */
+    if (clicon_ptr_get(h, "nacm-compiled", (void**)&nc) == 0 && nc != NULL){
+        nc->nc_req = NULL;
+        nc = NULL;
+    }
     /* Check clixon option: disabled, external tree or internal */
     mode = clicon_option_str(h, "CLICON_NACM_MODE");
     if (mode == NULL)
@@ -1347,17 +2548,33 @@ nacm_access_pre(clixon_handle h,
     else if (strcmp(mode, "disabled")==0)
         goto permit;
     else if (strcmp(mode, "external")==0){
-        if ((x = clicon_nacm_ext(h)))
-            if ((xnacm0 = xml_dup(x)) == NULL)
+        /* The tree may be reallocated at the same address, key on its generation */
+        gen = nacm_generation(h);
+        if ((x = clicon_nacm_ext(h)) != NULL){
+            if ((nc = nacm_compiled_get(h, gen)) != NULL){
+                if ((xnacm = xml_dup(nc->nc_xnacm)) == NULL)
+                    goto done;
+            }
+            else if ((xnacm0 = xml_dup(x)) == NULL)
                 goto done;
+        }
     }
     else if (strcmp(mode, "internal")==0){
-        if ((ret = xmldb_get0(h, "running", YB_MODULE, nsc, "nacm", 1, 0, &xnacm0, NULL, &xerr)) < 0)
-            goto done;
-        if (ret == 0){
-            if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+        /* Unchanged running: reuse NACM tree of compiled rules */
+        gen = nacm_generation(h);
+        if ((nc = nacm_compiled_get(h, gen)) != NULL){
+            if ((xnacm = xml_dup(nc->nc_xnacm)) == NULL)
                 goto done;
-            goto fail;
+        }
+        else {
+            if ((ret = xmldb_get0(h, "running", YB_MODULE, nsc, "nacm", 1, 0, &xnacm0, NULL, &xerr)) < 0)
+                goto done;
+            if (ret == 0){
+                if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+                    goto done;
+                goto fail;
+            }
+            gen = nacm_generation(h);
         }
     }
     else{
@@ -1366,18 +2583,26 @@ nacm_access_pre(clixon_handle h,
     }
     if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
         goto done;
-    /* If config does not exist then the operation is permitted(?) */
-    if (xnacm0 == NULL)
-        goto permit;
-    /* If config does not exist then the operation is permitted(?) */
-    if ((xnacm = xpath_first(xnacm0, nsc, "nacm")) == NULL)
-        goto permit;
-    if (xml_rootchild_node(xnacm0, xnacm) < 0)
-        goto done;
-    xnacm0 = NULL;
+    if (nc == NULL){
+        /* If config does not exist then the operation is permitted(?) */
+        if (xnacm0 == NULL)
+            goto permit;
+        /* If config does not exist then the operation is permitted(?) */
+        if ((xnacm = xpath_first(xnacm0, nsc, "nacm")) == NULL)
+            goto permit;
+        if (xml_rootchild_node(xnacm0, xnacm) < 0)
+            goto done;
+        xnacm0 = NULL;
+        /* New NACM configuration: user rules are compiled on demand */
+        if (gen != 0 &&
+            (nc = nacm_compiled_new(h, gen, xnacm)) == NULL)
+            goto done;
+    }
     /* Initial NACM steps and common to all NACM access validation. */
     if ((retval = nacm_access_check(h, xnacm, peername, username)) < 0)
         goto done;
+    if (nc)
+        nc->nc_req = retval==0 ? xnacm : NULL;
     if (retval == 0){ /* if retval == 0 then return an xml nacm tree */
         *xnacmp = xnacm;
         xnacm = NULL;
@@ -1486,11 +2711,13 @@ verify_nacm_user(clixon_handle           h,
 
 /*! Load external NACM file
  *
+ * Replaces the external NACM tree, may be called again to reload a changed file
  * @param[in]  h  Clixon handle
  * @retval     0  OK
  * @retval    -1  Error
+ * @see clicon_nacm_ext_set
  */
-static int
+int
 nacm_load_external(clixon_handle h)
 {
     int         retval = -1;
@@ -1578,11 +2805,17 @@ nacm_init(clixon_handle h)
 int
 nacm_exit(clixon_handle h)
 {
-    cxobj *x;
-    cvec  *cvv = NULL;
+    cxobj                *x;
+    cvec                 *cvv = NULL;
+    struct nacm_compiled *nc = NULL;
 
     if ((x = clicon_nacm_ext(h)) != NULL)
         xml_free(x);
+    if (clicon_ptr_get(h, "nacm-compiled", (void**)&nc) == 0 &&
+        nc != NULL){
+        nacm_compiled_free(nc);
+        clicon_ptr_del(h, "nacm-compiled");
+    }
     if (clicon_ptr_get(h, "nacm-proxyuser", (void**)&cvv) == 0 &&
         cvv != NULL){
         cvec_free(cvv);
@@ -44,6 +44,10 @@
         // invalid
  */
 
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -113,6 +117,40 @@ detect_endtag(char *tag,
     return retval;
 }
 
+#ifdef NETCONF_INPUT_BULK
+/*! Append a run of input data to a message, skipping NULL chars
+ *
+ * @param[in]  cb   Message
+ * @param[in]  p    Input data
+ * @param[in]  n    Length of input data
+ * @retval     n    Number of chars appended
+ */
+static size_t
+netconf_input_append_run(cbuf          *cb,
+                         unsigned char *p,
+                         size_t         n)
+{
+    size_t         nr = 0;
+    unsigned char *q;
+    size_t         k;
+
+    while (n > 0){
+        if ((q = memchr(p, 0, n)) == NULL){
+            cbuf_append_buf(cb, p, n);
+            nr += n;
+            break;
+        }
+        if ((k = q - p) > 0){
+            cbuf_append_buf(cb, p, k);
+            nr += k;
+        }
+        p = q + 1;   /* Skip NULL chars (eg from terminals) */
+        n -= k + 1;
+    }
+    return nr;
+}
+#endif /* NETCONF_INPUT_BULK */
+
 /*! Read from socket and append to cbuf
  *
  * @param[in]   s       Socket where input arrives. Read from this.
@@ -133,7 +171,6 @@ netconf_input_read2(int            s,
     int     restarts = 0;
     int     maxrestarts = 5;
 
-    memset(buf, 0, buflen);
     while ((len = read(s, buf, buflen)) < 0) {
         switch (errno){
         case EINTR:
@@ -198,10 +235,36 @@ netconf_input_msg2(unsigned char      **bufp,
     int       found = 0;
     size_t    len;
     char      ch;
+#ifdef NETCONF_INPUT_BULK
+    size_t    n;
+    unsigned char *q;
+#endif
 
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
     len = *lenp;
     for (i=0; i<len; i++){
+#ifdef NETCONF_INPUT_BULK
+        /* Append runs of data without framing chars in one go */
+        if (framing_type == NETCONF_SSH_CHUNKED){
+            if (*frame_state == 4 && *frame_size > 0){ /* chunk-data */
+                n = len - i;
+                if (n > *frame_size)
+                    n = *frame_size;
+                *frame_size -= netconf_input_append_run(cbmsg, *bufp + i, n);
+                i += n - 1;
+                continue;
+            }
+        }
+        else if (*frame_state == 0){
+            q = memchr(*bufp + i, ']', len - i);
+            n = q ? (size_t)(q - (*bufp + i)) : len - i;
+            if (n > 0){
+                netconf_input_append_run(cbmsg, *bufp + i, n);
+                i += n - 1;
+                continue;
+            }
+        }
+#endif
         if ((ch = (*bufp)[i]) == 0)
             continue; /* Skip NULL chars (eg from terminals) */
         if (framing_type == NETCONF_SSH_CHUNKED){
@@ -250,6 +313,7 @@ netconf_input_msg2(unsigned char      **bufp,
  *
  * Parse string to xml, check only one netconf message within a frame
  * A relatively high-level function.
+ * The packet buffer is parsed in place and its content is undefined after the call
  * @param[in]   cb    Packet buffer
  * @param[in]   yb    Yang binding: Y_RPC for server-side, Y_NONE for client-side (for now)
  * @param[in]   yspec Yang spec
@@ -284,7 +348,7 @@ netconf_input_frame2(cbuf      *cb,
         goto failed;
     }
     /* Fix to distinguish RPC and REPLIES */
-    if ((ret = clixon_xml_parse_string(str, yb, yspec, &xtop, xerr)) < 0){
+    if ((ret = clixon_xml_parse_cbuf(NULL, cb, yb, yspec, &xtop, xerr)) < 0){
         /* XXX possibly should quit on -1? */
         if (netconf_operation_failed_xml(xerr, "rpc", clixon_err_reason())< 0)
             goto done;
@@ -1975,6 +1975,9 @@ netconf_capabilites(clixon_handle h,
     }
     /* RFC6241 Sec 8.3.  Candidate Configuration Capability */
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:candidate:1.0</capability>");
+    /* draft-ietf-netconf-privcand Private Candidate Capability */
+    if (clicon_option_bool(h, "CLICON_XMLDB_PRIVATE_CANDIDATE"))
+        cprintf(cb, "<capability>urn:ietf:params:netconf:capability:private-candidate:1.0</capability>");
     /* RFC6241 Sec 8.6.  Validate Capability */
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:validate:1.1</capability>");
     /* rfc 6241 Sec 8.7 Distinct Startup Capability */
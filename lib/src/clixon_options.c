@@ -89,6 +89,48 @@
 #include "clixon_validate.h"
 #include "clixon_xml_default.h"
 
+/*! Type of pre-resolved option, how its string value is converted */
+enum option_slot_type{
+    OST_STR,    /* String only */
+    OST_BOOL,   /* "true" or "1" is 1, else 0 as clicon_option_bool */
+    OST_INT,    /* atoi, -1 if not set as clicon_option_int */
+    OST_FORMAT  /* format_str2int, -1 if not set or invalid */
+};
+
+/*! Name and type of each pre-resolved option, indexed by enum clicon_option_slot */
+static const struct {
+    const char           *ot_name;
+    enum option_slot_type ot_type;
+} option_slot_tab[OS_NR] = {
+    [OS_XMLDB_MULTI]              = {"CLICON_XMLDB_MULTI",              OST_BOOL},
+    [OS_XMLDB_SHARD]              = {"CLICON_XMLDB_SHARD",              OST_BOOL},
+    [OS_XMLDB_PRETTY]             = {"CLICON_XMLDB_PRETTY",             OST_BOOL},
+    [OS_XMLDB_FORMAT]             = {"CLICON_XMLDB_FORMAT",             OST_FORMAT},
+    [OS_XMLDB_MODSTATE]           = {"CLICON_XMLDB_MODSTATE",           OST_BOOL},
+    [OS_XMLDB_SYSTEM_ONLY_CONFIG] = {"CLICON_XMLDB_SYSTEM_ONLY_CONFIG", OST_BOOL},
+    [OS_XMLDB_RUNNING_RDONLY]     = {"CLICON_XMLDB_RUNNING_RDONLY",     OST_BOOL},
+    [OS_XMLDB_JOURNAL]            = {"CLICON_XMLDB_JOURNAL",            OST_BOOL},
+    [OS_XMLDB_JOURNAL_SIZE]       = {"CLICON_XMLDB_JOURNAL_SIZE",       OST_INT},
+    [OS_XMLDB_SNAPSHOT]           = {"CLICON_XMLDB_SNAPSHOT",           OST_BOOL},
+    [OS_XMLDB_SORT_THREADS]       = {"CLICON_XMLDB_SORT_THREADS",       OST_INT},
+    [OS_NACM_DISABLED_ON_EMPTY]   = {"CLICON_NACM_DISABLED_ON_EMPTY",   OST_BOOL},
+    [OS_YANG_SCHEMA_MOUNT]        = {"CLICON_YANG_SCHEMA_MOUNT",        OST_BOOL},
+    [OS_YANG_UNKNOWN_ANYDATA]     = {"CLICON_YANG_UNKNOWN_ANYDATA",     OST_BOOL},
+    [OS_IPC_BINARY]               = {"CLICON_IPC_BINARY",               OST_BOOL},
+    [OS_IPC_SHM]                  = {"CLICON_IPC_SHM",                  OST_BOOL},
+};
+
+/*! Pre-resolved options of a handle
+ *
+ * String values point into the option hash and are valid until the next option change,
+ * which invalidates all slots. They are resolved again on next access.
+ */
+struct clicon_option_slots {
+    int   os_valid;           /* Slots are resolved */
+    char *os_str[OS_NR];      /* String value, or NULL if not set */
+    int   os_int[OS_NR];      /* Converted value according to type */
+};
+
 /* Mapping between Clicon startup modes string <--> constants, 
    see clixon-config.yang type startup_mode */
 static const map_str2int startup_mode_map[] = {
@@ -136,6 +178,7 @@ static const map_str2int _FORMATS[] = {
     {"json",             FORMAT_JSON},
     {"cli",              FORMAT_CLI},
     {"netconf",          FORMAT_NETCONF},
+    {"cbor",             FORMAT_CBOR},
     {"default",          FORMAT_DEFAULT},
     {"pipe-xml-default", FORMAT_PIPE_XML_DEFAULT},
     {NULL,      -1}
@@ -176,7 +219,8 @@ cmpstringp(const void *p1,
  * @param[in] dbglevel Debug level
  * @retval    0        OK
  * @retval   -1        Error
- * @note CLICON_FEATURE, CLICON_YANG_DIR and CLICON_SNMP_MIB are treated specially since they are lists
+ * @note CLICON_FEATURE, CLICON_YANG_DIR, CLICON_SNMP_MIB and CLICON_YANG_SEARCH_INDEX are treated
+ *       specially since they are lists
  * @note sub-config structs not shown: eg autocli/restconf
  * @see clicon_option_dump1  different formats
  * @see cli_show_options
@@ -230,6 +274,12 @@ clicon_option_dump(clixon_handle h,
             continue;
         clixon_debug(dbglevel, "%s =\t \"%s\"", xml_name(x), xml_body(x));
     }
+    x = NULL;
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "CLICON_YANG_SEARCH_INDEX") != 0)
+            continue;
+        clixon_debug(dbglevel, "%s =\t \"%s\"", xml_name(x), xml_body(x));
+    }
    retval = 0;
  done:
     if (keys)
@@ -390,7 +440,8 @@ merge_control_xml(clixon_handle h,
         /* List options for configure options that are lists or leaf-lists: append to main */
         if (strcmp(name,"CLICON_FEATURE") == 0 ||
             strcmp(name,"CLICON_YANG_DIR") == 0 ||
-            strcmp(name,"CLICON_SNMP_MIB") == 0){
+            strcmp(name,"CLICON_SNMP_MIB") == 0 ||
+            strcmp(name,"CLICON_YANG_SEARCH_INDEX") == 0){
             if ((x = xml_dup(xec)) == NULL)
                 goto done;
             if (xml_addsub(xt, x) < 0)
@@ -545,6 +596,9 @@ parse_configfile(clixon_handle  h,
             continue;
         if (strcmp(name,"CLICON_SNMP_MIB")==0)
             continue;
+        if (strcmp(name,"CLICON_YANG_SEARCH_INDEX")==0)
+            continue;
+        clicon_option_slots_invalidate(h);
         if (clicon_hash_add(copt,
                             name,
                             body,
@@ -599,7 +653,8 @@ clicon_option_add(clixon_handle h,
     }
     if (strcmp(name, "CLICON_FEATURE")==0 ||
         strcmp(name, "CLICON_YANG_DIR")==0 ||
-        strcmp(name, "CLICON_SNMP_MIB")==0){
+        strcmp(name, "CLICON_SNMP_MIB")==0 ||
+        strcmp(name, "CLICON_YANG_SEARCH_INDEX")==0){
         if (clixon_xml_parse_va(YB_NONE, NULL, &xconfig, NULL, "<%s>%s</%s>",
                                 name, value, name) < 0)
             goto done;
@@ -626,6 +681,7 @@ clicon_option_add(clixon_handle h,
     }
     else {
         /* Add/change hash */
+        clicon_option_slots_invalidate(h);
         if (clicon_hash_add(copt,
                             name,
                             value,
@@ -745,6 +801,8 @@ clicon_options_main(clixon_handle h)
     xml_sort(xconfig);
     if (clicon_conf_xml_set(h, xconfig) < 0)
         goto done;
+    clixon_xml_parse_fast_set(clicon_option_bool(h, "CLICON_XML_PARSE_FAST"));
+    clixon_json_parse_fast_set(clicon_option_bool(h, "CLICON_JSON_PARSE_FAST"));
     retval = 0;
  done:
     if (extraconfdir)
@@ -857,6 +915,7 @@ clicon_option_str_set(clixon_handle h,
 {
     clicon_hash_t *copt = clicon_options(h);
 
+    clicon_option_slots_invalidate(h);
     return clicon_hash_add(copt, (char*)name, val, strlen(val)+1)==NULL?-1:0;
 }
 
@@ -972,9 +1031,147 @@ clicon_option_del(clixon_handle h,
 {
     clicon_hash_t *copt = clicon_options(h);
 
+    clicon_option_slots_invalidate(h);
     return clicon_hash_del(copt, (char*)name);
 }
 
+/*! Create pre-resolved options struct, part of the handle
+ *
+ * @retval    os    Option slots, free with clicon_option_slots_free
+ * @retval    NULL  Error
+ */
+clicon_option_slots *
+clicon_option_slots_new(void)
+{
+    clicon_option_slots *os;
+
+    if ((os = calloc(1, sizeof(*os))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    return os;
+}
+
+/*! Free pre-resolved options struct
+ *
+ * @param[in]  os   Option slots
+ */
+int
+clicon_option_slots_free(clicon_option_slots *os)
+{
+    free(os);
+    return 0;
+}
+
+/*! Invalidate pre-resolved options, they are resolved again on next access
+ *
+ * Called on every change of the option hash
+ * @param[in]  h    Clixon handle
+ */
+int
+clicon_option_slots_invalidate(clixon_handle h)
+{
+    clicon_option_slots *os;
+
+    if ((os = clicon_option_slots_get(h)) != NULL)
+        os->os_valid = 0;
+    return 0;
+}
+
+/*! Resolve all option slots from the option hash
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  os   Option slots
+ */
+static void
+option_slots_resolve(clixon_handle        h,
+                     clicon_option_slots *os)
+{
+    int   i;
+    char *s;
+
+    for (i = 0; i < OS_NR; i++){
+        s = clicon_option_str(h, option_slot_tab[i].ot_name);
+        os->os_str[i] = s;
+        switch (option_slot_tab[i].ot_type){
+        case OST_STR:
+            os->os_int[i] = 0;
+            break;
+        case OST_BOOL:
+            os->os_int[i] = s != NULL && (strcmp(s, "true") == 0 || strcmp(s, "1") == 0);
+            break;
+        case OST_INT:
+            os->os_int[i] = s ? atoi(s) : -1;
+            break;
+        case OST_FORMAT:
+            os->os_int[i] = s ? format_str2int(s) : -1;
+            break;
+        }
+    }
+    os->os_valid = 1;
+}
+
+/*! Get option slots of handle, resolve them if options have changed
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     os   Option slots
+ */
+static clicon_option_slots *
+option_slots(clixon_handle h)
+{
+    clicon_option_slots *os = clicon_option_slots_get(h);
+
+    if (!os->os_valid)
+        option_slots_resolve(h, os);
+    return os;
+}
+
+/*! Get pre-resolved option as string without hash lookup
+ *
+ * @param[in] h     Clixon handle
+ * @param[in] slot  Option slot
+ * @retval    str   Value of option
+ * @retval    NULL  Option not set
+ * @see clicon_option_str  Same result given an option name
+ */
+char *
+clicon_option_slot_str(clixon_handle           h,
+                       enum clicon_option_slot slot)
+{
+    return option_slots(h)->os_str[slot];
+}
+
+/*! Get pre-resolved option as integer without hash lookup or string conversion
+ *
+ * @param[in] h     Clixon handle
+ * @param[in] slot  Option slot
+ * @retval    int   Value converted according to the type of the slot: 
+ *                  boolean options as clicon_option_bool, integer options as
+ *                  clicon_option_int, and CLICON_XMLDB_FORMAT as format_str2int
+ * @retval   -1     Integer or format option not set, or invalid format
+ */
+int
+clicon_option_slot_int(clixon_handle           h,
+                       enum clicon_option_slot slot)
+{
+    return option_slots(h)->os_int[slot];
+}
+
+/*! Get pre-resolved boolean option without hash lookup or string compare
+ *
+ * @param[in] h     Clixon handle
+ * @param[in] slot  Option slot of a boolean option
+ * @retval    1     true
+ * @retval    0     false, or not set
+ * @see clicon_option_bool  Same result given an option name
+ */
+int
+clicon_option_slot_bool(clixon_handle           h,
+                        enum clicon_option_slot slot)
+{
+    return option_slots(h)->os_int[slot] == 1;
+}
+
 /*-----------------------------------------------------------------
  * Specific option access functions for YANG configuration variables.
  * Sometimes overridden by command-line options, 
@@ -78,6 +78,9 @@
 #include <arpa/inet.h>
 #include <sys/param.h>
 #include <netinet/in.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -703,12 +706,282 @@ api_path_fmt2xpath(char  *api_path_fmt,
     return retval;
 }
 
+/*
+ * Types
+ */
+struct api_path_template;
+
+#ifdef API_PATH_CACHE
+/* Max number of cached api-path templates, least recently used are evicted */
+#define API_PATH_CACHE_SIZE 1024
+
+/*! Translation of an api-path template to XPath, where key values are slots
+ *
+ * The XPath is stored without key values, at_offs are the offsets where the decoded key
+ * values are inserted. at_nvals is the number of values taken from each api-path element:
+ * 0 for none, -1 for the whole value (leaf-list), or the first n comma-separated values (list)
+ * @see api_path2xpath_cached
+ */
+struct api_path_template{
+    qelem_t  at_q;      /* LRU queue, least recently used first */
+    char    *at_key;    /* Key of cache: yspec and api-path without key values */
+    char    *at_xpath;  /* XPath without key values */
+    size_t  *at_offs;   /* Offsets in at_xpath where key values are inserted */
+    size_t  *at_lens;   /* Lengths of key values when template is created */
+    int      at_nslots; /* Length of at_offs */
+    int     *at_nvals;  /* Number of values per api-path element */
+    int      at_nelem;  /* Length of at_nvals */
+    cvec    *at_nsc;    /* Namespace context of XPath */
+    int      at_mount;  /* Mount-point encountered, translation depends on key values, not cached */
+};
+
+/* Cache of templates: key -> struct api_path_template* */
+static clicon_hash_t            *_api_path_cache = NULL;
+/* LRU queue of cache entries */
+static struct api_path_template *_api_path_cache_lru = NULL;
+/* Number of cache entries */
+static int                       _api_path_cache_nr = 0;
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t           _api_path_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/*! Record a key value written to XPath when creating a template
+ *
+ * @param[in]  apt    Template, or NULL
+ * @param[in]  xpath  XPath, the value ends at the end of xpath
+ * @param[in]  len    Length of value
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+api_path_template_slot(struct api_path_template *apt,
+                       cbuf                     *xpath,
+                       size_t                    len)
+{
+    size_t *offs;
+    size_t *lens;
+
+    if (apt == NULL)
+        return 0;
+    if ((offs = realloc(apt->at_offs, (apt->at_nslots+1)*sizeof(*offs))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    apt->at_offs = offs;
+    if ((lens = realloc(apt->at_lens, (apt->at_nslots+1)*sizeof(*lens))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    apt->at_lens = lens;
+    /* Offset in xpath for now, adjusted to template in api_path_template_done */
+    apt->at_offs[apt->at_nslots] = cbuf_len(xpath) - len;
+    apt->at_lens[apt->at_nslots++] = len;
+    return 0;
+}
+
+/*! Set number of values taken from an api-path element when creating a template
+ */
+static void
+api_path_template_nvals(struct api_path_template *apt,
+                        int                       i,
+                        int                       nvals)
+{
+    if (apt && i < apt->at_nelem)
+        apt->at_nvals[i] = nvals;
+}
+
+/*! Free an api-path template
+ */
+static void
+api_path_template_free(struct api_path_template *apt)
+{
+    if (apt->at_key)
+        free(apt->at_key);
+    if (apt->at_xpath)
+        free(apt->at_xpath);
+    if (apt->at_offs)
+        free(apt->at_offs);
+    if (apt->at_lens)
+        free(apt->at_lens);
+    if (apt->at_nvals)
+        free(apt->at_nvals);
+    if (apt->at_nsc)
+        cvec_free(apt->at_nsc);
+    free(apt);
+}
+
+/*! Remove and free an api-path cache entry
+ */
+static int
+api_path_cache_rm(struct api_path_template *apt)
+{
+    DELQ(apt, _api_path_cache_lru, struct api_path_template *);
+    if (clicon_hash_del(_api_path_cache, apt->at_key) < 0)
+        return -1;
+    _api_path_cache_nr--;
+    api_path_template_free(apt);
+    return 0;
+}
+
+/*! Create cache key of api-path: yspec and node names, but only the number of key values
+ *
+ * @param[in]  api_path  api-path as cvec
+ * @param[in]  yspec     Yang spec
+ * @param[out] key       Cache key
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+api_path_cache_key(cvec      *api_path,
+                   yang_stmt *yspec,
+                   cbuf      *key)
+{
+    cg_var *cv = NULL;
+    char   *val;
+    int     n;
+
+    cprintf(key, "%p", yspec);
+    while ((cv = cvec_each(api_path, cv)) != NULL){
+        cprintf(key, "/%s", cv_name_get(cv));
+        if (cv_type_get(cv) == CGV_STRING){
+            n = 1;
+            if ((val = cv_string_get(cv)) != NULL)
+                for (; *val; val++)
+                    if (*val == ',')
+                        n++;
+            cprintf(key, "=%d", n);
+        }
+    }
+    return 0;
+}
+
+/*! Strip key values from translated XPath and keep namespace context in template
+ *
+ * @param[in]  apt    Template with key value slots recorded by api_path2xpath_cvv
+ * @param[in]  xpath  Translated XPath
+ * @param[in]  nsc    Namespace context of XPath
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+api_path_template_done(struct api_path_template *apt,
+                       char                     *xpath,
+                       cvec                     *nsc)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    size_t pos = 0;
+    int    i;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    for (i=0; i<apt->at_nslots; i++){
+        cbuf_append_buf(cb, xpath + pos, apt->at_offs[i] - pos);
+        pos = apt->at_offs[i] + apt->at_lens[i];
+        apt->at_offs[i] = cbuf_len(cb);
+    }
+    cprintf(cb, "%s", xpath + pos);
+    if ((apt->at_xpath = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (nsc && (apt->at_nsc = cvec_dup(nsc)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_dup");
+        goto done;
+    }
+    free(apt->at_lens);
+    apt->at_lens = NULL;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Translate api-path to XPath by inserting its key values into a cached template
+ *
+ * @param[in]  apt       Template
+ * @param[in]  api_path  api-path as cvec, same key as template
+ * @param[out] xpath     XPath
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+api_path_template_expand(struct api_path_template *apt,
+                         cvec                     *api_path,
+                         cbuf                     *xpath)
+{
+    int     retval = -1;
+    cg_var *cv;
+    char   *val = NULL;
+    char  **valvec = NULL;
+    int     nvalvec;
+    char   *decval = NULL;
+    size_t  pos = 0;
+    int     slot = 0;
+    int     i;
+    int     j;
+
+    for (i=0; i<apt->at_nelem; i++){
+        if (apt->at_nvals[i] == 0)
+            continue;
+        cv = cvec_i(api_path, i);
+        if ((val = cv2str_dup(cv)) == NULL)
+            goto done;
+        if (apt->at_nvals[i] < 0){ /* leaf-list: whole value */
+            nvalvec = 1;
+            if ((valvec = malloc(sizeof(*valvec))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            valvec[0] = val;
+        }
+        else if ((valvec = clicon_strsep(val, ",", &nvalvec)) == NULL)
+            goto done;
+        for (j=0; j<nvalvec && (apt->at_nvals[i] < 0 || j<apt->at_nvals[i]); j++){
+            if (slot >= apt->at_nslots){
+                clixon_err(OE_XML, 0, "api-path template mismatch");
+                goto done;
+            }
+            if (uri_percent_decode(valvec[j], &decval) < 0)
+                goto done;
+            cbuf_append_buf(xpath, apt->at_xpath + pos, apt->at_offs[slot] - pos);
+            cprintf(xpath, "%s", decval);
+            pos = apt->at_offs[slot++];
+            free(decval);
+            decval = NULL;
+        }
+        free(valvec);
+        valvec = NULL;
+        free(val);
+        val = NULL;
+    }
+    if (slot != apt->at_nslots){
+        clixon_err(OE_XML, 0, "api-path template mismatch");
+        goto done;
+    }
+    cprintf(xpath, "%s", apt->at_xpath + pos);
+    retval = 0;
+ done:
+    if (decval)
+        free(decval);
+    if (valvec)
+        free(valvec);
+    if (val)
+        free(val);
+    return retval;
+}
+#endif /* API_PATH_CACHE */
+
 /*! Translate from restconf api-path(cvv) to xml xpath(cbuf) and namespace context
  * 
  * @param[in]     api_path URI-encoded path expression" (RFC8040 3.5.3) as cvec
  * @param[in]     yspec    Yang spec
  * @param[in,out] xpath    The xpath as cbuf (must be created and may have content)
  * @param[out]    nsc      Namespace context of xpath (free w xml_nsctx_free)
+ * @param[in,out] apt      If set, record key value slots of an api-path template, see API_PATH_CACHE
  * @param[out]    xerr     Netconf error message
  * @retval        1        OK
  * @retval        0        Invalid api_path or associated XML, netconf error xml set
@@ -720,7 +993,7 @@ api_path_fmt2xpath(char  *api_path_fmt,
  *   cvec *nsc = NULL;
  *   if (uri_str2cvec("www.foo.com/restconf/a/b=c", '/', '=', 0, &cvv) < 0)
  *      err;
- *   if ((ret = api_path2xpath_cvv(yspec, cvv, 0, cxpath, &nsc, NULL)) < 0)
+ *   if ((ret = api_path2xpath_cvv(cvv, yspec, cxpath, &nsc, NULL, NULL)) < 0)
  *      err;
  *   if (ret == 1)
  *     ... access xpath as cbuf_get(xpath) 
@@ -739,11 +1012,12 @@ api_path_fmt2xpath(char  *api_path_fmt,
  * @see api_path2xpath  Using strings as parameters
  */
 static int
-api_path2xpath_cvv(cvec      *api_path,
-                   yang_stmt *yspec,
-                   cbuf      *xpath,
-                   cvec     **nscp,
-                   cxobj    **xerr)
+api_path2xpath_cvv(cvec                     *api_path,
+                   yang_stmt                *yspec,
+                   cbuf                     *xpath,
+                   cvec                    **nscp,
+                   struct api_path_template *apt,
+                   cxobj                   **xerr)
 {
     int        retval = -1;
     int        i;
@@ -827,6 +1101,10 @@ api_path2xpath_cvv(cvec      *api_path,
         if ((ret = yang_schema_mount_point(y)) < 0)
             goto done;
         if (ret == 1){
+#ifdef API_PATH_CACHE
+            if (apt)
+                apt->at_mount = 1;
+#endif
             y1 = NULL;
             if (nsc){
                 cvec_free(nsc);
@@ -866,6 +1144,10 @@ api_path2xpath_cvv(cvec      *api_path,
         /* y may have changed to new */
         ymtpoint = yang_schema_mount_point(y);
         if (ymtpoint){
+#ifdef API_PATH_CACHE
+            if (apt)
+                apt->at_mount = 1;
+#endif
             /* If we cant find a specific mountpoint, we just assign the first.
              * XXX: Ignore return value: if none are mounted, no change of yspec is made here
              */
@@ -900,18 +1182,31 @@ api_path2xpath_cvv(cvec      *api_path,
                     /* valvec is uri encoded, needs decoding */
                     if (uri_percent_decode(val1, &decval) < 0)
                         goto done;
-                    cprintf(xpath, "%s='%s']", cv_string_get(cvi), decval);
+                    cprintf(xpath, "%s='%s", cv_string_get(cvi), decval);
+#ifdef API_PATH_CACHE
+                    if (api_path_template_slot(apt, xpath, strlen(decval)) < 0)
+                        goto done;
+#endif
+                    cprintf(xpath, "']");
                     if (decval){
                         free(decval);
                         decval = NULL;
                     }
                 }
+#ifdef API_PATH_CACHE
+                api_path_template_nvals(apt, i, vi);
+#endif
                 break;
             case Y_LEAF_LIST: /* XXX: LOOP? */
                 if (val){
                     if (uri_percent_decode(val, &decval) < 0)
                         goto done;
-                    cprintf(xpath, "[.='%s']", decval);
+                    cprintf(xpath, "[.='%s", decval);
+#ifdef API_PATH_CACHE
+                    if (api_path_template_slot(apt, xpath, strlen(decval)) < 0)
+                        goto done;
+#endif
+                    cprintf(xpath, "']");
                     if (decval){
                         free(decval);
                         decval = NULL;
@@ -919,6 +1214,10 @@ api_path2xpath_cvv(cvec      *api_path,
                 }
                 else
                     cprintf(xpath, "[.='']");
+#ifdef API_PATH_CACHE
+                if (val)
+                    api_path_template_nvals(apt, i, -1);
+#endif
                 break;
             default:
                 break;
@@ -958,6 +1257,204 @@ api_path2xpath_cvv(cvec      *api_path,
     goto done;
 }
 
+#ifdef API_PATH_CACHE
+/*! Translate from restconf api-path(cvv) to xpath(cbuf) using cache of api-path templates
+ *
+ * An api-path template is the api-path without key values, eg /ex:a/b=,/c. The XPath and
+ * namespace context of a template are cached, and the decoded key values of an api-path
+ * are inserted into the cached XPath.
+ * Api-paths via mount-points are translated but not cached
+ * @param[in]     api_path URI-encoded path expression" (RFC8040 3.5.3) as cvec
+ * @param[in]     yspec    Yang spec
+ * @param[in,out] xpath    The xpath as cbuf, must be empty
+ * @param[out]    nscp     Namespace context of xpath (free w xml_nsctx_free)
+ * @param[out]    xerr     Netconf error message
+ * @retval        1        OK
+ * @retval        0        Invalid api_path or associated XML, netconf error xml set
+ * @retval       -1        Fatal error
+ * @see api_path2xpath_cvv
+ */
+static int
+api_path2xpath_cached(cvec      *api_path,
+                      yang_stmt *yspec,
+                      cbuf      *xpath,
+                      cvec     **nscp,
+                      cxobj    **xerr)
+{
+    int                        retval = -1;
+    cbuf                      *key = NULL;
+    struct api_path_template **aptp;
+    struct api_path_template  *apt = NULL;
+    cvec                      *nsc = NULL;
+    int                        ret;
+
+    if ((key = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (api_path_cache_key(api_path, yspec, key) < 0)
+        goto done;
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&_api_path_cache_mutex);
+#endif
+    ret = 0;
+    if (_api_path_cache != NULL &&
+        (aptp = clicon_hash_value(_api_path_cache, cbuf_get(key), NULL)) != NULL){
+        apt = *aptp;
+        DELQ(apt, _api_path_cache_lru, struct api_path_template *);
+        ADDQ(apt, _api_path_cache_lru); /* Most recently used last */
+        ret = -1;
+        if (api_path_template_expand(apt, api_path, xpath) == 0 &&
+            (nscp == NULL || apt->at_nsc == NULL || (nsc = cvec_dup(apt->at_nsc)) != NULL))
+            ret = 1;
+        apt = NULL;
+    }
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&_api_path_cache_mutex);
+#endif
+    if (ret < 0)
+        goto done;
+    if (ret == 1)
+        goto ok;
+    /* Not cached: translate and record key value slots */
+    if ((apt = calloc(1, sizeof(*apt))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    apt->at_nelem = cvec_len(api_path);
+    if (apt->at_nelem &&
+        (apt->at_nvals = calloc(apt->at_nelem, sizeof(*apt->at_nvals))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((ret = api_path2xpath_cvv(api_path, yspec, xpath, &nsc, apt, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (apt->at_mount)
+        goto ok;
+    if (api_path_template_done(apt, cbuf_get(xpath), nsc) < 0)
+        goto done;
+    if ((apt->at_key = strdup(cbuf_get(key))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&_api_path_cache_mutex);
+#endif
+    ret = -1;
+    if (_api_path_cache == NULL &&
+        (_api_path_cache = clicon_hash_init()) == NULL)
+        goto unlock;
+    if (clicon_hash_value(_api_path_cache, apt->at_key, NULL) == NULL){ /* Not added by other thread */
+        /* Evict least recently used entry */
+        if (_api_path_cache_nr >= API_PATH_CACHE_SIZE &&
+            api_path_cache_rm(_api_path_cache_lru) < 0)
+            goto unlock;
+        if (clicon_hash_add(_api_path_cache, apt->at_key, &apt, sizeof(apt)) == NULL)
+            goto unlock;
+        ADDQ(apt, _api_path_cache_lru);
+        _api_path_cache_nr++;
+        apt = NULL;
+    }
+    ret = 1;
+ unlock:
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&_api_path_cache_mutex);
+#endif
+    if (ret < 0)
+        goto done;
+ ok:
+    if (nscp){
+        *nscp = nsc;
+        nsc = NULL;
+    }
+    retval = 1;
+ done:
+    if (apt)
+        api_path_template_free(apt);
+    if (nsc)
+        cvec_free(nsc);
+    if (key)
+        cbuf_free(key);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+#endif /* API_PATH_CACHE */
+
+/*! Free all cached api-path templates
+ *
+ * Called when a yang spec is freed, since the cache is keyed by yang spec
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see API_PATH_CACHE
+ */
+int
+api_path_cache_exit(void)
+{
+    int retval = 0;
+
+#ifdef API_PATH_CACHE
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&_api_path_cache_mutex);
+#endif
+    while (_api_path_cache_lru != NULL)
+        if (api_path_cache_rm(_api_path_cache_lru) < 0){
+            retval = -1;
+            break;
+        }
+    if (retval == 0 && _api_path_cache){
+        clicon_hash_free(_api_path_cache);
+        _api_path_cache = NULL;
+    }
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&_api_path_cache_mutex);
+#endif
+#endif
+    return retval;
+}
+
+/*! Return number of cached api-path templates and their approximate size
+ *
+ * @param[out] nr    Number of cache entries
+ * @param[out] szp   Size in bytes of templates, namespace contexts not included
+ * @retval     0     OK
+ * @see API_PATH_CACHE
+ */
+int
+api_path_cache_stats(uint64_t *nr,
+                     size_t   *szp)
+{
+#ifdef API_PATH_CACHE
+    struct api_path_template *apt;
+    size_t                    sz = 0;
+    int                       i;
+
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&_api_path_cache_mutex);
+#endif
+    apt = _api_path_cache_lru;
+    for (i=0; i<_api_path_cache_nr; i++){
+        sz += sizeof(*apt) + strlen(apt->at_key) + 1;
+        if (apt->at_xpath)
+            sz += strlen(apt->at_xpath) + 1;
+        sz += apt->at_nslots*2*sizeof(size_t) + apt->at_nelem*sizeof(int);
+        apt = NEXTQ(struct api_path_template *, apt);
+    }
+    *nr = _api_path_cache_nr;
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&_api_path_cache_mutex);
+#endif
+    *szp = sz;
+#else
+    *nr = 0;
+    *szp = 0;
+#endif
+    return 0;
+}
+
 /*! Translate from restconf api-path to xml xpath and namespace
  *
  * @param[in]  api_path  URI-encoded path expression" (RFC8040 3.5.3)
@@ -1011,8 +1508,13 @@ api_path2xpath(char      *api_path,
         goto done;
     if ((xpath = cbuf_new()) == NULL)
         goto done;
-    if ((ret = api_path2xpath_cvv(cvv, yspec, xpath, nsc, xerr)) < 0)
+#ifdef API_PATH_CACHE
+    if ((ret = api_path2xpath_cached(cvv, yspec, xpath, nsc, xerr)) < 0)
         goto done;
+#else
+    if ((ret = api_path2xpath_cvv(cvv, yspec, xpath, nsc, NULL, xerr)) < 0)
+        goto done;
+#endif
     if (ret == 0)
         goto fail;
     /* prepare output xpath parameter */
@@ -1539,6 +2041,121 @@ xml2api_path_1(cxobj *x,
     return retval;
 }
 
+/* Incremental api-path builder
+ * The api-path of the last node is kept with the length of each ancestor level, so that
+ * the path of a following node in the same tree, such as a sibling, reuses the prefix of
+ * the common ancestors, including their escaped key values.
+ */
+struct api_path_builder {
+    cbuf    *pb_cb;     /* api-path of last node */
+    cxobj  **pb_vec;    /* Ancestors of last node and node itself, top first */
+    size_t  *pb_len;    /* Length of pb_cb after each level */
+    int      pb_depth;  /* Number of levels in pb_vec */
+    int      pb_max;    /* Allocated length of pb_vec and pb_len */
+};
+
+/*! Create incremental api-path builder
+ *
+ * @retval  pb    Api-path builder, free with api_path_builder_free
+ * @retval  NULL  Error
+ * @see api_path_builder_path
+ */
+api_path_builder *
+api_path_builder_new(void)
+{
+    api_path_builder *pb;
+
+    if ((pb = calloc(1, sizeof(*pb))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    if ((pb->pb_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        free(pb);
+        return NULL;
+    }
+    return pb;
+}
+
+/*! Free incremental api-path builder
+ *
+ * @param[in]  pb    Api-path builder
+ * @retval     0     OK
+ */
+int
+api_path_builder_free(api_path_builder *pb)
+{
+    if (pb == NULL)
+        return 0;
+    if (pb->pb_cb)
+        cbuf_free(pb->pb_cb);
+    if (pb->pb_vec)
+        free(pb->pb_vec);
+    if (pb->pb_len)
+        free(pb->pb_len);
+    free(pb);
+    return 0;
+}
+
+/*! Construct the api-path of an XML node from the top of its tree, eg /example:c/a=1/x
+ *
+ * Levels of common ancestors with the node of the previous call are reused, only the
+ * levels below are printed with xml2api_path_1.
+ * @param[in]  pb    Api-path builder
+ * @param[in]  x     XML node, the top node of the tree (with no parent) is not included
+ * @param[out] pathp api-path, valid until next call or free of the builder
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @note The tree may not be changed between calls, since ancestors are compared by pointer
+ */
+int
+api_path_builder_path(api_path_builder *pb,
+                      cxobj            *x,
+                      char            **pathp)
+{
+    int     retval = -1;
+    cxobj  *xa;
+    int     n = 0;
+    int     d;
+    int     keep;
+    void   *p;
+
+    for (xa = x; xml_parent(xa) != NULL; xa = xml_parent(xa))
+        n++;
+    /* Deepest level that is common with the previous node */
+    for (xa = x, d = n-1; d >= 0; xa = xml_parent(xa), d--)
+        if (d < pb->pb_depth && pb->pb_vec[d] == xa)
+            break;
+    keep = d + 1;
+    if (n > pb->pb_max){
+        if ((p = realloc(pb->pb_vec, n*sizeof(*pb->pb_vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        pb->pb_vec = p;
+        if ((p = realloc(pb->pb_len, n*sizeof(*pb->pb_len))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        pb->pb_len = p;
+        pb->pb_max = n;
+    }
+    pb->pb_depth = keep;
+    cbuf_trunc(pb->pb_cb, keep ? pb->pb_len[keep-1] : 0);
+    for (xa = x, d = n-1; d >= keep; xa = xml_parent(xa), d--)
+        pb->pb_vec[d] = xa;
+    for (d = keep; d < n; d++){
+        if (xml2api_path_1(pb->pb_vec[d], pb->pb_cb) < 0)
+            goto done;
+        pb->pb_len[d] = cbuf_len(pb->pb_cb);
+        pb->pb_depth = d + 1;
+    }
+    *pathp = cbuf_get(pb->pb_cb);
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Resolve api-path module:names to yang statements
  *
  * @param[in]  cplist   Lisp of clixon-path
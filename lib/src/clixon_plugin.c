@@ -50,6 +50,7 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <time.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -79,6 +80,7 @@
 #include "clixon_proc.h"
 #include "clixon_data.h"
 #include "clixon_plugin.h"
+#include "clixon_event_profile.h"
 
 /*
  * Private types
@@ -93,6 +95,7 @@ struct clixon_plugin{
     char              cp_name[MAXPATHLEN]; /* Plugin filename. Note api ca_name is given by plugin itself */
     plghndl_t         cp_handle;  /* Handle to plugin using dlopen(3) */
     clixon_plugin_api cp_api;
+    uint64_t          cp_init_usec; /* Time of init function in micro-seconds */
 };
 
 /*
@@ -115,6 +118,7 @@ typedef struct {
 struct plugin_module_struct {
     clixon_plugin_t    *ms_plugin_list;
     rpc_callback_t     *ms_rpc_callbacks;
+    clicon_hash_t      *ms_rpc_index;   /* RPC name -> vector of callbacks in registration order */
     upgrade_callback_t *ms_upgrade_callbacks;
 };
 typedef struct plugin_module_struct plugin_module_struct;
@@ -188,6 +192,17 @@ clixon_plugin_handle_get(clixon_plugin_t *cp)
     return cp->cp_handle;
 }
 
+/*! Get time of plugin init function
+ *
+ * @param[in]  cp   Clixon plugin handle
+ * @retval     usec Time of init function when the plugin was loaded, in micro-seconds
+ */
+uint64_t
+clixon_plugin_init_usec_get(clixon_plugin_t *cp)
+{
+    return cp->cp_init_usec;
+}
+
 /*! Iterator over clixon plugins
  *
  * @note Never manipulate the plugin during operation or using the
@@ -376,6 +391,9 @@ plugin_load_one(clixon_handle h,
     char              *name;
     char              *p;
     void              *wh = NULL;
+    clixon_plugin_t   *cp = NULL;
+    struct timespec    t0;
+    uint64_t           usec;
 
     clixon_debug(CLIXON_DBG_INIT, "file:%s function:%s", file, function);
     dlerror();    /* Clear any existing error */
@@ -397,7 +415,10 @@ plugin_load_one(clixon_handle h,
     wh = NULL;
     if (clixon_resource_check(h, &wh, file, __func__) < 0)
         goto done;
-    if ((api = initfn(h)) == NULL) {
+    event_profile_start(&t0);
+    api = initfn(h);
+    usec = event_profile_usec(&t0);
+    if (api == NULL) {
         if (!clixon_err_category()){     /* if clixon_err() is not called then log and continue */
             clixon_log(h, LOG_DEBUG, "Warning: failed to initiate %s", strrchr(file,'/')?strchr(file, '/'):file);
             retval = 0;
@@ -420,9 +441,11 @@ plugin_load_one(clixon_handle h,
     if ((p=strrchr(name, '.')) != NULL)
         *p = '\0';
 
-    retval = plugin_add_one(h, name, handle, api, NULL);
-    if (retval == 0)
+    retval = plugin_add_one(h, name, handle, api, &cp);
+    if (retval == 0){
+        cp->cp_init_usec = usec;
         retval = 1;
+    }
 
  done:
     clixon_debug(CLIXON_DBG_INIT | CLIXON_DBG_DETAIL, "retval:%d", retval);
@@ -1399,6 +1422,45 @@ rpc_callback_dump(clixon_handle h)
 }
 #endif
 
+/*! Add RPC callback last in the index vector of its name
+ *
+ * @param[in]  ms   Plugin module struct
+ * @param[in]  rc   RPC callback
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see rpc_callback_call
+ */
+static int
+rpc_callback_index_add(plugin_module_struct *ms,
+                       rpc_callback_t       *rc)
+{
+    int              retval = -1;
+    rpc_callback_t **vec0;
+    rpc_callback_t **vec = NULL;
+    size_t           vlen = 0;
+
+    if (ms->ms_rpc_index == NULL &&
+        (ms->ms_rpc_index = clicon_hash_init()) == NULL)
+        goto done;
+    if ((vec0 = clicon_hash_value(ms->ms_rpc_index, rc->rc_name, &vlen)) == NULL)
+        vlen = 0;
+    if ((vec = malloc(vlen + sizeof(rc))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    if (vlen)
+        memcpy(vec, vec0, vlen);
+    vec[vlen/sizeof(rc)] = rc;
+    /* Value is copied */
+    if (clicon_hash_add(ms->ms_rpc_index, rc->rc_name, vec, vlen + sizeof(rc)) == NULL)
+        goto done;
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
 /*! Register a RPC callback by appending a new RPC to a global list
  *
  * @param[in]  h         clicon handle
@@ -1408,6 +1470,7 @@ rpc_callback_dump(clixon_handle h)
  * @param[in]  name      RPC name
  * @retval     0         OK
  * @retval    -1         Error
+ * The callback is also indexed by name, see rpc_callback_index_add
  * @see rpc_callback_call  which makes the actual callback
  */
 int
@@ -1438,6 +1501,12 @@ rpc_callback_register(clixon_handle  h,
     rc->rc_arg  = arg;
     rc->rc_namespace  = strdup(ns);
     rc->rc_name  = strdup(name);
+    if (rc->rc_namespace == NULL || rc->rc_name == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (rpc_callback_index_add(ms, rc) < 0)
+        goto done;
     ADDQ(rc, ms->ms_rpc_callbacks);
     return 0;
  done:
@@ -1468,6 +1537,10 @@ rpc_callback_delete_all(clixon_handle h)
                 free(rc->rc_name);
             free(rc);
         }
+    if (ms != NULL && ms->ms_rpc_index){
+        clicon_hash_free(ms->ms_rpc_index);
+        ms->ms_rpc_index = NULL;
+    }
     return 0;
 }
 
@@ -1486,6 +1559,7 @@ rpc_callback_delete_all(clixon_handle h)
  * @note that several callbacks can be registered. They need to cooperate on
  * return values, ie if one writes cbret, the other needs to handle that by
  * leaving it, replacing it or amending it.
+ * Callbacks are looked up by name in an index and called in registration order
  */
 int
 rpc_callback_call(clixon_handle h,
@@ -1496,6 +1570,9 @@ rpc_callback_call(clixon_handle h,
 {
     int                   retval = -1;
     rpc_callback_t       *rc;
+    rpc_callback_t      **vec;
+    size_t                vlen;
+    size_t                i;
     char                 *name;
     char                 *prefix;
     char                 *ns;
@@ -1511,34 +1588,36 @@ rpc_callback_call(clixon_handle h,
     name = xml_name(xe);
     prefix = xml_prefix(xe);
     xml2ns(xe, prefix, &ns);
-    if ((rc = ms->ms_rpc_callbacks) != NULL)
-        do {
-            if (strcmp(rc->rc_name, name) == 0 &&
-                ns && rc->rc_namespace &&
-                strcmp(rc->rc_namespace, ns) == 0){
-                wh = NULL;
-                if (clixon_resource_check(h, &wh, rc->rc_name, __func__) < 0)
-                    goto done;
-                /* This is for callback functions to check if this is part of an
-                 * incoming synchronous RPC (or another event such as timeout
-                 */
-                clicon_data_int_set(h, "clixon-client-rpc", 1);
-                if (rc->rc_callback(h, xe, cbret, arg, rc->rc_arg) < 0){
-                    clicon_data_int_set(h, "clixon-client-rpc", 0);
-                    clixon_debug(CLIXON_DBG_RPC, "Error in: %s", rc->rc_name);
-                    clixon_resource_check(h, &wh, rc->rc_name, __func__);
-                    goto done;
-                }
+    /* Look up vector again after each call, a callback may register new callbacks */
+    for (i = 0; ms->ms_rpc_index != NULL; i++){
+        if ((vec = clicon_hash_value(ms->ms_rpc_index, name, &vlen)) == NULL ||
+            i >= vlen/sizeof(rc))
+            break;
+        rc = vec[i];
+        if (ns && rc->rc_namespace &&
+            strcmp(rc->rc_namespace, ns) == 0){
+            wh = NULL;
+            if (clixon_resource_check(h, &wh, rc->rc_name, __func__) < 0)
+                goto done;
+            /* This is for callback functions to check if this is part of an
+             * incoming synchronous RPC (or another event such as timeout
+             */
+            clicon_data_int_set(h, "clixon-client-rpc", 1);
+            if (rc->rc_callback(h, xe, cbret, arg, rc->rc_arg) < 0){
                 clicon_data_int_set(h, "clixon-client-rpc", 0);
-                nr++;
-                if (clixon_resource_check(h, &wh, rc->rc_name, __func__) < 0)
-                    goto done;
-                /* Ensure only one reply: first wins */
-                if (cbuf_len(cbret) > 0)
-                    break;
+                clixon_debug(CLIXON_DBG_RPC, "Error in: %s", rc->rc_name);
+                clixon_resource_check(h, &wh, rc->rc_name, __func__);
+                goto done;
             }
-            rc = NEXTQ(rpc_callback_t *, rc);
-        } while (rc != ms->ms_rpc_callbacks);
+            clicon_data_int_set(h, "clixon-client-rpc", 0);
+            nr++;
+            if (clixon_resource_check(h, &wh, rc->rc_name, __func__) < 0)
+                goto done;
+            /* Ensure only one reply: first wins */
+            if (cbuf_len(cbret) > 0)
+                break;
+        }
+    }
     /* action reply checked in action_callback_call */
     if (nr &&
         strcmp(name, "hello") != 0 &&
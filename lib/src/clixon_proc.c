@@ -108,6 +108,9 @@
 #include <sys/user.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h> /* pidfd_open */
+#endif
 
 #include <cligen/cligen.h>
 
@@ -130,6 +133,14 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_proc.h"
 
+/* Get an event on process exit from a pidfd registered in the event loop, instead of
+ * scanning all processes on SIGCHLD and polling exiting processes.
+ * Requires pidfd_open(2), Linux 5.3, and falls back to SIGCHLD if not supported
+ */
+#if defined(__linux__) && defined(SYS_pidfd_open)
+#define PROC_PIDFD
+#endif
+
 /*
  * Types
  */
@@ -159,6 +170,8 @@ struct process_entry_t {
     pid_t          pe_exit_status;/* Status on exit as defined in waitpid */
     struct timeval pe_starttime; /* Start time */
     proc_cb_t     *pe_callback;  /* Wrapper function, may be called from process_operation  */
+    int            pe_pidfd;     /* pidfd of running process registered for exit events, or -1 */
+    clixon_handle  pe_h;         /* Clixon handle, used in exit event callback */
 };
 
 /*! Structure for checking resources before and after a call
@@ -175,6 +188,7 @@ struct resource_context {
 /* Forward declaration */
 static int clixon_process_sched_register(clixon_handle h, int delay);
 static int clixon_process_delete_only(process_entry_t *pe);
+static int proc_entry_reap(clixon_handle h, process_entry_t *pe, int status);
 
 static void
 clixon_proc_sigint(int sig)
@@ -481,6 +495,190 @@ static const map_str2int proc_operation_map[] = {
 /* List of process callback entries XXX move to handle */
 static process_entry_t *_proc_entry_list = NULL;
 
+/* Index of process entries by name, value is process_entry_t* */
+static clicon_hash_t *_proc_name_hash = NULL;
+
+/* Index of process entries with a running process by pid, value is process_entry_t* */
+static clicon_hash_t *_proc_pid_hash = NULL;
+
+/* A scheduling timeout is registered, and its time
+ * All operations scheduled before it expires are made by the same clixon_process_sched
+ */
+static int            _proc_sched_reg = 0;
+static struct timeval _proc_sched_time;
+
+/*! Find process entry given name
+ *
+ * @param[in]  name  Name of process
+ * @retval     pe    Process entry, first registered if several with same name
+ * @retval     NULL  Not found
+ */
+static process_entry_t *
+proc_entry_find(const char *name)
+{
+    process_entry_t **pp;
+
+    if (_proc_name_hash == NULL || name == NULL)
+        return NULL;
+    if ((pp = clicon_hash_value(_proc_name_hash, name, NULL)) == NULL)
+        return NULL;
+    return *pp;
+}
+
+/*! Find process entry given pid of running process
+ *
+ * @param[in]  pid   Process id
+ * @retval     pe    Process entry
+ * @retval     NULL  Not found
+ */
+static process_entry_t *
+proc_entry_find_pid(pid_t pid)
+{
+    process_entry_t **pp;
+    char              pidstr[16];
+
+    if (_proc_pid_hash == NULL || pid == 0)
+        return NULL;
+    snprintf(pidstr, sizeof(pidstr), "%d", pid);
+    if ((pp = clicon_hash_value(_proc_pid_hash, pidstr, NULL)) == NULL)
+        return NULL;
+    return *pp;
+}
+
+/*! Set pid of process entry and update pid index
+ *
+ * @param[in]  pe    Process entry
+ * @param[in]  pid   Process id, or 0 if dead
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+proc_entry_pid_set(process_entry_t *pe,
+                   pid_t            pid)
+{
+    char pidstr[16];
+
+    if (_proc_pid_hash == NULL &&
+        (_proc_pid_hash = clicon_hash_init()) == NULL)
+        return -1;
+    if (pe->pe_pid != 0 && proc_entry_find_pid(pe->pe_pid) == pe){
+        snprintf(pidstr, sizeof(pidstr), "%d", pe->pe_pid);
+        clicon_hash_del(_proc_pid_hash, pidstr);
+    }
+    pe->pe_pid = pid;
+    if (pid != 0){
+        snprintf(pidstr, sizeof(pidstr), "%d", pid);
+        if (clicon_hash_add(_proc_pid_hash, pidstr, &pe, sizeof(pe)) == NULL)
+            return -1;
+    }
+    return 0;
+}
+
+#ifdef PROC_PIDFD
+/*! Process exit event on pidfd, reap the process
+ *
+ * @param[in]  fd   pidfd
+ * @param[in]  arg  Process entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+clixon_process_pidfd_cb(int   fd,
+                        void *arg)
+{
+    int              retval = -1;
+    process_entry_t *pe = (process_entry_t *)arg;
+    int              status = 0;
+    pid_t            wpid;
+
+    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d)", pe->pe_name, pe->pe_pid);
+    if (pe->pe_pid != 0 &&
+        (wpid = waitpid(pe->pe_pid, &status, WNOHANG)) != 0){
+        if (wpid == pe->pe_pid){
+            if (proc_entry_reap(pe->pe_h, pe, status) < 0)
+                goto done;
+        }
+        else if (pe->pe_pidfd == fd){ /* Reaped elsewhere */
+            clixon_event_unreg_fd(fd, clixon_process_pidfd_cb);
+            close(fd);
+            pe->pe_pidfd = -1;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+#endif /* PROC_PIDFD */
+
+/*! Open a pidfd of a started process and register it for exit events
+ *
+ * If pidfd is not supported, exit is detected by SIGCHLD, see clixon_process_waitpid
+ * @param[in]  pe    Process entry
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+proc_pidfd_open(process_entry_t *pe)
+{
+#ifdef PROC_PIDFD
+    int fd;
+
+    if (pe->pe_pid == 0)
+        return 0;
+    if ((fd = syscall(SYS_pidfd_open, pe->pe_pid, 0)) < 0){
+        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "pidfd_open(%d): %s",
+                     pe->pe_pid, strerror(errno));
+        return 0;
+    }
+    if (clixon_event_reg_fd(fd, clixon_process_pidfd_cb, pe, "process exit") < 0){
+        close(fd);
+        return -1;
+    }
+    pe->pe_pidfd = fd;
+#endif
+    return 0;
+}
+
+/*! Unregister and close pidfd of process entry, if any
+ */
+static int
+proc_pidfd_close(process_entry_t *pe)
+{
+#ifdef PROC_PIDFD
+    if (pe->pe_pidfd != -1){
+        clixon_event_unreg_fd(pe->pe_pidfd, clixon_process_pidfd_cb);
+        close(pe->pe_pidfd);
+        pe->pe_pidfd = -1;
+    }
+#endif
+    return 0;
+}
+
+/*! Start process of process entry and index it by its pid
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  pe    Process entry
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+proc_entry_start(clixon_handle    h,
+                 process_entry_t *pe)
+{
+    pid_t pid = 0;
+
+    if (clixon_proc_background(h, pe->pe_argv, pe->pe_netns,
+                               pe->pe_uid, pe->pe_gid, pe->pe_fdkeep,
+                               &pid) < 0)
+        return -1;
+    proc_pidfd_close(pe);
+    if (proc_entry_pid_set(pe, pid) < 0)
+        return -1;
+    if (proc_pidfd_open(pe) < 0)
+        return -1;
+    return 0;
+}
+
 int
 clixon_process_op_str2int(char *opstr)
 {
@@ -505,14 +703,10 @@ clixon_process_argv_get(clixon_handle h,
 {
     process_entry_t *pe;
 
-    pe = _proc_entry_list;
-    do {
-        if (strcmp(pe->pe_name, name) == 0){
-            *argv = pe->pe_argv;
-            *argc = pe->pe_argc;
-        }
-        pe = NEXTQ(process_entry_t *, pe);
-    } while (pe != _proc_entry_list);
+    if ((pe = proc_entry_find(name)) != NULL){
+        *argv = pe->pe_argv;
+        *argc = pe->pe_argc;
+    }
     return 0;
 }
 
@@ -559,11 +753,16 @@ clixon_process_register(clixon_handle h,
 
     clixon_debug(CLIXON_DBG_PROC, "name:%s (%s)", name, argv[0]);
 
+    if (_proc_name_hash == NULL &&
+        (_proc_name_hash = clicon_hash_init()) == NULL)
+        goto done;
     if ((pe = malloc(sizeof(process_entry_t))) == NULL) {
         clixon_err(OE_DB, errno, "malloc");
         goto done;
     }
     memset(pe, 0, sizeof(*pe));
+    pe->pe_pidfd = -1;
+    pe->pe_h = h;
     if ((pe->pe_name = strdup(name)) == NULL){
         clixon_err(OE_DB, errno, "strdup name");
         free(pe);
@@ -602,6 +801,11 @@ clixon_process_register(clixon_handle h,
                  clicon_int2str(proc_state_map, PROC_STATE_STOPPED)
                  );
     pe->pe_state = PROC_STATE_STOPPED;
+    if (proc_entry_find(name) == NULL &&
+        clicon_hash_add(_proc_name_hash, name, &pe, sizeof(pe)) == NULL){
+        clixon_process_delete_only(pe);
+        goto done;
+    }
     ADDQ(pe, _proc_entry_list);
     retval = 0;
  done:
@@ -640,8 +844,18 @@ clixon_process_delete_all(clixon_handle h)
 
     while((pe = _proc_entry_list) != NULL) {
         DELQ(pe, _proc_entry_list, process_entry_t *);
+        proc_pidfd_close(pe);
         clixon_process_delete_only(pe);
     }
+    if (_proc_name_hash){
+        clicon_hash_free(_proc_name_hash);
+        _proc_name_hash = NULL;
+    }
+    if (_proc_pid_hash){
+        clicon_hash_free(_proc_pid_hash);
+        _proc_pid_hash = NULL;
+    }
+    _proc_sched_reg = 0;
     return 0;
 }
 
@@ -685,26 +899,15 @@ clixon_process_pid(clixon_handle h,
     process_entry_t *pe;
     int              isrunning; /* Process is actually running */
 
-    if (_proc_entry_list == NULL || !pid)
-    goto done;
-
-    pe = _proc_entry_list;
-    do {
-        if (strcmp(pe->pe_name, name) == 0) {
-            isrunning = 0;
-            if (proc_op_run(pe->pe_pid, &isrunning) < 0)
-                goto done;
-
-            if (!isrunning)
-                goto done;
-
-            *pid = pe->pe_pid;
-            retval = 0;
-            break;
-        }
-        pe = NEXTQ(process_entry_t *, pe);
-    } while (pe != _proc_entry_list);
-
+    if (!pid || (pe = proc_entry_find(name)) == NULL)
+        goto done;
+    isrunning = 0;
+    if (proc_op_run(pe->pe_pid, &isrunning) < 0)
+        goto done;
+    if (!isrunning)
+        goto done;
+    *pid = pe->pe_pid;
+    retval = 0;
 done:
     return retval;
 }
@@ -738,55 +941,47 @@ clixon_process_operation(clixon_handle  h,
     int              delay = 0;
 
     clixon_debug(CLIXON_DBG_PROC, "name:%s op:%s", name, clicon_int2str(proc_operation_map, op0));
-    if (_proc_entry_list == NULL)
-        goto ok;
-    if ((pe = _proc_entry_list) != NULL)
-        do {
-            if (strcmp(pe->pe_name, name) == 0){
-                /* Call wrapper function that eg changes op1 based on config */
-                op = op0;
-                if (wrapit && pe->pe_callback != NULL)
-                    if (pe->pe_callback(h, pe, &op) < 0)
+    if ((pe = proc_entry_find(name)) != NULL){
+        /* Call wrapper function that eg changes op1 based on config */
+        op = op0;
+        if (wrapit && pe->pe_callback != NULL)
+            if (pe->pe_callback(h, pe, &op) < 0)
+                goto done;
+        if (op == PROC_OP_START || op == PROC_OP_STOP || op == PROC_OP_RESTART){
+            pe->pe_operation = op;
+            clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "scheduling name: %s pid:%d op: %s",
+                         name, pe->pe_pid,
+                         clicon_int2str(proc_operation_map, pe->pe_operation));
+            if (pe->pe_state==PROC_STATE_RUNNING &&
+                (op == PROC_OP_STOP || op == PROC_OP_RESTART)){
+                isrunning = 0;
+                if (proc_op_run(pe->pe_pid, &isrunning) < 0)
+                    goto done;
+                if (isrunning) {
+                    clixon_log(h, LOG_NOTICE, "Killing old process %s with pid: %d",
+                               pe->pe_name, pe->pe_pid); /* XXX pid may be 0 */
+                    if (kill(pe->pe_pid, SIGTERM) < 0){
+                        clixon_err(OE_UNIX, errno, "kill(%d) %d", pe->pe_pid, errno);
                         goto done;
-                if (op == PROC_OP_START || op == PROC_OP_STOP || op == PROC_OP_RESTART){
-                    pe->pe_operation = op;
-                    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "scheduling name: %s pid:%d op: %s",
-                                 name, pe->pe_pid,
-                                 clicon_int2str(proc_operation_map, pe->pe_operation));
-                    if (pe->pe_state==PROC_STATE_RUNNING &&
-                        (op == PROC_OP_STOP || op == PROC_OP_RESTART)){
-                        isrunning = 0;
-                        if (proc_op_run(pe->pe_pid, &isrunning) < 0)
-                            goto done;
-                        if (isrunning) {
-                            clixon_log(h, LOG_NOTICE, "Killing old process %s with pid: %d",
-                                       pe->pe_name, pe->pe_pid); /* XXX pid may be 0 */
-                            if (kill(pe->pe_pid, SIGTERM) < 0){
-                                clixon_err(OE_UNIX, errno, "kill(%d) %d", pe->pe_pid, errno);
-                                goto done;
-                            }
-                            delay = 1;
-                        }
-                        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d) %s --%s--> %s",
-                                     pe->pe_name, pe->pe_pid,
-                                     clicon_int2str(proc_state_map, pe->pe_state),
-                                     clicon_int2str(proc_operation_map, pe->pe_operation),
-                                     clicon_int2str(proc_state_map, PROC_STATE_EXITING)
-                                     );
-                        pe->pe_state = PROC_STATE_EXITING; /* Keep operation stop/restart */
                     }
-                    sched++;/* start: immediate stop/restart: not immediate: wait timeout */
-                }
-                else{
-                    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "name:%s op %s cancelled by wrap", name, clicon_int2str(proc_operation_map, op0));
+                    delay = 1;
                 }
-                break;          /* hit break here */
+                clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d) %s --%s--> %s",
+                             pe->pe_name, pe->pe_pid,
+                             clicon_int2str(proc_state_map, pe->pe_state),
+                             clicon_int2str(proc_operation_map, pe->pe_operation),
+                             clicon_int2str(proc_state_map, PROC_STATE_EXITING)
+                             );
+                pe->pe_state = PROC_STATE_EXITING; /* Keep operation stop/restart */
             }
-            pe = NEXTQ(process_entry_t *, pe);
-        } while (pe != _proc_entry_list);
+            sched++;/* start: immediate stop/restart: not immediate: wait timeout */
+        }
+        else{
+            clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "name:%s op %s cancelled by wrap", name, clicon_int2str(proc_operation_map, op0));
+        }
+    }
     if (sched && clixon_process_sched_register(h, delay) < 0)
         goto done;
- ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_PROC, "retval:%d", retval);
@@ -816,47 +1011,40 @@ clixon_process_status(clixon_handle  h,
 
     clixon_debug(CLIXON_DBG_PROC, "name:%s", name);
 
-    if (_proc_entry_list != NULL){
-        pe = _proc_entry_list;
-        do {
-            if (strcmp(pe->pe_name, name) == 0){
-                clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "found %s pid:%d", name, pe->pe_pid);
-                /* Check if running */
-                run = 0;
-                if (pe->pe_pid && proc_op_run(pe->pe_pid, &run) < 0)
+    if ((pe = proc_entry_find(name)) != NULL){
+        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "found %s pid:%d", name, pe->pe_pid);
+        /* Check if running */
+        run = 0;
+        if (pe->pe_pid && proc_op_run(pe->pe_pid, &run) < 0)
+            goto done;
+        cprintf(cbret, "<rpc-reply xmlns=\"%s\"><active xmlns=\"%s\">%s</active>",
+                NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS, run?"true":"false");
+        if (pe->pe_description)
+            cprintf(cbret, "<description xmlns=\"%s\">%s</description>", CLIXON_LIB_NS, pe->pe_description);
+        cprintf(cbret, "<command xmlns=\"%s\">", CLIXON_LIB_NS);
+        /* The command may include any data, including XML (such as restconf -R
+         * command) and therefore needs explicit encoding */
+        for (i=0; i<pe->pe_argc-1; i++){
+            if (i)
+                if (xml_chardata_cbuf_append(cbret, 0, " ") < 0)
                     goto done;
-                cprintf(cbret, "<rpc-reply xmlns=\"%s\"><active xmlns=\"%s\">%s</active>",
-                        NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS, run?"true":"false");
-                if (pe->pe_description)
-                    cprintf(cbret, "<description xmlns=\"%s\">%s</description>", CLIXON_LIB_NS, pe->pe_description);
-                cprintf(cbret, "<command xmlns=\"%s\">", CLIXON_LIB_NS);
-                /* The command may include any data, including XML (such as restconf -R
-                 * command) and therefore needs explicit encoding */
-                for (i=0; i<pe->pe_argc-1; i++){
-                    if (i)
-                        if (xml_chardata_cbuf_append(cbret, 0, " ") < 0)
-                            goto done;
-                    if (xml_chardata_cbuf_append(cbret, 0, pe->pe_argv[i]) < 0)
-                        goto done;
-                }
-                cprintf(cbret, "</command>");
-                cprintf(cbret, "<status xmlns=\"%s\">%s</status>", CLIXON_LIB_NS,
-                        clicon_int2str(proc_state_map, pe->pe_state));
-                if (timerisset(&pe->pe_starttime)){
-                    if (time2str(&pe->pe_starttime, timestr, sizeof(timestr)) < 0){
-                        clixon_err(OE_UNIX, errno, "time2str");
-                        goto done;
-                    }
-                    cprintf(cbret, "<starttime xmlns=\"%s\">%s</starttime>", CLIXON_LIB_NS, timestr);
-                }
-                if (pe->pe_pid)
-                    cprintf(cbret, "<pid xmlns=\"%s\">%u</pid>", CLIXON_LIB_NS, pe->pe_pid);
-                cprintf(cbret, "</rpc-reply>");
-                match++;
-                break;      /* hit break here */
+            if (xml_chardata_cbuf_append(cbret, 0, pe->pe_argv[i]) < 0)
+                goto done;
+        }
+        cprintf(cbret, "</command>");
+        cprintf(cbret, "<status xmlns=\"%s\">%s</status>", CLIXON_LIB_NS,
+                clicon_int2str(proc_state_map, pe->pe_state));
+        if (timerisset(&pe->pe_starttime)){
+            if (time2str(&pe->pe_starttime, timestr, sizeof(timestr)) < 0){
+                clixon_err(OE_UNIX, errno, "time2str");
+                goto done;
             }
-            pe = NEXTQ(process_entry_t *, pe);
-        } while (pe != _proc_entry_list);
+            cprintf(cbret, "<starttime xmlns=\"%s\">%s</starttime>", CLIXON_LIB_NS, timestr);
+        }
+        if (pe->pe_pid)
+            cprintf(cbret, "<pid xmlns=\"%s\">%u</pid>", CLIXON_LIB_NS, pe->pe_pid);
+        cprintf(cbret, "</rpc-reply>");
+        match++;
     }
     if (!match){ /* No match, return error */
         if (netconf_unknown_element(cbret, "application", (char*)name, "Process service is not known") < 0)
@@ -932,6 +1120,7 @@ clixon_process_sched(int           fd,
     int              sched = 0;
 
     clixon_debug(CLIXON_DBG_PROC, "");
+    _proc_sched_reg = 0;
     if (_proc_entry_list == NULL)
         goto ok;
     pe = _proc_entry_list;
@@ -955,6 +1144,8 @@ clixon_process_sched(int           fd,
                     }
                     break;
                 case PROC_OP_RESTART:
+                     if (pe->pe_pidfd != -1) /* Restarted on exit event */
+                         break;
                      isrunning = 0;
                      if (proc_op_run(pe->pe_pid, &isrunning) < 0)
                          goto done;
@@ -978,9 +1169,7 @@ clixon_process_sched(int           fd,
                     if (proc_op_run(pe->pe_pid, &isrunning) < 0)
                         goto done;
                     if (!isrunning)
-                        if (clixon_proc_background(h, pe->pe_argv, pe->pe_netns,
-                                                   pe->pe_uid, pe->pe_gid, pe->pe_fdkeep,
-                                                   &pe->pe_pid) < 0)
+                        if (proc_entry_start(h, pe) < 0)
                             goto done;
                     clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL,
                                  "%s(%d) %s --%s--> %s",
@@ -1006,9 +1195,7 @@ clixon_process_sched(int           fd,
                 case PROC_OP_START:
                     if (isrunning) /* Already runs */
                         break;
-                    if (clixon_proc_background(h, pe->pe_argv, pe->pe_netns,
-                                               pe->pe_uid, pe->pe_gid, pe->pe_fdkeep,
-                                               &pe->pe_pid) < 0)
+                    if (proc_entry_start(h, pe) < 0)
                         goto done;
                     clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL,
                                  "%s(%d) %s --%s--> %s",
@@ -1043,6 +1230,8 @@ clixon_process_sched(int           fd,
  * Schedule a process event. There are two cases:
  * 1) A process has been killed and is in EXITING, after a delay kill again.
  * 2) A process is started, dont delay
+ * Operations are batched: if a timeout is already registered at or before the requested
+ * time, no new timeout is registered, eg many processes started by one commit.
  * @param[in]  h     Clixon handle
  * @param[in]  delay If 0 dont add a delay, if 1 add a delay
  * @retval     0     OK
@@ -1060,18 +1249,86 @@ clixon_process_sched_register(clixon_handle h,
     gettimeofday(&t, NULL);
     if (delay)
         timeradd(&t, &t1, &t);
+    if (_proc_sched_reg){
+        if (timercmp(&_proc_sched_time, &t, <=))
+            goto ok;
+        if (clixon_event_unreg_timeout(clixon_process_sched, h) < 0)
+            goto done;
+    }
     if (clixon_event_reg_timeout(t, clixon_process_sched, h, "process") < 0)
         goto done;
+    _proc_sched_reg = 1;
+    _proc_sched_time = t;
+ ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "retval:%d", retval);
     return retval;
 }
 
+/*! A process has been reaped, update state and restart it if requested
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  pe     Process entry
+ * @param[in]  status Exit status as returned by waitpid
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+proc_entry_reap(clixon_handle    h,
+                process_entry_t *pe,
+                int              status)
+{
+    int retval = -1;
+
+    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "waitpid(%d) waited", pe->pe_pid);
+    pe->pe_exit_status = status;
+    proc_pidfd_close(pe);
+    switch (pe->pe_operation){
+    case PROC_OP_NONE: /* Spontaneous / External termination */
+    case PROC_OP_STOP:
+        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL,
+                     "%s(%d) %s --%s--> %s",
+                     pe->pe_name, pe->pe_pid,
+                     clicon_int2str(proc_state_map, pe->pe_state),
+                     clicon_int2str(proc_operation_map, pe->pe_operation),
+                     clicon_int2str(proc_state_map, PROC_STATE_STOPPED)
+                     );
+        pe->pe_state = PROC_STATE_STOPPED;
+        if (proc_entry_pid_set(pe, 0) < 0)
+            goto done;
+        timerclear(&pe->pe_starttime);
+        break;
+    case PROC_OP_RESTART:
+        /* This is the case where there is an existing process running.
+         * it was killed above but still runs and needs to be reaped */
+        if (proc_entry_start(h, pe) < 0)
+            goto done;
+        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d) %s --%s--> %s",
+                     pe->pe_name, pe->pe_pid,
+                     clicon_int2str(proc_state_map, pe->pe_state),
+                     clicon_int2str(proc_operation_map, pe->pe_operation),
+                     clicon_int2str(proc_state_map, PROC_STATE_RUNNING)
+                     );
+        pe->pe_state = PROC_STATE_RUNNING;
+        gettimeofday(&pe->pe_starttime, NULL);
+        break;
+    default:
+        break;
+    }
+    pe->pe_operation = PROC_OP_NONE;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Go through processes and wait for child processes
  *
  * Typically we know a child has been killed by SIGCHLD, but we do not know which process it is
- * Traverse all known processes and reap them, eg call waitpid() to avoid zombies.
+ * Exited children are first looked up in the pid index without reaping them. If an exited
+ * child is not a known process, traverse all known processes and reap them, eg call waitpid()
+ * to avoid zombies.
+ * Processes with a pidfd are reaped on their exit event instead, see clixon_process_pidfd_cb
  * @param[in]  h  Clixon handle
  * @retval     0  OK
  * @retval    -1  Error
@@ -1084,60 +1341,37 @@ clixon_process_waitpid(clixon_handle h)
     process_entry_t *pe;
     int              status = 0;
     pid_t            wpid;
+    siginfo_t        info;
 
     clixon_debug(CLIXON_DBG_PROC, "");
     if (_proc_entry_list == NULL)
         goto ok;
+    while (1){
+        memset(&info, 0, sizeof(info));
+        if (waitid(P_ALL, 0, &info, WEXITED|WNOHANG|WNOWAIT) < 0 || info.si_pid == 0)
+            goto ok; /* No more exited children */
+        if ((pe = proc_entry_find_pid(info.si_pid)) == NULL)
+            break;   /* Not a known process, traverse all */
+        if ((wpid = waitpid(pe->pe_pid, &status, WNOHANG)) != pe->pe_pid)
+            break;
+        if (proc_entry_reap(h, pe, status) < 0)
+            goto done;
+    }
     if ((pe = _proc_entry_list) != NULL)
         do {
             clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d) %s op:%s",
                          pe->pe_name, pe->pe_pid,
                          clicon_int2str(proc_state_map, pe->pe_state),
                          clicon_int2str(proc_operation_map, pe->pe_operation));
-            if (pe->pe_pid != 0
+            if (pe->pe_pid != 0 && pe->pe_pidfd == -1
                 && (pe->pe_state == PROC_STATE_RUNNING || pe->pe_state == PROC_STATE_EXITING)
                 //      && (pe->pe_operation == PROC_OP_STOP || pe->pe_operation == PROC_OP_RESTART)
                 ){
                 clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s waitpid(%d)",
                              pe->pe_name, pe->pe_pid);
                 if ((wpid = waitpid(pe->pe_pid, &status, WNOHANG)) == pe->pe_pid){
-                    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "waitpid(%d) waited", pe->pe_pid);
-                    pe->pe_exit_status = status;
-                    switch (pe->pe_operation){
-                    case PROC_OP_NONE: /* Spontaneous / External termination */
-                    case PROC_OP_STOP:
-                        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL,
-                                     "%s(%d) %s --%s--> %s",
-                                     pe->pe_name, pe->pe_pid,
-                                     clicon_int2str(proc_state_map, pe->pe_state),
-                                     clicon_int2str(proc_operation_map, pe->pe_operation),
-                                     clicon_int2str(proc_state_map, PROC_STATE_STOPPED)
-                                     );
-                        pe->pe_state = PROC_STATE_STOPPED;
-                        pe->pe_pid = 0;
-                        timerclear(&pe->pe_starttime);
-                        break;
-                    case PROC_OP_RESTART:
-                        /* This is the case where there is an existing process running.
-                         * it was killed above but still runs and needs to be reaped */
-                        if (clixon_proc_background(h, pe->pe_argv, pe->pe_netns,
-                                                   pe->pe_uid, pe->pe_gid, pe->pe_fdkeep,
-                                                   &pe->pe_pid) < 0)
-                            goto done;
-                        gettimeofday(&pe->pe_starttime, NULL);
-                        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d) %s --%s--> %s",
-                                     pe->pe_name, pe->pe_pid,
-                                     clicon_int2str(proc_state_map, pe->pe_state),
-                                     clicon_int2str(proc_operation_map, pe->pe_operation),
-                                     clicon_int2str(proc_state_map, PROC_STATE_RUNNING)
-                                     );
-                        pe->pe_state = PROC_STATE_RUNNING;
-                        gettimeofday(&pe->pe_starttime, NULL);
-                        break;
-                    default:
-                        break;
-                    }
-                    pe->pe_operation = PROC_OP_NONE;
+                    if (proc_entry_reap(h, pe, status) < 0)
+                        goto done;
                     break; /* pid is unique */
                 }
                 else
@@ -56,6 +56,8 @@
 #include <sys/time.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <sys/param.h>
 #include <netinet/in.h>
 #include <sys/un.h>
@@ -81,9 +83,36 @@
 #include "clixon_netconf_input.h"
 #include "clixon_options.h"
 #include "clixon_proto.h"
+#include "clixon_shm.h"
+#include "clixon_stream.h"
 
 static int _atomicio_sig = 0;
 
+/* Coalesced notifications are written when this many bytes are queued, see clixon_msg_outq_coalesce */
+#define MSG_OUTQ_COALESCE_MAX 65536
+
+/*! Output queue of a socket, see clixon_msg_outq_init
+ */
+struct msg_outq {
+    int      oq_s;       /* Socket */
+    cbuf    *oq_cb;      /* Bytes not yet written */
+    size_t   oq_off;     /* Bytes of oq_cb already written */
+    size_t   oq_hiwat;   /* High-water mark in bytes */
+    int      oq_full;    /* Queue has reached high-water mark, call oq_fn when below low-water */
+    int      oq_timer;   /* Drain timer registered */
+    uint32_t oq_coalesce; /* Delay notifications up to this many usecs to write several at once */
+    uint32_t oq_dropped; /* Notifications dropped */
+    int    (*oq_fn)(int, void*); /* Called when queue drains below half of high-water mark */
+    void    *oq_arg;     /* Argument of oq_fn */
+};
+
+/* Output queues indexed by socket */
+static struct msg_outq **_outq = NULL;
+static int _outq_len = 0;
+
+/* Set in threads that write to sockets directly, bypassing output queues */
+static __thread int _outq_bypass = 0;
+
 /*! Given family, addr str, port, return sockaddr and length
  *
  * @param[in]  addrtype  Address family: inet:ipv4-address or inet:ipv6-address
@@ -353,6 +382,74 @@ atomicio(ssize_t (*fn) (int, void *, size_t),
     return (pos);
 }
 
+/*! Ensure all of several buffers are written to socket with one writev(2) per attempt
+ *
+ * As atomicio for write, but the buffers are not copied into one. If the socket is
+ * non-blocking and its send buffer is full, wait until it is writable instead of retrying
+ * at once.
+ * @param[in]  fd      File descriptor, eg socket
+ * @param[in]  iov     Buffers, modified on partial writes
+ * @param[in]  iovcnt  Number of buffers
+ * @retval     n       Bytes written
+ * @retval     0       EOF
+ * @retval    -1       Error
+ */
+static ssize_t
+atomicio_writev(int           fd,
+                struct iovec *iov,
+                int           iovcnt)
+{
+    ssize_t       res;
+    ssize_t       pos = 0;
+    struct pollfd pfd;
+
+    while (iovcnt > 0) {
+        if (iov->iov_len == 0){
+            iov++;
+            iovcnt--;
+            continue;
+        }
+        _atomicio_sig = 0;
+        res = writev(fd, iov, iovcnt);
+        switch (res) {
+        case -1:
+            if (errno == EINTR){
+                if (_atomicio_sig == 0)
+                    continue;
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK){
+                pfd.fd = fd;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+                if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+                    return -1;
+                continue;
+            }
+            else if (errno == ECONNRESET)/* Connection reset by peer */
+                res = 0;
+            else if (errno == EPIPE)     /* Client shutdown */
+                res = 0;
+            else if (errno == EBADF)     /* client shutdown - freebsd */
+                res = 0;
+        case 0: /* fall thru */
+            return (res);
+        default:
+            pos += res;
+            while (res > 0){ /* Skip written bytes */
+                if ((size_t)res < iov->iov_len){
+                    iov->iov_base = (char*)iov->iov_base + res;
+                    iov->iov_len -= res;
+                    break;
+                }
+                res -= iov->iov_len;
+                iov++;
+                iovcnt--;
+            }
+        }
+    }
+    return (pos);
+}
+
 /*! Send a message using NETCONF without encapsulation
  *
  * That is, NETCONF 1.0 / 1.1 encapsulation must have been done
@@ -543,11 +640,415 @@ clixon_rpc10(int         sock,
 
 /*================= NETCONF 1.1 Chunked framing ================*/
 
+/*! Get output queue of socket
+ */
+static struct msg_outq *
+msg_outq_get(int s)
+{
+    if (_outq_bypass || s < 0 || s >= _outq_len)
+        return NULL;
+    return _outq[s];
+}
+
+/*! Bytes in output queue
+ */
+static size_t
+msg_outq_bytes(struct msg_outq *oq)
+{
+    return cbuf_len(oq->oq_cb) - oq->oq_off;
+}
+
+/*! Write as much as possible of buffers to socket without blocking
+ *
+ * @param[in]     s      Socket
+ * @param[in,out] iov    Buffers, modified on partial writes
+ * @param[in,out] iovcnt Number of buffers, modified on partial writes
+ * @retval        n      Bytes written, 0 if socket buffer is full
+ * @retval       -1      Error, eg peer is gone
+ */
+static ssize_t
+msg_outq_writev(int            s,
+                struct iovec **iovp,
+                int           *iovcnt)
+{
+    struct iovec *iov = *iovp;
+    struct msghdr msg = {0,};
+    ssize_t       res;
+    ssize_t       pos = 0;
+
+    while (*iovcnt > 0){
+        if (iov->iov_len == 0){
+            iov++;
+            (*iovcnt)--;
+            continue;
+        }
+        msg.msg_iov = iov;
+        msg.msg_iovlen = *iovcnt;
+        if ((res = sendmsg(s, &msg, MSG_DONTWAIT)) < 0){
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            pos = -1;
+            break;
+        }
+        pos += res;
+        while (res > 0){ /* Skip written bytes */
+            if ((size_t)res < iov->iov_len){
+                iov->iov_base = (char*)iov->iov_base + res;
+                iov->iov_len -= res;
+                break;
+            }
+            res -= iov->iov_len;
+            iov++;
+            (*iovcnt)--;
+        }
+    }
+    *iovp = iov;
+    return pos;
+}
+
+static int msg_outq_drain(int s, void *arg);
+
+/*! Try to write output queue of socket, register a retry if not all is written
+ *
+ * The callback of a queue that has drained is only called from the event loop, not while
+ * sending.
+ * @param[in]  oq     Output queue of socket
+ * @param[in]  timer  Called from drain timer
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+msg_outq_flush(struct msg_outq *oq,
+               int              timer)
+{
+    int            s = oq->oq_s;
+    struct iovec   iov;
+    struct iovec  *iovp = &iov;
+    int            iovcnt = 1;
+    ssize_t        n;
+    struct timeval t;
+    struct timeval tr = {0, 10000}; /* Retry after 10 ms */
+
+    iov.iov_base = cbuf_get(oq->oq_cb) + oq->oq_off;
+    iov.iov_len = msg_outq_bytes(oq);
+    if ((n = msg_outq_writev(s, &iovp, &iovcnt)) < 0){
+        /* Peer gone, drop queue, the peer is removed when eof is read */
+        clixon_debug(CLIXON_DBG_MSG, "Send [%d]: %s, dropping %zu bytes", s, strerror(errno), msg_outq_bytes(oq));
+        n = msg_outq_bytes(oq);
+    }
+    oq->oq_off += n;
+    if (msg_outq_bytes(oq) == 0){
+        cbuf_reset(oq->oq_cb);
+        oq->oq_off = 0;
+    }
+    if (oq->oq_full && msg_outq_bytes(oq) < oq->oq_hiwat/2 && !timer)
+        tr.tv_usec = 0; /* Call fn from event loop, not while sending */
+    if (!oq->oq_timer && (tr.tv_usec == 0 || msg_outq_bytes(oq) > 0)){
+        gettimeofday(&t, NULL);
+        timeradd(&t, &tr, &t);
+        if (clixon_event_reg_timeout(t, msg_outq_drain, (void*)oq, "output queue") < 0)
+            return -1;
+        oq->oq_timer = 1;
+    }
+    if (oq->oq_full && msg_outq_bytes(oq) < oq->oq_hiwat/2 && timer){
+        oq->oq_full = 0;
+        /* Last, fn may free the queue */
+        if (oq->oq_fn && oq->oq_fn(s, oq->oq_arg) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Timer callback: write output queue of socket
+ *
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Output queue
+ */
+static int
+msg_outq_drain(int   fd,
+               void *arg)
+{
+    struct msg_outq *oq = (struct msg_outq *)arg;
+
+    oq->oq_timer = 0;
+    return msg_outq_flush(oq, 1);
+}
+
+/*! Send buffers on socket with output queue, queue what cannot be written now
+ *
+ * Data is appended to the queue if the queue is not empty, to keep order.
+ * A coalesced notification is only appended, and written together with following
+ * notifications by the drain timer, by a reply, or when MSG_OUTQ_COALESCE_MAX is reached
+ * @param[in]  s        Socket
+ * @param[in]  oq       Output queue of socket
+ * @param[in]  iov      Buffers
+ * @param[in]  iovcnt   Number of buffers
+ * @param[in]  coalesce Notification that may be delayed, see clixon_msg_outq_coalesce
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+msg_outq_send(int              s,
+              struct msg_outq *oq,
+              struct iovec    *iov,
+              int              iovcnt,
+              int              coalesce)
+{
+    ssize_t        n;
+    int            i;
+    struct timeval t;
+    struct timeval tc;
+
+    coalesce = coalesce && oq->oq_coalesce;
+    if (msg_outq_bytes(oq) == 0 && !coalesce){
+        if ((n = msg_outq_writev(s, &iov, &iovcnt)) < 0){
+            clixon_err(OE_CFG, errno, "sendmsg");
+            clixon_log(NULL, LOG_WARNING, "%s: write: %s", __func__, strerror(errno));
+            return -1;
+        }
+        if (iovcnt == 0)
+            return 0;
+    }
+    else if (oq->oq_off > cbuf_len(oq->oq_cb)/2){ /* Compact */
+        memmove(cbuf_get(oq->oq_cb), cbuf_get(oq->oq_cb) + oq->oq_off, msg_outq_bytes(oq));
+        cbuf_trunc(oq->oq_cb, msg_outq_bytes(oq));
+        oq->oq_off = 0;
+    }
+    for (i = 0; i < iovcnt; i++)
+        if (cbuf_append_buf(oq->oq_cb, iov[i].iov_base, iov[i].iov_len) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            return -1;
+        }
+    if (oq->oq_hiwat && msg_outq_bytes(oq) >= oq->oq_hiwat)
+        oq->oq_full = 1;
+    if (coalesce && !oq->oq_full && msg_outq_bytes(oq) < MSG_OUTQ_COALESCE_MAX){
+        if (!oq->oq_timer){
+            gettimeofday(&t, NULL);
+            tc.tv_sec = oq->oq_coalesce / 1000000;
+            tc.tv_usec = oq->oq_coalesce % 1000000;
+            timeradd(&t, &tc, &t);
+            if (clixon_event_reg_timeout(t, msg_outq_drain, (void*)oq, "output queue") < 0)
+                return -1;
+            oq->oq_timer = 1;
+        }
+        return 0;
+    }
+    return msg_outq_flush(oq, 0);
+}
+
+/*! Queue output of a socket instead of blocking when the peer does not read
+ *
+ * Messages sent with NETCONF 1.1 framing that cannot be written at once are queued, and
+ * written from the event loop. When the queue reaches the high-water mark, notifications are
+ * dropped and clixon_msg_outq_full returns true. When it drains below half of it, fn is called.
+ * @param[in]  s      Socket
+ * @param[in]  hiwat  High-water mark in bytes, 0 means no limit
+ * @param[in]  fn     Called with socket and arg when queue is below half of hiwat again
+ * @param[in]  arg    Argument of fn
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clixon_msg_outq_free
+ */
+int
+clixon_msg_outq_init(int    s,
+                     size_t hiwat,
+                     int  (*fn)(int, void*),
+                     void  *arg)
+{
+    struct msg_outq  *oq;
+    struct msg_outq **vec;
+    int               len;
+
+    if (s >= _outq_len){
+        len = _outq_len ? _outq_len : 64;
+        while (len <= s)
+            len *= 2;
+        if ((vec = realloc(_outq, len*sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        memset(vec + _outq_len, 0, (len - _outq_len)*sizeof(*vec));
+        _outq = vec;
+        _outq_len = len;
+    }
+    if ((oq = _outq[s]) == NULL){
+        if ((oq = calloc(1, sizeof(*oq))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            return -1;
+        }
+        if ((oq->oq_cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            free(oq);
+            return -1;
+        }
+        oq->oq_s = s;
+        _outq[s] = oq;
+    }
+    oq->oq_hiwat = hiwat;
+    oq->oq_fn = fn;
+    oq->oq_arg = arg;
+    return 0;
+}
+
+/*! Delay notifications on socket to write several of them at once
+ *
+ * Instead of one write per notification, notifications are queued for up to usec microseconds,
+ * or until MSG_OUTQ_COALESCE_MAX bytes are queued or a reply is sent. The output queue of the
+ * socket must be created with clixon_msg_outq_init
+ * @param[in]  s      Socket
+ * @param[in]  usec   Max delay of a notification in microseconds, 0 disables
+ * @retval     0      OK
+ * @retval    -1      Error, no output queue
+ */
+int
+clixon_msg_outq_coalesce(int      s,
+                         uint32_t usec)
+{
+    struct msg_outq *oq;
+
+    if (s < 0 || s >= _outq_len || (oq = _outq[s]) == NULL){
+        clixon_err(OE_UNIX, EINVAL, "No output queue of socket %d", s);
+        return -1;
+    }
+    oq->oq_coalesce = usec;
+    return 0;
+}
+
+/*! Remove output queue of socket, queued data is dropped
+ *
+ * @param[in]  s      Socket
+ * @retval     0      OK
+ */
+int
+clixon_msg_outq_free(int s)
+{
+    struct msg_outq *oq;
+
+    if (s < 0 || s >= _outq_len || (oq = _outq[s]) == NULL)
+        return 0;
+    if (oq->oq_timer)
+        clixon_event_unreg_timeout(msg_outq_drain, (void*)oq);
+    if (oq->oq_dropped)
+        clixon_debug(CLIXON_DBG_MSG, "Send [%d]: %u notifications dropped", s, oq->oq_dropped);
+    cbuf_free(oq->oq_cb);
+    free(oq);
+    _outq[s] = NULL;
+    return 0;
+}
+
+/*! Number of bytes queued for output on socket
+ *
+ * @param[in]  s      Socket
+ * @retval     n      Bytes queued, 0 if no output queue
+ */
+size_t
+clixon_msg_outq_len(int s)
+{
+    struct msg_outq *oq;
+
+    if ((oq = msg_outq_get(s)) == NULL)
+        return 0;
+    return msg_outq_bytes(oq);
+}
+
+/*! Check if output queue of socket has reached its high-water mark
+ *
+ * @param[in]  s      Socket
+ * @retval     1      Yes, the peer should not be read until fn of clixon_msg_outq_init is called
+ * @retval     0      No, or no output queue
+ */
+int
+clixon_msg_outq_full(int s)
+{
+    struct msg_outq *oq;
+
+    if ((oq = msg_outq_get(s)) == NULL)
+        return 0;
+    return oq->oq_full;
+}
+
+/*! Write directly to sockets with output queues in this thread
+ *
+ * Used by threads writing replies while the event loop does not write to the socket
+ * @param[in]  bypass  If set, sends in this thread block instead of using output queues
+ */
+void
+clixon_msg_outq_bypass(int bypass)
+{
+    _outq_bypass = bypass;
+}
+
+/*! Send data as one NETCONF 1.1 chunk, optionally followed by end-of-chunks
+ *
+ * Chunk header, data and trailer are written with one writev, without copying the data
+ * @param[in]  s      socket (unix or inet) to communicate with peer
+ * @param[in]  descr  Description of peer for logging
+ * @param[in]  data   Data, NUL-terminated (for logging)
+ * @param[in]  len    Length of data
+ * @param[in]  eom    If set, end message with end-of-chunks
+ * @param[in]  notify Notification, may be coalesced with following notifications
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+clixon_msg_send11_data(int         s,
+                       const char *descr,
+                       const char *data,
+                       size_t      len,
+                       int         eom,
+                       int         notify)
+{
+    int              retval = -1;
+    char             hdr[32];
+    struct iovec     iov[3];
+    int              n = 0;
+    struct msg_outq *oq;
+    int              ret;
+
+    if (clixon_debug_detail())
+        clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "Send [%s] %s", descr?descr:"", data);
+    else
+        clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_TRUNC, "Send [%s] %s", descr?descr:"", data);
+    snprintf(hdr, sizeof(hdr), "\n#%zu\n", len);
+    iov[n].iov_base = hdr;
+    iov[n++].iov_len = strlen(hdr);
+    iov[n].iov_base = (void*)data;
+    iov[n++].iov_len = len;
+    if (eom){
+        iov[n].iov_base = "\n##\n"; /* RFC6242 chunked-end */
+        iov[n++].iov_len = strlen("\n##\n");
+    }
+    if ((ret = clixon_shm_writev(s, iov, n)) < 0){
+        clixon_err(OE_CFG, errno, "clixon_shm_writev");
+        goto done;
+    }
+    if (ret == 1) /* Shared memory channel, see CLICON_IPC_SHM */
+        goto ok;
+    if ((oq = msg_outq_get(s)) != NULL){
+        if (msg_outq_send(s, oq, iov, n, notify) < 0)
+            goto done;
+    }
+    else if (atomicio_writev(s, iov, n) < 0){
+        clixon_err(OE_CFG, errno, "atomicio");
+        clixon_log(NULL, LOG_WARNING, "%s: write: %s", __func__, strerror(errno));
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Send a message using NETCONF 1.1 w chunked framing
  *
+ * The message is sent as one chunk, the buffer is not modified
  * @param[in]  s      socket (unix or inet) to communicate with backend
  * @param[in]  descr  Description of peer for logging
- * @param[out] msg    Outgoing Cbuf
+ * @param[in]  msg    Outgoing Cbuf
+ * @retval     0      OK
+ * @retval    -1      Error
  * @see clixon_msg_send10  1.0 EOM
  * @see clixon_msg_send    No encapsulation
  */
@@ -556,14 +1057,36 @@ clixon_msg_send11(int         s,
                   const char *descr,
                   cbuf       *msg)
 {
-    int retval = -1;
+    return clixon_msg_send11_data(s, descr, cbuf_get(msg), cbuf_len(msg), 1, 0);
+}
 
-    if (netconf_output_encap(NETCONF_SSH_CHUNKED, msg) < 0)
-        goto done;
-    if (clixon_msg_send(s, descr, msg) < 0)
+/*! Send a part of a message as one NETCONF 1.1 chunk without end-of-chunks
+ *
+ * Used to write a large message in several chunks while it is created. The message is
+ * terminated by a last call to clixon_msg_send11 (or send_msg_reply) with the remainder.
+ * The buffer is reset after sending. Nothing is sent if the buffer is empty.
+ * @param[in]     s      socket (unix or inet) to communicate with backend
+ * @param[in]     descr  Description of peer for logging
+ * @param[in,out] cb     Part of outgoing message, reset on return
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @see clixon_msg_send11
+ */
+int
+clixon_msg_send11_chunk(int         s,
+                        const char *descr,
+                        cbuf       *cb)
+{
+    int    retval = -1;
+
+    if (cbuf_len(cb) == 0)
+        goto ok;
+    if (clixon_msg_send11_data(s, descr, cbuf_get(cb), cbuf_len(cb), 0, 0) < 0)
         goto done;
+    cbuf_reset(cb);
+ ok:
     retval = 0;
-  done:
+ done:
     return retval;
 }
 
@@ -573,6 +1096,32 @@ atomicio_sig_handler(int arg)
     _atomicio_sig++;
 }
 
+/*! Read NETCONF input from the shared memory channel of a socket, or from the socket
+ *
+ * @param[in]  s      Socket
+ * @param[in]  buf    Buffer
+ * @param[in]  buflen Length of buffer
+ * @param[out] eof    Set if eof encountered
+ * @retval     len    Bytes read
+ * @retval    -1      Error
+ * @see CLICON_IPC_SHM
+ */
+static ssize_t
+msg_input_read(int            s,
+               unsigned char *buf,
+               ssize_t        buflen,
+               int           *eof)
+{
+    ssize_t len = 0;
+    int     ret;
+
+    if ((ret = clixon_shm_read(s, buf, buflen, &len, eof)) < 0)
+        return -1;
+    if (ret == 0)
+        return netconf_input_read2(s, buf, buflen, eof);
+    return len;
+}
+
 /*! Receive a message using unified NETCONF w chunked framing
  *
  * @param[in]   s      socket (unix or inet) to communicate with backend
@@ -593,7 +1142,11 @@ clixon_msg_rcv11(int         s,
                  int        *eof)
 {
     int              retval = -1;
+#ifdef NETCONF_INPUT_BUFSIZ
+    unsigned char    buf[NETCONF_INPUT_BUFSIZ];
+#else
     unsigned char    buf[BUFSIZ];
+#endif
     ssize_t          buflen = sizeof(buf);
     int              frame_state = 0;
     size_t           frame_size = 0;
@@ -624,7 +1177,7 @@ clixon_msg_rcv11(int         s,
     }
     while (*eof == 0 && eom == 0) {
         /* Read input data from socket and append to cbbuf */
-        if ((len = netconf_input_read2(s, buf, buflen, eof)) < 0)
+        if ((len = msg_input_read(s, buf, buflen, eof)) < 0)
             goto done;
         p = buf;
         plen = len;
@@ -685,6 +1238,231 @@ clixon_msg_rcv11(int         s,
     return retval;
 }
 
+/*! Receive state of a socket where several NETCONF 1.1 messages may be in flight
+ *
+ * Bytes read after the end of a message are kept for the next message
+ */
+struct clixon_msg_pipe{
+    cbuf          *mp_msg;         /* Message being received */
+    int            mp_frame_state; /* Chunked framing state */
+    size_t         mp_frame_size;  /* Chunked framing size */
+#ifdef NETCONF_INPUT_BUFSIZ
+    unsigned char  mp_buf[NETCONF_INPUT_BUFSIZ]; /* Bytes read from socket */
+#else
+    unsigned char  mp_buf[BUFSIZ]; /* Bytes read from socket */
+#endif
+    size_t         mp_len;         /* Bytes in mp_buf */
+    size_t         mp_off;         /* Bytes of mp_buf consumed */
+};
+
+/*! Create receive state of a socket with several messages in flight
+ *
+ * @retval     mp    Receive state, free with clixon_msg_pipe_free
+ * @retval     NULL  Error
+ * @see clixon_msg_rcv11_pipe
+ */
+clixon_msg_pipe *
+clixon_msg_pipe_new(void)
+{
+    clixon_msg_pipe *mp;
+
+    if ((mp = calloc(1, sizeof(*mp))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    if ((mp->mp_msg = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        free(mp);
+        return NULL;
+    }
+    return mp;
+}
+
+/*! Free receive state
+ *
+ * @param[in]  mp    Receive state
+ */
+int
+clixon_msg_pipe_free(clixon_msg_pipe *mp)
+{
+    if (mp->mp_msg)
+        cbuf_free(mp->mp_msg);
+    free(mp);
+    return 0;
+}
+
+/*! Check if bytes of a next message have been read but not received
+ *
+ * @param[in]  mp    Receive state
+ * @retval     1     Yes, clixon_msg_rcv11_pipe may return a message without reading socket
+ * @retval     0     No
+ */
+int
+clixon_msg_pipe_pending(clixon_msg_pipe *mp)
+{
+    return mp->mp_off < mp->mp_len;
+}
+
+/*! Return allocated size of receive state, including message being received
+ *
+ * @param[in]  mp    Receive state
+ * @retval     sz    Size in bytes
+ */
+size_t
+clixon_msg_pipe_size(clixon_msg_pipe *mp)
+{
+    size_t sz = sizeof(*mp);
+
+    if (mp->mp_msg)
+        sz += cbuf_buflen(mp->mp_msg);
+    return sz;
+}
+
+/*! Receive a message using NETCONF 1.1 chunked framing, keep bytes of next messages
+ *
+ * As clixon_msg_rcv11 but bytes read after the end of the message are kept in the
+ * receive state, so that a peer may send several messages without waiting for replies.
+ * @param[in]     s      Socket (unix or inet) to communicate with peer
+ * @param[in]     descr  Description of peer for logging
+ * @param[in,out] mp     Receive state of socket
+ * @param[out]    msg    Incoming message, created
+ * @param[out]    eof    Set if eof encountered
+ * @retval        0      OK (check eof)
+ * @retval       -1      Error
+ * @see clixon_msg_rcv11
+ */
+int
+clixon_msg_rcv11_pipe(int              s,
+                      const char      *descr,
+                      clixon_msg_pipe *mp,
+                      cbuf           **msg,
+                      int             *eof)
+{
+    int            retval = -1;
+    unsigned char *p;
+    size_t         plen;
+    ssize_t        len;
+    int            eom = 0;
+
+    *eof = 0;
+    while (eom == 0){
+        if (mp->mp_off == mp->mp_len){
+            if ((len = msg_input_read(s, mp->mp_buf, sizeof(mp->mp_buf), eof)) < 0)
+                goto done;
+            mp->mp_len = len;
+            mp->mp_off = 0;
+            if (*eof)
+                break;
+        }
+        p = mp->mp_buf + mp->mp_off;
+        plen = mp->mp_len - mp->mp_off;
+        if (netconf_input_msg2(&p, &plen, mp->mp_msg, NETCONF_SSH_CHUNKED,
+                               &mp->mp_frame_state, &mp->mp_frame_size, &eom) < 0){
+            /* Errors from input are only framing errors, non-fatal, return eof */
+            *eof = 1;
+            break;
+        }
+        mp->mp_off = mp->mp_len - plen;
+    }
+    if (*eof){
+        clixon_debug(CLIXON_DBG_MSG, "Recv [%s]: EOF", descr?descr:"");
+        cbuf_reset(mp->mp_msg);
+        mp->mp_frame_state = 0;
+        mp->mp_frame_size = 0;
+        mp->mp_len = mp->mp_off = 0;
+    }
+    else {
+        clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_TRUNC, "Recv [%s]: %s", descr?descr:"", cbuf_get(mp->mp_msg));
+        if (msg){
+            *msg = mp->mp_msg;
+            if ((mp->mp_msg = cbuf_new()) == NULL){
+                clixon_err(OE_XML, errno, "cbuf_new");
+                goto done;
+            }
+        }
+        else
+            cbuf_reset(mp->mp_msg);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Receive a message using NETCONF 1.1 chunked framing as a stream of parts
+ *
+ * As clixon_msg_rcv11 but the message is not accumulated. The data of each read from the
+ * socket is passed to a callback as it arrives, so that a large message can be forwarded
+ * without holding all of it in memory.
+ * The callback is called with eom set for the last part, which may be empty.
+ * @param[in]  s      Socket (unix or inet) to communicate with peer
+ * @param[in]  descr  Description of peer for logging
+ * @param[in]  fn     Callback with each part of the message
+ * @param[in]  arg    Argument to callback
+ * @param[out] eof    Set if eof encountered
+ * @retval     0      OK (check eof)
+ * @retval    -1      Error, also if callback returns error
+ * @see clixon_msg_rcv11
+ */
+int
+clixon_msg_rcv11_stream(int                   s,
+                        const char           *descr,
+                        clixon_msg_stream_fn *fn,
+                        void                 *arg,
+                        int                  *eof)
+{
+    int            retval = -1;
+#ifdef NETCONF_INPUT_BUFSIZ
+    unsigned char  buf[NETCONF_INPUT_BUFSIZ];
+#else
+    unsigned char  buf[BUFSIZ];
+#endif
+    int            frame_state = 0;
+    size_t         frame_size = 0;
+    unsigned char *p;
+    size_t         plen;
+    ssize_t        len;
+    cbuf          *cbpart = NULL;
+    size_t         total = 0;
+    int            eom = 0;
+
+    *eof = 0;
+    if ((cbpart = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    while (*eof == 0 && eom == 0) {
+        if ((len = msg_input_read(s, buf, sizeof(buf), eof)) < 0)
+            goto done;
+        p = buf;
+        plen = len;
+        while (!(*eof) && eom == 0 && plen > 0){
+            if (netconf_input_msg2(&p, &plen, cbpart, NETCONF_SSH_CHUNKED,
+                                   &frame_state, &frame_size, &eom) < 0){
+                /* Errors from input are only framing errors, non-fatal, return eof */
+                *eof = 1;
+                break;
+            }
+        }
+        if (*eof)
+            break;
+        if (cbuf_len(cbpart) || eom){
+            total += cbuf_len(cbpart);
+            if (fn(arg, cbuf_get(cbpart), cbuf_len(cbpart), eom) < 0)
+                goto done;
+            cbuf_reset(cbpart);
+        }
+    }
+    if (*eof)
+        clixon_debug(CLIXON_DBG_MSG, "Recv [%s]: EOF", descr?descr:"");
+    else
+        clixon_debug(CLIXON_DBG_MSG, "Recv [%s]: %zu bytes streamed", descr?descr:"", total);
+    retval = 0;
+ done:
+    if (cbpart)
+        cbuf_free(cbpart);
+    return retval;
+}
+
 /*! Send a netconf message and recieve result using NETCONF 1.1 framing
  *
  * This is mainly used by the client API.
@@ -732,24 +1510,8 @@ send_msg_reply(int         s,
                char       *data,
                uint32_t    datalen)
 {
-    int                retval = -1;
-    cbuf          *cb = NULL;
-
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    if (cbuf_append_buf(cb, data, datalen) < 0){
-        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
-        goto done;
-    }
-    if (clixon_msg_send11(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+    /* datalen may include the terminating NUL */
+    return clixon_msg_send11_data(s, descr, data, strnlen(data, datalen), 1, 0);
 }
 
 /*! Send a NETCONF NOTIFY message asynchronously to client
@@ -766,21 +1528,14 @@ send_msg_notify(int         s,
                 const char *descr,
                 char       *msg)
 {
-    int   retval = -1;
-    cbuf *cb = NULL;
+    struct msg_outq *oq;
 
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
+    /* Drop notifications to a peer that does not read */
+    if ((oq = msg_outq_get(s)) != NULL && oq->oq_full){
+        oq->oq_dropped++;
+        return 0;
     }
-    cprintf(cb, "%s", msg);
-    if (clixon_msg_send11(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+    return clixon_msg_send11_data(s, descr, msg, strlen(msg), 1, 1);
 }
 
 /*! Send NETCONF XML NOTIFY message asynchronously to client
@@ -801,7 +1556,16 @@ send_msg_notify_xml(clixon_handle h,
 {
     int   retval = -1;
     cbuf *cb = NULL;
+    cbuf *cbev = NULL;
 
+    /* Serialized once for all subscribers if xev is being distributed by stream_notify */
+    if (stream_event_cbuf(h, xev, &cbev) < 0)
+        goto done;
+    if (cbev != NULL){
+        if (send_msg_notify(s, descr, cbuf_get(cbev)) < 0)
+            goto done;
+        goto ok;
+    }
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_PLUGIN, errno, "cbuf_new");
         goto done;
@@ -810,6 +1574,7 @@ send_msg_notify_xml(clixon_handle h,
         goto done;
     if (send_msg_notify(s, descr, cbuf_get(cb)) < 0)
         goto done;
+ ok:
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "retval:%d", retval);
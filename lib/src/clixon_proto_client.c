@@ -53,6 +53,7 @@
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <sys/syslog.h>
+#include <time.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -84,16 +85,28 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_io.h"
 #include "clixon_proto_client.h"
+#include "clixon_shm.h"
+#include "clixon_event_profile.h"
+#include "clixon_trace.h"
 
 #define PERSIST_ID_XML_FMT "<persist-id>%s</persist-id>"
 #define PERSIST_XML_FMT "<persist>%s</persist>"
 #define TIMEOUT_XML_FMT "<confirm-timeout>%u</confirm-timeout>"
 
+/*! Create hello message to backend
+ *
+ * @param[in]  h           Clixon handle
+ * @param[out] cb          Hello message
+ * @param[in]  transport   RFC 6022 transport, or NULL
+ * @param[in]  source_host RFC 6022 source-host, or NULL
+ * @param[in]  shm         Request shared memory transport, see CLICON_IPC_SHM
+ */
 static int
 create_hello(clixon_handle h,
              cbuf         *cb,
              char         *transport,
-             char         *source_host)
+             char         *source_host,
+             int           shm)
 {
     char  *username;
     int    clixon_lib = 0;
@@ -123,8 +136,12 @@ create_hello(clixon_handle h,
     if (clixon_lib)
         cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
     cprintf(cb, ">");
-    cprintf(cb, "<capabilities><capability>%s</capability></capabilities>",
-            NETCONF_BASE_CAPABILITY_1_1);
+    cprintf(cb, "<capabilities><capability>%s</capability>", NETCONF_BASE_CAPABILITY_1_1);
+    if (clicon_option_slot_bool(h, OS_IPC_BINARY))
+        cprintf(cb, "<capability>%s</capability>", CLIXON_IPC_BINARY_CAPABILITY);
+    if (shm)
+        cprintf(cb, "<capability>%s</capability>", CLIXON_IPC_SHM_CAPABILITY);
+    cprintf(cb, "</capabilities>");
     cprintf(cb, "</hello>");
     return 0;
 }
@@ -158,6 +175,31 @@ parse_hello(clixon_handle h,
     return retval;
 }
 
+/*! Parse reply from backend, binary XML or text
+ *
+ * @param[in]   cbrcv  Reply message
+ * @param[out]  xret   Reply as xml tree. Free w xml_free
+ * @retval      0      OK
+ * @retval     -1      Error
+ */
+static int
+rpc_reply_parse(cbuf   *cbrcv,
+                cxobj **xret)
+{
+    int ret;
+
+    if (cbrcv && cbuf_get(cbrcv)){
+        /* Binary XML reply if negotiated in hello, see CLICON_IPC_BINARY */
+        if ((ret = clixon_xml_parse_bin(cbuf_get(cbrcv), cbuf_len(cbrcv), xret)) < 0)
+            return -1;
+        /* NONE: Cannot bind yang, need to know RPC name (eg "lock") */
+        if (ret == 0 &&
+            clixon_xml_parse_string(cbuf_get(cbrcv), YB_NONE, NULL, xret, NULL) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 /*! Send internal netconf rpc from client to backend, opt return new socket
  *
  * Some complexity in trying to restart socket if (cached) returns eof
@@ -197,11 +239,8 @@ clixon_rpc_msg2(clixon_handle h,
     }
     if (eof)
         goto eof;
-    if (cbrcv && cbuf_get(cbrcv)){
-        /* NONE: Cannot bind yang, need to know RPC name (eg "lock") */
-        if (clixon_xml_parse_string(cbuf_get(cbrcv), YB_NONE, NULL, &xret, NULL) < 0)
-            goto done;
-    }
+    if (rpc_reply_parse(cbrcv, &xret) < 0)
+        goto done;
     if (xret0){
         *xret0 = xret;
         xret = NULL;
@@ -219,6 +258,304 @@ clixon_rpc_msg2(clixon_handle h,
     goto done;
 }
 
+/*! Reply of a pipelined rpc received before it was asked for
+ */
+struct rpc_reply {
+    struct rpc_reply *rr_next;
+    uint32_t          rr_id;   /* Id returned by clicon_rpc_msg_send */
+    cxobj            *rr_xret; /* Reply */
+};
+
+/*! Rpcs in flight on the cached backend socket, see clicon_rpc_msg_send
+ *
+ * The backend replies to rpcs of a session in the order they were sent, a reply is
+ * therefore matched to its rpc by sequence number
+ */
+struct rpc_pipe {
+    int               rp_s;       /* Socket, state is reset if cached socket changes */
+    clixon_msg_pipe  *rp_mp;      /* Receive state of socket */
+    uint32_t          rp_sent;    /* Id of last rpc sent */
+    uint32_t          rp_rcvd;    /* Id of last reply received */
+    struct rpc_reply *rp_replies; /* Replies received but not yet asked for */
+};
+
+/*! Free rpcs in flight state
+ *
+ * @param[in]   rp     Rpcs in flight state
+ */
+static int
+rpc_pipe_free1(struct rpc_pipe *rp)
+{
+    struct rpc_reply *rr;
+
+    while ((rr = rp->rp_replies) != NULL){
+        rp->rp_replies = rr->rr_next;
+        if (rr->rr_xret)
+            xml_free(rr->rr_xret);
+        free(rr);
+    }
+    if (rp->rp_mp)
+        clixon_msg_pipe_free(rp->rp_mp);
+    free(rp);
+    return 0;
+}
+
+/*! Free rpcs in flight state of handle
+ *
+ * @param[in]   h      Clixon handle
+ */
+static int
+rpc_pipe_free(clixon_handle h)
+{
+    struct rpc_pipe  *rp = NULL;
+
+    if (clicon_ptr_get(h, "rpc-pipe", (void**)&rp) < 0 || rp == NULL)
+        return 0;
+    rpc_pipe_free1(rp);
+    clicon_ptr_del(h, "rpc-pipe");
+    return 0;
+}
+
+/*! Get rpcs in flight state of socket, create or reset if socket is new
+ *
+ * @param[in]   h      Clixon handle
+ * @param[in]   s      Cached backend socket
+ * @retval      rp     State
+ * @retval      NULL   Error
+ */
+static struct rpc_pipe *
+rpc_pipe_get(clixon_handle h,
+             int           s)
+{
+    struct rpc_pipe *rp = NULL;
+
+    if (clicon_ptr_get(h, "rpc-pipe", (void**)&rp) == 0 && rp != NULL){
+        if (rp->rp_s == s)
+            return rp;
+        rpc_pipe_free(h);
+    }
+    if ((rp = calloc(1, sizeof(*rp))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    rp->rp_s = s;
+    if ((rp->rp_mp = clixon_msg_pipe_new()) == NULL){
+        free(rp);
+        return NULL;
+    }
+    if (clicon_ptr_set(h, "rpc-pipe", rp) < 0){
+        clixon_msg_pipe_free(rp->rp_mp);
+        free(rp);
+        return NULL;
+    }
+    return rp;
+}
+
+/*! Receive next reply of rpcs in flight
+ *
+ * @param[in]   h      Clixon handle
+ * @param[in]   rp     Rpcs in flight state
+ * @param[out]  xret   Reply as xml tree. Free w xml_free
+ * @retval      0      OK
+ * @retval     -1      Error, including EOF
+ */
+static int
+rpc_pipe_rcv(clixon_handle    h,
+             struct rpc_pipe *rp,
+             cxobj          **xret)
+{
+    int   retval = -1;
+    cbuf *cbrcv = NULL;
+    int   eof = 0;
+
+    if (clixon_msg_rcv11_pipe(rp->rp_s, clicon_sock_str(h), rp->rp_mp, &cbrcv, &eof) < 0)
+        goto done;
+    if (eof){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+        goto done;
+    }
+    rp->rp_rcvd++;
+    if (rpc_reply_parse(cbrcv, xret) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cbrcv)
+        cbuf_free(cbrcv);
+    return retval;
+}
+
+/*! Receive all replies of rpcs in flight and keep them for clicon_rpc_msg_recv
+ *
+ * Done before a synchronous rpc on the same socket
+ * @param[in]   h      Clixon handle
+ * @param[in]   s      Cached backend socket
+ * @retval      0      OK
+ * @retval     -1      Error
+ */
+static int
+rpc_pipe_drain(clixon_handle h,
+               int           s)
+{
+    struct rpc_pipe  *rp = NULL;
+    struct rpc_reply *rr;
+
+    if (clicon_ptr_get(h, "rpc-pipe", (void**)&rp) < 0 || rp == NULL || rp->rp_s != s)
+        return 0;
+    while (rp->rp_rcvd < rp->rp_sent){
+        if ((rr = calloc(1, sizeof(*rr))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            return -1;
+        }
+        if (rpc_pipe_rcv(h, rp, &rr->rr_xret) < 0){
+            free(rr);
+            return -1;
+        }
+        rr->rr_id = rp->rp_rcvd;
+        rr->rr_next = rp->rp_replies;
+        rp->rp_replies = rr;
+    }
+    return 0;
+}
+
+/*! Close a session socket to backend, and its shared memory channel if any
+ *
+ * @param[in]   s      Socket
+ */
+static void
+rpc_session_close(int s)
+{
+    clixon_shm_close(s);
+    close(s);
+}
+
+/*! Connect to backend and open a session with hello
+ *
+ * If CLICON_IPC_SHM is set and the backend accepts, messages of the session are then
+ * sent in shared memory
+ * @param[in]   h      Clixon handle
+ * @param[out]  sp     Socket
+ * @retval      0      OK
+ * @retval     -1      Error
+ */
+static int
+rpc_session_open(clixon_handle h,
+                 int          *sp)
+{
+    int      retval = -1;
+    int      s = -1;
+    cbuf    *cb = NULL;
+    cxobj   *xret = NULL;
+    uint32_t id;
+    int      shm;
+    int      ret;
+
+    if (clixon_rpc_connect(h, &s) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    shm = clicon_sock_family(h) == AF_UNIX &&
+        clicon_option_slot_bool(h, OS_IPC_SHM) &&
+        clixon_shm_supported();
+    if (create_hello(h, cb, NULL, NULL, shm) < 0)
+        goto done;
+    if ((ret = clixon_rpc_msg2(h, cb, s, &xret)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_PROTO, ESHUTDOWN, "NETCONF Hello to backend failed with EOF.");
+        goto done;
+    }
+    if (parse_hello(h, xret, &id) < 0)
+        goto done;
+    /* Backend accepts shared memory transport */
+    if (shm &&
+        xpath_first(xret, NULL, "hello/capabilities[capability='%s']", CLIXON_IPC_SHM_CAPABILITY) != NULL &&
+        clixon_shm_connect(s) < 0)
+        goto done;
+    *sp = s;
+    s = -1;
+    retval = 0;
+ done:
+    if (s >= 0)
+        rpc_session_close(s);
+    if (xret)
+        xml_free(xret);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Get name of rpc in a message without parsing it, for the event profile
+ *
+ * Name is the local name of the first element in <rpc>, or "rpc" if not found
+ * @param[in]  cb    NETCONF message buffer, eg <rpc ...><get-config>...
+ * @param[out] name  Rpc name
+ * @param[in]  len   Length of name buffer
+ */
+static void
+rpc_msg_name(cbuf  *cb,
+             char  *name,
+             size_t len)
+{
+    char  *p;
+    char  *p1;
+    size_t n;
+
+    strncpy(name, "rpc", len-1);
+    name[len-1] = '\0';
+    if ((p = strstr(cbuf_get(cb), "<rpc")) == NULL ||
+        (p = strchr(p, '>')) == NULL ||
+        (p = strchr(p, '<')) == NULL)
+        return;
+    p++;
+    n = strcspn(p, " \t\r\n/>");
+    if ((p1 = memchr(p, ':', n)) != NULL){
+        n -= p1 + 1 - p;
+        p = p1 + 1;
+    }
+    if (n == 0 || *p == '/')
+        return;
+    if (n >= len)
+        n = len - 1;
+    memcpy(name, p, n);
+    name[n] = '\0';
+}
+
+/*! Add the trace context of the active trace to an internal rpc
+ *
+ * The traceparent is added as an attribute of <rpc> which the backend uses as parent
+ * of its spans, see clixon_trace_start
+ * @param[in]  cb    NETCONF message buffer, eg <rpc ...><get-config>...
+ * @param[out] cbtr  New message with traceparent attribute, or NULL if no active trace
+ *                   or not an rpc. Free with cbuf_free
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+rpc_msg_trace(cbuf  *cb,
+              cbuf **cbtr)
+{
+    char *str;
+
+    *cbtr = NULL;
+    if (!clixon_trace_active())
+        return 0;
+    str = cbuf_get(cb);
+    if (strncmp(str, "<rpc", 4) != 0 ||
+        (str[4] != ' ' && str[4] != '>'))
+        return 0;
+    if ((*cbtr = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        return -1;
+    }
+    cprintf(*cbtr, "<rpc xmlns:%s=\"%s\" %s:%s=\"",
+            CLIXON_TRACE_PREFIX, CLIXON_LIB_NS, CLIXON_TRACE_PREFIX, CLIXON_TRACE_ATTR);
+    clixon_trace_traceparent(*cbtr);
+    cprintf(*cbtr, "\"%s", str+4);
+    return 0;
+}
+
 /*! Send internal netconf rpc from client to backend
  *
  * @param[in]    h      Clixon handle
@@ -234,68 +571,62 @@ clicon_rpc_msg(clixon_handle h,
                cbuf         *cbsend,
                cxobj       **xret0)
 {
-    int      retval = -1;
-    int      s = -1;
-    cbuf    *cb = NULL;
-    cbuf    *cbrcv = NULL;
-    cxobj   *xret = NULL;
-    uint32_t id;
-    int      cached = 1;
-    int      ret;
-
+    int             retval = -1;
+    int             s = -1;
+    cbuf           *cbrcv = NULL;
+    int             cached = 1;
+    int             ret;
+    int             prof;
+    struct timespec t0;
+    char            name[64];
+    cbuf           *cbtr = NULL;
+
+    /* Round-trip time per rpc name */
+    if ((prof = event_profile_enabled()) != 0)
+        event_profile_start(&t0);
     if ((s = clicon_client_socket_get(h)) < 0){
         cached = 0;
-        if (clixon_rpc_connect(h, &s) < 0)
-            goto done;
-        if ((cb = cbuf_new()) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-        if (create_hello(h, cb, NULL, NULL) < 0)
-            goto done;
-        if ((ret = clixon_rpc_msg2(h, cb, s, &xret)) < 0){
-            close(s); s = -1;
-            goto done;
-        }
-        if (ret == 0){
-            clixon_err(OE_PROTO, ESHUTDOWN, "NETCONF Hello to backend failed with EOF.");
-            close(s); s = -1;
-            goto done;
-        }
-        if (parse_hello(h, xret, &id) < 0)
+        if (rpc_session_open(h, &s) < 0)
             goto done;
     }
+    /* Replies of pipelined rpcs come before the reply of this rpc */
+    else if (rpc_pipe_drain(h, s) < 0){
+        rpc_session_close(s); s = -1;
+        goto done;
+    }
+    /* Propagate active trace to backend */
+    if (rpc_msg_trace(cbsend, &cbtr) < 0)
+        goto done;
+    if (cbtr)
+        cbsend = cbtr;
     if ((ret = clixon_rpc_msg2(h, cbsend, s, xret0)) < 0){
-        close(s); s = -1;
+        rpc_session_close(s); s = -1;
         goto done;
     }
     if (ret == 0){
-        close(s); s = -1;
+        rpc_session_close(s); s = -1;
+        rpc_pipe_free(h); /* Replies in flight are lost */
 #ifdef PROTO_RESTART_RECONNECT
         if (cached && !clixon_exit_get()){ /* try again */
             int eof = 0;
 
             if (clixon_rpc_connect(h, &s) < 0) /* Create socket */
                 goto done;
-            /* Second time do not encapsulate by not calling the 11 fn */
-            if (clixon_msg_send(s, clicon_sock_str(h), cbsend) < 0){
-                close(s); s = -1;
+            if (clixon_msg_send11(s, clicon_sock_str(h), cbsend) < 0){
+                rpc_session_close(s); s = -1;
                 goto done;
             }
             if (clixon_msg_rcv11(s, clicon_sock_str(h), 0, &cbrcv, &eof) < 0){
-                close(s); s = -1;
+                rpc_session_close(s); s = -1;
                 goto done;
             }
             if (eof == 1){
                 clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
-                close(s); s = -1;
+                rpc_session_close(s); s = -1;
                 goto done;
             }
-            if (cbrcv && cbuf_get(cbrcv)){
-                /* NONE: Cannot bind yang, need to know RPC name (eg "lock") */
-                if (clixon_xml_parse_string(cbuf_get(cbrcv), YB_NONE, NULL, xret0, NULL) < 0)
-                    goto done;
-            }
+            if (rpc_reply_parse(cbrcv, xret0) < 0)
+                goto done;
         }
         else
 #endif
@@ -304,18 +635,307 @@ clicon_rpc_msg(clixon_handle h,
                 goto done;
             }
     }
+    if (prof){
+        rpc_msg_name(cbsend, name, sizeof(name));
+        if (event_profile_add(EP_RPC, name, event_profile_usec(&t0)) < 0)
+            goto done;
+    }
     retval = 0;
  done:
+    if (s < 0)
+        rpc_pipe_free(h);
     clicon_client_socket_set(h, s);
-    if (xret)
-        xml_free(xret);
-    if (cb)
-        cbuf_free(cb);
     if (cbrcv)
         cbuf_free(cbrcv);
+    if (cbtr)
+        cbuf_free(cbtr);
     return retval;
 }
 
+/*! Send internal netconf rpc from client to backend without waiting for reply
+ *
+ * Several rpcs may be in flight on the cached backend socket. Receive the reply with
+ * clicon_rpc_msg_recv using the returned id. Replies may be received in any order.
+ * @param[in]    h      Clixon handle
+ * @param[in]    cbsend NETCONF Message buffer
+ * @param[out]   idp    Id of rpc, used in clicon_rpc_msg_recv
+ * @retval       0      OK
+ * @retval      -1      Error
+ * @note Replies not received are lost if the cached socket is closed or reconnected
+ * @see clicon_rpc_msg   Synchronous rpc, replies of rpcs in flight are kept
+ */
+int
+clicon_rpc_msg_send(clixon_handle h,
+                    cbuf         *cbsend,
+                    uint32_t     *idp)
+{
+    int              retval = -1;
+    int              s;
+    struct rpc_pipe *rp;
+    cbuf            *cbtr = NULL;
+
+    if ((s = clicon_client_socket_get(h)) < 0){
+        if (rpc_session_open(h, &s) < 0)
+            goto done;
+        clicon_client_socket_set(h, s);
+    }
+    if ((rp = rpc_pipe_get(h, s)) == NULL)
+        goto done;
+    if (rpc_msg_trace(cbsend, &cbtr) < 0)
+        goto done;
+    if (clixon_msg_send11(s, clicon_sock_str(h), cbtr?cbtr:cbsend) < 0){
+        rpc_pipe_free(h);
+        rpc_session_close(s);
+        clicon_client_socket_set(h, -1);
+        goto done;
+    }
+    *idp = ++rp->rp_sent;
+    retval = 0;
+ done:
+    if (cbtr)
+        cbuf_free(cbtr);
+    return retval;
+}
+
+/*! Receive reply of an rpc sent with clicon_rpc_msg_send
+ *
+ * Replies of rpcs sent before this one are received and kept if not already received
+ * @param[in]    h      Clixon handle
+ * @param[in]    id     Id of rpc from clicon_rpc_msg_send
+ * @param[out]   xret   Reply from backend as xml tree. Free w xml_free
+ * @retval       0      OK
+ * @retval      -1      Error
+ */
+int
+clicon_rpc_msg_recv(clixon_handle h,
+                    uint32_t      id,
+                    cxobj       **xret)
+{
+    int                retval = -1;
+    int                s;
+    struct rpc_pipe   *rp = NULL;
+    struct rpc_reply **rrp;
+    struct rpc_reply  *rr;
+    cxobj             *x = NULL;
+
+    s = clicon_client_socket_get(h);
+    if (clicon_ptr_get(h, "rpc-pipe", (void**)&rp) < 0 || rp == NULL || rp->rp_s != s ||
+        id == 0 || id > rp->rp_sent){
+        clixon_err(OE_PROTO, EINVAL, "No rpc %u in flight", id);
+        goto done;
+    }
+    for (rrp = &rp->rp_replies; (rr = *rrp) != NULL; rrp = &rr->rr_next)
+        if (rr->rr_id == id)
+            break;
+    if (rr != NULL){
+        *rrp = rr->rr_next;
+        *xret = rr->rr_xret;
+        free(rr);
+        goto ok;
+    }
+    if (id <= rp->rp_rcvd){
+        clixon_err(OE_PROTO, EINVAL, "Reply of rpc %u already received", id);
+        goto done;
+    }
+    while (rp->rp_rcvd < id){
+        if (rpc_pipe_rcv(h, rp, &x) < 0){
+            rpc_pipe_free(h);
+            rpc_session_close(s);
+            clicon_client_socket_set(h, -1);
+            goto done;
+        }
+        if (rp->rp_rcvd == id)
+            break;
+        if ((rr = calloc(1, sizeof(*rr))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        rr->rr_id = rp->rp_rcvd;
+        rr->rr_xret = x;
+        x = NULL;
+        rr->rr_next = rp->rp_replies;
+        rp->rp_replies = rr;
+    }
+    *xret = x;
+    x = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (x)
+        xml_free(x);
+    return retval;
+}
+
+/*! Session of a pool of backend sessions
+ */
+struct client_pool_session {
+    int              ps_s;      /* Backend socket, -1 if not connected */
+    struct rpc_pipe *ps_pipe;   /* Rpcs in flight on socket, if not current session */
+    int              ps_owners; /* Number of owners bound to session */
+};
+
+/*! Pool of persistent backend sessions of a handle, see clicon_client_pool_init
+ */
+struct client_pool {
+    int                         cp_len;    /* Number of sessions */
+    struct client_pool_session *cp_vec;    /* Vector of sessions */
+    struct client_pool_session *cp_cur;    /* Session of handle socket */
+    clicon_hash_t              *cp_owners; /* Owner pointer -> session */
+};
+
+/*! Create a pool of persistent backend sessions of a handle
+ *
+ * The rpc functions use the cached socket of the handle. With a pool, each owner, such
+ * as a RESTCONF connection, is bound to one of several backend sessions and
+ * clicon_client_pool_select makes its session the cached socket. An owner uses the same
+ * session until released, so that locks taken by an owner stay with its session.
+ * Sessions are connected on first use and kept open.
+ * @param[in]  h    Clixon handle
+ * @param[in]  n    Number of sessions, no pool is created if less than 2
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clicon_client_pool_exit
+ */
+int
+clicon_client_pool_init(clixon_handle h,
+                        int           n)
+{
+    int                 retval = -1;
+    struct client_pool *cp = NULL;
+    int                 i;
+
+    if (n < 2)
+        goto ok;
+    if ((cp = calloc(1, sizeof(*cp))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((cp->cp_vec = calloc(n, sizeof(*cp->cp_vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((cp->cp_owners = clicon_hash_init()) == NULL)
+        goto done;
+    cp->cp_len = n;
+    for (i = 0; i < n; i++)
+        cp->cp_vec[i].ps_s = -1;
+    /* Current socket of handle is first session */
+    cp->cp_cur = &cp->cp_vec[0];
+    if (clicon_ptr_set(h, "client-pool", cp) < 0)
+        goto done;
+    cp = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (cp){
+        if (cp->cp_owners)
+            clicon_hash_free(cp->cp_owners);
+        if (cp->cp_vec)
+            free(cp->cp_vec);
+        free(cp);
+    }
+    return retval;
+}
+
+/*! Make the backend session of an owner the cached socket of the handle
+ *
+ * An owner without session is bound to the session with fewest owners
+ * @param[in]  h      Clixon handle
+ * @param[in]  owner  Owner, eg a connection
+ * @retval     0      OK, also if no pool
+ * @retval    -1      Error
+ */
+int
+clicon_client_pool_select(clixon_handle h,
+                          void         *owner)
+{
+    struct client_pool         *cp = NULL;
+    struct client_pool_session *ps;
+    struct rpc_pipe            *rp = NULL;
+    int                         i;
+
+    if (clicon_ptr_get(h, "client-pool", (void**)&cp) < 0 || cp == NULL)
+        return 0;
+    if ((ps = clicon_hash_ptr_value(cp->cp_owners, owner)) == NULL){
+        ps = &cp->cp_vec[0];
+        for (i = 1; i < cp->cp_len; i++)
+            if (cp->cp_vec[i].ps_owners < ps->ps_owners)
+                ps = &cp->cp_vec[i];
+        if (clicon_hash_add_ptr(cp->cp_owners, owner, ps) == NULL)
+            return -1;
+        ps->ps_owners++;
+    }
+    if (ps == cp->cp_cur)
+        return 0;
+    /* Save socket and rpcs in flight of current session */
+    cp->cp_cur->ps_s = clicon_client_socket_get(h);
+    if (clicon_ptr_get(h, "rpc-pipe", (void**)&rp) == 0 && rp != NULL){
+        cp->cp_cur->ps_pipe = rp;
+        clicon_ptr_del(h, "rpc-pipe");
+    }
+    clicon_client_socket_set(h, ps->ps_s);
+    if (ps->ps_pipe){
+        if (clicon_ptr_set(h, "rpc-pipe", ps->ps_pipe) < 0)
+            return -1;
+        ps->ps_pipe = NULL;
+    }
+    cp->cp_cur = ps;
+    return 0;
+}
+
+/*! Release the binding of an owner to its backend session
+ *
+ * The session is kept open for other owners
+ * @param[in]  h      Clixon handle
+ * @param[in]  owner  Owner, eg a connection
+ * @retval     0      OK, also if no pool or owner not bound
+ */
+int
+clicon_client_pool_release(clixon_handle h,
+                           void         *owner)
+{
+    struct client_pool         *cp = NULL;
+    struct client_pool_session *ps;
+
+    if (clicon_ptr_get(h, "client-pool", (void**)&cp) < 0 || cp == NULL)
+        return 0;
+    if ((ps = clicon_hash_ptr_value(cp->cp_owners, owner)) == NULL)
+        return 0;
+    clicon_hash_del_ptr(cp->cp_owners, owner);
+    ps->ps_owners--;
+    return 0;
+}
+
+/*! Close the backend sessions of a pool except the cached socket, and free the pool
+ *
+ * @param[in]  h      Clixon handle
+ * @retval     0      OK
+ */
+int
+clicon_client_pool_exit(clixon_handle h)
+{
+    struct client_pool         *cp = NULL;
+    struct client_pool_session *ps;
+    int                         i;
+
+    if (clicon_ptr_get(h, "client-pool", (void**)&cp) < 0 || cp == NULL)
+        return 0;
+    for (i = 0; i < cp->cp_len; i++){
+        ps = &cp->cp_vec[i];
+        if (ps == cp->cp_cur)
+            continue;
+        if (ps->ps_s >= 0)
+            rpc_session_close(ps->ps_s);
+        if (ps->ps_pipe)
+            rpc_pipe_free1(ps->ps_pipe);
+    }
+    clicon_hash_free(cp->cp_owners);
+    free(cp->cp_vec);
+    free(cp);
+    clicon_ptr_del(h, "client-pool");
+    return 0;
+}
+
 /*! Send netconf rpc from client to backend and return a persistent socket
  *
  * @param[in]   h      Clixon handle
@@ -350,7 +970,7 @@ clicon_rpc_msg_persistent(clixon_handle h,
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
     }
-    if (create_hello(h, cb, NULL, NULL) < 0)
+    if (create_hello(h, cb, NULL, NULL, 0) < 0)
         goto done;
     if ((ret = clixon_rpc_msg2(h, cb, s, &xret)) < 0 ||
         ret == 0){
@@ -542,6 +1162,131 @@ clicon_rpc_netconf_xml(clixon_handle  h,
     return retval;
 }
 
+/*! Generic netconf clicon rpc with request and reply as text, without parsing
+ *
+ * Used for pass-through of netconf messages, see CLICON_NETCONF_PASSTHROUGH
+ * @param[in]  h       clicon handle
+ * @param[in]  cbsend  NETCONF rpc as text
+ * @param[out] cbret   Reply from backend as text. Free with cbuf_free
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @note A binary XML reply (CLICON_IPC_BINARY) is converted to text
+ * @see clicon_rpc_netconf  reply as xml tree
+ */
+int
+clicon_rpc_netconf_raw(clixon_handle h,
+                       cbuf         *cbsend,
+                       cbuf        **cbret)
+{
+    int    retval = -1;
+    int    s;
+    cbuf  *cbrcv = NULL;
+    cxobj *xret = NULL;
+    int    eof = 0;
+    int    ret;
+
+    if (session_id_check(h, NULL) < 0)
+        goto done;
+    if ((s = clicon_client_socket_get(h)) < 0){
+        if (rpc_session_open(h, &s) < 0)
+            goto done;
+        clicon_client_socket_set(h, s);
+    }
+    /* Replies of pipelined rpcs come before the reply of this rpc */
+    else if (rpc_pipe_drain(h, s) < 0)
+        goto closed;
+    if (clixon_rpc11(s, clicon_sock_str(h), cbsend, &cbrcv, &eof) < 0)
+        goto closed;
+    if (eof){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+        goto closed;
+    }
+    if ((ret = clixon_xml_parse_bin(cbuf_get(cbrcv), cbuf_len(cbrcv), &xret)) < 0)
+        goto done;
+    if (ret == 1){
+        cbuf_reset(cbrcv);
+        if (clixon_xml2cbuf1(cbrcv, xml_child_i_type(xret, 0, CX_ELMNT), 0, 0, NULL, -1, 0, 0) < 0)
+            goto done;
+    }
+    *cbret = cbrcv;
+    cbrcv = NULL;
+    retval = 0;
+ done:
+    if (xret)
+        xml_free(xret);
+    if (cbrcv)
+        cbuf_free(cbrcv);
+    return retval;
+ closed:
+    rpc_pipe_free(h);
+    rpc_session_close(s);
+    clicon_client_socket_set(h, -1);
+    goto done;
+}
+
+/*! Generic netconf clicon rpc with request as text and reply streamed as text
+ *
+ * As clicon_rpc_netconf_raw but the reply is not accumulated: each part is passed to a
+ * callback as it is received from the backend, see clixon_msg_rcv11_stream
+ * @param[in]  h       clicon handle
+ * @param[in]  cbsend  NETCONF rpc as text
+ * @param[in]  fn      Callback with each part of the reply, eom set for the last part
+ * @param[in]  arg     Argument to callback
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @note With CLICON_IPC_BINARY the reply is received whole and converted to text
+ * @see clicon_rpc_netconf_raw
+ */
+int
+clicon_rpc_netconf_stream(clixon_handle         h,
+                          cbuf                 *cbsend,
+                          clixon_msg_stream_fn *fn,
+                          void                 *arg)
+{
+    int   retval = -1;
+    int   s;
+    cbuf *cbret = NULL;
+    int   eof = 0;
+
+    /* Binary XML cannot be converted in parts */
+    if (clicon_option_slot_bool(h, OS_IPC_BINARY)){
+        if (clicon_rpc_netconf_raw(h, cbsend, &cbret) < 0)
+            goto done;
+        if (fn(arg, cbuf_get(cbret), cbuf_len(cbret), 1) < 0)
+            goto done;
+        goto ok;
+    }
+    if (session_id_check(h, NULL) < 0)
+        goto done;
+    if ((s = clicon_client_socket_get(h)) < 0){
+        if (rpc_session_open(h, &s) < 0)
+            goto done;
+        clicon_client_socket_set(h, s);
+    }
+    /* Replies of pipelined rpcs come before the reply of this rpc */
+    else if (rpc_pipe_drain(h, s) < 0)
+        goto closed;
+    if (clixon_msg_send11(s, clicon_sock_str(h), cbsend) < 0)
+        goto closed;
+    if (clixon_msg_rcv11_stream(s, clicon_sock_str(h), fn, arg, &eof) < 0)
+        goto closed;
+    if (eof){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+        goto closed;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+ closed:
+    rpc_pipe_free(h);
+    rpc_session_close(s);
+    clicon_client_socket_set(h, -1);
+    goto done;
+}
+
 /*! Get database configuration
  *
  * Same as clicon_proto_change just with a cvec instead of lvec
@@ -1361,9 +2106,10 @@ clicon_rpc_close_session(clixon_handle h)
     if (clicon_rpc_msg(h, cb, &xret) < 0)
         goto done;
     if ((s = clicon_client_socket_get(h)) >= 0){
-        close(s);
+        rpc_session_close(s);
         clicon_client_socket_set(h, -1);
     }
+    rpc_pipe_free(h);
     if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
         clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Close session");
         goto done;
@@ -1845,7 +2591,7 @@ clicon_hello_req(clixon_handle h,
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
     }
-    if (create_hello(h, cb, transport, source_host) < 0)
+    if (create_hello(h, cb, transport, source_host, 0) < 0)
         goto done;
     if (clicon_rpc_msg(h, cb, &xret) < 0) // In turn sends on main socket
         goto done;
@@ -1913,3 +2659,238 @@ clicon_rpc_restart_plugin(clixon_handle h,
         xml_free(xret);
     return retval;
 }
+
+/*! Get change id and time of last change of a datastore from backend
+ *
+ * The change id increases when the datastore content changes, eg for entity-tags
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Datastore, eg "running"
+ * @param[out] id    Change id
+ * @param[out] tv    Time of last change, in whole seconds (if given)
+ * @retval     0     OK
+ * @retval    -1     Error and logged to syslog
+ */
+int
+clicon_rpc_datastore_change(clixon_handle   h,
+                            char           *db,
+                            uint64_t       *id,
+                            struct timeval *tv)
+{
+    int      retval = -1;
+    cxobj   *xret = NULL;
+    cxobj   *xerr;
+    char    *username;
+    uint32_t session_id;
+    cbuf    *cb = NULL;
+    char    *str;
+    char    *reason = NULL;
+    int      ret;
+
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cb, " %s", NETCONF_MESSAGE_ID_ATTR); /* XXX: use incrementing sequence */
+    cprintf(cb, ">");
+    cprintf(cb, "<datastore-change xmlns=\"%s\"><datastore>%s</datastore></datastore-change>",
+            CLIXON_LIB_NS, db);
+    cprintf(cb, "</rpc>");
+    if (clicon_rpc_msg(h, cb, &xret) < 0)
+        goto done;
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Datastore change");
+        goto done;
+    }
+    if ((str = xml_find_body(xpath_first(xret, NULL, "rpc-reply"), "change-id")) == NULL){
+        clixon_err(OE_XML, 0, "No change-id in reply");
+        goto done;
+    }
+    if ((ret = parse_uint64(str, id, &reason)) < 0){
+        clixon_err(OE_XML, errno, "parse_uint64");
+        goto done;
+    }
+    if (ret == 0){
+        clixon_err(OE_XML, EINVAL, "change-id: %s", reason);
+        goto done;
+    }
+    if (tv != NULL){
+        if ((str = xml_find_body(xpath_first(xret, NULL, "rpc-reply"), "last-modified")) == NULL ||
+            str2time(str, tv) < 0){
+            clixon_err(OE_XML, EINVAL, "No or invalid last-modified in reply");
+            goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    if (cb)
+        cbuf_free(cb);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Get distinct values of nodes selected by an XPath in a datastore from backend
+ *
+ * Eg for CLI completion of list keys, only the values are sent, not the data tree
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Datastore, eg "running"
+ * @param[in]  xpath   XPath of nodes
+ * @param[in]  nsc     Namespace context of xpath
+ * @param[in]  prefix  Only values beginning with prefix, or NULL
+ * @param[in]  limit   Max nr of values, 0 is unbounded
+ * @param[out] xt      rpc-reply with value elements, free with xml_free
+ * @retval     0       OK
+ * @retval    -1       Error and logged to syslog
+ * @code
+ *   cxobj *xt = NULL;
+ *   cxobj *x = NULL;
+ *   if (clicon_rpc_expand_values(h, "running", "/ex:a/ex:name", nsc, NULL, 0, &xt) < 0)
+ *      err;
+ *   while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+ *      value = xml_body(x);
+ *   xml_free(xt);
+ * @endcode
+ */
+int
+clicon_rpc_expand_values(clixon_handle h,
+                         char         *db,
+                         char         *xpath,
+                         cvec         *nsc,
+                         char         *prefix,
+                         uint32_t      limit,
+                         cxobj       **xt)
+{
+    int      retval = -1;
+    cxobj   *xret = NULL;
+    cxobj   *xerr;
+    cxobj   *xr;
+    char    *username;
+    uint32_t session_id;
+    cbuf    *cb = NULL;
+
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL)
+        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+    cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    cprintf(cb, " %s", NETCONF_MESSAGE_ID_ATTR); /* XXX: use incrementing sequence */
+    cprintf(cb, ">");
+    cprintf(cb, "<%s:expand-values>", CLIXON_LIB_PREFIX);
+    cprintf(cb, "<%s:datastore>%s</%s:datastore>", CLIXON_LIB_PREFIX, db, CLIXON_LIB_PREFIX);
+    /* Namespace prefixes of xpath are declared on the xpath element */
+    cprintf(cb, "<%s:xpath", CLIXON_LIB_PREFIX);
+    if (xml_nsctx_cbuf(cb, nsc) < 0)
+        goto done;
+    cprintf(cb, ">");
+    if (xml_chardata_cbuf_append(cb, 0, xpath) < 0)
+        goto done;
+    cprintf(cb, "</%s:xpath>", CLIXON_LIB_PREFIX);
+    if (prefix){
+        cprintf(cb, "<%s:prefix>", CLIXON_LIB_PREFIX);
+        if (xml_chardata_cbuf_append(cb, 0, prefix) < 0)
+            goto done;
+        cprintf(cb, "</%s:prefix>", CLIXON_LIB_PREFIX);
+    }
+    if (limit)
+        cprintf(cb, "<%s:limit>%u</%s:limit>", CLIXON_LIB_PREFIX, limit, CLIXON_LIB_PREFIX);
+    cprintf(cb, "</%s:expand-values></rpc>", CLIXON_LIB_PREFIX);
+    if (clicon_rpc_msg(h, cb, &xret) < 0)
+        goto done;
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Expand values");
+        goto done;
+    }
+    if ((xr = xpath_first(xret, NULL, "rpc-reply")) == NULL){
+        clixon_err(OE_XML, 0, "No rpc-reply");
+        goto done;
+    }
+    if (xml_rm(xr) < 0)
+        goto done;
+    *xt = xr;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Get differences between two datastores from backend
+ *
+ * The diff is computed in the backend, only the diff is sent
+ * @param[in]  h       Clixon handle
+ * @param[in]  db1     First datastore, eg "running"
+ * @param[in]  db2     Second datastore, eg "candidate"
+ * @param[in]  format  Diff format: "xml" or "text"
+ * @param[out] cb      Diff is appended to this buffer, empty if equal
+ * @retval     0       OK
+ * @retval    -1       Error and logged to syslog
+ * @see clixon_xml_diff2cbuf
+ */
+int
+clicon_rpc_datastore_diff(clixon_handle h,
+                          char         *db1,
+                          char         *db2,
+                          char         *format,
+                          cbuf         *cb)
+{
+    int      retval = -1;
+    cxobj   *xret = NULL;
+    cxobj   *xerr;
+    char    *diff;
+    char    *username;
+    uint32_t session_id;
+    cbuf    *cbmsg = NULL;
+
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cbmsg = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbmsg, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cbmsg, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL)
+        cprintf(cbmsg, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+    cprintf(cbmsg, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    cprintf(cbmsg, " %s", NETCONF_MESSAGE_ID_ATTR); /* XXX: use incrementing sequence */
+    cprintf(cbmsg, ">");
+    cprintf(cbmsg, "<%s:datastore-diff>", CLIXON_LIB_PREFIX);
+    cprintf(cbmsg, "<%s:source>%s</%s:source>", CLIXON_LIB_PREFIX, db1, CLIXON_LIB_PREFIX);
+    cprintf(cbmsg, "<%s:target>%s</%s:target>", CLIXON_LIB_PREFIX, db2, CLIXON_LIB_PREFIX);
+    if (format)
+        cprintf(cbmsg, "<%s:format>%s</%s:format>", CLIXON_LIB_PREFIX, format, CLIXON_LIB_PREFIX);
+    cprintf(cbmsg, "</%s:datastore-diff></rpc>", CLIXON_LIB_PREFIX);
+    if (clicon_rpc_msg(h, cbmsg, &xret) < 0)
+        goto done;
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Datastore diff");
+        goto done;
+    }
+    if ((diff = xml_find_body(xml_find_type(xret, NULL, "rpc-reply", CX_ELMNT), "diff")) != NULL)
+        cprintf(cb, "%s", diff);
+    retval = 0;
+ done:
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
@@ -67,6 +67,37 @@
 #include "clixon_options.h"
 #include "clixon_regex.h"
 
+#ifdef REGEX_CACHE
+/* Max number of cached compiled regexps, least recently used are evicted */
+#define REGEX_CACHE_SIZE 1024
+
+/*
+ * Types
+ */
+/*! Cached compiled regexp, see regex_cache_get
+ */
+struct regex_cache_entry{
+    qelem_t  rc_q;     /* LRU queue, least recently used first */
+    char    *rc_key;   /* Mode and XSD regexp, key of cache */
+    int      rc_mode;  /* Regexp engine, see enum regexp_mode */
+    void    *rc_re;    /* Compiled regexp */
+};
+
+/*
+ * Variables
+ */
+/* Cache of compiled regexps: "<mode> <regexp>" -> struct regex_cache_entry* */
+static clicon_hash_t            *_regex_cache = NULL;
+/* LRU queue of cache entries */
+static struct regex_cache_entry *_regex_cache_lru = NULL;
+/* Number of cache entries */
+static int                       _regex_cache_nr = 0;
+/* Number of cache lookups that found a compiled regexp */
+static uint64_t                  _regex_cache_hits = 0;
+/* Number of cache lookups that compiled the regexp */
+static uint64_t                  _regex_cache_misses = 0;
+#endif /* REGEX_CACHE */
+
 /*-------------------------- POSIX translation -------------------------*/
 
 /* parse 4 digit hexadecimal number */
@@ -386,21 +417,40 @@ int
 regex_compile(clixon_handle h,
               char         *regexp,
               void        **recomp)
+{
+    return regex_compile_mode(clicon_yang_regexp(h), regexp, recomp);
+}
+
+/*! Compilation of regular expression / pattern given regexp engine
+ *
+ * Same as regex_compile but without handle, eg in XPath functions
+ * @param[in]   mode    Regexp engine, see enum regexp_mode
+ * @param[in]   regexp  Regular expression string in XSD regex format
+ * @param[out]  recomp  Compiled regular expression (malloc:d, should be freed)
+ * @retval      1       OK
+ * @retval      0       Invalid regular expression (syntax error?)
+ * @retval     -1       Error
+ * @see regex_compile
+ */
+int
+regex_compile_mode(int         mode,
+                   const char *regexp,
+                   void      **recomp)
 {
     int              retval = -1;
     char            *posix = NULL;    /* Transform to posix regex */
 
-    switch (clicon_yang_regexp(h)){
+    switch (mode){
     case REGEXP_POSIX:
-        if (regexp_xsd2posix(regexp, &posix) < 0)
+        if (regexp_xsd2posix((char*)regexp, &posix) < 0)
             goto done;
         retval = cligen_regex_posix_compile(posix, recomp);
         break;
     case REGEXP_LIBXML2:
-        retval = cligen_regex_libxml2_compile(regexp, recomp);
+        retval = cligen_regex_libxml2_compile((char*)regexp, recomp);
         break;
     default:
-        clixon_err(OE_CFG, 0, "clicon_yang_regexp invalid value: %d", clicon_yang_regexp(h));
+        clixon_err(OE_CFG, 0, "clicon_yang_regexp invalid value: %d", mode);
         break;
     }
     /* retval from fns above */
@@ -470,3 +520,221 @@ regex_free(clixon_handle h,
  done:
     return retval;
 }
+
+/*! Free of (pre-compiled) regular expression / pattern given regexp engine
+ *
+ * Frees also the regexp itself, unlike regex_free
+ * @param[in]  mode    Regexp engine, see enum regexp_mode
+ * @param[in]  recomp  Compiled regular expression
+ */
+static void
+regex_free_mode(int   mode,
+                void *recomp)
+{
+    switch (mode){
+    case REGEXP_POSIX:
+        cligen_regex_posix_free(recomp);
+        free(recomp);
+        break;
+    case REGEXP_LIBXML2:
+        cligen_regex_libxml2_free(recomp); /* Note, also frees recomp */
+        break;
+    default:
+        break;
+    }
+}
+
+#ifdef REGEX_CACHE
+/*! Remove and free a regexp cache entry
+ */
+static int
+regex_cache_rm(struct regex_cache_entry *rc)
+{
+    DELQ(rc, _regex_cache_lru, struct regex_cache_entry *);
+    if (clicon_hash_del(_regex_cache, rc->rc_key) < 0)
+        return -1;
+    _regex_cache_nr--;
+    if (rc->rc_re)
+        regex_free_mode(rc->rc_mode, rc->rc_re);
+    free(rc->rc_key);
+    free(rc);
+    return 0;
+}
+#endif /* REGEX_CACHE */
+
+/*! Get compiled regexp from cache, compile and add it if not found
+ *
+ * The cache is keyed on regexp engine and XSD regexp string, and shared by all callers.
+ * The compiled regexp is owned by the cache and may be evicted at a later call, ie it
+ * should be used directly and not be kept or freed by the caller.
+ * Without REGEX_CACHE, the regexp is compiled and should be freed with regex_cache_release
+ * @param[in]   mode    Regexp engine, see enum regexp_mode
+ * @param[in]   regexp  Regular expression string in XSD regex format
+ * @param[out]  recomp  Compiled regular expression
+ * @retval      1       OK
+ * @retval      0       Invalid regular expression (syntax error?), not cached
+ * @retval     -1       Error
+ * @see regex_compile_mode  Uncached variant
+ * @see REGEX_CACHE
+ */
+int
+regex_cache_get(int         mode,
+                const char *regexp,
+                void      **recomp)
+{
+    int                        retval = -1;
+#ifdef REGEX_CACHE
+    struct regex_cache_entry  *rc = NULL;
+    struct regex_cache_entry **rcp;
+    cbuf                      *cb = NULL;
+    void                      *re = NULL;
+    int                        ret;
+
+    if (regexp == NULL){
+        clixon_err(OE_CFG, EINVAL, "regexp is NULL");
+        goto done;
+    }
+    if (_regex_cache == NULL &&
+        (_regex_cache = clicon_hash_init()) == NULL)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%d %s", mode, regexp);
+    if ((rcp = clicon_hash_value(_regex_cache, cbuf_get(cb), NULL)) != NULL){
+        rc = *rcp;
+        DELQ(rc, _regex_cache_lru, struct regex_cache_entry *);
+        ADDQ(rc, _regex_cache_lru); /* Most recently used last */
+        _regex_cache_hits++;
+        *recomp = rc->rc_re;
+        retval = 1;
+        goto done;
+    }
+    _regex_cache_misses++;
+    if ((ret = regex_compile_mode(mode, regexp, &re)) < 0)
+        goto done;
+    if (ret == 0){
+        retval = 0;
+        goto done;
+    }
+    /* Evict least recently used entry */
+    if (_regex_cache_nr >= REGEX_CACHE_SIZE)
+        if (regex_cache_rm(_regex_cache_lru) < 0)
+            goto done;
+    if ((rc = calloc(1, sizeof(*rc))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((rc->rc_key = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(rc);
+        goto done;
+    }
+    if (clicon_hash_add(_regex_cache, rc->rc_key, &rc, sizeof(rc)) == NULL){
+        free(rc->rc_key);
+        free(rc);
+        goto done;
+    }
+    rc->rc_mode = mode;
+    rc->rc_re = re;
+    re = NULL;
+    ADDQ(rc, _regex_cache_lru);
+    _regex_cache_nr++;
+    *recomp = rc->rc_re;
+    retval = 1;
+ done:
+    if (re)
+        regex_free_mode(mode, re);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+#else
+    retval = regex_compile_mode(mode, regexp, recomp);
+    return retval;
+#endif /* REGEX_CACHE */
+}
+
+/*! Release compiled regexp given by regex_cache_get
+ *
+ * Only frees the regexp if REGEX_CACHE is not enabled
+ * @param[in]  mode    Regexp engine, see enum regexp_mode
+ * @param[in]  recomp  Compiled regular expression
+ */
+void
+regex_cache_release(int   mode,
+                    void *recomp)
+{
+#ifndef REGEX_CACHE
+    if (recomp)
+        regex_free_mode(mode, recomp);
+#endif
+}
+
+/*! Free all cached compiled regexps
+ *
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see REGEX_CACHE
+ */
+int
+regex_cache_exit(void)
+{
+#ifdef REGEX_CACHE
+    while (_regex_cache_lru != NULL)
+        if (regex_cache_rm(_regex_cache_lru) < 0)
+            return -1;
+    if (_regex_cache){
+        clicon_hash_free(_regex_cache);
+        _regex_cache = NULL;
+    }
+#endif
+    return 0;
+}
+
+/*! Get regexp cache statistics
+ *
+ * @param[out] nr      Number of cached compiled regexps
+ * @param[out] hits    Number of lookups that found a compiled regexp
+ * @param[out] misses  Number of lookups that compiled the regexp
+ * @retval     0       OK
+ */
+int
+regex_cache_stats(uint64_t *nr,
+                  uint64_t *hits,
+                  uint64_t *misses)
+{
+#ifdef REGEX_CACHE
+    *nr = _regex_cache_nr;
+    *hits = _regex_cache_hits;
+    *misses = _regex_cache_misses;
+#else
+    *nr = *hits = *misses = 0;
+#endif
+    return 0;
+}
+
+/*! Get approximate size of regexp cache
+ *
+ * Entries and keys, compiled regexps are opaque to the cache and not included
+ * @param[out] szp     Size in bytes
+ * @retval     0       OK
+ */
+int
+regex_cache_size(size_t *szp)
+{
+#ifdef REGEX_CACHE
+    struct regex_cache_entry *rc;
+    int                       i;
+
+    *szp = 0;
+    rc = _regex_cache_lru;
+    for (i=0; i<_regex_cache_nr; i++){
+        *szp += sizeof(*rc) + strlen(rc->rc_key) + 1;
+        rc = NEXTQ(struct regex_cache_entry *, rc);
+    }
+#else
+    *szp = 0;
+#endif
+    return 0;
+}
@@ -0,0 +1,743 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Shared memory transport between backend and local clients, see CLICON_IPC_SHM
+ *
+ * A client offers the transport in its hello on the UNIX socket. If the backend accepts,
+ * the client creates a memory file with two ring buffers, one per direction, and four
+ * eventfds, and passes them to the backend on the socket. The NETCONF byte stream is
+ * then written to and read from the rings instead of the socket:
+ *
+ *   client                                backend
+ *     ---> ring 0 (data: efd 0, space: efd 1) --->
+ *     <--- ring 1 (data: efd 2, space: efd 3) <---
+ *
+ * Each ring has one producer and one consumer. A consumer that finds its ring empty marks
+ * that it waits and the producer only writes the data eventfd if so, and vice versa for a
+ * producer that finds the ring full. The socket is kept open but not written: it is
+ * readable only when the peer is gone.
+ * Channels are found by socket, so that clixon_msg_send11 and clixon_msg_rcv11 use them
+ * transparently.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#ifdef HAVE_MEMFD_CREATE
+#define _GNU_SOURCE /* memfd_create */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_shm.h"
+
+#if defined(HAVE_SYS_EVENTFD_H) && defined(HAVE_MEMFD_CREATE) && defined(IPC_SHM_RING_SIZE)
+#define SHM_SUPPORTED
+#endif
+
+#ifdef SHM_SUPPORTED
+
+/*
+ * Constants
+ */
+/* Number of eventfds of a channel */
+#define SHM_NEFD 4
+
+/* Byte sent on socket with channel file descriptors, or without if client fell back */
+#define SHM_BYTE_CHANNEL  'S'
+#define SHM_BYTE_NONE     'N'
+
+/*
+ * Types
+ */
+/*! Ring buffer in shared memory, one producer and one consumer
+ *
+ * Head and tail are free-running byte counters, fields written by different ends are on
+ * different cache lines
+ */
+struct shm_ring {
+    uint64_t sr_head;      /* Bytes written, by producer */
+    uint8_t  sr_pad0[56];
+    uint64_t sr_tail;      /* Bytes read, by consumer */
+    uint8_t  sr_pad1[56];
+    uint32_t sr_rwait;     /* Consumer waits for data */
+    uint32_t sr_wwait;     /* Producer waits for space */
+    uint8_t  sr_pad2[56];
+    uint8_t  sr_data[IPC_SHM_RING_SIZE];
+};
+
+/*! Local state of a channel of a socket
+ */
+struct clixon_shm {
+    int              sh_s;         /* Socket */
+    struct shm_ring *sh_map;       /* Both rings */
+    struct shm_ring *sh_in;        /* Ring read by this end */
+    struct shm_ring *sh_out;       /* Ring written by this end */
+    int              sh_efd[SHM_NEFD]; /* eventfds, see file comment */
+    int              sh_in_data;   /* Signaled by peer: data in input ring */
+    int              sh_in_space;  /* Signaled by this end: space in input ring */
+    int              sh_out_data;  /* Signaled by this end: data in output ring */
+    int              sh_out_space; /* Signaled by peer: space in output ring */
+    pthread_mutex_t  sh_wlock;     /* Reader threads of the backend also send */
+};
+
+/*
+ * Internal variables
+ */
+/* Channels indexed by socket */
+static struct clixon_shm **_shm = NULL;
+static int _shm_len = 0;
+static int _shm_nr = 0;
+static pthread_mutex_t _shm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*! Get channel of socket
+ *
+ * @param[in]  s    Socket
+ * @retval     sh   Channel
+ * @retval     NULL No channel
+ */
+static struct clixon_shm *
+shm_get(int s)
+{
+    struct clixon_shm *sh = NULL;
+
+    if (s < 0 || __atomic_load_n(&_shm_nr, __ATOMIC_ACQUIRE) == 0)
+        return NULL;
+    pthread_mutex_lock(&_shm_lock);
+    if (s < _shm_len)
+        sh = _shm[s];
+    pthread_mutex_unlock(&_shm_lock);
+    return sh;
+}
+
+/*! Add channel of socket
+ */
+static int
+shm_add(struct clixon_shm *sh)
+{
+    int                 retval = -1;
+    struct clixon_shm **vec;
+    int                 len;
+
+    pthread_mutex_lock(&_shm_lock);
+    if (sh->sh_s >= _shm_len){
+        len = _shm_len ? _shm_len : 64;
+        while (len <= sh->sh_s)
+            len *= 2;
+        if ((vec = realloc(_shm, len*sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        memset(vec + _shm_len, 0, (len - _shm_len)*sizeof(*vec));
+        _shm = vec;
+        _shm_len = len;
+    }
+    _shm[sh->sh_s] = sh;
+    __atomic_add_fetch(&_shm_nr, 1, __ATOMIC_RELEASE);
+    retval = 0;
+ done:
+    pthread_mutex_unlock(&_shm_lock);
+    return retval;
+}
+
+/*! Free local state of channel
+ */
+static void
+shm_free(struct clixon_shm *sh)
+{
+    int i;
+
+    if (sh->sh_map != NULL)
+        munmap(sh->sh_map, 2*sizeof(struct shm_ring));
+    for (i = 0; i < SHM_NEFD; i++)
+        if (sh->sh_efd[i] >= 0)
+            close(sh->sh_efd[i]);
+    pthread_mutex_destroy(&sh->sh_wlock);
+    free(sh);
+}
+
+/*! Create local state of channel from memory file and eventfds
+ *
+ * @param[in]  s      Socket
+ * @param[in]  memfd  Memory file with both rings, closed after mapping
+ * @param[in]  efd    eventfds, owned by channel
+ * @param[in]  client Set if client end, else backend end
+ * @retval     sh     Channel
+ * @retval     NULL   Error
+ */
+static struct clixon_shm *
+shm_new(int  s,
+        int  memfd,
+        int *efd,
+        int  client)
+{
+    struct clixon_shm *sh;
+    void              *map;
+    int                i;
+
+    if ((sh = calloc(1, sizeof(*sh))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    sh->sh_s = s;
+    for (i = 0; i < SHM_NEFD; i++)
+        sh->sh_efd[i] = efd[i];
+    pthread_mutex_init(&sh->sh_wlock, NULL);
+    if ((map = mmap(NULL, 2*sizeof(struct shm_ring), PROT_READ|PROT_WRITE, MAP_SHARED,
+                    memfd, 0)) == MAP_FAILED){
+        clixon_err(OE_UNIX, errno, "mmap");
+        shm_free(sh);
+        return NULL;
+    }
+    sh->sh_map = (struct shm_ring *)map;
+    if (client){
+        sh->sh_out = &sh->sh_map[0];
+        sh->sh_out_data = efd[0];
+        sh->sh_out_space = efd[1];
+        sh->sh_in = &sh->sh_map[1];
+        sh->sh_in_data = efd[2];
+        sh->sh_in_space = efd[3];
+    }
+    else {
+        sh->sh_in = &sh->sh_map[0];
+        sh->sh_in_data = efd[0];
+        sh->sh_in_space = efd[1];
+        sh->sh_out = &sh->sh_map[1];
+        sh->sh_out_data = efd[2];
+        sh->sh_out_space = efd[3];
+    }
+    return sh;
+}
+
+/*! Signal eventfd
+ */
+static void
+shm_signal(int efd)
+{
+    uint64_t one = 1;
+
+    while (write(efd, &one, sizeof(one)) < 0 && errno == EINTR)
+        ;
+}
+
+/*! Clear eventfd, non-blocking
+ */
+static void
+shm_clear(int efd)
+{
+    uint64_t val;
+
+    while (read(efd, &val, sizeof(val)) < 0 && errno == EINTR)
+        ;
+}
+
+/*! Wait for eventfd, or for the socket to be readable, ie peer is gone
+ *
+ * @param[in]  sh    Channel
+ * @param[in]  efd   eventfd
+ * @retval     1     eventfd signaled
+ * @retval     0     Peer is gone
+ * @retval    -1     Error
+ */
+static int
+shm_wait(struct clixon_shm *sh,
+         int                efd)
+{
+    struct pollfd pfd[2];
+    int           restarts = 0;
+
+    pfd[0].fd = efd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = sh->sh_s;
+    pfd[1].events = POLLIN;
+    while (poll(pfd, 2, -1) < 0){
+        if (errno != EINTR || restarts++ >= 5){
+            clixon_err(OE_UNIX, errno, "poll");
+            return -1;
+        }
+    }
+    if (pfd[0].revents & POLLIN){
+        shm_clear(efd);
+        return 1;
+    }
+    return 0;
+}
+
+/*! Send byte on socket with or without file descriptors
+ */
+static int
+shm_send_fds(int   s,
+             char  byte,
+             int  *fds,
+             int   nfds)
+{
+    struct msghdr   msg = {0,};
+    struct iovec    iov;
+    struct cmsghdr *cmsg;
+    union {
+        char            buf[CMSG_SPACE((SHM_NEFD+1)*sizeof(int))];
+        struct cmsghdr  align;
+    } u;
+
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (nfds){
+        memset(&u, 0, sizeof(u));
+        msg.msg_control = u.buf;
+        msg.msg_controllen = CMSG_SPACE(nfds*sizeof(int));
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(nfds*sizeof(int));
+        memcpy(CMSG_DATA(cmsg), fds, nfds*sizeof(int));
+    }
+    while (sendmsg(s, &msg, 0) < 0){
+        if (errno != EINTR){
+            clixon_err(OE_UNIX, errno, "sendmsg");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#endif /* SHM_SUPPORTED */
+
+/*! Check if the shared memory transport is supported on this platform
+ *
+ * @retval     1     Yes
+ * @retval     0     No
+ */
+int
+clixon_shm_supported(void)
+{
+#ifdef SHM_SUPPORTED
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/*! Client: create a channel of a socket and pass it to the backend
+ *
+ * Called when the backend has accepted the transport in its hello reply. The backend then
+ * expects one byte on the socket, with the channel or without if it could not be created.
+ * @param[in]  s     UNIX socket to backend
+ * @retval     1     Channel created, messages on s are sent in shared memory
+ * @retval     0     Channel not created, messages are sent on socket
+ * @retval    -1     Error
+ * @see clixon_shm_accept  Backend end
+ */
+int
+clixon_shm_connect(int s)
+{
+#ifdef SHM_SUPPORTED
+    int                retval = -1;
+    int                fds[SHM_NEFD+1];
+    int                memfd = -1;
+    int                efd[SHM_NEFD];
+    struct clixon_shm *sh = NULL;
+    int                i;
+
+    for (i = 0; i < SHM_NEFD; i++)
+        efd[i] = -1;
+    /* Sealed so that the backend can not get SIGBUS by the file shrinking */
+    if ((memfd = memfd_create("clixon-ipc", MFD_CLOEXEC|MFD_ALLOW_SEALING)) < 0 ||
+        ftruncate(memfd, 2*sizeof(struct shm_ring)) < 0 ||
+        fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK|F_SEAL_GROW|F_SEAL_SEAL) < 0){
+        clixon_log(NULL, LOG_WARNING, "%s: memfd: %s, using socket", __func__, strerror(errno));
+        goto fallback;
+    }
+    for (i = 0; i < SHM_NEFD; i++)
+        if ((efd[i] = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC)) < 0){
+            clixon_log(NULL, LOG_WARNING, "%s: eventfd: %s, using socket", __func__, strerror(errno));
+            goto fallback;
+        }
+    if ((sh = shm_new(s, memfd, efd, 1)) == NULL)
+        goto fallback;
+    for (i = 0; i < SHM_NEFD; i++)
+        efd[i] = -1; /* Owned by sh */
+    /* Both ends wait for data initially */
+    sh->sh_map[0].sr_rwait = 1;
+    sh->sh_map[1].sr_rwait = 1;
+    fds[0] = memfd;
+    for (i = 0; i < SHM_NEFD; i++)
+        fds[i+1] = sh->sh_efd[i];
+    if (shm_send_fds(s, SHM_BYTE_CHANNEL, fds, SHM_NEFD+1) < 0)
+        goto done;
+    if (shm_add(sh) < 0)
+        goto done;
+    sh = NULL;
+    clixon_debug(CLIXON_DBG_MSG, "shared memory channel on socket %d", s);
+    retval = 1;
+    goto done;
+ fallback:
+    if (shm_send_fds(s, SHM_BYTE_NONE, NULL, 0) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (sh)
+        shm_free(sh);
+    if (memfd >= 0)
+        close(memfd);
+    for (i = 0; i < SHM_NEFD; i++)
+        if (efd[i] >= 0)
+            close(efd[i]);
+    return retval;
+#else
+    return 0;
+#endif
+}
+
+/*! Backend: receive the channel of a client socket
+ *
+ * Called on the first input from a client after accepting the transport in the hello reply.
+ * Messages from the client are then read in the channel. The eventfd returned is signaled
+ * when there is input: register it in the event loop and use clixon_shm_pending.
+ * @param[in]  s     UNIX socket of client
+ * @param[out] efd   eventfd signaled on input, if channel received
+ * @retval     1     Channel received
+ * @retval     0     Client fell back to socket, or closed
+ * @retval    -1     Error
+ * @see clixon_shm_connect  Client end
+ */
+int
+clixon_shm_accept(int  s,
+                  int *efd)
+{
+#ifdef SHM_SUPPORTED
+    int                retval = -1;
+    struct msghdr      msg = {0,};
+    struct iovec       iov;
+    struct cmsghdr    *cmsg;
+    char               byte = 0;
+    int                fds[SHM_NEFD+1];
+    int                nfds = 0;
+    struct clixon_shm *sh = NULL;
+    ssize_t            len;
+    struct stat        st;
+    int                seals;
+    int                i;
+    union {
+        char            buf[CMSG_SPACE((SHM_NEFD+1)*sizeof(int))];
+        struct cmsghdr  align;
+    } u;
+
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = u.buf;
+    msg.msg_controllen = sizeof(u.buf);
+    while ((len = recvmsg(s, &msg, MSG_CMSG_CLOEXEC)) < 0){
+        if (errno != EINTR){
+            clixon_err(OE_UNIX, errno, "recvmsg");
+            goto done;
+        }
+    }
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS){
+            nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            if (nfds > SHM_NEFD + 1)
+                nfds = SHM_NEFD + 1;
+            memcpy(fds, CMSG_DATA(cmsg), nfds*sizeof(int));
+            break;
+        }
+    if (len == 0 || byte != SHM_BYTE_CHANNEL || nfds != SHM_NEFD + 1 ||
+        (msg.msg_flags & MSG_CTRUNC)){
+        for (i = 0; i < nfds; i++)
+            close(fds[i]);
+        retval = 0;
+        goto done;
+    }
+    if (fstat(fds[0], &st) < 0 ||
+        st.st_size < (off_t)(2*sizeof(struct shm_ring)) ||
+        (seals = fcntl(fds[0], F_GET_SEALS)) < 0 ||
+        (seals & F_SEAL_SHRINK) == 0){
+        clixon_err(OE_UNIX, EINVAL, "Shared memory of client is not a sealed file of %zu bytes",
+                   2*sizeof(struct shm_ring));
+        for (i = 0; i < nfds; i++)
+            close(fds[i]);
+        goto done;
+    }
+    if ((sh = shm_new(s, fds[0], &fds[1], 0)) == NULL){
+        for (i = 1; i < nfds; i++)
+            close(fds[i]);
+        close(fds[0]);
+        goto done;
+    }
+    close(fds[0]);
+    if (shm_add(sh) < 0){
+        shm_free(sh);
+        goto done;
+    }
+    *efd = sh->sh_in_data;
+    clixon_debug(CLIXON_DBG_MSG, "shared memory channel on socket %d", s);
+    retval = 1;
+ done:
+    return retval;
+#else
+    return 0;
+#endif
+}
+
+/*! Close channel of socket, if any
+ *
+ * Call before closing the socket
+ * @param[in]  s     Socket
+ * @retval     0     OK
+ */
+int
+clixon_shm_close(int s)
+{
+#ifdef SHM_SUPPORTED
+    struct clixon_shm *sh = NULL;
+
+    if (shm_get(s) == NULL)
+        return 0;
+    pthread_mutex_lock(&_shm_lock);
+    if (s < _shm_len && (sh = _shm[s]) != NULL){
+        _shm[s] = NULL;
+        __atomic_sub_fetch(&_shm_nr, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&_shm_lock);
+    if (sh)
+        shm_free(sh);
+#endif
+    return 0;
+}
+
+/*! Check if there is input in the channel of a socket, and clear its eventfd
+ *
+ * If there is none, the peer signals the eventfd when it writes
+ * @param[in]  s     Socket
+ * @retval     1     Input in channel
+ * @retval     0     No input, or no channel
+ */
+int
+clixon_shm_pending(int s)
+{
+#ifdef SHM_SUPPORTED
+    struct clixon_shm *sh;
+    struct shm_ring   *r;
+    uint64_t           tail;
+
+    if ((sh = shm_get(s)) == NULL)
+        return 0;
+    r = sh->sh_in;
+    shm_clear(sh->sh_in_data);
+    tail = r->sr_tail;
+    if (__atomic_load_n(&r->sr_head, __ATOMIC_ACQUIRE) != tail)
+        return 1;
+    __atomic_store_n(&r->sr_rwait, 1, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&r->sr_head, __ATOMIC_SEQ_CST) != tail;
+#else
+    return 0;
+#endif
+}
+
+/*! Read from channel of socket, block until there is input or peer is gone
+ *
+ * @param[in]  s      Socket
+ * @param[out] buf    Buffer
+ * @param[in]  buflen Length of buffer
+ * @param[out] len    Bytes read, if channel
+ * @param[out] eof    Set if peer is gone
+ * @retval     1      Read from channel
+ * @retval     0      No channel, read from socket
+ * @retval    -1      Error
+ */
+int
+clixon_shm_read(int      s,
+                void    *buf,
+                size_t   buflen,
+                ssize_t *len,
+                int     *eof)
+{
+#ifdef SHM_SUPPORTED
+    struct clixon_shm *sh;
+    struct shm_ring   *r;
+    uint64_t           head;
+    uint64_t           tail;
+    size_t             n;
+    size_t             off;
+    size_t             n1;
+    int                ret;
+
+    if ((sh = shm_get(s)) == NULL)
+        return 0;
+    r = sh->sh_in;
+    *len = 0;
+    tail = r->sr_tail;
+    while ((head = __atomic_load_n(&r->sr_head, __ATOMIC_ACQUIRE)) == tail){
+        __atomic_store_n(&r->sr_rwait, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&r->sr_head, __ATOMIC_SEQ_CST) != tail)
+            continue;
+        if ((ret = shm_wait(sh, sh->sh_in_data)) < 0)
+            return -1;
+        if (ret == 0 && __atomic_load_n(&r->sr_head, __ATOMIC_SEQ_CST) == tail){
+            *eof = 1;
+            return 1;
+        }
+    }
+    n = head - tail;
+    if (n > buflen)
+        n = buflen;
+    off = tail % IPC_SHM_RING_SIZE;
+    n1 = IPC_SHM_RING_SIZE - off;
+    if (n1 > n)
+        n1 = n;
+    memcpy(buf, &r->sr_data[off], n1);
+    if (n > n1)
+        memcpy((uint8_t*)buf + n1, &r->sr_data[0], n - n1);
+    __atomic_store_n(&r->sr_tail, tail + n, __ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&r->sr_wwait, 0, __ATOMIC_SEQ_CST))
+        shm_signal(sh->sh_in_space);
+    *len = n;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/*! Write buffers to channel of socket, block while the channel is full
+ *
+ * @param[in]  s      Socket
+ * @param[in]  iov    Buffers
+ * @param[in]  iovcnt Number of buffers
+ * @retval     1      Written to channel
+ * @retval     0      No channel, write to socket
+ * @retval    -1      Error, errno is EPIPE if peer is gone
+ */
+int
+clixon_shm_writev(int           s,
+                  struct iovec *iov,
+                  int           iovcnt)
+{
+#ifdef SHM_SUPPORTED
+    int                retval = -1;
+    struct clixon_shm *sh;
+    struct shm_ring   *r;
+    uint64_t           head;
+    uint64_t           tail;
+    size_t             space;
+    size_t             off;
+    size_t             n;
+    size_t             n1;
+    int                i = 0;
+    size_t             pos = 0; /* Position in iov[i] */
+    int                ret;
+
+    if ((sh = shm_get(s)) == NULL)
+        return 0;
+    r = sh->sh_out;
+    pthread_mutex_lock(&sh->sh_wlock);
+    head = r->sr_head;
+    while (i < iovcnt){
+        tail = __atomic_load_n(&r->sr_tail, __ATOMIC_ACQUIRE);
+        if ((space = IPC_SHM_RING_SIZE - (head - tail)) == 0){
+            __atomic_store_n(&r->sr_wwait, 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&r->sr_tail, __ATOMIC_SEQ_CST) != tail)
+                continue;
+            if ((ret = shm_wait(sh, sh->sh_out_space)) < 0)
+                goto done;
+            if (ret == 0){
+                errno = EPIPE;
+                goto done;
+            }
+            continue;
+        }
+        /* Copy as much as fits, then publish */
+        while (i < iovcnt && space > 0){
+            n = iov[i].iov_len - pos;
+            if (n > space)
+                n = space;
+            off = head % IPC_SHM_RING_SIZE;
+            n1 = IPC_SHM_RING_SIZE - off;
+            if (n1 > n)
+                n1 = n;
+            memcpy(&r->sr_data[off], (uint8_t*)iov[i].iov_base + pos, n1);
+            if (n > n1)
+                memcpy(&r->sr_data[0], (uint8_t*)iov[i].iov_base + pos + n1, n - n1);
+            head += n;
+            space -= n;
+            pos += n;
+            if (pos == iov[i].iov_len){
+                i++;
+                pos = 0;
+            }
+        }
+        __atomic_store_n(&r->sr_head, head, __ATOMIC_SEQ_CST);
+        if (__atomic_exchange_n(&r->sr_rwait, 0, __ATOMIC_SEQ_CST))
+            shm_signal(sh->sh_out_data);
+    }
+    retval = 1;
+ done:
+    pthread_mutex_unlock(&sh->sh_wlock);
+    return retval;
+#else
+    return 0;
+#endif
+}
@@ -91,6 +91,9 @@
 /* Go through and timeout subscription timers [s] */
 #define STREAM_TIMER_TIMEOUT_S 5
 
+/* Initial nr of entries of replay ring, doubled when full */
+#define STREAM_REPLAY_RING_INIT 64
+
 /*! Find an event notification stream given name
  *
  * @param[in]  h    Clixon handle
@@ -168,6 +171,10 @@ stream_add(clixon_handle   h,
     es->es_replay_enabled = replay_enabled;
     if (retention)
         es->es_retention = *retention;
+    if (clicon_option_exists(h, "CLICON_STREAM_REPLAY_MAX"))
+        es->es_replay_max = clicon_option_int(h, "CLICON_STREAM_REPLAY_MAX");
+    if (clicon_option_exists(h, "CLICON_STREAM_RATE_LIMIT"))
+        es->es_rate = clicon_option_int(h, "CLICON_STREAM_RATE_LIMIT");
     clicon_stream_append(h, es);
     es = NULL;
  ok:
@@ -178,6 +185,48 @@ stream_add(clixon_handle   h,
     return retval;
 }
 
+/*! Set rate limit of a stream, overriding CLICON_STREAM_RATE_LIMIT
+ *
+ * Events to a subscription of the stream exceeding the rate are dropped and counted
+ * @param[in]  h     Clixon handle
+ * @param[in]  name  Name of stream
+ * @param[in]  rate  Max events per second to each subscription, 0 is unlimited
+ * @retval     0     OK
+ * @retval    -1     Error, stream not found
+ */
+int
+stream_rate_limit_set(clixon_handle h,
+                      const char   *name,
+                      uint32_t      rate)
+{
+    event_stream_t *es;
+
+    if ((es = stream_find(h, name)) == NULL){
+        clixon_err(OE_CFG, ENOENT, "Stream %s not found", name);
+        return -1;
+    }
+    es->es_rate = rate;
+    return 0;
+}
+
+/*! Remove oldest entry of replay ring
+ *
+ * @param[in] es   Stream with at least one replay entry
+ */
+static void
+stream_replay_rm(event_stream_t *es)
+{
+    struct stream_replay *r;
+
+    r = &es->es_replay[es->es_replay_i0];
+    es->es_replay_size -= r->r_len;
+    if (r->r_str)
+        free(r->r_str);
+    memset(r, 0, sizeof(*r));
+    es->es_replay_i0 = (es->es_replay_i0 + 1) % es->es_replay_len;
+    es->es_replay_nr--;
+}
+
 /*! Delete complete notification event stream list (not just single stream)
  *
  * @param[in] h     Clixon handle
@@ -190,7 +239,6 @@ stream_delete_all(clixon_handle h,
                   int           force)
 {
     int                   retval = -1;
-    struct stream_replay *r;
     struct stream_subscription *ss;
     event_stream_t       *es;
     event_stream_t       *head = clicon_stream(h);
@@ -202,11 +250,11 @@ stream_delete_all(clixon_handle h,
             if (stream_ss_rm(h, es, ss, force) < 0)
                 goto done;
         }
-        while ((r = es->es_replay) != NULL){
-            DELQ(r, es->es_replay, struct stream_replay *);
-            if (r->r_xml)
-                xml_free(r->r_xml);
-            free(r);
+        while (es->es_replay_nr)
+            stream_replay_rm(es);
+        if (es->es_replay){
+            free(es->es_replay);
+            es->es_replay = NULL;
         }
         if (stream_delete(es) < 0)
             goto done;
@@ -280,8 +328,6 @@ stream_timer_setup(int   fd,
     event_stream_t              *es;
     struct stream_subscription  *ss;
     struct stream_subscription  *ss1;
-    struct stream_replay        *r;
-    struct stream_replay        *r1;
 
     clixon_debug(CLIXON_DBG_STREAM|CLIXON_DBG_DETAIL, "");
     /* Go thru callbacks and see if any have timed out, if so remove them 
@@ -309,21 +355,11 @@ stream_timer_setup(int   fd,
                         ss = NEXTQ(struct stream_subscription *, ss);
                 } while (ss && ss != es->es_subscription);
   /* 2) Go throughreplay buffer and remove entries with passed retention time */
-            if (timerisset(&es->es_retention) &&
-                (r = es->es_replay) != NULL){
+            if (timerisset(&es->es_retention)){
                 timersub(&now, &es->es_retention, &tret);
-                do {
-                    if (timercmp(&r->r_tv, &tret, <)){
-                        r1 = NEXTQ(struct stream_replay *, r);
-                        DELQ(r, es->es_replay, struct stream_replay *);
-                        if (r->r_xml)
-                            xml_free(r->r_xml);
-                        free(r);
-                        r = r1;
-                    }
-                    else
-                        r = NEXTQ(struct stream_replay *, r);
-                } while (r && r!=es->es_replay);
+                while (es->es_replay_nr &&
+                       timercmp(&es->es_replay[es->es_replay_i0].r_tv, &tret, <))
+                    stream_replay_rm(es);
             }
             es = NEXTQ(struct event_stream *, es);
         } while (es && es != clicon_stream(h));
@@ -412,6 +448,8 @@ stream_ss_rm(clixon_handle               h,
              int                         force)
 {
     clixon_debug(CLIXON_DBG_STREAM, "");
+    if (ss->ss_dropped)
+        clixon_debug(CLIXON_DBG_STREAM, "%s: %u events dropped by rate limit", es->es_name, ss->ss_dropped);
     DELQ(ss, es->es_subscription, struct stream_subscription *);
     /* Remove from upper layers - close socket etc. */
     (*ss->ss_fn)(h, 1, NULL, ss->ss_arg);
@@ -544,11 +582,51 @@ stream_ss_delete(clixon_handle     h,
     return retval;
 }
 
+/*! Get serialized event being distributed to subscribers, serialize on first call
+ *
+ * All subscribers of an event, eg many clients, share one serialization.
+ * Subscriber callbacks must not modify the event.
+ * @param[in]  h    Clixon handle
+ * @param[in]  xev  Event as XML
+ * @param[out] cbp  Serialized event, NULL if xev is not the event being distributed
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see stream_notify1
+ */
+int
+stream_event_cbuf(clixon_handle h,
+                  cxobj        *xev,
+                  cbuf        **cbp)
+{
+    cxobj *x = NULL;
+    cbuf  *cb = NULL;
+
+    *cbp = NULL;
+    if (clicon_ptr_get(h, "stream-event", (void**)&x) < 0 || x == NULL || x != xev)
+        return 0;
+    if (clicon_ptr_get(h, "stream-event-cbuf", (void**)&cb) < 0 || cb == NULL){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            return -1;
+        }
+        if (clixon_xml2cbuf(cb, xev, 0, 0, NULL, -1, 0) < 0){
+            cbuf_free(cb);
+            return -1;
+        }
+        clicon_ptr_set(h, "stream-event-cbuf", cb);
+    }
+    *cbp = cb;
+    return 0;
+}
+
 /*! Stream notify event and distribute to all registered callbacks
  *
+ * Each distinct xpath filter is evaluated once per event, and the event is serialized
+ * at most once, see stream_event_cbuf
  * @param[in]  h       Clixon handle
  * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
  * @param[in]  tv      Timestamp. Dont notify if subscription has stoptime<tv
+ * @param[in]  selector If set, only notify subscriptions with this filter, filters are not evaluated
  * @param[in]  event   Notification as xml tree
  * @retval     0       OK
  * @retval    -1       Error
@@ -559,12 +637,24 @@ static int
 stream_notify1(clixon_handle   h,
                event_stream_t *es,
                struct timeval *tv,
+               const char     *selector,
                cxobj          *xevent)
 {
     int                         retval = -1;
     struct stream_subscription *ss;
+    clicon_hash_t              *xpaths = NULL; /* xpath -> match */
+    int                        *matchp;
+    int                         match;
+    size_t                      vlen;
+    cxobj                      *xev0 = NULL;   /* Outer event if nested notify */
+    cbuf                       *cb0 = NULL;
+    cbuf                       *cb = NULL;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
+    clicon_ptr_get(h, "stream-event", (void**)&xev0);
+    clicon_ptr_get(h, "stream-event-cbuf", (void**)&cb0);
+    clicon_ptr_set(h, "stream-event", xevent);
+    clicon_ptr_set(h, "stream-event-cbuf", NULL);
     /* Go thru all subscriptions and find matches */
     if ((ss = es->es_subscription) != NULL)
         do {
@@ -578,9 +668,35 @@ stream_notify1(clixon_handle   h,
                 ss = ss1;
             }
             else{  /* xpath match */
-                if (ss->ss_xpath == NULL ||
-                    strlen(ss->ss_xpath)==0 ||
-                    xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL)
+                if (selector != NULL)
+                    match = strcmp(ss->ss_xpath ? ss->ss_xpath : "", selector) == 0;
+                else if (ss->ss_xpath == NULL || strlen(ss->ss_xpath)==0)
+                    match = 1;
+                else {
+                    if (xpaths == NULL &&
+                        (xpaths = clicon_hash_init()) == NULL)
+                        goto done;
+                    if ((matchp = clicon_hash_value(xpaths, ss->ss_xpath, &vlen)) != NULL)
+                        match = *matchp;
+                    else {
+                        match = xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL;
+                        if (clicon_hash_add(xpaths, ss->ss_xpath, &match, sizeof(match)) == NULL)
+                            goto done;
+                    }
+                }
+                /* Rate limit, drop events exceeding es_rate per second */
+                if (match && es->es_rate){
+                    if (ss->ss_rate_sec != tv->tv_sec){
+                        ss->ss_rate_sec = tv->tv_sec;
+                        ss->ss_rate_nr = 0;
+                    }
+                    if (ss->ss_rate_nr++ >= es->es_rate){
+                        ss->ss_dropped++;
+                        es->es_dropped++;
+                        match = 0;
+                    }
+                }
+                if (match)
                     if ((*ss->ss_fn)(h, 0, xevent, ss->ss_arg) < 0)
                         goto done;
                 ss = NEXTQ(struct stream_subscription *, ss);
@@ -588,6 +704,12 @@ stream_notify1(clixon_handle   h,
         } while (es->es_subscription && ss != es->es_subscription);
     retval = 0;
   done:
+    if (clicon_ptr_get(h, "stream-event-cbuf", (void**)&cb) == 0 && cb)
+        cbuf_free(cb);
+    clicon_ptr_set(h, "stream-event", xev0);
+    clicon_ptr_set(h, "stream-event-cbuf", cb0);
+    if (xpaths)
+        clicon_hash_free(xpaths);
     return retval;
 }
 
@@ -654,12 +776,11 @@ stream_notify(clixon_handle h,
         goto done;
     if (xml_rootchild(xev, 0, &xev) < 0)
         goto done;
-    if (stream_notify1(h, es, &tv, xev) < 0)
+    if (stream_notify1(h, es, &tv, NULL, xev) < 0)
         goto done;
     if (es->es_replay_enabled){
         if (stream_replay_add(es, &tv, xev) < 0)
             goto done;
-        xev = NULL; /* xml stored in replay_add and should not be freed */
     }
  ok:
     retval = 0;
@@ -673,28 +794,49 @@ stream_notify(clixon_handle h,
     return retval;
 }
 
-/*! Backward compatible function
+/*! Stream notify event given as XML and distribute to all registered callbacks
  *
+ * The notification is built around a copy of the event without a print/parse round trip
  * @param[in]  h       Clixon handle
  * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
- * @param[in]  xml     Notification as XML stream. Is copied.
+ * @param[in]  xml     Notification content as XML tree. Is copied.
  * @retval     0       OK
  * @retval    -1       Error
- * @see  stream_notify  Should be merged with this
+ * @see  stream_notify  Similar but with event as format string
  */
 int
 stream_notify_xml(clixon_handle h,
                   char         *stream,
                   cxobj        *xml)
 {
-    int        retval = -1;
-    cxobj     *xev = NULL;
-    cxobj     *xml2; /* copy */
-    yang_stmt *yspec = NULL;
-    char      *str = NULL; /* XXX: never set */
-    cbuf      *cb = NULL;
-    char       timestr[28];
-    struct timeval tv;
+    return stream_notify_xml_selector(h, stream, NULL, xml);
+}
+
+/*! Stream notify event given as XML to subscriptions with a given filter
+ *
+ * Used when the event is made for the subscriptions of a filter, eg on-change patches of
+ * a subtree. The filter is not evaluated on the event, and the event is not replayed.
+ * @param[in]  h        Clixon handle
+ * @param[in]  stream   Name of event stream
+ * @param[in]  selector Filter of subscriptions as given in stream_ss_add, "" for no filter,
+ *                      or NULL for all subscriptions with filters evaluated as stream_notify_xml
+ * @param[in]  xml      Notification content as XML tree. Is copied.
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see  stream_notify_xml
+ */
+int
+stream_notify_xml_selector(clixon_handle h,
+                           char         *stream,
+                           const char   *selector,
+                           cxobj        *xml)
+{
+    int             retval = -1;
+    cxobj          *xev = NULL;
+    cxobj          *xml2; /* copy */
+    yang_stmt      *yspec = NULL;
+    char            timestr[28];
+    struct timeval  tv;
     event_stream_t *es;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
@@ -704,42 +846,33 @@ stream_notify_xml(clixon_handle h,
         clixon_err(OE_YANG, 0, "No yang spec");
         goto done;
     }
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
     gettimeofday(&tv, NULL);
     if (time2str(&tv, timestr, sizeof(timestr)) < 0){
         clixon_err(OE_UNIX, errno, "time2str");
         goto done;
     }
-    cprintf(cb, "<notification xmlns=\"%s\"><eventTime>%s</eventTime>NULL</notification>",
-            NETCONF_NOTIFICATION_NAMESPACE,
-            timestr); /* XXX str is always NULL */
-    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, yspec, &xev, NULL) < 0)
+    /* From RFC5277 */
+    if ((xev = xml_new("notification", NULL, CX_ELMNT)) == NULL)
         goto done;
-    if (xml_rootchild(xev, 0, &xev) < 0)
+    if (xmlns_set(xev, NULL, NETCONF_NOTIFICATION_NAMESPACE) < 0)
+        goto done;
+    if (xml_new_body("eventTime", xev, timestr) == NULL)
         goto done;
     if ((xml2 = xml_dup(xml)) == NULL)
         goto done;
     if (xml_addsub(xev, xml2) < 0)
         goto done;
-    if (stream_notify1(h, es, &tv, xev) < 0)
+    if (stream_notify1(h, es, &tv, selector, xev) < 0)
         goto done;
-    if (es->es_replay_enabled){
+    if (es->es_replay_enabled && selector == NULL){
         if (stream_replay_add(es, &tv, xev) < 0)
             goto done;
-        xev = NULL; /* xml stored in replay_add and should not be freed */
     }
  ok:
     retval = 0;
   done:
-    if (cb)
-        cbuf_free(cb);
     if (xev)
         xml_free(xev);
-    if (str)
-        free(str);
     return retval;
 }
 
@@ -776,43 +909,109 @@ stream_replay_notify(clixon_handle               h,
 {
     int                   retval = -1;
     struct stream_replay *r;
+    size_t                lo;
+    size_t                hi;
+    size_t                mid;
+    cxobj                *xev = NULL;
+    cxobj                *xev0 = NULL;
+    cbuf                 *cb = NULL;
+    cbuf                 *cb0 = NULL;
+    yang_stmt            *yspec;
 
     /* If <startTime> is not present, this is not a replay */
     if (!timerisset(&ss->ss_starttime))
         goto ok;
     if (!es->es_replay_enabled)
         goto ok;
-    /* Get replay linked list */
-    if ((r = es->es_replay) == NULL)
+    if (es->es_replay_nr == 0)
         goto ok;
-    /* First loop to skip until start */
-    do {
-        if (timercmp(&r->r_tv, &ss->ss_starttime, >=))
-            break;
-        r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
-    if (r == NULL)
+    /* Binary search of first entry not before start */
+    lo = 0;
+    hi = es->es_replay_nr;
+    while (lo < hi){
+        mid = lo + (hi - lo)/2;
+        r = &es->es_replay[(es->es_replay_i0 + mid) % es->es_replay_len];
+        if (timercmp(&r->r_tv, &ss->ss_starttime, <))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == es->es_replay_nr)
         goto ok; /* No samples to replay */
+    yspec = clicon_dbspec_yang(h);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    clicon_ptr_get(h, "stream-event", (void**)&xev0);
+    clicon_ptr_get(h, "stream-event-cbuf", (void**)&cb0);
     /* Then notify until stop */
-    do {
+    for (; lo < es->es_replay_nr; lo++){
+        r = &es->es_replay[(es->es_replay_i0 + lo) % es->es_replay_len];
         if (timerisset(&ss->ss_stoptime) &&
             timercmp(&r->r_tv, &ss->ss_stoptime, >))
             break;
-        if ((*ss->ss_fn)(h, 0, r->r_xml, ss->ss_arg) < 0)
+        if (clixon_xml_parse_string(r->r_str, YB_MODULE, yspec, &xev, NULL) < 0)
             goto done;
-        r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
+        if (xml_rootchild(xev, 0, &xev) < 0)
+            goto done;
+        /* Send stored serialization, see stream_event_cbuf */
+        cbuf_reset(cb);
+        cbuf_append_str(cb, r->r_str);
+        clicon_ptr_set(h, "stream-event", xev);
+        clicon_ptr_set(h, "stream-event-cbuf", cb);
+        if ((*ss->ss_fn)(h, 0, xev, ss->ss_arg) < 0)
+            goto done;
+        xml_free(xev);
+        xev = NULL;
+    }
  ok:
     retval = 0;
  done:
+    if (cb){
+        clicon_ptr_set(h, "stream-event", xev0);
+        clicon_ptr_set(h, "stream-event-cbuf", cb0);
+        cbuf_free(cb);
+    }
+    if (xev)
+        xml_free(xev);
     return retval;
 }
 
+/*! Return number of replay samples and size of replay rings of all streams
+ *
+ * @param[in]  h    Clixon handle
+ * @param[out] nr   Number of replay samples
+ * @param[out] szp  Size in bytes of rings and serialized samples
+ * @retval     0    OK
+ */
+int
+stream_replay_stats(clixon_handle h,
+                    uint64_t     *nr,
+                    size_t       *szp)
+{
+    event_stream_t *es0;
+    event_stream_t *es;
+
+    *nr = 0;
+    *szp = 0;
+    es0 = clicon_stream(h);
+    if ((es = es0) != NULL)
+        do {
+            *nr += es->es_replay_nr;
+            *szp += es->es_replay_len*sizeof(struct stream_replay) + es->es_replay_size;
+            es = NEXTQ(struct event_stream *, es);
+        } while (es && es != es0);
+    return 0;
+}
+
 /*! Add replay sample to stream with timestamp
  *
+ * The sample is stored serialized in a ring ordered by time. Oldest samples are dropped
+ * when the ring exceeds CLICON_STREAM_REPLAY_MAX bytes.
  * @param[in] es   Stream
- * @param[in] tv   Timestamp
- * @param[in] xv   XML
+ * @param[in] tv   Timestamp, not before earlier samples
+ * @param[in] xv   XML, serialized, not kept
  * @retval    0    OK
  * @retval   -1    Error
  */
@@ -822,18 +1021,50 @@ stream_replay_add(event_stream_t *es,
                   cxobj          *xv)
 {
     int                   retval = -1;
-    struct stream_replay *new;
+    struct stream_replay *r;
+    struct stream_replay *ring;
+    size_t                len;
+    size_t                i;
+    cbuf                 *cb = NULL;
 
-    if ((new = malloc(sizeof *new)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, xv, 0, 0, NULL, -1, 0) < 0)
         goto done;
+    /* Grow ring, oldest entry first */
+    if (es->es_replay_nr == es->es_replay_len){
+        len = es->es_replay_len ? 2*es->es_replay_len : STREAM_REPLAY_RING_INIT;
+        if ((ring = calloc(len, sizeof(*ring))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        for (i = 0; i < es->es_replay_nr; i++)
+            ring[i] = es->es_replay[(es->es_replay_i0 + i) % es->es_replay_len];
+        if (es->es_replay)
+            free(es->es_replay);
+        es->es_replay = ring;
+        es->es_replay_len = len;
+        es->es_replay_i0 = 0;
     }
-    memset(new, 0, (sizeof *new));
-    new->r_tv = *tv;
-    new->r_xml = xv;
-    ADDQ(new, es->es_replay);
+    r = &es->es_replay[(es->es_replay_i0 + es->es_replay_nr) % es->es_replay_len];
+    r->r_tv = *tv;
+    r->r_len = cbuf_len(cb);
+    if ((r->r_str = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    es->es_replay_nr++;
+    es->es_replay_size += r->r_len;
+    /* Keep at least the new sample */
+    while (es->es_replay_max && es->es_replay_nr > 1 &&
+           es->es_replay_size > es->es_replay_max)
+        stream_replay_rm(es);
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
@@ -935,102 +1166,232 @@ stream_replay_trigger(clixon_handle h,
 
 #include <curl/curl.h>
 
+/* Max nr of pending and running publish posts, further events are dropped */
+#define STREAM_PUB_QUEUE_MAX    1024
+/* Max nr of events of a stream batched in one publish post */
+#define STREAM_PUB_BATCH_MAX    64
+/* Max nr of concurrent publish posts */
+#define STREAM_PUB_RUNNING_MAX  4
+/* Max nr of retries of a failed publish post, then it is dropped */
+#define STREAM_PUB_RETRY_MAX    3
+/* Delay before retry of a failed publish post in ms */
+#define STREAM_PUB_RETRY_MS     1000
+/* Max time between polls of running publish posts in ms */
+#define STREAM_PUB_POLL_MS      10
+
 /*
  * Types (curl)
  */
-struct curlbuf{
-    size_t b_len;
-    char  *b_buf;
+/* Pending or running publish post of one or several events of a stream */
+struct pub_post {
+    qelem_t         pp_q;       /* queue header */
+    char           *pp_url;     /* pub url + stream */
+    cbuf           *pp_data;    /* Events as XML */
+    int             pp_nr;      /* Nr of events in pp_data */
+    int             pp_tries;   /* Nr of failed attempts */
+    struct timeval  pp_next;    /* Do not start before this time, set on retry */
+    CURL           *pp_curl;    /* Easy handle while running, else NULL */
+    char            pp_err[CURL_ERROR_SIZE];
 };
 
-/*
- * For the asynchronous case. I think we must handle the case where of many of these
- * come in before we can handle them in the upper-level polling routine.
- * realloc. Therefore, we append new data to the userdata buffer.
+/* Publish state. Global since curl_global_init is */
+static CURLM           *_pub_multi = NULL;   /* Multi handle of running posts */
+static struct pub_post *_pub_posts = NULL;   /* Queue of pending and running posts */
+static int              _pub_nr = 0;         /* Length of _pub_posts */
+static int              _pub_running = 0;    /* Nr of running posts */
+static int              _pub_timer = 0;      /* stream_pub_timeout registered */
+static uint64_t         _pub_dropped = 0;    /* Nr of dropped events */
+
+/*! Reply data of publish post is not used
  */
 static size_t
-curl_get_cb(void  *ptr,
-            size_t size,
-            size_t nmemb,
-            void  *userdata)
+curl_pub_write_cb(void  *ptr,
+                  size_t size,
+                  size_t nmemb,
+                  void  *userdata)
 {
-    struct curlbuf *buf = (struct curlbuf *)userdata;
-    int len;
+    clixon_debug(CLIXON_DBG_STREAM | CLIXON_DBG_DETAIL, "%.*s", (int)(size*nmemb), (char*)ptr);
+    return size*nmemb;
+}
 
-    len = size*nmemb;
-    if ((buf->b_buf = realloc(buf->b_buf, buf->b_len+len+1)) == NULL)
-        return 0;
-    memcpy(buf->b_buf+buf->b_len, ptr, len);
-    buf->b_len += len;
-    buf->b_buf[buf->b_len] = '\0';
-    return len;
+/*! Free publish post, remove it from multi handle if running
+ */
+static void
+stream_pub_free(struct pub_post *pp)
+{
+    if (pp->pp_curl){
+        curl_multi_remove_handle(_pub_multi, pp->pp_curl);
+        curl_easy_cleanup(pp->pp_curl);
+    }
+    if (pp->pp_url)
+        free(pp->pp_url);
+    if (pp->pp_data)
+        cbuf_free(pp->pp_data);
+    free(pp);
 }
 
-/*! Send a curl POST request
+/*! Start pending publish posts up to STREAM_PUB_RUNNING_MAX, as non-blocking transfers
  *
- * @retval   1   ok
- * @retval   0   expect set but did not expected return or other non-fatal error
- * @retval  -1   fatal error
- * Note: curl_easy_perform blocks
- * Note: New handle is created every time, the handle can be re-used for better TCP performance
- * @see same function (url_post) in grideye_curl.c
+ * A post is an HTTP POST of its events to pub url + stream.
+ * Posts of different streams may run concurrently, posts of the same stream run in order.
+ * @retval   0   OK
+ * @retval  -1   Error
  */
 static int
-url_post(char *url,
-         char *postfields,
-         char **getdata)
+stream_pub_start(void)
 {
-    int            retval = -1;
-    CURL          *curl = NULL;
-    char          *err = NULL;
-    struct curlbuf cb = {0, };
-    CURLcode       errcode;
-
-    /* Try it with  curl -X PUT -d '*/
-    clixon_debug(CLIXON_DBG_STREAM, "curl -X POST -d '%s' %s",
-        postfields, url);
-    /* Set up curl for doing the communication with the controller */
-    if ((curl = curl_easy_init()) == NULL) {
-        clixon_debug(CLIXON_DBG_STREAM, "curl_easy_init");
-        goto done;
+    int              retval = -1;
+    struct pub_post *pp;
+    struct pub_post *pp1;
+    struct timeval   now;
+
+    if ((pp = _pub_posts) == NULL)
+        goto ok;
+    gettimeofday(&now, NULL);
+    do {
+        if (_pub_running >= STREAM_PUB_RUNNING_MAX)
+            break;
+        if (pp->pp_curl != NULL || timercmp(&pp->pp_next, &now, >))
+            continue;
+        /* An earlier post of the same stream is pending or running */
+        for (pp1 = _pub_posts; pp1 != pp; pp1 = NEXTQ(struct pub_post *, pp1))
+            if (strcmp(pp1->pp_url, pp->pp_url) == 0)
+                break;
+        if (pp1 != pp)
+            continue;
+        clixon_debug(CLIXON_DBG_STREAM, "curl -X POST -d '%s' %s", cbuf_get(pp->pp_data), pp->pp_url);
+        if ((pp->pp_curl = curl_easy_init()) == NULL){
+            clixon_err(OE_UNIX, 0, "curl_easy_init");
+            goto done;
+        }
+        curl_easy_setopt(pp->pp_curl, CURLOPT_URL, pp->pp_url);
+        curl_easy_setopt(pp->pp_curl, CURLOPT_WRITEFUNCTION, curl_pub_write_cb);
+        curl_easy_setopt(pp->pp_curl, CURLOPT_ERRORBUFFER, pp->pp_err);
+        curl_easy_setopt(pp->pp_curl, CURLOPT_POST, 1);
+        curl_easy_setopt(pp->pp_curl, CURLOPT_POSTFIELDS, cbuf_get(pp->pp_data));
+        curl_easy_setopt(pp->pp_curl, CURLOPT_POSTFIELDSIZE, cbuf_len(pp->pp_data));
+        curl_easy_setopt(pp->pp_curl, CURLOPT_PRIVATE, pp);
+        if (clixon_debug_get())
+            curl_easy_setopt(pp->pp_curl, CURLOPT_VERBOSE, 1);
+        if (curl_multi_add_handle(_pub_multi, pp->pp_curl) != CURLM_OK){
+            clixon_err(OE_UNIX, 0, "curl_multi_add_handle");
+            curl_easy_cleanup(pp->pp_curl);
+            pp->pp_curl = NULL;
+            goto done;
+        }
+        pp->pp_err[0] = '\0';
+        _pub_running++;
+    } while ((pp = NEXTQ(struct pub_post *, pp)) != _pub_posts);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+static int stream_pub_timeout(int fd, void *arg);
+
+/*! Register timer to drive publish posts, if there are pending or running posts
+ *
+ * Running posts are polled since the event loop only waits for sockets to be readable
+ * @retval   0   OK
+ * @retval  -1   Error
+ */
+static int
+stream_pub_timer(void)
+{
+    struct timeval t;
+    struct timeval now;
+    long           ms = STREAM_PUB_RETRY_MS;
+
+    if (_pub_timer || _pub_posts == NULL)
+        return 0;
+    if (_pub_running){
+        curl_multi_timeout(_pub_multi, &ms);
+        if (ms < 0 || ms > STREAM_PUB_POLL_MS)
+            ms = STREAM_PUB_POLL_MS;
     }
-    if ((err = malloc(CURL_ERROR_SIZE)) == NULL) {
-        clixon_debug(CLIXON_DBG_STREAM, "malloc");
-        goto done;
+    gettimeofday(&now, NULL);
+    t.tv_sec = ms / 1000;
+    t.tv_usec = (ms % 1000) * 1000;
+    timeradd(&now, &t, &t);
+    if (clixon_event_reg_timeout(t, stream_pub_timeout, NULL, "stream publish") < 0)
+        return -1;
+    _pub_timer = 1;
+    return 0;
+}
+
+/*! Drive running publish posts, handle completed posts, and start pending posts
+ *
+ * A failed post is retried after STREAM_PUB_RETRY_MS, at most STREAM_PUB_RETRY_MAX times
+ * @param[in]  fd    Not used
+ * @param[in]  arg   Not used
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+stream_pub_timeout(int   fd,
+                   void *arg)
+{
+    int              retval = -1;
+    int              running;
+    int              nmsg;
+    CURLMsg         *msg;
+    struct pub_post *pp;
+    long             code = 0;
+    struct timeval   t;
+
+    _pub_timer = 0;
+    if (_pub_multi == NULL)
+        goto ok;
+    curl_multi_perform(_pub_multi, &running);
+    while ((msg = curl_multi_info_read(_pub_multi, &nmsg)) != NULL){
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&pp);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &code);
+        curl_multi_remove_handle(_pub_multi, pp->pp_curl);
+        curl_easy_cleanup(pp->pp_curl);
+        pp->pp_curl = NULL;
+        _pub_running--;
+        if (msg->data.result == CURLE_OK && code < 300){
+            DELQ(pp, _pub_posts, struct pub_post *);
+            _pub_nr--;
+            stream_pub_free(pp);
+            continue;
+        }
+        clixon_debug(CLIXON_DBG_STREAM, "curl %s: %s(%d) code:%ld",
+                     pp->pp_url, pp->pp_err, msg->data.result, code);
+        if (++pp->pp_tries > STREAM_PUB_RETRY_MAX){
+            clixon_debug(CLIXON_DBG_STREAM, "%s: %d events dropped", pp->pp_url, pp->pp_nr);
+            _pub_dropped += pp->pp_nr;
+            DELQ(pp, _pub_posts, struct pub_post *);
+            _pub_nr--;
+            stream_pub_free(pp);
+            continue;
+        }
+        gettimeofday(&pp->pp_next, NULL);
+        t.tv_sec = STREAM_PUB_RETRY_MS / 1000;
+        t.tv_usec = (STREAM_PUB_RETRY_MS % 1000) * 1000;
+        timeradd(&pp->pp_next, &t, &pp->pp_next);
     }
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_get_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &cb);
-    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, err);
-    curl_easy_setopt(curl, CURLOPT_POST, 1);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postfields);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, strlen(postfields));
-
-    if (clixon_debug_get())
-        curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);
-    if ((errcode = curl_easy_perform(curl)) != CURLE_OK){
-        clixon_debug(CLIXON_DBG_STREAM, "curl: %s(%d)", err, errcode);
-        retval = 0;
+    if (stream_pub_start() < 0)
         goto done;
-    }
-    if (getdata && cb.b_buf){
-        *getdata = cb.b_buf;
-        cb.b_buf = NULL;
-    }
-    retval = 1;
-  done:
-    if (err)
-        free(err);
-    if (cb.b_buf)
-        free(cb.b_buf);
-    if (curl)
-        curl_easy_cleanup(curl);   /* cleanup */
+    if (_pub_running)
+        curl_multi_perform(_pub_multi, &running);
+ ok:
+    retval = 0;
+ done:
+    if (stream_pub_timer() < 0)
+        retval = -1;
     return retval;
 }
 
 /*! Stream callback for example stream notification 
  *
- * Push via curl_post to publish stream event
+ * Queue event for publish via non-blocking curl POST, see stream_pub_timeout.
+ * The event is batched with earlier pending events of the stream, up to
+ * STREAM_PUB_BATCH_MAX events in one post.
+ * If STREAM_PUB_QUEUE_MAX posts are pending, the event is dropped
  * @param[in]  h     Clixon handle
  * @param[in]  op    Operation: 0 OK, 1 Close
  * @param[in]  event Event as XML
@@ -1045,15 +1406,14 @@ stream_publish_cb(clixon_handle h,
                   cxobj        *event,
                   void         *arg)
 {
-    int   retval = -1;
-    cbuf *u = NULL; /* stream pub (push) url */
-    cbuf *d = NULL; /* (XML) data to push */
-    char *pub_prefix;
-    char *result = NULL;
-    char *stream = (char*)arg;
+    int              retval = -1;
+    cbuf            *u = NULL; /* stream pub (push) url */
+    char            *pub_prefix;
+    char            *stream = (char*)arg;
+    struct pub_post *pp = NULL;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
-    if (op != 0)
+    if (op != 0 || _pub_multi == NULL)
         goto ok;
     /* Create pub url */
     if ((u = cbuf_new()) == NULL){
@@ -1065,28 +1425,51 @@ stream_publish_cb(clixon_handle h,
         goto done;
     }
     cprintf(u, "%s/%s", pub_prefix, stream);
+    /* Last post of the stream, append if not started and not full */
+    if ((pp = _pub_posts) != NULL){
+        do {
+            pp = PREVQ(struct pub_post *, pp);
+            if (strcmp(pp->pp_url, cbuf_get(u)) == 0)
+                break;
+        } while (pp != _pub_posts);
+        if (strcmp(pp->pp_url, cbuf_get(u)) != 0 ||
+            pp->pp_curl != NULL ||
+            pp->pp_tries != 0 ||
+            pp->pp_nr >= STREAM_PUB_BATCH_MAX)
+            pp = NULL;
+    }
+    if (pp == NULL){
+        if (_pub_nr >= STREAM_PUB_QUEUE_MAX){
+            if (_pub_dropped++ == 0)
+                clixon_log(h, LOG_WARNING, "%s: publish queue full, dropping events", __func__);
+            goto ok;
+        }
+        if ((pp = calloc(1, sizeof(*pp))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if ((pp->pp_url = strdup(cbuf_get(u))) == NULL ||
+            (pp->pp_data = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            stream_pub_free(pp);
+            goto done;
+        }
+        ADDQ(pp, _pub_posts);
+        _pub_nr++;
+    }
     /* Create XML data as string */
-    if ((d = cbuf_new()) == NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
+    if (clixon_xml2cbuf(pp->pp_data, event, 0, 0, NULL, -1, 0) < 0)
         goto done;
-    }
-    if (clixon_xml2cbuf(d, event, 0, 0, NULL, -1, 0) < 0)
+    pp->pp_nr++;
+    if (stream_pub_start() < 0)
         goto done;
-    if (url_post(cbuf_get(u),     /* url+stream */
-                 cbuf_get(d),     /* postfields */
-                 &result) < 0)    /* result as xml */
+    if (stream_pub_timer() < 0)
         goto done;
-    if (result)
-        clixon_debug(CLIXON_DBG_STREAM, "%s", result);
  ok:
     retval = 0;
  done:
     if (u)
         cbuf_free(u);
-    if (d)
-        cbuf_free(d);
-    if (result)
-        free(result);
     return retval;
 }
 #endif /* CLIXON_PUBLISH_STREAMS */
@@ -1122,6 +1505,10 @@ stream_publish_init()
         clixon_err(OE_PLUGIN, errno, "curl_global_init");
         goto done;
     }
+    if ((_pub_multi = curl_multi_init()) == NULL){
+        clixon_err(OE_PLUGIN, errno, "curl_multi_init");
+        goto done;
+    }
     retval = 0;
  done:
     return retval;
@@ -1134,6 +1521,24 @@ int
 stream_publish_exit()
 {
 #ifdef CLIXON_PUBLISH_STREAMS
+    struct pub_post *pp;
+
+    if (_pub_timer){
+        clixon_event_unreg_timeout(stream_pub_timeout, NULL);
+        _pub_timer = 0;
+    }
+    if (_pub_dropped)
+        clixon_debug(CLIXON_DBG_STREAM, "%" PRIu64 " events dropped", _pub_dropped);
+    while ((pp = _pub_posts) != NULL){
+        DELQ(pp, _pub_posts, struct pub_post *);
+        stream_pub_free(pp);
+    }
+    _pub_nr = 0;
+    _pub_running = 0;
+    if (_pub_multi){
+        curl_multi_cleanup(_pub_multi);
+        _pub_multi = NULL;
+    }
     curl_global_cleanup();
 #endif
     return 0;
@@ -44,6 +44,9 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <ctype.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -642,8 +645,54 @@ xml_chardata_encode(char      **escp,
     return retval;
 }
 
+/*! Return length of initial part of string without characters to escape in XML
+ *
+ * Scans 16 bytes at a time with SSE2 where available
+ * @param[in]  s      String
+ * @param[in]  len    Length of string
+ * @param[in]  quote  Also stop at ' and "
+ * @retval     n      Index of first of &<> (and '" if quote), or len if none
+ */
+static size_t
+xml_chardata_span(const char *s,
+                  size_t      len,
+                  int         quote)
+{
+    size_t i = 0;
+    char   c;
+#ifdef __SSE2__
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i apos = _mm_set1_epi8(quote?'\'':'&');
+    const __m128i quot = _mm_set1_epi8(quote?'"':'&');
+    __m128i       v;
+    __m128i       m;
+    int           mask;
+
+    while (len - i >= 16){
+        v = _mm_loadu_si128((const __m128i *)(s + i));
+        m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, lt)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, gt),
+                                      _mm_or_si128(_mm_cmpeq_epi8(v, apos), _mm_cmpeq_epi8(v, quot))));
+        if ((mask = _mm_movemask_epi8(m)) != 0)
+            return i + __builtin_ctz(mask);
+        i += 16;
+    }
+#endif
+    for (; i<len; i++){
+        c = s[i];
+        if (c == '&' || c == '<' || c == '>')
+            break;
+        if (quote && (c == '\'' || c == '"'))
+            break;
+    }
+    return i;
+}
+
 /*! Escape characters according to XML definition and append to cbuf
  *
+ * Runs of characters that need no escaping are appended in bulk
  * @param[in]   cb     CLIgen buf
  * @param[in]   quote  Also encode ' and " (eg for attributes)
  * @param[in]   str    Not-encoded input string
@@ -655,56 +704,54 @@ xml_chardata_cbuf_append(cbuf       *cb,
                          int         quote,
                          const char *str)
 {
-    int    retval = -1;
-    int    i;
-    int    cdata; /* when set, skip encoding */
-    size_t len;
+    int         retval = -1;
+    size_t      len;
+    size_t      n;
+    const char *s;
+    const char *e;
 
     /* The original of this code is in xml_chardata_encode */
-    /* Step: encode and expand str --> enc */
-    /* Same code again, but now actually encode into output buffer */
-    cdata = 0;
     len = strlen(str);
-    for (i=0; i<len; i++){
-        if (cdata){
-            if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-                cdata = 0;
-                cbuf_append(cb, str[i++]);
-                cbuf_append(cb, str[i++]);
-            }
-            cbuf_append(cb, str[i]);
-        }
-        else
-            switch (str[i]){
-            case '&':
-                cbuf_append_str(cb, "&amp;");
-                break;
-            case '<':
-                if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-                    cbuf_append(cb, str[i]);
-                    cdata++;
-                    break;
-                }
-                cbuf_append_str(cb, "&lt;");
+    while (len > 0){
+        if ((n = xml_chardata_span(str, len, quote)) > 0){
+            cbuf_append_buf(cb, (void *)str, n);
+            str += n;
+            len -= n;
+            if (len == 0)
                 break;
-            case '>':
-                cbuf_append_str(cb, "&gt;");
-                break;
-            case '\'':
-                if (quote)
-                    cbuf_append_str(cb, "&apos;");
-                else
-                    cbuf_append(cb, str[i]);
-                break;
-            case '"':
-                if (quote)
-                    cbuf_append_str(cb, "&quot;");
+        }
+        switch (*str){
+        case '&':
+            cbuf_append_str(cb, "&amp;");
+            break;
+        case '<':
+            if (strncmp(str, "<![CDATA[", strlen("<![CDATA[")) == 0){
+                /* Copy CDATA section including end as-is */
+                s = str + strlen("<![CDATA[");
+                if ((e = strstr(s, "]]>")) != NULL)
+                    e += strlen("]]>");
                 else
-                    cbuf_append(cb, str[i]);
-                break;
-            default:
-                cbuf_append(cb, str[i]);
+                    e = str + len;
+                n = e - str;
+                cbuf_append_buf(cb, (void *)str, n);
+                str += n;
+                len -= n;
+                continue;
             }
+            cbuf_append_str(cb, "&lt;");
+            break;
+        case '>':
+            cbuf_append_str(cb, "&gt;");
+            break;
+        case '\'':
+            cbuf_append_str(cb, "&apos;");
+            break;
+        case '"':
+            cbuf_append_str(cb, "&quot;");
+            break;
+        }
+        str++;
+        len--;
     }
     retval = 0;
     return retval;
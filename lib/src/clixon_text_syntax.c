@@ -74,6 +74,9 @@
 /* Size of json read buffer when reading from file*/
 #define BUFLEN 1024
 
+/* Flush text2file output buffer to the output function when it reaches this length */
+#define TEXT_FLUSH_LIMIT 65536
+
 /* Name of xml top object created by parse functions
  * See also DATASTORE_TOP_SYMBOL which is the clixon datastore top symbol. By default also config
  */
@@ -81,7 +84,18 @@
 #define TEXT_TOP_SYMBOL "top"
 
 /* Forward */
-static int text_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop);
+static int text_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop, int flag);
+
+/* Precomputed indentation, appended in chunks instead of printed with "%*s" */
+static const char text_indent[] = "                                                                ";
+
+/*! Cache of yang key leafs of the last list populated, see text_populate_list
+ */
+struct text_keys {
+    yang_stmt  *tk_ylist; /* Yang list of cached keys */
+    yang_stmt **tk_ykeys; /* Yang leafs of keys in key order */
+    int         tk_len;   /* Number of keys */
+};
 
 /*! x is element and has eactly one child which in turn has none
  *
@@ -189,9 +203,107 @@ text_wdef(cxobj            *x,
     return retval;
 }
 
+#ifndef TEXT_SYNTAX_NOPREFIX
+static char *
+get_prefix(yang_stmt *yn)
+{
+    char      *prefix = NULL;
+    yang_stmt *yp = NULL;
+    yang_stmt *ymod;
+    yang_stmt *ypmod;
+
+    /* Find out prefix if needed: topmost or new module a la API-PATH */
+    if (ys_real_module(yn, &ymod) < 0)
+        return NULL;
+    if ((yp = yang_parent_get(yn)) != NULL &&
+        yp != ymod){
+        if (ys_real_module(yp, &ypmod) < 0)
+            return NULL;
+        if (ypmod != ymod)
+            prefix = yang_argument_get(ymod);
+    }
+    else
+        prefix = yang_argument_get(ymod);
+    return prefix;
+}
+#endif
+
+/*! Name is one of the keys of a list
+ *
+ * Same as yang_key_match but using the cached key vector of the list
+ * @param[in]  cvk   Vector of list keys, see yang_cvec_get
+ * @param[in]  name  Name of child
+ * @retval     1     Name is a key
+ * @retval     0     Name is not a key
+ */
+static int
+text_key_match(cvec *cvk,
+               char *name)
+{
+    cg_var *cvi = NULL;
+
+    while ((cvi = cvec_each(cvk, cvi)) != NULL)
+        if (strcmp(name, cv_string_get(cvi)) == 0)
+            return 1;
+    return 0;
+}
+
+/*! Append indentation of n spaces to buffer
+ */
+static int
+text_indent_append(cbuf *cb,
+                   int   n)
+{
+    int len;
+
+    while (n > 0){
+        len = n < (int)sizeof(text_indent)-1 ? n : (int)sizeof(text_indent)-1;
+        if (cbuf_append_buf(cb, (void*)text_indent, len) < 0)
+            return -1;
+        n -= len;
+    }
+    return 0;
+}
+
+/*! Append a body value to buffer, quoted if it contains spaces
+ */
+static int
+text_value_append(cbuf *cb,
+                  char *value)
+{
+    if (index(value, ' ') == NULL)
+        return cbuf_append_str(cb, value);
+    cbuf_append(cb, '"');
+    cbuf_append_str(cb, value);
+    return cbuf_append(cb, '"');
+}
+
+/*! Write the text2file buffer using the output function and reset it
+ *
+ * @param[in,out] cb    Output buffer
+ * @param[in]     fn    Callback to make print function
+ * @param[in]     f     File to print to
+ */
+static void
+text_flush(cbuf             *cb,
+           clicon_output_cb *fn,
+           FILE             *f)
+{
+    if (cbuf_len(cb) == 0)
+        return;
+    if (fn == fprintf)
+        fwrite(cbuf_get(cb), 1, cbuf_len(cb), f);
+    else
+        (*fn)(f, "%s", cbuf_get(cb));
+    cbuf_reset(cb);
+}
+
 /*! Translate XML to a "pseudo-code" textual format using a callback - internal function
  *
+ * Output is appended to a buffer that is flushed to the print function in large chunks,
+ * instead of one print call per token.
  * @param[in]     xn       XML object to print
+ * @param[in,out] cb       Output buffer, flushed when it reaches TEXT_FLUSH_LIMIT
  * @param[in]     fn       Callback to make print function
  * @param[in]     f        File to print to
  * @param[in]     level    Print PRETTYPRINT_INDENT spaces per level in front of each line
@@ -209,6 +321,7 @@ text_wdef(cxobj            *x,
  */
 static int
 text2file(cxobj            *xn,
+          cbuf             *cb,
           clicon_output_cb *fn,
           FILE             *f,
           int               level,
@@ -222,21 +335,21 @@ text2file(cxobj            *xn,
     cxobj     *xc = NULL;
     int        children=0;
     yang_stmt *yn;
-    char      *value;
+    int        isleafl = 0; /* xn is a leaf-list entry */
     cg_var    *cvi;
     cvec      *cvk = NULL; /* vector of index keys */
-    cbuf      *cbb = NULL;
+    int        istleaf;
     int        ret;
 #ifndef TEXT_SYNTAX_NOPREFIX
-    yang_stmt *yp = NULL;
-    yang_stmt *ymod;
-    yang_stmt *ypmod;
-    char      *prefix = NULL;
+    char      *prefix;
 #endif
+
     if (xn == NULL || fn == NULL){
         clixon_err(OE_XML, EINVAL, "xn or fn is NULL");
         goto done;
     }
+    if (cbuf_len(cb) >= TEXT_FLUSH_LIMIT)
+        text_flush(cb, fn, f);
     if ((yn = xml_spec(xn)) != NULL){
         if ((ret = text_wdef(xn, yn, wdef)) < 0)
             goto done;
@@ -249,34 +362,28 @@ text2file(cxobj            *xn,
             if (ret)
                 goto ok;
         }
-#ifndef TEXT_SYNTAX_NOPREFIX
-        /* Find out prefix if needed: topmost or new module a la API-PATH */
-        if (ys_real_module(yn, &ymod) < 0)
-            goto done;
-        if ((yp = yang_parent_get(yn)) != NULL &&
-            yp != ymod){
-            if (ys_real_module(yp, &ypmod) < 0)
-                goto done;
-            if (ypmod != ymod)
-                prefix = yang_argument_get(ymod);
-        }
-        else
-            prefix = yang_argument_get(ymod);
-#endif
-        if (yang_keyword_get(yn) == Y_LIST){
+        switch (yang_keyword_get(yn)){
+        case Y_LIST:
             if ((cvk = yang_cvec_get(yn)) == NULL){
                 clixon_err(OE_YANG, 0, "No keys");
                 goto done;
             }
+            break;
+        case Y_LEAF_LIST:
+            isleafl = 1;
+            break;
+        default:
+            break;
         }
     }
     if (*leafl && yn){
-        if (yang_keyword_get(yn) == Y_LEAF_LIST && strcmp(*leaflname, yang_argument_get(yn)) == 0)
+        if (isleafl && strcmp(*leaflname, yang_argument_get(yn)) == 0)
             ;
         else{
             *leafl = 0;
             *leaflname = NULL;
-            (*fn)(f, "%*s]\n", PRETTYPRINT_INDENT*(level), "");
+            text_indent_append(cb, PRETTYPRINT_INDENT*level);
+            cbuf_append_str(cb, "]\n");
         }
     }
     xc = NULL;     /* count children (elements and bodies, not attributes) */
@@ -285,30 +392,28 @@ text2file(cxobj            *xn,
             children++;
     if (children == 0){ /* If no children print line */
         switch (xml_type(xn)){
-        case CX_BODY:{
-            if ((cbb = cbuf_new()) == NULL){
-                clixon_err(OE_UNIX, errno, "cbuf_new");
-                goto done;
+        case CX_BODY:
+            if (*leafl){                           /* Skip keyword if leaflist */
+                text_indent_append(cb, PRETTYPRINT_INDENT*level);
+                text_value_append(cb, xml_value(xn));
+                cbuf_append(cb, '\n');
+            }
+            else{
+                text_value_append(cb, xml_value(xn));
+                cbuf_append_str(cb, ";\n");
             }
-            value = xml_value(xn);
-            if (index(value, ' ') != NULL)
-                cprintf(cbb, "\"%s\"", value);
-            else
-                cprintf(cbb, "%s", value);
-            if (*leafl)                            /* Skip keyword if leaflist */
-                (*fn)(f, "%*s%s\n", PRETTYPRINT_INDENT*level, "", cbuf_get(cbb));
-            else
-                (*fn)(f, "%s;\n", cbuf_get(cbb));
             break;
-        }
         case CX_ELMNT:
-            (*fn)(f, "%*s%s", PRETTYPRINT_INDENT*level, "", xml_name(xn));
+            text_indent_append(cb, PRETTYPRINT_INDENT*level);
+            cbuf_append_str(cb, xml_name(xn));
             cvi = NULL;             /* Lists only */
             while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-                if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL)
-                    (*fn)(f, " %s", xml_body(xc));
+                if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL){
+                    cbuf_append(cb, ' ');
+                    cbuf_append_str(cb, xml_body(xc));
+                }
             }
-            (*fn)(f, ";\n");
+            cbuf_append_str(cb, ";\n");
             break;
         default:
             break;
@@ -316,79 +421,59 @@ text2file(cxobj            *xn,
         goto ok;
     }
     if (*leafl == 0){
-        (*fn)(f, "%*s", PRETTYPRINT_INDENT*level, "");
+        text_indent_append(cb, PRETTYPRINT_INDENT*level);
 #ifndef TEXT_SYNTAX_NOPREFIX
-        if (prefix)
-            (*fn)(f, "%s:", prefix);
+        if (yn && (prefix = get_prefix(yn)) != NULL){
+            cbuf_append_str(cb, prefix);
+            cbuf_append(cb, ':');
+        }
 #endif
-        (*fn)(f, "%s", xml_name(xn));
+        cbuf_append_str(cb, xml_name(xn));
     }
     cvi = NULL;         /* Lists only */
     while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL)
-            (*fn)(f, " %s", xml_body(xc));
-    }
-    if (yn && yang_keyword_get(yn) == Y_LEAF_LIST && *leafl){
-        ;
+        if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL){
+            cbuf_append(cb, ' ');
+            cbuf_append_str(cb, xml_body(xc));
+        }
     }
-    else if (yn && yang_keyword_get(yn) == Y_LEAF_LIST && *leafl == 0){
-        *leafl = 1;
-        *leaflname = yang_argument_get(yn);
-        (*fn)(f, " [\n");
+    istleaf = tleaf(xn);
+    if (isleafl){
+        if (*leafl == 0){
+            *leafl = 1;
+            *leaflname = yang_argument_get(yn);
+            cbuf_append_str(cb, " [\n");
+        }
     }
-    else if (!tleaf(xn))
-        (*fn)(f, " {\n");
+    else if (!istleaf)
+        cbuf_append_str(cb, " {\n");
     else
-        (*fn)(f, " ");
+        cbuf_append(cb, ' ');
     xc = NULL;
     while ((xc = xml_child_each(xn, xc, -1)) != NULL){
         if (xml_type(xc) == CX_ELMNT || xml_type(xc) == CX_BODY){
-            if (yn && yang_key_match(yn, xml_name(xc), NULL))
+            if (cvk && xml_type(xc) == CX_ELMNT && text_key_match(cvk, xml_name(xc)))
                 continue; /* Skip keys, already printed */
-            if (text2file(xc, fn, f, level+1, autocliext, wdef, leafl, leaflname) < 0)
-                break;
+            if (text2file(xc, cb, fn, f, level+1, autocliext, wdef, leafl, leaflname) < 0)
+                goto done;
         }
     }
     /* Stop leaf-list printing (ie []) if no longer leaflist and same name */
-    if (yn && yang_keyword_get(yn) != Y_LEAF_LIST && *leafl != 0){
+    if (yn && !isleafl && *leafl != 0){
         *leafl = 0;
-        (*fn)(f, "%*s]\n", PRETTYPRINT_INDENT*(level+1), "");
+        text_indent_append(cb, PRETTYPRINT_INDENT*(level+1));
+        cbuf_append_str(cb, "]\n");
+    }
+    if (!istleaf){
+        text_indent_append(cb, PRETTYPRINT_INDENT*level);
+        cbuf_append_str(cb, "}\n");
     }
-    if (!tleaf(xn))
-        (*fn)(f, "%*s}\n", PRETTYPRINT_INDENT*level, "");
  ok:
     retval = 0;
  done:
-    if (cbb)
-        cbuf_free(cbb);
     return retval;
 }
 
-#ifndef TEXT_SYNTAX_NOPREFIX
-static char *
-get_prefix(yang_stmt *yn)
-{
-    char      *prefix = NULL;
-    yang_stmt *yp = NULL;
-    yang_stmt *ymod;
-    yang_stmt *ypmod;
-
-    /* Find out prefix if needed: topmost or new module a la API-PATH */
-    if (ys_real_module(yn, &ymod) < 0)
-        return NULL;
-    if ((yp = yang_parent_get(yn)) != NULL &&
-        yp != ymod){
-        if (ys_real_module(yp, &ypmod) < 0)
-            return NULL;
-        if (ypmod != ymod)
-            prefix = yang_argument_get(ymod);
-    }
-    else
-        prefix = yang_argument_get(ymod);
-    return prefix;
-}
-#endif
-
 /*! Translate XML to a "pseudo-code" textual format using a callback - internal function
  *
  * @param[in]     xn       XML object to print
@@ -422,12 +507,11 @@ text2cbuf(cbuf             *cb,
     cxobj     *xc = NULL;
     int        children=0;
     yang_stmt *yn;
-    char      *value;
     cg_var    *cvi;
     cvec      *cvk = NULL; /* vector of index keys */
-    cbuf      *cbb = NULL;
     int        level1;
     char      *prefix = NULL;
+    int        istleaf;
     int        ret;
 
     if (xn == NULL || cb == NULL){
@@ -476,25 +560,19 @@ text2cbuf(cbuf             *cb,
             children++;
     if (children == 0){ /* If no children print line */
         switch (xml_type(xn)){
-        case CX_BODY:{
-            if ((cbb = cbuf_new()) == NULL){
-                clixon_err(OE_UNIX, errno, "cbuf_new");
-                goto done;
-            }
-            value = xml_value(xn);
-            if (index(value, ' ') != NULL)
-                cprintf(cbb, "\"%s\"", value);
-            else
-                cprintf(cbb, "%s", value);
+        case CX_BODY:
             if (*leafl){                            /* Skip keyword if leaflist */
                 if (prepend)
                     cprintf(cb, "%s", prepend);
-                cprintf(cb, "%*s%s\n", level1, "", cbuf_get(cbb));
+                cprintf(cb, "%*s", level1, "");
+                text_value_append(cb, xml_value(xn));
+                cbuf_append(cb, '\n');
+            }
+            else{
+                text_value_append(cb, xml_value(xn));
+                cbuf_append_str(cb, ";\n");
             }
-            else
-                cprintf(cb, "%s;\n", cbuf_get(cbb));
             break;
-        }
         case CX_ELMNT:
             if (prepend)
                 cprintf(cb, "%s", prepend);
@@ -524,6 +602,7 @@ text2cbuf(cbuf             *cb,
         if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL)
             cprintf(cb, " %s", xml_body(xc));
     }
+    istleaf = tleaf(xn);
     if (yn && yang_keyword_get(yn) == Y_LEAF_LIST && *leafl){
         ;
     }
@@ -532,14 +611,14 @@ text2cbuf(cbuf             *cb,
         *leaflname = yang_argument_get(yn);
         cprintf(cb, " [\n");
     }
-    else if (!tleaf(xn))
+    else if (!istleaf)
         cprintf(cb, " {\n");
     else
         cprintf(cb, " ");
     xc = NULL;
     while ((xc = xml_child_each(xn, xc, -1)) != NULL){
         if (xml_type(xc) == CX_ELMNT || xml_type(xc) == CX_BODY){
-            if (yn && yang_key_match(yn, xml_name(xc), NULL))
+            if (cvk && xml_type(xc) == CX_ELMNT && text_key_match(cvk, xml_name(xc)))
                 continue; /* Skip keys, already printed */
             if (text2cbuf(cb, xc, level+1, prepend, autocliext, wdef, leafl, leaflname) < 0)
                 break;
@@ -552,7 +631,7 @@ text2cbuf(cbuf             *cb,
             cprintf(cb, "%s", prepend);
         cprintf(cb, "%*s\n", level1 + PRETTYPRINT_INDENT, "]");
     }
-    if (!tleaf(xn)){
+    if (!istleaf){
         if (prepend)
             cprintf(cb, "%s", prepend);
         cprintf(cb, "%*s}\n", level1, "");
@@ -560,8 +639,6 @@ text2cbuf(cbuf             *cb,
  ok:
     retval = 0;
  done:
-    if (cbb)
-        cbuf_free(cbb);
     return retval;
 }
 
@@ -588,21 +665,29 @@ clixon_text2file(FILE             *f,
     cxobj *xc;
     int    leafl = 0;
     char  *leaflname = NULL;
+    cbuf  *cb = NULL;
 
     if (fn == NULL)
         fn = fprintf;
+    if ((cb = cbuf_new_alloc(TEXT_FLUSH_LIMIT)) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
+        goto done;
+    }
     if (skiptop){
         xc = NULL;
         while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (text2file(xc, fn, f, level, autocliext, WITHDEFAULTS_EXPLICIT, &leafl, &leaflname) < 0)
+            if (text2file(xc, cb, fn, f, level, autocliext, WITHDEFAULTS_EXPLICIT, &leafl, &leaflname) < 0)
                 goto done;
     }
     else {
-        if (text2file(xn, fn, f, level, autocliext, WITHDEFAULTS_EXPLICIT, &leafl, &leaflname) < 0)
+        if (text2file(xn, cb, fn, f, level, autocliext, WITHDEFAULTS_EXPLICIT, &leafl, &leaflname) < 0)
             goto done;
     }
+    text_flush(cb, fn, f);
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
@@ -677,6 +762,7 @@ text_diff_keys(cbuf      *cb,
  * @param[in]  yc      Yang of x0c/x1c
  * @param[in]  level   How many spaces to insert before each line
  * @param[in]  skiptop  0: Include top object 1: Skip top-object, only children,
+ * @param[in]  flag    If set, only descend into nodes of x1 marked with flag
  * @retval     0       Ok
  * @retval    -1       Error
  * @see xml_diff_ordered_by_user
@@ -690,7 +776,8 @@ text_diff2cbuf_ordered_by_user(cbuf      *cb,
                                cxobj     *x1c,
                                yang_stmt *yc,
                                int        level,
-                               int        skiptop)
+                               int        skiptop,
+                               int        flag)
 {
     int    retval = 1;
     cxobj *xi;
@@ -712,7 +799,7 @@ text_diff2cbuf_ordered_by_user(cbuf      *cb,
                 /* Unmark node in x0 and x1 */
                 xml_flag_reset(xi, XML_FLAG_DEL);
                 xml_flag_reset(xj, XML_FLAG_ADD);
-                if (text_diff2cbuf(cb, xi, xj, level+1, 0) < 0)
+                if (text_diff2cbuf(cb, xi, xj, level+1, 0, flag) < 0)
                     goto done;
                 break;
             }
@@ -737,7 +824,7 @@ text_diff2cbuf_ordered_by_user(cbuf      *cb,
  * @param[in]  x1      Second XML tree
  * @param[in]  level   How many spaces to insert before each line
  * @param[in]  skiptop 0: Include top object 1: Skip top-object, only children,
-
+ * @param[in]  flag    If set, only descend into nodes of x1 marked with flag
  * @retval     0       OK
  * @retval    -1       Error
  * @cod
@@ -766,7 +853,8 @@ text_diff2cbuf(cbuf             *cb,
                cxobj            *x0,
                cxobj            *x1,
                int               level,
-               int               skiptop)
+               int               skiptop,
+               int               flag)
 {
     int        retval = -1;
     cxobj     *x0c = NULL; /* x0 child */
@@ -864,7 +952,7 @@ text_diff2cbuf(cbuf             *cb,
         b1 = xml_body(x1c);
         if (eq && y0c && y1c && y0c == y1c && yang_find(y0c, Y_ORDERED_BY, "user")){
             if (text_diff2cbuf_ordered_by_user(cb, x0, x1, x0c, x1c, y0c,
-                                               level, skiptop) < 0)
+                                               level, skiptop, flag) < 0)
                 goto done;
             /* Add all in x0 marked as DELETE in x0vec
              * Flags can remain: XXX should apply to all
@@ -944,7 +1032,9 @@ text_diff2cbuf(cbuf             *cb,
             continue;
         }
         else{ /* equal */
-            if (y0c && y1c && y0c != y1c){ /* choice */
+            if (flag && xml_flag(x1c, flag) == 0)
+                ; /* Not marked: equal subtrees */
+            else if (y0c && y1c && y0c != y1c){ /* choice */
                 if (nr==0 && skiptop==0){
                     cprintf(cb, "%*s", level1, "");
                     if (prefix)
@@ -990,7 +1080,7 @@ text_diff2cbuf(cbuf             *cb,
                     cprintf(cb, "+%*s%s \"%s\";\n", level1+PRETTYPRINT_INDENT-1, "", xml_name(x1c), b1);
                 }
             }
-            else if (text_diff2cbuf(cb, x0c, x1c, level+1, 0) < 0)
+            else if (text_diff2cbuf(cb, x0c, x1c, level+1, 0, flag) < 0)
                 goto done;
         }
         /* Get next */
@@ -1025,7 +1115,27 @@ clixon_text_diff2cbuf(cbuf  *cb,
                      cxobj  *x0,
                      cxobj  *x1)
 {
-    return text_diff2cbuf(cb, x0, x1, 0, 1);
+    return text_diff2cbuf(cb, x0, x1, 0, 1, 0);
+}
+
+/*! Print TEXT diff of two cxobj trees into a cbuf, where changes in the second are marked
+ *
+ * Same as clixon_text_diff2cbuf but only descend into nodes of x1 that are marked with flag.
+ * @param[out] cb      CLIgen buffer
+ * @param[in]  x0      First XML tree
+ * @param[in]  x1      Second XML tree, changed nodes and their ancestors marked with flag
+ * @param[in]  flag    Flag marking changed nodes in x1, eg XML_FLAG_EDIT
+ * @retval     0       Ok
+ * @retval    -1       Error
+ * @see clixon_xml_diff2cbuf_marked
+ */
+int
+clixon_text_diff2cbuf_marked(cbuf  *cb,
+                             cxobj *x0,
+                             cxobj *x1,
+                             int    flag)
+{
+    return text_diff2cbuf(cb, x0, x1, 0, 1, flag);
 }
 
 /*! Look for YANG lists nodes and convert bodies to keys
@@ -1042,25 +1152,42 @@ clixon_text_diff2cbuf(cbuf  *cb,
  * @see text_mark_bodies where marking of bodies made transformed here
  */
 static int
-text_populate_list(cxobj *xn)
+text_populate_list(cxobj            *xn,
+                   struct text_keys *tk)
 {
     int        retval = -1;
     yang_stmt *yn;
-    yang_stmt *yc;
     cxobj     *xc;
     cxobj     *xb;
     cvec      *cvk; /* vector of index keys */
     cg_var    *cvi = NULL;
     char      *namei;
+    int        i;
 
     if ((yn = xml_spec(xn)) == NULL)
         goto ok;
     if (yang_keyword_get(yn) == Y_LIST){
         cvk = yang_cvec_get(yn);
+        /* Look up key leafs once for consecutive entries of the same list */
+        if (tk->tk_ylist != yn){
+            if (tk->tk_len < cvec_len(cvk)){
+                if ((tk->tk_ykeys = realloc(tk->tk_ykeys, cvec_len(cvk)*sizeof(yang_stmt*))) == NULL){
+                    clixon_err(OE_UNIX, errno, "realloc");
+                    goto done;
+                }
+            }
+            tk->tk_len = cvec_len(cvk);
+            i = 0;
+            while ((cvi = cvec_each(cvk, cvi)) != NULL)
+                tk->tk_ykeys[i++] = yang_find(yn, Y_LEAF, cv_string_get(cvi));
+            tk->tk_ylist = yn;
+        }
         /* Loop over bodies and keys and create key leafs
+         * The tree is sorted after parsing, see _text_syntax_parse
          */
         cvi = NULL;
         xb = NULL;
+        i = 0;
         while ((xb = xml_find_type(xn, NULL, NULL, CX_BODY)) != NULL) {
             if (!xml_flag(xb, XML_FLAG_BODYKEY))
                 continue;
@@ -1072,18 +1199,15 @@ text_populate_list(cxobj *xn)
             namei = cv_string_get(cvi);
             if ((xc = xml_new(namei, xn, CX_ELMNT)) == NULL)
                 goto done;
-            yc = yang_find(yn, Y_LEAF, namei);
-            xml_spec_set(xc, yc);
+            xml_spec_set(xc, tk->tk_ykeys[i++]);
             if ((xml_addsub(xc, xb)) < 0)
                 goto done;
 
         }
-        if (xml_sort(xn) < 0)
-            goto done;
     }
     xc = NULL;
     while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL) {
-        if (text_populate_list(xc) < 0)
+        if (text_populate_list(xc, tk) < 0)
             goto done;
     }
  ok:
@@ -1120,6 +1244,7 @@ _text_syntax_parse(char      *str,
     cbuf                   *cberr = NULL;
     int                     failed = 0; /* yang assignment */
     cxobj                  *xc;
+    struct text_keys        tk = {0,};
 
     if (clixon_debug_get() & CLIXON_DBG_DETAIL)
         clixon_debug(CLIXON_DBG_PARSE|CLIXON_DBG_DETAIL, "%s", str);
@@ -1168,7 +1293,7 @@ _text_syntax_parse(char      *str,
         /* Look for YANG lists nodes and convert bodies to keys */
         xc = NULL;
         while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
-            if (text_populate_list(xc) < 0)
+            if (text_populate_list(xc, &tk) < 0)
                 goto done;
     }
     if (failed)
@@ -1184,6 +1309,8 @@ _text_syntax_parse(char      *str,
     clixon_debug(CLIXON_DBG_PARSE|CLIXON_DBG_DETAIL, "retval:%d", retval);
     if (cberr)
         cbuf_free(cberr);
+    if (tk.tk_ykeys)
+        free(tk.tk_ykeys);
     clixon_text_syntax_parsel_exit(&ts);
     return retval;
  fail: /* invalid */
@@ -1268,11 +1395,8 @@ clixon_text_syntax_parse_file(FILE      *fp,
     int       retval = -1;
     int       ret;
     char     *textbuf = NULL;
-    int       textbuflen = BUFLEN; /* start size */
-    int       oldtextbuflen;
-    char     *ptr;
-    char      ch;
-    int       len = 0;
+    size_t    textbuflen = BUFLEN; /* start size */
+    size_t    len = 0;
     size_t    sz;
 
     if (xt == NULL){
@@ -1283,40 +1407,35 @@ clixon_text_syntax_parse_file(FILE      *fp,
         clixon_err(OE_XML, errno, "malloc");
         goto done;
     }
-    memset(textbuf, 0, textbuflen);
-    ptr = textbuf;
+    /* Read the whole file in blocks, not char by char */
     while (1){
-        sz = fread(&ch, 1, 1, fp);
-        if (sz == 1){
-            textbuf[len++] = ch;
-        }
-        else if (sz == 0 && feof(fp)){
-            if (*xt == NULL)
-                if ((*xt = xml_new(TEXT_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if (len){
-                if ((ret = _text_syntax_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
+        sz = fread(textbuf+len, 1, textbuflen-len-1, fp); /* Space: one for the null character */
+        len += sz;
+        if (sz == 0){
+            if (ferror(fp)){
+                clixon_err(OE_XML, errno, "fread");
+                goto done;
             }
             break;
         }
-        else {
-            clixon_err(OE_XML, 0, "fread %lu", sz);
-            goto done;
-        }
-        if (len >= textbuflen-1){ /* Space: one for the null character */
-            oldtextbuflen = textbuflen;
+        if (len >= textbuflen-1){
             textbuflen *= 2;
             if ((textbuf = realloc(textbuf, textbuflen)) == NULL){
                 clixon_err(OE_XML, errno, "realloc");
                 goto done;
             }
-            memset(textbuf+oldtextbuflen, 0, textbuflen-oldtextbuflen);
-            ptr = textbuf;
         }
     }
+    textbuf[len] = '\0';
+    if (*xt == NULL)
+        if ((*xt = xml_new(TEXT_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if (len){
+        if ((ret = _text_syntax_parse(textbuf, yb, yspec, *xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
     retval = 1;
  done:
     if (retval < 0 && *xt){
@@ -0,0 +1,444 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * Request tracing across frontends and backend
+ * A trace is started by a frontend for a request, eg by restconf for a HTTP request,
+ * either from a W3C traceparent of the request or as a new sampled trace, see
+ * CLICON_TRACE_SAMPLE. Nested spans are opened and closed around parts of the request,
+ * and the context of the innermost span is propagated to the backend as a traceparent
+ * attribute of the internal rpc, where the backend continues the trace with its own
+ * spans for the rpc, commit and plugin callbacks.
+ * Each span is written when it ends as one line of JSON in CLICON_TRACE_FILE, with field
+ * names as in OpenTelemetry (OTLP/JSON) spans, so that the spans of all processes can be
+ * merged by trace id. Tracing is disabled if CLICON_TRACE_FILE is not set.
+ * Only one trace is active at a time in a thread, which fits the event loop of the backend
+ * and frontends. Spans of a trace are only opened in the thread that started it, eg
+ * callbacks in worker threads are not traced.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <time.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_options.h"
+#include "clixon_trace.h"
+
+/*
+ * Types
+ */
+/*! Open span, stacked with the innermost span on top
+ */
+struct trace_span {
+    struct trace_span *sp_parent;     /* Enclosing span in this process, or NULL */
+    char               sp_trace[33];  /* Trace id, 32 hex digits */
+    char               sp_id[17];     /* Span id, 16 hex digits */
+    char               sp_pid[17];    /* Parent span id, possibly in another process, or "" */
+    char              *sp_name;       /* Name of span */
+    char              *sp_detail;     /* Detail attribute, or NULL */
+    uint64_t           sp_start;      /* Start time in ns since epoch */
+};
+
+/*
+ * Variables
+ */
+/* Innermost open span of this thread, NULL if no trace is active */
+static __thread struct trace_span *_trace_span = NULL;
+/* Span export file, opened at first trace */
+static FILE              *_trace_f = NULL;
+/* State of random generator of ids */
+static uint64_t           _trace_rand = 0;
+
+/*! Time now in ns since epoch
+ */
+static uint64_t
+trace_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+/*! Pseudo-random 64-bit number, xorshift seeded by time and pid
+ *
+ * Ids only need to be unique, not unpredictable
+ */
+static uint64_t
+trace_random(void)
+{
+    uint64_t x;
+
+    if (_trace_rand == 0)
+        _trace_rand = trace_now() ^ ((uint64_t)getpid() << 32) ^ 0x9e3779b97f4a7c15ULL;
+    x = _trace_rand;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    _trace_rand = x;
+    return x;
+}
+
+/*! Check that a string is n lower-case hex digits and not all zero
+ */
+static int
+trace_hex_ok(const char *s,
+             int         n)
+{
+    int i;
+    int nonzero = 0;
+
+    for (i=0; i<n; i++){
+        if (!isxdigit(s[i]) || isupper(s[i]))
+            return 0;
+        if (s[i] != '0')
+            nonzero++;
+    }
+    return nonzero != 0;
+}
+
+/*! Parse W3C traceparent: "00-<trace-id>-<parent-id>-<flags>"
+ *
+ * @param[in]  traceparent  Traceparent string
+ * @param[out] trace        Trace id, 33 bytes
+ * @param[out] parent       Parent span id, 17 bytes
+ * @param[out] sampled      Sampled flag
+ * @retval     1            OK
+ * @retval     0            Invalid, ignore
+ */
+static int
+trace_parent_parse(const char *traceparent,
+                   char       *trace,
+                   char       *parent,
+                   int        *sampled)
+{
+    unsigned flags;
+
+    if (strlen(traceparent) < 55 ||
+        strncmp(traceparent, "00-", 3) != 0 ||
+        traceparent[35] != '-' || traceparent[52] != '-')
+        return 0;
+    if (!trace_hex_ok(traceparent+3, 32) ||
+        !trace_hex_ok(traceparent+36, 16) ||
+        !isxdigit(traceparent[53]) || !isxdigit(traceparent[54]))
+        return 0;
+    memcpy(trace, traceparent+3, 32);
+    trace[32] = '\0';
+    memcpy(parent, traceparent+36, 16);
+    parent[16] = '\0';
+    if (sscanf(traceparent+53, "%2x", &flags) != 1)
+        return 0;
+    *sampled = flags & 0x01;
+    return 1;
+}
+
+/*! Push a new span
+ *
+ * @param[in]  trace   Trace id
+ * @param[in]  pid     Parent span id or ""
+ * @param[in]  name    Name of span
+ * @param[in]  detail  Detail attribute or NULL
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+trace_span_push(const char *trace,
+                const char *pid,
+                const char *name,
+                const char *detail)
+{
+    struct trace_span *sp;
+
+    if ((sp = calloc(1, sizeof(*sp))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    strncpy(sp->sp_trace, trace, sizeof(sp->sp_trace)-1);
+    strncpy(sp->sp_pid, pid, sizeof(sp->sp_pid)-1);
+    snprintf(sp->sp_id, sizeof(sp->sp_id), "%016" PRIx64, trace_random());
+    if ((sp->sp_name = strdup(name)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(sp);
+        return -1;
+    }
+    if (detail && (sp->sp_detail = strdup(detail)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(sp->sp_name);
+        free(sp);
+        return -1;
+    }
+    sp->sp_start = trace_now();
+    sp->sp_parent = _trace_span;
+    _trace_span = sp;
+    return 0;
+}
+
+/*! Free a span
+ */
+static void
+trace_span_free(struct trace_span *sp)
+{
+    if (sp->sp_name)
+        free(sp->sp_name);
+    if (sp->sp_detail)
+        free(sp->sp_detail);
+    free(sp);
+}
+
+/*! Print a JSON string with escapes
+ */
+static void
+trace_json_str(cbuf       *cb,
+               const char *str)
+{
+    const char *s;
+
+    cprintf(cb, "\"");
+    for (s = str; *s; s++){
+        if (*s == '"' || *s == '\\')
+            cprintf(cb, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            cprintf(cb, "\\u%04x", (unsigned char)*s);
+        else
+            cprintf(cb, "%c", *s);
+    }
+    cprintf(cb, "\"");
+}
+
+/*! Start a trace for a request, or continue a trace from another process
+ *
+ * If traceparent is given and valid, the trace continues with a span whose parent is
+ * the span of traceparent, and only if traceparent is sampled.
+ * Otherwise a new trace is sampled by CLICON_TRACE_SAMPLE percent.
+ * If a trace is already active, a nested span is begun instead.
+ * End the trace with clixon_trace_stop.
+ * @param[in]  h            Clixon handle
+ * @param[in]  traceparent  W3C traceparent of request, or NULL
+ * @param[in]  name         Name of span
+ * @param[in]  detail       Detail attribute of span, or NULL
+ * @retval     1            Trace started
+ * @retval     0            Not traced, tracing disabled or not sampled
+ * @retval    -1            Error
+ */
+int
+clixon_trace_start(clixon_handle h,
+                   const char   *traceparent,
+                   const char   *name,
+                   const char   *detail)
+{
+    char  *file;
+    char   trace[33] = {0,};
+    char   pid[17] = {0,};
+    int    sampled = 0;
+
+    if ((file = clicon_option_str(h, "CLICON_TRACE_FILE")) == NULL)
+        return 0;
+    if (_trace_span != NULL)
+        return clixon_trace_span_begin(name, detail);
+    if (traceparent && trace_parent_parse(traceparent, trace, pid, &sampled) == 1){
+        if (!sampled)
+            return 0;
+    }
+    else {
+        if (trace_random() % 100 >= (uint64_t)clicon_option_int(h, "CLICON_TRACE_SAMPLE"))
+            return 0;
+        snprintf(trace, sizeof(trace), "%016" PRIx64 "%016" PRIx64, trace_random(), trace_random());
+        pid[0] = '\0';
+    }
+    if (_trace_f == NULL &&
+        (_trace_f = fopen(file, "a")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen %s", file);
+        return -1;
+    }
+    if (trace_span_push(trace, pid, name, detail) < 0)
+        return -1;
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "trace %s span %s %s",
+                 _trace_span->sp_trace, _trace_span->sp_id, name);
+    return 1;
+}
+
+/*! Check if a trace is active
+ *
+ * @retval  1  A trace is active in this thread, spans may be begun
+ * @retval  0  No trace
+ */
+int
+clixon_trace_active(void)
+{
+    return _trace_span != NULL;
+}
+
+/*! Begin a span nested in the innermost span of the active trace
+ *
+ * End the span with clixon_trace_span_end
+ * @param[in]  name    Name of span
+ * @param[in]  detail  Detail attribute of span, or NULL
+ * @retval     1       Span begun
+ * @retval     0       No active trace
+ * @retval    -1       Error
+ */
+int
+clixon_trace_span_begin(const char *name,
+                        const char *detail)
+{
+    if (_trace_span == NULL)
+        return 0;
+    if (trace_span_push(_trace_span->sp_trace, _trace_span->sp_id, name, detail) < 0)
+        return -1;
+    return 1;
+}
+
+/*! End the innermost span and export it
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  Status of the spanned operation, <0 is error
+ * @retval     0       OK, or no active trace
+ * @retval    -1       Error
+ */
+int
+clixon_trace_span_end(clixon_handle h,
+                      int           status)
+{
+    int                retval = -1;
+    struct trace_span *sp;
+    cbuf              *cb = NULL;
+
+    if ((sp = _trace_span) == NULL)
+        return 0;
+    _trace_span = sp->sp_parent;
+    if (_trace_f){
+        /* One write per span to keep lines of concurrent writers whole */
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "{\"traceId\":\"%s\",\"spanId\":\"%s\"", sp->sp_trace, sp->sp_id);
+        if (sp->sp_pid[0])
+            cprintf(cb, ",\"parentSpanId\":\"%s\"", sp->sp_pid);
+        cprintf(cb, ",\"name\":");
+        trace_json_str(cb, sp->sp_name);
+        cprintf(cb, ",\"startTimeUnixNano\":%" PRIu64 ",\"endTimeUnixNano\":%" PRIu64,
+                sp->sp_start, trace_now());
+        cprintf(cb, ",\"attributes\":{\"pid\":%d", getpid());
+        if (sp->sp_detail){
+            cprintf(cb, ",\"detail\":");
+            trace_json_str(cb, sp->sp_detail);
+        }
+        cprintf(cb, "},\"status\":\"%s\"}\n", status < 0 ? "error" : "ok");
+        if (fputs(cbuf_get(cb), _trace_f) == EOF || fflush(_trace_f) == EOF){
+            clixon_err(OE_UNIX, errno, "write trace");
+            goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    trace_span_free(sp);
+    return retval;
+}
+
+/*! End all open spans of the active trace
+ *
+ * Spans left open by error paths are ended with the same status
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  Status of the traced request, <0 is error
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+clixon_trace_stop(clixon_handle h,
+                  int           status)
+{
+    while (_trace_span != NULL)
+        if (clixon_trace_span_end(h, status) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Print W3C traceparent of the innermost span of the active trace
+ *
+ * Used to propagate the trace to another process
+ * @param[out] cb   Traceparent string is appended to cb
+ * @retval     1    Printed
+ * @retval     0    No active trace
+ */
+int
+clixon_trace_traceparent(cbuf *cb)
+{
+    if (_trace_span == NULL)
+        return 0;
+    cprintf(cb, "00-%s-%s-01", _trace_span->sp_trace, _trace_span->sp_id);
+    return 1;
+}
+
+/*! Free open spans without export and close export file
+ */
+int
+clixon_trace_exit(void)
+{
+    struct trace_span *sp;
+
+    while ((sp = _trace_span) != NULL){
+        _trace_span = sp->sp_parent;
+        trace_span_free(sp);
+    }
+    if (_trace_f){
+        fclose(_trace_f);
+        _trace_f = NULL;
+    }
+    return 0;
+}
@@ -51,6 +51,10 @@
 #include <arpa/inet.h>
 #include <sys/param.h>
 #include <netinet/in.h>
+#include <time.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -73,6 +77,10 @@
 #include "clixon_xml_io.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_deps.h"
+#include "clixon_validate_leafref.h"
+#include "clixon_xpath_profile.h"
+#include "clixon_validate_profile.h"
 #include "clixon_yang_module.h"
 #include "clixon_yang_type.h"
 #include "clixon_yang_schema_mount.h"
@@ -84,20 +92,56 @@
 #include "clixon_validate_minmax.h"
 #include "clixon_validate.h"
 
+#ifdef HAVE_LIBPTHREAD
+/* Max depth of nodes validated before the rest is split into units for threads */
+#define VALIDATE_THREAD_DEPTH 4
+/* Number of units per thread to aim for when splitting */
+#define VALIDATE_THREAD_UNITS 16
+/* Number of units taken by a thread at a time */
+#define VALIDATE_THREAD_CHUNK 32
+#endif
+
 #ifdef LEAFREF_OPTIMIZE
 
-/* Global cache data only directly used in validate_leafref()
+/* Minimum size of a leafref target node-set to put its values in a hash set
+ */
+#define LEAFREF_OPT_SET_MIN 8
+
+/* Target node-set of a leafref path from one anchor, shared by leafref nodes with the
+ * same absolute path
+ */
+struct leafref_target {
+    cxobj     *lt_anchor;  /* Ancestor of leafref xml node the path is evaluated from */
+    cxobj    **lt_xvec;    /* Resolved target node-set */
+    size_t     lt_xlen;    /* Length of lt_xvec */
+    char     **lt_set;     /* Hash set of values of lt_xvec, or NULL if linear search */
+    size_t     lt_setlen;  /* Size of lt_set, power of two */
+};
+
+/* Cache entry of one leafref yang node, only directly used in validate_leafref()
  */
 struct leafref_opt {
-    yang_stmt *lc_cache_yang;  /* YANG of leafref xml node*/
-    cxobj     *lc_cache_x0;    /* leafref xml node */
-    cxobj    **lc_cache_xvec;
-    size_t     lc_cache_xlen;
-    int        lc_bin_search;  /* Result is binary searchable */
-    cxobj     *lc_bin_x0;      /* First object hit, derive y and parent */
+    yang_stmt             *lc_yang;   /* YANG of leafref xml node, key of cache */
+    yang_stmt             *lc_path;   /* YANG path statement, differs if union of leafrefs */
+    struct leafref_target *lc_target; /* Target of lc_path */
 };
-struct leafref_opt leafref_opt = {0,};
 
+/* Global cache table of one validation pass, see leafref_opt_init()
+ */
+struct leafref_opt_table {
+    clicon_hash_t          *lt_hash;    /* Leafref yang -> struct leafref_opt */
+    struct leafref_opt    **lt_vec;     /* All entries, for freeing */
+    int                     lt_len;     /* Length of lt_vec */
+    clicon_hash_t          *lt_targets; /* "<module|yang> <path>" -> struct leafref_target */
+    struct leafref_target **lt_tvec;    /* All targets, for freeing */
+    int                     lt_tlen;    /* Length of lt_tvec */
+};
+/* Per thread since subtrees may be validated in threads, see CLICON_VALIDATE_THREADS */
+#ifdef HAVE_LIBPTHREAD
+static __thread struct leafref_opt_table leafref_opt = {0,};
+#else
+static struct leafref_opt_table leafref_opt = {0,};
+#endif
 #endif
 
 /*! Leafref validation error
@@ -135,306 +179,266 @@ validate_leafref_err(char   *xpath,
 }
 
 #ifdef LEAFREF_OPTIMIZE
-/*! Check cache hit
+/*! Get ancestor of a leafref node that a leafref path is evaluated from
  *
- * Find common ancestor, ie the parent of xp and xpc is the same object
- * recursively IF they are reachable by an initial "../" xpath.
- * @param[in]  xp    XML to check
- * @param[in]  xpc   XML cache element
- * @param[in]  xpath XPath
- * @param[in]  check Skip check this level
- * @retval     1     Cache hit
- * @retval     0     No cache hit
+ * A path beginning with N "../" only depends on the Nth ancestor of the leafref node.
+ * An absolute path depends on no node and the anchor is the top of the tree.
+ * Paths referring to current() or deref() depend on the leafref node itself and are
+ * not cached.
+ * @param[in]  xt    Leafref XML node
+ * @param[in]  xpath Leafref path
+ * @retval     x     Anchor
+ * @retval     NULL  Path cannot be cached
  */
-static int
-leafref_opt_cache_check(cxobj *xp,
-                        cxobj *xpc,
-                        char  *xpath,
-                        int    check)
+static cxobj *
+leafref_opt_anchor(cxobj *xt,
+                   char  *xpath)
 {
-    if (check && xp == xpc)
-        return 1;
-    else if (strncmp(xpath, "../", strlen("../")) == 0)
-        return leafref_opt_cache_check(xml_parent(xp),
-                                       xml_parent(xpc),
-                                       xpath+strlen("../"),
-                                       1);
-    return 0;
+    cxobj *x = xt;
+
+    if (strstr(xpath, "current()") != NULL ||
+        strstr(xpath, "deref(") != NULL)
+        return NULL;
+    if (*xpath == '/'){
+        while (xml_parent(x) != NULL)
+            x = xml_parent(x);
+        return x;
+    }
+    if (strncmp(xpath, "../", strlen("../")) != 0)
+        return NULL;
+    while (strncmp(xpath, "../", strlen("../")) == 0){
+        if ((x = xml_parent(x)) == NULL)
+            return NULL;
+        xpath += strlen("../");
+    }
+    return x;
 }
 
-/*! Free and zero all data in cache
+/*! String hash of leafref target values (FNV-1a)
  */
-int
-leafref_opt_free(struct leafref_opt *lc)
+static uint64_t
+leafref_opt_hash(const char *str)
 {
-    lc->lc_cache_yang = NULL;
-    lc->lc_cache_x0 = NULL;
-    if (lc->lc_cache_xvec)
-        free(lc->lc_cache_xvec);
-    lc->lc_cache_xvec = NULL;
-    lc->lc_cache_xlen = 0;
-    lc->lc_bin_search = 0;
-    lc->lc_bin_x0 = NULL;
-    return 0;
+    uint64_t h = 14695981039346656037ULL;
+
+    while (*str){
+        h ^= (unsigned char)*str++;
+        h *= 1099511628211ULL;
+    }
+    return h;
 }
 
-/*! Re-instate cache, after leafref yang/path change
- *
- * @param[in]  ys    Cached YANG node
- * @param[in]  xt    Cached XML node
- * @param[in]  xvec  Vector of matching XML values
- * @param[in]  xlen  Length of xvec
- * @retval     0     OK
+/*! Free data of a target, keep key
  */
 static int
-leafref_opt_cache_new(yang_stmt *ys,
-                      cxobj     *xt,
-                      cxobj    **xvec,
-                      size_t     xlen)
+leafref_target_clear(struct leafref_target *lt)
 {
-    leafref_opt_free(&leafref_opt);
-    leafref_opt.lc_cache_yang = ys;
-    leafref_opt.lc_cache_x0 = xt;
-    leafref_opt.lc_cache_xvec = xvec;
-    leafref_opt.lc_cache_xlen = xlen;
+    if (lt->lt_xvec)
+        free(lt->lt_xvec);
+    lt->lt_xvec = NULL;
+    lt->lt_xlen = 0;
+    if (lt->lt_set)
+        free(lt->lt_set);
+    lt->lt_set = NULL;
+    lt->lt_setlen = 0;
+    lt->lt_anchor = NULL;
     return 0;
 }
 
-/*! Detect if binary search can be used
+/*! Set target to a new node-set, and put its values in a hash set if large
  *
- * If xlen is very large, this takes time
- * Optimization:
- * if all elements belong to the same LEAFLIST or LIST
- * AND the leaflist/list is ordered-by system,
- * THEN one can do binary search instead of linear
- * Algorithm:
- * IF yang of all elements is same YANG
- * AND that yang is LEAF-LIST AND is ordered-by system
- * OR that yang's parent is LIST AND is ordered-by system
- * THEN use binary search
- * @param[in]  xvec   Vector of matching XML values
+ * @param[in]  lt     Target
+ * @param[in]  anchor Anchor of leafref path
+ * @param[in]  xvec   Vector of matching XML values, consumed also on error
  * @param[in]  xlen   Length of xvec
- * @param[out] search Can do binary search (or not)
- * @param[out] x0p    First object hit, if searchable
  * @retval     0      OK
- * @note only binary search if xvec have the same parent, this could probably be implemented
+ * @retval    -1      Error
  */
 static int
-leafref_opt_search_detect(cxobj **xvec,
-                          size_t  xlen,
-                          int    *search,
-                          cxobj **x0pp)
+leafref_target_set(struct leafref_target *lt,
+                   cxobj                 *anchor,
+                   cxobj                **xvec,
+                   size_t                 xlen)
 {
-    cxobj     *x;
-    cxobj     *x0;
-    cxobj     *xp;
-    cxobj     *x0p;
-    yang_stmt *y;
-    yang_stmt *y0;
-    yang_stmt *yp;
-    cvec      *cvk;
-    int        i;
-
-    x0 = NULL;
-    x0p = NULL;
-    y0 = NULL;
-    for (i = 0; i < xlen; i++) {
-        x = xvec[i];
-        if ((xp = xml_parent(x)) == NULL)
-            break;
-        // XXX Maybe we could do this in xpath code if we use xpath_vec_ctx instead
-        if ((y = xml_spec(x)) == NULL)
-            break;
-        if (i == 0){
-            x0 = x;
-            y0 = y;
-            x0p = xp;
-            if ((yp = xml_spec(xp)) == NULL)
-                break;
-            if (yang_keyword_get(y) == Y_LEAF_LIST){
-            }
-            else if (yang_keyword_get(yp) == Y_LIST &&
-                     (cvk = yang_cvec_get(yp)) != NULL &&
-                     cvec_len(cvk) == 1){
-                /* Only allow single key lists */
-            }
-            else
-                break;
-        }
-        else if (y0 != y || x0p != xp)
-            break;
+    int    retval = -1;
+    char  *body;
+    size_t i;
+    size_t j;
+
+    leafref_target_clear(lt);
+    lt->lt_anchor = anchor;
+    lt->lt_xvec = xvec;
+    lt->lt_xlen = xlen;
+    if (xlen < LEAFREF_OPT_SET_MIN)
+        goto ok;
+    /* At most half full */
+    for (lt->lt_setlen = 16; lt->lt_setlen < 2*xlen; lt->lt_setlen *= 2)
+        ;
+    if ((lt->lt_set = calloc(lt->lt_setlen, sizeof(char *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
     }
-    // Does not work in some cases for LISTs
-    if (i == xlen && x0 != NULL && xml_parent(x0) && xml_spec(x0)){
-        *search = 1;
-        *x0pp = x0;
+    for (i = 0; i < xlen; i++){
+        if ((body = xml_body(xvec[i])) == NULL)
+            continue;
+        j = leafref_opt_hash(body) & (lt->lt_setlen-1);
+        while (lt->lt_set[j] != NULL && strcmp(lt->lt_set[j], body) != 0)
+            j = (j+1) & (lt->lt_setlen-1);
+        lt->lt_set[j] = body;
     }
-    return 0;
+ ok:
+    retval = 0;
+ done:
+    return retval;
 }
 
-/*! Create artificial object for match_base_child API
+/*! Get target of a leafref path, create if not found
  *
- * @param[in]  x0p
- * @param[in]  yc
- * @param[in]  body
- * @param[out] x0cp
- * @retval     0    OK
- * @retval    -1    Error
- * Consider moving as uitlity functions to match_base_child
+ * Absolute paths of the same module are shared by all leafref nodes, relative paths
+ * are per leafref node since their anchors differ.
+ * @param[in]  ys    Leafref yang node
+ * @param[in]  xpath Leafref path
+ * @param[out] ltp   Target
+ * @retval     0     OK
+ * @retval    -1     Error
  */
 static int
-match_leafref_child_leaflist(cxobj     *x0p,
-                             yang_stmt *yc,
-                             char      *body,
-                             cxobj    **x0cp)
+leafref_target_get(yang_stmt              *ys,
+                   char                   *xpath,
+                   struct leafref_target **ltp)
 {
-    int    retval = -1;
-    char  *name;
-    cxobj *xf = NULL;
+    int                     retval = -1;
+    cbuf                   *cb = NULL;
+    struct leafref_target  *lt;
+    struct leafref_target **ltvec;
+    void                   *p;
 
-    name = yang_argument_get(yc);
-    if (clixon_xml_parse_va(YB_NONE, NULL, &xf, NULL, "<%s>%s</%s>",
-                            name, body, name) < 0)
-        goto done;
-    if (xml_rootchild(xf, 0, &xf) < 0)
-        goto done;
-    xml_spec_set(xf, yc);
-    if (match_base_child(x0p, xf, yc, x0cp) < 0)
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
+    }
+    /* Prefixes of path are resolved in the module of the leafref node */
+    cprintf(cb, "%p %s", *xpath == '/' ? (void*)ys_module(ys) : (void*)ys, xpath);
+    if ((p = clicon_hash_value(leafref_opt.lt_targets, cbuf_get(cb), NULL)) != NULL)
+        lt = *(struct leafref_target **)p;
+    else {
+        if ((lt = calloc(1, sizeof(*lt))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if ((ltvec = realloc(leafref_opt.lt_tvec, (leafref_opt.lt_tlen+1)*sizeof(*ltvec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            free(lt);
+            goto done;
+        }
+        leafref_opt.lt_tvec = ltvec;
+        leafref_opt.lt_tvec[leafref_opt.lt_tlen++] = lt;
+        if (clicon_hash_add(leafref_opt.lt_targets, cbuf_get(cb), &lt, sizeof(lt)) == NULL)
+            goto done;
+    }
+    *ltp = lt;
     retval = 0;
  done:
-    if (xf)
-        xml_free(xf);
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
-/*! Create artificial object for match_base_child API
+/*! Get target of a leafref yang node and path, create if not found
  *
- * @param[in]  x0
- * @param[in]  x0p
- * @param[in]  yc
- * @param[in]  body
- * @param[out] x0cp
- * @retval     0    OK
- * @retval    -1    Error
- * Consider moving as uitlity functions to match_base_child
+ * @param[in]  ys    Leafref yang node
+ * @param[in]  ypath YANG path statement of leafref
+ * @param[out] ltp   Target
+ * @retval     0     OK
+ * @retval    -1     Error
  */
 static int
-match_leafref_child_list(cxobj     *x0,
-                         cxobj     *x0p,
-                         yang_stmt *yc,
-                         char      *body,
-                         cxobj    **x0cp)
+leafref_opt_get(yang_stmt              *ys,
+                yang_stmt              *ypath,
+                struct leafref_target **ltp)
 {
-    int    retval = -1;
-    cxobj *x1 = NULL;
-    char  *ns = NULL;
-    char  *name;
-    int    ret;
+    int                  retval = -1;
+    struct leafref_opt  *lc;
+    struct leafref_opt **vec;
 
-    if (xml2ns(x0, NULL, &ns) < 0)
-        goto done;
-    name = yang_argument_get(yc);
-    if (clixon_xml_parse_va(YB_NONE, NULL, &x1, NULL, "<%s xmlns=\"%s\"><%s>%s</%s></%s>",
-                            name,
-                            ns,
-                            xml_name(x0),
-                            body,
-                            xml_name(x0),
-                            name) < 0)
-        goto done;
-    if (xml_rootchild(x1, 0, &x1) < 0)
-        goto done;
-    xml_spec_set(x1, yc);
-    if ((ret = xml_bind_yang(NULL, x1, YB_PARENT, NULL, 0, NULL)) < 0)
-        goto done;
-    if (ret == 0)
-        ;
-    if (match_base_child(xml_parent(x0p), x1, yc, x0cp) < 0)
-        goto done;
+    if ((lc = clicon_hash_ptr_value(leafref_opt.lt_hash, ys)) == NULL){
+        if ((lc = calloc(1, sizeof(*lc))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if ((vec = realloc(leafref_opt.lt_vec, (leafref_opt.lt_len+1)*sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            free(lc);
+            goto done;
+        }
+        leafref_opt.lt_vec = vec;
+        leafref_opt.lt_vec[leafref_opt.lt_len++] = lc;
+        lc->lc_yang = ys;
+        if (clicon_hash_add_ptr(leafref_opt.lt_hash, ys, lc) == NULL)
+            goto done;
+    }
+    if (lc->lc_target == NULL || lc->lc_path != ypath){
+        if (leafref_target_get(ys, yang_argument_get(ypath), &lc->lc_target) < 0)
+            goto done;
+        lc->lc_path = ypath;
+    }
+    *ltp = lc->lc_target;
     retval = 0;
  done:
-    if (x1)
-        xml_free(x1);
     return retval;
 }
 
-/*! Do binary search of body in ni search cache
+/*! Look up a leafref value in a target
  *
- * @param[in]  xpath  leafref xpath
- * @param[in]  body   Body to search for
- * @param[in]  x0     Cached x0
- * @param[out] xret   Matched object
- * @retval     1      Validation OK
- * @retval     0      Validation failed
- * @retval    -1      Error
+ * @param[in]  lt    Target
+ * @param[in]  body  Leafref value
+ * @retval     1     Found
+ * @retval     0     Not found
  */
 static int
-leafref_opt_search(char   *xpath,
-                   cxobj  *xt,
-                   cxobj  *x0,
-                   cxobj **xret)
+leafref_target_find(struct leafref_target *lt,
+                    char                  *body)
 {
-    int        retval = -1;
-    cxobj     *x0p;
-    yang_stmt *y0;
-    yang_stmt *y0p;
-    cxobj     *myx = NULL;
-    cvec      *cvk;
-    cg_var    *cvi;
-    char      *body;
-
-    body = xml_body(xt);
-    y0 = xml_spec(x0);
-    x0p = xml_parent(x0);
-    y0p = xml_spec(x0p);
-    if (yang_keyword_get(y0) == Y_LEAF_LIST){
-        if (match_leafref_child_leaflist(x0p, y0, body, &myx) < 0)
-            goto done;
-    }
-    else if (yang_keyword_get(y0p) == Y_LIST &&
-             (cvk = yang_cvec_get(y0p)) != NULL &&
-             (cvi = cvec_i(cvk, 0)) != NULL &&
-             strcmp(cv_string_get(cvi), yang_argument_get(y0)) == 0){
-        if (match_leafref_child_list(x0, x0p, y0p, body, &myx) < 0)
-            goto done;
-    }
-    else if (yang_keyword_get(y0) == Y_LEAF){
-        if (strcmp(xml_body(x0), body) == 0)
-            myx = x0;
-    }
-    else {
-        fprintf(stderr, "%s y0: %s y0p:%s\n", __FUNCTION__,
-                yang_key2str(yang_keyword_get(y0)),
-                yang_key2str(yang_keyword_get(y0p)));
-        if (match_leafref_child_leaflist(x0p, y0, body, &myx) < 0)
-            goto done;
+    char  *leafbody;
+    size_t i;
+
+    if (lt->lt_set){
+        i = leafref_opt_hash(body) & (lt->lt_setlen-1);
+        while ((leafbody = lt->lt_set[i]) != NULL){
+            if (strcmp(leafbody, body) == 0)
+                return 1;
+            i = (i+1) & (lt->lt_setlen-1);
+        }
+        return 0;
     }
-    if (myx == NULL){
-        if (validate_leafref_err(xpath, xt, xret) < 0)
-            goto done;
-        goto fail;
+    for (i = 0; i < lt->lt_xlen; i++) {
+        if ((leafbody = xml_body(lt->lt_xvec[i])) == NULL)
+            continue;
+        if (strcmp(leafbody, body) == 0)
+            return 1;
     }
-    retval = 1;
- done:
-    return retval;
- fail:
-    retval = 0;
-    goto done;
+    return 0;
 }
 
 /*! Leafref optimization init
  *
  * @param[in]  h  Clixon handle
  * @retval     0  OK
+ * @retval    -1  Error
  */
 static int
 leafref_opt_init(clixon_handle h)
 {
+    if (leafref_opt.lt_hash == NULL &&
+        (leafref_opt.lt_hash = clicon_hash_init()) == NULL)
+        return -1;
+    if (leafref_opt.lt_targets == NULL &&
+        (leafref_opt.lt_targets = clicon_hash_init()) == NULL)
+        return -1;
     return 0;
 }
 
-/*! Leafref optimization exit
+/*! Leafref optimization exit, free all cache entries
  *
  * @param[in]  h  Clixon handle
  * @retval     0  OK
@@ -442,7 +446,28 @@ leafref_opt_init(clixon_handle h)
 int
 leafref_opt_exit(clixon_handle h)
 {
-    leafref_opt_free(&leafref_opt);
+    int i;
+
+    for (i = 0; i < leafref_opt.lt_len; i++)
+        free(leafref_opt.lt_vec[i]);
+    if (leafref_opt.lt_vec)
+        free(leafref_opt.lt_vec);
+    leafref_opt.lt_vec = NULL;
+    leafref_opt.lt_len = 0;
+    for (i = 0; i < leafref_opt.lt_tlen; i++){
+        leafref_target_clear(leafref_opt.lt_tvec[i]);
+        free(leafref_opt.lt_tvec[i]);
+    }
+    if (leafref_opt.lt_tvec)
+        free(leafref_opt.lt_tvec);
+    leafref_opt.lt_tvec = NULL;
+    leafref_opt.lt_tlen = 0;
+    if (leafref_opt.lt_hash)
+        clicon_hash_free(leafref_opt.lt_hash);
+    leafref_opt.lt_hash = NULL;
+    if (leafref_opt.lt_targets)
+        clicon_hash_free(leafref_opt.lt_targets);
+    leafref_opt.lt_targets = NULL;
     return 0;
 }
 
@@ -499,10 +524,16 @@ validate_leafref(cxobj     *xt,
     char      *xpath;
     cg_var    *cv;
     int        require_instance = 1;
+    int        prof;
+    struct timespec t0;
 #ifdef LEAFREF_OPTIMIZE
+    cxobj     *anchor;
+    struct leafref_target *lt;
     int        ret;
 #endif
 
+    if ((prof = validate_profile_enabled()) != 0)
+        validate_profile_start(&t0);
     /* require instance */
     if ((yreqi = yang_find(ytype, Y_REQUIRE_INSTANCE, NULL)) != NULL){
         if ((cv = yang_cv_get(yreqi)) != NULL) /* shouldn't happen */
@@ -527,64 +558,50 @@ validate_leafref(cxobj     *xt,
     if (xml_nsctx_yang(ys, &nsc) < 0)
         goto done;
 #ifdef LEAFREF_OPTIMIZE
-    if (ys == leafref_opt.lc_cache_yang &&
-         leafref_opt.lc_cache_x0){
-        if ((ret = leafref_opt_cache_check(xt, leafref_opt.lc_cache_x0, xpath, 0)) < 0)
+    /* Reuse target node-set of leafrefs with same yang and path anchor */
+    if (leafref_opt.lt_hash != NULL &&
+        (anchor = leafref_opt_anchor(xt, xpath)) != NULL){
+        if (leafref_opt_get(ys, ypath, &lt) < 0)
             goto done;
-        if (ret == 1){
-            xvec = leafref_opt.lc_cache_xvec;
-            xlen = leafref_opt.lc_cache_xlen;
+        if (lt->lt_xvec == NULL || lt->lt_anchor != anchor){
+            if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
+                goto done;
+            ret = leafref_target_set(lt, anchor, xvec, xlen);
+            xvec = NULL; /* Consumed by cache */
+            if (ret < 0)
+                goto done;
         }
+        if (leafref_target_find(lt, leafrefbody) == 0){
+            if (validate_leafref_err(xpath, xt, xret) < 0)
+                goto done;
+            goto fail;
+        }
+        goto ok;
     }
 #endif /* LEAFREF_OPTIMIZE */
-    if (xvec == NULL)
-        if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
-            goto done;
-#ifdef LEAFREF_OPTIMIZE
-    if (ys != leafref_opt.lc_cache_yang){
-        if (leafref_opt_cache_new(ys, xt, xvec, xlen) < 0)
-            goto done;
-        leafref_opt.lc_bin_search = 0;
-        leafref_opt.lc_bin_x0 = NULL;
-        if (leafref_opt_search_detect(xvec, xlen,
-                                      &leafref_opt.lc_bin_search,
-                                      &leafref_opt.lc_bin_x0) < 0)
-            goto done;
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
+        goto done;
+    for (i = 0; i < xlen; i++) {
+        x = xvec[i];
+        if ((leafbody = xml_body(x)) == NULL)
+            continue;
+        if (strcmp(leafbody, leafrefbody) == 0)
+            break;
     }
-    if (leafref_opt.lc_bin_search){
-        if ((ret = leafref_opt_search(xpath, xt, leafref_opt.lc_bin_x0, xret)) < 0)
+    if (i==xlen){
+        if (validate_leafref_err(xpath, xt, xret) < 0)
             goto done;
-        if (ret == 0)
-            goto fail;
+        goto fail;
     }
-    else
-#endif
-        {
-            for (i = 0; i < xlen; i++) {
-                x = xvec[i];
-                if ((leafbody = xml_body(x)) == NULL)
-                    continue;
-                if (strcmp(leafbody, leafrefbody) == 0)
-                    break;
-            }
-            if (i==xlen){
-                if (validate_leafref_err(xpath, xt, xret) < 0)
-                    goto done;
-                goto fail;
-            }
-        }
  ok:
     retval = 1;
  done:
+    if (prof && validate_profile_add(ys, VP_LEAFREF, &t0) < 0)
+        retval = -1;
     if (nsc)
         xml_nsctx_free(nsc);
-#ifdef LEAFREF_OPTIMIZE
-    if (xvec != leafref_opt.lc_cache_xvec)
-        free(xvec);
-#else
     if (xvec)
         free(xvec);
-#endif
     return retval;
  fail:
     retval = 0;
@@ -629,8 +646,8 @@ validate_identityref(cxobj     *xt,
     char       *id = NULL;
     cbuf       *cberr = NULL;
     cbuf       *cb = NULL;
-    cvec       *idrefvec; /* Derived identityref list: (module:id)**/
     yang_stmt  *ymod;
+    int         ret;
 
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -683,10 +700,11 @@ validate_identityref(cxobj     *xt,
     cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
     idref = cbuf_get(cb);
     /* Here check if node is in the derived node list of the base identity
-     * The derived node list is a cvec computed XXX
+     * The derived node list is computed in ys_populate_identity
      */
-    idrefvec = yang_cvec_get(ybaseid);
-    if (cvec_find(idrefvec, idref) == NULL){
+    if ((ret = yang_identity_derived_find(ybaseid, idref)) < 0)
+        goto done;
+    if (ret == 0){
 
         cprintf(cberr, "Identityref validation failed, %s not derived from %s in %s.yang",
                 node,
@@ -1308,7 +1326,8 @@ check_mandatory(cxobj     *xt,
             goto fail;
     }
     inext = 0;
-    while ((yc = yn_iter(yt, &inext)) != NULL) {
+    /* Only children that may be mandatory, see YANG_SCHEMA_SUMMARY */
+    while ((yc = yang_mandatory_each(yt, &inext)) != NULL) {
         /* Choice is more complex because of choice/case structure and possibly hierarchical */
         if (yang_keyword_get(yc) == Y_CHOICE){
             if (yang_xml_mandatory(xt, yc)){
@@ -1413,6 +1432,9 @@ xml_yang_validate_add(clixon_handle h,
     cg_var      *cv0;
     enum cv_type cvtype;
     validate_level vl = VL_NONE;
+    int          prof = 0;
+    struct timespec t0;
+    yang_stmt   *yorig = NULL; /* previous node of validation profile */
 
     if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
         if ((ret = xml_yang_mount_get(h, xt, &vl, NULL, NULL)) < 0)
@@ -1436,6 +1458,11 @@ xml_yang_validate_add(clixon_handle h,
             /* validate value against ranges, etc */
             if ((cv0 = yang_cv_get(yt)) == NULL)
                 break;
+            /* Pattern and range checks of the value are recorded on yt */
+            if ((prof = validate_profile_enabled()) != 0){
+                validate_profile_start(&t0);
+                yorig = validate_profile_node(yt);
+            }
             if ((cv = cv_dup(cv0)) == NULL){
                 clixon_err(OE_UNIX, errno, "cv_dup");
                 goto done;
@@ -1475,6 +1502,12 @@ xml_yang_validate_add(clixon_handle h,
                     goto done;
                 goto fail;
             }
+            if (prof){
+                validate_profile_node(yorig);
+                prof = 0;
+                if (validate_profile_add(yt, VP_TYPE, &t0) < 0)
+                    goto done;
+            }
             break;
         default:
             break;
@@ -1490,6 +1523,8 @@ xml_yang_validate_add(clixon_handle h,
   ok:
     retval = 1;
  done:
+    if (prof)
+        validate_profile_node(yorig);
     if (cv)
         cv_free(cv);
     if (reason)
@@ -1604,40 +1639,36 @@ xml_yang_validate_leaf_union(clixon_handle h,
     goto done;
 }
 
-/*! Validate a single XML node with yang specification for all (not only added) entries
+/*! Validate a single XML node with yang specification, not its children
  *
- * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
- * @param[in]  xt  XML node to be validated
- * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
- * @retval     1     Validation OK
- * @retval     0     Validation failed (cbret set)
- * @retval    -1     Error
- * @code
- *   cxobj *x;
- *   cbuf *xret = NULL;
- *   if ((ret = xml_yang_validate_all(h, x, &xret)) < 0)
- *      err;
- *   if (ret == 0)
- *      fail;
- *   xml_free(xret);
- * @endcode
- * @see xml_yang_validate_add
- * @see xml_yang_validate_rpc
+ * When, mandatory, leafref, identityref and must checks of xt itself.
+ * @param[in]  xt         XML node to be validated
+ * @param[in]  chg        Set of names of changed nodes, or NULL. Skip must/when if not affected
+ * @param[out] skip       Set if children and unique/min/max are not to be validated
+ * @param[out] unchangedp Set if structure of node is as in valid tree, see chg
+ * @param[out] xret       Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1          Validation OK
+ * @retval     0          Validation failed (xret set)
+ * @retval    -1          Error
+ * @see xml_yang_validate_all1
  */
 static int
-xml_yang_validate_all1(clixon_handle h,
-                       cxobj        *xt,
-                       cxobj       **xret)
+xml_yang_validate_node(clixon_handle  h,
+                       cxobj         *xt,
+                       clicon_hash_t *chg,
+                       int           *skip,
+                       int           *unchangedp,
+                       cxobj        **xret)
 {
     int        retval = -1;
     yang_stmt *yt;  /* yang node associated with xt */
     yang_stmt *yc;  /* yang child */
     yang_stmt *ye;  /* yang must error-message */
+    yang_stmt *yorig; /* previous origin of XPath profile */
     char      *xpath;
     char      *xpath1 = NULL;
     int        nr;
     int        ret;
-    cxobj     *x;
     cxobj     *xp;
     char      *ns = NULL;
     cbuf      *cb = NULL;
@@ -1646,13 +1677,25 @@ xml_yang_validate_all1(clixon_handle h,
     validate_level vl = VL_NONE;
     int        saw_node = 0;
     int        inext;
+    int        skipwhen = 0;
+    int        unchanged = 0;
+    int        prof;
+    struct timespec t0;
+#ifdef XPATH_PARSE_CACHE
+    xpath_tree *xpt;
+#endif
+#if defined(XPATH_PARSE_CACHE) && defined(VALIDATE_INCREMENTAL)
+    yang_stmt *ypath;
+#endif
 
+    *skip = 0;
+    *unchangedp = 0;
     if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
         if ((ret = xml_yang_mount_get(h, xt, &vl, NULL, NULL)) < 0)
             goto done;
         /* Check if validate beyond mountpoints */
         if (ret == 1 && vl == VL_NONE)
-            goto ok;
+            goto skip;
     }
     /* if not given by argument (overide) use default link
        and !Node has a config sub-statement and it is false */
@@ -1661,7 +1704,7 @@ xml_yang_validate_all1(clixon_handle h,
             clixon_log(h, LOG_WARNING,
                        "%s: %d: No YANG spec for %s, validation skipped",
                        __func__, __LINE__, xml_name(xt));
-            goto ok;
+            goto skip;
         }
         if ((cb = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -1679,11 +1722,33 @@ xml_yang_validate_all1(clixon_handle h,
         goto fail;
     }
     if (yang_config(yt) != 0){
-        ret = yang_check_when_xpath(xt, xml_parent(xt), yt, &hit, &nr, &xpath1);
-        clixon_debug(CLIXON_DBG_XPATH|CLIXON_DBG_DETAIL, "nr:%d xpath:%s return:%d", nr, xpath1, ret);
-        if (ret < 0)
-            goto done;
-
+#if defined(XPATH_PARSE_CACHE) && defined(VALIDATE_INCREMENTAL)
+        /* Node is not added or changed and no child is deleted: structure is as in valid tree */
+        if (chg &&
+            xml_flag(xt, XML_FLAG_ADD|XML_FLAG_CHANGE) == 0 &&
+            clicon_hash_lookup(chg, xml_name(xt)) == NULL)
+            unchanged = 1;
+        /* Direct when not affected by change set keeps its result */
+        if (chg &&
+            yang_when_get(NULL, yt) == NULL &&
+            (yc = yang_find(yt, Y_WHEN, NULL)) != NULL){
+            if ((xpt = yang_xpath_get(yc)) == NULL)
+                goto done;
+            if (xpath_deps_changed(xpt, xt, chg) == 0)
+                skipwhen = 1;
+        }
+#endif
+        prof = validate_profile_enabled();
+        if (!skipwhen){
+            if (prof)
+                validate_profile_start(&t0);
+            ret = yang_check_when_xpath(xt, xml_parent(xt), yt, &hit, &nr, &xpath1);
+            if (prof && hit && validate_profile_add(yt, VP_WHEN, &t0) < 0)
+                goto done;
+            clixon_debug(CLIXON_DBG_XPATH|CLIXON_DBG_DETAIL, "nr:%d xpath:%s return:%d", nr, xpath1, ret);
+            if (ret < 0)
+                goto done;
+        }
         if (hit && nr == 0){
             if ((cb = cbuf_new()) == NULL){
                 clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -1698,15 +1763,17 @@ xml_yang_validate_all1(clixon_handle h,
                 goto done;
             goto fail;
         }
-        if ((ret = check_mandatory(xt, yt, xret)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
+        if (!unchanged){
+            if ((ret = check_mandatory(xt, yt, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
         /* Node-specific validation */
         switch (yang_keyword_get(yt)){
         case Y_ANYXML:
         case Y_ANYDATA:
-            goto ok;
+            goto skip;
             break;
         case Y_LEAF:
             /* fall thru */
@@ -1718,12 +1785,33 @@ xml_yang_validate_all1(clixon_handle h,
             if (yang_type_get(yt, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
                 goto done;
             if (strcmp(yang_argument_get(yc), "leafref") == 0){
+#if defined(XPATH_PARSE_CACHE) && defined(VALIDATE_INCREMENTAL)
+                /* Unchanged leafref is valid unless a node named in its path changed,
+                 * eg its target is deleted */
+#ifdef LEAFREF_INDEX
+                /* Or, with reverse index, unless it refers to a deleted or changed node */
+                if (unchanged && xml_leafref_index_marked(h)){
+                    if (xml_flag(xt, XML_FLAG_LEAFREF) == 0)
+                        break;
+                }
+                else
+#endif
+                if (unchanged &&
+                    (ypath = yang_find(yc, Y_PATH, NULL)) != NULL){
+                    if ((xpt = yang_xpath_get(ypath)) == NULL)
+                        goto done;
+                    if (xpath_deps_changed(xpt, xt, chg) == 0)
+                        break;
+                }
+#endif
                 if ((ret = validate_leafref(xt, yt, yc, xret)) < 0)
                     goto done;
                 if (ret == 0)
                     goto fail;
                 }
             else if (strcmp(yang_argument_get(yc), "identityref") == 0){
+                if (unchanged) /* Same value and identities as in valid tree */
+                    break;
                 if ((ret = validate_identityref(xt, yt, yc, xret)) < 0)
                     goto done;
                 if (ret == 0)
@@ -1745,6 +1833,15 @@ xml_yang_validate_all1(clixon_handle h,
         while ((yc = yn_iter(yt, &inext)) != NULL) {
             if (yang_keyword_get(yc) != Y_MUST)
                 continue;
+#if defined(XPATH_PARSE_CACHE) && defined(VALIDATE_INCREMENTAL)
+            /* Must not affected by change set was true before */
+            if (chg){
+                if ((xpt = yang_xpath_get(yc)) == NULL)
+                    goto done;
+                if (xpath_deps_changed(xpt, xt, chg) == 0)
+                    continue;
+            }
+#endif
             if (!saw_node)
                 clixon_debug_xml(CLIXON_DBG_XPATH, xt, "");
             saw_node = 1;
@@ -1758,7 +1855,20 @@ xml_yang_validate_all1(clixon_handle h,
             if (xml_nsctx_yang(yc, &nsc) < 0)
                 goto done;
             clixon_debug(CLIXON_DBG_XPATH, "namespace '%s'", xml_nsctx_get(nsc, NULL));
+            yorig = xpath_profile_origin(yc);
+            if (prof)
+                validate_profile_start(&t0);
+#ifdef XPATH_PARSE_CACHE
+            if ((xpt = yang_xpath_get(yc)) == NULL) /* Precompiled at populate */
+                nr = -1;
+            else
+                nr = xpath_vec_bool_tree(xt, nsc, xpt);
+#else
             nr = xpath_vec_bool(xt, nsc, "%s", xpath);
+#endif
+            xpath_profile_origin(yorig);
+            if (prof && validate_profile_add(yt, VP_MUST, &t0) < 0)
+                goto done;
             clixon_debug(CLIXON_DBG_XPATH, "result %s", (nr < 0 ? "error" : (nr != 0 ? "true" : "false")));
             if (nr < 0)
                 goto done;
@@ -1781,52 +1891,475 @@ xml_yang_validate_all1(clixon_handle h,
             }
         }
     }
+    *unchangedp = unchanged;
+    retval = 1;
+ done:
+    if (xpath1)
+        free(xpath1);
+    if (cb)
+        cbuf_free(cb);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+ skip:
+    *skip = 1;
+    retval = 1;
+    goto done;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate a single XML node with yang specification for all (not only added) entries
+ *
+ * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
+ * @param[in]  xt    XML node to be validated
+ * @param[in]  chg   Set of names of changed nodes, or NULL. Skip must/when if not affected
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (cbret set)
+ * @retval    -1     Error
+ * @code
+ *   cxobj *x;
+ *   cbuf *xret = NULL;
+ *   if ((ret = xml_yang_validate_all(h, x, &xret)) < 0)
+ *      err;
+ *   if (ret == 0)
+ *      fail;
+ *   xml_free(xret);
+ * @endcode
+ * @see xml_yang_validate_add
+ * @see xml_yang_validate_rpc
+ */
+static int
+xml_yang_validate_all1(clixon_handle  h,
+                       cxobj         *xt,
+                       clicon_hash_t *chg,
+                       cxobj        **xret)
+{
+    int    retval = -1;
+    int    ret;
+    cxobj *x;
+    int    skip;
+    int    unchanged;
+    int    prof;
+    struct timespec t0;
+
+    if ((ret = xml_yang_validate_node(h, xt, chg, &skip, &unchanged, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (skip)
+        goto ok;
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if ((ret = xml_yang_validate_all1(h, x, xret)) < 0)
+        if ((ret = xml_yang_validate_all1(h, x, chg, xret)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
     }
     /* Check unique and min-max after choice test for example*/
-    if (yang_config(yt) != 0){
+    if (yang_config(xml_spec(xt)) != 0 && !unchanged){
         /* Checks if next level contains any unique list constraints */
+        if ((prof = validate_profile_enabled()) != 0)
+            validate_profile_start(&t0);
         if ((ret = xml_yang_validate_minmax(xt, 1, xret)) < 0)
             goto done;
+        if (prof && validate_profile_add(xml_spec(xt), VP_MINMAX, &t0) < 0)
+            goto done;
         if (ret == 0)
             goto fail;
     }
  ok:
     retval = 1;
  done:
-    if (xpath1)
-        free(xpath1);
-    if (cb)
-        cbuf_free(cb);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
  fail:
     retval = 0;
     goto done;
 }
 
+static int
+xml_yang_validate_all0(clixon_handle  h,
+                       cxobj         *xt,
+                       clicon_hash_t *chg,
+                       cxobj        **xret)
+{
+    int retval;
+
+#ifdef LEAFREF_OPTIMIZE
+    leafref_opt_init(h);
+    retval = xml_yang_validate_all1(h, xt, chg, xret);
+    leafref_opt_exit(h);
+#else
+    retval = xml_yang_validate_all1(h, xt, chg, xret);
+#endif
+    return retval;
+}
+
 int
 xml_yang_validate_all(clixon_handle h,
                       cxobj        *xt,
                       cxobj       **xret)
 {
-    int retval;
+    return xml_yang_validate_all0(h, xt, NULL, xret);
+}
+
+#ifdef HAVE_LIBPTHREAD
+/* Kind of validation task, see xml_yang_validate_threads */
+enum validate_task_kind{
+    VT_NODE, /* Failed node check of a split node */
+    VT_UNIT, /* Validate subtree, see xml_yang_validate_all1 */
+    VT_POST, /* Unique and min/max-elements below a split node */
+    VT_TOP,  /* Unique and min/max-elements below top */
+};
 
+/*! Validation task, tasks are in the order of serial validation
+ */
+struct validate_task{
+    cxobj *vt_x;      /* XML node */
+    int    vt_kind;   /* enum validate_task_kind */
+    int    vt_thread; /* Unit may be validated in a thread, see yang_validate_parallel */
+    int    vt_ret;    /* 1: OK, 0: Failed, -1: Error */
+    cxobj *vt_xret;   /* Error XML tree if failed */
+};
+
+/*! Shared state of validation worker threads
+ */
+struct validate_work{
+    pthread_mutex_t       vw_mutex;
+    clixon_handle         vw_h;
+    struct validate_task *vw_tasks;
+    int                   vw_len;   /* Number of tasks */
+    int                   vw_max;   /* Allocated tasks */
+    int                   vw_depth; /* Depth of units below top */
+    int                   vw_xret;  /* Error trees are made */
+    int                   vw_next;  /* Next task to take */
+    int                   vw_first; /* First failed task, or vw_len if none */
+    int                   vw_err;   /* Set if any task had an error */
+};
+
+/*! Add a validation task last
+ */
+static int
+validate_task_add(struct validate_work *vw,
+                  cxobj                *x,
+                  int                   kind,
+                  int                   ret,
+                  cxobj                *xret)
+{
+    struct validate_task *vt;
+    yang_stmt            *y;
+
+    if (vw->vw_len >= vw->vw_max){
+        vw->vw_max = vw->vw_max ? 2*vw->vw_max : 64;
+        if ((vt = realloc(vw->vw_tasks, vw->vw_max*sizeof(*vt))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        vw->vw_tasks = vt;
+    }
+    vt = &vw->vw_tasks[vw->vw_len++];
+    memset(vt, 0, sizeof(*vt));
+    vt->vt_x = x;
+    vt->vt_kind = kind;
+    vt->vt_ret = ret;
+    vt->vt_xret = xret;
+    if (kind == VT_UNIT && (y = xml_spec(x)) != NULL)
+        vt->vt_thread = yang_validate_parallel(y);
+    return 0;
+}
+
+/*! Count XML elements at a depth below a node, stop at max
+ */
+static int
+validate_level_count(cxobj *xt,
+                     int    depth,
+                     int    max)
+{
+    cxobj *x;
+    int    n = 0;
+
+    if (depth == 0)
+        return 1;
+    x = NULL;
+    while (n < max && (x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+        n += validate_level_count(x, depth-1, max-n);
+    return n;
+}
+
+/*! Validate a node and split its children into tasks, in the order of serial validation
+ *
+ * Children at the unit depth, or without children, are units. Other children are split
+ * in turn. Node checks are made here, in the calling thread.
+ * @param[in]  h      Clixon handle
+ * @param[in]  vw     Validation work
+ * @param[in]  xt     XML node, not top
+ * @param[in]  depth  Depth of xt below top
+ * @retval     1      OK
+ * @retval     0      Node check failed, added as last task
+ * @retval    -1      Error
+ */
+static int
+validate_split(clixon_handle         h,
+               struct validate_work *vw,
+               cxobj                *xt,
+               int                   depth)
+{
+    int    retval = -1;
+    cxobj *x;
+    cxobj *xret = NULL;
+    int    skip;
+    int    unchanged;
+    int    ret;
+
+    if ((ret = xml_yang_validate_node(h, xt, NULL, &skip, &unchanged,
+                                      vw->vw_xret?&xret:NULL)) < 0)
+        goto done;
+    if (ret == 0){
+        if (validate_task_add(vw, xt, VT_NODE, 0, xret) < 0)
+            goto done;
+        xret = NULL;
+        goto fail;
+    }
+    if (skip)
+        goto ok;
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if (depth+1 < vw->vw_depth && xml_child_nr_type(x, CX_ELMNT) > 0){
+            if ((ret = validate_split(h, vw, x, depth+1)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        else if (validate_task_add(vw, x, VT_UNIT, 1, NULL) < 0)
+            goto done;
+    }
+    if (yang_config(xml_spec(xt)) != 0 &&
+        validate_task_add(vw, xt, VT_POST, 1, NULL) < 0)
+        goto done;
+ ok:
+    retval = 1;
+ done:
+    if (xret)
+        xml_free(xret);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Run a validation task
+ */
+static int
+validate_task_run(struct validate_work *vw,
+                  struct validate_task *vt)
+{
+    cxobj **xret = vw->vw_xret ? &vt->vt_xret : NULL;
+
+    switch (vt->vt_kind){
+    case VT_UNIT:
+        vt->vt_ret = xml_yang_validate_all1(vw->vw_h, vt->vt_x, NULL, xret);
+        break;
+    case VT_POST:
+        vt->vt_ret = xml_yang_validate_minmax(vt->vt_x, 1, xret);
+        break;
+    case VT_TOP:
+        vt->vt_ret = xml_yang_validate_minmax(vt->vt_x, 0, xret);
+        break;
+    default:
+        break;
+    }
+    return vt->vt_ret;
+}
+
+/*! Worker thread: validate units until none left before the first failed task
+ */
+static void *
+validate_worker(void *arg)
+{
+    struct validate_work *vw = (struct validate_work *)arg;
+    struct validate_task *vt;
+    int                   i;
+    int                   i1;
+    int                   ret;
+
+    xpath_parallel_worker(1);
+#ifdef LEAFREF_OPTIMIZE
+    leafref_opt_init(vw->vw_h);
+#endif
+    for (;;){
+        pthread_mutex_lock(&vw->vw_mutex);
+        if (vw->vw_err || (i = vw->vw_next) >= vw->vw_first)
+            i = -1;
+        else
+            vw->vw_next += VALIDATE_THREAD_CHUNK;
+        i1 = vw->vw_first;
+        pthread_mutex_unlock(&vw->vw_mutex);
+        if (i < 0)
+            break;
+        if (i1 > i + VALIDATE_THREAD_CHUNK)
+            i1 = i + VALIDATE_THREAD_CHUNK;
+        for (; i<i1; i++){
+            vt = &vw->vw_tasks[i];
+            if (vt->vt_kind != VT_UNIT || !vt->vt_thread)
+                continue;
+            if ((ret = validate_task_run(vw, vt)) == 1)
+                continue;
+            pthread_mutex_lock(&vw->vw_mutex);
+            if (ret < 0)
+                vw->vw_err++;
+            else if (i < vw->vw_first)
+                vw->vw_first = i;
+            pthread_mutex_unlock(&vw->vw_mutex);
+            break; /* Later tasks in chunk are not needed */
+        }
+    }
+#ifdef LEAFREF_OPTIMIZE
+    leafref_opt_exit(vw->vw_h);
+#endif
+    ctx_nodeset_pool_exit();
+    xpath_parallel_worker(0);
+    return NULL;
+}
+
+/*! Validate a top XML tree for all entries using threads
+ *
+ * The top levels are validated in the calling thread, and the rest is split into subtrees
+ * in the order of serial validation. Subtrees whose YANG allows it are validated by
+ * nthreads worker threads while the tree is read-only. The other subtrees, and unique and
+ * min/max-elements of split nodes, are validated after in the calling thread. The error
+ * returned is the same as in serial validation: of the first failed task in document order.
+ * @param[in]  h        Clixon handle
+ * @param[in]  xt       Top XML tree
+ * @param[in]  nthreads Number of threads
+ * @param[out] xret     Error XML tree (if ret == 0). Free with xml_free after use
+ * @retval     1        Validation OK
+ * @retval     0        Validation failed (xret set)
+ * @retval    -1        Error
+ * @see xml_yang_validate_all_top
+ * @see yang_validate_parallel  for subtrees validated in threads
+ */
+static int
+xml_yang_validate_threads(clixon_handle h,
+                          cxobj        *xt,
+                          int           nthreads,
+                          cxobj       **xret)
+{
+    int                   retval = -1;
+    struct validate_work  vw = {0,};
+    struct validate_task *vt;
+    pthread_t            *tids = NULL;
+    cxobj                *x;
+    int                   units;
+    int                   frozen;
+    int                   threads;
+    int                   mutex = 0;
+    int                   n = 0;
+    int                   i;
+    int                   ret;
+
+    vw.vw_h = h;
+    vw.vw_xret = (xret != NULL);
+    /* Shallowest depth with enough units */
+    for (vw.vw_depth=1; vw.vw_depth<VALIDATE_THREAD_DEPTH; vw.vw_depth++)
+        if (validate_level_count(xt, vw.vw_depth, nthreads*VALIDATE_THREAD_UNITS)
+            >= nthreads*VALIDATE_THREAD_UNITS)
+            break;
+    /* Pending sorts are made now, not while the tree is read by threads */
+    if (xml_sort_ensure_recurse(xt) < 0)
+        goto done;
 #ifdef LEAFREF_OPTIMIZE
     leafref_opt_init(h);
-    retval = xml_yang_validate_all1(h, xt, xret);
+#endif
+    /* Node checks of top levels, split rest into tasks */
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if (vw.vw_depth > 1 && xml_child_nr_type(x, CX_ELMNT) > 0){
+            if ((ret = validate_split(h, &vw, x, 1)) < 0)
+                goto done;
+            if (ret == 0)
+                break;
+        }
+        else if (validate_task_add(&vw, x, VT_UNIT, 1, NULL) < 0)
+            goto done;
+    }
+    if (x == NULL &&
+        validate_task_add(&vw, xt, VT_TOP, 1, NULL) < 0)
+        goto done;
+    vw.vw_first = vw.vw_len;
+    if (x != NULL) /* Node check failed */
+        vw.vw_first--;
+    /* Units in threads */
+    units = 0;
+    for (i=0; i<vw.vw_first; i++)
+        if (vw.vw_tasks[i].vt_kind == VT_UNIT && vw.vw_tasks[i].vt_thread)
+            units++;
+    if (units > VALIDATE_THREAD_CHUNK){
+        if (nthreads > (units + VALIDATE_THREAD_CHUNK - 1) / VALIDATE_THREAD_CHUNK)
+            nthreads = (units + VALIDATE_THREAD_CHUNK - 1) / VALIDATE_THREAD_CHUNK;
+        if ((tids = calloc(nthreads, sizeof(*tids))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if (pthread_mutex_init(&vw.vw_mutex, NULL) != 0){
+            clixon_err(OE_UNIX, errno, "pthread_mutex_init");
+            goto done;
+        }
+        mutex++;
+        /* Namespace lookups in threads only read caches, and XML nodes are created in threads */
+        frozen = xml2ns_cache_freeze(1);
+        threads = xml_threads_set(1);
+        for (n=0; n<nthreads; n++)
+            if ((ret = pthread_create(&tids[n], NULL, validate_worker, &vw)) != 0){
+                clixon_err(OE_UNIX, ret, "pthread_create");
+                break;
+            }
+        for (i=0; i<n; i++)
+            pthread_join(tids[i], NULL);
+        xml_threads_set(threads);
+        xml2ns_cache_freeze(frozen);
+        if (vw.vw_err)
+            goto done;
+    }
+    /* Rest in calling thread in order, including units not validated by threads */
+    for (i=0; i<vw.vw_first; i++){
+        vt = &vw.vw_tasks[i];
+        if (vt->vt_kind == VT_UNIT && vt->vt_thread && n > 0)
+            continue;
+        if ((ret = validate_task_run(&vw, vt)) < 0)
+            goto done;
+        if (ret == 0){
+            vw.vw_first = i;
+            break;
+        }
+    }
+    if (vw.vw_first < vw.vw_len){
+        vt = &vw.vw_tasks[vw.vw_first];
+        if (xret){
+            *xret = vt->vt_xret;
+            vt->vt_xret = NULL;
+        }
+        retval = 0;
+    }
+    else
+        retval = 1;
+ done:
+#ifdef LEAFREF_OPTIMIZE
     leafref_opt_exit(h);
-#else
-    retval = xml_yang_validate_all1(h, xt, xret);
 #endif
+    if (mutex)
+        pthread_mutex_destroy(&vw.vw_mutex);
+    if (tids)
+        free(tids);
+    for (i=0; i<vw.vw_len; i++)
+        if (vw.vw_tasks[i].vt_xret)
+            xml_free(vw.vw_tasks[i].vt_xret);
+    if (vw.vw_tasks)
+        free(vw.vw_tasks);
     return retval;
 }
+#endif /* HAVE_LIBPTHREAD */
 
 /*! Validate a single XML node with yang specification
  *
@@ -1840,13 +2373,50 @@ int
 xml_yang_validate_all_top(clixon_handle h,
                           cxobj        *xt,
                           cxobj       **xret)
+{
+    return xml_yang_validate_all_changed(h, xt, NULL, xret);
+}
+
+/*! Validate a top XML tree where only part has changed since a valid tree
+ *
+ * Same as xml_yang_validate_all_top but must and when expressions whose dependencies are not
+ * in the change set are not evaluated, since they were true in the valid tree.
+ * Also, mandatory, min/max-elements and unique are only checked on nodes that are added,
+ * changed or have a name in the change set, eg parents of deleted nodes. Leafrefs of such
+ * nodes are only checked if a node named in the leafref path is in the change set, and
+ * identityrefs are not checked.
+ * Nodes of xt must be flagged with XML_FLAG_ADD and XML_FLAG_CHANGE as in a commit diff
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    Top XML tree
+ * @param[in]  chg   Set of names of changed nodes, see xml_yang_validate_changed. NULL: all
+ * @param[out] xret  Error XML tree (if ret == 0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @see VALIDATE_INCREMENTAL
+ */
+int
+xml_yang_validate_all_changed(clixon_handle  h,
+                              cxobj         *xt,
+                              clicon_hash_t *chg,
+                              cxobj        **xret)
 {
     int    ret;
     cxobj *x;
-
+#ifdef HAVE_LIBPTHREAD
+    int    nthreads;
+
+    /* Full validation in threads, not with debug or mount-points */
+    if (chg == NULL &&
+        (xret == NULL || *xret == NULL) &&
+        (nthreads = clicon_option_int(h, "CLICON_VALIDATE_THREADS")) > 1 &&
+        clixon_debug_get() == 0 &&
+        !clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT"))
+        return xml_yang_validate_threads(h, xt, nthreads, xret);
+#endif
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if ((ret = xml_yang_validate_all(h, x, xret)) < 1)
+        if ((ret = xml_yang_validate_all0(h, x, chg, xret)) < 1)
             return ret;
     }
     if ((ret = xml_yang_validate_minmax(xt, 0, xret)) < 1)
@@ -1854,6 +2424,38 @@ xml_yang_validate_all_top(clixon_handle h,
     return 1;
 }
 
+/*! Add names of a changed node and of its ancestors to a change set
+ *
+ * @param[in]  chg      Set of names, see clicon_hash_init
+ * @param[in]  x        Changed, added or deleted XML node
+ * @param[in]  recurse  Also add names of all descendants, eg of added or deleted node
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xml_yang_validate_all_changed
+ */
+int
+xml_yang_validate_changed(clicon_hash_t *chg,
+                          cxobj         *x,
+                          int            recurse)
+{
+    cxobj *xc;
+    cxobj *xp;
+
+    if (recurse){
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+            if (xml_yang_validate_changed(chg, xc, 1) < 0)
+                return -1;
+    }
+    for (xp = x; xp != NULL; xp = xml_parent(xp)){
+        if (clicon_hash_lookup(chg, xml_name(xp)) != NULL)
+            continue;
+        if (clicon_hash_add(chg, xml_name(xp), NULL, 0) == NULL)
+            return -1;
+    }
+    return 0;
+}
+
 /*! Exit validation module
  */
 int
@@ -1862,6 +2464,7 @@ xml_yang_validate_exit(clixon_handle h)
 #ifdef LEAFREF_OPTIMIZE
     leafref_opt_exit(h);
 #endif
+    xml_leafref_index_free(h);
     return 0;
 }
 
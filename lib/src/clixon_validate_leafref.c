@@ -0,0 +1,580 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Reverse leafref index, see LEAFREF_INDEX
+ * Maps a referred node, given by the name of the last step of a leafref path and a value,
+ * to the api-paths of all leafref leafs in running referring to it.
+ * Leafrefs of different schema nodes with the same name share an entry, which only means
+ * that some leafrefs are checked that need not be.
+ * When a node is deleted or its value changed in a commit, only the leafrefs referring to
+ * it need to be validated again, see xml_leafref_index_mark.
+ * The index is built from a valid running and updated with the diff of every commit. It is
+ * valid for a content generation of running, see de_gen.
+ */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <ctype.h>
+#include <string.h>
+#include <stdint.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_data.h"
+#include "clixon_path.h"
+#include "clixon_yang_type.h"
+#include "clixon_validate_leafref.h"
+
+/*
+ * Types
+ */
+/*! Reverse leafref index, stored in handle
+ */
+struct leafref_index {
+    clicon_hash_t *li_hash;   /* "<name> <value>" -> cbuf* of NUL-separated api-paths */
+    uint64_t       li_gen;    /* Content generation of running indexed, 0 if not valid */
+    cxobj        **li_marks;  /* Leafrefs flagged with XML_FLAG_LEAFREF */
+    size_t         li_nmarks; /* Length of li_marks */
+    int            li_marked; /* 1: marks are used in validation, -1: marks not usable */
+};
+
+/*! Get reverse leafref index, create if not found
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     li   Leafref index
+ * @retval     NULL Error
+ */
+static struct leafref_index *
+leafref_index_get(clixon_handle h)
+{
+    struct leafref_index *li = NULL;
+
+    if (clicon_ptr_get(h, "leafref-index", (void**)&li) == 0 && li != NULL)
+        return li;
+    if ((li = calloc(1, sizeof(*li))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    if ((li->li_hash = clicon_hash_init()) == NULL ||
+        clicon_ptr_set(h, "leafref-index", li) < 0){
+        if (li->li_hash)
+            clicon_hash_free(li->li_hash);
+        free(li);
+        return NULL;
+    }
+    return li;
+}
+
+/*! Free all entries of reverse leafref index
+ */
+static int
+leafref_index_clear(struct leafref_index *li)
+{
+    char  **keys = NULL;
+    size_t  nkeys = 0;
+    size_t  i;
+    cbuf  **cbp;
+
+    if (clicon_hash_keys(li->li_hash, &keys, &nkeys) < 0)
+        return -1;
+    for (i=0; i<nkeys; i++){
+        if ((cbp = clicon_hash_value(li->li_hash, keys[i], NULL)) != NULL)
+            cbuf_free(*cbp);
+        clicon_hash_del(li->li_hash, keys[i]);
+    }
+    if (keys)
+        free(keys);
+    li->li_gen = 0;
+    return 0;
+}
+
+/*! Print index key of the node referred to by a leafref path
+ *
+ * The key is the name of the last step of the path, without prefix and predicates
+ * @param[out] cb     Key
+ * @param[in]  path   Leafref path, eg /if:interfaces/if:interface/if:name
+ * @param[in]  value  Value of leafref
+ */
+static void
+leafref_index_key(cbuf       *cb,
+                  const char *path,
+                  const char *value)
+{
+    const char *s = path;
+    const char *p;
+    const char *e;
+    int         depth = 0;
+
+    for (p = path; *p; p++){
+        if (*p == '[')
+            depth++;
+        else if (*p == ']')
+            depth--;
+        else if (*p == '/' && depth == 0)
+            s = p+1;
+    }
+    while (isspace((unsigned char)*s))
+        s++;
+    if ((e = strchr(s, '[')) == NULL)
+        e = s + strlen(s);
+    while (e > s && isspace((unsigned char)*(e-1)))
+        e--;
+    if ((p = memchr(s, ':', e-s)) != NULL)
+        s = p+1;
+    cprintf(cb, "%.*s %s", (int)(e-s), s, value);
+}
+
+/*! Add or remove an api-path of a referring leafref
+ *
+ * @param[in]  li    Leafref index
+ * @param[in]  key   Key of referred node
+ * @param[in]  path  api-path of leafref
+ * @param[in]  add   1: add, 0: remove
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+leafref_index_set(struct leafref_index *li,
+                  char                 *key,
+                  char                 *path,
+                  int                   add)
+{
+    cbuf  **cbp;
+    cbuf   *cb = NULL;
+    char   *val;
+    size_t  vlen;
+    size_t  plen = strlen(path)+1;
+    size_t  i;
+
+    if ((cbp = clicon_hash_value(li->li_hash, key, NULL)) != NULL)
+        cb = *cbp;
+    if (add){
+        if (cb == NULL){
+            if ((cb = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                return -1;
+            }
+            if (clicon_hash_add(li->li_hash, key, &cb, sizeof(cb)) == NULL){
+                cbuf_free(cb);
+                return -1;
+            }
+        }
+        if (cbuf_append_buf(cb, path, plen) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            return -1;
+        }
+        return 0;
+    }
+    if (cb == NULL)
+        return 0;
+    val = cbuf_get(cb);
+    vlen = cbuf_len(cb);
+    for (i=0; i<vlen; i += strlen(val+i)+1)
+        if (strcmp(val+i, path) == 0)
+            break;
+    if (i >= vlen)
+        return 0;
+    if (vlen == plen){
+        cbuf_free(cb);
+        return clicon_hash_del(li->li_hash, key);
+    }
+    memmove(val+i, val+i+plen, vlen-i-plen);
+    cbuf_trunc(cb, vlen-plen);
+    return 0;
+}
+
+/*! Add or remove all leafrefs of an XML tree to the index
+ *
+ * @param[in]  li    Leafref index
+ * @param[in]  x     XML node
+ * @param[in]  add   1: add, 0: remove
+ * @param[in]  cbk   Assist buffer for key
+ * @param[in]  pb    Api-path builder
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+leafref_index_walk(struct leafref_index *li,
+                   cxobj                *x,
+                   int                   add,
+                   cbuf                 *cbk,
+                   api_path_builder     *pb)
+{
+    yang_stmt *ys;
+    yang_stmt *yrestype = NULL;
+    yang_stmt *ypath;
+    cxobj     *xc;
+    char      *body;
+    char      *path;
+
+    if ((ys = xml_spec(x)) == NULL || yang_config(ys) == 0)
+        return 0;
+    switch (yang_keyword_get(ys)){
+    case Y_LEAF:
+    case Y_LEAF_LIST:
+        if ((body = xml_body(x)) == NULL)
+            break;
+        if (yang_type_get(ys, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+            return -1;
+        if (yrestype == NULL ||
+            strcmp(yang_argument_get(yrestype), "leafref") != 0 ||
+            (ypath = yang_find(yrestype, Y_PATH, NULL)) == NULL)
+            break;
+        cbuf_reset(cbk);
+        leafref_index_key(cbk, yang_argument_get(ypath), body);
+        if (api_path_builder_path(pb, x, &path) < 0)
+            return -1;
+        if (leafref_index_set(li, cbuf_get(cbk), path, add) < 0)
+            return -1;
+        break;
+    default:
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+            if (leafref_index_walk(li, xc, add, cbk, pb) < 0)
+                return -1;
+        break;
+    }
+    return 0;
+}
+
+/*! Add or remove leafrefs of a vector of XML trees
+ */
+static int
+leafref_index_walk_vec(struct leafref_index *li,
+                       cxobj               **xvec,
+                       int                   xlen,
+                       int                   add)
+{
+    int               retval = -1;
+    cbuf             *cbk = NULL;
+    api_path_builder *pb = NULL;
+    int               i;
+
+    if ((cbk = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((pb = api_path_builder_new()) == NULL)
+        goto done;
+    for (i=0; i<xlen; i++)
+        if (leafref_index_walk(li, xvec[i], add, cbk, pb) < 0)
+            goto done;
+    retval = 0;
+ done:
+    if (cbk)
+        cbuf_free(cbk);
+    if (pb)
+        api_path_builder_free(pb);
+    return retval;
+}
+
+/*! Build reverse leafref index from a valid tree, typically running
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  xt   Top of XML tree
+ * @param[in]  gen  Content generation of tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xml_leafref_index_build(clixon_handle h,
+                        cxobj        *xt,
+                        uint64_t      gen)
+{
+    struct leafref_index *li;
+    cxobj                *x;
+    cxobj               **xvec = NULL;
+    int                   xlen = 0;
+    int                   retval = -1;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "");
+    if ((li = leafref_index_get(h)) == NULL)
+        goto done;
+    if (leafref_index_clear(li) < 0)
+        goto done;
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+        if (cxvec_append(x, &xvec, &xlen) < 0)
+            goto done;
+    if (leafref_index_walk_vec(li, xvec, xlen, 1) < 0)
+        goto done;
+    li->li_gen = gen;
+    retval = 0;
+ done:
+    if (xvec)
+        free(xvec);
+    return retval;
+}
+
+/*! Update reverse leafref index with added or deleted trees, eg of a commit diff
+ *
+ * Call with deleted and original values of changed nodes before added and new values
+ * @param[in]  h     Clixon handle
+ * @param[in]  xvec  Vector of XML trees
+ * @param[in]  xlen  Length of xvec
+ * @param[in]  add   1: leafrefs in trees are added, 0: deleted
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xml_leafref_index_update(clixon_handle h,
+                         cxobj       **xvec,
+                         int           xlen,
+                         int           add)
+{
+    struct leafref_index *li;
+
+    if ((li = leafref_index_get(h)) == NULL)
+        return -1;
+    return leafref_index_walk_vec(li, xvec, xlen, add);
+}
+
+/*! Get content generation of tree indexed
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     gen  Content generation, 0 if index is not valid
+ */
+uint64_t
+xml_leafref_index_gen(clixon_handle h)
+{
+    struct leafref_index *li = NULL;
+
+    if (clicon_ptr_get(h, "leafref-index", (void**)&li) < 0 || li == NULL)
+        return 0;
+    return li->li_gen;
+}
+
+/*! Set content generation of tree indexed, eg after update with commit diff
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  gen  Content generation, 0 if index is not valid
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xml_leafref_index_gen_set(clixon_handle h,
+                          uint64_t      gen)
+{
+    struct leafref_index *li;
+
+    if ((li = leafref_index_get(h)) == NULL)
+        return -1;
+    li->li_gen = gen;
+    return 0;
+}
+
+/*! Flag leafrefs in target referring to deleted or changed nodes
+ *
+ * After this, validation only checks leafrefs of unchanged nodes if they are flagged with
+ * XML_FLAG_LEAFREF. If a referring leafref can not be found, all leafrefs are checked.
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    Top of target XML tree
+ * @param[in]  xvec  Deleted nodes and original values of changed nodes, in source tree
+ * @param[in]  xlen  Length of xvec
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml_leafref_index_unmark  Call after validation
+ */
+int
+xml_leafref_index_mark(clixon_handle h,
+                       cxobj        *xt,
+                       cxobj       **xvec,
+                       int           xlen)
+{
+    int                   retval = -1;
+    struct leafref_index *li;
+    cbuf                 *cbk = NULL;
+    cbuf                **cbp;
+    cxobj               **xv = NULL;
+    cxobj               **xrefs = NULL;
+    int                   xrlen = 0;
+    int                   xvlen = 0;
+    cxobj                *x;
+    yang_stmt            *ys;
+    char                 *body;
+    char                 *val;
+    size_t                vlen;
+    size_t                j;
+    int                   i;
+    int                   k;
+    int                   ret;
+
+    if ((li = leafref_index_get(h)) == NULL)
+        goto done;
+    if (li->li_marked < 0)
+        goto ok;
+    li->li_marked = 1;
+    if ((cbk = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* All leafs of deleted and changed trees */
+    for (i=0; i<xlen; i++){
+        if (cxvec_append(xvec[i], &xv, &xvlen) < 0)
+            goto done;
+    }
+    for (i=0; i<xvlen; i++){
+        x = xv[i];
+        if ((ys = xml_spec(x)) == NULL)
+            continue;
+        if (yang_keyword_get(ys) != Y_LEAF && yang_keyword_get(ys) != Y_LEAF_LIST){
+            x = NULL;
+            while ((x = xml_child_each(xv[i], x, CX_ELMNT)) != NULL)
+                if (cxvec_append(x, &xv, &xvlen) < 0)
+                    goto done;
+            continue;
+        }
+        if ((body = xml_body(x)) == NULL)
+            continue;
+        cbuf_reset(cbk);
+        cprintf(cbk, "%s %s", xml_name(x), body);
+        if ((cbp = clicon_hash_value(li->li_hash, cbuf_get(cbk), NULL)) == NULL)
+            continue;
+        val = cbuf_get(*cbp);
+        vlen = cbuf_len(*cbp);
+        for (j=0; j<vlen; j += strlen(val+j)+1){
+            if ((ret = clixon_xml_find_api_path(xt, ys_spec(ys), &xrefs, &xrlen, "%s", val+j)) < 0)
+                goto done;
+            if (ret == 0){ /* Not known where referring leafs are, check all */
+                clixon_debug(CLIXON_DBG_DATASTORE, "leafref %s not found, check all", val+j);
+                if (xml_leafref_index_unmark(h) < 0)
+                    goto done;
+                li->li_marked = -1;
+                goto ok;
+            }
+            for (k=0; k<xrlen; k++){
+                if (xml_flag(xrefs[k], XML_FLAG_LEAFREF))
+                    continue;
+                xml_flag_set(xrefs[k], XML_FLAG_LEAFREF);
+                if ((li->li_marks = realloc(li->li_marks, (li->li_nmarks+1)*sizeof(cxobj*))) == NULL){
+                    clixon_err(OE_UNIX, errno, "realloc");
+                    goto done;
+                }
+                li->li_marks[li->li_nmarks++] = xrefs[k];
+            }
+            if (xrefs){
+                free(xrefs);
+                xrefs = NULL;
+            }
+            xrlen = 0;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    if (xrefs)
+        free(xrefs);
+    if (xv)
+        free(xv);
+    if (cbk)
+        cbuf_free(cbk);
+    return retval;
+}
+
+/*! Check if leafrefs are flagged by xml_leafref_index_mark
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     1    Only flagged leafrefs of unchanged nodes need to be checked
+ * @retval     0    No, check leafrefs of unchanged nodes by their dependencies
+ */
+int
+xml_leafref_index_marked(clixon_handle h)
+{
+    struct leafref_index *li = NULL;
+
+    if (clicon_ptr_get(h, "leafref-index", (void**)&li) < 0 || li == NULL)
+        return 0;
+    return li->li_marked == 1;
+}
+
+/*! Reset flags set by xml_leafref_index_mark
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xml_leafref_index_unmark(clixon_handle h)
+{
+    struct leafref_index *li = NULL;
+    size_t                i;
+
+    if (clicon_ptr_get(h, "leafref-index", (void**)&li) < 0 || li == NULL)
+        return 0;
+    for (i=0; i<li->li_nmarks; i++)
+        xml_flag_reset(li->li_marks[i], XML_FLAG_LEAFREF);
+    if (li->li_marks)
+        free(li->li_marks);
+    li->li_marks = NULL;
+    li->li_nmarks = 0;
+    li->li_marked = 0;
+    return 0;
+}
+
+/*! Free reverse leafref index
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+xml_leafref_index_free(clixon_handle h)
+{
+    struct leafref_index *li = NULL;
+
+    if (clicon_ptr_get(h, "leafref-index", (void**)&li) < 0 || li == NULL)
+        return 0;
+    xml_leafref_index_unmark(h);
+    leafref_index_clear(li);
+    clicon_hash_free(li->li_hash);
+    free(li);
+    clicon_ptr_del(h, "leafref-index");
+    return 0;
+}
@@ -49,11 +49,13 @@
 #include <errno.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <arpa/inet.h>
 #include <sys/param.h>
 #include <netinet/in.h>
+#include <time.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -79,8 +81,10 @@
 #include "clixon_yang_module.h"
 #include "clixon_yang_type.h"
 #include "clixon_xml_map.h"
+#include "clixon_xml_sort.h"
 #include "clixon_xml_bind.h"
 #include "clixon_validate_minmax.h"
+#include "clixon_validate_profile.h"
 
 /*
  * Local types
@@ -95,53 +99,226 @@ struct vec_order {
     size_t        vo_slen;   /* Length of vo_strvec (is actually global to vector) */
 };
 
-/*! New element last in list, check if already exists if so return -1
+/* Adjacent compare of sorted list or leaf-list entries, see dup_adjacent_check
+ */
+struct dup_adjacent {
+    yang_stmt *da_y;     /* YANG of current list segment */
+    cvec      *da_cvk;   /* List keys, NULL if leaf-list */
+    cxobj     *da_first; /* First entry of segment, for error */
+    cxobj     *da_prev;  /* Previous entry with all keys */
+    char     **da_kprev; /* Key values of previous entry */
+    char     **da_kcur;  /* Key values of current entry */
+    size_t     da_klen;  /* Number of keys */
+    size_t     da_max;   /* Allocated length of da_kprev and da_kcur */
+};
+
+/*! Hash set of unique tuples of list entries, open addressing with linear probing
  *
- * @param[in]  vec   Vector of existing entries (new is last)
- * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Length of entry
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
+ * Replaces pairwise comparison of tuples, which is quadratic for unique statements and
+ * lists ordered-by user.
+ * @see check_unique_list_direct
+ */
+struct unique_hash {
+    uint64_t *uh_hash;   /* Hash of tuple per slot, 0 if slot is empty */
+    cxobj   **uh_xml;    /* List entry (or node of xpath result) per slot */
+    size_t    uh_size;   /* Number of slots, power of two */
+    size_t    uh_len;    /* Number of used slots */
+    cvec     *uh_cvk;    /* Names of tuple leafs, or NULL if tuple is body of node */
+};
+
+/*! Hash a string into a running FNV-1a hash, including terminating NUL as separator
+ */
+static uint64_t
+unique_hash_str(uint64_t    h,
+                const char *str)
+{
+    const unsigned char *s = (const unsigned char *)str;
+
+    do {
+        h ^= *s;
+        h *= 0x100000001b3ULL;
+    } while (*s++ != '\0');
+    return h;
+}
+
+/*! Compute hash of tuple of a list entry
+ *
+ * @param[in]  x    List entry, or node of xpath result if cvk is NULL
+ * @param[in]  cvk  Names of tuple leafs, or NULL
+ * @param[out] hash Hash of tuple, never 0
+ * @retval     1    OK
+ * @retval     0    Entry does not have values for all leafs and is not taken into account
+ */
+static int
+unique_hash_tuple(cxobj    *x,
+                  cvec     *cvk,
+                  uint64_t *hash)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    cg_var  *cvi = NULL;
+    cxobj   *xi;
+    char    *bi;
+
+    if (cvk == NULL){
+        if ((bi = xml_body(x)) == NULL)
+            return 0;
+        h = unique_hash_str(h, bi);
+    }
+    else while ((cvi = cvec_each(cvk, cvi)) != NULL){
+        if ((xi = xml_find(x, cv_string_get(cvi))) == NULL)
+            return 0;
+        if ((bi = xml_body(xi)) == NULL)
+            return 0;
+        h = unique_hash_str(h, bi);
+    }
+    *hash = h?h:1;
+    return 1;
+}
+
+/*! Compare tuples of two list entries
+ *
+ * @retval     1    Equal
+ * @retval     0    Not equal
+ */
+static int
+unique_hash_eq(cxobj *x1,
+               cxobj *x2,
+               cvec  *cvk)
+{
+    cg_var *cvi = NULL;
+    char   *str;
+
+    if (cvk == NULL)
+        return strcmp(xml_body(x1), xml_body(x2)) == 0;
+    while ((cvi = cvec_each(cvk, cvi)) != NULL){
+        str = cv_string_get(cvi);
+        if (strcmp(xml_body(xml_find(x1, str)), xml_body(xml_find(x2, str))) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+/*! Resize hash set to at least n slots
+ */
+static int
+unique_hash_resize(struct unique_hash *uh,
+                   size_t              n)
+{
+    uint64_t *hvec;
+    cxobj   **xvec;
+    size_t    size = 16;
+    size_t    i;
+    size_t    j;
+
+    while (size < 2*n)
+        size *= 2;
+    if ((hvec = calloc(size, sizeof(*hvec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    if ((xvec = calloc(size, sizeof(*xvec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        free(hvec);
+        return -1;
+    }
+    for (i=0; i<uh->uh_size; i++){
+        if (uh->uh_hash[i] == 0)
+            continue;
+        j = uh->uh_hash[i] & (size-1);
+        while (hvec[j] != 0)
+            j = (j+1) & (size-1);
+        hvec[j] = uh->uh_hash[i];
+        xvec[j] = uh->uh_xml[i];
+    }
+    if (uh->uh_hash)
+        free(uh->uh_hash);
+    if (uh->uh_xml)
+        free(uh->uh_xml);
+    uh->uh_hash = hvec;
+    uh->uh_xml = xvec;
+    uh->uh_size = size;
+    return 0;
+}
+
+/*! Insert tuple of a list entry into hash set unless already there
+ *
+ * @param[in]  uh   Hash set
+ * @param[in]  x    List entry, or node of xpath result if uh_cvk is NULL
+ * @retval     1    Inserted, or entry lacks values and is not taken into account
+ * @retval     0    Duplicate
+ * @retval    -1    Error
+ */
+static int
+unique_hash_insert(struct unique_hash *uh,
+                   cxobj              *x)
+{
+    uint64_t hash;
+    size_t   j;
+
+    if (unique_hash_tuple(x, uh->uh_cvk, &hash) == 0)
+        return 1;
+    if (2*(uh->uh_len+1) > uh->uh_size &&
+        unique_hash_resize(uh, uh->uh_len+1) < 0)
+        return -1;
+    j = hash & (uh->uh_size-1);
+    while (uh->uh_hash[j] != 0){
+        if (uh->uh_hash[j] == hash &&
+            unique_hash_eq(uh->uh_xml[j], x, uh->uh_cvk))
+            return 0;
+        j = (j+1) & (uh->uh_size-1);
+    }
+    uh->uh_hash[j] = hash;
+    uh->uh_xml[j] = x;
+    uh->uh_len++;
+    return 1;
+}
+
+/*! Free data of hash set
+ */
+static int
+unique_hash_free(struct unique_hash *uh)
+{
+    if (uh->uh_hash)
+        free(uh->uh_hash);
+    if (uh->uh_xml)
+        free(uh->uh_xml);
+    return 0;
+}
+
+/*! Collect xpath search results of one list entry, fail if already exists
+ *
+ * @param[in]  x     List entry
+ * @param[in]  xpath Descendant schema node identifier as canonical xpath
+ * @param[in]  nsc   Namespace context of xpath
+ * @param[in]  uh    Hash set of search results of previous entries
  * @retval     1     Validation OK
- * @retval     0     Validation failed (cbret set)
+ * @retval     0     Validation failed, duplicate
  * @retval    -1     Error
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
  */
 static int
-unique_search_xpath(cxobj  *x,
-                    char   *xpath,
-                    cvec   *nsc,
-                    char ***svec,
-                    size_t *slen)
+unique_search_xpath(cxobj              *x,
+                    char               *xpath,
+                    cvec               *nsc,
+                    struct unique_hash *uh)
 {
     int     retval = -1;
     cxobj **xvec = NULL;
     size_t  xveclen;
     int     i;
-    int     s;
     cxobj  *xi;
-    char   *bi;
+    int     ret;
 
     /* Collect tuples */
     if (xpath_vec(x, nsc, "%s", &xvec, &xveclen, xpath) < 0)
         goto done;
     for (i=0; i<xveclen; i++){
         xi = xvec[i];
-        if ((bi = xml_body(xi)) == NULL)
+        if (xml_body(xi) == NULL)
             break;
-        /* Check if bi is duplicate?
-         * XXX: sort svec?
-         */
-        for (s=0; s<(*slen); s++){
-            if (strcmp(bi, (*svec)[s]) == 0){
-                goto fail;
-            }
-        }
-        (*slen) ++;
-        if (((*svec) = realloc((*svec), (*slen)*sizeof(char*))) == NULL){
-            clixon_err(OE_UNIX, errno, "realloc");
+        if ((ret = unique_hash_insert(uh, xi)) < 0)
             goto done;
-        }
-        (*svec)[(*slen)-1] = bi;
+        if (ret == 0)
+            goto fail;
     } /* i search results */
     retval = 1;
  done:
@@ -162,7 +339,7 @@ unique_search_xpath(cxobj  *x,
  * @param[out] dupl   Index of duplicated element (if retval = -1)
  * @retval     0      OK, entry is unique
  * @retval    -1      Duplicate detected
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
+ * @note Unsorted is quadratic complexity, check_unique_list_direct uses unique_hash_insert instead
  */
 static int
 check_insert_duplicate(char **vec,
@@ -255,10 +432,11 @@ check_unique_list_direct(cxobj     *x,
     char     *str;
     cvec     *cvk;
     int       dupl;
+    struct unique_hash uh = {0,};
+    int       ret;
 
     /* If list and is sorted by system, then it is assumed elements are in key-order which is optimized
-     * Other cases are "unique" constraint or list sorted by user which is quadratic in complexity
-     * This second case COULD be optimized if binary insert is made on the vec vector.
+     * Other cases are "unique" constraint or list sorted by user which use a hash set of tuples
      */
     sorted = (yang_keyword_get(yu) == Y_LIST &&
               yang_find(y, Y_ORDERED_BY, "user") == NULL);
@@ -268,6 +446,32 @@ check_unique_list_direct(cxobj     *x,
         /* No keys: no checks necessary */
         goto ok;
     }
+    if (!sorted){
+        /* Hash set of tuples instead of comparing with all previous entries */
+        cvi = NULL;
+        while ((cvi = cvec_each(cvk, cvi)) != NULL){
+            if (index(cv_string_get(cvi), '/') != NULL){
+                clixon_err(OE_YANG, 0, "Multiple descendant nodes not allowed (w /)");
+                goto done;
+            }
+        }
+        uh.uh_cvk = cvk;
+        if (unique_hash_resize(&uh, xml_child_nr(xt)) < 0)
+            goto done;
+        do {
+            /* RFC7950: Sec 7.8.3.1: entries that do not have value for all
+             * referenced leafs are not taken into account */
+            if ((ret = unique_hash_insert(&uh, x)) < 0)
+                goto done;
+            if (ret == 0){
+                if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
+                    goto done;
+                goto fail;
+            }
+            x = xml_child_each(xt, x, CX_ELMNT);
+        } while (x && y == xml_spec(x));  /* stop if list ends, others may follow */
+        goto ok;
+    }
     /* Vector of key values, k00,k01,..,k0n,k10,k11,..
      * Ie, if nr of keys is n, and nr of children is m, then length is n*m
      * x need not be child 0, which could make the vector larger than necessary */
@@ -320,6 +524,7 @@ check_unique_list_direct(cxobj     *x,
         free(xvec);
     if (vec)
         free(vec);
+    unique_hash_free(&uh);
     return retval;
  fail:
     retval = 0;
@@ -359,8 +564,7 @@ check_unique_list(cxobj     *x,
 {
     int     retval = -1;
     cg_var *cvi; /* unique node name */
-    char  **svec = NULL; /* vector of search results */
-    size_t  slen = 0;
+    struct unique_hash uh = {0,}; /* set of search results */
     char   *xpath0 = NULL;
     char   *xpath1 = NULL;
     int     ret;
@@ -394,7 +598,7 @@ check_unique_list(cxobj     *x,
         goto fail; // XXX set xret
     do {
         /* Collect search results from one */
-        if ((ret = unique_search_xpath(x, xpath1, nsc1, &svec, &slen)) < 0)
+        if ((ret = unique_search_xpath(x, xpath1, nsc1, &uh)) < 0)
             goto done;
         if (ret == 0){
             if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
@@ -413,8 +617,7 @@ check_unique_list(cxobj     *x,
         cvec_free(nsc1);
     if (xpath1)
         free(xpath1);
-    if (svec)
-        free(svec);
+    unique_hash_free(&uh);
     return retval;
  fail:
     retval = 0;
@@ -490,8 +693,10 @@ check_empty_list_minmax(cxobj     *xt,
     int        inext;
 
     if (yang_config(ye) == 1){
+        /* Containers without min-elements below are skipped, see YANG_SCHEMA_SUMMARY */
         if(yang_keyword_get(ye) == Y_CONTAINER &&
-           yang_find(ye, Y_PRESENCE, NULL) == NULL){
+           yang_find(ye, Y_PRESENCE, NULL) == NULL &&
+           yang_minmax_maybe(ye)){
             inext = 0;
             while ((yprev = yn_iter(ye, &inext)) != NULL) {
                 if ((ret = check_empty_list_minmax(xt, yprev, xret)) < 0)
@@ -702,7 +907,10 @@ xml_yang_validate_minmax(cxobj  *xt,
     int           ret;
     yang_stmt    *yt;
     int           inext = 0;
+    int           prof;
+    struct timespec t0;
 
+    prof = validate_profile_enabled();
     yt = xml_spec(xt); /* If yt == NULL, then no gap-analysis is done */
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL){
         if ((y = xml_spec(x)) == NULL)
@@ -729,12 +937,16 @@ xml_yang_validate_minmax(cxobj  *xt,
             /* new list check */
             if (ret){
                 if (keyw == Y_LIST){
+                    if (prof)
+                        validate_profile_start(&t0);
                     if ((ret = check_unique_list_direct(x, xt, y, y, xret)) < 0)
                         goto done;
                     if (ret == 0)
                         goto fail;
                     if ((ret = xml_unique_detect(x, xt, y, xret)) < 0)
                         goto done;
+                    if (prof && validate_profile_add(y, VP_UNIQUE, &t0) < 0)
+                        goto done;
                     if (ret == 0)
                         goto fail;
                 }
@@ -965,6 +1177,115 @@ remove_duplicates_single(yang_stmt        *y,
     return retval;
 }
 
+/*! Check a list or leaf-list entry against the previous entry of a sorted segment
+ *
+ * Entries of lists ordered-by system are sorted by key, so duplicates are adjacent and are
+ * detected without collecting and sorting vectors, see vec_order_analyze.
+ * @param[in]  da    Adjacent compare state
+ * @param[in]  x     List or leaf-list entry
+ * @param[in]  y     YANG of x, ordered-by system
+ * @param[in]  rm    0: return 0 on duplicate, 1: remove previous duplicate, keep last
+ * @param[out] xret  Error XML tree. Free with xml_free after use
+ * @retval     1     OK, no duplicate or removed
+ * @retval     0     Validation failed (xret set) (only if rm=0)
+ * @retval    -1     Error
+ */
+static int
+dup_adjacent_check(struct dup_adjacent *da,
+                   cxobj               *x,
+                   yang_stmt           *y,
+                   int                  rm,
+                   cxobj              **xret)
+{
+    int       retval = -1;
+    cvec     *cvk = NULL;
+    cg_var   *cvi;
+    cxobj    *xi;
+    char    **kv;
+    size_t    i;
+
+    if (da->da_y != y){ /* New segment */
+        da->da_y = y;
+        da->da_first = NULL;
+        da->da_prev = NULL;
+        if (yang_keyword_get(y) == Y_LIST){
+            da->da_cvk = yang_cvec_get(y);
+            da->da_klen = da->da_cvk ? cvec_len(da->da_cvk) : 0;
+        }
+        else {
+            da->da_cvk = NULL;
+            da->da_klen = 1;
+        }
+        if (da->da_klen > da->da_max){
+            if ((kv = realloc(da->da_kprev, da->da_klen*sizeof(char *))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            da->da_kprev = kv;
+            if ((kv = realloc(da->da_kcur, da->da_klen*sizeof(char *))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            da->da_kcur = kv;
+            da->da_max = da->da_klen;
+        }
+    }
+    if (da->da_klen == 0)
+        goto ok;
+    if (da->da_cvk == NULL)
+        da->da_kcur[0] = xml_body(x);
+    else {
+        i = 0;
+        cvi = NULL;
+        while ((cvi = cvec_each(da->da_cvk, cvi)) != NULL){
+            if (cv_string_get(cvi) == NULL ||
+                (xi = xml_find(x, cv_string_get(cvi))) == NULL)
+                goto ok; /* No key: skip */
+            da->da_kcur[i++] = xml_body(xi) ? xml_body(xi) : "";
+        }
+    }
+    if (da->da_first == NULL)
+        da->da_first = x;
+    if (da->da_prev != NULL){
+        for (i=0; i<da->da_klen; i++)
+            if (clicon_strcmp(da->da_kprev[i], da->da_kcur[i]) != 0)
+                break;
+        if (i == da->da_klen){ /* Duplicate */
+            if (rm){
+                if (xml_purge(da->da_prev) < 0)
+                    goto done;
+                xml_vector_decrement(x, 1);
+            }
+            else {
+                if (da->da_cvk == NULL){
+                    if ((cvk = cvec_new(0)) == NULL){
+                        clixon_err(OE_UNIX, errno, "cvec_new");
+                        goto done;
+                    }
+                    cvec_add_string(cvk, "name", da->da_kcur[0]);
+                }
+                if (xret && netconf_data_not_unique_xml(xret, da->da_first,
+                                                        cvk?cvk:da->da_cvk) < 0)
+                    goto done;
+                goto fail;
+            }
+        }
+    }
+    da->da_prev = x;
+    kv = da->da_kprev;
+    da->da_kprev = da->da_kcur;
+    da->da_kcur = kv;
+ ok:
+    retval = 1;
+ done:
+    if (cvk)
+        cvec_free(cvk);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Analyze sorted list: detect and potentially remove duplicates
  *
  * @param[in]  y     YANG node of list segment
@@ -1051,14 +1372,28 @@ xml_duplicate_detect1(cxobj  *xt,
     cxobj            *xi;
     int               v;
     int               ret;
+    int               user = 0;
+    int               enumerated = 0;
+    struct dup_adjacent da = {0,};
 
-    xml_enumerate_children(xt); // Could be done in-line
+    if (xml_sort_ensure(xt) < 0)
+        goto done;
     y0 = NULL;
     slen0 = 0;
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
         if ((y = xml_spec(x)) == NULL)
             continue;
+        if (y != y0){
+            keyw = yang_keyword_get(y);
+            user = (keyw == Y_LIST || keyw == Y_LEAF_LIST) &&
+                yang_find(y, Y_ORDERED_BY, "user") != NULL;
+            /* Order of entries is only needed to sort ordered-by user segments */
+            if (user && !enumerated){
+                xml_enumerate_children(xt);
+                enumerated++;
+            }
+        }
         if (y != y0 && vec != NULL){ /* New */
             if ((ret = vec_order_analyze(y0, vec, vlen, x, rm, xret)) < 0)
                 goto done;
@@ -1070,7 +1405,21 @@ xml_duplicate_detect1(cxobj  *xt,
             vlen = 0;
             slen0 = 0;
         }
-        keyw = yang_keyword_get(y);
+        /* Sorted by system: duplicates are adjacent */
+        if (!user && (keyw == Y_LIST || keyw == Y_LEAF_LIST)){
+            if ((ret = dup_adjacent_check(&da, x, y, rm, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            /* Special case of YANG unique statement */
+            if (keyw == Y_LIST &&
+                (ret = xml_unique_detect(x, xt, y, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            y0 = y;
+            continue;
+        }
         switch (keyw){
         case Y_CONTAINER:
         case Y_LEAF:
@@ -1169,6 +1518,10 @@ xml_duplicate_detect1(cxobj  *xt,
  done:
     if (vec)
         vec_free(vec, vlen);
+    if (da.da_kprev)
+        free(da.da_kprev);
+    if (da.da_kcur)
+        free(da.da_kcur);
     return retval;
  fail:
     retval = 0;
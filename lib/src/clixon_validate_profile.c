@@ -0,0 +1,307 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ * Validation cost profiler
+ * When debug subject CLIXON_DBG_PROFILE is set, validation checks are recorded per YANG
+ * schema node and per kind of check, see enum validate_profile_kind:
+ * number of calls, total and max time.
+ * The profile is exposed in the stats RPC, see from_client_stats
+ * Parallel validation is not made when debug is set, so the profile is not locked.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <time.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_string.h"
+#include "clixon_validate_profile.h"
+
+/* Max number of profiled YANG nodes, new nodes are not recorded when full */
+#define VALIDATE_PROFILE_SIZE 8192
+
+/*
+ * Types
+ */
+/*! Profile of validation checks of one YANG schema node
+ */
+struct validate_profile_entry{
+    qelem_t    vp_q;              /* Queue of entries, in order of first check */
+    yang_stmt *vp_yang;           /* YANG schema node, key of entry */
+    char      *vp_node;           /* Schema node as <module>:<schema path> */
+    uint64_t   vp_calls[VP_NR];   /* Number of checks per kind */
+    uint64_t   vp_nsec[VP_NR];    /* Total time of checks per kind in nano-seconds */
+    uint64_t   vp_maxnsec[VP_NR]; /* Max time of one check per kind in nano-seconds */
+};
+
+/*
+ * Variables
+ */
+/* Profile entries: yang_stmt* -> struct validate_profile_entry* */
+static clicon_hash_t                 *_validate_profile = NULL;
+/* Queue of profile entries */
+static struct validate_profile_entry *_validate_profile_list = NULL;
+/* Number of profile entries */
+static int                            _validate_profile_nr = 0;
+/* YANG node of current type check, for pattern and range checks, see validate_profile_node */
+static yang_stmt                     *_validate_profile_node = NULL;
+
+/* Names of kinds, same order as enum validate_profile_kind */
+static const map_str2int vpkmap[] = {
+    {"type",    VP_TYPE},
+    {"pattern", VP_PATTERN},
+    {"range",   VP_RANGE},
+    {"must",    VP_MUST},
+    {"when",    VP_WHEN},
+    {"leafref", VP_LEAFREF},
+    {"unique",  VP_UNIQUE},
+    {"minmax",  VP_MINMAX},
+    {NULL,      -1}
+};
+
+/*! Check if validation profiling is enabled
+ *
+ * @retval  1  Enabled by debug subject CLIXON_DBG_PROFILE
+ * @retval  0  Not enabled
+ */
+int
+validate_profile_enabled(void)
+{
+    return clixon_debug_isset(CLIXON_DBG_PROFILE);
+}
+
+/*! Set YANG node of following pattern and range checks
+ *
+ * Type checks do not know the leaf they check, so the caller sets it
+ * @param[in]  ys  YANG leaf or leaf-list, or NULL
+ * @retval     ys  Previous YANG node, restore after check
+ */
+yang_stmt *
+validate_profile_node(yang_stmt *ys)
+{
+    yang_stmt *yold = _validate_profile_node;
+
+    _validate_profile_node = ys;
+    return yold;
+}
+
+/*! Start time of a check
+ *
+ * @param[out] t0  Start time, give to validate_profile_add
+ */
+void
+validate_profile_start(struct timespec *t0)
+{
+    clock_gettime(CLOCK_MONOTONIC, t0);
+}
+
+/*! Print schema node path of YANG statement, eg /a/b
+ *
+ * @param[in]  cb  CLIgen buffer
+ * @param[in]  ys  YANG statement
+ */
+static void
+validate_profile_path2cbuf(cbuf      *cb,
+                           yang_stmt *ys)
+{
+    if (ys == NULL ||
+        yang_keyword_get(ys) == Y_MODULE ||
+        yang_keyword_get(ys) == Y_SUBMODULE)
+        return;
+    validate_profile_path2cbuf(cb, yang_parent_get(ys));
+    cprintf(cb, "/%s", yang_argument_get(ys));
+}
+
+/*! Record one validation check in the profile
+ *
+ * @param[in]  ys    YANG schema node checked, or NULL for node set by validate_profile_node
+ * @param[in]  kind  Kind of check
+ * @param[in]  t0    Start time of check, see validate_profile_start
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @code
+ *   struct timespec t0;
+ *   if (validate_profile_enabled())
+ *      validate_profile_start(&t0);
+ *   ret = validate_leafref(xt, yt, yc, xret);
+ *   if (validate_profile_enabled() && validate_profile_add(yt, VP_LEAFREF, &t0) < 0)
+ *      err;
+ * @endcode
+ */
+int
+validate_profile_add(yang_stmt                 *ys,
+                     enum validate_profile_kind kind,
+                     struct timespec           *t0)
+{
+    int                            retval = -1;
+    struct validate_profile_entry *ve;
+    struct timespec                t1;
+    uint64_t                       nsec;
+    cbuf                          *cb = NULL;
+    yang_stmt                     *ymod;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    nsec = (t1.tv_sec - t0->tv_sec)*1000000000ULL + t1.tv_nsec - t0->tv_nsec;
+    if (ys == NULL && (ys = _validate_profile_node) == NULL)
+        goto ok;
+    if (_validate_profile == NULL &&
+        (_validate_profile = clicon_hash_init()) == NULL)
+        goto done;
+    if ((ve = clicon_hash_ptr_value(_validate_profile, ys)) == NULL){
+        if (_validate_profile_nr >= VALIDATE_PROFILE_SIZE)
+            goto ok;
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        if ((ymod = ys_module(ys)) != NULL)
+            cprintf(cb, "%s:", yang_argument_get(ymod));
+        validate_profile_path2cbuf(cb, ys);
+        if ((ve = calloc(1, sizeof(*ve))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        ve->vp_yang = ys;
+        if ((ve->vp_node = strdup(cbuf_get(cb))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            free(ve);
+            goto done;
+        }
+        if (clicon_hash_add_ptr(_validate_profile, ys, ve) == NULL){
+            free(ve->vp_node);
+            free(ve);
+            goto done;
+        }
+        ADDQ(ve, _validate_profile_list);
+        _validate_profile_nr++;
+    }
+    ve->vp_calls[kind]++;
+    ve->vp_nsec[kind] += nsec;
+    if (nsec > ve->vp_maxnsec[kind])
+        ve->vp_maxnsec[kind] = nsec;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Print validation profile as XML entries of clixon-lib stats validate-profile
+ *
+ * @param[in]  cb   CLIgen buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+validate_profile_print(cbuf *cb)
+{
+    int                            retval = -1;
+    struct validate_profile_entry *ve;
+    char                          *encstr = NULL;
+    int                            k;
+
+    if ((ve = _validate_profile_list) != NULL){
+        do {
+            cprintf(cb, "<entry>");
+            if (xml_chardata_encode(&encstr, 0, "%s", ve->vp_node) < 0)
+                goto done;
+            cprintf(cb, "<node>%s</node>", encstr);
+            free(encstr);
+            encstr = NULL;
+            for (k=0; k<VP_NR; k++){
+                if (ve->vp_calls[k] == 0)
+                    continue;
+                cprintf(cb, "<check>");
+                cprintf(cb, "<kind>%s</kind>", clicon_int2str(vpkmap, k));
+                cprintf(cb, "<calls>%" PRIu64 "</calls>", ve->vp_calls[k]);
+                cprintf(cb, "<nsec>%" PRIu64 "</nsec>", ve->vp_nsec[k]);
+                cprintf(cb, "<maxnsec>%" PRIu64 "</maxnsec>", ve->vp_maxnsec[k]);
+                cprintf(cb, "</check>");
+            }
+            cprintf(cb, "</entry>");
+            ve = NEXTQ(struct validate_profile_entry *, ve);
+        } while (ve && ve != _validate_profile_list);
+    }
+    retval = 0;
+ done:
+    if (encstr)
+        free(encstr);
+    return retval;
+}
+
+/*! Clear validation profile and free all entries
+ *
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+validate_profile_exit(void)
+{
+    struct validate_profile_entry *ve;
+
+    while ((ve = _validate_profile_list) != NULL){
+        DELQ(ve, _validate_profile_list, struct validate_profile_entry *);
+        free(ve->vp_node);
+        free(ve);
+    }
+    _validate_profile_nr = 0;
+    if (_validate_profile){
+        clicon_hash_free(_validate_profile);
+        _validate_profile = NULL;
+    }
+    return 0;
+}
@@ -53,6 +53,9 @@
 #include <string.h>
 #include <limits.h>
 #include <assert.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -76,6 +79,7 @@
 #include "clixon_xml_io.h"
 #include "clixon_xml_parse.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_alloc_profile.h"
 
 /*
  * Constants
@@ -89,18 +93,86 @@
 #define XML_CHILDVEC_SIZE_START_ELMNT 16
 #define XML_CHILDVEC_SIZE_THRESHOLD 65536
 
+/* Size of inline value buffer in body and attribute nodes. Longer values are malloc:ed
+ * Heurestics: most leaf values are short, such as numbers, booleans, names and addresses
+ */
+#define XML_BODY_INLINE 16
+
 /* Intention of these macros is to guard against access of type-specific fields 
  * As debug they can contain an assert.
  */
 #define is_element(x) (xml_type(x)==CX_ELMNT)
 #define is_bodyattr(x) (xml_type(x)==CX_BODY || xml_type(x)==CX_ATTR)
 
+/* Internal flags, not visible via xml_flag() */
+#define XML_IFLAG_NAME_INTERN   0x01 /* x_name is interned, do not free */
+#define XML_IFLAG_PREFIX_INTERN 0x02 /* x_prefix is interned, do not free */
+#define XML_IFLAG_ORDER         0x04 /* Order labels of children are valid, see XML_CHILD_ORDER */
+#define XML_IFLAG_SORT_PENDING  0x08 /* Children are not sorted yet, see xml_sort_lazy */
+#define XML_IFLAG_SORTED        0x10 /* Producer declares subtree is sorted, see xml_sorted_declare */
+#define XML_IFLAG_VISIT         0x20 /* Temporary mark in one traversal, see xml_visit_mark */
+
+#ifdef XML_NAME_INTERN
+/* Max number of interned strings. Beyond this names are strdup:ed as usual */
+#define XML_INTERN_MAX 65536
+/* Max length of an interned string, longer names are strdup:ed */
+#define XML_INTERN_LEN 64
+#endif
+
+#ifdef XML_CHILD_CHUNKS
+/* Number of children of a parent before its child vector is split in chunks */
+#define XML_CHUNK_THRESHOLD 4096
+/* Max number of children in one chunk */
+#define XML_CHUNK_SIZE 512
+#endif
+
+#ifdef XML_CHILD_ORDER
+/* Max distance between order labels of children, less if there are many children */
+#define XML_ORDER_GAP ((uint32_t)1 << 16)
+/* Min number of children of a parent to look up child order using labels */
+#define XML_ORDER_MIN 16
+#endif
+
+#ifdef XML_YANG_GROUPS
+/* Min number of children of a parent before ranges of yang groups are cached */
+#define XML_YANG_GROUPS_MIN 64
+#endif
+
+#ifdef XML_LIST_HASH
+/* Min number of children of a parent before a list hash index is built */
+#define XML_LIST_HASH_MIN 128
+/* Deleted slot in list hash index */
+#define XML_HASH_TOMB ((struct xml *)-1)
+#endif
+
 /*
  * Types
  */
 
+#ifdef XML_YANG_GROUPS
+/*! Range of adjacent children of a parent with the same yang spec
+ */
+struct xml_ygroup{
+    yang_stmt *yg_spec;  /* Yang spec of children */
+    int        yg_start; /* Position of first child */
+    int        yg_end;   /* Position after last child, equal to yg_start if empty */
+};
+
+/*! Cached ranges of yang groups of the children of a parent, see xml_child_group
+ *
+ * Children of a sorted parent are grouped by yang order. The ranges are built on first
+ * lookup and maintained when children are inserted and removed.
+ */
+struct xml_ygroups{
+    struct xml_ygroup *xy_vec; /* Groups in child order */
+    int                xy_len; /* Number of groups */
+    int                xy_max; /* Allocated length of xy_vec */
+};
+#endif
+
 #ifdef XML_EXPLICIT_INDEX
 static int xml_search_index_free(cxobj *x);
+static cxobj *xml_search_index_body(cxobj *x);
 
 /* A search index pair consisting of a name of an (index) variable and a vector of xml children
  * the variable should be a potential child of the XML node
@@ -128,6 +200,88 @@ struct search_index{
 };
 #endif
 
+#ifdef XML_CHILD_CHUNKS
+struct xml_chunks;
+static cxobj *xml_chunks_i(struct xml_chunks *xs, int i);
+static void   xml_chunks_i_set(struct xml_chunks *xs, int i, cxobj *xc);
+static int    xml_chunks_make(cxobj *xp);
+static int    xml_chunks_flatten(cxobj *xp);
+static int    xml_chunks_insert(cxobj *xp, cxobj *xc, int pos);
+static int    xml_chunks_rm(cxobj *xp, int i);
+static void   xml_chunks_free(struct xml_chunks *xs, int children);
+#endif
+
+#ifdef XML_YANG_GROUPS
+static void xml_ygroups_free(cxobj *xp);
+static void xml_ygroups_insert(cxobj *xp, int pos);
+static void xml_ygroups_rm(cxobj *xp, int i);
+#endif
+
+#ifdef XML_LIST_HASH
+static void xml_hash_free(cxobj *xp);
+static int  xml_hash_add(cxobj *xp, cxobj *xc);
+static int  xml_hash_rm(cxobj *xp, cxobj *xc);
+static void xml_hash_invalidate(cxobj *x);
+#endif
+
+#ifdef XML_CHILD_ORDER
+static void xml_order_relabel(cxobj *xp);
+static void xml_order_insert(cxobj *xp, int pos);
+#endif
+
+#ifdef XML_CHILD_CHUNKS
+/*! Chunked child vector of a parent element with many children
+ *
+ * Instead of one flat vector, children are stored in a vector of fixed-size chunks, so that
+ * inserting or removing a child moves at most XML_CHUNK_SIZE pointers plus one start index
+ * per chunk, instead of all children after the position.
+ * A parent is converted when a child is inserted or removed in the middle of a vector with
+ * at least XML_CHUNK_THRESHOLD children, and converted back to a flat vector if the children
+ * are accessed as a vector, see xml_childvec_get, or become few.
+ * Random access looks up the chunk with binary search on the start indexes, the last chunk
+ * accessed is cached so that sequential access (xml_child_each) is constant time.
+ */
+struct xml_chunk{
+    int         ck_len;                 /* Number of children in chunk */
+    struct xml *ck_vec[XML_CHUNK_SIZE]; /* Children */
+};
+
+struct xml_chunks{
+    struct xml_chunk **xs_chunk; /* Vector of chunks */
+    int               *xs_start; /* Index of first child in each chunk */
+    int                xs_nr;    /* Number of chunks */
+    int                xs_max;   /* Allocated length of xs_chunk and xs_start */
+};
+
+/* Last accessed chunked vector and chunk of this thread, see xml_chunks_find.
+ * Kept per thread, not in the vector, since threads may read a shared tree */
+static __thread struct xml_chunks *_chunks_last_xs = NULL;
+static __thread int                _chunks_last_k = 0;
+#endif
+
+#ifdef XML_LIST_HASH
+/*! Hash index of list entries of a parent, keyed on list key values
+ *
+ * Built on the first key lookup of a parent with at least XML_LIST_HASH_MIN children,
+ * thereafter maintained when children are added and removed.
+ * Open addressing with linear probing, deleted slots are marked with XML_HASH_TOMB.
+ * Entries with missing or unparseable keys are not indexed, they cannot be equal to a
+ * complete search key anyway.
+ * @see xml_hash_find
+ */
+struct xml_hash_slot{
+    struct xml *hs_x;    /* List entry, NULL if empty, XML_HASH_TOMB if deleted */
+    uint32_t    hs_hash; /* Hash of key values, see xml_key_hash */
+};
+
+struct xml_hash{
+    struct xml_hash_slot *xh_slots; /* Vector of slots */
+    uint32_t              xh_size;  /* Number of slots, power of 2 */
+    uint32_t              xh_used;  /* Slots not empty, including deleted */
+    uint32_t              xh_nr;    /* Number of entries */
+};
+#endif
+
 /*! xml tree node, with name, type, parent, children, etc 
  *
  * Note that this is a private type not visible from externally, use
@@ -168,6 +322,11 @@ struct xml{
     char             *x_name;       /* name of node */
     char             *x_prefix;     /* namespace localname N, called prefix */
     uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           x_iflags;     /* Internal flags according to XML_IFLAG_* */
+#ifdef XML_CHILD_ORDER
+    uint32_t         _x_ord;        /* Order label among siblings, see xml_child_order.
+                                       Fills alignment padding, does not add to size */
+#endif
     struct xml       *x_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *x_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -175,23 +334,45 @@ struct xml{
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for stable sorting:
                                        see xml_enumerate_children and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-                                       memory) cv? */
-    /*----- up to here is common to all next is element only */
+    /*----- up to here is common to all next is element only, see struct xmlbody */
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
+#ifdef XML_CHILD_CHUNKS
+    struct xml_chunks *x_chunks;    /* Chunked children if not NULL, then x_childvec is unused */
+#endif
     int               x_childvec_len;/* Number of children */
     int               x_childvec_max;/* Length of allocated vector */
 
     cvec             *x_ns_cache;   /* Cached vector of namespaces (set by bind-yang) */
+    struct xml_nsscope *x_nsscope;  /* Shared namespace context of scope, see xml_nsscope_node */
+#ifdef XML_FLAG_EPOCH
+    uint32_t          x_epoch;      /* Epoch of XML_FLAG_EPOCH_MASK flags, see xml_flag_epoch_next */
+#endif
     yang_stmt        *x_spec;       /* Pointer to specification, eg yang, 
                                        by reference, dont free */
     cg_var           *x_cv;         /* Cached value as cligen variable (set by xml_cmp) */
 #ifdef XML_EXPLICIT_INDEX
     struct search_index *x_search_index; /* explicit search index vectors */
 #endif
+#ifdef XML_LIST_HASH
+    struct xml_hash  *x_hash;       /* Hash index of list children, or NULL */
+#endif
+#ifdef XML_YANG_GROUPS
+    struct xml_ygroups *x_ygroups;  /* Ranges of yang groups of children, or NULL */
+#endif
 };
 
+/* Generation of namespace scopes, incremented when a tree or attribute changes
+ * @see nsscope_gen
+ */
+static uint64_t _nsscope_gen = 1;
+
+#ifdef XML_FLAG_EPOCH
+/* Current flag epoch, epoch flags of element nodes stamped with another epoch are reset
+ * @see xml_flag_epoch_next
+ */
+static uint32_t _xml_flag_epoch = 0;
+#endif
+
 /* Variant of struct xml for use by non-elements to save space
  * @see struct xml  For XML elements
  */
@@ -200,6 +381,10 @@ struct xmlbody{
     char             *xb_name;       /* name of node */
     char             *xb_prefix;     /* namespace localname N, called prefix */
     uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           xb_iflags;     /* Internal flags according to XML_IFLAG_* */
+#ifdef XML_CHILD_ORDER
+    uint32_t         _xb_ord;        /* Order label among siblings, see xml_child_order */
+#endif
     struct xml       *xb_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *xb_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -207,9 +392,52 @@ struct xmlbody{
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
                                        see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    /*----- up to here is common to all next is body/attribute only */
+    char             *xb_value;      /* Value: points to xb_inline or malloc:ed, or NULL */
+    uint32_t          xb_len;        /* Length of value (excluding NULL) */
+    uint32_t          xb_max;        /* Size of malloc:ed value, 0 if inline */
+    char              xb_inline[XML_BODY_INLINE]; /* Inline buffer for short values */
 };
 
+/* Access body/attribute-only fields, guard with is_bodyattr() */
+#define xml_body_node(x) ((struct xmlbody*)(x))
+
+/*! Get child i of element in flat or chunked child vector, no checks
+ */
+static inline struct xml *
+xml_childvec_i(struct xml *x,
+               int         i)
+{
+#ifdef XML_CHILD_CHUNKS
+    if (x->x_chunks)
+        return xml_chunks_i(x->x_chunks, i);
+#endif
+    return x->x_childvec[i];
+}
+
+/*! Invalidate cached cligen value of parent element if its body changes
+ *
+ * Keeps x_cv coherent with the body so that it may be kept across sorts, see xml_cv_cache
+ * Also drops a list hash index that may depend on the body, see xml_hash_invalidate
+ * @param[in]  x   Body or attribute node. If body, the cache of its parent element is cleared
+ */
+static inline void
+xml_cv_invalidate(cxobj *x)
+{
+    struct xml *xp;
+
+    if (x->x_type == CX_BODY &&
+        (xp = x->x_up) != NULL){
+        if (xp->x_cv != NULL){
+            cv_free(xp->x_cv);
+            xp->x_cv = NULL;
+        }
+    }
+#ifdef XML_LIST_HASH
+    xml_hash_invalidate(x);
+#endif
+}
+
 /*
  * Variables
  */
@@ -237,6 +465,192 @@ xml_type2str(enum cxobj_type type)
 /* Stats (too low-level to hang it on handle) */
 static uint64_t _stats_xml_nr = 0;
 
+#ifdef HAVE_LIBPTHREAD
+/* Set while XML nodes may be created and freed in several threads, see xml_threads_set */
+static int             _xml_threads = 0;
+static pthread_mutex_t _xml_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define XML_LOCK()   do {if (_xml_threads) pthread_mutex_lock(&_xml_mutex);} while (0)
+#define XML_UNLOCK() do {if (_xml_threads) pthread_mutex_unlock(&_xml_mutex);} while (0)
+#else
+#define XML_LOCK()
+#define XML_UNLOCK()
+#endif
+
+/*! Allow XML nodes to be created and freed in several threads
+ *
+ * While set, the intern table, slab pools and node statistics are protected by a mutex, and
+ * the flex/bison XML parser is called by one thread at a time.
+ * Set by the calling thread before starting threads that build XML trees, such as thread-safe
+ * plugin callbacks, and reset after they are joined.
+ * A tree is changed by one thread at a time, but may be read by several threads. Therefore lazy
+ * indexes are not built while set, see xml_hash_find, and the cursor of chunked children is
+ * per thread.
+ * @param[in]  threads  1: several threads, 0: one thread
+ * @retval     old      Previous setting
+ */
+int
+xml_threads_set(int threads)
+{
+#ifdef HAVE_LIBPTHREAD
+    int old = _xml_threads;
+
+    _xml_threads = threads;
+    return old;
+#else
+    return 0;
+#endif
+}
+
+/*! Get if XML nodes may be created and freed in several threads
+ *
+ * @retval     1     Several threads, see xml_threads_set
+ * @retval     0     One thread
+ */
+int
+xml_threads_get(void)
+{
+#ifdef HAVE_LIBPTHREAD
+    return _xml_threads;
+#else
+    return 0;
+#endif
+}
+
+#ifdef XML_SLAB_ALLOC
+/*! Number of XML nodes allocated in each slab */
+#define XML_SLAB_NODES 1024
+
+/*! A slab is a header followed by XML_SLAB_NODES nodes of a fixed size
+ */
+struct xml_slab{
+    struct xml_slab *sl_next;    /* Next slab in pool */
+    void            *sl_pad;     /* Keep nodes 16-byte aligned */
+};
+
+/*! Pool of slabs of a single node size, with a free-list of released nodes
+ *
+ * A released node stores the free-list next pointer in its first word
+ */
+struct xml_slab_pool{
+    size_t           sp_size;    /* Size of each node */
+    void            *sp_free;    /* Free-list of released nodes */
+    struct xml_slab *sp_slabs;   /* List of allocated slabs */
+    uint64_t         sp_nslabs;  /* Number of slabs */
+    uint64_t         sp_inuse;   /* Number of nodes in use */
+};
+
+static struct xml_slab_pool _slab_elmnt = {sizeof(struct xml), NULL, NULL, 0, 0};
+static struct xml_slab_pool _slab_body = {sizeof(struct xmlbody), NULL, NULL, 0, 0};
+
+/*! Allocate one node from a slab pool, allocate a new slab if free-list is empty
+ *
+ * @param[in]  sp   Slab pool
+ * @retval     x    Uninitialized node of size sp_size
+ * @retval     NULL Error
+ */
+static void *
+xml_slab_alloc(struct xml_slab_pool *sp)
+{
+    struct xml_slab *sl;
+    char            *p;
+    void            *x;
+    int              i;
+
+    if (sp->sp_free == NULL){
+        if ((sl = malloc(sizeof(struct xml_slab) + XML_SLAB_NODES*sp->sp_size)) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
+            return NULL;
+        }
+        sl->sl_next = sp->sp_slabs;
+        sp->sp_slabs = sl;
+        sp->sp_nslabs++;
+        /* Thread nodes onto free-list in reverse order so they are handed out in memory order */
+        p = (char*)(sl + 1);
+        for (i=XML_SLAB_NODES-1; i>=0; i--){
+            *(void**)(p + i*sp->sp_size) = sp->sp_free;
+            sp->sp_free = p + i*sp->sp_size;
+        }
+    }
+    x = sp->sp_free;
+    sp->sp_free = *(void**)x;
+    sp->sp_inuse++;
+    return x;
+}
+
+/*! Release one node back to its slab pool free-list
+ *
+ * @param[in]  sp   Slab pool
+ * @param[in]  x    Node allocated by xml_slab_alloc from the same pool
+ */
+static void
+xml_slab_free(struct xml_slab_pool *sp,
+              void                 *x)
+{
+    *(void**)x = sp->sp_free;
+    sp->sp_free = x;
+    sp->sp_inuse--;
+}
+
+/*! Free all slabs of a pool, only possible if no nodes of the pool are in use
+ *
+ * @param[in]  sp   Slab pool
+ * @retval     1    Slabs freed
+ * @retval     0    Nodes still in use, nothing freed
+ */
+static int
+xml_slab_pool_release(struct xml_slab_pool *sp)
+{
+    struct xml_slab *sl;
+
+    if (sp->sp_inuse != 0)
+        return 0;
+    while ((sl = sp->sp_slabs) != NULL){
+        sp->sp_slabs = sl->sl_next;
+        free(sl);
+    }
+    sp->sp_free = NULL;
+    sp->sp_nslabs = 0;
+    return 1;
+}
+
+/*! Get statistics of XML node slabs
+ *
+ * @param[out]  nslabs  Number of allocated slabs (element and body)
+ * @param[out]  inuse   Number of nodes in use
+ * @param[out]  sz      Total size of slabs in bytes
+ * @retval      0       OK
+ */
+int
+xml_slab_stats(uint64_t *nslabs,
+               uint64_t *inuse,
+               size_t   *sz)
+{
+    if (nslabs)
+        *nslabs = _slab_elmnt.sp_nslabs + _slab_body.sp_nslabs;
+    if (inuse)
+        *inuse = _slab_elmnt.sp_inuse + _slab_body.sp_inuse;
+    if (sz)
+        *sz = _slab_elmnt.sp_nslabs*(sizeof(struct xml_slab) + XML_SLAB_NODES*_slab_elmnt.sp_size) +
+            _slab_body.sp_nslabs*(sizeof(struct xml_slab) + XML_SLAB_NODES*_slab_body.sp_size);
+    return 0;
+}
+
+/*! Return slab memory to the OS if no XML nodes are in use
+ *
+ * Typically called on exit, or after a large tree has been freed, eg after startup
+ * @retval      1       All slabs freed
+ * @retval      0       Nodes still in use in at least one pool
+ */
+int
+xml_slab_release(void)
+{
+    int ret;
+
+    ret = xml_slab_pool_release(&_slab_elmnt);
+    return xml_slab_pool_release(&_slab_body) && ret;
+}
+#endif /* XML_SLAB_ALLOC */
+
 /*! Get global statistics about XML objects
  *
  * @param[out]  nr  Number of existing XML objects (created - freed)
@@ -262,14 +676,20 @@ xml_stats_one(cxobj    *x,
 {
     size_t sz = 0;
 
-    if (x->x_name)
+    if (x->x_name && (x->x_iflags & XML_IFLAG_NAME_INTERN) == 0)
         sz += strlen(x->x_name) + 1;
-    if (x->x_prefix)
+    if (x->x_prefix && (x->x_iflags & XML_IFLAG_PREFIX_INTERN) == 0)
         sz += strlen(x->x_prefix) + 1;
     switch (xml_type(x)){
     case CX_ELMNT:
         sz += sizeof(struct xml);
         sz += x->x_childvec_max*sizeof(struct xml*);
+#ifdef XML_CHILD_CHUNKS
+        if (x->x_chunks)
+            sz += sizeof(struct xml_chunks) +
+                x->x_chunks->xs_max*(sizeof(struct xml_chunk*) + sizeof(int)) +
+                x->x_chunks->xs_nr*sizeof(struct xml_chunk);
+#endif
         if (x->x_ns_cache)
             sz += cvec_size(x->x_ns_cache);
         if (x->x_cv)
@@ -283,13 +703,16 @@ xml_stats_one(cxobj    *x,
             if (x->x_search_index->si_xvec)
                 sz += clixon_xvec_len(x->x_search_index->si_xvec)*sizeof(struct cxobj*);
         }
+#endif
+#ifdef XML_LIST_HASH
+        if (x->x_hash)
+            sz += sizeof(struct xml_hash) + x->x_hash->xh_size*sizeof(struct xml_hash_slot);
 #endif
         break;
     case CX_BODY:
     case CX_ATTR:
         sz += sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            sz += cbuf_buflen(x->x_value_cb);
+        sz += xml_body_node(x)->xb_max;
         break;
     default:
         break;
@@ -336,6 +759,174 @@ xml_stats(cxobj    *xt,
     return retval;
 }
 
+/*! Return size of search indexes of an XML tree recursively
+ *
+ * Explicit search indexes and hash indexes of list children. This size is included in
+ * the size of xml_stats
+ * @param[in]   xt   XML object
+ * @param[out]  szp  Size of indexes, added to
+ * @retval      0    OK
+ * @see xml_stats
+ */
+int
+xml_stats_index(cxobj  *xt,
+                size_t *szp)
+{
+    cxobj *xc;
+
+    if (xml_type(xt) != CX_ELMNT)
+        return 0;
+#ifdef XML_EXPLICIT_INDEX
+    if (xt->x_search_index){
+        *szp += sizeof(struct search_index);
+        if (xt->x_search_index->si_name)
+            *szp += strlen(xt->x_search_index->si_name)+1;
+        if (xt->x_search_index->si_xvec)
+            *szp += clixon_xvec_len(xt->x_search_index->si_xvec)*sizeof(struct cxobj*);
+    }
+#endif
+#ifdef XML_LIST_HASH
+    if (xt->x_hash)
+        *szp += sizeof(struct xml_hash) + xt->x_hash->xh_size*sizeof(struct xml_hash_slot);
+#endif
+    xc = NULL;
+    while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL)
+        xml_stats_index(xc, szp);
+    return 0;
+}
+
+#ifdef XML_NAME_INTERN
+/* Global intern table of element/attribute names and prefixes */
+static clicon_hash_t *_xml_intern = NULL;
+static uint32_t       _xml_intern_nr = 0;
+/* Number of interned strings held outside XML objects, eg by XPath parse trees */
+static uint64_t       _xml_intern_refs = 0;
+#endif
+
+/*! Intern a string, ie return a shared copy that is unique for each string value
+ *
+ * Two interned strings are equal if and only if their pointers are equal.
+ * Interned strings are never freed until xml_intern_exit(), and should not be modified.
+ * Holders of interned strings other than XML objects must count them with xml_intern_ref()
+ * Only names up to XML_INTERN_LEN are interned, and at most XML_INTERN_MAX strings.
+ * @param[in]  str   String to intern
+ * @param[out] istr  Interned string (if retval is 1)
+ * @retval     1     OK, string interned
+ * @retval     0     OK, string not interned (too long, table full or interning disabled)
+ * @retval    -1     Error
+ */
+int
+xml_intern(const char *str,
+           char      **istr)
+{
+#ifdef XML_NAME_INTERN
+    int           retval = -1;
+    clicon_hash_t h;
+
+    if (str == NULL)
+        return 0;
+    XML_LOCK();
+    if (_xml_intern == NULL){
+        if ((_xml_intern = clicon_hash_init()) == NULL)
+            goto done;
+    }
+    if ((h = clicon_hash_lookup(_xml_intern, str)) == NULL){
+        if (_xml_intern_nr >= XML_INTERN_MAX ||
+            strnlen(str, XML_INTERN_LEN+1) > XML_INTERN_LEN){
+            retval = 0;
+            goto done;
+        }
+        if ((h = clicon_hash_add(_xml_intern, str, NULL, 0)) == NULL)
+            goto done;
+        _xml_intern_nr++;
+    }
+    *istr = h->h_key;
+    retval = 1;
+ done:
+    XML_UNLOCK();
+    return retval;
+#else
+    return 0;
+#endif
+}
+
+/*! Count an interned string held outside XML objects
+ *
+ * The intern table is not freed as long as such strings are held, see xml_intern_exit
+ * @param[in]  inc   1 when an interned string is taken, -1 when it is released
+ * @code
+ *   if ((ret = xml_intern(str, &istr)) == 1)
+ *      xml_intern_ref(1);
+ *   ...
+ *   if (istr)
+ *      xml_intern_ref(-1);
+ * @endcode
+ */
+void
+xml_intern_ref(int inc)
+{
+#ifdef XML_NAME_INTERN
+    XML_LOCK();
+    if (inc > 0)
+        _xml_intern_refs++;
+    else if (_xml_intern_refs > 0)
+        _xml_intern_refs--;
+    XML_UNLOCK();
+#endif
+}
+
+/*! Free the intern table, but only if no interned strings are held
+ *
+ * That is, no XML objects exist and no other holders, such as XPath parse trees, remain.
+ * @retval     0     OK
+ * @see xml_intern_ref
+ */
+int
+xml_intern_exit(void)
+{
+#ifdef XML_NAME_INTERN
+    if (_xml_intern != NULL && _stats_xml_nr == 0 && _xml_intern_refs == 0){
+        clicon_hash_free(_xml_intern);
+        _xml_intern = NULL;
+        _xml_intern_nr = 0;
+    }
+#endif
+    return 0;
+}
+
+/*! Compare name of XML node with a name, using interned pointer comparison if possible
+ *
+ * @param[in]  x      XML node
+ * @param[in]  name   Name to compare with
+ * @param[in]  iname  Interned name as given by xml_intern(name), or NULL if not interned
+ * @retval     1      Equal
+ * @retval     0      Not equal
+ * @see xml_intern
+ */
+int
+xml_name_eq(cxobj      *x,
+            const char *name,
+            const char *iname)
+{
+    if (iname && (x->x_iflags & XML_IFLAG_NAME_INTERN))
+        return x->x_name == iname;
+    return x->x_name == name || strcmp(x->x_name, name) == 0;
+}
+
+/*! Get name of XML node if it is interned
+ *
+ * @param[in]  x      XML node
+ * @retval     iname  Interned name, can be given to xml_name_eq
+ * @retval     NULL   Name is not interned
+ */
+char *
+xml_name_interned(cxobj *x)
+{
+    if (x == NULL || (x->x_iflags & XML_IFLAG_NAME_INTERN) == 0)
+        return NULL;
+    return x->x_name;
+}
+
 /*
  * Access functions
  */
@@ -364,11 +955,23 @@ int
 xml_name_set(cxobj      *xn,
              const char *name)
 {
+    int ret;
+
+    if (xml_type(xn) == CX_ATTR)
+        _nsscope_gen++;
     if (xn->x_name){
-        free(xn->x_name);
+        if ((xn->x_iflags & XML_IFLAG_NAME_INTERN) == 0)
+            free(xn->x_name);
+        xn->x_iflags &= ~XML_IFLAG_NAME_INTERN;
         xn->x_name = NULL;
     }
     if (name){
+        if ((ret = xml_intern(name, &xn->x_name)) < 0)
+            return -1;
+        if (ret == 1){
+            xn->x_iflags |= XML_IFLAG_NAME_INTERN;
+            return 0;
+        }
         if ((xn->x_name = strdup(name)) == NULL){
             clixon_err(OE_XML, errno, "strdup");
             return -1;
@@ -399,11 +1002,23 @@ int
 xml_prefix_set(cxobj      *xn,
                const char *prefix)
 {
+    int ret;
+
+    if (xml_type(xn) == CX_ATTR)
+        _nsscope_gen++;
     if (xn->x_prefix){
-        free(xn->x_prefix);
+        if ((xn->x_iflags & XML_IFLAG_PREFIX_INTERN) == 0)
+            free(xn->x_prefix);
+        xn->x_iflags &= ~XML_IFLAG_PREFIX_INTERN;
         xn->x_prefix = NULL;
     }
     if (prefix){
+        if ((ret = xml_intern(prefix, &xn->x_prefix)) < 0)
+            return -1;
+        if (ret == 1){
+            xn->x_iflags |= XML_IFLAG_PREFIX_INTERN;
+            return 0;
+        }
         if ((xn->x_prefix = strdup(prefix)) == NULL){
             clixon_err(OE_XML, errno, "strdup");
             return -1;
@@ -466,6 +1081,46 @@ nscache_get_all(cxobj *x)
     return x->x_ns_cache;
 }
 
+/*! Get shared namespace scope of xml node, may be stale
+ *
+ * @param[in]  x    XML node
+ * @retval     sc   Namespace scope, valid if built in current generation
+ * @retval     NULL No scope
+ * @see xml_nsscope_node
+ */
+xml_nsscope *
+nsscope_get(cxobj *x)
+{
+    if (!is_element(x))
+        return NULL;
+    return x->x_nsscope;
+}
+
+/*! Set shared namespace scope of xml node, previous scope is not released
+ *
+ * @param[in]  x    XML node
+ * @param[in]  sc   Namespace scope, reference is consumed
+ */
+int
+nsscope_set(cxobj       *x,
+            xml_nsscope *sc)
+{
+    if (is_element(x))
+        x->x_nsscope = sc;
+    return 0;
+}
+
+/*! Current generation of namespace scopes
+ *
+ * Incremented when a node changes parent, or an attribute is changed, since that may
+ * change the namespace context of nodes. Scopes built in an earlier generation are stale.
+ */
+uint64_t
+nsscope_gen(void)
+{
+    return _nsscope_gen;
+}
+
 /*! Set cached namespace for specific namespace. Replace if necessary
  *
  * @param[in] x         XML node
@@ -568,6 +1223,7 @@ xml_parent_set(cxobj *xn,
                cxobj *parent)
 {
     xn->x_up = parent;
+    _nsscope_gen++;
     return 0;
 }
 
@@ -610,9 +1266,31 @@ uint16_t
 xml_flag(cxobj   *xn,
          uint16_t flag)
 {
+#ifdef XML_FLAG_EPOCH
+    if ((flag & XML_FLAG_EPOCH_MASK) &&
+        is_element(xn) &&
+        xn->x_epoch != _xml_flag_epoch)
+        return xn->x_flags & flag & ~XML_FLAG_EPOCH_MASK;
+#endif
     return xn->x_flags&flag;
 }
 
+#ifdef XML_FLAG_EPOCH
+/*! Reset epoch flags of a node stamped in an earlier epoch and stamp it with current
+ *
+ * @param[in]  xn      xml node
+ */
+static inline void
+xml_flag_epoch_sync(cxobj *xn)
+{
+    if (is_element(xn) &&
+        xn->x_epoch != _xml_flag_epoch){
+        xn->x_flags &= ~XML_FLAG_EPOCH_MASK;
+        xn->x_epoch = _xml_flag_epoch;
+    }
+}
+#endif
+
 /*! Set xml node flags, used for internal algorithms
  *
  * @param[in]  xn      xml node
@@ -622,6 +1300,10 @@ int
 xml_flag_set(cxobj   *xn,
              uint16_t flag)
 {
+#ifdef XML_FLAG_EPOCH
+    if (flag & XML_FLAG_EPOCH_MASK)
+        xml_flag_epoch_sync(xn);
+#endif
     xn->x_flags |= flag;
     return 0;
 }
@@ -635,21 +1317,94 @@ int
 xml_flag_reset(cxobj   *xn,
                uint16_t flag)
 {
+#ifdef XML_FLAG_EPOCH
+    if (flag & XML_FLAG_EPOCH_MASK)
+        xml_flag_epoch_sync(xn);
+#endif
     xn->x_flags &= ~flag;
     return 0;
 }
 
-/*! Get value of xnode
+/*! Reset transient flags of all element nodes in all trees
  *
- * @param[in]  xn    xml node
- * @retval     value of xml node
+ * Resets the XML_FLAG_EPOCH_MASK flags in O(1) by advancing the flag epoch. Call only when
+ * no algorithm has such flags pending in any tree, eg after a transaction is done.
+ * Without XML_FLAG_EPOCH this does nothing, and flags must be reset by traversal
+ * @retval  1   Flags are reset
+ * @retval  0   XML_FLAG_EPOCH not enabled, reset flags by traversal
  */
-char*
-xml_value(cxobj *xn)
+int
+xml_flag_epoch_next(void)
+{
+#ifdef XML_FLAG_EPOCH
+    _xml_flag_epoch++;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/*! Get value of xnode
+ *
+ * @param[in]  xn    xml node
+ * @retval     value of xml node
+ */
+char*
+xml_value(cxobj *xn)
 {
     if (!is_bodyattr(xn))
         return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    return xml_body_node(xn)->xb_value;
+}
+
+/*! Ensure value buffer of body or attribute node can hold a string of a given length
+ *
+ * Values that fit use the inline buffer, otherwise a buffer is malloc:ed
+ * @param[in]  xb    XML body or attribute node
+ * @param[in]  len   Length of string (excluding NULL)
+ * @param[in]  grow  If set, grow exponentially (append), otherwise allocate exact size
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_value_alloc(struct xmlbody *xb,
+                size_t          len,
+                int             grow)
+{
+    size_t max;
+    char  *p;
+
+    if (len >= UINT32_MAX){
+        clixon_err(OE_XML, EINVAL, "value too large");
+        return -1;
+    }
+    max = xb->xb_max ? xb->xb_max : XML_BODY_INLINE;
+    if (len + 1 <= max){
+        if (xb->xb_value == NULL)
+            xb->xb_value = xb->xb_inline;
+        return 0;
+    }
+    if (grow){
+        while (max < len + 1)
+            max *= 2;
+    }
+    else
+        max = len + 1;
+    if (xb->xb_max == 0){ /* From inline to malloc */
+        if ((p = malloc(max)) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
+            return -1;
+        }
+        if (xb->xb_value)
+            memcpy(p, xb->xb_inline, xb->xb_len + 1);
+    }
+    else if ((p = realloc(xb->xb_value, max)) == NULL){
+        clixon_err(OE_XML, errno, "realloc");
+        return -1;
+    }
+    xb->xb_value = p;
+    xb->xb_max = max;
+    return 0;
 }
 
 /*! Set value of xml node, value is copied
@@ -663,8 +1418,12 @@ int
 xml_value_set(cxobj      *xn,
               const char *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          len;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj          *xi = NULL;
+#endif
 
     if (!is_bodyattr(xn))
         return 0;
@@ -672,16 +1431,25 @@ xml_value_set(cxobj      *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-    }
-    else
-        cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+    if (xml_type(xn) == CX_ATTR)
+        _nsscope_gen++;
+    xml_cv_invalidate(xn);
+#ifdef XML_EXPLICIT_INDEX
+    /* Index variable changes: reinsert its list element in search vector */
+    if ((xi = xml_search_index_body(xn)) != NULL &&
+        xml_search_child_rm(xml_parent(xi), xi) < 0)
+        goto done;
+#endif
+    xb = xml_body_node(xn);
+    len = strlen(val);
+    if (xml_value_alloc(xb, len, 0) < 0)
+        goto done;
+    memmove(xb->xb_value, val, len + 1);
+    xb->xb_len = len;
+#ifdef XML_EXPLICIT_INDEX
+    if (xi && xml_search_child_insert(xml_parent(xi), xi) < 0)
+        goto done;
+#endif
     retval = 0;
  done:
     return retval;
@@ -698,8 +1466,12 @@ int
 xml_value_append(cxobj      *xn,
                  const char *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          len;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj          *xi = NULL;
+#endif
 
     if (!is_bodyattr(xn))
         return 0;
@@ -707,17 +1479,24 @@ xml_value_append(cxobj      *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-    }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-        clixon_err(OE_XML, errno, "cprintf");
+    if (xml_type(xn) == CX_ATTR)
+        _nsscope_gen++;
+    xml_cv_invalidate(xn);
+#ifdef XML_EXPLICIT_INDEX
+    if ((xi = xml_search_index_body(xn)) != NULL &&
+        xml_search_child_rm(xml_parent(xi), xi) < 0)
         goto done;
-    }
+#endif
+    xb = xml_body_node(xn);
+    len = strlen(val);
+    if (xml_value_alloc(xb, xb->xb_len + len, 1) < 0)
+        goto done;
+    memcpy(xb->xb_value + xb->xb_len, val, len + 1);
+    xb->xb_len += len;
+#ifdef XML_EXPLICIT_INDEX
+    if (xi && xml_search_child_insert(xml_parent(xi), xi) < 0)
+        goto done;
+#endif
     retval = 0;
  done:
     return retval;
@@ -836,7 +1615,7 @@ xml_child_i(cxobj *xn,
     if (!is_element(xn))
         return NULL;
     if (i < xn->x_childvec_len)
-        return xn->x_childvec[i];
+        return xml_childvec_i(xn, i);
     return NULL;
 }
 
@@ -879,6 +1658,22 @@ xml_child_i_set(cxobj *xt,
 {
     if (!is_element(xt))
         return NULL;
+#ifdef XML_LIST_HASH
+    xml_hash_free(xt);
+#endif
+#ifdef XML_YANG_GROUPS
+    xml_ygroups_free(xt);
+#endif
+#ifdef XML_CHILD_ORDER
+    xt->x_iflags &= ~XML_IFLAG_ORDER;
+#endif
+#ifdef XML_CHILD_CHUNKS
+    if (xt->x_chunks){
+        if (i < xt->x_childvec_len)
+            xml_chunks_i_set(xt->x_chunks, i, xc);
+        return 0;
+    }
+#endif
     if (i < xt->x_childvec_len)
         xt->x_childvec[i] = xc;
     return 0;
@@ -898,9 +1693,37 @@ xml_child_order(cxobj *xp,
 {
     cxobj *x = NULL;
     int    i = 0;
+#ifdef XML_CHILD_ORDER
+    int    low;
+    int    high;
+    int    mid;
+#endif
 
     if (!is_element(xp))
         return -1;
+#ifdef XML_CHILD_ORDER
+    /* Binary search on order labels, children are labeled in increasing order */
+    if (xc != NULL && xml_parent(xc) == xp && xp->x_childvec_len >= XML_ORDER_MIN){
+        if ((xp->x_iflags & XML_IFLAG_ORDER) == 0)
+            xml_order_relabel(xp);
+        low = 0;
+        high = xp->x_childvec_len;
+        while (low < high){
+            mid = (low + high)/2;
+            if ((x = xml_childvec_i(xp, mid)) == NULL)
+                break;
+            if (x->_x_ord < xc->_x_ord)
+                low = mid+1;
+            else if (x->_x_ord > xc->_x_ord)
+                high = mid;
+            else if (x == xc)
+                return mid;
+            else
+                break;
+        }
+        x = NULL; /* Not found using labels, fall back to linear search */
+    }
+#endif
     while ((x = xml_child_each(xp, x, -1)) != NULL) {
         if (x == xc)
             return i;
@@ -909,6 +1732,85 @@ xml_child_order(cxobj *xp,
     return -1;
 }
 
+/*! Get the range of children of a parent with a given yang spec
+ *
+ * Children of a sorted parent are grouped by yang spec. The ranges of the groups are cached
+ * in the parent on first call if it has many children, and maintained on insert and remove.
+ * @param[in]  xp    XML parent node
+ * @param[in]  yc    Yang spec of children
+ * @param[out] start Position of first child with spec yc
+ * @param[out] end   Position after last child with spec yc, equal to start if none
+ * @retval     1     OK, range found, it may be empty
+ * @retval     0     No cached range, eg few children or children not grouped by yang
+ * @see xml_search_yang  where the range limits a binary search
+ */
+int
+xml_child_group(cxobj     *xp,
+                yang_stmt *yc,
+                int       *start,
+                int       *end)
+{
+#ifdef XML_YANG_GROUPS
+    struct xml_ygroups *xy;
+    struct xml_ygroup  *yg;
+    cxobj              *xc;
+    yang_stmt          *y;
+    int                 i;
+    int                 k;
+
+    if (!is_element(xp) || yc == NULL || xp->x_childvec_len < XML_YANG_GROUPS_MIN)
+        return 0;
+    if ((xy = xp->x_ygroups) == NULL){ /* Build */
+        if ((xy = calloc(1, sizeof(*xy))) == NULL)
+            return 0;
+        yg = NULL;
+        for (i=0; i<xp->x_childvec_len; i++){
+            if ((xc = xml_childvec_i(xp, i)) == NULL ||
+                xml_type(xc) != CX_ELMNT ||
+                (y = xc->x_spec) == NULL){
+                yg = NULL; /* Ends current group */
+                continue;
+            }
+            if (yg != NULL && yg->yg_spec == y){
+                yg->yg_end = i+1;
+                continue;
+            }
+            for (k=0; k<xy->xy_len; k++)
+                if (xy->xy_vec[k].yg_spec == y)
+                    break;
+            if (k < xy->xy_len) /* Not grouped, eg not sorted */
+                goto fail;
+            if (xy->xy_len == xy->xy_max){
+                xy->xy_max = xy->xy_max?2*xy->xy_max:8;
+                if ((yg = realloc(xy->xy_vec, xy->xy_max*sizeof(*yg))) == NULL)
+                    goto fail;
+                xy->xy_vec = yg;
+            }
+            yg = &xy->xy_vec[xy->xy_len++];
+            yg->yg_spec = y;
+            yg->yg_start = i;
+            yg->yg_end = i+1;
+        }
+        xp->x_ygroups = xy;
+    }
+    *start = *end = 0;
+    for (k=0; k<xy->xy_len; k++){
+        yg = &xy->xy_vec[k];
+        if (yg->yg_spec == yc){
+            *start = yg->yg_start;
+            *end = yg->yg_end;
+            break;
+        }
+    }
+    return 1;
+ fail:
+    if (xy->xy_vec)
+        free(xy->xy_vec);
+    free(xy);
+#endif /* XML_YANG_GROUPS */
+    return 0;
+}
+
 /*! Advanced function to decrement _x_vector_i if objects have been removed
  */
 int
@@ -966,7 +1868,7 @@ xml_child_each(cxobj           *xparent,
     if (!is_element(xparent))
         return NULL;
     for (i=xprev?xprev->_x_vector_i+1:0; i<xparent->x_childvec_len; i++){
-        xn = xparent->x_childvec[i];
+        xn = xml_childvec_i(xparent, i);
         if (xn == NULL)
             continue;
         if (type != CX_ERROR && xml_type(xn) != type)
@@ -1003,7 +1905,7 @@ xml_child_each_attr(cxobj  *xparent,
     if (!is_element(xparent))
         return NULL;
     for (i=xprev?xprev->_x_vector_i+1:0; i<xparent->x_childvec_len; i++){
-        xn = xparent->x_childvec[i];
+        xn = xml_childvec_i(xparent, i);
         if (xn == NULL)
             continue;
         if (xml_type(xn) != CX_ATTR){
@@ -1032,6 +1934,13 @@ xml_child_append(cxobj *xp,
 
     if (!is_element(xp))
         return 0;
+#ifdef XML_CHILD_CHUNKS
+    if (xp->x_chunks){
+        if (xml_chunks_insert(xp, xc, xp->x_childvec_len) < 0)
+            return -1;
+        goto added;
+    }
+#endif
     start = XML_CHILDVEC_SIZE_START;
     /* Heurestics: if child is body only single child is expected, but element children may
      * have siblings
@@ -1051,6 +1960,19 @@ xml_child_append(cxobj *xp,
         }
     }
     xp->x_childvec[xp->x_childvec_len-1] = xc;
+#ifdef XML_CHILD_CHUNKS
+ added:
+#endif
+#ifdef XML_CHILD_ORDER
+    xml_order_insert(xp, xp->x_childvec_len-1);
+#endif
+#ifdef XML_YANG_GROUPS
+    xml_ygroups_insert(xp, xp->x_childvec_len-1);
+#endif
+#ifdef XML_LIST_HASH
+    if (xml_hash_add(xp, xc) < 0)
+        return -1;
+#endif
     return 0;
 }
 
@@ -1073,6 +1995,18 @@ xml_child_insert_pos(cxobj *xp,
 
     if (!is_element(xp))
         return 0;
+#ifdef XML_CHILD_CHUNKS
+    if (xp->x_chunks == NULL &&
+        xp->x_childvec_len >= XML_CHUNK_THRESHOLD &&
+        pos < xp->x_childvec_len &&
+        xml_chunks_make(xp) < 0)
+        return -1;
+    if (xp->x_chunks){
+        if (xml_chunks_insert(xp, xc, pos) < 0)
+            return -1;
+        goto added;
+    }
+#endif
     xp->x_childvec_len++;
     if (xp->x_childvec_len > xp->x_childvec_max){
         if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
@@ -1088,6 +2022,19 @@ xml_child_insert_pos(cxobj *xp,
     size = (xml_child_nr(xp) - pos - 1)*sizeof(cxobj *);
     memmove(&xp->x_childvec[pos+1], &xp->x_childvec[pos], size);
     xp->x_childvec[pos] = xc;
+#ifdef XML_CHILD_CHUNKS
+ added:
+#endif
+#ifdef XML_CHILD_ORDER
+    xml_order_insert(xp, pos);
+#endif
+#ifdef XML_YANG_GROUPS
+    xml_ygroups_insert(xp, pos);
+#endif
+#ifdef XML_LIST_HASH
+    if (xml_hash_add(xp, xc) < 0)
+        return -1;
+#endif
     return 0;
 }
 
@@ -1105,6 +2052,21 @@ xml_childvec_set(cxobj *x,
 {
     if (!is_element(x))
         return 0;
+#ifdef XML_LIST_HASH
+    xml_hash_free(x);
+#endif
+#ifdef XML_CHILD_ORDER
+    x->x_iflags &= ~XML_IFLAG_ORDER;
+#endif
+#ifdef XML_YANG_GROUPS
+    xml_ygroups_free(x);
+#endif
+#ifdef XML_CHILD_CHUNKS
+    if (x->x_chunks){
+        xml_chunks_free(x->x_chunks, 0);
+        x->x_chunks = NULL;
+    }
+#endif
     x->x_childvec_len = len;
     x->x_childvec_max = len;
     if (x->x_childvec)
@@ -1117,12 +2079,27 @@ xml_childvec_set(cxobj *x,
 }
 
 /*! Get the children of an XML node as an XML vector
+ *
+ * Not a read access: the node is modified, use xml_child_i or xml_child_each to read a tree
+ * that other threads may read.
+ * @note If children are chunked, they are first converted to a flat vector
+ * @note The caller may reorder the vector, therefore order labels and content hash are invalidated
  */
 cxobj **
 xml_childvec_get(cxobj *x)
 {
     if (!is_element(x))
         return NULL;
+#ifdef XML_CHILD_ORDER
+    x->x_iflags &= ~XML_IFLAG_ORDER;
+#endif
+#ifdef XML_YANG_GROUPS
+    xml_ygroups_free(x); /* Children may be reordered */
+#endif
+#ifdef XML_CHILD_CHUNKS
+    if (x->x_chunks && xml_chunks_flatten(x) < 0)
+        return NULL;
+#endif
     return x->x_childvec;
 }
 
@@ -1190,11 +2167,20 @@ xml_new(const char     *name,
         return NULL;
         break;
     }
+#ifdef XML_SLAB_ALLOC
+    XML_LOCK();
+    x = xml_slab_alloc(type==CX_ELMNT?&_slab_elmnt:&_slab_body);
+    XML_UNLOCK();
+    if (x == NULL)
+        return NULL;
+#else
     if ((x = malloc(sz)) == NULL){
         clixon_err(OE_XML, errno, "malloc");
         return NULL;
     }
+#endif
     memset(x, 0, sz);
+    ALLOC_PROFILE_COUNT(ALLOC_XML_NEW);
     xml_type_set(x, type);
     if (name && (xml_name_set(x, name)) < 0)
         return NULL;
@@ -1204,7 +2190,9 @@ xml_new(const char     *name,
             return NULL;
         x->_x_i = xml_child_nr(xp)-1;
     }
+    XML_LOCK();
     _stats_xml_nr++;
+    XML_UNLOCK();
     return x;
 }
 
@@ -1263,6 +2251,37 @@ xml_spec_set(cxobj     *x,
 {
     if (!is_element(x))
         return 0;
+#ifdef XML_EXPLICIT_INDEX
+    if (x->x_spec != spec){
+        if (xml_search_index_p(x) &&
+            xml_search_child_rm(xml_parent(x), x) < 0)
+            return -1;
+        if (xml_search_list_rm(x) < 0)
+            return -1;
+    }
+#endif
+    if (x->x_spec != spec && x->x_cv){ /* Cached value depends on yang type */
+        cv_free(x->x_cv);
+        x->x_cv = NULL;
+    }
+#ifdef XML_LIST_HASH
+    if (x->x_spec != spec && x->x_up && x->x_up->x_hash) /* Entries are indexed by yang */
+        xml_hash_free(x->x_up);
+#endif
+#ifdef XML_YANG_GROUPS
+    if (x->x_spec != spec && x->x_up && x->x_up->x_ygroups) /* Groups are by yang */
+        xml_ygroups_free(x->x_up);
+#endif
+#ifdef XML_EXPLICIT_INDEX
+    if (x->x_spec != spec){
+        x->x_spec = spec;
+        if (xml_search_index_p(x) &&
+            xml_search_child_insert(xml_parent(x), x) < 0)
+            return -1;
+        if (xml_search_list_insert(x) < 0)
+            return -1;
+    }
+#endif
     x->x_spec = spec;
     return 0;
 }
@@ -1334,7 +2353,7 @@ xml_find(cxobj      *xp,
     if (!is_element(xp))
         return NULL;
     while ((x = xml_child_each(xp, x, -1)) != NULL)
-        if (strcmp(name, xml_name(x)) == 0)
+        if (name == xml_name(x) || strcmp(name, xml_name(x)) == 0)
             break; /* x is set */
     return x;
 }
@@ -1360,6 +2379,9 @@ xml_addsub(cxobj *xp,
     char  *pns = NULL; /* parent namespace */
     char  *cns = NULL; /* child namespace */
     cxobj *xa;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *xi;
+#endif
 
     if ((oldp = xml_parent(xc)) != NULL){
         /* Find child order i in old parent*/
@@ -1376,6 +2398,7 @@ xml_addsub(cxobj *xp,
             goto done;
         /* Set new parent in child */
         xml_parent_set(xc, xp);
+        xml_cv_invalidate(xc);
         /* Ensure default namespace is not duplicated
          * here only remove duplicate default namespace, there may be more */
         /* 1. Get parent default namespace */
@@ -1393,8 +2416,17 @@ xml_addsub(cxobj *xp,
         /* clear namespace context cache of child */
         nscache_clear(xc);
 #ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xc))
-            xml_search_child_insert(xp, xc);
+        if (xml_search_index_p(xc) &&
+            xml_search_child_insert(xp, xc) < 0)
+            goto done;
+        if (xml_search_list_insert(xc) < 0)
+            goto done;
+        if ((xi = xml_search_index_body(xc)) != NULL){ /* Value of index variable changed */
+            if (xml_search_child_rm(xml_parent(xi), xi) < 0)
+                goto done;
+            if (xml_search_child_insert(xml_parent(xi), xi) < 0)
+                goto done;
+        }
 #endif
     }
     retval = 0;
@@ -1508,6 +2540,9 @@ xml_child_rm(cxobj *xp,
 {
     int    retval = -1;
     cxobj *xc = NULL;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *xi;
+#endif
 
     if (!is_element(xp))
         return 0;
@@ -1515,16 +2550,49 @@ xml_child_rm(cxobj *xp,
         clixon_err(OE_XML, 0, "Child not found");
         goto done;
     }
+#ifdef XML_LIST_HASH
+    if (xml_hash_rm(xp, xc) < 0)
+        goto done;
+#endif
+    xml_cv_invalidate(xc);
+#ifdef XML_EXPLICIT_INDEX
+    /* Remove from search vectors while parent links are intact */
+    if (xml_search_index_p(xc) &&
+        xml_search_child_rm(xp, xc) < 0)
+        goto done;
+    if (xml_search_list_rm(xc) < 0)
+        goto done;
+    xi = xml_search_index_body(xc);
+#endif
     xml_parent_set(xc, NULL);
+#ifdef XML_YANG_GROUPS
+    xml_ygroups_rm(xp, i);
+#endif
+#ifdef XML_CHILD_CHUNKS
+    if (xp->x_chunks == NULL &&
+        xp->x_childvec_len >= XML_CHUNK_THRESHOLD &&
+        i < xp->x_childvec_len - 1 &&
+        xml_chunks_make(xp) < 0)
+        goto done;
+    if (xp->x_chunks){
+        if (xml_chunks_rm(xp, i) < 0)
+            goto done;
+        goto removed;
+    }
+#endif
     xp->x_childvec[i] = NULL;
     xp->x_childvec_len--;
     if (i<xp->x_childvec_len)
         memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
+#ifdef XML_CHILD_CHUNKS
+ removed:
+#endif
 #ifdef XML_EXPLICIT_INDEX
-    if (xml_type(xc) == CX_ELMNT){
-        if (xml_search_index_p(xc))
-            xml_search_child_rm(xp, xc);
-
+    if (xi){ /* Value of index variable changed */
+        if (xml_search_child_rm(xml_parent(xi), xi) < 0)
+            goto done;
+        if (xml_search_child_insert(xml_parent(xi), xi) < 0)
+            goto done;
     }
 #endif
     retval = 0;
@@ -1744,6 +2812,103 @@ xml_enumerate_get(cxobj *x)
     return x->_x_i;
 }
 
+/*! Get if sorting of children of an XML node is pending
+ *
+ * @param[in]  x   XML node
+ * @retval     1   Children are not sorted, sort before keyed access
+ * @retval     0   Children are sorted or not sortable
+ * @see xml_sort_lazy
+ * @see xml_sort_ensure
+ */
+int
+xml_sort_pending(cxobj *x)
+{
+    if (!is_element(x))
+        return 0;
+    return (x->x_iflags & XML_IFLAG_SORT_PENDING) != 0;
+}
+
+/*! Set or clear pending sorting of children of an XML node
+ *
+ * @param[in]  x   XML node
+ * @param[in]  val 1: sort pending, 0: sorted
+ * @retval     0   OK
+ */
+int
+xml_sort_pending_set(cxobj *x,
+                     int    val)
+{
+    if (!is_element(x))
+        return 0;
+    if (val)
+        x->x_iflags |= XML_IFLAG_SORT_PENDING;
+    else
+        x->x_iflags &= ~XML_IFLAG_SORT_PENDING;
+    return 0;
+}
+
+/*! Declare that an XML tree is already sorted, eg produced in key order by a state callback
+ *
+ * The tree is then neither sorted nor marked for sorting by xml_sort_lazy.
+ * @param[in]  x   Top of XML tree
+ * @retval     0   OK
+ * @note It is the responsibility of the producer that the tree is sorted as by xml_sort
+ */
+int
+xml_sorted_declare(cxobj *x)
+{
+    if (!is_element(x))
+        return 0;
+    x->x_iflags |= XML_IFLAG_SORTED;
+    return 0;
+}
+
+/*! Get if an XML tree is declared sorted by its producer
+ *
+ * @param[in]  x   Top of XML tree
+ * @retval     1   Declared sorted
+ * @retval     0   Not declared
+ * @see xml_sorted_declare
+ */
+int
+xml_sorted_declared(cxobj *x)
+{
+    if (!is_element(x))
+        return 0;
+    return (x->x_iflags & XML_IFLAG_SORTED) != 0;
+}
+
+/*! Mark XML node as visited and get if it was marked already
+ *
+ * A temporary mark, eg for removing duplicates when merging XPath node-sets. The marks
+ * must be cleared with xml_visit_clear() before the traversal using them is done.
+ * @param[in]  x   XML node, any type
+ * @retval     1   Marked already
+ * @retval     0   Not marked before, marked now
+ * @see xml_visit_clear
+ */
+int
+xml_visit_mark(cxobj *x)
+{
+    if (x->x_iflags & XML_IFLAG_VISIT)
+        return 1;
+    x->x_iflags |= XML_IFLAG_VISIT;
+    return 0;
+}
+
+/*! Clear visited mark of XML node
+ *
+ * @param[in]  x   XML node, any type
+ * @retval     0   OK
+ * @see xml_visit_mark
+ */
+int
+xml_visit_clear(cxobj *x)
+{
+    x->x_iflags &= ~XML_IFLAG_VISIT;
+    return 0;
+}
+
 /*! Get the first sub-node which is an XML body.
  *
  * @param[in]   xn     XML tree node
@@ -1850,7 +3015,7 @@ xml_find_type(cxobj          *xt,
         }
         else
             pmatch = 1;
-        if (pmatch && (name==NULL || strcmp(name, xml_name(x)) == 0))
+        if (pmatch && (name==NULL || name == xml_name(x) || strcmp(name, xml_name(x)) == 0))
             return x;
     }
     return NULL;
@@ -1961,13 +3126,20 @@ xml_free0(cxobj *x)
 
     if (x == NULL)
         return 0;
-    if (x->x_name)
+    if (x->x_name && (x->x_iflags & XML_IFLAG_NAME_INTERN) == 0)
         free(x->x_name);
-    if (x->x_prefix)
+    if (x->x_prefix && (x->x_iflags & XML_IFLAG_PREFIX_INTERN) == 0)
         free(x->x_prefix);
     switch (xml_type(x)){
     case CX_ELMNT:
         sz = sizeof(struct xml);
+#ifdef XML_CHILD_CHUNKS
+        if (x->x_chunks){
+            xml_chunks_free(x->x_chunks, 1);
+            x->x_chunks = NULL;
+            x->x_childvec_len = 0;
+        }
+#endif
         for (i=0; i<x->x_childvec_len; i++){
             if ((xc = x->x_childvec[i]) != NULL){
                 xml_free(xc);
@@ -1980,15 +3152,23 @@ xml_free0(cxobj *x)
             cv_free(x->x_cv);
         if (x->x_ns_cache)
             xml_nsctx_free(x->x_ns_cache);
+        if (x->x_nsscope)
+            xml_nsscope_unref(x->x_nsscope);
 #ifdef XML_EXPLICIT_INDEX
         xml_search_index_free(x);
+#endif
+#ifdef XML_LIST_HASH
+        xml_hash_free(x);
+#endif
+#ifdef XML_YANG_GROUPS
+        xml_ygroups_free(x);
 #endif
         break;
     case CX_BODY:
     case CX_ATTR:
         sz = sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            cbuf_free(x->x_value_cb);
+        if (xml_body_node(x)->xb_max)
+            free(xml_body_node(x)->xb_value);
         break;
     default:
         break;
@@ -2006,11 +3186,26 @@ xml_free0(cxobj *x)
 int
 xml_free(cxobj *x)
 {
+#ifdef XML_SLAB_ALLOC
+    struct xml_slab_pool *sp;
+#endif
+
     if (x == NULL)
         return 0;
+#ifdef XML_SLAB_ALLOC
+    /* Get pool before xml_free0 resets the type */
+    sp = is_element(x)?&_slab_elmnt:&_slab_body;
+    xml_free0(x);
+    XML_LOCK();
+    xml_slab_free(sp, x);
+    XML_UNLOCK();
+#else
     xml_free0(x);
     free(x);
+#endif
+    XML_LOCK();
     _stats_xml_nr--;
+    XML_UNLOCK();
     return 0;
 }
 
@@ -2032,13 +3227,24 @@ xml_copy_one(cxobj *x0,
         clixon_err(OE_XML, EINVAL, "x0 or x1 is NULL");
         goto done;
     }
+    ALLOC_PROFILE_COUNT(ALLOC_XML_COPY);
     xml_type_set(x1, xml_type(x0));
-    if ((s = xml_name(x0))) /* malloced string */
-        if ((xml_name_set(x1, s)) < 0)
+    if ((s = xml_name(x0)) != NULL && s != xml_name(x1)){ /* malloced or interned string */
+        if ((xml_name_set(x1, (x0->x_iflags & XML_IFLAG_NAME_INTERN)?NULL:s)) < 0)
             goto done;
-    if ((s = xml_prefix(x0))) /* malloced string */
-        if ((xml_prefix_set(x1, s)) < 0)
+        if (x0->x_iflags & XML_IFLAG_NAME_INTERN){ /* Share interned string */
+            x1->x_name = s;
+            x1->x_iflags |= XML_IFLAG_NAME_INTERN;
+        }
+    }
+    if ((s = xml_prefix(x0)) != NULL && s != xml_prefix(x1)){
+        if ((xml_prefix_set(x1, (x0->x_iflags & XML_IFLAG_PREFIX_INTERN)?NULL:s)) < 0)
             goto done;
+        if (x0->x_iflags & XML_IFLAG_PREFIX_INTERN){
+            x1->x_prefix = s;
+            x1->x_iflags |= XML_IFLAG_PREFIX_INTERN;
+        }
+    }
     switch (xml_type(x0)){
     case CX_ELMNT:
         xml_spec_set(x1, xml_spec(x0));
@@ -2054,44 +3260,222 @@ xml_copy_one(cxobj *x0,
     default:
         break;
     }
-    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY)); /* Maybe more flags */
+    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY | XML_FLAG_EDIT)); /* Maybe more flags */
+    if (xml_type(x0) == CX_ELMNT) /* Children are copied in same order */
+        x1->x_iflags |= (x0->x_iflags & XML_IFLAG_SORT_PENDING);
     retval = 0;
  done:
     return retval;
 }
 
-/*! Copy xml tree x0 to other existing tree x1
+/*! Allocate child vector of an element for at least len children
  *
- * x1 should be a created placeholder. If x1 is non-empty,
- * the copied tree is appended to the existing tree.
- * @param[in]  x0  Source XML tree
- * @param[in]  x1  Destination XML tree (must exist)
- * @retval     0   OK
- * @retval    -1   Error
- * @code
- *   x1 = xml_new("new", xparent, xml_type(x0));
- *   if (xml_copy(x0, x1) < 0)
- *      err;
- * @endcode
- * @see xml_dup
+ * Avoids growing the vector child by child when the number of children is known
+ * @param[in]  x    XML element
+ * @param[in]  len  Number of children
+ * @retval     0    OK
+ * @retval    -1    Error
  */
-int
-xml_copy(cxobj *x0,
-         cxobj *x1)
+static int
+xml_childvec_reserve(cxobj *x,
+                     int    len)
 {
-    int    retval = -1;
-    cxobj *x;
-    cxobj *xcopy;
+    cxobj **vec;
 
-    if (xml_copy_one(x0, x1) <0)
-        goto done;
-    x = NULL;
-    while ((x = xml_child_each(x0, x, -1)) != NULL) {
-        if ((xcopy = xml_new(xml_name(x), x1, xml_type(x))) == NULL)
-            goto done;
+    if (!is_element(x) || len <= x->x_childvec_max)
+        return 0;
+#ifdef XML_CHILD_CHUNKS
+    if (x->x_chunks)
+        return 0;
+#endif
+    if ((vec = realloc(x->x_childvec, len*sizeof(cxobj*))) == NULL){
+        clixon_err(OE_XML, errno, "realloc");
+        return -1;
+    }
+    x->x_childvec = vec;
+    x->x_childvec_max = len;
+    return 0;
+}
+
+/*! Release slack memory of one XML node
+ *
+ * Child vectors are shrunk to their length, and malloc:ed values are moved to the inline
+ * buffer if they fit, otherwise reallocated to their length.
+ * @param[in]   x    XML node
+ * @param[out]  szp  Number of bytes released is added
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+xml_compact_one(cxobj  *x,
+                size_t *szp)
+{
+    struct xmlbody *xb;
+    cxobj         **vec;
+    char           *p;
+
+    switch (xml_type(x)){
+    case CX_ELMNT:
+#ifdef XML_CHILD_CHUNKS
+        if (x->x_chunks)
+            break;
+#endif
+        if (x->x_childvec_max <= x->x_childvec_len)
+            break;
+        *szp += (x->x_childvec_max - x->x_childvec_len)*sizeof(cxobj*);
+        if (x->x_childvec_len == 0){
+            free(x->x_childvec);
+            x->x_childvec = NULL;
+        }
+        else {
+            if ((vec = realloc(x->x_childvec, x->x_childvec_len*sizeof(cxobj*))) == NULL){
+                clixon_err(OE_XML, errno, "realloc");
+                return -1;
+            }
+            x->x_childvec = vec;
+        }
+        x->x_childvec_max = x->x_childvec_len;
+        break;
+    case CX_BODY:
+    case CX_ATTR:
+        xb = xml_body_node(x);
+        if (xb->xb_max == 0 || xb->xb_max <= xb->xb_len + 1)
+            break;
+        if (xb->xb_len + 1 <= XML_BODY_INLINE){
+            memcpy(xb->xb_inline, xb->xb_value, xb->xb_len + 1);
+            free(xb->xb_value);
+            *szp += xb->xb_max;
+            xb->xb_value = xb->xb_inline;
+            xb->xb_max = 0;
+        }
+        else {
+            if ((p = realloc(xb->xb_value, xb->xb_len + 1)) == NULL){
+                clixon_err(OE_XML, errno, "realloc");
+                return -1;
+            }
+            *szp += xb->xb_max - (xb->xb_len + 1);
+            xb->xb_value = p;
+            xb->xb_max = xb->xb_len + 1;
+        }
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*! Release slack memory of an XML subtree
+ *
+ * @param[in]   xt   XML tree
+ * @param[out]  szp  Number of bytes released is added
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+xml_compact_tree(cxobj  *xt,
+                 size_t *szp)
+{
+    cxobj *x;
+
+    if (xml_compact_one(xt, szp) < 0)
+        return -1;
+    x = NULL;
+    while ((x = xml_child_each(xt, x, -1)) != NULL)
+        if (xml_compact_tree(x, szp) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Release slack memory of large lists in an XML tree
+ *
+ * Parents with at least min children, and the whole subtree of each of their children,
+ * are compacted: child vectors are shrunk to their length, and body and attribute values
+ * are moved to the inline buffer or reallocated to their length.
+ * Vectors and values grow geometrically when a tree is built, so that a large list that is
+ * parsed or built child by child has up to half of its vectors unused.
+ * Intended for trees that are mostly read after being built, such as a datastore cache.
+ * Subsequent changes grow vectors and values again as usual.
+ * @param[in]   xt   XML tree
+ * @param[in]   min  Min number of children of a parent to compact, 0 compacts the whole tree
+ * @param[out]  szp  Number of bytes released, or NULL
+ * @retval      0    OK
+ * @retval     -1    Error
+ * @see CLICON_XMLDB_COMPACT_LISTS
+ */
+int
+xml_compact(cxobj  *xt,
+            int     min,
+            size_t *szp)
+{
+    int    retval = -1;
+    size_t sz = 0;
+    cxobj *x;
+
+    if (xt == NULL || !is_element(xt))
+        return 0;
+    if (xml_child_nr(xt) >= min){
+        if (xml_compact_tree(xt, &sz) < 0)
+            goto done;
+    }
+    else {
+        x = NULL;
+        while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+            if (xml_compact(x, min, &sz) < 0)
+                goto done;
+    }
+    if (szp)
+        *szp += sz;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Copy xml tree x0 to other existing tree x1
+ *
+ * x1 should be a created placeholder. If x1 is non-empty,
+ * the copied tree is appended to the existing tree.
+ * The child vector of each copy is allocated once, children are copied in order and keep
+ * their sort state, and the cached value of a copied element is kept, see xml_cv_get.
+ * @param[in]  x0  Source XML tree
+ * @param[in]  x1  Destination XML tree (must exist)
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @code
+ *   x1 = xml_new("new", xparent, xml_type(x0));
+ *   if (xml_copy(x0, x1) < 0)
+ *      err;
+ * @endcode
+ * @see xml_dup
+ */
+int
+xml_copy(cxobj *x0,
+         cxobj *x1)
+{
+    int    retval = -1;
+    cxobj *x;
+    cxobj *xcopy;
+    int    len;
+
+    if (xml_copy_one(x0, x1) <0)
+        goto done;
+    if ((len = xml_child_nr(x0)) > 0 &&
+        xml_childvec_reserve(x1, xml_child_nr(x1) + len) < 0)
+        goto done;
+    x = NULL;
+    while ((x = xml_child_each(x0, x, -1)) != NULL) {
+        /* Name is set by xml_copy_one, shared if interned */
+        if ((xcopy = xml_new(NULL, x1, xml_type(x))) == NULL)
+            goto done;
         if (xml_copy(x, xcopy) < 0) /* recursion */
             goto done;
     }
+    /* After children since setting a body clears the cached value of its parent */
+    if (is_element(x0) && x0->x_cv != NULL && x1->x_cv == NULL &&
+        x0->x_spec == x1->x_spec &&
+        (x1->x_cv = cv_dup(x0->x_cv)) == NULL){
+        clixon_err(OE_UNIX, errno, "cv_dup");
+        goto done;
+    }
     retval = 0;
   done:
     return retval;
@@ -2114,7 +3498,7 @@ xml_dup(cxobj *x0)
 {
     cxobj *x1;
 
-    if ((x1 = xml_new("new", NULL, xml_type(x0))) == NULL)
+    if ((x1 = xml_new(NULL, NULL, xml_type(x0))) == NULL)
         return NULL;
     if (xml_copy(x0, x1) < 0)
         return NULL;
@@ -2660,12 +4044,45 @@ xml_search_vector_get(cxobj        *xp,
     return 0;
 }
 
+/*! Find position of list element in search vector, starting from an equal element
+ *
+ * @param[in]  xv       Search vector
+ * @param[in]  xp       XML list element
+ * @param[in]  indexvar Name of index variable
+ * @param[in]  i        Position of an element equal to xp
+ * @retval     i        Position of xp
+ * @retval    -1        Not found among elements equal to xp
+ */
+static int
+xml_search_xvec_find(clixon_xvec *xv,
+                     cxobj       *xp,
+                     char        *indexvar,
+                     int          i)
+{
+    int j;
+
+    for (j=i; j>=0; j--){
+        if (clixon_xvec_i(xv, j) == xp)
+            return j;
+        if (xml_cmp(xp, clixon_xvec_i(xv, j), 0, 0, indexvar) != 0)
+            break;
+    }
+    for (j=i+1; j<clixon_xvec_len(xv); j++){
+        if (clixon_xvec_i(xv, j) == xp)
+            return j;
+        if (xml_cmp(xp, clixon_xvec_i(xv, j), 0, 0, indexvar) != 0)
+            break;
+    }
+    return -1;
+}
+
 /*! Insert a new cxobj into search index vector for list for variable "name"
  *
  * @param[in] xp  XML parent object (the list element)
  * @param[in] xi  XML index object (that should be added)
  * @retval    0   OK
  * @retval   -1   Error
+ * @note xp is not inserted if already present
  */
 int
 xml_search_child_insert(cxobj *xp,
@@ -2677,6 +4094,7 @@ xml_search_child_insert(cxobj *xp,
     cxobj               *xpp;
     int                  i;
     int                  len;
+    int                  eq = 0;
 
     indexvar = xml_name(xi);
     if ((xpp = xml_parent(xp)) == NULL)
@@ -2687,11 +4105,12 @@ xml_search_child_insert(cxobj *xp,
         if ((si = xml_search_index_add(xpp, indexvar)) == NULL)
             goto done;
     }
-    /* Find element position using binary search and then remove */
+    /* Find element position using binary search and then insert */
     len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, NULL)) < 0)
+    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, &eq)) < 0)
         goto done;
-    assert(clixon_xvec_i(si->si_xvec, i) != xp);
+    if (eq && xml_search_xvec_find(si->si_xvec, xp, indexvar, i) >= 0)
+        goto ok;
     if (clixon_xvec_insert_pos(si->si_xvec, xp, i) < 0)
         goto done;
  ok:
@@ -2702,8 +4121,10 @@ xml_search_child_insert(cxobj *xp,
 
 /*! Remove a single cxobj from search vector 
  *
+ * The element is removed by pointer. It is first looked for among equal elements using
+ * binary search, and if not found (eg the value of the index has changed), linearly.
  * @param[in] xp    XML parent object (the list element)
- * @param[in] xi    XML index object (that should be added)
+ * @param[in] xi    XML index object (that should be removed)
  * @retval    0     OK
  * @retval   -1     Error
  */
@@ -2725,15 +4146,180 @@ xml_search_child_rm(cxobj *xp,
     /* Find base vector in grandparent */
     if ((si = xml_search_index_get(xpp, indexvar)) == NULL)
         goto ok;
-
     /* Find element using binary search and then remove */
     len = clixon_xvec_len(si->si_xvec);
     if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, &eq)) < 0)
         goto done;
-        //    if (clixon_xvec_i(si->si_xvec, i) == xp)
     if (eq)
-        if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
-            goto done;
+        i = xml_search_xvec_find(si->si_xvec, xp, indexvar, i);
+    else
+        i = -1;
+    if (i < 0){ /* Linear fallback */
+        for (i=0; i<len; i++)
+            if (clixon_xvec_i(si->si_xvec, i) == xp)
+                break;
+    }
+    if (i < len &&
+        clixon_xvec_rm_pos(si->si_xvec, i) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Is this XML object a list element with a search index
+ *
+ * @param[in] x  XML object
+ * @retval    1  Yes
+ * @retval    0  No
+ */
+static int
+xml_search_list_p(cxobj *x)
+{
+    yang_stmt *y;
+
+    if (!is_element(x) ||
+        (y = xml_spec(x)) == NULL ||
+        yang_keyword_get(y) != Y_LIST ||
+        yang_flag_get(y, YANG_FLAG_HAS_INDEX) == 0 ||
+        xml_parent(x) == NULL)
+        return 0;
+    return 1;
+}
+
+/*! Insert list element in all search vectors of its parent
+ *
+ * Called when a list element, complete with index children, is added to a parent
+ * @param[in] xp  XML list element
+ * @retval    0   OK
+ * @retval   -1   Error
+ */
+int
+xml_search_list_insert(cxobj *xp)
+{
+    cxobj *xi;
+    int    i;
+
+    if (!xml_search_list_p(xp))
+        return 0;
+    for (i=0; i<xml_child_nr(xp); i++)
+        if ((xi = xml_child_i(xp, i)) != NULL &&
+            xml_search_index_p(xi) &&
+            xml_search_child_insert(xp, xi) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Remove list element from all search vectors of its parent
+ *
+ * Called when a list element is removed from its parent, before the parent link is cleared
+ * @param[in] xp  XML list element
+ * @retval    0   OK
+ * @retval   -1   Error
+ */
+int
+xml_search_list_rm(cxobj *xp)
+{
+    cxobj *xi;
+    int    i;
+
+    if (!xml_search_list_p(xp))
+        return 0;
+    for (i=0; i<xml_child_nr(xp); i++)
+        if ((xi = xml_child_i(xp, i)) != NULL &&
+            xml_search_index_p(xi) &&
+            xml_search_child_rm(xp, xi) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Return index variable if x is its body, ie the index changes if x changes
+ *
+ * @param[in] x   XML body
+ * @retval    xi  XML index variable
+ * @retval    NULL Not body of index variable
+ */
+static cxobj *
+xml_search_index_body(cxobj *x)
+{
+    cxobj *xi;
+
+    if (xml_type(x) == CX_BODY &&
+        (xi = xml_parent(x)) != NULL &&
+        xml_search_index_p(xi))
+        return xi;
+    return NULL;
+}
+
+/*! Verify search vectors of an XML node, for tests and debugging
+ *
+ * Check that all search vectors are sorted, and that they contain exactly the list
+ * element children with the index variable.
+ * @param[in]   x    XML node. Check its search vectors
+ * @param[in]   arg  Dummy. Ensures xml_apply can be used with this fn
+ * @retval      0    OK
+ * @retval     -1    Error, or inconsistent with clixon_err
+ * @see xml_sort_verify
+ */
+int
+xml_search_index_verify(cxobj *x,
+                        void  *arg)
+{
+    int                  retval = -1;
+    struct search_index *si;
+    cxobj               *xc;
+    cxobj               *xi;
+    cxobj               *xprev;
+    int                  i;
+    int                  n;
+
+    if (!is_element(x))
+        goto ok;
+    if ((si = x->x_search_index) != NULL) {
+        do {
+            xprev = NULL;
+            for (i=0; i<clixon_xvec_len(si->si_xvec); i++){
+                xc = clixon_xvec_i(si->si_xvec, i);
+                if (xml_parent(xc) != x){
+                    clixon_err(OE_XML, 0, "Search index %s of %s: element %d not a child",
+                               si->si_name, xml_name(x), i);
+                    goto done;
+                }
+                if (xprev && xml_cmp(xprev, xc, 0, 0, si->si_name) > 0){
+                    clixon_err(OE_XML, 0, "Search index %s of %s: element %d not sorted",
+                               si->si_name, xml_name(x), i);
+                    goto done;
+                }
+                xprev = xc;
+            }
+            n = 0;
+            xc = NULL;
+            while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+                if ((xi = xml_find_type(xc, NULL, si->si_name, CX_ELMNT)) != NULL &&
+                    xml_search_index_p(xi))
+                    n++;
+            if (n != clixon_xvec_len(si->si_xvec)){
+                clixon_err(OE_XML, 0, "Search index %s of %s: %d elements, expected %d",
+                           si->si_name, xml_name(x), clixon_xvec_len(si->si_xvec), n);
+                goto done;
+            }
+            si = NEXTQ(struct search_index *, si);
+        } while (si && si != x->x_search_index);
+    }
+    /* All list elements with index variables are indexed */
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+        if (!xml_search_list_p(xc))
+            continue;
+        xi = NULL;
+        while ((xi = xml_child_each(xc, xi, CX_ELMNT)) != NULL)
+            if (xml_search_index_p(xi) &&
+                xml_search_index_get(x, xml_name(xi)) == NULL){
+                clixon_err(OE_XML, 0, "Search index %s of %s missing", xml_name(xi), xml_name(x));
+                goto done;
+            }
+    }
  ok:
     retval = 0;
  done:
@@ -2792,3 +4378,759 @@ xml_child_index_each(cxobj           *xparent,
 }
 
 #endif /* XML_EXPLICIT_INDEX */
+
+#ifdef XML_LIST_HASH
+/*! Free list hash index of an XML parent
+ *
+ * @param[in]  xp   XML parent
+ */
+static void
+xml_hash_free(cxobj *xp)
+{
+    struct xml_hash *xh;
+
+    if ((xh = xp->x_hash) != NULL){
+        if (xh->xh_slots)
+            free(xh->xh_slots);
+        free(xh);
+        xp->x_hash = NULL;
+    }
+}
+
+/*! Put an entry in a hash index slot vector, no resizing
+ */
+static void
+xml_hash_put(struct xml_hash *xh,
+             cxobj           *xc,
+             uint32_t         hash)
+{
+    uint32_t mask = xh->xh_size - 1;
+    uint32_t i;
+
+    i = hash & mask;
+    while (xh->xh_slots[i].hs_x != NULL && xh->xh_slots[i].hs_x != XML_HASH_TOMB)
+        i = (i + 1) & mask;
+    if (xh->xh_slots[i].hs_x == NULL)
+        xh->xh_used++;
+    xh->xh_slots[i].hs_x = xc;
+    xh->xh_slots[i].hs_hash = hash;
+    xh->xh_nr++;
+}
+
+/*! Resize hash index so that it can hold at least nr entries, and remove deleted slots
+ *
+ * @param[in]  xh   Hash index
+ * @param[in]  nr   Number of entries
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_hash_resize(struct xml_hash *xh,
+                uint32_t         nr)
+{
+    struct xml_hash_slot *old = xh->xh_slots;
+    uint32_t              oldsize = xh->xh_size;
+    uint32_t              size = 16;
+    uint32_t              i;
+
+    while (size < 2*nr)
+        size *= 2;
+    if ((xh->xh_slots = calloc(size, sizeof(struct xml_hash_slot))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        xh->xh_slots = old;
+        return -1;
+    }
+    xh->xh_size = size;
+    xh->xh_used = 0;
+    xh->xh_nr = 0;
+    for (i=0; i<oldsize; i++)
+        if (old[i].hs_x != NULL && old[i].hs_x != XML_HASH_TOMB)
+            xml_hash_put(xh, old[i].hs_x, old[i].hs_hash);
+    if (old)
+        free(old);
+    return 0;
+}
+
+/*! Add child to the list hash index of its parent, if any
+ *
+ * @param[in]  xp   XML parent
+ * @param[in]  xc   XML child
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_hash_add(cxobj *xp,
+             cxobj *xc)
+{
+    struct xml_hash *xh;
+    yang_stmt       *y;
+    uint32_t         hash;
+    int              ret;
+
+    if ((xh = xp->x_hash) == NULL ||
+        !is_element(xc) ||
+        (y = xml_spec(xc)) == NULL ||
+        (yang_keyword_get(y) != Y_LIST && yang_keyword_get(y) != Y_LEAF_LIST))
+        return 0;
+    if ((ret = xml_key_hash(xc, y, &hash)) < 0)
+        return -1;
+    if (ret == 0)
+        return 0;
+    if (2*(xh->xh_used + 1) > xh->xh_size &&
+        xml_hash_resize(xh, xh->xh_nr + 1) < 0)
+        return -1;
+    xml_hash_put(xh, xc, hash);
+    return 0;
+}
+
+/*! Remove child from the list hash index of its parent, if any
+ *
+ * @param[in]  xp   XML parent
+ * @param[in]  xc   XML child
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_hash_rm(cxobj *xp,
+            cxobj *xc)
+{
+    struct xml_hash *xh;
+    yang_stmt       *y;
+    uint32_t         hash;
+    uint32_t         mask;
+    uint32_t         i;
+    int              ret;
+
+    if ((xh = xp->x_hash) == NULL ||
+        !is_element(xc) ||
+        (y = xml_spec(xc)) == NULL ||
+        (yang_keyword_get(y) != Y_LIST && yang_keyword_get(y) != Y_LEAF_LIST))
+        return 0;
+    if ((ret = xml_key_hash(xc, y, &hash)) < 0)
+        return -1;
+    if (ret == 0) /* Not indexed */
+        return 0;
+    mask = xh->xh_size - 1;
+    i = hash & mask;
+    while (xh->xh_slots[i].hs_x != NULL){
+        if (xh->xh_slots[i].hs_x == xc){
+            xh->xh_slots[i].hs_x = XML_HASH_TOMB;
+            xh->xh_nr--;
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+/*! Drop list hash index if a key of an indexed list entry, or a leaf-list value, changes
+ *
+ * A change of a key value, or a key leaf added or removed, invalidates the hash of the
+ * list entry. Instead of rehashing, the hash index of the list parent is dropped and
+ * rebuilt on next lookup. Key changes of existing entries are rare.
+ * Likewise for a changed value of a leaf-list entry.
+ * @param[in]  x   Body of a leaf that has changed, or element added/removed from a parent
+ */
+static void
+xml_hash_invalidate(cxobj *x)
+{
+    cxobj     *xl;
+    cxobj     *xe;
+    cxobj     *xp;
+    yang_stmt *ye;
+    cg_var    *cvi = NULL;
+
+    switch (xml_type(x)){
+    case CX_BODY:
+        xl = x->x_up;
+        break;
+    case CX_ELMNT:
+        xl = x;
+        break;
+    default:
+        return;
+    }
+    if (xml_type(x) == CX_BODY && /* Value of leaf-list entry */
+        xl != NULL &&
+        (xe = xl->x_up) != NULL &&
+        xe->x_hash != NULL &&
+        (ye = xl->x_spec) != NULL &&
+        yang_keyword_get(ye) == Y_LEAF_LIST){
+        xml_hash_free(xe);
+        return;
+    }
+    if (xl == NULL ||
+        (xe = xl->x_up) == NULL ||
+        (xp = xe->x_up) == NULL ||
+        xp->x_hash == NULL ||
+        (ye = xe->x_spec) == NULL ||
+        yang_keyword_get(ye) != Y_LIST)
+        return;
+    while ((cvi = cvec_each(yang_cvec_get(ye), cvi)) != NULL)
+        if (strcmp(xml_name(xl), cv_string_get(cvi)) == 0){
+            xml_hash_free(xp);
+            break;
+        }
+}
+
+/*! Find list or leaf-list entries equal to x1 among the children of xp using a hash index
+ *
+ * The hash index is built on first use if xp has at least XML_LIST_HASH_MIN children.
+ * It is not built while several threads may read trees, see xml_threads_set, since xp may be
+ * shared, then the caller makes a binary search.
+ * Only applicable if x1 has all keys of the list, otherwise the caller makes a binary search
+ * @param[in]  xp    Parent xml node
+ * @param[in]  x1    Find children of xp equal to this list or leaf-list entry
+ * @param[in]  yc    Yang list or leaf-list spec of x1
+ * @param[out] xvec  Vector of matching XML return objects (can be empty)
+ * @retval     1     OK, see xvec (may be empty)
+ * @retval     0     Not applicable, use other search
+ * @retval    -1     Error
+ * @see XML_LIST_HASH
+ */
+int
+xml_hash_find(cxobj       *xp,
+              cxobj       *x1,
+              yang_stmt   *yc,
+              clixon_xvec *xvec)
+{
+    int              retval = -1;
+    struct xml_hash *xh;
+    struct xml_hash_slot *hs;
+    uint32_t         hash;
+    uint32_t         mask;
+    uint32_t         i;
+    int              ret;
+
+    if (!is_element(xp))
+        goto notapplicable;
+    if ((xh = xp->x_hash) == NULL){
+        if (xml_child_nr(xp) < XML_LIST_HASH_MIN || xml_threads_get())
+            goto notapplicable;
+        if ((xh = calloc(1, sizeof(struct xml_hash))) == NULL){
+            clixon_err(OE_XML, errno, "calloc");
+            goto done;
+        }
+        xp->x_hash = xh;
+        if (xml_hash_resize(xh, xml_child_nr(xp)) < 0){
+            xml_hash_free(xp);
+            goto done;
+        }
+        for (i=0; i<xml_child_nr(xp); i++)
+            if (xml_hash_add(xp, xml_child_i(xp, i)) < 0){
+                xml_hash_free(xp);
+                goto done;
+            }
+    }
+    if ((ret = xml_key_hash(x1, yc, &hash)) < 0)
+        goto done;
+    if (ret == 0)
+        goto notapplicable;
+    mask = xh->xh_size - 1;
+    i = hash & mask;
+    while ((hs = &xh->xh_slots[i])->hs_x != NULL){
+        if (hs->hs_x != XML_HASH_TOMB &&
+            hs->hs_hash == hash &&
+            xml_spec(hs->hs_x) == yc &&
+            xml_cmp(x1, hs->hs_x, 0, 0, NULL) == 0){
+            if (clixon_xvec_append(xvec, hs->hs_x) < 0)
+                goto done;
+        }
+        i = (i + 1) & mask;
+    }
+    retval = 1;
+ done:
+    return retval;
+ notapplicable:
+    retval = 0;
+    goto done;
+}
+#endif /* XML_LIST_HASH */
+
+#ifdef XML_CHILD_CHUNKS
+/*! Find chunk containing child i
+ *
+ * The last accessed chunk is remembered per thread, which makes sequential access fast
+ * without writing to the vector.
+ * @param[in]  xs   Chunked child vector
+ * @param[in]  i    Child index, 0 <= i < number of children
+ * @retval     k    Chunk index
+ */
+static int
+xml_chunks_find(struct xml_chunks *xs,
+                int                i)
+{
+    int k;
+    int low;
+    int upper;
+
+    /* The cursor may be of a freed vector at the same address, k is checked */
+    k = _chunks_last_k;
+    if (_chunks_last_xs == xs && k < xs->xs_nr && xs->xs_start[k] <= i){
+        if (i < xs->xs_start[k] + xs->xs_chunk[k]->ck_len)
+            return k;
+        /* Sequential access: next chunk */
+        if (k+1 < xs->xs_nr && i < xs->xs_start[k+1] + xs->xs_chunk[k+1]->ck_len){
+            _chunks_last_k = k+1;
+            return k+1;
+        }
+    }
+    low = 0;
+    upper = xs->xs_nr - 1;
+    while (low < upper){
+        k = (low + upper + 1) / 2;
+        if (xs->xs_start[k] <= i)
+            low = k;
+        else
+            upper = k - 1;
+    }
+    _chunks_last_xs = xs;
+    _chunks_last_k = low;
+    return low;
+}
+
+/*! Get child i of chunked child vector
+ */
+static cxobj *
+xml_chunks_i(struct xml_chunks *xs,
+             int                i)
+{
+    int k;
+
+    k = xml_chunks_find(xs, i);
+    return xs->xs_chunk[k]->ck_vec[i - xs->xs_start[k]];
+}
+
+/*! Set child i of chunked child vector
+ */
+static void
+xml_chunks_i_set(struct xml_chunks *xs,
+                 int                i,
+                 cxobj             *xc)
+{
+    int k;
+
+    k = xml_chunks_find(xs, i);
+    xs->xs_chunk[k]->ck_vec[i - xs->xs_start[k]] = xc;
+}
+
+/*! Ensure chunk vectors have room for one more chunk
+ */
+static int
+xml_chunks_grow(struct xml_chunks *xs)
+{
+    struct xml_chunk **chunk;
+    int               *start;
+    int                max;
+
+    if (xs->xs_nr < xs->xs_max)
+        return 0;
+    max = xs->xs_max ? 2*xs->xs_max : 16;
+    if ((chunk = realloc(xs->xs_chunk, max*sizeof(struct xml_chunk*))) == NULL){
+        clixon_err(OE_XML, errno, "realloc");
+        return -1;
+    }
+    xs->xs_chunk = chunk;
+    if ((start = realloc(xs->xs_start, max*sizeof(int))) == NULL){
+        clixon_err(OE_XML, errno, "realloc");
+        return -1;
+    }
+    xs->xs_start = start;
+    xs->xs_max = max;
+    return 0;
+}
+
+/*! Insert a new empty chunk at position k
+ */
+static struct xml_chunk *
+xml_chunks_new(struct xml_chunks *xs,
+               int                k,
+               int                start)
+{
+    struct xml_chunk *ck;
+
+    if (xml_chunks_grow(xs) < 0)
+        return NULL;
+    if ((ck = malloc(sizeof(struct xml_chunk))) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        return NULL;
+    }
+    ck->ck_len = 0;
+    memmove(&xs->xs_chunk[k+1], &xs->xs_chunk[k], (xs->xs_nr-k)*sizeof(struct xml_chunk*));
+    memmove(&xs->xs_start[k+1], &xs->xs_start[k], (xs->xs_nr-k)*sizeof(int));
+    xs->xs_chunk[k] = ck;
+    xs->xs_start[k] = start;
+    xs->xs_nr++;
+    return ck;
+}
+
+/*! Free a chunked child vector
+ *
+ * @param[in]  xs        Chunked child vector
+ * @param[in]  children  If set, also free the children
+ */
+static void
+xml_chunks_free(struct xml_chunks *xs,
+                int                children)
+{
+    int k;
+    int j;
+
+    for (k=0; k<xs->xs_nr; k++){
+        if (children)
+            for (j=0; j<xs->xs_chunk[k]->ck_len; j++)
+                if (xs->xs_chunk[k]->ck_vec[j])
+                    xml_free(xs->xs_chunk[k]->ck_vec[j]);
+        free(xs->xs_chunk[k]);
+    }
+    if (xs->xs_chunk)
+        free(xs->xs_chunk);
+    if (xs->xs_start)
+        free(xs->xs_start);
+    free(xs);
+}
+
+/*! Convert flat child vector of an element to chunks
+ *
+ * Chunks are filled to 3/4 to leave room for inserts
+ * @param[in]  xp   XML element
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_chunks_make(cxobj *xp)
+{
+    struct xml_chunks *xs;
+    struct xml_chunk  *ck;
+    int                fill = 3*XML_CHUNK_SIZE/4;
+    int                i;
+    int                n;
+
+    if ((xs = calloc(1, sizeof(struct xml_chunks))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        return -1;
+    }
+    for (i=0; i<xp->x_childvec_len; i+=n){
+        if ((ck = xml_chunks_new(xs, xs->xs_nr, i)) == NULL){
+            xml_chunks_free(xs, 0);
+            return -1;
+        }
+        n = xp->x_childvec_len - i;
+        if (n > fill)
+            n = fill;
+        memcpy(ck->ck_vec, &xp->x_childvec[i], n*sizeof(cxobj*));
+        ck->ck_len = n;
+    }
+    free(xp->x_childvec);
+    xp->x_childvec = NULL;
+    xp->x_childvec_max = 0;
+    xp->x_chunks = xs;
+    return 0;
+}
+
+/*! Convert chunked child vector of an element to a flat vector
+ *
+ * @param[in]  xp   XML element
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_chunks_flatten(cxobj *xp)
+{
+    struct xml_chunks *xs = xp->x_chunks;
+    cxobj            **vec;
+    int                max;
+    int                k;
+
+    max = xp->x_childvec_len ? xp->x_childvec_len : XML_CHILDVEC_SIZE_START;
+    if ((vec = malloc(max*sizeof(cxobj*))) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        return -1;
+    }
+    for (k=0; k<xs->xs_nr; k++)
+        memcpy(&vec[xs->xs_start[k]], xs->xs_chunk[k]->ck_vec,
+               xs->xs_chunk[k]->ck_len*sizeof(cxobj*));
+    xml_chunks_free(xs, 0);
+    xp->x_chunks = NULL;
+    xp->x_childvec = vec;
+    xp->x_childvec_max = max;
+    return 0;
+}
+
+/*! Insert child at position in chunked child vector
+ *
+ * A full chunk is split in two halves.
+ * @param[in]  xp   XML element with chunked children
+ * @param[in]  xc   Child to insert
+ * @param[in]  pos  Position, 0 <= pos <= number of children
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_chunks_insert(cxobj *xp,
+                  cxobj *xc,
+                  int    pos)
+{
+    struct xml_chunks *xs = xp->x_chunks;
+    struct xml_chunk  *ck;
+    struct xml_chunk  *ck1;
+    int                k;
+    int                j;
+    int                half;
+
+    if (pos >= xp->x_childvec_len)
+        k = xs->xs_nr - 1;
+    else
+        k = xml_chunks_find(xs, pos);
+    ck = xs->xs_chunk[k];
+    if (ck->ck_len == XML_CHUNK_SIZE && pos == xp->x_childvec_len){
+        /* Append: start a new chunk instead of splitting */
+        if ((ck = xml_chunks_new(xs, ++k, pos)) == NULL)
+            return -1;
+    }
+    else if (ck->ck_len == XML_CHUNK_SIZE){
+        half = XML_CHUNK_SIZE/2;
+        if ((ck1 = xml_chunks_new(xs, k+1, xs->xs_start[k] + half)) == NULL)
+            return -1;
+        memcpy(ck1->ck_vec, &ck->ck_vec[half], (XML_CHUNK_SIZE-half)*sizeof(cxobj*));
+        ck1->ck_len = XML_CHUNK_SIZE-half;
+        ck->ck_len = half;
+        if (pos > xs->xs_start[k+1]){
+            k++;
+            ck = ck1;
+        }
+    }
+    j = pos - xs->xs_start[k];
+    memmove(&ck->ck_vec[j+1], &ck->ck_vec[j], (ck->ck_len-j)*sizeof(cxobj*));
+    ck->ck_vec[j] = xc;
+    ck->ck_len++;
+    for (k=k+1; k<xs->xs_nr; k++)
+        xs->xs_start[k]++;
+    xp->x_childvec_len++;
+    return 0;
+}
+
+/*! Remove child i from chunked child vector
+ *
+ * An empty chunk is removed. If few children remain, convert back to a flat vector
+ * @param[in]  xp   XML element with chunked children
+ * @param[in]  i    Child index
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_chunks_rm(cxobj *xp,
+              int    i)
+{
+    struct xml_chunks *xs = xp->x_chunks;
+    struct xml_chunk  *ck;
+    int                k;
+    int                j;
+
+    k = xml_chunks_find(xs, i);
+    ck = xs->xs_chunk[k];
+    j = i - xs->xs_start[k];
+    ck->ck_len--;
+    memmove(&ck->ck_vec[j], &ck->ck_vec[j+1], (ck->ck_len-j)*sizeof(cxobj*));
+    if (ck->ck_len == 0){
+        free(ck);
+        xs->xs_nr--;
+        memmove(&xs->xs_chunk[k], &xs->xs_chunk[k+1], (xs->xs_nr-k)*sizeof(struct xml_chunk*));
+        memmove(&xs->xs_start[k], &xs->xs_start[k+1], (xs->xs_nr-k)*sizeof(int));
+    }
+    else
+        k++;
+    for (; k<xs->xs_nr; k++)
+        xs->xs_start[k]--;
+    xp->x_childvec_len--;
+    if (xp->x_childvec_len < XML_CHUNK_THRESHOLD/2 &&
+        xml_chunks_flatten(xp) < 0)
+        return -1;
+    return 0;
+}
+#endif /* XML_CHILD_CHUNKS */
+
+#ifdef XML_CHILD_ORDER
+/*! Distance between order labels of children of a parent
+ *
+ * At most XML_ORDER_GAP, and small enough that labeling all children anew leaves half of
+ * the 32-bit label space free for children appended later.
+ * @param[in]  xp   XML parent element
+ * @retval     gap  Distance between labels, at least 1
+ */
+static uint32_t
+xml_order_gap(cxobj *xp)
+{
+    uint32_t gap;
+
+    gap = (uint32_t)(UINT32_MAX / (2*(uint64_t)xp->x_childvec_len + 2));
+    if (gap > XML_ORDER_GAP)
+        gap = XML_ORDER_GAP;
+    if (gap == 0)
+        gap = 1;
+    return gap;
+}
+
+/*! Label all children of a parent in order with xml_order_gap between labels
+ *
+ * Order labels are increasing along the child vector and are used by xml_child_order to
+ * find the position of a child using binary search.
+ * An inserted child gets a label between the labels of its neighbours, and only if there is
+ * no free label left all children are labeled anew. Removing a child keeps labels increasing.
+ * @param[in]  xp   XML parent element
+ */
+static void
+xml_order_relabel(cxobj *xp)
+{
+    cxobj   *xc;
+    uint32_t gap;
+    uint32_t ord = 0;
+    int      i;
+
+    gap = xml_order_gap(xp);
+    for (i=0; i<xp->x_childvec_len; i++){
+        ord += gap;
+        if ((xc = xml_childvec_i(xp, i)) != NULL)
+            xc->_x_ord = ord;
+    }
+    xp->x_iflags |= XML_IFLAG_ORDER;
+}
+
+/*! Label a child inserted at a position between the labels of its neighbours
+ *
+ * If labels of the parent are not valid, nothing is done: they are labeled anew when needed.
+ * If there is no free label between the neighbours, the labels are invalidated.
+ * @param[in]  xp   XML parent element
+ * @param[in]  pos  Position of the inserted child
+ */
+static void
+xml_order_insert(cxobj *xp,
+                 int    pos)
+{
+    cxobj   *xc;
+    cxobj   *x;
+    uint32_t gap;
+    uint32_t low = 0;
+    uint32_t high;
+
+    if ((xc = xml_childvec_i(xp, pos)) == NULL)
+        return;
+    if (xp->x_childvec_len == 1){
+        xc->_x_ord = XML_ORDER_GAP;
+        xp->x_iflags |= XML_IFLAG_ORDER;
+        return;
+    }
+    if ((xp->x_iflags & XML_IFLAG_ORDER) == 0)
+        return;
+    if (pos > 0){
+        if ((x = xml_childvec_i(xp, pos-1)) == NULL)
+            goto invalid;
+        low = x->_x_ord;
+    }
+    if (pos == xp->x_childvec_len-1){ /* Last */
+        gap = xml_order_gap(xp);
+        if (low > UINT32_MAX - gap)
+            goto invalid;
+        xc->_x_ord = low + gap;
+        return;
+    }
+    if ((x = xml_childvec_i(xp, pos+1)) == NULL)
+        goto invalid;
+    high = x->_x_ord;
+    if (high <= low || high - low < 2)
+        goto invalid;
+    xc->_x_ord = low + (high - low)/2;
+    return;
+ invalid:
+    xp->x_iflags &= ~XML_IFLAG_ORDER;
+}
+#endif /* XML_CHILD_ORDER */
+
+#ifdef XML_YANG_GROUPS
+/*! Free cached ranges of yang groups of a parent, they are built anew on next lookup
+ *
+ * @param[in]  xp   XML parent element
+ */
+static void
+xml_ygroups_free(cxobj *xp)
+{
+    struct xml_ygroups *xy;
+
+    if ((xy = xp->x_ygroups) == NULL)
+        return;
+    if (xy->xy_vec)
+        free(xy->xy_vec);
+    free(xy);
+    xp->x_ygroups = NULL;
+}
+
+/*! Update cached ranges of yang groups after a child has been inserted at a position
+ *
+ * If the child is not inserted in or adjacent to its group, or is the first of a new yang
+ * spec, the ranges are freed.
+ * @param[in]  xp   XML parent element
+ * @param[in]  pos  Position of the inserted child
+ */
+static void
+xml_ygroups_insert(cxobj *xp,
+                   int    pos)
+{
+    struct xml_ygroups *xy;
+    struct xml_ygroup  *yg;
+    cxobj              *xc;
+    yang_stmt          *y = NULL;
+    int                 found = 0;
+    int                 k;
+
+    if ((xy = xp->x_ygroups) == NULL)
+        return;
+    if ((xc = xml_childvec_i(xp, pos)) != NULL && xml_type(xc) == CX_ELMNT)
+        y = xc->x_spec;
+    for (k=0; k<xy->xy_len; k++){
+        yg = &xy->xy_vec[k];
+        if (y != NULL && yg->yg_spec == y){
+            if (pos < yg->yg_start || pos > yg->yg_end)
+                goto invalid;
+            yg->yg_end++;
+            found++;
+        }
+        else if (pos <= yg->yg_start){
+            yg->yg_start++;
+            yg->yg_end++;
+        }
+        else if (pos < yg->yg_end) /* Inside another group */
+            goto invalid;
+    }
+    if (y != NULL && !found) /* New yang spec */
+        goto invalid;
+    return;
+ invalid:
+    xml_ygroups_free(xp);
+}
+
+/*! Update cached ranges of yang groups before child i is removed
+ *
+ * @param[in]  xp   XML parent element
+ * @param[in]  i    Position of the removed child
+ */
+static void
+xml_ygroups_rm(cxobj *xp,
+               int    i)
+{
+    struct xml_ygroups *xy;
+    struct xml_ygroup  *yg;
+    int                 k;
+
+    if ((xy = xp->x_ygroups) == NULL)
+        return;
+    for (k=0; k<xy->xy_len; k++){
+        yg = &xy->xy_vec[k];
+        if (i < yg->yg_start){
+            yg->yg_start--;
+            yg->yg_end--;
+        }
+        else if (i < yg->yg_end)
+            yg->yg_end--;
+    }
+}
+#endif /* XML_YANG_GROUPS */
@@ -195,7 +195,7 @@ populate_self_parent(clixon_handle h,
         goto done;
     /* Special case since action is not a datanode */
     if ((y = yang_find(yparent, Y_ACTION, name)) == NULL){
-        if (h && clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
+        if (h && clicon_option_slot_bool(h, OS_YANG_SCHEMA_MOUNT)){
             if (yang_schema_mount_point(yparent)){
                 yspec1 = NULL;
                 if ((ret = yang_mount_get_yspec_any(yparent, &yspec1)) < 0)
@@ -265,11 +265,8 @@ populate_self_parent(clixon_handle h,
         goto fail;
     }
  set:
-    xml_spec_set(xt, y);
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xt))
-        xml_search_child_insert(xp, xt);
-#endif
+    if (xml_spec_set(xt, y) < 0) /* Also inserts in search index, see XML_EXPLICIT_INDEX */
+        goto done;
     retval = 1;
  done:
     if (cb)
@@ -569,7 +566,7 @@ xml_bind_yang0_opt(clixon_handle h,
         goto ok;
     strip_body_objects(xt);
     ybc = YB_PARENT;
-    if (h && clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT") &&
+    if (h && clicon_option_slot_bool(h, OS_YANG_SCHEMA_MOUNT) &&
         xml_schema_mount_point(xt)){
         if ((ret = yang_schema_mount_yspec(h, xt, &ybc, &yspec, xerr)) < 0)
             goto done;
@@ -602,6 +599,10 @@ xml_bind_yang0_opt(clixon_handle h,
         name0 = xml_name(xc);
         prefix0 = xml_prefix(xc);
     }
+#ifdef XML_BIND_CV_CACHE
+    if (xml_cv_cache_keys(xt) < 0)
+        goto done;
+#endif
  ok:
     retval = 1;
  done:
@@ -665,7 +666,7 @@ xml_bind_yang0(clixon_handle h,
     else if (ret == 2)     /* ret=2 for anyxml from parent^ */
         goto ok;
     strip_body_objects(xt);
-    if (h && clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")&&
+    if (h && clicon_option_slot_bool(h, OS_YANG_SCHEMA_MOUNT)&&
         xml_schema_mount_point(xt)){
         if ((ret = yang_schema_mount_yspec(h, xt,
                                            NULL, // &ybc,
@@ -681,6 +682,10 @@ xml_bind_yang0(clixon_handle h,
         if (ret == 0)
             goto fail;
     }
+#ifdef XML_BIND_CV_CACHE
+    if (xml_cv_cache_keys(xt) < 0)
+        goto done;
+#endif
  ok:
     retval = 1;
  done:
@@ -216,92 +216,125 @@ changelog_move(clixon_handle h,
     return retval;
 }
 
-/*! Perform a changelog operation
+/*! Perform a changelog operation on one target node
  *
- * @param[in]  h   Clixon handle
- * @param[in]  xt  XML to upgrade
- * @param[in]  xi  Changelog item
- * @retval     0   OK
- * @retval    -1   Error
+ * @param[in]  h    Clixon handle
+ * @param[in]  xt   XML to upgrade
+ * @param[in]  xw   Target node meeting the where requirement of xi
+ * @param[in]  xi   Changelog item
+ * @param[in]  nsc  Namespace context of changelog item
+ * @retval     1    OK
+ * @retval     0    Failed
+ * @retval    -1    Error
+ */
+static int
+changelog_op_target(clixon_handle h,
+                    cxobj        *xt,
+                    cxobj        *xw,
+                    cxobj        *xi,
+                    cvec         *nsc)
+{
+    int     retval = -1;
+    char   *op;
+    char   *whenxpath;   /* xpath to when */
+    xp_ctx *xctx = NULL;
+    int     ret;
+
+    op = xml_find_body(xi, "op");
+    /* If 'when' exists and is false, skip this target */
+    if ((whenxpath = xml_find_body(xi, "when")) != NULL){
+        if (xpath_vec_ctx(xw, nsc, whenxpath, 0, &xctx) < 0)
+            goto done;
+        if ((ret = ctx2boolean(xctx)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
+    /* Now switch on operation */
+    if (strcmp(op, "rename") == 0){
+        ret = changelog_rename(h, xt, xw, nsc, xml_find_body(xi, "tag"));
+    }
+    else if (strcmp(op, "replace") == 0){
+        ret = changelog_replace(h, xt, xw, xml_find(xi, "new"));
+    }
+    else if (strcmp(op, "insert") == 0){
+        ret = changelog_insert(h, xt, xw, xml_find(xi, "new"));
+    }
+    else if (strcmp(op, "delete") == 0){
+        ret = changelog_delete(h, xt, xw);
+    }
+    else if (strcmp(op, "move") == 0){
+        ret = changelog_move(h, xt, xw, nsc, xml_find_body(xi, "dst"));
+    }
+    else{
+        clixon_err(OE_XML, 0, "Unknown operation: %s", op);
+        goto done;
+    }
+    if (ret < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+ ok:
+    retval = 1;
+ done:
+    if (xctx)
+        ctx_free(xctx);
+    return retval;
+ fail:
+    retval = 0;
+    clixon_debug(CLIXON_DBG_XML, "fail op:%s", op);
+    goto done;
+}
+
+/*! Perform a group of changelog operations with the same targets
+ *
+ * The targets are the nodes meeting the where requirement of the first item, which are
+ * computed once. For each target, the operations of all items are made in order.
+ * @param[in]  h    Clixon handle
+ * @param[in]  xt   XML to upgrade
+ * @param[in]  vec  Changelog items, see changelog_group
+ * @param[in]  n    Number of changelog items
+ * @retval     1    OK
+ * @retval     0    Failed
+ * @retval    -1    Error
  * @note XXX error handling!
  * @note XXX xn --> xt  xpath may not match
 */
 static int
 changelog_op(clixon_handle h,
              cxobj        *xt,
-             cxobj        *xi)
+             cxobj       **vec,
+             int           n)
 
 {
     int     retval = -1;
-    char   *op;
-    char   *whenxpath;   /* xpath to when */
-    char   *tag;         /* xpath to extra path (move) */
-    char   *dst;         /* xpath to extra path (move) */
-    cxobj  *xnew;        /* new xml (insert, replace) */
+    cxobj  *xi = vec[0];
     char   *wxpath;      /* xpath to where (target-node) */
     cxobj **wvec = NULL; /* Vector of where(target) nodes */
     size_t  wlen;
-    cxobj  *xw;
     int     ret;
-    xp_ctx *xctx = NULL;
     int     i;
+    int     j;
     cvec   *nsc = NULL;
 
     /* Get namespace context from changelog item */
     if (xml_nsctx_node(xi, &nsc) < 0)
         goto done;
-    if ((op = xml_find_body(xi, "op")) == NULL)
+    if (xml_find_body(xi, "op") == NULL)
         goto ok;
-    /* get common variables that may be used in the operations below */
-    tag = xml_find_body(xi, "tag");
-    dst = xml_find_body(xi, "dst");
-    xnew = xml_find(xi, "new");
-    whenxpath = xml_find_body(xi, "when");
     if ((wxpath = xml_find_body(xi, "where")) == NULL)
         goto ok;
     /* Get vector of target nodes meeting the where requirement */
     if (xpath_vec(xt, nsc, "%s", &wvec, &wlen, wxpath) < 0)
        goto done;
-   for (i=0; i<wlen; i++){
-       xw = wvec[i];
-       /* If 'when' exists and is false, skip this target */
-       if (whenxpath){
-           if (xpath_vec_ctx(xw, nsc, whenxpath, 0, &xctx) < 0)
-               goto done;
-           if ((ret = ctx2boolean(xctx)) < 0)
-               goto done;
-           if (xctx){
-               ctx_free(xctx);
-               xctx = NULL;
-           }
-           if (ret == 0)
-               continue;
-       }
-       /* Now switch on operation */
-       if (strcmp(op, "rename") == 0){
-           ret = changelog_rename(h, xt, xw, nsc, tag);
-       }
-       else if (strcmp(op, "replace") == 0){
-           ret = changelog_replace(h, xt, xw, xnew);
-       }
-       else if (strcmp(op, "insert") == 0){
-           ret = changelog_insert(h, xt, xw, xnew);
-       }
-       else if (strcmp(op, "delete") == 0){
-           ret = changelog_delete(h, xt, xw);
-       }
-       else if (strcmp(op, "move") == 0){
-           ret = changelog_move(h, xt, xw, nsc, dst);
-       }
-       else{
-           clixon_err(OE_XML, 0, "Unknown operation: %s", op);
-           goto done;
-       }
-       if (ret < 0)
-           goto done;
-       if (ret == 0)
-           goto fail;
-   }
+    for (i=0; i<wlen; i++){
+        for (j=0; j<n; j++){
+            if ((ret = changelog_op_target(h, xt, wvec[i], vec[j], nsc)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+    }
  ok:
     retval = 1;
  done:
@@ -309,15 +342,67 @@ changelog_op(clixon_handle h,
         xml_nsctx_free(nsc);
     if (wvec)
         free(wvec);
-    if (xctx)
-        ctx_free(xctx);
     return retval;
  fail:
     retval = 0;
-    clixon_debug(CLIXON_DBG_XML, "fail op:%s", op);
     goto done;
 }
 
+/*! Check if a where xpath is a plain absolute location path
+ *
+ * Ie only child steps of names, no predicates, wildcards, descendants or functions.
+ * The nodes matching such a path only depend on the names of the nodes along the path.
+ */
+static int
+changelog_path_plain(char *xpath)
+{
+    return xpath[0] == '/' &&
+        strpbrk(xpath, "[]()*|@ \t\n") == NULL &&
+        strstr(xpath, "//") == NULL &&
+        strstr(xpath, "..") == NULL;
+}
+
+/*! Get number of changelog items from item i that can be made as one group
+ *
+ * Consecutive items with the same plain where path, no when condition and no own
+ * namespace declarations have the same targets. If the ops of all but the last item are
+ * insert or replace, which only modify the children of a target, the target set does not
+ * change between the items, and the items can be made target by target in one pass with
+ * the same result as item by item.
+ * @param[in]  vec  Changelog items
+ * @param[in]  len  Number of changelog items
+ * @param[in]  i    First item of group
+ * @retval     n    Number of items in group, at least 1
+ */
+static int
+changelog_group(cxobj **vec,
+                int     len,
+                int     i)
+{
+    char  *where;
+    char  *op;
+    cxobj *xj;
+    int    j;
+
+    if ((where = xml_find_body(vec[i], "where")) == NULL ||
+        !changelog_path_plain(where))
+        return 1;
+    for (j=i; j<len; j++){
+        xj = vec[j];
+        if (xml_child_nr_type(xj, CX_ATTR) != 0 ||
+            xml_find(xj, "when") != NULL ||
+            xml_find_body(xj, "where") == NULL ||
+            strcmp(xml_find_body(xj, "where"), where) != 0 ||
+            (op = xml_find_body(xj, "op")) == NULL)
+            break;
+        if (strcmp(op, "insert") != 0 && strcmp(op, "replace") != 0){
+            j++; /* Last item of group may change the targets */
+            break;
+        }
+    }
+    return j > i ? j - i : 1;
+}
+
 /*! Iterate through one changelog item
  *
  * @param[in]  h   Clixon handle
@@ -337,12 +422,14 @@ changelog_iterate(clixon_handle h,
     size_t     veclen;
     int        ret;
     int        i;
+    int        n;
 
     if (xpath_vec(xch, NULL, "step", &vec, &veclen) < 0)
         goto done;
-    /* Iterate through changelog items */
-    for (i=0; i<veclen; i++){
-        if ((ret = changelog_op(h, xt, vec[i])) < 0)
+    /* Iterate through changelog items, consecutive items with same targets as one group */
+    for (i=0; i<veclen; i+=n){
+        n = changelog_group(vec, veclen, i);
+        if ((ret = changelog_op(h, xt, &vec[i], n)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
@@ -397,6 +484,9 @@ xml_changelog_upgrade(clixon_handle h,
     /* Check if changelog enabled */
     if (!clicon_option_bool(h, "CLICON_XML_CHANGELOG"))
         goto ok;
+    /* Module removed or revision not changed: no changelog applies (revision is a key) */
+    if (to == 0 || from == to)
+        goto ok;
     /* Get changelog */
     if ((xchlog = clicon_xml_changelog_get(h)) == NULL)
         goto ok;
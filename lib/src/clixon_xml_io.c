@@ -55,6 +55,10 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <dirent.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -85,15 +89,18 @@
 #include "clixon_xpath.h"
 #include "clixon_datastore.h"
 #include "clixon_xml_io.h"
+#include "clixon_file.h"
 
-/*
- * Constants
- */
-/* Size of xml read buffer */
-#define BUFLEN 1024
+/* Use hand-written XML parser before flex/bison, see CLICON_XML_PARSE_FAST */
+static int _xml_parse_fast = 0;
+
+#ifdef HAVE_LIBPTHREAD
+/* The flex/bison parser is not reentrant, serialize it in threads, see xml_threads_set */
+static pthread_mutex_t _xml_parse_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 /* Forward */
-static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop);
+static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop, int flag);
 
 /*------------------------------------------------------------------------
  * XML printing functions. Output a parse tree to file, string cligen buf
@@ -192,6 +199,36 @@ xml2output_wdef(cxobj            *x,
     return retval;
 }
 
+/*! Check if XML node is root of a split sub-file of a multi-file datastore
+ *
+ * @param[in]  x      XML node
+ * @param[in]  multi  Split mode, see XML_MULTI_SPLIT and XML_MULTI_SHARD
+ * @retval     1      Yes, x is written in a separate file
+ * @retval     0      No
+ * @retval    -1      Error
+ * @see CLICON_XMLDB_MULTI
+ */
+int
+xml_multi_split(cxobj *x,
+                int    multi)
+{
+    yang_stmt *y;
+    cxobj     *xp;
+    int        exist = 0;
+
+    if (multi == 0 ||
+        (y = xml_spec(x)) == NULL ||
+        xml_child_nr_type(x, CX_ELMNT) == 0)
+        return 0;
+    if ((multi & XML_MULTI_SHARD) &&
+        (xp = xml_parent(x)) != NULL &&
+        xml_flag(xp, XML_FLAG_TOP))
+        return 1;
+    if (yang_extension_value(y, "xmldb-split", CLIXON_LIB_NS, &exist, NULL) < 0)
+        return -1;
+    return exist;
+}
+
 /*! Print an XML tree structure to an output stream and encode chars "<>&"
  *
  * @param[in]   f          UNIX output stream
@@ -246,6 +283,8 @@ xml2file_recurse(FILE                *f,
 
     if (x == NULL)
         goto ok;
+    if (xml_sort_ensure(x) < 0)
+        goto done;
     y = xml_spec(x);
     /* Check if system-only, then do not write to datastore
      */
@@ -325,8 +364,8 @@ xml2file_recurse(FILE                *f,
             (*fn)(f, "/>");
         else{
             /* Check if this is a multi-file split-point */
-            if (multi && (y = xml_spec(x)) != NULL){
-                if (yang_extension_value(y, "xmldb-split", CLIXON_LIB_NS, &exist, NULL) < 0)
+            if (multi){
+                if ((exist = xml_multi_split(x, multi)) < 0)
                     goto done;
                 if (exist){
                     subfile++;
@@ -552,6 +591,14 @@ xml_dump(FILE  *f,
     return xml_dump1(f, x, 0);
 }
 
+/*! Flush state of streaming XML output, see clixon_xml2cbuf_stream
+ */
+struct xml2cbuf_flush {
+    size_t                 xf_limit; /* Flush when buffer length reaches this */
+    clixon_output_flush_t *xf_fn;    /* Flush function */
+    void                  *xf_arg;   /* Argument to flush function */
+};
+
 /*! Internal: print XML tree structure to a cligen buffer and encode chars "<>&"
  *
  * @param[in,out] cb       Cligen buffer to write to
@@ -561,6 +608,9 @@ xml_dump(FILE  *f,
  * @param[in]     prefix   Add string to beginning of each line (if pretty)
  * @param[in]     depth    Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
  * @param[in]     wdef     With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     fn       Filter function for elements, or NULL for all
+ * @param[in]     arg      Argument to filter function
+ * @param[in]     xf       Flush buffer before elements when it exceeds a limit, or NULL
  * @retval        0        OK
  * @retval       -1        Error
  * wdef changes the output as follows:
@@ -571,13 +621,16 @@ xml_dump(FILE  *f,
  * @see xml2file_recurse  same with FILE
  */
 static int
-xml2cbuf_recurse(cbuf             *cb,
-                 cxobj            *x,
-                 int               level,
-                 int               pretty,
-                 char             *prefix,
-                 int32_t           depth,
-                 withdefaults_type wdef)
+xml2cbuf_recurse(cbuf                *cb,
+                 cxobj               *x,
+                 int                  level,
+                 int                  pretty,
+                 char                *prefix,
+                 int32_t              depth,
+                 withdefaults_type    wdef,
+                 xml_output_filter_t *fn,
+                 void                *arg,
+                 struct xml2cbuf_flush *xf)
 {
     int        retval = -1;
     cxobj     *xc;
@@ -593,6 +646,16 @@ xml2cbuf_recurse(cbuf             *cb,
 
     if (depth == 0)
         goto ok;
+    if (fn && xml_type(x) == CX_ELMNT){
+        if ((ret = fn(x, arg)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+        if (ret == 2) /* Print whole sub-tree */
+            fn = NULL;
+    }
+    if (xml_sort_ensure(x) < 0)
+        goto done;
     if ((y = xml_spec(x)) != NULL){
         /* with-defaults: if object should be printed or not */
         if ((ret = xml2output_wdef(x, wdef, &tag)) < 0)
@@ -613,24 +676,32 @@ xml2cbuf_recurse(cbuf             *cb,
             goto done;
         break;
     case CX_ATTR:
-        cbuf_append_str(cb, " ");
+        cbuf_append(cb, ' ');
         if (namespace){
             cbuf_append_str(cb, namespace);
-            cbuf_append_str(cb, ":");
+            cbuf_append(cb, ':');
         }
-        cprintf(cb, "%s=\"%s\"", name, xml_value(x));
+        cbuf_append_str(cb, name);
+        cbuf_append_str(cb, "=\"");
+        if ((val = xml_value(x)) != NULL)
+            cbuf_append_str(cb, val);
+        cbuf_append(cb, '"');
         break;
     case CX_ELMNT:
+        if (xf && cbuf_len(cb) >= xf->xf_limit){
+            if (xf->xf_fn(cb, xf->xf_arg) < 0)
+                goto done;
+        }
         if (pretty){
             if (prefix)
                 cprintf(cb, "%s", prefix);
             cprintf(cb, "%*s<", level1, "");
         }
         else
-            cbuf_append_str(cb, "<");
+            cbuf_append(cb, '<');
         if (namespace){
             cbuf_append_str(cb, namespace);
-            cbuf_append_str(cb, ":");
+            cbuf_append(cb, ':');
         }
         cbuf_append_str(cb, name);
         if (tag) /* If default and WITHDEFAULTS_REPORT_ALL_TAGGED */
@@ -642,7 +713,7 @@ xml2cbuf_recurse(cbuf             *cb,
         while ((xc = xml_child_each(x, xc, -1)) != NULL)
             switch (xml_type(xc)){
             case CX_ATTR:
-                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef) < 0)
+                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef, NULL, NULL, NULL) < 0)
                     goto done;
                 break;
             case CX_BODY:
@@ -658,9 +729,9 @@ xml2cbuf_recurse(cbuf             *cb,
         if (hasbody==0 && haselement==0)
             cbuf_append_str(cb, "/>");
         else{
-            cbuf_append_str(cb, ">");
+            cbuf_append(cb, '>');
             if (pretty && hasbody == 0)
-                cbuf_append_str(cb, "\n");
+                cbuf_append(cb, '\n');
             xc = NULL;
             while ((xc = xml_child_each(x, xc, -1)) != NULL)
                 if (xml_type(xc) != CX_ATTR){
@@ -679,7 +750,7 @@ xml2cbuf_recurse(cbuf             *cb,
                             xa = xml_find_type(xc, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE, CX_ATTR);
                         }
                     }
-                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef) < 0)
+                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef, fn, arg, xf) < 0)
                         goto done;
                     if (xa){
                         if (xml_purge(xa) < 0)
@@ -694,13 +765,13 @@ xml2cbuf_recurse(cbuf             *cb,
             cbuf_append_str(cb, "</");
             if (namespace){
                 cbuf_append_str(cb, namespace);
-                cbuf_append_str(cb, ":");
+                cbuf_append(cb, ':');
             }
             cbuf_append_str(cb, name);
-            cbuf_append_str(cb, ">");
+            cbuf_append(cb, '>');
         }
         if (pretty)
-            cbuf_append_str(cb, "\n");
+            cbuf_append(cb, '\n');
         break;
     default:
         break;
@@ -750,11 +821,115 @@ clixon_xml2cbuf1(cbuf             *cb,
     if (skiptop){
         xc = NULL;
         while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef) < 0)
+            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef, NULL, NULL, NULL) < 0)
                 goto done;
     }
     else {
-        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef) < 0)
+        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef, NULL, NULL, NULL) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print a filtered XML tree structure to a cligen buffer and encode chars "<>&"
+ *
+ * Print directly from a tree, such as a datastore cache, instead of making a filtered copy
+ * The filter function is called for each element before it is printed and returns:
+ *   2: print element and its whole sub-tree, the filter is not called for descendants
+ *   1: print element and call the filter for its children
+ *   0: skip element
+ *  -1: error
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xn      Top-level xml object
+ * @param[in]     level   Indentation level for pretty
+ * @param[in]     pretty  Insert \n and spaces to make the xml more readable.
+ * @param[in]     prefix  Add string to beginning of each line (or NULL) (if pretty)
+ * @param[in]     depth   Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]     skiptop 0: Include top object 1: Skip top-object, only children,
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     fn      Filter function
+ * @param[in]     arg     Argument to filter function
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @see xml_marked_filter  Filter function that prints marked nodes, as xml_copy_marked
+ */
+int
+clixon_xml2cbuf_filter(cbuf                *cb,
+                       cxobj               *xn,
+                       int                  level,
+                       int                  pretty,
+                       char                *prefix,
+                       int32_t              depth,
+                       int                  skiptop,
+                       withdefaults_type    wdef,
+                       xml_output_filter_t *fn,
+                       void                *arg)
+{
+    int    retval = -1;
+    cxobj *xc;
+
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
+            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef, fn, arg, NULL) < 0)
+                goto done;
+    }
+    else {
+        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef, fn, arg, NULL) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print a filtered XML tree structure to a cligen buffer and flush it while printing
+ *
+ * As clixon_xml2cbuf_filter, but before an element is printed and the buffer has reached
+ * limit bytes, the flush function is called with the buffer. The flush function is
+ * expected to write the buffer, eg to a socket, and reset it. The remainder is left in
+ * the buffer on return.
+ * Thereby a large tree can be written without holding the whole serialized tree.
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xn      Top-level xml object
+ * @param[in]     depth   Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]     skiptop 0: Include top object 1: Skip top-object, only children,
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     fn      Filter function, or NULL for all
+ * @param[in]     arg     Argument to filter function
+ * @param[in]     limit   Flush buffer when it has reached this length
+ * @param[in]     flushfn Flush function
+ * @param[in]     flusharg Argument to flush function
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @see clixon_xml2cbuf_filter
+ */
+int
+clixon_xml2cbuf_stream(cbuf                  *cb,
+                       cxobj                 *xn,
+                       int32_t                depth,
+                       int                    skiptop,
+                       withdefaults_type      wdef,
+                       xml_output_filter_t   *fn,
+                       void                  *arg,
+                       size_t                 limit,
+                       clixon_output_flush_t *flushfn,
+                       void                  *flusharg)
+{
+    int                   retval = -1;
+    cxobj                *xc;
+    struct xml2cbuf_flush xf = {limit, flushfn, flusharg};
+
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
+            if (xml2cbuf_recurse(cb, xc, 0, 0, NULL, depth, wdef, fn, arg, &xf) < 0)
+                goto done;
+    }
+    else {
+        if (xml2cbuf_recurse(cb, xn, 0, 0, NULL, depth, wdef, fn, arg, &xf) < 0)
             goto done;
     }
     retval = 0;
@@ -828,40 +1003,48 @@ xmltree2cbuf(cbuf  *cb,
 /*--------------------------------------------------------------------
  * XML parsing functions. Create XML parse tree from string and file.
  *--------------------------------------------------------------------*/
-/*! Common internal xml parsing function string to parse-tree
+/*! Enable or disable hand-written XML parser
  *
- * Given a string containing XML, parse into existing XML tree and return
+ * @param[in]  enable  If set, try clixon_xml_parse_fast before the flex/bison parser
+ * @retval     0       OK
+ * @see CLICON_XML_PARSE_FAST
+ */
+int
+clixon_xml_parse_fast_set(int enable)
+{
+    _xml_parse_fast = enable;
+    return 0;
+}
+
+/*! Parse XML in a buffer terminated by two null characters in place
+ *
+ * The scanner reads the buffer directly without copying it, the buffer may be modified
+ * If copy is set, buf is a null-terminated string that is not modified: the hand-written
+ * parser reads it in place and only the flex/bison parser makes a copy.
  * @param[in]     h     Clixon handle sometimes NULL
- * @param[in]     str   Pointer to string containing XML definition.
+ * @param[in]     buf   Buffer with XML, followed by two null characters, or string if copy
+ * @param[in]     len   Length of XML in buf, excluding null characters
+ * @param[in]     copy  buf is a string that may not be modified and has one null character
  * @param[in]     yb    How to bind yang to XML top-level when parsing
  * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
- * @param[in,out] xtop  Top of XML parse tree. Assume created. Holds new tree.
+ * @param[in,out] xt    Top of XML parse tree. Assume created. Holds new tree.
  * @param[out]    xerr  Reason for failure (yang assignment not made)
  * @retval        1     Parse OK and all yang assignment made
  * @retval        0     Parse OK but yang assigment not made (or only partial) and xerr set
  * @retval       -1     Error
- * @see clixon_xml_parse_file
- * @see clixon_xml_parse_string
- * @see _json_parse
- * @note special case is empty XML where the parser is not invoked.
- * It is questionable empty XML is legal. From https://www.w3.org/TR/2008/REC-xml-20081126 Sec 2.1:
- *    A well-formed document ... contains one or more elements.
- * But in clixon one can invoke a parser on a sub-part of a document where it makes sense to accept
- * an empty XML. For example where an empty config: <config></config> is parsed.
- * In other cases, such as receiving netconf ]]>]]> it should represent a complete document and
- * therefore not well-formed.
- * Therefore checking for empty XML must be done by a calling function which knows wether the
- * the XML represents a full document or not.
- * @note may be called recursively, some yang-bind (eg rpc) semantic checks may trigger error message
- * @note yang-binding over schema mount-points do not work, you need to make a separate bind call
+ * @see _xml_parse   for a null-terminated string
+ * @see clicon_file_read
+ * @see clixon_xml_parse_cbuf
  */
 static int
-_xml_parse(clixon_handle h,
-           const char   *str,
-           yang_bind     yb,
-           yang_stmt    *yspec,
-           cxobj        *xt,
-           cxobj       **xerr)
+_xml_parse_buf(clixon_handle h,
+               char         *buf,
+               size_t        len,
+               int           copy,
+               yang_bind     yb,
+               yang_stmt    *yspec,
+               cxobj        *xt,
+               cxobj       **xerr)
 {
     int             retval = -1;
     clixon_xml_yacc xy = {0,};
@@ -869,28 +1052,52 @@ _xml_parse(clixon_handle h,
     int             ret;
     int             failed = 0; /* yang assignment */
     int             i;
+    char           *bufcopy = NULL;
+#ifdef HAVE_LIBPTHREAD
+    int             locked = 0;
+#endif
 
     if (clixon_debug_get() & CLIXON_DBG_DETAIL)
-        clixon_debug(CLIXON_DBG_PARSE | CLIXON_DBG_DETAIL, "%s", str);
+        clixon_debug(CLIXON_DBG_PARSE | CLIXON_DBG_DETAIL, "%s", buf);
     else
-        clixon_debug(CLIXON_DBG_PARSE & CLIXON_DBG_TRUNC, "%s", str);
-    if (strlen(str) == 0){
+        clixon_debug(CLIXON_DBG_PARSE & CLIXON_DBG_TRUNC, "%s", buf);
+    if (len == 0){
         return 1; /* OK */
     }
     if (xt == NULL){
         clixon_err(OE_XML, errno, "Unexpected NULL XML");
         return -1;
     }
-    if ((xy.xy_parse_string = strdup(str)) == NULL){
-        clixon_err(OE_XML, errno, "strdup");
-        return -1;
-    }
+    xy.xy_parse_string = buf;
+    xy.xy_parse_len = len;
     xy.xy_xtop = xt;
     xy.xy_xparent = xt;
-    if (clixon_xml_parsel_init(&xy) < 0)
-        goto done;
-    if (clixon_xml_parseparse(&xy) != 0)  /* yacc returns 1 on error */
+    ret = 0;
+    if (_xml_parse_fast &&
+        (ret = clixon_xml_parse_fast(&xy)) < 0)
         goto done;
+    if (ret == 0){
+        if (copy){ /* Scanner needs two null characters and may modify the buffer */
+            if ((bufcopy = malloc(len + 2)) == NULL){
+                clixon_err(OE_XML, errno, "malloc");
+                goto done;
+            }
+            memcpy(bufcopy, buf, len);
+            bufcopy[len] = '\0';
+            bufcopy[len+1] = '\0';
+            xy.xy_parse_string = bufcopy;
+        }
+#ifdef HAVE_LIBPTHREAD
+        if (xml_threads_get()){
+            pthread_mutex_lock(&_xml_parse_mutex);
+            locked = 1;
+        }
+#endif
+        if (clixon_xml_parsel_init(&xy) < 0)
+            goto done;
+        if (clixon_xml_parseparse(&xy) != 0)  /* yacc returns 1 on error */
+            goto done;
+    }
     /* Purge all top-level body objects */
     x = NULL;
     while ((x = xml_find_type(xt, NULL, "body", CX_BODY)) != NULL)
@@ -952,16 +1159,58 @@ _xml_parse(clixon_handle h,
  done:
     clixon_debug(CLIXON_DBG_PARSE | CLIXON_DBG_DETAIL, "retval:%d", retval);
     clixon_xml_parsel_exit(&xy);
-    if (xy.xy_parse_string != NULL)
-        free(xy.xy_parse_string);
+#ifdef HAVE_LIBPTHREAD
+    if (locked)
+        pthread_mutex_unlock(&_xml_parse_mutex);
+#endif
     if (xy.xy_xvec)
         free(xy.xy_xvec);
+    if (bufcopy)
+        free(bufcopy);
     return retval;
  fail: /* invalid */
     retval = 0;
     goto done;
 }
 
+/*! Common internal xml parsing function string to parse-tree
+ *
+ * Given a string containing XML, parse into existing XML tree and return
+ * @param[in]     h     Clixon handle sometimes NULL
+ * @param[in]     str   Pointer to string containing XML definition.
+ * @param[in]     yb    How to bind yang to XML top-level when parsing
+ * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
+ * @param[in,out] xtop  Top of XML parse tree. Assume created. Holds new tree.
+ * @param[out]    xerr  Reason for failure (yang assignment not made)
+ * @retval        1     Parse OK and all yang assignment made
+ * @retval        0     Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval       -1     Error
+ * @see clixon_xml_parse_file
+ * @see clixon_xml_parse_string
+ * @see _json_parse
+ * @note special case is empty XML where the parser is not invoked.
+ * It is questionable empty XML is legal. From https://www.w3.org/TR/2008/REC-xml-20081126 Sec 2.1:
+ *    A well-formed document ... contains one or more elements.
+ * But in clixon one can invoke a parser on a sub-part of a document where it makes sense to accept
+ * an empty XML. For example where an empty config: <config></config> is parsed.
+ * In other cases, such as receiving netconf ]]>]]> it should represent a complete document and
+ * therefore not well-formed.
+ * Therefore checking for empty XML must be done by a calling function which knows wether the
+ * the XML represents a full document or not.
+ * @note may be called recursively, some yang-bind (eg rpc) semantic checks may trigger error message
+ * @note yang-binding over schema mount-points do not work, you need to make a separate bind call
+ */
+static int
+_xml_parse(clixon_handle h,
+           const char   *str,
+           yang_bind     yb,
+           yang_stmt    *yspec,
+           cxobj        *xt,
+           cxobj       **xerr)
+{
+    return _xml_parse_buf(h, (char *)str, strlen(str), 1, yb, yspec, xt, xerr);
+}
+
 /*! Read an XML definition from file and parse it into a parse-tree, advanced API
  *
  * @param[in]     fd    A file descriptor containing the XML file (as ASCII characters)
@@ -995,17 +1244,11 @@ clixon_xml_parse_file(FILE      *fp,
                       cxobj    **xt,
                       cxobj    **xerr)
 {
-    int   retval = -1;
-    int   ret;
-    int   len = 0;
-    char  ch;
-    char *xmlbuf = NULL;
-    char *ptr;
-    int   xmlbuflen = BUFLEN; /* start size */
-    int   oldxmlbuflen;
-    int   failed = 0;
-    int   xtempty; /* empty on entry */
-    size_t sz;
+    int     retval = -1;
+    int     ret;
+    char   *xmlbuf = NULL;
+    size_t  len = 0;
+    int     xtempty; /* empty on entry */
 
     if (xt == NULL || fp == NULL){
         clixon_err(OE_XML, EINVAL, "arg is NULL");
@@ -1016,43 +1259,15 @@ clixon_xml_parse_file(FILE      *fp,
         clixon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
         return -1;
     }
-    if ((xmlbuf = malloc(xmlbuflen)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    /* Read whole file in blocks, parse buffer in place */
+    if (clicon_file_read(fp, &xmlbuf, &len) < 0)
         goto done;
-    }
-    memset(xmlbuf, 0, xmlbuflen);
-    ptr = xmlbuf;
-    while (1){
-        sz = fread(&ch, 1, 1, fp);
-        if (sz == 1){
-            xmlbuf[len++] = ch;
-        }
-        else if (sz == 0 && feof(fp)) {
-            if (*xt == NULL)
-                if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if ((ret = _xml_parse(NULL, ptr, yb, yspec, *xt, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        }
-        else {
-            clixon_err(OE_XML, 0, "fread %lu", sz);
+    if (*xt == NULL)
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
             goto done;
-        }
-        if (len >= xmlbuflen-1){ /* Space: one for the null character */
-            oldxmlbuflen = xmlbuflen;
-            xmlbuflen *= 2;
-            if ((xmlbuf = realloc(xmlbuf, xmlbuflen)) == NULL){
-                clixon_err(OE_XML, errno, "realloc");
-                goto done;
-            }
-            memset(xmlbuf+oldxmlbuflen, 0, xmlbuflen-oldxmlbuflen);
-            ptr = xmlbuf;
-        }
-    } /* while */
-    retval = (failed==0) ? 1 : 0;
+    if ((ret = _xml_parse_buf(NULL, xmlbuf, len, 0, yb, yspec, *xt, xerr)) < 0)
+        goto done;
+    retval = ret;
  done:
     if (retval < 0 && *xt && xtempty){
         free(*xt);
@@ -1114,6 +1329,54 @@ clixon_xml_parse_string1(clixon_handle h,
     return _xml_parse(h, str, yb, yspec, *xt, xerr);
 }
 
+/*! Read an XML definition from a cbuf and parse it in place into a parse-tree
+ *
+ * Same as clixon_xml_parse_string1 but the buffer of cb is scanned directly without
+ * copying it, eg a received NETCONF frame.
+ * @param[in]     h     Clixon handle sometimes NULL
+ * @param[in]     cb    CLIgen buffer containing XML. Content is undefined after the call
+ * @param[in]     yb    How to bind yang to XML top-level when parsing
+ * @param[in]     yspec Yang specification, or NULL
+ * @param[in,out] xt    Pointer to XML parse tree. If empty will be created.
+ * @param[out]    xerr  Reason for failure (yang assignment not made) if retval = 0
+ * @retval        1     Parse OK and all yang assignment made
+ * @retval        0     Parse OK but yang assigment not made (or only partial), xerr is set
+ * @retval       -1     Error
+ * @see clixon_xml_parse_string1
+ */
+int
+clixon_xml_parse_cbuf(clixon_handle h,
+                      cbuf         *cb,
+                      yang_bind     yb,
+                      yang_stmt    *yspec,
+                      cxobj       **xt,
+                      cxobj       **xerr)
+{
+    size_t len;
+
+    if (xt==NULL || cb == NULL){
+        clixon_err(OE_XML, EINVAL, "arg is NULL");
+        return -1;
+    }
+    if (yb == YB_MODULE && yspec == NULL){
+        clixon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
+        return -1;
+    }
+    if (*xt == NULL){
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            return -1;
+    }
+    /* The string may be terminated before the end of cb, eg an end-of-message trailer.
+     * Append a second null character after the string for the scanner */
+    len = strlen(cbuf_get(cb));
+    if (cbuf_trunc(cb, len) < 0 ||
+        cbuf_append(cb, '\0') < 0){
+        clixon_err(OE_XML, errno, "cbuf_append");
+        return -1;
+    }
+    return _xml_parse_buf(h, cbuf_get(cb), len, 0, yb, yspec, *xt, xerr);
+}
+
 /*! Read XML from var-arg list and parse it into xml tree
  *
  * Utility function using stdarg instead of static string.
@@ -1281,7 +1544,8 @@ xml_diff2cbuf_ordered_by_user(cbuf      *cb,
                               cxobj     *x0c,
                               cxobj     *x1c,
                               yang_stmt *yc,
-                              int        level)
+                              int        level,
+                              int        flag)
 {
     int    retval = 1;
     cxobj *xi;
@@ -1303,7 +1567,7 @@ xml_diff2cbuf_ordered_by_user(cbuf      *cb,
                 /* Unmark node in x0 and x1 */
                 xml_flag_reset(xi, XML_FLAG_DEL);
                 xml_flag_reset(xj, XML_FLAG_ADD);
-                if (xml_diff2cbuf(cb, xi, xj, level+1, 0) < 0)
+                if (xml_diff2cbuf(cb, xi, xj, level+1, 0, flag) < 0)
                     goto done;
                 break;
             }
@@ -1395,6 +1659,7 @@ xml_diff2cbuf_leaf(cbuf      *cb,
  * @param[in]  x1      Second XML tree
  * @param[in]  level   How many spaces to insert before each line
  * @param[in]  skiptop  0: Include top object 1: Skip top-object, only children,
+ * @param[in]  flag    If set, only descend into nodes of x1 marked with flag
  * @retval     0       Ok
  * @retval    -1       Error
  * @code
@@ -1414,7 +1679,8 @@ xml_diff2cbuf(cbuf  *cb,
               cxobj *x0,
               cxobj *x1,
               int    level,
-              int    skiptop)
+              int    skiptop,
+              int    flag)
 {
     int        retval = -1;
     cxobj     *x0c = NULL; /* x0 child */
@@ -1496,7 +1762,7 @@ xml_diff2cbuf(cbuf  *cb,
         b0 = xml_body(x0c);
         b1 = xml_body(x1c);
         if (eq && y0c && y1c && y0c == y1c && yang_find(y0c, Y_ORDERED_BY, "user")){
-            if (xml_diff2cbuf_ordered_by_user(cb, x0, x1, x0c, x1c, y0c, level) < 0)
+            if (xml_diff2cbuf_ordered_by_user(cb, x0, x1, x0c, x1c, y0c, level, flag) < 0)
                 goto done;
             /* Show all marked as DELETE as - entries
              */
@@ -1562,7 +1828,9 @@ xml_diff2cbuf(cbuf  *cb,
             /* xml-spec NULL could happen with anydata children for example,
              * if so, continute compare children but without yang
              */
-            if (y0c && y1c && y0c != y1c){ /* choice */
+            if (flag && xml_flag(x1c, flag) == 0)
+                ; /* Not marked: equal subtrees */
+            else if (y0c && y1c && y0c != y1c){ /* choice */
                 if (nr==0 && skiptop==0){
                     xml_diff_context(cb, x0, level1);
                     xml_diff_keys(cb, x0, y0, (level+1)*PRETTYPRINT_INDENT);
@@ -1590,7 +1858,7 @@ xml_diff2cbuf(cbuf  *cb,
                         goto done;
                 }
             }
-            else if (xml_diff2cbuf(cb, x0c, x1c, level+1, 0) < 0)
+            else if (xml_diff2cbuf(cb, x0c, x1c, level+1, 0, flag) < 0)
                 goto done;
 
         }
@@ -1630,5 +1898,524 @@ clixon_xml_diff2cbuf(cbuf  *cb,
                      cxobj *x0,
                      cxobj *x1)
 {
-    return xml_diff2cbuf(cb, x0, x1, 0, 1);
+    return xml_diff2cbuf(cb, x0, x1, 0, 1, 0);
+}
+
+/*! Print XML diff of two cxobj trees into a cbuf, where changes in the second are marked
+ *
+ * Same as clixon_xml_diff2cbuf but only descend into nodes of x1 that are marked with flag.
+ * Unmarked nodes of x1 are assumed to be equal to the corresponding nodes in x0.
+ * @param[out] cb      CLIgen buffer
+ * @param[in]  x0      First XML tree
+ * @param[in]  x1      Second XML tree, changed nodes and their ancestors marked with flag
+ * @param[in]  flag    Flag marking changed nodes in x1, eg XML_FLAG_EDIT
+ * @retval     0       Ok
+ * @retval    -1       Error
+ * @see xml_diff_marked
+ * @see xmldb_edit_marked
+ */
+int
+clixon_xml_diff2cbuf_marked(cbuf  *cb,
+                            cxobj *x0,
+                            cxobj *x1,
+                            int    flag)
+{
+    return xml_diff2cbuf(cb, x0, x1, 0, 1, flag);
+}
+
+/*------------------------------------------------------------------------
+ * Binary XML encoding, see CLICON_IPC_BINARY
+ * A compact encoding of XML trees used on the internal socket between backend and clients.
+ * The encoding is a header followed by a pre-order sequence of nodes:
+ *   element: XML_BIN_ELMNT <prefix> <name> ...children... XML_BIN_END
+ *   attribute: XML_BIN_ATTR <prefix> <name> <value>
+ *   body: XML_BIN_BODY <value>
+ * Names and prefixes are <ref>: a number 0 for no prefix, 2*i+2 for the i:th name of
+ * the message, or 2*len+1 followed by a new name of length len.
+ * Values are a number len followed by len bytes.
+ * Strings are followed by a filler byte that the decoder overwrites with a NUL, so that
+ * strings are used in place.
+ * Numbers are base-127 digits with least significant first, where a digit d is d+1 if it is
+ * the last digit, otherwise d+128.
+ * No byte is zero, so a message can be handled as a C string.
+ *------------------------------------------------------------------------*/
+
+#define XML_BIN_MAGIC     "\xff" "CXB" /* Header, not valid at start of any XML or UTF-8 text */
+#define XML_BIN_ELMNT     0x01
+#define XML_BIN_ATTR      0x02
+#define XML_BIN_BODY      0x03
+#define XML_BIN_END       0x04
+#define XML_BIN_FILLER    0xff
+#define XML_BIN_NAMES_MAX 4096   /* Names beyond this are written in full */
+
+/*! Binary XML encoder state
+ */
+struct clixon_xml_bin {
+    cbuf           *xb_cb;     /* Output buffer */
+    clicon_hash_t  *xb_names;  /* Name -> index in message */
+    uint32_t        xb_nnames; /* Number of names in message */
+    struct xml2cbuf_flush xb_flush; /* Flush, if xf_fn set */
+};
+
+/*! Append a number to binary XML
+ */
+static void
+xml_bin_num(cbuf  *cb,
+            size_t n)
+{
+    while (n >= 127){
+        cbuf_append(cb, (int)(n % 127) + 128);
+        n /= 127;
+    }
+    cbuf_append(cb, (int)n + 1);
+}
+
+/*! Append a value string to binary XML
+ */
+static void
+xml_bin_value(cbuf       *cb,
+              const char *val)
+{
+    size_t len = strlen(val);
+
+    xml_bin_num(cb, len);
+    cbuf_append_buf(cb, (void *)val, len);
+    cbuf_append(cb, XML_BIN_FILLER);
+}
+
+/*! Append a name or prefix to binary XML, as reference if written before in the message
+ */
+static int
+xml_bin_name(clixon_xml_bin *xb,
+             const char     *name)
+{
+    int       retval = -1;
+    uint32_t *ip;
+    size_t    len;
+
+    if (name == NULL){
+        xml_bin_num(xb->xb_cb, 0);
+        goto ok;
+    }
+    if ((ip = clicon_hash_value(xb->xb_names, name, NULL)) != NULL){
+        xml_bin_num(xb->xb_cb, 2*(size_t)*ip + 2);
+        goto ok;
+    }
+    len = strlen(name);
+    xml_bin_num(xb->xb_cb, 2*len + 1);
+    cbuf_append_buf(xb->xb_cb, (void *)name, len);
+    cbuf_append(xb->xb_cb, XML_BIN_FILLER);
+    if (xb->xb_nnames < XML_BIN_NAMES_MAX){
+        if (clicon_hash_add(xb->xb_names, name, &xb->xb_nnames, sizeof(xb->xb_nnames)) == NULL)
+            goto done;
+        xb->xb_nnames++;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Create binary XML encoder and write header to buffer
+ *
+ * @param[in]  cb   Output buffer
+ * @retval     xb   Binary XML encoder, free with clixon_xml_bin_free
+ * @retval     NULL Error
+ * @code
+ *   if ((xb = clixon_xml_bin_new(cb)) == NULL)
+ *      err;
+ *   if (clixon_xml_bin_element(xb, NULL, "rpc-reply", NETCONF_BASE_NAMESPACE) < 0)
+ *      err;
+ *   if (clixon_xml2bin_filter(xb, xt, -1, 1, WITHDEFAULTS_REPORT_ALL, NULL, NULL) < 0)
+ *      err;
+ *   clixon_xml_bin_end(xb);
+ *   clixon_xml_bin_free(xb);
+ * @endcode
+ */
+clixon_xml_bin *
+clixon_xml_bin_new(cbuf *cb)
+{
+    clixon_xml_bin *xb = NULL;
+
+    if ((xb = malloc(sizeof(*xb))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xb, 0, sizeof(*xb));
+    xb->xb_cb = cb;
+    if ((xb->xb_names = clicon_hash_init()) == NULL){
+        free(xb);
+        xb = NULL;
+        goto done;
+    }
+    cbuf_append_str(cb, XML_BIN_MAGIC);
+ done:
+    return xb;
+}
+
+/*! Free binary XML encoder
+ *
+ * @param[in]  xb   Binary XML encoder
+ */
+void
+clixon_xml_bin_free(clixon_xml_bin *xb)
+{
+    if (xb->xb_names)
+        clicon_hash_free(xb->xb_names);
+    free(xb);
+}
+
+/*! Flush encoded data while encoding, see clixon_xml2cbuf_stream
+ *
+ * @param[in]  xb       Binary XML encoder
+ * @param[in]  limit    Flush buffer when it has reached this length
+ * @param[in]  flushfn  Flush function, should write and reset buffer
+ * @param[in]  flusharg Argument to flush function
+ */
+void
+clixon_xml_bin_flush_set(clixon_xml_bin        *xb,
+                         size_t                 limit,
+                         clixon_output_flush_t *flushfn,
+                         void                  *flusharg)
+{
+    xb->xb_flush.xf_limit = limit;
+    xb->xb_flush.xf_fn = flushfn;
+    xb->xb_flush.xf_arg = flusharg;
+}
+
+/*! Start an element in binary XML, end with clixon_xml_bin_end
+ *
+ * @param[in]  xb      Binary XML encoder
+ * @param[in]  prefix  Prefix of element, or NULL
+ * @param[in]  name    Name of element
+ * @param[in]  ns      Default namespace of element, or NULL
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+clixon_xml_bin_element(clixon_xml_bin *xb,
+                       const char     *prefix,
+                       const char     *name,
+                       const char     *ns)
+{
+    int retval = -1;
+
+    cbuf_append(xb->xb_cb, XML_BIN_ELMNT);
+    if (xml_bin_name(xb, prefix) < 0 ||
+        xml_bin_name(xb, name) < 0)
+        goto done;
+    if (ns){
+        cbuf_append(xb->xb_cb, XML_BIN_ATTR);
+        if (xml_bin_name(xb, NULL) < 0 ||
+            xml_bin_name(xb, "xmlns") < 0)
+            goto done;
+        xml_bin_value(xb->xb_cb, ns);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! End an element in binary XML
+ *
+ * @param[in]  xb      Binary XML encoder
+ */
+void
+clixon_xml_bin_end(clixon_xml_bin *xb)
+{
+    cbuf_append(xb->xb_cb, XML_BIN_END);
+}
+
+/*! Internal: encode XML tree in binary XML
+ *
+ * Same selection of nodes as xml2cbuf_recurse
+ * @param[in]  xb     Binary XML encoder
+ * @param[in]  x      XML tree
+ * @param[in]  depth  Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]  wdef   With-defaults parameter, except WITHDEFAULTS_REPORT_ALL_TAGGED
+ * @param[in]  fn     Filter function for elements, or NULL for all
+ * @param[in]  arg    Argument to filter function
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xml2cbuf_recurse
+ */
+static int
+xml2bin_recurse(clixon_xml_bin      *xb,
+                cxobj               *x,
+                int32_t              depth,
+                withdefaults_type    wdef,
+                xml_output_filter_t *fn,
+                void                *arg)
+{
+    int    retval = -1;
+    cbuf  *cb = xb->xb_cb;
+    cxobj *xc;
+    char  *val;
+    int    ret;
+
+    if (depth == 0)
+        goto ok;
+    if (fn && xml_type(x) == CX_ELMNT){
+        if ((ret = fn(x, arg)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+        if (ret == 2) /* Encode whole sub-tree */
+            fn = NULL;
+    }
+    if (xml_sort_ensure(x) < 0)
+        goto done;
+    if (xml_spec(x) != NULL){
+        if ((ret = xml2output_wdef(x, wdef, NULL)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
+    switch(xml_type(x)){
+    case CX_BODY:
+        /* As text, empty bodies are not parsed */
+        if ((val = xml_value(x)) == NULL || *val == '\0')
+            break;
+        cbuf_append(cb, XML_BIN_BODY);
+        xml_bin_value(cb, val);
+        break;
+    case CX_ATTR:
+        cbuf_append(cb, XML_BIN_ATTR);
+        if (xml_bin_name(xb, xml_prefix(x)) < 0 ||
+            xml_bin_name(xb, xml_name(x)) < 0)
+            goto done;
+        xml_bin_value(cb, (val = xml_value(x)) != NULL ? val : "");
+        break;
+    case CX_ELMNT:
+        if (xb->xb_flush.xf_fn && cbuf_len(cb) >= xb->xb_flush.xf_limit){
+            if (xb->xb_flush.xf_fn(cb, xb->xb_flush.xf_arg) < 0)
+                goto done;
+        }
+        if (clixon_xml_bin_element(xb, xml_prefix(x), xml_name(x), NULL) < 0)
+            goto done;
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ATTR)) != NULL)
+            if (xml2bin_recurse(xb, xc, -1, wdef, NULL, NULL) < 0)
+                goto done;
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, -1)) != NULL)
+            if (xml_type(xc) != CX_ATTR &&
+                xml2bin_recurse(xb, xc, depth-1, wdef, fn, arg) < 0)
+                goto done;
+        clixon_xml_bin_end(xb);
+        break;
+    default:
+        break;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Encode a filtered XML tree in binary XML
+ *
+ * Same as clixon_xml2cbuf_filter but binary encoded
+ * @param[in]  xb      Binary XML encoder
+ * @param[in]  xn      Top-level xml object
+ * @param[in]  depth   Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]  skiptop 0: Include top object 1: Skip top-object, only children,
+ * @param[in]  wdef    With-defaults parameter, except WITHDEFAULTS_REPORT_ALL_TAGGED
+ * @param[in]  fn      Filter function, or NULL for all
+ * @param[in]  arg     Argument to filter function
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clixon_xml2cbuf_filter
+ */
+int
+clixon_xml2bin_filter(clixon_xml_bin      *xb,
+                      cxobj               *xn,
+                      int32_t              depth,
+                      int                  skiptop,
+                      withdefaults_type    wdef,
+                      xml_output_filter_t *fn,
+                      void                *arg)
+{
+    int    retval = -1;
+    cxobj *xc;
+
+    if (wdef == WITHDEFAULTS_REPORT_ALL_TAGGED){
+        clixon_err(OE_XML, EINVAL, "Tagged with-defaults not supported in binary XML");
+        goto done;
+    }
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
+            if (xml2bin_recurse(xb, xc, depth, wdef, fn, arg) < 0)
+                goto done;
+    }
+    else {
+        if (xml2bin_recurse(xb, xn, depth, wdef, fn, arg) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Read a number from binary XML
+ *
+ * @retval  p     Pointer after number
+ * @retval  NULL  Malformed
+ */
+static char *
+xml_bin_num_get(char   *p,
+                char   *end,
+                size_t *np)
+{
+    size_t n = 0;
+    size_t m = 1;
+    int    d;
+
+    while (p < end){
+        d = (unsigned char)*p++;
+        if (d == 0)
+            break;
+        if (d < 128){
+            *np = n + (d - 1) * m;
+            return p;
+        }
+        n += (d - 128) * m;
+        if ((m *= 127) > SIZE_MAX/127)
+            break;
+    }
+    return NULL;
+}
+
+/*! Read a string of known length from binary XML and NUL-terminate it in place
+ */
+static char *
+xml_bin_str_get(char   *p,
+                char   *end,
+                size_t  len,
+                char  **strp)
+{
+    if (len >= (size_t)(end - p) || (unsigned char)p[len] != XML_BIN_FILLER)
+        return NULL;
+    p[len] = '\0';
+    *strp = p;
+    return p + len + 1;
+}
+
+/*! Parse binary XML from a buffer in place
+ *
+ * The buffer is modified and its content is undefined after the call
+ * @param[in]  buf   Buffer, possibly binary XML
+ * @param[in]  len   Length of buffer
+ * @param[out] xt    XML top node with parsed tree as children, must be freed with xml_free
+ * @retval     1     OK, xt set
+ * @retval     0     Not binary XML, parse as XML text
+ * @retval    -1     Error, eg malformed
+ * @see clixon_xml_bin_new
+ */
+int
+clixon_xml_parse_bin(char   *buf,
+                     size_t  len,
+                     cxobj **xt)
+{
+    int     retval = -1;
+    char   *p = buf;
+    char   *end = buf + len;
+    cxobj  *xtop = NULL;
+    cxobj  *xp;
+    cxobj  *x;
+    char  **names = NULL;
+    size_t  nnames = 0;
+    char   *str[3];
+    size_t  n;
+    int     type;
+    int     i;
+    int     nstr;
+
+    if (len < strlen(XML_BIN_MAGIC) ||
+        memcmp(buf, XML_BIN_MAGIC, strlen(XML_BIN_MAGIC)) != 0)
+        goto notbin;
+    p += strlen(XML_BIN_MAGIC);
+    if ((names = malloc(XML_BIN_NAMES_MAX * sizeof(*names))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    if ((xtop = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    xp = xtop;
+    while (p < end){
+        type = (unsigned char)*p++;
+        switch (type){
+        case XML_BIN_ELMNT:
+        case XML_BIN_ATTR:
+            nstr = (type == XML_BIN_ATTR) ? 3 : 2;
+            for (i=0; i<nstr; i++){
+                if ((p = xml_bin_num_get(p, end, &n)) == NULL)
+                    goto malformed;
+                if (i == 2){ /* value */
+                    if ((p = xml_bin_str_get(p, end, n, &str[i])) == NULL)
+                        goto malformed;
+                }
+                else if (n == 0) /* no prefix */
+                    str[i] = NULL;
+                else if (n % 2 == 0){ /* reference */
+                    if (n/2 - 1 >= nnames)
+                        goto malformed;
+                    str[i] = names[n/2 - 1];
+                }
+                else {
+                    if ((p = xml_bin_str_get(p, end, n/2, &str[i])) == NULL)
+                        goto malformed;
+                    if (nnames < XML_BIN_NAMES_MAX)
+                        names[nnames++] = str[i];
+                }
+            }
+            if (str[1] == NULL)
+                goto malformed;
+            if ((x = xml_new(str[1], xp, type == XML_BIN_ATTR ? CX_ATTR : CX_ELMNT)) == NULL)
+                goto done;
+            if (str[0] && xml_prefix_set(x, str[0]) < 0)
+                goto done;
+            if (type == XML_BIN_ATTR){
+                if (xml_value_set(x, str[2]) < 0)
+                    goto done;
+            }
+            else
+                xp = x;
+            break;
+        case XML_BIN_BODY:
+            if ((p = xml_bin_num_get(p, end, &n)) == NULL ||
+                (p = xml_bin_str_get(p, end, n, &str[0])) == NULL)
+                goto malformed;
+            if ((x = xml_new("body", xp, CX_BODY)) == NULL)
+                goto done;
+            if (xml_value_set(x, str[0]) < 0)
+                goto done;
+            break;
+        case XML_BIN_END:
+            if (xp == xtop)
+                goto malformed;
+            xp = xml_parent(xp);
+            break;
+        default:
+            goto malformed;
+        }
+    }
+    if (xp != xtop)
+        goto malformed;
+    *xt = xtop;
+    xtop = NULL;
+    retval = 1;
+ done:
+    if (names)
+        free(names);
+    if (xtop)
+        xml_free(xtop);
+    return retval;
+ notbin:
+    retval = 0;
+    goto done;
+ malformed:
+    clixon_err(OE_XML, EBADMSG, "Malformed binary XML");
+    goto done;
 }
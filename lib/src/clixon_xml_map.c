@@ -74,6 +74,7 @@
 #include "clixon_xml_nsctx.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_profile.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_sort.h"
 #include "clixon_yang_type.h"
@@ -81,6 +82,14 @@
 #include "clixon_xml_io.h"
 #include "clixon_xml_map.h"
 
+#ifdef XML_MERGE_JOIN
+/* Minimum number of children of the modification tree for merge-join */
+#define XML_MERGE_JOIN_MIN 16
+/* Max number of base children per modification child for merge-join, otherwise a binary
+ * search per child is cheaper than walking all base children */
+#define XML_MERGE_JOIN_RATIO 8
+#endif
+
 /* Local types 
  */
 /* Merge code needs a two-phase pass where objects subject to merge are first checked for,
@@ -93,8 +102,9 @@ typedef struct  {
     yang_stmt *mt_yc;
 } merge_twophase;
 
-/* Forward declaration */
-static int xml_diff1(cxobj *x0, cxobj *x1, cxobj ***x0vec, int *x0veclen,
+/* Forward declarations */
+static int xml_merge1(cxobj *x0, yang_stmt *y0, cxobj *x0p, cxobj *x1, char **reason);
+static int xml_diff1(cxobj *x0, cxobj *x1, int flag, cxobj ***x0vec, int *x0veclen,
                      cxobj ***x1vec, int *x1veclen,
                      cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen);
 
@@ -324,6 +334,7 @@ xml_diff_ordered_by_user(cxobj     *x0,
  *
  * @param[in]  x0         First XML tree
  * @param[in]  x1         Second XML tree
+ * @param[in]  flag       If set, only compare nodes in x1 marked with flag, others are equal
  * @param[out] x0vec      Pointervector to XML nodes existing in only first tree
  * @param[out] x0veclen   Length of first vector
  * @param[out] x1vec      Pointervector to XML nodes existing in only second tree
@@ -356,6 +367,7 @@ xml_diff_ordered_by_user(cxobj     *x0,
 static int
 xml_diff1(cxobj     *x0,
           cxobj     *x1,
+          int        flag,
           cxobj   ***x0vec,
           int       *x0veclen,
           cxobj   ***x1vec,
@@ -376,6 +388,9 @@ xml_diff1(cxobj     *x0,
     cxobj     *xj;
     int        extflag;
 
+    if (xml_sort_ensure(x0) < 0 ||
+        xml_sort_ensure(x1) < 0)
+        goto done;
     /* Traverse x0 and x1 in lock-step */
     x0c = x1c = NULL;
     x0c = xml_child_each(x0, x0c, CX_ELMNT);
@@ -476,7 +491,9 @@ xml_diff1(cxobj     *x0,
             /* xml-spec NULL could happen with anydata children for example,
              * if so, continute compare children but without yang
              */
-            if (y0c && y1c && y0c != y1c){ /* choice */
+            if (flag && xml_flag(x1c, flag) == 0)
+                ; /* Not marked, unchanged */
+            else if (y0c && y1c && y0c != y1c){ /* choice */
                 if (cxvec_append(x0c, x0vec, x0veclen) < 0)
                     goto done;
                 if (cxvec_append(x1c, x1vec, x1veclen) < 0)
@@ -498,7 +515,7 @@ xml_diff1(cxobj     *x0,
                         goto done;
                 }
             }
-            else if (xml_diff1(x0c, x1c,
+            else if (xml_diff1(x0c, x1c, flag,
                                x0vec, x0veclen,
                                x1vec, x1veclen,
                                changed_x0, changed_x1, changedlen)< 0)
@@ -558,7 +575,7 @@ xml_diff(cxobj     *x0,
             goto done;
         goto ok;
     }
-    if (xml_diff1(x0, x1,
+    if (xml_diff1(x0, x1, 0,
                   first, firstlen,
                   second, secondlen,
                   changed_x0, changed_x1, changedlen) < 0)
@@ -569,6 +586,56 @@ xml_diff(cxobj     *x0,
     return retval;
 }
 
+/*! Compute differences between two xml trees, where changes in the second are marked
+ *
+ * Same as xml_diff but only descend into nodes of x1 that are marked with flag. Unmarked
+ * nodes of x1 are assumed to be equal to the corresponding nodes in x0.
+ * Thereby the cost is proportional to the marked part of x1, not to the whole trees.
+ * @param[in]  x0         First XML tree
+ * @param[in]  x1         Second XML tree, changed nodes and their ancestors marked with flag
+ * @param[in]  flag       Flag marking changed nodes in x1, eg XML_FLAG_EDIT
+ * @param[out] first      Pointervector to XML nodes existing in only first tree
+ * @param[out] firstlen   Length of first vector
+ * @param[out] second     Pointervector to XML nodes existing in only second tree
+ * @param[out] secondlen  Length of second vector
+ * @param[out] changed_x0 Pointervector to XML nodes changed orig value
+ * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
+ * @param[out] changedlen Length of changed vector
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see xml_diff
+ * @see xmldb_edit_marked
+ */
+int
+xml_diff_marked(cxobj     *x0,
+                cxobj     *x1,
+                int        flag,
+                cxobj   ***first,
+                int       *firstlen,
+                cxobj   ***second,
+                int       *secondlen,
+                cxobj   ***changed_x0,
+                cxobj   ***changed_x1,
+                int       *changedlen)
+{
+    int retval = -1;
+
+    *firstlen = 0;
+    *secondlen = 0;
+    *changedlen = 0;
+    if (x0 == NULL || x1 == NULL)
+        return xml_diff(x0, x1, first, firstlen, second, secondlen,
+                        changed_x0, changed_x1, changedlen);
+    if (xml_diff1(x0, x1, flag,
+                  first, firstlen,
+                  second, secondlen,
+                  changed_x0, changed_x1, changedlen) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Compute if two XML trees are equal or not
  *
  * @param[in]  x0   First XML tree
@@ -593,6 +660,9 @@ xml_tree_equal(cxobj *x0,
     cxobj     *x1c; /* x1 child */
     int        extflag = 0;
 
+    if (xml_sort_ensure(x0) < 0 ||
+        xml_sort_ensure(x1) < 0)
+        goto done;
     /* Traverse x0 and x1 in lock-step */
     x0c = x1c = NULL;
     x0c = xml_child_each(x0, x0c, CX_ELMNT);
@@ -1284,6 +1354,168 @@ assign_namespace_body(cxobj *x0, /* source */
     return retval;
 }
 
+/*! Ensure namespaces of a moved node are declared in its new position
+ *
+ * @param[in]  x1   XML node moved to a new parent
+ * @param[in]  nsc  Namespace context of x1 in its old position
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_merge_nsfix(cxobj *x1,
+                cvec  *nsc)
+{
+    int     retval = -1;
+    cg_var *cv;
+    char   *ns;
+    char   *px;
+    char   *pxe;
+    int     ret;
+
+    cv = NULL;
+    while ((cv = cvec_each(nsc, cv)) != NULL){
+        px = cv_name_get(cv);
+        ns = cv_string_get(cv);
+        /* Check if namespace exists */
+        if ((ret = xml2prefix(x1, ns, &pxe)) < 0)
+            goto done;
+        if (ret == 0 ||  /* Not exist */
+            clicon_strcmp(px, pxe) != 0){ /* Exists and not equal (can be NULL) */
+            if (xmlns_set(x1, px, ns) < 0)
+                goto done;
+            xml_sort(x1);
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+#ifdef XML_MERGE_JOIN
+/*! Check if element children of x are in strict sorted order, and can be merge-joined
+ *
+ * All element children need a yang spec and no two siblings may compare equal, which
+ * excludes keyless lists, duplicates and (in most cases) ordered-by user lists
+ * @param[in]  x   XML node
+ * @retval     1   Children are in strict order
+ * @retval     0   Not in strict order
+ */
+static int
+xml_merge_ordered(cxobj *x)
+{
+    cxobj *xc = NULL;
+    cxobj *xprev = NULL;
+
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+        if (xml_spec(xc) == NULL)
+            return 0;
+        if (xprev && xml_cmp(xprev, xc, 0, 0, NULL) >= 0)
+            return 0;
+        xprev = xc;
+    }
+    return 1;
+}
+
+/*! Check if children of x0 and x1 can be merge-joined in xml_merge1
+ *
+ * @param[in]  x0  Base xml node
+ * @param[in]  x1  Modification xml node
+ * @retval     1   Yes, use merge-join
+ * @retval     0   No, use a binary search per child
+ * @retval    -1   Error
+ */
+static int
+xml_merge_join_p(cxobj *x0,
+                 cxobj *x1)
+{
+    int n1;
+
+    n1 = xml_child_nr(x1);
+    if (n1 < XML_MERGE_JOIN_MIN ||
+        xml_child_nr(x0) > XML_MERGE_JOIN_RATIO * n1)
+        return 0;
+    if (xml_sort_ensure(x0) < 0)
+        return -1;
+    return xml_merge_ordered(x0) && xml_merge_ordered(x1);
+}
+
+/*! Second phase of merge-join: merge matched children and move new children
+ *
+ * Matched children are merged recursively. New children are detached from x1 in order, so
+ * that a single forward scan finds them, appended to x0, and then merged into place with
+ * one xml_sort_merge.
+ * @param[in]  x0       Base xml node
+ * @param[in]  x1       Modification xml node
+ * @param[in]  twophase Children matched in the first phase, in x1 order
+ * @param[in]  len      Length of twophase
+ * @param[out] reason   If retval=0 a malloced string
+ * @retval     1        OK
+ * @retval     0        Yang error, reason is set
+ * @retval    -1        Error
+ */
+static int
+xml_merge_join(cxobj          *x0,
+               cxobj          *x1,
+               merge_twophase *twophase,
+               int             len,
+               char          **reason)
+{
+    int    retval = -1;
+    cxobj *x1c;
+    cvec  *nsc = NULL;
+    int    start;
+    int    i;
+    int    k;
+    int    ret;
+
+    for (i=0; i<len; i++){
+        if (twophase[i].mt_x0c == NULL)
+            continue;
+        if ((ret = xml_merge1(twophase[i].mt_x0c,
+                              twophase[i].mt_yc,
+                              x0,
+                              twophase[i].mt_x1c,
+                              reason)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    start = xml_child_nr(x0);
+    k = 0;
+    for (i=0; i<len; i++){
+        if (twophase[i].mt_x0c != NULL)
+            continue;
+        x1c = twophase[i].mt_x1c;
+        while (k < xml_child_nr(x1) && xml_child_i(x1, k) != x1c)
+            k++;
+        if (k == xml_child_nr(x1)){
+            clixon_err(OE_XML, 0, "Merge child %s not found", xml_name(x1c));
+            goto done;
+        }
+        if (xml_nsctx_node(x1c, &nsc) < 0)
+            goto done;
+        if (xml_child_rm(x1, k) < 0)
+            goto done;
+        if (xml_addsub(x0, x1c) < 0)
+            goto done;
+        if (xml_merge_nsfix(x1c, nsc) < 0)
+            goto done;
+        cvec_free(nsc);
+        nsc = NULL;
+    }
+    if (xml_sort_merge(x0, start) < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (nsc)
+        cvec_free(nsc);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+#endif /* XML_MERGE_JOIN */
+
 /*! Merge a base tree x0 with x1 with yang spec y
  *
  * @param[in]  x0  Base xml tree (can be NULL in add scenarios)
@@ -1316,10 +1548,10 @@ xml_merge1(cxobj              *x0,  /* the target */
     merge_twophase *twophase = NULL;
     int             twophase_len;
     cvec           *nsc = NULL;
-    cg_var         *cv;
-    char           *ns;
-    char           *px;
-    char           *pxe;
+#ifdef XML_MERGE_JOIN
+    int             join;
+    cxobj          *x0j = NULL; /* Join cursor in base children */
+#endif
 
     if (x1 == NULL || xml_type(x1) != CX_ELMNT || y0 == NULL){
         clixon_err(OE_XML, EINVAL, "x1 is NULL or not XML element, or lacks yang spec");
@@ -1338,20 +1570,8 @@ xml_merge1(cxobj              *x0,  /* the target */
         else
             if (xml_insert(x0p, x1, INS_LAST, NULL, NULL) < 0)
                 goto done;
-        cv = NULL;
-        while ((cv = cvec_each(nsc, cv)) != NULL){
-            px = cv_name_get(cv);
-            ns = cv_string_get(cv);
-            /* Check if namespace exists */
-            if ((ret = xml2prefix(x1, ns, &pxe)) < 0)
-                goto done;
-            if (ret == 0 ||  /* Not exist */
-                clicon_strcmp(px, pxe) != 0){ /* Exists and not equal (can be NULL) */
-                if (xmlns_set(x1, px, ns) < 0)
-                    goto done;
-                xml_sort(x1);
-            }
-        }
+        if (xml_merge_nsfix(x1, nsc) < 0)
+            goto done;
         goto ok;
     }
     if (yang_keyword_get(y0) == Y_LEAF_LIST || yang_keyword_get(y0) == Y_LEAF){
@@ -1378,6 +1598,12 @@ xml_merge1(cxobj              *x0,  /* the target */
             clixon_err(OE_UNIX, errno, "calloc");
             goto done;
         }
+#ifdef XML_MERGE_JOIN
+        if ((join = xml_merge_join_p(x0, x1)) < 0)
+            goto done;
+        if (join)
+            x0j = xml_child_each(x0, NULL, CX_ELMNT);
+#endif
         i = 0;
         /* Loop through children of the modification tree */
         x1c = NULL;
@@ -1416,6 +1642,16 @@ xml_merge1(cxobj              *x0,  /* the target */
             }
             /* See if there is a corresponding node in the base tree */
             x0c = NULL;
+#ifdef XML_MERGE_JOIN
+            if (join && xml_spec(x1c) == yc){
+                /* Both in order: advance base cursor past smaller children */
+                while (x0j && (ret = xml_cmp(x0j, x1c, 0, 0, NULL)) < 0)
+                    x0j = xml_child_each(x0, x0j, CX_ELMNT);
+                if (x0j && ret == 0)
+                    x0c = x0j;
+            }
+            else
+#endif
             if (yc && match_base_child(x0, x1c, yc, &x0c) < 0)
                 goto done;
             /* If x0 already has a value, do not replace it with a default value in x1 */
@@ -1430,6 +1666,15 @@ xml_merge1(cxobj              *x0,  /* the target */
             i++;
         } /* while */
         twophase_len = i; /* Inital length included non-elements */
+#ifdef XML_MERGE_JOIN
+        if (join){
+            if ((ret = xml_merge_join(x0, x1, twophase, twophase_len, reason)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        else
+#endif
         /* Second run where actual merging is done 
          * Loop through children of the modification tree */
         for (i=0; i<twophase_len; i++){
@@ -1587,12 +1832,22 @@ yang_valstr2enum(yang_stmt *ytype,
     int        retval = -1;
     yang_stmt *yenum;
     yang_stmt *yval;
+    int32_t    v;
     int        inext;
 
     if (enumstr == NULL){
         clixon_err(OE_UNIX, EINVAL, "str is NULL");
         goto done;
     }
+    /* Lookup by value, explicit value must match since implicit values may collide */
+    if (parse_int32(valstr, &v, NULL) == 1 &&
+        (yenum = yang_enum_find_value(ytype, v)) != NULL &&
+        (yval = yang_find(yenum, Y_VALUE, NULL)) != NULL &&
+        strcmp(yang_argument_get(yval), valstr) == 0){
+        *enumstr = yang_argument_get(yenum);
+        retval = 0;
+        goto done;
+    }
     inext = 0;
     while ((yenum = yn_iter(ytype, &inext)) != NULL) {
         if ((yval = yang_find(yenum, Y_VALUE, NULL)) == NULL)
@@ -1631,7 +1886,7 @@ yang_enum2valstr(yang_stmt *ytype,
         clixon_err(OE_UNIX, EINVAL, "valstr is NULL");
         goto done;
     }
-    if ((yenum = yang_find(ytype, Y_ENUM, enumstr)) == NULL)
+    if ((yenum = yang_enum_find(ytype, enumstr)) == NULL)
         goto fail;
     /* Should assign value if yval not found */
     if ((yval = yang_find(yenum, Y_VALUE, NULL)) == NULL)
@@ -1667,7 +1922,7 @@ yang_enum2int(yang_stmt *ytype,
         clixon_err(OE_UNIX, EINVAL, "val is NULL");
         goto done;
     }
-    if ((yenum = yang_find(ytype, Y_ENUM, enumstr)) == NULL){
+    if ((yenum = yang_enum_find(ytype, enumstr)) == NULL){
         clixon_err(OE_YANG, 0, "No such enum %s", enumstr);
         goto done;
     }
@@ -2136,6 +2391,43 @@ xml_copy_marked(cxobj *x0,
     return retval;
 }
 
+/*! Output filter for XML tree with marked nodes, same nodes as copied by xml_copy_marked
+ *
+ * Nodes marked with XML_FLAG_MARK are printed with their whole sub-tree, nodes marked with
+ * XML_FLAG_CHANGE are printed and filtered, and key nodes of printed lists are printed.
+ * @param[in]   x    XML element
+ * @param[in]   arg  Not used
+ * @retval      2    Print sub-tree
+ * @retval      1    Print element and filter its children
+ * @retval      0    Skip element
+ * @retval     -1    Error
+ * @see clixon_xml2cbuf_filter
+ * @see xml_copy_marked
+ */
+int
+xml_marked_filter(cxobj *x,
+                  void  *arg)
+{
+    cxobj     *xp;
+    yang_stmt *yp;
+    int        iskey;
+
+    if (xml_flag(x, XML_FLAG_MARK))
+        return 2;
+    if (xml_flag(x, XML_FLAG_CHANGE))
+        return 1;
+    if ((xp = xml_parent(x)) != NULL &&
+        xml_flag(xp, XML_FLAG_CHANGE) &&
+        (yp = xml_spec(xp)) != NULL &&
+        yang_keyword_get(yp) == Y_LIST){
+        if ((iskey = yang_key_match(yp, xml_name(x), NULL)) < 0)
+            return -1;
+        if (iskey)
+            return 2;
+    }
+    return 0;
+}
+
 /*! Check when condition 
  * 
  * @param[in]   xn     XML node, can be NULL, in which case it is added as dummy under xp
@@ -2164,14 +2456,21 @@ yang_check_when_xpath(cxobj        *xn,
     int        nr = 0;
     cvec      *nsc = NULL;
     int        variant = 0;   /* ugly help variable to clean temporary object */
+    yang_stmt *yorig = NULL;  /* when statement, origin of XPath profile */
+#ifdef XPATH_PARSE_CACHE
+    yang_stmt  *ywhen = NULL; /* when sub-statement with precompiled xpath */
+    xpath_tree *xpt;
+#endif
 
     if (yang_when_canonical_xpath_get(yn, &xpath, &nsc) < 0)
         goto done;
     if (xpath != NULL){
         x = xp;
         *hit = 1;
+        yorig = yang_when_get(NULL, yn);
     }
     else if ((yc = yang_find(yn, Y_WHEN, NULL)) != NULL){
+        yorig = yc;
         /* "when" has xpath argument */
         if ((xpath = strdup(yang_argument_get(yc))) == NULL){
             clixon_err(OE_UNIX, errno, "strdup");
@@ -2189,11 +2488,26 @@ yang_check_when_xpath(cxobj        *xn,
         if (xml_nsctx_yang(yn, &nsc) < 0)
             goto done;
         *hit = 1;
+#ifdef XPATH_PARSE_CACHE
+        ywhen = yc;
+#endif
     }
     else
         *hit = 0;
     if (x && xpath){
-        if ((nr = xpath_vec_bool(x, nsc, "%s", xpath)) < 0)
+        yorig = xpath_profile_origin(yorig);
+#ifdef XPATH_PARSE_CACHE
+        if (ywhen){
+            if ((xpt = yang_xpath_get(ywhen)) == NULL)
+                nr = -1;
+            else
+                nr = xpath_vec_bool_tree(x, nsc, xpt);
+        }
+        else
+#endif
+        nr = xpath_vec_bool(x, nsc, "%s", xpath);
+        xpath_profile_origin(yorig);
+        if (nr < 0)
             goto done;
     }
     if (nrp)
@@ -2244,6 +2558,12 @@ yang_xml_mandatory(cxobj     *xt,
     int           nr;
     int           inext;
 
+    /* Not mandatory regardless of when conditions, see YANG_SCHEMA_SUMMARY */
+    if (yang_mandatory_maybe(ys) == 0)
+        return 0;
+    /* Mandatory without when conditions, no dummy node needed */
+    if (yang_when_maybe(ys) == 0)
+        return 1;
     /* Create dummy xs if not exist */
     if ((xs = xml_new(yang_argument_get(ys), xt, CX_ELMNT)) == NULL)
         goto done;
@@ -2273,7 +2593,7 @@ yang_xml_mandatory(cxobj     *xt,
     else if (keyw == Y_CONTAINER &&
              yang_find(ys, Y_PRESENCE, NULL) == NULL){
         inext = 0;
-        while ((yc = yn_iter(ys, &inext)) != NULL) {
+        while ((yc = yang_mandatory_each(ys, &inext)) != NULL) {
             if ((ret = yang_xml_mandatory(xs, yc)) < 0)
                 goto done;
             if (ret == 1)
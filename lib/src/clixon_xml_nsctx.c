@@ -72,6 +72,7 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_sort.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_alloc_profile.h"
 
 /* Undefine if you want to ensure strict namespace assignment on all netconf
  * and XML statements according to the standard RFC 6241.
@@ -81,6 +82,22 @@
  */
 static int _USE_NAMESPACE_NETCONF_DEFAULT = 0;
 
+/* If set, xml2ns does not set namespace caches, eg while trees are read by several threads */
+static int _NSCACHE_FROZEN = 0;
+
+/*! Shared namespace context of a scope
+ *
+ * A node declaring namespaces with xmlns attributes, or a top node, starts a scope. Other
+ * nodes share the scope of their parent. A scope is built on first use and rebuilt if
+ * the tree has changed since, see nsscope_gen.
+ * @see xml_nsscope_node
+ */
+struct xml_nsscope {
+    cvec     *ns_nsc;   /* Full namespace context of scope */
+    uint64_t  ns_gen;   /* Generation when built, 0 if not attached to a node */
+    int       ns_ref;   /* Reference count: nodes and callers */
+};
+
 /*! Set if use internal default namespace mechanism or not
  *
  * This function shouldnt really be here, it sets a local variable from the value of the
@@ -121,6 +138,7 @@ xml_nsctx_init(const char *prefix,
         clixon_err(OE_XML, errno, "cvec_new");
         goto done;
     }
+    ALLOC_PROFILE_COUNT(ALLOC_NSCTX);
     if (ns && xml_nsctx_add(cvv, prefix, ns) < 0)
         goto done;
  done:
@@ -217,16 +235,22 @@ xml_nsctx_add(cvec       *cvv,
     return retval;
 }
 
+/*! Add namespace declarations of one node to namespace context, unless already set
+ *
+ * @param[in]  xn   XML node
+ * @param[in]  nsc  Namespace context
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
 static int
-xml_nsctx_node1(cxobj *xn,
-                cvec  *nsc)
+xml_nsctx_node_attrs(cxobj *xn,
+                     cvec  *nsc)
 {
     int    retval = -1;
     cxobj *xa = NULL;
     char  *pf;  /* prefix */
     char  *nm;  /* name */
     char  *val; /* value */
-    cxobj *xp;  /* parent */
 
     /* xmlns:t="<ns1>" prefix:xmlns, name:t
      * xmlns="<ns2>"   prefix:NULL   name:xmlns
@@ -250,6 +274,20 @@ xml_nsctx_node1(cxobj *xn,
                     goto done;
             }
     }
+    retval = 0;
+ done:
+    return retval;
+}
+
+static int
+xml_nsctx_node1(cxobj *xn,
+                cvec  *nsc)
+{
+    int    retval = -1;
+    cxobj *xp;  /* parent */
+
+    if (xml_nsctx_node_attrs(xn, nsc) < 0)
+        goto done;
     if ((xp = xml_parent(xn)) == NULL){
         if (_USE_NAMESPACE_NETCONF_DEFAULT){
             /* If not default namespace defined, use the base netconf ns as default */
@@ -266,6 +304,200 @@ xml_nsctx_node1(cxobj *xn,
     return retval;
 }
 
+/*! Check if node declares any namespace with xmlns attributes
+ *
+ * @param[in]  xn   XML node
+ * @retval     1    Declares namespace
+ * @retval     0    No namespace declaration
+ */
+static int
+xml_nsscope_declares(cxobj *xn)
+{
+    cxobj *xa = NULL;
+    char  *pf;
+
+    while ((xa = xml_child_each_attr(xn, xa)) != NULL){
+        if ((pf = xml_prefix(xa)) == NULL){
+            if (strcmp(xml_name(xa), "xmlns") == 0)
+                return 1;
+        }
+        else if (strcmp(pf, "xmlns") == 0)
+            return 1;
+    }
+    return 0;
+}
+
+/*! Create new scope with one reference
+ *
+ * @param[in]  nsc  Namespace context, consumed
+ * @param[in]  gen  Generation
+ * @retval     sc   New scope
+ * @retval     NULL Error
+ */
+static xml_nsscope *
+xml_nsscope_new(cvec    *nsc,
+                uint64_t gen)
+{
+    xml_nsscope *sc;
+
+    if ((sc = calloc(1, sizeof(*sc))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        return NULL;
+    }
+    sc->ns_nsc = nsc;
+    sc->ns_gen = gen;
+    sc->ns_ref = 1;
+    return sc;
+}
+
+/*! Get current scope of node, build it and the scopes of its ancestors if stale
+ *
+ * @param[in]  xn   XML node
+ * @param[out] scp  Scope, referenced by the node, not by the caller
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_nsscope_build(cxobj        *xn,
+                  xml_nsscope **scp)
+{
+    int          retval = -1;
+    uint64_t     gen = nsscope_gen();
+    xml_nsscope *sc;
+    xml_nsscope *psc = NULL;
+    xml_nsscope *new = NULL;
+    cxobj       *xp;
+    cvec        *nsc = NULL;
+    cg_var      *cv = NULL;
+
+    if ((sc = nsscope_get(xn)) != NULL && sc->ns_gen == gen){
+        *scp = sc;
+        goto ok;
+    }
+    xp = xml_parent(xn);
+    if (xp != NULL &&
+        xml_nsscope_build(xp, &psc) < 0)
+        goto done;
+    if (psc != NULL && !xml_nsscope_declares(xn)){
+        /* Share scope of parent */
+        __atomic_add_fetch(&psc->ns_ref, 1, __ATOMIC_RELAXED);
+        new = psc;
+    }
+    else {
+        /* Own declarations first, then inherited not overridden, as xml_nsctx_node1 */
+        if ((nsc = cvec_new(0)) == NULL){
+            clixon_err(OE_XML, errno, "cvec_new");
+            goto done;
+        }
+        ALLOC_PROFILE_COUNT(ALLOC_NSCTX);
+        if (psc != NULL){
+            if (xml_nsctx_node_attrs(xn, nsc) < 0)
+                goto done;
+            while ((cv = cvec_each(psc->ns_nsc, cv)) != NULL){
+                if (xml_nsctx_get(nsc, cv_name_get(cv)) == NULL &&
+                    xml_nsctx_add(nsc, cv_name_get(cv), cv_string_get(cv)) < 0)
+                    goto done;
+            }
+        }
+        else if (xml_nsctx_node1(xn, nsc) < 0)
+            goto done;
+        if ((new = xml_nsscope_new(nsc, gen)) == NULL)
+            goto done;
+        nsc = NULL;
+    }
+    if (sc)
+        xml_nsscope_unref(sc);
+    nsscope_set(xn, new);
+    *scp = new;
+ ok:
+    retval = 0;
+ done:
+    if (nsc)
+        cvec_free(nsc);
+    return retval;
+}
+
+/*! Get shared namespace context of XML node
+ *
+ * The context is shared by all nodes in the same scope, ie below a node declaring
+ * namespaces. It is built once per scope and reused until the tree changes, so that in
+ * a stable tree getting the context of a node is O(1) and allocation-free.
+ * While namespace caches are frozen, see xml2ns_cache_freeze, a valid shared scope is used,
+ * otherwise a private scope is built without changing the tree.
+ * @param[in]  xn     XML node
+ * @param[out] scp    Namespace scope, release with xml_nsscope_unref
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ * xml_nsscope *sc = NULL;
+ * if (xml_nsscope_node(x, &sc) < 0)
+ *   err
+ * nsc = xml_nsscope_nsc(sc); // Do not modify or free
+ * ...
+ * xml_nsscope_unref(sc);
+ * @endcode
+ * @see xml_nsctx_node  For a private copy that can be modified
+ */
+int
+xml_nsscope_node(cxobj        *xn,
+                 xml_nsscope **scp)
+{
+    int          retval = -1;
+    xml_nsscope *sc;
+    cvec        *nsc = NULL;
+
+    if (_NSCACHE_FROZEN &&
+        ((sc = nsscope_get(xn)) == NULL || sc->ns_gen != nsscope_gen())){
+        if ((nsc = cvec_new(0)) == NULL){
+            clixon_err(OE_XML, errno, "cvec_new");
+            goto done;
+        }
+        ALLOC_PROFILE_COUNT(ALLOC_NSCTX);
+        if (xml_nsctx_node1(xn, nsc) < 0)
+            goto done;
+        if ((*scp = xml_nsscope_new(nsc, 0)) == NULL)
+            goto done;
+        nsc = NULL;
+        goto ok;
+    }
+    if (xml_nsscope_build(xn, &sc) < 0)
+        goto done;
+    __atomic_add_fetch(&sc->ns_ref, 1, __ATOMIC_RELAXED);
+    *scp = sc;
+ ok:
+    retval = 0;
+ done:
+    if (nsc)
+        cvec_free(nsc);
+    return retval;
+}
+
+/*! Get namespace context of scope
+ *
+ * @param[in]  sc   Namespace scope
+ * @retval     nsc  Namespace context, do not modify or free
+ */
+cvec *
+xml_nsscope_nsc(xml_nsscope *sc)
+{
+    return sc->ns_nsc;
+}
+
+/*! Release reference of namespace scope, free it if it was the last
+ *
+ * @param[in]  sc   Namespace scope
+ */
+int
+xml_nsscope_unref(xml_nsscope *sc)
+{
+    if (__atomic_sub_fetch(&sc->ns_ref, 1, __ATOMIC_ACQ_REL) == 0){
+        if (sc->ns_nsc)
+            cvec_free(sc->ns_nsc);
+        free(sc);
+    }
+    return 0;
+}
+
 /*! Create and initialize XML namespace from XML node context
  *
  * Fully explore all prefix:namespace pairs from context of one node
@@ -283,23 +515,28 @@ xml_nsctx_node1(cxobj *xn,
  * @endcode
  * @see xml_nsctx_init
  * @see xml_nsctx_free  Free the returned handle
+ * @see xml_nsscope_node  Shared context without copy
  */
 int
 xml_nsctx_node(cxobj *xn,
                cvec **ncp)
 {
-    int   retval = -1;
-    cvec *nc = NULL;
+    int          retval = -1;
+    cvec        *nc = NULL;
+    xml_nsscope *sc = NULL;
 
-    if ((nc = cvec_new(0)) == NULL){
-        clixon_err(OE_XML, errno, "cvec_new");
+    if (xml_nsscope_node(xn, &sc) < 0)
         goto done;
-    }
-    if (xml_nsctx_node1(xn, nc) < 0)
+    if ((nc = cvec_dup(xml_nsscope_nsc(sc))) == NULL){
+        clixon_err(OE_XML, errno, "cvec_dup");
         goto done;
+    }
+    ALLOC_PROFILE_COUNT(ALLOC_NSCTX);
     *ncp = nc;
     retval = 0;
  done:
+    if (sc)
+        xml_nsscope_unref(sc);
     return retval;
 }
 
@@ -350,6 +587,7 @@ xml_nsctx_yang(yang_stmt *yn,
         clixon_err(OE_XML, errno, "cvec_new");
         goto done;
     }
+    ALLOC_PROFILE_COUNT(ALLOC_NSCTX);
     if ((myprefix = yang_find_myprefix(yn)) == NULL){
         clixon_err(OE_YANG, ENOENT, "My yang prefix not found");
         goto done;
@@ -433,6 +671,7 @@ xml_nsctx_yangspec(yang_stmt *yspec,
         clixon_err(OE_XML, errno, "cvec_new");
         goto done;
     }
+    ALLOC_PROFILE_COUNT(ALLOC_NSCTX);
     inext = 0;
     while ((ymod = yn_iter(yspec, &inext)) != NULL){
         if (yang_keyword_get(ymod) != Y_MODULE)
@@ -483,6 +722,23 @@ xml_nsctx_cbuf(cbuf *cb,
     return 0;
 }
 
+/*! Stop or resume setting of namespace caches in xml2ns
+ *
+ * While frozen, xml2ns only reads namespace caches, so that trees can be read by several
+ * threads in parallel.
+ * @param[in]  freeze  1: Do not set caches, 0: Set caches
+ * @retval     old     Previous value
+ * @see xpath_parallel_frozen
+ */
+int
+xml2ns_cache_freeze(int freeze)
+{
+    int old = _NSCACHE_FROZEN;
+
+    _NSCACHE_FROZEN = freeze;
+    return old;
+}
+
 /*! Given an xml tree return URI namespace recursively : default or localname given
  *
  * Given an XML tree and a prefix (or NULL) return URI namespace.
@@ -503,12 +759,18 @@ xml2ns(cxobj      *x,
        const char *prefix,
        char      **namespace)
 {
-    int    retval = -1;
-    char  *ns = NULL;
-    cxobj *xp;
+    int          retval = -1;
+    char        *ns = NULL;
+    cxobj       *xp;
+    xml_nsscope *sc;
 
     if ((ns = nscache_get(x, prefix)) != NULL)
         goto ok;
+    /* Valid shared scope has the whole context */
+    if ((sc = nsscope_get(x)) != NULL && sc->ns_gen == nsscope_gen()){
+        ns = xml_nsctx_get(sc->ns_nsc, prefix);
+        goto ok;
+    }
     if (prefix != NULL) /* xmlns:<prefix>="<uri>" */
         ns = xml_find_type_value(x, "xmlns", prefix, CX_ATTR);
     else{                /* xmlns="<uri>" */
@@ -533,6 +795,7 @@ xml2ns(cxobj      *x,
      * If not, this is devastating when populating deep yang structures
      */
     if (ns &&
+        !_NSCACHE_FROZEN &&
         xml_child_nr(x) > 1 &&  /* Dont set cache if few children: if 1 child typically a body */
         nscache_set(x, prefix, ns) < 0)
         goto done;
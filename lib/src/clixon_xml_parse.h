@@ -45,7 +45,8 @@
  */
 /*! XML parser yacc handler struct */
 struct clixon_xml_parse_yacc {
-    char       *xy_parse_string; /* original (copy of) parse string */
+    char       *xy_parse_string; /* copy of parse string, followed by two null characters */
+    size_t      xy_parse_len;    /* Length of parse string, excluding null characters */
     int         xy_linenum;      /* Number of \n in parsed buffer */
     void       *xy_lexbuf;       /* internal parse buffer from lex */
     cxobj      *xy_xtop;         /* cxobj top element (fixed) */
@@ -72,4 +73,6 @@ int clixon_xml_parsel_linenr(void);
 int clixon_xml_parselex(void *);
 int clixon_xml_parseparse(void *);
 
+int clixon_xml_parse_fast(clixon_xml_yacc *xy);
+
 #endif  /* _CLIXON_XML_PARSE_H_ */
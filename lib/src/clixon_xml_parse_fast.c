@@ -0,0 +1,542 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ * Hand-written XML parser for the common subset of XML, see CLICON_XML_PARSE_FAST
+ * Builds the XML tree directly from the parse buffer without tokens or a grammar.
+ * Character data is scanned for special characters 16 bytes at a time using SSE2
+ * where available.
+ * Only elements, attributes, character data, entity references and an initial XML
+ * declaration are handled. Anything else, such as comments, processing instructions,
+ * CDATA sections and all errors are left to the flex/bison parser: the partially built
+ * tree is then removed and the caller falls back to clixon_xml_parseparse, so that
+ * accepted documents, created trees and error messages are the same as before.
+ * @see clixon_xml_parse.l, clixon_xml_parse.y
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <stdint.h>
+#include <syslog.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_xml_parse.h"
+
+/* White space between tokens inside tags, skipped by the lexer in START state */
+#define XF_ISSPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/* NCName start and following characters, see namestart and namechar in clixon_xml_parse.l */
+#define XF_ISNAMESTART(c) (((c) >= 'A' && (c) <= 'Z') || ((c) >= 'a' && (c) <= 'z') || (c) == '_')
+#define XF_ISNAMECHAR(c) (XF_ISNAMESTART(c) || ((c) >= '0' && (c) <= '9') || (c) == '-' || (c) == '.')
+
+/*! Find next character in character data that needs special handling
+ *
+ * Special characters are '<', '&', '\r' and null
+ * @param[in]  s    Start of scan
+ * @param[in]  end  End of buffer
+ * @retval     p    Pointer to first special character, or end if none
+ */
+static inline char *
+xf_scan_chardata(char *s,
+                 char *end)
+{
+    char c;
+#ifdef __SSE2__
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i zero = _mm_setzero_si128();
+    __m128i       v;
+    __m128i       m;
+    int           mask;
+
+    while (end - s >= 16){
+        v = _mm_loadu_si128((const __m128i *)s);
+        m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, amp)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, zero)));
+        if ((mask = _mm_movemask_epi8(m)) != 0)
+            return s + __builtin_ctz(mask);
+        s += 16;
+    }
+#endif
+    while (s < end){
+        c = *s;
+        if (c == '<' || c == '&' || c == '\r' || c == '\0')
+            break;
+        s++;
+    }
+    return s;
+}
+
+/*! Skip white space inside a tag
+ */
+static inline char *
+xf_skip_space(char *s,
+              char *end)
+{
+    while (s < end && XF_ISSPACE(*s))
+        s++;
+    return s;
+}
+
+/*! Scan a possibly prefixed name: NAME or NAME:NAME with optional space around ':'
+ *
+ * @param[in]  s       Start of scan, first character of name
+ * @param[in]  end     End of buffer
+ * @param[out] prefix  Start of prefix, or NULL if no prefix
+ * @param[out] plen    Length of prefix
+ * @param[out] name    Start of local name
+ * @param[out] nlen    Length of local name
+ * @retval     p       Pointer after name and trailing space
+ * @retval     NULL    Not a name
+ */
+static char *
+xf_scan_qname(char  *s,
+              char  *end,
+              char **prefix,
+              size_t *plen,
+              char **name,
+              size_t *nlen)
+{
+    char *p;
+
+    if (s >= end || !XF_ISNAMESTART(*s))
+        return NULL;
+    p = s;
+    while (p < end && XF_ISNAMECHAR(*p))
+        p++;
+    *prefix = NULL;
+    *plen = 0;
+    *name = s;
+    *nlen = p - s;
+    p = xf_skip_space(p, end);
+    if (p < end && *p == ':'){
+        p = xf_skip_space(p+1, end);
+        if (p >= end || !XF_ISNAMESTART(*p))
+            return NULL;
+        *prefix = s;
+        *plen = *nlen;
+        *name = p;
+        while (p < end && XF_ISNAMECHAR(*p))
+            p++;
+        *nlen = p - *name;
+        p = xf_skip_space(p, end);
+    }
+    return p;
+}
+
+/*! Scan entity reference after '&' and append its value to cb
+ *
+ * Predefined entities are decoded, character references are kept as is, as by the lexer
+ * @param[in]  s    Character after '&'
+ * @param[in]  end  End of buffer
+ * @param[in]  cb   Character data buffer, or NULL if character data is not kept
+ * @retval     p    Pointer after ';'
+ * @retval     NULL Not a known entity reference
+ */
+static char *
+xf_scan_entity(char *s,
+               char *end,
+               cbuf *cb)
+{
+    static const struct {
+        const char *ent;
+        size_t      len;
+        char        c;
+    } entities[] = {
+        {"amp;", 4, '&'},
+        {"lt;", 3, '<'},
+        {"gt;", 3, '>'},
+        {"apos;", 5, '\''},
+        {"quot;", 5, '"'},
+    };
+    char *p;
+    int   i;
+
+    for (i = 0; i < sizeof(entities)/sizeof(entities[0]); i++){
+        if (end - s >= entities[i].len &&
+            strncmp(s, entities[i].ent, entities[i].len) == 0){
+            if (cb)
+                cbuf_append(cb, entities[i].c);
+            return s + entities[i].len;
+        }
+    }
+    if (s >= end || *s != '#')
+        return NULL;
+    p = s + 1;
+    if (p < end && *p == 'x'){
+        p++;
+        while (p < end && ((*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'f') || (*p >= 'A' && *p <= 'F')))
+            p++;
+        if (p == s + 2)
+            return NULL;
+    }
+    else {
+        while (p < end && *p >= '0' && *p <= '9')
+            p++;
+        if (p == s + 1)
+            return NULL;
+    }
+    if (p >= end || *p != ';')
+        return NULL;
+    p++;
+    if (cb){
+        cbuf_append(cb, '&');
+        cbuf_append_buf(cb, s, p - s);
+    }
+    return p;
+}
+
+/*! Scan quoted string inside a tag
+ *
+ * @param[in]  s     Start of scan, the quote character
+ * @param[in]  end   End of buffer
+ * @param[out] val   Start of value
+ * @param[out] vlen  Length of value
+ * @retval     p     Pointer after end quote
+ * @retval     NULL  Not a quoted string
+ */
+static char *
+xf_scan_quoted(char   *s,
+               char   *end,
+               char  **val,
+               size_t *vlen)
+{
+    char *p;
+
+    if (s >= end || (*s != '"' && *s != '\''))
+        return NULL;
+    if ((p = memchr(s+1, *s, end - s - 1)) == NULL)
+        return NULL;
+    *val = s + 1;
+    *vlen = p - s - 1;
+    if (memchr(*val, '\0', *vlen) != NULL)
+        return NULL;
+    return p + 1;
+}
+
+/*! Scan XML declaration: <?xml version="1.0" encoding="UTF-8" standalone="..."?>
+ *
+ * @param[in]  s     Character after "<?xml"
+ * @param[in]  end   End of buffer
+ * @retval     p     Pointer after "?>"
+ * @retval     NULL  Not a supported XML declaration
+ */
+static char *
+xf_scan_xmldecl(char *s,
+                char *end)
+{
+    static const char *keys[] = {"version", "encoding", "standalone"};
+    char              *p;
+    char              *val;
+    size_t             vlen;
+    size_t             klen;
+    int                i;
+
+    if (s >= end || !XF_ISSPACE(*s))
+        return NULL;
+    p = s;
+    for (i = 0; i < 3; i++){
+        p = xf_skip_space(p, end);
+        klen = strlen(keys[i]);
+        if (end - p < klen || strncmp(p, keys[i], klen) != 0){
+            if (i == 0)
+                return NULL;
+            continue;
+        }
+        p = xf_skip_space(p + klen, end);
+        if (p >= end || *p != '=')
+            return NULL;
+        p = xf_skip_space(p + 1, end);
+        if ((p = xf_scan_quoted(p, end, &val, &vlen)) == NULL)
+            return NULL;
+        if (i == 0 && (vlen != 3 || strncmp(val, "1.0", 3) != 0))
+            return NULL;
+        if (i == 1 && (vlen != 5 || strncasecmp(val, "UTF-8", 5) != 0))
+            return NULL;
+        if (i == 2 && vlen == 0)
+            return NULL;
+    }
+    p = xf_skip_space(p, end);
+    if (end - p < 2 || p[0] != '?' || p[1] != '>')
+        return NULL;
+    return p + 2;
+}
+
+/*! Create element or attribute from names in the parse buffer
+ *
+ * The names are temporarily null-terminated in place
+ * @param[in]  xp     Parent
+ * @param[in]  prefix Prefix or NULL
+ * @param[in]  plen   Length of prefix
+ * @param[in]  name   Local name
+ * @param[in]  nlen   Length of local name
+ * @param[in]  type   CX_ELMNT or CX_ATTR
+ * @retval     x      Created XML object
+ * @retval     NULL   Error
+ */
+static cxobj *
+xf_new(cxobj      *xp,
+       char       *prefix,
+       size_t      plen,
+       char       *name,
+       size_t      nlen,
+       enum cxobj_type type)
+{
+    cxobj *x = NULL;
+    char   csave;
+    char   psave = '\0';
+
+    csave = name[nlen];
+    name[nlen] = '\0';
+    if (prefix){
+        psave = prefix[plen];
+        prefix[plen] = '\0';
+    }
+    if (type == CX_ATTR)
+        x = xml_find_type(xp, prefix, name, CX_ATTR);
+    if (x == NULL){
+        if ((x = xml_new(name, xp, type)) == NULL)
+            goto done;
+        if (xml_prefix_set(x, prefix) < 0){
+            x = NULL;
+            goto done;
+        }
+    }
+ done:
+    name[nlen] = csave;
+    if (prefix)
+        prefix[plen] = psave;
+    return x;
+}
+
+/*! Parse XML in the parse buffer directly into an XML tree
+ *
+ * Created top-level elements are added to xy_xvec, as by the bison parser.
+ * If the document uses constructs not handled here, or is not well-formed, all created
+ * objects are removed and 0 is returned, the caller then parses the buffer with the
+ * flex/bison parser, which also reports errors.
+ * The buffer is not modified.
+ * @param[in]  xy   XML parser yacc handler struct, with parse string, length and top
+ * @retval     1    OK, tree created
+ * @retval     0    Not handled, use regular parser
+ * @retval    -1    Error
+ */
+int
+clixon_xml_parse_fast(clixon_xml_yacc *xy)
+{
+    int     retval = -1;
+    char   *s = xy->xy_parse_string;
+    char   *end = s + xy->xy_parse_len;
+    char   *p;
+    char   *prefix;
+    char   *name;
+    char   *val;
+    size_t  plen;
+    size_t  nlen;
+    size_t  vlen;
+    cxobj  *xt = xy->xy_xtop;
+    cxobj  *xp = xt;  /* Parent of current content */
+    cxobj  *x;
+    cxobj  *xa;
+    cxobj  *xb;
+    cbuf   *cb = NULL;
+    int     elchild = 0; /* Current parent has element children, its character data is dropped */
+    int     single = 0;  /* XML declaration: only one top-level element */
+    int     started = 0; /* Top-level element seen */
+    char   *pn;
+    int     i;
+    char    csave;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    /* Prolog: space and optional XML declaration, as lexer START state */
+    s = xf_skip_space(s, end);
+    if (end - s >= 5 && strncmp(s, "<?xml", 5) == 0){
+        if ((s = xf_scan_xmldecl(s + 5, end)) == NULL)
+            goto fail;
+        s = xf_skip_space(s, end);
+        single++;
+    }
+    while (s < end){
+        if (*s != '<'){
+            /* Character data, as lexer STATEA state */
+            if (!started)
+                goto fail;
+            p = xf_scan_chardata(s, end);
+            if (xp == xt){ /* Top-level character data is dropped */
+                if (single && xf_skip_space(s, p) != p)
+                    goto fail;
+            }
+            else if (!elchild)
+                cbuf_append_buf(cb, s, p - s);
+            s = p;
+            if (s >= end)
+                break;
+            switch (*s){
+            case '&':
+                if (single && xp == xt)
+                    goto fail;
+                if ((s = xf_scan_entity(s + 1, end, (xp != xt && !elchild) ? cb : NULL)) == NULL)
+                    goto fail;
+                break;
+            case '\r': /* \r\n and \r are translated to \n */
+                s++;
+                if (s < end && *s == '\n')
+                    s++;
+                if (xp != xt && !elchild)
+                    cbuf_append(cb, '\n');
+                break;
+            case '<':
+                break;
+            default: /* null */
+                goto fail;
+            }
+            continue;
+        }
+        /* Markup */
+        p = s + 1;
+        if (p < end && *p == '/'){
+            /* End tag */
+            if (xp == xt)
+                goto fail;
+            p = xf_skip_space(p + 1, end);
+            if ((p = xf_scan_qname(p, end, &prefix, &plen, &name, &nlen)) == NULL)
+                goto fail;
+            if (p >= end || *p != '>')
+                goto fail;
+            pn = xml_name(xp);
+            if (strlen(pn) != nlen || strncmp(pn, name, nlen) != 0)
+                goto fail;
+            pn = xml_prefix(xp);
+            if ((pn == NULL) != (prefix == NULL))
+                goto fail;
+            if (pn && (strlen(pn) != plen || strncmp(pn, prefix, plen) != 0))
+                goto fail;
+            if (!elchild && cbuf_len(cb)){
+                if ((xb = xml_new("body", xp, CX_BODY)) == NULL)
+                    goto done;
+                if (xml_value_set(xb, cbuf_get(cb)) < 0)
+                    goto done;
+            }
+            cbuf_reset(cb);
+            xp = xml_parent(xp);
+            elchild = 1;
+            s = p + 1;
+            continue;
+        }
+        /* Start tag. Comments, CDATA and processing instructions are not handled */
+        if (single && started && xp == xt)
+            goto fail;
+        p = xf_skip_space(p, end);
+        if ((p = xf_scan_qname(p, end, &prefix, &plen, &name, &nlen)) == NULL)
+            goto fail;
+        if ((x = xf_new(xp, prefix, plen, name, nlen, CX_ELMNT)) == NULL)
+            goto done;
+        if (xp == xt){
+            if (cxvec_append(x, &xy->xy_xvec, &xy->xy_xlen) < 0)
+                goto done;
+        }
+        /* Attributes */
+        while (p < end && XF_ISNAMESTART(*p)){
+            if ((p = xf_scan_qname(p, end, &prefix, &plen, &name, &nlen)) == NULL)
+                goto fail;
+            if (p >= end || *p != '=')
+                goto fail;
+            p = xf_skip_space(p + 1, end);
+            if ((p = xf_scan_quoted(p, end, &val, &vlen)) == NULL)
+                goto fail;
+            if ((xa = xf_new(x, prefix, plen, name, nlen, CX_ATTR)) == NULL)
+                goto done;
+            csave = val[vlen];
+            val[vlen] = '\0';
+            i = xml_value_set(xa, val);
+            val[vlen] = csave;
+            if (i < 0)
+                goto done;
+            p = xf_skip_space(p, end);
+        }
+        if (end - p >= 2 && p[0] == '/' && p[1] == '>'){
+            s = p + 2;
+            elchild = 1;
+        }
+        else if (p < end && *p == '>'){
+            s = p + 1;
+            xp = x;
+            elchild = 0;
+            cbuf_reset(cb);
+        }
+        else
+            goto fail;
+        started++;
+    }
+    if (xp != xt) /* Unterminated element */
+        goto fail;
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ fail:
+    /* Remove created objects, the regular parser starts from scratch */
+    for (i = 0; i < xy->xy_xlen; i++)
+        xml_purge(xy->xy_xvec[i]);
+    if (xy->xy_xvec)
+        free(xy->xy_xvec);
+    xy->xy_xvec = NULL;
+    xy->xy_xlen = 0;
+    retval = 0;
+    goto done;
+}
@@ -46,6 +46,9 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 #include <limits.h>
 #include <stdint.h>
 #include <syslog.h>
@@ -76,20 +79,27 @@
 #include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 
-/*! Get xml body value as cligen variable
+#ifdef HAVE_LIBPTHREAD
+/* Max depth of levels sorted in calling thread by xml_sort_recurse_threads */
+#define XML_SORT_THREAD_DEPTH 3
+/* Subtrees per thread wanted before sorting in threads */
+#define XML_SORT_THREAD_UNITS 4
+#endif
+
+/*! Parse xml body value as a new cligen variable, help function
  *
- * @param[in]  x   XML node (body and leaf/leaf-list)
- * @param[out] cvp Pointer to cligen variable containing value of x body
- * @retval     0   OK, cvp contains cv or NULL
- * @retval    -1   Error
- * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Move to clixon_xml.c?
- * As a side-effect sets the cache.
- * Clear cache with xml_cv_set(x, NULL)
+ * @param[in]  x      XML node (body and leaf/leaf-list)
+ * @param[out] cvp    Pointer to new cligen variable containing value of x body, free with cv_free
+ * @param[out] reason If parse error, malloced reason string, free with free()
+ * @retval     1      OK, cvp contains cv
+ * @retval     0      Parse error, reason set
+ * @retval    -1      Error
+ * @see xml_cv_cache1
  */
 static int
-xml_cv_cache(cxobj   *x,
-             cg_var **cvp)
+xml_cv_parse1(cxobj   *x,
+              cg_var **cvp,
+              char   **reason)
 {
     int          retval = -1;
     cg_var      *cv = NULL;
@@ -97,15 +107,12 @@ xml_cv_cache(cxobj   *x,
     yang_stmt   *yrestype;
     enum cv_type cvtype;
     int          ret;
-    char        *reason=NULL;
     int          options = 0;
     uint8_t      fraction = 0;
     char        *body;
 
     if ((body = xml_body(x)) == NULL)
         body="";
-    if ((cv = xml_cv(x)) != NULL)
-        goto ok;
     if ((y = xml_spec(x)) == NULL){
         clixon_err(OE_XML, EFAULT, "Yang binding missing for xml symbol %s, body:%s", xml_name(x), body);
         goto done;
@@ -124,12 +131,48 @@ xml_cv_cache(cxobj   *x,
     }
     if (cvtype == CGV_DEC64)
         cv_dec64_n_set(cv, fraction);
-    if ((ret = cv_parse1(body, cv, &reason)) < 0){
+    if ((ret = cv_parse1(body, cv, reason)) < 0){
         clixon_err(OE_YANG, errno, "cv_parse1");
         goto done;
     }
     if (ret == 0){
-        clixon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
+        retval = 0;
+        goto done;
+    }
+    *cvp = cv;
+    cv = NULL;
+    retval = 1;
+ done:
+    if (cv)
+        cv_free(cv);
+    return retval;
+}
+
+/*! Parse xml body value as cligen variable and cache it, help function
+ *
+ * @param[in]  x      XML node (body and leaf/leaf-list)
+ * @param[out] cvp    Pointer to cligen variable containing value of x body
+ * @param[out] reason If parse error, malloced reason string, free with free()
+ * @retval     1      OK, cvp contains cv
+ * @retval     0      Parse error, reason set
+ * @retval    -1      Error
+ * @see xml_cv_cache
+ */
+static int
+xml_cv_cache1(cxobj   *x,
+              cg_var **cvp,
+              char   **reason)
+{
+    int     retval = -1;
+    cg_var *cv = NULL;
+    int     ret;
+
+    if ((cv = xml_cv(x)) != NULL)
+        goto ok;
+    if ((ret = xml_cv_parse1(x, &cv, reason)) < 0)
+        goto done;
+    if (ret == 0){
+        retval = 0;
         goto done;
     }
     if (xml_cv_set(x, cv) < 0)
@@ -137,15 +180,254 @@ xml_cv_cache(cxobj   *x,
  ok:
     *cvp = cv;
     cv = NULL;
+    retval = 1;
+ done:
+    if (cv)
+        cv_free(cv);
+    return retval;
+}
+
+/*! Get xml body value as cligen variable
+ *
+ * @param[in]  x   XML node (body and leaf/leaf-list)
+ * @param[out] cvp Pointer to cligen variable containing value of x body
+ * @retval     0   OK, cvp contains cv or NULL
+ * @retval    -1   Error
+ * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
+ * As a side-effect sets the cache.
+ * Clear cache with xml_cv_set(x, NULL). The cache is also cleared if the body of x changes
+ */
+int
+xml_cv_cache(cxobj   *x,
+             cg_var **cvp)
+{
+    int   retval = -1;
+    char *reason = NULL;
+    int   ret;
+
+    if ((ret = xml_cv_cache1(x, cvp, &reason)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    return retval;
+}
+
+/*! Get xml body value as cligen variable without setting the cache
+ *
+ * Same as xml_cv_cache but x is not modified, for trees that other threads may read, see
+ * xml_threads_set.
+ * @param[in]  x      XML node (body and leaf/leaf-list)
+ * @param[out] cvp    Pointer to cligen variable containing value of x body
+ * @param[out] cvfree Same as cvp if not cached, free with cv_free, otherwise NULL
+ * @retval     0      OK, cvp contains cv
+ * @retval    -1      Error
+ * @code
+ *   if (xml_cv_parse(x, &cv, &cvfree) < 0)
+ *      err;
+ *   ...
+ *   if (cvfree)
+ *      cv_free(cvfree);
+ * @endcode
+ */
+int
+xml_cv_parse(cxobj   *x,
+             cg_var **cvp,
+             cg_var **cvfree)
+{
+    int   retval = -1;
+    char *reason = NULL;
+    int   ret;
+
+    *cvfree = NULL;
+    if ((*cvp = xml_cv(x)) != NULL)
+        goto ok;
+    if ((ret = xml_cv_parse1(x, cvp, &reason)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
+        goto done;
+    }
+    *cvfree = *cvp;
+ ok:
     retval = 0;
  done:
     if (reason)
         free(reason);
-    if (cv)
-        cv_free(cv);
     return retval;
 }
 
+#ifdef XML_LIST_HASH
+/*! FNV-1a hash of a byte string, continuing from h
+ */
+static inline uint32_t
+xml_key_hash_bytes(uint32_t    h,
+                   const char *s,
+                   size_t      len)
+{
+    size_t i;
+
+    for (i=0; i<len; i++){
+        h ^= (uint8_t)s[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*! Continue hash with the canonical value of a key leaf or leaf-list entry
+ *
+ * @param[in]     xk    Key leaf or leaf-list entry
+ * @param[in,out] h     Hash value
+ * @retval        1     OK
+ * @retval        0     Value does not parse
+ * @retval       -1     Error
+ */
+static int
+xml_key_hash_value(cxobj    *xk,
+                   uint32_t *h)
+{
+    int     retval = -1;
+    cg_var *cv;
+    char   *body;
+    char   *reason = NULL;
+    char    buf[64];
+    int     len;
+    int     ret;
+
+    if ((body = xml_body(xk)) == NULL || *body == '\0')
+        body = "";
+    else {
+        if ((ret = xml_cv_cache1(xk, &cv, &reason)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if ((len = cv2str(cv, buf, sizeof(buf))) < 0)
+            goto fail;
+        body = buf; /* A truncated value is still a valid hash input */
+    }
+    *h = xml_key_hash_bytes(*h, body, strlen(body) + 1);
+    retval = 1;
+ done:
+    if (reason)
+        free(reason);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Compute hash of the key values of a list entry, or the value of a leaf-list entry
+ *
+ * The hash is computed over the canonical (cligen) string of each key value so that two
+ * entries that are equal according to xml_cmp have the same hash, eg "01" and "1" of an
+ * integer key. A missing body is hashed as the empty string.
+ * @param[in]  x     XML list or leaf-list entry
+ * @param[in]  y     Yang list or leaf-list of x
+ * @param[out] hash  Hash value
+ * @retval     1     OK, hash set
+ * @retval     0     Not all keys present, or key value does not parse, no hash
+ * @retval    -1     Error
+ * @see xml_hash_find
+ */
+int
+xml_key_hash(cxobj     *x,
+             yang_stmt *y,
+             uint32_t  *hash)
+{
+    uint32_t  h = 2166136261U;
+    cvec     *cvk;
+    cg_var   *cvi = NULL;
+    cxobj    *xk;
+    int       ret;
+
+    h = xml_key_hash_bytes(h, (const char*)&y, sizeof(y));
+    if (yang_keyword_get(y) == Y_LEAF_LIST){
+        if ((ret = xml_key_hash_value(x, &h)) < 1)
+            return ret;
+    }
+    else {
+        if ((cvk = yang_cvec_get(y)) == NULL)
+            return 0;
+        while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+            if ((xk = xml_find(x, cv_string_get(cvi))) == NULL ||
+                xml_spec(xk) == NULL)
+                return 0;
+            if ((ret = xml_key_hash_value(xk, &h)) < 1)
+                return ret;
+        }
+    }
+    *hash = h;
+    return 1;
+}
+#endif /* XML_LIST_HASH */
+
+/*! Populate cached values of list keys and leaf-list entries at bind time
+ *
+ * Parse the key leaves of a list element, or the value of a leaf-list element, once, so
+ * that later sorting and searching (xml_cmp) compare native values only.
+ * Values that do not parse are silently skipped, they are reported by validation.
+ * @param[in]  xt   XML element with yang spec
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see XML_BIND_CV_CACHE
+ */
+int
+xml_cv_cache_keys(cxobj *xt)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cvec      *cvk;
+    cg_var    *cvi = NULL;
+    cxobj     *xk;
+    cg_var    *cv;
+    char      *reason = NULL;
+
+    if ((y = xml_spec(xt)) == NULL)
+        goto ok;
+    switch (yang_keyword_get(y)){
+    case Y_LEAF_LIST:
+        if (xml_cv(xt) == NULL &&
+            xml_cv_cache1(xt, &cv, &reason) < 0)
+            goto done;
+        break;
+    case Y_LIST:
+        if ((cvk = yang_cvec_get(y)) == NULL)
+            break;
+        while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+            if ((xk = xml_find_type(xt, NULL, cv_string_get(cvi), CX_ELMNT)) == NULL ||
+                xml_spec(xk) == NULL ||
+                xml_cv(xk) != NULL)
+                continue;
+            if (xml_cv_cache1(xk, &cv, &reason) < 0)
+                goto done;
+            if (reason){
+                free(reason);
+                reason = NULL;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    return retval;
+}
+
+#ifndef XML_BIND_CV_CACHE
+/*! Clear cached values of children after sorting
+ *
+ * @param[in]  xt   XML parent
+ * @note Not used if XML_BIND_CV_CACHE, then the cache is kept since it is coherent with the body
+ */
 static int
 xml_cv_cache_clear(cxobj *xt)
 {
@@ -159,6 +441,28 @@ xml_cv_cache_clear(cxobj *xt)
  done:
     return retval;
 }
+#endif /* XML_BIND_CV_CACHE */
+
+/*! Find child with a name, comparing interned names by pointer
+ *
+ * @param[in]  xp     XML parent
+ * @param[in]  name   Name of child
+ * @param[in]  iname  Interned name, or NULL, see xml_name_interned
+ * @retval     x      Child
+ * @retval     NULL   Not found
+ */
+static cxobj *
+xml_cmp_find(cxobj      *xp,
+             const char *name,
+             const char *iname)
+{
+    cxobj *x = NULL;
+
+    while ((x = xml_child_each(xp, x, -1)) != NULL)
+        if (xml_name_eq(x, name, iname))
+            break;
+    return x;
+}
 
 /*! Help function to qsort for sorting entries in xml child vector same parent
  *
@@ -367,7 +671,8 @@ xml_cmp(cxobj  *x1,
                 /* match1: key matching skipped for keys not in x1 (see explanation) */
                 if (skip1 && x1b == NULL)
                     continue;
-                x2b = xml_find(x2, keyname);
+                /* Key names of x2 are compared by pointer with the interned name of x1 */
+                x2b = xml_cmp_find(x2, keyname, xml_name_interned(x1b));
                 if (x1b == NULL && x2b == NULL)
                     ;
                 else if (x1b == NULL)
@@ -435,6 +740,7 @@ int
 xml_sort_by(cxobj *x,
             char  *indexvar)
 {
+    xml_sort_pending_set(x, 0);
     xml_enumerate_children(x); /* This is to make sorting "stable", ie not change existing order */
 #ifdef HAVE_QSORT_S
     qsort_s(xml_childvec_get(x), xml_child_nr(x), sizeof(cxobj *), xml_cmp_qsort, indexvar);
@@ -444,6 +750,256 @@ xml_sort_by(cxobj *x,
     return 0;
 }
 
+#ifdef XML_SORT_DECORATE
+/*! Pre-computed sort value of one list key or leaf-list entry
+ */
+struct xml_sort_val{
+    cxobj  *sv_x;    /* Key leaf (list) or entry (leaf-list), NULL if absent */
+    char   *sv_body; /* Body of sv_x or NULL */
+    cg_var *sv_cv;   /* Cached value of sv_x, NULL if no body or parse error */
+};
+
+/*! Decorated child for xml_sort: sort key computed once per child
+ */
+struct xml_sort_key{
+    cxobj               *sk_x;    /* Child */
+    yang_stmt           *sk_y;    /* Yang spec of child or NULL */
+    int                  sk_type; /* Attributes first */
+    int                  sk_yi;   /* Yang order */
+    int                  sk_nr;   /* Existing position, see xml_enumerate_children */
+    int                  sk_user; /* Ordered-by user or state: keep existing order */
+    int                  sk_nv;   /* Number of values in sk_v */
+    struct xml_sort_val *sk_v;    /* Key values (list) or value (leaf-list) */
+};
+
+/*! Threshold of number of children to use decorated sort in xml_sort */
+#define XML_SORT_DECORATE_MIN 16
+
+/*! Compute sort value of a key leaf or leaf-list entry
+ */
+static int
+xml_sort_val_set(cxobj               *x,
+                 struct xml_sort_val *sv)
+{
+    int   retval = -1;
+    char *reason = NULL;
+    int   ret;
+
+    sv->sv_x = x;
+    sv->sv_body = NULL;
+    sv->sv_cv = NULL;
+    if (x && (sv->sv_body = xml_body(x)) != NULL){
+        if ((ret = xml_cv_cache1(x, &sv->sv_cv, &reason)) < 0)
+            goto done;
+        if (ret == 0)
+            sv->sv_cv = NULL;
+    }
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    return retval;
+}
+
+/*! Compare two pre-computed values as the cached values are compared in xml_cmp
+ */
+static int
+xml_sort_val_cmp(struct xml_sort_val *sv1,
+                 struct xml_sort_val *sv2)
+{
+    if (sv1->sv_cv != NULL && sv2->sv_cv != NULL)
+        return cv_cmp(sv1->sv_cv, sv2->sv_cv);
+    else if (sv1->sv_cv == NULL && sv2->sv_cv == NULL)
+        return 0;
+    else if (sv1->sv_cv == NULL)
+        return -1;
+    else
+        return 1;
+}
+
+/*! Compare two decorated children, same order as xml_cmp with same set
+ *
+ * @see xml_cmp
+ */
+static int
+xml_sort_key_cmp(const void *arg1,
+                 const void *arg2)
+{
+    struct xml_sort_key *sk1 = (struct xml_sort_key *)arg1;
+    struct xml_sort_key *sk2 = (struct xml_sort_key *)arg2;
+    struct xml_sort_val *sv1;
+    struct xml_sort_val *sv2;
+    int                  equal = 0;
+    int                  i;
+
+    if (sk1->sk_type != sk2->sk_type){
+        if (sk1->sk_type == CX_ATTR)
+            return -1;
+        else if (sk2->sk_type == CX_ATTR)
+            return 1;
+    }
+    if (sk1->sk_y == NULL && sk2->sk_y == NULL)
+        return sk1->sk_nr - sk2->sk_nr;
+    if (sk1->sk_y == NULL)
+        return -1;
+    if (sk2->sk_y == NULL)
+        return 1;
+    if (sk1->sk_y != sk2->sk_y){
+        if ((equal = sk1->sk_yi - sk2->sk_yi) != 0)
+            return equal;
+        /* Same order but different yang, eg choice: not decorated */
+        return xml_cmp(sk1->sk_x, sk2->sk_x, 1, 0, NULL);
+    }
+    if (sk1->sk_user)
+        return sk1->sk_nr - sk2->sk_nr;
+    switch (yang_keyword_get(sk1->sk_y)){
+    case Y_LEAF_LIST:
+        sv1 = &sk1->sk_v[0];
+        sv2 = &sk2->sk_v[0];
+        if (sv1->sv_body == NULL && sv2->sv_body == NULL)
+            ;
+        else if (sv1->sv_body == NULL)
+            equal = -1;
+        else if (sv2->sv_body == NULL)
+            equal = 1;
+        else
+            equal = xml_sort_val_cmp(sv1, sv2);
+        break;
+    case Y_LIST:
+        for (i=0; i<sk1->sk_nv && equal == 0; i++){
+            sv1 = &sk1->sk_v[i];
+            sv2 = &sk2->sk_v[i];
+            if (sv1->sv_x == NULL && sv2->sv_x == NULL)
+                ;
+            else if (sv1->sv_x == NULL)
+                equal = -1;
+            else if (sv2->sv_x == NULL)
+                equal = 1;
+            else if (sv1->sv_body == NULL && sv2->sv_body == NULL)
+                ;
+            else if (sv1->sv_body == NULL && strcmp(sv2->sv_body, "") == 0)
+                ;
+            else if (sv2->sv_body == NULL && strcmp(sv1->sv_body, "") == 0)
+                ;
+            else if (sv1->sv_body == NULL)
+                equal = -1;
+            else if (sv2->sv_body == NULL)
+                equal = 1;
+            else
+                equal = xml_sort_val_cmp(sv1, sv2);
+        }
+        break;
+    default:
+        break;
+    }
+    if (equal == 0)
+        equal = sk1->sk_nr - sk2->sk_nr;
+    return equal;
+}
+
+/*! Sort children of x using a sort key computed once per child
+ *
+ * Yang spec, yang order, ordered-by and list key values are looked up once per child
+ * instead of in every comparison as in xml_cmp_qsort.
+ * @param[in] x   XML node, children enumerated
+ * @retval    0   OK
+ * @retval   -1   Error
+ * @see xml_sort
+ */
+static int
+xml_sort_decorated(cxobj *x)
+{
+    int                  retval = -1;
+    struct xml_sort_key *skvec = NULL;
+    struct xml_sort_key *sk;
+    struct xml_sort_val *svvec = NULL;
+    cxobj              **vec;
+    cxobj               *xc;
+    yang_stmt           *yc;
+    cvec                *cvk;
+    cg_var              *cvi;
+    int                  n;
+    int                  nv = 0;
+    int                  i;
+    int                  j;
+
+    n = xml_child_nr(x);
+    if ((vec = xml_childvec_get(x)) == NULL)
+        goto done;
+    if ((skvec = calloc(n, sizeof(*skvec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    /* First pass: yang and number of values */
+    for (i=0; i<n; i++){
+        sk = &skvec[i];
+        xc = vec[i];
+        sk->sk_x = xc;
+        sk->sk_type = xml_type(xc);
+        sk->sk_nr = xml_enumerate_get(xc);
+        if ((yc = xml_spec(xc)) == NULL)
+            continue;
+        sk->sk_y = yc;
+        if ((sk->sk_yi = yang_order(yc)) < -1)
+            goto done;
+        sk->sk_user = (
+#ifndef STATE_ORDERED_BY_SYSTEM
+                       yang_config(yc)==0 ||
+#endif
+                       yang_find(yc, Y_ORDERED_BY, "user") != NULL);
+        if (sk->sk_user)
+            continue;
+        switch (yang_keyword_get(yc)){
+        case Y_LEAF_LIST:
+            sk->sk_nv = 1;
+            break;
+        case Y_LIST:
+            if ((cvk = yang_cvec_get(yc)) != NULL)
+                sk->sk_nv = cvec_len(cvk);
+            break;
+        default:
+            break;
+        }
+        nv += sk->sk_nv;
+    }
+    if (nv && (svvec = calloc(nv, sizeof(*svvec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    /* Second pass: values */
+    nv = 0;
+    for (i=0; i<n; i++){
+        sk = &skvec[i];
+        if (sk->sk_nv == 0)
+            continue;
+        sk->sk_v = &svvec[nv];
+        nv += sk->sk_nv;
+        if (yang_keyword_get(sk->sk_y) == Y_LEAF_LIST){
+            if (xml_sort_val_set(sk->sk_x, &sk->sk_v[0]) < 0)
+                goto done;
+            continue;
+        }
+        cvk = yang_cvec_get(sk->sk_y);
+        cvi = NULL;
+        j = 0;
+        while ((cvi = cvec_each(cvk, cvi)) != NULL && j < sk->sk_nv){
+            if (xml_sort_val_set(xml_find(sk->sk_x, cv_string_get(cvi)), &sk->sk_v[j++]) < 0)
+                goto done;
+        }
+    }
+    qsort(skvec, n, sizeof(*skvec), xml_sort_key_cmp);
+    for (i=0; i<n; i++)
+        vec[i] = skvec[i].sk_x;
+    retval = 0;
+ done:
+    if (svvec)
+        free(svvec);
+    if (skvec)
+        free(skvec);
+    return retval;
+}
+#endif /* XML_SORT_DECORATE */
+
 /*! Sort children of an XML node 
  *
  * Assume populated by yang spec.
@@ -459,12 +1015,19 @@ xml_sort(cxobj *x)
 {
 #ifndef STATE_ORDERED_BY_SYSTEM
     yang_stmt *ys;
+#endif
 
+    xml_sort_pending_set(x, 0);
+#ifndef STATE_ORDERED_BY_SYSTEM
     /* Abort sort if non-config (=state) data */
     if ((ys = xml_spec(x)) != 0 && yang_config(ys)==0)
         return 1;
 #endif
     xml_enumerate_children(x); /* This is to make sorting "stable", ie not change existing order */
+#ifdef XML_SORT_DECORATE
+    if (xml_child_nr(x) >= XML_SORT_DECORATE_MIN)
+        return xml_sort_decorated(x);
+#endif
 #ifdef HAVE_QSORT_S
     qsort_s(xml_childvec_get(x), xml_child_nr(x), sizeof(cxobj *), xml_cmp_qsort, NULL);
 #else
@@ -473,6 +1036,115 @@ xml_sort(cxobj *x)
     return 0;
 }
 
+/*! Sort children appended after a sorted prefix and merge them into place
+ *
+ * The children [0,start) of x are assumed to be sorted and [start,n) to be appended in any
+ * order, eg by xml_addsub in a bulk edit. The appended children are sorted and then merged
+ * with the prefix in one linear pass, instead of n-start insertions using xml_insert.
+ * Existing children are placed before appended children that compare equal.
+ * @param[in] x      XML node
+ * @param[in] start  Number of sorted children
+ * @retval    1      OK, x is not sortable (state data), nothing done
+ * @retval    0      OK
+ * @retval   -1      Error
+ * @see xml_sort  which sorts all children
+ */
+int
+xml_sort_merge(cxobj *x,
+               int    start)
+{
+    int        retval = -1;
+#ifndef STATE_ORDERED_BY_SYSTEM
+    yang_stmt *ys;
+#endif
+    cxobj    **vec;
+    cxobj    **tail = NULL;
+    int        n;
+    int        m;
+    int        i;
+    int        j;
+    int        k;
+
+#ifndef STATE_ORDERED_BY_SYSTEM
+    if ((ys = xml_spec(x)) != 0 && yang_config(ys)==0){
+        retval = 1;
+        goto done;
+    }
+#endif
+    n = xml_child_nr(x);
+    if (start < 0 || start > n){
+        clixon_err(OE_XML, EINVAL, "start %d out of range", start);
+        goto done;
+    }
+    if ((m = n - start) == 0)
+        goto ok;
+    if ((vec = xml_childvec_get(x)) == NULL)
+        goto done;
+    xml_enumerate_children(x); /* Stable, and existing before appended if equal */
+#ifdef HAVE_QSORT_S
+    qsort_s(vec + start, m, sizeof(cxobj *), xml_cmp_qsort, NULL);
+#else
+    qsort_r(vec + start, m, sizeof(cxobj *), xml_cmp_qsort, NULL);
+#endif
+    if (start == 0 || xml_cmp(vec[start-1], vec[start], 1, 0, NULL) <= 0)
+        goto ok; /* Already in place, eg all appended after the existing */
+    if ((tail = malloc(m * sizeof(cxobj *))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memcpy(tail, vec + start, m * sizeof(cxobj *));
+    /* Merge from the end, vec[0,i] with tail[0,j] into vec[0,k] */
+    i = start - 1;
+    j = m - 1;
+    k = n - 1;
+    while (j >= 0){
+        if (i >= 0 && xml_cmp(vec[i], tail[j], 1, 0, NULL) > 0)
+            vec[k--] = vec[i--];
+        else
+            vec[k--] = tail[j--];
+    }
+ ok:
+    retval = 0;
+ done:
+    if (tail)
+        free(tail);
+    return retval;
+}
+
+/*! Sort children of one node if not sorted, help function to xml_sort_recurse
+ *
+ * @param[in]  xn      XML node
+ * @retval     1       This node is not sortable, skip its subtree
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xml_sort1(cxobj *xn)
+{
+    int retval = -1;
+    int ret;
+
+    ret = xml_sort_verify(xn, NULL);
+    if (ret == 1) /* This node is not sortable */
+        goto skip;
+    if (ret == -1){ /* not sorted */
+        if ((ret = xml_sort(xn)) < 0)
+            goto done;
+        if (ret == 1) /* This node is not sortable */
+            goto skip;
+    }
+#ifndef XML_BIND_CV_CACHE
+    if (xml_cv_cache_clear(xn) < 0)
+        goto done;
+#endif
+    retval = 0;
+ done:
+    return retval;
+ skip:
+    retval = 1;
+    goto done;
+}
+
 /*! Recursively sort a tree 
  *
  * Alt to use xml_apply
@@ -487,26 +1159,237 @@ xml_sort_recurse(cxobj *xn)
     cxobj *x;
     int    ret;
 
-    ret = xml_sort_verify(xn, NULL);
+    if ((ret = xml_sort1(xn)) < 0)
+        goto done;
     if (ret == 1) /* This node is not sortable */
         goto ok;
-    if (ret == -1){ /* not sorted */
-        if ((ret = xml_sort(xn)) < 0)
+    x = NULL;
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+        if (xml_sort_recurse(x) < 0)
             goto done;
-        if (ret == 1) /* This node is not sortable */
-            goto ok;
     }
-    if (xml_cv_cache_clear(xn) < 0)
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Recursively mark a tree to be sorted on first keyed access instead of sorting it now
+ *
+ * Intended for trees that are typically only serialized once, such as state data from plugin
+ * callbacks. Children of a marked node are sorted by xml_sort_ensure, which is called
+ * by keyed searches and inserts, diffs, duplicate detection and serialization.
+ * A tree declared sorted by its producer with xml_sorted_declare is left as is.
+ * @param[in]  xn      XML node
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xml_sort_recurse  which sorts directly
+ */
+int
+xml_sort_lazy(cxobj *xn)
+{
+#ifdef XML_SORT_LAZY
+    int    retval = -1;
+    cxobj *x;
+
+    if (xml_sorted_declared(xn))
+        goto ok;
+    if (xml_child_nr(xn) > 1)
+        xml_sort_pending_set(xn, 1);
+    x = NULL;
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+        if (xml_sort_lazy(x) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+#else
+    if (xml_sorted_declared(xn))
+        return 0;
+    return xml_sort_recurse(xn);
+#endif
+}
+
+/*! Sort children of an XML node if sorting is pending
+ *
+ * @param[in]  x   XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see xml_sort_lazy
+ */
+int
+xml_sort_ensure(cxobj *x)
+{
+    if (x == NULL || !xml_sort_pending(x))
+        return 0;
+    if (xml_sort(x) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Recursively sort children of all XML nodes in a tree where sorting is pending
+ *
+ * @param[in]  xn  XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see xml_sort_lazy
+ */
+int
+xml_sort_ensure_recurse(cxobj *xn)
+{
+    int    retval = -1;
+    cxobj *x;
+
+    if (xml_sort_ensure(xn) < 0)
         goto done;
     x = NULL;
     while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
-        if (xml_sort_recurse(x) < 0)
+        if (xml_sort_ensure_recurse(x) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*! Shared state of xml_sort_recurse_threads workers
+ */
+struct xml_sort_work{
+    pthread_mutex_t sw_mutex;
+    clixon_xvec    *sw_units; /* Subtrees to sort */
+    int             sw_next;  /* Next unit to sort */
+    int             sw_err;   /* Set if any unit failed */
+};
+
+/*! Worker thread: sort subtrees until none left
+ */
+static void *
+xml_sort_worker(void *arg)
+{
+    struct xml_sort_work *sw = (struct xml_sort_work *)arg;
+    cxobj                *x;
+    int                   i;
+
+    for (;;){
+        pthread_mutex_lock(&sw->sw_mutex);
+        if (sw->sw_err || (i = sw->sw_next) >= clixon_xvec_len(sw->sw_units))
+            i = -1;
+        else
+            sw->sw_next++;
+        pthread_mutex_unlock(&sw->sw_mutex);
+        if (i < 0)
+            break;
+        x = clixon_xvec_i(sw->sw_units, i);
+        if (xml_sort_recurse(x) < 0){
+            pthread_mutex_lock(&sw->sw_mutex);
+            sw->sw_err++;
+            pthread_mutex_unlock(&sw->sw_mutex);
+        }
+    }
+    return NULL;
+}
+#endif /* HAVE_LIBPTHREAD */
+
+/*! Recursively sort a tree using several threads
+ *
+ * The top levels are sorted in the calling thread until there are enough subtrees, then the
+ * subtrees are sorted by nthreads worker threads. Subtrees are disjoint and sorting only
+ * modifies the nodes of a subtree and reads YANG, whose type caches are set at YANG parse.
+ * Use only on a tree not visible to other code, such as a freshly read datastore.
+ * @param[in]  xn       XML node
+ * @param[in]  nthreads Number of threads, 1 or less sorts in calling thread only
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xml_sort_recurse
+ * @note without pthreads, same as xml_sort_recurse
+ */
+int
+xml_sort_recurse_threads(cxobj *xn,
+                         int    nthreads)
+{
+    int                  retval = -1;
+#ifdef HAVE_LIBPTHREAD
+    struct xml_sort_work sw = {0,};
+    clixon_xvec         *level = NULL;
+    clixon_xvec         *next = NULL;
+    clixon_xvec         *xv;
+    pthread_t           *tids = NULL;
+    cxobj               *x;
+    cxobj               *xc;
+    int                  depth;
+    int                  i;
+    int                  n = 0;
+    int                  ret;
+
+    if (nthreads <= 1)
+        return xml_sort_recurse(xn);
+    if ((level = clixon_xvec_new()) == NULL ||
+        (next = clixon_xvec_new()) == NULL)
+        goto done;
+    if (clixon_xvec_append(level, xn) < 0)
+        goto done;
+    /* Sort top levels here until there are a few subtrees per thread */
+    for (depth=0; depth<XML_SORT_THREAD_DEPTH; depth++){
+        clixon_xvec_free(next);
+        if ((next = clixon_xvec_new()) == NULL)
             goto done;
+        for (i=0; i<clixon_xvec_len(level); i++){
+            x = clixon_xvec_i(level, i);
+            if ((ret = xml_sort1(x)) < 0)
+                goto done;
+            if (ret == 1)
+                continue;
+            xc = NULL;
+            while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+                if (clixon_xvec_append(next, xc) < 0)
+                    goto done;
+        }
+        xv = level; level = next; next = xv;
+        if (clixon_xvec_len(level) >= nthreads * XML_SORT_THREAD_UNITS)
+            break;
+    }
+    if (clixon_xvec_len(level) == 0)
+        goto ok;
+    if (clixon_xvec_len(level) < nthreads)
+        nthreads = clixon_xvec_len(level);
+    if ((tids = calloc(nthreads, sizeof(*tids))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    sw.sw_units = level;
+    if (pthread_mutex_init(&sw.sw_mutex, NULL) != 0){
+        clixon_err(OE_UNIX, errno, "pthread_mutex_init");
+        goto done;
     }
+    for (n=0; n<nthreads; n++)
+        if ((ret = pthread_create(&tids[n], NULL, xml_sort_worker, &sw)) != 0){
+            clixon_err(OE_UNIX, ret, "pthread_create");
+            break;
+        }
+    if (n == 0) /* No threads, sort here */
+        xml_sort_worker(&sw);
+    for (i=0; i<n; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&sw.sw_mutex);
+    if (sw.sw_err)
+        goto done;
  ok:
     retval = 0;
  done:
+    if (tids)
+        free(tids);
+    if (level)
+        clixon_xvec_free(level);
+    if (next)
+        clixon_xvec_free(next);
+    return retval;
+#else
+    retval = xml_sort_recurse(xn);
     return retval;
+#endif /* HAVE_LIBPTHREAD */
 }
 
 /*! Special case search for ordered-by user or state data where linear sort is used
@@ -568,8 +1451,7 @@ xml_find_keys_notsorted(cxobj   *xp,
 
 /*! Find more equal objects in a vector up and down in the array of the present
  *
- * @param[in]  childvec  Vector of children of parent
- * @param[in]  childlen  Length of child vector
+ * @param[in]  xp        Parent XML node
  * @param[in]  x1        XML node to match
  * @param[in]  yangi     Yang order number (according to spec)
  * @param[in]  mid       Where to start from (may be in middle of interval)
@@ -578,8 +1460,7 @@ xml_find_keys_notsorted(cxobj   *xp,
  * @retval    -1         Error
  */
 static int
-search_multi_equals(cxobj  **childvec,
-                    size_t   childlen,
+search_multi_equals(cxobj   *xp,
                     cxobj   *x1,
                     int      yangi,
                     int      mid,
@@ -593,7 +1474,7 @@ search_multi_equals(cxobj  **childvec,
     int        yi;
 
     for (i=mid-1; i>=0; i--){ /* First decrement */
-        xc = childvec[i];
+        xc = xml_child_i(xp, i);
         yc = xml_spec(xc);
         if ((yi = yang_order(yc)) < -1)
             goto done;
@@ -604,8 +1485,8 @@ search_multi_equals(cxobj  **childvec,
         if (clixon_xvec_prepend(xvec, xc) < 0)
             goto done;
     }
-    for (i=mid+1; i<childlen; i++){ /* Then increment */
-        xc = childvec[i];
+    for (i=mid+1; i<xml_child_nr(xp); i++){ /* Then increment */
+        xc = xml_child_i(xp, i);
         yc = xml_spec(xc);
         if ((yi = yang_order(yc)) < -1)
             goto done;
@@ -622,6 +1503,98 @@ search_multi_equals(cxobj  **childvec,
     return retval;
 }
 
+/*! Compare x1 with child i of xp for range search, first on yang order, then on keys
+ *
+ * @param[in]  xp     Parent XML node
+ * @param[in]  x1     XML node to match
+ * @param[in]  yangi  Yang order number of x1
+ * @param[in]  i      Child index of xp
+ * @param[in]  skip1  Key matching skipped for keys not in x1
+ * @retval     0      Equal
+ * @retval    <0      x1 is less than child i
+ * @retval    >0      x1 is greater than child i
+ * @note a child without yang spec is sorted before any yang child
+ */
+static int
+search_range_cmp(cxobj *xp,
+                 cxobj *x1,
+                 int    yangi,
+                 int    i,
+                 int    skip1)
+{
+    cxobj     *xc;
+    yang_stmt *yc;
+    int        cmp;
+
+    xc = xml_child_i(xp, i);
+    if ((yc = xml_spec(xc)) == NULL)
+        return 1;
+    if ((cmp = yangi - yang_order(yc)) != 0)
+        return cmp;
+    return xml_cmp(x1, xc, 0, skip1, NULL);
+}
+
+/*! Find all objects equal to x1 in a sorted list as a contiguous range
+ *
+ * Given that child mid is equal to x1, find the first and last equal children using
+ * binary search on each side of mid and append them in order to xvec.
+ * Since children are sorted on the key tuple, this also works for a prefix of the keys in x1
+ * when skip1 is set, eg x1 with only a first key of a two-key list.
+ * @param[in]  xp        Parent XML node
+ * @param[in]  x1        XML node to match
+ * @param[in]  yangi     Yang order number (according to spec)
+ * @param[in]  low       Lower bound of childvec search interval
+ * @param[in]  mid       Index of a child equal to x1, low <= mid
+ * @param[in]  skip1     Key matching skipped for keys not in x1
+ * @param[out] xvec      Vector of matching XML return objects
+ * @retval     0         OK, see xvec
+ * @retval    -1         Error
+ * @see search_multi_equals  for non-sorted lists
+ */
+static int
+search_range_equals(cxobj       *xp,
+                    cxobj       *x1,
+                    int          yangi,
+                    int          low,
+                    int          mid,
+                    int          skip1,
+                    clixon_xvec *xvec)
+{
+    int retval = -1;
+    int lo;
+    int hi;
+    int m;
+    int i;
+
+    /* First equal: all children in [low,mid) compare less or equal */
+    lo = low;
+    hi = mid;
+    while (lo < hi){
+        m = (lo + hi) / 2;
+        if (search_range_cmp(xp, x1, yangi, m, skip1) > 0)
+            lo = m + 1;
+        else
+            hi = m;
+    }
+    low = lo;
+    /* Last equal + 1: all children after mid compare greater or equal */
+    lo = mid + 1;
+    hi = xml_child_nr(xp);
+    while (lo < hi){
+        m = (lo + hi) / 2;
+        if (search_range_cmp(xp, x1, yangi, m, skip1) < 0)
+            hi = m;
+        else
+            lo = m + 1;
+    }
+    for (i=low; i<lo; i++)
+        if (clixon_xvec_append(xvec, xml_child_i(xp, i)) < 0)
+            goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
 #ifdef XML_EXPLICIT_INDEX
 /* XXX unify with search_multi_equals */
 static int
@@ -838,11 +1811,16 @@ xml_search_binary(cxobj   *xp,
         }
     }
     if (cmp == 0){
+        if (sorted){
+            /* there may be more, eg prefix of keys: find the whole range */
+            if (search_range_equals(xp, x1, yangi, low, mid, skip1, xvec) < 0)
+                goto done;
+            goto ok;
+        }
         if (clixon_xvec_append(xvec, xc) < 0)
             goto done;
         /* there may be more? */
-        if (search_multi_equals(xml_childvec_get(xp), xml_child_nr(xp),
-                                x1, yangi, mid, skip1, xvec) < 0)
+        if (search_multi_equals(xp, x1, yangi, mid, skip1, xvec) < 0)
             goto done;
     }
     else if (cmp < 0)
@@ -885,17 +1863,34 @@ xml_search_yang(cxobj       *xp,
     int    upper = xml_child_nr(xp);
     int    sorted = 1;
     int    yangi;
+#ifdef XML_LIST_HASH
+    int    ret;
+#endif
 
     if (xp == NULL){
         clixon_err(OE_XML, EINVAL, "xp is NULL");
         goto done;
     }
+    if (xml_sort_ensure(xp) < 0)
+        goto done;
+#ifdef XML_LIST_HASH
+    if (indexvar == NULL &&
+        (yang_keyword_get(yc) == Y_LIST || yang_keyword_get(yc) == Y_LEAF_LIST)){
+        if ((ret = xml_hash_find(xp, x1, yc, xvec)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
+    }
+#endif
     upper = xml_child_nr(xp);
     /* Assume if there are any attributes, they are first in the list, mask
        them by raising low to skip them */
     for (low=0; low<upper; low++)
         if ((xa = xml_child_i(xp, low)) == NULL || xml_type(xa) != CX_ATTR)
             break;
+    /* Limit search to children with same yang spec, if cached */
+    if (xml_child_group(xp, yc, &low, &upper) == 1 && low == upper)
+        goto ok;
 #ifndef STATE_ORDERED_BY_SYSTEM
     /* Find if non-config and if ordered-by-user */
     if (yang_config_ancestor(yc)==0)
@@ -908,6 +1903,7 @@ xml_search_yang(cxobj       *xp,
         goto done;
     if (xml_search_binary(xp, x1, sorted, yangi, low, upper, skip1, indexvar, xvec) < 0)
         goto done;
+ ok:
     retval = 0;
  done:
     return retval;
@@ -923,6 +1919,8 @@ xml_search_yang(cxobj       *xp,
  * @param[in] nsc_key Network namespace for key
  * @retval    i       Order where xn should be inserted into xp:s children
  * @retval   -1       Error
+ * Siblings with the same yang spec as xn are adjacent and mid is one of them, so first and
+ * last are found using binary search, and before/after using labels in xml_child_order.
  * LIST: RFC 7950 7.8.6:
  * The value of the "key" attribute is the key predicates of the
  *  full instance identifier (see Section 9.13) for the list entry.
@@ -944,31 +1942,39 @@ xml_insert_userorder(cxobj           *xp,
 {
     int        retval = -1;
     int        i;
+    int        low;
+    int        high;
     cxobj     *xc;
     yang_stmt *yc;
 
     switch (ins){
-    case INS_FIRST:
-        for (i=mid-1; i>=0; i--){ /* decrement */
+    case INS_FIRST: /* Binary search for start of run of yn siblings before mid */
+        low = 0;
+        high = mid;
+        while (low < high){
+            i = (low + high)/2;
             xc = xml_child_i(xp, i);
             yc = xml_spec(xc);
-            if (yc != yn){
-                retval = i+1;
-                goto done;
-            }
+            if (yc == yn)
+                high = i;
+            else
+                low = i+1;
         }
-        retval = i+1;
+        retval = low;
         break;
-    case INS_LAST:
-        for (i=mid+1; i<xml_child_nr(xp); i++){ /* First increment */
+    case INS_LAST: /* Binary search for end of run of yn siblings after mid */
+        low = mid+1;
+        high = xml_child_nr(xp);
+        while (low < high){
+            i = (low + high)/2;
             xc = xml_child_i(xp, i);
             yc = xml_spec(xc);
-            if (yc != yn){
-                retval = i;
-                goto done;
-            }
+            if (yc == yn)
+                low = i+1;
+            else
+                high = i;
         }
-        retval = i;
+        retval = low;
         break;
     case INS_BEFORE:
     case INS_AFTER: /* see retval handling different between before and after */
@@ -1003,7 +2009,6 @@ xml_insert_userorder(cxobj           *xp,
             } /* switch */
         }
     }
- done:
     return retval;
 }
 
@@ -1137,6 +2142,8 @@ xml_insert(cxobj           *xp,
         clixon_err(OE_XML, 0, "No spec found %s", xml_name(xi));
         goto done;
     }
+    if (xml_sort_ensure(xp) < 0)
+        goto done;
     upper = xml_child_nr(xp);
     /* Assume if there are any attributes, they are first in the list, mask
        them by raising low to skip them */
@@ -1162,7 +2169,13 @@ xml_insert(cxobj           *xp,
     xml_parent_set(xi, xp);
     /* clear namespace context cache of child */
     nscache_clear(xi);
-
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_p(xi) &&
+        xml_search_child_insert(xp, xi) < 0)
+        goto done;
+    if (xml_search_list_insert(xi) < 0)
+        goto done;
+#endif
     retval = 0;
  done:
     return retval;
@@ -1374,7 +2387,7 @@ xml_find_noyang_name(cxobj       *xp,
 /*! Try to find an XML child from parent with yang available using list keys and leaf-lists
  *
  * Must be populated with Yang specs, parent must be list or leaf-list, and (for list) search
- * index MUST be keys in the order they are declared.
+ * index MUST be keys in the order they are declared, or a prefix of them.
  * First identify that this search qualifies for yang-based list/leaf-list optimized search,
  * - if no, revert (return 0) so that the overlying algorithm can try next or fallback to
  *   linear seacrh
@@ -1448,6 +2461,16 @@ xml_find_index_yang(cxobj       *xp,
         }
         if (revert)
             break;
+        /* Leading keys only is a range search, which requires the list to be sorted */
+        if (i < cvec_len(ycvk) &&
+            (
+#ifndef STATE_ORDERED_BY_SYSTEM
+             yang_config_ancestor(yc) == 0 ||
+#endif
+             yang_find(yc, Y_ORDERED_BY, "user") != NULL)){
+            revert++;
+            break;
+        }
         cprintf(cb, "</%s>", name);
         break;
     case Y_LEAF_LIST:
@@ -1538,6 +2561,8 @@ xml_find_index_yang(cxobj       *xp,
  * - if xp is leaf-list and "id" is "."
  * - if xp is a yang list and "id" is a registered index key
  * - if xp is a yang list and first "id" is first leaf key, second "id" is second leaf key, etc.
+ *   Leading keys only, eg the first of two keys, is a range search returning all entries
+ *   matching that prefix, provided the list is ordered-by system.
  * - Otherwise search is made using linear search
  * 
  * @param[in]  xp     Parent xml node. 
@@ -1614,9 +2639,10 @@ clixon_xml_find_index(cxobj        *xp,
     return retval;
 }
 
-/*! Find positional parameter in xml child list, eg x/y[42]. Note, not optimized
+/*! Find positional parameter in xml child list, eg x/y[42]
  *
- * Create a temporary search object: a list (xc) with a key (xk) and call the binary search.
+ * If the parent has a cached range of children of yc, see xml_child_group(), the child is
+ * found directly in the sorted child vector. Otherwise the children are scanned.
  * @param[in]  xp     Parent xml node.
  * @param[in]  yc     Yang spec of list child
  * @param[in]  pos    Position
@@ -1634,11 +2660,19 @@ clixon_xml_find_pos(cxobj        *xp,
     cxobj     *xc = NULL;
     char      *name;
     uint32_t   u;
+    int        start;
+    int        end;
 
     if (yc == NULL){
         clixon_err(OE_YANG, ENOENT, "yang spec not found");
         goto done;
     }
+    if (xml_child_group(xp, yc, &start, &end) == 1){
+        if (pos < end - start &&
+            clixon_xvec_append(xvec, xml_child_i(xp, start + pos)) < 0)
+            goto done;
+        goto ok;
+    }
     name = yang_argument_get(yc);
     u = 0;
     xc = NULL;
@@ -1651,6 +2685,7 @@ clixon_xml_find_pos(cxobj        *xp,
             break;
         }
     }
+ ok:
     retval = 0;
  done:
     return retval;
@@ -73,12 +73,17 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <math.h>  /* NaN */
+#include <inttypes.h>
+#include <sys/time.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -102,6 +107,11 @@
 #include "clixon_xpath.h"
 #include "clixon_xpath_parse.h"
 #include "clixon_xpath_eval.h"
+#include "clixon_xpath_compile.h"
+#include "clixon_xpath_deps.h"
+#include "clixon_xpath_optimize.h"
+#include "clixon_xpath_profile.h"
+#include "clixon_probe.h"
 
 /* Use apostrophe(') in XPath literals, eg a/[x='foo'], not double-quotes(")
  * If not set, use ": a/[x="foo"]
@@ -110,10 +120,40 @@
  */
 #define XPATH_USE_APOSTROPHE
 
+#ifdef XPATH_PARSE_CACHE
+/* Max number of cached XPath parse trees, least recently used are evicted */
+#define XPATH_PARSE_CACHE_SIZE 1024
+
+/*
+ * Types
+ */
+/*! Cached parse tree of an XPath expression, see xpath_parse_cache_get
+ */
+struct xpath_cache_entry{
+    qelem_t     xe_q;     /* LRU queue, least recently used first */
+    char       *xe_str;   /* XPath expression, key of cache */
+    xpath_tree *xe_tree;  /* Parse tree */
+    int         xe_refs;  /* Number of current users, not evicted if > 0 */
+};
+#endif
+
 /*
  * Variables
  */
 
+#ifdef XPATH_PARSE_CACHE
+/* Cache of parse trees: XPath string -> struct xpath_cache_entry* */
+static clicon_hash_t            *_xpath_cache = NULL;
+/* LRU queue of cache entries */
+static struct xpath_cache_entry *_xpath_cache_lru = NULL;
+/* Number of cache entries */
+static int                       _xpath_cache_nr = 0;
+#ifdef HAVE_LIBPTHREAD
+/* Cache is used by XPath evaluations in threads, eg parallel validation */
+static pthread_mutex_t           _xpath_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+#endif
+
 /* Mapping between XPath_tree node name string <--> int
  * @see xpath_tree_int2str
  */
@@ -529,10 +569,16 @@ xpath_tree_free(xpath_tree *xs)
         free(xs->xs_s0);
     if (xs->xs_s1)
         free(xs->xs_s1);
+    if (xs->xs_s1i)
+        xml_intern_ref(-1);
     if (xs->xs_c0)
         xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
         xpath_tree_free(xs->xs_c1);
+    if (xs->xs_prog)
+        xpath_prog_free(xs->xs_prog);
+    if (xs->xs_deps)
+        xpath_deps_free(xs->xs_deps);
     free(xs);
     return 0;
 }
@@ -607,6 +653,321 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
+#ifdef XPATH_PARSE_CACHE
+/*! Remove and free an XPath cache entry
+ */
+static int
+xpath_parse_cache_rm(struct xpath_cache_entry *xe)
+{
+    DELQ(xe, _xpath_cache_lru, struct xpath_cache_entry *);
+    if (clicon_hash_del(_xpath_cache, xe->xe_str) < 0)
+        return -1;
+    _xpath_cache_nr--;
+    if (xe->xe_tree)
+        xpath_tree_free(xe->xe_tree);
+    free(xe->xe_str);
+    free(xe);
+    return 0;
+}
+
+/*! Get parse tree of XPath expression from cache, parse and add it if not found
+ *
+ * The parse tree does not depend on namespace context, so the XPath string is the key.
+ * The entry is referenced until released with xpath_parse_cache_release and is not evicted
+ * while referenced, eg by a nested evaluation.
+ * @param[in]  xpath  String with XPath 1.0 syntax
+ * @retval     xe     Cache entry with parse tree in xe_tree
+ * @retval     NULL   Error, eg parse error
+ */
+static struct xpath_cache_entry *
+xpath_parse_cache_get(const char *xpath)
+{
+    struct xpath_cache_entry  *xe = NULL;
+    struct xpath_cache_entry **xep;
+    struct xpath_cache_entry  *xv;
+    xpath_tree                *xpt = NULL;
+    int                        i;
+
+    if (xpath == NULL){
+        clixon_err(OE_XML, EINVAL, "XPath is NULL");
+        return NULL;
+    }
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&_xpath_cache_mutex);
+#endif
+    if (_xpath_cache == NULL &&
+        (_xpath_cache = clicon_hash_init()) == NULL)
+        goto done;
+    if ((xep = clicon_hash_value(_xpath_cache, xpath, NULL)) != NULL){
+        xe = *xep;
+        DELQ(xe, _xpath_cache_lru, struct xpath_cache_entry *);
+        ADDQ(xe, _xpath_cache_lru); /* Most recently used last */
+        xe->xe_refs++;
+        goto done;
+    }
+    if (xpath_parse(xpath, &xpt) < 0)
+        goto done;
+    /* Evict least recently used entry not in use */
+    if (_xpath_cache_nr >= XPATH_PARSE_CACHE_SIZE){
+        xv = _xpath_cache_lru;
+        for (i=0; i<_xpath_cache_nr; i++){
+            if (xv->xe_refs == 0){
+                if (xpath_parse_cache_rm(xv) < 0)
+                    goto done;
+                break;
+            }
+            xv = NEXTQ(struct xpath_cache_entry *, xv);
+        }
+    }
+    if ((xe = calloc(1, sizeof(*xe))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((xe->xe_str = strdup(xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(xe);
+        xe = NULL;
+        goto done;
+    }
+    if (clicon_hash_add(_xpath_cache, xpath, &xe, sizeof(xe)) == NULL){
+        free(xe->xe_str);
+        free(xe);
+        xe = NULL;
+        goto done;
+    }
+    xe->xe_tree = xpt;
+    xpt = NULL;
+    ADDQ(xe, _xpath_cache_lru);
+    _xpath_cache_nr++;
+    xe->xe_refs++;
+ done:
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&_xpath_cache_mutex);
+#endif
+    if (xpt)
+        xpath_tree_free(xpt);
+    return xe;
+}
+
+/*! Release reference of an XPath cache entry
+ */
+static void
+xpath_parse_cache_release(struct xpath_cache_entry *xe)
+{
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&_xpath_cache_mutex);
+#endif
+    if (xe && xe->xe_refs > 0)
+        xe->xe_refs--;
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&_xpath_cache_mutex);
+#endif
+}
+#endif /* XPATH_PARSE_CACHE */
+
+/*! Free all cached XPath parse trees
+ *
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see XPATH_PARSE_CACHE
+ */
+int
+xpath_parse_cache_exit(void)
+{
+#ifdef XPATH_PARSE_CACHE
+    while (_xpath_cache_lru != NULL)
+        if (xpath_parse_cache_rm(_xpath_cache_lru) < 0)
+            return -1;
+    if (_xpath_cache){
+        clicon_hash_free(_xpath_cache);
+        _xpath_cache = NULL;
+    }
+#endif
+    return 0;
+}
+
+#ifdef XPATH_PARSE_CACHE
+/*! Return approximate size of XPath parse tree
+ *
+ * Compiled programs and dependencies of the top node are not included
+ * @param[in]  xs  XPath tree
+ * @retval     sz  Size in bytes
+ */
+static size_t
+xpath_tree_size(xpath_tree *xs)
+{
+    size_t sz = sizeof(*xs);
+
+    if (xs->xs_strnr)
+        sz += strlen(xs->xs_strnr) + 1;
+    if (xs->xs_s0)
+        sz += strlen(xs->xs_s0) + 1;
+    if (xs->xs_s1)
+        sz += strlen(xs->xs_s1) + 1;
+    if (xs->xs_c0)
+        sz += xpath_tree_size(xs->xs_c0);
+    if (xs->xs_c1)
+        sz += xpath_tree_size(xs->xs_c1);
+    return sz;
+}
+#endif
+
+/*! Return number of cached XPath parse trees and their approximate size
+ *
+ * @param[out] nr    Number of cache entries
+ * @param[out] szp   Size in bytes of entries and parse trees
+ * @retval     0     OK
+ * @see XPATH_PARSE_CACHE
+ */
+int
+xpath_parse_cache_stats(uint64_t *nr,
+                        size_t   *szp)
+{
+#ifdef XPATH_PARSE_CACHE
+    struct xpath_cache_entry *xe;
+    size_t                    sz = 0;
+    int                       i;
+
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&_xpath_cache_mutex);
+#endif
+    xe = _xpath_cache_lru;
+    for (i=0; i<_xpath_cache_nr; i++){
+        sz += sizeof(*xe) + strlen(xe->xe_str) + 1;
+        if (xe->xe_tree)
+            sz += xpath_tree_size(xe->xe_tree);
+        xe = NEXTQ(struct xpath_cache_entry *, xe);
+    }
+    *nr = _xpath_cache_nr;
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&_xpath_cache_mutex);
+#endif
+    *szp = sz;
+#else
+    *nr = 0;
+    *szp = 0;
+#endif
+    return 0;
+}
+
+/*! Given XML tree and parsed XPath, eval it and return XPath context, no profiling
+ *
+ * @param[in]  xpath  XPath string of xptree for tracing, or NULL
+ * @see xpath_vec_ctx_tree
+ */
+static int
+xpath_vec_ctx_tree1(cxobj      *xcur,
+                    cvec       *nsc,
+                    const char *xpath,
+                    xpath_tree *xptree,
+                    int         localonly,
+                    xp_ctx    **xrp)
+{
+    int         retval = -1;
+    xp_ctx      xc = {0,};
+
+    CLIXON_PROBE1(xpath__eval__start, xpath);
+    xc.xc_type = XT_NODESET;
+    xc.xc_node = xcur;
+    xc.xc_initial = xcur;
+    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+        goto done;
+    if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (xc.xc_nodeset){
+        free(xc.xc_nodeset);
+        xc.xc_nodeset = NULL;
+    }
+    CLIXON_PROBE2(xpath__eval__done, xpath, retval);
+    return retval;
+}
+
+/*! Given XML tree and parsed XPath, eval it and record evaluation in XPath profile
+ *
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  XPath string of xptree, or NULL: unparse xptree
+ * @param[in]  xptree Parsed XPath tree
+ * @param[in]  localonly Skip prefix and namespace tests
+ * @param[out] xrp    Return XPATH
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xpath_profile_add
+ */
+static int
+xpath_vec_ctx_profile(cxobj      *xcur,
+                      cvec       *nsc,
+                      const char *xpath,
+                      xpath_tree *xptree,
+                      int         localonly,
+                      xp_ctx    **xrp)
+{
+    int            retval = -1;
+    cbuf          *cb = NULL;
+    struct timeval t0;
+    struct timeval t1;
+    struct timeval t;
+    int            hits0;
+    int            misses0;
+    int            hits1;
+    int            misses1;
+    uint64_t       nodes = 0;
+
+    xpath_list_optimize_get(&hits0, &misses0);
+    gettimeofday(&t0, NULL);
+    if (xpath_vec_ctx_tree1(xcur, nsc, xpath, xptree, localonly, xrp) < 0)
+        goto done;
+    gettimeofday(&t1, NULL);
+    xpath_list_optimize_get(&hits1, &misses1);
+    timersub(&t1, &t0, &t);
+    if (*xrp && (*xrp)->xc_type == XT_NODESET)
+        nodes = (*xrp)->xc_size;
+    if (xpath == NULL){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        if (xpath_tree2cbuf(xptree, cb) < 0)
+            goto done;
+        xpath = cbuf_get(cb);
+    }
+    if (xpath_profile_add(xpath, t.tv_sec*1000000ULL + t.tv_usec, nodes,
+                          hits1 - hits0, misses1 - misses0) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Given XML tree and parsed XPath, eval it and return XPath context
+ *
+ * Same as xpath_vec_ctx but with an already parsed XPath, eg precompiled in a yang statement
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xptree Parsed XPath tree
+ * @param[in]  localonly Skip prefix and namespace tests
+ * @param[out] xrp    Return XPATH
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xpath_vec_ctx
+ * @see yang_xpath_get
+ */
+int
+xpath_vec_ctx_tree(cxobj      *xcur,
+                   cvec       *nsc,
+                   xpath_tree *xptree,
+                   int         localonly,
+                   xp_ctx    **xrp)
+{
+    if (xpath_profile_enabled())
+        return xpath_vec_ctx_profile(xcur, nsc, NULL, xptree, localonly, xrp);
+    return xpath_vec_ctx_tree1(xcur, nsc, NULL, xptree, localonly, xrp);
+}
+
 /*! Given XML tree and XPath, parse XPath, eval it and return XPath context,
  *
  * This is a raw form of XPath where you can do type conversion of the return
@@ -635,24 +996,31 @@ xpath_vec_ctx(cxobj      *xcur,
 {
     int         retval = -1;
     xpath_tree *xptree = NULL;
-    xp_ctx      xc = {0,};
+#ifdef XPATH_PARSE_CACHE
+    struct xpath_cache_entry *xe;
+#endif
 
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpath);
-    if (xpath_parse(xpath, &xptree) < 0)
+#ifdef XPATH_PARSE_CACHE
+    if ((xe = xpath_parse_cache_get(xpath)) == NULL)
         goto done;
-    xc.xc_type = XT_NODESET;
-    xc.xc_node = xcur;
-    xc.xc_initial = xcur;
-    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+    if (xpath_profile_enabled())
+        retval = xpath_vec_ctx_profile(xcur, nsc, xpath, xe->xe_tree, localonly, xrp);
+    else
+        retval = xpath_vec_ctx_tree1(xcur, nsc, xpath, xe->xe_tree, localonly, xrp);
+    xpath_parse_cache_release(xe);
+#else
+    if (xpath_parse(xpath, &xptree) < 0)
         goto done;
-    if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
+    if (xpath_profile_enabled()){
+        if (xpath_vec_ctx_profile(xcur, nsc, xpath, xptree, localonly, xrp) < 0)
+            goto done;
+    }
+    else if (xpath_vec_ctx_tree1(xcur, nsc, xpath, xptree, localonly, xrp) < 0)
         goto done;
     retval = 0;
+#endif
  done:
-    if (xc.xc_nodeset){
-        free(xc.xc_nodeset);
-        xc.xc_nodeset = NULL;
-    }
     if (xptree)
         xpath_tree_free(xptree);
     return retval;
@@ -979,6 +1347,42 @@ xpath_vec_bool(cxobj      *xcur,
     return retval;
 }
 
+/*! Given XML tree and parsed XPath, eval it and return boolean result
+ *
+ * @param[in]  xcur     xml-tree where to search
+ * @param[in]  nsc      External XML namespace context, or NULL
+ * @param[in]  xptree   Parsed XPath, eg from yang_xpath_get
+ * @retval     1        True
+ * @retval     0        False
+ * @retval    -1        Error
+ * @see xpath_vec_bool
+ */
+int
+xpath_vec_bool_tree(cxobj      *xcur,
+                    cvec       *nsc,
+                    xpath_tree *xptree)
+{
+    int     retval = -1;
+    xp_ctx *xr = NULL;
+    int     ret;
+    int     b;
+
+    if ((ret = xpath_compile_bool(xcur, nsc, xptree, &b)) < 0)
+        goto done;
+    if (ret == 1){ /* Compiled */
+        retval = b;
+        goto done;
+    }
+    if (xpath_vec_ctx_tree(xcur, nsc, xptree, 0, &xr) < 0)
+        goto done;
+    if (xr)
+        retval = ctx2boolean(xr);
+ done:
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
 /*! Translate literal string to "canonical" form
  *
  * the prefix according to actual namespace.
@@ -0,0 +1,879 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Clixon XML XPath 1.0 according to https://www.w3.org/TR/xpath-10
+ * Compiled XPath evaluation, see XPATH_COMPILE
+ * An XPath parse tree is compiled into a tree of code nodes where location paths are flat
+ * vectors of steps with node-set buffers kept between evaluations.
+ * Only a subset is compiled, which covers most YANG must and when expressions:
+ * - Location paths with child, self and parent steps and predicates, absolute or starting
+ *   with current()
+ * - and, or, relational and numeric operators
+ * - Literals, numbers, current(), count(), boolean(), not(), true() and false()
+ * Other expressions are evaluated by xp_eval() as before.
+ * Semantics are those of xp_eval(), including operators which are shared with it.
+ */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <syslog.h>
+#include <fcntl.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_xml_vec.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xpath_optimize.h"
+#include "clixon_xpath_function.h"
+#include "clixon_xpath_eval.h"
+#include "clixon_xpath_compile.h"
+
+#ifdef XPATH_COMPILE
+/*
+ * Types
+ */
+/*! Code node type */
+enum xpc_op{
+    XPC_PATH,     /* Location path */
+    XPC_LOGOP,    /* and, or */
+    XPC_RELOP,    /* =, !=, <, etc */
+    XPC_NUMOP,    /* +, -, *, div, mod */
+    XPC_STRING,   /* Literal */
+    XPC_NUMBER,   /* Number */
+    XPC_CURRENT,  /* current() */
+    XPC_COUNT,    /* count(c0) */
+    XPC_BOOLEAN,  /* boolean(c0) */
+    XPC_NOT,      /* not(c0) */
+    XPC_TRUE,     /* true() */
+    XPC_FALSE,    /* false() */
+};
+
+/*! Start of location path */
+enum xpc_start{
+    XPC_START_CONTEXT, /* Relative path: context node */
+    XPC_START_ROOT,    /* Absolute path: top node */
+    XPC_START_CURRENT, /* current()/...: initial node */
+};
+
+struct xpc_code;
+
+/*! Location step */
+struct xpc_step{
+    int               st_axis;   /* A_CHILD, A_SELF or A_PARENT */
+    xpath_tree       *st_tree;   /* Original XP_STEP: nodetest and list optimization */
+    int               st_npred;  /* Number of predicates */
+    struct xpc_code **st_preds;  /* Predicates in order */
+};
+
+/*! Compiled XPath code node */
+struct xpc_code{
+    enum xpc_op      pc_op;
+    enum xp_op       pc_int;     /* Operator if XPC_LOGOP, XPC_RELOP or XPC_NUMOP */
+    struct xpc_code *pc_c0;      /* Operand 1 */
+    struct xpc_code *pc_c1;      /* Operand 2 */
+    char            *pc_str;     /* XPC_STRING, pointer into parse tree */
+    double           pc_number;  /* XPC_NUMBER */
+    enum xpc_start   pc_start;   /* XPC_PATH */
+    int              pc_nsteps;  /* XPC_PATH: number of steps, 0 means single "/" */
+    struct xpc_step *pc_steps;   /* XPC_PATH: steps */
+    cxobj          **pc_vec[2];  /* Node-set buffers, alternating between steps */
+    int              pc_max[2];  /* Allocated length of node-set buffers */
+};
+
+/*! Compiled XPath, kept in the top node of the parse tree */
+struct xpath_prog{
+    struct xpc_code *xp_code;  /* NULL if XPath is not compilable, use xp_eval */
+    int              xp_busy;  /* Being evaluated, nested calls use xp_eval */
+};
+
+/*! Evaluation environment, corresponds to the context of xp_eval */
+struct xpc_env{
+    cxobj *xe_node;      /* Context node. Absolute paths set it to top as xp_eval does */
+    cxobj *xe_initial;   /* Initial node, for current() */
+    cvec  *xe_nsc;       /* XML Namespace context */
+    int    xe_localonly; /* Skip prefix and namespace tests */
+};
+
+static int xpc_compile(xpath_tree *xs, struct xpc_code **pcp);
+static int xpc_eval(struct xpc_code *pc, struct xpc_env *xe, xp_ctx *xr);
+
+/*! Free compiled code node recursively
+ */
+static int
+xpc_free(struct xpc_code *pc)
+{
+    int i;
+    int j;
+
+    if (pc->pc_c0)
+        xpc_free(pc->pc_c0);
+    if (pc->pc_c1)
+        xpc_free(pc->pc_c1);
+    if (pc->pc_steps){
+        for (i=0; i<pc->pc_nsteps; i++){
+            if (pc->pc_steps[i].st_preds){
+                for (j=0; j<pc->pc_steps[i].st_npred; j++)
+                    if (pc->pc_steps[i].st_preds[j])
+                        xpc_free(pc->pc_steps[i].st_preds[j]);
+                free(pc->pc_steps[i].st_preds);
+            }
+        }
+        free(pc->pc_steps);
+    }
+    if (pc->pc_vec[0])
+        free(pc->pc_vec[0]);
+    if (pc->pc_vec[1])
+        free(pc->pc_vec[1]);
+    free(pc);
+    return 0;
+}
+
+/*! Create new compiled code node
+ */
+static struct xpc_code *
+xpc_new(enum xpc_op op)
+{
+    struct xpc_code *pc;
+
+    if ((pc = malloc(sizeof(*pc))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(pc, 0, sizeof(*pc));
+    pc->pc_op = op;
+    return pc;
+}
+
+/*! Count steps of a relative location path, and check they can be compiled
+ *
+ * @param[in]  xs   XPath tree of type XP_RELLOCPATH
+ * @param[out] n    Number of steps
+ * @retval     1    OK
+ * @retval     0    Not compilable
+ */
+static int
+xpc_steps_count(xpath_tree *xs,
+                int        *n)
+{
+    xpath_tree *xstep;
+
+    if (xs->xs_type != XP_RELLOCPATH || xs->xs_int == A_DESCENDANT_OR_SELF)
+        return 0;
+    if (xs->xs_c1 == NULL)
+        xstep = xs->xs_c0;
+    else {
+        if (xs->xs_c0 == NULL || xpc_steps_count(xs->xs_c0, n) == 0)
+            return 0;
+        xstep = xs->xs_c1;
+    }
+    if (xstep == NULL || xstep->xs_type != XP_STEP)
+        return 0;
+    switch (xstep->xs_int){
+    case A_CHILD:
+        if (xstep->xs_c0 == NULL)
+            return 0;
+        break;
+    case A_SELF:
+    case A_PARENT:
+        break;
+    default:
+        return 0;
+    }
+    (*n)++;
+    return 1;
+}
+
+/*! Compile predicates of a step
+ *
+ * @param[in]  xs   XPath tree of type XP_PRED
+ * @param[in]  st   Step
+ * @retval     1    OK
+ * @retval     0    Not compilable
+ * @retval    -1    Error
+ */
+static int
+xpc_compile_preds(xpath_tree      *xs,
+                  struct xpc_step *st)
+{
+    int        ret;
+    xpath_tree *xp;
+    int         i;
+
+    for (xp = xs; xp != NULL; xp = xp->xs_c0){
+        if (xp->xs_type != XP_PRED)
+            return 0;
+        if (xp->xs_c1)
+            st->st_npred++;
+    }
+    if (st->st_npred == 0)
+        return 1;
+    if ((st->st_preds = calloc(st->st_npred, sizeof(struct xpc_code *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    /* Innermost predicate is evaluated first */
+    i = st->st_npred;
+    for (xp = xs; xp != NULL; xp = xp->xs_c0){
+        if (xp->xs_c1 == NULL)
+            continue;
+        if ((ret = xpc_compile(xp->xs_c1, &st->st_preds[--i])) <= 0)
+            return ret;
+    }
+    return 1;
+}
+
+/*! Compile steps of a relative location path
+ *
+ * @param[in]  xs   XPath tree of type XP_RELLOCPATH
+ * @param[in]  pc   Code node of type XPC_PATH with allocated steps
+ * @param[in]  i    Index of last step of xs
+ * @retval     1    OK
+ * @retval     0    Not compilable
+ * @retval    -1    Error
+ */
+static int
+xpc_compile_steps(xpath_tree      *xs,
+                  struct xpc_code *pc,
+                  int              i)
+{
+    int              ret;
+    xpath_tree      *xstep;
+    struct xpc_step *st;
+
+    if (xs->xs_c1 == NULL)
+        xstep = xs->xs_c0;
+    else {
+        if ((ret = xpc_compile_steps(xs->xs_c0, pc, i-1)) <= 0)
+            return ret;
+        xstep = xs->xs_c1;
+    }
+    st = &pc->pc_steps[i];
+    st->st_axis = xstep->xs_int;
+    st->st_tree = xstep;
+    if (xstep->xs_c1)
+        return xpc_compile_preds(xstep->xs_c1, st);
+    return 1;
+}
+
+/*! Compile a location path
+ *
+ * @param[in]  xs    XPath tree of type XP_RELLOCPATH or NULL for single "/"
+ * @param[in]  start Start of path
+ * @param[out] pcp   Code node
+ * @retval     1     OK
+ * @retval     0     Not compilable
+ * @retval    -1     Error
+ */
+static int
+xpc_compile_path(xpath_tree       *xs,
+                 enum xpc_start    start,
+                 struct xpc_code **pcp)
+{
+    struct xpc_code *pc;
+    int              n = 0;
+
+    if (xs != NULL && xpc_steps_count(xs, &n) == 0)
+        return 0;
+    if ((pc = xpc_new(XPC_PATH)) == NULL)
+        return -1;
+    *pcp = pc;
+    pc->pc_start = start;
+    pc->pc_nsteps = n;
+    if (n == 0)
+        return 1;
+    if ((pc->pc_steps = calloc(n, sizeof(struct xpc_step))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    return xpc_compile_steps(xs, pc, n-1);
+}
+
+/*! Get single argument of function call
+ *
+ * @param[in]  xs   XPath tree of type XP_PRIME_FN
+ * @retval     xa   Argument expression
+ * @retval     NULL None or several arguments
+ */
+static xpath_tree*
+xpc_fn_arg(xpath_tree *xs)
+{
+    if (xs->xs_c0 == NULL || xs->xs_c0->xs_c1 != NULL)
+        return NULL;
+    return xs->xs_c0->xs_c0;
+}
+
+/*! Compile XPath parse tree to code node
+ *
+ * @param[in]  xs   XPath tree
+ * @param[out] pcp  Code node, partially compiled on 0 or -1, free with xpc_free
+ * @retval     1    OK
+ * @retval     0    Not compilable, use xp_eval
+ * @retval    -1    Error
+ */
+static int
+xpc_compile(xpath_tree       *xs,
+            struct xpc_code **pcp)
+{
+    int              ret;
+    struct xpc_code *pc = NULL;
+    xpath_tree      *xa;
+    enum xpc_op      op;
+
+    switch (xs->xs_type){
+    case XP_EXP:
+    case XP_AND:
+    case XP_RELEX:
+    case XP_ADD:
+    case XP_UNION:
+    case XP_PATHEXPR:
+    case XP_FILTEREXPR:
+    case XP_LOCPATH:
+    case XP_PRI0:
+        if (xs->xs_c0 == NULL)
+            return 0;
+        if (xs->xs_c1 == NULL) /* Single operand, transparent */
+            return xpc_compile(xs->xs_c0, pcp);
+        switch (xs->xs_type){
+        case XP_AND:
+            op = XPC_LOGOP;
+            break;
+        case XP_RELEX:
+            op = XPC_RELOP;
+            break;
+        case XP_ADD:
+            op = XPC_NUMOP;
+            break;
+        case XP_PATHEXPR:
+            /* Only current()/<rellocpath> */
+            if (xs->xs_s0 == NULL || strcmp(xs->xs_s0, "/") != 0)
+                return 0;
+            if ((xa = xs->xs_c0)->xs_type != XP_FILTEREXPR ||
+                (xa = xa->xs_c0) == NULL ||
+                xa->xs_type != XP_PRIME_FN ||
+                xa->xs_int != XPATHFN_CURRENT ||
+                xa->xs_c0 != NULL)
+                return 0;
+            return xpc_compile_path(xs->xs_c1, XPC_START_CURRENT, pcp);
+        default:
+            return 0;
+        }
+        if ((pc = xpc_new(op)) == NULL)
+            return -1;
+        *pcp = pc;
+        pc->pc_int = xs->xs_int;
+        if ((ret = xpc_compile(xs->xs_c0, &pc->pc_c0)) <= 0)
+            return ret;
+        return xpc_compile(xs->xs_c1, &pc->pc_c1);
+    case XP_ABSPATH:
+        if (xs->xs_int != A_ROOT)
+            return 0;
+        return xpc_compile_path(xs->xs_c0, XPC_START_ROOT, pcp);
+    case XP_RELLOCPATH:
+        return xpc_compile_path(xs, XPC_START_CONTEXT, pcp);
+    case XP_PRIME_STR:
+        if ((pc = xpc_new(XPC_STRING)) == NULL)
+            return -1;
+        *pcp = pc;
+        pc->pc_str = xs->xs_s0;
+        return 1;
+    case XP_PRIME_NR:
+        if ((pc = xpc_new(XPC_NUMBER)) == NULL)
+            return -1;
+        *pcp = pc;
+        pc->pc_number = xs->xs_double;
+        return 1;
+    case XP_PRIME_FN:
+        if (xs->xs_s0 == NULL)
+            return 0;
+        xa = NULL;
+        switch (xs->xs_int){
+        case XPATHFN_CURRENT:
+        case XPATHFN_TRUE:
+        case XPATHFN_FALSE:
+            if (xs->xs_c0 != NULL)
+                return 0;
+            op = xs->xs_int == XPATHFN_CURRENT ? XPC_CURRENT :
+                xs->xs_int == XPATHFN_TRUE ? XPC_TRUE : XPC_FALSE;
+            break;
+        case XPATHFN_COUNT:
+        case XPATHFN_BOOLEAN:
+        case XPATHFN_NOT:
+            if ((xa = xpc_fn_arg(xs)) == NULL)
+                return 0;
+            op = xs->xs_int == XPATHFN_COUNT ? XPC_COUNT :
+                xs->xs_int == XPATHFN_BOOLEAN ? XPC_BOOLEAN : XPC_NOT;
+            break;
+        default:
+            return 0;
+        }
+        if ((pc = xpc_new(op)) == NULL)
+            return -1;
+        *pcp = pc;
+        if (xa)
+            return xpc_compile(xa, &pc->pc_c0);
+        return 1;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*! Append node to node-set buffer of code node
+ *
+ * @param[in]     pc   Code node
+ * @param[in]     k    Buffer index
+ * @param[in]     x    XML node
+ * @param[in,out] len  Length of node-set in buffer
+ * @retval        0    OK
+ * @retval       -1    Error
+ */
+static int
+xpc_vec_append(struct xpc_code *pc,
+               int              k,
+               cxobj           *x,
+               int             *len)
+{
+    cxobj **vec;
+    int     max;
+
+    if (*len >= pc->pc_max[k]){
+        max = pc->pc_max[k] ? 2*pc->pc_max[k] : 16;
+        if ((vec = realloc(pc->pc_vec[k], max*sizeof(cxobj *))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        pc->pc_vec[k] = vec;
+        pc->pc_max[k] = max;
+    }
+    pc->pc_vec[k][(*len)++] = x;
+    return 0;
+}
+
+/*! Evaluate one location step into a node-set buffer
+ *
+ * @param[in]  pc    Code node of type XPC_PATH
+ * @param[in]  st    Step
+ * @param[in]  xe    Evaluation environment
+ * @param[in]  vec   Input node-set
+ * @param[in]  veclen Length of input node-set
+ * @param[in]  k     Index of output buffer, not the buffer of vec
+ * @param[out] len   Length of output node-set
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xp_eval_step
+ * @see xp_eval_predicate
+ */
+static int
+xpc_eval_step(struct xpc_code *pc,
+              struct xpc_step *st,
+              struct xpc_env  *xe,
+              cxobj          **vec,
+              int              veclen,
+              int              k,
+              int             *len)
+{
+    int            retval = -1;
+    int            i;
+    int            j;
+    int            p;
+    int            n = 0;
+    int            keep;
+    int            ret;
+    cxobj         *x;
+    cxobj         *xv;
+    cxobj        **vec0;
+    int            veclen0;
+    struct xpc_env xe1;
+    xp_ctx         xr;
+
+    switch (st->st_axis){
+    case A_CHILD:
+        for (i=0; i<veclen; i++){
+            xv = vec[i];
+            ret = 0;
+            if (st->st_npred){
+                vec0 = NULL;
+                veclen0 = 0;
+                if ((ret = xpath_optimize_check(st->st_tree, xv, &vec0, &veclen0)) < 0)
+                    goto done;
+                if (ret == 1){
+                    for (j=0; j<veclen0; j++)
+                        if (xpc_vec_append(pc, k, vec0[j], &n) < 0){
+                            free(vec0);
+                            goto done;
+                        }
+                    if (vec0)
+                        free(vec0);
+                }
+            }
+            if (ret == 0){
+                x = NULL;
+                while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+                    if (nodetest_eval(x, st->st_tree->xs_c0, xe->xe_nsc, xe->xe_localonly) == 1)
+                        if (xpc_vec_append(pc, k, x, &n) < 0)
+                            goto done;
+                }
+            }
+        }
+        break;
+    case A_SELF:
+        for (i=0; i<veclen; i++)
+            if (xpc_vec_append(pc, k, vec[i], &n) < 0)
+                goto done;
+        break;
+    case A_PARENT:
+        for (i=0; i<veclen; i++){
+            x = vec[i];
+            if ((xv = xml_parent(x)) != NULL
+#ifdef XML_PARENT_CANDIDATE
+                || (xv = xml_parent_candidate(x)) != NULL
+#endif
+                )
+                if (xpc_vec_append(pc, k, xv, &n) < 0)
+                    goto done;
+        }
+        break;
+    default:
+        clixon_err(OE_XML, EFAULT, "Unexpected axis: %d", st->st_axis);
+        goto done;
+    }
+    /* Filter node-set in place with each predicate, position is before filtering */
+    xe1 = *xe;
+    for (p=0; p<st->st_npred; p++){
+        j = 0;
+        for (i=0; i<n; i++){
+            x = pc->pc_vec[k][i];
+            xe1.xe_node = x;
+            if (xpc_eval(st->st_preds[p], &xe1, &xr) < 0)
+                goto done;
+            if (xr.xc_type == XT_NUMBER)
+                keep = ((int)xr.xc_number == i);
+            else
+                keep = ctx2boolean(&xr);
+            if (keep)
+                pc->pc_vec[k][j++] = x;
+        }
+        n = j;
+    }
+    *len = n;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Evaluate location path
+ *
+ * @param[in]  pc   Code node of type XPC_PATH
+ * @param[in]  xe   Evaluation environment
+ * @param[out] xr   Result node-set, points to a buffer of pc
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xpc_eval_path(struct xpc_code *pc,
+              struct xpc_env  *xe,
+              xp_ctx          *xr)
+{
+    int     retval = -1;
+    cxobj  *x0;
+    cxobj  *x;
+    cxobj **vec;
+    int     veclen;
+    int     i;
+    int     k = 0;
+
+    switch (pc->pc_start){
+    case XPC_START_CONTEXT:
+        x0 = xe->xe_node;
+        break;
+    case XPC_START_ROOT:
+        x0 = xe->xe_node;
+#ifdef XML_PARENT_CANDIDATE
+        while (xml_parent(x0) != NULL || xml_parent_candidate(x0) != NULL)
+            x0 = xml_parent(x0)?xml_parent(x0):xml_parent_candidate(x0);
+#else
+        while (xml_parent(x0) != NULL)
+            x0 = xml_parent(x0);
+#endif
+        xe->xe_node = x0; /* As xp_eval sets context node */
+        break;
+    case XPC_START_CURRENT:
+    default:
+        x0 = xe->xe_initial;
+        break;
+    }
+    vec = &x0;
+    veclen = 1;
+    if (pc->pc_nsteps == 0){ /* Single "/": children of top */
+        veclen = 0;
+        x = NULL;
+        while ((x = xml_child_each(x0, x, CX_ELMNT)) != NULL)
+            if (xpc_vec_append(pc, k, x, &veclen) < 0)
+                goto done;
+        vec = pc->pc_vec[k];
+    }
+    for (i=0; i<pc->pc_nsteps; i++){
+        if (xpc_eval_step(pc, &pc->pc_steps[i], xe, vec, veclen, k, &veclen) < 0)
+            goto done;
+        vec = pc->pc_vec[k];
+        k = !k;
+    }
+    xr->xc_type = XT_NODESET;
+    xr->xc_nodeset = vec;
+    xr->xc_size = veclen;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Count children of a location path of parent steps and a last child step
+ *
+ * Eg count(../entry), see xp_count_children
+ * @param[in]  pc     Code node, argument of count()
+ * @param[in]  xe     Evaluation environment
+ * @param[out] count  Number of nodes
+ * @retval     1      OK, count is set
+ * @retval     0      Not applicable, evaluate path
+ */
+static int
+xpc_count_children(struct xpc_code *pc,
+                   struct xpc_env  *xe,
+                   int             *count)
+{
+    struct xpc_step *st;
+    cxobj           *x;
+    int              i;
+
+    if (pc->pc_op != XPC_PATH || pc->pc_nsteps == 0 || pc->pc_start == XPC_START_ROOT)
+        return 0;
+    x = pc->pc_start == XPC_START_CONTEXT ? xe->xe_node : xe->xe_initial;
+    for (i=0; i<pc->pc_nsteps-1; i++){
+        st = &pc->pc_steps[i];
+        if (st->st_axis != A_PARENT || st->st_npred || st->st_tree->xs_c0 != NULL)
+            return 0;
+        if ((x = xml_parent(x)) == NULL)
+            return 0;
+    }
+    st = &pc->pc_steps[pc->pc_nsteps-1];
+    if (st->st_axis != A_CHILD || st->st_npred)
+        return 0;
+    return xp_count_children(x, st->st_tree->xs_c0, xe->xe_nsc, xe->xe_localonly, count);
+}
+
+/*! Evaluate compiled code node
+ *
+ * @param[in]  pc   Code node
+ * @param[in]  xe   Evaluation environment
+ * @param[out] xr   Result, node-sets and strings point into pc and parse tree, do not free
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xpc_eval(struct xpc_code *pc,
+         struct xpc_env  *xe,
+         xp_ctx          *xr)
+{
+    int    retval = -1;
+    xp_ctx xr0;
+    xp_ctx xr1;
+    int    b;
+    int    n;
+
+    memset(xr, 0, sizeof(*xr));
+    xr->xc_initial = xe->xe_initial;
+    switch (pc->pc_op){
+    case XPC_PATH:
+        if (xpc_eval_path(pc, xe, xr) < 0)
+            goto done;
+        break;
+    case XPC_LOGOP:
+    case XPC_RELOP:
+    case XPC_NUMOP:
+        /* Both operands are evaluated, as in xp_eval */
+        if (xpc_eval(pc->pc_c0, xe, &xr0) < 0)
+            goto done;
+        if (xpc_eval(pc->pc_c1, xe, &xr1) < 0)
+            goto done;
+        if (pc->pc_op == XPC_LOGOP)
+            retval = xp_logop1(&xr0, &xr1, pc->pc_int, xr);
+        else if (pc->pc_op == XPC_RELOP)
+            retval = xp_relop1(&xr0, &xr1, pc->pc_int, xr);
+        else
+            retval = xp_numop1(&xr0, &xr1, pc->pc_int, xr);
+        if (retval < 0)
+            goto done;
+        break;
+    case XPC_STRING:
+        xr->xc_type = XT_STRING;
+        xr->xc_string = pc->pc_str;
+        break;
+    case XPC_NUMBER:
+        xr->xc_type = XT_NUMBER;
+        xr->xc_number = pc->pc_number;
+        break;
+    case XPC_CURRENT:
+        xr->xc_type = XT_NODESET;
+        xr->xc_nodeset = &xe->xe_initial;
+        xr->xc_size = 1;
+        break;
+    case XPC_COUNT:
+        xr->xc_type = XT_NUMBER;
+        if (xpc_count_children(pc->pc_c0, xe, &n) == 1){
+            xr->xc_number = n;
+            break;
+        }
+        if (xpc_eval(pc->pc_c0, xe, &xr0) < 0)
+            goto done;
+        xr->xc_number = xr0.xc_size;
+        break;
+    case XPC_BOOLEAN:
+    case XPC_NOT:
+        if (xpc_eval(pc->pc_c0, xe, &xr0) < 0)
+            goto done;
+        b = ctx2boolean(&xr0);
+        xr->xc_type = XT_BOOL;
+        xr->xc_bool = pc->pc_op == XPC_NOT ? !b : b;
+        break;
+    case XPC_TRUE:
+    case XPC_FALSE:
+        xr->xc_type = XT_BOOL;
+        xr->xc_bool = pc->pc_op == XPC_TRUE;
+        break;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+#endif /* XPATH_COMPILE */
+
+/*! Free compiled XPath
+ *
+ * @param[in]  prog  Compiled XPath
+ * @retval     0     OK
+ */
+int
+xpath_prog_free(struct xpath_prog *prog)
+{
+#ifdef XPATH_COMPILE
+    if (prog->xp_code)
+        xpc_free(prog->xp_code);
+    free(prog);
+#endif
+    return 0;
+}
+
+/*! Evaluate parsed XPath to boolean using compiled code if applicable
+ *
+ * The XPath is compiled on first call and the result is kept in the top node of the
+ * parse tree. If not compilable, or if in use by an enclosing call, return 0 and the
+ * caller uses regular evaluation.
+ * @param[in]  xcur    XML-tree where to search
+ * @param[in]  nsc     External XML namespace context, or NULL
+ * @param[in]  xptree  Parsed XPath
+ * @param[out] result  Boolean result if retval is 1
+ * @retval     1       Evaluated, see result
+ * @retval     0       Not evaluated, use regular evaluation
+ * @retval    -1       Error
+ * @see xpath_vec_bool_tree
+ */
+int
+xpath_compile_bool(cxobj      *xcur,
+                   cvec       *nsc,
+                   xpath_tree *xptree,
+                   int        *result)
+{
+#ifdef XPATH_COMPILE
+    int                retval = -1;
+    int                ret;
+    struct xpath_prog *prog;
+    struct xpc_env     xe = {0,};
+    xp_ctx             xr;
+
+    if ((prog = xptree->xs_prog) == NULL){
+        if ((prog = malloc(sizeof(*prog))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(prog, 0, sizeof(*prog));
+        xptree->xs_prog = prog;
+        ret = xpc_compile(xptree, &prog->xp_code);
+        if (ret <= 0 && prog->xp_code){ /* Partially compiled */
+            xpc_free(prog->xp_code);
+            prog->xp_code = NULL;
+        }
+        if (ret < 0)
+            goto done;
+    }
+    if (prog->xp_code == NULL || prog->xp_busy)
+        goto ok;
+    xe.xe_node = xcur;
+    xe.xe_initial = xcur;
+    xe.xe_nsc = nsc;
+    xe.xe_localonly = 0;
+    prog->xp_busy = 1;
+    ret = xpc_eval(prog->xp_code, &xe, &xr);
+    prog->xp_busy = 0;
+    if (ret < 0)
+        goto done;
+    *result = ctx2boolean(&xr);
+    retval = 1;
+ done:
+    return retval;
+ ok:
+    retval = 0;
+    goto done;
+#else
+    return 0;
+#endif /* XPATH_COMPILE */
+}
@@ -36,6 +36,10 @@
  * Clixon XML XPath 1.0 according to https://www.w3.org/TR/xpath-10
  * This file defines XPath contexts used in traversing the XPath parse tree.
  */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -63,6 +67,7 @@
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_xpath_parse.h"
+#include "clixon_alloc_profile.h"
 
 /*
  * Variables
@@ -75,12 +80,106 @@ const map_str2int ctxmap[] = {
     {NULL,        -1}
 };
 
+#ifdef XPATH_NODESET_POOL
+/* Max number of kept node-set buffers */
+#define XPATH_NODESET_POOL_SIZE 32
+
+/* Max length of a kept node-set buffer, larger are freed */
+#define XPATH_NODESET_POOL_MAXLEN 4096
+
+/* The pool is per thread since predicates may be evaluated in threads, see
+ * CLICON_XPATH_THREADS. Threads free their pool with ctx_nodeset_pool_exit */
+#ifdef HAVE_LIBPTHREAD
+#define NODESET_POOL_LOCAL __thread
+#else
+#define NODESET_POOL_LOCAL
+#endif
+
+/* Pool of free node-set buffers and their allocated lengths */
+static NODESET_POOL_LOCAL cxobj **_nodeset_pool[XPATH_NODESET_POOL_SIZE];
+static NODESET_POOL_LOCAL int     _nodeset_pool_max[XPATH_NODESET_POOL_SIZE];
+static NODESET_POOL_LOCAL int     _nodeset_pool_len = 0;
+#endif /* XPATH_NODESET_POOL */
+
+/*! Get a node-set buffer, from pool if possible
+ *
+ * @param[in]  len   Minimum length
+ * @param[out] max   Allocated length
+ * @retval     vec   Node-set buffer, free with ctx_nodeset_put
+ * @retval     NULL  Error
+ */
+static cxobj **
+ctx_nodeset_get(int  len,
+                int *max)
+{
+    cxobj **vec;
+#ifdef XPATH_NODESET_POOL
+    int     i;
+
+    for (i=_nodeset_pool_len-1; i>=0; i--){
+        if (_nodeset_pool_max[i] >= len){
+            vec = _nodeset_pool[i];
+            *max = _nodeset_pool_max[i];
+            _nodeset_pool_len--;
+            _nodeset_pool[i] = _nodeset_pool[_nodeset_pool_len];
+            _nodeset_pool_max[i] = _nodeset_pool_max[_nodeset_pool_len];
+            return vec;
+        }
+    }
+    if (len < 16)
+        len = 16;
+#endif
+    if ((vec = malloc(len*sizeof(cxobj *))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    ALLOC_PROFILE_COUNT(ALLOC_XPATH);
+    *max = len;
+    return vec;
+}
+
+/*! Release a node-set buffer, keep it in pool if possible
+ *
+ * @param[in]  vec   Node-set buffer
+ * @param[in]  max   Allocated length, or 0 if not known
+ */
+static void
+ctx_nodeset_put(cxobj **vec,
+                int     max)
+{
+#ifdef XPATH_NODESET_POOL
+    if (max > 0 &&
+        max <= XPATH_NODESET_POOL_MAXLEN &&
+        _nodeset_pool_len < XPATH_NODESET_POOL_SIZE){
+        _nodeset_pool[_nodeset_pool_len] = vec;
+        _nodeset_pool_max[_nodeset_pool_len] = max;
+        _nodeset_pool_len++;
+        return;
+    }
+#endif
+    free(vec);
+}
+
+/*! Free node-set buffers kept in pool of calling thread
+ *
+ * @retval  0  OK
+ */
+int
+ctx_nodeset_pool_exit(void)
+{
+#ifdef XPATH_NODESET_POOL
+    while (_nodeset_pool_len > 0)
+        free(_nodeset_pool[--_nodeset_pool_len]);
+#endif
+    return 0;
+}
+
 /*! Free xpath context */
 int
 ctx_free(xp_ctx *xc)
 {
     if (xc->xc_nodeset)
-        free(xc->xc_nodeset);
+        ctx_nodeset_put(xc->xc_nodeset, xc->xc_max);
     if (xc->xc_string)
         free(xc->xc_string);
     free(xc);
@@ -97,13 +196,14 @@ ctx_dup(xp_ctx *xc0)
         clixon_err(OE_UNIX, errno, "malloc");
         goto done;
     }
+    ALLOC_PROFILE_COUNT(ALLOC_XPATH);
     memset(xc, 0, sizeof(*xc));
     *xc = *xc0;
+    xc->xc_nodeset = NULL;
+    xc->xc_max = 0;
     if (xc0->xc_size){
-        if ((xc->xc_nodeset = calloc(xc0->xc_size, sizeof(cxobj*))) == NULL){
-            clixon_err(OE_UNIX, errno, "calloc");
+        if ((xc->xc_nodeset = ctx_nodeset_get(xc0->xc_size, &xc->xc_max)) == NULL)
             goto done;
-        }
         memcpy(xc->xc_nodeset, xc0->xc_nodeset, xc->xc_size*sizeof(cxobj*));
     }
     if (xc0->xc_string)
@@ -329,8 +429,42 @@ ctx_nodeset_replace(xp_ctx   *xc,
                     size_t    veclen)
 {
     if (xc->xc_nodeset)
-        free(xc->xc_nodeset);
+        ctx_nodeset_put(xc->xc_nodeset, xc->xc_max);
     xc->xc_nodeset = vec;
     xc->xc_size = veclen;
+    xc->xc_max = veclen;
+    return 0;
+}
+
+/*! Append a node to the nodeset of a XPath context
+ *
+ * The nodeset grows in steps and its buffer is taken from and returned to a pool
+ * @param[in] xc     XPath context
+ * @param[in] x      XML node
+ * @retval    0      OK
+ * @retval   -1      Error
+ * @note The nodeset must not be grown by other means, eg cxvec_append, since allocated
+ *       length is kept in xc_max
+ */
+int
+ctx_nodeset_append(xp_ctx *xc,
+                   cxobj  *x)
+{
+    cxobj **vec;
+    int     max;
+
+    if (xc->xc_max < xc->xc_size) /* Unknown allocated length, eg from cxvec_append */
+        xc->xc_max = xc->xc_size;
+    if (xc->xc_size == xc->xc_max){
+        if ((vec = ctx_nodeset_get(xc->xc_max?2*xc->xc_max:16, &max)) == NULL)
+            return -1;
+        if (xc->xc_nodeset){
+            memcpy(vec, xc->xc_nodeset, xc->xc_size*sizeof(cxobj*));
+            ctx_nodeset_put(xc->xc_nodeset, xc->xc_max);
+        }
+        xc->xc_nodeset = vec;
+        xc->xc_max = max;
+    }
+    xc->xc_nodeset[xc->xc_size++] = x;
     return 0;
 }
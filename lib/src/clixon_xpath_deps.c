@@ -0,0 +1,441 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Clixon XML XPath 1.0 according to https://www.w3.org/TR/xpath-10
+ * XPath dependencies, see VALIDATE_INCREMENTAL
+ * Compute which XML nodes an XPath expression, eg of a YANG must or when statement, can read,
+ * so that an expression need not be evaluated again if none of them changed.
+ * Dependencies are over-approximated by:
+ * - Names of all name tests of the expression
+ * - Number of ancestors of the context node whose content can be read, eg ".." as last step
+ * - A flag if the nodes read can not be determined, eg wildcard steps upwards or deref()
+ * A change is given as a set of names of changed, added and deleted nodes, including all
+ * their ancestors and, for added and deleted nodes, all descendants.
+ * If an expression reads a node whose content changed, the node or one of its ancestors on
+ * the path is either named in the expression, or is the context node or one of its counted
+ * ancestors, whose names are therefore also in the set.
+ */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <syslog.h>
+#include <fcntl.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xpath_function.h"
+#include "clixon_xpath_deps.h"
+
+/* Depth of a node-set is not known, eg after a descendant step */
+#define XPD_UNKNOWN INT_MIN
+
+/*
+ * Types
+ */
+/*! Dependencies of an XPath expression, see xpath_tree_deps */
+struct xpath_deps{
+    int     xd_any;    /* Any node can be read */
+    int     xd_levels; /* Number of ancestors of the context node that can be read */
+    char  **xd_names;  /* Names of name tests */
+    int     xd_len;    /* Length of xd_names */
+};
+
+/*! State of a location path while traversing its steps
+ *
+ * The anchor is the closest level, counted as ancestors of the context node, whose name is in
+ * the change set if the content of the current node-set changed.
+ */
+struct xpd_state{
+    int     st_depth;   /* Level of node-set relative to context node, ancestors are > 0 */
+    int     st_covered; /* Changes of node-set are covered by the names */
+    int     st_anchor;  /* Level covering changes if not covered */
+};
+
+static int xpd_expr(xpath_tree *xs, struct xpath_deps *xd, struct xpd_state *ctx, struct xpd_state *top);
+
+/*! Add name of a name test to dependencies
+ */
+static int
+xpd_name_add(struct xpath_deps *xd,
+             char              *name)
+{
+    char **names;
+    int    i;
+
+    for (i=0; i<xd->xd_len; i++)
+        if (strcmp(xd->xd_names[i], name) == 0)
+            return 0;
+    if ((names = realloc(xd->xd_names, (xd->xd_len+1)*sizeof(char*))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    xd->xd_names = names;
+    if ((xd->xd_names[xd->xd_len] = strdup(name)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    xd->xd_len++;
+    return 0;
+}
+
+/*! The content of the node-set of a location path can be read, eg at end of path
+ */
+static void
+xpd_need(struct xpath_deps *xd,
+         struct xpd_state  *st)
+{
+    if (st->st_covered)
+        return;
+    if (st->st_anchor == XPD_UNKNOWN)
+        xd->xd_any = 1;
+    else if (st->st_anchor > xd->xd_levels)
+        xd->xd_levels = st->st_anchor;
+}
+
+/*! Update state of location path with a step
+ *
+ * @param[in]     xs    XPath tree of type XP_STEP
+ * @param[in]     xd    Dependencies
+ * @param[in,out] st    State of location path
+ * @param[in]     top   State of context node, for current()
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+xpd_step(xpath_tree        *xs,
+         struct xpath_deps *xd,
+         struct xpd_state  *st,
+         struct xpd_state  *top)
+{
+    xpath_tree      *xn;
+    xpath_tree      *xp;
+    char            *name = NULL;
+    int              depth;
+    struct xpd_state pst;
+
+    xn = xs->xs_c0;
+    if (xn && xn->xs_type == XP_NODE && xn->xs_s1 && strcmp(xn->xs_s1, "*") != 0){
+        name = xn->xs_s1;
+        if (xpd_name_add(xd, name) < 0)
+            return -1;
+    }
+    depth = st->st_depth;
+    switch (xs->xs_int){
+    case A_SELF:
+        break;
+    case A_CHILD:
+        if (depth != XPD_UNKNOWN)
+            depth--;
+        break;
+    case A_DESCENDANT:
+    case A_DESCENDANT_OR_SELF:
+        depth = XPD_UNKNOWN;
+        break;
+    case A_PARENT:
+        if (name == NULL && depth == XPD_UNKNOWN){
+            xd->xd_any = 1;
+            return 0;
+        }
+        if (depth != XPD_UNKNOWN)
+            depth++;
+        break;
+    case A_FOLLOWING_SIBLING:
+    case A_PRECEDING_SIBLING:
+        if (name == NULL){
+            xd->xd_any = 1;
+            return 0;
+        }
+        break;
+    default: /* ancestor, following, preceding, attribute, etc */
+        if (name == NULL){
+            xd->xd_any = 1;
+            return 0;
+        }
+        depth = XPD_UNKNOWN;
+        break;
+    }
+    if (name)
+        st->st_covered = 1;
+    else if (xs->xs_int == A_PARENT){
+        /* Parent of nodes within subtree of anchor is covered by anchor unless above it */
+        if (st->st_covered)
+            st->st_anchor = depth;
+        else if (st->st_anchor != XPD_UNKNOWN && depth > st->st_anchor)
+            st->st_anchor = depth;
+        st->st_covered = 0;
+    }
+    /* Unnamed child, descendant and self steps stay in subtree of previous node-set */
+    st->st_depth = depth;
+    /* Predicates with node-set as context */
+    for (xp = xs->xs_c1; xp != NULL; xp = xp->xs_c0){
+        if (xp->xs_type != XP_PRED)
+            break;
+        if (xp->xs_c1 == NULL)
+            continue;
+        pst = *st;
+        if (xpd_expr(xp->xs_c1, xd, &pst, top) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Update state of location path with a relative location path
+ *
+ * @param[in]     xs    XPath tree of type XP_RELLOCPATH or XP_STEP
+ * @param[in]     xd    Dependencies
+ * @param[in,out] st    State of location path
+ * @param[in]     top   State of context node, for current()
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+xpd_rellocpath(xpath_tree        *xs,
+               struct xpath_deps *xd,
+               struct xpd_state  *st,
+               struct xpd_state  *top)
+{
+    if (xs == NULL)
+        return 0;
+    switch (xs->xs_type){
+    case XP_STEP:
+        return xpd_step(xs, xd, st, top);
+    case XP_RELLOCPATH:
+        if (xpd_rellocpath(xs->xs_c0, xd, st, top) < 0)
+            return -1;
+        if (xs->xs_c1 == NULL)
+            break;
+        if (xs->xs_int == A_DESCENDANT_OR_SELF) /* "//" */
+            st->st_depth = XPD_UNKNOWN;
+        return xpd_rellocpath(xs->xs_c1, xd, st, top);
+    default:
+        xd->xd_any = 1;
+        break;
+    }
+    return 0;
+}
+
+/*! Traverse XPath expression and add dependencies
+ *
+ * @param[in]  xs    XPath tree
+ * @param[in]  xd    Dependencies
+ * @param[in]  ctx   State of context node of expression, eg of a predicate
+ * @param[in]  top   State of context node of top expression, for current()
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xpd_expr(xpath_tree        *xs,
+         struct xpath_deps *xd,
+         struct xpd_state  *ctx,
+         struct xpd_state  *top)
+{
+    struct xpd_state st;
+    xpath_tree      *xf;
+
+    if (xs == NULL || xd->xd_any)
+        return 0;
+    switch (xs->xs_type){
+    case XP_ABSPATH:
+        /* Root is not named and not an ancestor at known level */
+        st.st_depth = XPD_UNKNOWN;
+        st.st_covered = 0;
+        st.st_anchor = XPD_UNKNOWN;
+        if (xpd_rellocpath(xs->xs_c0, xd, &st, top) < 0)
+            return -1;
+        xpd_need(xd, &st);
+        break;
+    case XP_RELLOCPATH:
+    case XP_STEP:
+        st = *ctx;
+        if (xpd_rellocpath(xs, xd, &st, top) < 0)
+            return -1;
+        xpd_need(xd, &st);
+        break;
+    case XP_PATHEXPR:
+        if (xs->xs_c1 == NULL)
+            return xpd_expr(xs->xs_c0, xd, ctx, top);
+        /* current()/<rellocpath> starts at context node, others are not known */
+        if ((xf = xs->xs_c0) != NULL &&
+            xf->xs_type == XP_FILTEREXPR &&
+            (xf = xf->xs_c0) != NULL &&
+            xf->xs_type == XP_PRIME_FN &&
+            xf->xs_int == XPATHFN_CURRENT)
+            st = *top;
+        else{
+            if (xpd_expr(xs->xs_c0, xd, ctx, top) < 0)
+                return -1;
+            st.st_depth = XPD_UNKNOWN;
+            st.st_covered = 0;
+            st.st_anchor = XPD_UNKNOWN;
+        }
+        if (xs->xs_s0 && strcmp(xs->xs_s0, "//") == 0)
+            st.st_depth = XPD_UNKNOWN;
+        if (xpd_rellocpath(xs->xs_c1, xd, &st, top) < 0)
+            return -1;
+        xpd_need(xd, &st);
+        break;
+    case XP_PRIME_FN:
+        switch (xs->xs_int){
+        case XPATHFN_DEREF: /* Reads nodes referred to by value */
+        case XPATHFN_ID:
+            xd->xd_any = 1;
+            return 0;
+        default:
+            break;
+        }
+        return xpd_expr(xs->xs_c0, xd, ctx, top);
+    case XP_PRIME_NR:
+    case XP_PRIME_STR:
+        break;
+    case XP_EXP:
+    case XP_AND:
+    case XP_RELEX:
+    case XP_ADD:
+    case XP_UNION:
+    case XP_FILTEREXPR:
+    case XP_LOCPATH:
+    case XP_PRI0:
+        if (xpd_expr(xs->xs_c0, xd, ctx, top) < 0)
+            return -1;
+        return xpd_expr(xs->xs_c1, xd, ctx, top);
+    default:
+        xd->xd_any = 1;
+        break;
+    }
+    return 0;
+}
+
+/*! Free XPath dependencies
+ *
+ * @param[in]  xd   Dependencies
+ * @retval     0    OK
+ */
+int
+xpath_deps_free(struct xpath_deps *xd)
+{
+    int i;
+
+    if (xd->xd_names){
+        for (i=0; i<xd->xd_len; i++)
+            free(xd->xd_names[i]);
+        free(xd->xd_names);
+    }
+    free(xd);
+    return 0;
+}
+
+/*! Compute dependencies of XPath expression and keep them in top node of parse tree
+ *
+ * The context node of the expression, eg of a must statement, is always a dependency.
+ * @param[in]  xptree  XPath parse tree
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xpath_deps_changed
+ */
+int
+xpath_tree_deps(xpath_tree *xptree)
+{
+    int                retval = -1;
+    struct xpath_deps *xd = NULL;
+    struct xpd_state   top = {0, 1, 0};
+
+    if (xptree->xs_deps != NULL)
+        return 0;
+    if ((xd = malloc(sizeof(*xd))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xd, 0, sizeof(*xd));
+    if (xpd_expr(xptree, xd, &top, &top) < 0)
+        goto done;
+    xptree->xs_deps = xd;
+    xd = NULL;
+    retval = 0;
+ done:
+    if (xd)
+        xpath_deps_free(xd);
+    return retval;
+}
+
+/*! Check if any node read by an XPath expression may have changed
+ *
+ * @param[in]  xptree  XPath parse tree with dependencies, see xpath_tree_deps
+ * @param[in]  xcur    Context node of expression
+ * @param[in]  chg     Set of names of changed nodes, see xml_yang_validate_changed
+ * @retval     1       May have changed, or dependencies not known
+ * @retval     0       Not changed, result of expression is same as before
+ */
+int
+xpath_deps_changed(xpath_tree    *xptree,
+                   cxobj         *xcur,
+                   clicon_hash_t *chg)
+{
+    struct xpath_deps *xd;
+    cxobj             *x;
+    int                i;
+
+    if ((xd = xptree->xs_deps) == NULL || xd->xd_any)
+        return 1;
+    x = xcur;
+    for (i=0; i<=xd->xd_levels && x != NULL; i++){
+        if (clicon_hash_lookup(chg, xml_name(x)) != NULL)
+            return 1;
+        x = xml_parent(x);
+    }
+    for (i=0; i<xd->xd_len; i++)
+        if (clicon_hash_lookup(chg, xd->xd_names[i]) != NULL)
+            return 1;
+    return 0;
+}
@@ -68,6 +68,9 @@
 #include <syslog.h>
 #include <fcntl.h>
 #include <math.h> /* NaN */
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -82,6 +85,7 @@
 #include "clixon_err.h"
 #include "clixon_log.h"
 #include "clixon_debug.h"
+#include "clixon_options.h"
 #include "clixon_yang_type.h"
 #include "clixon_xml_sort.h"
 #include "clixon_xml_nsctx.h"
@@ -92,6 +96,25 @@
 #include "clixon_xpath_function.h"
 #include "clixon_xpath_eval.h"
 
+#ifdef HAVE_LIBPTHREAD
+/* Min number of nodes of a node-set whose predicate is evaluated in threads */
+#define XPATH_PARALLEL_MIN 1024
+/* Number of nodes evaluated by a thread at a time */
+#define XPATH_PARALLEL_CHUNK 128
+#endif
+
+/*
+ * Variables
+ */
+/* Number of threads evaluating predicates, see CLICON_XPATH_THREADS */
+static int _xpath_threads = 1;
+/* Set while evaluated trees are read-only, see xpath_parallel_frozen */
+static int _xpath_frozen = 0;
+#ifdef HAVE_LIBPTHREAD
+/* Set in predicate worker threads */
+static __thread int _xpath_worker = 0;
+#endif
+
 /* Mapping between XPath operator string <--> int  */
 const map_str2int xpopmap[] = {
     {"and",              XO_AND},
@@ -154,7 +177,7 @@ nodetest_eval_namespace(cxobj      *x,
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s %s", name1, name2);
     if (strcmp(name2, "*") != 0){
         /* if name1 != name2 -> fail */
-        if (strcmp(name1, name2) != 0)
+        if (!xml_name_eq(x, name2, xs->xs_s1i))
             goto fail;
     }
     /* get namespace of xml tree */
@@ -214,7 +237,7 @@ nodetest_eval_prefixonly(cxobj      *x,
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s:%s %s:%s", prefix1, name1, prefix2, name2);
     if (strcmp(name2, "*") != 0){
         /* if name1 != name2 -> fail */
-        if (strcmp(name1, name2) != 0)
+        if (!xml_name_eq(x, name2, xs->xs_s1i))
             goto fail;
     }
     ret = clicon_strcmp(prefix1, prefix2);
@@ -254,7 +277,7 @@ nodetest_eval_localonly(cxobj      *x,
         goto done;
     }
     /* Check name only */
-    if (strcmp(name1, name2) == 0){
+    if (xml_name_eq(x, name2, xs->xs_s1i)){
         retval = 1;
         goto done;
     }
@@ -275,7 +298,7 @@ nodetest_eval_localonly(cxobj      *x,
  * - node() is true for any node of any type whatsoever.
  * - text() is true for any text node.
  */
-static int
+int
 nodetest_eval(cxobj      *x,
               xpath_tree *xs,
               cvec       *nsc,
@@ -352,6 +375,42 @@ nodetest_recursive(cxobj      *xn,
     return retval;
 }
 
+/*! Test node recursive and append matching nodes to nodeset of XPath context
+ *
+ * Same as nodetest_recursive but grows the nodeset in steps, see ctx_nodeset_append
+ * @param[in]  xn         XML node
+ * @param[in]  nodetest   XPath stack
+ * @param[in]  node_type
+ * @param[in]  nsc        XML Namespace context
+ * @param[in]  localonly  Skip prefix and namespace tests (non-standard)
+ * @param[in]  xr         XPath context with nodeset to append to
+ * @retval     0          OK
+ * @retval    -1          Error
+ */
+static int
+nodetest_recursive_ctx(cxobj      *xn,
+                       xpath_tree *nodetest,
+                       int         node_type,
+                       cvec       *nsc,
+                       int         localonly,
+                       xp_ctx     *xr)
+{
+    int     retval = -1;
+    cxobj  *xsub;
+
+    xsub = NULL;
+    while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
+        if (nodetest_eval(xsub, nodetest, nsc, localonly) == 1)
+            if (ctx_nodeset_append(xr, xsub) < 0)
+                goto done;
+        if (nodetest_recursive_ctx(xsub, nodetest, node_type, nsc, localonly, xr) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Evaluate xpath step rule of an XML tree
  *
  * @param[in]  xc0       Incoming context
@@ -380,10 +439,9 @@ xp_eval_step(xp_ctx     *xc0,
     cxobj      *x;
     cxobj      *xv;
     cxobj      *xp;
-    cxobj     **vec = NULL;
-    int         veclen = 0;
     xpath_tree *nodetest = xs->xs_c0;
     xp_ctx     *xc = NULL;
+    xp_ctx      xn = {0,}; /* New nodeset */
     int         ret;
 
     /* Create new xc */
@@ -400,7 +458,7 @@ xp_eval_step(xp_ctx     *xc0,
         if (xc->xc_descendant){
             for (i=0; i<xc->xc_size; i++){
                 xv = xc->xc_nodeset[i];
-                if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+                if (nodetest_recursive_ctx(xv, nodetest, CX_ELMNT, nsc, localonly, &xn) < 0)
                     goto done;
             }
             xc->xc_descendant = 0;
@@ -414,12 +472,19 @@ xp_eval_step(xp_ctx     *xc0,
 
                 xv = xc->xc_nodeset[i];
                 x = NULL;
+                ret = 0;
+#ifdef HAVE_LIBPTHREAD
+                /* Optimization builds indexes and patterns lazily, not in worker threads */
+                if (!_xpath_worker)
+#endif
                 if ((ret = xpath_optimize_check(xs, xv, &vec0, &veclen0)) < 0)
                     goto done;
                 if (ret == 1){
                     for (j=0; j<veclen0; j++){
-                        if (cxvec_append(vec0[0], &vec, &veclen) < 0)
+                        if (ctx_nodeset_append(&xn, vec0[j]) < 0){
+                            free(vec0);
                             goto done;
+                        }
                     }
                     if (vec0)
                         free(vec0);
@@ -429,40 +494,38 @@ xp_eval_step(xp_ctx     *xc0,
                         /* xs->xs_c0 is nodetest */
                         if (nodetest == NULL ||
                             nodetest_eval(x, nodetest, nsc, localonly) == 1){
-                            if (cxvec_append(x, &vec, &veclen) < 0)
+                            if (ctx_nodeset_append(&xn, x) < 0)
                                 goto done;
                         }
                     }
                 }
             }
         }
-        ctx_nodeset_replace(xc, vec, veclen);
-        if (vec)
-            vec = NULL;
+        ctx_nodeset_replace(xc, xn.xc_nodeset, xn.xc_size);
+        xc->xc_max = xn.xc_max;
+        xn.xc_nodeset = NULL;
         break;
     case A_DESCENDANT_OR_SELF:
         for (i=0; i<xc->xc_size; i++){
             xv = xc->xc_nodeset[i];
-            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+            if (nodetest_recursive_ctx(xv, xs->xs_c0, CX_ELMNT, nsc, localonly, &xn) < 0)
                 goto done;
         }
-        for (i=0; i<veclen; i++){
-            x = vec[i];
-            if (cxvec_append(x, &xc->xc_nodeset, &xc->xc_size) < 0)
+        for (i=0; i<xn.xc_size; i++){
+            x = xn.xc_nodeset[i];
+            if (ctx_nodeset_append(xc, x) < 0)
                 goto done;
         }
-        if (vec){
-            free(vec);
-            vec = NULL;
-        }
         break;
     case A_DESCENDANT:
         for (i=0; i<xc->xc_size; i++){
             xv = xc->xc_nodeset[i];
-            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+            if (nodetest_recursive_ctx(xv, xs->xs_c0, CX_ELMNT, nsc, localonly, &xn) < 0)
                 goto done;
         }
-        ctx_nodeset_replace(xc, vec, veclen);
+        ctx_nodeset_replace(xc, xn.xc_nodeset, xn.xc_size);
+        xc->xc_max = xn.xc_max;
+        xn.xc_nodeset = NULL;
         break;
     case A_FOLLOWING:
         break;
@@ -471,25 +534,20 @@ xp_eval_step(xp_ctx     *xc0,
     case A_NAMESPACE: /* principal node type is namespace */
         break;
     case A_PARENT:
-        veclen = xc->xc_size;
-        vec = xc->xc_nodeset;
-        xc->xc_size = 0;
-        xc->xc_nodeset = NULL;
-        for (i=0; i<veclen; i++){
-            x = vec[i];
+        for (i=0; i<xc->xc_size; i++){
+            x = xc->xc_nodeset[i];
             if ((xp = xml_parent(x)) != NULL
 #ifdef XML_PARENT_CANDIDATE
                 /* Also check "candidate" parent for special when use-case */
                 || (xp = xml_parent_candidate(x)) != NULL
 #endif /* XML_PARENT_CANDIDATE */
                 )
-                if (cxvec_append(xp, &xc->xc_nodeset, &xc->xc_size) < 0)
+                if (ctx_nodeset_append(&xn, xp) < 0)
                     goto done;
         }
-        if (vec){
-            free(vec);
-            vec = NULL;
-        }
+        ctx_nodeset_replace(xc, xn.xc_nodeset, xn.xc_size);
+        xc->xc_max = xn.xc_max;
+        xn.xc_nodeset = NULL;
         break;
     case A_PRECEDING:
         break;
@@ -502,7 +560,9 @@ xp_eval_step(xp_ctx     *xc0,
         goto done;
         break;
     }
-    if (xs->xs_c1){
+    /* Empty predicates gives a copy of xc, skip it */
+    if (xs->xs_c1 &&
+        (xs->xs_c1->xs_type != XP_PRED || xs->xs_c1->xs_c0 || xs->xs_c1->xs_c1)){
         if (xp_eval(xc, xs->xs_c1, nsc, localonly, xrp) < 0)
             goto done;
     }
@@ -516,11 +576,317 @@ xp_eval_step(xp_ctx     *xc0,
     }
     retval = 0;
  done:
+    if (xn.xc_nodeset)
+        ctx_nodeset_replace(&xn, NULL, 0);
     if (xc)
         ctx_free(xc);
     return retval;
 }
 
+/*! Set number of threads evaluating predicates from option CLICON_XPATH_THREADS
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @see xpath_parallel_frozen
+ */
+int
+xpath_parallel_init(clixon_handle h)
+{
+    _xpath_threads = clicon_option_int(h, "CLICON_XPATH_THREADS");
+    return 0;
+}
+
+/*! Mark evaluated trees as read-only, which allows predicates to be evaluated in threads
+ *
+ * Set by code that evaluates XPaths on trees that are not modified during an evaluation,
+ * such as validation of candidate and get, and reset after.
+ * @param[in]  frozen  1: Trees are read-only, 0: Trees may be modified
+ * @retval     old     Previous value, to be restored
+ * @see xpath_parallel_init
+ */
+int
+xpath_parallel_frozen(int frozen)
+{
+    int old = _xpath_frozen;
+
+    _xpath_frozen = frozen;
+    return old;
+}
+
+#ifdef HAVE_LIBPTHREAD
+/*! Check if an XPath predicate expression only reads the tree and can be evaluated in threads
+ *
+ * Expressions with unions, which mark nodes, and functions using lazily built caches, such as
+ * count(), deref() or re-match(), are evaluated serially.
+ * @param[in]  xs   XPath tree
+ * @retval     1    Yes, no side-effects
+ * @retval     0    No
+ */
+static int
+xp_parallel_expr(xpath_tree *xs)
+{
+    if (xs == NULL)
+        return 1;
+    switch (xs->xs_type){
+    case XP_UNION:
+        if (xs->xs_c1 != NULL)
+            return 0;
+        break;
+    case XP_STEP:
+        switch (xs->xs_int){
+        case A_CHILD:
+        case A_DESCENDANT:
+        case A_DESCENDANT_OR_SELF:
+        case A_PARENT:
+        case A_SELF:
+            break;
+        default:
+            return 0;
+        }
+        break;
+    case XP_PRIME_FN:
+        switch (xs->xs_int){
+        case XPATHFN_CURRENT:
+        case XPATHFN_POSITION:
+        case XPATHFN_LOCAL_NAME:
+        case XPATHFN_NAME:
+        case XPATHFN_STRING:
+        case XPATHFN_STARTS_WITH:
+        case XPATHFN_CONTAINS:
+        case XPATHFN_SUBSTRING_BEFORE:
+        case XPATHFN_SUBSTRING_AFTER:
+        case XPATHFN_SUBSTRING:
+        case XPATHFN_STRING_LENGTH:
+        case XPATHFN_TRANSLATE:
+        case XPATHFN_BOOLEAN:
+        case XPATHFN_NOT:
+        case XPATHFN_TRUE:
+        case XPATHFN_FALSE:
+            break;
+        default:
+            return 0;
+        }
+        break;
+    case XP_EXP:
+    case XP_AND:
+    case XP_RELEX:
+    case XP_ADD:
+    case XP_PATHEXPR:
+    case XP_FILTEREXPR:
+    case XP_LOCPATH:
+    case XP_ABSPATH:
+    case XP_RELLOCPATH:
+    case XP_NODE:
+    case XP_NODE_FN:
+    case XP_PRED:
+    case XP_PRI0:
+    case XP_PRIME_NR:
+    case XP_PRIME_STR:
+        break;
+    default:
+        return 0;
+    }
+    return xp_parallel_expr(xs->xs_c0) && xp_parallel_expr(xs->xs_c1);
+}
+
+/*! Shared state of predicate worker threads
+ */
+struct xp_pred_work{
+    pthread_mutex_t pw_mutex;
+    xp_ctx         *pw_xc;      /* Incoming context */
+    xp_ctx         *pw_xr0;     /* Node-set to filter */
+    xpath_tree     *pw_xs;      /* Predicate expression */
+    cvec           *pw_nsc;     /* XML Namespace context */
+    int             pw_localonly;
+    char           *pw_keep;    /* Result per node of node-set */
+    int             pw_next;    /* Next node to evaluate */
+    int             pw_err;     /* Set if any evaluation failed */
+};
+
+/*! Worker thread: evaluate predicate of chunks of the node-set until none left
+ */
+static void *
+xp_pred_worker(void *arg)
+{
+    struct xp_pred_work *pw = (struct xp_pred_work *)arg;
+    xp_ctx              *xrc = NULL;
+    xp_ctx               xcc;
+    int                  i;
+    int                  i1;
+
+    _xpath_worker = 1;
+    for (;;){
+        pthread_mutex_lock(&pw->pw_mutex);
+        if (pw->pw_err || (i = pw->pw_next) >= pw->pw_xr0->xc_size)
+            i = -1;
+        else
+            pw->pw_next += XPATH_PARALLEL_CHUNK;
+        pthread_mutex_unlock(&pw->pw_mutex);
+        if (i < 0)
+            break;
+        if ((i1 = i + XPATH_PARALLEL_CHUNK) > pw->pw_xr0->xc_size)
+            i1 = pw->pw_xr0->xc_size;
+        for (; i<i1; i++){
+            /* Same as serial evaluation in xp_eval_predicate */
+            memset(&xcc, 0, sizeof(xcc));
+            xcc.xc_type = XT_NODESET;
+            xcc.xc_initial = pw->pw_xc->xc_initial;
+            xcc.xc_node = pw->pw_xr0->xc_nodeset[i];
+            xcc.xc_position = i;
+            xcc.xc_nodeset = &xcc.xc_node;
+            xcc.xc_size = 1;
+            if (xp_eval(&xcc, pw->pw_xs, pw->pw_nsc, pw->pw_localonly, &xrc) < 0)
+                break;
+            if (xrc->xc_type == XT_NUMBER)
+                pw->pw_keep[i] = ((int)xrc->xc_number == i);
+            else
+                pw->pw_keep[i] = ctx2boolean(xrc);
+            ctx_free(xrc);
+            xrc = NULL;
+        }
+        if (i < i1){
+            pthread_mutex_lock(&pw->pw_mutex);
+            pw->pw_err++;
+            pthread_mutex_unlock(&pw->pw_mutex);
+            break;
+        }
+    }
+    ctx_nodeset_pool_exit();
+    _xpath_worker = 0;
+    return NULL;
+}
+
+/*! Filter a large node-set with a predicate in threads
+ *
+ * The node-set is evaluated in chunks by CLICON_XPATH_THREADS threads, each node with the
+ * same context as in serial evaluation. Results are kept per node and the node-set is
+ * filtered in place in the calling thread, so the result order is the node-set order.
+ * Only while trees are read-only, see xpath_parallel_frozen, and only for expressions
+ * without side-effects. Namespace caches are not set meanwhile, and values of yang bound
+ * nodes are parsed without caching, see xml_cv_parse.
+ * @param[in]     xc        Incoming context
+ * @param[in,out] xr0       Node-set to filter in place
+ * @param[in]     xs        Predicate expression
+ * @param[in]     nsc       XML Namespace context
+ * @param[in]     localonly Skip prefix and namespace tests (non-standard)
+ * @retval        1         OK, xr0 filtered
+ * @retval        0         Not evaluated in threads, evaluate serially
+ * @retval       -1         Error
+ */
+static int
+xp_eval_predicate_threads(xp_ctx     *xc,
+                          xp_ctx     *xr0,
+                          xpath_tree *xs,
+                          cvec       *nsc,
+                          int         localonly)
+{
+    int                 retval = -1;
+    struct xp_pred_work pw = {0,};
+    pthread_t          *tids = NULL;
+    int                 nthreads;
+    int                 frozen;
+    int                 threads;
+    int                 n = 0;
+    int                 i;
+    int                 j;
+    int                 ret;
+
+    if (_xpath_threads <= 1 ||
+        !_xpath_frozen ||
+        _xpath_worker ||
+        xr0->xc_size < XPATH_PARALLEL_MIN ||
+        clixon_debug_get() != 0 ||
+        xp_parallel_expr(xs) == 0)
+        goto skip;
+    if ((nthreads = _xpath_threads) > xr0->xc_size / XPATH_PARALLEL_CHUNK)
+        nthreads = xr0->xc_size / XPATH_PARALLEL_CHUNK;
+    if ((pw.pw_keep = calloc(xr0->xc_size, sizeof(char))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((tids = calloc(nthreads, sizeof(*tids))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    pw.pw_xc = xc;
+    pw.pw_xr0 = xr0;
+    pw.pw_xs = xs;
+    pw.pw_nsc = nsc;
+    pw.pw_localonly = localonly;
+    if (pthread_mutex_init(&pw.pw_mutex, NULL) != 0){
+        clixon_err(OE_UNIX, errno, "pthread_mutex_init");
+        goto done;
+    }
+    /* Lazy XML indexes are not built meanwhile, see xml_threads_set */
+    frozen = xml2ns_cache_freeze(1);
+    threads = xml_threads_set(1);
+    for (n=0; n<nthreads; n++)
+        if ((ret = pthread_create(&tids[n], NULL, xp_pred_worker, &pw)) != 0){
+            clixon_err(OE_UNIX, ret, "pthread_create");
+            break;
+        }
+    for (i=0; i<n; i++)
+        pthread_join(tids[i], NULL);
+    xml_threads_set(threads);
+    xml2ns_cache_freeze(frozen);
+    pthread_mutex_destroy(&pw.pw_mutex);
+    if (n == 0) /* No threads, evaluate serially */
+        goto skip;
+    if (pw.pw_err)
+        goto done;
+    j = 0;
+    for (i=0; i<xr0->xc_size; i++)
+        if (pw.pw_keep[i])
+            xr0->xc_nodeset[j++] = xr0->xc_nodeset[i];
+    xr0->xc_size = j;
+    retval = 1;
+ done:
+    if (tids)
+        free(tids);
+    if (pw.pw_keep)
+        free(pw.pw_keep);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+#endif /* HAVE_LIBPTHREAD */
+
+/*! Check if an XPath expression only reads the tree and can be evaluated in threads
+ *
+ * Used by callers evaluating XPaths in their own threads, such as parallel validation
+ * @param[in]  xs   XPath tree
+ * @retval     1    Yes, no side-effects
+ * @retval     0    No, or no pthreads
+ */
+int
+xpath_parallel_tree(xpath_tree *xs)
+{
+#ifdef HAVE_LIBPTHREAD
+    return xp_parallel_expr(xs);
+#else
+    return 0;
+#endif
+}
+
+/*! Mark calling thread as worker of a parallel evaluation, where predicates are serial
+ *
+ * @param[in]  worker  1: Calling thread is a worker thread, 0: Not a worker thread
+ * @retval     old     Previous value, to be restored
+ */
+int
+xpath_parallel_worker(int worker)
+{
+#ifdef HAVE_LIBPTHREAD
+    int old = _xpath_worker;
+
+    _xpath_worker = worker;
+    return old;
+#else
+    return 0;
+#endif
+}
+
 /*! Evaluate xpath predicates rule
  *
  * pred -> pred expr
@@ -556,11 +922,13 @@ xp_eval_predicate(xp_ctx     *xc,
 {
     int      retval = -1;
     xp_ctx  *xr0 = NULL;
-    xp_ctx  *xr1 = NULL;
     xp_ctx  *xrc = NULL;
     int      i;
+    int      j;
+    int      keep;
     cxobj   *x;
-    xp_ctx  *xcc = NULL;
+    xp_ctx   xcc;
+    int      ret = 0;
 
     if (xs->xs_c0 != NULL){ /* eval previous predicates */
         if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
@@ -570,106 +938,83 @@ xp_eval_predicate(xp_ctx     *xc,
         if ((xr0 = ctx_dup(xc)) == NULL)
             goto done;
     }
-    // alt set nodeset to NULL
     if (xs->xs_c1 && xr0->xc_type == XT_NODESET){ /* Second child */
-        /* Loop over each node in the nodeset 
-         * XXX: alt to check xr0 is nodeset: set new var nodeset to NULL
-         */
-        if ((xr1 = malloc(sizeof(*xr1))) == NULL){
-            clixon_err(OE_UNIX, errno, "malloc");
+#ifdef HAVE_LIBPTHREAD
+        /* Large node-sets of read-only trees may be filtered in threads */
+        if ((ret = xp_eval_predicate_threads(xc, xr0, xs->xs_c1, nsc, localonly)) < 0)
             goto done;
-        }
-        memset(xr1, 0, sizeof(*xr1));
-        xr1->xc_type = XT_NODESET;
-        xr1->xc_node = xc->xc_node;
-        xr1->xc_initial = xc->xc_initial;
-        for (i=0; i<xr0->xc_size; i++){
+#endif
+        /* Loop over each node in the nodeset and filter it in place */
+        j = 0;
+        for (i=0; ret == 0 && i<xr0->xc_size; i++){
             x = xr0->xc_nodeset[i];
-            /* Create new context */
-            if ((xcc = malloc(sizeof(*xcc))) == NULL){
-                clixon_err(OE_XML, errno, "malloc");
-                goto done;
-            }
-            memset(xcc, 0, sizeof(*xcc));
-            xcc->xc_type = XT_NODESET;
-            xcc->xc_initial = xc->xc_initial;
-            xcc->xc_node = x;
-            xcc->xc_position = i;
+            /* Create new context with x as only member, on stack since it is not kept */
+            memset(&xcc, 0, sizeof(xcc));
+            xcc.xc_type = XT_NODESET;
+            xcc.xc_initial = xc->xc_initial;
+            xcc.xc_node = x;
+            xcc.xc_position = i;
+            xcc.xc_nodeset = &xcc.xc_node;
+            xcc.xc_size = 1;
             /* For each node in the node-set to be filtered, the PredicateExpr is
              * evaluated with that node as the context node */
-            if (cxvec_append(x, &xcc->xc_nodeset, &xcc->xc_size) < 0)
-                goto done;
-            if (xp_eval(xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
+            if (xp_eval(&xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
                 goto done;
-            ctx_free(xcc);
-            xcc = NULL;
             if (xrc->xc_type == XT_NUMBER){
                 /* If the result is a number, the result will be converted to true
                    if the number is equal to the context position */
-                if ((int)xrc->xc_number == i)
-                    if (cxvec_append(x, &xr1->xc_nodeset, &xr1->xc_size) < 0)
-                        goto done;
+                keep = ((int)xrc->xc_number == i);
             }
             else {
                 /* if PredicateExpr evaluates to true for that node, the node is
                    included in the new node-set */
-                if (ctx2boolean(xrc))
-                    if (cxvec_append(x, &xr1->xc_nodeset, &xr1->xc_size) < 0)
-                        goto done;
+                keep = ctx2boolean(xrc);
             }
-            if (xrc)
-                ctx_free(xrc);
+            ctx_free(xrc);
+            xrc = NULL;
+            if (keep)
+                xr0->xc_nodeset[j++] = x;
         }
+        if (ret == 0)
+            xr0->xc_size = j;
+        xr0->xc_node = xc->xc_node;
+        xr0->xc_initial = xc->xc_initial;
+        xr0->xc_position = 0;
+        xr0->xc_descendant = 0;
     }
-    if (xr0 == NULL && xr1 == NULL){
+    if (xr0 == NULL){
         clixon_err(OE_XML, EFAULT, "Internal error: no result produced");
         goto done;
     }
-    if (xr1){
-        *xrp = xr1;
-        xr1 = NULL;
-    }
-    else if (xr0){
-        *xrp = xr0;
-        xr0 = NULL;
-    }
+    *xrp = xr0;
+    xr0 = NULL;
     retval = 0;
  done:
-    if (xcc)
-        ctx_free(xcc);
     if (xr0)
         ctx_free(xr0);
-    if (xr1)
-        ctx_free(xr1);
     return retval;
 }
 
-/*! Given two XPath contexts, eval logical  operations: or,and
+/*! Given two XPath contexts, eval logical operations: or,and into a given result context
  *
- * The logical operators convert their operands to booleans
  * @param[in]  xc1  Context of operand1
  * @param[in]  xc2  Context of operand2
  * @param[in]  op   Relational operator
- * @param[out] xrp  Result context
+ * @param[out] xr   Result context, allocated by caller
  * @retval     0    OK
  * @retval    -1    Error
+ * @see xp_logop
  */
-static int
-xp_logop(xp_ctx    *xc1,
-         xp_ctx    *xc2,
-         enum xp_op op,
-         xp_ctx   **xrp)
+int
+xp_logop1(xp_ctx    *xc1,
+          xp_ctx    *xc2,
+          enum xp_op op,
+          xp_ctx    *xr)
 {
     int     retval = -1;
-    xp_ctx *xr = NULL;
     int     b1;
     int     b2;
 
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
-        goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_initial = xc1->xc_initial;
     xr->xc_type = XT_BOOL;
     if ((b1 = ctx2boolean(xc1)) < 0)
@@ -688,19 +1033,14 @@ xp_logop(xp_ctx    *xc1,
                    __func__, clicon_int2str(xpopmap,op));
         goto done;
     }
-    *xrp = xr;
-    xr = NULL;
     retval = 0;
  done:
-    if (xr)
-        ctx_free(xr);
     return retval;
 }
 
-/*! Given two XPath contexts, eval numeric operations: +-*,div,mod
+/*! Given two XPath contexts, eval logical  operations: or,and
  *
- * The numeric operators convert their operands to numbers as if by 
- * calling the number function.
+ * The logical operators convert their operands to booleans
  * @param[in]  xc1  Context of operand1
  * @param[in]  xc2  Context of operand2
  * @param[in]  op   Relational operator
@@ -709,21 +1049,50 @@ xp_logop(xp_ctx    *xc1,
  * @retval    -1    Error
  */
 static int
-xp_numop(xp_ctx    *xc1,
+xp_logop(xp_ctx    *xc1,
          xp_ctx    *xc2,
          enum xp_op op,
          xp_ctx   **xrp)
 {
     int     retval = -1;
     xp_ctx *xr = NULL;
-    double  n1;
-    double  n2;
 
     if ((xr = malloc(sizeof(*xr))) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
         goto done;
     }
     memset(xr, 0, sizeof(*xr));
+    if (xp_logop1(xc1, xc2, op, xr) < 0)
+        goto done;
+    *xrp = xr;
+    xr = NULL;
+    retval = 0;
+ done:
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
+/*! Given two XPath contexts, eval numeric operations: +-*,div,mod into a given result context
+ *
+ * @param[in]  xc1  Context of operand1
+ * @param[in]  xc2  Context of operand2
+ * @param[in]  op   Relational operator
+ * @param[out] xr   Result context, allocated by caller
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xp_numop
+ */
+int
+xp_numop1(xp_ctx    *xc1,
+          xp_ctx    *xc2,
+          enum xp_op op,
+          xp_ctx    *xr)
+{
+    int     retval = -1;
+    double  n1;
+    double  n2;
+
     xr->xc_initial = xc1->xc_initial;
     xr->xc_type = XT_NUMBER;
     if (ctx2number(xc1, &n1) < 0)
@@ -754,83 +1123,44 @@ xp_numop(xp_ctx    *xc1,
                        clicon_int2str(xpopmap,op));
             goto done;
         }
-    *xrp = xr;
-    xr = NULL;
     retval = 0;
  done:
-    if (xr)
-        ctx_free(xr);
     return retval;
 }
 
-/*! Get xml body value as cligen variable
+/*! Given two XPath contexts, eval numeric operations: +-*,div,mod
  *
- * @param[in]  x   XML node (body and leaf/leaf-list)
- * @param[out] cvp Pointer to cligen variable containing value of x body
- * @retval     0   OK, cvp contains cv or NULL
- * @retval    -1   Error
- * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Move to clixon_xml.c?
- * As a side-effect sets the cache.
- * Clear cache with xml_cv_set(x, NULL)
- * @see xml_cv_cache.c duplicated function
+ * The numeric operators convert their operands to numbers as if by 
+ * calling the number function.
+ * @param[in]  xc1  Context of operand1
+ * @param[in]  xc2  Context of operand2
+ * @param[in]  op   Relational operator
+ * @param[out] xrp  Result context
+ * @retval     0    OK
+ * @retval    -1    Error
  */
 static int
-xml_cv_cache(cxobj   *x,
-             cg_var **cvp)
+xp_numop(xp_ctx    *xc1,
+         xp_ctx    *xc2,
+         enum xp_op op,
+         xp_ctx   **xrp)
 {
-    int          retval = -1;
-    cg_var      *cv = NULL;
-    yang_stmt   *y;
-    yang_stmt   *yrestype;
-    enum cv_type cvtype;
-    int          ret;
-    char        *reason=NULL;
-    int          options = 0;
-    uint8_t      fraction = 0;
-    char        *body;
+    int     retval = -1;
+    xp_ctx *xr = NULL;
 
-    if ((body = xml_body(x)) == NULL)
-        body="";
-    if ((cv = xml_cv(x)) != NULL)
-        goto ok;
-    if ((y = xml_spec(x)) == NULL){
-        clixon_err(OE_XML, EFAULT, "Yang binding missing for xml symbol %s, body:%s", xml_name(x), body);
-        goto done;
-    }
-    if (yang_type_get(y, NULL, &yrestype, &options, NULL, NULL, NULL, &fraction) < 0)
-        goto done;
-    yang2cv_type(yang_argument_get(yrestype), &cvtype);
-    if (cvtype==CGV_ERR){
-        clixon_err(OE_YANG, errno, "yang->cligen type %s mapping failed",
-                   yang_argument_get(yrestype));
-        goto done;
-    }
-    if ((cv = cv_new(cvtype)) == NULL){
-        clixon_err(OE_YANG, errno, "cv_new");
-        goto done;
-    }
-    if (cvtype == CGV_DEC64)
-        cv_dec64_n_set(cv, fraction);
-    if ((ret = cv_parse1(body, cv, &reason)) < 0){
-        clixon_err(OE_YANG, errno, "cv_parse1");
-        goto done;
-    }
-    if (ret == 0){
-        clixon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
         goto done;
     }
-    if (xml_cv_set(x, cv) < 0)
+    memset(xr, 0, sizeof(*xr));
+    if (xp_numop1(xc1, xc2, op, xr) < 0)
         goto done;
- ok:
-    *cvp = cv;
-    cv = NULL;
+    *xrp = xr;
+    xr = NULL;
     retval = 0;
  done:
-    if (reason)
-        free(reason);
-    if (cv)
-        cv_free(cv);
+    if (xr)
+        ctx_free(xr);
     return retval;
 }
 
@@ -852,18 +1182,18 @@ xml_cv_cache(cxobj   *x,
  * @param[in]  xc1  Context of operand1
  * @param[in]  xc2  Context of operand2
  * @param[in]  op   Relational operator
- * @param[out] xrp  Result context
+ * @param[out] xr   Result context, allocated by caller
  * @retval     0    OK
  * @retval    -1    Error
+ * @see xp_relop
  */
-static int
-xp_relop(xp_ctx    *xc1,
-         xp_ctx    *xc2,
-         enum xp_op op,
-         xp_ctx   **xrp)
+int
+xp_relop1(xp_ctx    *xc1,
+          xp_ctx    *xc2,
+          enum xp_op op,
+          xp_ctx    *xr)
 {
     int     retval = -1;
-    xp_ctx *xr = NULL;
     xp_ctx *xc;
     cxobj  *x1;
     cxobj  *x2;
@@ -876,17 +1206,14 @@ xp_relop(xp_ctx    *xc1,
     double  n1, n2;
     char   *xb;
     cg_var *cv1, *cv2;
+    cg_var *cvf1 = NULL;
+    cg_var *cvf2 = NULL;
     int     ret;
 
     if (xc1 == NULL || xc2 == NULL){
         clixon_err(OE_UNIX, EINVAL, "xc1 or xc2 NULL");
         goto done;
     }
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
-        goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_initial = xc1->xc_initial;
     xr->xc_type = XT_BOOL;
     if (xc1->xc_type == xc2->xc_type){ /* cases (2-3) above */
@@ -909,9 +1236,17 @@ xp_relop(xp_ctx    *xc1,
                     }
                     /* YANG bound, use cv evaluation, else strcmp */
                     if (xml_spec(x1) && xml_spec(x2)){
-                        if (xml_cv_cache(x1, &cv1) < 0) /* error case */
-                            goto done;
-                        if (xml_cv_cache(x2, &cv2) < 0) /* error case */
+#ifdef HAVE_LIBPTHREAD
+                        /* Trees are shared by worker threads, parse values without caching */
+                        if (_xpath_worker){
+                            if (xml_cv_parse(x1, &cv1, &cvf1) < 0 || /* error case */
+                                xml_cv_parse(x2, &cv2, &cvf2) < 0)
+                                goto done;
+                        }
+                        else
+#endif
+                        if (xml_cv_cache(x1, &cv1) < 0 || /* error case */
+                            xml_cv_cache(x2, &cv2) < 0)
                             goto done;
                         if (cv1 != NULL && cv2 != NULL)
                             ret = cv_cmp(cv1, cv2);
@@ -921,6 +1256,14 @@ xp_relop(xp_ctx    *xc1,
                             ret = -1;
                         else
                             ret = 1;
+                        if (cvf1){
+                            cv_free(cvf1);
+                            cvf1 = NULL;
+                        }
+                        if (cvf2){
+                            cv_free(cvf2);
+                            cvf2 = NULL;
+                        }
                         switch(op){
                         case XO_EQ:
                             xr->xc_bool = (ret == 0);
@@ -1136,6 +1479,41 @@ xp_relop(xp_ctx    *xc1,
     /* Just ensure bool is 0 or 1 */
     if (xr->xc_type == XT_BOOL && xr->xc_bool != 0)
         xr->xc_bool = 1;
+    retval = 0;
+ done:
+    if (cvf1)
+        cv_free(cvf1);
+    if (cvf2)
+        cv_free(cvf2);
+    return retval;
+}
+
+/*! Given two XPath contexts, eval relational operations: <>=
+ *
+ * @param[in]  xc1  Context of operand1
+ * @param[in]  xc2  Context of operand2
+ * @param[in]  op   Relational operator
+ * @param[out] xrp  Result context
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xp_relop1 for semantics
+ */
+static int
+xp_relop(xp_ctx    *xc1,
+         xp_ctx    *xc2,
+         enum xp_op op,
+         xp_ctx   **xrp)
+{
+    int     retval = -1;
+    xp_ctx *xr = NULL;
+
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xr, 0, sizeof(*xr));
+    if (xp_relop1(xc1, xc2, op, xr) < 0)
+        goto done;
     *xrp = xr;
     xr = NULL;
     retval = 0;
@@ -1148,6 +1526,7 @@ xp_relop(xp_ctx    *xc1,
 /*! Given two XPath contexts, eval union operation
  *
  * Both operands must be nodesets, otherwise empty nodeset is returned
+ * Nodes in both node-sets are included once, in the order of the first node-set
  * @param[in]  xc1  Context of operand1
  * @param[in]  xc2  Context of operand2
  * @param[in]  op   Relational operator
@@ -1163,6 +1542,7 @@ xp_union(xp_ctx    *xc1,
 {
     int     retval = -1;
     xp_ctx *xr = NULL;
+    cxobj  *x;
     int     i;
 
     if (op != XO_UNION){
@@ -1178,19 +1558,28 @@ xp_union(xp_ctx    *xc1,
     xr->xc_initial = xc1->xc_initial;
     xr->xc_type = XT_NODESET;
 
-    for (i=0; i<xc1->xc_size; i++)
-        if (cxvec_append(xc1->xc_nodeset[i], &xr->xc_nodeset, &xr->xc_size) < 0)
-            goto done;
-    for (i=0; i<xc2->xc_size; i++){
-        if (cxvec_append(xc2->xc_nodeset[i], &xr->xc_nodeset, &xr->xc_size) < 0)
+    /* Mark nodes when added to remove duplicates */
+    for (i=0; i<xc1->xc_size + xc2->xc_size; i++){
+        x = i<xc1->xc_size ? xc1->xc_nodeset[i] : xc2->xc_nodeset[i-xc1->xc_size];
+        if (x && xml_visit_mark(x) == 1)
+            continue;
+        if (ctx_nodeset_append(xr, x) < 0){
+            if (x)
+                xml_visit_clear(x);
             goto done;
+        }
     }
     *xrp = xr;
-    xr = NULL;
     retval = 0;
  done:
-    if (xr)
-        ctx_free(xr);
+    if (xr){
+        /* Clear marks of all added nodes */
+        for (i=0; i<xr->xc_size; i++)
+            if ((x = xr->xc_nodeset[i]) != NULL)
+                xml_visit_clear(x);
+        if (retval < 0)
+            ctx_free(xr);
+    }
     return retval;
 }
 
@@ -187,8 +187,8 @@ xp_function_current(xp_ctx            *xc0,
  * @see RFC 7950 10.2.1
  * @note Uses xml2 regexp if libxml2 enabled, otherwise posix
  *       This means for xml2, you have to configure BOTH cligen and clixon with --with-libxml2
- * @note Compiling regexp takes a lot of resources, no caching is made of re here
- *       as is done for eg YANG patterns
+ * @note Compiling regexp takes a lot of resources, compiled regexps are cached, see
+ *       regex_cache_get
  * Example: re-match("1.22.333", "\d{1,3}\.\d{1,3}\.\d{1,3}") returns true
  */
 int
@@ -204,9 +204,13 @@ xp_function_re_match(xp_ctx            *xc,
     xp_ctx *xr = NULL;
     char   *s0 = NULL;
     char   *regexp = NULL;
-    char   *posix = NULL;
     void   *re = NULL;
     int     ret;
+#ifdef HAVE_LIBXML2
+    int     mode = REGEXP_LIBXML2;
+#else
+    int     mode = REGEXP_POSIX;
+#endif
 
     if (xs == NULL || xs->xs_c0 == NULL || xs->xs_c1 == NULL){
         clixon_err(OE_XML, EINVAL, "contains expects but did not get two arguments");
@@ -221,15 +225,8 @@ xp_function_re_match(xp_ctx            *xc,
         goto done;
     if (ctx2string(xr1, &regexp) < 0)
         goto done;
-#ifdef HAVE_LIBXML2
-    if ((ret = cligen_regex_libxml2_compile(regexp, &re)) < 0)
-        goto done;
-#else
-    if (regexp_xsd2posix(regexp, &posix) < 0)
-        goto done;
-    if ((ret = cligen_regex_posix_compile(posix, &re)) < 0)
+    if ((ret = regex_cache_get(mode, regexp, &re)) < 0)
         goto done;
-#endif
     if (ret == 0){
         clixon_err(OE_YANG, 0, "regexp compile fail: \"%s\"", regexp);
         goto done;
@@ -254,14 +251,8 @@ xp_function_re_match(xp_ctx            *xc,
     xr = NULL;
     retval = 0;
  done:
-    if (re){
-#ifdef HAVE_LIBXML2
-        cligen_regex_libxml2_free(re);
-#else
-        cligen_regex_posix_free(re);
-        free(re);
-#endif
-    }
+    if (re)
+        regex_cache_release(mode, re);
     if (xr0)
         ctx_free(xr0);
     if (xr1)
@@ -270,8 +261,6 @@ xp_function_re_match(xp_ctx            *xc,
         free(s0);
     if (regexp)
         free(regexp);
-    if (posix)
-        free(posix);
     return retval;
 }
 
@@ -336,33 +325,28 @@ xp_function_deref(xp_ctx            *xc0,
 
 /*! Helper function for derived-from(-and-self) - eval one node
  *
- * @param[in]  nsc  XML Namespace context
- * @param[in]  self If set, implements derived_from_or_self
- * @retval     1    OK and match
- * @retval     0    OK but not match
- * @retval    -1    Error
+ * @param[in]  ybaseid Base identity
+ * @param[in]  xleaf   XML leaf node of type identityref
+ * @param[in]  self    If set, implements derived_from_or_self
+ * @retval     1       OK and match
+ * @retval     0       OK but not match
+ * @retval    -1       Error
  */
 static int
-derived_from_one(char  *baseidentity,
-                 cvec  *nsc,
-                 cxobj *xleaf,
-                 int    self)
+derived_from_one(yang_stmt *ybaseid,
+                 cxobj     *xleaf,
+                 int        self)
 {
     int        retval = -1;
     yang_stmt *yleaf;
     yang_stmt *ytype;
-    yang_stmt *ybaseid;
     yang_stmt *ymod;
-    cvec      *idrefvec; /* Derived identityref list: (module:id)**/
+    yang_stmt *yid;
     char      *node = NULL;
     char      *prefix = NULL;
     char      *id = NULL;
-    cbuf      *cb = NULL;
-    char      *baseid = NULL;
+    int        ret;
 
-    /* Split baseidentity to get its id (w/o prefix) */
-    if (nodeid_split(baseidentity, NULL, &baseid) < 0)
-        goto done;
     if ((yleaf = xml_spec(xleaf)) == NULL)
         goto nomatch;
     if (yang_keyword_get(yleaf) != Y_LEAF && yang_keyword_get(yleaf) != Y_LEAF_LIST)
@@ -378,11 +362,6 @@ derived_from_one(char  *baseidentity,
      * xleaf <type>fast-ethernet</type>
      * yleaf type identityref{base interface-type;}
      */
-    /* Just get the object corresponding to the base identity */
-    if ((ybaseid = yang_find_identity_nsc(ys_spec(yleaf), baseidentity, nsc)) == NULL)
-        goto nomatch;
-    /* Get its list of derived identities  */
-    idrefvec = yang_cvec_get(ybaseid);
     /* Get and split the leaf id reference */
     if ((node = xml_body(xleaf)) == NULL) /* It may not be empty */
         goto nomatch;
@@ -396,28 +375,19 @@ derived_from_one(char  *baseidentity,
     }
     if (ymod == NULL)
         goto nomatch;
+    if ((yid = yang_find(ymod, Y_IDENTITY, id)) == NULL)
+        goto nomatch;
     /* self special case, ie that the xleaf has a ref to itself */
-    if (self &&
-        ymod == ys_module(ybaseid) &&
-        strcmp(baseid, id) == 0){
+    if (self && yid == ybaseid)
         ; /* match */
-    }
     else {
-        /* Allocate cbuf */
-        if ((cb = cbuf_new()) == NULL){
-            clixon_err(OE_UNIX, errno, "cbuf_new");
+        if ((ret = yang_identity_derived(yid, ybaseid)) < 0)
             goto done;
-        }
-        cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
-        if (cvec_find(idrefvec, cbuf_get(cb)) == NULL)
+        if (ret == 0)
             goto nomatch;
     }
     retval = 1;
  done:
-    if (baseid)
-        free(baseid);
-    if (cb)
-        cbuf_free(cb);
     if (id)
         free(id);
     if (prefix)
@@ -459,6 +429,9 @@ xp_function_derived_from(xp_ctx            *xc,
     char      *identity = NULL;
     int        i;
     int        ret = 0;
+    cxobj     *x;
+    yang_stmt *yspec = NULL;
+    yang_stmt *ybaseid = NULL;
 
     if (xs == NULL || xs->xs_c0 == NULL || xs->xs_c1 == NULL){
         clixon_err(OE_XML, EINVAL, "derived-from expects but did not get two arguments");
@@ -484,7 +457,17 @@ xp_function_derived_from(xp_ctx            *xc,
     xr->xc_type = XT_BOOL;
     /* ANY node is an identityref and its value an identity that is derived ... */
     for (i=0; i<xr0->xc_size; i++){
-        if ((ret = derived_from_one(identity, nsc, xr0->xc_nodeset[i], self)) < 0)
+        x = xr0->xc_nodeset[i];
+        if (xml_spec(x) == NULL)
+            continue;
+        /* Get the object corresponding to the base identity, once per yang spec */
+        if (ys_spec(xml_spec(x)) != yspec){
+            yspec = ys_spec(xml_spec(x));
+            ybaseid = yang_find_identity_nsc(yspec, identity, nsc);
+        }
+        if (ybaseid == NULL)
+            continue;
+        if ((ret = derived_from_one(ybaseid, x, self)) < 0)
             goto done;
         if (ret == 1)
             break;
@@ -612,9 +595,99 @@ xp_function_position(xp_ctx            *xc,
     return retval;
 }
 
+/*! Count children of a node matching a name test without building a node-set
+ *
+ * Uses the cached range of children with the yang spec of the name, see xml_child_group
+ * @param[in]  xp        XML parent node
+ * @param[in]  nodetest  XPath tree of type XP_NODE
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] count     Number of matching children
+ * @retval     1         OK, count is set
+ * @retval     0         Not applicable, eg no cached range, count using a node-set
+ */
+int
+xp_count_children(cxobj      *xp,
+                  xpath_tree *nodetest,
+                  cvec       *nsc,
+                  int         localonly,
+                  int        *count)
+{
+    yang_stmt *yp;
+    yang_stmt *yc;
+    int        start;
+    int        end;
+
+    if (nodetest == NULL ||
+        nodetest->xs_type != XP_NODE ||
+        nodetest->xs_s1 == NULL ||
+        strcmp(nodetest->xs_s1, "*") == 0)
+        return 0;
+    if ((yp = xml_spec(xp)) == NULL)
+        return 0;
+    if ((yc = yang_find_datanode(yp, nodetest->xs_s1)) == NULL)
+        return 0;
+    if (xml_child_group(xp, yc, &start, &end) != 1 || start == end)
+        return 0;
+    /* All children in range have same name and namespace */
+    if (nodetest_eval(xml_child_i(xp, start), nodetest, nsc, localonly) != 1)
+        return 0;
+    *count = end - start;
+    return 1;
+}
+
+/*! Check if XPath is a relative path of parent steps and a final child name test
+ *
+ * Matches eg "entry", "../entry" and "../../entry", without predicates
+ * @param[in]  xs        XPath tree, argument of count()
+ * @param[out] nparents  Number of leading parent steps
+ * @param[out] nodetest  Name test of last step
+ * @retval     1         Match
+ * @retval     0         No match
+ */
+static int
+count_children_path(xpath_tree  *xs,
+                    int         *nparents,
+                    xpath_tree **nodetest)
+{
+    xpath_tree *xstep;
+
+    /* Skip single operand expressions down to location path */
+    while (xs && xs->xs_c1 == NULL &&
+           (xs->xs_type == XP_EXP || xs->xs_type == XP_AND || xs->xs_type == XP_RELEX ||
+            xs->xs_type == XP_ADD || xs->xs_type == XP_UNION || xs->xs_type == XP_PATHEXPR ||
+            xs->xs_type == XP_LOCPATH))
+        xs = xs->xs_c0;
+    if (xs == NULL || xs->xs_type != XP_RELLOCPATH)
+        return 0;
+    *nparents = 0;
+    *nodetest = NULL;
+    /* Last step first */
+    while (xs && xs->xs_type == XP_RELLOCPATH && xs->xs_int != A_DESCENDANT_OR_SELF){
+        xstep = xs->xs_c1 ? xs->xs_c1 : xs->xs_c0;
+        if (xstep == NULL || xstep->xs_type != XP_STEP)
+            return 0;
+        if (xstep->xs_c1 && (xstep->xs_c1->xs_c0 || xstep->xs_c1->xs_c1)) /* Predicates */
+            return 0;
+        if (*nodetest == NULL){
+            if (xstep->xs_int != A_CHILD)
+                return 0;
+            *nodetest = xstep->xs_c0;
+        }
+        else if (xstep->xs_int == A_PARENT && xstep->xs_c0 == NULL)
+            (*nparents)++;
+        else
+            return 0;
+        xs = xs->xs_c1 ? xs->xs_c0 : NULL;
+    }
+    return xs == NULL && *nodetest != NULL;
+}
+
 /*! The count function returns the number of nodes in the argument node-set.
  *
  * Signature: number count(node-set)
+ * Counting children in a list, eg count(../entry), does not build a node-set if the range of
+ * the list is cached, see xp_count_children
  */
 int
 xp_function_count(xp_ctx            *xc,
@@ -626,12 +699,28 @@ xp_function_count(xp_ctx            *xc,
     int         retval = -1;
     xp_ctx     *xr = NULL;
     xp_ctx     *xr0 = NULL;
+    xpath_tree *nodetest;
+    cxobj      *x = NULL;
+    int         nparents;
+    int         n = -1;
+    int         i;
 
     if (xs == NULL || xs->xs_c0 == NULL){
         clixon_err(OE_XML, EINVAL, "count expects but did not get one argument");
         goto done;
     }
-    if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+    if (xc->xc_type == XT_NODESET &&
+        xc->xc_size == 1 &&
+        xc->xc_descendant == 0 &&
+        count_children_path(xs->xs_c0, &nparents, &nodetest) == 1){
+        x = xc->xc_nodeset[0];
+        for (i=0; i<nparents && x != NULL; i++)
+            x = xml_parent(x);
+        if (x == NULL || xp_count_children(x, nodetest, nsc, localonly, &n) == 0)
+            n = -1;
+    }
+    if (n < 0 &&
+        xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
         goto done;
     if ((xr = malloc(sizeof(*xr))) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
@@ -639,7 +728,7 @@ xp_function_count(xp_ctx            *xc,
     }
     memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_NUMBER;
-    xr->xc_number = xr0->xc_size;
+    xr->xc_number = n < 0 ? xr0->xc_size : n;
     *xrp = xr;
     retval = 0;
  done:
@@ -74,17 +74,54 @@
 static xpath_tree *_xmtop = NULL; /* pattern match tree top */
 static xpath_tree *_xm = NULL;
 static xpath_tree *_xe = NULL;
+static xpath_tree *_xstop = NULL; /* pattern match tree top of leaf-list value */
+static xpath_tree *_xes = NULL;
 static int _optimize_enable = 1;
 static int _optimize_hits = 0;
+static int _optimize_misses = 0;
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/* XXX development in clixon_xpath_eval */
+/*! Get and reset xpath list optimize statistics
+ *
+ * @param[out] hits    Number of child steps made with binary search since last call
+ * @param[out] misses  Number of child steps reverted to linear search since last call
+ * @retval     0       OK
+ */
 int
-xpath_list_optimize_stats(int *hits)
+xpath_list_optimize_stats(int *hits,
+                          int *misses)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    *hits = _optimize_hits;
+    if (hits)
+        *hits = _optimize_hits;
+    if (misses)
+        *misses = _optimize_misses;
     _optimize_hits = 0;
+    _optimize_misses = 0;
+#endif
+    return 0;
+}
+
+/*! Get xpath list optimize statistics without reset
+ *
+ * @param[out] hits    Number of child steps made with binary search
+ * @param[out] misses  Number of child steps reverted to linear search
+ * @retval     0       OK
+ * @see xpath_list_optimize_stats  Get and reset
+ */
+int
+xpath_list_optimize_get(int *hits,
+                        int *misses)
+{
+    if (hits)
+        *hits = 0;
+    if (misses)
+        *misses = 0;
+#ifdef XPATH_LIST_OPTIMIZE
+    if (hits)
+        *hits = _optimize_hits;
+    if (misses)
+        *misses = _optimize_misses;
 #endif
     return 0;
 }
@@ -108,6 +145,8 @@ xpath_optimize_exit(void)
 #ifdef XPATH_LIST_OPTIMIZE
     if (_xmtop)
         xpath_tree_free(_xmtop);
+    if (_xstop)
+        xpath_tree_free(_xstop);
 #endif
 }
 
@@ -115,11 +154,15 @@ xpath_optimize_exit(void)
 /*! Initialize xpath module
  *
  * XXX move to clixon_xpath.c 
+ * @param[out] xm   Pattern of step with predicates: _x[...]
+ * @param[out] xe   Pattern of key predicate expression: _y='_z'
+ * @param[out] xes  Pattern of leaf-list value predicate expression: .='_z'
  * @see loop_preds
  */
-int
+static int
 xpath_optimize_init(xpath_tree **xm,
-                    xpath_tree **xe)
+                    xpath_tree **xe,
+                    xpath_tree **xes)
 {
     int         retval = -1;
     xpath_tree *xs;
@@ -151,8 +194,22 @@ xpath_optimize_init(xpath_tree **xm,
             goto done;
         xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
     }
+    if (_xes == NULL){
+        /* Same as above but with self as left operand */
+        if (xpath_parse("_x[.='_z']", &_xstop) < 0)
+            goto done;
+        if ((xs = xpath_tree_traverse(_xstop, 0, 0, 1, -1)) == NULL)
+            goto done;
+        if ((_xes = xpath_tree_traverse(xs, 1, -1)) == NULL)
+            goto done;
+        /* get value (_z) */
+        if ((xs = xpath_tree_traverse(_xes, 0, 0, 1, 0, 0, 0, 0, -1)) == NULL)
+            goto done;
+        xs->xs_match++;
+    }
     *xm = _xm;
     *xe = _xe;
+    *xes = _xes;
     retval = 0;
  done:
     return retval;
@@ -162,7 +219,8 @@ xpath_optimize_init(xpath_tree **xm,
  *
  * @param[in]  xt    XPath tree of type PRED
  * @param[in]  xepat Pattern matching XPath tree of type EXPR
- * @param[out] cvk   Vector of <keyname>:<keyval> pairs
+ * @param[in]  xespat Pattern matching leaf-list value XPath tree of type EXPR
+ * @param[out] cvk   Vector of <keyname>:<keyval> pairs, name is "." for leaf-list value
  * @retval     1     Match
  * @retval     0     No match
  * @retval    -1     Error
@@ -171,6 +229,7 @@ xpath_optimize_init(xpath_tree **xm,
 static int
 loop_preds(xpath_tree *xt,
            xpath_tree *xepat,
+           xpath_tree *xespat,
            cvec       *cvk)
 {
     int          retval = -1;
@@ -179,9 +238,11 @@ loop_preds(xpath_tree *xt,
     xpath_tree **vec = NULL;
     size_t       veclen = 0;
     cg_var      *cvi;
+    char        *name;
+    xpath_tree  *xval;
 
     if (xt->xs_type == XP_PRED && xt->xs_c0){
-        if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
+        if ((ret = loop_preds(xt->xs_c0, xepat, xespat, cvk)) < 0)
             goto done;
         if (ret == 0)
             goto ok;
@@ -189,19 +250,28 @@ loop_preds(xpath_tree *xt,
     if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
         if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
             goto done;
-        if (ret == 0)
-            goto ok;
-        if (veclen != 2)
-            goto ok;
+        if (ret == 1 && veclen == 2){
+            name = vec[0]->xs_s1;
+            xval = vec[1];
+        }
+        else { /* Leaf-list value: .='_z' */
+            veclen = 0;
+            if ((ret = xpath_tree_eq(xespat, xe, &vec, &veclen)) < 0)
+                goto done;
+            if (ret == 0 || veclen != 1)
+                goto ok;
+            name = ".";
+            xval = vec[0];
+        }
         if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
             clixon_err(OE_XML, errno, "cvec_add");
             goto done;
         }
-        cv_name_set(cvi, vec[0]->xs_s1);
-        if (vec[1]->xs_type == XP_PRIME_NR)
-            cv_string_set(cvi, vec[1]->xs_strnr);
+        cv_name_set(cvi, name);
+        if (xval->xs_type == XP_PRIME_NR)
+            cv_string_set(cvi, xval->xs_strnr);
         else
-            cv_string_set(cvi, vec[1]->xs_s0);
+            cv_string_set(cvi, xval->xs_s0);
     }
     retval = 1;
  done:
@@ -226,6 +296,14 @@ loop_preds(xpath_tree *xt,
  * @retval    -1      Error
  *  XPath:
  *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
+ *  y[k1=3][k2=4] # all keys, or leading keys only, eg y[k1=3] for a list with keys "k1 k2"
+ *  y[k2=4][k1=3] # predicates in any order, keys are picked in yang key order
+ *  y[k1=3][x=5]  # non-key predicates are ignored here and evaluated on the result
+ *  y[i=5]        # single non-key leaf with explicit search index, see XML_EXPLICIT_INDEX
+ *  y[.='x']      # leaf-list value
+ * The context node may itself be a list entry, ie nested paths such as a[k=1]/y[k=3] are
+ * optimized step by step.
+ * Returning a superset is OK since all predicates are evaluated on the result by the caller.
  */
 static int
 xpath_list_optimize_fn(xpath_tree  *xt,
@@ -235,6 +313,7 @@ xpath_list_optimize_fn(xpath_tree  *xt,
     int          retval = -1;
     xpath_tree  *xm = NULL;
     xpath_tree  *xem = NULL;
+    xpath_tree  *xes = NULL;
     char        *name;
     yang_stmt   *yp;
     yang_stmt   *yc;
@@ -243,10 +322,11 @@ xpath_list_optimize_fn(xpath_tree  *xt,
     size_t       veclen = 0;
     xpath_tree  *xtp;
     int          ret;
+    cvec        *cvp = NULL; /* vector of predicate name/values */
     cvec        *cvk = NULL; /* vector of index keys */
     cg_var      *cvi;
-    int          i;
-    yang_stmt   *ypp;
+    cg_var      *cvy;
+    char        *kname;
 
     /* revert to non-optimized if no yang */
     if ((yp = xml_spec(xv)) == NULL)
@@ -254,17 +334,12 @@ xpath_list_optimize_fn(xpath_tree  *xt,
     /* or if not config data (state data should not be ordered) */
     if (yang_config_ancestor(yp) == 0)
         goto ok;
-    /* Check that there is no "outer" list. */
-    ypp = yp;
-    do {
-        if (yang_keyword_get(ypp) == Y_LIST)
-            goto ok;
-    } while((ypp = yang_parent_get(ypp)) != NULL);
     /* Check yang and that only a list with key as index is a special case can do bin search 
      * That is, ONLY check optimize cases of this type:_x[_y='_z']
      * Should we extend this simple example and have more cases (all cases?)
      */
-    xpath_optimize_init(&xm, &xem);
+    if (xpath_optimize_init(&xm, &xem, &xes) < 0)
+        goto done;
     /* Here is where pattern is checked for equality and where variable binding is made (if
      * equal) */
     if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
@@ -275,33 +350,69 @@ xpath_list_optimize_fn(xpath_tree  *xt,
         goto ok;
     name = vec[0]->xs_s1;
     /* Extract variables */
-    if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
-#ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
-        if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
-#endif
-            goto ok;
-    /* Validate keys */
-    if ((cvv = yang_cvec_get(yc)) == NULL)
+    if ((yc = yang_find(yp, Y_LIST, name)) == NULL &&
+        (yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL)
         goto ok;
     xtp = vec[1];
-    if ((cvk = cvec_new(0)) == NULL){
+    if ((cvp = cvec_new(0)) == NULL){
         clixon_err(OE_YANG, errno, "cvec_new");
         goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    if ((ret = loop_preds(xtp, xem, xes, cvp)) < 0)
         goto done;
-    if (ret == 0)
+    if (ret == 0 || cvec_len(cvp) == 0)
         goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
+    if ((cvk = cvec_new(0)) == NULL){
+        clixon_err(OE_YANG, errno, "cvec_new");
+        goto done;
+    }
+    if (yang_keyword_get(yc) == Y_LEAF_LIST){
+        /* Value of leaf-list entry, eg y[.='x'] */
+        if ((cvi = cvec_find(cvp, ".")) == NULL)
+            goto ok;
+        if (cvec_append_var(cvk, cvi) == NULL){
+            clixon_err(OE_YANG, errno, "cvec_append_var");
+            goto done;
+        }
+        goto search;
+    }
+    /* Validate keys */
+    if ((cvv = yang_cvec_get(yc)) == NULL)
         goto ok;
-    i = 0;
-    cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
+    /* All keys, or leading keys only which gives a range search in a sorted list */
+    cvy = NULL;
+    while ((cvy = cvec_each(cvv, cvy)) != NULL) {
+        kname = cv_string_get(cvy);
+        if ((cvi = cvec_find(cvp, kname)) == NULL)
+            break;
+        if (cvec_append_var(cvk, cvi) == NULL){
+            clixon_err(OE_YANG, errno, "cvec_append_var");
+            goto done;
+        }
+    }
+    if (cvec_len(cvk) == 0){
+#ifdef XML_EXPLICIT_INDEX
+        /* No leading key: try a leaf with an explicit search index */
+        yang_stmt *yi;
+
+        cvi = NULL;
+        while ((cvi = cvec_each(cvp, cvi)) != NULL) {
+            if ((yi = yang_find_datanode(yc, cv_name_get(cvi))) != NULL &&
+                yang_keyword_get(yi) == Y_LEAF &&
+                yang_flag_get(yi, YANG_FLAG_INDEX) != 0)
+                break;
+        }
+        if (cvi == NULL)
             goto ok;
-        i++;
+        if (cvec_append_var(cvk, cvi) == NULL){
+            clixon_err(OE_YANG, errno, "cvec_append_var");
+            goto done;
+        }
+#else
+        goto ok;
+#endif
     }
+ search:
     /* Use 2a form since yc already given to compute cvk */
     if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
         goto done;
@@ -309,6 +420,8 @@ xpath_list_optimize_fn(xpath_tree  *xt,
  done:
     if (vec)
         free(vec);
+    if (cvp)
+        cvec_free(cvp);
     if (cvk)
         cvec_free(cvk);
     return retval;
@@ -355,6 +468,7 @@ xpath_optimize_check(xpath_tree *xs,
         retval = 1; /* Optimized */
         goto done;
     }
+    _optimize_misses++;
  ok:
     retval = 0; /* use regular code */
  done:
@@ -198,6 +198,7 @@ xp_new(enum xp_type  type,
        xpath_tree   *c1)
 {
     xpath_tree *xs = NULL;
+    int         ret = 0;
 
     if ((xs = malloc(sizeof(xpath_tree))) == NULL){
         clixon_err(OE_XML, errno, "malloc");
@@ -217,6 +218,10 @@ xp_new(enum xp_type  type,
         xs->xs_double = 0.0;
     xs->xs_s0  = s0;
     xs->xs_s1  = s1;
+    if (s1 && (ret = xml_intern(s1, &xs->xs_s1i)) < 0)
+        goto done;
+    if (ret == 1)
+        xml_intern_ref(1); /* Released in xpath_tree_free */
     xs->xs_c0  = c0;
     xs->xs_c1  = c1;
  done:
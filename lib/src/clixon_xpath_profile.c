@@ -0,0 +1,318 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ * XPath evaluation profiler
+ * When debug subject CLIXON_DBG_PROFILE is set, every XPath evaluation is recorded per
+ * expression and per originating YANG statement, eg a must or when statement:
+ * number of calls, total and max time, result node-set sizes and list optimizer hits.
+ * The profile is exposed in the stats RPC, see from_client_stats
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_string.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xpath_profile.h"
+
+/* Max number of profiled expressions, new expressions are not recorded when full */
+#define XPATH_PROFILE_SIZE 4096
+
+/*
+ * Types
+ */
+/*! Profile of one XPath expression evaluated from one origin
+ */
+struct xpath_profile_entry{
+    qelem_t   xp_q;         /* Queue of entries, in order of first evaluation */
+    char     *xp_xpath;     /* XPath expression */
+    char     *xp_origin;    /* Originating YANG statement, or NULL */
+    uint64_t  xp_calls;     /* Number of evaluations */
+    uint64_t  xp_usec;      /* Total time of evaluations in micro-seconds */
+    uint64_t  xp_maxusec;   /* Max time of one evaluation in micro-seconds */
+    uint64_t  xp_nodes;     /* Sum of result node-set sizes */
+    uint64_t  xp_maxnodes;  /* Max result node-set size */
+    uint64_t  xp_opthits;   /* Child steps made with binary search by list optimizer */
+    uint64_t  xp_optmisses; /* Child steps where list optimizer reverted to linear search */
+};
+
+/*
+ * Variables
+ */
+/* Profile entries: "<origin>\n<xpath>" -> struct xpath_profile_entry* */
+static clicon_hash_t              *_xpath_profile = NULL;
+/* Queue of profile entries */
+static struct xpath_profile_entry *_xpath_profile_list = NULL;
+/* Number of profile entries */
+static int                         _xpath_profile_nr = 0;
+/* Originating YANG statement of current evaluations, see xpath_profile_origin
+ * Per thread since XPaths may be evaluated in threads, eg by parallel validation */
+#ifdef HAVE_LIBPTHREAD
+static __thread yang_stmt         *_xpath_profile_origin = NULL;
+#else
+static yang_stmt                  *_xpath_profile_origin = NULL;
+#endif
+
+/*! Check if XPath profiling is enabled
+ *
+ * @retval  1  Enabled by debug subject CLIXON_DBG_PROFILE
+ * @retval  0  Not enabled
+ */
+int
+xpath_profile_enabled(void)
+{
+    return clixon_debug_isset(CLIXON_DBG_PROFILE);
+}
+
+/*! Set originating YANG statement of following XPath evaluations
+ *
+ * Used by must and when validation to attribute evaluations to a YANG statement
+ * @param[in]  ys  YANG statement, eg must or when, or NULL
+ * @retval     ys  Previous originating YANG statement, restore after evaluation
+ * @code
+ *   yold = xpath_profile_origin(ymust);
+ *   nr = xpath_vec_bool_tree(xt, nsc, xpt);
+ *   xpath_profile_origin(yold);
+ * @endcode
+ */
+yang_stmt *
+xpath_profile_origin(yang_stmt *ys)
+{
+    yang_stmt *yold = _xpath_profile_origin;
+
+    _xpath_profile_origin = ys;
+    return yold;
+}
+
+/*! Print schema node path of YANG statement, eg /a/b
+ *
+ * @param[in]  cb  CLIgen buffer
+ * @param[in]  ys  YANG statement
+ */
+static void
+xpath_profile_path2cbuf(cbuf      *cb,
+                        yang_stmt *ys)
+{
+    if (ys == NULL ||
+        yang_keyword_get(ys) == Y_MODULE ||
+        yang_keyword_get(ys) == Y_SUBMODULE)
+        return;
+    xpath_profile_path2cbuf(cb, yang_parent_get(ys));
+    cprintf(cb, "/%s", yang_argument_get(ys));
+}
+
+/*! Record one XPath evaluation in the profile
+ *
+ * @param[in]  xpath     XPath expression
+ * @param[in]  usec      Time of evaluation in micro-seconds
+ * @param[in]  nodes     Size of result node-set, 0 if not a node-set
+ * @param[in]  opthits   Child steps made with binary search by list optimizer
+ * @param[in]  optmisses Child steps where list optimizer reverted to linear search
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+int
+xpath_profile_add(const char *xpath,
+                  uint64_t    usec,
+                  uint64_t    nodes,
+                  uint64_t    opthits,
+                  uint64_t    optmisses)
+{
+    int                          retval = -1;
+    cbuf                        *cb = NULL;
+    struct xpath_profile_entry  *xe = NULL;
+    struct xpath_profile_entry **xep;
+    yang_stmt                   *ys;
+    yang_stmt                   *ymod;
+    size_t                       len;
+
+    if (xpath == NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    /* Origin first in key as: <keyword> <module>:<schema path> */
+    if ((ys = _xpath_profile_origin) != NULL){
+        cprintf(cb, "%s ", yang_key2str(yang_keyword_get(ys)));
+        if ((ymod = ys_module(ys)) != NULL)
+            cprintf(cb, "%s:", yang_argument_get(ymod));
+        xpath_profile_path2cbuf(cb, yang_parent_get(ys));
+    }
+    len = cbuf_len(cb);
+    cprintf(cb, "\n%s", xpath);
+    if (_xpath_profile == NULL &&
+        (_xpath_profile = clicon_hash_init()) == NULL)
+        goto done;
+    if ((xep = clicon_hash_value(_xpath_profile, cbuf_get(cb), NULL)) != NULL)
+        xe = *xep;
+    else {
+        if (_xpath_profile_nr >= XPATH_PROFILE_SIZE)
+            goto ok;
+        if ((xe = calloc(1, sizeof(*xe))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if ((xe->xp_xpath = strdup(xpath)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            free(xe);
+            goto done;
+        }
+        if (len && (xe->xp_origin = clicon_strndup(cbuf_get(cb), len)) == NULL){
+            clixon_err(OE_UNIX, errno, "strndup");
+            free(xe->xp_xpath);
+            free(xe);
+            goto done;
+        }
+        if (clicon_hash_add(_xpath_profile, cbuf_get(cb), &xe, sizeof(xe)) == NULL){
+            if (xe->xp_origin)
+                free(xe->xp_origin);
+            free(xe->xp_xpath);
+            free(xe);
+            goto done;
+        }
+        ADDQ(xe, _xpath_profile_list);
+        _xpath_profile_nr++;
+    }
+    xe->xp_calls++;
+    xe->xp_usec += usec;
+    if (usec > xe->xp_maxusec)
+        xe->xp_maxusec = usec;
+    xe->xp_nodes += nodes;
+    if (nodes > xe->xp_maxnodes)
+        xe->xp_maxnodes = nodes;
+    xe->xp_opthits += opthits;
+    xe->xp_optmisses += optmisses;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Print XPath profile as XML entries of clixon-lib stats xpath-profile
+ *
+ * @param[in]  cb   CLIgen buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xpath_profile_print(cbuf *cb)
+{
+    int                         retval = -1;
+    struct xpath_profile_entry *xe;
+    char                       *encstr = NULL;
+
+    if ((xe = _xpath_profile_list) != NULL){
+        do {
+            cprintf(cb, "<entry>");
+            if (xml_chardata_encode(&encstr, 0, "%s", xe->xp_xpath) < 0)
+                goto done;
+            cprintf(cb, "<xpath>%s</xpath>", encstr);
+            free(encstr);
+            encstr = NULL;
+            if (xe->xp_origin){
+                if (xml_chardata_encode(&encstr, 0, "%s", xe->xp_origin) < 0)
+                    goto done;
+                cprintf(cb, "<origin>%s</origin>", encstr);
+                free(encstr);
+                encstr = NULL;
+            }
+            cprintf(cb, "<calls>%" PRIu64 "</calls>", xe->xp_calls);
+            cprintf(cb, "<usec>%" PRIu64 "</usec>", xe->xp_usec);
+            cprintf(cb, "<maxusec>%" PRIu64 "</maxusec>", xe->xp_maxusec);
+            cprintf(cb, "<nodes>%" PRIu64 "</nodes>", xe->xp_nodes);
+            cprintf(cb, "<maxnodes>%" PRIu64 "</maxnodes>", xe->xp_maxnodes);
+            cprintf(cb, "<opthits>%" PRIu64 "</opthits>", xe->xp_opthits);
+            cprintf(cb, "<optmisses>%" PRIu64 "</optmisses>", xe->xp_optmisses);
+            cprintf(cb, "</entry>");
+            xe = NEXTQ(struct xpath_profile_entry *, xe);
+        } while (xe && xe != _xpath_profile_list);
+    }
+    retval = 0;
+ done:
+    if (encstr)
+        free(encstr);
+    return retval;
+}
+
+/*! Clear XPath profile and free all entries
+ *
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xpath_profile_exit(void)
+{
+    struct xpath_profile_entry *xe;
+
+    while ((xe = _xpath_profile_list) != NULL){
+        DELQ(xe, _xpath_profile_list, struct xpath_profile_entry *);
+        free(xe->xp_xpath);
+        if (xe->xp_origin)
+            free(xe->xp_origin);
+        free(xe);
+    }
+    _xpath_profile_nr = 0;
+    if (_xpath_profile){
+        clicon_hash_free(_xpath_profile);
+        _xpath_profile = NULL;
+    }
+    return 0;
+}
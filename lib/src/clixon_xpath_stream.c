@@ -0,0 +1,477 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Clixon XML XPath 1.0 according to https://www.w3.org/TR/xpath-10
+ * Streaming XPath evaluation during serialization, see XPATH_STREAM
+ * For a subset of XPath, matching nodes are found while walking the tree and are printed
+ * directly with their ancestors, without a node vector, marks or a copied result tree.
+ * The subset is absolute location paths of child steps with name tests and equality
+ * predicates of child leaves and string literals, eg:
+ *   /ex:a/ex:b[ex:k='x']/ex:c
+ * Other XPaths are not handled and the caller should use a regular XPath evaluation.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <syslog.h>
+#include <fcntl.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_xml_vec.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_xml_io.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xpath_stream.h"
+
+#ifdef XPATH_STREAM
+/*
+ * Types
+ */
+/*! One child step of a streamed XPath
+ */
+struct xpath_stream_step{
+    char *xss_ns;    /* Namespace of name test */
+    char *xss_name;  /* Name of name test */
+    cvec *xss_preds; /* Predicates as <name>=<value> string cvs, or NULL */
+};
+
+/*! Skip expression nodes with a single child, eg expr -> andexpr -> ... -> locationpath
+ */
+static xpath_tree *
+xpath_stream_unwrap(xpath_tree *xs)
+{
+    while (xs != NULL && xs->xs_c1 == NULL){
+        switch (xs->xs_type){
+        case XP_EXP:
+        case XP_AND:
+        case XP_RELEX:
+        case XP_ADD:
+        case XP_UNION:
+        case XP_FILTEREXPR:
+        case XP_LOCPATH:
+            break;
+        case XP_PATHEXPR:
+            if (xs->xs_s0 != NULL)
+                return xs;
+            break;
+        default:
+            return xs;
+        }
+        xs = xs->xs_c0;
+    }
+    return xs;
+}
+
+/*! Get name test of a child step without predicates, eg k in [k='x']
+ *
+ * @param[in]  xs    XPath tree of a relative location path
+ * @retval     xn    Node test of step
+ * @retval     NULL  Not a single child step without predicates
+ */
+static xpath_tree *
+xpath_stream_leafstep(xpath_tree *xs)
+{
+    xpath_tree *xn;
+
+    if (xs == NULL || xs->xs_type != XP_RELLOCPATH ||
+        xs->xs_int != A_NAN || xs->xs_c1 != NULL)
+        return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_STEP || xs->xs_int != A_CHILD)
+        return NULL;
+    if (xs->xs_c1 && (xs->xs_c1->xs_c0 || xs->xs_c1->xs_c1))
+        return NULL;
+    if ((xn = xs->xs_c0) == NULL || xn->xs_type != XP_NODE ||
+        xn->xs_s1 == NULL || strcmp(xn->xs_s1, "*") == 0)
+        return NULL;
+    return xn;
+}
+
+/*! Add predicates of a step on the form [name='literal'] to a vector
+ *
+ * @param[in]  xp    XPath tree of type PRED
+ * @param[in]  preds Vector of <name>=<value> pairs
+ * @retval     1     OK, predicates added
+ * @retval     0     Not streamable predicate
+ * @retval    -1     Error
+ */
+static int
+xpath_stream_preds(xpath_tree *xp,
+                   cvec       *preds)
+{
+    int         retval = -1;
+    int         ret;
+    xpath_tree *xe;
+    xpath_tree *xn;
+    xpath_tree *xl;
+    cg_var     *cv;
+
+    if (xp->xs_c0){
+        if ((ret = xpath_stream_preds(xp->xs_c0, preds)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    if (xp->xs_c1 == NULL)
+        goto ok;
+    if ((xe = xpath_stream_unwrap(xp->xs_c1)) == NULL ||
+        xe->xs_type != XP_RELEX || xe->xs_int != XO_EQ)
+        goto fail;
+    if ((xn = xpath_stream_leafstep(xpath_stream_unwrap(xe->xs_c0))) != NULL)
+        xl = xpath_stream_unwrap(xe->xs_c1);
+    else if ((xn = xpath_stream_leafstep(xpath_stream_unwrap(xe->xs_c1))) != NULL)
+        xl = xpath_stream_unwrap(xe->xs_c0);
+    else
+        goto fail;
+    /* Only string literals, numbers compare as numbers, not as strings */
+    if (xl == NULL || xl->xs_type != XP_PRIME_STR || xl->xs_s0 == NULL)
+        goto fail;
+    if ((cv = cvec_add(preds, CGV_STRING)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_add");
+        goto done;
+    }
+    cv_name_set(cv, xn->xs_s1);
+    cv_string_set(cv, xl->xs_s0);
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get child steps of a relative location path
+ *
+ * @param[in]     xs     XPath tree of type RELLOCPATH
+ * @param[in]     nsc    XML Namespace context
+ * @param[in,out] steps  Vector of steps, appended to
+ * @param[in,out] nsteps Length of steps
+ * @retval        1      OK
+ * @retval        0      Not streamable
+ * @retval       -1      Error
+ */
+static int
+xpath_stream_steps(xpath_tree                *xs,
+                   cvec                      *nsc,
+                   struct xpath_stream_step **steps,
+                   int                       *nsteps)
+{
+    int                       retval = -1;
+    int                       ret;
+    xpath_tree               *xstep;
+    xpath_tree               *xn;
+    struct xpath_stream_step *st;
+    char                     *ns;
+
+    if (xs->xs_type != XP_RELLOCPATH || xs->xs_int != A_NAN)
+        goto fail;
+    if (xs->xs_c1 == NULL)
+        xstep = xs->xs_c0;
+    else {
+        if (xs->xs_c0 == NULL)
+            goto fail;
+        if ((ret = xpath_stream_steps(xs->xs_c0, nsc, steps, nsteps)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        xstep = xs->xs_c1;
+    }
+    if (xstep == NULL || xstep->xs_type != XP_STEP || xstep->xs_int != A_CHILD)
+        goto fail;
+    if ((xn = xstep->xs_c0) == NULL || xn->xs_type != XP_NODE ||
+        xn->xs_s1 == NULL || strcmp(xn->xs_s1, "*") == 0)
+        goto fail;
+    if ((ns = xml_nsctx_get(nsc, xn->xs_s0)) == NULL)
+        goto fail;
+    if ((*steps = realloc(*steps, (*nsteps+1)*sizeof(**steps))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        goto done;
+    }
+    st = &(*steps)[(*nsteps)++];
+    memset(st, 0, sizeof(*st));
+    st->xss_ns = ns;
+    st->xss_name = xn->xs_s1;
+    if (xstep->xs_c1 && (xstep->xs_c1->xs_c0 || xstep->xs_c1->xs_c1)){
+        if ((st->xss_preds = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        if ((ret = xpath_stream_preds(xstep->xs_c1, st->xss_preds)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check if child of a list is a key and sibling step names it, print keys of list
+ *
+ * Keys of printed list entries are printed, as in xml_marked_filter. If the next step is a
+ * key, it is printed as key and counts as a match only if it is the last step.
+ * @param[in]  cb      Cligen buffer to write to
+ * @param[in]  x       XML list entry
+ * @param[in]  st      Next step, or NULL
+ * @param[in]  last    Next step is last step
+ * @param[in]  wdef    With-defaults parameter
+ * @param[out] iskey   Next step names a key of the list
+ * @param[out] match   Next step is a matched key
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xpath_stream_keys(cbuf                     *cb,
+                  cxobj                    *x,
+                  struct xpath_stream_step *st,
+                  int                       last,
+                  withdefaults_type         wdef,
+                  int                      *iskey,
+                  int                      *match)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cg_var    *cvi = NULL;
+    char      *kname;
+    cxobj     *xk;
+
+    *iskey = 0;
+    *match = 0;
+    if ((y = xml_spec(x)) == NULL || yang_keyword_get(y) != Y_LIST)
+        goto ok;
+    while ((cvi = cvec_each(yang_cvec_get(y), cvi)) != NULL){
+        kname = cv_string_get(cvi);
+        if ((xk = xml_find_type(x, NULL, kname, CX_ELMNT)) == NULL)
+            continue;
+        if (clixon_xml2cbuf1(cb, xk, 0, 0, NULL, -1, 0, wdef) < 0)
+            goto done;
+        if (st && strcmp(st->xss_name, kname) == 0){
+            *iskey = 1;
+            if (last && st->xss_preds == NULL)
+                *match = 1;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print children of an XML node matching a step, and their ancestors if anything matches
+ *
+ * @param[in]  cb      Cligen buffer to write to
+ * @param[in]  xp      XML parent node
+ * @param[in]  steps   Vector of steps
+ * @param[in]  i       Current step
+ * @param[in]  nsteps  Length of steps
+ * @param[in]  wdef    With-defaults parameter
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xpath_stream_recurse(cbuf                     *cb,
+                     cxobj                    *xp,
+                     struct xpath_stream_step *steps,
+                     int                       i,
+                     int                       nsteps,
+                     withdefaults_type         wdef)
+{
+    int                       retval = -1;
+    struct xpath_stream_step *st = &steps[i];
+    clixon_xvec              *xv = NULL;
+    cxobj                    *xc;
+    cxobj                    *xa;
+    size_t                    len0;
+    size_t                    len1;
+    int                       iskey;
+    int                       match;
+    int                       j;
+
+    if (xml_sort_ensure(xp) < 0)
+        goto done;
+    if ((xv = clixon_xvec_new()) == NULL)
+        goto done;
+    /* Binary search if predicates are leading keys, otherwise linear */
+    if (clixon_xml_find_index(xp, NULL, st->xss_ns, st->xss_name, st->xss_preds, xv) < 0)
+        goto done;
+    for (j=0; j<clixon_xvec_len(xv); j++){
+        xc = clixon_xvec_i(xv, j);
+        if (i == nsteps-1){ /* Last step: print whole sub-tree */
+            if (clixon_xml2cbuf1(cb, xc, 0, 0, NULL, -1, 0, wdef) < 0)
+                goto done;
+            continue;
+        }
+        /* Print start tag, and remove it again if nothing below matches */
+        len0 = cbuf_len(cb);
+        cbuf_append_str(cb, "<");
+        if (xml_prefix(xc)){
+            cbuf_append_str(cb, xml_prefix(xc));
+            cbuf_append_str(cb, ":");
+        }
+        cbuf_append_str(cb, xml_name(xc));
+        xa = NULL;
+        while ((xa = xml_child_each(xc, xa, CX_ATTR)) != NULL){
+            cbuf_append_str(cb, " ");
+            if (xml_prefix(xa)){
+                cbuf_append_str(cb, xml_prefix(xa));
+                cbuf_append_str(cb, ":");
+            }
+            cprintf(cb, "%s=\"%s\"", xml_name(xa), xml_value(xa));
+        }
+        cbuf_append_str(cb, ">");
+        if (xpath_stream_keys(cb, xc, &steps[i+1], i+1 == nsteps-1, wdef, &iskey, &match) < 0)
+            goto done;
+        len1 = cbuf_len(cb);
+        if (!iskey &&
+            xpath_stream_recurse(cb, xc, steps, i+1, nsteps, wdef) < 0)
+            goto done;
+        if (match || cbuf_len(cb) > len1){
+            cbuf_append_str(cb, "</");
+            if (xml_prefix(xc)){
+                cbuf_append_str(cb, xml_prefix(xc));
+                cbuf_append_str(cb, ":");
+            }
+            cbuf_append_str(cb, xml_name(xc));
+            cbuf_append_str(cb, ">");
+        }
+        else
+            cbuf_trunc(cb, len0);
+    }
+    retval = 0;
+ done:
+    if (xv)
+        clixon_xvec_free(xv);
+    return retval;
+}
+#endif /* XPATH_STREAM */
+
+/*! Print nodes matching an XPath and their ancestors while walking an XML tree
+ *
+ * Same output as marking the XPath result and its ancestors and printing with
+ * xml_marked_filter, but without node vector or marks. The top node is not printed.
+ * Only a subset of XPath is handled, see file header. Ancestors are printed with their
+ * list keys, and only if a descendant was printed.
+ * @param[in]  cb     Cligen buffer to write to
+ * @param[in]  xt     XML top node, eg datastore top
+ * @param[in]  nsc    XML Namespace context of xpath
+ * @param[in]  xpath  XPath, canonical
+ * @param[in]  wdef   With-defaults parameter, except WITHDEFAULTS_REPORT_ALL_TAGGED
+ * @retval     1      OK, matching nodes printed to cb, if any
+ * @retval     0      XPath not handled, nothing printed, use regular evaluation
+ * @retval    -1      Error
+ * @see xml_marked_filter
+ * @see XPATH_STREAM
+ */
+int
+xpath_stream2cbuf(cbuf             *cb,
+                  cxobj            *xt,
+                  cvec             *nsc,
+                  const char       *xpath,
+                  withdefaults_type wdef)
+{
+    int                       retval = -1;
+#ifdef XPATH_STREAM
+    xpath_tree               *xptree = NULL;
+    xpath_tree               *xs;
+    struct xpath_stream_step *steps = NULL;
+    int                       nsteps = 0;
+    int                       ret;
+    int                       i;
+
+    if (xpath == NULL || wdef == WITHDEFAULTS_REPORT_ALL_TAGGED)
+        goto fail;
+    if (xpath_parse(xpath, &xptree) < 0)
+        goto done;
+    if ((xs = xpath_stream_unwrap(xptree)) == NULL ||
+        xs->xs_type != XP_ABSPATH || xs->xs_int != A_ROOT)
+        goto fail;
+    if (xs->xs_c0 == NULL){ /* "/" */
+        if (clixon_xml2cbuf1(cb, xt, 0, 0, NULL, -1, 1, wdef) < 0)
+            goto done;
+        goto ok;
+    }
+    if ((ret = xpath_stream_steps(xs->xs_c0, nsc, &steps, &nsteps)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "stream %s", xpath);
+    if (xpath_stream_recurse(cb, xt, steps, 0, nsteps, wdef) < 0)
+        goto done;
+ ok:
+    retval = 1;
+ done:
+    if (steps){
+        for (i=0; i<nsteps; i++)
+            if (steps[i].xss_preds)
+                cvec_free(steps[i].xss_preds);
+        free(steps);
+    }
+    if (xptree)
+        xpath_tree_free(xptree);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+#else
+    retval = 0;
+    return retval;
+#endif /* XPATH_STREAM */
+}
@@ -79,6 +79,8 @@
 #include "clixon_xml_nsctx.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_path.h"
+#include "clixon_xpath_deps.h"
 #include "clixon_yang_module.h"
 #include "clixon_plugin.h"
 #include "clixon_data.h"
@@ -89,6 +91,7 @@
 #include "clixon_yang_cardinality.h"
 #include "clixon_yang_type.h"
 #include "clixon_yang_schema_mount.h"
+#include "clixon_yang_cache.h"
 #include "clixon_yang_internal.h" /* internal included by this file only, not API */
 
 #ifdef XML_EXPLICIT_INDEX
@@ -186,6 +189,59 @@ static size_t       _yang_mymodule_map_len = 0;
 /* See option CLICON_YANG_USE_ORIGINAL */
 static int _yang_use_orig = 0;
 
+#ifdef YANG_IDENTITY_BITSET
+/*! Index and base identities of an identity, see yang_identity_derived
+ */
+struct yang_identity{
+    uint32_t  yi_index;  /* Unique index of identity */
+    int       yi_len;    /* Number of words in yi_bits, -1 if not computed */
+    uint64_t *yi_bits;   /* Bit i set if identity with index i is a base, transitively */
+    char    **yi_derived;  /* Sorted derived identities <module>:<id>, NULL if not made */
+    int       yi_nderived; /* Length of yi_derived */
+};
+
+/* Next identity index */
+static uint32_t _yang_identity_nr = 0;
+#endif
+
+#if defined(YANG_DATANODE_INDEX) && !defined(YANG_SCHEMA_SUMMARY)
+#undef YANG_DATANODE_INDEX /* Index is part of schema summary */
+#endif
+
+#ifdef YANG_SCHEMA_SUMMARY
+/*! Schema summary of a YANG node, for mandatory and min-elements validation
+ */
+struct yang_summary{
+    uint8_t    ysm_mandatory; /* Node is mandatory unless a when condition fails */
+    uint8_t    ysm_deep;      /* Node or a descendant has mandatory true */
+    uint8_t    ysm_minmax;    /* An empty instance may violate min-elements of a list below */
+    uint8_t    ysm_when;      /* Node, or a mandatory node below, has a when condition */
+    uint8_t    ysm_serial;    /* Validation of an instance modifies shared state, no threads */
+#ifdef YANG_DATANODE_INDEX
+    uint32_t     ysm_nindex;  /* Length of ysm_index */
+    map_str2ptr *ysm_index;   /* Data nodes as found by yang_find_datanode, sorted on name */
+#endif
+    int        ysm_len;       /* Length of ysm_vec */
+    yang_stmt *ysm_vec[];     /* Children that may be mandatory, in schema order */
+};
+
+/* Shared summary of nodes without mandatory children or constraints */
+static struct yang_summary _yang_summary_empty = {0,};
+
+static void
+yang_summary_free(yang_stmt *ys)
+{
+    if (ys->ys_summary && ys->ys_summary != &_yang_summary_empty){
+#ifdef YANG_DATANODE_INDEX
+        if (ys->ys_summary->ysm_index)
+            free(ys->ys_summary->ysm_index);
+#endif
+        free(ys->ys_summary);
+    }
+    ys->ys_summary = NULL;
+}
+#endif /* YANG_SCHEMA_SUMMARY */
+
 /* Forward static */
 static int yang_type_cache_free(yang_type_cache *ycache);
 
@@ -244,6 +300,27 @@ yang_argument_get(yang_stmt *ys)
     return ys->ys_argument;
 }
 
+#ifdef XPATH_PARSE_CACHE
+/*! Free parsed XPath argument of must, when or path statement if argument changes
+ */
+static void
+yang_xpath_reset(yang_stmt *ys)
+{
+    switch (ys->ys_keyword){
+    case Y_MUST:
+    case Y_WHEN:
+    case Y_PATH:
+        if (ys->ys_xpath){
+            xpath_tree_free(ys->ys_xpath);
+            ys->ys_xpath = NULL;
+        }
+        break;
+    default:
+        break;
+    }
+}
+#endif
+
 /*! Set yang argument, not not copied
  *
  * @param[in] ys   Yang statement node
@@ -255,6 +332,9 @@ int
 yang_argument_set(yang_stmt *ys,
                   char      *arg)
 {
+#ifdef XPATH_PARSE_CACHE
+    yang_xpath_reset(ys);
+#endif
     ys->ys_argument = arg; /* not strdup/copied */
     return 0;
 }
@@ -276,6 +356,9 @@ yang_argument_dup(yang_stmt *ys,
         clixon_err(OE_UNIX, errno, "strdup");
         return -1;
     }
+#ifdef XPATH_PARSE_CACHE
+    yang_xpath_reset(ys);
+#endif
     ys->ys_argument = dup; /* not strdup/copied */
     return 0;
 }
@@ -714,6 +797,264 @@ yang_typecache_set(yang_stmt *ys,
     return 0;
 }
 
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+/*! Get mount-point cache of top-level yang mounts
+ *
+ * @param[in]  ys       Yang statement of type Y_MOUNTS
+ * @retval     ymc      Mount cache
+ * @retval     NULL     Not created
+ */
+void *
+yang_mntcache_get(yang_stmt *ys)
+{
+    if (ys->ys_keyword != Y_MOUNTS)
+        return NULL;
+    return ys->ys_mntcache;
+}
+
+/*! Set mount-point cache of top-level yang mounts
+ *
+ * @param[in]  ys      Yang statement of type Y_MOUNTS
+ * @param[in]  ymc     Mount cache, freed with ys_free
+ * @retval     0       OK
+ */
+int
+yang_mntcache_set(yang_stmt *ys,
+                  void      *ymc)
+{
+    ys->ys_mntcache = ymc;
+    return 0;
+}
+#endif /* YANG_SCHEMA_MOUNT_CACHE */
+
+/*! Get parsed XPath argument of must, when or path statement
+ *
+ * The argument is parsed on first call, eg at populate, and kept in the statement so that
+ * evaluation does not need to parse it again.
+ * @param[in]  ys     Yang statement of type Y_MUST, Y_WHEN or Y_PATH
+ * @retval     xpt    XPath parse tree (xpath_tree*), do not free
+ * @retval     NULL   Error, eg parse error or other keyword
+ * @see xpath_vec_ctx_tree
+ */
+void *
+yang_xpath_get(yang_stmt *ys)
+{
+    xpath_tree *xpt = NULL;
+
+    switch (ys->ys_keyword){
+    case Y_MUST:
+    case Y_WHEN:
+    case Y_PATH:
+        break;
+    default:
+        clixon_err(OE_YANG, EINVAL, "Not an XPath statement: %s", yang_key2str(ys->ys_keyword));
+        return NULL;
+    }
+#ifdef XPATH_PARSE_CACHE
+    if ((xpt = ys->ys_xpath) != NULL)
+        return xpt;
+    if (xpath_parse(yang_argument_get(ys), &xpt) < 0)
+        return NULL;
+    ys->ys_xpath = xpt;
+#ifdef VALIDATE_INCREMENTAL
+    if (xpath_tree_deps(xpt) < 0)
+        return NULL;
+#endif
+    return xpt;
+#else
+    clixon_err(OE_YANG, ENOTSUP, "XPATH_PARSE_CACHE not enabled");
+    return xpt;
+#endif
+}
+
+#ifdef YANG_IDENTITY_BITSET
+/*! Get index and bases of identity, allocate if not found
+ *
+ * @param[in]  yid   Yang identity statement
+ * @retval     yi    Identity index and bases, bases may not be computed
+ * @retval     NULL  Error
+ */
+static struct yang_identity *
+yang_identity_get(yang_stmt *yid)
+{
+    struct yang_identity *yi;
+
+    if ((yi = yid->ys_identity) == NULL){
+        if ((yi = malloc(sizeof(*yi))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            return NULL;
+        }
+        memset(yi, 0, sizeof(*yi));
+        yi->yi_index = _yang_identity_nr++;
+        yi->yi_len = -1;
+        yid->ys_identity = yi;
+    }
+    return yi;
+}
+
+/*! Extend base identity set to a number of words
+ */
+static int
+yang_identity_grow(struct yang_identity *yi,
+                   int                   len)
+{
+    uint64_t *bits;
+
+    if (len > yi->yi_len){
+        if ((bits = realloc(yi->yi_bits, len*sizeof(uint64_t))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        memset(&bits[yi->yi_len], 0, (len - yi->yi_len)*sizeof(uint64_t));
+        yi->yi_bits = bits;
+        yi->yi_len = len;
+    }
+    return 0;
+}
+
+/*! Compute set of all base identities of an identity, transitively
+ *
+ * @param[in]  yid   Yang identity statement
+ * @retval     yi    Identity index and bases
+ * @retval     NULL  Error
+ */
+static struct yang_identity *
+yang_identity_bases(yang_stmt *yid)
+{
+    struct yang_identity *yi;
+    struct yang_identity *yb;
+    yang_stmt            *yc;
+    yang_stmt            *ybase;
+    int                   inext;
+    int                   i;
+
+    if ((yi = yang_identity_get(yid)) == NULL)
+        return NULL;
+    if (yi->yi_len >= 0)
+        return yi;
+    yi->yi_len = 0; /* Also guards against cycles */
+    inext = 0;
+    while ((yc = yn_iter(yid, &inext)) != NULL) {
+        if (yc->ys_keyword != Y_BASE)
+            continue;
+        /* Checked at populate, see ys_populate_identity */
+        if ((ybase = yang_find_identity(yid, yang_argument_get(yc))) == NULL)
+            continue;
+        if ((yb = yang_identity_bases(ybase)) == NULL)
+            return NULL;
+        if (yang_identity_grow(yi, yb->yi_index/64 + 1) < 0 ||
+            yang_identity_grow(yi, yb->yi_len) < 0)
+            return NULL;
+        yi->yi_bits[yb->yi_index/64] |= (uint64_t)1 << (yb->yi_index%64);
+        for (i=0; i<yb->yi_len; i++)
+            yi->yi_bits[i] |= yb->yi_bits[i];
+    }
+    return yi;
+}
+#endif /* YANG_IDENTITY_BITSET */
+
+/*! Check if an identity is derived from a base identity
+ *
+ * With YANG_IDENTITY_BITSET each identity has an index and a bitset of the indexes of all its
+ * base identities, computed on first call. Otherwise the derived list of the base is searched.
+ * @param[in]  yid    Yang identity statement
+ * @param[in]  ybase  Yang base identity statement
+ * @retval     1      yid is derived from ybase, directly or transitively, but is not ybase
+ * @retval     0      Not derived
+ * @retval    -1      Error
+ * @see ys_populate_identity  where derived lists are made
+ */
+int
+yang_identity_derived(yang_stmt *yid,
+                      yang_stmt *ybase)
+{
+#ifdef YANG_IDENTITY_BITSET
+    struct yang_identity *yi;
+    struct yang_identity *yb;
+
+    if ((yi = yang_identity_bases(yid)) == NULL)
+        return -1;
+    if ((yb = yang_identity_get(ybase)) == NULL)
+        return -1;
+    if (yb->yi_index/64 >= yi->yi_len)
+        return 0;
+    return (yi->yi_bits[yb->yi_index/64] & ((uint64_t)1 << (yb->yi_index%64))) != 0;
+#else
+    int        retval = -1;
+    cbuf      *cb = NULL;
+    char      *id = NULL;
+    yang_stmt *ymod;
+
+    if ((ymod = ys_module(yid)) == NULL)
+        return 0;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (nodeid_split(yang_argument_get(yid), NULL, &id) < 0)
+        goto done;
+    cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
+    retval = yang_identity_derived_find(ybase, cbuf_get(cb));
+ done:
+    if (id)
+        free(id);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+#endif
+}
+
+#ifdef YANG_IDENTITY_BITSET
+static int
+yang_identity_strcmp(const void *a,
+                     const void *b)
+{
+    return strcmp(*(char **)a, *(char **)b);
+}
+#endif
+
+/*! Check if an identity given as <module>:<id> is in the derived list of a base identity
+ *
+ * With YANG_IDENTITY_BITSET the derived list is searched with binary search in a sorted
+ * vector made on first call. Otherwise the derived list is searched linearly.
+ * @param[in]  ybase  Yang base identity statement
+ * @param[in]  idref  Identity on canonical form <module>:<id>
+ * @retval     1      idref is derived from ybase
+ * @retval     0      Not derived
+ * @retval    -1      Error
+ * @see ys_populate_identity  where derived lists are made
+ */
+int
+yang_identity_derived_find(yang_stmt *ybase,
+                           char      *idref)
+{
+#ifdef YANG_IDENTITY_BITSET
+    struct yang_identity *yb;
+    cvec                 *cvv;
+    cg_var               *cv;
+
+    if ((cvv = yang_cvec_get(ybase)) == NULL)
+        return 0;
+    if ((yb = yang_identity_get(ybase)) == NULL)
+        return -1;
+    if (yb->yi_derived == NULL){
+        if ((yb->yi_derived = calloc(cvec_len(cvv)+1, sizeof(char *))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            return -1;
+        }
+        yb->yi_nderived = 0;
+        cv = NULL;
+        while ((cv = cvec_each(cvv, cv)) != NULL)
+            yb->yi_derived[yb->yi_nderived++] = cv_name_get(cv);
+        qsort(yb->yi_derived, yb->yi_nderived, sizeof(char *), yang_identity_strcmp);
+    }
+    return bsearch(&idref, yb->yi_derived, yb->yi_nderived, sizeof(char *),
+                   yang_identity_strcmp) != NULL;
+#else
+    return cvec_find(yang_cvec_get(ybase), idref) != NULL;
+#endif
+}
+
 /*! Get mymodule
  *
  * Shortcut to "my" module. Used by augmented and unknown nodes
@@ -762,6 +1103,8 @@ yang_mymodule_set(yang_stmt *ys,
 
 /* Stats */
 static uint64_t _stats_yang_nr = 0;
+static uint64_t _stats_yang_compact_nr = 0;   /* YANG objects removed by yang_compact */
+static uint64_t _stats_yang_compact_size = 0; /* Memory freed by yang_compact */
 
 /*! Get global statistics about YANG statements: created - freed
  *
@@ -775,6 +1118,23 @@ yang_stats_global(uint64_t *nr)
     return 0;
 }
 
+/*! Get global statistics about YANG statements removed by yang_compact
+ *
+ * @param[out]  nr  Number of removed YANG objects
+ * @param[out]  sz  Memory freed in bytes
+ * @see CLICON_YANG_COMPACT
+ */
+int
+yang_stats_compact(uint64_t *nr,
+                   uint64_t *sz)
+{
+    if (nr)
+        *nr = _stats_yang_compact_nr;
+    if (sz)
+        *sz = _stats_yang_compact_size;
+    return 0;
+}
+
 /*! Return the alloced memory of a single YANG obj
  *
  * @param[in]   y    YANG object
@@ -791,7 +1151,11 @@ yang_stats_one(yang_stmt *ys,
 
     sz += sizeof(struct yang_stmt);
     sz += ys->ys_len*sizeof(struct yang_stmt*);
-    if (ys->ys_argument)
+    if (ys->ys_argument
+#ifdef YANG_CACHE_SHARED
+        && !yang_cache_mapped(ys->ys_argument) /* Shared, not in process memory */
+#endif
+        )
         sz += strlen(ys->ys_argument) + 1;
     if (ys->ys_cvec)
         sz += cvec_size(ys->ys_cvec);
@@ -862,6 +1226,53 @@ yang_stats(yang_stmt    *yt,
     return retval;
 }
 
+/*! Remove documentation statements from a YANG tree recursively
+ *
+ * Remove description, reference, contact and organization statements, which are not used
+ * for validation or data handling. Removed objects and freed memory are counted, see
+ * yang_stats_compact.
+ * @param[in]  yt   YANG object
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see CLICON_YANG_COMPACT
+ */
+int
+yang_compact(yang_stmt *yt)
+{
+    int        retval = -1;
+    yang_stmt *ys;
+    int        i;
+    uint64_t   nr;
+    size_t     sz;
+
+    for (i=0; i<yt->ys_len; ){
+        ys = yt->ys_stmt[i];
+        switch (ys->ys_keyword){
+        case Y_DESCRIPTION:
+        case Y_REFERENCE:
+        case Y_CONTACT:
+        case Y_ORGANIZATION:
+            nr = 0;
+            sz = sizeof(struct yang_stmt *); /* Child pointer of parent */
+            if (yang_stats(ys, 0, &nr, &sz) < 0)
+                goto done;
+            _stats_yang_compact_nr += nr;
+            _stats_yang_compact_size += sz;
+            ys_prune(yt, i);
+            ys_free(ys);
+            break;
+        default:
+            if (yang_compact(ys) < 0)
+                goto done;
+            i++;
+            break;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /* stats end */
 
 /*! Create new yang specification for top domain, add as child to top-level yang_mounts
@@ -1048,11 +1459,17 @@ ys_free1(yang_stmt *ys,
         cvec_free(cvv);
     }
     if (ys->ys_argument){
+#ifdef YANG_CACHE_SHARED
+        if (!yang_cache_mapped(ys->ys_argument))
+#endif
         free(ys->ys_argument);
         ys->ys_argument = NULL;
     }
     if (ys->ys_stmt)
         free(ys->ys_stmt);
+#ifdef YANG_SCHEMA_SUMMARY
+    yang_summary_free(ys);
+#endif
     switch (ys->ys_keyword) {     /* type-specifi union fields */
     case Y_ACTION:
         while((rc = ys->ys_action_cb) != NULL) {
@@ -1081,10 +1498,38 @@ ys_free1(yang_stmt *ys,
             xml_free(ys->ys_nopres_cache);
         break;
 #endif
-#ifdef OPTIMIZE_YSPEC_NAMESPACE
+#ifdef XPATH_PARSE_CACHE
+    case Y_MUST:
+    case Y_WHEN:
+    case Y_PATH:
+        if (ys->ys_xpath)
+            xpath_tree_free(ys->ys_xpath);
+        break;
+#endif
+#ifdef YANG_IDENTITY_BITSET
+    case Y_IDENTITY:
+        if (ys->ys_identity){
+            if (ys->ys_identity->yi_bits)
+                free(ys->ys_identity->yi_bits);
+            if (ys->ys_identity->yi_derived)
+                free(ys->ys_identity->yi_derived);
+            free(ys->ys_identity);
+        }
+        break;
+#endif
     case Y_SPEC:
+#ifdef OPTIMIZE_YSPEC_NAMESPACE
         if (ys->ys_nscache)
             free(ys->ys_nscache);
+#endif
+#ifdef API_PATH_CACHE
+        api_path_cache_exit(); /* Cache is keyed by yspec */
+#endif
+        break;
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+    case Y_MOUNTS:
+        if (ys->ys_mntcache)
+            yang_mount_cache_free(ys->ys_mntcache);
         break;
 #endif
     default:
@@ -1097,6 +1542,36 @@ ys_free1(yang_stmt *ys,
     return 0;
 }
 
+#ifdef YANG_DATANODE_INDEX
+/*! Remove datanode indexes that may change when a child is added to or removed from a node
+ *
+ * The index of a node covers data nodes under choice, case, input and output
+ * @param[in]  yp   Parent of added or removed child
+ * @param[in]  yc   Added or removed child
+ */
+static void
+yang_datanode_index_clear(yang_stmt *yp,
+                          yang_stmt *yc)
+{
+    struct yang_summary *ysm;
+
+    if (!yang_datanode(yc) &&
+        yc->ys_keyword != Y_CHOICE && yc->ys_keyword != Y_CASE &&
+        yc->ys_keyword != Y_INPUT && yc->ys_keyword != Y_OUTPUT)
+        return;
+    for (; yp != NULL; yp = yp->ys_parent){
+        if ((ysm = yp->ys_summary) != NULL && ysm->ysm_index != NULL){
+            free(ysm->ysm_index);
+            ysm->ysm_index = NULL;
+            ysm->ysm_nindex = 0;
+        }
+        if (yp->ys_keyword != Y_CHOICE && yp->ys_keyword != Y_CASE &&
+            yp->ys_keyword != Y_INPUT && yp->ys_keyword != Y_OUTPUT)
+            break;
+    }
+}
+#endif /* YANG_DATANODE_INDEX */
+
 /*! Remove child i from parent yp (dont free) 
  *
  * @param[in]  yp   Parent node
@@ -1117,6 +1592,10 @@ ys_prune(yang_stmt *yp,
     if (i >= yp->ys_len)
         goto done;
     yc = yp->ys_stmt[i];
+#ifdef YANG_DATANODE_INDEX
+    if (yc)
+        yang_datanode_index_clear(yp, yc);
+#endif
     if (i < yp->ys_len - 1){
         size = (yp->ys_len - i - 1)*sizeof(struct yang_stmt *);
         memmove(&yp->ys_stmt[i],
@@ -1306,13 +1785,20 @@ ys_cp_one(yang_stmt *ynew,
     sz = sizeof(*yold);
     memcpy(ynew, yold, sz);
     yang_flag_reset(ynew, YANG_FLAG_WHEN); /* Dont inherit WHENs */
+#ifdef YANG_SCHEMA_SUMMARY
+    ynew->ys_summary = NULL; /* Made again, see yang_summary_set */
+#endif
     ynew->ys_parent = NULL;
     if (yold->ys_stmt)
         if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
             clixon_err(OE_YANG, errno, "calloc");
             goto done;
         }
-    if (yold->ys_argument)
+    if (yold->ys_argument
+#ifdef YANG_CACHE_SHARED
+        && !yang_cache_mapped(yold->ys_argument) /* Else shared, see memcpy above */
+#endif
+        )
         if ((ynew->ys_argument = strdup(yold->ys_argument)) == NULL){
             clixon_err(OE_YANG, errno, "strdup");
             goto done;
@@ -1343,10 +1829,27 @@ ys_cp_one(yang_stmt *ynew,
         yold->ys_nopres_cache = NULL;
         break;
 #endif
+#ifdef XPATH_PARSE_CACHE
+    case Y_MUST:
+    case Y_WHEN:
+    case Y_PATH:
+        ynew->ys_xpath = NULL; /* Parsed again on first use */
+        break;
+#endif
+#ifdef YANG_IDENTITY_BITSET
+    case Y_IDENTITY:
+        ynew->ys_identity = NULL; /* Computed again on first use */
+        break;
+#endif
 #ifdef OPTIMIZE_YSPEC_NAMESPACE
     case Y_SPEC:
         yold->ys_nscache = NULL;
         break;
+#endif
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+    case Y_MOUNTS:
+        ynew->ys_mntcache = NULL;
+        break;
 #endif
     default:
         break;
@@ -1476,6 +1979,9 @@ yn_insert(yang_stmt *ys_parent,
         return -1;
     ys_parent->ys_stmt[pos] = ys_child;
     ys_child->ys_parent = ys_parent;
+#ifdef YANG_DATANODE_INDEX
+    yang_datanode_index_clear(ys_parent, ys_child);
+#endif
     return 0;
 }
 
@@ -1525,6 +2031,30 @@ yn_iter(yang_stmt *yparent,
     return yc;
 }
 
+#ifdef YANG_DATANODE_INDEX
+/*! Look up data node in the datanode index of a YANG node
+ *
+ * @param[in]  yn        YANG node
+ * @param[in]  argument  Name of data node
+ * @param[out] ysp       Data node as yang_find_datanode, or NULL if not found
+ * @retval     1         Node has an index, ysp set
+ * @retval     0         No index, search linearly
+ * @see yang_datanode_index_make
+ */
+static int
+yang_datanode_index_find(yang_stmt  *yn,
+                         const char *argument,
+                         yang_stmt **ysp)
+{
+    struct yang_summary *ysm;
+
+    if ((ysm = yn->ys_summary) == NULL || ysm->ysm_index == NULL)
+        return 0;
+    *ysp = clixon_str2ptr(ysm->ysm_index, argument, ysm->ysm_nindex);
+    return 1;
+}
+#endif /* YANG_DATANODE_INDEX */
+
 /*! Find first child yang_stmt with matching keyword and argument
  *
  * Find child given keyword and argument.
@@ -1556,6 +2086,15 @@ yang_find(yang_stmt  *yn,
         uses_orig_ptr(keyword)){
         return yang_find(yorig, keyword, argument);
     }
+#ifdef YANG_DATANODE_INDEX
+    /* All data node children are in the index, included submodules are not searched here */
+    if (argument != NULL &&
+        yn->ys_keyword != Y_MODULE && yn->ys_keyword != Y_SUBMODULE &&
+        (keyword == Y_CONTAINER || keyword == Y_LEAF || keyword == Y_LIST ||
+         keyword == Y_LEAF_LIST || keyword == Y_ANYDATA || keyword == Y_ANYXML) &&
+        yang_datanode_index_find(yn, argument, &ys) == 1)
+        return (ys != NULL && ys->ys_parent == yn && ys->ys_keyword == keyword) ? ys : NULL;
+#endif
     for (i=0; i<yn->ys_len; i++){
         ys = yn->ys_stmt[i];
         if (keyword == 0 || ys->ys_keyword == keyword){
@@ -1606,6 +2145,11 @@ yang_find_datanode(yang_stmt *yn,
     int        inext;
     int        inext2;
 
+#ifdef YANG_DATANODE_INDEX
+    if (argument != NULL &&
+        yang_datanode_index_find(yn, argument, &ysmatch) == 1)
+        goto done;
+#endif
     inext = 0;
     while ((ys = yn_iter(yn, &inext)) != NULL){
         if (yang_keyword_get(ys) == Y_CHOICE){ /* Look for its children */
@@ -3237,6 +3781,13 @@ ys_populate_identity(clixon_handle h,
             clixon_err(OE_UNIX, errno, "cv_new");
             goto done;
         }
+#ifdef YANG_IDENTITY_BITSET
+        /* Sorted derived list is made again on first use */
+        if (ybaseid->ys_identity && ybaseid->ys_identity->yi_derived){
+            free(ybaseid->ys_identity->yi_derived);
+            ybaseid->ys_identity->yi_derived = NULL;
+        }
+#endif
         /* Transitive to the root */
         if (ys_populate_identity(h, ybaseid, idref) < 0)
             goto done;
@@ -3626,47 +4177,507 @@ ys_populate2(yang_stmt    *ys,
     return retval;
 }
 
-/*! Find feature and if-feature nodes, check features and remove disabled nodes
+#ifdef YANG_SCHEMA_SUMMARY
+/*! Check if a YANG child may be mandatory in check_mandatory
  *
- * @param[in] h   Clixon handle
- * @param[in] yt  Yang statement
- * @retval    1   OK
- * @retval    0   Feature not enabled: remove yt
- * @retval   -1   Error
- * @note On return 0 the over-lying function need to remove yt from its parent
- * @note cannot use yang_apply here since child-list is modified (destructive) 
- * @note if-features is parsed in full context here, previous restricted pass in ys_parse_sub
+ * Choices are checked if there is a mandatory node in a case, other nodes if they are
+ * mandatory. Config false nodes are skipped by check_mandatory itself
  */
-int
-yang_features(clixon_handle h,
-              yang_stmt    *yt)
+static int
+yang_summary_candidate(yang_stmt *yc)
 {
-    int        retval = -1;
-    int        i;
-    int        j;
-    yang_stmt *ys = NULL;
-    yang_stmt *ymod;
-    const char *mainfile = NULL;
-    int        enabled;
+    struct yang_summary *ysm = yc->ys_summary;
 
-    i = 0;
-    while (i<yt->ys_len){
-        ys = yt->ys_stmt[i];
-        if (ys->ys_keyword == Y_IF_FEATURE){
-            /* Parse the if-feature-expr string using yang sub-parser */
-            if ((ymod = ys_module(ys)) != NULL)
-                mainfile = yang_filename_get(ymod);
-            enabled = 0;
-            if (yang_subparse(h, yang_argument_get(ys), ys, YA_IF_FEATURE, mainfile, 1, &enabled) < 0)
-                goto done;
-            clixon_debug(CLIXON_DBG_YANG | CLIXON_DBG_DETAIL, "%s %d", yang_argument_get(ys), enabled);
-            if (enabled == 0)
-                goto disabled;
-        }
-        else if (ys->ys_keyword == Y_FEATURE){
-            if (ys_populate_feature(h, ys) < 0)
-                goto done;
-        }
+    if (yc->ys_keyword == Y_CHOICE)
+        return ysm->ysm_deep;
+    switch (yc->ys_keyword){
+    case Y_CONTAINER:
+    case Y_LEAF:
+    case Y_ANYDATA:
+    case Y_ANYXML:
+        return ysm->ysm_mandatory;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*! Check if an XPath statement cannot be evaluated in a thread
+ *
+ * @param[in]  ys   Must, when or path statement
+ * @retval     1    Serial only, or not known
+ * @retval     0    May be evaluated in a thread
+ */
+static int
+yang_summary_xpath_serial(yang_stmt *ys)
+{
+#ifdef XPATH_PARSE_CACHE
+    xpath_tree *xpt;
+
+    if ((xpt = yang_xpath_get(ys)) == NULL)
+        return 1;
+    return !xpath_parallel_tree(xpt);
+#else
+    return 1;
+#endif
+}
+
+/*! Check if leafref paths of a resolved type cannot be evaluated in a thread
+ *
+ * @param[in]  ys       Leaf or leaf-list
+ * @param[in]  yrestype Resolved type, may be a union
+ * @retval     1        Serial only
+ * @retval     0        May be validated in a thread
+ * @retval    -1        Error
+ */
+static int
+yang_summary_type_serial(yang_stmt *ys,
+                         yang_stmt *yrestype)
+{
+    yang_stmt *ypath;
+    yang_stmt *ytsub;
+    yang_stmt *ytype;
+    char      *restype;
+    int        inext;
+    int        ret;
+
+    if (yrestype == NULL || (restype = yang_argument_get(yrestype)) == NULL)
+        return 0;
+    if (strcmp(restype, "leafref") == 0){
+        if ((ypath = yang_find(yrestype, Y_PATH, NULL)) == NULL)
+            return 0;
+        return yang_summary_xpath_serial(ypath);
+    }
+    if (strcmp(restype, "union") != 0)
+        return 0;
+    inext = 0;
+    while ((ytsub = yn_iter(yrestype, &inext)) != NULL){
+        if (ytsub->ys_keyword != Y_TYPE)
+            continue;
+        if (yang_type_resolve(ys, ys, ytsub, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+            return -1;
+        if ((ret = yang_summary_type_serial(ys, ytype)) != 0)
+            return ret;
+    }
+    return 0;
+}
+
+#ifdef YANG_DATANODE_INDEX
+/*! Append data node to index vector
+ */
+static int
+yang_datanode_index_push(yang_stmt    *ys,
+                         map_str2ptr **vec,
+                         size_t       *len)
+{
+    map_str2ptr *v;
+
+    if ((v = realloc(*vec, (*len+1)*sizeof(*v))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    v[*len].mp_str = ys->ys_argument;
+    v[*len].mp_ptr = ys;
+    (*len)++;
+    *vec = v;
+    return 0;
+}
+
+/*! Add data nodes found by yang_find_datanode to a vector, in search order
+ *
+ * Same search as yang_find_datanode: through choice, case, input and output, and
+ * included submodules of a (sub)module
+ * @param[in]     yn    YANG node
+ * @param[in,out] vec   Vector of data nodes, realloced
+ * @param[in,out] len   Length of vector
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+yang_datanode_index_add(yang_stmt    *yn,
+                        map_str2ptr **vec,
+                        size_t       *len)
+{
+    yang_stmt *ys;
+    yang_stmt *yc;
+    yang_stmt *ym;
+    int        inext;
+    int        inext2;
+
+    inext = 0;
+    while ((ys = yn_iter(yn, &inext)) != NULL){
+        if (ys->ys_keyword == Y_CHOICE){
+            inext2 = 0;
+            while ((yc = yn_iter(ys, &inext2)) != NULL){
+                if (yc->ys_keyword == Y_CASE){
+                    if (yang_datanode_index_add(yc, vec, len) < 0)
+                        return -1;
+                }
+                else if (yang_datanode(yc) && yc->ys_argument &&
+                         yang_datanode_index_push(yc, vec, len) < 0)
+                    return -1;
+            }
+        }
+        else if (ys->ys_keyword == Y_INPUT || ys->ys_keyword == Y_OUTPUT){
+            if (yang_datanode_index_add(ys, vec, len) < 0)
+                return -1;
+        }
+        else if (yang_datanode(ys) && ys->ys_argument &&
+                 yang_datanode_index_push(ys, vec, len) < 0)
+            return -1;
+    }
+    if (yn->ys_keyword == Y_MODULE || yn->ys_keyword == Y_SUBMODULE){
+        inext = 0;
+        while ((ys = yn_iter(yn, &inext)) != NULL){
+            if (ys->ys_keyword == Y_INCLUDE &&
+                (ym = yang_find_module_by_name(ys_spec(yn), ys->ys_argument)) != NULL &&
+                yang_datanode_index_add(ym, vec, len) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/*! Make datanode index of a YANG node with many data nodes
+ *
+ * Not made if two data nodes have the same name, eg from augments of different modules,
+ * since yang_find_datanode returns the first in schema order
+ * @param[in]  ys    YANG node
+ * @param[out] sm    Summary, index set if made
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+yang_datanode_index_make(yang_stmt           *ys,
+                         struct yang_summary *sm)
+{
+    int          retval = -1;
+    map_str2ptr *vec = NULL;
+    size_t       len = 0;
+    size_t       i;
+
+    if (yang_datanode_index_add(ys, &vec, &len) < 0)
+        goto done;
+    if (len < YANG_DATANODE_INDEX)
+        goto ok;
+    clixon_str2ptr_sort(vec, len);
+    for (i = 1; i < len; i++)
+        if (strcmp(vec[i-1].mp_str, vec[i].mp_str) == 0)
+            goto ok;
+    sm->ysm_index = vec;
+    sm->ysm_nindex = len;
+    vec = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+#endif /* YANG_DATANODE_INDEX */
+
+/*! Make schema summary of a YANG node and its descendants, bottom-up
+ *
+ * @param[in]  ys   YANG node
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see yang_xml_mandatory  for the dynamic check that the summary approximates
+ */
+static int
+yang_summary_make(yang_stmt *ys)
+{
+    struct yang_summary  sm = {0,};
+    struct yang_summary *ysm;
+    yang_stmt           *yc;
+    yang_stmt           *ym;
+    yang_stmt           *yrestype = NULL;
+    cg_var              *cv;
+    int                  len = 0;
+    int                  empty;
+    int                  inext;
+    int                  i;
+    int                  ret;
+
+    /* Groupings are expanded where used, types are not resolved inside */
+    if (ys->ys_keyword == Y_GROUPING){
+        yang_summary_free(ys);
+        ys->ys_summary = &_yang_summary_empty;
+        return 0;
+    }
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL){
+        if (yang_summary_make(yc) < 0)
+            return -1;
+        if (yc->ys_summary->ysm_deep)
+            sm.ysm_deep = 1;
+        if (yc->ys_summary->ysm_serial)
+            sm.ysm_serial = 1;
+        if (yang_summary_candidate(yc))
+            len++;
+    }
+    /* Augment or uses when is kept outside the node */
+    if ((ym = yang_when_get(NULL, ys)) != NULL){
+        sm.ysm_when = 1;
+        if (yang_summary_xpath_serial(ym))
+            sm.ysm_serial = 1;
+    }
+    else if (yang_find(ys, Y_WHEN, NULL) != NULL)
+        sm.ysm_when = 1;
+    /* Leafref paths may be in typedefs */
+    if (ys->ys_keyword == Y_LEAF || ys->ys_keyword == Y_LEAF_LIST){
+        if (yang_type_get(ys, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+            return -1;
+        if ((ret = yang_summary_type_serial(ys, yrestype)) < 0)
+            return -1;
+        if (ret == 1)
+            sm.ysm_serial = 1;
+    }
+    switch (ys->ys_keyword){
+    case Y_IDENTITY:
+        /* Sort derived list now, so that lookups only read it, eg in threads */
+        if (yang_identity_derived_find(ys, "") < 0)
+            return -1;
+        break;
+    case Y_MUST:
+    case Y_WHEN:
+        if (yang_summary_xpath_serial(ys))
+            sm.ysm_serial = 1;
+        break;
+    case Y_LEAF:
+    case Y_CHOICE:
+    case Y_ANYDATA:
+    case Y_ANYXML:
+        /* Mandatory cv is set in ys_populate2, if not set assume mandatory */
+        if ((ym = yang_find(ys, Y_MANDATORY, NULL)) != NULL &&
+            ((cv = yang_cv_get(ym)) == NULL || cv_bool_get(cv)))
+            sm.ysm_mandatory = sm.ysm_deep = 1;
+        /* Mandatory case nodes are marked in the YANG choice, see check_mandatory_case */
+        if (ys->ys_keyword == Y_CHOICE && sm.ysm_deep)
+            sm.ysm_serial = 1;
+        break;
+    case Y_CONTAINER:
+        if (yang_find(ys, Y_PRESENCE, NULL) != NULL)
+            break;
+        inext = 0;
+        while ((yc = yn_iter(ys, &inext)) != NULL){
+            if (yc->ys_summary->ysm_mandatory){
+                sm.ysm_mandatory = 1;
+                if (yc->ys_summary->ysm_when)
+                    sm.ysm_when = 1;
+            }
+            if (yc->ys_summary->ysm_minmax)
+                sm.ysm_minmax = 1;
+        }
+        if (yang_config(ys) == 0)
+            sm.ysm_minmax = 0;
+        break;
+    case Y_LIST:
+    case Y_LEAF_LIST:
+        if (yang_config(ys) == 1 &&
+            (ym = yang_find(ys, Y_MIN_ELEMENTS, NULL)) != NULL &&
+            ((cv = yang_cv_get(ym)) == NULL || cv_uint32_get(cv) > 0))
+            sm.ysm_minmax = 1;
+        break;
+    default:
+        break;
+    }
+    /* A dummy node is added to evaluate when of a missing mandatory node */
+    if (sm.ysm_mandatory && sm.ysm_when)
+        sm.ysm_serial = 1;
+    yang_summary_free(ys);
+    empty = len == 0 && !sm.ysm_mandatory && !sm.ysm_deep && !sm.ysm_minmax &&
+        !sm.ysm_when && !sm.ysm_serial;
+#ifdef YANG_DATANODE_INDEX
+    if (yang_datanode_index_make(ys, &sm) < 0)
+        return -1;
+    if (sm.ysm_index != NULL)
+        empty = 0;
+#endif
+    if (empty){
+        ys->ys_summary = &_yang_summary_empty;
+        return 0;
+    }
+    if ((ysm = malloc(sizeof(*ysm) + len*sizeof(yang_stmt *))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+#ifdef YANG_DATANODE_INDEX
+        if (sm.ysm_index)
+            free(sm.ysm_index);
+#endif
+        return -1;
+    }
+    *ysm = sm;
+    i = 0;
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL)
+        if (yang_summary_candidate(yc))
+            ysm->ysm_vec[i++] = yc;
+    ysm->ysm_len = i;
+    ys->ys_summary = ysm;
+    return 0;
+}
+#endif /* YANG_SCHEMA_SUMMARY */
+
+/*! Make schema summaries of all YANG nodes of a spec, for mandatory and min-elements checks
+ *
+ * Made last when loading YANG, after grouping expansion, augments and deviations.
+ * Made again for the whole spec if modules are added later, since augments may change
+ * nodes of existing modules
+ * @param[in]  yspec  Top-level YANG spec
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see yang_mandatory_each
+ */
+int
+yang_summary_set(yang_stmt *yspec)
+{
+#ifdef YANG_SCHEMA_SUMMARY
+    yang_stmt *ymod;
+    int        inext;
+
+    inext = 0;
+    while ((ymod = yn_iter(yspec, &inext)) != NULL)
+        if (yang_summary_make(ymod) < 0)
+            return -1;
+#endif
+    return 0;
+}
+
+/*! Iterate over the children of a YANG node that may be mandatory
+ *
+ * With YANG_SCHEMA_SUMMARY only children that may be mandatory are returned: choices with
+ * a mandatory node in a case, and mandatory leafs, anydata, anyxml and non-presence
+ * containers with mandatory children. Otherwise, or if the node has no summary, all
+ * children are returned.
+ * @param[in]     ys     YANG node
+ * @param[in,out] inext  Iterator, initialize to 0
+ * @retval        yc     Next child
+ * @retval        NULL   No more children
+ * @see yang_xml_mandatory  for the complete check of each child
+ */
+yang_stmt *
+yang_mandatory_each(yang_stmt *ys,
+                    int       *inext)
+{
+#ifdef YANG_SCHEMA_SUMMARY
+    struct yang_summary *ysm;
+
+    if ((ysm = ys->ys_summary) != NULL){
+        if (*inext < 0 || *inext >= ysm->ysm_len)
+            return NULL;
+        return ysm->ysm_vec[(*inext)++];
+    }
+#endif
+    return yn_iter(ys, inext);
+}
+
+/*! Check from schema summary if a YANG node may be mandatory
+ *
+ * @param[in]  ys   YANG node
+ * @retval     1    May be mandatory, or no summary
+ * @retval     0    Not mandatory
+ */
+int
+yang_mandatory_maybe(yang_stmt *ys)
+{
+#ifdef YANG_SCHEMA_SUMMARY
+    if (ys->ys_summary != NULL)
+        return ys->ys_summary->ysm_mandatory;
+#endif
+    return 1;
+}
+
+/*! Check from schema summary if an empty instance may violate min-elements below a node
+ *
+ * @param[in]  ys   YANG node, eg non-presence container
+ * @retval     1    May violate min-elements, or no summary
+ * @retval     0    No list or leaf-list with min-elements below node
+ */
+int
+yang_minmax_maybe(yang_stmt *ys)
+{
+#ifdef YANG_SCHEMA_SUMMARY
+    if (ys->ys_summary != NULL)
+        return ys->ys_summary->ysm_minmax;
+#endif
+    return 1;
+}
+
+/*! Check from schema summary if a when condition may make a YANG node not mandatory
+ *
+ * @param[in]  ys   YANG node
+ * @retval     1    Node or a mandatory node below has a when condition, or no summary
+ * @retval     0    No when conditions, mandatory as given by yang_mandatory_maybe
+ */
+int
+yang_when_maybe(yang_stmt *ys)
+{
+#ifdef YANG_SCHEMA_SUMMARY
+    if (ys->ys_summary != NULL)
+        return ys->ys_summary->ysm_when;
+#endif
+    return 1;
+}
+
+/*! Check from schema summary if instances of a YANG node may be validated in a thread
+ *
+ * Not if validation of the node or its descendants evaluates XPaths with side-effects,
+ * adds nodes to evaluate when conditions, or marks YANG nodes, eg of choices
+ * @param[in]  ys   YANG node
+ * @retval     1    Yes, validation only reads the tree
+ * @retval     0    No, or no summary
+ * @see xpath_parallel_tree
+ */
+int
+yang_validate_parallel(yang_stmt *ys)
+{
+#ifdef YANG_SCHEMA_SUMMARY
+    if (ys->ys_summary != NULL)
+        return !ys->ys_summary->ysm_serial;
+#endif
+    return 0;
+}
+
+/*! Find feature and if-feature nodes, check features and remove disabled nodes
+ *
+ * @param[in] h   Clixon handle
+ * @param[in] yt  Yang statement
+ * @retval    1   OK
+ * @retval    0   Feature not enabled: remove yt
+ * @retval   -1   Error
+ * @note On return 0 the over-lying function need to remove yt from its parent
+ * @note cannot use yang_apply here since child-list is modified (destructive) 
+ * @note if-features is parsed in full context here, previous restricted pass in ys_parse_sub
+ */
+int
+yang_features(clixon_handle h,
+              yang_stmt    *yt)
+{
+    int        retval = -1;
+    int        i;
+    int        j;
+    yang_stmt *ys = NULL;
+    yang_stmt *ymod;
+    const char *mainfile = NULL;
+    int        enabled;
+
+    i = 0;
+    while (i<yt->ys_len){
+        ys = yt->ys_stmt[i];
+        if (ys->ys_keyword == Y_IF_FEATURE){
+            /* Parse the if-feature-expr string using yang sub-parser */
+            if ((ymod = ys_module(ys)) != NULL)
+                mainfile = yang_filename_get(ymod);
+            enabled = 0;
+            if (yang_subparse(h, yang_argument_get(ys), ys, YA_IF_FEATURE, mainfile, 1, &enabled) < 0)
+                goto done;
+            clixon_debug(CLIXON_DBG_YANG | CLIXON_DBG_DETAIL, "%s %d", yang_argument_get(ys), enabled);
+            if (enabled == 0)
+                goto disabled;
+        }
+        else if (ys->ys_keyword == Y_FEATURE){
+            if (ys_populate_feature(h, ys) < 0)
+                goto done;
+        }
         else
             switch (yang_features(h, ys)){
                 case -1: /* error */
@@ -4292,6 +5303,222 @@ yang_type_cache_get2(yang_stmt  *ytype,
     return retval;
 }
 
+#ifdef YANG_TYPE_VALIDATOR
+/*! Get compiled validator from yang type cache
+ *
+ * @param[in]  ytype  Yang type statement
+ * @retval     tv     Validator, see ys_cv_validate
+ * @retval     NULL   No cache or no validator
+ */
+void *
+yang_type_cache_valid_get(yang_stmt *ytype)
+{
+    yang_type_cache *ycache;
+
+    if ((ycache = yang_typecache_get(ytype)) == NULL)
+        return NULL;
+    return ycache->yc_valid;
+}
+
+/*! Set compiled validator of yang type cache, freed with the cache
+ *
+ * @param[in]  ytype  Yang type statement
+ * @param[in]  tv     Validator
+ * @retval     0      OK
+ * @retval    -1      Error, no type cache
+ */
+int
+yang_type_cache_valid_set(yang_stmt *ytype,
+                          void      *tv)
+{
+    yang_type_cache *ycache;
+
+    if ((ycache = yang_typecache_get(ytype)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang type cache");
+        return -1;
+    }
+    if (ycache->yc_valid)
+        yang_type_valid_free(ycache->yc_valid);
+    ycache->yc_valid = tv;
+    return 0;
+}
+#endif /* YANG_TYPE_VALIDATOR */
+
+#ifdef YANG_ENUM_TABLE
+/*! Lookup table of the enums of an enumeration type
+ */
+struct yang_enum_table{
+    int         et_len;    /* Number of enums */
+    yang_stmt **et_name;   /* Enums sorted by name */
+    yang_stmt **et_value;  /* Enums sorted by value */
+};
+
+static int
+yang_enum_name_cmp(const void *a,
+                   const void *b)
+{
+    return strcmp(yang_argument_get(*(yang_stmt **)a), yang_argument_get(*(yang_stmt **)b));
+}
+
+static int
+yang_enum_value_cmp(const void *a,
+                    const void *b)
+{
+    int32_t v1 = cv_int32_get(yang_cv_get(*(yang_stmt **)a));
+    int32_t v2 = cv_int32_get(yang_cv_get(*(yang_stmt **)b));
+
+    return v1 < v2 ? -1 : v1 > v2 ? 1 : 0;
+}
+
+static void
+yang_enum_table_free(struct yang_enum_table *et)
+{
+    if (et->et_name)
+        free(et->et_name);
+    if (et->et_value)
+        free(et->et_value);
+    free(et);
+}
+
+/*! Make enum lookup table of an enumeration type in its type cache
+ *
+ * Enum values are assigned in ys_populate_type_enum
+ * @param[in]  ytype  Yang type statement "enumeration" with a type cache
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see ys_resolve_type  where it is called
+ */
+int
+yang_type_cache_enum_set(yang_stmt *ytype)
+{
+    int                     retval = -1;
+    yang_type_cache        *ycache;
+    struct yang_enum_table *et = NULL;
+    yang_stmt              *yenum;
+    int                     inext;
+
+    if ((ycache = yang_typecache_get(ytype)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang type cache");
+        goto done;
+    }
+    if ((et = calloc(1, sizeof(*et))) == NULL ||
+        (et->et_name = calloc(ytype->ys_len+1, sizeof(yang_stmt *))) == NULL ||
+        (et->et_value = calloc(ytype->ys_len+1, sizeof(yang_stmt *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    inext = 0;
+    while ((yenum = yn_iter(ytype, &inext)) != NULL) {
+        if (yenum->ys_keyword != Y_ENUM || yang_cv_get(yenum) == NULL)
+            continue;
+        et->et_name[et->et_len] = yenum;
+        et->et_value[et->et_len++] = yenum;
+    }
+    qsort(et->et_name, et->et_len, sizeof(yang_stmt *), yang_enum_name_cmp);
+    qsort(et->et_value, et->et_len, sizeof(yang_stmt *), yang_enum_value_cmp);
+    if (ycache->yc_enums)
+        yang_enum_table_free(ycache->yc_enums);
+    ycache->yc_enums = et;
+    et = NULL;
+    retval = 0;
+ done:
+    if (et)
+        yang_enum_table_free(et);
+    return retval;
+}
+#endif /* YANG_ENUM_TABLE */
+
+/*! Find enum of an enumeration type by name
+ *
+ * With YANG_ENUM_TABLE uses the lookup table of the type cache if present
+ * @param[in]  ytype  Resolved yang type statement "enumeration"
+ * @param[in]  name   Enum name
+ * @retval     yenum  Enum statement
+ * @retval     NULL   Not found
+ */
+yang_stmt *
+yang_enum_find(yang_stmt  *ytype,
+               const char *name)
+{
+#ifdef YANG_ENUM_TABLE
+    yang_type_cache        *ycache;
+    struct yang_enum_table *et;
+    int                     lo;
+    int                     hi;
+    int                     mid;
+    int                     cmp;
+
+    if (name != NULL &&
+        (ycache = yang_typecache_get(ytype)) != NULL &&
+        (et = ycache->yc_enums) != NULL){
+        lo = 0;
+        hi = et->et_len - 1;
+        while (lo <= hi){
+            mid = (lo + hi)/2;
+            if ((cmp = strcmp(name, yang_argument_get(et->et_name[mid]))) == 0)
+                return et->et_name[mid];
+            if (cmp < 0)
+                hi = mid - 1;
+            else
+                lo = mid + 1;
+        }
+        return NULL;
+    }
+#endif
+    if (name == NULL)
+        return NULL;
+    return yang_find(ytype, Y_ENUM, name);
+}
+
+/*! Find enum of an enumeration type by value
+ *
+ * With YANG_ENUM_TABLE uses the lookup table of the type cache if present
+ * @param[in]  ytype  Resolved yang type statement "enumeration"
+ * @param[in]  value  Enum value, explicit or implicitly assigned
+ * @retval     yenum  Enum statement
+ * @retval     NULL   Not found
+ */
+yang_stmt *
+yang_enum_find_value(yang_stmt *ytype,
+                     int32_t    value)
+{
+    yang_stmt              *yenum;
+    cg_var                 *cv;
+    int                     inext;
+#ifdef YANG_ENUM_TABLE
+    yang_type_cache        *ycache;
+    struct yang_enum_table *et;
+    int                     lo;
+    int                     hi;
+    int                     mid;
+    int32_t                 v;
+
+    if ((ycache = yang_typecache_get(ytype)) != NULL &&
+        (et = ycache->yc_enums) != NULL){
+        lo = 0;
+        hi = et->et_len - 1;
+        while (lo <= hi){
+            mid = (lo + hi)/2;
+            if ((v = cv_int32_get(yang_cv_get(et->et_value[mid]))) == value)
+                return et->et_value[mid];
+            if (value < v)
+                hi = mid - 1;
+            else
+                lo = mid + 1;
+        }
+        return NULL;
+    }
+#endif
+    inext = 0;
+    while ((yenum = yn_iter(ytype, &inext)) != NULL) {
+        if (yenum->ys_keyword == Y_ENUM &&
+            (cv = yang_cv_get(yenum)) != NULL &&
+            cv_int32_get(cv) == value)
+            return yenum;
+    }
+    return NULL;
+}
+
 /*! Free yang type cache
  */
 static int
@@ -4300,6 +5527,14 @@ yang_type_cache_free(yang_type_cache *ycache)
     cg_var *cv;
     void   *p;
 
+#ifdef YANG_TYPE_VALIDATOR
+    if (ycache->yc_valid)
+        yang_type_valid_free(ycache->yc_valid);
+#endif
+#ifdef YANG_ENUM_TABLE
+    if (ycache->yc_enums)
+        yang_enum_table_free(ycache->yc_enums);
+#endif
     if (ycache->yc_cvv)
         cvec_free(ycache->yc_cvv);
     if (ycache->yc_patterns)
@@ -4509,6 +5744,7 @@ yang_list_index_add(yang_stmt *ys)
         goto ok;
     }
     yang_flag_set(ys, YANG_FLAG_INDEX);
+    yang_flag_set(yp, YANG_FLAG_HAS_INDEX);
  ok:
     retval = 0;
    // done:
@@ -4549,6 +5785,67 @@ yang_search_index_extension(clixon_handle h,
     return retval;
 }
 
+/*! Mark list elements as search index as given by CLICON_YANG_SEARCH_INDEX options
+ *
+ * Alternative to the search_index extension without modifying the YANG.
+ * Each option is an absolute schema node id of a list element, eg /ex:table/ex:p/ex:value
+ * Nodes of modules not (yet) loaded are skipped, since this is called once per yang_parse_post
+ * @param[in] h      Clixon handle
+ * @param[in] yspec  Yang spec
+ * @retval    0      OK (warnings may appear)
+ * @retval   -1      Error
+ */
+int
+yang_search_index_option(clixon_handle h,
+                         yang_stmt    *yspec)
+{
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xc = NULL;
+    char      *str;
+    char      *prefix = NULL;
+    char      *id = NULL;
+    yang_stmt *ys;
+
+    if ((x = clicon_conf_xml(h)) == NULL)
+        goto ok;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(xc), "CLICON_YANG_SEARCH_INDEX") != 0)
+            continue;
+        if ((str = xml_body(xc)) == NULL || *str != '/')
+            continue;
+        /* Skip if first module is not loaded */
+        if (nodeid_split(str+1, &prefix, &id) < 0)
+            goto done;
+        if (prefix && yang_find_module_by_prefix_yspec(yspec, prefix) != NULL){
+            if (yang_abs_schema_nodeid(yspec, str, &ys) < 0)
+                goto done;
+            if (ys == NULL)
+                clixon_log(h, LOG_WARNING, "CLICON_YANG_SEARCH_INDEX %s not found", str);
+            else if (yang_keyword_get(ys) != Y_LEAF)
+                clixon_log(h, LOG_WARNING, "CLICON_YANG_SEARCH_INDEX %s should be a leaf", str);
+            else if (yang_list_index_add(ys) < 0)
+                goto done;
+        }
+        if (prefix){
+            free(prefix);
+            prefix = NULL;
+        }
+        if (id){
+            free(id);
+            id = NULL;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    if (prefix)
+        free(prefix);
+    if (id)
+        free(id);
+    return retval;
+}
+
 #endif /* XML_EXPLICIT_INDEX */
 
 /*! Check if yang node has a single child of specific type
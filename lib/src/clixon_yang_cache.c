@@ -0,0 +1,686 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ * YANG parse cache
+ * A cache file is a binary image of the parse tree of a YANG file, written to
+ * CLICON_YANG_CACHE_DIR after the file is parsed. When the YANG file is parsed again, eg
+ * at the next daemon start, the cache file is mapped and the tree is rebuilt without
+ * YANG tokenizing and parsing.
+ * The cache file records path, size and mtime of the YANG file, and is ignored if they
+ * do not match. The tree is cached before YANG patch, features, grouping and augment
+ * expansion, which are made after reading as after parsing.
+ * With YANG_CACHE_SHARED, a cache file is kept mapped and argument strings of statements
+ * read from it point into the mapping instead of being copied. The pages are then shared by
+ * all processes reading the same cache file, eg backend and CLI and NETCONF clients.
+ * File layout, native byte order, no padding:
+ *   header: struct yang_cache_hdr
+ *   path:   char path[hdr.yh_pathlen]; '\0'
+ *   statements in pre-order:
+ *     uint32 keyword; uint32 linenum; uint32 nchildren;
+ *     uint32 len; char argument[len]; '\0'   (len YANG_CACHE_NOSTR and no string if none)
+ *     uint32 len; char extra[len]; '\0'      (unknown statement argument, as above)
+ *     followed by children
+ */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_options.h"
+#include "clixon_yang_parse_lib.h"
+#include "clixon_yang_cache.h"
+
+/*
+ * Constants
+ */
+#define YANG_CACHE_MAGIC   0x43594c43 /* "CLYC" little-endian */
+#define YANG_CACHE_VERSION 1
+#define YANG_CACHE_NOSTR   UINT32_MAX
+
+/* Local types */
+/*! YANG cache file header
+ */
+struct yang_cache_hdr {
+    uint32_t yh_magic;     /* YANG_CACHE_MAGIC */
+    uint32_t yh_version;   /* YANG_CACHE_VERSION */
+    uint64_t yh_size;      /* Size of YANG file */
+    int64_t  yh_mtime;     /* Mtime of YANG file, seconds */
+    int64_t  yh_mtime_ns;  /* Mtime of YANG file, nanoseconds */
+    uint32_t yh_pathlen;   /* Length of path of YANG file following header */
+    uint32_t yh_pad;
+};
+
+/*! State when reading a cache file
+ */
+struct yang_cache_rd {
+    const char *yr_p;      /* Current position in mapped file */
+    const char *yr_end;    /* End of mapped file */
+    const char *yr_name;   /* YANG filename, for sub-parsing */
+    int         yr_shared; /* Arguments point into mapped file, are not copied */
+};
+
+#ifdef YANG_CACHE_SHARED
+/*! Cache file mapped for the lifetime of the process
+ */
+struct yang_cache_map {
+    char      *ym_addr;    /* Start of mapping */
+    size_t     ym_len;     /* Length of mapping */
+    dev_t      ym_dev;     /* Device of cache file */
+    ino_t      ym_ino;     /* Inode of cache file, a rewritten cache file has a new inode */
+};
+
+/*
+ * Variables
+ */
+/* Mapped cache files sorted on address, see yang_cache_mapped */
+static struct yang_cache_map *_yang_cache_maps = NULL;
+static int                    _yang_cache_nmaps = 0;
+#endif /* YANG_CACHE_SHARED */
+
+/*! FNV-1a hash of a string
+ */
+static uint64_t
+yang_cache_fnv(const char *str)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (; *str != '\0'; str++){
+        hash ^= (uint8_t)*str;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*! Translate from YANG filename to cache filename
+ *
+ * The cache filename is the basename of the YANG file and a hash of its path
+ * @param[in]   h         Clixon handle
+ * @param[in]   filename  YANG filename
+ * @param[out]  cachefile Cache filename, or NULL if no cache. Unallocate after use with free()
+ * @retval      0         OK
+ * @retval     -1         Error
+ */
+static int
+yang_cache_file(clixon_handle h,
+                const char   *filename,
+                char        **cachefile)
+{
+    int         retval = -1;
+    cbuf       *cb = NULL;
+    char       *dir;
+    const char *base;
+
+    *cachefile = NULL;
+    if ((dir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR")) == NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_YANG, errno, "cbuf_new");
+        goto done;
+    }
+    if ((base = strrchr(filename, '/')) != NULL)
+        base++;
+    else
+        base = filename;
+    cprintf(cb, "%s/%s.%016llx.bin", dir, base, (unsigned long long)yang_cache_fnv(filename));
+    if ((*cachefile = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Write string with length, or YANG_CACHE_NOSTR if NULL
+ */
+static int
+yang_cache_write_str(FILE       *f,
+                     const char *str)
+{
+    uint32_t len;
+
+    len = str ? strlen(str) : YANG_CACHE_NOSTR;
+    if (fwrite(&len, sizeof(len), 1, f) != 1)
+        return -1;
+    if (str && fwrite(str, 1, len+1, f) != len+1)
+        return -1;
+    return 0;
+}
+
+/*! Write YANG statement and its children in pre-order
+ *
+ * @param[in]  f    Open cache file
+ * @param[in]  ys   YANG statement
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+yang_cache_write_node(FILE      *f,
+                      yang_stmt *ys)
+{
+    int        retval = -1;
+    uint32_t   u32[3];
+    char      *extra = NULL;
+    cg_var    *cv;
+    yang_stmt *yc;
+    int        inext;
+
+    u32[0] = yang_keyword_get(ys);
+    u32[1] = yang_linenum_get(ys);
+    u32[2] = yang_len_get(ys);
+    if (yang_keyword_get(ys) == Y_UNKNOWN &&
+        (cv = yang_cv_get(ys)) != NULL &&
+        (extra = cv2str_dup(cv)) == NULL){
+        clixon_err(OE_UNIX, errno, "cv2str_dup");
+        goto done;
+    }
+    if (fwrite(u32, sizeof(u32), 1, f) != 1 ||
+        yang_cache_write_str(f, yang_argument_get(ys)) < 0 ||
+        yang_cache_write_str(f, extra) < 0){
+        clixon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL)
+        if (yang_cache_write_node(f, yc) < 0)
+            goto done;
+    retval = 0;
+ done:
+    if (extra)
+        free(extra);
+    return retval;
+}
+
+/*! Write cache file of a parsed YANG file
+ *
+ * Write to a temporary file and rename so that a partial cache file is never read.
+ * @param[in]  h         Clixon handle
+ * @param[in]  filename  YANG filename
+ * @param[in]  ymod      YANG (sub)module parsed from the file, before YANG patch
+ * @retval     0         OK, or no cache dir
+ * @retval    -1         Error
+ */
+int
+yang_cache_write(clixon_handle h,
+                 const char   *filename,
+                 yang_stmt    *ymod)
+{
+    int                   retval = -1;
+    char                 *cachefile = NULL;
+    cbuf                 *cbtmp = NULL;
+    FILE                 *f = NULL;
+    struct stat           st = {0,};
+    struct yang_cache_hdr hdr = {0,};
+
+    if (yang_cache_file(h, filename, &cachefile) < 0)
+        goto done;
+    if (cachefile == NULL)
+        goto ok;
+    if (stat(filename, &st) < 0){
+        clixon_err(OE_UNIX, errno, "stat(%s)", filename);
+        goto done;
+    }
+    if ((cbtmp = cbuf_new()) == NULL){
+        clixon_err(OE_YANG, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbtmp, "%s.%u.tmp", cachefile, (unsigned)getpid());
+    if ((f = fopen(cbuf_get(cbtmp), "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    hdr.yh_magic = YANG_CACHE_MAGIC;
+    hdr.yh_version = YANG_CACHE_VERSION;
+    hdr.yh_size = st.st_size;
+    hdr.yh_mtime = st.st_mtim.tv_sec;
+    hdr.yh_mtime_ns = st.st_mtim.tv_nsec;
+    hdr.yh_pathlen = strlen(filename);
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1 ||
+        fwrite(filename, 1, hdr.yh_pathlen+1, f) != hdr.yh_pathlen+1){
+        clixon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    if (yang_cache_write_node(f, ymod) < 0)
+        goto done;
+    if (fclose(f) != 0){
+        f = NULL;
+        clixon_err(OE_UNIX, errno, "fclose(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    f = NULL;
+    if (rename(cbuf_get(cbtmp), cachefile) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", cachefile);
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_YANG, "Wrote YANG cache %s", cachefile);
+ ok:
+    retval = 0;
+ done:
+    if (f){
+        fclose(f);
+        unlink(cbuf_get(cbtmp));
+    }
+    if (cbtmp)
+        cbuf_free(cbtmp);
+    if (cachefile)
+        free(cachefile);
+    return retval;
+}
+
+/*! Read uint32 from mapped file
+ *
+ * @retval  0   OK
+ * @retval -1   Truncated file
+ */
+static int
+yang_cache_u32(struct yang_cache_rd *yr,
+               uint32_t             *u32)
+{
+    if (yr->yr_end - yr->yr_p < (ptrdiff_t)sizeof(*u32))
+        return -1;
+    memcpy(u32, yr->yr_p, sizeof(*u32));
+    yr->yr_p += sizeof(*u32);
+    return 0;
+}
+
+/*! Read string with length from mapped file and copy it
+ *
+ * @param[in]  yr    Read state
+ * @param[in]  copy  If 0, return pointer into mapped file
+ * @param[out] strp  Malloced copy of string, NULL if none
+ * @retval     1     OK
+ * @retval     0     Truncated or malformed file
+ * @retval    -1     Error
+ */
+static int
+yang_cache_str(struct yang_cache_rd *yr,
+               int                   copy,
+               char                **strp)
+{
+    uint32_t len;
+
+    *strp = NULL;
+    if (yang_cache_u32(yr, &len) < 0)
+        return 0;
+    if (len == YANG_CACHE_NOSTR)
+        return 1;
+    if (yr->yr_end - yr->yr_p <= (ptrdiff_t)len || yr->yr_p[len] != '\0')
+        return 0;
+    if (!copy){
+        *strp = (char *)yr->yr_p;
+        yr->yr_p += len + 1;
+        return 1;
+    }
+    if ((*strp = malloc(len+1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    memcpy(*strp, yr->yr_p, len+1);
+    yr->yr_p += len + 1;
+    return 1;
+}
+
+/*! Rebuild YANG statement and its children from mapped file
+ *
+ * Statement-specific values are created as when parsing, but syntax-only checks are skipped
+ * @see ys_parse_sub
+ * @param[in]  yr     Read state
+ * @param[in]  yp     Parent
+ * @param[out] yret   Created statement
+ * @retval     1      OK
+ * @retval     0      Malformed cache file
+ * @retval    -1      Error
+ */
+static int
+yang_cache_read_node(struct yang_cache_rd *yr,
+                     yang_stmt            *yp,
+                     yang_stmt           **yret)
+{
+    uint32_t   u32[3];
+    char      *arg = NULL;
+    char      *extra = NULL;
+    yang_stmt *ys;
+    uint32_t   i;
+    int        ret;
+
+    if (yang_cache_u32(yr, &u32[0]) < 0 ||
+        yang_cache_u32(yr, &u32[1]) < 0 ||
+        yang_cache_u32(yr, &u32[2]) < 0)
+        return 0;
+    if (u32[0] < Y_ACTION || u32[0] > Y_YIN_ELEMENT)
+        return 0;
+    if ((ret = yang_cache_str(yr, !yr->yr_shared, &arg)) <= 0)
+        return ret;
+    if ((ret = yang_cache_str(yr, 1, &extra)) <= 0){
+        if (!yr->yr_shared)
+            free(arg);
+        return ret;
+    }
+    if ((ys = ys_new(u32[0])) == NULL){
+        if (!yr->yr_shared)
+            free(arg);
+        free(extra);
+        return -1;
+    }
+    /* argument is consumed, or is in a kept mapping if shared */
+    yang_argument_set(ys, arg);
+    if (yn_insert(yp, ys) < 0){
+        ys_free(ys);
+        free(extra);
+        return -1;
+    }
+    if (yret)
+        *yret = ys;
+    yang_linenum_set(ys, u32[1]);
+    switch (u32[0]){
+    case Y_BASE:      /* Syntax checked when the cache was written */
+    case Y_TYPE:
+    case Y_USES:
+    case Y_AUGMENT:
+    case Y_REFINE:
+    case Y_IF_FEATURE:
+    case Y_STATUS:
+    case Y_MODIFIER:
+        if (extra)
+            free(extra);
+        break;
+    default:
+        /* extra is consumed */
+        if (ys_parse_sub(ys, yr->yr_name, extra) < 0)
+            return -1;
+        break;
+    }
+    for (i = 0; i < u32[2]; i++)
+        if ((ret = yang_cache_read_node(yr, ys, NULL)) <= 0)
+            return ret;
+    return 1;
+}
+
+/*! Check if cache header was written for the YANG file
+ *
+ * @param[in]  hdr   Cache header
+ * @param[in]  st    Status of YANG file
+ * @retval     1     Valid
+ * @retval     0     Stale or not a cache file
+ */
+static int
+yang_cache_hdr_valid(struct yang_cache_hdr *hdr,
+                     struct stat           *st)
+{
+    return hdr->yh_magic == YANG_CACHE_MAGIC &&
+        hdr->yh_version == YANG_CACHE_VERSION &&
+        hdr->yh_size == (uint64_t)st->st_size &&
+        hdr->yh_mtime == st->st_mtim.tv_sec &&
+        hdr->yh_mtime_ns == st->st_mtim.tv_nsec;
+}
+
+#ifdef YANG_CACHE_SHARED
+/*! Check if a string is in a kept mapped cache file and therefore not malloced
+ *
+ * @param[in]  str  String, eg YANG argument
+ * @retval     1    In mapped cache file, do not free or modify
+ * @retval     0    Not in mapped cache file
+ */
+int
+yang_cache_mapped(const char *str)
+{
+    int lo = 0;
+    int hi = _yang_cache_nmaps;
+    int mid;
+
+    while (lo < hi){ /* Binary search on address */
+        mid = (lo + hi) / 2;
+        if (str < _yang_cache_maps[mid].ym_addr)
+            hi = mid;
+        else if (str >= _yang_cache_maps[mid].ym_addr + _yang_cache_maps[mid].ym_len)
+            lo = mid + 1;
+        else
+            return 1;
+    }
+    return 0;
+}
+
+/*! Find kept mapping of cache file
+ *
+ * @param[in]  st   Status of open cache file
+ * @retval     ym   Mapping
+ * @retval     NULL Cache file not mapped
+ */
+static struct yang_cache_map *
+yang_cache_map_find(struct stat *st)
+{
+    int i;
+
+    for (i = 0; i < _yang_cache_nmaps; i++)
+        if (_yang_cache_maps[i].ym_dev == st->st_dev &&
+            _yang_cache_maps[i].ym_ino == st->st_ino)
+            return &_yang_cache_maps[i];
+    return NULL;
+}
+
+/*! Keep mapping of cache file, sorted on address
+ *
+ * @param[in]  map  Mapped cache file
+ * @param[in]  st   Status of cache file
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+yang_cache_map_add(char        *map,
+                   struct stat *st)
+{
+    struct yang_cache_map *maps;
+    int                    i;
+
+    if ((maps = realloc(_yang_cache_maps, (_yang_cache_nmaps+1)*sizeof(*maps))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    _yang_cache_maps = maps;
+    for (i = _yang_cache_nmaps; i > 0 && maps[i-1].ym_addr > map; i--)
+        maps[i] = maps[i-1];
+    maps[i].ym_addr = map;
+    maps[i].ym_len = st->st_size;
+    maps[i].ym_dev = st->st_dev;
+    maps[i].ym_ino = st->st_ino;
+    _yang_cache_nmaps++;
+    return 0;
+}
+
+/*! Remove kept mapping of cache file, only if no YANG statement points into it
+ *
+ * @param[in]  map  Mapped cache file
+ */
+static void
+yang_cache_map_rm(char *map)
+{
+    int i;
+
+    for (i = 0; i < _yang_cache_nmaps; i++)
+        if (_yang_cache_maps[i].ym_addr == map)
+            break;
+    if (i == _yang_cache_nmaps)
+        return;
+    _yang_cache_nmaps--;
+    memmove(&_yang_cache_maps[i], &_yang_cache_maps[i+1],
+            (_yang_cache_nmaps-i)*sizeof(*_yang_cache_maps));
+}
+#endif /* YANG_CACHE_SHARED */
+
+/*! Read parse tree of YANG file from cache file if it is valid for the YANG file
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  filename  YANG filename
+ * @param[in]  yspec     Yang specification, module is added to it
+ * @param[out] ymodp     YANG (sub)module
+ * @retval     1         OK, ymodp set
+ * @retval     0         No valid cache file, parse YANG file instead
+ * @retval    -1         Error
+ */
+int
+yang_cache_read(clixon_handle h,
+                const char   *filename,
+                yang_stmt    *yspec,
+                yang_stmt   **ymodp)
+{
+    int                   retval = -1;
+    char                 *cachefile = NULL;
+    int                   fd = -1;
+    struct stat           st = {0,};
+    struct stat           sty = {0,};
+    char                 *map = MAP_FAILED;
+    int                   keep = 0;
+    struct yang_cache_hdr hdr;
+    struct yang_cache_rd  yr = {0,};
+    yang_stmt            *ymod = NULL;
+    const char           *path;
+    int                   ret;
+#ifdef YANG_CACHE_SHARED
+    struct yang_cache_map *ym;
+#endif
+
+    if (yang_cache_file(h, filename, &cachefile) < 0)
+        goto done;
+    if (cachefile == NULL)
+        goto fail;
+    if (stat(filename, &sty) < 0)
+        goto fail;
+    if ((fd = open(cachefile, O_RDONLY)) < 0)
+        goto fail;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(hdr))
+        goto fail;
+#ifdef YANG_CACHE_SHARED
+    if ((ym = yang_cache_map_find(&st)) != NULL){ /* Already mapped, eg by other yspec */
+        yr.yr_p = ym->ym_addr;
+        keep = 1;
+    }
+    else
+#endif
+    {
+        /* Writable private mapping: a write to an argument copies only that page */
+        if ((map = mmap(NULL, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+            clixon_err(OE_UNIX, errno, "mmap(%s)", cachefile);
+            goto done;
+        }
+        yr.yr_p = map;
+    }
+    memcpy(&hdr, yr.yr_p, sizeof(hdr));
+    yr.yr_end = yr.yr_p + st.st_size;
+    yr.yr_p += sizeof(hdr);
+    yr.yr_name = filename;
+    if (!yang_cache_hdr_valid(&hdr, &sty) ||
+        yr.yr_end - yr.yr_p <= (ptrdiff_t)hdr.yh_pathlen){
+        clixon_debug(CLIXON_DBG_YANG, "YANG cache %s stale, ignored", cachefile);
+        goto fail;
+    }
+    path = yr.yr_p;
+    if (path[hdr.yh_pathlen] != '\0' || strcmp(path, filename) != 0){
+        clixon_debug(CLIXON_DBG_YANG, "YANG cache %s of other file, ignored", cachefile);
+        goto fail;
+    }
+    yr.yr_p += hdr.yh_pathlen + 1;
+#ifdef YANG_CACHE_SHARED
+    yr.yr_shared = 1;
+    if (map != MAP_FAILED){
+        if (yang_cache_map_add(map, &st) < 0)
+            goto done;
+        keep = 1;
+    }
+#endif
+    if ((ret = yang_cache_read_node(&yr, yspec, &ymod)) < 0)
+        goto done;
+    if (ret == 0 || yr.yr_p != yr.yr_end)
+        goto malformed;
+    if (yang_keyword_get(ymod) != Y_MODULE && yang_keyword_get(ymod) != Y_SUBMODULE)
+        goto malformed;
+    if (yang_filename_set(ymod, filename) < 0)
+        goto done;
+#ifdef OPTIMIZE_YSPEC_NAMESPACE
+    yspec_nscache_clear(yspec);
+#endif
+    clixon_debug(CLIXON_DBG_YANG, "Read YANG cache %s", cachefile);
+    *ymodp = ymod;
+    ymod = NULL;
+    if (map != MAP_FAILED && keep)
+        map = MAP_FAILED; /* Kept until exit */
+    retval = 1;
+ done:
+    if (ymod){ /* Partial tree */
+        ys_prune_self(ymod);
+        ys_free(ymod);
+    }
+    if (map != MAP_FAILED){
+#ifdef YANG_CACHE_SHARED
+        if (keep)
+            yang_cache_map_rm(map);
+#endif
+        munmap(map, st.st_size);
+    }
+    if (fd != -1)
+        close(fd);
+    if (cachefile)
+        free(cachefile);
+    return retval;
+ malformed:
+    clixon_log(h, LOG_WARNING, "YANG cache %s malformed, ignored", cachefile);
+ fail:
+    retval = 0;
+    goto done;
+}
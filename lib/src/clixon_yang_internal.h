@@ -57,6 +57,12 @@ struct yang_type_cache{
     cvec      *yc_patterns; /* List of regexp, if cvec_len() > 0 */
     cvec      *yc_regexps;  /* List of _compiled_ regexp, if cvec_len() > 0 */
     yang_stmt *yc_resolved; /* Resolved type object, can be NULL - note direct ptr */
+#ifdef YANG_TYPE_VALIDATOR
+    struct yang_type_valid *yc_valid; /* Compiled validator, see ys_cv_validate */
+#endif
+#ifdef YANG_ENUM_TABLE
+    struct yang_enum_table *yc_enums; /* Enum lookup of enumeration type, see yang_enum_find */
+#endif
 };
 typedef struct yang_type_cache yang_type_cache;
 
@@ -109,6 +115,9 @@ struct yang_stmt {
                                         Y_UNKNOWN: app-dep: yang-mount-points
                                      */
     yang_stmt         *ys_orig;      /* Pointer to original (for uses/augment copies) */
+#ifdef YANG_SCHEMA_SUMMARY
+    struct yang_summary *ys_summary; /* Mandatory and min-elements summary, see yang_summary_set */
+#endif
     union {                          /* Depends on ys_keyword */
         rpc_callback_t  *ysu_action_cb; /* Y_ACTION: Action callback list*/
         char            *ysu_filename;  /* Y_MODULE/Y_SUBMODULE: For debug/errors: filename */
@@ -118,6 +127,15 @@ struct yang_stmt {
 #endif
 #ifdef OPTIMIZE_NO_PRESENCE_CONTAINER
         cxobj           *ysu_nopres_cache; /* Y_CONTAINER: no-presence XML cache */
+#endif
+#ifdef XPATH_PARSE_CACHE
+        struct xpath_tree *ysu_xpath;   /* Y_MUST/Y_WHEN/Y_PATH: parsed argument, see yang_xpath_get */
+#endif
+#ifdef YANG_IDENTITY_BITSET
+        struct yang_identity *ysu_identity; /* Y_IDENTITY: index and bases, see yang_identity_derived */
+#endif
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+        void            *ysu_mntcache;  /* Y_MOUNTS: mount-point and yang-lib registry, see yang_mount_get */
 #endif
     } u;
 };
@@ -132,5 +150,14 @@ struct yang_stmt {
 #ifdef OPTIMIZE_NO_PRESENCE_CONTAINER
 #define ys_nopres_cache   u.ysu_nopres_cache
 #endif
+#ifdef XPATH_PARSE_CACHE
+#define ys_xpath          u.ysu_xpath
+#endif
+#ifdef YANG_IDENTITY_BITSET
+#define ys_identity       u.ysu_identity
+#endif
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+#define ys_mntcache       u.ysu_mntcache
+#endif
 
 #endif  /* _CLIXON_YANG_INTERNAL_H_ */
@@ -70,6 +70,9 @@
 #include <sys/param.h>
 #include <netinet/in.h>
 #include <libgen.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -101,6 +104,7 @@
 #include "clixon_yang_internal.h"
 #include "clixon_yang_sub_parse.h"
 #include "clixon_yang_parse_lib.h"
+#include "clixon_yang_cache.h"
 
 /* Size of json read buffer when reading from file*/
 #define BUFLEN 1024
@@ -917,6 +921,62 @@ yang_parse_str(const char *str,
     return ymod;  /* top-level (sub)module */
 }
 
+/*! Read a whole YANG file into a string
+ *
+ * @param[in]  fp    Open file
+ * @param[out] bufp  File contents, null-terminated, free with free()
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @note Does not use the YANG parser, may be called in threads
+ */
+static int
+yang_file_read(FILE  *fp,
+               char **bufp)
+{
+    int         retval = -1;
+    char       *buf = NULL;
+    size_t      len;
+    size_t      i;
+    size_t      sz;
+    size_t      want;
+    struct stat st = {0,};
+
+    /* Read the whole file, size from fstat is a hint, one byte extra to detect EOF */
+    len = BUFLEN; /* any number is fine */
+    if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        len = st.st_size + 2;
+    if ((buf = malloc(len)) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        goto done;
+    }
+    i = 0; /* position in buf */
+    while (1){
+        want = len - 1 - i;
+        sz = fread(buf+i, 1, want, fp);
+        i += sz;
+        if (sz < want){
+            if (ferror(fp)){
+                clixon_err(OE_XML, errno, "fread");
+                goto done;
+            }
+            break;
+        }
+        if ((buf = realloc(buf, 2*len)) == NULL){
+            clixon_err(OE_XML, errno, "realloc");
+            goto done;
+        }
+        len *= 2;
+    }
+    buf[i] = '\0';
+    *bufp = buf;
+    buf = NULL;
+    retval = 0;
+  done:
+    if (buf != NULL)
+        free(buf);
+    return retval;
+}
+
 /*! Parse yang spec from an open file descriptor
  *
  * @param[in] fd     File descriptor containing the YANG file as ASCII characters
@@ -931,41 +991,11 @@ yang_parse_file(FILE       *fp,
                 const char *name,
                 yang_stmt  *yspec)
 {
-    char      *buf = NULL;
-    int        i;
-    char       c;
-    int        len;
-    yang_stmt *ymod = NULL;
-    size_t     sz;
+    char       *buf = NULL;
+    yang_stmt  *ymod = NULL;
 
-    len = BUFLEN; /* any number is fine */
-    if ((buf = malloc(len)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    if (yang_file_read(fp, &buf) < 0)
         goto done;
-    }
-    memset(buf, 0, len);
-    i = 0; /* position in buf */
-    while (1){ /* read the whole file */
-        sz = fread(&c, 1, 1, fp);
-        if (sz == 0 && feof(fp)){
-            break;
-        }
-        else if (sz == 1) {
-            if (i == len-1){
-                if ((buf = realloc(buf, 2*len)) == NULL){
-                    clixon_err(OE_XML, errno, "realloc");
-                    goto done;
-                }
-                memset(buf+len, 0, len);
-                len *= 2;
-            }
-            buf[i++] = (char)(c&0xff);
-        }
-        else {
-            clixon_err(OE_XML, errno, "fread %lu", sz);
-            goto done;
-        }
-    } /* read a line */
     if (NULL == (ymod = yang_parse_str(buf, name, yspec)))
         goto done;
   done:
@@ -1148,22 +1178,21 @@ done:
     goto done;
 }
 
-/*! Open a file, read into a string and invoke yang parsing
+/*! Parse a YANG file, or its contents if already read
  *
- * Similar to clicon_yang_str(), just read a file first
  * @param[in] h        Clixon handle (can be NULL, but then no callbacks)
  * @param[in] filename Name of file
- * @param[in] yspec    Yang specification. Should have been created by caller using yspec_new
+ * @param[in] str      Contents of file if already read, or NULL
+ * @param[in] yspec    Yang specification
  * @retval    ymod     Top-level yang (sub)module
  * @retval    NULL     Error encountered
-
- * The database symbols are inserted in alphabetical order.
- * See top of file for diagram of calling order
+ * @see yang_parse_filename
  */
-yang_stmt *
-yang_parse_filename(clixon_handle h,
-                    const char   *filename,
-                    yang_stmt    *yspec)
+static yang_stmt *
+yang_parse_filename_str(clixon_handle h,
+                        const char   *filename,
+                        const char   *str,
+                        yang_stmt    *yspec)
 {
     yang_stmt    *ymod = NULL;
     FILE         *fp = NULL;
@@ -1174,12 +1203,30 @@ yang_parse_filename(clixon_handle h,
         clixon_err(OE_YANG, errno, "%s not found", filename);
         goto done;
     }
-    if ((fp = fopen(filename, "r")) == NULL){
-        clixon_err(OE_YANG, errno, "fopen(%s)", filename);
-        goto done;
+    /* Use parse tree from cache file if valid, see CLICON_YANG_CACHE_DIR */
+    if (h && clicon_option_str(h, "CLICON_YANG_CACHE_DIR") != NULL){
+        if (yang_cache_read(h, filename, yspec, &ymod) < 0)
+            goto done;
+    }
+    if (ymod == NULL){
+        if (str != NULL){
+            if ((ymod = yang_parse_str(str, filename, yspec)) == NULL)
+                goto done;
+        }
+        else {
+            if ((fp = fopen(filename, "r")) == NULL){
+                clixon_err(OE_YANG, errno, "fopen(%s)", filename);
+                goto done;
+            }
+            if (NULL == (ymod = yang_parse_file(fp, filename, yspec)))
+                goto done;
+        }
+        /* Cache parse tree before patch, the cache is not essential */
+        if (h && yang_cache_write(h, filename, ymod) < 0){
+            clixon_log(h, LOG_WARNING, "YANG cache of %s not written: %s", filename, clixon_err_reason());
+            clixon_err_reset();
+        }
     }
-    if (NULL == (ymod = yang_parse_file(fp, filename, yspec)))
-        goto done;
     /* YANG patch hook */
     if (ymod && h && clixon_plugin_yang_patch_all(h, ymod) < 0)
         goto done;
@@ -1189,6 +1236,26 @@ yang_parse_filename(clixon_handle h,
     return ymod; /* top-level (sub)module */
 }
 
+/*! Open a file, read into a string and invoke yang parsing
+ *
+ * Similar to clicon_yang_str(), just read a file first
+ * @param[in] h        Clixon handle (can be NULL, but then no callbacks)
+ * @param[in] filename Name of file
+ * @param[in] yspec    Yang specification. Should have been created by caller using yspec_new
+ * @retval    ymod     Top-level yang (sub)module
+ * @retval    NULL     Error encountered
+
+ * The database symbols are inserted in alphabetical order.
+ * See top of file for diagram of calling order
+ */
+yang_stmt *
+yang_parse_filename(clixon_handle h,
+                    const char   *filename,
+                    yang_stmt    *yspec)
+{
+    return yang_parse_filename_str(h, filename, NULL, yspec);
+}
+
 /*! Given a (sub)module, parse all (sub)modules in turn recursively
  *
  * Find a yang module file, and then recursively parse all its imported modules.
@@ -1647,6 +1714,20 @@ yang_parse_post(clixon_handle h,
     for (i=0; i<ylen; i++)
         if (yang_cardinality(h, ylist[i], yang_argument_get(ylist[i])) < 0)
             goto done;
+#ifdef XML_EXPLICIT_INDEX
+    /* 12. Search indexes given by config options */
+    if (yang_search_index_option(h, yspec) < 0)
+        goto done;
+#endif
+    /* 13. Schema summaries for mandatory and min-elements checks */
+    if (yang_summary_set(yspec) < 0)
+        goto done;
+    /* 14. Remove documentation statements not needed at runtime */
+    if (clicon_option_bool(h, "CLICON_YANG_COMPACT")){
+        for (i=0; i<ylen; i++)
+            if (yang_compact(ylist[i]) < 0)
+                goto done;
+    }
     retval = 0;
  done:
     if (ylist)
@@ -1755,6 +1836,103 @@ yang_spec_parse_file(clixon_handle h,
     return retval;
 }
 
+/*! YANG file selected for loading by yang_spec_load_dir */
+struct yang_load_file {
+    char     *yl_filename; /* Full filename */
+    char     *yl_base;     /* Module name */
+    uint32_t  yl_revf;     /* Revision in filename */
+    char     *yl_buf;      /* File contents if read in advance, or NULL */
+};
+
+#ifdef HAVE_LIBPTHREAD
+/*! Argument of threads reading YANG files in advance */
+struct yang_load_read_arg {
+    struct yang_load_file *lr_files;
+    int                    lr_len;
+    int                    lr_next;  /* Next file to read */
+    pthread_mutex_t        lr_mutex; /* Protects lr_next */
+};
+
+/*! Thread reading YANG files until none are left
+ *
+ * A file that cannot be read is left unread and read again when parsed, where the
+ * error is reported
+ */
+static void *
+yang_load_read_worker(void *arg)
+{
+    struct yang_load_read_arg *lr = (struct yang_load_read_arg *)arg;
+    struct yang_load_file     *yl;
+    FILE                      *fp;
+    int                        i;
+
+    for (;;){
+        pthread_mutex_lock(&lr->lr_mutex);
+        if ((i = lr->lr_next) < lr->lr_len)
+            lr->lr_next++;
+        pthread_mutex_unlock(&lr->lr_mutex);
+        if (i >= lr->lr_len)
+            break;
+        yl = &lr->lr_files[i];
+        if ((fp = fopen(yl->yl_filename, "r")) == NULL)
+            continue;
+        (void)yang_file_read(fp, &yl->yl_buf);
+        fclose(fp);
+    }
+    return NULL;
+}
+
+/*! Read YANG files in parallel before they are parsed
+ *
+ * The YANG parser is not reentrant and adds to the common yspec, therefore only the
+ * file reading is made in threads, parsing is made serially from the read contents.
+ * @param[in]  files    Selected YANG files
+ * @param[in]  len      Number of files
+ * @param[in]  nthreads Number of threads
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+yang_load_read_files(struct yang_load_file *files,
+                     int                    len,
+                     int                    nthreads)
+{
+    int                       retval = -1;
+    struct yang_load_read_arg lr = {0, };
+    pthread_t                *tids = NULL;
+    int                       n;
+    int                       i;
+    int                       ret;
+
+    if (len < nthreads)
+        nthreads = len;
+    if ((tids = calloc(nthreads, sizeof(*tids))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    lr.lr_files = files;
+    lr.lr_len = len;
+    if (pthread_mutex_init(&lr.lr_mutex, NULL) != 0){
+        clixon_err(OE_UNIX, errno, "pthread_mutex_init");
+        goto done;
+    }
+    for (n=0; n<nthreads; n++)
+        if ((ret = pthread_create(&tids[n], NULL, yang_load_read_worker, &lr)) != 0){
+            clixon_log(NULL, LOG_WARNING, "pthread_create: %s", strerror(ret));
+            break;
+        }
+    /* If no threads were created the files are read when parsed */
+    for (i=0; i<n; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&lr.lr_mutex);
+    retval = 0;
+ done:
+    if (tids)
+        free(tids);
+    return retval;
+}
+#endif /* HAVE_LIBPTHREAD */
+
 /*! Load all yang modules in directory
  *
  * @param[in]  h     Clicon handle
@@ -1770,6 +1948,8 @@ yang_spec_parse_file(clixon_handle h,
  * 3) If only x@rev.yang's found, prefer newest (newest revision)
  * There is also an extra failsafe which may not be necessary, which removes
  * the oldest module if 1-3 for some reason fails.
+ * The files are first selected, then read in parallel if CLICON_YANG_LOAD_THREADS is
+ * larger than 1, and then parsed serially.
  */
 int
 yang_spec_load_dir(clixon_handle h,
@@ -1792,6 +1972,12 @@ yang_spec_load_dir(clixon_handle h,
     uint32_t       rev0; /* revision in existing module */
     char          *oldbase = NULL;
     int            taken = 0;
+    struct yang_load_file *files = NULL;
+    struct yang_load_file *yl;
+    int            nfiles = 0;
+#ifdef HAVE_LIBPTHREAD
+    int            nthreads;
+#endif
 
     /* Get yang files names from yang module directory. Note that these
      * are sorted alphatetically:
@@ -1803,9 +1989,13 @@ yang_spec_load_dir(clixon_handle h,
         goto done;
     if (ndp == 0)
         goto ok;
+    if ((files = calloc(ndp, sizeof(*files))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
     /* Apply post steps on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
-    /* Load all yang files in dir */
+    /* Select yang files in dir */
     for (i = 0; i < ndp; i++) {
         /* base = module name [+ @rev ] + .yang */
        if (oldbase)
@@ -1838,24 +2028,48 @@ yang_spec_load_dir(clixon_handle h,
             taken = 1; /* last in line and not taken */
         }
         /* Here only a single file is reached(taken)
-         * Check if module already exists -> ym0/rev0 */
+         * Skip if already added by specific file or module */
+        if (yang_find(yspec, Y_MODULE, base) != NULL ||
+            yang_find(yspec, Y_SUBMODULE, base) != NULL)
+            continue;
+        /* Create full filename */
+        snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
+        yl = &files[nfiles++];
+        if ((yl->yl_filename = strdup(filename)) == NULL ||
+            (yl->yl_base = strdup(base)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        yl->yl_revf = revf;
+    }
+#ifdef HAVE_LIBPTHREAD
+    /* Cached parse trees do not need the file, see CLICON_YANG_CACHE_DIR */
+    if (nfiles > 1 &&
+        clicon_option_str(h, "CLICON_YANG_CACHE_DIR") == NULL &&
+        (nthreads = clicon_option_int(h, "CLICON_YANG_LOAD_THREADS")) > 1){
+        if (yang_load_read_files(files, nfiles, nthreads) < 0)
+            goto done;
+    }
+#endif
+    /* Parse selected yang files */
+    for (i = 0; i < nfiles; i++) {
+        yl = &files[i];
+        /* Check if module already exists -> ym0/rev0, eg by an earlier file */
         rev0 = 0;
-        if ((ym0 = yang_find(yspec, Y_MODULE, base)) != NULL ||
-            (ym0 = yang_find(yspec, Y_SUBMODULE, base)) != NULL){
+        if ((ym0 = yang_find(yspec, Y_MODULE, yl->yl_base)) != NULL ||
+            (ym0 = yang_find(yspec, Y_SUBMODULE, yl->yl_base)) != NULL){
             yrev = yang_find(ym0, Y_REVISION, NULL);
             rev0 = cv_uint32_get(yang_cv_get(yrev));
             continue; /* skip if already added by specific file or module */
         }
-        /* Create full filename */
-        snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
-        if ((ym = yang_parse_filename(h, filename, yspec)) == NULL)
+        if ((ym = yang_parse_filename_str(h, yl->yl_filename, yl->yl_buf, yspec)) == NULL)
             goto done;
         revm = 0;
         if ((yrev = yang_find(ym, Y_REVISION, NULL)) != NULL)
             revm = cv_uint32_get(yang_cv_get(yrev));
         /* Sanity check that file revision does not match internal rev stmt */
-        if (revf && revm && revm != revf){ /* XXX */
-            clixon_err(OE_YANG, EINVAL, "Yang module file revision and in yang does not match: %s(%u) vs %u", filename, revf, revm);
+        if (yl->yl_revf && revm && revm != yl->yl_revf){ /* XXX */
+            clixon_err(OE_YANG, EINVAL, "Yang module file revision and in yang does not match: %s(%u) vs %u", yl->yl_filename, yl->yl_revf, revm);
             goto done;
         }
         /* If ym0 and ym exists, delete the yang with oldest revision 
@@ -1876,6 +2090,17 @@ yang_spec_load_dir(clixon_handle h,
  ok:
     retval = 0;
   done:
+    if (files){
+        for (i = 0; i < nfiles; i++){
+            if (files[i].yl_filename)
+                free(files[i].yl_filename);
+            if (files[i].yl_base)
+                free(files[i].yl_base);
+            if (files[i].yl_buf)
+                free(files[i].yl_buf);
+        }
+        free(files);
+    }
     if (dp)
         free(dp);
     if (base)
@@ -2024,8 +2249,13 @@ ys_parse_sub(yang_stmt  *ys,
         break;
     case Y_MUST:
     case Y_WHEN:
+#ifdef XPATH_PARSE_CACHE
+        if (yang_xpath_get(ys) == NULL) /* Precompile, kept for evaluation */
+            goto done;
+#else
         if (xpath_parse(yang_argument_get(ys), NULL) < 0)
             goto done;
+#endif
         break;
     case Y_REVISION:
     case Y_REVISION_DATE:  /* YYYY-MM-DD encoded as uint32 YYYYMMDD */
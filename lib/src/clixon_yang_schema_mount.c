@@ -122,8 +122,138 @@
 #include "clixon_plugin.h"
 #include "clixon_xml_bind.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_digest.h"
 #include "clixon_yang_schema_mount.h"
 
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+/*! Registry of mounted yspecs, kept on the top-level yang mounts node
+ */
+struct yang_mount_cache {
+    clicon_hash_t *ymc_xpath; /* Canonical mount-point xpath -> mounted yspec */
+    clicon_hash_t *ymc_lib;   /* Digest of yang-library -> mounted yspec */
+};
+
+/*! Get registry of mounted yspecs, create if not exists
+ *
+ * @param[in]  ymounts  Top-level yang mounts
+ * @retval     ymc      Registry
+ * @retval     NULL     Error
+ */
+static struct yang_mount_cache *
+yang_mount_cache_get(yang_stmt *ymounts)
+{
+    struct yang_mount_cache *ymc;
+
+    if ((ymc = yang_mntcache_get(ymounts)) != NULL)
+        return ymc;
+    if ((ymc = calloc(1, sizeof(*ymc))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    if ((ymc->ymc_xpath = clicon_hash_init()) == NULL ||
+        (ymc->ymc_lib = clicon_hash_init()) == NULL){
+        yang_mount_cache_free(ymc);
+        return NULL;
+    }
+    yang_mntcache_set(ymounts, ymc);
+    return ymc;
+}
+
+/*! Free registry of mounted yspecs, not the yspecs
+ *
+ * @param[in]  arg  Registry
+ * @retval     0    OK
+ */
+int
+yang_mount_cache_free(void *arg)
+{
+    struct yang_mount_cache *ymc = (struct yang_mount_cache *)arg;
+
+    if (ymc->ymc_xpath)
+        clicon_hash_free(ymc->ymc_xpath);
+    if (ymc->ymc_lib)
+        clicon_hash_free(ymc->ymc_lib);
+    free(ymc);
+    return 0;
+}
+
+/*! Remove mount-point xpath from registry of mounted yspecs
+ *
+ * @param[in]  ymounts  Top-level yang mounts
+ * @param[in]  xpath    Canonical mount-point xpath
+ */
+static void
+yang_mount_cache_rm(yang_stmt  *ymounts,
+                    const char *xpath)
+{
+    struct yang_mount_cache *ymc;
+
+    if ((ymc = yang_mntcache_get(ymounts)) != NULL &&
+        clicon_hash_lookup(ymc->ymc_xpath, xpath) != NULL)
+        clicon_hash_del(ymc->ymc_xpath, xpath);
+}
+
+/*! Compute registry key of a yang-library: digest of its XML
+ *
+ * Equal yang-libraries have equal keys, as compared by xml_tree_equal
+ * @param[in]  xyanglib  XML yang-library, including module-set name (domain)
+ * @param[out] keyp      Key, free after use
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+yang_mount_cache_libkey(cxobj *xyanglib,
+                        char **keyp)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_YANG, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, xyanglib, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if (clixon_digest_hex(cbuf_get(cb), keyp) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Register mounted yspec by its yang-library, for sharing with equal mount-points
+ *
+ * @param[in]  ymounts   Top-level yang mounts
+ * @param[in]  xyanglib  XML yang-library
+ * @param[in]  yspec     Mounted yspec with all modules parsed
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+yang_mount_cache_lib_add(yang_stmt *ymounts,
+                         cxobj     *xyanglib,
+                         yang_stmt *yspec)
+{
+    int                      retval = -1;
+    struct yang_mount_cache *ymc;
+    char                    *key = NULL;
+
+    if ((ymc = yang_mount_cache_get(ymounts)) == NULL)
+        goto done;
+    if (yang_mount_cache_libkey(xyanglib, &key) < 0)
+        goto done;
+    if (clicon_hash_add(ymc->ymc_lib, key, &yspec, sizeof(yspec)) == NULL)
+        goto done;
+    retval = 0;
+ done:
+    if (key)
+        free(key);
+    return retval;
+}
+#endif /* YANG_SCHEMA_MOUNT_CACHE */
+
 /*! Check if YANG node is a RFC 8528 YANG schema mount
  *
  * Check if:
@@ -223,11 +353,26 @@ yang_mount_get(yang_stmt  *ys,
     yang_stmt *yspec = NULL;
     int        inext;
     int        inext2;
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+    struct yang_mount_cache *ymc = NULL;
+    yang_stmt **yp;
+#endif
 
     if ((ymounts = ys_mounts(ys)) == NULL){
         clixon_err(OE_YANG, ENOENT, "Top-level yang mounts not found");
         goto done;
     }
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+    if (xpath != NULL){
+        if ((ymc = yang_mount_cache_get(ymounts)) == NULL)
+            goto done;
+        if ((yp = clicon_hash_value(ymc->ymc_xpath, xpath, NULL)) != NULL){
+            *yspecp = *yp;
+            retval = 0;
+            goto done;
+        }
+    }
+#endif
     inext = 0;
     ydomain = NULL;
     while ((ydomain = yn_iter(ymounts, &inext)) != NULL) {
@@ -243,6 +388,12 @@ yang_mount_get(yang_stmt  *ys,
         if (yspec != NULL)
             break;
     }
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+    /* Only found yspecs, a mount-point may get a yspec later */
+    if (ymc != NULL && yspec != NULL &&
+        clicon_hash_add(ymc->ymc_xpath, xpath, &yspec, sizeof(yspec)) == NULL)
+        goto done;
+#endif
     *yspecp = yspec;
     retval = 0;
  done:
@@ -723,6 +874,7 @@ yang_schema_mount_statedata(clixon_handle h,
     goto done;
 }
 
+#ifndef YANG_SCHEMA_MOUNT_CACHE
 /*! Given xml mount-point and yanglib, find existing yspec
  *
  * Get and loop through all XML from xt mount-points.
@@ -786,6 +938,45 @@ yang_schema_find_share(clixon_handle h,
         cvec_free(cvv);
     return retval;
 }
+#else /* YANG_SCHEMA_MOUNT_CACHE */
+/*! Given yanglib, find existing yspec in registry of mounted yspecs
+ *
+ * As yang_schema_find_share but without getting the yang-library of all other mount-points
+ * @param[in]   h        Clixon handle
+ * @param[in]   xyanglib yanglib in XML
+ * @param[out]  yspecp   Yang spec, or NULL if none
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see yang_mount_cache_lib_add
+ */
+static int
+yang_schema_find_share_cached(clixon_handle h,
+                              cxobj        *xyanglib,
+                              yang_stmt   **yspecp)
+{
+    int                      retval = -1;
+    struct yang_mount_cache *ymc;
+    yang_stmt               *ymounts;
+    yang_stmt              **yp;
+    char                    *key = NULL;
+
+    if ((ymounts = clixon_yang_mounts_get(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "Top-level yang mounts not found");
+        goto done;
+    }
+    if ((ymc = yang_mount_cache_get(ymounts)) == NULL)
+        goto done;
+    if (yang_mount_cache_libkey(xyanglib, &key) < 0)
+        goto done;
+    if ((yp = clicon_hash_value(ymc->ymc_lib, key, NULL)) != NULL)
+        *yspecp = *yp;
+    retval = 0;
+ done:
+    if (key)
+        free(key);
+    return retval;
+}
+#endif /* YANG_SCHEMA_MOUNT_CACHE */
 
 /*! Given yanglib, mount it, potentially create a new yspec, and parse all its yangs
  *
@@ -838,8 +1029,13 @@ yang_schema_yanglib_mount_parse(clixon_handle h,
             goto done;
     }
     /* Optimization: find equal yspec from other mount-point */
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+    if (yang_schema_find_share_cached(h, xyanglib, &yspec0) < 0)
+        goto done;
+#else
     if (yang_schema_find_share(h, xt, xyanglib, &yspec0) < 0)
         goto done;
+#endif
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_YANG, errno, "cbuf_new");
         goto done;
@@ -852,9 +1048,16 @@ yang_schema_yanglib_mount_parse(clixon_handle h,
         if ((ret = yang_lib2yspec(h, xyanglib, xpath, domain, yspec1)) < 0)
             goto done;
         if (ret == 0){
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+            yang_mount_cache_rm(ymounts, xpath);
+#endif
             ys_prune_self(yspec1); /* remove from tree, free in done code */
             goto anydata;
         }
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+        if (yang_mount_cache_lib_add(ymounts, xyanglib, yspec1) < 0)
+            goto done;
+#endif
     }
     if (xml_yang_mount_set(h, xt, yspec1) < 0)
         goto done;
@@ -975,6 +1178,9 @@ yang_schema_yspec_rm(clixon_handle h,
     if ((ret = xml_yang_mount_get(h, xmnt, NULL, &xpath, &yspec)) < 0)
         goto done;
     if (ret == 1 && xpath != NULL && yspec != NULL){
+#ifdef YANG_SCHEMA_MOUNT_CACHE
+        yang_mount_cache_rm(ys_mounts(yspec), xpath);
+#endif
         if (yang_cvec_rm(yspec, xpath) < 0)
             goto done;
 #if 0
@@ -78,6 +78,7 @@
 #include <regex.h>
 #include <netinet/in.h>
 #include <sys/param.h>
+#include <time.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -101,6 +102,7 @@
 #include "clixon_plugin.h"
 #include "clixon_options.h"
 #include "clixon_yang_type.h"
+#include "clixon_validate_profile.h"
 
 /*
  * Local types and variables
@@ -294,6 +296,11 @@ ys_resolve_type(yang_stmt *ytype,
     if (yang_type_cache_set2(ytype, resolved, options, cvv,
                              patterns, fraction, clicon_yang_regexp(h), regexps) < 0)
         goto done;
+#ifdef YANG_ENUM_TABLE
+    if (resolved == ytype && strcmp(yang_argument_get(ytype), "enumeration") == 0 &&
+        yang_type_cache_enum_set(ytype) < 0)
+        goto done;
+#endif
     retval = 0;
  done:
     if (regexps)
@@ -607,6 +614,8 @@ cv_validate1(clixon_handle h,
     int             retu; /* separated due to different error handling */
     int             rets;
     int             inext;
+    int             prof = 0;
+    struct timespec t0;
 
     if (reason && *reason){
         free(*reason);
@@ -615,6 +624,8 @@ cv_validate1(clixon_handle h,
     /* check options first for length and range */
     if ((options & YANG_OPTIONS_RANGE) != 0 ||
         (options & YANG_OPTIONS_LENGTH) != 0){
+        if ((prof = validate_profile_enabled()) != 0)
+            validate_profile_start(&t0);
         i = 0;
         while (i<cvec_len(cvv)){
             cv1 = cvec_i(cvv, i++); /* Increment to check for max pair */
@@ -696,6 +707,8 @@ cv_validate1(clixon_handle h,
         } /* while i<cvec_len(cvv) */
     }
  step1ok:
+    if (prof && validate_profile_add(NULL, VP_RANGE, &t0) < 0)
+        goto done;
     /* then check options for others */
     switch (cvtype){
     case CGV_STRING:
@@ -705,20 +718,7 @@ cv_validate1(clixon_handle h,
          */
         if (restype){
             if (strcmp(restype, "enumeration") == 0){
-                found = 0;
-                if (str != NULL) {
-                    //              str = clixon_trim2(str, " \t\n"); /* May be misplaced, strip earlier? */
-                    inext = 0;
-                    while ((yi = yn_iter(yrestype, &inext)) != NULL){
-                        if (yang_keyword_get(yi) != Y_ENUM)
-                            continue;
-                        if (strcmp(yang_argument_get(yi), str) == 0){
-                            found++;
-                            break;
-                        }
-                    }
-                }
-                if (!found){
+                if (yang_enum_find(yrestype, str) == NULL){
                     if (reason)
                         *reason = cligen_reason("'%s' does not match enumeration", str);
                     goto fail;
@@ -756,8 +756,12 @@ cv_validate1(clixon_handle h,
             }
         }
         if (regexps && cvec_len(regexps)) {
+            if ((prof = validate_profile_enabled()) != 0)
+                validate_profile_start(&t0);
             if ((ret = cv_validate_pattern(h, regexps, yrestype, str, reason)) < 0)
                 goto done;
+            if (prof && validate_profile_add(NULL, VP_PATTERN, &t0) < 0)
+                goto done;
             if (ret == 0)
                 goto fail;
         }
@@ -989,6 +993,579 @@ ys_cv_validate_union(clixon_handle h,
     return retval;
 }
 
+#ifdef YANG_TYPE_VALIDATOR
+/* Forward */
+static int yang_type_stmt(yang_stmt **ysp, yang_stmt **ytypep);
+
+/* Map signed to unsigned values preserving order, for range intervals */
+#define TV_SIGNED2U(i) ((uint64_t)(i) ^ 0x8000000000000000ULL)
+
+/*! Interval of a range or length restriction, signed values are mapped with TV_SIGNED2U
+ */
+struct yang_type_interval {
+    uint64_t ti_min;
+    uint64_t ti_max;
+};
+
+/*! Validator compiled from a resolved type, attached to the type cache
+ *
+ * A value accepted by the validator is valid. Unless tv_generic is set, a value not
+ * accepted is not valid, and the generic code is only used to give the reason.
+ */
+struct yang_type_valid {
+    enum cv_type               tv_cvtype;   /* Resolved cligen type */
+    uint8_t                    tv_fraction; /* Fraction digits for decimal64 */
+    int                        tv_generic;  /* Not compiled, use generic validation */
+    struct yang_type_interval *tv_range;    /* Sorted disjoint range/length intervals, or NULL */
+    int                        tv_nrange;   /* Length of tv_range */
+    cvec                      *tv_regexps;  /* Compiled patterns, regexps owned by type caches */
+    char                     **tv_enums;    /* Sorted enumeration names, or NULL */
+    int                        tv_nenums;   /* Length of tv_enums */
+    struct yang_type_valid   **tv_union;    /* Validators of union members */
+    yang_stmt                **tv_utype;    /* Type statements of union members */
+    int                        tv_nunion;   /* Number of union members, 0 if not union */
+};
+
+/*! Free compiled type validator
+ *
+ * @param[in]  arg  Validator, see yang_type_cache_valid_set
+ * @retval     0    OK
+ */
+int
+yang_type_valid_free(void *arg)
+{
+    struct yang_type_valid *tv = (struct yang_type_valid *)arg;
+    int                     i;
+
+    if (tv == NULL)
+        return 0;
+    if (tv->tv_range)
+        free(tv->tv_range);
+    if (tv->tv_regexps)
+        cvec_free(tv->tv_regexps);
+    if (tv->tv_enums)
+        free(tv->tv_enums);
+    for (i=0; i<tv->tv_nunion; i++)
+        yang_type_valid_free(tv->tv_union[i]);
+    if (tv->tv_union)
+        free(tv->tv_union);
+    if (tv->tv_utype)
+        free(tv->tv_utype);
+    free(tv);
+    return 0;
+}
+
+static int
+tv_strcmp(const void *a,
+          const void *b)
+{
+    return strcmp(*(char **)a, *(char **)b);
+}
+
+static int
+tv_interval_cmp(const void *a,
+                const void *b)
+{
+    const struct yang_type_interval *i1 = a;
+    const struct yang_type_interval *i2 = b;
+
+    if (i1->ti_min == i2->ti_min)
+        return 0;
+    return i1->ti_min < i2->ti_min ? -1 : 1;
+}
+
+/*! Get value of an integer cligen variable as ordered unsigned value
+ *
+ * @param[in]  cv   Cligen variable
+ * @param[out] u    Value, signed values mapped with TV_SIGNED2U
+ * @retval     1    OK
+ * @retval     0    Not an integer type
+ */
+static int
+tv_cv2u64(cg_var   *cv,
+          uint64_t *u)
+{
+    switch (cv_type_get(cv)){
+    case CGV_INT8:
+        *u = TV_SIGNED2U((int64_t)cv_int8_get(cv));
+        break;
+    case CGV_INT16:
+        *u = TV_SIGNED2U((int64_t)cv_int16_get(cv));
+        break;
+    case CGV_INT32:
+        *u = TV_SIGNED2U((int64_t)cv_int32_get(cv));
+        break;
+    case CGV_INT64:
+        *u = TV_SIGNED2U(cv_int64_get(cv));
+        break;
+    case CGV_UINT8:
+        *u = cv_uint8_get(cv);
+        break;
+    case CGV_UINT16:
+        *u = cv_uint16_get(cv);
+        break;
+    case CGV_UINT32:
+        *u = cv_uint32_get(cv);
+        break;
+    case CGV_UINT64:
+        *u = cv_uint64_get(cv);
+        break;
+    default:
+        return 0;
+    }
+    return 1;
+}
+
+/*! Compile range or length restriction into sorted disjoint intervals
+ *
+ * Same pairing of range_min and range_max as in cv_validate1
+ * @param[in]  tv      Validator
+ * @param[in]  cvv     Range or length restriction
+ * @param[in]  length  Length restriction, values are unsigned
+ * @retval     1       OK
+ * @retval     0       Not compiled, eg decimal64
+ * @retval    -1       Error
+ */
+static int
+tv_compile_range(struct yang_type_valid *tv,
+                 cvec                   *cvv,
+                 int                     length)
+{
+    struct yang_type_interval *ti;
+    cg_var                    *cv1;
+    cg_var                    *cv2;
+    int                        i;
+    int                        j;
+
+    if ((tv->tv_range = calloc(cvec_len(cvv), sizeof(*tv->tv_range))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    i = 0;
+    while (i<cvec_len(cvv)){
+        cv1 = cvec_i(cvv, i++);
+        if (strcmp(cv_name_get(cv1), "range_min") != 0)
+            return 0;
+        if (i<cvec_len(cvv) &&
+            (cv2 = cvec_i(cvv, i)) != NULL &&
+            strcmp(cv_name_get(cv2), "range_max") == 0)
+            i++;
+        else
+            cv2 = cv1;
+        ti = &tv->tv_range[tv->tv_nrange++];
+        if (length){
+            if (cv_type_get(cv1) != CGV_UINT64 || cv_type_get(cv2) != CGV_UINT64)
+                return 0;
+            ti->ti_min = cv_uint64_get(cv1);
+            ti->ti_max = cv_uint64_get(cv2);
+        }
+        else if (cv_type_get(cv1) != tv->tv_cvtype || cv_type_get(cv2) != tv->tv_cvtype ||
+                 tv_cv2u64(cv1, &ti->ti_min) == 0 || tv_cv2u64(cv2, &ti->ti_max) == 0)
+            return 0;
+        if (ti->ti_min > ti->ti_max)
+            return 0;
+    }
+    /* Sort and merge overlapping intervals */
+    qsort(tv->tv_range, tv->tv_nrange, sizeof(*tv->tv_range), tv_interval_cmp);
+    for (i=0, j=1; j<tv->tv_nrange; j++){
+        if (tv->tv_range[j].ti_min <= tv->tv_range[i].ti_max){
+            if (tv->tv_range[j].ti_max > tv->tv_range[i].ti_max)
+                tv->tv_range[i].ti_max = tv->tv_range[j].ti_max;
+        }
+        else
+            tv->tv_range[++i] = tv->tv_range[j];
+    }
+    if (tv->tv_nrange)
+        tv->tv_nrange = i+1;
+    return 1;
+}
+
+/*! Compile a validator from a resolved type
+ *
+ * @param[in]  cvtype   Resolved cligen type
+ * @param[in]  yrestype Resolved type
+ * @param[in]  options  See YANG_OPTIONS_*
+ * @param[in]  cvv      Range or length restriction
+ * @param[in]  regexps  Compiled patterns
+ * @param[in]  fraction Fraction digits of decimal64
+ * @param[out] tvp      Validator, free with yang_type_valid_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @note Unions and leafrefs are generic, unions are compiled by the caller
+ */
+static int
+tv_compile(enum cv_type             cvtype,
+           yang_stmt               *yrestype,
+           int                      options,
+           cvec                    *cvv,
+           cvec                    *regexps,
+           uint8_t                  fraction,
+           struct yang_type_valid **tvp)
+{
+    int                     retval = -1;
+    struct yang_type_valid *tv;
+    char                   *restype;
+    yang_stmt              *yi;
+    int                     inext;
+    int                     ret;
+
+    if ((tv = calloc(1, sizeof(*tv))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    tv->tv_cvtype = cvtype;
+    tv->tv_fraction = fraction;
+    restype = yrestype?yang_argument_get(yrestype):NULL;
+    if (cvtype == CGV_ERR ||
+        (restype && (strcmp(restype, "union") == 0 ||
+                     strcmp(restype, "leafref") == 0 ||
+                     strcmp(restype, "bits") == 0))){
+        tv->tv_generic = 1;
+        goto ok;
+    }
+    if ((options & (YANG_OPTIONS_RANGE|YANG_OPTIONS_LENGTH)) != 0 && cvv && cvec_len(cvv) > 0){
+        if (cvtype == CGV_STRING || cvtype == CGV_REST)
+            ret = tv_compile_range(tv, cvv, 1);
+        else
+            ret = tv_compile_range(tv, cvv, 0);
+        if (ret < 0)
+            goto done;
+        if (ret == 0){
+            tv->tv_generic = 1;
+            goto ok;
+        }
+    }
+    if (cvtype == CGV_STRING || cvtype == CGV_REST){
+        if (regexps && cvec_len(regexps) &&
+            (tv->tv_regexps = cvec_dup(regexps)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_dup");
+            goto done;
+        }
+        if (restype && strcmp(restype, "enumeration") == 0){
+            if ((tv->tv_enums = calloc(yang_len_get(yrestype)+1, sizeof(char *))) == NULL){
+                clixon_err(OE_UNIX, errno, "calloc");
+                goto done;
+            }
+            inext = 0;
+            while ((yi = yn_iter(yrestype, &inext)) != NULL){
+                if (yang_keyword_get(yi) == Y_ENUM)
+                    tv->tv_enums[tv->tv_nenums++] = yang_argument_get(yi);
+            }
+            qsort(tv->tv_enums, tv->tv_nenums, sizeof(char *), tv_strcmp);
+        }
+    }
+ ok:
+    *tvp = tv;
+    tv = NULL;
+    retval = 0;
+ done:
+    if (tv)
+        yang_type_valid_free(tv);
+    return retval;
+}
+
+/*! Check a parsed value with a compiled validator
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  tv   Validator, not generic
+ * @param[in]  cv   Parsed value
+ * @retval     1    Valid
+ * @retval     0    Not valid
+ * @retval    -1    Error
+ */
+static int
+tv_check(clixon_handle           h,
+         struct yang_type_valid *tv,
+         cg_var                 *cv)
+{
+    char    *str = NULL;
+    uint64_t u;
+    cg_var  *cvr;
+    int      lo;
+    int      hi;
+    int      mid;
+    int      ret;
+    int      prof;
+    struct timespec t0;
+
+    prof = validate_profile_enabled();
+    if (tv->tv_cvtype == CGV_STRING || tv->tv_cvtype == CGV_REST)
+        str = cv_string_get(cv);
+    if (tv->tv_nrange){
+        if (prof)
+            validate_profile_start(&t0);
+        if (tv->tv_cvtype == CGV_STRING || tv->tv_cvtype == CGV_REST)
+            u = str?strlen(str):0;
+        else if (tv_cv2u64(cv, &u) == 0)
+            return 0;
+        /* Binary search of last interval with min <= u */
+        lo = 0;
+        hi = tv->tv_nrange-1;
+        while (lo < hi){
+            mid = (lo+hi+1)/2;
+            if (tv->tv_range[mid].ti_min <= u)
+                lo = mid;
+            else
+                hi = mid-1;
+        }
+        if (prof && validate_profile_add(NULL, VP_RANGE, &t0) < 0)
+            return -1;
+        if (u < tv->tv_range[lo].ti_min || u > tv->tv_range[lo].ti_max)
+            return 0;
+    }
+    if (tv->tv_enums){
+        if (str == NULL ||
+            bsearch(&str, tv->tv_enums, tv->tv_nenums, sizeof(char *), tv_strcmp) == NULL)
+            return 0;
+    }
+    if (tv->tv_regexps){
+        if (prof)
+            validate_profile_start(&t0);
+        cvr = NULL;
+        while ((cvr = cvec_each(tv->tv_regexps, cvr)) != NULL){
+            if ((ret = regex_exec(h, cv_void_get(cvr), str?str:"")) < 0)
+                return -1;
+            if (cv_flag(cvr, V_INVERT))
+                ret = !ret;
+            if (ret == 0)
+                break;
+        }
+        if (prof && validate_profile_add(NULL, VP_PATTERN, &t0) < 0)
+            return -1;
+        if (cvr != NULL)
+            return 0;
+    }
+    return 1;
+}
+
+/*! Reject a union member without parsing the value, if it cannot match
+ *
+ * @param[in]  tv   Validator of union member, not generic
+ * @param[in]  val  Value
+ * @retval     1    Value cannot match
+ * @retval     0    Value may match
+ */
+static int
+tv_union_reject(struct yang_type_valid *tv,
+                char                   *val)
+{
+    switch (tv->tv_cvtype){
+    case CGV_INT8:
+    case CGV_INT16:
+    case CGV_INT32:
+    case CGV_INT64:
+    case CGV_UINT8:
+    case CGV_UINT16:
+    case CGV_UINT32:
+    case CGV_UINT64:
+        return *val == '\0' || isalpha((unsigned char)*val);
+    default:
+        break;
+    }
+    if (tv->tv_enums &&
+        bsearch(&val, tv->tv_enums, tv->tv_nenums, sizeof(char *), tv_strcmp) == NULL)
+        return 1;
+    return 0;
+}
+
+/*! Get compiled validator of a leaf or leaf-list, compile on first use
+ *
+ * @param[in]  ys   Leaf or leaf-list
+ * @param[out] tvp  Validator, or NULL if type has no cache
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+yang_type_valid_get(yang_stmt               *ys,
+                    struct yang_type_valid **tvp)
+{
+    int                     retval = -1;
+    yang_stmt              *ys0 = ys;
+    yang_stmt              *ytype;
+    struct yang_type_valid *tv = NULL;
+    struct yang_type_valid *tvm;
+    char                   *origtype = NULL;
+    yang_stmt              *yrestype = NULL;
+    yang_stmt              *ymrestype;
+    yang_stmt              *yt;
+    char                   *restype;
+    int                     options = 0;
+    cvec                   *cvv = NULL;
+    cvec                   *patterns = NULL;
+    cvec                   *regexps = NULL;
+    uint8_t                 fraction = 0;
+    enum cv_type            cvtype;
+    int                     inext;
+
+    *tvp = NULL;
+    if (yang_type_stmt(&ys0, &ytype) < 0)
+        goto done;
+    if (yang_typecache_get(ytype) == NULL)
+        goto ok;
+    if ((*tvp = yang_type_cache_valid_get(ytype)) != NULL)
+        goto ok;
+    if ((patterns = cvec_new(0)) == NULL ||
+        (regexps = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    if (yang_type_get(ys, &origtype, &yrestype, &options, &cvv, patterns, regexps, &fraction) < 0)
+        goto done;
+    restype = yrestype?yang_argument_get(yrestype):NULL;
+    if (clicon_type2cv(origtype, restype, ys, &cvtype) < 0)
+        goto done;
+    if (tv_compile(cvtype, yrestype, options, cvv, regexps, fraction, &tv) < 0)
+        goto done;
+    if (restype && strcmp(restype, "union") == 0 && cvtype == CGV_REST){
+        /* Compile union members, nested unions and leafrefs are generic */
+        tv->tv_generic = 0;
+        if ((tv->tv_union = calloc(yang_len_get(yrestype), sizeof(*tv->tv_union))) == NULL ||
+            (tv->tv_utype = calloc(yang_len_get(yrestype), sizeof(*tv->tv_utype))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        inext = 0;
+        while ((yt = yn_iter(yrestype, &inext)) != NULL){
+            if (yang_keyword_get(yt) != Y_TYPE)
+                continue;
+            cvec_reset(patterns);
+            cvec_reset(regexps);
+            if (yang_type_resolve(ys, ys, yt, &ymrestype, &options, &cvv, patterns, regexps,
+                                  &fraction) < 0)
+                goto done;
+            if (clicon_type2cv(origtype, ymrestype?yang_argument_get(ymrestype):NULL,
+                               ys, &cvtype) < 0)
+                goto done;
+            if (tv_compile(cvtype, ymrestype, options, cvv, regexps, fraction, &tvm) < 0)
+                goto done;
+            tv->tv_utype[tv->tv_nunion] = yt;
+            tv->tv_union[tv->tv_nunion++] = tvm;
+        }
+    }
+    if (yang_type_cache_valid_set(ytype, tv) < 0)
+        goto done;
+    *tvp = tv;
+    tv = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (tv)
+        yang_type_valid_free(tv);
+    if (origtype)
+        free(origtype);
+    if (patterns)
+        cvec_free(patterns);
+    if (regexps)
+        cvec_free(regexps);
+    return retval;
+}
+
+/*! Validate union value with compiled validators of members
+ *
+ * Members are tried in order, as the first matching member is the sub-type of the value
+ * @param[in]  h     Clixon handle
+ * @param[in]  ys    Leaf or leaf-list
+ * @param[in]  tv    Validator of union
+ * @param[in]  type  Original type
+ * @param[in]  val   Value
+ * @param[out] ysubp Sub-type of ys that matches val
+ * @retval     1     Valid
+ * @retval     0     Not valid, no reason
+ * @retval    -1     Error
+ */
+static int
+tv_union_check(clixon_handle           h,
+               yang_stmt              *ys,
+               struct yang_type_valid *tv,
+               char                   *type,
+               char                   *val,
+               yang_stmt             **ysubp)
+{
+    int                     retval = -1;
+    struct yang_type_valid *tvm;
+    cg_var                 *cvt = NULL;
+    int                     i;
+    int                     ret;
+
+    for (i=0; i<tv->tv_nunion; i++){
+        tvm = tv->tv_union[i];
+        if (tvm->tv_generic){
+            if ((ret = ys_cv_validate_union_one(h, ys, NULL, tv->tv_utype[i], type, val)) < 0)
+                goto done;
+        }
+        else if (tv_union_reject(tvm, val))
+            ret = 0;
+        else {
+            if (cvt)
+                cv_free(cvt);
+            if ((cvt = cv_new(tvm->tv_cvtype)) == NULL){
+                clixon_err(OE_UNIX, errno, "cv_new");
+                goto done;
+            }
+            if (tvm->tv_cvtype == CGV_DEC64)
+                cv_dec64_n_set(cvt, tvm->tv_fraction);
+            if ((ret = cv_parse1(val, cvt, NULL)) < 0){
+                clixon_err(OE_UNIX, errno, "cv_parse");
+                goto done;
+            }
+            if (ret == 1 && (ret = tv_check(h, tvm, cvt)) < 0)
+                goto done;
+        }
+        if (ret == 1){
+            if (ysubp)
+                *ysubp = tv->tv_utype[i];
+            break;
+        }
+    }
+    retval = (i < tv->tv_nunion);
+ done:
+    if (cvt)
+        cv_free(cvt);
+    return retval;
+}
+
+/*! Validate cligen variable with compiled validator of its type
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  cv      A cligen variable to validate
+ * @param[in]  ys      A yang statement, leaf or leaf-list
+ * @param[out] ysub    Sub-type that matches val (in case of union, otherwise ys)
+ * @retval     1       Valid
+ * @retval     0       Not known to be valid, use generic validation
+ * @retval    -1       Error
+ */
+static int
+ys_cv_validate_compiled(clixon_handle h,
+                        cg_var       *cv,
+                        yang_stmt    *ys,
+                        yang_stmt   **ysub)
+{
+    struct yang_type_valid *tv;
+    enum cv_type            ycvtype;
+    char                   *val;
+    int                     ret;
+
+    if (yang_type_valid_get(ys, &tv) < 0)
+        return -1;
+    if (tv == NULL || tv->tv_generic)
+        return 0;
+    /* Type mismatch is reported by generic validation */
+    ycvtype = cv_type_get(yang_cv_get(ys));
+    if (ycvtype != tv->tv_cvtype &&
+        !(tv->tv_cvtype == CGV_STRING && ycvtype == CGV_REST))
+        return 0;
+    if (tv->tv_nunion){
+        if ((val = cv_string_get(cv)) == NULL)
+            val = "";
+        return tv_union_check(h, ys, tv, yang_argument_get(yang_find(ys, Y_TYPE, NULL)),
+                              val, ysub);
+    }
+    if ((ret = tv_check(h, tv, cv)) == 1 && ysub)
+        *ysub = ys;
+    return ret;
+}
+#endif /* YANG_TYPE_VALIDATOR */
+
 /*! Validate cligen variable cv using yang statement as spec
  *
  * @param[in]  h       Clixon handle     
@@ -1031,6 +1608,15 @@ ys_cv_validate(clixon_handle h,
         retval = 1;
         goto done;
     }
+#ifdef YANG_TYPE_VALIDATOR
+    /* Fast path, generic validation below is used for failures and reasons */
+    if ((retval2 = ys_cv_validate_compiled(h, cv, ys, ysub)) < 0)
+        goto done;
+    if (retval2 == 1){
+        retval = 1;
+        goto done;
+    }
+#endif
     ycv = yang_cv_get(ys);
     if ((patterns = cvec_new(0)) == NULL){
         clixon_err(OE_UNIX, errno, "cvec_new");
@@ -1422,6 +2008,38 @@ yang_type_resolve(yang_stmt   *yorig,
     return retval;
 }
 
+/*! Get type statement of a leaf/leaf-list used to resolve its type
+ *
+ * Use original tree to resolve types, unless the type is refined
+ * @param[in,out] ysp    Leaf or leaf-list, on return the original if used
+ * @param[out]    ytypep Type statement
+ * @retval        0      OK
+ * @retval       -1      Error
+ */
+static int
+yang_type_stmt(yang_stmt **ysp,
+               yang_stmt **ytypep)
+{
+    yang_stmt *ys = *ysp;
+    yang_stmt *ytype;
+    yang_stmt *yorig;
+
+    if ((ytype = yang_find(ys, Y_TYPE, NULL)) == NULL){
+        clixon_err(OE_DB, ENOENT, "mandatory type object is not found");
+        return -1;
+    }
+    if ((yorig = yang_orig_get(ys)) != NULL && yang_flag_get(ytype, YANG_FLAG_REFINE) == 0){
+        ys = yorig;
+        if ((ytype = yang_find(ys, Y_TYPE, NULL)) == NULL){
+            clixon_err(OE_DB, ENOENT, "mandatory type object is not found");
+            return -1;
+        }
+    }
+    *ysp = ys;
+    *ytypep = ytype;
+    return 0;
+}
+
 /*! Get type information about a leaf/leaf-list yang-statement
  *
  * @code
@@ -1475,7 +2093,6 @@ yang_type_get(yang_stmt    *ys,
 {
     int        retval = -1;
     yang_stmt *ytype;        /* type */
-    yang_stmt *yorig;
     char      *type = NULL;
 
     if (yrestype == NULL){
@@ -1484,23 +2101,8 @@ yang_type_get(yang_stmt    *ys,
     }
     if (options)
         *options = 0x0;
-    /* Use original tree to resolve types */
-    if ((ytype = yang_find(ys, Y_TYPE, NULL)) == NULL){
-        clixon_err(OE_DB, ENOENT, "mandatory type object is not found");
+    if (yang_type_stmt(&ys, &ytype) < 0)
         goto done;
-    }
-    if ((yorig = yang_orig_get(ys)) != NULL && yang_flag_get(ytype, YANG_FLAG_REFINE) == 0){
-        ys = yorig;
-        if ((ytype = yang_find(ys, Y_TYPE, NULL)) == NULL){
-            clixon_err(OE_DB, ENOENT, "mandatory type object is not found");
-            goto done;
-        }
-    }
-    /* Find mandatory type */
-    if ((ytype = yang_find(ys, Y_TYPE, NULL)) == NULL){
-        clixon_err(OE_DB, ENOENT, "mandatory type object is not found");
-        goto done;
-    }
     /* XXX: here we seem to have some problems if type is union */
     if (nodeid_split(yang_argument_get(ytype), NULL, &type) < 0)
         goto done;
@@ -0,0 +1,803 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * In-process microbenchmarks of libclixon hot paths
+ *
+ * Each benchmark is run on a list of N shuffled entries for each size given with -n.
+ * Per run, an untimed setup prepares the input, the operation is timed, and an untimed
+ * teardown frees the result, so that only the library call itself is measured.
+ * Results are written to stdout as one JSON object per line and size:
+ *   {"name":"xml_parse","entries":1000,"iterations":10,"ops":1000,"min_us":..,...}
+ * Lookup benchmarks make BENCH_LOOKUPS lookups per run, other benchmarks one operation per
+ * entry. ns_per_op is the minimum time divided by ops. maxrss_kb is the peak resident set
+ * size of the process after the benchmark, see test/perf_regress.sh.
+ * Usage: make bench, or clixon_bench -n 1000,100000 -r 5 -b xpath
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <syslog.h>
+#include <sys/resource.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+/* Command line options to be passed to getopt(3) */
+#define BENCH_OPTS "hD:n:r:b:s:"
+
+/* Default list sizes and number of timed runs per benchmark and size */
+#define BENCH_SIZES      "1000,10000,100000"
+#define BENCH_ITERATIONS 10
+
+/* Number of key lookups per run of lookup benchmarks */
+#define BENCH_LOOKUPS    100
+
+/* Benchmark datastore */
+#define BENCH_DB         "bench"
+
+#define BENCH_NS         "urn:example:bench"
+
+static const char *bench_yang =
+    "module bench{"
+    "  yang-version 1.1;"
+    "  namespace \"" BENCH_NS "\";"
+    "  prefix b;"
+    "  container top{"
+    "    list entry{"
+    "      key name;"
+    "      leaf name{ type string; }"
+    "      leaf value{ type uint32; }"
+    "      leaf descr{ type string; }"
+    "    }"
+    "  }"
+    "}";
+
+/* NACM rules: user bench may read entries, anything else is denied */
+static const char *bench_nacm =
+    "<nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\">"
+    "<enable-nacm>true</enable-nacm>"
+    "<read-default>deny</read-default>"
+    "<write-default>deny</write-default>"
+    "<exec-default>permit</exec-default>"
+    "<groups><group><name>bench</name><user-name>bench</user-name></group></groups>"
+    "<rule-list><name>bench</name><group>bench</group>"
+    "<rule><name>entries</name><module-name>bench</module-name>"
+    "<path xmlns:b=\"" BENCH_NS "\">/b:top/b:entry</path>"
+    "<access-operations>read</access-operations><action>permit</action></rule>"
+    "</rule-list>"
+    "</nacm>";
+
+/*
+ * Local types
+ */
+/* Dataset of one size and per-run state shared by all benchmarks */
+struct bench_data {
+    clixon_handle bd_h;
+    yang_stmt    *bd_yspec;
+    uint32_t      bd_n;        /* Number of list entries */
+    uint32_t     *bd_perm;     /* Shuffled entry numbers */
+    char         *bd_xmlstr;   /* Entries as XML string in shuffled order */
+    char         *bd_jsonstr;  /* Entries as JSON string */
+    cxobj        *bd_xt;       /* Bound and sorted tree */
+    cxobj        *bd_x1;       /* Copy of bd_xt with every tenth value changed */
+    cxobj        *bd_xnacm;    /* NACM rules */
+    cvec         *bd_nsc;      /* Namespace context of xpath lookups */
+    cvec        **bd_keys;     /* Key vectors of lookups */
+    cbuf         *bd_cb;       /* Output buffer */
+    /* Per run */
+    cxobj        *bd_xw;       /* Work tree */
+    cxobj       **bd_xv;       /* Detached entries to insert */
+    cxobj       **bd_vec;      /* Result vectors */
+    cxobj       **bd_vec1;
+    cxobj       **bd_vec2;
+    cxobj       **bd_vec3;
+};
+
+typedef int (bench_fn)(struct bench_data *bd);
+
+/* Benchmark of one operation with untimed setup and teardown of each run */
+struct bench {
+    const char *be_name;
+    bench_fn   *be_setup;    /* Untimed, may be NULL */
+    bench_fn   *be_run;      /* Timed */
+    bench_fn   *be_teardown; /* Untimed, may be NULL */
+    int         be_lookups;  /* Set if run makes BENCH_LOOKUPS operations, else bd_n */
+};
+
+/*! Parse the XML string without YANG into work tree
+ */
+static int
+bench_parse_unbound(struct bench_data *bd)
+{
+    if (clixon_xml_parse_string(bd->bd_xmlstr, YB_NONE, NULL, &bd->bd_xw, NULL) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Parse the XML string without YANG and bind it, leaving it unsorted
+ */
+static int
+bench_parse_bound(struct bench_data *bd)
+{
+    cxobj *xerr = NULL;
+    int    ret;
+
+    if (bench_parse_unbound(bd) < 0)
+        return -1;
+    if ((ret = xml_bind_yang(bd->bd_h, bd->bd_xw, YB_MODULE, bd->bd_yspec, 0, &xerr)) < 0)
+        return -1;
+    if (xerr)
+        xml_free(xerr);
+    if (ret == 0){
+        clixon_err(OE_YANG, 0, "bench data does not bind");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Free work tree and result vectors
+ */
+static int
+bench_free(struct bench_data *bd)
+{
+    if (bd->bd_xw){
+        xml_free(bd->bd_xw);
+        bd->bd_xw = NULL;
+    }
+    if (bd->bd_xv){
+        free(bd->bd_xv);
+        bd->bd_xv = NULL;
+    }
+    if (bd->bd_vec){
+        free(bd->bd_vec);
+        bd->bd_vec = NULL;
+    }
+    if (bd->bd_vec1){
+        free(bd->bd_vec1);
+        bd->bd_vec1 = NULL;
+    }
+    if (bd->bd_vec2){
+        free(bd->bd_vec2);
+        bd->bd_vec2 = NULL;
+    }
+    if (bd->bd_vec3){
+        free(bd->bd_vec3);
+        bd->bd_vec3 = NULL;
+    }
+    return 0;
+}
+
+static int
+bench_xml_parse(struct bench_data *bd)
+{
+    return bench_parse_unbound(bd);
+}
+
+static int
+bench_xml_serialize(struct bench_data *bd)
+{
+    cbuf_reset(bd->bd_cb);
+    return clixon_xml2cbuf(bd->bd_cb, bd->bd_xt, 0, 0, NULL, -1, 1);
+}
+
+static int
+bench_json_parse(struct bench_data *bd)
+{
+    cxobj *xerr = NULL;
+    int    ret;
+
+    if ((ret = clixon_json_parse_string(bd->bd_h, bd->bd_jsonstr, 1, YB_MODULE, bd->bd_yspec,
+                                        &bd->bd_xw, &xerr)) < 0)
+        return -1;
+    if (xerr)
+        xml_free(xerr);
+    return ret == 1 ? 0 : -1;
+}
+
+static int
+bench_json_serialize(struct bench_data *bd)
+{
+    cbuf_reset(bd->bd_cb);
+    return clixon_json2cbuf(bd->bd_cb, bd->bd_xt, 0, 1, 0, 0);
+}
+
+static int
+bench_xml_bind_yang(struct bench_data *bd)
+{
+    cxobj *xerr = NULL;
+    int    ret;
+
+    if ((ret = xml_bind_yang(bd->bd_h, bd->bd_xw, YB_MODULE, bd->bd_yspec, 0, &xerr)) < 0)
+        return -1;
+    if (xerr)
+        xml_free(xerr);
+    return ret == 1 ? 0 : -1;
+}
+
+static int
+bench_xml_sort_recurse(struct bench_data *bd)
+{
+    return xml_sort_recurse(bd->bd_xw);
+}
+
+/*! Copy sorted tree and detach its entries in shuffled order
+ */
+static int
+bench_insert_setup(struct bench_data *bd)
+{
+    cxobj   *xtop;
+    cxobj   *x;
+    cxobj  **xs;
+    uint32_t i = 0;
+
+    if ((bd->bd_xw = xml_dup(bd->bd_xt)) == NULL)
+        return -1;
+    if ((xtop = xml_find_type(bd->bd_xw, NULL, "top", CX_ELMNT)) == NULL){
+        clixon_err(OE_XML, ENOENT, "top not found");
+        return -1;
+    }
+    if ((xs = calloc(bd->bd_n, sizeof(cxobj *))) == NULL ||
+        (bd->bd_xv = calloc(bd->bd_n, sizeof(cxobj *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        if (xs)
+            free(xs);
+        return -1;
+    }
+    x = NULL;
+    while ((x = xml_child_each(xtop, x, CX_ELMNT)) != NULL && i < bd->bd_n)
+        xs[i++] = x;
+    for (i = 0; i < bd->bd_n; i++){
+        bd->bd_xv[i] = xs[bd->bd_perm[i]];
+        if (xml_rm(bd->bd_xv[i]) < 0){
+            free(xs);
+            return -1;
+        }
+    }
+    free(xs);
+    return 0;
+}
+
+static int
+bench_xml_insert(struct bench_data *bd)
+{
+    cxobj   *xtop;
+    uint32_t i;
+
+    xtop = xml_find_type(bd->bd_xw, NULL, "top", CX_ELMNT);
+    for (i = 0; i < bd->bd_n; i++)
+        if (xml_insert(xtop, bd->bd_xv[i], INS_LAST, NULL, NULL) < 0)
+            return -1;
+    return 0;
+}
+
+static int
+bench_xml_find_index(struct bench_data *bd)
+{
+    int          retval = -1;
+    cxobj       *xtop;
+    yang_stmt   *ytop;
+    clixon_xvec *xvec = NULL;
+    int          i;
+
+    xtop = xml_find_type(bd->bd_xt, NULL, "top", CX_ELMNT);
+    ytop = xml_spec(xtop);
+    for (i = 0; i < BENCH_LOOKUPS; i++){
+        if ((xvec = clixon_xvec_new()) == NULL)
+            goto done;
+        if (clixon_xml_find_index(xtop, ytop, BENCH_NS, "entry", bd->bd_keys[i], xvec) < 0)
+            goto done;
+        if (clixon_xvec_len(xvec) != 1){
+            clixon_err(OE_XML, ENOENT, "entry not found");
+            goto done;
+        }
+        clixon_xvec_free(xvec);
+        xvec = NULL;
+    }
+    retval = 0;
+ done:
+    if (xvec)
+        clixon_xvec_free(xvec);
+    return retval;
+}
+
+/*! Xpath lookups of entries by key
+ */
+static int
+bench_xpath(struct bench_data *bd)
+{
+    cxobj **vec = NULL;
+    size_t  veclen;
+    int     i;
+
+    for (i = 0; i < BENCH_LOOKUPS; i++){
+        if (xpath_vec(bd->bd_xt, bd->bd_nsc, "/b:top/b:entry[b:name='%s']", &vec, &veclen,
+                      cv_string_get(cvec_i(bd->bd_keys[i], 0))) < 0)
+            return -1;
+        if (vec)
+            free(vec);
+        vec = NULL;
+        if (veclen != 1){
+            clixon_err(OE_XML, ENOENT, "entry not found");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int
+bench_xpath_optimized(struct bench_data *bd)
+{
+    xpath_list_optimize_set(1);
+    return bench_xpath(bd);
+}
+
+static int
+bench_xpath_unoptimized(struct bench_data *bd)
+{
+    int ret;
+
+    xpath_list_optimize_set(0);
+    ret = bench_xpath(bd);
+    xpath_list_optimize_set(1);
+    return ret;
+}
+
+static int
+bench_xml_diff(struct bench_data *bd)
+{
+    int firstlen;
+    int secondlen;
+    int changedlen;
+
+    return xml_diff(bd->bd_xt, bd->bd_x1,
+                    &bd->bd_vec, &firstlen,
+                    &bd->bd_vec1, &secondlen,
+                    &bd->bd_vec2, &bd->bd_vec3, &changedlen);
+}
+
+static int
+bench_xml_yang_validate_all(struct bench_data *bd)
+{
+    int ret;
+
+    if ((ret = xml_yang_validate_all(bd->bd_h, bd->bd_xt, &bd->bd_xw)) < 0)
+        return -1;
+    return ret == 1 ? 0 : -1;
+}
+
+/*! Clear volatile datastore and copy tree as modification tree
+ */
+static int
+bench_xmldb_put_setup(struct bench_data *bd)
+{
+    if (xmldb_clear(bd->bd_h, BENCH_DB) < 0)
+        return -1;
+    if ((bd->bd_xw = xml_dup(bd->bd_xt)) == NULL)
+        return -1;
+    if (xml_name_set(bd->bd_xw, NETCONF_INPUT_CONFIG) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Merge into empty datastore, measures text_modify
+ */
+static int
+bench_xmldb_put(struct bench_data *bd)
+{
+    int ret;
+
+    cbuf_reset(bd->bd_cb);
+    if ((ret = xmldb_put(bd->bd_h, BENCH_DB, OP_MERGE, bd->bd_xw, NULL, bd->bd_cb)) < 0)
+        return -1;
+    if (ret == 0){
+        clixon_err(OE_DB, 0, "xmldb_put: %s", cbuf_get(bd->bd_cb));
+        return -1;
+    }
+    return 0;
+}
+
+static int
+bench_nacm_read(struct bench_data *bd)
+{
+    return nacm_datanode_read1(bd->bd_h, bd->bd_xt, "bench", bd->bd_xnacm);
+}
+
+static struct bench benchmarks[] = {
+    {"xml_parse",             NULL,                 bench_xml_parse,             bench_free, 0},
+    {"xml_serialize",         NULL,                 bench_xml_serialize,         NULL,       0},
+    {"json_parse",            NULL,                 bench_json_parse,            bench_free, 0},
+    {"json_serialize",        NULL,                 bench_json_serialize,        NULL,       0},
+    {"xml_bind_yang",         bench_parse_unbound,  bench_xml_bind_yang,         bench_free, 0},
+    {"xml_sort_recurse",      bench_parse_bound,    bench_xml_sort_recurse,      bench_free, 0},
+    {"xml_insert",            bench_insert_setup,   bench_xml_insert,            bench_free, 0},
+    {"clixon_xml_find_index", NULL,                 bench_xml_find_index,        NULL,       1},
+    {"xpath_vec_optimized",   NULL,                 bench_xpath_optimized,       NULL,       1},
+    {"xpath_vec_unoptimized", NULL,                 bench_xpath_unoptimized,     NULL,       1},
+    {"xml_diff",              NULL,                 bench_xml_diff,              bench_free, 0},
+    {"xml_yang_validate_all", NULL,                 bench_xml_yang_validate_all, bench_free, 0},
+    {"xmldb_put",             bench_xmldb_put_setup, bench_xmldb_put,            bench_free, 0},
+    {"nacm_datanode_read",    NULL,                 bench_nacm_read,             NULL,       0},
+    {NULL,                    NULL,                 NULL,                        NULL,       0}
+};
+
+/*! Monotonic time in ns
+ */
+static uint64_t
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*! Run one benchmark iterations times and print result as a JSON line
+ *
+ * @param[in]  be         Benchmark
+ * @param[in]  bd         Dataset
+ * @param[in]  iterations Number of timed runs
+ * @retval     0          OK
+ * @retval    -1          Error
+ */
+static int
+bench_run(struct bench      *be,
+          struct bench_data *bd,
+          int                iterations)
+{
+    uint64_t t0;
+    uint64_t t;
+    uint64_t tmin = UINT64_MAX;
+    uint64_t tmax = 0;
+    uint64_t tsum = 0;
+    uint32_t ops;
+    int      i;
+    struct rusage ru = {0,};
+
+    for (i = 0; i < iterations; i++){
+        if (be->be_setup && be->be_setup(bd) < 0)
+            return -1;
+        t0 = bench_now();
+        if (be->be_run(bd) < 0)
+            return -1;
+        t = bench_now() - t0;
+        if (be->be_teardown && be->be_teardown(bd) < 0)
+            return -1;
+        if (t < tmin)
+            tmin = t;
+        if (t > tmax)
+            tmax = t;
+        tsum += t;
+    }
+    ops = be->be_lookups ? BENCH_LOOKUPS : bd->bd_n;
+    getrusage(RUSAGE_SELF, &ru);
+    fprintf(stdout, "{\"name\":\"%s\",\"entries\":%u,\"iterations\":%d,\"ops\":%u,"
+            "\"min_us\":%.1f,\"mean_us\":%.1f,\"max_us\":%.1f,\"ns_per_op\":%.1f,"
+            "\"maxrss_kb\":%ld}\n",
+            be->be_name, bd->bd_n, iterations, ops,
+            tmin / 1000.0, tsum / 1000.0 / iterations, tmax / 1000.0,
+            (double)tmin / ops, ru.ru_maxrss);
+    fflush(stdout);
+    return 0;
+}
+
+/*! Create dataset of n entries in shuffled order
+ *
+ * @param[in]  bd  Dataset with handle and yspec set
+ * @param[in]  n   Number of list entries
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+bench_data_init(struct bench_data *bd,
+                uint32_t           n)
+{
+    int      retval = -1;
+    cbuf    *cb = NULL;
+    cxobj   *xerr = NULL;
+    cxobj   *x;
+    uint32_t i;
+    uint32_t j;
+    uint32_t k;
+    int      ret;
+
+    bd->bd_n = n;
+    if ((bd->bd_perm = calloc(n, sizeof(uint32_t))) == NULL ||
+        (bd->bd_keys = calloc(BENCH_LOOKUPS, sizeof(cvec *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i = 0; i < n; i++)
+        bd->bd_perm[i] = i;
+    for (i = n - 1; i > 0; i--){ /* Fisher-Yates */
+        j = random() % (i + 1);
+        k = bd->bd_perm[i];
+        bd->bd_perm[i] = bd->bd_perm[j];
+        bd->bd_perm[j] = k;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<top xmlns=\"%s\">", BENCH_NS);
+    for (i = 0; i < n; i++)
+        cprintf(cb, "<entry><name>e%08u</name><value>%u</value><descr>entry %u</descr></entry>",
+                bd->bd_perm[i], bd->bd_perm[i], bd->bd_perm[i]);
+    cprintf(cb, "</top>");
+    if ((bd->bd_xmlstr = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((ret = clixon_xml_parse_string(bd->bd_xmlstr, YB_MODULE, bd->bd_yspec, &bd->bd_xt, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_YANG, 0, "bench data does not bind");
+        goto done;
+    }
+    if (xml_sort_recurse(bd->bd_xt) < 0)
+        goto done;
+    cbuf_reset(cb);
+    if (clixon_json2cbuf(cb, bd->bd_xt, 0, 1, 0, 0) < 0)
+        goto done;
+    if ((bd->bd_jsonstr = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    /* Every tenth value changed */
+    if ((bd->bd_x1 = xml_dup(bd->bd_xt)) == NULL)
+        goto done;
+    x = NULL;
+    i = 0;
+    while ((x = xml_child_each(xml_find_type(bd->bd_x1, NULL, "top", CX_ELMNT), x, CX_ELMNT)) != NULL)
+        if (i++ % 10 == 0 &&
+            xml_value_set(xml_body_get(xml_find_type(x, NULL, "value", CX_ELMNT)), "0") < 0)
+            goto done;
+    /* Lookup keys */
+    for (i = 0; i < BENCH_LOOKUPS; i++){
+        cbuf_reset(cb);
+        cprintf(cb, "e%08u", bd->bd_perm[i % n]);
+        if ((bd->bd_keys[i] = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        if (cvec_add_string(bd->bd_keys[i], "name", cbuf_get(cb)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Free dataset
+ */
+static int
+bench_data_free(struct bench_data *bd)
+{
+    int i;
+
+    bench_free(bd);
+    if (bd->bd_perm)
+        free(bd->bd_perm);
+    if (bd->bd_xmlstr)
+        free(bd->bd_xmlstr);
+    if (bd->bd_jsonstr)
+        free(bd->bd_jsonstr);
+    if (bd->bd_xt)
+        xml_free(bd->bd_xt);
+    if (bd->bd_x1)
+        xml_free(bd->bd_x1);
+    if (bd->bd_keys){
+        for (i = 0; i < BENCH_LOOKUPS; i++)
+            if (bd->bd_keys[i])
+                cvec_free(bd->bd_keys[i]);
+        free(bd->bd_keys);
+    }
+    bd->bd_perm = NULL;
+    bd->bd_xmlstr = NULL;
+    bd->bd_jsonstr = NULL;
+    bd->bd_xt = NULL;
+    bd->bd_x1 = NULL;
+    bd->bd_keys = NULL;
+    return 0;
+}
+
+/*! Load benchmark YANG and NACM rules, and create volatile benchmark datastore
+ */
+static int
+bench_init(clixon_handle      h,
+           struct bench_data *bd,
+           char              *dbdir)
+{
+    if (clicon_option_str_set(h, "CLICON_XMLDB_DIR", dbdir) < 0 ||
+        clicon_option_str_set(h, "CLICON_XMLDB_FORMAT", "xml") < 0 ||
+        clicon_option_str_set(h, "CLICON_XMLDB_SORT_THREADS", "1") < 0)
+        return -1;
+    if ((bd->bd_yspec = yspec_new1(h, YANG_DOMAIN_TOP, YANG_DATA_TOP)) == NULL)
+        return -1;
+    if (yang_parse_str(bench_yang, "bench", bd->bd_yspec) == NULL)
+        return -1;
+    if (yang_parse_post(h, bd->bd_yspec, 0) < 0)
+        return -1;
+    if (clixon_xml_parse_string(bench_nacm, YB_NONE, NULL, &bd->bd_xnacm, NULL) < 0)
+        return -1;
+    if ((bd->bd_xnacm = xml_find_type(bd->bd_xnacm, NULL, "nacm", CX_ELMNT)) == NULL){
+        clixon_err(OE_XML, ENOENT, "nacm not found");
+        return -1;
+    }
+    if ((bd->bd_nsc = xml_nsctx_init("b", BENCH_NS)) == NULL)
+        return -1;
+    if ((bd->bd_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        return -1;
+    }
+    bd->bd_h = h;
+    if (xmldb_connect(h) < 0)
+        return -1;
+    if (xmldb_create(h, BENCH_DB) < 0)
+        return -1;
+    if (xmldb_volatile_set(h, BENCH_DB, 1) < 0)
+        return -1;
+    return 0;
+}
+
+static void
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+            "where options are\n"
+            "\t-h \t\tHelp\n"
+            "\t-D <level>\tDebug level\n"
+            "\t-n <n>[,<n>]*\tNumber of list entries, default %s\n"
+            "\t-r <nr>\tTimed runs per benchmark and size, default %d\n"
+            "\t-b <name>\tOnly run benchmarks whose name contains <name>\n"
+            "\t-s <seed>\tRandom seed of entry order\n",
+            argv0,
+            BENCH_SIZES,
+            BENCH_ITERATIONS);
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int               retval = -1;
+    clixon_handle     h;
+    struct bench_data bd = {0,};
+    struct bench     *be;
+    char             *sizes = BENCH_SIZES;
+    char             *filter = NULL;
+    int               iterations = BENCH_ITERATIONS;
+    unsigned int      seed = 42;
+    char              dbdir[] = "/tmp/clixon_bench.XXXXXX";
+    int               dbdir_created = 0;
+    char             *s;
+    char             *next;
+    uint32_t          n;
+    int               dbg = 0;
+    int               c;
+
+    if ((h = clixon_handle_init()) == NULL)
+        return -1;
+    clixon_log_init(h, __PROGRAM__, LOG_INFO, CLIXON_LOG_STDERR);
+    clixon_err_init(h);
+    while ((c = getopt(argc, argv, BENCH_OPTS)) != -1)
+        switch (c) {
+        case 'h':
+            usage(argv[0]);
+            break;
+        case 'D':
+            if (sscanf(optarg, "%d", &dbg) != 1)
+                usage(argv[0]);
+            break;
+        case 'n':
+            sizes = optarg;
+            break;
+        case 'r':
+            if ((iterations = atoi(optarg)) <= 0)
+                usage(argv[0]);
+            break;
+        case 'b':
+            filter = optarg;
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+            break;
+        }
+    clixon_debug_init(h, dbg);
+    srandom(seed);
+    if (mkdtemp(dbdir) == NULL){
+        clixon_err(OE_UNIX, errno, "mkdtemp");
+        goto done;
+    }
+    dbdir_created++;
+    if (bench_init(h, &bd, dbdir) < 0)
+        goto done;
+    for (s = sizes; s != NULL; s = next){
+        if ((next = strchr(s, ',')) != NULL)
+            *next++ = '\0';
+        if ((n = strtoul(s, NULL, 10)) == 0)
+            continue;
+        if (bench_data_init(&bd, n) < 0)
+            goto done;
+        for (be = benchmarks; be->be_name != NULL; be++){
+            if (filter && strstr(be->be_name, filter) == NULL)
+                continue;
+            if (bench_run(be, &bd, iterations) < 0)
+                goto done;
+        }
+        bench_data_free(&bd);
+    }
+    retval = 0;
+ done:
+    if (retval < 0)
+        clixon_log(h, LOG_ERR, "%s: benchmark failed", __PROGRAM__);
+    bench_data_free(&bd);
+    if (dbdir_created){
+        xmldb_delete(h, BENCH_DB);
+        rmdir(dbdir);
+    }
+    xmldb_disconnect(h);
+    if (bd.bd_xnacm)
+        xml_free(xml_root(bd.bd_xnacm));
+    if (bd.bd_nsc)
+        xml_nsctx_free(bd.bd_nsc);
+    if (bd.bd_cb)
+        cbuf_free(bd.bd_cb);
+    clixon_handle_exit(h);
+    clixon_err_exit();
+    clixon_log_exit();
+    return retval < 0 ? 1 : 0;
+}
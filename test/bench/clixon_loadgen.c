@@ -0,0 +1,725 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * End-to-end load generator of concurrent RESTCONF and NETCONF clients
+ *
+ * Runs -r RESTCONF connections using curl multi over HTTP/1.1 or HTTP/2, and -N NETCONF
+ * sessions as clixon_netconf child processes, in one poll loop. Each client has one
+ * outstanding request at a time and issues the next as soon as the reply is received, for
+ * -t seconds. Requests are drawn with the ratios of -m from:
+ *   get    Read one random list entry
+ *   patch  Merge -s random list entries
+ *   commit Commit candidate (NETCONF), RESTCONF commits each patch and counts it as patch
+ * Data is the list of the scaling YANG of doc/scaling/large-lists.md with keys 0..-n:
+ *   module scaling{ namespace "urn:example:clixon"; container x{ list y{ key a; leaf a..; leaf b..}}}
+ * The list is expected to be populated before the run, missing entries are counted as errors.
+ * Results are written to stdout as one JSON object per line and operation, with
+ * number of requests, errors, requests per second and latency percentiles in ms.
+ * The random seed makes the sequence of requests of each client reproducible.
+ * Example:
+ *   clixon_loadgen -u http://localhost -H 2 -r 16 -N 4 -e "clixon_netconf -f /usr/local/etc/example.xml"
+ * NETCONF sessions exchange hello with base:1.0 and use end-of-message framing, the session
+ * command should therefore not use -q, -0 or -1.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <signal.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <curl/curl.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+/* Command line options to be passed to getopt(3) */
+#define LOADGEN_OPTS "hD:u:H:r:N:e:t:n:s:m:S:kM"
+
+/* NETCONF 1.0 end-of-message, sessions only announce base:1.0 */
+#define LOADGEN_EOM  "]]>]]>"
+
+#define LOADGEN_NS   "urn:example:clixon"
+
+/*
+ * Local types
+ */
+enum loadgen_op {
+    LG_GET = 0,
+    LG_PATCH,
+    LG_COMMIT,
+    LG_NOPS
+};
+
+static const char *loadgen_opname[LG_NOPS] = {"get", "patch", "commit"};
+
+/* Latency samples in us of one operation */
+struct loadgen_stats {
+    uint32_t *ls_vec;
+    size_t    ls_len;
+    size_t    ls_max;
+    uint32_t  ls_errors;
+};
+
+/* Run parameters */
+struct loadgen {
+    char                 *lg_url;      /* RESTCONF base url, eg http://localhost */
+    int                   lg_http2;    /* Use HTTP/2 */
+    int                   lg_mplex;    /* Multiplex HTTP/2 streams over connections */
+    int                   lg_insecure; /* Do not verify server certificate */
+    char                 *lg_ncmd;     /* NETCONF session command */
+    uint32_t              lg_entries;  /* List keys 0..entries-1 */
+    uint32_t              lg_psize;    /* Entries per patch */
+    int                   lg_ratio[LG_NOPS]; /* Operation weights */
+    int                   lg_rsum;
+    uint64_t              lg_end;      /* End time ns */
+    CURLM                *lg_multi;
+    struct loadgen_stats  lg_stats[LG_NOPS];
+};
+
+/* One RESTCONF connection or NETCONF session */
+struct loadgen_client {
+    struct loadgen *lc_lg;
+    unsigned int    lc_seed;     /* rand_r state */
+    enum loadgen_op lc_op;       /* Outstanding operation */
+    uint64_t        lc_start;    /* Start time of outstanding request in ns */
+    cbuf           *lc_req;      /* Request body */
+    /* RESTCONF */
+    CURL           *lc_curl;
+    struct curl_slist *lc_hdrs;
+    char            lc_err[CURL_ERROR_SIZE];
+    /* NETCONF */
+    pid_t           lc_pid;
+    int             lc_wfd;
+    int             lc_rfd;
+    cbuf           *lc_rbuf;     /* Received, up to end-of-message */
+    int             lc_hello;    /* Server hello received */
+    uint32_t        lc_msgid;
+    int             lc_done;
+};
+
+/*! Monotonic time in ns
+ */
+static uint64_t
+loadgen_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*! Record latency of completed request
+ */
+static int
+loadgen_record(struct loadgen  *lg,
+               enum loadgen_op  op,
+               uint64_t         start,
+               int              error)
+{
+    struct loadgen_stats *ls = &lg->lg_stats[op];
+
+    if (error){
+        ls->ls_errors++;
+        return 0;
+    }
+    if (ls->ls_len == ls->ls_max){
+        ls->ls_max = ls->ls_max ? 2 * ls->ls_max : 1024;
+        if ((ls->ls_vec = realloc(ls->ls_vec, ls->ls_max * sizeof(uint32_t))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+    }
+    ls->ls_vec[ls->ls_len++] = (loadgen_now() - start) / 1000;
+    return 0;
+}
+
+/*! Draw next operation using the weights of -m
+ */
+static enum loadgen_op
+loadgen_draw(struct loadgen_client *lc)
+{
+    struct loadgen *lg = lc->lc_lg;
+    int             r;
+    int             i;
+
+    r = rand_r(&lc->lc_seed) % lg->lg_rsum;
+    for (i = 0; i < LG_NOPS - 1; i++){
+        if (r < lg->lg_ratio[i])
+            break;
+        r -= lg->lg_ratio[i];
+    }
+    return i;
+}
+
+/*! Discard reply body, only status is checked
+ */
+static size_t
+restconf_write_cb(void  *ptr,
+                  size_t size,
+                  size_t nmemb,
+                  void  *userdata)
+{
+    return size * nmemb;
+}
+
+/*! Start next RESTCONF request of connection
+ *
+ * Commit is implicit in RESTCONF, a commit draw is sent as a patch
+ */
+static int
+restconf_next(struct loadgen_client *lc)
+{
+    struct loadgen *lg = lc->lc_lg;
+    cbuf           *cb = NULL;
+    uint32_t        i;
+    uint32_t        k;
+
+    if (loadgen_now() >= lg->lg_end){
+        lc->lc_done++;
+        return 0;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        return -1;
+    }
+    if ((lc->lc_op = loadgen_draw(lc)) == LG_COMMIT)
+        lc->lc_op = LG_PATCH;
+    cbuf_reset(lc->lc_req);
+    curl_easy_reset(lc->lc_curl);
+    if (lc->lc_op == LG_GET){
+        cprintf(cb, "%s/restconf/data/scaling:x/y=%u", lg->lg_url,
+                rand_r(&lc->lc_seed) % lg->lg_entries);
+        curl_easy_setopt(lc->lc_curl, CURLOPT_HTTPGET, 1L);
+    }
+    else {
+        cprintf(cb, "%s/restconf/data/scaling:x", lg->lg_url);
+        cprintf(lc->lc_req, "{\"scaling:x\":{\"y\":[");
+        for (i = 0; i < lg->lg_psize; i++){
+            k = rand_r(&lc->lc_seed) % lg->lg_entries;
+            cprintf(lc->lc_req, "%s{\"a\":%u,\"b\":%u}", i ? "," : "", k, rand_r(&lc->lc_seed) % 1000);
+        }
+        cprintf(lc->lc_req, "]}}");
+        curl_easy_setopt(lc->lc_curl, CURLOPT_CUSTOMREQUEST, "PATCH");
+        curl_easy_setopt(lc->lc_curl, CURLOPT_POSTFIELDS, cbuf_get(lc->lc_req));
+        curl_easy_setopt(lc->lc_curl, CURLOPT_POSTFIELDSIZE, (long)cbuf_len(lc->lc_req));
+    }
+    curl_easy_setopt(lc->lc_curl, CURLOPT_URL, cbuf_get(cb));
+    curl_easy_setopt(lc->lc_curl, CURLOPT_HTTPHEADER, lc->lc_hdrs);
+    curl_easy_setopt(lc->lc_curl, CURLOPT_HTTP_VERSION,
+                     lg->lg_http2 ?
+                     (strncmp(lg->lg_url, "https", 5) == 0 ?
+                      CURL_HTTP_VERSION_2TLS : CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE) :
+                     CURL_HTTP_VERSION_1_1);
+    curl_easy_setopt(lc->lc_curl, CURLOPT_WRITEFUNCTION, restconf_write_cb);
+    curl_easy_setopt(lc->lc_curl, CURLOPT_ERRORBUFFER, lc->lc_err);
+    curl_easy_setopt(lc->lc_curl, CURLOPT_PRIVATE, lc);
+    if (lg->lg_insecure){
+        curl_easy_setopt(lc->lc_curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(lc->lc_curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    }
+    cbuf_free(cb);
+    lc->lc_start = loadgen_now();
+    if (curl_multi_add_handle(lg->lg_multi, lc->lc_curl) != CURLM_OK){
+        clixon_err(OE_UNIX, 0, "curl_multi_add_handle");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Reap completed RESTCONF transfers and start next request of each
+ */
+static int
+restconf_done(struct loadgen *lg)
+{
+    CURLMsg               *msg;
+    int                    nmsg;
+    struct loadgen_client *lc;
+    long                   code = 0;
+    int                    error;
+
+    while ((msg = curl_multi_info_read(lg->lg_multi, &nmsg)) != NULL){
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&lc);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &code);
+        error = msg->data.result != CURLE_OK || code < 200 || code >= 300;
+        if (error)
+            clixon_debug(CLIXON_DBG_DEFAULT, "%s: %s code:%ld", loadgen_opname[lc->lc_op],
+                         msg->data.result != CURLE_OK ? lc->lc_err : "", code);
+        if (loadgen_record(lg, lc->lc_op, lc->lc_start, error) < 0)
+            return -1;
+        curl_multi_remove_handle(lg->lg_multi, lc->lc_curl);
+        if (restconf_next(lc) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Write all of buffer to NETCONF session
+ */
+static int
+netconf_write(struct loadgen_client *lc,
+              cbuf                  *cb)
+{
+    char *buf = cbuf_get(cb);
+    int   len = cbuf_len(cb);
+    int   n;
+
+    while (len > 0){
+        if ((n = write(lc->lc_wfd, buf, len)) < 0){
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            clixon_err(OE_UNIX, errno, "write");
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*! Send next NETCONF rpc of session, or close-session when time is up
+ */
+static int
+netconf_next(struct loadgen_client *lc)
+{
+    struct loadgen *lg = lc->lc_lg;
+    cbuf           *cb = lc->lc_req;
+    uint32_t        i;
+
+    cbuf_reset(cb);
+    if (loadgen_now() >= lg->lg_end){
+        cprintf(cb, "<rpc xmlns=\"%s\" message-id=\"%u\"><close-session/></rpc>%s",
+                NETCONF_BASE_NAMESPACE, ++lc->lc_msgid, LOADGEN_EOM);
+        lc->lc_done++;
+        return netconf_write(lc, cb);
+    }
+    lc->lc_op = loadgen_draw(lc);
+    cprintf(cb, "<rpc xmlns=\"%s\" message-id=\"%u\">", NETCONF_BASE_NAMESPACE, ++lc->lc_msgid);
+    switch (lc->lc_op){
+    case LG_GET:
+        cprintf(cb, "<get-config><source><running/></source>"
+                "<filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='%u']\" xmlns:ex=\"%s\"/>"
+                "</get-config>",
+                rand_r(&lc->lc_seed) % lg->lg_entries, LOADGEN_NS);
+        break;
+    case LG_PATCH:
+        cprintf(cb, "<edit-config><target><candidate/></target><config><x xmlns=\"%s\">", LOADGEN_NS);
+        for (i = 0; i < lg->lg_psize; i++)
+            cprintf(cb, "<y><a>%u</a><b>%u</b></y>",
+                    rand_r(&lc->lc_seed) % lg->lg_entries, rand_r(&lc->lc_seed) % 1000);
+        cprintf(cb, "</x></config></edit-config>");
+        break;
+    default:
+        cprintf(cb, "<commit/>");
+        break;
+    }
+    cprintf(cb, "</rpc>%s", LOADGEN_EOM);
+    lc->lc_start = loadgen_now();
+    return netconf_write(lc, cb);
+}
+
+/*! Read from NETCONF session, on complete reply record it and send next rpc
+ */
+static int
+netconf_input(struct loadgen_client *lc)
+{
+    char  buf[BUFSIZ];
+    char *str;
+    char *eom;
+    int   n;
+    int   error;
+
+    if ((n = read(lc->lc_rfd, buf, sizeof(buf)-1)) < 0){
+        if (errno == EINTR || errno == EAGAIN)
+            return 0;
+        clixon_err(OE_UNIX, errno, "read");
+        return -1;
+    }
+    if (n == 0){
+        if (!lc->lc_done){
+            clixon_err(OE_PROTO, ESHUTDOWN, "NETCONF session closed");
+            return -1;
+        }
+        close(lc->lc_rfd);
+        lc->lc_rfd = -1;
+        return 0;
+    }
+    buf[n] = '\0';
+    cprintf(lc->lc_rbuf, "%s", buf);
+    while ((eom = strstr((str = cbuf_get(lc->lc_rbuf)), LOADGEN_EOM)) != NULL){
+        *eom = '\0';
+        if (!lc->lc_hello)
+            lc->lc_hello++;
+        else if (!lc->lc_done){
+            error = strstr(str, "<rpc-error>") != NULL;
+            if (error)
+                clixon_debug(CLIXON_DBG_DEFAULT, "%s: %s", loadgen_opname[lc->lc_op], str);
+            if (loadgen_record(lc->lc_lg, lc->lc_op, lc->lc_start, error) < 0)
+                return -1;
+        }
+        /* Keep remainder after end-of-message */
+        eom += strlen(LOADGEN_EOM);
+        memmove(str, eom, strlen(eom) + 1);
+        cbuf_trunc(lc->lc_rbuf, strlen(str));
+        if (!lc->lc_done && netconf_next(lc) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Start NETCONF session process and send hello
+ */
+static int
+netconf_start(struct loadgen_client *lc)
+{
+    int   in[2];
+    int   out[2];
+    cbuf *cb = lc->lc_req;
+
+    if (pipe(in) < 0 || pipe(out) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        return -1;
+    }
+    if ((lc->lc_pid = fork()) < 0){
+        clixon_err(OE_UNIX, errno, "fork");
+        return -1;
+    }
+    if (lc->lc_pid == 0){
+        dup2(in[0], 0);
+        dup2(out[1], 1);
+        close(in[0]); close(in[1]);
+        close(out[0]); close(out[1]);
+        execl("/bin/sh", "sh", "-c", lc->lc_lg->lg_ncmd, NULL);
+        _exit(127);
+    }
+    close(in[0]);
+    close(out[1]);
+    lc->lc_wfd = in[1];
+    lc->lc_rfd = out[0];
+    cbuf_reset(cb);
+    cprintf(cb, "<hello xmlns=\"%s\"><capabilities><capability>%s</capability></capabilities></hello>%s",
+            NETCONF_BASE_NAMESPACE, NETCONF_BASE_CAPABILITY_1_0, LOADGEN_EOM);
+    return netconf_write(lc, cb);
+}
+
+static int
+loadgen_cmp(const void *a,
+            const void *b)
+{
+    uint32_t ua = *(uint32_t*)a;
+    uint32_t ub = *(uint32_t*)b;
+
+    return ua < ub ? -1 : ua > ub;
+}
+
+/*! Print one JSON line per operation with throughput and latency percentiles in ms
+ */
+static void
+loadgen_report(struct loadgen *lg,
+               double          secs,
+               int             nrc,
+               int             nnc)
+{
+    struct loadgen_stats *ls;
+    int                   i;
+    size_t                n;
+
+    for (i = 0; i < LG_NOPS; i++){
+        ls = &lg->lg_stats[i];
+        if (ls->ls_len == 0 && ls->ls_errors == 0)
+            continue;
+        n = ls->ls_len;
+        qsort(ls->ls_vec, n, sizeof(uint32_t), loadgen_cmp);
+        fprintf(stdout, "{\"op\":\"%s\",\"restconf\":%d,\"netconf\":%d,\"http\":\"%s\","
+                "\"seconds\":%.2f,\"requests\":%zu,\"errors\":%u,\"rps\":%.1f",
+                loadgen_opname[i], nrc, nnc, lg->lg_http2 ? "2" : "1.1",
+                secs, n, ls->ls_errors, n / secs);
+        if (n)
+            fprintf(stdout, ",\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f",
+                    ls->ls_vec[n*50/100] / 1000.0,
+                    ls->ls_vec[n*90/100] / 1000.0,
+                    ls->ls_vec[n*99/100] / 1000.0,
+                    ls->ls_vec[n-1] / 1000.0);
+        fprintf(stdout, "}\n");
+    }
+    fflush(stdout);
+}
+
+static void
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+            "where options are\n"
+            "\t-h \t\tHelp\n"
+            "\t-D <level>\tDebug level\n"
+            "\t-u <url>\tRESTCONF base url, default http://localhost\n"
+            "\t-H <1|2>\tHTTP version 1.1 or 2, default 1.1\n"
+            "\t-M \t\tMultiplex HTTP/2 streams over shared connections\n"
+            "\t-k \t\tDo not verify server certificate\n"
+            "\t-r <nr>\tNumber of concurrent RESTCONF connections, default 0\n"
+            "\t-N <nr>\tNumber of concurrent NETCONF sessions, default 0\n"
+            "\t-e <cmd>\tNETCONF session command, default \"clixon_netconf\"\n"
+            "\t-t <sec>\tDuration, default 10\n"
+            "\t-n <nr>\tNumber of list entries of scaling:x/y, default 1000\n"
+            "\t-s <nr>\tList entries per patch, default 1\n"
+            "\t-m <g:p:c>\tRatio of get, patch and commit requests, default 80:15:5\n"
+            "\t-S <seed>\tRandom seed\n",
+            argv0);
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int                    retval = -1;
+    clixon_handle          h;
+    struct loadgen         lg = {0,};
+    struct loadgen_client *clients = NULL;
+    struct loadgen_client *lc;
+    struct curl_waitfd    *wfds = NULL;
+    int                    nrc = 0;
+    int                    nnc = 0;
+    int                    secs = 10;
+    unsigned int           seed = 42;
+    int                    dbg = 0;
+    int                    running;
+    int                    active;
+    uint64_t               t0;
+    int                    c;
+    int                    i;
+    int                    j;
+
+    if ((h = clixon_handle_init()) == NULL)
+        return -1;
+    clixon_log_init(h, __PROGRAM__, LOG_INFO, CLIXON_LOG_STDERR);
+    clixon_err_init(h);
+    lg.lg_url = "http://localhost";
+    lg.lg_ncmd = "clixon_netconf";
+    lg.lg_entries = 1000;
+    lg.lg_psize = 1;
+    lg.lg_ratio[LG_GET] = 80;
+    lg.lg_ratio[LG_PATCH] = 15;
+    lg.lg_ratio[LG_COMMIT] = 5;
+    while ((c = getopt(argc, argv, LOADGEN_OPTS)) != -1)
+        switch (c) {
+        case 'h':
+            usage(argv[0]);
+            break;
+        case 'D':
+            if (sscanf(optarg, "%d", &dbg) != 1)
+                usage(argv[0]);
+            break;
+        case 'u':
+            lg.lg_url = optarg;
+            break;
+        case 'H':
+            lg.lg_http2 = strcmp(optarg, "2") == 0;
+            break;
+        case 'M':
+            lg.lg_mplex++;
+            break;
+        case 'k':
+            lg.lg_insecure++;
+            break;
+        case 'r':
+            nrc = atoi(optarg);
+            break;
+        case 'N':
+            nnc = atoi(optarg);
+            break;
+        case 'e':
+            lg.lg_ncmd = optarg;
+            break;
+        case 't':
+            secs = atoi(optarg);
+            break;
+        case 'n':
+            lg.lg_entries = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            lg.lg_psize = strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            if (sscanf(optarg, "%d:%d:%d", &lg.lg_ratio[LG_GET], &lg.lg_ratio[LG_PATCH],
+                       &lg.lg_ratio[LG_COMMIT]) != 3)
+                usage(argv[0]);
+            break;
+        case 'S':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+            break;
+        }
+    clixon_debug_init(h, dbg);
+    for (i = 0; i < LG_NOPS; i++)
+        lg.lg_rsum += lg.lg_ratio[i];
+    if (nrc + nnc <= 0 || secs <= 0 || lg.lg_entries == 0 || lg.lg_psize == 0 || lg.lg_rsum <= 0)
+        usage(argv[0]);
+    /* NETCONF sessions exit when we close their stdin */
+    signal(SIGPIPE, SIG_IGN);
+    if (curl_global_init(CURL_GLOBAL_ALL) != 0){
+        clixon_err(OE_UNIX, 0, "curl_global_init");
+        goto done;
+    }
+    if ((lg.lg_multi = curl_multi_init()) == NULL){
+        clixon_err(OE_UNIX, 0, "curl_multi_init");
+        goto done;
+    }
+    /* One connection per concurrent transfer unless multiplexed */
+    curl_multi_setopt(lg.lg_multi, CURLMOPT_PIPELINING, lg.lg_mplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+    if ((clients = calloc(nrc + nnc, sizeof(*clients))) == NULL ||
+        (wfds = calloc(nnc + 1, sizeof(*wfds))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    t0 = loadgen_now();
+    lg.lg_end = t0 + (uint64_t)secs * 1000000000ULL;
+    for (i = 0; i < nrc + nnc; i++){
+        lc = &clients[i];
+        lc->lc_lg = &lg;
+        lc->lc_seed = seed + i;
+        lc->lc_wfd = lc->lc_rfd = -1;
+        if ((lc->lc_req = cbuf_new()) == NULL ||
+            (lc->lc_rbuf = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (i < nrc){
+            if ((lc->lc_curl = curl_easy_init()) == NULL){
+                clixon_err(OE_UNIX, 0, "curl_easy_init");
+                goto done;
+            }
+            lc->lc_hdrs = curl_slist_append(NULL, "Content-Type: application/yang-data+json");
+            lc->lc_hdrs = curl_slist_append(lc->lc_hdrs, "Accept: application/yang-data+json");
+            if (restconf_next(lc) < 0)
+                goto done;
+        }
+        else if (netconf_start(lc) < 0)
+            goto done;
+    }
+    /* Poll loop: curl sockets and NETCONF session pipes */
+    do {
+        j = 0;
+        active = 0;
+        for (i = nrc; i < nrc + nnc; i++){
+            lc = &clients[i];
+            if (lc->lc_rfd < 0)
+                continue;
+            active++;
+            wfds[j].fd = lc->lc_rfd;
+            wfds[j].events = CURL_WAIT_POLLIN;
+            wfds[j].revents = 0;
+            j++;
+        }
+        if (curl_multi_wait(lg.lg_multi, wfds, j, 100, NULL) != CURLM_OK){
+            clixon_err(OE_UNIX, 0, "curl_multi_wait");
+            goto done;
+        }
+        curl_multi_perform(lg.lg_multi, &running);
+        if (restconf_done(&lg) < 0)
+            goto done;
+        for (i = nrc; i < nrc + nnc; i++){
+            lc = &clients[i];
+            if (lc->lc_rfd < 0)
+                continue;
+            for (j = 0; j < nnc; j++)
+                if (wfds[j].fd == lc->lc_rfd && wfds[j].revents)
+                    break;
+            if (j < nnc && netconf_input(lc) < 0)
+                goto done;
+            /* Close stdin after close-session so that the session exits */
+            if (lc->lc_done && lc->lc_wfd >= 0){
+                close(lc->lc_wfd);
+                lc->lc_wfd = -1;
+            }
+        }
+        curl_multi_perform(lg.lg_multi, &running);
+    } while (running || active);
+    loadgen_report(&lg, (loadgen_now() - t0) / 1e9, nrc, nnc);
+    retval = 0;
+ done:
+    if (clients){
+        for (i = 0; i < nrc + nnc; i++){
+            lc = &clients[i];
+            if (lc->lc_curl){
+                curl_multi_remove_handle(lg.lg_multi, lc->lc_curl);
+                curl_easy_cleanup(lc->lc_curl);
+            }
+            if (lc->lc_hdrs)
+                curl_slist_free_all(lc->lc_hdrs);
+            if (lc->lc_wfd >= 0)
+                close(lc->lc_wfd);
+            if (lc->lc_rfd >= 0)
+                close(lc->lc_rfd);
+            if (lc->lc_pid > 0)
+                waitpid(lc->lc_pid, NULL, 0);
+            if (lc->lc_req)
+                cbuf_free(lc->lc_req);
+            if (lc->lc_rbuf)
+                cbuf_free(lc->lc_rbuf);
+        }
+        free(clients);
+    }
+    if (wfds)
+        free(wfds);
+    for (i = 0; i < LG_NOPS; i++)
+        if (lg.lg_stats[i].ls_vec)
+            free(lg.lg_stats[i].ls_vec);
+    if (lg.lg_multi)
+        curl_multi_cleanup(lg.lg_multi);
+    curl_global_cleanup();
+    clixon_handle_exit(h);
+    clixon_err_exit();
+    clixon_log_exit();
+    return retval < 0 ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+#!/usr/bin/env bash
+# Performance regression tracking of the C microbenchmarks in bench/ and test_perf_*.sh
+# Each benchmark and script is run several times and the samples are stored per
+# architecture. A compare run fails if the median of a metric is worse than the baseline
+# median both by more than a relative tolerance and by more than a number of standard
+# deviations of the baseline samples, to not fail on noise.
+# Metrics, all lower is better:
+#   ns_per_op  time per operation of each C benchmark and list size (inverse throughput)
+#   maxrss_kb  peak resident memory of the C benchmark process
+#   seconds    wall clock time of each test_perf_*.sh script
+#   mem_mb     backend memory of test_perf_mem.sh
+# Examples
+# 1. Store a baseline, eg on the main branch
+#    mode=baseline ./perf_regress.sh
+# 2. Compare a change against it, exit status 1 on regression
+#    mode=compare ./perf_regress.sh
+# 3. Only C benchmarks of xpath, 20% time tolerance
+#    scripts= benchargs="-n 10000 -b xpath" timetol=20 ./perf_regress.sh
+# Do not compare results from different machines or build options
+
+set -u
+
+arch=$(arch)
+# Default values
+: ${mode:=compare}      # baseline: store samples, compare: run and compare with baseline
+: ${basedir:=$HOME/.clixon_perf} # Baseline dir, one file per architecture
+: ${baseline:=$basedir/$arch.txt} # Baseline samples
+: ${resdir:=/var/tmp/clixon_perf} # Result dir of current run
+: ${repeat:=5}          # Runs of each benchmark and script
+: ${timetol:=10}        # Time tolerance in percent
+: ${memtol:=5}          # Memory tolerance in percent
+: ${nsd:=3}             # Minimum difference in baseline standard deviations
+: ${bench:=true}        # Run C microbenchmarks
+: ${benchargs="-n 1000,10000 -r 10"} # C microbenchmark arguments
+: ${scripts=$(ls test_perf_*.sh)} # Perf scripts to run, empty for none
+: ${make:=make}
+
+if [ "$mode" != baseline -a "$mode" != compare ]; then
+    echo "mode=$mode: expected baseline or compare" >&2
+    exit 255
+fi
+if [ "$mode" = compare -a ! -f "$baseline" ]; then
+    echo "No baseline $baseline, run with mode=baseline first" >&2
+    exit 255
+fi
+if [ ! -d $resdir ]; then
+    mkdir -p $resdir
+fi
+res=$resdir/$arch.txt # Samples of this run as lines: <key> <metric> <value>
+: > $res
+
+# Run C microbenchmarks, one JSON line per benchmark and size
+# Arguments:
+# 1: run nr
+function run_bench(){
+    local r=$1
+
+    LD_LIBRARY_PATH=../lib/src ./bench/clixon_bench $benchargs -s $r > $resdir/bench.json
+    if [ $? -ne 0 ]; then
+        echo "clixon_bench failed" >&2
+        exit 255
+    fi
+    sed -n 's/.*"name":"\([^"]*\)","entries":\([0-9]*\),.*"ns_per_op":\([0-9.]*\),"maxrss_kb":\([0-9]*\).*/bench:\1:\2 ns_per_op \3\nbench:\1:\2 maxrss_kb \4/p' $resdir/bench.json >> $res
+}
+
+# Run perf script, measure wall clock time and for test_perf_mem.sh backend memory
+# Arguments:
+# 1: script
+function run_script(){
+    local t=$1
+    local t0
+    local t1
+    local mem
+
+    t0=$(date +%s.%N)
+    ./$t > $resdir/$t.log 2>&1
+    if [ $? -ne 0 ]; then
+        echo "$t failed, see $resdir/$t.log" >&2
+        exit 255
+    fi
+    t1=$(date +%s.%N)
+    awk -v t="$t" -v t0=$t0 -v t1=$t1 'BEGIN {printf("script:%s seconds %.2f\n", t, t1 - t0)}' >> $res
+    mem=$(awk '/statm:/ {sub("M", "", $2); print $2; exit}' $resdir/$t.log)
+    if [ -n "$mem" ]; then
+        echo "script:$t mem_mb $mem" >> $res
+    fi
+}
+
+if $bench; then
+    (cd bench && $make clixon_bench) > /dev/null || exit 255
+fi
+
+for (( r=1; r<=$repeat; r++ )); do
+    echo "run $r/$repeat"
+    if $bench; then
+        run_bench $r
+    fi
+    for t in $scripts; do
+        run_script $t
+    done
+done
+
+if [ "$mode" = baseline ]; then
+    if [ ! -d $basedir ]; then
+        mkdir -p $basedir
+    fi
+    cp $res $baseline
+    echo "Baseline stored in $baseline"
+    exit 0
+fi
+
+# Compare median of this run with baseline median per key and metric
+awk -v timetol=$timetol -v memtol=$memtol -v nsd=$nsd '
+function median(k, n,    i, j, v){
+    for (i = 1; i <= n; i++)
+        a[i] = vals[k, i];
+    for (i = 2; i <= n; i++){
+        v = a[i];
+        for (j = i - 1; j >= 1 && a[j] > v; j--)
+            a[j+1] = a[j];
+        a[j+1] = v;
+    }
+    if (n % 2)
+        return a[(n+1)/2];
+    return (a[n/2] + a[n/2+1]) / 2;
+}
+function stddev(k, n,    i, s, m){
+    if (n < 2)
+        return 0;
+    for (i = 1; i <= n; i++)
+        s += vals[k, i];
+    m = s / n;
+    s = 0;
+    for (i = 1; i <= n; i++)
+        s += (vals[k, i] - m)^2;
+    return sqrt(s / (n - 1));
+}
+{
+    k = FILENAME == ARGV[1] ? "b" : "c";
+    k = k SUBSEP $1 SUBSEP $2;
+    vals[k, ++nr[k]] = $3;
+    if (FILENAME != ARGV[1] && !(($1, $2) in keys)){
+        keys[$1, $2] = 1;
+        order[++nkeys] = $1 SUBSEP $2;
+    }
+}
+END {
+    printf("%-40s %-10s %12s %12s %8s %s\n", "Key", "Metric", "Baseline", "Current", "Diff%", "");
+    for (i = 1; i <= nkeys; i++){
+        split(order[i], km, SUBSEP);
+        bk = "b" SUBSEP order[i];
+        ck = "c" SUBSEP order[i];
+        cm = median(ck, nr[ck]);
+        if (!nr[bk]){
+            printf("%-40s %-10s %12s %12g %8s %s\n", km[1], km[2], "-", cm, "-", "new");
+            continue;
+        }
+        bm = median(bk, nr[bk]);
+        sd = stddev(bk, nr[bk]);
+        tol = (km[2] ~ /kb$|mb$/) ? memtol : timetol;
+        diff = bm > 0 ? 100 * (cm - bm) / bm : 0;
+        status = "";
+        if (diff > tol && cm - bm > nsd * sd){
+            status = "REGRESSION";
+            fails++;
+        }
+        else if (diff < -tol && bm - cm > nsd * sd)
+            status = "improved";
+        printf("%-40s %-10s %12g %12g %8.1f %s\n", km[1], km[2], bm, cm, diff, status);
+    }
+    if (fails){
+        printf("%d regression(s) against baseline\n", fails);
+        exit 1;
+    }
+}' $baseline $res
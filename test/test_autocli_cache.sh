@@ -181,6 +181,29 @@ if [ ! ${cachefile2} ]; then
     err1 "Expected ${cachefile2}"
 fi
 
+new "Check cache key"
+key=$(head -1 ${cachefile})
+if [ "${key:0:23}" != "# clixon autocli cache " ]; then
+    err1 "# clixon autocli cache" "$key"
+fi
+
+# Cache entry with another module-set or autocli config is regenerated
+echo "# clixon autocli cache 0" > ${cachefile}
+echo "stale;" >> ${cachefile}
+
+new "autocli readwrite stale entry"
+expectpart "$($clixon_cli -f $cfg -1 show config)" 0 "<table xmlns=\"urn:example:clixon\"><parameter><name>x</name>"
+
+new "Check stale entry rewritten"
+content=$(cat ${cachefile})
+if [ "$(head -1 ${cachefile})" != "$key" ]; then
+    err "$key" "$(head -1 ${cachefile})"
+fi
+match=$(echo "${content}" | grep --null -o "$expected")
+if [[ -z "${match}" ]]; then
+    err "$expected" "${content}"
+fi
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
@@ -338,6 +338,30 @@ EOF
 new "show config netconf"
 expectpart "$(cat $fin | $clixon_cli -f $cfg 2>&1)" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><parameter><name>a</name><value>42</value></parameter>" "</config></edit-config></rpc>]]>]]>"
 
+# Batched edits from script, see CLICON_CLI_BATCH_EDITS
+cat <<EOF > $fin
+set table parameter c value 1
+set table parameter d value 2
+set table parameter c value 3
+delete table parameter d
+edit table
+set parameter e value 5
+top
+show config xml
+EOF
+new "batched edits; show"
+expectpart "$(cat $fin | $clixon_cli -f $cfg -o CLICON_CLI_BATCH_EDITS=2 2>&1)" 0 "<parameter><name>c</name><value>3</value></parameter><parameter><name>e</name><value>5</value></parameter>" --not-- "<name>d</name>"
+
+cat <<EOF > $fin
+delete table parameter c
+delete table parameter e
+EOF
+new "batched edits at end of script"
+expectpart "$(cat $fin | $clixon_cli -f $cfg -o CLICON_CLI_BATCH_EDITS=100 2>&1)" 0 "^$"
+
+new "show batched edits"
+expectpart "$(echo "show config xml" | $clixon_cli -f $cfg 2>&1)" 0 '<table xmlns="urn:example:clixon"><parameter><name>a</name><value>42</value></parameter><parameter><name>b</name><value>71</value></parameter></table>'
+
 # Negative test
 new "config parameter only expect fail"
 expectpart "$(echo "set table parameter" | $clixon_cli -f $cfg 2>&1)" 0 "CLI syntax error" "Incomplete command"
@@ -167,11 +167,14 @@ EOF
 
 # Args:
 # 1: grouping_treeref
+# 2: module_treeref
 function testrun()
 {
     # Whether grouping treeref is enabled
     grouping_treeref=$1
-    echo "grouping_treeref=$1"
+    # Whether top-level containers and lists are generated on demand
+    module_treeref=$2
+    echo "grouping_treeref=$1 module_treeref=$2"
     #    cat <<EOF > $cfd/autocli.xml # XXX
     cat <<EOF > $cfg
 <clixon-config xmlns="http://clicon.org/config">
@@ -193,6 +196,7 @@ function testrun()
     <module-default>false</module-default>
      <list-keyword-default>kw-nokey</list-keyword-default>
      <grouping-treeref>${grouping_treeref}</grouping-treeref>
+     <module-treeref>${module_treeref}</module-treeref>
      <rule>
         <name>include ${APPNAME}</name>
         <operation>enable</operation>
@@ -227,6 +231,11 @@ EOF
         expectpart "$($clixon_cli -f $cfg -G -1 2>&1)" 0 --not-- "@grouping--top--data--example--pg1" "@grouping--top--data--example-external--pg2" "@grouping--top--data-example-external-pg3"
     fi
 
+    if ${module_treeref}; then
+        new "verify module treeref is enabled"
+        expectpart "$($clixon_cli -f $cfg -G -1 2>&1)" 0 "@module--top--data--example--table"
+    fi
+
     new "set top-level grouping"
     expectpart "$($clixon_cli -f $cfg -1 set value1 39)" 0 ""
 
@@ -276,10 +285,16 @@ EOF
 }
 
 new "autocli grouping=true"
-testrun true
+testrun true false
 
 new "autocli grouping=false"
-testrun false
+testrun false false
+
+new "autocli grouping=true module=true"
+testrun true true
+
+new "autocli grouping=false module=true"
+testrun false true
 
 rm -rf $dir
 
@@ -255,6 +255,22 @@ expectpart "$($clixon_cli -1 -f $cfg -l o show auto $format table)" 0 "^$X$"
 
 # XXX rest does not print whole NETCONF path to root, eg does not include "table"
 
+# Paged show of list, one entry per page, see CLICON_CLI_SHOW_PAGE_SIZE
+format=xml
+
+new "cli check show auto $format table parameter paged"
+X='<parameter><name>x</name><value>1</value><array1>a</array1><array1>b</array1></parameter><parameter><name>y</name><value>2</value></parameter>'
+expectpart "$($clixon_cli -1 -f $cfg -l o -o CLICON_CLI_SHOW_PAGE_SIZE=1 show auto $format table parameter)" 0 "^$X$"
+
+new "cli check show auto $format table parameter x paged"
+X='<parameter><name>x</name><value>1</value><array1>a</array1><array1>b</array1></parameter>'
+expectpart "$($clixon_cli -1 -f $cfg -l o -o CLICON_CLI_SHOW_PAGE_SIZE=1 show auto $format table parameter x)" 0 "^$X$"
+
+format=cli
+
+new "cli check show auto $format table parameter paged"
+expectpart "$($clixon_cli -1 -f $cfg -l o -o CLICON_CLI_SHOW_PAGE_SIZE=1 show auto $format table parameter)" 0 "parameter x value 1" "parameter x array1 a" "parameter y value 2"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
@@ -0,0 +1,140 @@
+#!/usr/bin/env bash
+# Coalescing of autocommit edits, see CLICON_AUTOCOMMIT_BATCH
+# Edits of several clients within the window are committed in one transaction
+# If the batch commit fails, the edits are committed one by one and each client gets the
+# result of its own edit
+# Using the -C <xpath> option of the main example to fail commit
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Coalescing window in ms
+: ${window:=2000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_AUTOCOMMIT>1</CLICON_AUTOCOMMIT>
+  <CLICON_AUTOCOMMIT_BATCH>$window</CLICON_AUTOCOMMIT_BATCH>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Edit a parameter in candidate in a client of its own in background, reply in $dir/<name>.xml
+# Arguments:
+# 1: name
+function editparam(){
+    echo "$HELLONO11<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>$1</name><value>$1</value></parameter></table></config></edit-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg > $dir/$1.xml &
+}
+
+new "test params: -f $cfg -- -C /table/parameter[name='fail']"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -C /table/parameter[name='fail']"
+    start_backend -s init -f $cfg -- -C "/table/parameter[name='fail']"
+fi
+
+new "wait backend"
+wait_backend
+
+new "edit a and b in two clients within window"
+editparam a
+editparam b
+sleep 1
+
+new "running is not committed within window"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+wait
+
+new "edit a is committed"
+expectpart "$(cat $dir/a.xml)" 0 "<ok/>" --not-- "rpc-error"
+
+new "edit b is committed"
+expectpart "$(cat $dir/b.xml)" 0 "<ok/>" --not-- "rpc-error"
+
+new "get-config running after batch"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>a</value></parameter><parameter><name>b</name><value>b</value></parameter></table></data></rpc-reply>"
+
+new "edit c, fail and d in three clients within window, batch commit fails"
+editparam c
+sleep 0.2
+editparam fail
+sleep 0.2
+editparam d
+wait
+
+new "edit c is committed one by one"
+expectpart "$(cat $dir/c.xml)" 0 "<ok/>" --not-- "rpc-error"
+
+new "edit fail gets error of its own commit"
+expectpart "$(cat $dir/fail.xml)" 0 "<error-tag>operation-failed</error-tag>" "User commit error" --not-- "<ok/>"
+
+new "edit d is committed one by one"
+expectpart "$(cat $dir/d.xml)" 0 "<ok/>" --not-- "rpc-error"
+
+new "get-config running after failed batch"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>a</value></parameter><parameter><name>b</name><value>b</value></parameter><parameter><name>c</name><value>c</value></parameter><parameter><name>d</name><value>d</value></parameter></table></data></rpc-reply>"
+
+new "get-config candidate is running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>a</value></parameter><parameter><name>b</name><value>b</value></parameter><parameter><name>c</name><value>c</value></parameter><parameter><name>d</name><value>d</value></parameter></table></data></rpc-reply>"
+
+new "single edit fail in window"
+editparam fail
+wait
+
+new "edit fail gets error of batch commit"
+expectpart "$(cat $dir/fail.xml)" 0 "<error-tag>operation-failed</error-tag>" "User commit error" --not-- "<ok/>"
+
+new "get-config running is unchanged"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='fail']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -172,6 +172,9 @@ expectpart "$($clixon_cli -1 -f $cfg show compare xml)" 0 "<table xmlns=\"urn:ex
 new "check compare text"
 expectpart "$($clixon_cli -1 -f $cfg show compare text)" 0 "^\ *table {" "^\-\ *parameter a {" "^+\ *parameter c {" "^\-\ *value \"98\";" "^+\ *value \"99\";"
 
+new "netconf datastore-diff text"
+expectpart "$(echo "$HELLONO11<rpc $DEFAULTNS><datastore-diff $LIBNS><source>running</source><target>candidate</target><format>text</format></datastore-diff></rpc>]]>]]>" | $clixon_netconf -qf $cfg)" 0 "<rpc-reply $DEFAULTNS><diff $LIBNS>" "parameter c {" --not-- "rpc-error"
+
 new "delete section x"
 expectpart "$($clixon_cli -1 -f $cfg delete top section x)" 0 "^$"
 
@@ -135,6 +135,15 @@ expectpart "$($clixon_cli -1 -f $cfg set list1 zyx)" 0 "^$"
 new "Expand delete"
 expectpart "$(echo "delete list1 	" | $clixon_cli -f $cfg 2>&1)" 0 xyz zyx
 
+new "Add entry 3"
+expectpart "$($clixon_cli -1 -f $cfg set list1 xab)" 0 "^$"
+
+new "expand-values rpc"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><expand-values xmlns=\"http://clicon.org/lib\"><datastore>candidate</datastore><xpath xmlns:ex=\"urn:example:clixon\">/ex:list1/ex:key1</xpath></expand-values></rpc>" "" "<rpc-reply $DEFAULTNS><value xmlns=\"http://clicon.org/lib\">xab</value><value xmlns=\"http://clicon.org/lib\">xyz</value><value xmlns=\"http://clicon.org/lib\">zyx</value></rpc-reply>"
+
+new "expand-values rpc prefix and limit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><expand-values xmlns=\"http://clicon.org/lib\"><datastore>candidate</datastore><xpath xmlns:ex=\"urn:example:clixon\">/ex:list1/ex:key1</xpath><prefix>x</prefix><limit>1</limit></expand-values></rpc>" "" "<rpc-reply $DEFAULTNS><value xmlns=\"http://clicon.org/lib\">xab</value></rpc-reply>"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
@@ -134,6 +134,12 @@ CLICON_MODE="|mypipe"; # Must start with |
    except <arg:string>, pipe_grep_fn("-v", "arg");
    tail <arg:string>, pipe_tail_fn("-n", "arg");
    count, pipe_wc_fn("-l");
+   include <arg:string>, pipe_include_fn("arg");
+   exclude <arg:string>, pipe_exclude_fn("arg");
+   lines, pipe_count_fn();
+   head <arg:string>, pipe_head_fn("arg");
+   last <arg:string>, pipe_last_fn("arg");
+   xpath <arg:string>, pipe_xpath_fn("arg", "xml", false);
    show {
      json, pipe_showas_fn("json");
      text, pipe_showas_fn("text");
@@ -204,6 +210,27 @@ expectpart "$($clixon_cli -1 -m $mode -f $cfg show explicit config \| count)" 0
 
 # XXX dont work with valgrind?
 if [ $valgrindtest -eq 0 ]; then
+new "$mode show explicit | include par"
+expectpart "$($clixon_cli -1 -m $mode -f $cfg show explicit config \| include par)" 0 "<parameter>" "</parameter>" --not-- "table" "value"
+
+new "$mode show explicit | include table|name"
+expectpart "$($clixon_cli -1 -m $mode -f $cfg show explicit config \| include 'table|name')" 0 "<table xmlns=\"urn:example:clixon\">" "<name>x</name>" "<name>y</name>" "</table>" --not-- "parameter" "value"
+
+new "$mode show explicit | exclude par"
+expectpart "$($clixon_cli -1 -m $mode -f $cfg show explicit config \| exclude par)" 0 "table" "value" --not-- "parameter"
+
+new "$mode show explicit | lines"
+expectpart "$($clixon_cli -1 -m $mode -f $cfg show explicit config \| lines)" 0 "^10$"
+
+new "$mode show explicit | head 2"
+expectpart "$($clixon_cli -1 -m $mode -f $cfg show explicit config \| head 2)" 0 "<table xmlns=\"urn:example:clixon\">" "<parameter>" --not-- "<name>x</name>"
+
+new "$mode show explicit | last 5"
+expectpart "$($clixon_cli -1 -m $mode -f $cfg show explicit config \| last 5)" 0 "<name>y</name>" "</table>" --not-- "<name>x</name>"
+
+new "$mode show explicit | xpath"
+expectpart "$($clixon_cli -1 -m $mode -f $cfg show explicit config \| xpath "/ex:table/ex:parameter[ex:name='y']")" 0 "^<parameter><name>y</name><value>b</value></parameter>$" --not-- "<name>x</name>"
+
 new "$mode show explicit | show json"
 expectpart "$($clixon_cli -1 -m $mode -f $cfg show explicit config \| show json)" 0 '"name": "x",' --not-- "<name>"
 
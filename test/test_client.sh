@@ -77,6 +77,7 @@ EOF
 cat<<EOF > $cfile
 #include <unistd.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 
 #include <clixon/clixon_queue.h>
@@ -111,6 +112,19 @@ main(int    argc,
          goto done;
        printf("%u\n", u); /* for test output */
     }
+    /* Read several values in one request */
+    {
+       const char *xpaths[] = {"/table/parameter[name='a']/value",
+                               "/table/parameter[name='b']/value"};
+       char       *vals[2];
+       int         i;
+
+       if (clixon_client_get_multi(ch, vals, 2, "urn:example:clixon-client", xpaths) < 0)
+         goto done;
+       printf("%s %s\n", vals[0], vals[1]); /* for test output */
+       for (i=0; i<2; i++)
+         free(vals[i]);
+    }
     retval = 0;
   done:
     clixon_client_disconnect(ch);
@@ -156,7 +170,7 @@ fi
 new "wait restconf"
 wait_restconf
 
-XML='<table xmlns="urn:example:clixon-client"><parameter><name>a</name><value>42</value></parameter></table>'
+XML='<table xmlns="urn:example:clixon-client"><parameter><name>a</name><value>42</value></parameter><parameter><name>b</name><value>7</value></parameter></table>'
 
 # Add a set of entries using restconf
 new "POST the XML"
@@ -166,7 +180,7 @@ new "Check entries"
 expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/clixon-client:table -H 'Accept: application/yang-data+xml')" 0 "HTTP/$HVER 200" "$XML"
 
 new "Run $app"
-expectpart "$(sudo $app)" 0 '^42$'
+expectpart "$(sudo $app)" 0 '^42$' '^42 7$'
 
 if [ $RC -ne 0 ]; then
     new "Kill restconf daemon"
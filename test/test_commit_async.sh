@@ -0,0 +1,147 @@
+#!/usr/bin/env bash
+# Asynchronous commit, see CLICON_BACKEND_COMMIT_ASYNC
+# Using the -P <ms> option of the main example, the commit callback is pending and done
+# later by a timer, and -C <xpath> to fail the pending commit
+# While a commit is pending, reads of other clients are served and see the old running,
+# writes are queued until the commit is done
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Time the commit is pending in ms
+: ${pending:=2000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_COMMIT_ASYNC>true</CLICON_BACKEND_COMMIT_ASYNC>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Send rpcs in one session with EOM framing
+# Arguments:
+# 1: rpcs
+function session(){
+    echo "$HELLONO11$1" | $clixon_netconf -qf $cfg
+}
+
+# Edit a parameter in candidate
+# Arguments:
+# 1: name
+function editparam(){
+    echo "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>$1</name><value>$1</value></parameter></table></config></edit-config></rpc>]]>]]>"
+}
+
+new "test params: -f $cfg -- -P $pending -C /table/parameter[name='fail']"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -P $pending -C /table/parameter[name='fail']"
+    start_backend -s init -f $cfg -- -P $pending -C "/table/parameter[name='fail']"
+fi
+
+new "wait backend"
+wait_backend
+
+new "edit a"
+expectpart "$(session "$(editparam a)")" 0 "<ok/>" --not-- "rpc-error"
+
+new "commit a in background, pending"
+session "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" > $dir/commit.xml &
+sleep 1
+
+new "get-config running while commit is pending is served with old running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "commit is not yet replied"
+expectpart "$(cat $dir/commit.xml)" 0 "" --not-- "<ok/>" "rpc-error"
+
+new "edit b while commit is pending is queued until commit is done"
+expectpart "$(session "$(editparam b)")" 0 "<ok/>" --not-- "rpc-error"
+wait
+
+new "pending commit is done"
+expectpart "$(cat $dir/commit.xml)" 0 "<ok/>" --not-- "rpc-error"
+
+new "get-config running after commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>a</value></parameter></table></data></rpc-reply>"
+
+new "commit b"
+expectpart "$(session "<rpc $DEFAULTNS><commit/></rpc>]]>]]>")" 0 "<ok/>" --not-- "rpc-error"
+
+new "edit fail"
+expectpart "$(session "$(editparam fail)")" 0 "<ok/>" --not-- "rpc-error"
+
+new "commit fail in background, pending"
+session "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" > $dir/commit.xml &
+sleep 1
+
+new "get-config candidate while commit is pending"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='fail']/ex:name\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>fail</name></parameter></table></data></rpc-reply>"
+wait
+
+new "pending commit fails, client gets error"
+expectpart "$(cat $dir/commit.xml)" 0 "<error-tag>operation-failed</error-tag>" "User commit error" --not-- "<ok/>"
+
+new "get-config running after failed commit is unchanged"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>a</value></parameter><parameter><name>b</name><value>b</value></parameter></table></data></rpc-reply>"
+
+new "discard-changes"
+expectpart "$(session "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>")" 0 "<ok/>" --not-- "rpc-error"
+
+new "edit and commit c after failed commit"
+expectpart "$(session "$(editparam c)<rpc $DEFAULTNS><commit/></rpc>]]>]]>")" 0 "<ok/>" --not-- "rpc-error"
+
+new "get-config running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>a</value></parameter><parameter><name>b</name><value>b</value></parameter><parameter><name>c</name><value>c</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
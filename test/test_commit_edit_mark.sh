@@ -0,0 +1,166 @@
+#!/usr/bin/env bash
+# Commit diff restricted to subtrees marked as edited in candidate, see XMLDB_EDIT_MARK
+# Check with the transaction log of the main example (-t) that the commit callback gets
+# exactly the changes of several edits, also after failed commits, discard and failed edits
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/trans.yang
+flog=$dir/backend.log
+touch $flog
+
+cat <<EOF > $fyang
+module trans{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+      list y {
+         key "a";
+         leaf a {
+            type int32;
+         }
+         leaf b {
+            type int32{
+               range "0..100";
+            }
+         }
+      }
+      leaf z {
+         type int32;
+      }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+# Edit candidate
+# Arguments:
+# 1: config under x
+# 2: expected reply
+function edit(){
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns='urn:example:clixon'>$1</x></config></edit-config></rpc>" "" "$2"
+}
+
+# Commit, log lines before commit are in l0
+# Arguments:
+# 1: expected reply
+function commit(){
+    l0=$(wc -l < $flog)
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "$1"
+}
+
+# Print transaction log of commit callback of last commit
+function commitlog(){
+    tail -n +$((l0+1)) $flog | grep "main_commit " || true
+}
+
+new "test params: -f $cfg -l f$flog -- -t"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -l f$flog -- -t"
+    start_backend -s init -f $cfg -l f$flog -- -t
+fi
+
+new "wait backend"
+wait_backend
+
+new "base config"
+edit "<y><a>1</a><b>1</b></y><y><a>2</a><b>2</b></y><y><a>3</a><b>3</b></y><z>0</z>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit base"
+commit "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+expectpart "$(commitlog)" 0 "add: <x"
+
+new "1. several edits before commit: change"
+edit "<y><a>1</a><b>11</b></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "1. several edits before commit: delete"
+edit "<y nc:operation='delete' xmlns:nc='$BASENS'><a>3</a></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "1. several edits before commit: add"
+edit "<y><a>4</a></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "1. commit has all edits"
+commit "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+expectpart "$(commitlog)" 0 "del: <y><a>3</a><b>3</b></y>" "add: <y><a>4</a></y>" "change: <b>1</b><b>11</b>" --not-- "<a>2</a>" "<z>"
+
+new "2. edit invalid value"
+edit "<y><a>2</a><b>9999</b></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "2. commit fails on validation"
+commit "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>b</bad-element></error-info><error-severity>error</error-severity><error-message>Number 9999 out of range: 0 - 100</error-message></rpc-error></rpc-reply>"
+expectpart "$(commitlog)" 0 "" --not-- "main_commit"
+
+new "2. edit other leaf after failed commit"
+edit "<z>1</z>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "2. edit valid value"
+edit "<y><a>2</a><b>22</b></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "2. commit has edits before and after failed commit"
+commit "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+expectpart "$(commitlog)" 0 "change: <b>2</b><b>22</b><z>0</z><z>1</z>" --not-- "<a>1</a>" "<a>4</a>" "<b>9999</b>"
+
+new "3. edit before discard-changes"
+edit "<y><a>1</a><b>99</b></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "3. discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "3. edit after discard-changes"
+edit "<y><a>2</a><b>23</b></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "3. commit has only edit after discard-changes"
+commit "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+expectpart "$(commitlog)" 0 "change: <b>22</b><b>23</b>" --not-- "<a>1</a>" "<b>99</b>"
+
+new "4. edit with unknown element fails"
+expectpart "$(echo "$HELLONO11<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns='urn:example:clixon'><y><a>1</a><b>5</b></y><w>1</w></x></config></edit-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg)" 0 "rpc-error" --not-- "<ok/>"
+
+new "4. edit after failed edit"
+edit "<y><a>4</a><b>44</b></y>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "4. commit has edit after failed edit"
+commit "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+expectpart "$(commitlog)" 0 "add: <b>44</b>" --not-- "<a>2</a>" "<b>5</b>"
+
+new "get-config running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>11</b></y><y><a>2</a><b>23</b></y><y><a>4</a><b>44</b></y><z>1</z></x></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
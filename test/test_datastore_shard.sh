@@ -0,0 +1,142 @@
+#!/usr/bin/env bash
+# Sharded multi-file datastore, each top-level node is stored in its own sub file
+# Check that an edit only rewrites the sub file of the changed top-level node, and that
+# sub files are read in parallel at startup
+# See CLICON_XMLDB_SHARD
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# linux stat <- freebsd gnustat in coreutils
+if [ -n "$(type gnustat 2> /dev/null)" ]; then
+    stat=gnustat
+else
+    stat=stat
+fi
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_MULTI>true</CLICON_XMLDB_MULTI>
+  <CLICON_XMLDB_SHARD>true</CLICON_XMLDB_SHARD>
+  <CLICON_XMLDB_SORT_THREADS>4</CLICON_XMLDB_SORT_THREADS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container a{
+      leaf x{
+         type uint32;
+      }
+   }
+   container b{
+      leaf y{
+         type uint32;
+      }
+   }
+}
+EOF
+
+# Get sub file of a top-level node
+# Arguments:
+# 1: db
+# 2: top-level node name
+function subfile(){
+    grep -l "<$2 " $dir/$1.d/*.xml | grep -v "/0.xml"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "add a and b"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><x>1</x></a><b xmlns=\"urn:example:clixon\"><y>2</y></b></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "candidate has one sub file per top-level node"
+fa=$(subfile candidate a)
+fb=$(subfile candidate b)
+if [ -z "$fa" -o -z "$fb" -o "$fa" = "$fb" ]; then
+    err "sub files of a and b" "$(ls $dir/candidate.d)"
+fi
+
+sa0=$($stat -c "%Y" $fa)
+sb0=$($stat -c "%Y" $fb)
+sleep 1
+
+new "change a"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><x>3</x></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "sub file of a changed"
+sa1=$($stat -c "%Y" $fa)
+if [ $sa0 -eq $sa1 ]; then
+    err "Timestamp changed" "$sa0 = $sa1"
+fi
+
+new "sub file of b not changed"
+sb1=$($stat -c "%Y" $fb)
+if [ $sb0 -ne $sb1 ]; then
+    err "Timestamp not changed" "$sb0 != $sb1"
+fi
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+
+    new "start backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "running read from sub files"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>3</x></a><b xmlns=\"urn:example:clixon\"><y>2</y></b></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
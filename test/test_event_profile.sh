@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+# Event loop and rpc latency histograms, enabled with debug profile
+# Callbacks of the backend event loop are recorded per registration string, and loop
+# lag and ready file descriptors per wakeup, and shown in the stats RPC and the CLI
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+clidir=$dir/cli
+if [ -d $clidir ]; then
+    rm -rf $clidir/*
+else
+    mkdir $clidir
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>$clidir</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_MODE>example</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $clidir/ex.cli
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %W> ";
+
+show("Show a particular state of the system"){
+    latency("Show latency histograms"){
+        cli("Show CLI latency histograms"), cli_show_statistics("cli", "event");
+        backend("Show backend latency histograms"), cli_show_statistics("backend", "event");
+    }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -D profile"
+    start_backend -s init -f $cfg -D profile
+fi
+
+new "wait backend"
+wait_backend
+
+new "add parameter"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "stats event-profile has callback of client socket"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"><event-profile>true</event-profile></stats></rpc>" "<entry><kind>callback</kind><name>local netconf client socket</name><count>[0-9]*</count><sum>[0-9]*</sum><max>[0-9]*</max><bucket><lower>[0-9]*</lower><count>"
+
+new "stats event-profile has ready fds and dispatch lag"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"><event-profile>true</event-profile></stats></rpc>" "<entry><kind>ready</kind><name>fds</name><count>[0-9]*</count>.*<entry><kind>lag</kind><name>dispatch</name><count>"
+
+new "cli show backend latency"
+expectpart "$($clixon_cli -1 -f $cfg show latency backend 2>&1)" 0 "Kind" "P99" "callback" "local netconf client socket" "ready" "fds"
+
+new "cli show cli latency"
+expectpart "$($clixon_cli -1 -f $cfg -D profile show latency cli 2>&1)" 0 "Kind" "P99"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,119 @@
+#!/usr/bin/env bash
+# Get with depth, see xmldb_get_depth
+# Only the levels of the datastore that are printed are copied, the replies are the same as
+# when the complete tree is read and printed with depth
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example-depth.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example-depth{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+      container sub{
+        leaf x{
+          type string;
+        }
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $dir/startup_db
+<config>
+  <table xmlns="urn:example:clixon">
+    <parameter><name>a</name><value>1</value><sub><x>11</x></sub></parameter>
+    <parameter><name>b</name><value>2</value><sub><x>22</x></sub></parameter>
+  </table>
+</config>
+EOF
+
+# NETCONF get of xpath $1 with depth $2
+function getdepth()
+{
+    echo "<rpc $DEFAULTNS><get cl:depth=\"$2\" xmlns:cl=\"http://clicon.org/lib\"><filter type=\"xpath\" select=\"$1\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>"
+}
+
+new "test params: -f $cfg -s startup"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get depth 1"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(getdepth /ex:table 1)" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"></table></data></rpc-reply>"
+
+new "get depth 2"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(getdepth /ex:table 2)" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter></parameter><parameter></parameter></table></data></rpc-reply>"
+
+new "get depth 3"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(getdepth /ex:table 3)" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value><sub></sub></parameter><parameter><name>b</name><value>2</value><sub></sub></parameter></table></data></rpc-reply>"
+
+new "get depth 1 of list entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(getdepth "/ex:table/ex:parameter[ex:name='b']" 1)" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"></table></data></rpc-reply>"
+
+new "get depth 2 with predicate on non-key"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(getdepth "/ex:table/ex:parameter[ex:value='2']" 2)" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter></parameter></table></data></rpc-reply>"
+
+new "get depth 4 with predicate on grandchild"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(getdepth "/ex:table/ex:parameter[ex:sub/ex:x='22']" 4)" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>2</value><sub><x>22</x></sub></parameter></table></data></rpc-reply>"
+
+new "get depth 2 with predicate on grandchild"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(getdepth "/ex:table/ex:parameter[ex:sub/ex:x='22']" 2)" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
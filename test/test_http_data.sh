@@ -240,6 +240,39 @@ TP/$HVER 200" "Content-Type: text/html" "<title>Welcome to Clixon!</title>"
         new "WWW head"
         expectpart "$(curl $CURLOPTS --head -H 'Accept: text/html' $proto://localhost/data/index.html)" 0 "HTTP/$HVER 200" "Content-Type: text/html" --not-- "<title>Welcome to Clixon!</title>"
 
+        new "WWW get entity-tag"
+        ret=$(curl $CURLOPTS -X GET -H 'Accept: text/html' $proto://localhost/data/index.html)
+        expectpart "$ret" 0 "HTTP/$HVER 200" "ETag: \"" "Last-Modified: " "Accept-Ranges: bytes"
+        etag=$(echo "$ret" | grep -i "^etag:" | sed -e "s/^[^:]*: *//" | tr -d '\r')
+
+        new "WWW get If-None-Match not modified"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/html' -H "If-None-Match: $etag" $proto://localhost/data/index.html)" 0 "HTTP/$HVER 304" --not-- "<title>Welcome to Clixon!</title>"
+
+        new "WWW get range"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/html' -H 'Range: bytes=5-8' $proto://localhost/data/index.html)" 0 "HTTP/$HVER 206" "Content-Range: bytes 5-8/" "Content-Length: 4" "TYPE"
+
+        new "WWW get suffix range"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/html' -H 'Range: bytes=-8' $proto://localhost/data/index.html)" 0 "HTTP/$HVER 206" "Content-Length: 8" "</html>"
+
+        new "WWW get range If-Range other entity-tag"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/html' -H 'Range: bytes=5-8' -H 'If-Range: "x"' $proto://localhost/data/index.html)" 0 "HTTP/$HVER 200" "<title>Welcome to Clixon!</title>"
+
+        new "WWW get range not satisfiable"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/html' -H 'Range: bytes=100000-' $proto://localhost/data/index.html)" 0 "HTTP/$HVER 416" "Content-Range: bytes \*/"
+
+        new "WWW get css without gzip variant"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/css' -H 'Accept-Encoding: gzip' $proto://localhost/data/example.css)" 0 "HTTP/$HVER 200" "display: inline;" --not-- "Content-Encoding"
+
+        gzip -k $dir/www/data/example.css
+
+        new "WWW get css gzip variant"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/css' -H 'Accept-Encoding: gzip' $proto://localhost/data/example.css)" 0 "HTTP/$HVER 200" "Content-Encoding: gzip" "Vary: Accept-Encoding" "Content-Type: text/css"
+
+        new "WWW get css gzip not accepted"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/css' $proto://localhost/data/example.css)" 0 "HTTP/$HVER 200" "Vary: Accept-Encoding" "display: inline;" --not-- "Content-Encoding"
+
+        rm $dir/www/data/example.css.gz
+
         new "WWW options"
         expectpart "$(curl $CURLOPTS -X OPTIONS $proto://localhost/data/index.html)" 0 "HTTP/$HVER 200" "allow: OPTIONS,HEAD,GET" 
 
@@ -0,0 +1,135 @@
+#!/usr/bin/env bash
+# Native restconf http-data files sent with sendfile, see restconf_reply_send_file
+# A large file is got over HTTP/1.1 with http and with https and kernel TLS,
+# see CLICON_RESTCONF_TLS_KTLS. If kernel TLS is not available, user space TLS is used
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Only native restconf
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+rm -rf $dir/www
+mkdir -p $dir/www/data
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf x{
+         type uint32;
+      }
+   }
+}
+EOF
+
+# Large binary file, several times the socket buffers
+head -c 4000000 /dev/urandom > $dir/www/data/large.bin
+
+# Get large file with proto $1
+function testrun()
+{
+    proto=$1  # http/https
+
+    RESTCONFIG=$(restconf_config none false $proto true)
+    if [ $? -ne 0 ]; then
+        err1 "Error when generating certs"
+    fi
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_FEATURE>clixon-restconf:http-data</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_HTTP_DATA_PATH>/data</CLICON_HTTP_DATA_PATH>
+  <CLICON_HTTP_DATA_ROOT>$dir/www</CLICON_HTTP_DATA_ROOT>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_RESTCONF_TLS_KTLS>true</CLICON_RESTCONF_TLS_KTLS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        sudo pkill -f clixon_backend # to be sure
+
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    if [ $RC -ne 0 ]; then
+        new "kill old restconf daemon"
+        stop_restconf_pre
+
+        new "start restconf daemon"
+        start_restconf -f $cfg
+    fi
+
+    new "wait restconf"
+    wait_restconf $proto
+
+    new "$proto head large file"
+    expectpart "$(curl -sSik --http1.1 --head $proto://localhost/data/large.bin)" 0 "HTTP/1.1 200" "Content-Type: application/octet-stream" "Content-Length: 4000000"
+
+    new "$proto get large file"
+    curl -sSk --http1.1 -X GET $proto://localhost/data/large.bin -o $dir/large.out
+    cmp $dir/large.out $dir/www/data/large.bin
+    if [ $? -ne 0 ]; then
+        err1 "$dir/large.out $dir/www/data/large.bin should be equal" "Not equal"
+    fi
+
+    new "$proto get large file slowly"
+    curl -sSk --http1.1 --limit-rate 2M -X GET $proto://localhost/data/large.bin -o $dir/large.out
+    cmp $dir/large.out $dir/www/data/large.bin
+    if [ $? -ne 0 ]; then
+        err1 "$dir/large.out $dir/www/data/large.bin should be equal" "Not equal"
+    fi
+
+    new "$proto restconf still serves requests"
+    expectpart "$(curl -sSik --http1.1 -X GET $proto://localhost/restconf/yang-library-version)" 0 "HTTP/1.1 200"
+
+    if [ $RC -ne 0 ]; then
+        new "Kill restconf daemon"
+        stop_restconf
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+for proto in http https; do
+    testrun $proto
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -91,6 +91,13 @@ module example{
                 require-instance true;  
             }
         }
+        leaf peer{
+            description "Second leafref in same entry, interleaved with template";
+            type leafref{
+                path "../../sender/name";
+                require-instance true;
+            }
+        }
     }
 }
 EOF
@@ -206,6 +213,26 @@ expectpart "$($clixon_cli -1f $cfg -l o set sender a)" 0 "^$"
 new "cli sender template"
 expectpart "$($clixon_cli -1f $cfg -l o set sender b template a)" 0 "^$"
 
+SENDERS=""
+for i in $(seq 0 9); do
+    SENDERS="$SENDERS<sender xmlns=\"urn:example:clixon\"><name>s$i</name><template>a</template><peer>s$(( (i+1)%10 ))</peer></sender>"
+done
+
+new "leafref add senders with two leafrefs each"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$SENDERS</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "leafref senders validate ok"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "leafref add sender with non-existing peer"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><sender xmlns=\"urn:example:clixon\"><name>s5</name><peer>s99</peer></sender></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "leafref senders validate (should fail)"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>data-missing</error-tag><error-app-tag>instance-required</error-app-tag><error-path>../../sender/name</error-path><error-info><peer>s99</peer></error-info><error-severity>error</error-severity></rpc-error></rpc-reply>" ""
+
+new "leafref discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
@@ -0,0 +1,287 @@
+#!/usr/bin/env bash
+# Authentication and authorization and IETF NACM
+# Compiled NACM rules cache and NACM optimizations, see clixon_custom.h:
+# - Compiled rules of a user are dropped when the NACM config changes, internal and external mode
+# - Data node rules deny and permit with schema-level pre-evaluation (NACM_READ_SCHEMA,
+#   NACM_WRITE_SCHEMA) and permit-all fast path
+# - Denied subtrees do not appear in zero-copy get-config or get replies
+# The limited user wilma is used, the admin user andy is permitted all
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf_yang.xml
+cfgx=$dir/conf_ext.xml
+fyang=$dir/nacm-example.yang
+nacmfile=$dir/nacmfile
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend_nacm.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+  <CLICON_NACM_DISABLED_ON_EMPTY>true</CLICON_NACM_DISABLED_ON_EMPTY>
+</clixon-config>
+EOF
+
+cat <<EOF > $cfgx
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfgx</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend_nacm.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_NACM_MODE>external</CLICON_NACM_MODE>
+  <CLICON_NACM_FILE>$nacmfile</CLICON_NACM_FILE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module nacm-example{
+  yang-version 1.1;
+  namespace "urn:example:nacm";
+  prefix ex;
+  import ietf-netconf-acm {
+    prefix nacm;
+  }
+  container table{
+    container parameters{
+      list parameter{
+        key name;
+        leaf name{
+          type string;
+        }
+        leaf value{
+          type string;
+        }
+      }
+    }
+    container secret{
+      leaf value{
+        type string;
+      }
+    }
+  }
+  leaf x{
+    type int32;
+  }
+}
+EOF
+
+# NACM rules with a data node rule of the limited group
+# Arguments:
+# 1: read-default
+# 2: path of data node rule
+# 3: action of data node rule
+function nacmrules(){
+    cat <<EOF
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>$1</read-default>
+     <write-default>permit</write-default>
+     <exec-default>permit</exec-default>
+
+     $NGROUPS
+
+     <rule-list>
+       <name>limited-acl</name>
+       <group>limited</group>
+       <rule>
+         <name>data</name>
+         <module-name>*</module-name>
+         <access-operations>*</access-operations>
+         <path xmlns:ex="urn:example:nacm">$2</path>
+         <action>$3</action>
+       </rule>
+     </rule-list>
+
+     $NADMIN
+
+   </nacm>
+EOF
+}
+
+CONFIG="<table xmlns=\"urn:example:nacm\"><parameters><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter></parameters><secret><value>42</value></secret></table>"
+
+PARAMS="<parameters><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter></parameters>"
+SECRET="<secret><value>42</value></secret>"
+DENIED="<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>access-denied</error-tag><error-severity>error</error-severity><error-message>access denied</error-message></rpc-error></rpc-reply>"
+FILTER="<filter type=\"xpath\" select=\"/ex:table\" xmlns:ex=\"urn:example:nacm\"/>"
+
+# Check read and write access of wilma
+# Arguments:
+# 1: config: expected table content in running of wilma
+# 2: Expected x in running, or empty
+# 3: true if wilma may write parameters, false if denied
+# 4: true if wilma may write secret, false if denied
+function testwilma(){
+    table=$1
+    x=$2
+    wparam=$3
+    wsecret=$4
+
+    if [ -n "$table" ]; then
+        data="<table xmlns=\"urn:example:nacm\">$table</table>"
+    else
+        data=""
+    fi
+    new "wilma get-config running"
+    expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$data$x</data></rpc-reply>"
+
+    new "wilma get-config running with xpath"
+    expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source>$FILTER</get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$data</data></rpc-reply>"
+
+    new "wilma get with xpath"
+    expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get>$FILTER</get></rpc>" "" "<rpc-reply $DEFAULTNS><data>$data</data></rpc-reply>"
+
+    new "wilma edit parameter"
+    if $wparam; then
+        expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:nacm\"><parameters><parameter><name>c</name><value>3</value></parameter></parameters></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    else
+        expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:nacm\"><parameters><parameter><name>c</name><value>3</value></parameter></parameters></table></config></edit-config></rpc>" "" "$DENIED"
+    fi
+
+    new "wilma edit secret"
+    if $wsecret; then
+        expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:nacm\"><secret><value>43</value></secret></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    else
+        expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:nacm\"><secret><value>43</value></secret></table></config></edit-config></rpc>" "" "$DENIED"
+    fi
+
+    new "discard wilma edits"
+    expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+# Change data node rule of limited group and commit as admin
+# Arguments:
+# 1: read-default
+# 2: path of data node rule
+# 3: action of data node rule
+function setrule(){
+    new "set read-default $1 rule $2 $3"
+    expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><read-default>$1</read-default><rule-list><name>limited-acl</name><rule><name>data</name><path xmlns:ex=\"urn:example:nacm\">$2</path><action>$3</action></rule></rule-list></nacm></config></edit-config></rpc><rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply><rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "add nacm rules and config"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$(nacmrules permit /ex:table/ex:secret deny)$CONFIG</config></edit-config></rpc><rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply><rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "admin get-config is not filtered"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source>$FILTER</get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$CONFIG</data></rpc-reply>"
+
+# Run twice to use compiled rules of wilma from cache
+new "internal: secret is denied"
+testwilma "$PARAMS" "" true false
+testwilma "$PARAMS" "" true false
+
+setrule permit /ex:table/ex:parameters deny
+
+new "internal: changed rule, parameters are denied"
+testwilma "$SECRET" "" false true
+
+setrule permit /ex:table/ex:parameters permit
+
+new "internal: permit-all rules, nothing is denied"
+testwilma "$PARAMS$SECRET" "" true true
+
+setrule deny /ex:table/ex:parameters permit
+
+new "internal: read-default deny, parameters are permitted"
+testwilma "$PARAMS" "" true true
+
+setrule permit /ex:table/ex:secret deny
+
+new "internal: back to first rules, secret is denied"
+testwilma "$PARAMS" "" true false
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# External mode, the NACM file is reloaded after each commit
+cfg=$cfgx
+nacmrules permit /ex:table/ex:secret deny > $nacmfile
+
+new "test params: -f $cfg -- -e"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -e"
+    start_backend -s init -f $cfg -- -e
+fi
+
+new "wait backend"
+wait_backend
+
+new "add config"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$CONFIG</config></edit-config></rpc><rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply><rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "external: secret is denied"
+testwilma "$PARAMS" "" true false
+testwilma "$PARAMS" "" true false
+
+new "change external nacm file"
+nacmrules permit /ex:table/ex:parameters deny > $nacmfile
+
+new "commit as admin reloads external nacm file"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:nacm\">1</x></config></edit-config></rpc><rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply><rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "external: changed rule, parameters are denied"
+testwilma "$SECRET" "<x xmlns=\"urn:example:nacm\">1</x>" false true
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
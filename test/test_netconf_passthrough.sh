@@ -0,0 +1,101 @@
+#!/usr/bin/env bash
+# NETCONF pass-through: rpcs handled by the backend are forwarded as text without parsing
+# in the netconf frontend, replies are forwarded as text with the rpc attributes
+# See CLICON_NETCONF_PASSTHROUGH
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_NETCONF_PASSTHROUGH>true</CLICON_NETCONF_PASSTHROUGH>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf x{
+         type uint32;
+      }
+      leaf y{
+         type string;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "edit-config pass-through, rpc attributes in reply"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS xmlns:ex=\"urn:example:clixon\" ex:extra=\"a&amp;b\"><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>42</x><y>a&lt;b</y></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS xmlns:ex=\"urn:example:clixon\" ex:extra=\"a&amp;b\"><ok/></rpc-reply>"
+
+new "edit-config pass-through, unknown element is rejected by backend"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><kallekaka/></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>unknown-element</error-tag><error-info><bad-element>kallekaka</bad-element></error-info>"
+
+new "edit-config with test-option is not passed through"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><test-option>set</test-option><config><c xmlns=\"urn:example:clixon\"><x>43</x></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>operation-not-supported</error-tag>"
+
+new "commit pass-through"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config with xpath filter pass-through, reply streamed"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS xmlns:ex=\"urn:example:clixon\" ex:extra=\"b\"><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:c\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS xmlns:ex=\"urn:example:clixon\" ex:extra=\"b\"><data><c xmlns=\"urn:example:clixon\"><x>42</x><y>a&lt;b</y></c></data></rpc-reply>"
+
+new "get without filter pass-through"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get/></rpc>" "" "<c xmlns=\"urn:example:clixon\"><x>42</x><y>a&lt;b</y></c>"
+
+new "get-config with subtree filter is parsed by frontend"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"subtree\"><c xmlns=\"urn:example:clixon\"><y/></c></filter></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><y>a&lt;b</y></c></data></rpc-reply>"
+
+new "prefixed rpc is parsed by frontend"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<nc:rpc xmlns:nc=\"${BASENS}\" nc:message-id=\"42\"><nc:lock><nc:target><nc:candidate/></nc:target></nc:lock></nc:rpc>" "" "<rpc-reply xmlns=\"${BASENS}\" xmlns:nc=\"${BASENS}\" nc:message-id=\"42\"><ok/></rpc-reply>"
+
+new "pass-through without message-id is parsed by frontend"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTONLY><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTONLY><rpc-error><error-type>rpc</error-type><error-tag>missing-attribute</error-tag>"
+
+new "validate pass-through"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,99 @@
+#!/usr/bin/env bash
+# Persistent NETCONF server: clixon_netconf -S loads YANG once and forks a session per
+# connection, clixon_netconf relays stdin/stdout to the server if it is running
+# See CLICON_NETCONF_SERVER_SOCK
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+nsock=$dir/netconf.sock
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_NETCONF_SERVER_SOCK>$nsock</CLICON_NETCONF_SERVER_SOCK>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf x{
+         type uint32;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "session without netconf server"
+expecteof_netconf "$clixon_netconf -f $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "<hello $DEFAULTONLY><capabilities><capability>urn:ietf:params:netconf:base:1.1</capability>" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "start netconf server"
+$clixon_netconf -D $DBG -S -f $cfg -l s &
+npid=$!
+sleep $DEMSLEEP
+if [ ! -S $nsock ]; then
+    err "netconf server socket $nsock"
+fi
+
+new "edit-config via netconf server"
+expecteof_netconf "$clixon_netconf -f $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>42</x></c></config></edit-config></rpc>" "<hello $DEFAULTONLY><capabilities><capability>urn:ietf:params:netconf:base:1.1</capability>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit via netconf server"
+expecteof_netconf "$clixon_netconf -f $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "<hello $DEFAULTONLY>" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config via netconf server"
+expecteof_netconf "$clixon_netconf -f $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "<hello $DEFAULTONLY>" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><x>42</x></c></data></rpc-reply>"
+
+new "session options are not relayed, quiet session"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><x>42</x></c></data></rpc-reply>"
+
+new "stop netconf server"
+kill $npid
+wait $npid 2> /dev/null
+
+new "session after netconf server stopped"
+expecteof_netconf "$clixon_netconf -f $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "<hello $DEFAULTONLY>" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><x>42</x></c></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
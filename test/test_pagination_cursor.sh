@@ -0,0 +1,147 @@
+#!/usr/bin/env bash
+# List pagination of a large config list with offset, sort-by, direction and cursor
+# Pages are read directly from the sorted datastore cache, and sort-by orders are cached
+# The cursor is the base64 encoding of the list keys, each terminated by a null character.
+# An empty cursor starts at the first entry and requests next and previous cursors.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example-table.yang
+
+# Number of list entries
+: ${perfnr:=1000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example-table{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type uint32;
+      }
+      leaf value{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+new "generate config with $perfnr list entries"
+# Values are in reverse order of the keys
+echo "<config><table xmlns=\"urn:example:clixon\">" > $dir/startup_db
+for (( i=0; i<$perfnr; i++ )); do
+    printf "<parameter><name>%d</name><value>v%06d</value></parameter>\n" $i $((perfnr-i)) >> $dir/startup_db
+done
+echo "</table></config>" >> $dir/startup_db
+
+# Entry of the table list
+function entry()
+{
+    printf "<parameter><name>%d</name><value>v%06d</value></parameter>" $1 $((perfnr-$1))
+}
+
+# Cursor of a table list entry
+function cursor()
+{
+    printf "%d\0" $1 | base64
+}
+
+# NETCONF get-config of the table list with list pagination parameters
+function pagination()
+{
+    echo "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter\" xmlns:ex=\"urn:example:clixon\"/><list-pagination xmlns=\"urn:ietf:params:xml:ns:yang:ietf-list-pagination-nc\">$1</list-pagination></get-config></rpc>"
+}
+
+new "test params: -f $cfg -s startup"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "offset and limit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<offset>500</offset><limit>2</limit>")" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\">$(entry 500)$(entry 501)</table></data></rpc-reply>"
+
+new "offset past end"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<offset>$perfnr</offset><limit>2</limit>")" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "direction backwards"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<direction>backwards</direction><offset>1</offset><limit>2</limit>")" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\">$(entry $((perfnr-2)))$(entry $((perfnr-3)))</table></data></rpc-reply>"
+
+new "sort-by value"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<sort-by>value</sort-by><limit>2</limit>")" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\">$(entry $((perfnr-1)))$(entry $((perfnr-2)))</table></data></rpc-reply>"
+
+new "sort-by value again, cached order"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<sort-by>value</sort-by><offset>10</offset><limit>1</limit>")" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\">$(entry $((perfnr-11)))</table></data></rpc-reply>"
+
+new "empty cursor: first page with next cursor"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<cursor/><limit>2</limit>")" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter [^>]*lpg:next=\"$(cursor 2)\"[^>]*><name>0</name>" ""
+
+new "cursor: next page with next cursor"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<cursor>$(cursor 2)</cursor><limit>2</limit>")" "<parameter [^>]*lpg:next=\"$(cursor 4)\"[^>]*><name>2</name>.*</parameter>$(entry 3)</table></data></rpc-reply>" ""
+
+new "cursor: next page with previous cursor"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<cursor>$(cursor 2)</cursor><limit>2</limit>")" "<parameter [^>]*lpg:previous=\"$(cursor 0)\"[^>]*><name>2</name>" ""
+
+new "cursor with sort-by"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<sort-by>value</sort-by><cursor>$(cursor 5)</cursor><limit>2</limit>")" "<name>5</name>.*</parameter>$(entry 4)</table></data></rpc-reply>" ""
+
+new "cursor not found"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<cursor>$(cursor $perfnr)</cursor><limit>2</limit>")" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>invalid-value</error-tag><error-severity>error</error-severity><error-message>cursor not found in list</error-message></rpc-error></rpc-reply>"
+
+new "add entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>$perfnr</name><value>v000000</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "sort-by value after commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(pagination "<sort-by>value</sort-by><limit>1</limit>")" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>$perfnr</name><value>v000000</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -3,6 +3,7 @@
 # Lists (and leaf-lists)
 # Add, get and delete entries
 # If both HTTP/1 and /2, force to /1 to test native http/1 implementation
+# Requests are sequential, for concurrent load use bench/clixon_loadgen
 
 # Override default to use http/1.1, comment to use https/2
 RCPROTO=http
@@ -0,0 +1,125 @@
+#!/usr/bin/env bash
+# Private candidate datastores, see draft-ietf-netconf-privcand
+# Each session edits its own candidate, commit rebases the edits onto current running and
+# fails on conflicting changes
+# See CLICON_XMLDB_PRIVATE_CANDIDATE
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRIVATE_CANDIDATE>true</CLICON_XMLDB_PRIVATE_CANDIDATE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf x{
+         type uint32;
+      }
+      leaf y{
+         type uint32;
+      }
+   }
+}
+EOF
+
+# Send rpcs in one session with EOM framing
+# Arguments:
+# 1: rpcs
+function session(){
+    echo "$HELLONO11$1" | $clixon_netconf -qf $cfg
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "private candidate capability"
+expectpart "$($clixon_netconf -qf $cfg < /dev/null 2>&1)" 0 "urn:ietf:params:netconf:capability:private-candidate:1.0"
+
+new "edit is seen in own candidate"
+expectpart "$(session "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>1</x></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>")" 0 "<data><c xmlns=\"urn:example:clixon\"><x>1</x></c></data>"
+
+new "edit is not seen in candidate of other session"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "edit and commit"
+expectpart "$(session "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>1</x></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>")" 0 "<ok/>" --not-- "rpc-error"
+
+new "get running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><x>1</x></c></data></rpc-reply>"
+
+new "discard-changes shares running again"
+expectpart "$(session "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>5</x></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><discard-changes/></rpc>]]>]]><rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>")" 0 "<data><c xmlns=\"urn:example:clixon\"><x>1</x></c></data>"
+
+new "edit y in first session, commit later"
+(echo "$HELLONO11<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><y>2</y></c></config></edit-config></rpc>]]>]]>"; sleep 2; echo "<rpc $DEFAULTNS><commit/></rpc>]]>]]>") | $clixon_netconf -qf $cfg > $dir/first.xml &
+sleep 1
+
+new "edit and commit x in second session"
+expectpart "$(session "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>3</x></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>")" 0 "<ok/>" --not-- "rpc-error"
+wait
+
+new "commit of first session is rebased"
+expectpart "$(cat $dir/first.xml)" 0 "<ok/>" --not-- "rpc-error"
+
+new "get running with both edits"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><x>3</x><y>2</y></c></data></rpc-reply>"
+
+new "edit x in first session, commit later"
+(echo "$HELLONO11<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>4</x></c></config></edit-config></rpc>]]>]]>"; sleep 2; echo "<rpc $DEFAULTNS><commit/></rpc>]]>]]>") | $clixon_netconf -qf $cfg > $dir/first.xml &
+sleep 1
+
+new "edit and commit x in second session"
+expectpart "$(session "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>5</x></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>")" 0 "<ok/>" --not-- "rpc-error"
+wait
+
+new "commit of first session conflicts"
+expectpart "$(cat $dir/first.xml)" 0 "<error-tag>operation-failed</error-tag>" "Private candidate conflicts with running"
+
+new "get running with second edit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><x>5</x><y>2</y></c></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
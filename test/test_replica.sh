@@ -0,0 +1,111 @@
+#!/usr/bin/env bash
+# Active/standby backend replication
+# Commits of the active backend are replicated as deltas to a standby backend
+# See CLICON_BACKEND_REPLICA
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+cfgs=$dir/conf_standby.xml
+fyang=$dir/example.yang
+sdir=$dir/standby
+test -d $sdir || mkdir -p $sdir
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_REPLICA>/usr/local/var/run/${APPNAME}_standby.sock</CLICON_BACKEND_REPLICA>
+</clixon-config>
+EOF
+
+cat <<EOF > $cfgs
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfgs</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/${APPNAME}_standby.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/${APPNAME}_standby.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$sdir</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_STANDBY>true</CLICON_BACKEND_STANDBY>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf x{
+            type uint32;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg -f $cfgs"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backends"
+    sudo clixon_backend -zf $cfg
+    sudo clixon_backend -zf $cfgs
+    new "start standby backend -s init -f $cfgs"
+    start_backend -s init -f $cfgs
+    new "start active backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait active backend"
+wait_backend
+
+new "add entries and commit in active"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><name>1</name><x>1</x></a><a><name>2</name><x>2</x></a></c></config></edit-config></rpc><rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply><rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+# Commit does not wait for the standby
+sleep 1
+
+new "standby running has entries"
+expecteof_netconf "$clixon_netconf -qf $cfgs" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>1</name><x>1</x></a><a><name>2</name><x>2</x></a></c></data></rpc-reply>"
+
+new "change, delete and add entries and commit in active"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><a><name>1</name><x>11</x></a><a nc:operation=\"delete\"><name>2</name></a><a><name>3</name><x>3</x></a></c></config></edit-config></rpc><rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply><rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+sleep 1
+
+new "standby running has delta applied"
+expecteof_netconf "$clixon_netconf -qf $cfgs" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>1</name><x>11</x></a><a><name>3</name><x>3</x></a></c></data></rpc-reply>"
+
+new "standby candidate has delta applied"
+expecteof_netconf "$clixon_netconf -qf $cfgs" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><name>1</name><x>11</x></a><a><name>3</name><x>3</x></a></c></data></rpc-reply>"
+
+new "delta out of sequence is rejected by standby"
+expecteof_netconf "$clixon_netconf -qf $cfgs" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><replicate $LIBNS><sequence>100</sequence><config/></replicate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>Replica out of sequence</error-message></rpc-error></rpc-reply>"
+
+new "replicate is not supported by active backend"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><replicate $LIBNS><sequence>1</sequence><full>true</full><config/></replicate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-not-supported</error-tag>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill active backend"
+    stop_backend -f $cfg
+    new "Kill standby backend"
+    stop_backend -f $cfgs
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
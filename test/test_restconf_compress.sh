@@ -0,0 +1,141 @@
+#!/usr/bin/env bash
+# Native restconf gzip content-coding of replies and request bodies
+# See CLICON_RESTCONF_COMPRESS_LEVEL and CLICON_RESTCONF_COMPRESS_MIN
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Only native restconf with zlib
+if [ "${WITH_RESTCONF}" != "native" -o "${HAVE_LIBZ}" != "true" ]; then
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_RESTCONF_COMPRESS_LEVEL>1</CLICON_RESTCONF_COMPRESS_LEVEL>
+  <CLICON_RESTCONF_COMPRESS_MIN>200</CLICON_RESTCONF_COMPRESS_MIN>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "k";
+         leaf k{
+            type uint32;
+         }
+         leaf v{
+            type string;
+         }
+      }
+   }
+   container d{
+      leaf x{
+         type uint32;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+data='{"example:c":{"a":['
+for (( i=0; i<100; i++ )); do
+    data+="{\"k\":$i,\"v\":\"value $i\"},"
+done
+data+='{"k":100,"v":"value 100"}]}}'
+
+new "restconf PUT gzip request body"
+expectpart "$(echo "$data" | gzip | curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -H "Content-Encoding: gzip" --data-binary @- $RCPROTO://localhost/restconf/data/example:c)" 0 "HTTP/$HVER 201"
+
+new "restconf PUT small entry"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -d '{"example:d":{"x":42}}' $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 201"
+
+new "restconf GET compressed"
+expectpart "$(curl $CURLOPTS --compressed -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:c)" 0 "HTTP/$HVER 200" "Content-Encoding: gzip" "Vary: Accept-Encoding" '{"k":100,"v":"value 100"}'
+
+new "restconf GET gzip not accepted"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "Accept-Encoding: gzip;q=0, identity" $RCPROTO://localhost/restconf/data/example:c)" 0 "HTTP/$HVER 200" '{"k":100,"v":"value 100"}' --not-- "Content-Encoding"
+
+new "restconf GET small reply not compressed"
+expectpart "$(curl $CURLOPTS --compressed -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 200" '{"example:d":{"x":42}}' --not-- "Content-Encoding"
+
+new "restconf PUT invalid gzip request body"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -H "Content-Encoding: gzip" -d '{"example:d":{"x":43}}' $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 400" "malformed-message"
+
+new "restconf PUT unsupported content-encoding"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -H "Content-Encoding: br" -d '{"example:d":{"x":43}}' $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 415" "Accept-Encoding: gzip"
+
+new "restconf GET unchanged"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 200" '{"example:d":{"x":42}}'
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
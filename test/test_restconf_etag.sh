@@ -0,0 +1,148 @@
+#!/usr/bin/env bash
+# Restconf entity-tag and last-modified of configuration data, RFC 8040 Sec 3.5.2
+# Conditional GET with If-None-Match and If-Modified-Since replies 304 if running is unchanged
+# State data has no entity-tag
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "k";
+         leaf k{
+            type uint32;
+         }
+      }
+   }
+   container s{
+      config false;
+      leaf x{
+         type uint32;
+      }
+   }
+}
+EOF
+
+# Get value of header $1 of reply $2
+function header()
+{
+    echo "$2" | grep -i "^$1:" | sed -e "s/^[^:]*: *//" | tr -d '\r'
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "restconf PUT entry"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:c/a=1 -d '{"example:a":{"k":1}}')" 0 "HTTP/$HVER 201"
+
+new "restconf GET with entity-tag"
+ret=$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:c)
+expectpart "$ret" 0 "HTTP/$HVER 200" '{"example:c":{"a":\[{"k":1}\]}}'
+etag=$(header etag "$ret")
+lastmod=$(header last-modified "$ret")
+if [ -z "$etag" -o -z "$lastmod" ]; then
+    err "ETag and Last-Modified" "$ret"
+fi
+
+new "restconf GET If-None-Match unchanged"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "If-None-Match: $etag" $RCPROTO://localhost/restconf/data/example:c)" 0 "HTTP/$HVER 304" --not-- '"example:c"'
+
+new "restconf GET If-Modified-Since unchanged"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "If-Modified-Since: $lastmod" $RCPROTO://localhost/restconf/data/example:c/a=1)" 0 "HTTP/$HVER 304"
+
+new "restconf GET state has no entity-tag"
+ret=$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "If-None-Match: *" $RCPROTO://localhost/restconf/data/example:s)
+if [ -n "$(header etag "$ret")" ]; then
+    err "No ETag" "$ret"
+fi
+
+sleep 1
+
+new "restconf PUT other entry"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:c/a=2 -d '{"example:a":{"k":2}}')" 0 "HTTP/$HVER 201"
+
+new "restconf GET If-None-Match changed"
+ret=$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "If-None-Match: $etag" $RCPROTO://localhost/restconf/data/example:c)
+expectpart "$ret" 0 "HTTP/$HVER 200" '{"example:c":{"a":\[{"k":1},{"k":2}\]}}'
+if [ "$(header etag "$ret")" = "$etag" ]; then
+    err "New ETag" "$etag"
+fi
+
+new "restconf GET If-Modified-Since changed"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "If-Modified-Since: $lastmod" $RCPROTO://localhost/restconf/data/example:c)" 0 "HTTP/$HVER 200" '{"example:c":{"a":\[{"k":1},{"k":2}\]}}'
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,157 @@
+#!/usr/bin/env bash
+# Native restconf HTTP/1.1 request parsing of raw requests over a plain socket:
+# pipelined and queued requests, request headers and body split over several reads, malformed requests
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Only native restconf
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Raw requests are sent over plain http
+RESTCONFIG=$(restconf_config none false http)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf x{
+         type uint32;
+      }
+   }
+}
+EOF
+
+# Send raw request parts $* on one connection, pause between parts, print replies
+function rawreq()
+{
+    exec 3<>/dev/tcp/127.0.0.1/80
+    for part in "$@"; do
+        printf "$part" >&3
+        sleep 0.2
+    done
+    timeout 1 cat <&3
+    exec 3<&-
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf http
+
+body='{"example:c":{"x":42}}'
+
+new "request split over several reads"
+expectpart "$(rawreq "PUT /restconf/data/example:c HTTP/1.1\r\nHost: localhost\r\nContent-Ty" "pe: application/yang-data+json\r\nContent-Length: ${#body}\r\n" "\r\n{\"example:c\"" ":{\"x\":42}}")" 0 "HTTP/1.1 201"
+
+new "pipelined requests in one read"
+ret=$(rawreq "GET /restconf/data/example:c HTTP/1.1\r\nHost: localhost\r\nAccept: application/yang-data+json\r\n\r\nGET /restconf/data/example:c?depth=1 HTTP/1.1\r\nHost: localhost\r\nAccept: application/yang-data+xml\r\n\r\n")
+expectpart "$ret" 0 "HTTP/1.1 200" '{"example:c":{"x":42}}' '<c xmlns="urn:example:clixon"><x>42</x></c>'
+if [ $(echo "$ret" | grep -c "HTTP/1.1 200") -ne 2 ]; then
+    err1 "two replies" "$ret"
+fi
+
+new "pipelined request after body"
+ret=$(rawreq "PUT /restconf/data/example:c HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/yang-data+json\r\nContent-Length: 22\r\n\r\n{\"example:c\":{\"x\":43}}GET /restconf/data/example:c HTTP/1.1\r\nHost: localhost\r\nAccept:   application/yang-data+json  \r\n\r\n")
+expectpart "$ret" 0 "HTTP/1.1 204" "HTTP/1.1 200" '{"example:c":{"x":43}}'
+
+# Many pipelined requests, more than HTTP1_PIPELINE_BATCH, some are queued in the connection
+req="GET /restconf/data/example:c HTTP/1.1\r\nHost: localhost\r\nAccept: application/yang-data+json\r\n\r\n"
+reqs=""
+for (( i=0; i<100; i++ )); do
+    reqs+=$req
+done
+
+new "100 pipelined requests on keep-alive connection"
+ret=$(rawreq "$reqs")
+if [ $(echo "$ret" | grep -c "HTTP/1.1 200") -ne 100 ]; then
+    err1 "100 replies" "$(echo "$ret" | grep -c "HTTP/1.1 200")"
+fi
+
+new "malformed request-line"
+expectpart "$(rawreq "GET restconf HTTP/1.1\r\nHost: localhost\r\n\r\n")" 0 "HTTP/1.1 400" "malformed-message"
+
+new "malformed header field"
+expectpart "$(rawreq "GET /restconf HTTP/1.1\r\nHost localhost\r\n\r\n")" 0 "HTTP/1.1 400" "malformed-message"
+
+new "non-numeric Content-Length"
+expectpart "$(rawreq "PUT /restconf/data/example:c HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/yang-data+json\r\nContent-Length: 22x\r\n\r\n{\"example:c\":{\"x\":44}}")" 0 "HTTP/1.1 400" "malformed-message" "Invalid Content-Length"
+
+new "negative Content-Length"
+expectpart "$(rawreq "PUT /restconf/data/example:c HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/yang-data+json\r\nContent-Length: -1\r\n\r\n")" 0 "HTTP/1.1 400" "malformed-message"
+
+new "Content-Length too large"
+expectpart "$(rawreq "PUT /restconf/data/example:c HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/yang-data+json\r\nContent-Length: 99999999999999999999999\r\n\r\n")" 0 "HTTP/1.1 400" "malformed-message"
+
+new "restconf still serves requests"
+expectpart "$(curl -sSik --http1.1 -X GET http://localhost/restconf/yang-library-version)" 0 "HTTP/1.1 200"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+# Native restconf HTTP/2 concurrent streams on one connection
+# Requests, also with bodies, of multiplexed streams are dispatched after they are received
+# See CLICON_RESTCONF_HTTP2_MAX_STREAMS
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Only native restconf with http/2
+if [ "${WITH_RESTCONF}" != "native" -o "${HAVE_LIBNGHTTP2}" != "true" ]; then
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# http/2 is negotiated with TLS ALPN
+RESTCONFIG=$(restconf_config none false https)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_RESTCONF_HTTP2_MAX_STREAMS>10</CLICON_RESTCONF_HTTP2_MAX_STREAMS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf x{
+         type uint32;
+      }
+      leaf y{
+         type uint32;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf https
+
+H2OPTS="-Ssik --http2 --parallel --parallel-immediate --parallel-max 20"
+
+new "parallel PUT with bodies on one connection"
+ret=$(curl $H2OPTS -X PUT -H "Content-Type: application/yang-data+json" -d '{"example:x":1}' https://localhost/restconf/data/example:c/x --next -X PUT -H "Content-Type: application/yang-data+json" -d '{"example:y":2}' https://localhost/restconf/data/example:c/y)
+if [ $(echo "$ret" | grep -c "HTTP/2 201") -ne 2 ]; then
+    err1 "two HTTP/2 201" "$ret"
+fi
+
+new "parallel GET on one connection"
+urls=""
+for (( i=0; i<30; i++ )); do
+    urls+=" https://localhost/restconf/data/example:c/x https://localhost/restconf/data/example:c/y"
+done
+ret=$(curl $H2OPTS -X GET -H "Accept: application/yang-data+json" $urls)
+if [ $(echo "$ret" | grep -c '{"example:x":1}') -ne 30 ]; then
+    err1 '30 {"example:x":1}' "$ret"
+fi
+if [ $(echo "$ret" | grep -c '{"example:y":2}') -ne 30 ]; then
+    err1 '30 {"example:y":2}' "$ret"
+fi
+
+new "restconf still serves requests"
+expectpart "$(curl -Ssik --http2 -X GET -H "Accept: application/yang-data+json" https://localhost/restconf/data/example:c)" 0 "HTTP/2 200" '{"example:c":{"x":1,"y":2}}'
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,111 @@
+#!/usr/bin/env bash
+# Native restconf Prometheus metrics endpoint with restconf and backend counters
+# See CLICON_RESTCONF_METRICS_PATH
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Only native restconf
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_RESTCONF_METRICS_PATH>/metrics</CLICON_RESTCONF_METRICS_PATH>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container d{
+      leaf x{
+         type uint32;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "restconf PUT entry"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -d '{"example:d":{"x":42}}' $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 201"
+
+new "metrics restconf counters"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/metrics)" 0 "HTTP/$HVER 200" "Content-Type: text/plain; version=0.0.4" "# TYPE clixon_restconf_requests_total counter" 'clixon_restconf_requests_total{method="PUT",code="201"} 1' 'clixon_restconf_request_duration_seconds_bucket{method="PUT",le="+Inf"} 1' "clixon_restconf_connections " "clixon_restconf_connection_bytes [1-9]"
+
+new "metrics backend counters"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/metrics)" 0 "HTTP/$HVER 200" "clixon_backend_up 1" "clixon_backend_commits_total [1-9]" "clixon_backend_commit_failures_total 0" 'clixon_backend_datastore_nodes{db="running"}'
+
+new "metrics POST not allowed"
+expectpart "$(curl $CURLOPTS -X POST $RCPROTO://localhost/metrics)" 0 "HTTP/$HVER 405" "Allow: GET,HEAD"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
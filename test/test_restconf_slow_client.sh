@@ -0,0 +1,143 @@
+#!/usr/bin/env bash
+# Native restconf non-blocking output, see native_buf_write and restconf_conn_output_wait
+# A client that reads a large reply slowly does not block replies to other clients
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Only native restconf
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Number of list entries, reply of several MB
+: ${perfnr:=20000}
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "k";
+         leaf k{
+            type uint32;
+         }
+         leaf v{
+            type string;
+         }
+      }
+   }
+   container d{
+      leaf x{
+         type uint32;
+      }
+   }
+}
+EOF
+
+new "generate config with $perfnr list entries"
+v=$(printf "%0200d" 0)
+echo "<config><c xmlns=\"urn:example:clixon\">" > $dir/startup_db
+for (( i=0; i<$perfnr; i++ )); do
+    echo "<a><k>$i</k><v>$v</v></a>" >> $dir/startup_db
+done
+echo "</c><d xmlns=\"urn:example:clixon\"><x>42</x></d></config>" >> $dir/startup_db
+
+new "test params: -f $cfg -s startup"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "slow client reads large config"
+curl $CURLOPTS --limit-rate 100k -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:c > $dir/slow.out 2>&1 &
+pid=$!
+sleep 2
+
+new "other client is served meanwhile"
+t0=$(date +%s)
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 200" '{"example:d":{"x":42}}'
+t1=$(date +%s)
+if [ $((t1-t0)) -gt 2 ]; then
+    err "less than 2 s" "$((t1-t0)) s"
+fi
+
+new "slow client still reading"
+if ! kill -0 $pid 2> /dev/null; then
+    err "slow client running" "$(head -c 256 $dir/slow.out)"
+fi
+kill $pid 2> /dev/null
+wait $pid 2> /dev/null
+
+new "server serves after slow client is gone"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 200" '{"example:d":{"x":42}}'
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,150 @@
+#!/usr/bin/env bash
+# Native restconf TLS session resumption with session cache and session tickets
+# See CLICON_RESTCONF_TLS_SESSION_CACHE and CLICON_RESTCONF_TLS_TICKET_ROTATE
+# A client reconnecting with the session of a previous connection resumes it
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Skip if other than native
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Always TLS
+RESTCONFIG=$(restconf_config none false https)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+# Create config with session cache size $1 and ticket rotation $2
+function mkconfig()
+{
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_RESTCONF_TLS_SESSION_CACHE>$1</CLICON_RESTCONF_TLS_SESSION_CACHE>
+  <CLICON_RESTCONF_TLS_TICKET_ROTATE>$2</CLICON_RESTCONF_TLS_TICKET_ROTATE>
+  $RESTCONFIG
+</clixon-config>
+EOF
+}
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf x{
+         type uint32;
+      }
+   }
+}
+EOF
+
+# TLS 1.2 connection with options $*, print if new or reused session
+function connect()
+{
+    echo | openssl s_client -connect localhost:443 -tls1_2 $* 2> /dev/null | grep -E "^(New|Reused), TLS"
+}
+
+# Start restconf with session cache size $1 and ticket rotation $2
+function restconf_start()
+{
+    mkconfig $1 $2
+    if [ $RC -ne 0 ]; then
+        new "kill old restconf daemon"
+        stop_restconf_pre
+
+        new "start restconf daemon cache:$1 rotate:$2"
+        start_restconf -f $cfg
+    fi
+
+    new "wait restconf"
+    wait_restconf
+}
+
+function restconf_stop()
+{
+    if [ $RC -ne 0 ]; then
+        new "Kill restconf daemon"
+        stop_restconf
+    fi
+}
+
+mkconfig 1024 3600
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+restconf_start 1024 3600
+
+new "session ticket: first connection"
+expectpart "$(connect -sess_out $dir/ticket.pem)" 0 "New, TLS"
+
+new "session ticket: resumed"
+expectpart "$(connect -sess_in $dir/ticket.pem)" 0 "Reused, TLS"
+
+new "session cache: first connection"
+expectpart "$(connect -no_ticket -sess_out $dir/session.pem)" 0 "New, TLS"
+
+new "session cache: resumed"
+expectpart "$(connect -no_ticket -sess_in $dir/session.pem)" 0 "Reused, TLS"
+
+new "restconf still serves requests"
+expectpart "$(curl $CURLOPTS -X GET https://localhost/restconf/yang-library-version)" 0 "HTTP/$HVER 200"
+
+restconf_stop
+
+restconf_start 0 0
+
+new "no resumption: first connection"
+expectpart "$(connect -sess_out $dir/session.pem)" 0 "New, TLS"
+
+new "no resumption: not resumed"
+expectpart "$(connect -sess_in $dir/session.pem)" 0 "New, TLS"
+
+restconf_stop
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
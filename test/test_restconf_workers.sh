@@ -0,0 +1,133 @@
+#!/usr/bin/env bash
+# Restconf with several worker processes, see CLICON_RESTCONF_WORKERS
+# Parallel clients are accepted by the workers, and each worker has its own backend session
+# Native workers accept on the same listening sockets, fcgi workers on the same fcgi socket
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Number of restconf processes
+: ${workers:=4}
+
+# Number of parallel clients
+: ${nr:=20}
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_RESTCONF_WORKERS>$workers</CLICON_RESTCONF_WORKERS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "k";
+         leaf k{
+            type uint32;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "Check $workers restconf processes"
+n=$(pgrep -f "clixon_restconf .*-f $cfg" | wc -l)
+if [ $n -lt $workers ]; then
+    err "$workers restconf processes" "$n"
+fi
+
+new "restconf PUT $nr entries in parallel"
+for (( i=0; i<$nr; i++ )); do
+    curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:c/a=$i -d "{\"example:a\":{\"k\":$i}}" > $dir/put$i &
+done
+wait
+for (( i=0; i<$nr; i++ )); do
+    expectpart "$(cat $dir/put$i)" 0 "HTTP/$HVER 201"
+done
+
+new "restconf GET all entries"
+ret=$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:c)
+n=$(echo "$ret" | grep -o '"k":' | wc -l)
+if [ $n -ne $nr ]; then
+    err "$nr entries" "$n"
+fi
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+
+    new "Check no restconf processes left"
+    sleep 1
+    n=$(pgrep -f "clixon_restconf .*-f $cfg" | wc -l)
+    if [ $n -ne 0 ]; then
+        err "0 restconf processes" "$n"
+    fi
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
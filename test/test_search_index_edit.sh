@@ -0,0 +1,117 @@
+#!/usr/bin/env bash
+# Explicit search index maintenance on datastore edits, see XML_EXPLICIT_INDEX
+# Index declared both by extension and by CLICON_YANG_SEARCH_INDEX option
+# Backend runs with debug datastore+detail, which verifies search vectors after each edit
+# and returns error if inconsistent
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_SEARCH_INDEX>/ex:routes/ex:route/ex:nexthop</CLICON_YANG_SEARCH_INDEX>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  import clixon-config {
+    prefix "cc";
+  }
+  container interfaces{
+    list interface{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf ifindex{
+        type uint32;
+        cc:search_index;
+      }
+    }
+  }
+  container routes{
+    list route{
+      key prefix;
+      leaf prefix{
+        type string;
+      }
+      leaf nexthop{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -D datastore -D detail"
+    start_backend -s init -f $cfg -D datastore -D detail
+fi
+
+new "wait backend"
+wait_backend
+
+new "add interfaces and routes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth0</name><ifindex>3</ifindex></interface><interface><name>eth1</name><ifindex>1</ifindex></interface><interface><name>eth2</name><ifindex>2</ifindex></interface></interfaces><routes xmlns=\"urn:example:clixon\"><route><prefix>10.0.0.0/8</prefix><nexthop>b</nexthop></route><route><prefix>11.0.0.0/8</prefix><nexthop>a</nexthop></route></routes></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "change index value"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth0</name><ifindex>0</ifindex></interface></interfaces><routes xmlns=\"urn:example:clixon\"><route><prefix>10.0.0.0/8</prefix><nexthop>c</nexthop></route></routes></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "remove index leaf"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\"><interface><name>eth2</name><ifindex nc:operation=\"delete\"/></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "delete list entries"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\"><interface nc:operation=\"delete\"><name>eth1</name></interface></interfaces><routes xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\"><route nc:operation=\"delete\"><prefix>11.0.0.0/8</prefix></route></routes></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "replace config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><default-operation>replace</default-operation><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth3</name><ifindex>7</ifindex></interface><interface><name>eth0</name><ifindex>5</ifindex></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "add to candidate after discard"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth4</name><ifindex>4</ifindex></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config candidate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth0</name><ifindex>0</ifindex></interface><interface><name>eth2</name></interface><interface><name>eth4</name><ifindex>4</ifindex></interface></interfaces><routes xmlns=\"urn:example:clixon\"><route><prefix>10.0.0.0/8</prefix><nexthop>c</nexthop></route></routes></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
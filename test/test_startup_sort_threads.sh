@@ -0,0 +1,100 @@
+#!/usr/bin/env bash
+# Sort startup datastore in several threads, see CLICON_XMLDB_SORT_THREADS
+# Startup has several top-level subtrees with unsorted lists, result should be sorted
+# Also compact the lists after reading, see CLICON_XMLDB_COMPACT_LISTS
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+# Number of list entries of each list
+: ${nr:=50}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_SORT_THREADS>4</CLICON_XMLDB_SORT_THREADS>
+  <CLICON_XMLDB_COMPACT_LISTS>10</CLICON_XMLDB_COMPACT_LISTS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  grouping tab{
+    list parameter{
+      key name;
+      leaf name{
+        type uint32;
+      }
+    }
+  }
+  container a{
+    uses tab;
+  }
+  container b{
+    uses tab;
+  }
+  container c{
+    container d{
+      uses tab;
+    }
+  }
+}
+EOF
+
+rev=""
+all=""
+for (( i=0; i<$nr; i++ )); do
+    let r=$nr-$i-1
+    rev="$rev<parameter><name>$r</name></parameter>"
+    all="$all<parameter><name>$i</name></parameter>"
+done
+
+# Unsorted, and top-level symbols in wrong order
+echo "<${DATASTORE_TOP}><c xmlns=\"urn:example:clixon\"><d>$rev</d></c><b xmlns=\"urn:example:clixon\">$rev</b><a xmlns=\"urn:example:clixon\">$rev</a></${DATASTORE_TOP}>" > $dir/startup_db
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get-config sorted"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\">$all</a><b xmlns=\"urn:example:clixon\">$all</b><c xmlns=\"urn:example:clixon\"><d>$all</d></c></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,89 @@
+#!/usr/bin/env bash
+# Backend startup timing: time of each startup phase and plugin callback
+# Shown in the stats RPC, and logged with backend option -T
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+  <table xmlns="urn:example:clixon">
+    <parameter><name>a</name></parameter>
+  </table>
+</${DATASTORE_TOP}>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg -T"
+    start_backend -s startup -f $cfg -T
+fi
+
+new "wait backend"
+wait_backend
+
+new "stats startup-timing has phases in order"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"><startup-timing>true</startup-timing></stats></rpc>" "<startup-timing xmlns=\"http://clicon.org/lib\"><usec>[1-9][0-9]*</usec><phase><name>options</name><usec>[0-9]*</usec></phase>.*<phase><name>yang-parse</name>.*<phase><name>startup-read</name>.*<phase><name>startup-validate</name>.*<phase><name>startup-commit</name>.*<phase><name>plugin-start</name>.*<phase><name>socket</name>"
+
+new "stats startup-timing has plugin callbacks"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"><startup-timing>true</startup-timing></stats></rpc>" "<plugin><name>example_backend</name><callback>init</callback><usec>[0-9]*</usec></plugin>.*<plugin><name>example_backend</name><callback>start</callback>"
+
+new "startup timing not included by default"
+rpc=$(chunked_framing "<rpc $DEFAULTNS><stats $LIBNS/></rpc>")
+expectpart "$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg)" 0 "<global" --not-- "startup-timing"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,106 @@
+#!/usr/bin/env bash
+# State data cache with TTL, see ca_statedata_ttl
+# Using the -sS <file> state capability of the main example with -T <ms> cache TTL
+# State read within the TTL is the cached state, also for xpaths below the cached xpath
+# After the TTL the state file is read again
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fstate=$dir/state.xml
+fyang=$dir/state.yang
+
+# State cache TTL in ms
+: ${ttl:=3000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module state{
+    yang-version 1.1;
+    namespace "urn:example:example";
+    prefix ex;
+    container counters{
+        config false;
+        leaf in{
+            type uint32;
+        }
+        leaf out{
+            type uint32;
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fstate
+<counters xmlns="urn:example:example"><in>1</in><out>2</out></counters>
+EOF
+
+new "test params: -f $cfg -- -sS $fstate -T $ttl"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -sS $fstate -T $ttl"
+    start_backend -s init -f $cfg -- -sS $fstate -T $ttl
+fi
+
+new "wait backend"
+wait_backend
+
+new "get counters"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:counters\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:example\"><in>1</in><out>2</out></counters></data></rpc-reply>"
+
+cat <<EOF > $fstate
+<counters xmlns="urn:example:example"><in>10</in><out>20</out></counters>
+EOF
+
+new "get counters within ttl is cached"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:counters\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:example\"><in>1</in><out>2</out></counters></data></rpc-reply>"
+
+new "get counters/in within ttl is cached"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:counters/ex:in\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:example\"><in>1</in></counters></data></rpc-reply>"
+
+new "get counters with other prefix is not cached"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/st:counters\" xmlns:st=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:example\"><in>10</in><out>20</out></counters></data></rpc-reply>"
+
+sleep $(( (ttl+999)/1000 + 1 ))
+
+new "get counters after ttl"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:counters\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:example\"><in>10</in><out>20</out></counters></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,132 @@
+#!/usr/bin/env bash
+# State data is not sorted when it is received from state callbacks, see XML_SORT_LAZY
+# Using the -s state capability of the main example, which returns keyed lists of the
+# urn:example:lazy namespace in reverse key order
+# State merged into config lists and state-only lists are sorted when first searched by key,
+# ie XPath predicates and merge, and when printed
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/lazy.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module lazy{
+    yang-version 1.1;
+    namespace "urn:example:lazy";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+            leaf counter{
+                config false;
+                type uint32;
+            }
+        }
+    }
+    container stats{
+        config false;
+        list entry{
+            key id;
+            leaf id{
+                type uint32;
+            }
+            leaf count{
+                type uint32;
+            }
+        }
+    }
+}
+EOF
+
+new "test params: -f $cfg -- -s"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -s"
+    start_backend -s init -f $cfg -- -s
+fi
+
+new "wait backend"
+wait_backend
+
+new "add config parameters"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:lazy\"><parameter><name>b</name><value>vb</value></parameter><parameter><name>a</name><value>va</value></parameter><parameter><name>c</name><value>vc</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get state merged into config, sorted"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table\" xmlns:ex=\"urn:example:lazy\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:lazy\"><parameter><name>a</name><value>va</value><counter>1</counter></parameter><parameter><name>b</name><value>vb</value><counter>2</counter></parameter><parameter><name>c</name><value>vc</value><counter>3</counter></parameter></table></data></rpc-reply>"
+
+for n in a b c; do
+    case $n in
+        a) c=1;;
+        b) c=2;;
+        c) c=3;;
+    esac
+    new "get parameter $n with key predicate"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='$n']\" xmlns:ex=\"urn:example:lazy\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:lazy\"><parameter><name>$n</name><value>v$n</value><counter>$c</counter></parameter></table></data></rpc-reply>"
+done
+
+new "get state leaf of parameter b with key predicate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='b']/ex:counter\" xmlns:ex=\"urn:example:lazy\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:lazy\"><parameter><name>b</name><counter>2</counter></parameter></table></data></rpc-reply>"
+
+new "get state-only list, sorted by numeric key"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:stats\" xmlns:ex=\"urn:example:lazy\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><stats xmlns=\"urn:example:lazy\"><entry><id>9</id><count>90</count></entry><entry><id>20</id><count>200</count></entry><entry><id>30</id><count>300</count></entry></stats></data></rpc-reply>"
+
+for id in 9 20 30; do
+    new "get state-only entry $id with key predicate"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:stats/ex:entry[ex:id='$id']/ex:count\" xmlns:ex=\"urn:example:lazy\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><stats xmlns=\"urn:example:lazy\"><entry><id>$id</id><count>${id}0</count></entry></stats></data></rpc-reply>"
+done
+
+new "get state-only entry that does not exist"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:stats/ex:entry[ex:id='10']\" xmlns:ex=\"urn:example:lazy\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "get state entries with count greater than 100"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:stats/ex:entry[ex:count>100]\" xmlns:ex=\"urn:example:lazy\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><stats xmlns=\"urn:example:lazy\"><entry><id>20</id><count>200</count></entry><entry><id>30</id><count>300</count></entry></stats></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
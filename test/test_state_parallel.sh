@@ -0,0 +1,152 @@
+#!/usr/bin/env bash
+# Parallel statedata callbacks, see ca_statedata_parallel and CLICON_BACKEND_PLUGIN_THREADS
+# Compile the same backend plugin twice, each with a thread-safe statedata callback that
+# sleeps before returning its own state container.
+# A get of all state calls both callbacks in parallel and merges the trees
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/state.yang
+cfile=$dir/example-state.c
+pdir=$dir/plugin
+
+# Seconds each statedata callback sleeps
+: ${delay:=2}
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+  <CLICON_BACKEND_PLUGIN_THREADS>2</CLICON_BACKEND_PLUGIN_THREADS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module state{
+    yang-version 1.1;
+    namespace "urn:example:example";
+    prefix ex;
+    container state-a{
+        config false;
+        leaf value{
+            type string;
+        }
+    }
+    container state-b{
+        config false;
+        leaf value{
+            type string;
+        }
+    }
+}
+EOF
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* Clixon */
+#include <clixon/clixon.h>
+#include <clixon/clixon_backend.h>
+
+static int
+state_parallel(clixon_handle h,
+               cvec         *nsc,
+               char         *xpath,
+               cxobj        *xstate)
+{
+    sleep(DELAY);
+    if (clixon_xml_parse_string("<state-" NAME " xmlns=\"urn:example:example\">"
+                                "<value>" NAME "</value>"
+                                "</state-" NAME ">", YB_NONE, NULL, &xstate, NULL) < 0)
+        return -1;
+    return 0;
+}
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static clixon_plugin_api api = {
+    "state-" NAME,      /* name */
+    clixon_plugin_init, /* init */
+    .ca_statedata=state_parallel,
+    .ca_statedata_parallel=1
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    return &api;
+}
+EOF
+
+for n in a b; do
+    new "compile $cfile for $n"
+    # -I /usr/local_include for eg freebsd
+    expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include -DNAME=\"$n\" -DDELAY=$delay $cfile -o $pdir/example-state-$n.so)" 0 ""
+done
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get state of both plugins"
+t0=$(date +%s)
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"/></rpc>" "" "<rpc-reply $DEFAULTNS><data><state-a xmlns=\"urn:example:example\"><value>a</value></state-a><state-b xmlns=\"urn:example:example\"><value>b</value></state-b></data></rpc-reply>"
+t1=$(date +%s)
+
+new "callbacks called in parallel"
+if [ $((t1-t0)) -ge $((2*delay)) ]; then
+    err "less than $((2*delay)) s" "$((t1-t0)) s"
+fi
+
+new "get state of one plugin"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:state-b\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><state-b xmlns=\"urn:example:example\"><value>b</value></state-b></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
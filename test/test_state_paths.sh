@@ -0,0 +1,108 @@
+#!/usr/bin/env bash
+# State data paths, see ca_statedata_paths
+# Using the -sS <file> state capability of the main example with -p <path>
+# The state callback is only called for gets of xpaths that intersect the path, gets of
+# other subtrees skip the callback
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fstate=$dir/state.xml
+fyang=$dir/state.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module state{
+    yang-version 1.1;
+    namespace "urn:example:example";
+    prefix ex;
+    container counters{
+        config false;
+        list counter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type uint32;
+            }
+        }
+    }
+    container clock{
+        config false;
+        leaf time{
+            type string;
+        }
+    }
+}
+EOF
+
+# Clock is outside of the state path, only returned when the callback is called for other reasons
+cat <<EOF > $fstate
+<counters xmlns="urn:example:example"><counter><name>in</name><value>1</value></counter></counters>
+<clock xmlns="urn:example:example"><time>now</time></clock>
+EOF
+
+new "test params: -f $cfg -- -sS $fstate -p /ex:counters"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -sS $fstate -p /ex:counters"
+    start_backend -s init -f $cfg -- -sS $fstate -p /ex:counters
+fi
+
+new "wait backend"
+wait_backend
+
+new "get counters"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:counters\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:example\"><counter><name>in</name><value>1</value></counter></counters></data></rpc-reply>"
+
+new "get counter with predicate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/st:counters/st:counter[st:name='in']/st:value\" xmlns:st=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:example\"><counter><name>in</name><value>1</value></counter></counters></data></rpc-reply>"
+
+new "get clock, callback not called"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:clock\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "get union of clock and counters"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:clock | /ex:counters\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:example\"><counter><name>in</name><value>1</value></counter></counters><clock xmlns=\"urn:example:example\"><time>now</time></clock></data></rpc-reply>"
+
+new "get all"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"/></rpc>" "" "<rpc-reply $DEFAULTNS><data><counters xmlns=\"urn:example:example\"><counter><name>in</name><value>1</value></counter></counters><clock xmlns=\"urn:example:example\"><time>now</time></clock></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,184 @@
+#!/usr/bin/env bash
+# State list producers, see clixon_statelist_cb_register and STATELIST_BATCH
+# A backend plugin registers a producer of a large operational list, which is called in
+# batches of entries in key order. A get of the list streams the batches to the reply, and
+# list pagination lets the producer seek to the offset
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/rib.yang
+cfile=$dir/example-rib.c
+pdir=$dir/plugin
+
+# Number of routes, more than one batch
+: ${nr:=3000}
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module rib{
+    yang-version 1.1;
+    namespace "urn:example:example";
+    prefix ex;
+    container rib{
+        config false;
+        list route{
+            key id;
+            leaf id{
+                type uint32;
+            }
+            leaf nexthop{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* Clixon */
+#include <clixon/clixon.h>
+#include <clixon/clixon_backend.h>
+
+/*! Produce routes 0..NR-1 in key order, continuing after the cursor
+ */
+static int
+rib_producer(void          *h,
+             char          *xpath,
+             statelist_data sd,
+             void          *arg)
+{
+    int         retval = -1;
+    cxobj      *xstate = statelist_xstate(sd);
+    const char *cursor;
+    cbuf       *cb = NULL;
+    uint32_t    id;
+    uint32_t    i;
+    char        str[16];
+
+    if ((cursor = statelist_cursor(sd)) == NULL)
+        id = statelist_offset(sd);
+    else
+        id = strtoul(cursor, NULL, 10) + 1;
+    if ((cb = cbuf_new()) == NULL)
+        goto done;
+    cprintf(cb, "<rib xmlns=\"urn:example:example\">");
+    for (i=0; i<statelist_batch(sd) && id < NR; i++, id++)
+        cprintf(cb, "<route><id>%u</id><nexthop>10.0.0.%u</nexthop></route>", id, id%256);
+    cprintf(cb, "</rib>");
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xstate, NULL) < 0)
+        goto done;
+    snprintf(str, sizeof(str), "%u", id-1);
+    if (statelist_cursor_set(sd, str) < 0)
+        goto done;
+    if (id >= NR)
+        statelist_end_set(sd);
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static clixon_plugin_api api = {
+    "rib",              /* name */
+    clixon_plugin_init, /* init */
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    if (clixon_statelist_cb_register(h, rib_producer, "/ex:rib/ex:route", NULL) < 0)
+        return NULL;
+    return &api;
+}
+EOF
+
+new "compile $cfile"
+# -I /usr/local_include for eg freebsd
+expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include -DNR=$nr $cfile -o $pdir/example-rib.so)" 0 ""
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get all routes, first route"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:rib/ex:route\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "<rpc-reply $DEFAULTNS><data><rib xmlns=\"urn:example:example\"><route><id>0</id><nexthop>10.0.0.0</nexthop></route><route><id>1</id>" ""
+
+new "get all routes, last route"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:rib/ex:route\" xmlns:ex=\"urn:example:example\"/></get></rpc>" "<route><id>$((nr-1))</id><nexthop>10.0.0.$(((nr-1)%256))</nexthop></route></rib></data></rpc-reply>" ""
+
+new "get all routes, count"
+ret=$($clixon_netconf -qf $cfg <<EOF
+$DEFAULTHELLO$(chunked_framing "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:rib/ex:route\" xmlns:ex=\"urn:example:example\"/></get></rpc>")
+EOF
+)
+n=$(echo "$ret" | grep -o "<route>" | wc -l)
+if [ $n -ne $nr ]; then
+    err "$nr" "$n"
+fi
+
+new "list pagination of routes across batches"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:rib/ex:route\" xmlns:ex=\"urn:example:example\"/><list-pagination xmlns=\"urn:ietf:params:xml:ns:yang:ietf-list-pagination-nc\"><offset>1023</offset><limit>3</limit></list-pagination></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><rib xmlns=\"urn:example:example\"><route><id>1023</id><nexthop>10.0.0.255</nexthop></route><route><id>1024</id><nexthop>10.0.0.0</nexthop></route><route><id>1025</id><nexthop>10.0.0.1</nexthop></route></rib></data></rpc-reply>"
+
+new "list pagination of last routes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:rib/ex:route\" xmlns:ex=\"urn:example:example\"/><list-pagination xmlns=\"urn:ietf:params:xml:ns:yang:ietf-list-pagination-nc\"><offset>$((nr-1))</offset><limit>10</limit></list-pagination></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><rib xmlns=\"urn:example:example\"><route><id>$((nr-1))</id><nexthop>10.0.0.$(((nr-1)%256))</nexthop></route></rib></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
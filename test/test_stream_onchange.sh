@@ -0,0 +1,101 @@
+#!/usr/bin/env bash
+# On-change push of datastore changes, YANG-Push style (RFC 8641)
+# Subscriptions to the on-change stream get a push-change-update with a yang-patch of each commit
+# See CLICON_STREAM_ON_CHANGE and CLICON_STREAM_ON_CHANGE_DAMPENING
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+NCWAIT=6 # Wait for notification
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_ON_CHANGE>on-change</CLICON_STREAM_ON_CHANGE>
+  <CLICON_STREAM_ON_CHANGE_DAMPENING>500</CLICON_STREAM_ON_CHANGE_DAMPENING>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf x{
+         type uint32;
+      }
+      leaf y{
+         type uint32;
+      }
+   }
+}
+EOF
+
+# Edit and commit config $1 in background, after the subscription is made
+function change_later()
+{
+    edit=$(chunked_framing "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$1</config></edit-config></rpc>")
+    commit=$(chunked_framing "<rpc $DEFAULTNS><commit/></rpc>")
+    (sleep 2; echo "$DEFAULTHELLO$edit$commit" | $clixon_netconf -qf $cfg > /dev/null) &
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "on-change stream discovery"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"n:netconf/n:streams\" xmlns:n=\"urn:ietf:params:xml:ns:netmod:notification\"/></get></rpc>" "" "<stream><name>on-change</name><description>On-change datastore changes</description><replay-support>false</replay-support></stream>"
+
+new "on-change subscription, create container"
+change_later "<c xmlns=\"urn:example:clixon\"><x>1</x></c>"
+expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>on-change</stream></create-subscription></rpc>" $NCWAIT "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" "<push-change-update xmlns=\"urn:ietf:params:xml:ns:yang:ietf-yang-push\"><datastore-changes><yang-patch><patch-id>[0-9]*</patch-id><edit><edit-id>edit1</edit-id><operation>create</operation><target>/example:c</target><value><c xmlns=\"urn:example:clixon\"><x>1</x></c></value></edit></yang-patch></datastore-changes></push-change-update>"
+
+new "on-change subscription of leaf, replace leaf"
+change_later "<c xmlns=\"urn:example:clixon\"><x>2</x></c>"
+expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>on-change</stream><filter type=\"xpath\" select=\"/c/x\"/></create-subscription></rpc>" $NCWAIT "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" "<edit><edit-id>edit1</edit-id><operation>replace</operation><target>/example:c/x</target><value><x xmlns=\"urn:example:clixon\">2</x></value></edit>"
+
+new "on-change subscription of other leaf, only its changes are pushed"
+change_later "<c xmlns=\"urn:example:clixon\"><x>3</x><y>4</y></c>"
+expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>on-change</stream><filter type=\"xpath\" select=\"/c/y\"/></create-subscription></rpc>" $NCWAIT "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" "<operation>create</operation><target>/example:c/y</target><value><y xmlns=\"urn:example:clixon\">4</y></value>" --not-- "/example:c/x"
+
+new "on-change subscription, delete container"
+change_later "<c xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\" nc:operation=\"delete\"/>"
+expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>on-change</stream></create-subscription></rpc>" $NCWAIT "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" "<edit><edit-id>edit1</edit-id><operation>delete</operation><target>/example:c</target></edit>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,129 @@
+#!/usr/bin/env bash
+# Request tracing across restconf and backend
+# Spans of restconf requests, backend rpcs and commits are written as JSON lines
+# See CLICON_TRACE_FILE and CLICON_TRACE_SAMPLE
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+ftrace=$dir/trace.json
+
+# W3C traceparent of client
+trace=0af7651916cd43dd8448eb211c80319c
+parent=b7ad6b7169203331
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_TRACE_FILE>$ftrace</CLICON_TRACE_FILE>
+  <CLICON_TRACE_SAMPLE>100</CLICON_TRACE_SAMPLE>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container d{
+      leaf x{
+         type uint32;
+      }
+   }
+}
+EOF
+
+# Written by both backend and restconf
+touch $ftrace
+chmod 666 $ftrace
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "restconf PUT with traceparent"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -H "traceparent: 00-$trace-$parent-01" -d '{"example:d":{"x":42}}' $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 201"
+
+new "restconf span is child of client span"
+expectpart "$(grep "\"name\":\"restconf PUT\"" $ftrace)" 0 "\"traceId\":\"$trace\"" "\"parentSpanId\":\"$parent\"" "\"detail\":\"/restconf/data/example:d\"" "\"status\":\"ok\""
+
+new "backend rpc spans are in same trace"
+expectpart "$(grep "\"name\":\"backend rpc\"" $ftrace)" 0 "\"traceId\":\"$trace\"" "\"detail\":\"edit-config\""
+
+new "commit span is in same trace"
+expectpart "$(grep "\"name\":\"commit\"" $ftrace)" 0 "\"traceId\":\"$trace\"" "\"detail\":\"candidate\""
+
+new "restconf GET with traceparent not sampled"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "traceparent: 00-1af7651916cd43dd8448eb211c80319c-$parent-00" $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 200" '{"example:d":{"x":42}}'
+
+new "no spans of trace not sampled"
+expectpart "$(grep -c 1af7651916cd43dd8448eb211c80319c $ftrace)" 1 "^0$"
+
+new "restconf GET without traceparent"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/example:d)" 0 "HTTP/$HVER 200" '{"example:d":{"x":42}}'
+
+new "new trace is started"
+expectpart "$(grep "\"name\":\"restconf GET\"" $ftrace)" 0 "\"traceId\":\"[0-9a-f]*\",\"spanId\":\"[0-9a-f]*\",\"name\":\"restconf GET\""
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -230,6 +230,12 @@ cat <<EOF > $changelog
       <name>3</name>
       <op>replace</op>
       <where>/a:system/a:host-name</where>
+      <new><host-name>i am replaced</host-name></new>
+    </step>
+    <step>
+      <name>3a</name>
+      <op>replace</op>
+      <where>/a:system/a:host-name</where>
       <new><host-name>i am modified</host-name></new>
     </step>
     <step>
@@ -0,0 +1,87 @@
+#!/usr/bin/env bash
+# XPath predicates on leading keys of a list with several keys
+# Ordered-by system lists use a binary range search (XPATH_LIST_OPTIMIZE), ordered-by user
+# lists a linear search, both should return all matching entries in order
+# Also leaf-list value predicates, eg l[.='x'], on a leaf-list large enough for a hash index
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xpath:=clixon_util_xpath}
+
+xml=$dir/xml.xml
+fyang=$dir/example.yang
+
+cat <<EOF > $fyang
+module example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container c{
+    list s{
+      key "vrf prefix";
+      leaf vrf{
+        type string;
+      }
+      leaf prefix{
+        type string;
+      }
+      leaf nexthop{
+        type string;
+      }
+    }
+    list u{
+      ordered-by user;
+      key "vrf prefix";
+      leaf vrf{
+        type string;
+      }
+      leaf prefix{
+        type string;
+      }
+    }
+    leaf-list l{
+      type uint32;
+    }
+  }
+}
+EOF
+
+# Large leaf-list, see XML_LIST_HASH
+ll=""
+for (( i=0; i<200; i++ )); do
+    ll="$ll<l>$i</l>"
+done
+
+cat <<EOF > $xml
+<c xmlns="urn:example:clixon"><s><vrf>a</vrf><prefix>1</prefix><nexthop>x</nexthop></s><s><vrf>b</vrf><prefix>1</prefix><nexthop>y</nexthop></s><s><vrf>b</vrf><prefix>2</prefix><nexthop>z</nexthop></s><s><vrf>b</vrf><prefix>3</prefix><nexthop>x</nexthop></s><s><vrf>c</vrf><prefix>1</prefix><nexthop>y</nexthop></s><u><vrf>b</vrf><prefix>1</prefix></u><u><vrf>a</vrf><prefix>1</prefix></u><u><vrf>b</vrf><prefix>2</prefix></u>$ll</c>
+EOF
+
+new "xpath s on first key"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -n ex:urn:example:clixon -y $fyang -p "/ex:c/ex:s[ex:vrf='b']")" 0 "^nodeset:0:<s><vrf>b</vrf><prefix>1</prefix><nexthop>y</nexthop></s>1:<s><vrf>b</vrf><prefix>2</prefix><nexthop>z</nexthop></s>2:<s><vrf>b</vrf><prefix>3</prefix><nexthop>x</nexthop></s>$"
+
+new "xpath s on first key, first entry"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -n ex:urn:example:clixon -y $fyang -p "/ex:c/ex:s[ex:vrf='a']")" 0 "^nodeset:0:<s><vrf>a</vrf><prefix>1</prefix><nexthop>x</nexthop></s>$"
+
+new "xpath s on first key, no match"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -n ex:urn:example:clixon -y $fyang -p "/ex:c/ex:s[ex:vrf='d']")" 0 "nodeset:" --not-- "<s>"
+
+new "xpath s on both keys"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -n ex:urn:example:clixon -y $fyang -p "/ex:c/ex:s[ex:vrf='b'][ex:prefix='2']")" 0 "^nodeset:0:<s><vrf>b</vrf><prefix>2</prefix><nexthop>z</nexthop></s>$"
+
+new "xpath s on second key is not optimized"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -n ex:urn:example:clixon -y $fyang -p "/ex:c/ex:s[ex:prefix='1']")" 0 "^nodeset:0:<s><vrf>a</vrf><prefix>1</prefix><nexthop>x</nexthop></s>1:<s><vrf>b</vrf><prefix>1</prefix><nexthop>y</nexthop></s>2:<s><vrf>c</vrf><prefix>1</prefix><nexthop>y</nexthop></s>$"
+
+new "xpath ordered-by user on first key"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -n ex:urn:example:clixon -y $fyang -p "/ex:c/ex:u[ex:vrf='b']")" 0 "^nodeset:0:<u><vrf>b</vrf><prefix>1</prefix></u>1:<u><vrf>b</vrf><prefix>2</prefix></u>$"
+
+new "xpath leaf-list value"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -n ex:urn:example:clixon -y $fyang -p "/ex:c/ex:l[.='142']")" 0 "^nodeset:0:<l>142</l>$"
+
+new "xpath leaf-list value, no match"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -n ex:urn:example:clixon -y $fyang -p "/ex:c/ex:l[.='300']")" 0 "nodeset:" --not-- "<l>"
+
+rm -rf $dir
+
+new "endtest"
+endtest
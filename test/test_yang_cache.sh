@@ -0,0 +1,139 @@
+#!/usr/bin/env bash
+# YANG parse cache, see CLICON_YANG_CACHE_DIR
+# The first start writes cache files, the second start reads them.
+# A changed YANG file is parsed again and its cache file rewritten
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+cachedir=$dir/cache
+
+test -d $cachedir || mkdir -p $cachedir
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_YANG_CACHE_DIR>$cachedir</CLICON_YANG_CACHE_DIR>
+</clixon-config>
+EOF
+
+# Arguments:
+# 1: extra leaf statement
+function mkyang()
+{
+    cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  import clixon-lib {
+    prefix cl;
+  }
+  revision 2025-10-01;
+  grouping value{
+    leaf value{
+      type uint32;
+      must ". < 1000" {
+        error-message "value too large";
+      }
+    }
+  }
+  container table{
+    list parameter{
+      key name;
+      max-elements 10;
+      leaf name{
+        type string;
+      }
+      uses value;
+      $1
+    }
+  }
+}
+EOF
+}
+
+# Arguments:
+# 1: Expected parameter content
+function testrun()
+{
+    content=$1
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -z -f $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "add parameter"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name>$content</parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "get parameter"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name>$content</parameter></table></data></rpc-reply>"
+
+    new "add too large value"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1000</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "validate must from cached grouping"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>value too large</error-message></rpc-error></rpc-reply>"
+
+    new "discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+mkyang ""
+
+new "First start, write cache"
+testrun "<value>1</value>"
+
+new "Check cache file written"
+if ! ls $cachedir/clixon-example.yang.*.bin > /dev/null 2>&1; then
+    err "cache file" "none"
+fi
+if ! ls $cachedir/clixon-lib@*.yang.*.bin > /dev/null 2>&1; then
+    err "imported cache file" "none"
+fi
+
+new "Second start, read cache"
+testrun "<value>1</value>"
+
+# Change YANG file, ensure another mtime
+sleep 1
+mkyang "leaf extra{ type string; }"
+
+new "Changed YANG, cache stale"
+testrun "<value>1</value><extra>x</extra>"
+
+rm -rf $dir
+
+new "endtest"
+endtest